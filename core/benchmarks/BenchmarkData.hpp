@@ -0,0 +1,149 @@
+#ifndef BENCHMARKS_BENCHMARKDATA_HPP_DEFINED
+#define BENCHMARKS_BENCHMARKDATA_HPP_DEFINED
+
+#include "config.hpp"
+
+#include "BoundingBox.hpp"
+#include "CancellationToken.hpp"
+#include "entities/Area.hpp"
+#include "entities/Element.hpp"
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Relation.hpp"
+#include "entities/Way.hpp"
+#include "formats/osm/OsmDataVisitor.hpp"
+#include "formats/osm/xml/OsmXmlParser.hpp"
+#include "index/ElementStream.hpp"
+#include "index/StringTable.hpp"
+#include "mapcss/MapCssParser.hpp"
+#include "mapcss/StyleProvider.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace utymap {
+namespace benchmarks {
+
+/// Counts visited elements.
+struct ElementCounter final : public utymap::entities::ElementVisitor {
+  void visitNode(const utymap::entities::Node &) override { ++count; }
+  void visitWay(const utymap::entities::Way &) override { ++count; }
+  void visitArea(const utymap::entities::Area &) override { ++count; }
+  void visitRelation(const utymap::entities::Relation &) override { ++count; }
+  std::size_t count = 0;
+};
+
+/// Provides realistic inputs for benchmarks: elements of berlin test file, their strings
+/// and default stylesheet. Data is loaded once and shared by all benchmarks.
+/// NOTE string table is created in temporary directory which is removed on exit.
+class BenchmarkData final {
+ public:
+  static BenchmarkData &instance() {
+    static BenchmarkData data;
+    return data;
+  }
+
+  BenchmarkData(const BenchmarkData &) = delete;
+  BenchmarkData &operator=(const BenchmarkData &) = delete;
+
+  ~BenchmarkData() {
+    styleProvider_.reset();
+    stringTable_.reset();
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(directory_, ec);
+  }
+
+  utymap::index::StringTable &getStringTable() const {
+    return *stringTable_;
+  }
+
+  const utymap::mapcss::StyleProvider &getStyleProvider() const {
+    return *styleProvider_;
+  }
+
+  /// Returns elements of test file.
+  const std::vector<std::unique_ptr<utymap::entities::Element>> &getElements() const {
+    return elements_;
+  }
+
+  /// Returns elements serialized by element stream.
+  const std::vector<std::string> &getElementData() const {
+    return elementData_;
+  }
+
+  /// Returns areas of test file.
+  const std::vector<const utymap::entities::Area *> &getAreas() const {
+    return areas_;
+  }
+
+  /// Returns bounding box of nodes of test file.
+  const utymap::BoundingBox &getBoundingBox() const {
+    return bbox_;
+  }
+
+  /// Returns keys and values of tags in order of their appearance in test file.
+  const std::vector<std::string> &getStrings() const {
+    return strings_;
+  }
+
+ private:
+  BenchmarkData() :
+      directory_(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directories(directory_);
+    stringTable_ = utymap::utils::make_unique<utymap::index::StringTable>(directory_.string() + "/");
+    loadStyle(TEST_ASSETS_PATH TEST_MAPCSS_DEFAULT);
+    loadElements(TEST_XML_FILE);
+  }
+
+  void loadStyle(const std::string &path) {
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    utymap::mapcss::MapCssParser parser(path.substr(0, path.find_last_of("\\/") + 1));
+    styleProvider_ = utymap::utils::make_unique<utymap::mapcss::StyleProvider>(parser.parse(content), *stringTable_);
+  }
+
+  /// Parses osm file and keeps copies of its elements read back from element stream.
+  void loadElements(const std::string &path) {
+    utymap::CancellationToken cancelToken;
+    utymap::formats::OsmDataVisitor visitor(*stringTable_, [&](utymap::entities::Element &element) {
+      std::stringstream stream;
+      utymap::index::ElementStream::write(stream, element);
+      elementData_.push_back(stream.str());
+      elements_.push_back(utymap::index::ElementStream::read(stream, element.id));
+      if (auto node = dynamic_cast<const utymap::entities::Node *>(elements_.back().get()))
+        bbox_.expand(node->coordinate);
+      else if (auto area = dynamic_cast<const utymap::entities::Area *>(elements_.back().get()))
+        areas_.push_back(area);
+      for (const auto &tag : element.tags) {
+        strings_.push_back(*stringTable_->getString(tag.key));
+        strings_.push_back(*stringTable_->getString(tag.value));
+      }
+      return true;
+    }, cancelToken);
+
+    std::ifstream file(path);
+    utymap::formats::OsmXmlParser<utymap::formats::OsmDataVisitor>().parse(file, visitor);
+    visitor.complete();
+  }
+
+  boost::filesystem::path directory_;
+  std::unique_ptr<utymap::index::StringTable> stringTable_;
+  std::unique_ptr<utymap::mapcss::StyleProvider> styleProvider_;
+  std::vector<std::unique_ptr<utymap::entities::Element>> elements_;
+  std::vector<std::string> elementData_;
+  std::vector<const utymap::entities::Area *> areas_;
+  utymap::BoundingBox bbox_;
+  std::vector<std::string> strings_;
+};
+
+}
+}
+
+#endif // BENCHMARKS_BENCHMARKDATA_HPP_DEFINED
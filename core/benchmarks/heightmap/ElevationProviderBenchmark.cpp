@@ -0,0 +1,155 @@
+#include "config.hpp"
+
+#include "BoundingBox.hpp"
+#include "QuadKey.hpp"
+#include "heightmap/CompressedElevationProvider.hpp"
+#include "heightmap/GridElevationProvider.hpp"
+#include "heightmap/SrtmElevationProvider.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <benchmark/benchmark.h>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+using namespace utymap::utils;
+
+namespace {
+
+/// Tile which has data in test index for every provider.
+const QuadKey TileKey(16, 35205, 21489);
+/// SRTM cell which contains the tile.
+const BoundingBox CellBox(GeoCoordinate(52, 13), GeoCoordinate(53, 14));
+/// Amount of points in query set.
+const std::size_t PointCount = 4096;
+
+enum class ProviderType { Srtm = 0, Grid, Compressed };
+/// Defines order of points: random inside tile, rows of tile grid as vertices of terrain
+/// mesh and random inside SRTM cell, so queries cross data blocks.
+enum class Pattern { Random = 0, Coherent, Scattered };
+
+/// Keeps compressed copy of test SRTM cell in temporary index.
+class CompressedIndex final {
+ public:
+  static const std::string &getPath() {
+    static CompressedIndex index;
+    return index.path_;
+  }
+
+  ~CompressedIndex() {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(path_, ec);
+  }
+
+ private:
+  CompressedIndex() :
+      path_((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string() + "/") {
+    boost::filesystem::create_directories(path_ + "data/");
+    CompressedElevationProvider::compress(TEST_ASSETS_PATH "index/data/N52E013.hgt", path_ + "data/N52E013.hgz");
+  }
+
+  std::string path_;
+};
+
+std::unique_ptr<ElevationProvider> createProvider(ProviderType type) {
+  switch (type) {
+    case ProviderType::Srtm: return utymap::utils::make_unique<SrtmElevationProvider>(TEST_ASSETS_PATH "index/");
+    case ProviderType::Grid: return utymap::utils::make_unique<GridElevationProvider>(TEST_ASSETS_PATH "index/");
+    default: return utymap::utils::make_unique<CompressedElevationProvider>(CompressedIndex::getPath());
+  }
+}
+
+std::vector<GeoCoordinate> createPoints(Pattern pattern) {
+  auto bbox = pattern == Pattern::Scattered ? CellBox : GeoUtils::quadKeyToBoundingBox(TileKey);
+  std::vector<GeoCoordinate> points;
+  points.reserve(PointCount);
+  if (pattern == Pattern::Coherent) {
+    auto size = static_cast<std::size_t>(std::sqrt(PointCount));
+    double latStep = bbox.height() / (size - 1), lonStep = bbox.width() / (size - 1);
+    for (std::size_t row = 0; row < size; ++row)
+      for (std::size_t column = 0; column < size; ++column)
+        points.push_back(GeoCoordinate(bbox.minPoint.latitude + row * latStep,
+                                       bbox.minPoint.longitude + column * lonStep));
+    return points;
+  }
+
+  std::minstd_rand random(42);
+  std::uniform_real_distribution<double> latitude(bbox.minPoint.latitude, bbox.maxPoint.latitude);
+  std::uniform_real_distribution<double> longitude(bbox.minPoint.longitude, bbox.maxPoint.longitude);
+  for (std::size_t i = 0; i < PointCount; ++i)
+    points.push_back(GeoCoordinate(latitude(random), longitude(random)));
+  return points;
+}
+
+void setLabel(benchmark::State &state, ProviderType type) {
+  static const char *Names[] = { "srtm", "grid", "compressed" };
+  state.SetLabel(Names[static_cast<int>(type)]);
+}
+
+/// Queries points one by one with warm provider.
+void ElevationProvider_GetElevation(benchmark::State &state) {
+  auto type = static_cast<ProviderType>(state.range(0));
+  auto points = createPoints(static_cast<Pattern>(state.range(1)));
+  auto provider = createProvider(type);
+  provider->getElevation(TileKey, points.front());
+  for (auto _ : state) {
+    for (const auto &point : points)
+      benchmark::DoNotOptimize(provider->getElevation(TileKey, point));
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  setLabel(state, type);
+}
+
+/// Queries the first point with new provider, so data is loaded from disk.
+/// NOTE files are likely in page cache after the first iteration.
+void ElevationProvider_ColdStart(benchmark::State &state) {
+  auto type = static_cast<ProviderType>(state.range(0));
+  auto point = GeoUtils::quadKeyToBoundingBox(TileKey).center();
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto provider = createProvider(type);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(provider->getElevation(TileKey, point));
+    state.PauseTiming();
+    provider.reset();
+    state.ResumeTiming();
+  }
+  setLabel(state, type);
+}
+
+/// Queries coherent points in batches of given size with warm provider.
+void ElevationProvider_GetElevations(benchmark::State &state) {
+  auto type = static_cast<ProviderType>(state.range(0));
+  auto batchSize = static_cast<std::size_t>(state.range(1));
+  auto points = createPoints(Pattern::Coherent);
+  std::vector<double> elevations(points.size());
+  auto provider = createProvider(type);
+  provider->getElevation(TileKey, points.front());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < points.size(); i += batchSize)
+      provider->getElevations(TileKey, points.data() + i, elevations.data() + i, std::min(batchSize, points.size() - i));
+    benchmark::DoNotOptimize(elevations.data());
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+  setLabel(state, type);
+}
+
+}
+
+// NOTE grid data exists only for test tile, so scattered points are not queried.
+BENCHMARK(ElevationProvider_GetElevation)
+    ->Args({0, 0})->Args({0, 1})->Args({0, 2})
+    ->Args({1, 0})->Args({1, 1})
+    ->Args({2, 0})->Args({2, 1})->Args({2, 2})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(ElevationProvider_ColdStart)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(ElevationProvider_GetElevations)
+    ->ArgsProduct({{0, 1, 2}, {1, 16, 256, 4096}})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,50 @@
+#include "BenchmarkData.hpp"
+#include "LodRange.hpp"
+#include "index/InMemoryElementStore.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace utymap;
+using namespace utymap::benchmarks;
+using namespace utymap::index;
+
+namespace {
+
+const LodRange Range(16, 16);
+
+/// Defines not, and, or terms of benchmarked queries.
+const char *Queries[][3] = {
+    {"", "residential", ""},
+    {"", "", "shop restaurant cafe"},
+    {"yes", "building", ""},
+};
+
+/// Returns store with elements of test file indexed by bitmap index.
+InMemoryElementStore &getStore() {
+  static std::unique_ptr<InMemoryElementStore> store;
+  if (store == nullptr) {
+    const auto &data = BenchmarkData::instance();
+    store = utymap::utils::make_unique<InMemoryElementStore>(data.getStringTable());
+    for (const auto &element : data.getElements())
+      store->store(*element, Range, data.getStyleProvider());
+  }
+  return *store;
+}
+
+void BitmapIndex_Search(benchmark::State &state) {
+  const auto &query = Queries[state.range(0)];
+  auto &store = getStore();
+  const auto &bbox = BenchmarkData::instance().getBoundingBox();
+  CancellationToken cancelToken;
+  std::size_t matches = 0;
+  for (auto _ : state) {
+    ElementCounter visitor;
+    store.search(query[0], query[1], query[2], bbox, Range, visitor, cancelToken);
+    matches = visitor.count;
+  }
+  state.counters["matches"] = static_cast<double>(matches);
+}
+
+}
+
+BENCHMARK(BitmapIndex_Search)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,161 @@
+#include "BenchmarkData.hpp"
+#include "LodRange.hpp"
+#include "builders/BuilderContext.hpp"
+#include "builders/MeshCache.hpp"
+#include "builders/MeshPool.hpp"
+#include "heightmap/FlatElevationProvider.hpp"
+#include "index/PersistentElementStore.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <random>
+
+using namespace utymap;
+using namespace utymap::benchmarks;
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+
+const int LevelOfDetail = 16;
+const LodRange Range(LevelOfDetail, LevelOfDetail);
+const int MaxThreads = 32;
+
+/// Stores and caches shared by all threads. Persistent store is filled with elements of test
+/// file, so reads hit real data while writes add copies of its nodes.
+/// NOTE written data is kept between runs with different amount of threads.
+class SharedState final {
+ public:
+  static SharedState &instance() {
+    static SharedState state;
+    return state;
+  }
+
+  ~SharedState() {
+    store.reset();
+    meshCache.reset();
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(directory, ec);
+  }
+
+  boost::filesystem::path directory;
+  std::vector<QuadKey> quadKeys;
+  std::vector<const Node *> nodes;
+  std::unique_ptr<PersistentElementStore> store;
+  std::unique_ptr<MeshCache> meshCache;
+  heightmap::FlatElevationProvider eleProvider;
+  std::atomic<std::uint64_t> nextId;
+
+ private:
+  SharedState() :
+      directory(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()), nextId(1ull << 48) {
+    const auto &data = BenchmarkData::instance();
+    boost::filesystem::create_directories(directory / std::to_string(LevelOfDetail));
+    boost::filesystem::create_directories(directory / "cache" / data.getStyleProvider().getTag() /
+        std::to_string(LevelOfDetail));
+
+    store = utymap::utils::make_unique<PersistentElementStore>(directory.string(), data.getStringTable());
+    for (const auto &element : data.getElements()) {
+      store->store(*element, Range, data.getStyleProvider());
+      if (auto node = dynamic_cast<const Node *>(element.get()))
+        if (!node->tags.empty()) nodes.push_back(node);
+    }
+    store->flush();
+    meshCache = utymap::utils::make_unique<MeshCache>(directory.string(), "mesh");
+    GeoUtils::visitTileRange(data.getBoundingBox(), LevelOfDetail,
+                             [&](const QuadKey &quadKey, const BoundingBox &) { quadKeys.push_back(quadKey); });
+  }
+};
+
+/// Runs mixed store workload: quad key and text searches, hasData checks and writes in
+/// 4:2:1:1 proportion.
+void PersistentElementStore_Mixed(benchmark::State &state) {
+  auto &shared = SharedState::instance();
+  const auto &data = BenchmarkData::instance();
+  std::minstd_rand random(static_cast<std::minstd_rand::result_type>(state.thread_index() + 1));
+  CancellationToken cancelToken;
+  std::size_t operation = 0;
+  for (auto _ : state) {
+    const auto &quadKey = shared.quadKeys[random() % shared.quadKeys.size()];
+    ElementCounter counter;
+    switch (operation++ % 8) {
+      case 0: case 1: case 2: case 3:
+        shared.store->search(quadKey, counter, cancelToken);
+        break;
+      case 4:
+        shared.store->search("", "residential", "", data.getBoundingBox(), Range, counter, cancelToken);
+        break;
+      case 5:
+        shared.store->search("", "", "shop cafe", GeoUtils::quadKeyToBoundingBox(quadKey), Range, counter, cancelToken);
+        break;
+      case 6:
+        benchmark::DoNotOptimize(shared.store->hasData(quadKey));
+        break;
+      default: {
+        Node node(*shared.nodes[random() % shared.nodes.size()]);
+        node.id = shared.nextId.fetch_add(1);
+        node.coordinate = GeoUtils::quadKeyToBoundingBox(quadKey).center();
+        shared.store->store(node, quadKey, data.getStyleProvider());
+      }
+    }
+    benchmark::DoNotOptimize(counter.count);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// Looks up ids of existing strings and adds new one on every eighth operation.
+void StringTable_Mixed(benchmark::State &state) {
+  auto &stringTable = BenchmarkData::instance().getStringTable();
+  const auto &strings = BenchmarkData::instance().getStrings();
+  auto &shared = SharedState::instance();
+  std::minstd_rand random(static_cast<std::minstd_rand::result_type>(state.thread_index() + 1));
+  std::size_t operation = 0;
+  for (auto _ : state) {
+    if (operation++ % 8 == 7) {
+      auto id = stringTable.getId("benchmark:" + std::to_string(shared.nextId.fetch_add(1)));
+      benchmark::DoNotOptimize(stringTable.getString(id));
+    } else
+      benchmark::DoNotOptimize(stringTable.getId(strings[random() % strings.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/// Fetches meshes of random quad keys from cache, missed ones are built as one small mesh
+/// and written to cache.
+void MeshCache_Mixed(benchmark::State &state) {
+  auto &shared = SharedState::instance();
+  const auto &data = BenchmarkData::instance();
+  std::minstd_rand random(static_cast<std::minstd_rand::result_type>(state.thread_index() + 1));
+  MeshPool meshPool;
+  CancellationToken cancelToken;
+  std::size_t meshes = 0;
+  for (auto _ : state) {
+    const auto &quadKey = shared.quadKeys[random() % shared.quadKeys.size()];
+    BuilderContext context(quadKey, data.getStyleProvider(), data.getStringTable(), meshPool, shared.eleProvider,
+                           [&meshes](const math::Mesh &) { ++meshes; }, [](const Element &) {}, cancelToken);
+    if (shared.meshCache->fetch(context))
+      continue;
+
+    auto wrapped = shared.meshCache->wrap(context);
+    math::Mesh mesh("benchmark");
+    auto center = context.boundingBox.center();
+    mesh.vertices = { center.longitude, center.latitude, 0, center.longitude + 1E-4, center.latitude, 0,
+                      center.longitude, center.latitude + 1E-4, 0 };
+    mesh.triangles = { 0, 1, 2 };
+    mesh.colors = { 0, 0, 0 };
+    wrapped.meshCallback(mesh);
+    shared.meshCache->unwrap(wrapped);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["fetched"] = benchmark::Counter(static_cast<double>(meshes), benchmark::Counter::kIsRate);
+}
+
+}
+
+BENCHMARK(PersistentElementStore_Mixed)->ThreadRange(1, MaxThreads)->UseRealTime();
+BENCHMARK(StringTable_Mixed)->ThreadRange(1, MaxThreads)->UseRealTime();
+BENCHMARK(MeshCache_Mixed)->ThreadRange(1, MaxThreads)->UseRealTime();
@@ -0,0 +1,40 @@
+#include "BenchmarkData.hpp"
+#include "entities/ElementDispatch.hpp"
+#include "index/ElementGeometryVisitor.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace utymap::benchmarks;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+
+/// Calculates bounding boxes of test elements using virtual accept.
+void ElementDispatch_Accept(benchmark::State &state) {
+  const auto &elements = BenchmarkData::instance().getElements();
+  for (auto _ : state) {
+    ElementGeometryVisitor visitor;
+    for (const auto &element : elements)
+      element->accept(visitor);
+    benchmark::DoNotOptimize(visitor.boundingBox);
+  }
+  state.SetItemsProcessed(state.iterations() * elements.size());
+}
+
+/// Calculates bounding boxes of test elements using dispatch by element kind.
+void ElementDispatch_Dispatch(benchmark::State &state) {
+  const auto &elements = BenchmarkData::instance().getElements();
+  for (auto _ : state) {
+    ElementGeometryVisitor visitor;
+    for (const auto &element : elements)
+      dispatch(*element, visitor);
+    benchmark::DoNotOptimize(visitor.boundingBox);
+  }
+  state.SetItemsProcessed(state.iterations() * elements.size());
+}
+
+}
+
+BENCHMARK(ElementDispatch_Accept);
+BENCHMARK(ElementDispatch_Dispatch);
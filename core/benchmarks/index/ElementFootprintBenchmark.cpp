@@ -0,0 +1,212 @@
+#include "BenchmarkData.hpp"
+#include "entities/Area.hpp"
+#include "entities/Node.hpp"
+#include "entities/Relation.hpp"
+#include "entities/Way.hpp"
+#include "formats/osm/OsmDataContext.hpp"
+#include "index/InMemoryElementStore.hpp"
+#include "utils/AllocationTracker.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace utymap;
+using namespace utymap::benchmarks;
+using namespace utymap::entities;
+using namespace utymap::formats;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+
+const int LevelOfDetail = 16;
+/// Amount of coordinates of synthetic way and area.
+const std::size_t WayCoordinates = 8;
+const std::size_t AreaCoordinates = 12;
+/// Amount of members of synthetic relation. Members are shared by all relations.
+const std::size_t RelationMembers = 3;
+
+enum class Structure { CopyStore = 0, ArenaStore, OsmDataContext };
+enum class Kind { Node = 0, Way, Area, Relation };
+
+/// Returns heap bytes in use including malloc overhead and mapped chunks.
+/// NOTE supported only with glibc 2.33+, zero is returned otherwise.
+std::size_t getHeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  auto info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#else
+  return 0;
+#endif
+}
+
+/// Creates synthetic elements which resemble elements of test data: tags are taken from
+/// real strings and geometry is spread over test bounding box.
+class ElementFactory final {
+ public:
+  explicit ElementFactory(Kind kind) : kind_(kind) {
+    const auto &data = BenchmarkData::instance();
+    auto &stringTable = data.getStringTable();
+    tags_ = { utymap::entities::Tag(stringTable.getId("highway"), stringTable.getId("residential")),
+              utymap::entities::Tag(stringTable.getId("name"), stringTable.getId("Unter den Linden")),
+              utymap::entities::Tag(stringTable.getId("surface"), stringTable.getId("asphalt")) };
+    bbox_ = data.getBoundingBox();
+    for (std::size_t i = 0; i < RelationMembers; ++i) {
+      auto node = std::make_shared<Node>();
+      node->id = i;
+      node->coordinate = bbox_.center();
+      node->tags = tags_;
+      members_.push_back(node);
+    }
+  }
+
+  std::shared_ptr<Element> create(std::uint64_t id) const {
+    auto coordinate = getCoordinate(id);
+    switch (kind_) {
+      case Kind::Node: {
+        auto node = std::make_shared<Node>();
+        node->coordinate = coordinate;
+        return init(node, id, 2);
+      }
+      case Kind::Way: {
+        auto way = std::make_shared<Way>();
+        way->coordinates = getCoordinates(coordinate, WayCoordinates);
+        return init(way, id, 3);
+      }
+      case Kind::Area: {
+        auto area = std::make_shared<Area>();
+        area->coordinates = getCoordinates(coordinate, AreaCoordinates);
+        return init(area, id, 3);
+      }
+      default: {
+        auto relation = std::make_shared<Relation>();
+        relation->elements = members_;
+        return init(relation, id, 1);
+      }
+    }
+  }
+
+  QuadKey getQuadKey(std::uint64_t id) const {
+    return GeoUtils::GeoCoordinateToQuadKey(getCoordinate(id), LevelOfDetail);
+  }
+
+ private:
+  template<typename T>
+  std::shared_ptr<Element> init(std::shared_ptr<T> element, std::uint64_t id, std::size_t tagCount) const {
+    element->id = id;
+    element->tags.assign(tags_.begin(), tags_.begin() + tagCount);
+    return element;
+  }
+
+  /// Spreads elements over bounding box with pseudo random low discrepancy sequence.
+  GeoCoordinate getCoordinate(std::uint64_t id) const {
+    double x = std::fmod(id * 0.618033988749895, 1), y = std::fmod(id * 0.754877666246693, 1);
+    return GeoCoordinate(bbox_.minPoint.latitude + y * bbox_.height(), bbox_.minPoint.longitude + x * bbox_.width());
+  }
+
+  static std::vector<GeoCoordinate> getCoordinates(const GeoCoordinate &start, std::size_t count) {
+    std::vector<GeoCoordinate> coordinates;
+    coordinates.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+      coordinates.push_back(GeoCoordinate(start.latitude + (i % 2) * 1E-4, start.longitude + (i / 2) * 1E-4));
+    return coordinates;
+  }
+
+  const Kind kind_;
+  std::vector<utymap::entities::Tag> tags_;
+  BoundingBox bbox_;
+  std::vector<std::shared_ptr<Element>> members_;
+};
+
+/// Keeps elements in the same way as OSM importer does: element is shared object in map by id.
+void fill(OsmDataContext &context, const ElementFactory &factory, Kind kind, std::uint64_t count) {
+  for (std::uint64_t id = 0; id < count; ++id) {
+    auto element = factory.create(id);
+    switch (kind) {
+      case Kind::Node: context.nodeMap.emplace(id, std::static_pointer_cast<Node>(element)); break;
+      case Kind::Way: context.wayMap.emplace(id, std::static_pointer_cast<Way>(element)); break;
+      case Kind::Area: context.areaMap.emplace(id, std::static_pointer_cast<Area>(element)); break;
+      default: context.relationMap.emplace(id, std::static_pointer_cast<Relation>(element));
+    }
+  }
+}
+
+void fill(InMemoryElementStore &store, const ElementFactory &factory, std::uint64_t count) {
+  for (std::uint64_t id = 0; id < count; ++id)
+    store.save(*factory.create(id), factory.getQuadKey(id));
+}
+
+/// Measures heap bytes and allocations per element kept by in memory store or by OSM import
+/// context. Allocations are counted only if allocation tracking is enabled.
+void ElementFootprint(benchmark::State &state) {
+  static const char *StructureNames[] = { "copyStore", "arenaStore", "osmDataContext" };
+  static const char *KindNames[] = { "node", "way", "area", "relation" };
+
+  auto structure = static_cast<Structure>(state.range(0));
+  auto kind = static_cast<Kind>(state.range(1));
+  auto count = static_cast<std::uint64_t>(state.range(2));
+  ElementFactory factory(kind);
+  auto &stringTable = BenchmarkData::instance().getStringTable();
+
+  // NOTE structures are destroyed after loop, so destruction is not timed.
+  std::unique_ptr<OsmDataContext> context;
+  std::unique_ptr<InMemoryElementStore> store;
+  double bytes = 0, allocations = 0, footprint = 0;
+  for (auto _ : state) {
+    AllocationTracker::reset();
+    auto heapBytes = getHeapBytes();
+    if (structure == Structure::OsmDataContext) {
+      context = utymap::utils::make_unique<OsmDataContext>();
+      ALLOCATION_SCOPE(Import);
+      fill(*context, factory, kind, count);
+    } else {
+      store = utymap::utils::make_unique<InMemoryElementStore>(stringTable, structure == Structure::CopyStore
+          ? InMemoryElementStore::StorageMode::Copy
+          : InMemoryElementStore::StorageMode::Arena);
+      ALLOCATION_SCOPE(Import);
+      fill(*store, factory, count);
+      footprint = static_cast<double>(store->getFootprint());
+    }
+    bytes = static_cast<double>(getHeapBytes() - heapBytes);
+    allocations = static_cast<double>(AllocationTracker::getCount(AllocationTracker::Subsystem::Import));
+  }
+  context.reset();
+  store.reset();
+
+  state.counters["bytesPerElement"] = bytes / count;
+#ifdef ALLOCATION_TRACKING_ENABLED
+  state.counters["allocationsPerElement"] = allocations / count;
+#endif
+  if (structure != Structure::OsmDataContext)
+    state.counters["footprintPerElement"] = footprint / count;
+  state.SetItemsProcessed(count);
+  state.SetLabel(std::string(StructureNames[state.range(0)]) + "/" + KindNames[state.range(1)]);
+}
+
+/// Registers one million elements of every kind for every structure. Ten and fifty millions
+/// need several gigabytes and are added only if UTYMAP_BENCHMARK_LARGE is set.
+void registerArgs(benchmark::internal::Benchmark *benchmark) {
+  std::vector<std::int64_t> counts = { 1000000 };
+  if (std::getenv("UTYMAP_BENCHMARK_LARGE") != nullptr) {
+    counts.push_back(10000000);
+    counts.push_back(50000000);
+  }
+  for (auto count : counts)
+    for (int structure = 0; structure <= 2; ++structure)
+      for (int kind = 0; kind <= 3; ++kind)
+        benchmark->Args({ structure, kind, count });
+}
+
+}
+
+BENCHMARK(ElementFootprint)->Apply(registerArgs)->Iterations(1)->Unit(benchmark::kMillisecond);
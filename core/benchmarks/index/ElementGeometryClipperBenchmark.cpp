@@ -0,0 +1,31 @@
+#include "BenchmarkData.hpp"
+#include "index/ElementGeometryClipper.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace utymap;
+using namespace utymap::benchmarks;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+
+/// Clips elements of test file by tile at center of their bounding box at given level of details.
+void ElementGeometryClipper_Clip(benchmark::State &state) {
+  const auto &data = BenchmarkData::instance();
+  auto quadKey = GeoUtils::GeoCoordinateToQuadKey(data.getBoundingBox().center(), static_cast<int>(state.range(0)));
+  auto bbox = GeoUtils::quadKeyToBoundingBox(quadKey);
+  std::size_t clipped = 0;
+  for (auto _ : state) {
+    ElementGeometryClipper clipper(quadKey, bbox, [&](const entities::Element &, const QuadKey &) { ++clipped; });
+    for (const auto &element : data.getElements())
+      clipper.clipAndCall(*element);
+  }
+  state.SetItemsProcessed(state.iterations() * data.getElements().size());
+  state.counters["clipped"] = benchmark::Counter(static_cast<double>(clipped), benchmark::Counter::kAvgIterations);
+}
+
+}
+
+BENCHMARK(ElementGeometryClipper_Clip)->Arg(12)->Arg(14)->Arg(16)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,41 @@
+#include "BenchmarkData.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace utymap::benchmarks;
+using namespace utymap::index;
+
+namespace {
+
+void ElementStream_Write(benchmark::State &state) {
+  const auto &elements = BenchmarkData::instance().getElements();
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    std::stringstream stream;
+    for (const auto &element : elements)
+      ElementStream::write(stream, *element);
+    bytes += stream.tellp();
+  }
+  state.SetItemsProcessed(state.iterations() * elements.size());
+  state.SetBytesProcessed(bytes);
+}
+
+void ElementStream_Read(benchmark::State &state) {
+  const auto &data = BenchmarkData::instance();
+  const auto &elements = data.getElements();
+  const auto &elementData = data.getElementData();
+  std::size_t bytes = 0;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < elementData.size(); ++i) {
+      benchmark::DoNotOptimize(ElementStream::read(elementData[i].data(), elementData[i].size(), elements[i]->id));
+      bytes += elementData[i].size();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * elementData.size());
+  state.SetBytesProcessed(bytes);
+}
+
+}
+
+BENCHMARK(ElementStream_Write)->Unit(benchmark::kMillisecond);
+BENCHMARK(ElementStream_Read)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,121 @@
+#include "BenchmarkData.hpp"
+#include "LodRange.hpp"
+#include "index/GeoStore.hpp"
+#include "index/InMemoryElementStore.hpp"
+#include "index/PersistentElementStore.hpp"
+#include "utils/MemoryUtils.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <exception>
+
+using namespace utymap;
+using namespace utymap::benchmarks;
+using namespace utymap::index;
+using namespace utymap::mapcss;
+using namespace utymap::utils;
+
+namespace {
+
+const std::string StoreKey = "benchmark";
+
+/// Defines imported file. Osm files cover berlin, pbf one is larger, so data of osm files is
+/// stored only inside of bounding box of xml file to keep stores comparable.
+struct Dataset {
+  const char *name;
+  const char *path;
+  bool isNaturalEarth;
+  LodRange range;
+};
+
+const Dataset Datasets[] = {
+    {"xml", TEST_XML_FILE, false, LodRange(16, 16)},
+    {"pbf", TEST_PBF_FILE, false, LodRange(16, 16)},
+    {"json", TEST_JSON_2_FILE, false, LodRange(16, 16)},
+    {"shape", TEST_SHAPE_NE_110M_LAND, true, LodRange(1, 1)},
+};
+
+enum class StoreType { InMemory = 0, Persistent };
+
+const StyleProvider &getNaturalEarthStyle() {
+  static std::unique_ptr<StyleProvider> styleProvider;
+  if (styleProvider == nullptr) {
+    std::string path = TEST_MAPCSS_PATH "natural_earth.z1.mapcss";
+    std::ifstream file(path);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    styleProvider = utymap::utils::make_unique<StyleProvider>(MapCssParser(TEST_MAPCSS_PATH).parse(content),
+                                                              BenchmarkData::instance().getStringTable());
+  }
+  return *styleProvider;
+}
+
+std::uint64_t getDirectorySize(const boost::filesystem::path &directory) {
+  std::uint64_t size = 0;
+  for (boost::filesystem::recursive_directory_iterator it(directory), end; it != end; ++it) {
+    if (boost::filesystem::is_regular_file(it->path()))
+      size += boost::filesystem::file_size(it->path());
+  }
+  return size;
+}
+
+/// Imports dataset into new store on every iteration. Stores are created outside of timed
+/// region, persistent store is flushed by its destruction inside of it.
+/// NOTE peak memory is maximum of process, so it depends on benchmarks run before.
+void GeoStore_Import(benchmark::State &state) {
+  const auto &dataset = Datasets[state.range(0)];
+  auto storeType = static_cast<StoreType>(state.range(1));
+  const auto &data = BenchmarkData::instance();
+  const auto &styleProvider = dataset.isNaturalEarth ? getNaturalEarthStyle() : data.getStyleProvider();
+  auto directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+  ImportStatistics::Snapshot snapshot;
+  std::uint64_t elements = 0, bytesParsed = 0, bytesWritten = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    boost::filesystem::remove_all(directory);
+    for (int lod = dataset.range.start; lod <= dataset.range.end; ++lod)
+      boost::filesystem::create_directories(directory / std::to_string(lod));
+    GeoStore geoStore(data.getStringTable());
+    geoStore.setImportProgress([&snapshot](const ImportStatistics::Snapshot &value) { snapshot = value; });
+    InMemoryElementStore *inMemoryStore = nullptr;
+    if (storeType == StoreType::InMemory) {
+      auto store = utymap::utils::make_unique<InMemoryElementStore>(data.getStringTable());
+      inMemoryStore = store.get();
+      geoStore.registerStore(StoreKey, std::move(store));
+    } else
+      geoStore.registerStore(StoreKey, utymap::utils::make_unique<PersistentElementStore>(
+          directory.string(), data.getStringTable()));
+    state.ResumeTiming();
+
+    try {
+      if (dataset.isNaturalEarth)
+        geoStore.add(StoreKey, dataset.path, dataset.range, styleProvider, CancellationToken());
+      else
+        geoStore.add(StoreKey, dataset.path, data.getBoundingBox(), dataset.range, styleProvider, CancellationToken());
+    } catch (std::exception &ex) {
+      state.SkipWithError(ex.what());
+      break;
+    }
+
+    state.PauseTiming();
+    elements += snapshot.elementsParsed;
+    bytesParsed += snapshot.bytesParsed;
+    bytesWritten = inMemoryStore != nullptr ? inMemoryStore->getFootprint() : 0;
+    state.ResumeTiming();
+  }
+  if (storeType == StoreType::Persistent && boost::filesystem::exists(directory))
+    bytesWritten = getDirectorySize(directory);
+  boost::filesystem::remove_all(directory);
+
+  state.SetLabel(std::string(dataset.name) + (storeType == StoreType::InMemory ? "/memory" : "/persistent"));
+  state.SetBytesProcessed(static_cast<std::int64_t>(bytesParsed));
+  state.counters["elements"] = benchmark::Counter(static_cast<double>(elements), benchmark::Counter::kIsRate);
+  state.counters["written"] = benchmark::Counter(static_cast<double>(bytesWritten), benchmark::Counter::kDefaults,
+                                                 benchmark::Counter::kIs1024);
+  state.counters["peakRss"] = benchmark::Counter(static_cast<double>(getPeakMemory()), benchmark::Counter::kDefaults,
+                                                 benchmark::Counter::kIs1024);
+}
+
+}
+
+BENCHMARK(GeoStore_Import)->ArgsProduct({{0, 1, 2, 3}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
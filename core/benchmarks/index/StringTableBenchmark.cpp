@@ -0,0 +1,23 @@
+#include "BenchmarkData.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace utymap::benchmarks;
+
+namespace {
+
+/// Looks up ids of tag strings which are already in table, as it happens on import and search.
+void StringTable_GetId(benchmark::State &state) {
+  const auto &data = BenchmarkData::instance();
+  const auto &strings = data.getStrings();
+  std::size_t count = std::min(strings.size(), static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < count; ++i)
+      benchmark::DoNotOptimize(data.getStringTable().getId(strings[i]));
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+}
+
+BENCHMARK(StringTable_GetId)->Arg(1 << 10)->Arg(1 << 14);
@@ -0,0 +1,22 @@
+#include "BenchmarkData.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace utymap::benchmarks;
+
+namespace {
+
+/// Matches default stylesheet against elements of test file at given level of details.
+void StyleProvider_ForElement(benchmark::State &state) {
+  const auto &data = BenchmarkData::instance();
+  int lod = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    for (const auto &element : data.getElements())
+      benchmark::DoNotOptimize(data.getStyleProvider().forElement(*element, lod));
+  }
+  state.SetItemsProcessed(state.iterations() * data.getElements().size());
+}
+
+}
+
+BENCHMARK(StyleProvider_ForElement)->Arg(1)->Arg(12)->Arg(16)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,61 @@
+#include "BenchmarkData.hpp"
+#include "builders/MeshBuilder.hpp"
+#include "heightmap/FlatElevationProvider.hpp"
+#include "mapcss/ColorGradient.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <benchmark/benchmark.h>
+
+using namespace utymap;
+using namespace utymap::benchmarks;
+using namespace utymap::builders;
+using namespace utymap::heightmap;
+using namespace utymap::mapcss;
+using namespace utymap::math;
+using namespace utymap::utils;
+
+namespace {
+
+/// Builds polygons from areas of test file. Coordinates are used as is, so polygons keep
+/// shape and vertex count of real buildings and landuse.
+std::vector<std::vector<Vector2>> getContours() {
+  std::vector<std::vector<Vector2>> contours;
+  for (const auto *area : BenchmarkData::instance().getAreas()) {
+    std::vector<Vector2> contour;
+    contour.reserve(area->coordinates.size());
+    for (const auto &coordinate : area->coordinates)
+      contour.push_back(Vector2(coordinate.longitude, coordinate.latitude));
+    contours.push_back(std::move(contour));
+  }
+  return contours;
+}
+
+/// Adds areas of test file to mesh. Argument is max triangle area in 1E-10 squared degrees
+/// (about one square meter) where zero disables refinement.
+void MeshBuilder_AddPolygon(benchmark::State &state) {
+  static const auto contours = getContours();
+  const auto &data = BenchmarkData::instance();
+  auto quadKey = GeoUtils::GeoCoordinateToQuadKey(data.getBoundingBox().center(), 16);
+  FlatElevationProvider eleProvider;
+  MeshBuilder builder(quadKey, eleProvider);
+  ColorGradient gradient;
+  TextureRegion textureRegion;
+  MeshBuilder::GeometryOptions geometryOptions(state.range(0) * 1E-10, 0, 0, 0);
+  MeshBuilder::AppearanceOptions appearanceOptions(gradient, 0, 0, textureRegion, 0);
+  std::size_t triangles = 0;
+  for (auto _ : state) {
+    Mesh mesh("");
+    for (const auto &contour : contours) {
+      Polygon polygon(contour.size(), 0);
+      polygon.addContour(contour);
+      builder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+    }
+    triangles = mesh.triangles.size() / 3;
+  }
+  state.SetItemsProcessed(state.iterations() * contours.size());
+  state.counters["triangles"] = static_cast<double>(triangles);
+}
+
+}
+
+BENCHMARK(MeshBuilder_AddPolygon)->Arg(0)->Arg(10000)->Arg(1000)->Unit(benchmark::kMillisecond);
@@ -647,18 +647,27 @@ struct memorypool {
 };
 
 
+/* Global state is kept per thread, so different meshes can be triangulated */
+/*   concurrently: everything else is stored in mesh and behavior structures.*/
+
+#ifdef _MSC_VER
+#define THREADLOCAL __declspec(thread)
+#else /* not _MSC_VER */
+#define THREADLOCAL __thread
+#endif /* not _MSC_VER */
+
 /* Global constants.                                                         */
 
-REAL splitter;       /* Used to split REAL factors for exact multiplication. */
-REAL epsilon;                             /* Floating-point machine epsilon. */
-REAL resulterrbound;
-REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
-REAL iccerrboundA, iccerrboundB, iccerrboundC;
-REAL o3derrboundA, o3derrboundB, o3derrboundC;
+THREADLOCAL REAL splitter;  /* Used to split REAL factors for exact mult. */
+THREADLOCAL REAL epsilon;                 /* Floating-point machine epsilon. */
+THREADLOCAL REAL resulterrbound;
+THREADLOCAL REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
+THREADLOCAL REAL iccerrboundA, iccerrboundB, iccerrboundC;
+THREADLOCAL REAL o3derrboundA, o3derrboundB, o3derrboundC;
 
 /* Random number seed is not constant, but I've made it global anyway.       */
 
-unsigned long randomseed;                     /* Current random number seed. */
+THREADLOCAL unsigned long randomseed;         /* Current random number seed. */
 
 
 /* Mesh data structure.  Triangle operates on only one mesh, but the mesh    */
@@ -6,10 +6,16 @@
 #include "Search.hpp"
 #include "Storage.hpp"
 
+#include "heightmap/CompressedElevationProvider.hpp"
 #include "heightmap/FlatElevationProvider.hpp"
 #include "heightmap/GridElevationProvider.hpp"
 #include "heightmap/SrtmElevationProvider.hpp"
 #include "mapcss/MapCssParser.hpp"
+#include "mapcss/StyleSheetStream.hpp"
+#include "utils/ReadWriteLock.hpp"
+
+#include <atomic>
+#include <mutex>
 
 /// Composes object graph and exposes functionality as API.
 class Application {
@@ -20,6 +26,7 @@ class Application {
              std::bind(&Application::getStyleProvider, this, std::placeholders::_1),
              std::bind(&Application::getElevationProvider, this, std::placeholders::_1, std::placeholders::_2)),
     flatEleProvider_(), srtmEleProvider_(indexPath), gridEleProvider_(indexPath),
+    compressedEleProvider_(indexPath),
     configuration_(context_), search_(context_), storage_(context_)
   {}
 
@@ -39,25 +46,62 @@ class Application {
   }
 
  private:
-  /// Gets registered style provider by its style path.
+  /// Gets registered style provider by its style path. Provider is created once per path,
+  /// lookup of existing one takes shared lock only.
   const utymap::mapcss::StyleProvider &getStyleProvider(const std::string &stylePath) {
-    auto pair = styleProviders_.find(stylePath);
-    if (pair != styleProviders_.end())
-      return *pair->second;
+    StyleEntry *entry = nullptr;
+    {
+      utymap::utils::SharedLock lock(styleLock_);
+      auto pair = styleProviders_.find(stylePath);
+      if (pair != styleProviders_.end()) {
+        if (pair->second->isReady.load(std::memory_order_acquire))
+          return *pair->second->provider;
+        entry = pair->second.get();
+      }
+    }
+
+    if (entry == nullptr) {
+      std::lock_guard<utymap::utils::ReadWriteLock> lock(styleLock_);
+      auto &value = styleProviders_[stylePath];
+      if (value == nullptr)
+        value = utymap::utils::make_unique<StyleEntry>();
+      entry = value.get();
+    }
+
+    // NOTE concurrent requests for the same style wait here instead of parsing it again.
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (!entry->isReady.load(std::memory_order_relaxed)) {
+      entry->provider = createStyleProvider(stylePath);
+      entry->isReady.store(true, std::memory_order_release);
+    }
+    return *entry->provider;
+  }
 
+  /// Creates style provider from compiled stylesheet stored in index or from mapcss file.
+  std::unique_ptr<const utymap::mapcss::StyleProvider> createStyleProvider(const std::string &stylePath) {
     std::ifstream styleFile(stylePath);
     if (!styleFile.good())
       throw std::invalid_argument(std::string("Cannot read mapcss file:") + stylePath);
+    std::string content((std::istreambuf_iterator<char>(styleFile)), std::istreambuf_iterator<char>());
+
+    // NOTE compiled stylesheet is stored in index, so parsing is skipped while sources are not changed.
+    std::string compiledPath = context_.indexPath + "/" +
+        utymap::utils::toString(std::hash<std::string>()(stylePath)) + ".style";
+    utymap::mapcss::StyleSheet stylesheet;
+    std::ifstream compiledFile(compiledPath, std::ios::binary);
+    if (!compiledFile.good() || !utymap::mapcss::StyleSheetStream::read(compiledFile, content, stylesheet)) {
+      // NOTE not safe, but don't want to use boost filesystem only for this task.
+      std::string dir = stylePath.substr(0, stylePath.find_last_of("\\/") + 1);
+      utymap::mapcss::MapCssParser parser(dir);
+      stylesheet = parser.parse(content);
+
+      compiledFile.close();
+      std::ofstream output(compiledPath, std::ios::binary | std::ios::trunc);
+      if (output.good())
+        utymap::mapcss::StyleSheetStream::write(output, content, stylesheet);
+    }
 
-    // NOTE not safe, but don't want to use boost filesystem only for this task.
-    std::string dir = stylePath.substr(0, stylePath.find_last_of("\\/") + 1);
-    utymap::mapcss::MapCssParser parser(dir);
-    utymap::mapcss::StyleSheet stylesheet = parser.parse(styleFile);
-
-    styleProviders_.emplace(stylePath,
-      utymap::utils::make_unique<const utymap::mapcss::StyleProvider>(stylesheet, context_.stringTable));
-
-    return *styleProviders_[stylePath];
+    return utymap::utils::make_unique<const utymap::mapcss::StyleProvider>(stylesheet, context_.stringTable);
   }
 
   /// Gets registered elevation provider by its type and requested quad key.
@@ -66,6 +110,7 @@ class Application {
     switch (eleDataType) {
       case ElevationDataType::Grid: return gridEleProvider_;
       case ElevationDataType::Srtm: return srtmEleProvider_;
+      case ElevationDataType::CompressedSrtm: return compressedEleProvider_;
       default: return flatEleProvider_;
     }
   }
@@ -75,7 +120,19 @@ class Application {
   utymap::heightmap::FlatElevationProvider flatEleProvider_;
   utymap::heightmap::SrtmElevationProvider srtmEleProvider_;
   utymap::heightmap::GridElevationProvider gridEleProvider_;
-  std::unordered_map<std::string, std::unique_ptr<const utymap::mapcss::StyleProvider>> styleProviders_;
+  utymap::heightmap::CompressedElevationProvider compressedEleProvider_;
+
+  /// Holds style provider which is created on first request.
+  struct StyleEntry {
+    StyleEntry() : isReady(false) {}
+    std::mutex mutex;
+    std::atomic<bool> isReady;
+    std::unique_ptr<const utymap::mapcss::StyleProvider> provider;
+  };
+
+  /// NOTE entries are never removed, so they can be used outside of lock.
+  std::unordered_map<std::string, std::unique_ptr<StyleEntry>> styleProviders_;
+  utymap::utils::ReadWriteLock styleLock_;
 
   Configuration configuration_;
   Search search_;
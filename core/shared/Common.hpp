@@ -4,10 +4,15 @@
 #include "builders/QuadKeyBuilder.hpp"
 #include "heightmap/ElevationProvider.hpp"
 #include "index/GeoStore.hpp"
+#include "utils/ThreadPool.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 /// Callback which is called when directory should be created.
 /// NOTE with C++11, directory cannot be created with header only libs.
@@ -22,6 +27,55 @@ typedef void OnMeshBuilt(int tag,                                // a request ta
                          const double *uvs, int uvSize,          // absolute texture uvs
                          const int *uvMap, int uvMapSize);       // map with info about used atlas and texture region
 
+/// Callback which is called when mesh is built in float output mode. Vertices are offsets from
+/// origin, so float keeps precision inside of tile.
+typedef void OnMeshBuiltFloat(int tag,                                       // a request tag
+                              const char *name,                              // name
+                              double originX, double originY,                // origin (x, y) of tile
+                              const float *vertices, int vertexSize,         // vertices (dx, dy, elevation)
+                              const int *triangles, int triSize,             // triangle indices
+                              const int *colors, int colorSize,              // rgba colors
+                              const float *uvs, int uvSize,                  // absolute texture uvs
+                              const int *uvMap, int uvMapSize);              // map with info about used atlas and texture region
+
+/// Callback which is called when mesh is built in interleaved output mode. Vertex data is array
+/// of utymap::builders::InterleavedVertex which can be uploaded to GPU as is. Indices are 16 bit
+/// when amount of vertices allows that, otherwise they are 32 bit.
+typedef void OnInterleavedMeshBuilt(int tag,                                  // a request tag
+                                    const char *name,                         // name
+                                    double originX, double originY,           // origin (x, y) of tile
+                                    const void *vertexData, int vertexCount,  // interleaved vertices
+                                    int vertexStride,                         // size of vertex in bytes
+                                    const void *indexData, int indexCount,    // triangle indices
+                                    int indexStride);                         // size of index in bytes
+
+/// Callback which is called when mesh is built and its ownership is passed to host. Arrays stay
+/// valid until mesh is released by its handle, so host can use them without copying.
+typedef void OnMeshOwned(int tag,                                // a request tag
+                         std::uint64_t handle,                   // handle to release mesh
+                         const char *name,                       // name
+                         const double *vertices, int vertexSize, // vertices (x, y, elevation)
+                         const int *triangles, int triSize,      // triangle indices
+                         const int *colors, int colorSize,       // rgba colors
+                         const double *uvs, int uvSize,          // absolute texture uvs
+                         const int *uvMap, int uvMapSize);       // map with info about used atlas and texture region
+
+/// Callback which is called when mesh is written into buffers provided by host. Every array
+/// of mesh is passed as offset and size of its items in the corresponding buffer.
+typedef void OnMeshWritten(int tag,                                // a request tag
+                           const char *name,                       // name
+                           int vertexOffset, int vertexSize,       // vertices (x, y, elevation)
+                           int triOffset, int triSize,             // triangle indices
+                           int colorOffset, int colorSize,         // rgba colors
+                           int uvOffset, int uvSize,               // absolute texture uvs
+                           int uvMapOffset, int uvMapSize);        // map with info about used atlas and texture region
+
+/// Callback which is called with instances of prototype mesh which was passed to mesh callback
+/// before. Translations are added to prototype vertices, so they use the same order.
+typedef void OnInstancesBuilt(int tag,                                   // a request tag
+                              const char *prototypeName,                 // prototype mesh name
+                              const double *translations, int transSize); // translations (x, y, elevation)
+
 /// Callback which is called when element is loaded.
 typedef void OnElementLoaded(int tag,                                // a request tag
                              std::uint64_t id,                       // element id
@@ -29,11 +83,94 @@ typedef void OnElementLoaded(int tag,                                // a reques
                              const double *vertices, int vertexSize, // vertices (x, y, elevation)
                              const char **style, int styleSize);     // mapcss styles (key, value)
 
+/// Callback which is called with batch of loaded elements. Data of all elements is packed
+/// into shared arrays: element i uses items from offsets[i] to offsets[i + 1] of tags,
+/// vertices and styles arrays, so every offsets array has count + 1 items.
+typedef void OnElementsLoaded(int tag,                                         // a request tag
+                              const std::uint64_t *ids, int count,             // element ids
+                              const char **tags, const int *tagOffsets,        // tags
+                              const double *vertices, const int *vertexOffsets, // vertices (x, y, elevation)
+                              const char **styles, const int *styleOffsets);   // mapcss styles (key, value)
+
+/// Callback which is called with strings of ids which are not passed yet within request.
+/// NOTE strings stay valid while application exists, so host can intern them once.
+typedef void OnStringsAdded(int tag,                         // a request tag
+                            const std::uint32_t *ids,        // string ids
+                            const char **strings, int count); // strings
+
+/// Callback which is called when element is loaded. Tags and styles are passed as string ids,
+/// their strings are passed to strings callback before the first element which uses them.
+typedef void OnElementIdsLoaded(int tag,                                   // a request tag
+                                std::uint64_t id,                          // element id
+                                const std::uint32_t *tags, int tagsSize,   // tag ids (key, value)
+                                const double *vertices, int vertexSize,    // vertices (x, y, elevation)
+                                const std::uint32_t *styles, int styleSize); // mapcss style ids (key, value)
+
+/// Callback which is called periodically while data is imported. Time of phases is in seconds
+/// and is summed over all import threads.
+typedef void OnImportProgress(std::uint64_t bytesParsed,    // bytes of files parsed so far
+                              std::uint64_t bytesTotal,     // bytes of all imported files
+                              std::uint64_t elementsParsed, // elements read from files
+                              std::uint64_t elementsStored, // elements accepted by style
+                              std::uint64_t tilesWritten,   // quad keys which got elements
+                              double parseTime,             // time of reading files
+                              double styleTime,             // time of style matching
+                              double clipTime,              // time of geometry clipping
+                              double writeTime);            // time of writing to store
+
+/// Callback which is called with style rule statistics serialized as json.
+typedef void OnStyleProfile(const char *profile);
+
+/// Callback which is called when prioritized request is finished or dropped.
+typedef void OnRequestCompleted(int tag, int isCancelled);
+
+/// Callback which is called when tile of baked region is built.
+typedef void OnBakeProgress(std::uint64_t tilesBuilt,   // tiles built so far
+                            std::uint64_t tilesTotal,   // tiles of region
+                            double seconds);            // time since bake is started
+
 /// Callback which is called when error is occured.
 typedef void OnError(const char *errorMessage);
 
 /// Specifies mapping from integer to elevation data type.
-enum class ElevationDataType { Flat = 0, Srtm, Grid };
+enum class ElevationDataType { Flat = 0, Srtm, Grid, CompressedSrtm };
+
+/// Specifies mapping from integer to thread pool of context.
+enum class ThreadPoolType { Cpu = 0, Io };
+
+/// Specifies mapping from integer to subsystem which caches are released by memory trim.
+enum class MemorySubsystem { StringTable = 0, PersistentStores, Elevation, MeshPools, MeshCaches, Count };
+
+/// Specifies mapping from integer to memory trim level: moderate level releases caches
+/// down to their floors, critical level releases them entirely.
+enum class MemoryTrimLevel { Moderate = 0, Critical };
+
+/// Thread pools which are shared by all contexts of process, so several applications do not
+/// oversubscribe cores. Pools are destroyed with the last context which uses them.
+/// NOTE pool configuration is applied to every application of process.
+struct ThreadPools final {
+  ThreadPools() :
+    cpu(std::max(1u, std::thread::hardware_concurrency())),
+    io(DefaultIoThreads) {}
+
+  static const std::size_t DefaultIoThreads = 2;
+
+  /// Returns pools which are used by existing contexts or creates new ones.
+  static std::shared_ptr<ThreadPools> acquire() {
+    static std::mutex lock;
+    static std::weak_ptr<ThreadPools> shared;
+    std::lock_guard<std::mutex> guard(lock);
+    auto pools = shared.lock();
+    if (pools == nullptr) {
+      pools = std::make_shared<ThreadPools>();
+      shared = pools;
+    }
+    return pools;
+  }
+
+  utymap::utils::ThreadPool cpu;
+  utymap::utils::ThreadPool io;
+};
 
 /// Provides shared context properties.
 struct Context {
@@ -43,13 +180,24 @@ struct Context {
   Context(const std::string& indexPath,
           const StyleProviderGetter& styleProviderGetter,
           const ElevationProviderGetter& elevationProviderGetter) :
+    threadPools(ThreadPools::acquire()),
+    cpuPool(threadPools->cpu),
+    ioPool(threadPools->io),
     indexPath(indexPath),
     stringTable(indexPath),
-    geoStore(stringTable),
-    quadKeyBuilder(geoStore, stringTable),
+    geoStore(stringTable, &cpuPool),
+    quadKeyBuilder(geoStore, stringTable, &cpuPool),
     getStyleProvider(styleProviderGetter),
     getElevationProvider(elevationProviderGetter) { }
 
+  /// NOTE pools are declared first, so they outlive components which use them. Components
+  /// wait for their own tasks, so pools can outlive context.
+  std::shared_ptr<ThreadPools> threadPools;
+  /// Runs parallel parts of import, search and build. Thread settings of these features
+  /// limit amount of their parallel tasks while pool limits amount of threads.
+  utymap::utils::ThreadPool &cpuPool;
+  /// Runs background reads such as prefetch.
+  utymap::utils::ThreadPool &ioPool;
   const std::string indexPath;
   utymap::index::StringTable stringTable;
   utymap::index::GeoStore geoStore;
@@ -59,7 +207,7 @@ struct Context {
 };
 
 /// Executes function and catches exception if it occurs.
-inline void safeExecute(const std::function<void()> &action, OnError *errorCallback) {
+inline void safeExecute(const std::function<void()> &action, const std::function<OnError> &errorCallback) {
   try {
     action();
   }
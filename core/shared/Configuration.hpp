@@ -5,19 +5,30 @@
 
 #include "builders/CacheBuilder.hpp"
 #include "builders/MeshCache.hpp"
+#include "builders/MeshPool.hpp"
 #include "builders/misc/LampBuilder.hpp"
 #include "builders/misc/BarrierBuilder.hpp"
 #include "builders/poi/TreeBuilder.hpp"
 #include "builders/buildings/BuildingBuilder.hpp"
 #include "builders/terrain/TerraBuilder.hpp"
+#include "builders/terrain/TerraCache.hpp"
 #include "mapcss/StyleProvider.hpp"
 #include "index/InMemoryElementStore.hpp"
 #include "index/PersistentElementStore.hpp"
+#include "utils/Metrics.hpp"
+#include "utils/Tracer.hpp"
+
+#include <fstream>
+#include <sstream>
 
 /// Exposes configuration API.
 class Configuration {
   const int MinLevelOfDetail = 1;
   const int MaxLevelOfDetail = 16;
+  /// Elevation types which providers have caches.
+  const ElevationDataType ElevationTypes[3] = {
+    ElevationDataType::Srtm, ElevationDataType::Grid, ElevationDataType::CompressedSrtm
+  };
 public:
   explicit Configuration(Context& context) : context_(context) {
     registerDefaultBuilders();
@@ -31,18 +42,231 @@ public:
   }
 
   /// Registers new in-memory store.
-  void registerInMemoryStore(const char *key) const {
-    context_.geoStore.registerStore(key,
-      utymap::utils::make_unique<utymap::index::InMemoryElementStore>(context_.stringTable));
+  void registerInMemoryStore(const char *key) {
+    registerInMemoryStore(key, 0, false);
+  }
+
+  /// Registers new in-memory store with given memory budget in bytes. Least recently used
+  /// quad keys above budget are dropped or, if spill is enabled, moved to temporary disk store.
+  void registerInMemoryStore(const char *key, std::size_t maxBytes, bool isSpillEnabled) {
+    auto store = utymap::utils::make_unique<utymap::index::InMemoryElementStore>(
+      context_.stringTable, utymap::index::InMemoryElementStore::StorageMode::Copy, maxBytes, isSpillEnabled);
+    inMemoryStores_[key] = store.get();
+    context_.geoStore.registerStore(key, std::move(store));
+  }
+
+  /// Gets approximate memory footprint of in-memory store. Returns false if there is no such store.
+  bool getInMemoryStoreFootprint(const char *key, std::size_t &bytes) const {
+    auto store = inMemoryStores_.find(key);
+    if (store == inMemoryStores_.end())
+      return false;
+
+    bytes = store->second->getFootprint();
+    return true;
+  }
+
+  /// Writes snapshot of in-memory store to given path. Returns false if there is no such store
+  /// or snapshot cannot be written.
+  bool saveInMemoryStoreSnapshot(const char *key, const char *path, OnError *errorCallback) {
+    auto store = inMemoryStores_.find(key);
+    if (store == inMemoryStores_.end())
+      return false;
+
+    bool isSaved = false;
+    ::safeExecute([&]() {
+      store->second->saveSnapshot(path);
+      isSaved = true;
+    }, errorCallback);
+    return isSaved;
+  }
+
+  /// Adds elements of snapshot to in-memory store. Returns false if there is no such store
+  /// or snapshot cannot be read.
+  bool loadInMemoryStoreSnapshot(const char *key, const char *path, OnError *errorCallback) {
+    auto store = inMemoryStores_.find(key);
+    if (store == inMemoryStores_.end())
+      return false;
+
+    bool isLoaded = false;
+    ::safeExecute([&]() {
+      store->second->loadSnapshot(path);
+      isLoaded = true;
+    }, errorCallback);
+    return isLoaded;
   }
 
   /// Registers new persistent store.
-  void registerPersistentStore(const char *key, const char *dataPath, OnNewDirectory *directoryCallback) const {
-    context_.geoStore.registerStore(key,
-      utymap::utils::make_unique<utymap::index::PersistentElementStore>(dataPath, context_.stringTable));
+  void registerPersistentStore(const char *key, const char *dataPath, OnNewDirectory *directoryCallback) {
+    registerPersistentStore(key, dataPath,
+                            utymap::index::PersistentElementStore::DefaultMaxOpenFiles,
+                            utymap::index::PersistentElementStore::DefaultMaxBitmapBytes,
+                            directoryCallback);
+  }
+
+  /// Registers new persistent store with given limits of open files and cached bitmap memory.
+  void registerPersistentStore(const char *key, const char *dataPath,
+                               std::size_t maxOpenFiles, std::size_t maxBitmapBytes,
+                               OnNewDirectory *directoryCallback) {
+    auto store = utymap::utils::make_unique<utymap::index::PersistentElementStore>(
+      dataPath, context_.stringTable, maxOpenFiles, maxBitmapBytes);
+    store->setPrefetchPool(&context_.ioPool);
+    persistentStores_[key] = store.get();
+    context_.geoStore.registerStore(key, std::move(store));
     createDataDirs(dataPath, directoryCallback);
   }
 
+  /// Registers read only persistent store which reads package exported by exportPackage.
+  /// NOTE application should be created with package path as index path to use its string table.
+  void registerPackageStore(const char *key, const char *packagePath) {
+    auto store = utymap::utils::make_unique<utymap::index::PersistentElementStore>(packagePath, context_.stringTable);
+    store->setReadOnly(true);
+    store->setPrefetchPool(&context_.ioPool);
+    persistentStores_[key] = store.get();
+    context_.geoStore.registerStore(key, std::move(store));
+  }
+
+  /// Exports persistent store and string table into package directory. Returns false if there is no such store.
+  bool exportPackage(const char *key, const char *packagePath) {
+    auto store = persistentStores_.find(key);
+    if (store == persistentStores_.end())
+      return false;
+
+    store->second->exportPackage(packagePath);
+    context_.stringTable.exportTo(std::string(packagePath) + "/");
+    return true;
+  }
+
+  /// Gets cache statistics of persistent store. Returns false if there is no such store.
+  bool getPersistentStoreStatistics(const char *key,
+                                    utymap::index::PersistentElementStore::CacheStatistics &statistics) const {
+    auto store = persistentStores_.find(key);
+    if (store == persistentStores_.end())
+      return false;
+
+    statistics = store->second->getCacheStatistics();
+    return true;
+  }
+
+  /// Sets amount of tasks used to decode pbf data and shapefile records while importing. Zero disables parallel decoding.
+  void setImportThreads(int threadCount) {
+    context_.geoStore.setImportThreads(threadCount > 0 ? static_cast<std::size_t>(threadCount) : 0);
+  }
+
+  /// Sets amount of files parsed concurrently by batch import. Zero means amount of hardware threads.
+  void setImportFileThreads(int threadCount) {
+    context_.geoStore.setImportFileThreads(threadCount > 0 ? static_cast<std::size_t>(threadCount) : 0);
+  }
+
+  /// Sets amount of tasks used to mesh terrain regions of tile concurrently. Zero disables it.
+  void setBuildThreads(int threadCount) {
+    context_.quadKeyBuilder.setBuildThreads(threadCount > 0 ? static_cast<std::size_t>(threadCount) : 0);
+  }
+
+  /// Replaces threads of given pool (0 for CPU, 1 for I/O work) with given amount of threads which
+  /// run parallel work of all features. Core mask binds them to cores, e.g. big cores of big.LITTLE
+  /// device, zero means any core. Positive niceness lowers their scheduling priority.
+  /// NOTE queued work is finished first and new work waits until threads are replaced. Pools are
+  /// shared by all applications of process, so they are configured for all of them.
+  void configureThreadPool(int poolType, int threadCount, std::uint64_t coreMask, int niceness) {
+    auto &threadPool = static_cast<ThreadPoolType>(poolType) == ThreadPoolType::Io ? context_.ioPool : context_.cpuPool;
+    // NOTE pool keeps at least one thread as background tasks do not run without workers.
+    threadPool.configure(static_cast<std::size_t>(std::max(threadCount, 1)), coreMask, niceness);
+  }
+
+  /// Enables or disables merging of mesh vertices with the same position, color and texture coordinates.
+  void enableMeshWelding(int enabled) {
+    context_.quadKeyBuilder.setMeshWelding(enabled > 0);
+  }
+
+  /// Enables or disables running element builders of tile as separate tasks on build threads.
+  void enableParallelBuilders(int enabled) {
+    context_.quadKeyBuilder.setParallelBuilders(enabled > 0);
+  }
+
+  /// Enables or disables progressive delivery: terrain is passed to host first, then buildings,
+  /// then other details, each of them as soon as it is built.
+  void enableProgressiveDelivery(int enabled) {
+    context_.quadKeyBuilder.setProgressiveOrder(enabled > 0
+                                                ? std::vector<std::string>{ "terrain", "building" }
+                                                : std::vector<std::string>());
+  }
+
+  /// Enables or disables emitting repeated meshes, such as trees, once with their instances.
+  /// Requests without instances callback still get copied meshes.
+  void enableInstancing(int enabled) {
+    context_.quadKeyBuilder.setInstancing(enabled > 0);
+  }
+
+  /// Sets max amount of vertices in mesh which merges buildings of tile with the same textures.
+  /// Zero disables merging.
+  void setBatchVertexLimit(int vertexLimit) {
+    context_.quadKeyBuilder.setBatchVertexLimit(static_cast<std::size_t>(std::max(vertexLimit, 0)));
+  }
+
+  /// Sets max amount of memory retained by pools of meshes reused between builds.
+  void setMeshPoolMaxBytes(std::uint64_t maxBytes) {
+    utymap::builders::MeshPool::setMaxBytes(static_cast<std::size_t>(maxBytes));
+  }
+
+  /// Gets statistics of pools of meshes reused between builds.
+  utymap::builders::MeshPool::Statistics getMeshPoolStatistics() const {
+    return utymap::builders::MeshPool::getStatistics();
+  }
+
+  /// Sets resolution of grid which caches elevation of tile during its build. Zero disables it.
+  void setElevationCacheResolution(int resolution) {
+    context_.quadKeyBuilder.setElevationCacheResolution(resolution);
+  }
+
+  /// Sets callback which receives import progress. Null disables it.
+  void setImportProgressCallback(OnImportProgress *progressCallback) {
+    if (progressCallback == nullptr) {
+      context_.geoStore.setImportProgress(nullptr);
+      return;
+    }
+    context_.geoStore.setImportProgress([progressCallback](const utymap::index::ImportStatistics::Snapshot &snapshot) {
+      progressCallback(snapshot.bytesParsed, snapshot.bytesTotal, snapshot.elementsParsed, snapshot.elementsStored,
+                       snapshot.tilesWritten, snapshot.parseTime, snapshot.styleTime, snapshot.clipTime, snapshot.writeTime);
+    });
+  }
+
+  /// Enables two pass import of osm files which decreases memory usage.
+  void setTwoPassImport(bool enabled) {
+    context_.geoStore.setTwoPassImport(enabled);
+  }
+
+  /// Enables clipping of elements by tiles of previous level of detail before children tiles.
+  void setHierarchicalClipping(bool enabled) {
+    context_.geoStore.setHierarchicalClipping(enabled);
+  }
+
+  /// Sets directory for node location files used while importing large osm files.
+  void setNodeLocationDirectory(const char *directory) {
+    context_.geoStore.setNodeLocationDirectory(directory == nullptr ? "" : directory);
+  }
+
+  /// Sets directory for checkpoints which let interrupted imports resume. Null or empty disables them.
+  void setCheckpointDirectory(const char *directory) {
+    context_.geoStore.setCheckpointDirectory(directory == nullptr ? "" : directory);
+  }
+
+  /// Sets amount of tasks used to search registered stores concurrently. Zero disables parallel search.
+  void setSearchThreads(int threadCount) {
+    context_.geoStore.setSearchThreads(threadCount > 0 ? static_cast<std::size_t>(threadCount) : 0);
+  }
+
+  /// Compiles string table into sealed read only snapshot used on next start.
+  void sealStringTable() {
+    context_.stringTable.seal();
+  }
+
+  /// Sets durability mode of string table: strings are synced with storage device if enabled.
+  void setStringTableDurability(int isSafe) {
+    context_.stringTable.setDurability(isSafe > 0
+                                       ? utymap::index::StringTable::Durability::Safe
+                                       : utymap::index::StringTable::Durability::Fast);
+  }
+
   /// Enables or disables mesh caching.
   void enableMeshCache(int enabled) {
     for (const auto &entry : meshCaches_) {
@@ -51,6 +275,133 @@ public:
     }
   }
 
+  /// Enables or disables collecting of rule statistics of given style.
+  void enableStyleProfiling(const char *styleFile, int enabled) const {
+    context_.getStyleProvider(styleFile).enableProfiling(enabled > 0);
+  }
+
+  /// Gets rule statistics of given style as json.
+  std::string getStyleProfile(const char *styleFile) const {
+    return context_.getStyleProvider(styleFile).getProfile();
+  }
+
+  /// Gets process wide counters and latency histograms of data pipeline as json.
+  std::string getStatistics() const {
+    return utymap::utils::Metrics::toJson();
+  }
+
+  /// Gets approximate memory used by caches and stores per subsystem as json. Values are in bytes.
+  /// NOTE elevation includes size of mapped files which might be not resident.
+  std::string getMemoryUsage() const {
+    std::uint64_t persistentBytes = 0, inMemoryBytes = 0, elevationBytes = 0, meshCacheBytes = 0;
+    for (const auto &entry : persistentStores_)
+      persistentBytes += entry.second->getCacheStatistics().bitmapBytes;
+    for (const auto &entry : inMemoryStores_)
+      inMemoryBytes += entry.second->getFootprint();
+    for (auto type : ElevationTypes)
+      elevationBytes += context_.getElevationProvider(utymap::QuadKey(), type).getMemoryUsage();
+    for (const auto &entry : meshCaches_)
+      meshCacheBytes += entry.second->getMemoryUsage();
+    std::uint64_t stringBytes = context_.stringTable.getMemoryUsage();
+    std::uint64_t meshPoolBytes = utymap::builders::MeshPool::getStatistics().retainedBytes;
+
+    std::stringstream ss;
+    ss << "{\"stringTable\":" << stringBytes << ",\"persistentStores\":" << persistentBytes
+       << ",\"inMemoryStores\":" << inMemoryBytes << ",\"elevation\":" << elevationBytes
+       << ",\"meshPools\":" << meshPoolBytes << ",\"meshCaches\":" << meshCacheBytes
+       << ",\"total\":" << stringBytes + persistentBytes + inMemoryBytes + elevationBytes + meshPoolBytes + meshCacheBytes
+       << "}";
+    return ss.str();
+  }
+
+  /// Sets memory which caches of given subsystem keep when memory is trimmed at moderate level.
+  /// Floor is shared equally by instances of subsystem, e.g. by persistent stores.
+  void setMemoryFloor(int subsystem, std::uint64_t bytes) {
+    if (subsystem >= 0 && subsystem < static_cast<int>(MemorySubsystem::Count))
+      memoryFloors_[subsystem] = bytes;
+  }
+
+  /// Sets max amount of grids which grid elevation provider keeps loaded.
+  void setGridElevationCacheSize(int maxCacheSize) {
+    context_.getElevationProvider(utymap::QuadKey(), ElevationDataType::Grid).setMaxCacheSize(maxCacheSize);
+  }
+
+  /// Releases caches under memory pressure: moderate level keeps memory set by setMemoryFloor,
+  /// critical level releases caches entirely. Released data is loaded again on demand.
+  /// NOTE elements of in-memory stores are data, not cache, so they are not released.
+  void trimMemory(int level) {
+    bool isCritical = level >= static_cast<int>(MemoryTrimLevel::Critical);
+    auto getFloor = [&](MemorySubsystem subsystem, std::size_t count) {
+      return isCritical || count == 0
+             ? std::size_t(0)
+             : static_cast<std::size_t>(memoryFloors_[static_cast<int>(subsystem)] / count);
+    };
+
+    context_.stringTable.trimMemory(getFloor(MemorySubsystem::StringTable, 1));
+    for (const auto &entry : persistentStores_)
+      entry.second->trimCache(getFloor(MemorySubsystem::PersistentStores, persistentStores_.size()));
+    for (auto type : ElevationTypes)
+      context_.getElevationProvider(utymap::QuadKey(), type).trim(
+        getFloor(MemorySubsystem::Elevation, sizeof(ElevationTypes) / sizeof(ElevationTypes[0])));
+    utymap::builders::MeshPool::trimAll(getFloor(MemorySubsystem::MeshPools, 1));
+    for (const auto &entry : meshCaches_)
+      entry.second->trimMemory(getFloor(MemorySubsystem::MeshCaches, meshCaches_.size()));
+    if (isCritical)
+      terraCache_.clear();
+  }
+
+  /// Starts collecting trace zones of tile builds. Previously collected zones are discarded.
+  /// NOTE zones are collected only if library is built with tracing feature.
+  void startTracing() {
+    utymap::utils::Tracer::start();
+  }
+
+  /// Stops collecting trace zones and writes them to given file as chrome trace json.
+  bool stopTracing(const char *path) {
+    auto json = utymap::utils::Tracer::stop();
+    std::ofstream file(path, std::ios::trunc);
+    file << json;
+    return file.good();
+  }
+
+  /// Sets max amount of memory used by every mesh cache to keep recently fetched tiles.
+  /// Zero disables it.
+  void setMeshCacheMemoryLimit(std::uint64_t maxBytes) {
+    for (const auto &entry : meshCaches_)
+      entry.second->setMemoryLimit(static_cast<std::size_t>(maxBytes));
+  }
+
+  /// Sets max amount of disk space used by every mesh cache. The least recently used
+  /// tiles are removed once it is exceeded. Zero means no limit.
+  void setMeshCacheDiskLimit(std::uint64_t maxBytes) {
+    for (const auto &entry : meshCaches_)
+      entry.second->setDiskLimit(maxBytes);
+  }
+
+  /// Waits until built meshes are written to mesh caches.
+  void flushMeshCache() const {
+    for (const auto &entry : meshCaches_)
+      entry.second->flush();
+  }
+
+  /// Removes meshes cached with styles other than given ones.
+  void purgeMeshCache(const char **styleFiles, int count) const {
+    std::vector<std::string> tags;
+    for (int i = 0; i < count; ++i)
+      tags.push_back(context_.getStyleProvider(styleFiles[i]).getTag());
+    for (const auto &entry : meshCaches_)
+      entry.second->purge(tags);
+  }
+
+  /// Removes cached meshes of given quad keys built with given style.
+  void invalidateMeshCache(const char *styleFile, const std::vector<utymap::QuadKey> &quadKeys) const {
+    auto &styleProvider = context_.getStyleProvider(styleFile);
+    for (const auto &entry : meshCaches_) {
+      for (const auto &quadKey : quadKeys)
+        entry.second->invalidate(quadKey, styleProvider);
+    }
+  }
+
 private:
   /// Creates map data directories in given root directory.
   void createDataDirs(const std::string &root, OnNewDirectory *directoryCallback) const {
@@ -62,7 +413,10 @@ private:
 
   /// Registers default builders.
   void registerDefaultBuilders() {
-    registerBuilder<utymap::builders::TerraBuilder>("terrain", true);
+    registerBuilder<utymap::builders::TerraBuilder>("terrain", true,
+      [&](const utymap::builders::BuilderContext &context) {
+        return utymap::utils::make_unique<utymap::builders::TerraBuilder>(context, &terraCache_);
+      });
     registerBuilder<utymap::builders::BuildingBuilder>("building");
     registerBuilder<utymap::builders::TreeBuilder>("tree");
     registerBuilder<utymap::builders::BarrierBuilder>("barrier");
@@ -70,31 +424,47 @@ private:
   }
 
   template<typename Builder>
-  void registerBuilder(const std::string &name, bool useCache = false) {
+  void registerBuilder(const std::string &name, bool useCache = false,
+                       const utymap::builders::QuadKeyBuilder::ElementBuilderFactory &factory = createFactory<Builder>()) {
     if (useCache)
       meshCaches_.emplace(name, utymap::utils::make_unique<utymap::builders::MeshCache>(context_.indexPath, name));
 
     context_.quadKeyBuilder.registerElementBuilder(name,
-      useCache ? createCacheFactory<Builder>(name) : createFactory<Builder>());
+      useCache ? createCacheFactory<Builder>(name, factory) : factory);
   }
 
   template<typename Builder>
-  utymap::builders::QuadKeyBuilder::ElementBuilderFactory createFactory() const {
+  static utymap::builders::QuadKeyBuilder::ElementBuilderFactory createFactory() {
     return [](const utymap::builders::BuilderContext &context) {
       return utymap::utils::make_unique<Builder>(context);
     };
   }
 
   template<typename Builder>
-  utymap::builders::QuadKeyBuilder::ElementBuilderFactory createCacheFactory(const std::string &name) const {
+  utymap::builders::QuadKeyBuilder::ElementBuilderFactory createCacheFactory(
+      const std::string &name, const utymap::builders::QuadKeyBuilder::ElementBuilderFactory &factory) const {
     auto &meshCache = *meshCaches_.find(name)->second;
-    return [&, name](const utymap::builders::BuilderContext &context) {
-      return utymap::utils::make_unique<utymap::builders::CacheBuilder<Builder>>(meshCache, context);
+    return [&, name, factory](const utymap::builders::BuilderContext &context) {
+      return utymap::utils::make_unique<utymap::builders::CacheBuilder<Builder>>(meshCache, context, factory);
     };
   }
 
   Context &context_;
   std::unordered_map<std::string, std::unique_ptr<utymap::builders::MeshCache>> meshCaches_;
+  /// Merged terrain layers of recently built tiles.
+  utymap::builders::TerraCache terraCache_;
+  /// Persistent stores owned by geo store.
+  std::unordered_map<std::string, utymap::index::PersistentElementStore*> persistentStores_;
+  /// In-memory stores owned by geo store.
+  std::unordered_map<std::string, utymap::index::InMemoryElementStore*> inMemoryStores_;
+  /// Memory kept by subsystems when memory is trimmed at moderate level.
+  std::uint64_t memoryFloors_[static_cast<int>(MemorySubsystem::Count)] = {
+    1024 * 1024,      // string table
+    8 * 1024 * 1024,  // persistent stores
+    32 * 1024 * 1024, // elevation
+    16 * 1024 * 1024, // mesh pools
+    8 * 1024 * 1024   // mesh caches
+  };
 };
 
 #endif // CONFIGURATION_HPP_DEFINED
@@ -7,89 +7,1064 @@
 #endif
 
 #include "Application.hpp"
+#include "RequestLog.hpp"
 
 static Application *applicationPtr = nullptr;
 
+/// Copies json into buffer provided by host and returns size of buffer required for it.
+/// NOTE json is truncated if buffer is too small, required size is returned anyway.
+static int copyJson(const std::string &json, char *jsonBuffer, int size) {
+  if (jsonBuffer != nullptr && size > 0) {
+    auto count = std::min(json.size(), static_cast<std::size_t>(size - 1));
+    std::memcpy(jsonBuffer, json.data(), count);
+    jsonBuffer[count] = '\0';
+  }
+  return static_cast<int>(json.size() + 1);
+}
+
+static Application *toApplication(void *handle) {
+  return static_cast<Application *>(handle);
+}
+
 // Specifies export functions.
 // NOTE: see documentation comments in actual method implementation.
 extern "C"
 {
 
-/************* Lifecycle API *****************/
-void EXPORT_API disconnect() {
-  delete applicationPtr;
-}
+// NOTE functions take handle of application created by connectEx. Every handle owns its own
+// application with its own index, stores and caches, so several datasets can be served by one
+// process. Thread pools are shared by all of them.
 
-void EXPORT_API connect(const char *indexPath, OnError *errorCallback) {
+/************* Lifecycle API *****************/
+void EXPORT_API *connectEx(const char *indexPath, OnError *errorCallback) {
+  RequestLog::Call call(nullptr, "connect", indexPath);
   try {
-    applicationPtr = new Application(indexPath);
+    auto application = new Application(indexPath);
+    call.setHandle(application);
+    return application;
   } catch (std::exception &ex) {
     errorCallback(ex.what());
   }
+  return nullptr;
+}
+
+void EXPORT_API disconnectEx(void *handle) {
+  RequestLog::Call call(handle, "disconnect");
+  delete toApplication(handle);
 }
 
 /************* Configuration API *****************/
+void EXPORT_API registerStylesheetEx(void *handle, const char *path, OnNewDirectory *directoryCallback) {
+  RequestLog::Call call(handle, "registerStylesheet", path);
+  toApplication(handle)->getConfiguration().registerStylesheet(path, directoryCallback);
+}
+
+void EXPORT_API registerInMemoryStoreEx(void *handle, const char *key) {
+  RequestLog::Call call(handle, "registerInMemoryStore", key);
+  toApplication(handle)->getConfiguration().registerInMemoryStore(key);
+}
+
+void EXPORT_API registerInMemoryStoreWithBudgetEx(void *handle, const char *key, std::uint64_t maxBytes,
+                                                   int isSpillEnabled) {
+  RequestLog::Call call(handle, "registerInMemoryStoreWithBudget", key, maxBytes, isSpillEnabled);
+  toApplication(handle)->getConfiguration().registerInMemoryStore(key, static_cast<std::size_t>(maxBytes), isSpillEnabled > 0);
+}
+
+bool EXPORT_API getInMemoryStoreFootprintEx(void *handle, const char *key, std::uint64_t *bytes) {
+  RequestLog::Call call(handle, "getInMemoryStoreFootprint", key);
+  std::size_t footprint = 0;
+  if (!toApplication(handle)->getConfiguration().getInMemoryStoreFootprint(key, footprint))
+    return false;
+
+  *bytes = footprint;
+  return true;
+}
+
+bool EXPORT_API saveInMemoryStoreSnapshotEx(void *handle, const char *key, const char *path, OnError *errorCallback) {
+  RequestLog::Call call(handle, "saveInMemoryStoreSnapshot", key, path);
+  return toApplication(handle)->getConfiguration().saveInMemoryStoreSnapshot(key, path, errorCallback);
+}
+
+bool EXPORT_API loadInMemoryStoreSnapshotEx(void *handle, const char *key, const char *path, OnError *errorCallback) {
+  RequestLog::Call call(handle, "loadInMemoryStoreSnapshot", key, path);
+  return toApplication(handle)->getConfiguration().loadInMemoryStoreSnapshot(key, path, errorCallback);
+}
+
+void EXPORT_API registerPersistentStoreEx(void *handle, const char *key, const char *dataPath, OnNewDirectory *directoryCallback) {
+  RequestLog::Call call(handle, "registerPersistentStore", key, dataPath);
+  toApplication(handle)->getConfiguration().registerPersistentStore(key, dataPath, directoryCallback);
+}
+
+void EXPORT_API registerPersistentStoreWithLimitsEx(void *handle, const char *key, const char *dataPath,
+                                                    int maxOpenFiles, std::uint64_t maxBitmapBytes,
+                                                    OnNewDirectory *directoryCallback) {
+  RequestLog::Call call(handle, "registerPersistentStoreWithLimits", key, dataPath, maxOpenFiles, maxBitmapBytes);
+  toApplication(handle)->getConfiguration().registerPersistentStore(key, dataPath,
+    static_cast<std::size_t>(maxOpenFiles), static_cast<std::size_t>(maxBitmapBytes), directoryCallback);
+}
+
+void EXPORT_API registerPackageStoreEx(void *handle, const char *key, const char *packagePath) {
+  RequestLog::Call call(handle, "registerPackageStore", key, packagePath);
+  toApplication(handle)->getConfiguration().registerPackageStore(key, packagePath);
+}
+
+bool EXPORT_API exportPackageEx(void *handle, const char *key, const char *packagePath) {
+  RequestLog::Call call(handle, "exportPackage", key, packagePath);
+  return toApplication(handle)->getConfiguration().exportPackage(key, packagePath);
+}
+
+bool EXPORT_API getPersistentStoreStatisticsEx(void *handle, const char *key, std::uint64_t *hits, std::uint64_t *misses,
+                                               std::uint64_t *evictions, std::uint64_t *bitmapBytes) {
+  RequestLog::Call call(handle, "getPersistentStoreStatistics", key);
+  utymap::index::PersistentElementStore::CacheStatistics statistics;
+  if (!toApplication(handle)->getConfiguration().getPersistentStoreStatistics(key, statistics))
+    return false;
+
+  *hits = statistics.hits;
+  *misses = statistics.misses;
+  *evictions = statistics.evictions;
+  *bitmapBytes = statistics.bitmapBytes;
+  return true;
+}
+
+void EXPORT_API setSearchThreadsEx(void *handle, int threadCount) {
+  RequestLog::Call call(handle, "setSearchThreads", threadCount);
+  toApplication(handle)->getConfiguration().setSearchThreads(threadCount);
+}
+
+void EXPORT_API setImportThreadsEx(void *handle, int threadCount) {
+  RequestLog::Call call(handle, "setImportThreads", threadCount);
+  toApplication(handle)->getConfiguration().setImportThreads(threadCount);
+}
+
+void EXPORT_API setImportFileThreadsEx(void *handle, int threadCount) {
+  RequestLog::Call call(handle, "setImportFileThreads", threadCount);
+  toApplication(handle)->getConfiguration().setImportFileThreads(threadCount);
+}
+
+void EXPORT_API setBuildThreadsEx(void *handle, int threadCount) {
+  RequestLog::Call call(handle, "setBuildThreads", threadCount);
+  toApplication(handle)->getConfiguration().setBuildThreads(threadCount);
+}
+
+void EXPORT_API configureThreadPoolEx(void *handle, int poolType, int threadCount, std::uint64_t coreMask, int niceness) {
+  RequestLog::Call call(handle, "configureThreadPool", poolType, threadCount, coreMask, niceness);
+  toApplication(handle)->getConfiguration().configureThreadPool(poolType, threadCount, coreMask, niceness);
+}
+
+void EXPORT_API enableMeshWeldingEx(void *handle, int enabled) {
+  RequestLog::Call call(handle, "enableMeshWelding", enabled);
+  toApplication(handle)->getConfiguration().enableMeshWelding(enabled);
+}
+
+void EXPORT_API enableParallelBuildersEx(void *handle, int enabled) {
+  RequestLog::Call call(handle, "enableParallelBuilders", enabled);
+  toApplication(handle)->getConfiguration().enableParallelBuilders(enabled);
+}
+
+void EXPORT_API enableProgressiveDeliveryEx(void *handle, int enabled) {
+  RequestLog::Call call(handle, "enableProgressiveDelivery", enabled);
+  toApplication(handle)->getConfiguration().enableProgressiveDelivery(enabled);
+}
+
+void EXPORT_API enableInstancingEx(void *handle, int enabled) {
+  RequestLog::Call call(handle, "enableInstancing", enabled);
+  toApplication(handle)->getConfiguration().enableInstancing(enabled);
+}
+
+void EXPORT_API setBatchVertexLimitEx(void *handle, int vertexLimit) {
+  RequestLog::Call call(handle, "setBatchVertexLimit", vertexLimit);
+  toApplication(handle)->getConfiguration().setBatchVertexLimit(vertexLimit);
+}
+
+void EXPORT_API setMeshPoolMaxBytesEx(void *handle, std::uint64_t maxBytes) {
+  RequestLog::Call call(handle, "setMeshPoolMaxBytes", maxBytes);
+  toApplication(handle)->getConfiguration().setMeshPoolMaxBytes(maxBytes);
+}
+
+void EXPORT_API setGridElevationCacheSizeEx(void *handle, int maxCacheSize) {
+  RequestLog::Call call(handle, "setGridElevationCacheSize", maxCacheSize);
+  toApplication(handle)->getConfiguration().setGridElevationCacheSize(maxCacheSize);
+}
+
+void EXPORT_API getMeshPoolStatisticsEx(void *handle, std::uint64_t *hits, std::uint64_t *misses,
+                                        std::uint64_t *retainedBytes, std::uint64_t *trimmedBytes) {
+  RequestLog::Call call(handle, "getMeshPoolStatistics");
+  auto statistics = toApplication(handle)->getConfiguration().getMeshPoolStatistics();
+  *hits = statistics.hits;
+  *misses = statistics.misses;
+  *retainedBytes = statistics.retainedBytes;
+  *trimmedBytes = statistics.trimmedBytes;
+}
+
+void EXPORT_API setMeshCacheMemoryLimitEx(void *handle, std::uint64_t maxBytes) {
+  RequestLog::Call call(handle, "setMeshCacheMemoryLimit", maxBytes);
+  toApplication(handle)->getConfiguration().setMeshCacheMemoryLimit(maxBytes);
+}
+
+void EXPORT_API setMeshCacheDiskLimitEx(void *handle, std::uint64_t maxBytes) {
+  RequestLog::Call call(handle, "setMeshCacheDiskLimit", maxBytes);
+  toApplication(handle)->getConfiguration().setMeshCacheDiskLimit(maxBytes);
+}
+
+void EXPORT_API purgeMeshCacheEx(void *handle, const char **styleFiles, int count) {
+  RequestLog::Call call(handle, "purgeMeshCache", RequestLog::Strings{ styleFiles, count });
+  toApplication(handle)->getConfiguration().purgeMeshCache(styleFiles, count);
+}
+
+void EXPORT_API setElevationCacheResolutionEx(void *handle, int resolution) {
+  RequestLog::Call call(handle, "setElevationCacheResolution", resolution);
+  toApplication(handle)->getConfiguration().setElevationCacheResolution(resolution);
+}
+
+void EXPORT_API setImportProgressCallbackEx(void *handle, OnImportProgress *progressCallback) {
+  RequestLog::Call call(handle, "setImportProgressCallback", progressCallback != nullptr);
+  toApplication(handle)->getConfiguration().setImportProgressCallback(progressCallback);
+}
+
+void EXPORT_API setTwoPassImportEx(void *handle, bool enabled) {
+  RequestLog::Call call(handle, "setTwoPassImport", enabled);
+  toApplication(handle)->getConfiguration().setTwoPassImport(enabled);
+}
+
+void EXPORT_API setHierarchicalClippingEx(void *handle, bool enabled) {
+  RequestLog::Call call(handle, "setHierarchicalClipping", enabled);
+  toApplication(handle)->getConfiguration().setHierarchicalClipping(enabled);
+}
+
+void EXPORT_API setNodeLocationDirectoryEx(void *handle, const char *directory) {
+  RequestLog::Call call(handle, "setNodeLocationDirectory", directory);
+  toApplication(handle)->getConfiguration().setNodeLocationDirectory(directory);
+}
+
+void EXPORT_API setCheckpointDirectoryEx(void *handle, const char *directory) {
+  RequestLog::Call call(handle, "setCheckpointDirectory", directory);
+  toApplication(handle)->getConfiguration().setCheckpointDirectory(directory);
+}
+
+void EXPORT_API sealStringTableEx(void *handle) {
+  RequestLog::Call call(handle, "sealStringTable");
+  toApplication(handle)->getConfiguration().sealStringTable();
+}
+
+void EXPORT_API setStringTableDurabilityEx(void *handle, int isSafe) {
+  RequestLog::Call call(handle, "setStringTableDurability", isSafe);
+  toApplication(handle)->getConfiguration().setStringTableDurability(isSafe);
+}
+
+void EXPORT_API enableMeshCacheEx(void *handle, int enabled) {
+  RequestLog::Call call(handle, "enableMeshCache", enabled);
+  toApplication(handle)->getConfiguration().enableMeshCache(enabled);
+}
+
+void EXPORT_API enableStyleProfilingEx(void *handle, const char *styleFile, int enabled) {
+  RequestLog::Call call(handle, "enableStyleProfiling", styleFile, enabled);
+  toApplication(handle)->getConfiguration().enableStyleProfiling(styleFile, enabled);
+}
+
+void EXPORT_API getStyleProfileEx(void *handle, const char *styleFile, OnStyleProfile *profileCallback) {
+  RequestLog::Call call(handle, "getStyleProfile", styleFile);
+  profileCallback(toApplication(handle)->getConfiguration().getStyleProfile(styleFile).c_str());
+}
+
+int EXPORT_API getStatisticsEx(void *handle, char *jsonBuffer, int size) {
+  RequestLog::Call call(handle, "getStatistics", size);
+  return copyJson(toApplication(handle)->getConfiguration().getStatistics(), jsonBuffer, size);
+}
+
+int EXPORT_API getMemoryUsageEx(void *handle, char *jsonBuffer, int size) {
+  RequestLog::Call call(handle, "getMemoryUsage", size);
+  return copyJson(toApplication(handle)->getConfiguration().getMemoryUsage(), jsonBuffer, size);
+}
+
+void EXPORT_API setMemoryFloorEx(void *handle, int subsystem, std::uint64_t bytes) {
+  RequestLog::Call call(handle, "setMemoryFloor", subsystem, bytes);
+  toApplication(handle)->getConfiguration().setMemoryFloor(subsystem, bytes);
+}
+
+void EXPORT_API trimMemoryEx(void *handle, int level) {
+  RequestLog::Call call(handle, "trimMemory", level);
+  toApplication(handle)->getConfiguration().trimMemory(level);
+}
+
+void EXPORT_API startTracingEx(void *handle) {
+  RequestLog::Call call(handle, "startTracing");
+  toApplication(handle)->getConfiguration().startTracing();
+}
+
+bool EXPORT_API stopTracingEx(void *handle, const char *path) {
+  RequestLog::Call call(handle, "stopTracing", path);
+  return toApplication(handle)->getConfiguration().stopTracing(path);
+}
+
+/************* Storage API *****************/
+void EXPORT_API addDataInRangeEx(void *handle, const char *key, const char *styleFile, const char *path, int startLod, int endLod,
+                                 OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "addDataInRange", key, styleFile, path, startLod, endLod);
+  toApplication(handle)->getStorage().addToStore(key, styleFile, path, startLod, endLod, errorCallback, cancellationToken);
+}
+
+void EXPORT_API addDataInRangeBatchEx(void *handle, const char *key, const char **styleFiles, const char **paths, int count,
+                                      int startLod, int endLod,
+                                      OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "addDataInRangeBatch", key, RequestLog::Strings{ styleFiles, count },
+                        RequestLog::Strings{ paths, count }, startLod, endLod);
+  toApplication(handle)->getStorage().addToStore(key, styleFiles, paths, count, startLod, endLod, errorCallback, cancellationToken);
+}
+
+void EXPORT_API addDataInBoundingBoxEx(void *handle, const char *key, const char *styleFile, const char *path,
+                                       double minLat, double minLon, double maxLat,  double maxLon, int startLod, int endLod,
+                                       OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "addDataInBoundingBox", key, styleFile, path, minLat, minLon, maxLat, maxLon,
+                        startLod, endLod);
+  toApplication(handle)->getStorage().addToStore(key, styleFile, path, minLat, minLon, maxLat, maxLon, startLod, endLod, errorCallback, cancellationToken);
+}
+
+void EXPORT_API addDataInQuadKeyEx(void *handle, const char *key, const char *styleFile, const char *path,
+                                   int tileX, int tileY, int levelOfDetail,
+                                   OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "addDataInQuadKey", key, styleFile, path, tileX, tileY, levelOfDetail);
+  toApplication(handle)->getStorage().addToStore(key, styleFile, path, tileX, tileY, levelOfDetail, errorCallback, cancellationToken);
+}
+
+void EXPORT_API addDataInElementEx(void *handle, const char *key, const char *styleFile, std::uint64_t id, const double *vertices, int vertexLength,
+                                   const char **tags, int tagLength, int startLod, int endLod,
+                                   OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "addDataInElement", key, styleFile, id, RequestLog::Doubles{ vertices,
+                        vertexLength }, RequestLog::Strings{ tags, tagLength }, startLod, endLod);
+  toApplication(handle)->getStorage().addToStore(key, styleFile, id, vertices, vertexLength, tags, tagLength, startLod, endLod, errorCallback, cancellationToken);
+}
+
+void EXPORT_API applyChangesEx(void *handle, const char *key, const char *styleFile, const char *path, int startLod, int endLod,
+                               OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "applyChanges", key, styleFile, path, startLod, endLod);
+  auto application = toApplication(handle);
+  auto quadKeys = application->getStorage().applyChanges(key, styleFile, path, startLod, endLod, errorCallback, cancellationToken);
+  application->getConfiguration().invalidateMeshCache(styleFile, quadKeys);
+}
+
+bool EXPORT_API hasDataEx(void *handle, int tileX, int tileY, int levelOfDetail) {
+  RequestLog::Call call(handle, "hasData", tileX, tileY, levelOfDetail);
+  return toApplication(handle)->getStorage().hasData(tileX, tileY, levelOfDetail);
+}
+
+/// Gets amounts of nodes, ways, areas, relations, vertices and payload bytes stored for
+/// given quad key, so client can estimate cost of building tile.
+void EXPORT_API getTileSummaryEx(void *handle, int tileX, int tileY, int levelOfDetail, std::uint64_t *values) {
+  RequestLog::Call call(handle, "getTileSummary", tileX, tileY, levelOfDetail);
+  auto summary = toApplication(handle)->getStorage().getSummary(tileX, tileY, levelOfDetail);
+  values[0] = summary.nodes;
+  values[1] = summary.ways;
+  values[2] = summary.areas;
+  values[3] = summary.relations;
+  values[4] = summary.vertices;
+  values[5] = summary.bytes;
+}
+
+/************* Search API *****************/
+void EXPORT_API getDataByTextEx(void *handle, int tag, const char *notTerms, const char *andTerms, const char *orTerms,
+                                double minLatitude, double minLongitude, double maxLatitude, double maxLongitude, int startLod, int endLod,
+                                OnElementLoaded *elementCallback, OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByText", tag, notTerms, andTerms, orTerms, minLatitude, minLongitude,
+                        maxLatitude, maxLongitude, startLod, endLod);
+  toApplication(handle)->getSearch().getDataByText(tag, notTerms, andTerms, orTerms, minLatitude, minLongitude,maxLatitude, maxLongitude,
+    startLod, endLod, 0, 0, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByTextPageEx(void *handle, int tag, const char *notTerms, const char *andTerms, const char *orTerms,
+                                    double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                                    int startLod, int endLod, int offset, int limit,
+                                    OnElementLoaded *elementCallback, OnError *errorCallback,
+                                    utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByTextPage", tag, notTerms, andTerms, orTerms, minLatitude, minLongitude,
+                        maxLatitude, maxLongitude, startLod, endLod, offset, limit);
+  toApplication(handle)->getSearch().getDataByText(tag, notTerms, andTerms, orTerms, minLatitude, minLongitude,maxLatitude, maxLongitude,
+    startLod, endLod, offset, limit, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByTextBatchEx(void *handle, int tag, const char *notTerms, const char *andTerms, const char *orTerms,
+                                     double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                                     int startLod, int endLod, int offset, int limit, int batchSize,
+                                     OnElementsLoaded *elementsCallback, OnError *errorCallback,
+                                     utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByTextBatch", tag, notTerms, andTerms, orTerms, minLatitude, minLongitude,
+                        maxLatitude, maxLongitude, startLod, endLod, offset, limit, batchSize);
+  toApplication(handle)->getSearch().getDataByText(tag, notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude, maxLongitude,
+    startLod, endLod, offset, limit, batchSize, elementsCallback, errorCallback, cancellationToken);
+}
+
+int EXPORT_API countDataByTextEx(void *handle, const char *notTerms, const char *andTerms, const char *orTerms,
+                                 double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                                 int startLod, int endLod, OnError *errorCallback,
+                                 utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "countDataByText", notTerms, andTerms, orTerms, minLatitude, minLongitude,
+                        maxLatitude, maxLongitude, startLod, endLod);
+  return toApplication(handle)->getSearch().countDataByText(notTerms, andTerms, orTerms, minLatitude, minLongitude,
+    maxLatitude, maxLongitude, startLod, endLod, errorCallback, cancellationToken);
+}
+
+bool EXPORT_API existsDataByTextEx(void *handle, const char *notTerms, const char *andTerms, const char *orTerms,
+                                   double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                                   int startLod, int endLod, OnError *errorCallback,
+                                   utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "existsDataByText", notTerms, andTerms, orTerms, minLatitude, minLongitude,
+                        maxLatitude, maxLongitude, startLod, endLod);
+  return toApplication(handle)->getSearch().existsDataByText(notTerms, andTerms, orTerms, minLatitude, minLongitude,
+    maxLatitude, maxLongitude, startLod, endLod, errorCallback, cancellationToken);
+}
+
+bool EXPORT_API getDataByIdEx(void *handle, int tag, std::uint64_t id, OnElementLoaded *elementCallback, OnError *errorCallback) {
+  RequestLog::Call call(handle, "getDataById", tag, id);
+  return toApplication(handle)->getSearch().getDataById(tag, id, elementCallback, errorCallback);
+}
+
+void EXPORT_API getDataByQuadKeyEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                   OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback, OnError *errorCallback,
+                                   utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKey", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType);
+  toApplication(handle)->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, 
+    eleDataType, meshCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyBatchEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                        int batchSize, OnMeshBuilt *meshCallback, OnElementsLoaded *elementsCallback,
+                                        OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKeyBatch", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+                        batchSize);
+  toApplication(handle)->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail,
+    eleDataType, batchSize, meshCallback, elementsCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyFloatEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                        int eleDataType, OnMeshBuiltFloat *meshCallback, OnElementLoaded *elementCallback,
+                                        OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKeyFloat", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType);
+  toApplication(handle)->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail,
+    eleDataType, meshCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyIdsEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                      int eleDataType, OnMeshBuilt *meshCallback, OnStringsAdded *stringsCallback,
+                                      OnElementIdsLoaded *elementIdsCallback, OnError *errorCallback,
+                                      utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKeyIds", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType);
+  toApplication(handle)->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail,
+    eleDataType, meshCallback, stringsCallback, elementIdsCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeysEx(void *handle, const char *styleFile, const int *tiles, int tileCount, int levelOfDetail,
+                                    int eleDataType, OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback,
+                                    OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKeys", styleFile, RequestLog::Ints{ tiles, 2 * tileCount }, levelOfDetail,
+                        eleDataType);
+  toApplication(handle)->getSearch().getDataByQuadKeys(styleFile, tiles, tileCount, levelOfDetail, eleDataType,
+    meshCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyOwnedEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                        int eleDataType, OnMeshOwned *meshCallback, OnElementLoaded *elementCallback,
+                                        OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKeyOwned", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType);
+  toApplication(handle)->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail,
+    eleDataType, meshCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+bool EXPORT_API releaseMeshEx(void *handle, std::uint64_t meshHandle) {
+  RequestLog::Call call(handle, "releaseMesh", meshHandle);
+  return toApplication(handle)->getSearch().releaseMesh(meshHandle);
+}
+
+void EXPORT_API getDataByQuadKeyInterleavedEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                              int eleDataType, OnInterleavedMeshBuilt *meshCallback,
+                                              OnElementLoaded *elementCallback, OnError *errorCallback,
+                                              utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKeyInterleaved", tag, styleFile, tileX, tileY, levelOfDetail,
+                        eleDataType);
+  toApplication(handle)->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail,
+    eleDataType, meshCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API enableMeshSplittingEx(void *handle, int enabled) {
+  RequestLog::Call call(handle, "enableMeshSplitting", enabled);
+  toApplication(handle)->getSearch().enableMeshSplitting(enabled);
+}
+
+void EXPORT_API enableRequestCoalescingEx(void *handle, int enabled) {
+  RequestLog::Call call(handle, "enableRequestCoalescing", enabled);
+  toApplication(handle)->getSearch().enableRequestCoalescing(enabled);
+}
+
+void EXPORT_API getDataByQuadKeyInstancedEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                            int eleDataType, OnMeshBuilt *meshCallback, OnInstancesBuilt *instancesCallback,
+                                            OnElementLoaded *elementCallback, OnError *errorCallback,
+                                            utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "getDataByQuadKeyInstanced", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType);
+  toApplication(handle)->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail,
+    eleDataType, meshCallback, instancesCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API setRequestThreadsEx(void *handle, int threadCount) {
+  RequestLog::Call call(handle, "setRequestThreads", threadCount);
+  toApplication(handle)->getSearch().setRequestThreads(threadCount);
+}
+
+void EXPORT_API setRequestBudgetEx(void *handle, int milliseconds) {
+  RequestLog::Call call(handle, "setRequestBudget", milliseconds);
+  toApplication(handle)->getSearch().setRequestBudget(milliseconds);
+}
+
+void EXPORT_API submitDataByQuadKeyEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                      double priority, OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback,
+                                      OnError *errorCallback, OnRequestCompleted *completionCallback) {
+  RequestLog::Call call(handle, "submitDataByQuadKey", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+                        priority);
+  toApplication(handle)->getSearch().submitDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+    priority, meshCallback, elementCallback, errorCallback, completionCallback);
+}
+
+void EXPORT_API submitDataByQuadKeyBatchEx(void *handle, int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                           int eleDataType, double priority, int batchSize, OnMeshBuilt *meshCallback,
+                                           OnElementsLoaded *elementsCallback, OnError *errorCallback,
+                                           OnRequestCompleted *completionCallback) {
+  RequestLog::Call call(handle, "submitDataByQuadKeyBatch", tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+                        priority, batchSize);
+  toApplication(handle)->getSearch().submitDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+    priority, batchSize, meshCallback, elementsCallback, errorCallback, completionCallback);
+}
+
+void EXPORT_API bakeRegionEx(void *handle, const char *styleFile, double minLatitude, double minLongitude,
+                             double maxLatitude, double maxLongitude, int startLod, int endLod, int eleDataType,
+                             OnBakeProgress *progressCallback, OnError *errorCallback,
+                             utymap::CancellationToken *cancellationToken) {
+  RequestLog::Call call(handle, "bakeRegion", styleFile, minLatitude, minLongitude, maxLatitude, maxLongitude,
+                        startLod, endLod, eleDataType);
+  auto application = toApplication(handle);
+  application->getSearch().bakeRegion(styleFile, minLatitude, minLongitude, maxLatitude, maxLongitude,
+    startLod, endLod, eleDataType, progressCallback, errorCallback, cancellationToken);
+  application->getConfiguration().flushMeshCache();
+}
+
+int EXPORT_API submitQuadKeyJobEx(void *handle, const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                  double priority) {
+  RequestLog::Call call(handle, "submitQuadKeyJob", styleFile, tileX, tileY, levelOfDetail, eleDataType, priority);
+  int jobId = toApplication(handle)->getSearch().submitQuadKeyJob(styleFile, tileX, tileY, levelOfDetail, eleDataType,
+                                                                  priority);
+  call.setResult(jobId);
+  return jobId;
+}
+
+int EXPORT_API pollCompletedJobsEx(void *handle, int *jobIds, int maxCount) {
+  RequestLog::Call call(handle, "pollCompletedJobs", maxCount);
+  return toApplication(handle)->getSearch().pollCompletedJobs(jobIds, maxCount);
+}
+
+bool EXPORT_API fetchJobResultEx(void *handle, int jobId, OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback,
+                                 OnError *errorCallback) {
+  RequestLog::Call call(handle, "fetchJobResult", jobId);
+  return toApplication(handle)->getSearch().fetchJobResult(jobId, meshCallback, elementCallback, errorCallback);
+}
+
+bool EXPORT_API getJobMeshSizesEx(void *handle, int jobId, int *meshCount, int *vertexSize, int *triSize, int *colorSize,
+                                  int *uvSize, int *uvMapSize) {
+  RequestLog::Call call(handle, "getJobMeshSizes", jobId);
+  return toApplication(handle)->getSearch().getJobMeshSizes(jobId, meshCount, vertexSize, triSize, colorSize,
+                                                            uvSize, uvMapSize);
+}
+
+bool EXPORT_API fetchJobMeshesEx(void *handle, int jobId, double *vertices, int vertexCapacity, int *triangles, int triCapacity,
+                                 int *colors, int colorCapacity, double *uvs, int uvCapacity, int *uvMap,
+                                 int uvMapCapacity, OnMeshWritten *meshCallback, OnElementLoaded *elementCallback,
+                                 OnError *errorCallback) {
+  RequestLog::Call call(handle, "fetchJobMeshes", jobId, vertexCapacity, triCapacity, colorCapacity, uvCapacity,
+                        uvMapCapacity);
+  return toApplication(handle)->getSearch().fetchJobMeshes(jobId, vertices, vertexCapacity, triangles, triCapacity,
+                                                           colors, colorCapacity, uvs, uvCapacity, uvMap, uvMapCapacity,
+                                                           meshCallback, elementCallback, errorCallback);
+}
+
+void EXPORT_API setRequestPriorityEx(void *handle, int tag, double priority) {
+  RequestLog::Call call(handle, "setRequestPriority", tag, priority);
+  toApplication(handle)->getSearch().setRequestPriority(tag, priority);
+}
+
+void EXPORT_API cancelRequestsBelowEx(void *handle, double threshold) {
+  RequestLog::Call call(handle, "cancelRequestsBelow", threshold);
+  toApplication(handle)->getSearch().cancelRequestsBelow(threshold);
+}
+
+void EXPORT_API prefetchEx(void *handle, const int *tiles, int tileCount, int levelOfDetail) {
+  RequestLog::Call call(handle, "prefetch", RequestLog::Ints{ tiles, 2 * tileCount }, levelOfDetail);
+  toApplication(handle)->getSearch().prefetch(tiles, tileCount, levelOfDetail);
+}
+
+void EXPORT_API prefetchElevationEx(void *handle, const int *tiles, int tileCount, int levelOfDetail, int eleDataType) {
+  RequestLog::Call call(handle, "prefetchElevation", RequestLog::Ints{ tiles, 2 * tileCount }, levelOfDetail,
+                        eleDataType);
+  toApplication(handle)->getSearch().prefetchElevation(tiles, tileCount, levelOfDetail, eleDataType);
+}
+
+double EXPORT_API getElevationByQuadKeyEx(void *handle, int tileX, int tileY, int levelOfDetail, int eleDataType, double latitude, double longitude) {
+  RequestLog::Call call(handle, "getElevationByQuadKey", tileX, tileY, levelOfDetail, eleDataType, latitude, longitude);
+  return toApplication(handle)->getSearch().getElevationByQuadKey(tileX, tileY, levelOfDetail, eleDataType, latitude, longitude);
+}
+
+void EXPORT_API getElevationsByQuadKeyEx(void *handle, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                         const double *coordinates, int count, double *elevations) {
+  RequestLog::Call call(handle, "getElevationsByQuadKey", tileX, tileY, levelOfDetail, eleDataType,
+                        RequestLog::Doubles{ coordinates, 2 * count });
+  toApplication(handle)->getSearch().getElevationsByQuadKey(tileX, tileY, levelOfDetail, eleDataType,
+                                                            coordinates, count, elevations);
+}
+
+/************* Global API *****************/
+// NOTE functions mirror their handle versions using application created by connect.
+
+void EXPORT_API disconnect() {
+  disconnectEx(applicationPtr);
+}
+
+void EXPORT_API connect(const char *indexPath, OnError *errorCallback) {
+  applicationPtr = toApplication(connectEx(indexPath, errorCallback));
+}
+
 void EXPORT_API registerStylesheet(const char *path, OnNewDirectory *directoryCallback) {
-  applicationPtr->getConfiguration().registerStylesheet(path, directoryCallback);
+  registerStylesheetEx(applicationPtr, path, directoryCallback);
 }
 
 void EXPORT_API registerInMemoryStore(const char *key) {
-  applicationPtr->getConfiguration().registerInMemoryStore(key);
+  registerInMemoryStoreEx(applicationPtr, key);
+}
+
+void EXPORT_API registerInMemoryStoreWithBudget(const char *key, std::uint64_t maxBytes, int isSpillEnabled) {
+  registerInMemoryStoreWithBudgetEx(applicationPtr, key, maxBytes, isSpillEnabled);
+}
+
+bool EXPORT_API getInMemoryStoreFootprint(const char *key, std::uint64_t *bytes) {
+  return getInMemoryStoreFootprintEx(applicationPtr, key, bytes);
+}
+
+bool EXPORT_API saveInMemoryStoreSnapshot(const char *key, const char *path, OnError *errorCallback) {
+  return saveInMemoryStoreSnapshotEx(applicationPtr, key, path, errorCallback);
+}
+
+bool EXPORT_API loadInMemoryStoreSnapshot(const char *key, const char *path, OnError *errorCallback) {
+  return loadInMemoryStoreSnapshotEx(applicationPtr, key, path, errorCallback);
 }
 
 void EXPORT_API registerPersistentStore(const char *key, const char *dataPath, OnNewDirectory *directoryCallback) {
-  applicationPtr->getConfiguration().registerPersistentStore(key, dataPath, directoryCallback);
+  registerPersistentStoreEx(applicationPtr, key, dataPath, directoryCallback);
+}
+
+void EXPORT_API registerPersistentStoreWithLimits(const char *key, const char *dataPath,
+                                                  int maxOpenFiles, std::uint64_t maxBitmapBytes,
+                                                  OnNewDirectory *directoryCallback) {
+  registerPersistentStoreWithLimitsEx(applicationPtr, key, dataPath, maxOpenFiles, maxBitmapBytes, directoryCallback);
+}
+
+void EXPORT_API registerPackageStore(const char *key, const char *packagePath) {
+  registerPackageStoreEx(applicationPtr, key, packagePath);
+}
+
+bool EXPORT_API exportPackage(const char *key, const char *packagePath) {
+  return exportPackageEx(applicationPtr, key, packagePath);
+}
+
+bool EXPORT_API getPersistentStoreStatistics(const char *key, std::uint64_t *hits, std::uint64_t *misses,
+                                             std::uint64_t *evictions, std::uint64_t *bitmapBytes) {
+  return getPersistentStoreStatisticsEx(applicationPtr, key, hits, misses, evictions, bitmapBytes);
+}
+
+void EXPORT_API setSearchThreads(int threadCount) {
+  setSearchThreadsEx(applicationPtr, threadCount);
+}
+
+void EXPORT_API setImportThreads(int threadCount) {
+  setImportThreadsEx(applicationPtr, threadCount);
+}
+
+void EXPORT_API setImportFileThreads(int threadCount) {
+  setImportFileThreadsEx(applicationPtr, threadCount);
+}
+
+void EXPORT_API setBuildThreads(int threadCount) {
+  setBuildThreadsEx(applicationPtr, threadCount);
+}
+
+void EXPORT_API configureThreadPool(int poolType, int threadCount, std::uint64_t coreMask, int niceness) {
+  configureThreadPoolEx(applicationPtr, poolType, threadCount, coreMask, niceness);
+}
+
+void EXPORT_API enableMeshWelding(int enabled) {
+  enableMeshWeldingEx(applicationPtr, enabled);
+}
+
+void EXPORT_API enableParallelBuilders(int enabled) {
+  enableParallelBuildersEx(applicationPtr, enabled);
+}
+
+void EXPORT_API enableProgressiveDelivery(int enabled) {
+  enableProgressiveDeliveryEx(applicationPtr, enabled);
+}
+
+void EXPORT_API enableInstancing(int enabled) {
+  enableInstancingEx(applicationPtr, enabled);
+}
+
+void EXPORT_API setBatchVertexLimit(int vertexLimit) {
+  setBatchVertexLimitEx(applicationPtr, vertexLimit);
+}
+
+void EXPORT_API setMeshPoolMaxBytes(std::uint64_t maxBytes) {
+  setMeshPoolMaxBytesEx(applicationPtr, maxBytes);
+}
+
+void EXPORT_API setGridElevationCacheSize(int maxCacheSize) {
+  setGridElevationCacheSizeEx(applicationPtr, maxCacheSize);
+}
+
+void EXPORT_API getMeshPoolStatistics(std::uint64_t *hits, std::uint64_t *misses,
+                                      std::uint64_t *retainedBytes, std::uint64_t *trimmedBytes) {
+  getMeshPoolStatisticsEx(applicationPtr, hits, misses, retainedBytes, trimmedBytes);
+}
+
+void EXPORT_API setMeshCacheMemoryLimit(std::uint64_t maxBytes) {
+  setMeshCacheMemoryLimitEx(applicationPtr, maxBytes);
+}
+
+void EXPORT_API setMeshCacheDiskLimit(std::uint64_t maxBytes) {
+  setMeshCacheDiskLimitEx(applicationPtr, maxBytes);
+}
+
+void EXPORT_API purgeMeshCache(const char **styleFiles, int count) {
+  purgeMeshCacheEx(applicationPtr, styleFiles, count);
+}
+
+void EXPORT_API setElevationCacheResolution(int resolution) {
+  setElevationCacheResolutionEx(applicationPtr, resolution);
+}
+
+void EXPORT_API setImportProgressCallback(OnImportProgress *progressCallback) {
+  setImportProgressCallbackEx(applicationPtr, progressCallback);
+}
+
+void EXPORT_API setTwoPassImport(bool enabled) {
+  setTwoPassImportEx(applicationPtr, enabled);
+}
+
+void EXPORT_API setHierarchicalClipping(bool enabled) {
+  setHierarchicalClippingEx(applicationPtr, enabled);
+}
+
+void EXPORT_API setNodeLocationDirectory(const char *directory) {
+  setNodeLocationDirectoryEx(applicationPtr, directory);
+}
+
+void EXPORT_API setCheckpointDirectory(const char *directory) {
+  setCheckpointDirectoryEx(applicationPtr, directory);
+}
+
+void EXPORT_API sealStringTable() {
+  sealStringTableEx(applicationPtr);
+}
+
+void EXPORT_API setStringTableDurability(int isSafe) {
+  setStringTableDurabilityEx(applicationPtr, isSafe);
 }
 
 void EXPORT_API enableMeshCache(int enabled) {
-  applicationPtr->getConfiguration().enableMeshCache(enabled);
+  enableMeshCacheEx(applicationPtr, enabled);
+}
+
+void EXPORT_API enableStyleProfiling(const char *styleFile, int enabled) {
+  enableStyleProfilingEx(applicationPtr, styleFile, enabled);
+}
+
+void EXPORT_API getStyleProfile(const char *styleFile, OnStyleProfile *profileCallback) {
+  getStyleProfileEx(applicationPtr, styleFile, profileCallback);
+}
+
+int EXPORT_API getStatistics(char *jsonBuffer, int size) {
+  return getStatisticsEx(applicationPtr, jsonBuffer, size);
+}
+
+int EXPORT_API getMemoryUsage(char *jsonBuffer, int size) {
+  return getMemoryUsageEx(applicationPtr, jsonBuffer, size);
+}
+
+void EXPORT_API setMemoryFloor(int subsystem, std::uint64_t bytes) {
+  setMemoryFloorEx(applicationPtr, subsystem, bytes);
+}
+
+void EXPORT_API trimMemory(int level) {
+  trimMemoryEx(applicationPtr, level);
+}
+
+void EXPORT_API startTracing() {
+  startTracingEx(applicationPtr);
+}
+
+bool EXPORT_API stopTracing(const char *path) {
+  return stopTracingEx(applicationPtr, path);
+}
+
+/// Starts writing calls of export API with their arguments and timing to given file, so
+/// session can be replayed by UtyMap.ReplayRequests tool. Returns false if file cannot be opened.
+/// NOTE can be called before connect, so connect call is recorded too.
+bool EXPORT_API startRequestLog(const char *path) {
+  return RequestLog::start(path);
+}
+
+void EXPORT_API stopRequestLog() {
+  RequestLog::stop();
 }
 
-/************* Storage API *****************/
 void EXPORT_API addDataInRange(const char *key, const char *styleFile, const char *path, int startLod, int endLod,
                                OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
-  applicationPtr->getStorage().addToStore(key, styleFile, path, startLod, endLod, errorCallback, cancellationToken);
+  addDataInRangeEx(applicationPtr, key, styleFile, path, startLod, endLod, errorCallback, cancellationToken);
+}
+
+void EXPORT_API addDataInRangeBatch(const char *key, const char **styleFiles, const char **paths, int count,
+                                    int startLod, int endLod,
+                                    OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  addDataInRangeBatchEx(applicationPtr, key, styleFiles, paths, count, startLod, endLod, errorCallback,
+    cancellationToken);
 }
 
 void EXPORT_API addDataInBoundingBox(const char *key, const char *styleFile, const char *path,
                                      double minLat, double minLon, double maxLat,  double maxLon, int startLod, int endLod,
                                      OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
-  applicationPtr->getStorage().addToStore(key, styleFile, path, minLat, minLon, maxLat, maxLon, startLod, endLod, errorCallback, cancellationToken);
+  addDataInBoundingBoxEx(applicationPtr, key, styleFile, path, minLat, minLon, maxLat, maxLon, startLod, endLod,
+    errorCallback, cancellationToken);
 }
 
 void EXPORT_API addDataInQuadKey(const char *key, const char *styleFile, const char *path,
                                  int tileX, int tileY, int levelOfDetail,
                                  OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
-  applicationPtr->getStorage().addToStore(key, styleFile, path, tileX, tileY, levelOfDetail, errorCallback, cancellationToken);
+  addDataInQuadKeyEx(applicationPtr, key, styleFile, path, tileX, tileY, levelOfDetail, errorCallback,
+    cancellationToken);
 }
 
 void EXPORT_API addDataInElement(const char *key, const char *styleFile, std::uint64_t id, const double *vertices, int vertexLength,
                                  const char **tags, int tagLength, int startLod, int endLod,
                                  OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
-  applicationPtr->getStorage().addToStore(key, styleFile, id, vertices, vertexLength, tags, tagLength, startLod, endLod, errorCallback, cancellationToken);
+  addDataInElementEx(applicationPtr, key, styleFile, id, vertices, vertexLength, tags, tagLength, startLod, endLod,
+    errorCallback, cancellationToken);
+}
+
+void EXPORT_API applyChanges(const char *key, const char *styleFile, const char *path, int startLod, int endLod,
+                             OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  applyChangesEx(applicationPtr, key, styleFile, path, startLod, endLod, errorCallback, cancellationToken);
 }
 
 bool EXPORT_API hasData(int tileX, int tileY, int levelOfDetail) {
-  return applicationPtr->getStorage().hasData(tileX, tileY, levelOfDetail);
+  return hasDataEx(applicationPtr, tileX, tileY, levelOfDetail);
+}
+
+void EXPORT_API getTileSummary(int tileX, int tileY, int levelOfDetail, std::uint64_t *values) {
+  getTileSummaryEx(applicationPtr, tileX, tileY, levelOfDetail, values);
 }
 
-/************* Search API *****************/
 void EXPORT_API getDataByText(int tag, const char *notTerms, const char *andTerms, const char *orTerms,
                               double minLatitude, double minLongitude, double maxLatitude, double maxLongitude, int startLod, int endLod,
                               OnElementLoaded *elementCallback, OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
-  applicationPtr->getSearch().getDataByText(tag, notTerms, andTerms, orTerms, minLatitude, minLongitude,maxLatitude, maxLongitude,
-    startLod, endLod, elementCallback, errorCallback, cancellationToken);
+  getDataByTextEx(applicationPtr, tag, notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude,
+    maxLongitude, startLod, endLod, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByTextPage(int tag, const char *notTerms, const char *andTerms, const char *orTerms,
+                                  double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                                  int startLod, int endLod, int offset, int limit,
+                                  OnElementLoaded *elementCallback, OnError *errorCallback,
+                                  utymap::CancellationToken *cancellationToken) {
+  getDataByTextPageEx(applicationPtr, tag, notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude,
+    maxLongitude, startLod, endLod, offset, limit, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByTextBatch(int tag, const char *notTerms, const char *andTerms, const char *orTerms,
+                                   double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                                   int startLod, int endLod, int offset, int limit, int batchSize,
+                                   OnElementsLoaded *elementsCallback, OnError *errorCallback,
+                                   utymap::CancellationToken *cancellationToken) {
+  getDataByTextBatchEx(applicationPtr, tag, notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude,
+    maxLongitude, startLod, endLod, offset, limit, batchSize, elementsCallback, errorCallback, cancellationToken);
+}
+
+int EXPORT_API countDataByText(const char *notTerms, const char *andTerms, const char *orTerms,
+                               double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                               int startLod, int endLod, OnError *errorCallback,
+                               utymap::CancellationToken *cancellationToken) {
+  return countDataByTextEx(applicationPtr, notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude,
+    maxLongitude, startLod, endLod, errorCallback, cancellationToken);
+}
+
+bool EXPORT_API existsDataByText(const char *notTerms, const char *andTerms, const char *orTerms,
+                                 double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                                 int startLod, int endLod, OnError *errorCallback,
+                                 utymap::CancellationToken *cancellationToken) {
+  return existsDataByTextEx(applicationPtr, notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude,
+    maxLongitude, startLod, endLod, errorCallback, cancellationToken);
+}
+
+bool EXPORT_API getDataById(int tag, std::uint64_t id, OnElementLoaded *elementCallback, OnError *errorCallback) {
+  return getDataByIdEx(applicationPtr, tag, id, elementCallback, errorCallback);
 }
 
 void EXPORT_API getDataByQuadKey(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
                                  OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback, OnError *errorCallback,
                                  utymap::CancellationToken *cancellationToken) {
-  applicationPtr->getSearch().getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, 
-    eleDataType, meshCallback, elementCallback, errorCallback, cancellationToken);
+  getDataByQuadKeyEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback,
+    elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyBatch(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                      int batchSize, OnMeshBuilt *meshCallback, OnElementsLoaded *elementsCallback,
+                                      OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  getDataByQuadKeyBatchEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, batchSize,
+    meshCallback, elementsCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyFloat(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                      int eleDataType, OnMeshBuiltFloat *meshCallback, OnElementLoaded *elementCallback,
+                                      OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  getDataByQuadKeyFloatEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback,
+    elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyIds(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                    int eleDataType, OnMeshBuilt *meshCallback, OnStringsAdded *stringsCallback,
+                                    OnElementIdsLoaded *elementIdsCallback, OnError *errorCallback,
+                                    utymap::CancellationToken *cancellationToken) {
+  getDataByQuadKeyIdsEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback,
+    stringsCallback, elementIdsCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeys(const char *styleFile, const int *tiles, int tileCount, int levelOfDetail,
+                                  int eleDataType, OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback,
+                                  OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  getDataByQuadKeysEx(applicationPtr, styleFile, tiles, tileCount, levelOfDetail, eleDataType, meshCallback,
+    elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API getDataByQuadKeyOwned(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                      int eleDataType, OnMeshOwned *meshCallback, OnElementLoaded *elementCallback,
+                                      OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+  getDataByQuadKeyOwnedEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback,
+    elementCallback, errorCallback, cancellationToken);
+}
+
+bool EXPORT_API releaseMesh(std::uint64_t handle) {
+  return releaseMeshEx(applicationPtr, handle);
+}
+
+void EXPORT_API getDataByQuadKeyInterleaved(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                            int eleDataType, OnInterleavedMeshBuilt *meshCallback,
+                                            OnElementLoaded *elementCallback, OnError *errorCallback,
+                                            utymap::CancellationToken *cancellationToken) {
+  getDataByQuadKeyInterleavedEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+    meshCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API enableMeshSplitting(int enabled) {
+  enableMeshSplittingEx(applicationPtr, enabled);
+}
+
+void EXPORT_API enableRequestCoalescing(int enabled) {
+  enableRequestCoalescingEx(applicationPtr, enabled);
+}
+
+void EXPORT_API getDataByQuadKeyInstanced(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                          int eleDataType, OnMeshBuilt *meshCallback, OnInstancesBuilt *instancesCallback,
+                                          OnElementLoaded *elementCallback, OnError *errorCallback,
+                                          utymap::CancellationToken *cancellationToken) {
+  getDataByQuadKeyInstancedEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback,
+    instancesCallback, elementCallback, errorCallback, cancellationToken);
+}
+
+void EXPORT_API setRequestThreads(int threadCount) {
+  setRequestThreadsEx(applicationPtr, threadCount);
+}
+
+void EXPORT_API setRequestBudget(int milliseconds) {
+  setRequestBudgetEx(applicationPtr, milliseconds);
+}
+
+void EXPORT_API setCancellationDeadline(utymap::CancellationToken *cancellationToken, int milliseconds) {
+  cancellationToken->setDeadline(std::chrono::milliseconds(milliseconds));
+}
+
+void EXPORT_API submitDataByQuadKey(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                    double priority, OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback,
+                                    OnError *errorCallback, OnRequestCompleted *completionCallback) {
+  submitDataByQuadKeyEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, priority,
+    meshCallback, elementCallback, errorCallback, completionCallback);
+}
+
+void EXPORT_API submitDataByQuadKeyBatch(int tag, const char *styleFile, int tileX, int tileY, int levelOfDetail,
+                                         int eleDataType, double priority, int batchSize, OnMeshBuilt *meshCallback,
+                                         OnElementsLoaded *elementsCallback, OnError *errorCallback,
+                                         OnRequestCompleted *completionCallback) {
+  submitDataByQuadKeyBatchEx(applicationPtr, tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, priority,
+    batchSize, meshCallback, elementsCallback, errorCallback, completionCallback);
+}
+
+void EXPORT_API bakeRegion(const char *styleFile, double minLatitude, double minLongitude,
+                           double maxLatitude, double maxLongitude, int startLod, int endLod, int eleDataType,
+                           OnBakeProgress *progressCallback, OnError *errorCallback,
+                           utymap::CancellationToken *cancellationToken) {
+  bakeRegionEx(applicationPtr, styleFile, minLatitude, minLongitude, maxLatitude, maxLongitude, startLod, endLod,
+    eleDataType, progressCallback, errorCallback, cancellationToken);
+}
+
+int EXPORT_API submitQuadKeyJob(const char *styleFile, int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                double priority) {
+  return submitQuadKeyJobEx(applicationPtr, styleFile, tileX, tileY, levelOfDetail, eleDataType, priority);
+}
+
+int EXPORT_API pollCompletedJobs(int *jobIds, int maxCount) {
+  return pollCompletedJobsEx(applicationPtr, jobIds, maxCount);
+}
+
+bool EXPORT_API fetchJobResult(int jobId, OnMeshBuilt *meshCallback, OnElementLoaded *elementCallback,
+                               OnError *errorCallback) {
+  return fetchJobResultEx(applicationPtr, jobId, meshCallback, elementCallback, errorCallback);
+}
+
+bool EXPORT_API getJobMeshSizes(int jobId, int *meshCount, int *vertexSize, int *triSize, int *colorSize,
+                                int *uvSize, int *uvMapSize) {
+  return getJobMeshSizesEx(applicationPtr, jobId, meshCount, vertexSize, triSize, colorSize, uvSize, uvMapSize);
+}
+
+bool EXPORT_API fetchJobMeshes(int jobId, double *vertices, int vertexCapacity, int *triangles, int triCapacity,
+                               int *colors, int colorCapacity, double *uvs, int uvCapacity, int *uvMap,
+                               int uvMapCapacity, OnMeshWritten *meshCallback, OnElementLoaded *elementCallback,
+                               OnError *errorCallback) {
+  return fetchJobMeshesEx(applicationPtr, jobId, vertices, vertexCapacity, triangles, triCapacity, colors,
+    colorCapacity, uvs, uvCapacity, uvMap, uvMapCapacity, meshCallback, elementCallback, errorCallback);
+}
+
+void EXPORT_API setRequestPriority(int tag, double priority) {
+  setRequestPriorityEx(applicationPtr, tag, priority);
+}
+
+void EXPORT_API cancelRequestsBelow(double threshold) {
+  cancelRequestsBelowEx(applicationPtr, threshold);
+}
+
+void EXPORT_API prefetch(const int *tiles, int tileCount, int levelOfDetail) {
+  prefetchEx(applicationPtr, tiles, tileCount, levelOfDetail);
+}
+
+void EXPORT_API prefetchElevation(const int *tiles, int tileCount, int levelOfDetail, int eleDataType) {
+  prefetchElevationEx(applicationPtr, tiles, tileCount, levelOfDetail, eleDataType);
 }
 
 double EXPORT_API getElevationByQuadKey(int tileX, int tileY, int levelOfDetail, int eleDataType, double latitude, double longitude) {
-  return applicationPtr->getSearch().getElevationByQuadKey(tileX, tileY, levelOfDetail, eleDataType, latitude, longitude);
+  return getElevationByQuadKeyEx(applicationPtr, tileX, tileY, levelOfDetail, eleDataType, latitude, longitude);
+}
+
+void EXPORT_API getElevationsByQuadKey(int tileX, int tileY, int levelOfDetail, int eleDataType,
+                                       const double *coordinates, int count, double *elevations) {
+  getElevationsByQuadKeyEx(applicationPtr, tileX, tileY, levelOfDetail, eleDataType, coordinates, count, elevations);
 }
 
 }
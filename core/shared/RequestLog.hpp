@@ -0,0 +1,239 @@
+#ifndef REQUESTLOG_HPP_DEFINED
+#define REQUESTLOG_HPP_DEFINED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Records calls of export API with their arguments and timing while log is started, so
+/// session of host can be replayed offline by UtyMap.ReplayRequests tool.
+/// Every call is written as line of tab separated fields: start and duration in microseconds
+/// since log is started, thread id, handle of application, function name and arguments. Tabs,
+/// new lines and backslashes of strings are escaped, null string is written as \N.
+/// NOTE calls of global functions are recorded with handle of application created by connect
+/// and both global and handle functions are recorded by name of global one.
+class RequestLog final {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Array of ints which is written as comma separated list.
+  struct Ints {
+    const int *data;
+    int size;
+  };
+
+  /// Array of doubles which is written as comma separated list.
+  struct Doubles {
+    const double *data;
+    int size;
+  };
+
+  /// Array of strings which is written as its size followed by its strings as separate fields.
+  struct Strings {
+    const char *const *data;
+    int size;
+  };
+
+  /// Recorded call.
+  struct Entry {
+    std::uint64_t start;    // microseconds since log is started
+    std::uint64_t duration; // microseconds
+    std::size_t threadId;
+    std::uint64_t handle;   // address of application, zero if it is not created
+    std::string name;
+    std::vector<std::string> args;
+  };
+
+  /// Records call which lasts till destruction if log is started. Arguments are formatted
+  /// only if log is started.
+  class Call final {
+   public:
+    template<typename... Args>
+    explicit Call(const void *handle, const char *name, const Args &... args) :
+        isStarted_(RequestLog::isStarted()), start_(isStarted_ ? Clock::now() : Clock::time_point()),
+        handle_(reinterpret_cast<std::uintptr_t>(handle)) {
+      if (!isStarted_) return;
+      args_ << name;
+      format(args...);
+    }
+
+    ~Call() {
+      if (isStarted_)
+        instance().add(start_, Clock::now(), handle_, args_.str());
+    }
+
+    /// Sets handle of application which is created by call.
+    void setHandle(const void *handle) {
+      handle_ = reinterpret_cast<std::uintptr_t>(handle);
+    }
+
+    /// Appends result of call as its last argument, so ids returned to host can be mapped on replay.
+    template<typename T>
+    void setResult(const T &value) {
+      if (isStarted_)
+        format(value);
+    }
+
+    Call(const Call &) = delete;
+    Call &operator=(const Call &) = delete;
+
+   private:
+    void format() {}
+
+    template<typename Arg, typename... Args>
+    void format(const Arg &arg, const Args &... args) {
+      args_ << '\t';
+      write(arg);
+      format(args...);
+    }
+
+    void write(const char *str) {
+      if (str == nullptr) {
+        args_ << "\\N";
+        return;
+      }
+      for (; *str != '\0'; ++str) {
+        switch (*str) {
+          case '\t': args_ << "\\t"; break;
+          case '\n': args_ << "\\n"; break;
+          case '\\': args_ << "\\\\"; break;
+          default: args_ << *str;
+        }
+      }
+    }
+
+    void write(const Ints &ints) {
+      for (int i = 0; i < ints.size; ++i)
+        args_ << (i == 0 ? "" : ",") << ints.data[i];
+    }
+
+    void write(const Doubles &doubles) {
+      for (int i = 0; i < doubles.size; ++i) {
+        args_ << (i == 0 ? "" : ",");
+        write(doubles.data[i]);
+      }
+    }
+
+    void write(const Strings &strings) {
+      args_ << strings.size;
+      for (int i = 0; i < strings.size; ++i) {
+        args_ << '\t';
+        write(strings.data[i]);
+      }
+    }
+
+    void write(double value) {
+      args_ << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+    }
+
+    template<typename T>
+    void write(const T &value) {
+      args_ << value;
+    }
+
+    const bool isStarted_;
+    const Clock::time_point start_;
+    std::uint64_t handle_;
+    std::stringstream args_;
+  };
+
+  /// Starts writing calls to given file which is truncated. Returns false if file cannot
+  /// be opened. Log which is already started is stopped.
+  static bool start(const char *path) {
+    auto &log = instance();
+    std::lock_guard<std::mutex> lock(log.lock_);
+    log.file_.close();
+    log.file_.clear();
+    log.file_.open(path, std::ios::trunc);
+    log.origin_ = Clock::now();
+    log.isStarted_ = log.file_.good();
+    return log.isStarted_;
+  }
+
+  /// Stops writing calls and closes file. Calls which are still running are dropped.
+  static void stop() {
+    auto &log = instance();
+    std::lock_guard<std::mutex> lock(log.lock_);
+    log.isStarted_ = false;
+    log.file_.close();
+  }
+
+  static bool isStarted() {
+    return instance().isStarted_.load(std::memory_order_relaxed);
+  }
+
+  /// Parses line of log into entry. Returns false if line is malformed.
+  static bool parse(const std::string &line, Entry &entry) {
+    std::vector<std::string> fields;
+    std::string field;
+    for (std::size_t i = 0; i < line.size(); ++i) {
+      char c = line[i];
+      if (c == '\t') {
+        fields.push_back(std::move(field));
+        field.clear();
+      } else if (c == '\\' && i + 1 < line.size()) {
+        switch (line[++i]) {
+          case 't': field += '\t'; break;
+          case 'n': field += '\n'; break;
+          // NOTE null string is kept escaped, so it can be distinguished from empty one.
+          case 'N': field += "\\N"; break;
+          default: field += line[i];
+        }
+      } else
+        field += c;
+    }
+    fields.push_back(std::move(field));
+    if (fields.size() < 5)
+      return false;
+
+    try {
+      entry.start = std::stoull(fields[0]);
+      entry.duration = std::stoull(fields[1]);
+      entry.threadId = static_cast<std::size_t>(std::stoull(fields[2]));
+      entry.handle = std::stoull(fields[3]);
+    } catch (const std::exception &) {
+      return false;
+    }
+    entry.name = fields[4];
+    entry.args.assign(std::make_move_iterator(fields.begin() + 5), std::make_move_iterator(fields.end()));
+    return true;
+  }
+
+ private:
+  RequestLog() : isStarted_(false) {}
+
+  static RequestLog &instance() {
+    static RequestLog log;
+    return log;
+  }
+
+  void add(Clock::time_point start, Clock::time_point end, std::uint64_t handle, const std::string &call) {
+    std::size_t threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::lock_guard<std::mutex> lock(lock_);
+    // NOTE call which was started before log is dropped.
+    if (!isStarted_ || start < origin_)
+      return;
+    file_ << toMicros(start - origin_) << '\t' << toMicros(end - start) << '\t' << threadId << '\t' << handle
+          << '\t' << call << '\n';
+  }
+
+  static std::uint64_t toMicros(Clock::duration duration) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+  }
+
+  std::atomic<bool> isStarted_;
+  Clock::time_point origin_;
+  std::ofstream file_;
+  std::mutex lock_;
+};
+
+#endif // REQUESTLOG_HPP_DEFINED
@@ -5,13 +5,49 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "builders/MeshInstancer.hpp"
+#include "builders/MeshInterleaver.hpp"
+#include "builders/MeshPool.hpp"
+#include "builders/TileBuildScheduler.hpp"
 #include "math/Mesh.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/IdSet.hpp"
+#include "utils/PriorityScheduler.hpp"
+#include "utils/SingleFlight.hpp"
+#include "utils/ThreadPool.hpp"
+#include "utils/Tracer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 /// Exposes search API.
 class Search {
 public:
   explicit Search(Context& context) :
-    context_(context) {}
+    context_(context), elePrefetchGeneration_(0), requestThreads_(1), requestBudget_(0), isMeshSplitting_(false), isCoalescing_(false),
+    lastMeshHandle_(0),
+    lastJobId_(0) {}
+
+  ~Search() {
+    // NOTE pending requests are cancelled, so completion callbacks are still called.
+    cancelRequestsBelow(std::numeric_limits<double>::infinity());
+    requestScheduler_.reset();
+    // NOTE pending elevation prefetch is dropped, running one stops after current tile.
+    ++elePrefetchGeneration_;
+    std::lock_guard<std::mutex> lock(elePrefetchLock_);
+    if (elePrefetchTask_.valid())
+      elePrefetchTask_.wait();
+  }
 
   /// Gets data represented by elements matching given text query.
   /// Note, that styles and real elevation height are not included.
@@ -25,16 +61,89 @@ public:
                      double maxLongitude,                      // max longitude
                      int startLod,                             // start lod
                      int endLod,                               // end lod
+                     int offset,                               // amount of skipped results
+                     int limit,                                // max amount of results, zero means no limit
                      OnElementLoaded *elementCallback,         // element callback
                      OnError *errorCallback,                   // error callback
                      utymap::CancellationToken *cancellationToken) {
-    utymap::BoundingBox bbox(utymap::GeoCoordinate(minLatitude, minLongitude),
-                             utymap::GeoCoordinate(maxLatitude, maxLongitude));
-    utymap::LodRange lodRange(startLod, endLod);
+    ExportElementVisitor elementVisitor(tag, context_.stringTable, elementCallback);
+    getDataByText(notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude, maxLongitude,
+                  startLod, endLod, offset, limit, elementVisitor, errorCallback, cancellationToken);
+  }
+
+  /// Gets data represented by elements matching given text query. Elements are
+  /// passed to callback in batches of given size.
+  /// Note, that styles and real elevation height are not included.
+  void getDataByText(int tag,                                  // request tag
+                     const char *notTerms,                     // NOT terms
+                     const char *andTerms,                     // AND terms
+                     const char *orTerms,                      // OR terms
+                     double minLatitude,                       // min latitude
+                     double minLongitude,                      // min longitude
+                     double maxLatitude,                       // max latitude
+                     double maxLongitude,                      // max longitude
+                     int startLod,                             // start lod
+                     int endLod,                               // end lod
+                     int offset,                               // amount of skipped results
+                     int limit,                                // max amount of results, zero means no limit
+                     int batchSize,                            // max amount of elements in one batch
+                     OnElementsLoaded *elementsCallback,       // elements callback
+                     OnError *errorCallback,                   // error callback
+                     utymap::CancellationToken *cancellationToken) {
+    ExportElementVisitor elementVisitor(tag, context_.stringTable, nullptr);
+    elementVisitor.setBatch(elementsCallback, batchSize);
+    getDataByText(notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude, maxLongitude,
+                  startLod, endLod, offset, limit, elementVisitor, errorCallback, cancellationToken);
+  }
+
+  /// Counts elements matching given text query using only bitmap index, so element
+  /// data is not read. Returns -1 if error occurred.
+  /// NOTE element stored in many tiles is counted in each of them.
+  int countDataByText(const char *notTerms,                     // NOT terms
+                      const char *andTerms,                     // AND terms
+                      const char *orTerms,                      // OR terms
+                      double minLatitude,                       // min latitude
+                      double minLongitude,                      // min longitude
+                      double maxLatitude,                       // max latitude
+                      double maxLongitude,                      // max longitude
+                      int startLod,                             // start lod
+                      int endLod,                               // end lod
+                      OnError *errorCallback,                   // error callback
+                      utymap::CancellationToken *cancellationToken) {
+    return countByText(notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude, maxLongitude,
+                       startLod, endLod, 0, errorCallback, cancellationToken);
+  }
+
+  /// Checks whether any element matches given text query. Search stops on first match
+  /// found in bitmap index.
+  bool existsDataByText(const char *notTerms,                   // NOT terms
+                        const char *andTerms,                   // AND terms
+                        const char *orTerms,                    // OR terms
+                        double minLatitude,                     // min latitude
+                        double minLongitude,                    // min longitude
+                        double maxLatitude,                     // max latitude
+                        double maxLongitude,                    // max longitude
+                        int startLod,                           // start lod
+                        int endLod,                             // end lod
+                        OnError *errorCallback,                 // error callback
+                        utymap::CancellationToken *cancellationToken) {
+    return countByText(notTerms, andTerms, orTerms, minLatitude, minLongitude, maxLatitude, maxLongitude,
+                       startLod, endLod, 1, errorCallback, cancellationToken) > 0;
+  }
+
+  /// Gets element with given id using id index of stores, so no tile is scanned.
+  /// Returns false if element is not found or error occurred.
+  /// Note, that styles and real elevation height are not included.
+  bool getDataById(int tag,                                       // request tag
+                   std::uint64_t id,                              // element id
+                   OnElementLoaded *elementCallback,              // element callback
+                   OnError *errorCallback) {                      // error callback
+    bool isFound = false;
     ExportElementVisitor elementVisitor(tag, context_.stringTable, elementCallback);
     ::safeExecute([&]() {
-      context_.geoStore.search(notTerms, andTerms, orTerms, bbox, lodRange, elementVisitor, *cancellationToken);
+      isFound = context_.geoStore.searchById(id, elementVisitor);
     }, errorCallback);
+    return isFound;
   }
 
   /// Gets data represented by elements and meshes for given quad key.
@@ -46,30 +155,598 @@ public:
                         OnElementLoaded *elementCallback,        // element callback
                         OnError *errorCallback,                  // error callback
                         utymap::CancellationToken *cancellationToken) {
-    utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback, nullptr,
+                     elementCallback, nullptr, 0, errorCallback, cancellationToken);
+  }
+
+  /// Gets data represented by elements and meshes for given quad key. Meshes are passed as
+  /// float data which halves memory and marshalling cost: vertices are offsets from tile center.
+  void getDataByQuadKey(int tag,                                 // request tag
+                        const char *styleFile,                   // style file
+                        int tileX, int tileY, int levelOfDetail, // quad key info
+                        int eleDataType,                         // elevation data type
+                        OnMeshBuiltFloat *meshCallback,          // mesh callback
+                        OnElementLoaded *elementCallback,        // element callback
+                        OnError *errorCallback,                  // error callback
+                        utymap::CancellationToken *cancellationToken) {
+    auto origin = utymap::utils::GeoUtils::quadKeyToBoundingBox(
+        utymap::QuadKey(levelOfDetail, tileX, tileY)).center();
+    std::vector<float> vertices;
+    std::vector<float> uvs;
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+      [&](const utymap::math::Mesh &mesh) {
+        vertices.resize(mesh.vertices.size());
+        for (std::size_t i = 0; i + 2 < mesh.vertices.size(); i += 3) {
+          vertices[i] = static_cast<float>(mesh.vertices[i] - origin.longitude);
+          vertices[i + 1] = static_cast<float>(mesh.vertices[i + 1] - origin.latitude);
+          vertices[i + 2] = static_cast<float>(mesh.vertices[i + 2]);
+        }
+        uvs.assign(mesh.uvs.begin(), mesh.uvs.end());
+        meshCallback(tag, mesh.name.data(), origin.longitude, origin.latitude,
+          vertices.data(), static_cast<int>(vertices.size()),
+          mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+          mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+          uvs.data(), static_cast<int>(uvs.size()),
+          mesh.uvMap.data(), static_cast<int>(mesh.uvMap.size()));
+      }, nullptr, elementCallback, nullptr, 0, errorCallback, cancellationToken);
+  }
+
+  /// Gets data represented by elements and meshes for given quad key. Every mesh is kept
+  /// until host releases it by its handle, so host maps its arrays instead of copying them.
+  /// NOTE builders reuse their meshes, so mesh is copied once into pooled one.
+  void getDataByQuadKey(int tag,                                 // request tag
+                        const char *styleFile,                   // style file
+                        int tileX, int tileY, int levelOfDetail, // quad key info
+                        int eleDataType,                         // elevation data type
+                        OnMeshOwned *meshCallback,               // mesh callback
+                        OnElementLoaded *elementCallback,        // element callback
+                        OnError *errorCallback,                  // error callback
+                        utymap::CancellationToken *cancellationToken) {
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+      [&](const utymap::math::Mesh &mesh) {
+        auto owned = ownedMeshPool_.get(mesh.name, mesh.vertices.size()/3);
+        owned.vertices.assign(mesh.vertices.begin(), mesh.vertices.end());
+        owned.triangles.assign(mesh.triangles.begin(), mesh.triangles.end());
+        owned.colors.assign(mesh.colors.begin(), mesh.colors.end());
+        owned.uvs.assign(mesh.uvs.begin(), mesh.uvs.end());
+        owned.uvMap.assign(mesh.uvMap.begin(), mesh.uvMap.end());
+
+        std::uint64_t handle;
+        const utymap::math::Mesh *result;
+        {
+          std::lock_guard<std::mutex> lock(ownedMeshLock_);
+          handle = ++lastMeshHandle_;
+          // NOTE elements of unordered map keep their addresses.
+          result = &ownedMeshes_.emplace(handle, std::move(owned)).first->second;
+        }
+        meshCallback(tag, handle, result->name.data(),
+          result->vertices.data(), static_cast<int>(result->vertices.size()),
+          result->triangles.data(), static_cast<int>(result->triangles.size()),
+          result->colors.data(), static_cast<int>(result->colors.size()),
+          result->uvs.data(), static_cast<int>(result->uvs.size()),
+          result->uvMap.data(), static_cast<int>(result->uvMap.size()));
+      }, nullptr, elementCallback, nullptr, 0, errorCallback, cancellationToken);
+  }
+
+  /// Gets data of given tile passing tags and styles of elements as string ids, so strings are
+  /// not copied per element. Every string is passed to strings callback once per request.
+  void getDataByQuadKey(int tag,                                 // request tag
+                        const char *styleFile,                   // style file
+                        int tileX, int tileY, int levelOfDetail, // quadkey info
+                        int eleDataType,                         // elevation data type
+                        OnMeshBuilt *meshCallback,               // mesh callback
+                        OnStringsAdded *stringsCallback,         // strings callback
+                        OnElementIdsLoaded *elementIdsCallback,  // element callback
+                        OnError *errorCallback,                  // error callback
+                        utymap::CancellationToken *cancellationToken) {
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+      [&](const utymap::math::Mesh &mesh) { notifyMesh(meshCallback, tag, mesh); },
+      nullptr, nullptr, nullptr, 0, errorCallback, cancellationToken, stringsCallback, elementIdsCallback);
+  }
+
+  /// Gets data of given tiles of the same level of detail. Storage data of all tiles is prefetched
+  /// and tiles are built in parallel on request threads. Tag passed to callbacks is index of tile.
+  /// NOTE callbacks are not called concurrently, method returns once all tiles are built.
+  void getDataByQuadKeys(const char *styleFile,                   // style file
+                         const int *tiles,                        // tile x and y pairs
+                         int tileCount,                           // amount of tiles
+                         int levelOfDetail,                       // level of detail
+                         int eleDataType,                         // elevation data type
+                         OnMeshBuilt *meshCallback,               // mesh callback
+                         OnElementLoaded *elementCallback,        // element callback
+                         OnError *errorCallback,                  // error callback
+                         utymap::CancellationToken *cancellationToken) {
+    std::vector<utymap::QuadKey> quadKeys;
+    quadKeys.reserve(static_cast<std::size_t>(std::max(tileCount, 0)));
+    for (int i = 0; i < tileCount; ++i)
+      quadKeys.push_back(utymap::QuadKey(levelOfDetail, tiles[2 * i], tiles[2 * i + 1]));
+
+    // NOTE style is resolved once, so broken style is reported once too.
+    bool isResolved = false;
+    ::safeExecute([&]() {
+      context_.getStyleProvider(styleFile);
+      isResolved = true;
+    }, errorCallback);
+    if (!isResolved)
+      return;
+    context_.geoStore.prefetch(quadKeys);
+
+    std::size_t threadCount;
+    {
+      std::lock_guard<std::mutex> lock(requestLock_);
+      threadCount = requestThreads_;
+    }
+
+    std::mutex callbackLock;
+    utymap::utils::PriorityScheduler scheduler(threadCount, &context_.cpuPool);
+    for (int i = 0; i < tileCount; ++i) {
+      // NOTE tiles go in given order, so host can sort them e.g. by distance to camera.
+      scheduler.submit(i, -i, [&, i](const utymap::CancellationToken &) {
+        if (cancellationToken->isCancelled()) return;
+        const auto &quadKey = quadKeys[i];
+        getDataByQuadKey(i, styleFile, quadKey.tileX, quadKey.tileY, quadKey.levelOfDetail, eleDataType,
+          [&](const utymap::math::Mesh &mesh) {
+            std::lock_guard<std::mutex> lock(callbackLock);
+            notifyMesh(meshCallback, i, mesh);
+          }, nullptr,
+          [&](int tag, std::uint64_t id, const char **tags, int tagSize, const double *vertices, int vertexSize,
+              const char **styles, int styleSize) {
+            std::lock_guard<std::mutex> lock(callbackLock);
+            elementCallback(tag, id, tags, tagSize, vertices, vertexSize, styles, styleSize);
+          }, nullptr, 0,
+          [&](const char *message) {
+            std::lock_guard<std::mutex> lock(callbackLock);
+            errorCallback(message);
+          }, cancellationToken);
+      });
+    }
+    // NOTE scheduler waits for all tiles when it is destroyed.
+  }
+
+  /// Returns memory of mesh passed with ownership to pool. Returns false if there is no such mesh.
+  bool releaseMesh(std::uint64_t handle) {
+    std::lock_guard<std::mutex> lock(ownedMeshLock_);
+    auto owned = ownedMeshes_.find(handle);
+    if (owned == ownedMeshes_.end())
+      return false;
+    ownedMeshPool_.release(std::move(owned->second));
+    ownedMeshes_.erase(owned);
+    return true;
+  }
+
+  /// Returns amount of meshes which are not released by host yet.
+  std::size_t getOwnedMeshCount() {
+    std::lock_guard<std::mutex> lock(ownedMeshLock_);
+    return ownedMeshes_.size();
+  }
+
+  /// Gets data represented by elements and meshes for given quad key. Meshes are passed as
+  /// interleaved vertex stream and index buffer which match GPU vertex layout.
+  void getDataByQuadKey(int tag,                                 // request tag
+                        const char *styleFile,                   // style file
+                        int tileX, int tileY, int levelOfDetail, // quad key info
+                        int eleDataType,                         // elevation data type
+                        OnInterleavedMeshBuilt *meshCallback,    // mesh callback
+                        OnElementLoaded *elementCallback,        // element callback
+                        OnError *errorCallback,                  // error callback
+                        utymap::CancellationToken *cancellationToken) {
+    using utymap::builders::InterleavedVertex;
+    using utymap::builders::MeshInterleaver;
+    auto origin = utymap::utils::GeoUtils::quadKeyToBoundingBox(
+        utymap::QuadKey(levelOfDetail, tileX, tileY)).center();
+    bool isSplitting = isMeshSplitting_;
+    std::vector<InterleavedVertex> vertices;
+    std::vector<int> indices;
+    std::vector<std::uint16_t> shortIndices;
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+      [&](const utymap::math::Mesh &mesh) {
+        MeshInterleaver::interleave(mesh, origin, vertices, indices);
+        std::size_t chunk = 0;
+        auto notifyChunk = [&](const std::vector<InterleavedVertex> &chunkVertices,
+                               const std::vector<int> &chunkIndices) {
+          auto name = chunk++ == 0 ? mesh.name : mesh.name + "#" + std::to_string(chunk - 1);
+          bool isShort = MeshInterleaver::narrow(chunkIndices, chunkVertices.size(), shortIndices);
+          meshCallback(tag, name.data(), origin.longitude, origin.latitude,
+            chunkVertices.data(), static_cast<int>(chunkVertices.size()),
+            static_cast<int>(sizeof(InterleavedVertex)),
+            isShort ? static_cast<const void *>(shortIndices.data()) : chunkIndices.data(),
+            static_cast<int>(chunkIndices.size()),
+            static_cast<int>(isShort ? sizeof(std::uint16_t) : sizeof(int)));
+        };
+        if (isSplitting)
+          MeshInterleaver::split(vertices, indices, MeshInterleaver::MaxShortVertices, notifyChunk);
+        else
+          notifyChunk(vertices, indices);
+      }, nullptr, elementCallback, nullptr, 0, errorCallback, cancellationToken);
+  }
+
+  /// Enables or disables splitting of interleaved meshes into chunks which can use 16 bit indices.
+  void enableMeshSplitting(int enabled) {
+    isMeshSplitting_ = enabled > 0;
+  }
+
+  /// Enables or disables coalescing of concurrent requests for the same tile, style and
+  /// elevation type: one of them builds tile and others get copy of its output. Disabled
+  /// by default.
+  /// NOTE while enabled, output of every build is copied as it is delivered, so it can be
+  /// shared. Enable it only when host requests the same tile concurrently.
+  void enableRequestCoalescing(int enabled) {
+    isCoalescing_ = enabled > 0;
+  }
+
+  /// Gets data represented by elements and meshes for given quad key. When instancing is enabled,
+  /// repeated meshes are passed to mesh callback once as prototype followed by their instances.
+  void getDataByQuadKey(int tag,                                 // request tag
+                        const char *styleFile,                   // style file
+                        int tileX, int tileY, int levelOfDetail, // quad key info
+                        int eleDataType,                         // elevation data type
+                        OnMeshBuilt *meshCallback,               // mesh callback
+                        OnInstancesBuilt *instancesCallback,     // instances callback
+                        OnElementLoaded *elementCallback,        // element callback
+                        OnError *errorCallback,                  // error callback
+                        utymap::CancellationToken *cancellationToken) {
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback, instancesCallback,
+                     elementCallback, nullptr, 0, errorCallback, cancellationToken);
+  }
+
+  /// Gets data represented by elements and meshes for given quad key. Elements are
+  /// passed to callback in batches of given size.
+  void getDataByQuadKey(int tag,                                 // request tag
+                        const char *styleFile,                   // style file
+                        int tileX, int tileY, int levelOfDetail, // quad key info
+                        int eleDataType,                         // elevation data type
+                        int batchSize,                           // max amount of elements in one batch
+                        OnMeshBuilt *meshCallback,               // mesh callback
+                        OnElementsLoaded *elementsCallback,      // elements callback
+                        OnError *errorCallback,                  // error callback
+                        utymap::CancellationToken *cancellationToken) {
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, meshCallback, nullptr,
+                     nullptr, elementsCallback, batchSize, errorCallback, cancellationToken);
+  }
+
+  /// Warms storage data of given tiles in background, e.g. next ring of tiles while
+  /// camera is moving. New call replaces tiles which are not prefetched yet.
+  void prefetch(const int *tiles,                              // tile x and y pairs
+                int tileCount,                                 // amount of tiles
+                int levelOfDetail) {                           // level of detail
+    std::vector<utymap::QuadKey> quadKeys;
+    quadKeys.reserve(static_cast<std::size_t>(std::max(tileCount, 0)));
+    for (int i = 0; i < tileCount; ++i)
+      quadKeys.push_back(utymap::QuadKey(levelOfDetail, tiles[2 * i], tiles[2 * i + 1]));
+    context_.geoStore.prefetch(quadKeys);
+  }
+
+  /// Loads elevation data of given tiles in background, so tile build doesn't wait for
+  /// elevation files. Runs on I/O pool, so it goes in parallel with storage prefetch.
+  /// New call replaces tiles which are not prefetched yet. Errors are ignored.
+  void prefetchElevation(const int *tiles,                     // tile x and y pairs
+                         int tileCount,                        // amount of tiles
+                         int levelOfDetail,                    // level of detail
+                         int eleDataType) {                    // elevation data type
+    std::vector<utymap::QuadKey> quadKeys;
+    quadKeys.reserve(static_cast<std::size_t>(std::max(tileCount, 0)));
+    for (int i = 0; i < tileCount; ++i)
+      quadKeys.push_back(utymap::QuadKey(levelOfDetail, tiles[2 * i], tiles[2 * i + 1]));
     auto eleProviderType = static_cast<ElevationDataType>(eleDataType);
+    auto generation = ++elePrefetchGeneration_;
+
+    std::lock_guard<std::mutex> lock(elePrefetchLock_);
+    // NOTE new prefetch waits for previous one, so they don't run concurrently.
+    auto previous = std::make_shared<utymap::utils::ThreadPool::Future>(std::move(elePrefetchTask_));
+    elePrefetchTask_ = context_.ioPool.enqueue([this, quadKeys, eleProviderType, generation, previous]() {
+      if (previous->valid())
+        previous->wait();
+      *previous = utymap::utils::ThreadPool::Future();
+      for (const auto &quadKey : quadKeys) {
+        if (elePrefetchGeneration_ != generation)
+          break;
+        try {
+          context_.getElevationProvider(quadKey, eleProviderType).prefetch(quadKey);
+        } catch (const std::exception &) {
+          // NOTE prefetch is best effort: missing data is reported when tile is built.
+        }
+      }
+    });
+  }
+
+  /// Sets time in milliseconds after which quadkey request is cancelled. Zero means no limit.
+  /// NOTE budget is not applied to request which token has own deadline.
+  void setRequestBudget(int milliseconds) {
+    requestBudget_ = std::max(milliseconds, 0);
+  }
+
+  /// Sets amount of requests which are built at the same time on threads of CPU pool. Takes
+  /// effect for requests submitted after pending ones are finished.
+  void setRequestThreads(int threadCount) {
+    std::unique_ptr<utymap::utils::PriorityScheduler> scheduler;
+    {
+      std::lock_guard<std::mutex> lock(requestLock_);
+      requestThreads_ = static_cast<std::size_t>(std::max(threadCount, 1));
+      if (requestScheduler_ != nullptr && requestScheduler_->size() != requestThreads_)
+        scheduler = std::move(requestScheduler_);
+    }
+    // NOTE old scheduler finishes its requests outside of lock as callbacks may call back.
+  }
+
+  /// Queues tile build request. Requests with higher priority are built first, so host can
+  /// pass e.g. negative distance from tile to camera. Completion callback is called once
+  /// for every request including cancelled ones.
+  void submitDataByQuadKey(int tag, const char *styleFile,
+                           int tileX, int tileY, int levelOfDetail, int eleDataType,
+                           double priority,
+                           OnMeshBuilt *meshCallback,
+                           OnElementLoaded *elementCallback,
+                           OnError *errorCallback,
+                           OnRequestCompleted *completionCallback) {
+    submitDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, priority,
+                        meshCallback, elementCallback, nullptr, 0, errorCallback, completionCallback);
+  }
+
+  /// Queues tile build request. Elements, e.g. produced by external builder, are passed
+  /// to callback in batches of given size, so host is not called for every element.
+  void submitDataByQuadKey(int tag, const char *styleFile,
+                           int tileX, int tileY, int levelOfDetail, int eleDataType,
+                           double priority, int batchSize,
+                           OnMeshBuilt *meshCallback,
+                           OnElementsLoaded *elementsCallback,
+                           OnError *errorCallback,
+                           OnRequestCompleted *completionCallback) {
+    submitDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType, priority,
+                        meshCallback, nullptr, elementsCallback, batchSize, errorCallback, completionCallback);
+  }
+
+  /// Queues tile build job which keeps its result until it is fetched, so host polls completed
+  /// jobs instead of receiving callbacks on worker threads. Returns job id which is also used
+  /// as request tag, e.g. to change job priority.
+  int submitQuadKeyJob(const char *styleFile,
+                       int tileX, int tileY, int levelOfDetail, int eleDataType,
+                       double priority) {
+    auto job = std::make_shared<Job>();
+    int jobId;
+    {
+      std::lock_guard<std::mutex> lock(jobLock_);
+      jobId = ++lastJobId_;
+      jobs_.emplace(jobId, job);
+    }
+
+    std::string style = styleFile;
+    submitRequest(jobId, priority, [=](const utymap::CancellationToken &cancelToken) {
+      if (!cancelToken.isCancelled()) {
+        getDataByQuadKey(jobId, style.c_str(), tileX, tileY, levelOfDetail, eleDataType,
+          [&](const utymap::math::Mesh &mesh) {
+            auto copy = ownedMeshPool_.get(mesh.name, mesh.vertices.size()/3);
+            copy.vertices.assign(mesh.vertices.begin(), mesh.vertices.end());
+            copy.triangles.assign(mesh.triangles.begin(), mesh.triangles.end());
+            copy.colors.assign(mesh.colors.begin(), mesh.colors.end());
+            copy.uvs.assign(mesh.uvs.begin(), mesh.uvs.end());
+            copy.uvMap.assign(mesh.uvMap.begin(), mesh.uvMap.end());
+            job->meshes.push_back(std::move(copy));
+          }, nullptr,
+          [&](int, std::uint64_t id, const char **tags, int tagSize, const double *vertices, int vertexSize,
+              const char **styles, int styleSize) {
+            job->elements.push_back(JobElement { id,
+                                                 std::vector<std::string>(tags, tags + tagSize),
+                                                 std::vector<double>(vertices, vertices + vertexSize),
+                                                 std::vector<std::string>(styles, styles + styleSize) });
+          }, nullptr, 0,
+          [&](const char *message) { job->errors.push_back(message); },
+          // NOTE builder expects mutable token, but it only reads it.
+          const_cast<utymap::CancellationToken*>(&cancelToken));
+      }
+      std::lock_guard<std::mutex> lock(jobLock_);
+      job->isCompleted = true;
+      completedJobs_.push_back(jobId);
+    });
+    return jobId;
+  }
+
+  /// Copies ids of completed jobs which are not polled yet. Returns amount of copied ids.
+  /// NOTE cancelled jobs are completed too, their result is empty.
+  int pollCompletedJobs(int *jobIds, int maxCount) {
+    std::lock_guard<std::mutex> lock(jobLock_);
+    int count = 0;
+    for (; count < maxCount && !completedJobs_.empty(); ++count) {
+      jobIds[count] = completedJobs_.front();
+      completedJobs_.pop_front();
+    }
+    return count;
+  }
+
+  /// Passes result of completed job to given callbacks on calling thread and drops it.
+  /// Callbacks can be null to drop result only. Returns false if job is unknown or not completed.
+  bool fetchJobResult(int jobId,
+                      OnMeshBuilt *meshCallback,
+                      OnElementLoaded *elementCallback,
+                      OnError *errorCallback) {
+    auto job = takeJob(jobId, [](const Job &) { return true; });
+    if (job == nullptr)
+      return false;
+
+    for (auto &mesh : job->meshes) {
+      if (meshCallback != nullptr)
+        meshCallback(jobId, mesh.name.data(),
+          mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+          mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+          mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+          mesh.uvs.data(), static_cast<int>(mesh.uvs.size()),
+          mesh.uvMap.data(), static_cast<int>(mesh.uvMap.size()));
+      ownedMeshPool_.release(std::move(mesh));
+    }
+
+    passJobData(jobId, *job, elementCallback, errorCallback);
+    return true;
+  }
+
+  /// Gets total sizes of mesh arrays of completed job, so host can provide buffers for
+  /// fetchJobMeshes. Returns false if job is unknown or not completed.
+  bool getJobMeshSizes(int jobId, int *meshCount, int *vertexSize, int *triSize, int *colorSize,
+                       int *uvSize, int *uvMapSize) {
+    std::lock_guard<std::mutex> lock(jobLock_);
+    auto entry = jobs_.find(jobId);
+    if (entry == jobs_.end() || !entry->second->isCompleted)
+      return false;
+
+    auto sizes = getMeshSizes(*entry->second);
+    *meshCount = static_cast<int>(entry->second->meshes.size());
+    *vertexSize = sizes[0];
+    *triSize = sizes[1];
+    *colorSize = sizes[2];
+    *uvSize = sizes[3];
+    *uvMapSize = sizes[4];
+    return true;
+  }
+
+  /// Copies meshes of completed job into buffers provided by host, e.g. memory of native arrays,
+  /// so host doesn't allocate arrays per mesh. Arrays of meshes are written one after another,
+  /// mesh callback receives offset and size of every mesh in every buffer. Elements and errors
+  /// are passed to their callbacks and job is dropped. Returns false if job is unknown, not
+  /// completed or buffers are smaller than sizes reported by getJobMeshSizes: job is kept then.
+  /// NOTE triangle indices refer to vertices of their mesh.
+  bool fetchJobMeshes(int jobId,
+                      double *vertices, int vertexCapacity,
+                      int *triangles, int triCapacity,
+                      int *colors, int colorCapacity,
+                      double *uvs, int uvCapacity,
+                      int *uvMap, int uvMapCapacity,
+                      OnMeshWritten *meshCallback,
+                      OnElementLoaded *elementCallback,
+                      OnError *errorCallback) {
+    auto job = takeJob(jobId, [&](const Job &candidate) {
+      auto sizes = getMeshSizes(candidate);
+      return sizes[0] <= vertexCapacity && sizes[1] <= triCapacity && sizes[2] <= colorCapacity &&
+             sizes[3] <= uvCapacity && sizes[4] <= uvMapCapacity;
+    });
+    if (job == nullptr)
+      return false;
+
+    int vertexOffset = 0, triOffset = 0, colorOffset = 0, uvOffset = 0, uvMapOffset = 0;
+    for (auto &mesh : job->meshes) {
+      std::copy(mesh.vertices.begin(), mesh.vertices.end(), vertices + vertexOffset);
+      std::copy(mesh.triangles.begin(), mesh.triangles.end(), triangles + triOffset);
+      std::copy(mesh.colors.begin(), mesh.colors.end(), colors + colorOffset);
+      std::copy(mesh.uvs.begin(), mesh.uvs.end(), uvs + uvOffset);
+      std::copy(mesh.uvMap.begin(), mesh.uvMap.end(), uvMap + uvMapOffset);
+      if (meshCallback != nullptr)
+        meshCallback(jobId, mesh.name.data(),
+          vertexOffset, static_cast<int>(mesh.vertices.size()),
+          triOffset, static_cast<int>(mesh.triangles.size()),
+          colorOffset, static_cast<int>(mesh.colors.size()),
+          uvOffset, static_cast<int>(mesh.uvs.size()),
+          uvMapOffset, static_cast<int>(mesh.uvMap.size()));
+      vertexOffset += static_cast<int>(mesh.vertices.size());
+      triOffset += static_cast<int>(mesh.triangles.size());
+      colorOffset += static_cast<int>(mesh.colors.size());
+      uvOffset += static_cast<int>(mesh.uvs.size());
+      uvMapOffset += static_cast<int>(mesh.uvMap.size());
+      ownedMeshPool_.release(std::move(mesh));
+    }
+
+    passJobData(jobId, *job, elementCallback, errorCallback);
+    return true;
+  }
+
+  /// Changes priority of requests with given tag which are not started yet.
+  void setRequestPriority(int tag, double priority) {
+    std::lock_guard<std::mutex> lock(requestLock_);
+    if (requestScheduler_ != nullptr)
+      requestScheduler_->reprioritize(tag, priority);
+  }
+
+  /// Cancels pending and running requests which priority is below given threshold.
+  void cancelRequestsBelow(double threshold) {
+    std::lock_guard<std::mutex> lock(requestLock_);
+    if (requestScheduler_ != nullptr)
+      requestScheduler_->cancelBelow(threshold);
+  }
+
+  /// Builds given tiles on tile build scheduler and passes their meshes with quad key of tile.
+  /// Instances are expanded into copies of prototype and elements are not passed.
+  /// NOTE callbacks are called from worker threads, but never at the same time.
+  void getDataByQuadKeys(const char *styleFile,                                   // style file
+                         const std::vector<utymap::QuadKey> &quadKeys,            // quad keys of tiles
+                         int eleDataType,                                         // elevation data type
+                         const utymap::builders::TileBuildScheduler::MeshCallback &meshCallback,
+                         const std::function<OnError> &errorCallback,
+                         const utymap::CancellationToken &cancelToken) {
     ::safeExecute([&]() {
+      if (quadKeys.empty())
+        return;
       auto &styleProvider = context_.getStyleProvider(styleFile);
-      auto &eleProvider = context_.getElevationProvider(quadKey, eleProviderType);
-      ExportElementVisitor elementVisitor(tag, quadKey, context_.stringTable, styleProvider, eleProvider, elementCallback);
-      context_.quadKeyBuilder.build(
-        quadKey, styleProvider, eleProvider,
-        [&meshCallback, tag](const utymap::math::Mesh &mesh) {
-        // NOTE do not notify if mesh is empty.
-        if (!mesh.vertices.empty()) {
-          meshCallback(tag, mesh.name.data(),
-            mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
-            mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
-            mesh.colors.data(), static_cast<int>(mesh.colors.size()),
-            mesh.uvs.data(), static_cast<int>(mesh.uvs.size()),
-            mesh.uvMap.data(), static_cast<int>(mesh.uvMap.size()));
-        }
-      }, [&elementVisitor](const utymap::entities::Element &element) {
-        element.accept(elementVisitor);
-      }, *cancellationToken);
+      auto &eleProvider = context_.getElevationProvider(quadKeys.front(), static_cast<ElevationDataType>(eleDataType));
+      context_.geoStore.prefetch(quadKeys);
+      std::unordered_map<utymap::QuadKey, InstanceExpander, utymap::QuadKey::Hash> expanders;
+      getTileScheduler()->build(quadKeys, styleProvider, eleProvider,
+        [&](const utymap::QuadKey &quadKey, const utymap::math::Mesh &mesh) {
+          expanders[quadKey].add(mesh, [&](const utymap::math::Mesh &expanded) {
+            // NOTE do not notify if mesh is empty.
+            if (!expanded.vertices.empty())
+              meshCallback(quadKey, expanded);
+          });
+        },
+        [](const utymap::QuadKey &, const utymap::entities::Element &) {}, cancelToken);
     }, errorCallback);
   }
 
+  /// Gets elements matching given text query and passes them to given callback on calling thread,
+  /// so callbacks can keep state of request.
+  /// Note, that styles and real elevation height are not included.
+  void getDataByText(const char *notTerms, const char *andTerms, const char *orTerms,
+                     const utymap::BoundingBox &bbox, const utymap::LodRange &lodRange,
+                     int offset, int limit,
+                     const std::function<OnElementLoaded> &elementCallback,
+                     const std::function<OnError> &errorCallback,
+                     const utymap::CancellationToken &cancelToken) {
+    ExportElementVisitor elementVisitor(0, context_.stringTable, elementCallback);
+    getDataByText(notTerms, andTerms, orTerms, bbox, lodRange, offset, limit, elementVisitor,
+                  errorCallback, cancelToken);
+  }
+
+  /// Builds all tiles of given region and level of detail range on request threads, so mesh
+  /// cache is filled before data is shipped. Built data is not passed to host.
+  void bakeRegion(const char *styleFile,                          // style file
+                  double minLatitude, double minLongitude,        // bounding box of region
+                  double maxLatitude, double maxLongitude,
+                  int startLod, int endLod,                       // level of detail range
+                  int eleDataType,                                // elevation data type
+                  OnBakeProgress *progressCallback,               // progress callback
+                  OnError *errorCallback,                         // error callback
+                  utymap::CancellationToken *cancellationToken) {
+    utymap::BoundingBox bbox(utymap::GeoCoordinate(minLatitude, minLongitude),
+                             utymap::GeoCoordinate(maxLatitude, maxLongitude));
+    std::vector<utymap::QuadKey> quadKeys;
+    for (int lod = startLod; lod <= endLod; ++lod) {
+      utymap::utils::GeoUtils::visitTileRange(bbox, lod, utymap::utils::GeoUtils::TileOrder::Morton,
+                                              [&](const utymap::QuadKey &quadKey, const utymap::BoundingBox &) {
+        quadKeys.push_back(quadKey);
+      });
+    }
+
+    std::size_t threadCount;
+    {
+      std::lock_guard<std::mutex> lock(requestLock_);
+      threadCount = requestThreads_;
+    }
+
+    std::mutex progressLock;
+    std::uint64_t tilesBuilt = 0;
+    auto start = std::chrono::steady_clock::now();
+    // NOTE own scheduler is used, so interactive requests are not queued behind the region.
+    utymap::utils::PriorityScheduler scheduler(threadCount, &context_.cpuPool);
+    for (const auto &quadKey : quadKeys) {
+      // NOTE coarse tiles go first as they cover bigger area.
+      scheduler.submit(0, -quadKey.levelOfDetail, [&, quadKey](const utymap::CancellationToken &) {
+        if (cancellationToken->isCancelled()) return;
+        getDataByQuadKey(0, styleFile, quadKey.tileX, quadKey.tileY, quadKey.levelOfDetail, eleDataType,
+                         [](const utymap::math::Mesh &) {}, &skipInstances, &skipElement, nullptr, 0,
+                         errorCallback, cancellationToken);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::lock_guard<std::mutex> lock(progressLock);
+        progressCallback(++tilesBuilt, quadKeys.size(), elapsed.count());
+      });
+    }
+    // NOTE scheduler waits for all tiles when it is destroyed.
+  }
+
   /// Gets elevation for given geocoordinate using specific elevation provider.
   double getElevationByQuadKey(int tileX, int tileY, int levelOfDetail, // quadkey info
                                int eleDataType,                         // elevation data type
@@ -80,8 +757,174 @@ public:
     return context_.getElevationProvider(quadKey, eleProviderType).getElevation(quadKey, coordinate);
   }
 
+  /// Gets elevations for given geocoordinates stored as latitude, longitude pairs.
+  void getElevationsByQuadKey(int tileX, int tileY, int levelOfDetail, // quadkey info
+                              int eleDataType,                         // elevation data type
+                              const double *coordinates, int count,    // coordinates
+                              double *elevations) const {
+    utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+    auto eleProviderType = static_cast<ElevationDataType>(eleDataType);
+    std::vector<utymap::GeoCoordinate> geoCoordinates;
+    geoCoordinates.reserve(static_cast<std::size_t>(std::max(count, 0)));
+    for (int i = 0; i < count; ++i)
+      geoCoordinates.emplace_back(coordinates[2 * i], coordinates[2 * i + 1]);
+    context_.getElevationProvider(quadKey, eleProviderType)
+        .getElevations(quadKey, geoCoordinates.data(), elevations, geoCoordinates.size());
+  }
+
 private:
   Context &context_;
+  /// Last queued elevation prefetch.
+  utymap::utils::ThreadPool::Future elePrefetchTask_;
+  std::atomic<std::uint64_t> elePrefetchGeneration_;
+  std::mutex elePrefetchLock_;
+  std::unique_ptr<utymap::utils::PriorityScheduler> requestScheduler_;
+  std::shared_ptr<utymap::builders::TileBuildScheduler> tileScheduler_;
+  std::size_t requestThreads_;
+  std::atomic<int> requestBudget_;
+  std::mutex requestLock_;
+  std::atomic<bool> isMeshSplitting_;
+  std::atomic<bool> isCoalescing_;
+  /// Meshes passed to host with ownership by their handles.
+  std::unordered_map<std::uint64_t, utymap::math::Mesh> ownedMeshes_;
+  utymap::builders::MeshPool ownedMeshPool_;
+  std::uint64_t lastMeshHandle_;
+  std::mutex ownedMeshLock_;
+
+  /// Output of tile build in order of delivery which is shared with coalesced requests.
+  struct TileOutput final : public utymap::entities::ElementVisitor {
+    std::vector<utymap::math::Mesh> meshes;
+    std::vector<std::unique_ptr<utymap::entities::Element>> elements;
+    /// True for mesh and false for element at every position of delivery order.
+    std::vector<bool> order;
+
+    void add(const utymap::math::Mesh &mesh) {
+      meshes.emplace_back(mesh.name);
+      auto &copy = meshes.back();
+      copy.vertices.assign(mesh.vertices.begin(), mesh.vertices.end());
+      copy.triangles.assign(mesh.triangles.begin(), mesh.triangles.end());
+      copy.colors.assign(mesh.colors.begin(), mesh.colors.end());
+      copy.uvs.assign(mesh.uvs.begin(), mesh.uvs.end());
+      copy.uvMap.assign(mesh.uvMap.begin(), mesh.uvMap.end());
+      order.push_back(true);
+    }
+
+    void visitNode(const utymap::entities::Node &node) override { add(node); }
+    void visitWay(const utymap::entities::Way &way) override { add(way); }
+    void visitArea(const utymap::entities::Area &area) override { add(area); }
+    void visitRelation(const utymap::entities::Relation &relation) override { add(relation); }
+
+    /// Passes output to given callbacks in the same order as it was delivered by build.
+    void replay(const utymap::builders::BuilderContext::MeshCallback &meshCallback,
+                const utymap::builders::BuilderContext::ElementCallback &elementCallback) const {
+      std::size_t mesh = 0, element = 0;
+      for (bool isMesh : order) {
+        if (isMesh)
+          meshCallback(meshes[mesh++]);
+        else
+          elementCallback(*elements[element++]);
+      }
+    }
+
+   private:
+    template<typename T>
+    void add(const T &element) {
+      elements.push_back(utymap::utils::make_unique<T>(element));
+      order.push_back(false);
+    }
+  };
+
+  /// Builds of tiles which are running keyed by style, quad key and elevation type.
+  utymap::utils::SingleFlight<std::string, TileOutput> tileFlights_;
+
+  /// Element collected by job.
+  struct JobElement {
+    std::uint64_t id;
+    std::vector<std::string> tags;
+    std::vector<double> vertices;
+    std::vector<std::string> styles;
+  };
+
+  /// Result of tile build job which is kept until host fetches it.
+  struct Job {
+    std::vector<utymap::math::Mesh> meshes;
+    std::vector<JobElement> elements;
+    std::vector<std::string> errors;
+    bool isCompleted = false;
+  };
+
+  std::unordered_map<int, std::shared_ptr<Job>> jobs_;
+  std::deque<int> completedJobs_;
+  int lastJobId_;
+  std::mutex jobLock_;
+
+  /// Removes completed job which satisfies given predicate and returns it, otherwise returns null.
+  template<typename Predicate>
+  std::shared_ptr<Job> takeJob(int jobId, const Predicate &predicate) {
+    std::lock_guard<std::mutex> lock(jobLock_);
+    auto entry = jobs_.find(jobId);
+    if (entry == jobs_.end() || !entry->second->isCompleted || !predicate(*entry->second))
+      return nullptr;
+    auto job = entry->second;
+    jobs_.erase(entry);
+    return job;
+  }
+
+  /// Gets total sizes of vertices, triangles, colors, uvs and uv maps of job meshes.
+  static std::array<int, 5> getMeshSizes(const Job &job) {
+    std::array<int, 5> sizes = {{ 0, 0, 0, 0, 0 }};
+    for (const auto &mesh : job.meshes) {
+      sizes[0] += static_cast<int>(mesh.vertices.size());
+      sizes[1] += static_cast<int>(mesh.triangles.size());
+      sizes[2] += static_cast<int>(mesh.colors.size());
+      sizes[3] += static_cast<int>(mesh.uvs.size());
+      sizes[4] += static_cast<int>(mesh.uvMap.size());
+    }
+    return sizes;
+  }
+
+  /// Passes elements and errors of job to given callbacks which can be null.
+  static void passJobData(int jobId, const Job &job, OnElementLoaded *elementCallback, OnError *errorCallback) {
+    std::vector<const char *> tags, styles;
+    for (const auto &element : job.elements) {
+      if (elementCallback == nullptr)
+        break;
+      tags.clear();
+      styles.clear();
+      for (const auto &tag : element.tags)
+        tags.push_back(tag.c_str());
+      for (const auto &style : element.styles)
+        styles.push_back(style.c_str());
+      elementCallback(jobId, element.id,
+        tags.data(), static_cast<int>(tags.size()),
+        element.vertices.data(), static_cast<int>(element.vertices.size()),
+        styles.data(), static_cast<int>(styles.size()));
+    }
+
+    for (const auto &error : job.errors) {
+      if (errorCallback != nullptr)
+        errorCallback(error.c_str());
+    }
+  }
+
+  static void skipInstances(int, const char *, const double *, int) {}
+
+  static void skipElement(int, std::uint64_t, const char **, int, const double *, int, const char **, int) {}
+
+  int countByText(const char *notTerms, const char *andTerms, const char *orTerms,
+                  double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                  int startLod, int endLod, std::size_t maxCount,
+                  OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+    utymap::BoundingBox bbox(utymap::GeoCoordinate(minLatitude, minLongitude),
+                             utymap::GeoCoordinate(maxLatitude, maxLongitude));
+    utymap::LodRange lodRange(startLod, endLod);
+    int count = -1;
+    ::safeExecute([&]() {
+      auto result = context_.geoStore.count(notTerms, andTerms, orTerms, bbox, lodRange, maxCount, *cancellationToken);
+      count = static_cast<int>(std::min<std::size_t>(result, std::numeric_limits<int>::max()));
+    }, errorCallback);
+    return count;
+  }
 
   /// Exports elements to external code using element callback.
   struct ExportElementVisitor : public utymap::entities::ElementVisitor {
@@ -94,14 +937,14 @@ private:
       utymap::index::StringTable &stringTable,
       const utymap::mapcss::StyleProvider &styleProvider,
       const utymap::heightmap::ElevationProvider &eleProvider,
-      OnElementLoaded *elementCallback) :
+      const std::function<OnElementLoaded> &elementCallback) :
       tag_(tag), quadKey_(quadKey), stringTable_(stringTable), styleProvider_(&styleProvider),
       eleProvider_(&eleProvider), elementCallback_(elementCallback) {}
 
     /// Creates visitor which does not return style and real height.
     ExportElementVisitor(int tag,
       utymap::index::StringTable &stringTable,
-      OnElementLoaded *elementCallback) :
+      const std::function<OnElementLoaded> &elementCallback) :
       tag_(tag), quadKey_(), stringTable_(stringTable), styleProvider_(nullptr),
       eleProvider_(nullptr), elementCallback_(elementCallback) {}
 
@@ -121,72 +964,169 @@ private:
       // TODO return geometry
       visitElement(relation, Coordinates{ { 0, 0 } });
     }
+
+    /// Passes elements to given callback in batches of given size instead of element callback.
+    void setBatch(OnElementsLoaded *elementsCallback, int batchSize) {
+      elementsCallback_ = elementsCallback;
+      batchSize_ = static_cast<std::size_t>(std::max(batchSize, 1));
+    }
+
+    /// Passes elements with string ids to given callback instead of element callback.
+    void setIds(OnStringsAdded *stringsCallback, OnElementIdsLoaded *elementIdsCallback) {
+      stringsCallback_ = stringsCallback;
+      elementIdsCallback_ = elementIdsCallback;
+    }
+
+    /// Passes pending batch to elements callback.
+    void flush() {
+      if (ids_.empty())
+        return;
+
+      elementsCallback_(tag_, ids_.data(), static_cast<int>(ids_.size()),
+        tags_.data(), tagOffsets_.data(),
+        vertices_.data(), vertexOffsets_.data(),
+        styles_.data(), styleOffsets_.data());
+
+      // NOTE clear vectors after raw array data is consumed by external code
+      clear();
+    }
+
   private:
     void visitElement(const utymap::entities::Element &element,
       const Coordinates &coordinates) {
-      auto ctags = getTags(element);
-      auto cstyles = getStyles(element);
+      if (elementIdsCallback_ != nullptr) {
+        visitElementIds(element, coordinates);
+        return;
+      }
+
+      if (elementsCallback_ != nullptr && ids_.empty()) {
+        tagOffsets_.push_back(0);
+        vertexOffsets_.push_back(0);
+        styleOffsets_.push_back(0);
+      }
 
+      fillTags(element);
+      fillStyles(element);
       fillVertices(coordinates);
 
+      if (elementsCallback_ != nullptr) {
+        ids_.push_back(element.id);
+        tagOffsets_.push_back(static_cast<int>(tags_.size()));
+        vertexOffsets_.push_back(static_cast<int>(vertices_.size()));
+        styleOffsets_.push_back(static_cast<int>(styles_.size()));
+        if (ids_.size() >= batchSize_)
+          flush();
+        return;
+      }
+
+      TRACE_ZONE("elementCallback", quadKey_, tag_);
       elementCallback_(tag_, element.id,
-        ctags.data(), static_cast<int>(ctags.size()),
+        tags_.data(), static_cast<int>(tags_.size()),
         vertices_.data(), static_cast<int>(vertices_.size()),
-        cstyles.data(), static_cast<int>(cstyles.size()));
+        styles_.data(), static_cast<int>(styles_.size()));
 
       // NOTE clear vectors after raw array data is consumed by external code
+      clear();
+    }
+
+    void visitElementIds(const utymap::entities::Element &element, const Coordinates &coordinates) {
+      for (const auto &tag : element.tags) {
+        tagIds_.push_back(addString(tag.key));
+        tagIds_.push_back(addString(tag.value));
+      }
+
+      if (styleProvider_ != nullptr) {
+        utymap::mapcss::Style style = styleProvider_->forElement(element, quadKey_.levelOfDetail);
+        for (const auto &declaration : style.declarations()) {
+          // NOTE declaration values are stylesheet strings, so their ids are resolved once.
+          auto pair = styleValueIds_.find(declaration);
+          if (pair == styleValueIds_.end())
+            pair = styleValueIds_.emplace(declaration, stringTable_.getId(declaration->value())).first;
+          styleIds_.push_back(addString(declaration->key()));
+          styleIds_.push_back(addString(pair->second));
+        }
+      }
+
+      fillVertices(coordinates);
+
+      if (!newIds_.empty()) {
+        stringsCallback_(tag_, newIds_.data(), newStrings_.data(), static_cast<int>(newIds_.size()));
+        newIds_.clear();
+        newStrings_.clear();
+      }
+
+      elementIdsCallback_(tag_, element.id,
+        tagIds_.data(), static_cast<int>(tagIds_.size()),
+        vertices_.data(), static_cast<int>(vertices_.size()),
+        styleIds_.data(), static_cast<int>(styleIds_.size()));
+
+      tagIds_.clear();
+      styleIds_.clear();
       vertices_.clear();
-      tagStrings_.clear();
+    }
+
+    /// Returns given string id and remembers its string if it is not passed yet.
+    std::uint32_t addString(std::uint32_t id) {
+      if (sentIds_.insert(id)) {
+        newIds_.push_back(id);
+        // NOTE views are null terminated and stay valid while string table exists.
+        newStrings_.push_back(stringTable_.getStringView(id).data);
+      }
+      return id;
+    }
+
+    void clear() {
+      ids_.clear();
+      tags_.clear();
+      vertices_.clear();
+      styles_.clear();
+      tagOffsets_.clear();
+      vertexOffsets_.clear();
+      styleOffsets_.clear();
       styleStrings_.clear();
     }
 
-    /// Gets tags.
-    std::vector<const char *> getTags(const utymap::entities::Element &element) {
-      std::vector<const char *> ctags;
-      tagStrings_.reserve(element.tags.size() * 2);
-      ctags.reserve(element.tags.size() * 2);
+    /// Appends tags.
+    void fillTags(const utymap::entities::Element &element) {
+      tags_.reserve(tags_.size() + element.tags.size() * 2);
+      // NOTE views are null terminated and stay valid while string table exists.
       for (std::size_t i = 0; i < element.tags.size(); ++i) {
         const utymap::entities::Tag &tag = element.tags[i];
-        auto key = stringTable_.getString(tag.key);
-        auto value = stringTable_.getString(tag.value);
-        tagStrings_.push_back(*key);
-        tagStrings_.push_back(*value);
-        ctags.push_back(tagStrings_[tagStrings_.size() - 2].c_str());
-        ctags.push_back(tagStrings_[tagStrings_.size() - 1].c_str());
+        tags_.push_back(stringTable_.getStringView(tag.key).data);
+        tags_.push_back(stringTable_.getStringView(tag.value).data);
       }
-
-      return std::move(ctags);
     }
 
-    /// Gets and converts style to their string representation.
-    std::vector<const char *> getStyles(const utymap::entities::Element &element) {
-      std::vector<const char *> cstyles;
+    /// Appends styles converted to their string representation.
+    void fillStyles(const utymap::entities::Element &element) {
       if (styleProvider_ == nullptr)
-        return cstyles;
+        return;
 
       utymap::mapcss::Style style = styleProvider_->forElement(element, quadKey_.levelOfDetail);
-      auto declarations = style.declarations();
-      styleStrings_.reserve(declarations.size() * 2);
-      cstyles.reserve(declarations.size());
+      const auto &declarations = style.declarations();
+      styles_.reserve(styles_.size() + declarations.size() * 2);
       for (const auto &declaration : declarations) {
         auto decKey = stringTable_.getString(declaration->key());
+        // NOTE deque keeps strings in place while batch grows.
         styleStrings_.push_back(*decKey);
+        styles_.push_back(styleStrings_.back().c_str());
         styleStrings_.push_back(declaration->value());
-        cstyles.push_back(styleStrings_[styleStrings_.size() - 2].c_str());
-        cstyles.push_back(styleStrings_[styleStrings_.size() - 1].c_str());
+        styles_.push_back(styleStrings_.back().c_str());
       }
-
-      return std::move(cstyles);
     }
 
     /// Converts geometry.
     void fillVertices(const Coordinates &coordinates) {
-      vertices_.reserve(coordinates.size() * 3);
+      elevations_.assign(coordinates.size(), 0);
+      if (eleProvider_ != nullptr)
+        eleProvider_->getElevations(quadKey_, coordinates.data(), elevations_.data(), coordinates.size());
+
+      vertices_.reserve(vertices_.size() + coordinates.size() * 3);
       for (std::size_t i = 0; i < coordinates.size(); ++i) {
         const utymap::GeoCoordinate coordinate = coordinates[i];
         vertices_.push_back(coordinate.longitude);
         vertices_.push_back(coordinate.latitude);
-        vertices_.push_back(eleProvider_ == nullptr ? 0 : eleProvider_->getElevation(quadKey_, coordinate));
+        vertices_.push_back(elevations_[i]);
       }
     }
 
@@ -196,12 +1136,240 @@ private:
 
     const utymap::mapcss::StyleProvider *styleProvider_;
     const utymap::heightmap::ElevationProvider *eleProvider_;
-    OnElementLoaded *elementCallback_;
+    std::function<OnElementLoaded> elementCallback_;
+    OnElementsLoaded *elementsCallback_ = nullptr;
+    std::size_t batchSize_ = 1;
 
+    std::vector<std::uint64_t> ids_;
+    std::vector<const char *> tags_;
     std::vector<double> vertices_;
-    std::vector<std::string> tagStrings_;   // holds temporary tag strings
-    std::vector<std::string> styleStrings_; // holds temporary style strings
+    std::vector<double> elevations_;
+    std::vector<const char *> styles_;
+    std::vector<int> tagOffsets_;
+    std::vector<int> vertexOffsets_;
+    std::vector<int> styleOffsets_;
+    std::deque<std::string> styleStrings_; // holds temporary style strings
+
+    OnStringsAdded *stringsCallback_ = nullptr;
+    OnElementIdsLoaded *elementIdsCallback_ = nullptr;
+    std::vector<std::uint32_t> tagIds_;
+    std::vector<std::uint32_t> styleIds_;
+    std::vector<std::uint32_t> newIds_;
+    std::vector<const char *> newStrings_;
+    utymap::utils::IdSet sentIds_;
+    std::unordered_map<const utymap::mapcss::StyleDeclaration *, std::uint32_t> styleValueIds_;
   };
+
+  void getDataByText(const char *notTerms, const char *andTerms, const char *orTerms,
+                     double minLatitude, double minLongitude, double maxLatitude, double maxLongitude,
+                     int startLod, int endLod, int offset, int limit,
+                     ExportElementVisitor &elementVisitor,
+                     OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+    utymap::BoundingBox bbox(utymap::GeoCoordinate(minLatitude, minLongitude),
+                             utymap::GeoCoordinate(maxLatitude, maxLongitude));
+    getDataByText(notTerms, andTerms, orTerms, bbox, utymap::LodRange(startLod, endLod), offset, limit,
+                  elementVisitor, errorCallback, *cancellationToken);
+  }
+
+  void getDataByText(const char *notTerms, const char *andTerms, const char *orTerms,
+                     const utymap::BoundingBox &bbox, const utymap::LodRange &lodRange,
+                     int offset, int limit,
+                     ExportElementVisitor &elementVisitor,
+                     const std::function<OnError> &errorCallback, const utymap::CancellationToken &cancelToken) {
+    ::safeExecute([&]() {
+      context_.geoStore.search(notTerms, andTerms, orTerms, bbox, lodRange,
+                               static_cast<std::size_t>(std::max(offset, 0)),
+                               static_cast<std::size_t>(std::max(limit, 0)),
+                               elementVisitor, cancelToken);
+      elementVisitor.flush();
+    }, errorCallback);
+  }
+
+  /// Replaces instances of prototype mesh with its copies. Prototype is built before its instances.
+  class InstanceExpander final {
+   public:
+    /// Passes given mesh or its expanded copies to callback. Prototypes are kept, not passed.
+    void add(const utymap::math::Mesh &mesh, const std::function<void(const utymap::math::Mesh &)> &callback) {
+      const auto &prototypePrefix = utymap::builders::MeshInstancer::prototypePrefix();
+      const auto &instancesPrefix = utymap::builders::MeshInstancer::instancesPrefix();
+      if (mesh.name.compare(0, prototypePrefix.size(), prototypePrefix) == 0) {
+        auto name = mesh.name.substr(prototypePrefix.size());
+        auto &prototype = prototypes_.emplace(name, utymap::math::Mesh(name)).first->second;
+        prototype.clear();
+        utymap::utils::copyMesh(utymap::math::Vector3(0, 0, 0), mesh, prototype);
+      } else if (mesh.name.compare(0, instancesPrefix.size(), instancesPrefix) == 0) {
+        auto prototype = prototypes_.find(mesh.name.substr(instancesPrefix.size()));
+        if (prototype == prototypes_.end())
+          return;
+        utymap::math::Mesh copies(prototype->first);
+        utymap::builders::MeshInstancer::expand(prototype->second, mesh, copies);
+        callback(copies);
+      } else
+        callback(mesh);
+    }
+
+   private:
+    std::map<std::string, utymap::math::Mesh> prototypes_;
+  };
+
+  /// Returns tile build scheduler which is created on first use with amount of request threads.
+  /// NOTE scheduler is shared, so it is kept by running build when amount of threads is changed.
+  std::shared_ptr<utymap::builders::TileBuildScheduler> getTileScheduler() {
+    std::lock_guard<std::mutex> lock(requestLock_);
+    if (tileScheduler_ == nullptr || tileScheduler_->size() != requestThreads_)
+      tileScheduler_ = std::make_shared<utymap::builders::TileBuildScheduler>(context_.quadKeyBuilder,
+                                                                              requestThreads_);
+    return tileScheduler_;
+  }
+
+  /// Queues task on request scheduler which is created on first use.
+  void submitRequest(int tag, double priority, const utymap::utils::PriorityScheduler::Task &task) {
+    std::lock_guard<std::mutex> lock(requestLock_);
+    if (requestScheduler_ == nullptr)
+      requestScheduler_ = utymap::utils::make_unique<utymap::utils::PriorityScheduler>(requestThreads_,
+                                                                                      &context_.cpuPool);
+    requestScheduler_->submit(tag, priority, task);
+  }
+
+  /// NOTE elements are passed either to element or to elements callback.
+  void submitDataByQuadKey(int tag, const char *styleFile,
+                           int tileX, int tileY, int levelOfDetail, int eleDataType,
+                           double priority,
+                           OnMeshBuilt *meshCallback,
+                           OnElementLoaded *elementCallback,
+                           OnElementsLoaded *elementsCallback, int batchSize,
+                           OnError *errorCallback,
+                           OnRequestCompleted *completionCallback) {
+    std::string style = styleFile;
+    submitRequest(tag, priority, [=](const utymap::CancellationToken &cancelToken) {
+      if (!cancelToken.isCancelled()) {
+        // NOTE builder expects mutable token, but it only reads it.
+        getDataByQuadKey(tag, style.c_str(), tileX, tileY, levelOfDetail, eleDataType,
+                         meshCallback, nullptr, elementCallback, elementsCallback, batchSize, errorCallback,
+                         const_cast<utymap::CancellationToken*>(&cancelToken));
+      }
+      completionCallback(tag, cancelToken.isCancelled() ? 1 : 0);
+    });
+  }
+
+  void getDataByQuadKey(int tag, const char *styleFile,
+                        int tileX, int tileY, int levelOfDetail, int eleDataType,
+                        OnMeshBuilt *meshCallback,
+                        OnInstancesBuilt *instancesCallback,
+                        OnElementLoaded *elementCallback,
+                        OnElementsLoaded *elementsCallback, int batchSize,
+                        OnError *errorCallback, utymap::CancellationToken *cancellationToken) {
+    getDataByQuadKey(tag, styleFile, tileX, tileY, levelOfDetail, eleDataType,
+      [&](const utymap::math::Mesh &mesh) { notifyMesh(meshCallback, tag, mesh); },
+      instancesCallback, elementCallback, elementsCallback, batchSize, errorCallback, cancellationToken);
+  }
+
+  static void notifyMesh(OnMeshBuilt *meshCallback, int tag, const utymap::math::Mesh &mesh) {
+    meshCallback(tag, mesh.name.data(),
+      mesh.vertices.data(), static_cast<int>(mesh.vertices.size()),
+      mesh.triangles.data(), static_cast<int>(mesh.triangles.size()),
+      mesh.colors.data(), static_cast<int>(mesh.colors.size()),
+      mesh.uvs.data(), static_cast<int>(mesh.uvs.size()),
+      mesh.uvMap.data(), static_cast<int>(mesh.uvMap.size()));
+  }
+
+  /// Builds tile or waits for build of the same tile which is already running and gets its output.
+  /// NOTE output of cancelled or failed build is not shared: waiting requests build tile themselves.
+  void buildTile(const utymap::QuadKey &quadKey, const char *styleFile, int eleDataType,
+                 const utymap::mapcss::StyleProvider &styleProvider,
+                 const utymap::heightmap::ElevationProvider &eleProvider,
+                 const utymap::builders::BuilderContext::MeshCallback &meshCallback,
+                 const utymap::builders::BuilderContext::ElementCallback &elementCallback,
+                 const utymap::CancellationToken &cancelToken) {
+    if (!isCoalescing_) {
+      context_.quadKeyBuilder.build(quadKey, styleProvider, eleProvider, meshCallback, elementCallback, cancelToken);
+      return;
+    }
+
+    std::string key = styleFile;
+    key.push_back('|');
+    utymap::utils::GeoUtils::appendQuadKey(quadKey, key);
+    key.push_back('|');
+    key.append(std::to_string(eleDataType));
+
+    bool isLeader = false;
+    auto output = tileFlights_.run(key, [&]() {
+      auto recorded = std::make_shared<TileOutput>();
+      context_.quadKeyBuilder.build(quadKey, styleProvider, eleProvider,
+        [&](const utymap::math::Mesh &mesh) {
+          recorded->add(mesh);
+          meshCallback(mesh);
+        },
+        [&](const utymap::entities::Element &element) {
+          element.accept(*recorded);
+          elementCallback(element);
+        }, cancelToken);
+      return cancelToken.isCancelled() ? nullptr : std::shared_ptr<const TileOutput>(std::move(recorded));
+    }, cancelToken, isLeader);
+
+    if (isLeader)
+      return;
+    if (output != nullptr)
+      output->replay(meshCallback, elementCallback);
+    else if (!cancelToken.isCancelled())
+      context_.quadKeyBuilder.build(quadKey, styleProvider, eleProvider, meshCallback, elementCallback, cancelToken);
+  }
+
+  /// NOTE elements are passed either to element or to elements callback.
+  /// NOTE instances are expanded into copies of prototype when there is no instances callback.
+  void getDataByQuadKey(int tag, const char *styleFile,
+                        int tileX, int tileY, int levelOfDetail, int eleDataType,
+                        const std::function<void(const utymap::math::Mesh &)> &meshCallback,
+                        OnInstancesBuilt *instancesCallback,
+                        const std::function<OnElementLoaded> &elementCallback,
+                        OnElementsLoaded *elementsCallback, int batchSize,
+                        const std::function<OnError> &errorCallback, utymap::CancellationToken *cancellationToken,
+                        OnStringsAdded *stringsCallback = nullptr,
+                        OnElementIdsLoaded *elementIdsCallback = nullptr) {
+    // NOTE budget is applied to token of request, so token of caller stays as it is.
+    utymap::CancellationToken requestToken(cancellationToken);
+    int budget = requestBudget_;
+    if (budget > 0 && !cancellationToken->hasDeadline())
+      requestToken.setDeadline(std::chrono::milliseconds(budget));
+
+    utymap::QuadKey quadKey(levelOfDetail, tileX, tileY);
+    auto eleProviderType = static_cast<ElevationDataType>(eleDataType);
+    ::safeExecute([&]() {
+      TRACE_ZONE("request", quadKey, tag);
+      auto &styleProvider = context_.getStyleProvider(styleFile);
+      auto &eleProvider = context_.getElevationProvider(quadKey, eleProviderType);
+      ExportElementVisitor elementVisitor(tag, quadKey, context_.stringTable, styleProvider, eleProvider, elementCallback);
+      if (elementsCallback != nullptr)
+        elementVisitor.setBatch(elementsCallback, batchSize);
+      if (elementIdsCallback != nullptr)
+        elementVisitor.setIds(stringsCallback, elementIdsCallback);
+      auto notifyMesh = [&](const utymap::math::Mesh &mesh) {
+        // NOTE do not notify if mesh is empty.
+        if (mesh.vertices.empty())
+          return;
+        TRACE_ZONE("meshCallback", quadKey, tag);
+        meshCallback(mesh);
+      };
+      InstanceExpander expander;
+      buildTile(quadKey, styleFile, eleDataType, styleProvider, eleProvider,
+        [&](const utymap::math::Mesh &mesh) {
+        const auto &prototypePrefix = utymap::builders::MeshInstancer::prototypePrefix();
+        const auto &instancesPrefix = utymap::builders::MeshInstancer::instancesPrefix();
+        if (instancesCallback != nullptr) {
+          if (mesh.name.compare(0, instancesPrefix.size(), instancesPrefix) == 0)
+            instancesCallback(tag, (prototypePrefix + mesh.name.substr(instancesPrefix.size())).data(),
+                              mesh.vertices.data(), static_cast<int>(mesh.vertices.size()));
+          else
+            notifyMesh(mesh);
+        } else
+          expander.add(mesh, notifyMesh);
+      }, [&elementVisitor](const utymap::entities::Element &element) {
+        element.accept(elementVisitor);
+      }, requestToken);
+      elementVisitor.flush();
+    }, errorCallback);
+  }
+
 };
 
 #endif // SEARCH_HPP_DEFINED
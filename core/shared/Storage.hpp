@@ -56,6 +56,43 @@ public:
     }, errorCallback);
   }
 
+  /// Adds data from many files to store for specific level of details range.
+  /// Files are parsed concurrently.
+  void addToStore(const char *key,           // store key
+                  const char **styleFiles,   // style file of every path
+                  const char **paths,        // paths to data
+                  int count,                 // amount of paths
+                  int startLod,              // start zoom level
+                  int endLod,                // end zoom level
+                  OnError *errorCallback,    // error callback
+                  utymap::CancellationToken *cancelToken) {
+    utymap::LodRange lodRange(startLod, endLod);
+    ::safeExecute([&]() {
+      std::vector<utymap::index::GeoStore::ImportFile> files;
+      files.reserve(static_cast<std::size_t>(count));
+      for (int i = 0; i < count; ++i)
+        files.push_back({ paths[i], context_.getStyleProvider(styleFiles[i]) });
+      context_.geoStore.add(key, files, lodRange, *cancelToken);
+    }, errorCallback);
+  }
+
+  /// Applies OSM change file to store for specific level of details range.
+  /// Returns quad keys which content was changed.
+  std::vector<utymap::QuadKey> applyChanges(const char *key,           // store key
+                                            const char *styleFile,     // style file
+                                            const char *path,          // path to change file
+                                            int startLod,              // start zoom level
+                                            int endLod,                // end zoom level
+                                            OnError *errorCallback,    // error callback
+                                            utymap::CancellationToken *cancelToken) {
+    utymap::LodRange lodRange(startLod, endLod);
+    std::vector<utymap::QuadKey> quadKeys;
+    ::safeExecute([&]() {
+      quadKeys = context_.geoStore.applyChanges(key, path, lodRange, context_.getStyleProvider(styleFile), *cancelToken);
+    }, errorCallback);
+    return quadKeys;
+  }
+
   /// Adds element to store.
   /// NOTE: relation is not yet supported.
   void addToStore(const char *key,           // store key
@@ -116,6 +153,11 @@ public:
     return context_.geoStore.hasData(utymap::QuadKey(levelOfDetail, tileX, tileY));
   }
 
+  /// Gets summary of elements stored in all registered stores for given quad key.
+  utymap::index::TileSummary getSummary(int tileX, int tileY, int levelOfDetail) const {
+    return context_.geoStore.getSummary(utymap::QuadKey(levelOfDetail, tileX, tileY));
+  }
+
 private:
   /// Adds element to store.
   void addToStore(const char *key,
@@ -0,0 +1,333 @@
+#ifndef TILESERVICE_HPP_DEFINED
+#define TILESERVICE_HPP_DEFINED
+
+#include "Search.hpp"
+#include "index/MeshStream.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/LruCache.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// Serves tiles, text search and elevation by request target, so transport is kept outside:
+///   /tile/<lod>/<x>/<y>[?ele=<type>]         meshes of tile as sequence of compact mesh records
+///   /search?bbox=&and=&or=&not=&lod=&limit=  elements matching text query inside of bbox as json
+///   /elevation/<lod>/<x>/<y>?at=<lat>,<lon>  elevation in meters
+/// Tile requests are queued and dispatcher thread builds all queued tiles at once on tile build
+/// scheduler of search. Identical concurrent tile requests share one build and built tiles are
+/// kept in memory.
+class TileService final {
+ public:
+  /// Response which is shared by coalesced requests and kept in cache.
+  struct Response {
+    int status;
+    std::string contentType;
+    std::string body;
+  };
+
+  TileService(Search &search, const std::string &styleFile, std::size_t cacheSize) :
+    search_(search), styleFile_(styleFile), cache_(cacheSize), isStopped_(false),
+    dispatcher_([this]() { dispatch(); }) {}
+
+  ~TileService() {
+    stop();
+  }
+
+  TileService(const TileService &) = delete;
+  TileService &operator=(const TileService &) = delete;
+
+  /// Handles request with given target. Blocks until response is ready.
+  /// NOTE malformed numbers are reported by exception.
+  std::shared_ptr<const Response> handle(const std::string &target) {
+    auto queryStart = target.find('?');
+    auto segments = splitPath(target.substr(0, queryStart));
+    auto parameters = parseQuery(queryStart == std::string::npos ? "" : target.substr(queryStart + 1));
+    int eleDataType = parameters.count("ele") > 0 ? std::stoi(parameters["ele"]) : 0;
+
+    if (segments.size() == 4 && segments[0] == "tile")
+      return getTile(utymap::QuadKey(std::stoi(segments[1]), std::stoi(segments[2]), std::stoi(segments[3])),
+                     eleDataType);
+
+    if (segments.size() == 4 && segments[0] == "elevation") {
+      auto coordinate = parseNumbers(parameters["at"]);
+      if (coordinate.size() != 2)
+        return createResponse(400, "text/plain", "Expected at=latitude,longitude");
+      double elevation = search_.getElevationByQuadKey(std::stoi(segments[2]), std::stoi(segments[3]),
+                                                       std::stoi(segments[1]), eleDataType,
+                                                       coordinate[0], coordinate[1]);
+      return createResponse(200, "text/plain", std::to_string(elevation));
+    }
+
+    if (segments.size() == 1 && segments[0] == "search")
+      return search(parameters);
+
+    return createResponse(404, "text/plain", "Unknown endpoint");
+  }
+
+  /// Stops dispatcher: running build is cancelled, waiting and later tile requests get 503.
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (isStopped_)
+        return;
+      isStopped_ = true;
+    }
+    cancelToken_.cancel();
+    condition_.notify_all();
+    dispatcher_.join();
+
+    auto response = createResponse(503, "text/plain", "Service is stopped");
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto &request : queue_)
+      request.promise.set_value(response);
+    queue_.clear();
+    pending_.clear();
+  }
+
+ private:
+  /// Tile request which waits for dispatcher.
+  struct TileRequest {
+    std::string key;
+    utymap::QuadKey quadKey;
+    int eleDataType;
+    std::promise<std::shared_ptr<const Response>> promise;
+  };
+
+  std::shared_ptr<const Response> getTile(const utymap::QuadKey &quadKey, int eleDataType) {
+    std::string key;
+    utymap::utils::GeoUtils::appendQuadKey(quadKey, key);
+    key.push_back('|');
+    key.append(std::to_string(eleDataType));
+
+    std::shared_future<std::shared_ptr<const Response>> future;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (isStopped_)
+        return createResponse(503, "text/plain", "Service is stopped");
+      if (cache_.exists(key))
+        return cache_.get(key);
+
+      auto pending = pending_.find(key);
+      if (pending != pending_.end())
+        future = pending->second;
+      else {
+        queue_.push_back(TileRequest { key, quadKey, eleDataType, {} });
+        future = queue_.back().promise.get_future().share();
+        pending_.emplace(key, future);
+        condition_.notify_one();
+      }
+    }
+    return future.get();
+  }
+
+  std::shared_ptr<const Response> search(std::unordered_map<std::string, std::string> &parameters) {
+    // NOTE bbox is required as every quadkey inside of it is visited.
+    auto bbox = parseNumbers(parameters["bbox"]);
+    auto lods = parseNumbers(parameters.count("lod") > 0 ? parameters["lod"] : "16,16");
+    if (bbox.size() != 4 || lods.size() != 2)
+      return createResponse(400, "text/plain", "Expected bbox=minLat,minLon,maxLat,maxLon and lod=start,end");
+
+    std::stringstream stream;
+    std::string error;
+    bool isFirst = true;
+    stream << "[";
+    utymap::CancellationToken cancelToken;
+    search_.getDataByText(parameters["not"].c_str(), parameters["and"].c_str(), parameters["or"].c_str(),
+                          utymap::BoundingBox(utymap::GeoCoordinate(bbox[0], bbox[1]),
+                                              utymap::GeoCoordinate(bbox[2], bbox[3])),
+                          utymap::LodRange(static_cast<int>(lods[0]), static_cast<int>(lods[1])),
+                          0, parameters.count("limit") > 0 ? std::stoi(parameters["limit"]) : 100,
+                          [&](int, std::uint64_t id, const char **tags, int tagCount,
+                              const double *vertices, int vertexCount, const char **, int) {
+                            if (!isFirst)
+                              stream << ",";
+                            isFirst = false;
+                            writeElement(stream, id, tags, tagCount, vertices, vertexCount);
+                          },
+                          [&](const char *message) {
+                            if (error.empty())
+                              error = message;
+                          }, cancelToken);
+    stream << "]";
+
+    if (!error.empty())
+      return createResponse(500, "text/plain", error);
+    return createResponse(200, "application/json", stream.str());
+  }
+
+  /// Takes all queued tile requests and builds them until service is stopped.
+  void dispatch() {
+    while (true) {
+      std::vector<TileRequest> requests;
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        condition_.wait(lock, [this]() { return isStopped_ || !queue_.empty(); });
+        if (isStopped_)
+          return;
+        std::move(queue_.begin(), queue_.end(), std::back_inserter(requests));
+        queue_.clear();
+      }
+
+      // NOTE coarse tiles go first as they are visible from far away.
+      std::stable_sort(requests.begin(), requests.end(), [](const TileRequest &left, const TileRequest &right) {
+        return left.eleDataType < right.eleDataType ||
+              (left.eleDataType == right.eleDataType && left.quadKey.levelOfDetail < right.quadKey.levelOfDetail);
+      });
+
+      for (auto begin = requests.begin(); begin != requests.end();) {
+        auto end = std::find_if(begin, requests.end(), [&](const TileRequest &request) {
+          return request.eleDataType != begin->eleDataType;
+        });
+        build(begin, end);
+        begin = end;
+      }
+    }
+  }
+
+  /// Builds tiles of given requests which have the same elevation type and completes them.
+  void build(std::vector<TileRequest>::iterator begin, std::vector<TileRequest>::iterator end) {
+    std::vector<utymap::QuadKey> quadKeys;
+    std::unordered_map<utymap::QuadKey, std::string, utymap::QuadKey::Hash> bodies;
+    for (auto request = begin; request != end; ++request) {
+      quadKeys.push_back(request->quadKey);
+      bodies.emplace(request->quadKey, std::string());
+    }
+
+    std::string error;
+    search_.getDataByQuadKeys(styleFile_.c_str(), quadKeys, begin->eleDataType,
+      [&](const utymap::QuadKey &quadKey, const utymap::math::Mesh &mesh) {
+        std::stringstream stream;
+        utymap::index::MeshStream::writeCompact(stream, mesh, utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey));
+        bodies[quadKey].append(stream.str());
+      },
+      [&](const char *message) {
+        if (error.empty())
+          error = message;
+      }, cancelToken_);
+
+    // NOTE tiles are built together, so error of one of them fails all.
+    std::shared_ptr<const Response> failure;
+    if (cancelToken_.isCancelled())
+      failure = createResponse(503, "text/plain", "Service is stopped");
+    else if (!error.empty())
+      failure = createResponse(500, "text/plain", error);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    for (auto request = begin; request != end; ++request) {
+      auto response = failure;
+      if (response == nullptr) {
+        response = createResponse(200, "application/octet-stream", std::move(bodies[request->quadKey]));
+        cache_.put(request->key, response);
+      }
+      pending_.erase(request->key);
+      request->promise.set_value(response);
+    }
+  }
+
+  static std::shared_ptr<const Response> createResponse(int status, const std::string &contentType, std::string body) {
+    return std::make_shared<const Response>(Response { status, contentType, std::move(body) });
+  }
+
+  static void writeElement(std::ostream &stream, std::uint64_t id, const char **tags, int tagCount,
+                           const double *vertices, int vertexCount) {
+    stream << "{\"id\":" << id << ",\"tags\":{";
+    for (int i = 0; i + 1 < tagCount; i += 2) {
+      stream << (i == 0 ? "" : ",");
+      writeJsonString(stream, tags[i]);
+      stream << ":";
+      writeJsonString(stream, tags[i + 1]);
+    }
+    stream << "},\"vertices\":[";
+    for (int i = 0; i < vertexCount; ++i)
+      stream << (i == 0 ? "" : ",") << vertices[i];
+    stream << "]}";
+  }
+
+  static void writeJsonString(std::ostream &stream, const char *str) {
+    stream << '"';
+    for (; *str != '\0'; ++str) {
+      auto c = static_cast<unsigned char>(*str);
+      if (c == '"' || c == '\\')
+        stream << '\\' << *str;
+      else if (c < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        stream << escaped;
+      } else
+        stream << *str;
+    }
+    stream << '"';
+  }
+
+  /// Splits path into segments.
+  static std::vector<std::string> splitPath(const std::string &path) {
+    std::vector<std::string> segments;
+    std::stringstream ss(path);
+    std::string segment;
+    while (std::getline(ss, segment, '/')) {
+      if (!segment.empty())
+        segments.push_back(segment);
+    }
+    return segments;
+  }
+
+  static std::string decodeUrl(const std::string &value) {
+    std::string result;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+      if (value[i] == '+')
+        result += ' ';
+      else if (value[i] == '%' && i + 2 < value.size()) {
+        result += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+        i += 2;
+      } else
+        result += value[i];
+    }
+    return result;
+  }
+
+  static std::unordered_map<std::string, std::string> parseQuery(const std::string &query) {
+    std::unordered_map<std::string, std::string> parameters;
+    std::stringstream ss(query);
+    std::string pair;
+    while (std::getline(ss, pair, '&')) {
+      auto separator = pair.find('=');
+      if (separator != std::string::npos)
+        parameters[decodeUrl(pair.substr(0, separator))] = decodeUrl(pair.substr(separator + 1));
+    }
+    return parameters;
+  }
+
+  /// Parses comma separated numbers.
+  static std::vector<double> parseNumbers(const std::string &value) {
+    std::vector<double> numbers;
+    std::stringstream ss(value);
+    std::string number;
+    while (std::getline(ss, number, ','))
+      numbers.push_back(std::stod(number));
+    return numbers;
+  }
+
+  Search &search_;
+  const std::string styleFile_;
+  utymap::utils::LruCache<std::string, const Response> cache_;
+  std::unordered_map<std::string, std::shared_future<std::shared_ptr<const Response>>> pending_;
+  std::deque<TileRequest> queue_;
+  std::mutex lock_;
+  std::condition_variable condition_;
+  utymap::CancellationToken cancelToken_;
+  bool isStopped_;
+  /// NOTE declared last, so it is started when other members are ready.
+  std::thread dispatcher_;
+};
+
+#endif // TILESERVICE_HPP_DEFINED
@@ -54,10 +54,21 @@ struct BoundingBox final {
   }
 
   /// Expands bounging box from collection of geo data.
+  /// NOTE extremes are kept in locals, so the loop is a plain min/max reduction
+  /// which compiler keeps in registers and can vectorize.
   template<typename ForwardIterator>
   void expand(ForwardIterator begin, ForwardIterator end) {
-    for (; begin!=end; ++begin)
-      expand(*begin);
+    double minLat = minPoint.latitude, minLon = minPoint.longitude;
+    double maxLat = maxPoint.latitude, maxLon = maxPoint.longitude;
+    for (; begin!=end; ++begin) {
+      const GeoCoordinate &c = *begin;
+      minLat = c.latitude < minLat ? c.latitude : minLat;
+      minLon = c.longitude < minLon ? c.longitude : minLon;
+      maxLat = c.latitude > maxLat ? c.latitude : maxLat;
+      maxLon = c.longitude > maxLon ? c.longitude : maxLon;
+    }
+    minPoint = GeoCoordinate(minLat, minLon);
+    maxPoint = GeoCoordinate(maxLat, maxLon);
   }
 
   /// Checks whether given bounding box inside the current one.
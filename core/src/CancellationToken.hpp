@@ -1,13 +1,24 @@
 #ifndef CANCELLATIONTOKEN_HPP_DEFINED
 #define CANCELLATIONTOKEN_HPP_DEFINED
 
+#include <chrono>
+#include <cstdint>
+
 namespace utymap {
 
-/// Cancellation token.
+/// Cancellation token. Token with deadline is cancelled once deadline is passed.
+/// NOTE layout is shared with host code, so fields should not be reordered.
 struct CancellationToken final {
+  CancellationToken() = default;
+
+  /// Creates token which is cancelled when given parent token is cancelled too, so request
+  /// can have own deadline without changing token of caller.
+  explicit CancellationToken(const CancellationToken *parent) : parent(parent) {}
+
   /// Checks whether token is in cancelled state.
   bool isCancelled() const {
-    return cancelled != 0;
+    return cancelled != 0 || (deadline != 0 && now() >= deadline) ||
+           (parent != nullptr && parent->isCancelled());
   }
 
   /// Sets token into cancelled state.
@@ -15,9 +26,30 @@ struct CancellationToken final {
     cancelled = 1;
   }
 
+  /// Sets deadline after given time from now. Earlier deadline is kept.
+  void setDeadline(std::chrono::steady_clock::duration budget) {
+    std::int64_t value = now() + std::chrono::duration_cast<std::chrono::nanoseconds>(budget).count();
+    if (deadline == 0 || value < deadline)
+      deadline = value;
+  }
+
+  /// Checks whether token has deadline.
+  bool hasDeadline() const {
+    return deadline != 0;
+  }
+
 private:
+  static std::int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
   /// Non-zero value means cancellation.
   volatile int cancelled = 0;
+  /// Time of steady clock in nanoseconds, zero means no deadline.
+  volatile std::int64_t deadline = 0;
+  /// Token which cancels this one, it is set by native code only.
+  const CancellationToken *parent = nullptr;
 };
 
 }
@@ -1,6 +1,10 @@
 #ifndef QUADKEY_HPP_DEFINED
 #define QUADKEY_HPP_DEFINED
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
 namespace utymap {
 
 /// Represents quadkey: a node of quadtree
@@ -17,6 +21,16 @@ struct QuadKey final {
     }
   };
 
+  /// Hashes quadkey by its packed code.
+  struct Hash {
+    std::size_t operator()(const QuadKey &quadKey) const {
+      return std::hash<std::uint64_t>()(quadKey.code());
+    }
+  };
+
+  /// Max level of detail which fits packed code.
+  static const int MaxLevelOfDetail = 29;
+
   /// Level of details (zoom).
   int levelOfDetail;
   /// Tile x
@@ -35,7 +49,76 @@ struct QuadKey final {
     return levelOfDetail==other.levelOfDetail &&
         tileX==other.tileX && tileY==other.tileY;
   }
+
+  bool operator!=(const QuadKey &other) const {
+    return !(*this==other);
+  }
+
+  /// Returns packed 64 bit code: level of detail is kept in upper 6 bits, tile x and y
+  /// are interleaved below (morton order), so two lowest bits are the last quadkey digit.
+  std::uint64_t code() const {
+    return (static_cast<std::uint64_t>(levelOfDetail) << 58) |
+        spread(static_cast<std::uint32_t>(tileX)) |
+        (spread(static_cast<std::uint32_t>(tileY)) << 1);
+  }
+
+  /// Restores quadkey from packed code.
+  static QuadKey fromCode(std::uint64_t code) {
+    return QuadKey(static_cast<int>(code >> 58),
+                   static_cast<int>(compact(code)),
+                   static_cast<int>(compact(code >> 1)));
+  }
+
+  /// Returns quadkey of previous level which contains this one.
+  QuadKey parent() const {
+    return QuadKey(levelOfDetail - 1, tileX >> 1, tileY >> 1);
+  }
+
+  /// Returns quadkey of next level by its digit: 0 - top left, 1 - top right,
+  /// 2 - bottom left, 3 - bottom right.
+  QuadKey child(int digit) const {
+    return QuadKey(levelOfDetail + 1, (tileX << 1) | (digit & 1), (tileY << 1) | (digit >> 1));
+  }
+
+  /// Returns quadkey on the same level shifted by given amount of tiles.
+  /// NOTE tile numbers are not wrapped around the world.
+  QuadKey neighbour(int dx, int dy) const {
+    return QuadKey(levelOfDetail, tileX + dx, tileY + dy);
+  }
+
+ private:
+  /// Inserts zero bit between each of lower 29 bits of value.
+  static std::uint64_t spread(std::uint32_t value) {
+    std::uint64_t x = value & 0x1FFFFFFF;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x << 2)) & 0x3333333333333333ull;
+    x = (x | (x << 1)) & 0x5555555555555555ull;
+    return x;
+  }
+
+  /// Reverses spread: takes each even bit of value.
+  static std::uint32_t compact(std::uint64_t value) {
+    std::uint64_t x = value & 0x0155555555555555ull;
+    x = (x | (x >> 1)) & 0x3333333333333333ull;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+    return static_cast<std::uint32_t>(x);
+  }
 };
 
 }
+
+namespace std {
+template<>
+struct hash<utymap::QuadKey> {
+  std::size_t operator()(const utymap::QuadKey &quadKey) const {
+    return utymap::QuadKey::Hash()(quadKey);
+  }
+};
+}
+
 #endif // QUADKEY_HPP_DEFINED
@@ -7,11 +7,16 @@
 #include "builders/MeshBuilder.hpp"
 #include "builders/MeshPool.hpp"
 #include "heightmap/ElevationProvider.hpp"
+#include "heightmap/TileElevationCache.hpp"
 #include "mapcss/StyleProvider.hpp"
 #include <math/Mesh.hpp>
 #include "utils/GeoUtils.hpp"
+#include "utils/ThreadPool.hpp"
 
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <set>
 
 namespace utymap {
 namespace builders {
@@ -31,7 +36,9 @@ struct BuilderContext final {
   utymap::index::StringTable &stringTable;
   // Mesh pool.
   utymap::builders::MeshPool &meshPool;
-  /// Current elevation provider.
+  /// Elevation samples of current tile. Null if elevation is not cached.
+  const std::shared_ptr<const utymap::heightmap::TileElevationCache> eleCache;
+  /// Current elevation provider: it is elevation cache if it exists.
   const utymap::heightmap::ElevationProvider &eleProvider;
   /// Mesh callback should be called once mesh is constructed.
   std::function<void(const utymap::math::Mesh &)> meshCallback;
@@ -41,6 +48,16 @@ struct BuilderContext final {
   const utymap::CancellationToken &cancelToken;
   /// Mesh builder.
   const utymap::builders::MeshBuilder meshBuilder;
+  /// Thread pool for independent work inside of tile. Null if tile is built on calling thread only.
+  /// NOTE mesh callback should be called only from calling thread.
+  utymap::utils::ThreadPool *threadPool;
+  /// Fingerprints of style rules applied to elements of the quadkey.
+  /// NOTE it is shared with wrapped contexts, so cache knows which rules its data depends on.
+  std::shared_ptr<std::set<std::uint64_t>> styleRules;
+  /// Whether builders should emit repeated meshes once with their instances instead of copies.
+  bool useInstancing;
+  /// Max amount of vertices in mesh which merges meshes of several elements. Zero disables merging.
+  std::size_t batchVertexLimit;
 
   BuilderContext(const utymap::QuadKey &quadKey,
                  const utymap::mapcss::StyleProvider &styleProvider,
@@ -49,17 +66,26 @@ struct BuilderContext final {
                  const utymap::heightmap::ElevationProvider &eleProvider,
                  const MeshCallback &meshCallback,
                  const ElementCallback &elementCallback,
-                 const utymap::CancellationToken &cancelToken) :
+                 const utymap::CancellationToken &cancelToken,
+                 utymap::utils::ThreadPool *threadPool = nullptr,
+                 int eleCacheResolution = 0) :
       quadKey(quadKey),
       boundingBox(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey)),
       styleProvider(styleProvider),
       meshPool(meshPool),
       stringTable(stringTable),
-      eleProvider(eleProvider),
+      eleCache(eleCacheResolution > 0
+               ? std::make_shared<utymap::heightmap::TileElevationCache>(eleProvider, quadKey, eleCacheResolution)
+               : nullptr),
+      eleProvider(eleCache ? *eleCache : eleProvider),
       meshCallback(meshCallback),
       elementCallback(elementCallback),
       cancelToken(cancelToken),
-      meshBuilder(quadKey, eleProvider) {
+      meshBuilder(quadKey, this->eleProvider),
+      threadPool(threadPool),
+      styleRules(std::make_shared<std::set<std::uint64_t>>()),
+      useInstancing(false),
+      batchVertexLimit(0) {
   }
 };
 
@@ -10,6 +10,9 @@
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 
+#include <functional>
+#include <memory>
+
 namespace utymap {
 namespace builders {
 
@@ -17,9 +20,18 @@ namespace builders {
 template<typename T>
 class CacheBuilder final : public ElementBuilder {
  public:
+  /// Creates actual builder for given context if output is not cached.
+  typedef std::function<std::unique_ptr<ElementBuilder>(const BuilderContext &)> Factory;
+
   CacheBuilder(MeshCache &meshCache, const BuilderContext &context) :
+      CacheBuilder(meshCache, context, [](const BuilderContext &cacheContext) {
+        return utymap::utils::make_unique<T>(cacheContext);
+      }) {}
+
+  CacheBuilder(MeshCache &meshCache, const BuilderContext &context, const Factory &factory) :
       ElementBuilder(context),
-      meshCache_(meshCache) {}
+      meshCache_(meshCache),
+      factory_(factory) {}
 
   void prepare() override {
     if (meshCache_.fetch(context_))
@@ -27,7 +39,7 @@ class CacheBuilder final : public ElementBuilder {
     else
     {
       cacheContext_ = utymap::utils::make_unique<BuilderContext>(meshCache_.wrap(context_));
-      builder_ = utymap::utils::make_unique<T>(*cacheContext_);
+      builder_ = factory_(*cacheContext_);
     }
   }
 
@@ -57,6 +69,7 @@ class CacheBuilder final : public ElementBuilder {
 
  private:
   MeshCache &meshCache_;
+  Factory factory_;
   std::unique_ptr<BuilderContext> cacheContext_;
   std::unique_ptr<ElementBuilder> builder_;
 };
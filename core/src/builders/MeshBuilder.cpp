@@ -3,12 +3,17 @@
 
 #include "BoundingBox.hpp"
 #include "MeshBuilder.hpp"
+#include "math/EarClipper.hpp"
+#include "math/PointKernels.hpp"
 #include "triangle/triangle.h"
 #include "utils/CoreUtils.hpp"
 #include "utils/GeoUtils.hpp"
-#include "utils/GradientUtils.hpp"
+#include "utils/Metrics.hpp"
+#include "utils/Tracer.hpp"
+#include "utils/NoiseUtils.hpp"
 
-#include <mutex>
+#include <algorithm>
+#include <stdexcept>
 
 using namespace utymap;
 using namespace utymap::builders;
@@ -17,37 +22,236 @@ using namespace utymap::math;
 using namespace utymap::utils;
 
 namespace {
-// NOTE triangle library is not thread safe.
-std::mutex lock_;
-
-/// Creates texture mapping function.
-std::function<Vector2(double, double)> createMapFunc(const MeshBuilder::AppearanceOptions &appearanceOptions,
-                                                     const BoundingBox &bbox) {
-  if (appearanceOptions.textureRegion.isEmpty()) {
-    return [](double x, double y) {
-      return Vector2(0, 0);
-    };
-  }
+/// Max amount of polygon points for which ear clipping is used instead of triangle library.
+const std::size_t MaxEarClippingPoints = 512;
 
-  double geoWidth = bbox.width();
-  double geoHeight = bbox.height();
-  double geoX = bbox.minPoint.longitude;
-  double geoY = bbox.minPoint.latitude;
+/// Maps point to texture coordinates relative to bounding box: uv = (point - origin)*scale.
+struct TextureMapping final {
+  Vector2 origin;
+  Vector2 scale;
 
-  auto scale = appearanceOptions.textureScale;
+  /// Creates mapping which gives zero texture coordinates if texture region is empty.
+  TextureMapping(const MeshBuilder::AppearanceOptions &appearanceOptions, const BoundingBox &bbox) {
+    if (appearanceOptions.textureRegion.isEmpty()) return;
 
-  return [=](double x, double y) {
-    double relX = (x - geoX)/geoWidth;
-    double relY = (y - geoY)/geoHeight;
-    return Vector2(relX*scale, relY*scale);
-  };
+    auto scale = appearanceOptions.textureScale;
+    this->origin = Vector2(bbox.minPoint.longitude, bbox.minPoint.latitude);
+    this->scale = Vector2(scale/bbox.width(), scale/bbox.height());
+  }
+};
+
+/// Reserves space for extra items keeping geometric growth of vector.
+template<typename T>
+void ensureCapacity(std::vector<T> &items, std::size_t extra) {
+  std::size_t required = items.size() + extra;
+  if (required > items.capacity())
+    items.reserve(std::max(required, items.capacity()*2));
 }
 
 void ensureMeshCapacity(Mesh &mesh, std::size_t pointCount, std::size_t triCount) {
-  mesh.vertices.reserve(mesh.vertices.size() + pointCount*3/2);
-  mesh.triangles.reserve(mesh.triangles.size() + triCount*3);
-  mesh.colors.reserve(mesh.colors.size() + pointCount);
-  mesh.uvs.reserve(mesh.uvs.size() + pointCount*2);
+  ensureCapacity(mesh.vertices, pointCount*3);
+  ensureCapacity(mesh.triangles, triCount*3);
+  ensureCapacity(mesh.colors, pointCount);
+  ensureCapacity(mesh.uvs, pointCount*2);
+}
+
+/// Appends vertices of one color with one resize per buffer, so small primitives are
+/// written in a single loop. Triangle index of vertex is its offset from the first
+/// appended vertex.
+template<std::size_t Count>
+void appendVertices(Mesh &mesh, const Vector3 (&points)[Count], const Vector2 (&uvs)[Count],
+                    const int (&offsets)[Count], int color) {
+  ensureMeshCapacity(mesh, Count, Count/3);
+  auto vertexStart = mesh.vertices.size();
+  auto start = static_cast<int>(vertexStart/3);
+  auto uvStart = mesh.uvs.size();
+  auto triStart = mesh.triangles.size();
+  mesh.vertices.resize(vertexStart + Count*3);
+  mesh.uvs.resize(uvStart + Count*2);
+  mesh.triangles.resize(triStart + Count);
+  mesh.colors.resize(mesh.colors.size() + Count, color);
+
+  double *vertices = mesh.vertices.data() + vertexStart;
+  double *uvData = mesh.uvs.data() + uvStart;
+  int *triangles = mesh.triangles.data() + triStart;
+  for (std::size_t i = 0; i < Count; ++i) {
+    vertices[i*3] = points[i].x;
+    vertices[i*3 + 1] = points[i].z;
+    vertices[i*3 + 2] = points[i].y;
+    uvData[i*2] = uvs[i].x;
+    uvData[i*2 + 1] = uvs[i].y;
+    triangles[i] = start + offsets[i];
+  }
+}
+
+/// Keeps buffers used by triangulation between calls on the same thread.
+/// NOTE output lists of triangle library are still allocated by the library itself
+/// as their size is not known in advance.
+struct TriangulationWorkspace final {
+  EarClipper clipper;
+  std::vector<int> indices;
+  std::vector<REAL> areas;
+  std::string options;
+
+  /// Tries to triangulate polygon without refinement using ear clipping.
+  bool tryEarClipping(const Polygon &polygon) {
+    return polygon.points.size()/2 <= MaxEarClippingPoints && clipper.triangulate(polygon, indices);
+  }
+
+  /// Returns triangle area constraints for given amount of triangles.
+  REAL *getAreas(int count, double area) {
+    areas.assign(static_cast<std::size_t>(count), area);
+    return areas.data();
+  }
+
+  /// Returns triangle library options for refinement.
+  char *getRefineOptions(int segmentSplit) {
+    options.assign("prazPQ");
+    options.append(static_cast<std::size_t>(std::max(segmentSplit, 0)), 'Y');
+    return &options[0];
+  }
+
+  static TriangulationWorkspace &get() {
+    thread_local TriangulationWorkspace workspace;
+    return workspace;
+  }
+};
+
+/// Keeps coordinates of terrain surface vertices as separate arrays to calculate
+/// their noise and texture coordinates in batch.
+struct SurfacePoints {
+  std::vector<double> xs;
+  std::vector<double> ys;
+  std::vector<bool> hasNoise;
+  std::vector<double> eleNoise;
+  std::vector<double> colorNoise;
+  std::vector<GeoCoordinate> coordinates;
+  std::vector<double> elevations;
+
+  void clear() {
+    xs.clear();
+    ys.clear();
+    hasNoise.clear();
+  }
+
+  void add(double x, double y, bool noise) {
+    xs.push_back(x);
+    ys.push_back(y);
+    hasNoise.push_back(noise);
+  }
+
+  static SurfacePoints &get() {
+    thread_local SurfacePoints points;
+    return points;
+  }
+};
+
+/// Checks whether elevation of geometry is constant: provider is flat and there is no
+/// elevation noise, so neither of them has to be sampled.
+bool isFlat(const ElevationProvider &eleProvider, const MeshBuilder::GeometryOptions &geometryOptions) {
+  return eleProvider.isFlat() && geometryOptions.eleNoiseFreq == 0;
+}
+
+/// Adds vertices on terrain surface with their colors and texture coordinates.
+/// NOTE flat version has elevation sampling and noise compiled out.
+template<bool IsFlat>
+void addSurfaceVertices(Mesh &mesh, SurfacePoints &points,
+                        const TextureMapping &mapping,
+                        const QuadKey &quadKey,
+                        const ElevationProvider &eleProvider,
+                        const MeshBuilder::GeometryOptions &geometryOptions,
+                        const MeshBuilder::AppearanceOptions &appearanceOptions) {
+  std::size_t count = points.xs.size();
+  points.colorNoise.resize(count);
+  NoiseUtils::perlin2D(points.xs.data(), points.ys.data(), points.colorNoise.data(), count,
+                       appearanceOptions.colorNoiseFreq);
+
+  // set colors
+  for (auto &noise : points.colorNoise)
+    noise = (noise + 1)/2;
+  std::size_t colorStart = mesh.colors.size();
+  mesh.colors.resize(colorStart + count);
+  appearanceOptions.gradient.evaluate(points.colorNoise.data(), mesh.colors.data() + colorStart, count);
+
+  bool hasElevation = geometryOptions.elevation > std::numeric_limits<double>::lowest();
+  std::size_t vertexStart = mesh.vertices.size();
+  mesh.vertices.resize(vertexStart + count*3);
+  double *vertices = mesh.vertices.data() + vertexStart;
+
+  if (IsFlat) {
+    double ele = geometryOptions.heightOffset + (hasElevation ? geometryOptions.elevation : 0);
+    for (std::size_t i = 0; i < count; ++i) {
+      vertices[i*3] = points.xs[i];
+      vertices[i*3 + 1] = points.ys[i];
+      vertices[i*3 + 2] = ele;
+    }
+  } else {
+    points.eleNoise.resize(count);
+    NoiseUtils::perlin2D(points.xs.data(), points.ys.data(), points.eleNoise.data(), count,
+                         geometryOptions.eleNoiseFreq);
+
+    if (hasElevation)
+      points.elevations.assign(count, geometryOptions.elevation);
+    else {
+      points.coordinates.clear();
+      for (std::size_t i = 0; i < count; ++i)
+        points.coordinates.emplace_back(points.ys[i], points.xs[i]);
+      points.elevations.resize(count);
+      eleProvider.getElevations(quadKey, points.coordinates.data(), points.elevations.data(), count);
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double ele = geometryOptions.heightOffset + points.elevations[i];
+
+      if (points.hasNoise[i])
+        ele += points.eleNoise[i];
+
+      vertices[i*3] = points.xs[i];
+      vertices[i*3 + 1] = points.ys[i];
+      vertices[i*3 + 2] = ele;
+    }
+  }
+
+  // set textures
+  std::size_t uvStart = mesh.uvs.size();
+  mesh.uvs.resize(uvStart + count*2);
+  PointKernels::mapUv(points.xs.data(), points.ys.data(), count, mapping.origin, mapping.scale, mesh.uvs.data() + uvStart);
+}
+
+/// Selects version of adding surface vertices once per polygon.
+void addSurfaceVertices(Mesh &mesh, SurfacePoints &points,
+                        const TextureMapping &mapping,
+                        const QuadKey &quadKey,
+                        const ElevationProvider &eleProvider,
+                        const MeshBuilder::GeometryOptions &geometryOptions,
+                        const MeshBuilder::AppearanceOptions &appearanceOptions) {
+  if (isFlat(eleProvider, geometryOptions))
+    addSurfaceVertices<true>(mesh, points, mapping, quadKey, eleProvider, geometryOptions, appearanceOptions);
+  else
+    addSurfaceVertices<false>(mesh, points, mapping, quadKey, eleProvider, geometryOptions, appearanceOptions);
+}
+
+/// Returns triangles of regular grid with given size: the same for all tiles.
+const std::vector<int> &getGridIndices(int columns, int rows) {
+  thread_local std::vector<int> indices;
+  thread_local int cachedColumns = 0, cachedRows = 0;
+  if (columns==cachedColumns && rows==cachedRows)
+    return indices;
+
+  indices.clear();
+  indices.reserve(static_cast<std::size_t>(columns*rows*6));
+  for (int row = 0; row < rows; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      int a = row*(columns + 1) + column;
+      int b = a + 1;
+      int d = a + columns + 1;
+      int c = d + 1;
+      indices.insert(indices.end(), {a, c, b, a, d, c});
+    }
+  }
+  cachedColumns = columns;
+  cachedRows = rows;
+  return indices;
 }
 
 /// Fills mesh with all data needed to render object correctly outside core library.
@@ -58,39 +262,20 @@ void fillMesh(triangulateio *io, QuadKey quadKey, const BoundingBox &bbox, Mesh
   int triStartIndex = static_cast<int>(mesh.vertices.size()/3);
 
   // prepare texture data
-  const auto map = createMapFunc(appearanceOptions, bbox);
-
-  ensureMeshCapacity(mesh, static_cast<std::size_t>(io->numberofpoints),
-                     static_cast<std::size_t>(io->numberoftriangles));
-
-  for (int i = 0; i < io->numberofpoints; i++) {
-    // get coordinates
-    double x = io->pointlist[i*2 + 0];
-    double y = io->pointlist[i*2 + 1];
-
-    double ele = geometryOptions.heightOffset +
-        (geometryOptions.elevation > std::numeric_limits<double>::lowest()
-         ? geometryOptions.elevation
-         : eleProvider.getElevation(quadKey, y, x));
-
-    // do no apply noise on boundaries
-    if (io->pointmarkerlist!=nullptr && io->pointmarkerlist[i]!=1)
-      ele += NoiseUtils::perlin2D(x, y, geometryOptions.eleNoiseFreq);
-
-    // set vertices
-    mesh.vertices.push_back(x);
-    mesh.vertices.push_back(y);
-    mesh.vertices.push_back(ele);
-
-    // set colors
-    int color = GradientUtils::getColor(appearanceOptions.gradient, x, y, appearanceOptions.colorNoiseFreq);
-    mesh.colors.push_back(color);
-
-    // set textures
-    const auto uv = map(x, y);
-    mesh.uvs.push_back(uv.x);
-    mesh.uvs.push_back(uv.y);
-  }
+  const TextureMapping mapping(appearanceOptions, bbox);
+
+  auto count = static_cast<std::size_t>(io->numberofpoints);
+  ensureMeshCapacity(mesh, count, static_cast<std::size_t>(io->numberoftriangles));
+
+  auto &points = SurfacePoints::get();
+  points.clear();
+  points.xs.resize(count);
+  points.ys.resize(count);
+  PointKernels::deinterleave(io->pointlist, count, points.xs.data(), points.ys.data());
+  // do no apply noise on boundaries
+  for (std::size_t i = 0; i < count; ++i)
+    points.hasNoise.push_back(io->pointmarkerlist!=nullptr && io->pointmarkerlist[i]!=1);
+  addSurfaceVertices(mesh, points, mapping, quadKey, eleProvider, geometryOptions, appearanceOptions);
 
   // set triangles
   int first = geometryOptions.flipSide ? 2 : 1;
@@ -117,6 +302,24 @@ void MeshBuilder::addPolygon(Mesh &mesh,
                              Polygon &polygon,
                              const GeometryOptions &geometryOptions,
                              const AppearanceOptions &appearanceOptions) const {
+  utymap::utils::Metrics::Timer timer(utymap::utils::Metrics::Latency::Triangulation);
+  TRACE_ZONE("triangulate", quadKey_);
+  auto &workspace = TriangulationWorkspace::get();
+
+  // do not refine mesh if area is not set: ear clipping is enough for that.
+  bool noRefinement = std::abs(geometryOptions.area) < std::numeric_limits<double>::epsilon();
+  if (noRefinement && workspace.tryEarClipping(polygon)) {
+    triangulateio io;
+    io.pointlist = polygon.points.data();
+    io.numberofpoints = static_cast<int>(polygon.points.size()/2);
+    io.trianglelist = workspace.indices.data();
+    io.numberofcorners = 3;
+    io.numberoftriangles = static_cast<int>(workspace.indices.size()/3);
+    io.pointmarkerlist = nullptr;
+    fillMesh(&io, quadKey_, bbox_, mesh, eleProvider_, geometryOptions, appearanceOptions);
+    return;
+  }
+
   triangulateio in, mid;
 
   in.numberofpoints = static_cast<int>(polygon.points.size()/2);
@@ -137,21 +340,13 @@ void MeshBuilder::addPolygon(Mesh &mesh,
   mid.segmentlist = nullptr;
   mid.segmentmarkerlist = nullptr;
 
-  {
-    std::lock_guard<std::mutex> lock(lock_);
-    ::triangulate(const_cast<char *>("pzBQ"), &in, &mid, nullptr);
-  }
+  // NOTE triangle library keeps its global state per thread, so no synchronization is required.
+  ::triangulate(const_cast<char *>("pzBQ"), &in, &mid, nullptr);
 
-  // do not refine mesh if area is not set.
-  if (std::abs(geometryOptions.area) < std::numeric_limits<double>::epsilon()) {
+  if (noRefinement) {
     fillMesh(&mid, quadKey_, bbox_, mesh, eleProvider_, geometryOptions, appearanceOptions);
-    mid.trianglearealist = nullptr;
   } else {
-
-    mid.trianglearealist = static_cast<REAL *>(malloc(mid.numberoftriangles*sizeof(REAL)));
-    for (int i = 0; i < mid.numberoftriangles; ++i) {
-      mid.trianglearealist[i] = geometryOptions.area;
-    }
+    mid.trianglearealist = workspace.getAreas(mid.numberoftriangles, geometryOptions.area);
 
     triangulateio out;
     out.pointlist = nullptr;
@@ -160,15 +355,7 @@ void MeshBuilder::addPolygon(Mesh &mesh,
     out.triangleattributelist = nullptr;
     out.pointmarkerlist = nullptr;
 
-    std::string triOptions = "prazPQ";
-    for (int i = 0; i < geometryOptions.segmentSplit; i++) {
-      triOptions += "Y";
-    }
-
-    {
-      std::lock_guard<std::mutex> lock(lock_);
-      ::triangulate(const_cast<char *>(triOptions.c_str()), &mid, &out, nullptr);
-    }
+    ::triangulate(workspace.getRefineOptions(geometryOptions.segmentSplit), &mid, &out, nullptr);
 
     fillMesh(&out, quadKey_, bbox_, mesh, eleProvider_, geometryOptions, appearanceOptions);
 
@@ -184,11 +371,86 @@ void MeshBuilder::addPolygon(Mesh &mesh,
   free(mid.pointlist);
   free(mid.pointmarkerlist);
   free(mid.trianglelist);
-  free(mid.trianglearealist);
   free(mid.segmentlist);
   free(mid.segmentmarkerlist);
 }
 
+void MeshBuilder::addPolygons(Mesh &mesh,
+                              std::vector<Polygon> &polygons,
+                              const GeometryOptions &geometryOptions,
+                              const AppearanceOptions &appearanceOptions) const {
+  std::size_t pointCount = 0;
+  for (const auto &polygon : polygons)
+    pointCount += polygon.points.size()/2;
+  // NOTE without refinement triangle count is close to point count.
+  ensureMeshCapacity(mesh, pointCount, pointCount);
+
+  for (auto &polygon : polygons)
+    addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+}
+
+void MeshBuilder::addGrid(Mesh &mesh,
+                          const std::vector<double> &xs,
+                          const std::vector<double> &ys,
+                          const std::vector<bool> &cells,
+                          const GeometryOptions &geometryOptions,
+                          const AppearanceOptions &appearanceOptions) const {
+  int columns = static_cast<int>(xs.size()) - 1;
+  int rows = static_cast<int>(ys.size()) - 1;
+  if (columns < 1 || rows < 1 || cells.size()!=static_cast<std::size_t>(columns*rows))
+    throw std::domain_error("Grid cells do not match grid size.");
+
+  auto isCell = [&](int column, int row) {
+    return column >= 0 && column < columns && row >= 0 && row < rows && cells[row*columns + column];
+  };
+
+  // vertex is used if any of its cells is set, noise is applied only if it is surrounded by cells.
+  int pointColumns = columns + 1;
+  std::vector<int> vertexIndices(static_cast<std::size_t>(pointColumns*(rows + 1)), -1);
+  bool isFull = std::find(cells.begin(), cells.end(), false)==cells.end();
+  int startIndex = static_cast<int>(mesh.vertices.size()/3);
+  int nextIndex = startIndex;
+
+  const TextureMapping mapping(appearanceOptions, bbox_);
+  ensureMeshCapacity(mesh, vertexIndices.size(), cells.size()*2);
+
+  auto &points = SurfacePoints::get();
+  points.clear();
+  for (int row = 0; row <= rows; ++row) {
+    for (int column = 0; column <= columns; ++column) {
+      int cellCount = isCell(column - 1, row - 1) + isCell(column, row - 1) +
+          isCell(column - 1, row) + isCell(column, row);
+      if (cellCount==0) continue;
+
+      vertexIndices[row*pointColumns + column] = nextIndex++;
+      points.add(xs[column], ys[row], cellCount==4);
+    }
+  }
+  addSurfaceVertices(mesh, points, mapping, quadKey_, eleProvider_, geometryOptions, appearanceOptions);
+
+  int first = geometryOptions.flipSide ? 2 : 1;
+  int third = geometryOptions.flipSide ? 1 : 2;
+  const auto &indices = getGridIndices(columns, rows);
+  if (isFull) {
+    // NOTE all vertices are used, so their indices are sequential.
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+      mesh.triangles.push_back(startIndex + indices[i]);
+      mesh.triangles.push_back(startIndex + indices[i + first]);
+      mesh.triangles.push_back(startIndex + indices[i + third]);
+    }
+    return;
+  }
+
+  for (std::size_t cell = 0; cell < cells.size(); ++cell) {
+    if (!cells[cell]) continue;
+    for (std::size_t i = cell*6; i < cell*6 + 6; i += 3) {
+      mesh.triangles.push_back(vertexIndices[indices[i]]);
+      mesh.triangles.push_back(vertexIndices[indices[i + first]]);
+      mesh.triangles.push_back(vertexIndices[indices[i + third]]);
+    }
+  }
+}
+
 void MeshBuilder::addPlane(Mesh &mesh,
                            const Vector2 &p1,
                            const Vector2 &p2,
@@ -196,11 +458,21 @@ void MeshBuilder::addPlane(Mesh &mesh,
                            const AppearanceOptions &appearanceOptions) const {
   bool hasElevation = geometryOptions.elevation > std::numeric_limits<double>::lowest();
 
+  if (isFlat(eleProvider_, geometryOptions)) {
+    double ele = hasElevation ? geometryOptions.elevation : 0;
+    addPlane(mesh, Vector3(p1.x, ele, p1.y), Vector3(p2.x, ele, p2.y), geometryOptions, appearanceOptions);
+    return;
+  }
+
   double ele1 = hasElevation ? geometryOptions.elevation : eleProvider_.getElevation(quadKey_, p1.y, p1.x);
   double ele2 = hasElevation ? geometryOptions.elevation : eleProvider_.getElevation(quadKey_, p2.y, p2.x);
 
-  ele1 += NoiseUtils::perlin2D(p1.x, p1.y, geometryOptions.eleNoiseFreq);
-  ele2 += NoiseUtils::perlin2D(p2.x, p2.y, geometryOptions.eleNoiseFreq);
+  const double xs[] = {p1.x, p2.x};
+  const double ys[] = {p1.y, p2.y};
+  double noise[2];
+  NoiseUtils::perlin2D(xs, ys, noise, 2, geometryOptions.eleNoiseFreq);
+  ele1 += noise[0];
+  ele2 += noise[1];
 
   addPlane(mesh, Vector3(p1.x, ele1, p1.y), Vector3(p2.x, ele2, p2.y), geometryOptions, appearanceOptions);
 }
@@ -209,8 +481,6 @@ void MeshBuilder::addPlane(Mesh &mesh, const Vector3 &p1, const Vector3 &p2,
                            const GeometryOptions &geometryOptions, const AppearanceOptions &appearanceOptions) const {
   auto color =
       appearanceOptions.gradient.evaluate((NoiseUtils::perlin2D(p1.x, p1.y, appearanceOptions.colorNoiseFreq) + 1)/2);
-  int index = static_cast<int>(mesh.vertices.size()/3);
-
   double size = bbox_.width()/appearanceOptions.textureScale;
   // NOTE cannot use original vertices as y is not normalized
   double scaleX = Vector2::distance(Vector2(p2.x, p2.z), Vector2(p1.x, p1.z))/size;
@@ -219,14 +489,11 @@ void MeshBuilder::addPlane(Mesh &mesh, const Vector3 &p1, const Vector3 &p2,
   const auto topP1 = Vector3(p1.x, p1.y + geometryOptions.heightOffset, p1.z);
   const auto topP2 = Vector3(p2.x, p2.y + geometryOptions.heightOffset, p2.z);
 
-  addVertex(mesh, p1, color, index, Vector2(0, 0));
-  addVertex(mesh, p2, color, index + 2, Vector2(scaleX, 0));
-  addVertex(mesh, topP2, color, index + 1, Vector2(scaleX, scaleY));
-  index += 3;
-
-  addVertex(mesh, topP1, color, index, Vector2(0, scaleY));
-  addVertex(mesh, p1, color, index + 2, Vector2(0, 0));
-  addVertex(mesh, topP2, color, index + 1, Vector2(scaleX, scaleY));
+  const Vector3 points[] = {p1, p2, topP2, topP1, p1, topP2};
+  const Vector2 uvs[] = {Vector2(0, 0), Vector2(scaleX, 0), Vector2(scaleX, scaleY),
+                         Vector2(0, scaleY), Vector2(0, 0), Vector2(scaleX, scaleY)};
+  const int offsets[] = {0, 2, 1, 3, 5, 4};
+  appendVertices(mesh, points, uvs, offsets, color);
 }
 
 void MeshBuilder::addTriangle(Mesh &mesh,
@@ -240,17 +507,17 @@ void MeshBuilder::addTriangle(Mesh &mesh,
                               const AppearanceOptions &appearanceOptions) const {
   auto color =
       appearanceOptions.gradient.evaluate((NoiseUtils::perlin2D(v0.x, v0.z, appearanceOptions.colorNoiseFreq) + 1)/2);
-  int startIndex = static_cast<int>(mesh.vertices.size()/3);
-
-  addVertex(mesh, v0, color, startIndex, uv0);
-  addVertex(mesh, v1, color, ++startIndex, uv1);
-  addVertex(mesh, v2, color, ++startIndex, uv2);
-
   if (geometryOptions.hasBackSide) {
     // TODO check indices
-    addVertex(mesh, v2, color, startIndex, uv0);
-    addVertex(mesh, v1, color, ++startIndex, uv1);
-    addVertex(mesh, v0, color, ++startIndex, uv2);
+    const Vector3 points[] = {v0, v1, v2, v2, v1, v0};
+    const Vector2 uvs[] = {uv0, uv1, uv2, uv0, uv1, uv2};
+    const int offsets[] = {0, 1, 2, 2, 3, 4};
+    appendVertices(mesh, points, uvs, offsets, color);
+  } else {
+    const Vector3 points[] = {v0, v1, v2};
+    const Vector2 uvs[] = {uv0, uv1, uv2};
+    const int offsets[] = {0, 1, 2};
+    appendVertices(mesh, points, uvs, offsets, color);
   }
 }
 
@@ -279,19 +546,3 @@ void MeshBuilder::writeTextureMappingInfo(Mesh &mesh, const AppearanceOptions &a
   mesh.uvMap.push_back(appearanceOptions.textureRegion.width);
   mesh.uvMap.push_back(appearanceOptions.textureRegion.height);
 }
-
-void MeshBuilder::addVertex(Mesh &mesh, const Vector2 &p, double ele, int color, int triIndex, const Vector2 &uv) {
-  mesh.vertices.push_back(p.x);
-  mesh.vertices.push_back(p.y);
-  mesh.vertices.push_back(ele);
-  mesh.colors.push_back(color);
-
-  mesh.uvs.push_back(uv.x);
-  mesh.uvs.push_back(uv.y);
-
-  mesh.triangles.push_back(triIndex);
-}
-
-void MeshBuilder::addVertex(Mesh &mesh, const Vector3 &vertex, int color, int triIndex, const Vector2 &uv) {
-  addVertex(mesh, Vector2(vertex.x, vertex.z), vertex.y, color, triIndex, uv);
-}
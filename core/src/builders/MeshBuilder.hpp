@@ -12,6 +12,7 @@
 #include "math/Mesh.hpp"
 
 #include <functional>
+#include <vector>
 
 namespace utymap {
 namespace builders {
@@ -97,6 +98,21 @@ class MeshBuilder final {
                   const GeometryOptions &geometryOptions,
                   const AppearanceOptions &appearanceOptions) const;
 
+  /// Adds polygons to existing mesh using the same options for all of them.
+  void addPolygons(utymap::math::Mesh &mesh,
+                   std::vector<utymap::math::Polygon> &polygons,
+                   const GeometryOptions &geometryOptions,
+                   const AppearanceOptions &appearanceOptions) const;
+
+  /// Adds regular grid with given lines to existing mesh. Only cells set in mask (row by row)
+  /// are added, vertices are shared between neighbour cells.
+  void addGrid(utymap::math::Mesh &mesh,
+               const std::vector<double> &xs,
+               const std::vector<double> &ys,
+               const std::vector<bool> &cells,
+               const GeometryOptions &geometryOptions,
+               const AppearanceOptions &appearanceOptions) const;
+
   /// Adds simple plane to existing mesh using options provided.
   void addPlane(utymap::math::Mesh &mesh,
                 const utymap::math::Vector2 &p1,
@@ -131,17 +147,6 @@ class MeshBuilder final {
                                const AppearanceOptions &appearanceOptions) const;
 
  private:
-
-  static void addVertex(utymap::math::Mesh &mesh,
-                        const utymap::math::Vector2 &p,
-                        double ele, int color, int triIndex,
-                        const utymap::math::Vector2 &uv);
-
-  static void addVertex(utymap::math::Mesh &mesh,
-                        const utymap::math::Vector3 &vertex,
-                        int color, int triIndex,
-                        const utymap::math::Vector2 &uv);
-
   const utymap::QuadKey quadKey_;
   const utymap::BoundingBox bbox_;
   const utymap::heightmap::ElevationProvider &eleProvider_;
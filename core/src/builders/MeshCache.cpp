@@ -1,9 +1,27 @@
 #include "builders/MeshCache.hpp"
 #include "index/ElementStream.hpp"
 #include "index/MeshStream.hpp"
+#include "utils/LruCache.hpp"
+#include "utils/Metrics.hpp"
+#include "utils/ThreadPool.hpp"
 
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <limits>
 #include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
 
 using namespace utymap;
 using namespace utymap::builders;
@@ -15,6 +33,84 @@ using namespace utymap::utils;
 namespace {
 const char ElementType = 0;
 const char MeshType = 1;
+/// Marks completely cached data. It is changed with format of cached data,
+/// so data cached by older versions is rebuilt.
+const char CompleteStatus = 4;
+/// Data follows its header as is.
+const char RawCodec = 0;
+/// Data follows its header as zlib block.
+const char ZlibCodec = 1;
+/// Extension of file which keeps style rules used to build cached data.
+const std::string DependencyExtension = ".deps";
+/// Extension of file which is written in background before it replaces cached data.
+const std::string TemporaryExtension = ".tmp";
+/// Name of file which keeps sizes of cached files in order of their usage.
+const std::string ManifestName = "manifest";
+/// Amount of manifest changes after which it is saved in background.
+const std::uint64_t ManifestSaveInterval = 64;
+
+/// Precedes cached data in file after status.
+#pragma pack(push, 1)
+struct DataHeader {
+  char codec;
+  std::uint32_t rawSize;
+};
+#pragma pack(pop)
+
+/// Encodes data with header, so it is compressed if compression is supported.
+std::string encode(const std::string &data) {
+  DataHeader header = { RawCodec, static_cast<std::uint32_t>(data.size()) };
+  std::string result(sizeof(header), '\0');
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+  uLongf size = compressBound(static_cast<uLong>(data.size()));
+  result.resize(sizeof(header) + size);
+  if (compress(reinterpret_cast<Bytef *>(&result[sizeof(header)]), &size,
+               reinterpret_cast<const Bytef *>(data.data()), static_cast<uLong>(data.size())) == Z_OK) {
+    header.codec = ZlibCodec;
+    result.resize(sizeof(header) + size);
+  } else
+    result.resize(sizeof(header));
+#endif
+  if (header.codec == RawCodec)
+    result.append(data);
+  std::memcpy(&result[0], &header, sizeof(header));
+  return result;
+}
+
+/// Decodes data with header. Returns null if data is corrupted or its codec is not supported.
+std::shared_ptr<const std::string> decode(const char *data, std::size_t size) {
+  DataHeader header;
+  if (size < sizeof(header)) return nullptr;
+  std::memcpy(&header, data, sizeof(header));
+  data += sizeof(header);
+  size -= sizeof(header);
+
+  if (header.codec == RawCodec)
+    return size == header.rawSize ? std::make_shared<const std::string>(data, size) : nullptr;
+
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+  if (header.codec == ZlibCodec) {
+    auto result = std::make_shared<std::string>(header.rawSize, '\0');
+    uLongf resultSize = static_cast<uLongf>(header.rawSize);
+    if (header.rawSize > 0 &&
+        (uncompress(reinterpret_cast<Bytef *>(&(*result)[0]), &resultSize,
+                    reinterpret_cast<const Bytef *>(data), static_cast<uLong>(size)) != Z_OK ||
+         resultSize != header.rawSize))
+      return nullptr;
+    return result;
+  }
+#endif
+  return nullptr;
+}
+
+/// Reads data kept in memory without copying it.
+class MemoryBuffer final : public std::streambuf {
+ public:
+  explicit MemoryBuffer(const std::string &data) {
+    auto begin = const_cast<char *>(data.data());
+    setg(begin, begin, begin + data.size());
+  }
+};
 }
 
 class MeshCache::MeshCacheImpl {
@@ -24,61 +120,326 @@ class MeshCache::MeshCacheImpl {
  public:
   explicit MeshCacheImpl(const std::string &dataPath, const std::string &extension) :
       dataPath_(dataPath),
-      extension_('.' + extension) {}
+      extension_('.' + extension),
+      memory_(std::numeric_limits<std::size_t>::max()),
+      memoryBytes_(0),
+      maxMemoryBytes_(0),
+      invalidations_(0),
+      disk_(std::numeric_limits<std::size_t>::max()),
+      diskBytes_(0),
+      maxDiskBytes_(0),
+      manifestChanges_(0),
+      writer_(1) {
+    loadManifest();
+  }
+
+  ~MeshCacheImpl() {
+    flush();
+  }
+
+  void setDiskLimit(std::uint64_t maxBytes) {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      maxDiskBytes_ = maxBytes;
+    }
+    writer_.enqueue([this]() {
+      std::lock_guard<std::mutex> lock(lock_);
+      trimDisk();
+    });
+  }
+
+  /// Removes data cached with styles which tags are not in given list.
+  void purge(const std::vector<std::string> &tags) {
+    namespace fs = boost::filesystem;
+    auto isStale = [&](const std::string &path) {
+      return std::find(tags.begin(), tags.end(), getTag(path))==tags.end();
+    };
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      std::vector<std::string> paths;
+      disk_.visit([&](const std::string &path, const std::uint64_t &) {
+        if (isStale(path)) paths.push_back(path);
+      });
+      for (const auto &path : paths)
+        removeEntry(path);
+
+      for (auto it = pendingWrites_.begin(); it!=pendingWrites_.end();)
+        it = isStale(it->first) ? pendingWrites_.erase(it) : std::next(it);
+      removeMemory(isStale);
+      ++invalidations_;
+    }
+
+    // NOTE other caches keep their files in the same directories.
+    boost::system::error_code ec;
+    fs::path cacheDir = fs::path(dataPath_) / "cache";
+    std::vector<fs::path> staleDirs;
+    for (fs::directory_iterator it(cacheDir, ec), end; !ec && it!=end; it.increment(ec)) {
+      if (fs::is_directory(it->path(), ec) &&
+          std::find(tags.begin(), tags.end(), it->path().filename().string())==tags.end())
+        staleDirs.push_back(it->path());
+    }
+    for (const auto &dir : staleDirs)
+      fs::remove_all(dir, ec);
+  }
+
+  void setMemoryLimit(std::size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(lock_);
+    maxMemoryBytes_ = maxBytes;
+    evictMemory(maxMemoryBytes_);
+  }
+
+  std::size_t getMemoryUsage() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return memoryBytes_;
+  }
+
+  void trimMemory(std::size_t maxBytes) {
+    std::lock_guard<std::mutex> lock(lock_);
+    evictMemory(maxBytes);
+  }
 
   BuilderContext wrap(const BuilderContext &context) {
     auto filePath = getFilePath(context);
 
     std::lock_guard<std::mutex> lock(lock_);
-    return isCacheHit(context.quadKey, filePath) ? context : wrap(context, filePath);
+    return isCacheHit(context.quadKey, filePath) ? context : createCachingContext(context);
   }
 
   bool fetch(const BuilderContext &context) {
     auto filePath = getFilePath(context);
+    auto diskPath = filePath;
+    std::uint64_t invalidations = 0;
+    std::shared_ptr<const std::string> data;
+
+    // NOTE data cached with other styles is restored from disk.
+    if (hasPendingSiblings(context.quadKey, filePath))
+      flush();
 
     {
       std::lock_guard<std::mutex> lock(lock_);
-      if (!isCacheHit(context.quadKey, filePath))
+      invalidations = invalidations_;
+      if (disk_.exists(filePath)) {
+        disk_.promote(filePath);
+        ++manifestChanges_;
+      }
+      auto pending = pendingWrites_.find(filePath);
+      if (pending != pendingWrites_.end())
+        data = pending->second->data;
+      else if (memory_.exists(filePath))
+        data = memory_.get(filePath);
+      else if (!isCacheHit(context.quadKey, filePath)) {
+        diskPath = restore(context.quadKey, context.styleProvider, filePath);
+        if (diskPath.empty())
+          return false;
+      }
+    }
+
+    if (data == nullptr) {
+      data = readCache(diskPath);
+      if (data == nullptr)
         return false;
+
+      // NOTE data invalidated while it was read is not kept.
+      std::lock_guard<std::mutex> lock(lock_);
+      if (invalidations == invalidations_)
+        putMemory(filePath, data);
     }
 
-    readCache(filePath, context);
+    // NOTE data is parsed outside of lock as callbacks may be slow.
+    MemoryBuffer buffer(*data);
+    std::istream stream(&buffer);
+    readData(stream, context);
 
     return true;
   }
 
-  void unwrap(const BuilderContext &context) {
+  void invalidate(const QuadKey &quadKey, const utymap::mapcss::StyleProvider &styleProvider) {
     std::lock_guard<std::mutex> lock(lock_);
+    ++invalidations_;
+    // NOTE quad key which is being cached now is removed once caching is finished.
+    // Data cached with other styles is removed too as it can be restored for this style.
+    auto filePath = getFilePath(quadKey, styleProvider);
+    for (const auto &path : getSiblingPaths(quadKey, styleProvider))
+      removeEntry(path);
+    removeEntry(filePath);
+
+    // NOTE pending writes of the quad key are dropped, siblings have the same relative path.
+    auto relativePath = getRelativePath(quadKey);
+    for (auto it = pendingWrites_.begin(); it != pendingWrites_.end();)
+      it = isSibling(it->first, relativePath) ? pendingWrites_.erase(it) : std::next(it);
+
+    removeMemory([&](const std::string &path) { return isSibling(path, relativePath); });
+  }
 
-    auto entry = cachingQuads_.find(context.quadKey);
-
-    if (entry==cachingQuads_.end()) return;
+  /// Waits until queued data is written and saves manifest if it is changed.
+  void flush() {
+    writer_.enqueue([this]() { saveManifest(); }).wait();
+  }
 
-    if (entry->second->good()) {
-      if (context.cancelToken.isCancelled()) {
-        // NOTE no guarantee that all data was processed and saved.
-        // So it is better to delete the whole file
-        entry->second->close();
-        // TODO any smarter option?
-        if (!entry->second->fail())
-          std::remove(getFilePath(context).c_str());
-      } else {
-        entry->second->seekg(0, std::ios::beg);
-        *entry->second << static_cast<char>(1);
-        entry->second->close();
+  /// Queues data collected by wrapped context to be written in background.
+  void unwrap(const BuilderContext &context) {
+    auto filePath = getFilePath(context);
+    std::shared_ptr<PendingWrite> pendingWrite;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      auto entry = cachingQuads_.find(context.quadKey);
+      if (entry==cachingQuads_.end()) return;
+
+      // NOTE no guarantee that all data was processed, so it is not cached.
+      if (!context.cancelToken.isCancelled() && entry->second->good()) {
+        pendingWrite = std::make_shared<PendingWrite>();
+        pendingWrite->data = std::make_shared<const std::string>(entry->second->str());
+        pendingWrites_[filePath] = pendingWrite;
       }
+      cachingQuads_.erase(entry);
     }
 
-    cachingQuads_.erase(entry);
+    if (pendingWrite == nullptr) return;
+
+    std::ostringstream deps;
+    writeDependencies(deps, context);
+    pendingWrite->deps = deps.str();
+    writer_.enqueue([this, filePath, pendingWrite]() { write(filePath, pendingWrite); });
   }
 
  private:
 
+  /// Data of built quad key which is not written to disk yet.
+  struct PendingWrite {
+    std::shared_ptr<const std::string> data;
+    std::string deps;
+  };
+
+  /// Keeps recently used data in memory while it fits the limit.
+  void putMemory(const std::string &filePath, const std::shared_ptr<const std::string> &data) {
+    if (maxMemoryBytes_ == 0 || data->size() > maxMemoryBytes_)
+      return;
+
+    if (memory_.exists(filePath))
+      memoryBytes_ -= memory_.peek(filePath)->size();
+    memory_.put(filePath, data);
+    memoryBytes_ += data->size();
+    evictMemory(maxMemoryBytes_);
+  }
+
+  template<typename Predicate>
+  void removeMemory(const Predicate &predicate) {
+    std::vector<std::string> paths;
+    memory_.visit([&](const std::string &path, const std::string &) {
+      if (predicate(path))
+        paths.push_back(path);
+    });
+    for (const auto &path : paths) {
+      memoryBytes_ -= memory_.peek(path)->size();
+      memory_.remove(path);
+    }
+  }
+
+  /// Removes the least recently used data from memory until it fits given size.
+  /// NOTE should be called under lock.
+  void evictMemory(std::size_t maxBytes) {
+    while (memoryBytes_ > maxBytes && memory_.size() > 0) {
+      memoryBytes_ -= memory_.peek(memory_.lastKey())->size();
+      memory_.removeLast();
+    }
+  }
+
+  /// Registers file written to disk as the most recently used one.
+  void addEntry(const std::string &filePath, std::uint64_t size) {
+    if (disk_.exists(filePath))
+      diskBytes_ -= *disk_.peek(filePath);
+    disk_.put(filePath, std::make_shared<const std::uint64_t>(size));
+    diskBytes_ += size;
+    ++manifestChanges_;
+  }
+
+  /// Removes cached data from disk and manifest.
+  void removeEntry(const std::string &filePath) {
+    remove(filePath);
+    if (disk_.exists(filePath)) {
+      diskBytes_ -= *disk_.peek(filePath);
+      disk_.remove(filePath);
+      ++manifestChanges_;
+    }
+  }
+
+  /// Removes least recently used files until cache fits the disk limit.
+  void trimDisk() {
+    while (maxDiskBytes_ > 0 && diskBytes_ > maxDiskBytes_ && disk_.size() > 0) {
+      auto filePath = disk_.lastKey();
+      removeEntry(filePath);
+    }
+  }
+
+  /// Gets path of manifest file which is unique for every cache in the same directory.
+  std::string getManifestPath() const {
+    return dataPath_ + "/cache/" + ManifestName + extension_;
+  }
+
+  /// Gets tag of style which was used to build data cached in given file.
+  std::string getTag(const std::string &filePath) const {
+    auto start = dataPath_.size() + std::string("/cache/").size();
+    return filePath.substr(start, filePath.find('/', start) - start);
+  }
+
+  /// Reads sizes of cached files in order of their usage. If there is no manifest,
+  /// it is built once from cache directory, e.g. when data is cached by older version.
+  void loadManifest() {
+    namespace fs = boost::filesystem;
+    auto prefix = dataPath_ + "/cache/";
+    std::vector<std::pair<std::string, std::uint64_t>> entries;
+    std::ifstream manifest(getManifestPath());
+    if (manifest.good()) {
+      std::uint64_t size;
+      std::string path;
+      while (manifest >> size && std::getline(manifest >> std::ws, path))
+        entries.push_back(std::make_pair(prefix + path, size));
+    } else {
+      boost::system::error_code ec;
+      fs::path cacheDir(prefix);
+      for (fs::recursive_directory_iterator it(cacheDir, ec), end; !ec && it!=end; it.increment(ec)) {
+        if (it.depth()!=2 || it->path().extension().string()!=extension_ ||
+            !fs::is_regular_file(it->path(), ec))
+          continue;
+        auto path = it->path().generic_string();
+        auto size = fs::file_size(path, ec) + fs::file_size(path + DependencyExtension, ec);
+        if (!ec) entries.push_back(std::make_pair(path, size));
+      }
+    }
+
+    // NOTE manifest keeps the most recently used files first.
+    for (auto it = entries.rbegin(); it!=entries.rend(); ++it)
+      addEntry(it->first, it->second);
+    manifestChanges_ = 0;
+  }
+
+  /// Writes manifest to temporary file which replaces existing one.
+  void saveManifest() {
+    std::ostringstream content;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (manifestChanges_==0) return;
+      auto prefix = dataPath_.size() + std::string("/cache/").size();
+      disk_.visit([&](const std::string &path, const std::uint64_t &size) {
+        content << size << ' ' << path.substr(prefix) << '\n';
+      });
+      manifestChanges_ = 0;
+    }
+
+    auto manifestPath = getManifestPath();
+    {
+      std::ofstream manifest(manifestPath + TemporaryExtension, std::ios::out | std::ios::trunc);
+      manifest << content.str();
+    }
+    std::rename((manifestPath + TemporaryExtension).c_str(), manifestPath.c_str());
+  }
+
   /// Checks whether the data associated with given context is already cached on disk.
   bool isCacheHit(const QuadKey &quadKey, const std::string &filePath) const {
     // NOTE if quadkey is preset in collection, then caching is in progress.
     // in this case, we let app to behaviour as there is no cache at all
     if (cachingQuads_.find(quadKey) != cachingQuads_.end()) return false;
+    if (pendingWrites_.find(filePath) != pendingWrites_.end() || memory_.exists(filePath)) return true;
     // NOTE if file is on disk, it should be processed.
     std::ifstream file(filePath, std::ios::in | std::ios::binary | std::ios::ate);
     file.seekg(0, std::ios::beg);
@@ -87,71 +448,244 @@ class MeshCache::MeshCacheImpl {
 
   /// Gets path to cache file on disk.
   std::string getFilePath(const BuilderContext &context) const {
-    std::stringstream ss;
-    ss << dataPath_ << "/cache/" << context.styleProvider.getTag()
-       << "/" << context.quadKey.levelOfDetail << "/"
-       << GeoUtils::quadKeyToString(context.quadKey) << extension_;
-    return ss.str();
+    return getFilePath(context.quadKey, context.styleProvider);
+  }
+
+  std::string getFilePath(const QuadKey &quadKey, const utymap::mapcss::StyleProvider &styleProvider) const {
+    return dataPath_ + "/cache/" + styleProvider.getTag() + getRelativePath(quadKey);
+  }
+
+  bool hasPendingSiblings(const QuadKey &quadKey, const std::string &filePath) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto relativePath = getRelativePath(quadKey);
+    for (const auto &pending : pendingWrites_) {
+      if (pending.first != filePath && isSibling(pending.first, relativePath))
+        return true;
+    }
+    return false;
+  }
+
+  static bool isSibling(const std::string &path, const std::string &relativePath) {
+    return path.size() >= relativePath.size() &&
+        path.compare(path.size() - relativePath.size(), relativePath.size(), relativePath) == 0;
+  }
+
+  /// Gets path to cache file relative to directory of style.
+  std::string getRelativePath(const QuadKey &quadKey) const {
+    return "/" + std::to_string(quadKey.levelOfDetail) + "/" + GeoUtils::quadKeyToString(quadKey) + extension_;
+  }
+
+  /// Removes cached data and its dependencies.
+  static void remove(const std::string &filePath) {
+    std::remove(filePath.c_str());
+    std::remove((filePath + DependencyExtension).c_str());
+  }
+
+  /// Gets paths to data of given quadkey cached with other styles.
+  std::vector<std::string> getSiblingPaths(const QuadKey &quadKey,
+                                           const utymap::mapcss::StyleProvider &styleProvider) const {
+    namespace fs = boost::filesystem;
+    std::vector<std::string> paths;
+    boost::system::error_code ec;
+    fs::path cacheDir = fs::path(dataPath_) / "cache";
+    if (!fs::is_directory(cacheDir, ec))
+      return paths;
+
+    auto relativePath = fs::path(std::to_string(quadKey.levelOfDetail)) /
+        (GeoUtils::quadKeyToString(quadKey) + extension_);
+    for (fs::directory_iterator it(cacheDir, ec), end; !ec && it!=end; it.increment(ec)) {
+      if (it->path().filename().string()==styleProvider.getTag())
+        continue;
+      auto path = it->path() / relativePath;
+      if (fs::exists(path, ec))
+        paths.push_back(path.string());
+    }
+    return paths;
+  }
+
+  /// Finds data cached with other style which is still valid for given one and copies it.
+  /// Returns path to data to read or empty string if there is no such data.
+  std::string restore(const QuadKey &quadKey,
+                      const utymap::mapcss::StyleProvider &styleProvider,
+                      const std::string &filePath) {
+    if (cachingQuads_.find(quadKey)!=cachingQuads_.end()) return "";
+
+    for (const auto &path : getSiblingPaths(quadKey, styleProvider)) {
+      if (!isValid(path, quadKey, styleProvider))
+        continue;
+
+      namespace fs = boost::filesystem;
+      boost::system::error_code ec;
+      fs::create_directories(fs::path(filePath).parent_path(), ec);
+      fs::copy_file(path + DependencyExtension, filePath + DependencyExtension,
+                    fs::copy_options::overwrite_existing, ec);
+      if (!ec)
+        fs::copy_file(path, filePath, fs::copy_options::overwrite_existing, ec);
+      // NOTE copy is an optimization only: data can be read from its original place.
+      if (ec) return path;
+
+      auto size = fs::file_size(filePath, ec) + fs::file_size(filePath + DependencyExtension, ec);
+      if (!ec) addEntry(filePath, size);
+      return filePath;
+    }
+    return "";
   }
 
-  BuilderContext wrap(const BuilderContext &context, const std::string &filePath) {
-    auto file = std::make_shared<std::fstream>();
-    file->open(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
-    // NOTE marker that processing in progress
-    *file << static_cast<char>(0);
+  /// Checks whether data cached with other style depends only on rules which exist in given one.
+  static bool isValid(const std::string &filePath,
+                      const QuadKey &quadKey,
+                      const utymap::mapcss::StyleProvider &styleProvider) {
+    std::ifstream file(filePath, std::ios::in | std::ios::binary);
+    if (!isGood(file))
+      return false;
+
+    std::ifstream deps(filePath + DependencyExtension, std::ios::in | std::ios::binary);
+    std::uint64_t layout;
+    std::uint32_t count;
+    deps.read(reinterpret_cast<char *>(&layout), sizeof(layout));
+    deps.read(reinterpret_cast<char *>(&count), sizeof(count));
+    if (!deps.good() || layout!=styleProvider.getLayoutFingerprint(quadKey.levelOfDetail))
+      return false;
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+      std::uint64_t rule;
+      if (!deps.read(reinterpret_cast<char *>(&rule), sizeof(rule)) || !styleProvider.hasRule(rule))
+        return false;
+    }
+    return true;
+  }
+
+  /// Writes layout of style and rules applied to elements of cached data.
+  static void writeDependencies(std::ostream &deps, const BuilderContext &context) {
+    std::uint64_t layout = context.styleProvider.getLayoutFingerprint(context.quadKey.levelOfDetail);
+    auto count = static_cast<std::uint32_t>(context.styleRules->size());
+    deps.write(reinterpret_cast<const char *>(&layout), sizeof(layout));
+    deps.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    for (auto rule : *context.styleRules)
+      deps.write(reinterpret_cast<const char *>(&rule), sizeof(rule));
+  }
+
+  /// Writes data of built quad key to temporary files which replace cached ones, so
+  /// readers never see incomplete data. Data is dropped if it was invalidated meanwhile.
+  void write(const std::string &filePath, const std::shared_ptr<const PendingWrite> &pendingWrite) {
+    auto tempPath = filePath + TemporaryExtension;
+    auto encoded = encode(*pendingWrite->data);
+    {
+      std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+      // NOTE marker that processing in progress
+      file << static_cast<char>(0);
+      file.write(encoded.data(), encoded.size());
+      file.seekp(0, std::ios::beg);
+      file << CompleteStatus;
+      std::ofstream deps(tempPath + DependencyExtension, std::ios::out | std::ios::binary | std::ios::trunc);
+      deps.write(pendingWrite->deps.data(), pendingWrite->deps.size());
+    }
 
-    cachingQuads_.insert({context.quadKey, file});
+    bool isManifestChanged = false;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      auto pending = pendingWrites_.find(filePath);
+      if (pending != pendingWrites_.end() && pending->second == pendingWrite) {
+        // NOTE dependencies go first, so data on disk always has them.
+        removeEntry(filePath);
+        std::rename((tempPath + DependencyExtension).c_str(), (filePath + DependencyExtension).c_str());
+        if (std::rename(tempPath.c_str(), filePath.c_str())==0) {
+          addEntry(filePath, encoded.size() + 1 + pendingWrite->deps.size());
+          trimDisk();
+        }
+        putMemory(filePath, pendingWrite->data);
+        pendingWrites_.erase(pending);
+      }
+      remove(tempPath);
+      isManifestChanged = manifestChanges_ >= ManifestSaveInterval;
+    }
+    // NOTE manifest is saved periodically, it is rebuilt from directory if it is lost.
+    if (isManifestChanged)
+      saveManifest();
+  }
 
-    return BuilderContext(
+  /// Returns context which collects data of quad key for writing it to cache.
+  BuilderContext createCachingContext(const BuilderContext &context) {
+    auto buffer = std::make_shared<std::stringstream>();
+    if (!cachingQuads_.insert({context.quadKey, buffer}).second)
+      return context;
+
+    BuilderContext cacheContext(
         context.quadKey,
         context.styleProvider,
         context.stringTable,
         context.meshPool,
         context.eleProvider,
-        wrap(*file, context.meshCallback, context.cancelToken),
-        wrap(*file, context.elementCallback, context.cancelToken),
-        context.cancelToken);
+        wrap(buffer, context.meshCallback, context.cancelToken),
+        wrap(buffer, context.elementCallback, context.cancelToken),
+        context.cancelToken,
+        context.threadPool);
+    cacheContext.styleRules = context.styleRules;
+    return cacheContext;
   }
 
-  static MeshCallback wrap(std::ostream &stream, const MeshCallback &callback, const CancellationToken &token) {
-    return [&](const Mesh &mesh) {
+  /// NOTE data is collected in memory and written to disk in background once quad key is built.
+  /// NOTE meshes are kept in compact form quantized within their own extent as bounding box
+  /// is empty, so precision follows size of mesh, not size of quad key.
+  static MeshCallback wrap(const std::shared_ptr<std::stringstream> &buffer,
+                           const MeshCallback &callback,
+                           const CancellationToken &token) {
+    return [buffer, &callback, &token](const Mesh &mesh) {
       if (token.isCancelled()) return;
-      stream << MeshType;
-      MeshStream::write(stream, mesh);
+      *buffer << MeshType;
+      MeshStream::writeCompact(*buffer, mesh, BoundingBox());
       callback(mesh);
     };
   }
 
-  static ElementCallback wrap(std::ostream &stream, const ElementCallback &callback, const CancellationToken &token) {
-    return [&](const Element &element) {
+  static ElementCallback wrap(const std::shared_ptr<std::stringstream> &buffer,
+                              const ElementCallback &callback,
+                              const CancellationToken &token) {
+    return [buffer, &callback, &token](const Element &element) {
       if (token.isCancelled()) return;
-      stream << ElementType;
-      stream.write(reinterpret_cast<const char *>(&element.id), sizeof(element.id));
-      ElementStream::write(stream, element);
+      *buffer << ElementType;
+      buffer->write(reinterpret_cast<const char *>(&element.id), sizeof(element.id));
+      ElementStream::write(*buffer, element);
       callback(element);
     };
   }
 
-  static void readCache(std::string &filePath, const BuilderContext &context) {
-    std::fstream file;
-    file.open(filePath, std::ios::in | std::ios::binary | std::ios::app | std::ios::ate);
-    file.seekg(0, std::ios::beg);
-    
-    if (!isGood(file)) return;
+  /// Reads cached data from disk mapping it into memory. Returns null if it is not completely cached.
+  static std::shared_ptr<const std::string> readCache(const std::string &filePath) {
+    using namespace boost::interprocess;
+    try {
+      file_mapping mapping(filePath.c_str(), read_only);
+      mapped_region region(mapping, read_only);
+      auto data = static_cast<const char *>(region.get_address());
+      if (region.get_size() == 0 || data[0] != CompleteStatus) return nullptr;
+
+      return decode(data + 1, region.get_size() - 1);
+    } catch (const interprocess_exception &) {
+      // NOTE file can be removed or being replaced meanwhile.
+      return nullptr;
+    }
+  }
 
+  /// Reads cached data passing it to callbacks. Meshes are read into the same pooled one.
+  static void readData(std::istream &stream, const BuilderContext &context) {
+    auto mesh = context.meshPool.getSmall("");
     while (!context.cancelToken.isCancelled()) {
       char type;
-      if (!(file >> type)) break;
+      if (!(stream >> type)) break;
 
-      if (type==MeshType)
-        context.meshCallback(MeshStream::read(file));
-      else if (type==ElementType) {
+      if (type==MeshType) {
+        MeshStream::readCompact(stream, mesh);
+        context.meshCallback(mesh);
+      } else if (type==ElementType) {
         std::uint64_t id;
-        file.read(reinterpret_cast<char *>(&id), sizeof(id));
-        context.elementCallback(*ElementStream::read(file, id));
-      } else
+        stream.read(reinterpret_cast<char *>(&id), sizeof(id));
+        context.elementCallback(*ElementStream::read(stream, id));
+      } else {
+        context.meshPool.release(std::move(mesh));
         throw std::invalid_argument("Cannot read cache.");
+      }
     }
+    context.meshPool.release(std::move(mesh));
   }
 
   static bool isGood(std::istream& stream) {
@@ -159,13 +693,27 @@ class MeshCache::MeshCacheImpl {
 
     char status;
     stream >> status;
-    return status == 1;
+    return status == CompleteStatus;
   }
 
   const std::string dataPath_;
   const std::string extension_;
   std::mutex lock_;
-  std::map<QuadKey, std::shared_ptr<std::fstream>, QuadKey::Comparator> cachingQuads_;
+  std::unordered_map<QuadKey, std::shared_ptr<std::stringstream>, QuadKey::Hash> cachingQuads_;
+  std::unordered_map<std::string, std::shared_ptr<const PendingWrite>> pendingWrites_;
+  /// Recently used data which is read without disk access.
+  utymap::utils::LruCache<std::string, const std::string> memory_;
+  std::size_t memoryBytes_;
+  std::size_t maxMemoryBytes_;
+  /// Counts invalidations, so data read from disk meanwhile is not kept in memory.
+  std::uint64_t invalidations_;
+  /// Sizes of files on disk ordered by their usage, so the least recently used are evicted.
+  utymap::utils::LruCache<std::string, const std::uint64_t> disk_;
+  std::uint64_t diskBytes_;
+  std::uint64_t maxDiskBytes_;
+  std::uint64_t manifestChanges_;
+  /// NOTE declared last, so pending writes are finished before other members are destroyed.
+  utymap::utils::ThreadPool writer_;
 };
 
 MeshCache::MeshCache(const std::string &directory, const std::string &extension) :
@@ -177,11 +725,45 @@ BuilderContext MeshCache::wrap(const BuilderContext &context) const {
 }
 
 bool MeshCache::fetch(const BuilderContext &context) const {
-  return isEnabled_ && pimpl_->fetch(context);
+  if (!isEnabled_)
+    return false;
+
+  bool isFetched = pimpl_->fetch(context);
+  utymap::utils::Metrics::add(isFetched ? utymap::utils::Metrics::Counter::MeshCacheHits
+                                        : utymap::utils::Metrics::Counter::MeshCacheMisses);
+  return isFetched;
+}
+
+void MeshCache::invalidate(const QuadKey &quadKey, const utymap::mapcss::StyleProvider &styleProvider) const {
+  pimpl_->invalidate(quadKey, styleProvider);
 }
 
 void MeshCache::unwrap(const BuilderContext &context) const {
   pimpl_->unwrap(context);
 }
 
+void MeshCache::flush() const {
+  pimpl_->flush();
+}
+
+void MeshCache::setMemoryLimit(std::size_t maxBytes) const {
+  pimpl_->setMemoryLimit(maxBytes);
+}
+
+std::size_t MeshCache::getMemoryUsage() const {
+  return pimpl_->getMemoryUsage();
+}
+
+void MeshCache::trimMemory(std::size_t maxBytes) const {
+  pimpl_->trimMemory(maxBytes);
+}
+
+void MeshCache::setDiskLimit(std::uint64_t maxBytes) const {
+  pimpl_->setDiskLimit(maxBytes);
+}
+
+void MeshCache::purge(const std::vector<std::string> &tags) const {
+  pimpl_->purge(tags);
+}
+
 MeshCache::~MeshCache() {}
@@ -3,7 +3,10 @@
 
 #include "builders/BuilderContext.hpp"
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace utymap {
 namespace builders {
@@ -33,9 +36,33 @@ class MeshCache final {
   /// Fetches data from cache. Returns true if operation is successful
   bool fetch(const BuilderContext &context) const;
 
-  /// Releases context.
+  /// Releases context. Cached data is written to disk in background.
   void unwrap(const BuilderContext &context) const;
 
+  /// Waits until cached data of released contexts is written to disk.
+  void flush() const;
+
+  /// Sets max amount of memory used to keep recently used data, so it is fetched without
+  /// disk access. Zero disables it.
+  void setMemoryLimit(std::size_t maxBytes) const;
+
+  /// Returns memory used to keep recently used data.
+  std::size_t getMemoryUsage() const;
+
+  /// Drops the least recently used data kept in memory until it takes at most given
+  /// amount of memory. Limit set by setMemoryLimit is not changed.
+  void trimMemory(std::size_t maxBytes) const;
+
+  /// Sets max amount of disk space used by cached data. The least recently used data
+  /// is removed once it is exceeded. Zero means no limit.
+  void setDiskLimit(std::uint64_t maxBytes) const;
+
+  /// Removes data cached with styles which tags are not in given list.
+  void purge(const std::vector<std::string> &tags) const;
+
+  /// Removes cached data of given quad key built with given style.
+  void invalidate(const QuadKey &quadKey, const utymap::mapcss::StyleProvider &styleProvider) const;
+
   ~MeshCache();
 
  private:
@@ -0,0 +1,120 @@
+#ifndef BUILDERS_MESHINSTANCER_HPP_DEFINED
+#define BUILDERS_MESHINSTANCER_HPP_DEFINED
+
+#include "builders/BuilderContext.hpp"
+#include "mapcss/Style.hpp"
+#include "math/Mesh.hpp"
+#include "math/Vector3.hpp"
+#include "utils/MeshUtils.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap {
+namespace builders {
+
+/// Collects meshes which element builder repeats many times, so every mesh is emitted once as
+/// prototype followed by translations of its instances. Host can draw them with GPU instancing
+/// instead of receiving copied geometry.
+/// Prototype is passed to mesh callback with name prefixed by prototype prefix. Instances are
+/// passed as mesh without triangles which name is prototype name prefixed by instances prefix.
+/// Its vertices are translations added to prototype vertices, so they use vertex order.
+class MeshInstancer final {
+ public:
+  static const std::string &prototypePrefix() {
+    static const std::string prefix = "prototype:";
+    return prefix;
+  }
+
+  static const std::string &instancesPrefix() {
+    static const std::string prefix = "instances:";
+    return prefix;
+  }
+
+  /// Gets name of prototype shared by elements which have the same style on given level of details.
+  /// NOTE declarations evaluated from element tags are not taken into account.
+  static std::string getName(const std::string &prefix, const utymap::mapcss::Style &style, int levelOfDetail) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (auto fingerprint : style.getRules())
+      hash = (hash ^ fingerprint)*1099511628211ull;
+    return prefix + std::to_string(levelOfDetail) + ":" + std::to_string(hash);
+  }
+
+  /// Copies prototype into destination once per instance.
+  static void expand(const utymap::math::Mesh &prototype,
+                     const utymap::math::Mesh &instances,
+                     utymap::math::Mesh &destination) {
+    for (std::size_t i = 0; i + 2 < instances.vertices.size(); i += 3) {
+      utymap::utils::copyMesh(utymap::math::Vector3(instances.vertices[i],
+                                                    instances.vertices[i + 2],
+                                                    instances.vertices[i + 1]),
+                              prototype, destination);
+    }
+  }
+
+  explicit MeshInstancer(const BuilderContext &context) : context_(context) {}
+
+  MeshInstancer(const MeshInstancer &) = delete;
+  MeshInstancer &operator=(const MeshInstancer &) = delete;
+
+  ~MeshInstancer() {
+    clear();
+  }
+
+  /// Checks whether prototype with given name is added.
+  bool has(const std::string &name) const {
+    return indices_.find(name)!=indices_.end();
+  }
+
+  /// Adds prototype with given name and returns mesh to generate its geometry into.
+  utymap::math::Mesh &add(const std::string &name) {
+    indices_[name] = entries_.size();
+    entries_.push_back(Entry { context_.meshPool.getSmall(prototypePrefix() + name),
+                               context_.meshPool.getSmall(instancesPrefix() + name) });
+    return entries_.back().prototype;
+  }
+
+  /// Adds instance of prototype translated by given offset which uses elevation as y.
+  void addInstance(const std::string &name, const utymap::math::Vector3 &offset) {
+    auto &instances = entries_[indices_.at(name)].instances.vertices;
+    instances.push_back(offset.x);
+    instances.push_back(offset.z);
+    instances.push_back(offset.y);
+  }
+
+  /// Passes prototypes which have instances to mesh callback followed by their instances.
+  void flush() {
+    for (const auto &entry : entries_) {
+      if (entry.instances.vertices.empty() || entry.prototype.vertices.empty())
+        continue;
+      context_.meshCallback(entry.prototype);
+      context_.meshCallback(entry.instances);
+    }
+    clear();
+  }
+
+ private:
+  struct Entry {
+    utymap::math::Mesh prototype;
+    utymap::math::Mesh instances;
+  };
+
+  void clear() {
+    for (auto &entry : entries_) {
+      context_.meshPool.release(std::move(entry.prototype));
+      context_.meshPool.release(std::move(entry.instances));
+    }
+    entries_.clear();
+    indices_.clear();
+  }
+
+  const BuilderContext &context_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, std::size_t> indices_;
+};
+
+}
+}
+#endif // BUILDERS_MESHINSTANCER_HPP_DEFINED
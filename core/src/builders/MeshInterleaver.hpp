@@ -0,0 +1,156 @@
+#ifndef BUILDERS_MESHINTERLEAVER_HPP_DEFINED
+#define BUILDERS_MESHINTERLEAVER_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "math/Mesh.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace utymap {
+namespace builders {
+
+/// Vertex of GPU ready buffer. Attributes go in order of vertex attribute descriptors:
+/// position (float3), color (unorm8x4), uv (float2), atlas index (float),
+/// texture size (float2) and texture offset (float2) inside of atlas.
+struct InterleavedVertex final {
+  float position[3];
+  std::uint8_t color[4];
+  float uv[2];
+  float textureIndex;
+  float textureSize[2];
+  float textureOffset[2];
+};
+
+/// Converts mesh into single interleaved vertex stream and index buffer, so host
+/// can upload them without conversion. Position is (x, y, elevation) where x and y
+/// are offsets from given origin, so float keeps precision.
+class MeshInterleaver final {
+  /// Amount of items in texture mapping info of every texture region.
+  static const std::size_t UvMapEntrySize = 8;
+ public:
+  static void interleave(const utymap::math::Mesh &mesh,
+                         const utymap::GeoCoordinate &origin,
+                         std::vector<InterleavedVertex> &vertices,
+                         std::vector<int> &indices) {
+    auto count = mesh.vertices.size() / 3;
+    vertices.resize(count);
+    indices.assign(mesh.triangles.begin(), mesh.triangles.end());
+
+    std::size_t entry = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      auto &vertex = vertices[i];
+      vertex.position[0] = static_cast<float>(mesh.vertices[i * 3] - origin.longitude);
+      vertex.position[1] = static_cast<float>(mesh.vertices[i * 3 + 1] - origin.latitude);
+      vertex.position[2] = static_cast<float>(mesh.vertices[i * 3 + 2]);
+
+      // NOTE color is stored as rgba int.
+      auto color = i < mesh.colors.size() ? static_cast<std::uint32_t>(mesh.colors[i]) : 0xFFFFFFFFu;
+      vertex.color[0] = static_cast<std::uint8_t>(color >> 24);
+      vertex.color[1] = static_cast<std::uint8_t>(color >> 16);
+      vertex.color[2] = static_cast<std::uint8_t>(color >> 8);
+      vertex.color[3] = static_cast<std::uint8_t>(color);
+
+      auto uvIndex = i * 2;
+      bool hasUv = uvIndex + 1 < mesh.uvs.size();
+      vertex.uv[0] = hasUv ? static_cast<float>(mesh.uvs[uvIndex]) : 0;
+      vertex.uv[1] = hasUv ? static_cast<float>(mesh.uvs[uvIndex + 1]) : 0;
+
+      // NOTE first item of mapping info is end of uv range which uses texture region.
+      while (entry + UvMapEntrySize <= mesh.uvMap.size() &&
+             static_cast<std::size_t>(mesh.uvMap[entry]) <= uvIndex)
+        entry += UvMapEntrySize;
+      setTexture(mesh.uvMap, entry, vertex);
+    }
+  }
+
+  /// Splits interleaved mesh into chunks which have no more than given amount of vertices.
+  /// Vertices shared by triangles of different chunks are copied. Visitor receives vertices
+  /// and indices of every chunk. Returns amount of chunks.
+  template<typename Visitor>
+  static std::size_t split(const std::vector<InterleavedVertex> &vertices,
+                           const std::vector<int> &indices,
+                           std::size_t maxVertices,
+                           const Visitor &visitor) {
+    if (vertices.size() <= maxVertices) {
+      visitor(vertices, indices);
+      return 1;
+    }
+
+    std::vector<int> remap(vertices.size(), -1);
+    std::vector<int> sources;
+    std::vector<InterleavedVertex> chunkVertices;
+    std::vector<int> chunkIndices;
+    std::size_t count = 0;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+      std::size_t added = 0;
+      for (std::size_t j = i; j < i + 3; ++j) {
+        if (remap[indices[j]] < 0 && (j == i || indices[j] != indices[i]) &&
+            (j < i + 2 || indices[j] != indices[i + 1]))
+          ++added;
+      }
+
+      if (chunkVertices.size() + added > maxVertices) {
+        visitor(chunkVertices, chunkIndices);
+        ++count;
+        for (auto source : sources)
+          remap[source] = -1;
+        sources.clear();
+        chunkVertices.clear();
+        chunkIndices.clear();
+      }
+
+      for (std::size_t j = i; j < i + 3; ++j) {
+        auto source = indices[j];
+        if (remap[source] < 0) {
+          remap[source] = static_cast<int>(chunkVertices.size());
+          sources.push_back(source);
+          chunkVertices.push_back(vertices[source]);
+        }
+        chunkIndices.push_back(remap[source]);
+      }
+    }
+
+    if (!chunkIndices.empty()) {
+      visitor(chunkVertices, chunkIndices);
+      ++count;
+    }
+    return count;
+  }
+
+  /// Copies indices into 16 bit buffer if mesh with given amount of vertices allows that.
+  static bool narrow(const std::vector<int> &indices, std::size_t vertexCount, std::vector<std::uint16_t> &result) {
+    if (vertexCount > MaxShortVertices)
+      return false;
+
+    result.assign(indices.begin(), indices.end());
+    return true;
+  }
+
+  /// Max amount of vertices which can be addressed by 16 bit indices.
+  static const std::size_t MaxShortVertices = 1 << 16;
+
+ private:
+  static void setTexture(const std::vector<int> &uvMap, std::size_t entry, InterleavedVertex &vertex) {
+    if (entry + UvMapEntrySize > uvMap.size()) {
+      vertex.textureIndex = 0;
+      vertex.textureSize[0] = vertex.textureSize[1] = 0;
+      vertex.textureOffset[0] = vertex.textureOffset[1] = 0;
+      return;
+    }
+
+    float atlasWidth = static_cast<float>(uvMap[entry + 2]);
+    float atlasHeight = static_cast<float>(uvMap[entry + 3]);
+    bool isEmpty = atlasWidth == 0 || atlasHeight == 0;
+    vertex.textureIndex = static_cast<float>(uvMap[entry + 1]);
+    vertex.textureOffset[0] = isEmpty ? 0 : uvMap[entry + 4] / atlasWidth;
+    vertex.textureOffset[1] = isEmpty ? 0 : uvMap[entry + 5] / atlasHeight;
+    vertex.textureSize[0] = isEmpty ? 0 : uvMap[entry + 6] / atlasWidth;
+    vertex.textureSize[1] = isEmpty ? 0 : uvMap[entry + 7] / atlasHeight;
+  }
+};
+
+}
+}
+
+#endif // BUILDERS_MESHINTERLEAVER_HPP_DEFINED
@@ -2,62 +2,261 @@
 #define BUILDERS_MESHPOOL_HPP_DEFINED
 
 #include "math/Mesh.hpp"
+#include "utils/CoreUtils.hpp"
 
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <unordered_set>
+#include <vector>
 
 namespace utymap {
 namespace builders {
 
 /// Provides the way to use pool of meshes instead of
 /// building them each time which might be expensive.
+/// Meshes are kept in power of two size classes by vertex capacity. Memory retained
+/// by all pools is limited: pool trims its largest meshes when limit is exceeded.
 class MeshPool final {
-  const std::size_t ThresholdSize = 1024 * 10 * 2;
+  /// Meshes which vertex capacity is above this size are large.
+  static const std::size_t ThresholdSize = 1 << 14;
+  static const std::size_t ClassCount = 64;
  public:
+  /// Contains counters shared by all pools.
+  struct Statistics {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    /// Memory consumed by pooled meshes.
+    std::uint64_t retainedBytes = 0;
+    /// Memory of meshes dropped to keep retained memory under limit.
+    std::uint64_t trimmedBytes = 0;
+  };
 
-  MeshPool() {}
+  MeshPool() : retainedBytes_(0) {
+    auto &registry = MeshPool::registry();
+    std::lock_guard<std::mutex> lock(registry.lock);
+    registry.pools.insert(this);
+  }
 
   /// Disable copying to prevent accidental copy
   MeshPool(const MeshPool &) = delete;
   MeshPool &operator=(const MeshPool &) = delete;
 
+  ~MeshPool() {
+    {
+      auto &registry = MeshPool::registry();
+      std::lock_guard<std::mutex> lock(registry.lock);
+      registry.pools.erase(this);
+    }
+    counters().retainedBytes -= retainedBytes_;
+  }
+
   /// Gets small size mesh.
   utymap::math::Mesh getSmall(const std::string& name) {
-    return getMesh(name, true);
+    return getMesh(name, 0, 0);
   }
 
   /// Gets large size mesh.
   utymap::math::Mesh getLarge(const std::string& name) {
-    return getMesh(name, false);
+    return getMesh(name, getClass(ThresholdSize) + 1, 0);
+  }
+
+  /// Gets mesh which keeps estimated amount of vertices without reallocation.
+  utymap::math::Mesh get(const std::string& name, std::size_t vertexCount) {
+    return getMesh(name, getClass(3*vertexCount), vertexCount);
   }
 
   /// Returns mesh to pool.
   void release(utymap::math::Mesh&& mesh) {
     mesh.clear();
     mesh.name.clear();
+    auto bytes = getBytes(mesh);
+    auto &counters = MeshPool::counters();
+
     std::lock_guard<std::mutex> lock(lock_);
-    pool_.emplace(mesh.vertices.capacity(), std::move(mesh));
+    classes_[getClass(mesh.vertices.capacity())].push_back(std::move(mesh));
+    retainedBytes_ += bytes;
+    counters.retainedBytes += bytes;
+    trim(counters, counters.maxBytes);
+  }
+
+  /// Returns statistics of all pools.
+  static Statistics getStatistics() {
+    const auto &counters = MeshPool::counters();
+    Statistics statistics;
+    statistics.hits = counters.hits;
+    statistics.misses = counters.misses;
+    statistics.retainedBytes = counters.retainedBytes;
+    statistics.trimmedBytes = counters.trimmedBytes;
+    return statistics;
+  }
+
+  /// Sets max amount of memory retained by all pools. Pools trim their meshes on next release.
+  static void setMaxBytes(std::size_t maxBytes) {
+    counters().maxBytes = maxBytes;
+  }
+
+  /// Drops meshes of all pools until they retain at most given amount of memory.
+  /// Limit set by setMaxBytes is not changed.
+  static void trimAll(std::size_t maxBytes) {
+    auto &registry = MeshPool::registry();
+    std::lock_guard<std::mutex> registryLock(registry.lock);
+    for (auto pool : registry.pools) {
+      std::lock_guard<std::mutex> lock(pool->lock_);
+      pool->trim(counters(), maxBytes);
+    }
   }
 
  private:
-  utymap::math::Mesh getMesh(const std::string &name, bool isLower) {
-    std::lock_guard<std::mutex> lock(lock_);
-    auto it = isLower
-      ? pool_.lower_bound(0)
-      : pool_.upper_bound(ThresholdSize);
-    if (it == pool_.end())
-      return utymap::math::Mesh(name);
+  struct Counters {
+    Counters() : hits(0), misses(0), retainedBytes(0), trimmedBytes(0), maxBytes(128 * 1024 * 1024) {}
+    std::atomic<std::uint64_t> hits;
+    std::atomic<std::uint64_t> misses;
+    std::atomic<std::uint64_t> retainedBytes;
+    std::atomic<std::uint64_t> trimmedBytes;
+    std::atomic<std::uint64_t> maxBytes;
+  };
+
+  /// Contains all existing pools, so they can be trimmed at once.
+  struct Registry {
+    std::unordered_set<MeshPool *> pools;
+    std::mutex lock;
+  };
+
+  static Counters &counters() {
+    static Counters counters;
+    return counters;
+  }
+
+  static Registry &registry() {
+    static Registry registry;
+    return registry;
+  }
+
+  /// Gets index of the smallest power of two which is not less than capacity.
+  static std::size_t getClass(std::size_t capacity) {
+    std::size_t index = 0;
+    while (index + 1 < ClassCount && (static_cast<std::size_t>(1) << index) < capacity)
+      ++index;
+    return index;
+  }
+
+  static std::uint64_t getBytes(const utymap::math::Mesh &mesh) {
+    return mesh.vertices.capacity() * sizeof(double) +
+        mesh.triangles.capacity() * sizeof(int) +
+        mesh.colors.capacity() * sizeof(int) +
+        mesh.uvs.capacity() * sizeof(double) +
+        mesh.uvMap.capacity() * sizeof(int);
+  }
+
+  /// Gets pooled mesh of given or bigger size class. New mesh is created with capacity
+  /// for given amount of vertices if there is none.
+  utymap::math::Mesh getMesh(const std::string &name, std::size_t minClass, std::size_t vertexCount) {
+    std::unique_lock<std::mutex> lock(lock_);
+    for (auto index = minClass; index < ClassCount; ++index) {
+      auto &meshes = classes_[index];
+      if (meshes.empty())
+        continue;
+
+      utymap::math::Mesh mesh(std::move(meshes.back()));
+      meshes.pop_back();
+      auto bytes = getBytes(mesh);
+      retainedBytes_ -= bytes;
+      lock.unlock();
 
-    auto mesh = std::move(it->second);
-    mesh.name = name;
-    pool_.erase(it);
-    return mesh;
+      auto &counters = MeshPool::counters();
+      counters.retainedBytes -= bytes;
+      ++counters.hits;
+      mesh.name = name;
+      return mesh;
+    }
+    lock.unlock();
+
+    ++counters().misses;
+    return utymap::math::Mesh(name, vertexCount);
+  }
+
+  /// Drops the largest meshes of the pool until memory retained by all pools fits limit.
+  /// NOTE memory retained by other pools is not freed here.
+  void trim(Counters &counters, std::uint64_t maxBytes) {
+    for (auto index = ClassCount; index > 0 && counters.retainedBytes > maxBytes;) {
+      auto &meshes = classes_[index - 1];
+      if (meshes.empty()) {
+        --index;
+        continue;
+      }
+
+      auto bytes = getBytes(meshes.back());
+      meshes.pop_back();
+      retainedBytes_ -= bytes;
+      counters.retainedBytes -= bytes;
+      counters.trimmedBytes += bytes;
+    }
   }
 
-  std::map<std::size_t, utymap::math::Mesh> pool_;
+  std::vector<utymap::math::Mesh> classes_[ClassCount];
+  std::uint64_t retainedBytes_;
   std::mutex lock_;
 };
 
+/// Keeps mesh pools leased by concurrent tasks, so tasks running at the same time do not
+/// contend for meshes. Pools are reused by next tasks.
+class MeshPoolSet final {
+ public:
+  /// Gives pool to the task until lease is destroyed.
+  class Lease final {
+   public:
+    Lease(MeshPoolSet &set, MeshPool &meshPool) : set_(set), meshPool_(meshPool) {}
+
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    ~Lease() {
+      set_.release(meshPool_);
+    }
+
+    MeshPool &get() { return meshPool_; }
+
+   private:
+    MeshPoolSet &set_;
+    MeshPool &meshPool_;
+  };
+
+  MeshPoolSet() {}
+
+  MeshPoolSet(const MeshPoolSet &) = delete;
+  MeshPoolSet &operator=(const MeshPoolSet &) = delete;
+
+  /// Leases free pool. New pool is created if all pools are leased.
+  std::unique_ptr<Lease> lease() {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (free_.empty()) {
+      pools_.push_back(utymap::utils::make_unique<MeshPool>());
+      free_.push_back(pools_.back().get());
+    }
+    auto meshPool = free_.back();
+    free_.pop_back();
+    return utymap::utils::make_unique<Lease>(*this, *meshPool);
+  }
+
+  /// Returns amount of created pools.
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return pools_.size();
+  }
+
+ private:
+  void release(MeshPool &meshPool) {
+    std::lock_guard<std::mutex> lock(lock_);
+    free_.push_back(&meshPool);
+  }
+
+  std::vector<std::unique_ptr<MeshPool>> pools_;
+  std::vector<MeshPool *> free_;
+  mutable std::mutex lock_;
+};
+
 }
 }
 
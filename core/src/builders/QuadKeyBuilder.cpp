@@ -1,8 +1,25 @@
 #include "builders/BuilderContext.hpp"
 #include "builders/ExternalBuilder.hpp"
 #include "builders/QuadKeyBuilder.hpp"
+#include "entities/ElementDispatch.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "mapcss/StyleConsts.hpp"
+#include "utils/AllocationTracker.hpp"
+#include "math/MeshSimplifier.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/IdSet.hpp"
+#include "utils/Metrics.hpp"
+#include "utils/Tracer.hpp"
+#include "utils/MeshUtils.hpp"
 
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <future>
 
 using namespace utymap;
 using namespace utymap::builders;
@@ -15,12 +32,89 @@ using namespace utymap::math;
 namespace {
 typedef std::unordered_map<std::string, QuadKeyBuilder::ElementBuilderFactory> BuilderFactoryMap;
 
+/// Creates copy of visited element which outlives store scan.
+class ElementCopier final : public ElementVisitor {
+ public:
+  static std::shared_ptr<const Element> copy(const Element &element) {
+    ElementCopier copier;
+    dispatch(element, copier);
+    return copier.result_;
+  }
+
+  void visitNode(const Node &node) override { result_ = std::make_shared<Node>(node); }
+
+  void visitWay(const Way &way) override { result_ = std::make_shared<Way>(way); }
+
+  void visitArea(const Area &area) override { result_ = std::make_shared<Area>(area); }
+
+  void visitRelation(const Relation &relation) override { result_ = std::make_shared<Relation>(relation); }
+
+ private:
+  std::shared_ptr<const Element> result_;
+};
+
+/// Keeps output of builder run as separate task to deliver it later in calling thread.
+/// NOTE meshes are copied into meshes of given pool and returned there once delivered.
+class BuilderOutput final {
+ public:
+  void setMeshPool(MeshPool &meshPool) {
+    meshPool_ = &meshPool;
+  }
+
+  void add(const Mesh &mesh) {
+    auto copy = meshPool_->get(mesh.name, mesh.vertices.size()/3);
+    copy.vertices = mesh.vertices;
+    copy.triangles = mesh.triangles;
+    copy.colors = mesh.colors;
+    copy.uvs = mesh.uvs;
+    copy.uvMap = mesh.uvMap;
+    meshes_.push_back(std::move(copy));
+    items_.push_back(nullptr);
+  }
+
+  void add(const Element &element) {
+    items_.push_back(ElementCopier::copy(element));
+  }
+
+  /// Passes output to callbacks in the same order as it was produced.
+  void deliver(const BuilderContext &context) {
+    std::size_t meshIndex = 0;
+    for (const auto &element : items_) {
+      if (element==nullptr)
+        context.meshCallback(meshes_[meshIndex++]);
+      else
+        context.elementCallback(*element);
+    }
+
+    for (auto &mesh : meshes_)
+      meshPool_->release(std::move(mesh));
+    meshes_.clear();
+  }
+
+ private:
+  MeshPool *meshPool_ = nullptr;
+  std::vector<Mesh> meshes_;
+  /// Produced elements or null for meshes in order of production.
+  std::vector<std::shared_ptr<const Element>> items_;
+};
+
 /// Responsible for processing elements of quadkey in consistent way.
-class BuilderElementVisitor : public ElementVisitor {
+/// NOTE if mesh pools are passed, elements are partitioned by builder during store scan and each
+/// builder is run as separate task on thread pool of context once scan is finished.
+class BuilderElementVisitor final : public ElementVisitor {
  public:
-  BuilderElementVisitor(const BuilderContext &context, BuilderFactoryMap &builderFactoryMap) :
+  BuilderElementVisitor(const BuilderContext &context, BuilderFactoryMap &builderFactoryMap,
+                        MeshPoolSet *meshPools = nullptr,
+                        const std::vector<std::string> &progressiveOrder = std::vector<std::string>()) :
     context_(context),
-    builderFactoryMap_(builderFactoryMap) { }
+    builderFactoryMap_(builderFactoryMap),
+    meshPools_(context.threadPool!=nullptr ? meshPools : nullptr),
+    progressiveOrder_(progressiveOrder),
+    ids_(acquireIds()) { }
+
+  ~BuilderElementVisitor() {
+    releaseIds(std::move(ids_));
+  }
 
   void visitNode(const Node &node) override {
     visitElement(node);
@@ -37,109 +131,453 @@ class BuilderElementVisitor : public ElementVisitor {
   void visitRelation(const Relation &relation) override {
     if (relation.tags.empty()) {
       // processing clipped element
-      ids_.insert(relation.id);
+      ids_->insert(relation.id);
       for (const auto &element : relation.elements)
         visitElement(*element);
     } else
       visitElement(relation);
   }
 
+  /// Returns time spent in visiting of elements including their style matching.
+  std::chrono::steady_clock::duration getVisitTime() const {
+    return visitTime_;
+  }
+
+  /// Returns time spent in style matching of visited elements.
+  std::chrono::steady_clock::duration getStyleTime() const {
+    return styleTime_;
+  }
+
   void complete() {
-    for (const auto &builder : builders_) {
-      builder.second->complete();
+    ALLOCATION_SCOPE(Mesh);
+    if (meshPools_!=nullptr) {
+      completeParallel();
+      return;
+    }
+
+    if (progressiveOrder_.empty()) {
+      for (const auto &builder : builders_)
+        builder.second->complete();
+      return;
     }
+
+    for (auto builderId : getOrder(builderIds_))
+      builders_[builderId]->complete();
   }
 
  private:
   /// Calls appropriate visitor for given element
   void visitElement(const Element &element) {
-    Style style = context_.styleProvider.forElement(element, context_.quadKey.levelOfDetail);
+    auto start = std::chrono::steady_clock::now();
+    Style style = getStyle(element);
+    styleTime_ += std::chrono::steady_clock::now() - start;
+    buildElement(element, style);
+    visitTime_ += std::chrono::steady_clock::now() - start;
+  }
+
+  Style getStyle(const Element &element) const {
+    ALLOCATION_SCOPE(Style);
+    return context_.styleProvider.forElement(element, context_.quadKey.levelOfDetail);
+  }
 
+  void buildElement(const Element &element, const Style &style) {
+    ALLOCATION_SCOPE(Mesh);
     if (canBuild(element, style)) {
 
-      ids_.insert(element.id);
+      ids_->insert(element.id);
+      context_.styleRules->insert(style.getRules().begin(), style.getRules().end());
 
-      for (const auto &name : style.getBuilders()) {
-        element.accept(getBuilder(name));
+      if (meshPools_!=nullptr) {
+        auto copy = ElementCopier::copy(element);
+        for (auto builderId : style.getBuilderIds())
+          getPartition(builderId).elements.push_back(copy);
+        return;
+      }
+
+      for (auto builderId : style.getBuilderIds()) {
+        dispatch(element, getBuilder(builderId));
       }
     }
   }
 
   bool canBuild(const Element &element, const Style &style) {
     // check do we know how to build it and prevent multiple building
-    return !style.empty() && (element.id==0 || ids_.find(element.id)==ids_.end());
+    return !style.empty() && (element.id==0 || !ids_->contains(element.id));
   }
 
-  ElementBuilder &getBuilder(const std::string &name) {
-    auto builderPair = builders_.find(name);
+  ElementBuilder &getBuilder(std::uint32_t builderId) {
+    auto builderPair = builders_.find(builderId);
     if (builderPair!=builders_.end())
       return *builderPair->second;
 
-    auto factory = builderFactoryMap_.find(name);
-    builders_.emplace(name, factory==builderFactoryMap_.end()
-      ? utymap::utils::make_unique<ExternalBuilder>(context_) // use external builder by default
-      : factory->second(context_));
+    builders_.emplace(builderId, createBuilder(builderId, context_));
+    builderIds_.push_back(builderId);
 
-    auto &builder = *builders_[name];
+    auto &builder = *builders_[builderId];
     builder.prepare();
 
     return builder;
   }
 
+  std::unique_ptr<ElementBuilder> createBuilder(std::uint32_t builderId, const BuilderContext &context) const {
+    auto name = context.stringTable.getString(builderId);
+    auto factory = builderFactoryMap_.find(*name);
+    return factory==builderFactoryMap_.end()
+      ? utymap::utils::make_unique<ExternalBuilder>(context) // use external builder by default
+      : factory->second(context);
+  }
+
+  /// Elements of one builder collected during store scan.
+  struct Partition {
+    std::uint32_t builderId;
+    std::vector<std::shared_ptr<const Element>> elements;
+  };
+
+  Partition &getPartition(std::uint32_t builderId) {
+    auto index = partitionIndices_.find(builderId);
+    if (index!=partitionIndices_.end())
+      return partitions_[index->second];
+
+    partitionIndices_.emplace(builderId, partitions_.size());
+    partitions_.push_back(Partition{builderId, {}});
+    return partitions_.back();
+  }
+
+  /// Gets position of builder in progressive order.
+  std::size_t getRank(std::uint32_t builderId) const {
+    auto name = context_.stringTable.getString(builderId);
+    return static_cast<std::size_t>(std::find(progressiveOrder_.begin(), progressiveOrder_.end(), *name) -
+        progressiveOrder_.begin());
+  }
+
+  /// Sorts builder ids given in order of first use by progressive order.
+  std::vector<std::uint32_t> getOrder(std::vector<std::uint32_t> builderIds) const {
+    std::unordered_map<std::uint32_t, std::size_t> ranks;
+    for (auto builderId : builderIds)
+      ranks[builderId] = getRank(builderId);
+    std::stable_sort(builderIds.begin(), builderIds.end(), [&ranks](std::uint32_t left, std::uint32_t right) {
+      return ranks[left] < ranks[right];
+    });
+    return builderIds;
+  }
+
+  /// Runs builders as separate tasks. Output is delivered in order of first use of builders or
+  /// in progressive order, so it doesn't depend on scheduling.
+  /// NOTE first error is rethrown once all builders are finished.
+  void completeParallel() {
+    std::vector<std::uint32_t> builderIds;
+    for (const auto &partition : partitions_)
+      builderIds.push_back(partition.builderId);
+    builderIds = getOrder(builderIds);
+
+    // NOTE builders are queued in delivery order, so the first ones are started first.
+    std::vector<BuilderOutput> outputs(partitions_.size());
+    std::vector<utymap::utils::ThreadPool::Future> futures;
+    futures.reserve(partitions_.size());
+    for (std::size_t i = 0; i < builderIds.size(); ++i) {
+      auto &partition = partitions_[partitionIndices_[builderIds[i]]];
+      futures.push_back(context_.threadPool->enqueue([this, &partition, &outputs, i]() {
+        run(partition, outputs[i]);
+      }));
+    }
+
+    bool isProgressive = !progressiveOrder_.empty();
+    std::exception_ptr error;
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+      try {
+        futures[i].get();
+      } catch (...) {
+        if (error==nullptr)
+          error = std::current_exception();
+      }
+      // NOTE output is delivered while next builders are still running.
+      if (isProgressive && error==nullptr && !context_.cancelToken.isCancelled())
+        outputs[i].deliver(context_);
+    }
+    if (error!=nullptr)
+      std::rethrow_exception(error);
+
+    for (auto &output : outputs) {
+      if (isProgressive || context_.cancelToken.isCancelled()) break;
+      output.deliver(context_);
+    }
+  }
+
+  /// Visits elements of partition by its builder using own mesh pool.
+  /// NOTE builder has no thread pool: it runs on worker thread which should not wait for other tasks.
+  void run(const Partition &partition, BuilderOutput &output) const {
+    ALLOCATION_SCOPE(Mesh);
+    auto meshPool = meshPools_->lease();
+    output.setMeshPool(meshPool->get());
+    BuilderContext context(context_.quadKey, context_.styleProvider, context_.stringTable,
+                           meshPool->get(), context_.eleProvider,
+                           [&output](const Mesh &mesh) { output.add(mesh); },
+                           [&output](const Element &element) { output.add(element); },
+                           context_.cancelToken);
+    context.styleRules = context_.styleRules;
+    context.useInstancing = context_.useInstancing;
+    context.batchVertexLimit = context_.batchVertexLimit;
+
+    auto builder = createBuilder(partition.builderId, context);
+    builder->prepare();
+    for (const auto &element : partition.elements) {
+      if (context.cancelToken.isCancelled()) break;
+      dispatch(*element, *builder);
+    }
+    builder->complete();
+  }
+
+  /// Returns set of built ids cached by calling thread, so its memory is reused by next builds.
+  /// NOTE nested build on the same thread gets new set.
+  static std::unique_ptr<utymap::utils::IdSet> &getCachedIds() {
+    thread_local std::unique_ptr<utymap::utils::IdSet> ids;
+    return ids;
+  }
+
+  static std::unique_ptr<utymap::utils::IdSet> acquireIds() {
+    auto &cached = getCachedIds();
+    return cached!=nullptr ? std::move(cached) : utymap::utils::make_unique<utymap::utils::IdSet>();
+  }
+
+  static void releaseIds(std::unique_ptr<utymap::utils::IdSet> ids) {
+    ids->clear();
+    getCachedIds() = std::move(ids);
+  }
+
   const BuilderContext &context_;
   BuilderFactoryMap &builderFactoryMap_;
-  std::set<std::uint64_t> ids_;
-  std::unordered_map<std::string, std::unique_ptr<ElementBuilder>> builders_;
+  MeshPoolSet *meshPools_;
+  const std::vector<std::string> &progressiveOrder_;
+  std::unique_ptr<utymap::utils::IdSet> ids_;
+  std::unordered_map<std::uint32_t, std::unique_ptr<ElementBuilder>> builders_;
+  /// Ids of created builders in order of first use.
+  std::vector<std::uint32_t> builderIds_;
+  std::unordered_map<std::uint32_t, std::size_t> partitionIndices_;
+  std::vector<Partition> partitions_;
+  std::chrono::steady_clock::duration visitTime_ = std::chrono::steady_clock::duration::zero();
+  std::chrono::steady_clock::duration styleTime_ = std::chrono::steady_clock::duration::zero();
 };
+
+/// Returns simplifier for calling thread.
+MeshSimplifier &getSimplifier() {
+  thread_local MeshSimplifier simplifier;
+  return simplifier;
+}
 }
 
 class QuadKeyBuilder::QuadKeyBuilderImpl {
  public:
-  QuadKeyBuilderImpl(GeoStore &geoStore, StringTable &stringTable) :
+  QuadKeyBuilderImpl(GeoStore &geoStore, StringTable &stringTable, utymap::utils::ThreadPool *threadPool) :
       geoStore_(geoStore),
       stringTable_(stringTable),
       meshPool_(),
-      builderFactory_() {}
+      builderFactory_(),
+      threadPool_(threadPool),
+      weldMeshes_(false),
+      parallelBuilders_(false),
+      instancing_(false),
+      batchVertexLimit_(0),
+      eleCacheResolution_(0) {}
 
   void registerElementVisitor(const std::string &name, ElementBuilderFactory factory) {
     builderFactory_[name] = factory;
   }
 
+  void setBuildThreads(std::size_t threadCount) {
+    threadPool_.resize(threadCount);
+  }
+
+  void setMeshWelding(bool enabled) {
+    weldMeshes_ = enabled;
+  }
+
+  void setParallelBuilders(bool enabled) {
+    parallelBuilders_ = enabled;
+  }
+
+  void setInstancing(bool enabled) {
+    instancing_ = enabled;
+  }
+
+  void setProgressiveOrder(const std::vector<std::string> &builderNames) {
+    progressiveOrder_ = builderNames;
+  }
+
+  void setBatchVertexLimit(std::size_t vertexLimit) {
+    batchVertexLimit_ = vertexLimit;
+  }
+
+  void setElevationCacheResolution(int resolution) {
+    eleCacheResolution_ = std::max(0, resolution);
+  }
+
   void build(const QuadKey &quadKey,
              const StyleProvider &styleProvider,
              const ElevationProvider &eleProvider,
+             MeshPool &meshPool,
              const BuilderContext::MeshCallback &meshCallback,
              const BuilderContext::ElementCallback &elementCallback,
              const utymap::CancellationToken &cancelToken) {
+    utymap::utils::Metrics::Timer timer(utymap::utils::Metrics::Latency::TileBuild);
+    TRACE_ZONE("build", quadKey);
+    ALLOCATION_SCOPE(Build);
+    auto start = std::chrono::steady_clock::now();
+    // NOTE callbacks might be called by builders from worker threads.
+    std::atomic<std::chrono::steady_clock::rep> callbackTime(0);
+    auto measureCallback = [&callbackTime](std::chrono::steady_clock::time_point callbackStart) {
+      callbackTime.fetch_add((std::chrono::steady_clock::now() - callbackStart).count(), std::memory_order_relaxed);
+    };
+    auto bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    double maxError = styleProvider.forCanvas(quadKey.levelOfDetail)
+        .getValue(StyleConsts::SimplificationErrorKey(), bbox);
+    // NOTE error is in degrees of latitude, so longitudes and heights are scaled accordingly.
+    Vector3 scale(std::cos(utymap::utils::deg2Rad(bbox.center().latitude)), 1,
+                  utymap::utils::GeoUtils::getOffset(bbox.center(), 1));
+
+    auto notifyMesh = [&](const Mesh &mesh) {
+      utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::MeshesBuilt);
+      utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::MeshVertices, mesh.vertices.size() / 3);
+      ALLOCATION_SCOPE(Callback);
+      auto callbackStart = std::chrono::steady_clock::now();
+      meshCallback(mesh);
+      measureCallback(callbackStart);
+    };
+    auto notifyElement = [&](const Element &element) {
+      ALLOCATION_SCOPE(Callback);
+      auto callbackStart = std::chrono::steady_clock::now();
+      elementCallback(element);
+      measureCallback(callbackStart);
+    };
+    auto processCallback = [&](const Mesh &mesh) {
+      // NOTE instances of prototype have no triangles, so they are passed as is.
+      if ((!weldMeshes_ && maxError <= 0) || mesh.triangles.empty()) {
+        notifyMesh(mesh);
+        return;
+      }
+      auto welded = meshPool.get(mesh.name, mesh.vertices.size()/3);
+      if (weldMeshes_)
+        utymap::utils::weldMesh(mesh, welded);
+      const Mesh &source = weldMeshes_ ? welded : mesh;
+      if (maxError > 0) {
+        auto simplified = meshPool.get(mesh.name, source.vertices.size()/3);
+        getSimplifier().simplify(source, simplified, maxError, scale);
+        notifyMesh(simplified);
+        meshPool.release(std::move(simplified));
+      } else
+        notifyMesh(source);
+      meshPool.release(std::move(welded));
+    };
     auto context = BuilderContext(quadKey, styleProvider, stringTable_,
-                                  meshPool_, eleProvider, meshCallback,
-                                  elementCallback, cancelToken);
-    auto visitor = BuilderElementVisitor(context, builderFactory_);
-    geoStore_.search(quadKey, styleProvider, visitor, cancelToken);
-    visitor.complete();
+                                  meshPool, eleProvider, processCallback,
+                                  notifyElement, cancelToken, threadPool_.get(), eleCacheResolution_);
+    context.useInstancing = instancing_;
+    context.batchVertexLimit = batchVertexLimit_;
+    BuilderElementVisitor visitor(context, builderFactory_, parallelBuilders_ ? &builderMeshPools_ : nullptr,
+                                  progressiveOrder_);
+    auto searchTime = std::chrono::steady_clock::duration::zero();
+    {
+      TRACE_ZONE("search", quadKey);
+      ALLOCATION_SCOPE(Search);
+      auto searchStart = std::chrono::steady_clock::now();
+      geoStore_.search(quadKey, styleProvider, visitor, cancelToken);
+      searchTime = std::chrono::steady_clock::now() - searchStart;
+    }
+    {
+      TRACE_ZONE("complete", quadKey);
+      visitor.complete();
+    }
+    recordStages(std::chrono::steady_clock::now() - start, searchTime - visitor.getVisitTime(), visitor.getStyleTime(),
+                 std::chrono::steady_clock::duration(callbackTime.load()));
+  }
+
+  MeshPool &getMeshPool() {
+    return meshPool_;
   }
 
  private:
+  /// Records time split of tile build. Search excludes visiting of found elements, style
+  /// includes matching of visited elements only and mesh stage takes the rest.
+  static void recordStages(std::chrono::steady_clock::duration total,
+                           std::chrono::steady_clock::duration search,
+                           std::chrono::steady_clock::duration style,
+                           std::chrono::steady_clock::duration callback) {
+    using utymap::utils::Metrics;
+    auto zero = std::chrono::steady_clock::duration::zero();
+    search = std::max(search, zero);
+    Metrics::record(Metrics::Latency::TileSearch, search);
+    Metrics::record(Metrics::Latency::TileStyle, style);
+    Metrics::record(Metrics::Latency::TileMesh, std::max(total - search - style - callback, zero));
+    Metrics::record(Metrics::Latency::TileCallback, callback);
+  }
+
   GeoStore &geoStore_;
   StringTable &stringTable_;
   MeshPool meshPool_;
   BuilderFactoryMap builderFactory_;
+  utymap::utils::ThreadPoolShare threadPool_;
+  /// Mesh pools leased by builders run as separate tasks.
+  MeshPoolSet builderMeshPools_;
+  bool weldMeshes_;
+  bool parallelBuilders_;
+  bool instancing_;
+  /// Names of builders in order of progressive delivery.
+  std::vector<std::string> progressiveOrder_;
+  std::size_t batchVertexLimit_;
+  int eleCacheResolution_;
 };
 
 void QuadKeyBuilder::registerElementBuilder(const std::string &name, ElementBuilderFactory factory) {
   pimpl_->registerElementVisitor(name, factory);
 }
 
+void QuadKeyBuilder::setBuildThreads(std::size_t threadCount) {
+  pimpl_->setBuildThreads(threadCount);
+}
+
+void QuadKeyBuilder::setMeshWelding(bool enabled) {
+  pimpl_->setMeshWelding(enabled);
+}
+
+void QuadKeyBuilder::setParallelBuilders(bool enabled) {
+  pimpl_->setParallelBuilders(enabled);
+}
+
+void QuadKeyBuilder::setInstancing(bool enabled) {
+  pimpl_->setInstancing(enabled);
+}
+
+void QuadKeyBuilder::setProgressiveOrder(const std::vector<std::string> &builderNames) {
+  pimpl_->setProgressiveOrder(builderNames);
+}
+
+void QuadKeyBuilder::setBatchVertexLimit(std::size_t vertexLimit) {
+  pimpl_->setBatchVertexLimit(vertexLimit);
+}
+
+void QuadKeyBuilder::setElevationCacheResolution(int resolution) {
+  pimpl_->setElevationCacheResolution(resolution);
+}
+
+void QuadKeyBuilder::build(const QuadKey &quadKey,
+                           const StyleProvider &styleProvider,
+                           const ElevationProvider &eleProvider,
+                           const BuilderContext::MeshCallback &meshCallback,
+                           const BuilderContext::ElementCallback &elementCallback,
+                           const utymap::CancellationToken &cancelToken) {
+  pimpl_->build(quadKey, styleProvider, eleProvider, pimpl_->getMeshPool(), meshCallback, elementCallback, cancelToken);
+}
+
 void QuadKeyBuilder::build(const QuadKey &quadKey,
                            const StyleProvider &styleProvider,
                            const ElevationProvider &eleProvider,
+                           MeshPool &meshPool,
                            const BuilderContext::MeshCallback &meshCallback,
                            const BuilderContext::ElementCallback &elementCallback,
                            const utymap::CancellationToken &cancelToken) {
-  pimpl_->build(quadKey, styleProvider, eleProvider, meshCallback, elementCallback, cancelToken);
+  pimpl_->build(quadKey, styleProvider, eleProvider, meshPool, meshCallback, elementCallback, cancelToken);
 }
 
-QuadKeyBuilder::QuadKeyBuilder(GeoStore &geoStore, StringTable &stringTable) :
-    pimpl_(utymap::utils::make_unique<QuadKeyBuilderImpl>(geoStore, stringTable)) {}
+QuadKeyBuilder::QuadKeyBuilder(GeoStore &geoStore, StringTable &stringTable, utymap::utils::ThreadPool *threadPool) :
+    pimpl_(utymap::utils::make_unique<QuadKeyBuilderImpl>(geoStore, stringTable, threadPool)) {}
 
 QuadKeyBuilder::~QuadKeyBuilder() {}
@@ -11,29 +11,77 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace utymap {
 namespace builders {
 
 /// Responsible for building single quadkey.
+/// NOTE build is thread safe, so different quadkeys can be built concurrently when registered
+/// element builders are thread safe. Registration and settings are not: they should be done
+/// before building.
 class QuadKeyBuilder final {
  public:
   /// Factory of element builders
   typedef std::function<std::unique_ptr<utymap::builders::ElementBuilder>(const utymap::builders::BuilderContext &)>
       ElementBuilderFactory;
 
+  /// Creates builder which runs parallel tasks on given pool. Without pool, own threads are used.
   QuadKeyBuilder(utymap::index::GeoStore &geoStore,
-                 utymap::index::StringTable &stringTable);
+                 utymap::index::StringTable &stringTable,
+                 utymap::utils::ThreadPool *threadPool = nullptr);
 
   ~QuadKeyBuilder();
 
   /// Registers factory method for element builder.
   void registerElementBuilder(const std::string &name, ElementBuilderFactory factory);
 
+  /// Sets amount of tasks used to mesh terrain regions of tile concurrently.
+  /// Zero means that tile is built on calling thread only.
+  void setBuildThreads(std::size_t threadCount);
+
+  /// Enables merging of vertices with the same attributes in meshes passed to mesh callback.
+  void setMeshWelding(bool enabled);
+
+  /// Enables running each element builder of tile as separate task on build threads. Elements are
+  /// partitioned by builder during store scan and output of builders is delivered in order of
+  /// their first use. Has no effect if build threads are not set.
+  void setParallelBuilders(bool enabled);
+
+  /// Enables progressive delivery: builders complete in given order of their names, e.g. terrain
+  /// before buildings, and with parallel builders output of every builder is delivered as soon as
+  /// it and builders before it are finished. Builders which are not listed go last in order of
+  /// first use. Empty list disables it.
+  void setProgressiveOrder(const std::vector<std::string> &builderNames);
+
+  /// Enables emitting meshes repeated by builders, such as trees or lamps, once as prototype
+  /// followed by their instances. See MeshInstancer for output format.
+  void setInstancing(bool enabled);
+
+  /// Enables merging of building meshes of tile which use the same textures into meshes with
+  /// given max amount of vertices, e.g. 65535 for 16 bit indices. Zero disables merging.
+  void setBatchVertexLimit(std::size_t vertexLimit);
+
+  /// Sets amount of cells along tile side of grid which caches elevation during tile build.
+  /// Zero disables the cache, so builders query elevation provider directly.
+  void setElevationCacheResolution(int resolution);
+
   /// Builds tile for given quadkey.
+  /// NOTE meshes are simplified when canvas style specifies simplification error. Only shared
+  /// vertices are collapsed, so it is more effective with mesh welding enabled.
+  void build(const utymap::QuadKey &quadKey,
+             const utymap::mapcss::StyleProvider &styleProvider,
+             const utymap::heightmap::ElevationProvider &eleProvider,
+             const utymap::builders::BuilderContext::MeshCallback &meshCallback,
+             const utymap::builders::BuilderContext::ElementCallback &elementCallback,
+             const utymap::CancellationToken &cancelToken);
+
+  /// Builds tile for given quadkey using given mesh pool instead of shared one, so concurrent
+  /// builds do not contend for meshes.
   void build(const utymap::QuadKey &quadKey,
              const utymap::mapcss::StyleProvider &styleProvider,
              const utymap::heightmap::ElevationProvider &eleProvider,
+             utymap::builders::MeshPool &meshPool,
              const utymap::builders::BuilderContext::MeshCallback &meshCallback,
              const utymap::builders::BuilderContext::ElementCallback &elementCallback,
              const utymap::CancellationToken &cancelToken);
@@ -0,0 +1,96 @@
+#include "builders/MeshPool.hpp"
+#include "builders/TileBuildScheduler.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <mutex>
+
+using namespace utymap;
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::heightmap;
+using namespace utymap::mapcss;
+using namespace utymap::math;
+
+class TileBuildScheduler::TileBuildSchedulerImpl {
+ public:
+  TileBuildSchedulerImpl(QuadKeyBuilder &quadKeyBuilder, std::size_t threadCount) :
+      quadKeyBuilder_(quadKeyBuilder),
+      threadPool_(std::max<std::size_t>(threadCount, 1)) {
+  }
+
+  std::size_t size() const {
+    return threadPool_.size();
+  }
+
+  void build(const std::vector<QuadKey> &quadKeys,
+             const StyleProvider &styleProvider,
+             const ElevationProvider &eleProvider,
+             const MeshCallback &meshCallback,
+             const ElementCallback &elementCallback,
+             const utymap::CancellationToken &cancelToken) {
+    std::vector<utymap::utils::ThreadPool::Future> futures;
+    futures.reserve(quadKeys.size());
+    for (const auto &quadKey : quadKeys) {
+      futures.push_back(threadPool_.enqueue([&, quadKey]() {
+        if (cancelToken.isCancelled())
+          return;
+
+        auto meshPool = meshPools_.lease();
+        quadKeyBuilder_.build(quadKey, styleProvider, eleProvider, meshPool->get(),
+          [&](const Mesh &mesh) {
+            std::lock_guard<std::mutex> lock(callbackLock_);
+            meshCallback(quadKey, mesh);
+          },
+          [&](const Element &element) {
+            std::lock_guard<std::mutex> lock(callbackLock_);
+            elementCallback(quadKey, element);
+          },
+          cancelToken);
+      }));
+    }
+
+    // NOTE tasks refer to arguments, so all of them should finish before leaving.
+    std::exception_ptr error;
+    for (auto &future : futures) {
+      try {
+        future.get();
+      } catch (...) {
+        if (error==nullptr)
+          error = std::current_exception();
+      }
+    }
+
+    if (error!=nullptr)
+      std::rethrow_exception(error);
+  }
+
+ private:
+  QuadKeyBuilder &quadKeyBuilder_;
+  /// NOTE amount of pools doesn't exceed amount of workers.
+  MeshPoolSet meshPools_;
+  std::mutex callbackLock_;
+  /// NOTE declared last, so workers are stopped before pools are destroyed.
+  utymap::utils::ThreadPool threadPool_;
+};
+
+TileBuildScheduler::TileBuildScheduler(QuadKeyBuilder &quadKeyBuilder, std::size_t threadCount) :
+    pimpl_(utymap::utils::make_unique<TileBuildSchedulerImpl>(quadKeyBuilder, threadCount)) {}
+
+TileBuildScheduler::~TileBuildScheduler() {}
+
+std::size_t TileBuildScheduler::size() const {
+  return pimpl_->size();
+}
+
+void TileBuildScheduler::build(const std::vector<QuadKey> &quadKeys,
+                               const StyleProvider &styleProvider,
+                               const ElevationProvider &eleProvider,
+                               const MeshCallback &meshCallback,
+                               const ElementCallback &elementCallback,
+                               const utymap::CancellationToken &cancelToken) {
+  pimpl_->build(quadKeys, styleProvider, eleProvider, meshCallback, elementCallback, cancelToken);
+}
@@ -0,0 +1,57 @@
+#ifndef BUILDERS_TILEBUILDSCHEDULER_HPP_DEFINED
+#define BUILDERS_TILEBUILDSCHEDULER_HPP_DEFINED
+
+#include "CancellationToken.hpp"
+#include "QuadKey.hpp"
+#include "builders/QuadKeyBuilder.hpp"
+#include "entities/Element.hpp"
+#include "heightmap/ElevationProvider.hpp"
+#include "mapcss/StyleProvider.hpp"
+#include "math/Mesh.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace utymap {
+namespace builders {
+
+/// Builds many tiles concurrently on fixed amount of worker threads. Every worker uses its own
+/// mesh pool, so tiles built at the same time do not contend for meshes.
+/// NOTE callbacks are called from worker threads, but never at the same time.
+class TileBuildScheduler final {
+ public:
+  /// Called when mesh of given tile is built.
+  typedef std::function<void(const utymap::QuadKey &, const utymap::math::Mesh &)> MeshCallback;
+  /// Called when element of given tile should be processed by external logic.
+  typedef std::function<void(const utymap::QuadKey &, const utymap::entities::Element &)> ElementCallback;
+
+  TileBuildScheduler(QuadKeyBuilder &quadKeyBuilder, std::size_t threadCount);
+
+  ~TileBuildScheduler();
+
+  TileBuildScheduler(const TileBuildScheduler &) = delete;
+  TileBuildScheduler &operator=(const TileBuildScheduler &) = delete;
+
+  /// Returns amount of worker threads.
+  std::size_t size() const;
+
+  /// Builds given tiles and waits until all of them are built. Tiles which are not started
+  /// before cancellation are skipped.
+  /// NOTE first error is rethrown once all tiles are processed.
+  void build(const std::vector<utymap::QuadKey> &quadKeys,
+             const utymap::mapcss::StyleProvider &styleProvider,
+             const utymap::heightmap::ElevationProvider &eleProvider,
+             const MeshCallback &meshCallback,
+             const ElementCallback &elementCallback,
+             const utymap::CancellationToken &cancelToken);
+
+ private:
+  class TileBuildSchedulerImpl;
+  std::unique_ptr<TileBuildSchedulerImpl> pimpl_;
+};
+
+}
+}
+
+#endif // BUILDERS_TILEBUILDSCHEDULER_HPP_DEFINED
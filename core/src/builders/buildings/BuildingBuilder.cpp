@@ -14,6 +14,13 @@
 #include "builders/buildings/roofs/MansardRoofBuilder.hpp"
 #include "builders/buildings/roofs/SkillionRoofBuilder.hpp"
 #include "builders/buildings/roofs/RoundRoofBuilder.hpp"
+#include "utils/ElementUtils.hpp"
+#include "utils/MeshUtils.hpp"
+
+#include <array>
+#include <map>
+#include <set>
+#include <unordered_map>
 
 using namespace utymap;
 using namespace utymap::builders;
@@ -26,6 +33,9 @@ using namespace utymap::utils;
 
 namespace {
 const std::string MeshNamePrefix = "building:";
+/// Estimated amount of mesh vertices per footprint point.
+const std::size_t VerticesPerPoint = 8;
+const std::string BatchNamePrefix = "buildings:";
 
 const std::string RoofPrefix = "roof-";
 const std::string RoofTypeKey = RoofPrefix + StyleConsts::TypeKey();
@@ -121,6 +131,78 @@ std::unordered_map<std::string, FacadeBuilderFactory> FacadeBuilderFactoryMap =
         }
     };
 
+/// Caches values resolved from style by declarations of given keys, so buildings which
+/// share these declarations resolve them once per tile.
+/// NOTE value which depends on evaluated declaration is resolved for every style.
+template<typename Value, std::size_t Size>
+class StyleCache final {
+ public:
+  StyleCache(StringTable &stringTable, const std::array<std::string, Size> &keys) {
+    for (std::size_t i = 0; i < Size; ++i)
+      keyIds_[i] = stringTable.getId(keys[i]);
+  }
+
+  template<typename Resolver>
+  const Value &get(const Style &style, const Resolver &resolve) {
+    Key key;
+    bool isEval = false;
+    for (std::size_t i = 0; i < Size; ++i) {
+      key[i] = style.has(keyIds_[i]) ? &style.get(keyIds_[i]) : nullptr;
+      isEval |= key[i]!=nullptr && key[i]->isEval();
+    }
+
+    if (isEval) {
+      evaluated_ = resolve(style);
+      return evaluated_;
+    }
+
+    auto it = values_.find(key);
+    if (it==values_.end())
+      it = values_.emplace(key, resolve(style)).first;
+    return it->second;
+  }
+
+  void clear() {
+    values_.clear();
+  }
+
+ private:
+  typedef std::array<const StyleDeclaration *, Size> Key;
+
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      std::size_t hash = 0;
+      for (const auto *declaration : key)
+        hash = hash*31 + std::hash<const StyleDeclaration *>()(declaration);
+      return hash;
+    }
+  };
+
+  std::array<std::uint32_t, Size> keyIds_;
+  std::unordered_map<Key, Value, KeyHash> values_;
+  Value evaluated_;
+};
+
+/// Appearance of building part resolved from style.
+struct PartStyle {
+  const ColorGradient *gradient = nullptr;
+  const TextureGroup *textures = nullptr;
+  std::uint16_t textureId = 0;
+  double textureScale = 0;
+};
+
+struct RoofStyle {
+  PartStyle part;
+  const RoofBuilderFactory *factory = nullptr;
+  double height = 0;
+  std::string direction;
+};
+
+struct FacadeStyle {
+  PartStyle part;
+  const FacadeBuilderFactory *factory = nullptr;
+};
+
 /// Creates points for polygon
 std::vector<Vector2> toPoints(const std::vector<GeoCoordinate> &coordinates) {
   std::vector<Vector2> points;
@@ -180,13 +262,27 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder {
  public:
   explicit BuildingBuilderImpl(const utymap::builders::BuilderContext &context) :
       ElementBuilder(context),
-      id_(0) {
+      id_(0),
+      roofStyles_(context.stringTable, {RoofTypeKey, RoofHeightKey, RoofDirectionKey, RoofGradientKey,
+                                        RoofTextureIndexKey, RoofTextureTypeKey, RoofTextureScaleKey}),
+      facadeStyles_(context.stringTable, {FacadeTypeKey, FacadeGradientKey, FacadeTextureIndexKey,
+                                          FacadeTextureTypeKey, FacadeTextureScaleKey}) {
   }
 
   void visitNode(const Node &) override {}
 
   void visitWay(const Way &) override {}
 
+  void complete() override {
+    for (auto &batch : batches_) {
+      flush(batch.second);
+      context_.meshPool.release(std::move(batch.second.mesh));
+    }
+    batches_.clear();
+    roofStyles_.clear();
+    facadeStyles_.clear();
+  }
+
   void visitArea(const Area &area) override {
     Style style = context_.styleProvider.forElement(area, context_.quadKey.levelOfDetail);
 
@@ -231,7 +327,8 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder {
       polygon_ = utymap::utils::make_unique<Polygon>(1, 0);
 
     if (mesh_==nullptr) {
-      auto mesh = context_.meshPool.getSmall(utymap::utils::getMeshName(MeshNamePrefix, element));
+      auto vertexCount = VerticesPerPoint * utymap::utils::countVertices(element);
+      auto mesh = context_.meshPool.get(utymap::utils::getMeshName(MeshNamePrefix, element), vertexCount);
       mesh_ = std::unique_ptr<Mesh>(new Mesh(std::move(mesh)));
       id_ = element.id;
       return true;
@@ -242,16 +339,80 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder {
 
   void completeIfNecessary(bool justCreated) {
     if (justCreated) {
-      context_.meshCallback(*mesh_);
+      if (context_.batchVertexLimit > 0)
+        addToBatch(*mesh_);
+      else
+        context_.meshCallback(*mesh_);
       context_.meshPool.release(std::move(*mesh_));
       mesh_.reset();
     }
   }
 
+  /// Merged meshes of buildings which use the same textures.
+  struct Batch {
+    explicit Batch(Mesh &&mesh) : mesh(std::move(mesh)) {}
+    Mesh mesh;
+    /// Building ids with index of their first triangle.
+    std::string ranges;
+  };
+
+  /// Merges mesh into batch of meshes with the same textures.
+  void addToBatch(const Mesh &mesh) {
+    std::size_t vertexCount = mesh.vertices.size()/3;
+    if (vertexCount==0)
+      return;
+    // NOTE mesh which doesn't fit into batch alone is passed as is.
+    if (vertexCount > context_.batchVertexLimit) {
+      context_.meshCallback(mesh);
+      return;
+    }
+
+    auto key = getTextureKey(mesh);
+    auto it = batches_.find(key);
+    if (it==batches_.end())
+      it = batches_.emplace(key, Batch(context_.meshPool.getLarge(""))).first;
+    else if (it->second.mesh.vertices.size()/3 + vertexCount > context_.batchVertexLimit)
+      flush(it->second);
+
+    auto &batch = it->second;
+    batch.ranges += (batch.ranges.empty() ? "" : ",") + utymap::utils::toString(id_) + "-" +
+        utymap::utils::toString(batch.mesh.triangles.size()/3);
+    utymap::utils::copyMesh(Vector3(0, 0, 0), mesh, batch.mesh);
+  }
+
+  /// Passes batch to mesh callback and clears it.
+  /// NOTE name lists ids of merged buildings with index of their first triangle, e.g.
+  /// "buildings:1-0,2-12", so buildings can be picked by triangle index.
+  void flush(Batch &batch) {
+    if (!batch.mesh.vertices.empty()) {
+      batch.mesh.name = BatchNamePrefix + batch.ranges;
+      context_.meshCallback(batch.mesh);
+    }
+    batch.mesh.clear();
+    batch.ranges.clear();
+  }
+
+  /// Gets key of textures used by mesh: meshes with the same key can share material.
+  static std::string getTextureKey(const Mesh &mesh) {
+    std::set<int> textureIds;
+    for (std::size_t i = 1; i < mesh.uvMap.size(); i += 8)
+      textureIds.insert(mesh.uvMap[i]);
+
+    std::string key;
+    for (auto textureId : textureIds)
+      key += utymap::utils::toString(textureId) + ",";
+    return key;
+  }
+
   static bool isBuilding(const Style &style) {
     return style.getString("building")=="true";
   }
 
+  /// Checks whether building should be built as extruded footprint only.
+  static bool isImpostor(const Style &style) {
+    return style.getString("impostor")=="true";
+  }
+
   static bool isMultipolygon(const Style &style) {
     return style.getString("multipolygon")=="true";
   }
@@ -270,6 +431,12 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder {
 
     height -= minHeight;
 
+    if (isImpostor(style)) {
+      attachImpostor(*mesh_, style, elevation, height);
+      polygon_.reset();
+      return;
+    }
+
     attachRoof(*mesh_, style, elevation, height);
 
     // NOTE so far, attach floors only for buildings with minHeight
@@ -281,39 +448,39 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder {
     polygon_.reset();
   }
 
-  void attachRoof(Mesh &mesh, const Style &style, double elevation, double height) const {
-    MeshContext roofMeshContext = MeshContext::create(mesh,
-                                                      style,
-                                                      context_.styleProvider,
-                                                      RoofGradientKey,
-                                                      RoofTextureIndexKey,
-                                                      RoofTextureTypeKey,
-                                                      RoofTextureScaleKey,
-                                                      id_);
-
-    auto roofType = roofMeshContext.style.getString(RoofTypeKey);
-    double roofHeight = roofMeshContext.style.getValue(RoofHeightKey);
-    auto direction = roofMeshContext.style.getString(RoofDirectionKey);
-
-    auto roofBuilder = RoofBuilderFactoryMap.find(roofType)->second(context_, roofMeshContext);
-    roofBuilder->setHeight(roofHeight);
+  /// Builds walls and flat top using facade appearance only. Roof and floors are not built.
+  void attachImpostor(Mesh &mesh, const Style &style, double elevation, double height) {
+    MeshContext meshContext = createMeshContext(mesh, style, getFacadeStyle(style).part);
+
+    FlatFacadeBuilder facadeBuilder(context_, meshContext);
+    facadeBuilder.setHeight(height);
+    facadeBuilder.setMinHeight(elevation);
+    facadeBuilder.setColorNoiseFreq(0);
+    facadeBuilder.build(*polygon_);
+
+    FlatRoofBuilder topBuilder(context_, meshContext);
+    topBuilder.setMinHeight(elevation + height);
+    topBuilder.build(*polygon_);
+
+    context_.meshBuilder.writeTextureMappingInfo(mesh, meshContext.appearanceOptions);
+  }
+
+  void attachRoof(Mesh &mesh, const Style &style, double elevation, double height) {
+    const auto &roofStyle = getRoofStyle(style);
+    MeshContext roofMeshContext = createMeshContext(mesh, style, roofStyle.part);
+
+    auto roofBuilder = (*roofStyle.factory)(context_, roofMeshContext);
+    roofBuilder->setHeight(roofStyle.height);
     roofBuilder->setMinHeight(elevation + height);
     roofBuilder->setColorNoiseFreq(0);
-    roofBuilder->setDirection(direction);
+    roofBuilder->setDirection(roofStyle.direction);
     roofBuilder->build(*polygon_);
 
     context_.meshBuilder.writeTextureMappingInfo(mesh, roofMeshContext.appearanceOptions);
   }
 
-  void attachFloors(Mesh &mesh, const Style &style, double elevation, double height) const {
-    MeshContext floorMeshContext = MeshContext::create(mesh,
-                                                       style,
-                                                       context_.styleProvider,
-                                                       RoofGradientKey,
-                                                       RoofTextureIndexKey,
-                                                       RoofTextureTypeKey,
-                                                       RoofTextureScaleKey,
-                                                       id_);
+  void attachFloors(Mesh &mesh, const Style &style, double elevation, double height) {
+    MeshContext floorMeshContext = createMeshContext(mesh, style, getRoofStyle(style).part);
 
     FlatRoofBuilder floorBuilder(context_, floorMeshContext);
     floorBuilder.setMinHeight(elevation);
@@ -324,19 +491,11 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder {
     context_.meshBuilder.writeTextureMappingInfo(mesh, floorMeshContext.appearanceOptions);
   }
 
-  void attachFacade(Mesh &mesh, const Style &style, double elevation, double height) const {
-    MeshContext facadeMeshContext = MeshContext::create(mesh,
-                                                        style,
-                                                        context_.styleProvider,
-                                                        FacadeGradientKey,
-                                                        FacadeTextureIndexKey,
-                                                        FacadeTextureTypeKey,
-                                                        FacadeTextureScaleKey,
-                                                        id_);
-
-    auto facadeType = facadeMeshContext.style.getString(FacadeTypeKey);
-    auto facadeBuilder = FacadeBuilderFactoryMap.find(facadeType)->second(context_, facadeMeshContext);
+  void attachFacade(Mesh &mesh, const Style &style, double elevation, double height) {
+    const auto &facadeStyle = getFacadeStyle(style);
+    MeshContext facadeMeshContext = createMeshContext(mesh, style, facadeStyle.part);
 
+    auto facadeBuilder = (*facadeStyle.factory)(context_, facadeMeshContext);
     facadeBuilder->setHeight(height);
     facadeBuilder->setMinHeight(elevation);
     facadeBuilder->setColorNoiseFreq(0);
@@ -345,9 +504,55 @@ class BuildingBuilder::BuildingBuilderImpl : public ElementBuilder {
     context_.meshBuilder.writeTextureMappingInfo(mesh, facadeMeshContext.appearanceOptions);
   }
 
+  /// Creates mesh context with resolved appearance. Texture region is picked by building id.
+  MeshContext createMeshContext(Mesh &mesh, const Style &style, const PartStyle &part) const {
+    MeshContext meshContext(mesh, style, *part.gradient, part.textures->random(id_));
+    meshContext.appearanceOptions.textureId = part.textureId;
+    meshContext.appearanceOptions.textureScale = part.textureScale;
+    return std::move(meshContext);
+  }
+
+  PartStyle resolvePart(const Style &style,
+                        const std::string &gradientKey,
+                        const std::string &textureIndexKey,
+                        const std::string &textureTypeKey,
+                        const std::string &textureScaleKey) const {
+    PartStyle part;
+    part.textureId = static_cast<std::uint16_t>(style.getValue(textureIndexKey));
+    part.gradient = &GradientUtils::evaluateGradient(context_.styleProvider, style, gradientKey);
+    part.textures = &context_.styleProvider.getTexture(part.textureId, style.getString(textureTypeKey));
+    part.textureScale = style.getValue(textureScaleKey);
+    return part;
+  }
+
+  const RoofStyle &getRoofStyle(const Style &style) {
+    return roofStyles_.get(style, [&](const Style &s) {
+      RoofStyle roofStyle;
+      roofStyle.part = resolvePart(s, RoofGradientKey, RoofTextureIndexKey, RoofTextureTypeKey, RoofTextureScaleKey);
+      roofStyle.factory = &RoofBuilderFactoryMap.find(s.getString(RoofTypeKey))->second;
+      roofStyle.height = s.getValue(RoofHeightKey);
+      roofStyle.direction = s.getString(RoofDirectionKey);
+      return roofStyle;
+    });
+  }
+
+  const FacadeStyle &getFacadeStyle(const Style &style) {
+    return facadeStyles_.get(style, [&](const Style &s) {
+      FacadeStyle facadeStyle;
+      facadeStyle.part = resolvePart(s, FacadeGradientKey, FacadeTextureIndexKey, FacadeTextureTypeKey,
+                                     FacadeTextureScaleKey);
+      facadeStyle.factory = &FacadeBuilderFactoryMap.find(s.getString(FacadeTypeKey))->second;
+      return facadeStyle;
+    });
+  }
+
   std::unique_ptr<Polygon> polygon_;
   std::unique_ptr<Mesh> mesh_;
   std::uint64_t id_;
+  std::map<std::string, Batch> batches_;
+  /// Resolved roof and facade parameters of styles seen in current tile.
+  StyleCache<RoofStyle, 7> roofStyles_;
+  StyleCache<FacadeStyle, 5> facadeStyles_;
 };
 
 BuildingBuilder::BuildingBuilder(const BuilderContext &context)
@@ -356,6 +561,10 @@ BuildingBuilder::BuildingBuilder(const BuilderContext &context)
 
 BuildingBuilder::~BuildingBuilder() {}
 
+void BuildingBuilder::complete() {
+  pimpl_->complete();
+}
+
 void BuildingBuilder::visitArea(const Area &area) {
   if (!shouldBeIgnored(area))
     area.accept(*pimpl_);
@@ -24,6 +24,9 @@ class BuildingBuilder final : public utymap::builders::ElementBuilder {
 
   void visitRelation(const utymap::entities::Relation &) override;
 
+  /// Passes merged meshes when batching is enabled by builder context.
+  void complete() override;
+
  private:
   class BuildingBuilderImpl;
   std::unique_ptr<BuildingBuilderImpl> pimpl_;
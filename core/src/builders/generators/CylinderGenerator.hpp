@@ -3,8 +3,15 @@
 
 #include "builders/generators/AbstractGenerator.hpp"
 #include "math/Quaternion.hpp"
+#include "utils/CoreUtils.hpp"
 #include "utils/MathUtils.hpp"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace utymap {
 namespace builders {
 
@@ -60,24 +67,29 @@ class CylinderGenerator : public AbstractGenerator {
   void generate() override {
     int heightSegments = maxSegmentHeight_!=0 ? static_cast<int>(std::ceil(size1_.y/maxSegmentHeight_)) : 1;
     double heightStep = size1_.y/heightSegments;
-    double angleStep = 2*pi/radialSegments_;
+    const auto &rotations = getRotations(radialSegments_);
+
+    // NOTE ring directions are shared by all height segments.
+    ring_.resize(radialSegments_);
+    for (int j = 0; j < radialSegments_; ++j)
+      ring_[j] = utymap::math::Quaternion(direction_*rotations[j].first, rotations[j].second)*right_;
+
+    // NOTE vertex is shared by neighbour segments, so it is moved to position only once.
+    vertices_.resize(static_cast<std::size_t>((heightSegments + 1)*radialSegments_));
+    for (int i = 0; i <= heightSegments; ++i) {
+      auto radius = getRadius(static_cast<double>(heightSegments - i)/heightSegments);
+      auto center = center_ + direction_*(heightStep*i);
+      for (int j = 0; j < radialSegments_; ++j)
+        vertices_[i*radialSegments_ + j] = translate(center + scale(ring_[j], radius));
+    }
 
     for (int j = 0; j < radialSegments_; ++j) {
-      auto direction1 = utymap::math::Quaternion::fromAngleAxis(j*angleStep, direction_);
-      auto direction2 =
-          utymap::math::Quaternion::fromAngleAxis((j==radialSegments_ - 1 ? 0 : j + 1)*angleStep, direction_);
-
+      int next = j==radialSegments_ - 1 ? 0 : j + 1;
       for (int i = 0; i < heightSegments; i++) {
-        auto radius1 = getRadius(static_cast<double>(heightSegments - i)/heightSegments);
-        auto radius2 = getRadius(static_cast<double>(heightSegments - i - 1)/heightSegments);
-
-        auto center1 = center_ + direction_*(heightStep*i);
-        auto center2 = center_ + direction_*(heightStep*(i + 1));
-
-        auto v0 = translate(center1 + scale(direction1*right_, radius1));
-        auto v1 = translate(center1 + scale(direction2*right_, radius1));
-        auto v2 = translate(center2 + scale(direction2*right_, radius2));
-        auto v3 = translate(center2 + scale(direction1*right_, radius2));
+        const auto &v0 = vertices_[i*radialSegments_ + j];
+        const auto &v1 = vertices_[i*radialSegments_ + next];
+        const auto &v2 = vertices_[(i + 1)*radialSegments_ + next];
+        const auto &v3 = vertices_[(i + 1)*radialSegments_ + j];
 
         // add side.
         addTriangle(v1, v2, v0);
@@ -85,15 +97,32 @@ class CylinderGenerator : public AbstractGenerator {
 
         // add bottom cap part.
         if (i==0)
-          addTriangle(translate(center1), v1, v0);
+          addTriangle(translate(center_), v1, v0);
         // add top cap part.
         if (i==heightSegments - 1 && !isCone())
-          addTriangle(translate(center2), v3, v2);
+          addTriangle(translate(center_ + direction_*(heightStep*(i + 1))), v3, v2);
       }
     }
   }
 
  private:
+  /// Gets sine and cosine of half angle of every radial segment. They are calculated once per process.
+  static const std::vector<std::pair<double, double>> &getRotations(int radialSegments) {
+    static std::mutex lock;
+    static std::map<int, std::unique_ptr<std::vector<std::pair<double, double>>>> rotations;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto &result = rotations[radialSegments];
+    if (result==nullptr) {
+      double angleStep = 2*pi/radialSegments;
+      result = utymap::utils::make_unique<std::vector<std::pair<double, double>>>();
+      for (int j = 0; j < radialSegments; ++j) {
+        double halfAngle = j*angleStep*0.5;
+        result->emplace_back(std::sin(halfAngle), std::cos(halfAngle));
+      }
+    }
+    return *result;
+  }
 
   bool isCone() const {
     return size2_==utymap::math::Vector3::zero();
@@ -117,7 +146,10 @@ class CylinderGenerator : public AbstractGenerator {
   utymap::math::Vector3 size2_ = utymap::math::Vector3::zero();
   double maxSegmentHeight_ = 0;
   int radialSegments_ = 5;
-
+  /// Rotated right vectors of current cylinder.
+  std::vector<utymap::math::Vector3> ring_;
+  /// Vertices of current cylinder moved to its position.
+  std::vector<utymap::math::Vector3> vertices_;
 };
 
 }
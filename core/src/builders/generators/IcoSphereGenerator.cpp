@@ -1,4 +1,10 @@
 #include "builders/generators/IcoSphereGenerator.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 using namespace utymap::builders;
 using namespace utymap::math;
@@ -84,69 +90,112 @@ const std::vector<TriangleIndices> &getSemiSphereFaces() {
 
   return faces;
 }
-}
 
-void IcoSphereGenerator::generate() {
-  vertexList_ = createVertexList();
-  const auto &faces = isSemiSphere_ ? getSemiSphereFaces() : getSphereFaces();
-
-  // refine triangles
-  std::vector<TriangleIndices> meshFaces;
-  for (int i = 0; i < recursionLevel_; i++) {
-    std::vector<TriangleIndices> faces2;
-    faces2.reserve(faces.size()*4);
-    for (const auto &tri : faces) {
-      // replace triangle by 4 triangles
-      auto a = getMiddlePoint(tri.V1, tri.V2);
-      auto b = getMiddlePoint(tri.V2, tri.V3);
-      auto c = getMiddlePoint(tri.V3, tri.V1);
-
-      faces2.push_back(TriangleIndices(tri.V1, a, c));
-      faces2.push_back(TriangleIndices(tri.V2, b, a));
-      faces2.push_back(TriangleIndices(tri.V3, c, b));
-      faces2.push_back(TriangleIndices(a, b, c));
+/// Icosphere of unit radius stored as unique vertices and triangle indices.
+struct Shape {
+  std::vector<Vector3> vertices;
+  std::vector<std::size_t> indices;
+};
+
+/// Builds unit icosphere by refining faces of icosahedron.
+class ShapeBuilder {
+ public:
+  Shape build(int recursionLevel, bool isSemiSphere) {
+    vertexList_ = createVertexList();
+    const auto &faces = isSemiSphere ? getSemiSphereFaces() : getSphereFaces();
+
+    // refine triangles
+    // NOTE every level refines faces of icosahedron, so levels above one give the same shape.
+    std::vector<TriangleIndices> meshFaces;
+    for (int i = 0; i < recursionLevel; i++) {
+      std::vector<TriangleIndices> faces2;
+      faces2.reserve(faces.size()*4);
+      for (const auto &tri : faces) {
+        // replace triangle by 4 triangles
+        auto a = getMiddlePoint(tri.V1, tri.V2);
+        auto b = getMiddlePoint(tri.V2, tri.V3);
+        auto c = getMiddlePoint(tri.V3, tri.V1);
+
+        faces2.push_back(TriangleIndices(tri.V1, a, c));
+        faces2.push_back(TriangleIndices(tri.V2, b, a));
+        faces2.push_back(TriangleIndices(tri.V3, c, b));
+        faces2.push_back(TriangleIndices(a, b, c));
+      }
+      meshFaces = std::move(faces2);
     }
-    meshFaces = std::move(faces2);
+
+    Shape shape;
+    shape.vertices = std::move(vertexList_);
+    shape.indices.reserve(meshFaces.size()*3);
+    for (const auto &face : meshFaces) {
+      shape.indices.push_back(face.V1);
+      shape.indices.push_back(face.V2);
+      shape.indices.push_back(face.V3);
+    }
+    return shape;
   }
 
-  // generate mesh
-  for (const auto &face : meshFaces) {
-    addTriangle(
-        translate(scale(vertexList_[face.V1]) + center_),
-        translate(scale(vertexList_[face.V2]) + center_),
-        translate(scale(vertexList_[face.V3]) + center_));
+ private:
+  ///  Returns index of point in the middle of p1 and p2.
+  std::size_t getMiddlePoint(std::size_t p1, std::size_t p2) {
+    // first check if we have it already
+    bool firstIsSmaller = p1 < p2;
+    std::uint64_t smallerIndex = firstIsSmaller ? p1 : p2;
+    std::uint64_t greaterIndex = firstIsSmaller ? p2 : p1;
+    std::uint64_t key = (smallerIndex << 32) + greaterIndex;
+
+    auto ret = middlePointIndexCache_.find(key);
+    if (ret!=middlePointIndexCache_.end())
+      return ret->second;
+
+    // not in cache, calculate it
+    Vector3 point1 = vertexList_[p1];
+    Vector3 point2 = vertexList_[p2];
+    Vector3 middle(
+        (point1.x + point2.x)/2,
+        (point1.y + point2.y)/2,
+        (point1.z + point2.z)/2);
+
+    // add vertex makes sure point is on unit sphere
+    std::size_t size = vertexList_.size();
+    vertexList_.push_back(middle.normalized());
+
+    // store it, return index
+    middlePointIndexCache_.insert(std::make_pair(key, size));
+
+    return size;
   }
 
-  // clear state to allow reuse
-  middlePointIndexCache_.clear();
-  vertexList_.clear();
+  std::unordered_map<std::uint64_t, std::size_t> middlePointIndexCache_;
+  std::vector<Vector3> vertexList_;
+};
+
+/// Gets unit icosphere which is built once per process.
+const Shape &getShape(int recursionLevel, bool isSemiSphere) {
+  static std::mutex lock;
+  static std::map<std::pair<int, bool>, std::unique_ptr<Shape>> shapes;
+
+  std::lock_guard<std::mutex> guard(lock);
+  auto &shape = shapes[std::make_pair(recursionLevel, isSemiSphere)];
+  if (shape==nullptr)
+    shape = utymap::utils::make_unique<Shape>(ShapeBuilder().build(recursionLevel, isSemiSphere));
+  return *shape;
 }
+}
+
+void IcoSphereGenerator::generate() {
+  const auto &shape = getShape(recursionLevel_, isSemiSphere_);
+
+  // NOTE vertex is shared by several faces, so it is moved to position only once.
+  vertices_.resize(shape.vertices.size());
+  for (std::size_t i = 0; i < shape.vertices.size(); ++i) {
+    const auto &v = shape.vertices[i];
+    vertices_[i] = Vector3(v.x*size_.x + center_.x, v.y*size_.y + center_.y, v.z*size_.z + center_.z);
+  }
+  for (auto &vertex : vertices_)
+    vertex = translate(vertex);
 
-std::size_t IcoSphereGenerator::getMiddlePoint(std::size_t p1, std::size_t p2) {
-  // first check if we have it already
-  bool firstIsSmaller = p1 < p2;
-  std::uint64_t smallerIndex = firstIsSmaller ? p1 : p2;
-  std::uint64_t greaterIndex = firstIsSmaller ? p2 : p1;
-  std::uint64_t key = (smallerIndex << 32) + greaterIndex;
-
-  auto ret = middlePointIndexCache_.find(key);
-  if (ret!=middlePointIndexCache_.end())
-    return ret->second;
-
-  // not in cache, calculate it
-  Vector3 point1 = vertexList_[p1];
-  Vector3 point2 = vertexList_[p2];
-  Vector3 middle(
-      (point1.x + point2.x)/2,
-      (point1.y + point2.y)/2,
-      (point1.z + point2.z)/2);
-
-  // add vertex makes sure point is on unit sphere
-  std::size_t size = vertexList_.size();
-  vertexList_.push_back(middle.normalized());
-
-  // store it, return index
-  middlePointIndexCache_.insert(std::make_pair(key, size));
-
-  return size;
+  // generate mesh
+  for (std::size_t i = 0; i < shape.indices.size(); i += 3)
+    addTriangle(vertices_[shape.indices[i]], vertices_[shape.indices[i + 1]], vertices_[shape.indices[i + 2]]);
 }
@@ -48,21 +48,12 @@ class IcoSphereGenerator final : public AbstractGenerator {
   void generate() override;
 
  private:
-  ///  Returns index of point in the middle of p1 and p2.
-  std::size_t getMiddlePoint(std::size_t p1, std::size_t p2);
-
-  utymap::math::Vector3 scale(const utymap::math::Vector3 &v) const {
-    return utymap::math::Vector3(v.x*size_.x, v.y*size_.y, v.z*size_.z);
-  }
-
   utymap::math::Vector3 center_;
   utymap::math::Vector3 size_;
   int recursionLevel_;
   bool isSemiSphere_;
-
-  std::unordered_map<std::uint64_t, std::size_t> middlePointIndexCache_;
-  std::vector<utymap::math::Vector3> vertexList_;
-
+  /// Vertices of current icosphere moved to its position.
+  std::vector<utymap::math::Vector3> vertices_;
 };
 
 }
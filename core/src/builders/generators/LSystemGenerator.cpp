@@ -3,6 +3,7 @@
 #include "builders/generators/LSystemGenerator.hpp"
 #include <lsys/Turtle3d.hpp>
 #include "utils/GeometryUtils.hpp"
+#include "utils/MeshUtils.hpp"
 
 using namespace utymap::builders;
 using namespace utymap::lsys;
@@ -51,10 +52,12 @@ const MeshBuilder::AppearanceOptions &getAppearanceByIndex(std::size_t index,
 class DickTurtle : public Turtle3d {
   static std::unordered_map<std::string, void (DickTurtle::*)()> WordMap;
  public:
+  /// Creates turtle which generates mesh at given position. If position is not set,
+  /// mesh is generated in local coordinates without translation.
   DickTurtle(const BuilderContext &builderContext,
              const Style &style,
              Mesh &mesh,
-             const utymap::GeoCoordinate &position,
+             const utymap::GeoCoordinate *position,
              double minHeight) :
       builderContext_(builderContext),
       appearances_(createAppearances(builderContext, style)),
@@ -63,7 +66,8 @@ class DickTurtle : public Turtle3d {
       cylinderGenerator_(builderContext, *cylinderContext_),
       icoSphereGenerator_(builderContext, *icoSphereContext_),
       translationFunc_(std::bind(&DickTurtle::translate, this, std::placeholders::_1)),
-      position_(position),
+      position_(position != nullptr ? *position : utymap::GeoCoordinate()),
+      isLocal_(position == nullptr),
       minHeight_(minHeight) {
     cylinderGenerator_
         .setMaxSegmentHeight(0)
@@ -77,8 +81,10 @@ class DickTurtle : public Turtle3d {
     state_.length = size;
     state_.width = size;
 
-    cylinderGenerator_.setTranslation(translationFunc_);
-    icoSphereGenerator_.setTranslation(translationFunc_);
+    if (!isLocal_) {
+      cylinderGenerator_.setTranslation(translationFunc_);
+      icoSphereGenerator_.setTranslation(translationFunc_);
+    }
   }
 
   void say(const std::string &word) override {
@@ -162,6 +168,7 @@ class DickTurtle : public Turtle3d {
   AbstractGenerator::TranslateFunc translationFunc_;
 
   utymap::GeoCoordinate position_;
+  bool isLocal_;
   double minHeight_;
 };
 
@@ -172,6 +179,28 @@ std::unordered_map<std::string, void (DickTurtle::*)()> DickTurtle::WordMap =
         {"cylinder", &DickTurtle::addCylinder},
     };
 
+/// Gets key of values which generated mesh depends on.
+std::string getCacheKey(const Style &style) {
+  return style.getString(StyleConsts::LSystemKey()) + '|' +
+      style.getString(SizeKey) + '|' +
+      style.getString(GradientsKey) + '|' +
+      style.getString(TextureIndicesKey) + '|' +
+      style.getString(TextureTypesKey) + '|' +
+      style.getString(TextureScalesKey);
+}
+
+/// Copies mesh generated in local coordinates into destination moving it to given position.
+void copyLocalMesh(const Mesh &source, Mesh &destination, const utymap::GeoCoordinate &position, double elevation) {
+  auto startIndex = destination.vertices.size();
+  utymap::utils::copyMesh(Vector3(0, 0, 0), source, destination);
+  for (auto i = startIndex; i < destination.vertices.size(); i += 3) {
+    auto coordinate = GeoUtils::worldToGeo(position, destination.vertices[i], destination.vertices[i + 1]);
+    destination.vertices[i] = coordinate.longitude;
+    destination.vertices[i + 1] = coordinate.latitude;
+    destination.vertices[i + 2] += elevation;
+  }
+}
+
 }
 
 void LSystemGenerator::generate(const BuilderContext &builderContext,
@@ -192,6 +221,25 @@ void LSystemGenerator::generate(const BuilderContext &builderContext,
                                 Mesh &mesh,
                                 const utymap::GeoCoordinate &position,
                                 double elevation) {
-  DickTurtle(builderContext, style, mesh, position, elevation)
+  DickTurtle(builderContext, style, mesh, &position, elevation)
       .run(lsystem);
 }
+
+void LSystemGenerator::generate(const BuilderContext &builderContext,
+                                const Style &style,
+                                Cache &cache,
+                                Mesh &mesh,
+                                const utymap::GeoCoordinate &position,
+                                double elevation) {
+  auto key = getCacheKey(style);
+  auto it = cache.meshes_.find(key);
+  if (it == cache.meshes_.end()) {
+    it = cache.meshes_.emplace(key, Mesh("")).first;
+    const auto &lsystem = builderContext.styleProvider
+        .getLsystem(style.getString(StyleConsts::LSystemKey()));
+    DickTurtle(builderContext, style, it->second, nullptr, 0)
+        .run(lsystem);
+  }
+
+  copyLocalMesh(it->second, mesh, position, elevation);
+}
@@ -5,12 +5,27 @@
 #include "builders/MeshContext.hpp"
 #include "lsys/LSystem.hpp"
 
+#include <string>
+#include <unordered_map>
+
 namespace utymap {
 namespace builders {
 
 /// Defines generator which generates a tree like structures using lsystem.
 class LSystemGenerator final {
  public:
+  /// Keeps meshes generated in local coordinates, so elements with the same lsystem and
+  /// appearance are generated once and then only moved to their position.
+  /// NOTE cache is bound to style provider of builder context and is not thread safe.
+  class Cache final {
+   public:
+    /// Returns amount of cached meshes.
+    std::size_t size() const { return meshes_.size(); }
+
+   private:
+    friend class LSystemGenerator;
+    std::unordered_map<std::string, utymap::math::Mesh> meshes_;
+  };
 
   static void generate(const utymap::builders::BuilderContext &builderContext,
                        const utymap::mapcss::Style &style,
@@ -24,6 +39,14 @@ class LSystemGenerator final {
                        utymap::math::Mesh &mesh,
                        const utymap::GeoCoordinate &position,
                        double elevation);
+
+  /// Generates mesh from cached one if lsystem with the same appearance was generated before.
+  static void generate(const utymap::builders::BuilderContext &builderContext,
+                       const utymap::mapcss::Style &style,
+                       Cache &cache,
+                       utymap::math::Mesh &mesh,
+                       const utymap::GeoCoordinate &position,
+                       double elevation);
 };
 
 }
@@ -57,9 +57,24 @@ class WallGenerator : public AbstractGenerator {
   void generate() override {
     if (begin_==end_) return;
 
+    if (gap_ > 0 && length_ > 0)
+      generateSegments();
+    else
+      generateContinuous();
+
+    builderContext_.meshBuilder.writeTextureMappingInfo(meshContext_->mesh,
+                                                        meshContext_->appearanceOptions);
+  }
+
+ private:
+
+  /// Builds wall with gaps as separate parallelepipeds. Elevations of their corners are
+  /// sampled at once.
+  void generateSegments() {
     auto size = static_cast<std::size_t>(std::distance(begin_, end_) - 1);
     auto fullLength = length_ + gap_;
     auto ratio = length_/fullLength;
+    corners_.clear();
     for (std::size_t i = 0; i < size; ++i) {
       const auto &p0 = *(begin_ + i);
       const auto &p1 = *(begin_ + i + 1);
@@ -71,47 +86,205 @@ class WallGenerator : public AbstractGenerator {
       for (int j = 1; j <= count; ++j) {
         double offset = static_cast<double>(j)/count;
         auto end = count==1 ? p1 : utymap::utils::GeoUtils::newPoint(p0, p1, offset);
-        buildSegment(utymap::math::Vector2(start.longitude, start.latitude),
-                     utymap::math::Vector2(start.longitude + (end.longitude - start.longitude)*ratio,
-                                           start.latitude + (end.latitude - start.latitude)*ratio));
+        addCorners(utymap::math::Vector2(start.longitude, start.latitude),
+                   utymap::math::Vector2(start.longitude + (end.longitude - start.longitude)*ratio,
+                                         start.latitude + (end.latitude - start.latitude)*ratio));
         start = end;
       }
     }
 
-    builderContext_.meshBuilder.writeTextureMappingInfo(meshContext_->mesh,
-                                                        meshContext_->appearanceOptions);
+    sampleElevations();
+    for (std::size_t i = 0; i < corners_.size(); i += 4) {
+      buildParallelepiped(getVertex(i), getVertex(i + 1), getVertex(i + 2), getVertex(i + 3), height_);
+    }
   }
 
- private:
-
-  /// Builds segment separately. NOTE better to connect them.
-  void buildSegment(const utymap::math::Vector2 &p0, const utymap::math::Vector2 &p1) const {
-    // get segments.
+  /// Adds left and right corners of segment without gap.
+  void addCorners(const utymap::math::Vector2 &p0, const utymap::math::Vector2 &p1) {
     auto direction = (p1 - p0).normalized();
     utymap::math::Vector2 normal(-direction.y, direction.x);
-    auto leftP0 = p0 + normal*width_;
-    auto leftP1 = p1 + normal*width_;
-    auto rightP0 = p0 - normal*width_;
-    auto rightP1 = p1 - normal*width_;
-
-    auto bottomLeftP0 =
-        heightOffset_ + builderContext_.eleProvider.getElevation(builderContext_.quadKey, leftP0.y, leftP0.x);
-    auto bottomLeftP1 =
-        heightOffset_ + builderContext_.eleProvider.getElevation(builderContext_.quadKey, leftP1.y, leftP1.x);
-    auto bottomRightP0 =
-        heightOffset_ + builderContext_.eleProvider.getElevation(builderContext_.quadKey, rightP0.y, rightP0.x);
-    auto bottomRightP1 =
-        heightOffset_ + builderContext_.eleProvider.getElevation(builderContext_.quadKey, rightP1.y, rightP1.x);
-
-    buildParallelepiped(utymap::math::Vector3(leftP0.x, bottomLeftP0, leftP0.y),
-                        utymap::math::Vector3(leftP1.x, bottomLeftP1, leftP1.y),
-                        utymap::math::Vector3(rightP0.x, bottomRightP0, rightP0.y),
-                        utymap::math::Vector3(rightP1.x, bottomRightP1, rightP1.y),
-                        height_);
+    addCorner(p0 + normal*width_);
+    addCorner(p1 + normal*width_);
+    addCorner(p0 - normal*width_);
+    addCorner(p1 - normal*width_);
+  }
+
+  /// Builds continuous wall as strips of sides and top which share vertices between
+  /// consecutive segments. Segments are joined by miter, so only ends of wall are capped.
+  /// Elevations and color noise of all corners are sampled at once.
+  void generateContinuous() {
+    points_.clear();
+    for (auto it = begin_; it != end_; ++it) {
+      utymap::math::Vector2 point(it->longitude, it->latitude);
+      if (points_.empty() || points_.back() != point)
+        points_.push_back(point);
+    }
+    if (points_.size() < 2) return;
+
+    // NOTE left corners go first, then right ones.
+    const std::size_t count = points_.size();
+    corners_.clear();
+    for (std::size_t i = 0; i < count; ++i)
+      addCorner(points_[i] + getJoinNormal(i)*width_);
+    for (std::size_t i = 0; i < count; ++i)
+      addCorner(points_[i] - getJoinNormal(i)*width_);
+
+    sampleElevations();
+    sampleColors();
+
+    const auto &appearance = meshContext_->appearanceOptions;
+    double size = builderContext_.boundingBox.width()/appearance.textureScale;
+    double scaleY = utymap::utils::GeoUtils::getOffset(corners_[0], height_)/size;
+
+    // left side goes backward and right one goes forward, so both face outside.
+    addSide(0, count, -1, size, scaleY);
+    addSide(count, count, 1, size, scaleY);
+    addTop(count, size);
+
+    // caps of wall ends
+    meshContext_->geometryOptions.heightOffset = height_;
+    builderContext_.meshBuilder.addPlane(meshContext_->mesh, getVertex(0), getVertex(count),
+                                         meshContext_->geometryOptions, appearance);
+    builderContext_.meshBuilder.addPlane(meshContext_->mesh, getVertex(2*count - 1), getVertex(count - 1),
+                                         meshContext_->geometryOptions, appearance);
+  }
+
+  /// Adds side strip over corners [first, first + count) walked in given direction.
+  void addSide(std::size_t first, std::size_t count, int step, double size, double scaleY) {
+    auto &mesh = meshContext_->mesh;
+    int start = static_cast<int>(mesh.vertices.size()/3);
+    double u = 0;
+    for (std::size_t k = 0; k < count; ++k) {
+      std::size_t i = step > 0 ? first + k : first + count - 1 - k;
+      if (k > 0) {
+        std::size_t previous = step > 0 ? i - 1 : i + 1;
+        u += getDistance(previous, i)/size;
+      }
+      addVertex(i, 0, u, 0);
+      addVertex(i, height_, u, scaleY);
+    }
+
+    for (int k = 0; k + 1 < static_cast<int>(count); ++k) {
+      int bottom0 = start + 2*k, top0 = bottom0 + 1, bottom1 = bottom0 + 2, top1 = bottom0 + 3;
+      addTriangle(bottom0, top1, bottom1);
+      addTriangle(top0, top1, bottom0);
+    }
+  }
+
+  /// Adds top strip between left and right corners.
+  void addTop(std::size_t count, double size) {
+    auto &mesh = meshContext_->mesh;
+    int start = static_cast<int>(mesh.vertices.size()/3);
+    double u = 0, v = 2*width_/size;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (i > 0)
+        u += utymap::math::Vector2::distance(points_[i - 1], points_[i])/size;
+      addVertex(i, height_, u, 0);
+      addVertex(count + i, height_, u, v);
+    }
+
+    for (int k = 0; k + 1 < static_cast<int>(count); ++k) {
+      int left0 = start + 2*k, right0 = left0 + 1, left1 = left0 + 2, right1 = left0 + 3;
+      addTriangle(left0, left1, right0);
+      addTriangle(right0, left1, right1);
+    }
+  }
+
+  /// Returns normal at given point scaled, so offset corners of adjacent segments meet.
+  /// NOTE sharp turns are not mitered to avoid long spikes.
+  utymap::math::Vector2 getJoinNormal(std::size_t index) const {
+    if (index==0) return getNormal(0);
+    if (index + 1==points_.size()) return getNormal(index - 1);
+
+    auto previous = getNormal(index - 1);
+    auto miter = (previous + getNormal(index)).normalized();
+    double cos = miter.dot(previous);
+    return cos > 0.25 ? miter/cos : previous;
+  }
+
+  /// Returns left normal of segment which starts at given point.
+  utymap::math::Vector2 getNormal(std::size_t index) const {
+    auto direction = (points_[index + 1] - points_[index]).normalized();
+    return utymap::math::Vector2(-direction.y, direction.x);
+  }
+
+  double getDistance(std::size_t i, std::size_t j) const {
+    return utymap::math::Vector2::distance(
+        utymap::math::Vector2(corners_[i].longitude, corners_[i].latitude),
+        utymap::math::Vector2(corners_[j].longitude, corners_[j].latitude));
+  }
+
+  void addCorner(const utymap::math::Vector2 &corner) {
+    corners_.push_back(utymap::GeoCoordinate(corner.y, corner.x));
+  }
+
+  /// Gets elevations of all corners in one call.
+  void sampleElevations() {
+    if (builderContext_.eleProvider.isFlat()) {
+      elevations_.assign(corners_.size(), heightOffset_);
+      return;
+    }
+
+    elevations_.resize(corners_.size());
+    builderContext_.eleProvider.getElevations(builderContext_.quadKey, corners_.data(),
+                                              elevations_.data(), corners_.size());
+    for (auto &elevation : elevations_)
+      elevation += heightOffset_;
+  }
+
+  /// Gets colors of all corners from gradient using noise at their positions.
+  void sampleColors() {
+    const auto &appearance = meshContext_->appearanceOptions;
+    xs_.resize(corners_.size());
+    ys_.resize(corners_.size());
+    for (std::size_t i = 0; i < corners_.size(); ++i) {
+      xs_[i] = corners_[i].longitude;
+      ys_[i] = corners_[i].latitude;
+    }
+    noise_.resize(corners_.size());
+    utymap::utils::NoiseUtils::perlin2D(xs_.data(), ys_.data(), noise_.data(), corners_.size(),
+                                        appearance.colorNoiseFreq);
+    for (auto &noise : noise_)
+      noise = (noise + 1)/2;
+    colors_.resize(corners_.size());
+    appearance.gradient.evaluate(noise_.data(), colors_.data(), corners_.size());
+  }
+
+  utymap::math::Vector3 getVertex(std::size_t index) const {
+    return utymap::math::Vector3(corners_[index].longitude, elevations_[index], corners_[index].latitude);
+  }
+
+  void addVertex(std::size_t index, double height, double u, double v) {
+    auto &mesh = meshContext_->mesh;
+    mesh.vertices.push_back(corners_[index].longitude);
+    mesh.vertices.push_back(corners_[index].latitude);
+    mesh.vertices.push_back(elevations_[index] + height);
+    mesh.colors.push_back(colors_[index]);
+    mesh.uvs.push_back(u);
+    mesh.uvs.push_back(v);
+  }
+
+  void addTriangle(int v0, int v1, int v2) {
+    auto &triangles = meshContext_->mesh.triangles;
+    triangles.push_back(v0);
+    triangles.push_back(v1);
+    triangles.push_back(v2);
+    if (meshContext_->geometryOptions.hasBackSide) {
+      triangles.push_back(v2);
+      triangles.push_back(v1);
+      triangles.push_back(v0);
+    }
   }
 
   Iterator begin_, end_;
   double width_, height_, heightOffset_, length_, gap_;
+
+  /// Scratch data reused by calls.
+  std::vector<utymap::math::Vector2> points_;
+  std::vector<utymap::GeoCoordinate> corners_;
+  std::vector<double> elevations_;
+  std::vector<double> xs_, ys_, noise_;
+  std::vector<int> colors_;
 };
 
 }
@@ -41,6 +41,10 @@ void BarrierBuilder::visitRelation(const Relation &relation) {
   resetStyle(isSet);
 }
 
+void BarrierBuilder::complete() {
+  instancer_.flush();
+}
+
 bool BarrierBuilder::setStyle(const utymap::entities::Element &element) {
   if (style_==nullptr) {
     style_ =
@@ -60,7 +64,9 @@ template<typename T>
 void BarrierBuilder::build(const T &element, Iterator begin, Iterator end) {
   bool isSet = setStyle(element);
 
-  auto mesh = context_.meshPool.getSmall(utymap::utils::getMeshName(MeshNamePrefix, element));
+  // NOTE wall segment is a box of eight vertices.
+  auto vertexCount = 8 * static_cast<std::size_t>(std::distance(begin, end));
+  auto mesh = context_.meshPool.get(utymap::utils::getMeshName(MeshNamePrefix, element), vertexCount);
   MeshContext meshContext = MeshContext::create(mesh, *style_, context_.styleProvider, element.id);
 
   if (style_->getString(StyleConsts::TypeKey())==PillarType)
@@ -117,6 +123,19 @@ void BarrierBuilder::buildPillar(const T &element, Iterator begin, Iterator end,
   }
 
   double treeStepInMeters = meshContext.style.getValue(StyleConsts::StepKey());
+
+  // NOTE pillar geometry depends on element, so every element gets its own prototype.
+  if (context_.useInstancing) {
+    if (!instancer_.has(mesh.name))
+      utymap::utils::copyMesh(Vector3(0, 0, 0), meshContext.mesh, instancer_.add(mesh.name));
+    for (std::size_t i = 0; i < static_cast<std::size_t>(size - 1); ++i) {
+      utymap::utils::visitOffsetsAlong(context_.quadKey, *begin, *(begin + i), *(begin + i + 1),
+                                       treeStepInMeters, context_.eleProvider,
+                                       [&](const Vector3 &offset) { instancer_.addInstance(mesh.name, offset); });
+    }
+    return;
+  }
+
   for (std::size_t i = 0; i < static_cast<std::size_t>(size - 1); ++i) {
     const auto p0 = (begin + i);
     const auto p1 = (begin + i + 1);
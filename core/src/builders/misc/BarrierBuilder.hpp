@@ -3,6 +3,7 @@
 
 #include "builders/ElementBuilder.hpp"
 #include "builders/MeshContext.hpp"
+#include "builders/MeshInstancer.hpp"
 
 namespace utymap {
 namespace builders {
@@ -12,7 +13,7 @@ class BarrierBuilder final : public ElementBuilder {
 
  public:
   explicit BarrierBuilder(const utymap::builders::BuilderContext &context) :
-      ElementBuilder(context) {
+      ElementBuilder(context), instancer_(context) {
   }
 
   void visitNode(const utymap::entities::Node &) override;
@@ -23,6 +24,8 @@ class BarrierBuilder final : public ElementBuilder {
 
   void visitRelation(const utymap::entities::Relation &) override;
 
+  void complete() override;
+
  private:
   typedef std::vector<GeoCoordinate>::const_iterator Iterator;
 
@@ -46,6 +49,9 @@ class BarrierBuilder final : public ElementBuilder {
 
   /// Holds style of the element.
   std::unique_ptr<utymap::mapcss::Style> style_;
+
+  /// Collects pillars when instancing is used.
+  utymap::builders::MeshInstancer instancer_;
 };
 
 }
@@ -24,9 +24,17 @@ void LampBuilder::visitNode(const utymap::entities::Node &node) {
 
   const auto elevation = context_.eleProvider.getElevation(context_.quadKey, node.coordinate);
 
+  if (context_.useInstancing) {
+    const auto center = context_.boundingBox.center();
+    instancer_.addInstance(addPrototype(style), Vector3(node.coordinate.longitude - center.longitude,
+                                                        elevation,
+                                                        node.coordinate.latitude - center.latitude));
+    return;
+  }
+
   auto lampMesh = context_.meshPool.getSmall(utymap::utils::getMeshName(NodeMeshNamePrefix, node));
 
-  LSystemGenerator::generate(context_, style, lampMesh, node.coordinate, elevation);
+  LSystemGenerator::generate(context_, style, lsystemCache_, lampMesh, node.coordinate, elevation);
 
   context_.meshCallback(lampMesh);
   context_.meshPool.release(std::move(lampMesh));
@@ -42,7 +50,18 @@ void LampBuilder::visitWay(const utymap::entities::Way &way) {
   auto lampMesh = context_.meshPool.getSmall("");
   auto newMesh = context_.meshPool.getLarge(utymap::utils::getMeshName(WayMeshNamePrefix, way));
 
-  LSystemGenerator::generate(context_, style, lampMesh, center, 0);
+  std::string name;
+  if (context_.useInstancing)
+    name = addPrototype(style);
+  else
+    LSystemGenerator::generate(context_, style, lsystemCache_, lampMesh, center, 0);
+
+  auto place = [&](const Vector3 &offset) {
+    if (context_.useInstancing)
+      instancer_.addInstance(name, offset);
+    else
+      utymap::utils::copyMesh(offset, lampMesh, newMesh);
+  };
 
   for (std::size_t i = 0; i < way.coordinates.size() - 1; ++i) {
     const auto &p0 = way.coordinates[i];
@@ -72,21 +91,19 @@ void LampBuilder::visitWay(const utymap::entities::Way &way) {
                                                       offset);
 
         double elevation = context_.eleProvider.getElevation(context_.quadKey, position);
-        utymap::utils::copyMesh(Vector3(position.longitude - center.longitude,
-                                        elevation,
-                                        position.latitude - center.latitude),
-                                lampMesh, newMesh);
+        place(Vector3(position.longitude - center.longitude,
+                      elevation,
+                      position.latitude - center.latitude));
       }
 
     } else
-      utymap::utils::copyMeshAlong(context_.quadKey,
-                                   center,
-                                   p0,
-                                   p1,
-                                   lampMesh,
-                                   newMesh,
-                                   stepInMeters,
-                                   context_.eleProvider);
+      utymap::utils::visitOffsetsAlong(context_.quadKey,
+                                       center,
+                                       p0,
+                                       p1,
+                                       stepInMeters,
+                                       context_.eleProvider,
+                                       place);
   }
 
   if (!newMesh.vertices.empty())
@@ -100,3 +117,14 @@ void LampBuilder::visitRelation(const utymap::entities::Relation &relation) {
   for (const auto &element : relation.elements)
     element->accept(*this);
 }
+
+void LampBuilder::complete() {
+  instancer_.flush();
+}
+
+std::string LampBuilder::addPrototype(const Style &style) {
+  auto name = MeshInstancer::getName(NodeMeshNamePrefix, style, context_.quadKey.levelOfDetail);
+  if (!instancer_.has(name))
+    LSystemGenerator::generate(context_, style, lsystemCache_, instancer_.add(name), context_.boundingBox.center(), 0);
+  return name;
+}
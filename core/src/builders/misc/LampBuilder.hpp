@@ -2,6 +2,8 @@
 #define BUILDERS_MISC_LAMPBUILDER_HPP_DEFINED
 
 #include "builders/ElementBuilder.hpp"
+#include "builders/MeshInstancer.hpp"
+#include "builders/generators/LSystemGenerator.hpp"
 
 namespace utymap {
 namespace builders {
@@ -10,7 +12,7 @@ namespace builders {
 class LampBuilder final : public ElementBuilder {
  public:
   explicit LampBuilder(const utymap::builders::BuilderContext &context) :
-      ElementBuilder(context) {
+      ElementBuilder(context), instancer_(context) {
   }
 
   void visitNode(const utymap::entities::Node &) override;
@@ -20,6 +22,17 @@ class LampBuilder final : public ElementBuilder {
   void visitWay(const utymap::entities::Way &way) override;
 
   void visitRelation(const utymap::entities::Relation &) override;
+
+  void complete() override;
+
+ private:
+  /// Generates prototype for given style if it doesn't exist yet and returns its name.
+  std::string addPrototype(const utymap::mapcss::Style &style);
+
+  /// Collects lamps when instancing is used.
+  utymap::builders::MeshInstancer instancer_;
+  /// Keeps generated meshes of tile, so the same lsystems are not generated again.
+  utymap::builders::LSystemGenerator::Cache lsystemCache_;
 };
 
 }
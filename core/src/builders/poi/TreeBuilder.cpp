@@ -21,27 +21,44 @@ const std::string TreeStepKey = "tree-step";
 }
 
 void TreeBuilder::visitNode(const utymap::entities::Node &node) {
-  auto mesh = context_.meshPool.getSmall(utymap::utils::getMeshName(NodeMeshNamePrefix, node));
   Style style = context_.styleProvider.forElement(node, context_.quadKey.levelOfDetail);
 
   double elevation = context_.eleProvider.getElevation(context_.quadKey, node.coordinate);
 
-  LSystemGenerator::generate(context_, style, mesh, node.coordinate, elevation);
+  if (context_.useInstancing) {
+    const auto center = context_.boundingBox.center();
+    instancer_.addInstance(addPrototype(style), Vector3(node.coordinate.longitude - center.longitude,
+                                                        elevation,
+                                                        node.coordinate.latitude - center.latitude));
+    return;
+  }
+
+  auto mesh = context_.meshPool.getSmall(utymap::utils::getMeshName(NodeMeshNamePrefix, node));
+  LSystemGenerator::generate(context_, style, lsystemCache_, mesh, node.coordinate, elevation);
 
   context_.meshCallback(mesh);
   context_.meshPool.release(std::move(mesh));
 }
 
 void TreeBuilder::visitWay(const utymap::entities::Way &way) {
-  auto treeMesh = context_.meshPool.getSmall("");
-  auto newMesh = context_.meshPool.getLarge(utymap::utils::getMeshName(WayMeshNamePrefix, way));
-
   Style style = context_.styleProvider.forElement(way, context_.quadKey.levelOfDetail);
   const auto center = context_.boundingBox.center();
+  double treeStepInMeters = style.getValue(TreeStepKey);
 
-  LSystemGenerator::generate(context_, style, treeMesh, center, 0);
+  if (context_.useInstancing) {
+    auto name = addPrototype(style);
+    for (std::size_t i = 0; i < way.coordinates.size() - 1; ++i) {
+      utymap::utils::visitOffsetsAlong(context_.quadKey, center, way.coordinates[i], way.coordinates[i + 1],
+                                       treeStepInMeters, context_.eleProvider,
+                                       [&](const Vector3 &offset) { instancer_.addInstance(name, offset); });
+    }
+    return;
+  }
 
-  double treeStepInMeters = style.getValue(TreeStepKey);
+  auto treeMesh = context_.meshPool.getSmall("");
+  auto newMesh = context_.meshPool.getLarge(utymap::utils::getMeshName(WayMeshNamePrefix, way));
+
+  LSystemGenerator::generate(context_, style, lsystemCache_, treeMesh, center, 0);
 
   for (std::size_t i = 0; i < way.coordinates.size() - 1; ++i) {
     const auto &p0 = way.coordinates[i];
@@ -66,3 +83,14 @@ void TreeBuilder::visitRelation(const utymap::entities::Relation &relation) {
     element->accept(*this);
   }
 }
+
+void TreeBuilder::complete() {
+  instancer_.flush();
+}
+
+std::string TreeBuilder::addPrototype(const Style &style) {
+  auto name = MeshInstancer::getName(NodeMeshNamePrefix, style, context_.quadKey.levelOfDetail);
+  if (!instancer_.has(name))
+    LSystemGenerator::generate(context_, style, lsystemCache_, instancer_.add(name), context_.boundingBox.center(), 0);
+  return name;
+}
@@ -2,6 +2,8 @@
 #define BUILDERS_POI_TREEBUILDER_HPP_DEFINED
 
 #include "builders/ElementBuilder.hpp"
+#include "builders/MeshInstancer.hpp"
+#include "builders/generators/LSystemGenerator.hpp"
 #include "entities/Area.hpp"
 
 namespace utymap {
@@ -11,7 +13,7 @@ namespace builders {
 class TreeBuilder final : public utymap::builders::ElementBuilder {
  public:
   explicit TreeBuilder(const utymap::builders::BuilderContext &context) :
-      utymap::builders::ElementBuilder(context) {
+      utymap::builders::ElementBuilder(context), instancer_(context) {
   }
 
   void visitNode(const utymap::entities::Node &node) override;
@@ -21,6 +23,17 @@ class TreeBuilder final : public utymap::builders::ElementBuilder {
   void visitArea(const utymap::entities::Area &area) override {}
 
   void visitRelation(const utymap::entities::Relation &relation) override;
+
+  void complete() override;
+
+ private:
+  /// Generates prototype for given style if it doesn't exist yet and returns its name.
+  std::string addPrototype(const utymap::mapcss::Style &style);
+
+  /// Collects trees when instancing is used.
+  utymap::builders::MeshInstancer instancer_;
+  /// Keeps generated meshes of tile, so the same lsystems are not generated again.
+  utymap::builders::LSystemGenerator::Cache lsystemCache_;
 };
 
 }
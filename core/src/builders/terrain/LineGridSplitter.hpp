@@ -8,6 +8,7 @@
 #include <cmath>
 #include <cstdint>
 #include <limits>
+#include <vector>
 
 namespace utymap {
 namespace builders {
@@ -42,26 +43,36 @@ class LineGridSplitter final {
     step_ = step;
   }
 
-  /// Splits line to segments.
+  /// Splits line to segments. Points are appended to result.
   void split(const utymap::math::IntPoint &start,
              const utymap::math::IntPoint &end,
              Points &result) const {
     Point s(start.X/scale_, start.Y/scale_);
     Point e(end.X/scale_, end.Y/scale_);
 
-    Points points;
-    points.reserve(2);
-    points.push_back(s);
+    std::size_t first = result.size();
+    result.push_back(s);
 
     double slope = (e.y - s.y)/(e.x - s.x);
     if (std::isinf(slope) || std::abs(slope) < std::numeric_limits<double>::epsilon())
-      zeroSlope(s, e, points);
+      zeroSlope(s, e, first, result);
     else
-      normalCase(s, e, slope, points);
+      normalCase(s, e, slope, first, result);
 
-    points.push_back(e);
+    result.push_back(e);
 
-    mergeResults(points, result);
+    mergeResults(first, result);
+  }
+
+  /// Splits closed path to segments. Points are appended to result.
+  void split(const utymap::math::IntPath &path, Points &result) const {
+    if (path.empty()) return;
+
+    // NOTE each segment produces at least its start and end points.
+    result.reserve(result.size() + path.size()*2);
+    std::size_t last = path.size() - 1;
+    for (std::size_t i = 0; i <= last; ++i)
+      split(path[i], path[i==last ? 0 : i + 1], result);
   }
 
  private:
@@ -70,7 +81,7 @@ class LineGridSplitter final {
     return std::ceil(value/step_)*step_;
   }
 
-  void zeroSlope(Point start, Point end, Points &points) const {
+  void zeroSlope(Point start, Point end, std::size_t first, Points &points) const {
     if ((start.x - end.x)==0) {
       bool isBottomTop = start.y < end.y;
       if (!isBottomTop) {
@@ -85,9 +96,9 @@ class LineGridSplitter final {
         points.push_back(Point(start.x, y));
 
       if (isBottomTop)
-        std::sort(points.begin(), points.end(), sort_y());
+        std::sort(points.begin() + first, points.end(), sort_y());
       else
-        std::sort(points.begin(), points.end(), sort_reverse_y());
+        std::sort(points.begin() + first, points.end(), sort_reverse_y());
     } else {
       bool isLeftRight = start.x < end.x;
       if (!isLeftRight) {
@@ -102,13 +113,13 @@ class LineGridSplitter final {
         points.push_back(Point(x, start.y));
 
       if (isLeftRight)
-        std::sort(points.begin(), points.end(), sort_x());
+        std::sort(points.begin() + first, points.end(), sort_x());
       else
-        std::sort(points.begin(), points.end(), sort_reverse_x());
+        std::sort(points.begin() + first, points.end(), sort_reverse_x());
     }
   }
 
-  void normalCase(Point start, Point end, double slope, Points &points) const {
+  void normalCase(Point start, Point end, double slope, std::size_t first, Points &points) const {
     double inverseSlope = 1/slope;
     double b = start.y - slope*start.x;
 
@@ -137,23 +148,26 @@ class LineGridSplitter final {
       points.push_back(Point((y - b)*inverseSlope, y));
 
     if (isLeftRight)
-      std::sort(points.begin(), points.end(), sort_x());
+      std::sort(points.begin() + first, points.end(), sort_x());
     else
-      std::sort(points.begin(), points.end(), sort_reverse_x());
+      std::sort(points.begin() + first, points.end(), sort_reverse_x());
   }
 
-  void mergeResults(const Points &points, Points &result) const {
-    for (std::size_t i = 0; i < points.size(); ++i) {
-      Point candidate = points[i];
-      if (result.size() > 0) {
-        Point last = result[result.size() - 1];
+  /// Removes duplicates from points added starting from given index.
+  static void mergeResults(std::size_t first, Points &result) {
+    std::size_t size = first;
+    for (std::size_t i = first; i < result.size(); ++i) {
+      const Point candidate = result[i];
+      if (size > 0) {
+        const Point &last = result[size - 1];
         if (std::abs(last.x - candidate.x) < std::numeric_limits<double>::epsilon() &&
             std::abs(last.y - candidate.y) < std::numeric_limits<double>::epsilon())
           continue;
       }
 
-      result.push_back(candidate);
+      result[size++] = candidate;
     }
+    result.resize(size);
   }
 
   double scale_;
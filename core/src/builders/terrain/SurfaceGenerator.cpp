@@ -1,4 +1,9 @@
 #include "builders/terrain/SurfaceGenerator.hpp"
+#include "math/FixedPoint.hpp"
+#include "utils/MeshUtils.hpp"
+
+#include <algorithm>
+#include <exception>
 
 using namespace utymap::builders;
 using namespace utymap::mapcss;
@@ -19,7 +24,8 @@ const std::unordered_map<std::string, TerraExtras::ExtrasFunc> ExtrasFuncs =
 };
 
 SurfaceGenerator::SurfaceGenerator(const BuilderContext &context, const Style &style, const IntPath &tileRect) :
-    TerraGenerator(context, style, tileRect, context.meshPool.getLarge(TerrainMeshName)) {
+    TerraGenerator(context, style, tileRect, context.meshPool.getLarge(TerrainMeshName)),
+    vertexBudget_(static_cast<std::size_t>(std::max(0., style.getValue(StyleConsts::MeshVertexBudgetKey())))) {
 }
 
 void SurfaceGenerator::onNewRegion(const std::string &type,
@@ -30,11 +36,21 @@ void SurfaceGenerator::onNewRegion(const std::string &type,
 
 /// NOTE Original layer collection is cleared after this function executed.
 void SurfaceGenerator::generateFrom(const std::vector<Layer> &layers) {
+  // NOTE regions are clipped one after another as each one cuts out previous ones,
+  // but their polygons are triangulated independently.
   buildForeground(layers);
 
-  buildBackground();
+  // NOTE pending tasks are still completed to release their meshes.
+  if (!context_.cancelToken.isCancelled())
+    buildBackground();
 
-  context_.meshCallback(mesh_);
+  buildMeshes();
+
+  completeMeshes();
+
+  // NOTE in streaming mode the rest of mesh is emitted only if it is not empty.
+  if (!context_.cancelToken.isCancelled() && (vertexBudget_==0 || !mesh_.vertices.empty()))
+    context_.meshCallback(mesh_);
   context_.meshPool.release(std::move(mesh_));
 }
 
@@ -49,13 +65,105 @@ void SurfaceGenerator::buildBackground() {
   executeDifference(backgroundClipper_, background);
   backgroundClipper_.Clear();
 
+  if (background.empty())
+    return;
+
+  auto regionContext = RegionContext::create(context_, style_, "");
+  // NOTE height offset builds walls along contours, so it cannot be used with grid cells.
+  if (style_.getString(StyleConsts::GridMeshKey())=="true" &&
+      std::abs(regionContext.geometryOptions.heightOffset) == 0)
+    buildGrid(background, regionContext);
+
   if (!background.empty())
-    TerraGenerator::addGeometry(Level, background, RegionContext::create(context_, style_, ""),
-                                [](const IntPath &path) {});
+    TerraGenerator::addGeometry(Level, background, regionContext, [](const IntPath &path) {});
+}
+
+void SurfaceGenerator::buildGrid(IntPaths &background, const RegionContext &regionContext) {
+  const auto &bbox = context_.boundingBox;
+  int columns = std::max(1, static_cast<int>(std::lround(bbox.width()/cellSize_)));
+  int rows = std::max(1, static_cast<int>(std::lround(bbox.height()/cellSize_)));
+
+  // grid lines in fixed point coordinates, so cells match clipped geometry exactly.
+  const IntPoint &min = tileRect_[0], &max = tileRect_[2];
+  std::vector<cInt> xs(columns + 1), ys(rows + 1);
+  for (int i = 0; i <= columns; ++i)
+    xs[i] = min.X + (max.X - min.X)*i/columns;
+  for (int i = 0; i <= rows; ++i)
+    ys[i] = min.Y + (max.Y - min.Y)*i/rows;
+
+  auto columnOf = [&](double x) {
+    auto index = std::upper_bound(xs.begin(), xs.end(), x) - xs.begin() - 1;
+    return std::min(std::max(static_cast<int>(index), 0), columns - 1);
+  };
+  auto rowOf = [&](double y) {
+    auto index = std::upper_bound(ys.begin(), ys.end(), y) - ys.begin() - 1;
+    return std::min(std::max(static_cast<int>(index), 0), rows - 1);
+  };
+
+  // mark cells crossed by background contours: they are meshed as polygons.
+  std::vector<bool> crossed(static_cast<std::size_t>(columns*rows), false);
+  for (const auto &path : background) {
+    for (std::size_t i = 0; i < path.size(); ++i) {
+      const auto &p1 = path[i];
+      const auto &p2 = path[i==path.size() - 1 ? 0 : i + 1];
+      double xMin = static_cast<double>(std::min(p1.X, p2.X));
+      double xMax = static_cast<double>(std::max(p1.X, p2.X));
+      for (int column = columnOf(xMin), lastColumn = columnOf(xMax); column <= lastColumn; ++column) {
+        // find part of segment inside column
+        double x1 = std::max(xMin, static_cast<double>(xs[column]));
+        double x2 = std::min(xMax, static_cast<double>(xs[column + 1]));
+        double y1 = static_cast<double>(p1.Y), y2 = static_cast<double>(p2.Y);
+        if (p1.X!=p2.X) {
+          double slope = static_cast<double>(p2.Y - p1.Y)/(p2.X - p1.X);
+          y1 = p1.Y + (x1 - p1.X)*slope;
+          y2 = p1.Y + (x2 - p1.X)*slope;
+        }
+        for (int row = rowOf(std::min(y1, y2)), lastRow = rowOf(std::max(y1, y2)); row <= lastRow; ++row)
+          crossed[row*columns + column] = true;
+      }
+    }
+  }
+
+  // other cells are either fully inside or fully outside of background.
+  std::vector<bool> cells(crossed.size(), false);
+  Clipper cellClipper;
+  bool hasCells = false;
+  for (int row = 0; row < rows; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      if (crossed[row*columns + column]) {
+        addClip(cellClipper, IntPath {IntPoint(xs[column], ys[row]), IntPoint(xs[column + 1], ys[row]),
+                                      IntPoint(xs[column + 1], ys[row + 1]), IntPoint(xs[column], ys[row + 1])});
+        continue;
+      }
+      IntPoint center((xs[column] + xs[column + 1])/2, (ys[row] + ys[row + 1])/2);
+      bool isInside = false;
+      for (const auto &path : background)
+        isInside ^= pointInPolygon(center, path)!=0;
+      cells[row*columns + column] = isInside;
+      hasCells |= isInside;
+    }
+  }
+
+  if (!hasCells)
+    return;
+
+  std::vector<double> xCoords(xs.size()), yCoords(ys.size());
+  std::transform(xs.begin(), xs.end(), xCoords.begin(), fromFixed);
+  std::transform(ys.begin(), ys.end(), yCoords.begin(), fromFixed);
+  context_.meshBuilder.addGrid(mesh_, xCoords, yCoords, cells,
+                               regionContext.geometryOptions, regionContext.appearanceOptions);
+  context_.meshBuilder.writeTextureMappingInfo(mesh_, regionContext.appearanceOptions);
+
+  // only crossed cells are left for triangulation.
+  IntPaths rest;
+  addSubjects(cellClipper, background);
+  executeIntersection(cellClipper, rest);
+  background.swap(rest);
 }
 
 void SurfaceGenerator::buildLayer(const Layer &layer) {
   for (const auto &region : layer.regions) {
+    if (context_.cancelToken.isCancelled()) return;
     // TODO revise condition once level processing is implemented
     // if (region->level == 0)
     buildRegion(*region);
@@ -75,23 +183,68 @@ void SurfaceGenerator::buildRegion(const Region &region) {
 
 void SurfaceGenerator::addGeometry(int level, Polygon &polygon, const RegionContext &regionContext) {
   std::string meshName = regionContext.style.getString(regionContext.prefix + StyleConsts::MeshNameKey());
-  if (!meshName.empty()) {
-    Mesh polygonMesh(meshName);
-    TerraExtras::Context extrasContext(polygonMesh, regionContext.style);
-    context_.meshBuilder.addPolygon(polygonMesh, polygon,
-                                    regionContext.geometryOptions, regionContext.appearanceOptions);
-    context_.meshBuilder.writeTextureMappingInfo(polygonMesh, regionContext.appearanceOptions);
-
-    addExtrasIfNecessary(polygonMesh, extrasContext, regionContext);
-    context_.meshCallback(polygonMesh);
-  } else {
-    TerraExtras::Context extrasContext(mesh_, regionContext.style);
-    context_.meshBuilder.addPolygon(mesh_, polygon,
-                                    regionContext.geometryOptions, regionContext.appearanceOptions);
-    context_.meshBuilder.writeTextureMappingInfo(mesh_, regionContext.appearanceOptions);
-
-    addExtrasIfNecessary(mesh_, extrasContext, regionContext);
+  tasks_.push_back(utymap::utils::make_unique<MeshTask>(std::move(polygon), regionContext,
+                                                        context_.meshPool.getSmall(meshName)));
+}
+
+void SurfaceGenerator::buildMeshes() {
+  if (context_.threadPool==nullptr || tasks_.size() < 2)
+    return;
+
+  for (const auto &task : tasks_) {
+    MeshTask *taskPtr = task.get();
+    task->future = context_.threadPool->enqueue([this, taskPtr]() { buildMesh(*taskPtr); });
+  }
+}
+
+void SurfaceGenerator::buildMesh(MeshTask &task) const {
+  if (context_.cancelToken.isCancelled()) return;
+
+  context_.meshBuilder.addPolygon(task.mesh, task.polygon,
+                                  task.regionContext.geometryOptions, task.regionContext.appearanceOptions);
+  context_.meshBuilder.writeTextureMappingInfo(task.mesh, task.regionContext.appearanceOptions);
+}
+
+void SurfaceGenerator::completeMeshes() {
+  // NOTE all tasks should be finished before first exception is rethrown as they reference tasks_.
+  std::exception_ptr exception = nullptr;
+  for (auto &task : tasks_) {
+    try {
+      if (task->future.valid())
+        task->future.get();
+      else if (exception==nullptr)
+        buildMesh(*task);
+    } catch (...) {
+      if (exception==nullptr) exception = std::current_exception();
+    }
+
+    if (exception==nullptr) {
+      const auto &regionContext = task->regionContext;
+      if (!task->mesh.name.empty()) {
+        TerraExtras::Context extrasContext(task->mesh, regionContext.style);
+        addExtrasIfNecessary(task->mesh, extrasContext, regionContext);
+        context_.meshCallback(task->mesh);
+      } else {
+        TerraExtras::Context extrasContext(mesh_, regionContext.style);
+        utymap::utils::copyMesh(Vector3(0, 0, 0), task->mesh, mesh_);
+        addExtrasIfNecessary(mesh_, extrasContext, regionContext);
+        flushIfNecessary();
+      }
+    }
+    context_.meshPool.release(std::move(task->mesh));
   }
+  tasks_.clear();
+
+  if (exception!=nullptr)
+    std::rethrow_exception(exception);
+}
+
+void SurfaceGenerator::flushIfNecessary() {
+  if (vertexBudget_==0 || mesh_.vertices.size()/3 < vertexBudget_)
+    return;
+
+  context_.meshCallback(mesh_);
+  mesh_.clear();
 }
 
 void SurfaceGenerator::addExtrasIfNecessary(Mesh &mesh,
@@ -8,6 +8,10 @@
 #include "math/Polygon.hpp"
 #include "math/Vector2.hpp"
 
+#include <future>
+#include <memory>
+#include <vector>
+
 namespace utymap {
 namespace builders {
 
@@ -30,12 +34,41 @@ class SurfaceGenerator final : public TerraGenerator {
   void addGeometry(int level, utymap::math::Polygon &polygon, const RegionContext &regionContext) override;
 
  private:
+  /// Polygon of region which is meshed independently from others.
+  struct MeshTask {
+    MeshTask(utymap::math::Polygon &&polygon, const RegionContext &regionContext, utymap::math::Mesh &&mesh) :
+        polygon(std::move(polygon)), regionContext(regionContext), mesh(std::move(mesh)) {
+    }
+
+    utymap::math::Polygon polygon;
+    const RegionContext regionContext;
+    utymap::math::Mesh mesh;
+    utymap::utils::ThreadPool::Future future;
+  };
+
+  /// Starts triangulation of polygons of all tasks on thread pool if it is available.
+  void buildMeshes();
+
+  /// Triangulates polygon of given task into its own mesh.
+  void buildMesh(MeshTask &task) const;
+
+  /// Passes meshes of tasks to callback or merges them into terrain mesh in order of tasks.
+  /// Each task is completed as soon as its mesh is built.
+  void completeMeshes();
+
+  /// Passes terrain mesh to callback and clears it when it reaches vertex budget.
+  void flushIfNecessary();
+
   /// Builds foreground surface.
   void buildForeground(const std::vector<Layer> &layers);
 
   /// Builds background surface.
   void buildBackground();
 
+  /// Builds background cells which are not crossed by regions as regular grid
+  /// and leaves only crossed cells in background.
+  void buildGrid(utymap::math::IntPaths &background, const RegionContext &regionContext);
+
   /// Builds layer.
   void buildLayer(const Layer &layer);
 
@@ -49,6 +82,10 @@ class SurfaceGenerator final : public TerraGenerator {
 
   utymap::math::Clipper foregroundClipper_;
   utymap::math::Clipper backgroundClipper_;
+  std::vector<std::unique_ptr<MeshTask>> tasks_;
+  /// Amount of vertices after which terrain mesh is passed to callback.
+  /// Zero means that it is passed once when whole surface is built.
+  std::size_t vertexBudget_;
 };
 
 }
@@ -3,13 +3,19 @@
 #include "builders/terrain/TerraBuilder.hpp"
 #include "builders/terrain/SurfaceGenerator.hpp"
 #include "builders/terrain/ExteriorGenerator.hpp"
+#include "builders/terrain/TerraCache.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "math/FixedPoint.hpp"
 #include "utils/GeometryUtils.hpp"
+#include "utils/Tracer.hpp"
 
+#include <map>
 #include <numeric>
+#include <tuple>
+#include <unordered_set>
 
 using namespace utymap::builders;
 using namespace utymap::entities;
@@ -20,13 +26,6 @@ using namespace utymap::math;
 using namespace utymap::utils;
 
 namespace {
-const double Scale = 1E7;
-
-/// Converts coordinate to clipper's IntPoint.
-IntPoint toIntPoint(double x, double y) {
-  return IntPoint(static_cast<cInt>(x*Scale), static_cast<cInt>(y*Scale));
-}
-
 /// Compares regions based on their area.
 struct LessThanByArea {
   bool operator()(const std::shared_ptr<const Region> &lhs,
@@ -42,6 +41,20 @@ struct MoreThanSortOrder {
   }
 };
 
+/// Combines hash of geometry and its parameters with seed.
+std::size_t hashGeometry(std::size_t seed, const IntPaths &paths, int level, double width) {
+  seed ^= std::hash<int>()(level) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  seed ^= std::hash<double>()(width) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+  for (const auto &path : paths) {
+    seed ^= path.size() + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    for (const auto &point : path) {
+      seed ^= std::hash<cInt>()(point.X) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      seed ^= std::hash<cInt>()(point.Y) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+  }
+  return seed;
+}
+
 /// Visits relation and fills region.
 struct RelationVisitor : public ElementVisitor {
   const Relation &relation;
@@ -59,7 +72,7 @@ struct RelationVisitor : public ElementVisitor {
     IntPath path;
     path.reserve(a.coordinates.size());
     for (const utymap::GeoCoordinate &c : a.coordinates)
-      path.push_back(toIntPoint(c.longitude, c.latitude));
+      path.push_back(toIntPoint(c));
 
     region.geometry.push_back(path);
   }
@@ -71,14 +84,15 @@ struct RelationVisitor : public ElementVisitor {
 class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
  public:
 
-  explicit TerraBuilderImpl(const BuilderContext &context) :
+  TerraBuilderImpl(const BuilderContext &context, TerraCache *cache) :
       ElementBuilder(context),
       style_(context.styleProvider.forCanvas(context.quadKey.levelOfDetail)),
-      generators_(), dimenstionKey_(context.stringTable.getId(StyleConsts::DimensionKey())) {
-    tileRect_.push_back(toIntPoint(context.boundingBox.minPoint.longitude, context.boundingBox.minPoint.latitude));
-    tileRect_.push_back(toIntPoint(context.boundingBox.maxPoint.longitude, context.boundingBox.minPoint.latitude));
-    tileRect_.push_back(toIntPoint(context.boundingBox.maxPoint.longitude, context.boundingBox.maxPoint.latitude));
-    tileRect_.push_back(toIntPoint(context.boundingBox.minPoint.longitude, context.boundingBox.maxPoint.latitude));
+      generators_(), dimenstionKey_(context.styleProvider.getConstIds().dimensionKey), cache_(cache) {
+    const auto &min = context.boundingBox.minPoint, &max = context.boundingBox.maxPoint;
+    tileRect_.push_back(toIntPoint(min));
+    tileRect_.push_back(toIntPoint(GeoCoordinate(min.latitude, max.longitude)));
+    tileRect_.push_back(toIntPoint(max));
+    tileRect_.push_back(toIntPoint(GeoCoordinate(max.latitude, min.longitude)));
 
     addClip(clipper_, tileRect_);
 
@@ -93,25 +107,28 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
   void visitWay(const utymap::entities::Way &way) override {
     Style style = context_.styleProvider.forElement(way, context_.quadKey.levelOfDetail);
     auto region = createRegion(style, way.coordinates);
-    double width = getWidth(style)*Scale;
-
-    IntPaths solution;
-    // make polygon from line by offsetting it using width specified
-    // NOTE: we should limit round shape precision due to performance reasons.
-    offset_.ArcTolerance = width*0.05;
-    addRoundOpenRound(offset_, region->geometry);
-    offset_.Execute(solution, width);
-    offset_.Clear();
-
-    addSubjects(clipper_, solution);
-    executeIntersection(clipper_, solution);
-    clipper_.removeSubject();
-
-    region->geometry = solution;
+    double width = getWidth(style)*FixedPointScale;
     std::string type = region->isLayer()
                        ? style.getString(StyleConsts::TerrainLayerKey())
                        : "";
 
+    // NOTE regions of named layer are merged by level anyway, so ways with the same
+    // width are offset and clipped together once all of them are collected.
+    if (!type.empty()) {
+      signatures_[type] = hashGeometry(signatures_[type], region->geometry, region->level, width);
+      auto &group = wayGroups_[std::make_tuple(type, region->level, width)];
+      if (group.region==nullptr) {
+        group.region = region;
+        group.paths = std::move(region->geometry);
+        layers_[type].regions.push_back(region);
+      } else {
+        group.paths.insert(group.paths.end(), region->geometry.begin(), region->geometry.end());
+      }
+      notifyGenerators(type, way, style, group.region);
+      return;
+    }
+
+    region->geometry = offsetAndClip(region->geometry, width);
     addRegion(type, way, style, region);
   }
 
@@ -140,7 +157,7 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
 
     if (!region->geometry.empty()) {
       Style style = context_.styleProvider.forElement(rel, context_.quadKey.levelOfDetail);
-      if (!style.has(context_.stringTable.getId(StyleConsts::TerrainLayerKey())))
+      if (!style.has(context_.styleProvider.getConstIds().terrainLayerKey))
         region->context = utymap::utils::make_unique<RegionContext>(RegionContext::create(context_, style, ""));
 
       std::string type = region->isLayer()
@@ -155,16 +172,30 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
   void complete() override {
     if (context_.cancelToken.isCancelled()) return;
 
+    auto cachedLayers = restoreCachedLayers();
+
+    TRACE_ZONE("terra.clip", context_.quadKey);
+    for (auto &groupPair : wayGroups_) {
+      if (context_.cancelToken.isCancelled()) return;
+      if (cachedLayers.find(std::get<0>(groupPair.first))==cachedLayers.end())
+        groupPair.second.region->geometry = offsetAndClip(groupPair.second.paths, std::get<2>(groupPair.first));
+    }
+    wayGroups_.clear();
+
     std::vector<Layer> layers;
     layers.reserve(layers_.size());
 
     for (auto &layerPair : layers_) {
+      if (context_.cancelToken.isCancelled()) return;
       // named layer has to merge all regions inside
       if (!layerPair.first.empty()) {
         auto stylePrefix = layerPair.first + "-";
         layerPair.second.sortOrder = static_cast<int>(style_.getValue(stylePrefix + StyleConsts::SortOrderKey()));
-        mergeRegions(layerPair.second, std::make_shared<RegionContext>(
-            RegionContext::create(context_, style_, stylePrefix)));
+        if (cachedLayers.find(layerPair.first)==cachedLayers.end()) {
+          mergeRegions(layerPair.second, std::make_shared<RegionContext>(
+              RegionContext::create(context_, style_, stylePrefix)));
+          storeLayer(layerPair.first, layerPair.second);
+        }
       } else
         layerPair.second.sortOrder = 0;
 
@@ -178,11 +209,19 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
     // sort all layers based on their sort order
     std::sort(layers.begin(), layers.end(), MoreThanSortOrder());
 
-    for (const auto &generator : generators_)
+    TRACE_ZONE("terra.generate", context_.quadKey);
+    for (const auto &generator : generators_) {
+      if (context_.cancelToken.isCancelled()) return;
       generator->generateFrom(layers);
+    }
   }
 
  private:
+  /// Keeps region shared by ways of the same group and their center lines.
+  struct WayGroup {
+    std::shared_ptr<Region> region;
+    IntPaths paths;
+  };
 
   /// Gets width for line offsetting taking care about dimension.
   double getWidth(const Style &style) const {
@@ -194,11 +233,69 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
            : value;
   }
 
+  /// Makes polygons from lines by offsetting them using width specified and clips them by tile.
+  IntPaths offsetAndClip(const IntPaths &lines, double width) {
+    IntPaths solution;
+    // NOTE: we should limit round shape precision due to performance reasons.
+    offset_.ArcTolerance = width*0.05;
+    addRoundOpenRound(offset_, lines);
+    offset_.Execute(solution, width);
+    offset_.Clear();
+
+    addSubjects(clipper_, solution);
+    executeIntersection(clipper_, solution);
+    clipper_.removeSubject();
+    return solution;
+  }
+
+  /// Replaces regions of named layers with cached ones if their source geometry is the same.
+  std::unordered_set<std::string> restoreCachedLayers() {
+    std::unordered_set<std::string> cachedLayers;
+    if (cache_==nullptr)
+      return cachedLayers;
+
+    std::vector<std::shared_ptr<const Region>> cachedRegions;
+    for (auto &layerPair : layers_) {
+      if (layerPair.first.empty() ||
+          !cache_->tryGet(context_.quadKey, layerPair.first, signatures_[layerPair.first], cachedRegions))
+        continue;
+
+      auto regionContext = std::make_shared<RegionContext>(
+          RegionContext::create(context_, style_, layerPair.first + "-"));
+      layerPair.second.regions.clear();
+      for (const auto &cachedRegion : cachedRegions) {
+        auto region = std::make_shared<Region>();
+        region->level = cachedRegion->level;
+        region->area = cachedRegion->area;
+        region->context = regionContext;
+        region->geometry = cachedRegion->geometry;
+        layerPair.second.regions.push_back(region);
+      }
+      cachedLayers.insert(layerPair.first);
+    }
+    return cachedLayers;
+  }
+
+  /// Stores merged regions of named layer in cache.
+  void storeLayer(const std::string &type, const Layer &layer) {
+    if (cache_!=nullptr)
+      cache_->put(context_.quadKey, type, signatures_[type], layer.regions);
+  }
+
   void addRegion(const std::string &type,
                  const utymap::entities::Element &element,
                  const Style &style,
                  std::shared_ptr<Region> &region) {
+    if (!type.empty())
+      signatures_[type] = hashGeometry(signatures_[type], region->geometry, region->level, 0);
     layers_[type].regions.push_back(region);
+    notifyGenerators(type, element, style, region);
+  }
+
+  void notifyGenerators(const std::string &type,
+                        const utymap::entities::Element &element,
+                        const Style &style,
+                        std::shared_ptr<Region> &region) {
     for (const auto &generator : generators_) {
       generator->onNewRegion(type, element, style, region);
     }
@@ -210,11 +307,11 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
     IntPath path;
     path.reserve(coordinates.size());
     for (const GeoCoordinate &c : coordinates)
-      path.push_back(toIntPoint(c.longitude, c.latitude));
+      path.push_back(toIntPoint(c));
 
     region->geometry.push_back(path);
 
-    if (!style.has(context_.stringTable.getId(StyleConsts::TerrainLayerKey())))
+    if (!style.has(context_.styleProvider.getConstIds().terrainLayerKey))
       region->context = std::make_shared<RegionContext>(RegionContext::create(context_, style, ""));
 
     region->level = static_cast<int>(style.getValue(StyleConsts::LevelKey()));
@@ -242,7 +339,7 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
       pair.second.first->area = std::accumulate(result.begin(), result.end(), 0.,
                                                 [](double acc, const IntPath &path) {
                                                   return acc + std::abs(getArea(path));
-                                                })/(Scale*Scale);
+                                                })/(FixedPointScale*FixedPointScale);
 
       pair.second.first->geometry = std::move(result);
       layer.regions.push_back(pair.second.first);
@@ -254,8 +351,13 @@ class TerraBuilder::TerraBuilderImpl final : public ElementBuilder {
   ClipperOffset offset_;
   std::vector<std::unique_ptr<TerraGenerator>> generators_;
   std::unordered_map<std::string, Layer> layers_;
+  /// Center lines of layer ways grouped by layer type, level and width.
+  std::map<std::tuple<std::string, int, double>, WayGroup> wayGroups_;
   IntPath tileRect_;
   std::uint32_t dimenstionKey_;
+  TerraCache *cache_;
+  /// Signatures of source geometry of named layers.
+  std::unordered_map<std::string, std::size_t> signatures_;
 };
 
 void TerraBuilder::visitNode(const utymap::entities::Node &node) { pimpl_->visitNode(node); }
@@ -270,6 +372,6 @@ void TerraBuilder::complete() { pimpl_->complete(); }
 
 TerraBuilder::~TerraBuilder() {}
 
-TerraBuilder::TerraBuilder(const BuilderContext &context) :
-    ElementBuilder(context), pimpl_(utymap::utils::make_unique<TerraBuilderImpl>(context)) {
+TerraBuilder::TerraBuilder(const BuilderContext &context, TerraCache *cache) :
+    ElementBuilder(context), pimpl_(utymap::utils::make_unique<TerraBuilderImpl>(context, cache)) {
 }
@@ -9,11 +9,16 @@
 namespace utymap {
 namespace builders {
 
+class TerraCache;
+
 /// Provides the way to build terrain mesh.
 class TerraBuilder final : public utymap::builders::ElementBuilder {
  public:
 
-  explicit TerraBuilder(const utymap::builders::BuilderContext &);
+  /// Creates builder. If cache is specified, merged geometry of named layers is reused
+  /// between builds of the same tile.
+  explicit TerraBuilder(const utymap::builders::BuilderContext &context,
+                        utymap::builders::TerraCache *cache = nullptr);
 
   virtual ~TerraBuilder();
 
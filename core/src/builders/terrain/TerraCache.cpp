@@ -0,0 +1,100 @@
+#include "builders/BuilderContext.hpp"
+#include "builders/terrain/RegionTypes.hpp"
+#include "builders/terrain/TerraCache.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/LruCache.hpp"
+
+#include <mutex>
+#include <unordered_map>
+
+using namespace utymap;
+using namespace utymap::builders;
+
+class TerraCache::TerraCacheImpl final {
+  /// Regions of layer with signature of their source.
+  struct Entry {
+    std::size_t signature = 0;
+    std::vector<std::shared_ptr<const Region>> regions;
+  };
+
+  typedef std::unordered_map<std::string, Entry> Layers;
+
+ public:
+  explicit TerraCacheImpl(std::size_t maxTiles) : tiles_(maxTiles) {
+  }
+
+  bool tryGet(const QuadKey &quadKey, const std::string &layer, std::size_t signature,
+              std::vector<std::shared_ptr<const Region>> &regions) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!tiles_.exists(quadKey))
+      return false;
+
+    const auto &layers = *tiles_.get(quadKey);
+    auto layerPair = layers.find(layer);
+    if (layerPair==layers.end() || layerPair->second.signature!=signature)
+      return false;
+
+    regions = layerPair->second.regions;
+    return true;
+  }
+
+  void put(const QuadKey &quadKey, const std::string &layer, std::size_t signature,
+           const std::vector<std::shared_ptr<const Region>> &regions) {
+    // NOTE context references style provider which can be destroyed before cache.
+    std::vector<std::shared_ptr<const Region>> geometryOnly;
+    geometryOnly.reserve(regions.size());
+    for (const auto &region : regions) {
+      auto copy = std::make_shared<Region>();
+      copy->level = region->level;
+      copy->area = region->area;
+      copy->geometry = region->geometry;
+      geometryOnly.push_back(copy);
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!tiles_.exists(quadKey))
+      tiles_.put(quadKey, Layers());
+
+    auto &entry = (*tiles_.get(quadKey))[layer];
+    entry.signature = signature;
+    entry.regions = std::move(geometryOnly);
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return tiles_.size();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(lock_);
+    tiles_.clear();
+  }
+
+ private:
+  mutable std::mutex lock_;
+  utymap::utils::LruCache<QuadKey, Layers, QuadKey::Comparator> tiles_;
+};
+
+TerraCache::TerraCache(std::size_t maxTiles) :
+    pimpl_(utymap::utils::make_unique<TerraCacheImpl>(maxTiles)) {
+}
+
+TerraCache::~TerraCache() {}
+
+bool TerraCache::tryGet(const QuadKey &quadKey, const std::string &layer, std::size_t signature,
+                        std::vector<std::shared_ptr<const Region>> &regions) {
+  return pimpl_->tryGet(quadKey, layer, signature, regions);
+}
+
+void TerraCache::put(const QuadKey &quadKey, const std::string &layer, std::size_t signature,
+                     const std::vector<std::shared_ptr<const Region>> &regions) {
+  pimpl_->put(quadKey, layer, signature, regions);
+}
+
+std::size_t TerraCache::size() const {
+  return pimpl_->size();
+}
+
+void TerraCache::clear() {
+  pimpl_->clear();
+}
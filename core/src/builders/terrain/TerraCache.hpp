@@ -0,0 +1,51 @@
+#ifndef BUILDERS_TERRAIN_TERRACACHE_HPP_DEFINED
+#define BUILDERS_TERRAIN_TERRACACHE_HPP_DEFINED
+
+#include "QuadKey.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utymap {
+namespace builders {
+
+struct Region;
+
+/// Keeps merged regions of named terrain layers for recently built tiles, so only layers
+/// whose elements have changed are offset, clipped and merged again on next build of the tile.
+/// NOTE layer is identified by signature of its source geometry, so stale entry is never used.
+class TerraCache final {
+ public:
+  explicit TerraCache(std::size_t maxTiles = 8);
+
+  ~TerraCache();
+
+  /// Returns regions of given layer if cached ones were built from source with the same signature.
+  /// NOTE cached regions have no context.
+  bool tryGet(const utymap::QuadKey &quadKey,
+              const std::string &layer,
+              std::size_t signature,
+              std::vector<std::shared_ptr<const Region>> &regions);
+
+  /// Stores geometry of regions of given layer replacing previous ones.
+  void put(const utymap::QuadKey &quadKey,
+           const std::string &layer,
+           std::size_t signature,
+           const std::vector<std::shared_ptr<const Region>> &regions);
+
+  /// Returns amount of tiles in cache.
+  std::size_t size() const;
+
+  /// Removes all cached layers.
+  void clear();
+
+ private:
+  class TerraCacheImpl;
+  std::unique_ptr<TerraCacheImpl> pimpl_;
+};
+
+}
+}
+
+#endif // BUILDERS_TERRAIN_TERRACACHE_HPP_DEFINED
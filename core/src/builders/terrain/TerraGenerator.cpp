@@ -1,4 +1,5 @@
 #include "builders/terrain/TerraGenerator.hpp"
+#include "math/FixedPoint.hpp"
 
 using namespace utymap::builders;
 using namespace utymap::mapcss;
@@ -7,8 +8,6 @@ using namespace utymap::math;
 namespace {
 /// Tolerance for meshing
 const double AreaTolerance = 1000;
-/// Coordinate scale.
-const double Scale = 1E7;
 }
 
 TerraGenerator::TerraGenerator(const BuilderContext &context,
@@ -26,9 +25,9 @@ TerraGenerator::TerraGenerator(const BuilderContext &context,
   auto relativeQuadKey =
       utymap::utils::GeoUtils::GeoCoordinateToQuadKey(GeoCoordinate(0, 0), context.quadKey.levelOfDetail);
   auto relativeBbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(relativeQuadKey);
-  auto size = style_.getValue(StyleConsts::GridCellSize(), relativeBbox);
+  cellSize_ = style_.getValue(StyleConsts::GridCellSize(), relativeBbox);
 
-  splitter_.setParams(Scale, size);
+  splitter_.setParams(FixedPointScale, cellSize_);
 }
 
 void TerraGenerator::addGeometry(int level,
@@ -45,6 +44,7 @@ void TerraGenerator::addGeometry(int level,
     size += geometry[i].size()*1.5;
 
   Polygon polygon(static_cast<std::size_t>(size));
+  std::vector<Vector2> points;
   for (const IntPath &path : geometry) {
     double area = utymap::math::getArea(path);
     bool isHole = area < 0;
@@ -53,7 +53,8 @@ void TerraGenerator::addGeometry(int level,
 
     geometryVisitor(path);
 
-    auto points = restoreGeometry(path);
+    points.clear();
+    splitter_.split(path, points);
     if (isHole)
       polygon.addHole(points);
     else
@@ -82,13 +83,3 @@ void TerraGenerator::buildHeightOffset(const std::vector<Vector2> &points, const
     context_.meshBuilder.addPlane(mesh_, p1, p2, newGeometryOptions, regionContext.appearanceOptions);
   }
 }
-
-std::vector<Vector2> TerraGenerator::restoreGeometry(const IntPath &geometry) const {
-  auto lastItemIndex = geometry.size() - 1;
-  std::vector<utymap::math::Vector2> points;
-  points.reserve(geometry.size());
-  for (std::size_t i = 0; i <= lastItemIndex; i++)
-    splitter_.split(geometry[i], geometry[i==lastItemIndex ? 0 : i + 1], points);
-
-  return std::move(points);
-}
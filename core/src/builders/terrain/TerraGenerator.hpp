@@ -46,6 +46,8 @@ class TerraGenerator {
   const utymap::mapcss::Style &style_;
   const utymap::math::IntPath &tileRect_;
   utymap::math::Mesh mesh_;
+  /// Size of grid cell in degrees used to split geometry.
+  double cellSize_;
 
  private:
 
@@ -55,9 +57,6 @@ class TerraGenerator {
   /// Builds height contour shape.
   void buildHeightOffset(const std::vector<utymap::math::Vector2> &points, const RegionContext &regionContext);
 
-  /// Restores geometry from clipper format.
-  std::vector<utymap::math::Vector2> restoreGeometry(const utymap::math::IntPath &geometry) const;
-
   const utymap::math::Rectangle rect_;
   utymap::builders::LineGridSplitter splitter_;
 };
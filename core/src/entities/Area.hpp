@@ -15,6 +15,8 @@ struct Area final : public Element {
   /// Returns way's coordinates on map.
   std::vector<GeoCoordinate> coordinates;
 
+  Area() : Element(ElementKind::Area) {}
+
   /// Accepts visitor.
   void accept(ElementVisitor &visitor) const override {
     visitor.visitArea(*this);
@@ -26,12 +26,17 @@ struct Tag {
   bool operator<(const Tag &a) const { return key < a.key; }
 };
 
+/// Specifies actual type of element, so it can be dispatched without virtual call.
+enum class ElementKind : std::uint8_t { Node = 0, Way, Area, Relation };
+
 /// Represents element stored in index.
 struct Element {
   /// Returns id of given element.
   std::uint64_t id;
   /// Returns tag collection represented by vector of tuple<uint,uint>.
   std::vector<Tag> tags;
+  /// Returns actual type of element.
+  ElementKind kind;
 
   virtual ~Element() = default;
 
@@ -53,6 +58,9 @@ struct Element {
     return stm.str();
   }
   // TODO prevent copy/move/assign functions for base class
+
+ protected:
+  explicit Element(ElementKind kind) : kind(kind) {}
 };
 
 }
@@ -0,0 +1,28 @@
+#ifndef ENTITIES_ELEMENTDISPATCH_HPP_DEFINED
+#define ENTITIES_ELEMENTDISPATCH_HPP_DEFINED
+
+#include "entities/Area.hpp"
+#include "entities/Node.hpp"
+#include "entities/Relation.hpp"
+#include "entities/Way.hpp"
+
+namespace utymap {
+namespace entities {
+
+/// Calls visit method of given visitor for actual type of element using element kind instead
+/// of virtual accept. If visitor type is final, visit method is called directly and can be
+/// inlined, so loops over many small elements don't pay for indirect calls.
+template<typename Visitor>
+inline void dispatch(const Element &element, Visitor &visitor) {
+  switch (element.kind) {
+    case ElementKind::Node: visitor.visitNode(static_cast<const Node &>(element)); break;
+    case ElementKind::Way: visitor.visitWay(static_cast<const Way &>(element)); break;
+    case ElementKind::Area: visitor.visitArea(static_cast<const Area &>(element)); break;
+    case ElementKind::Relation: visitor.visitRelation(static_cast<const Relation &>(element)); break;
+  }
+}
+
+}
+}
+
+#endif // ENTITIES_ELEMENTDISPATCH_HPP_DEFINED
@@ -14,6 +14,8 @@ namespace entities {
 struct Relation final : public Element {
   std::vector<std::shared_ptr<Element>> elements;
 
+  Relation() : Element(ElementKind::Relation) {}
+
   /// Accepts visitor.
   void accept(ElementVisitor &visitor) const override {
     visitor.visitRelation(*this);
@@ -14,7 +14,16 @@ enum class FormatType {
   Pbf = 0,
   Xml = 1,
   Shape = 2,
-  Json = 3
+  Json = 3,
+  Mvt = 4
+};
+
+/// Action of osm change file which is applied to following elements.
+enum class ChangeAction {
+  None = 0,
+  Create = 1,
+  Modify = 2,
+  Delete = 3
 };
 
 struct Tag final {
@@ -0,0 +1,345 @@
+#ifndef FORMATS_MVT_MVTPARSER_HPP_INCLUDED
+#define FORMATS_MVT_MVTPARSER_HPP_INCLUDED
+
+#include "GeoCoordinate.hpp"
+#include "QuadKey.hpp"
+#include "formats/FormatTypes.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/GeometryUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace utymap {
+namespace formats {
+
+/// Parses Mapbox vector tiles (version 2). Features are passed to visitor in the same way
+/// as shapefile records: points as nodes, lines as ways, polygons without holes as rings
+/// and other multi geometries as relations. Name of layer is added to tags of its features.
+/// NOTE tile is expected to be decompressed: gzip encoded tiles are rejected.
+template<typename Visitor>
+class MvtParser final {
+  enum class GeometryType { Unknown = 0, Point = 1, LineString = 2, Polygon = 3 };
+
+  /// Point in tile coordinates.
+  typedef std::pair<std::int64_t, std::int64_t> Point;
+  typedef std::vector<Point> Points;
+
+  /// Reads messages encoded in protocol buffers wire format.
+  class Reader final {
+   public:
+    Reader(const char *begin, const char *end) : current_(begin), end_(end), key_(0) {}
+
+    bool hasData() const {
+      return current_ < end_;
+    }
+
+    /// Reads key of next field. Returns false at the end of message.
+    bool next() {
+      if (!hasData()) return false;
+      key_ = varint();
+      return true;
+    }
+
+    std::uint32_t field() const {
+      return static_cast<std::uint32_t>(key_ >> 3);
+    }
+
+    std::uint64_t varint() {
+      std::uint64_t value = 0;
+      for (int shift = 0; shift < 64; shift += 7) {
+        if (!hasData()) break;
+        auto byte = static_cast<std::uint8_t>(*current_++);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return value;
+      }
+      throw std::domain_error("Invalid vector tile varint.");
+    }
+
+    /// Reads length delimited field as nested message or packed values.
+    Reader message() {
+      auto size = static_cast<std::size_t>(varint());
+      if (size > static_cast<std::size_t>(end_ - current_))
+        throw std::domain_error("Invalid vector tile message length.");
+      Reader reader(current_, current_ + size);
+      current_ += size;
+      return reader;
+    }
+
+    std::string string() {
+      auto reader = message();
+      return std::string(reader.current_, reader.end_);
+    }
+
+    template<typename T>
+    T fixed() {
+      if (sizeof(T) > static_cast<std::size_t>(end_ - current_))
+        throw std::domain_error("Invalid vector tile fixed value.");
+      T value;
+      std::memcpy(&value, current_, sizeof(T));
+      current_ += sizeof(T);
+      return value;
+    }
+
+    void skip() {
+      switch (key_ & 0x07) {
+        case 0: varint(); break;
+        case 1: fixed<std::uint64_t>(); break;
+        case 2: message(); break;
+        case 5: fixed<std::uint32_t>(); break;
+        default: throw std::domain_error("Unsupported vector tile wire type.");
+      }
+    }
+
+   private:
+    const char *current_;
+    const char *end_;
+    std::uint64_t key_;
+  };
+
+  /// Keeps data shared by features of layer.
+  struct Layer final {
+    std::string name;
+    std::vector<std::string> keys;
+    std::vector<std::string> values;
+    double extent = 4096;
+  };
+
+ public:
+  /// Key of tag which keeps name of layer.
+  static const std::string &layerKey() {
+    static const std::string key = "mvt:layer";
+    return key;
+  }
+
+  /// Parses data of given tile from stream calling visitor.
+  void parse(std::istream &istream, const utymap::QuadKey &tile, Visitor &visitor) const {
+    std::string data((std::istreambuf_iterator<char>(istream)), std::istreambuf_iterator<char>());
+    if (data.size() > 1 && static_cast<std::uint8_t>(data[0]) == 0x1F && static_cast<std::uint8_t>(data[1]) == 0x8B)
+      throw std::domain_error("Compressed vector tiles are not supported.");
+
+    Reader reader(data.data(), data.data() + data.size());
+    while (reader.next()) {
+      if (reader.field() == 3)
+        parseLayer(reader.message(), tile, visitor);
+      else
+        reader.skip();
+    }
+  }
+
+  /// Returns tile from path which ends with zoom/x/y.mvt.
+  static utymap::QuadKey getTile(const std::string &path) {
+    std::vector<std::string> tokens;
+    std::string token;
+    for (char c : path.substr(0, path.find_last_of('.'))) {
+      if (c == '/' || c == '\\') {
+        tokens.push_back(token);
+        token.clear();
+      } else {
+        token.push_back(c);
+      }
+    }
+    tokens.push_back(token);
+
+    if (tokens.size() < 3)
+      throw std::domain_error("Cannot get tile from path: " + path);
+    int numbers[3];
+    for (std::size_t i = 0; i < 3; ++i) {
+      const auto &number = tokens[tokens.size() - 3 + i];
+      if (number.empty() || number.size() > 9 || !std::all_of(number.begin(), number.end(), ::isdigit))
+        throw std::domain_error("Cannot get tile from path: " + path);
+      numbers[i] = std::stoi(number);
+    }
+    return utymap::QuadKey(numbers[0], numbers[1], numbers[2]);
+  }
+
+ private:
+  void parseLayer(Reader reader, const utymap::QuadKey &tile, Visitor &visitor) const {
+    // NOTE keys and values may follow features, so features are decoded once layer is read.
+    Layer layer;
+    std::vector<Reader> features;
+    while (reader.next()) {
+      switch (reader.field()) {
+        case 1: layer.name = reader.string(); break;
+        case 2: features.push_back(reader.message()); break;
+        case 3: layer.keys.push_back(reader.string()); break;
+        case 4: layer.values.push_back(parseValue(reader.message())); break;
+        case 5: layer.extent = static_cast<double>(reader.varint()); break;
+        default: reader.skip(); break;
+      }
+    }
+    if (layer.extent <= 0)
+      throw std::domain_error("Invalid vector tile extent.");
+
+    for (auto &feature : features)
+      parseFeature(feature, layer, tile, visitor);
+  }
+
+  static std::string parseValue(Reader reader) {
+    std::string value;
+    while (reader.next()) {
+      switch (reader.field()) {
+        case 1: value = reader.string(); break;
+        case 2: value = utymap::utils::toString(reader.template fixed<float>()); break;
+        case 3: value = utymap::utils::toString(reader.template fixed<double>()); break;
+        case 4: value = utymap::utils::toString(static_cast<std::int64_t>(reader.varint())); break;
+        case 5: value = utymap::utils::toString(reader.varint()); break;
+        case 6: {
+          auto raw = reader.varint();
+          value = utymap::utils::toString(static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1));
+          break;
+        }
+        case 7: value = reader.varint() != 0 ? "true" : "false"; break;
+        default: reader.skip(); break;
+      }
+    }
+    return value;
+  }
+
+  void parseFeature(Reader reader, const Layer &layer, const utymap::QuadKey &tile, Visitor &visitor) const {
+    Tags tags;
+    GeometryType type = GeometryType::Unknown;
+    std::vector<Points> parts;
+    while (reader.next()) {
+      switch (reader.field()) {
+        case 2: {
+          auto packed = reader.message();
+          while (packed.hasData()) {
+            auto key = static_cast<std::size_t>(packed.varint());
+            auto value = static_cast<std::size_t>(packed.varint());
+            if (key >= layer.keys.size() || value >= layer.values.size())
+              throw std::domain_error("Invalid vector tile feature tag.");
+            tags.push_back(Tag(layer.keys[key], layer.values[value]));
+          }
+          break;
+        }
+        case 3: type = static_cast<GeometryType>(reader.varint()); break;
+        case 4: parts = parseGeometry(reader.message()); break;
+        default: reader.skip(); break;
+      }
+    }
+
+    if (!layer.name.empty())
+      tags.push_back(Tag(layerKey(), layer.name));
+
+    switch (type) {
+      case GeometryType::Point: visitPoints(parts, layer, tile, tags, visitor); break;
+      case GeometryType::LineString: visitLines(parts, layer, tile, tags, visitor); break;
+      case GeometryType::Polygon: visitPolygons(parts, layer, tile, tags, visitor); break;
+      default: break;
+    }
+  }
+
+  /// Decodes commands of geometry. Every MoveTo starts new part.
+  static std::vector<Points> parseGeometry(Reader reader) {
+    const std::uint32_t MoveTo = 1, LineTo = 2, ClosePath = 7;
+    std::vector<Points> parts;
+    std::int64_t x = 0, y = 0;
+    while (reader.hasData()) {
+      auto command = static_cast<std::uint32_t>(reader.varint());
+      auto id = command & 0x07;
+      auto count = command >> 3;
+      if (id == ClosePath) continue;
+      if ((id != MoveTo && id != LineTo) || (id == LineTo && parts.empty()))
+        throw std::domain_error("Invalid vector tile geometry.");
+
+      for (std::uint32_t i = 0; i < count; ++i) {
+        auto dx = reader.varint();
+        auto dy = reader.varint();
+        x += static_cast<std::int64_t>(dx >> 1) ^ -static_cast<std::int64_t>(dx & 1);
+        y += static_cast<std::int64_t>(dy >> 1) ^ -static_cast<std::int64_t>(dy & 1);
+        if (id == MoveTo)
+          parts.push_back(Points());
+        parts.back().push_back(Point(x, y));
+      }
+    }
+    return parts;
+  }
+
+  static void visitPoints(const std::vector<Points> &parts, const Layer &layer, const utymap::QuadKey &tile,
+                          Tags &tags, Visitor &visitor) {
+    for (const auto &part : parts) {
+      for (const auto &point : part) {
+        auto coordinate = toGeo(point, layer, tile);
+        Tags pointTags = tags;
+        visitor.visitNode(coordinate, pointTags);
+      }
+    }
+  }
+
+  static void visitLines(const std::vector<Points> &parts, const Layer &layer, const utymap::QuadKey &tile,
+                         Tags &tags, Visitor &visitor) {
+    PolygonMembers members;
+    for (const auto &part : parts) {
+      if (part.size() < 2) continue;
+      members.push_back(PolygonMember{false, toGeo(part, layer, tile)});
+    }
+
+    if (members.size() == 1)
+      visitor.visitWay(members[0].coordinates, tags, false);
+    else if (members.size() > 1)
+      visitor.visitRelation(members, tags);
+  }
+
+  /// Visits polygon rings. Rings are classified by winding order in tile coordinates and
+  /// are oriented in the same way as rings of osm multipolygons. Last point is not repeated.
+  static void visitPolygons(const std::vector<Points> &parts, const Layer &layer, const utymap::QuadKey &tile,
+                            Tags &tags, Visitor &visitor) {
+    PolygonMembers members;
+    for (const auto &part : parts) {
+      if (part.size() < 3) continue;
+      std::int64_t area = getArea(part);
+      if (area == 0) continue;
+
+      auto coordinates = toGeo(part, layer, tile);
+      // NOTE y axis of tile points down, so exterior ring has positive area in tile and
+      // clockwise order in geo coordinates: it is reversed.
+      bool isExterior = area > 0;
+      if (isExterior == utymap::utils::isClockwise(coordinates))
+        std::reverse(coordinates.begin(), coordinates.end());
+      members.push_back(PolygonMember{true, std::move(coordinates)});
+    }
+
+    if (members.size() == 1)
+      visitor.visitWay(members[0].coordinates, tags, true);
+    else if (members.size() > 1)
+      visitor.visitRelation(members, tags);
+  }
+
+  static std::int64_t getArea(const Points &points) {
+    std::int64_t area = 0;
+    for (std::size_t p = points.size() - 1, q = 0; q < points.size(); p = q++)
+      area += points[p].first * points[q].second - points[q].first * points[p].second;
+    return area;
+  }
+
+  static Coordinates toGeo(const Points &points, const Layer &layer, const utymap::QuadKey &tile) {
+    Coordinates coordinates;
+    coordinates.reserve(points.size());
+    for (const auto &point : points)
+      coordinates.push_back(toGeo(point, layer, tile));
+    return coordinates;
+  }
+
+  /// Converts point in tile coordinates to geo coordinate using web mercator projection.
+  static utymap::GeoCoordinate toGeo(const Point &point, const Layer &layer, const utymap::QuadKey &tile) {
+    const double pi = std::acos(-1);
+    double size = std::pow(2.0, tile.levelOfDetail);
+    double x = (tile.tileX + point.first / layer.extent) / size;
+    double y = (tile.tileY + point.second / layer.extent) / size;
+    return utymap::GeoCoordinate(std::atan(std::sinh(pi * (1 - 2 * y))) * 180 / pi, x * 360 - 180);
+  }
+};
+
+}
+}
+
+#endif  // FORMATS_MVT_MVTPARSER_HPP_INCLUDED
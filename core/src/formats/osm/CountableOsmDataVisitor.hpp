@@ -26,6 +26,9 @@ struct CountableOsmDataVisitor : public utymap::entities::ElementVisitor {
     bounds++;
   }
 
+  void visitChange(ChangeAction action) {
+  }
+
   void visitNode(uint64_t id, utymap::GeoCoordinate &coordinate, Tags &tags) {
     nodes++;
   }
@@ -1,3 +1,4 @@
+#include "BoundingBox.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
@@ -7,6 +8,11 @@
 #include "utils/GeoUtils.hpp"
 #include "utils/GeometryUtils.hpp"
 
+#include <algorithm>
+#include <numeric>
+#include <set>
+#include <unordered_map>
+
 using namespace utymap;
 using namespace utymap::entities;
 using namespace utymap::formats;
@@ -15,6 +21,32 @@ using namespace utymap::index;
 typedef std::deque<GeoCoordinate> Coords;
 typedef std::vector<int> Ints;
 
+namespace {
+/// Hashes coordinate by exact values of its components.
+struct CoordinateHash final {
+  std::size_t operator()(const GeoCoordinate &coordinate) const {
+    std::size_t seed = std::hash<double>()(coordinate.latitude);
+    return seed ^ (std::hash<double>()(coordinate.longitude) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+  }
+};
+
+/// Compares coordinates by exact values to be consistent with hash.
+struct CoordinateEqual final {
+  bool operator()(const GeoCoordinate &lhs, const GeoCoordinate &rhs) const {
+    return lhs.latitude==rhs.latitude && lhs.longitude==rhs.longitude;
+  }
+};
+
+/// Maps end point of sequence to its index.
+typedef std::unordered_multimap<GeoCoordinate, std::size_t, CoordinateHash, CoordinateEqual> EndPointMap;
+
+/// Checks whether inner bounding box is inside or equal to outer one.
+bool containsBox(const BoundingBox &outer, const BoundingBox &inner) {
+  return outer.minPoint.latitude <= inner.minPoint.latitude && outer.minPoint.longitude <= inner.minPoint.longitude &&
+      outer.maxPoint.latitude >= inner.maxPoint.latitude && outer.maxPoint.longitude >= inner.maxPoint.longitude;
+}
+}
+
 struct MultipolygonProcessor::CoordinateSequence final {
   std::uint64_t id;
   Coords coordinates;
@@ -56,6 +88,11 @@ struct MultipolygonProcessor::CoordinateSequence final {
     return false;
   }
 
+  /// Checks whether other sequence can be added by tryAdd.
+  bool isAdjacent(const CoordinateSequence &other) const {
+    return last()==other.first() || last()==other.last() || first()==other.last() || first()==other.first();
+  }
+
   bool isClosed() const {
     return coordinates.size() > 1 && coordinates[0]==coordinates[coordinates.size() - 1];
   }
@@ -66,12 +103,12 @@ struct MultipolygonProcessor::CoordinateSequence final {
     });
   }
 
- private:
-
   GeoCoordinate first() const { return coordinates[0]; }
 
   GeoCoordinate last() const { return coordinates[coordinates.size() - 1]; }
 
+ private:
+
   void addToBegin(const Coords &other) { coordinates.insert(coordinates.begin(), other.begin(), other.end()); }
 
   void addToEnd(const Coords &other) { coordinates.insert(coordinates.end(), other.begin(), other.end()); }
@@ -82,8 +119,9 @@ struct MultipolygonProcessor::CoordinateSequence final {
 MultipolygonProcessor::MultipolygonProcessor(Relation &relation,
                                              const RelationMembers &members,
                                              OsmDataContext &context,
-                                             std::function<void(Relation &)> resolve)
-    : relation_(relation), members_(members), context_(context), resolve_(resolve) {
+                                             std::function<void(Relation &)> resolve,
+                                             const utymap::CancellationToken &cancelToken)
+    : relation_(relation), members_(members), context_(context), cancelToken_(cancelToken), resolve_(resolve) {
 }
 
 /// For algorithm details, see http://wiki.openstreetmap.org/wiki/Relation:multipolygon/Algorithm
@@ -178,87 +216,146 @@ void MultipolygonProcessor::complexCase(CoordinateSequences &sequences) const {
 
 std::vector<std::shared_ptr<MultipolygonProcessor::CoordinateSequence>> MultipolygonProcessor::createRings(
     CoordinateSequences &sequences) const {
+  // NOTE sequences are indexed by their end points, so the ring is continued without scanning all of them.
+  // Spent sequences are not removed from index, they are skipped instead.
+  EndPointMap endPoints;
+  endPoints.reserve(sequences.size() * 2);
+  for (std::size_t i = 0; i < sequences.size(); ++i) {
+    endPoints.emplace(sequences[i]->first(), i);
+    endPoints.emplace(sequences[i]->last(), i);
+  }
+
+  std::vector<bool> isUsed(sequences.size(), false);
+  std::size_t remaining = sequences.size();
+  std::size_t lastIndex = sequences.size();
+
+  // returns the first remaining sequence which touches given end point of the ring
+  auto findAdjacent = [&](const GeoCoordinate &endPoint, std::size_t index) {
+    auto range = endPoints.equal_range(endPoint);
+    for (auto it = range.first; it!=range.second; ++it) {
+      if (!isUsed[it->second])
+        index = std::min(index, it->second);
+    }
+    return index;
+  };
+
   CoordinateSequences closedRings;
   std::shared_ptr<MultipolygonProcessor::CoordinateSequence> currentRing = nullptr;
-  while (!sequences.empty()) {
+  while (remaining > 0) {
+    // NOTE huge relations take long, so cancellation is checked per added sequence.
+    if (cancelToken_.isCancelled())
+      return CoordinateSequences();
+
+    std::size_t index = sequences.size();
     if (currentRing==nullptr) {
       // start a new ring with any remaining node sequence
-      auto lastIndex = sequences.size() - 1;
-      currentRing = sequences[lastIndex];
-      sequences.erase(sequences.begin() + lastIndex);
+      while (isUsed[--lastIndex]);
+      index = lastIndex;
+      currentRing = sequences[index];
     } else {
       // try to continue the ring by appending a node sequence
-      bool isFound = false;
-      for (auto it = sequences.begin(); it!=sequences.end(); ++it) {
-        if (!currentRing->tryAdd(**it)) continue;
-        isFound = true;
-        sequences.erase(it);
-        break;
+      index = findAdjacent(currentRing->first(), findAdjacent(currentRing->last(), index));
+
+      // NOTE end points are equal with tolerance, so fallback to full scan when exact match is not found.
+      for (std::size_t i = 0; index==sequences.size() && i < sequences.size(); ++i) {
+        if (!isUsed[i] && currentRing->isAdjacent(*sequences[i]))
+          index = i;
       }
 
-      if (!isFound)
+      if (index==sequences.size())
         return CoordinateSequences();
+
+      currentRing->tryAdd(*sequences[index]);
     }
+    isUsed[index] = true;
+    --remaining;
 
     // check whether the ring under construction is closed
-    if (currentRing!=nullptr && currentRing->isClosed()) {
+    if (currentRing->isClosed()) {
       // TODO check that it isn't self-intersecting!
       closedRings.push_back(currentRing);
       currentRing = nullptr;
     }
   }
 
+  sequences.clear();
   return std::move(closedRings);
 }
 
 void MultipolygonProcessor::fillRelation(CoordinateSequences &rings) const {
-  while (!rings.empty()) {
-    // find an outer ring
-    std::shared_ptr<CoordinateSequence> outer = nullptr;
-    for (auto candidate = rings.begin(); candidate!=rings.end(); ++candidate) {
-      bool containedInOtherRings = false;
-      for (auto other = rings.begin(); other!=rings.end(); ++other) {
-        if (other!=candidate && (*other)->containsRing((*candidate)->coordinates)) {
-          containedInOtherRings = true;
-          break;
-        }
-      }
-      if (containedInOtherRings) continue;
-      outer = *candidate;
-      rings.erase(candidate);
-      break;
+  // NOTE containment of rings is resolved once. Rings are sorted by min longitude of their bounding boxes,
+  // so only rings which start inside longitude range of the given one are checked. Bounding box check
+  // is done before point in polygon test.
+  std::vector<BoundingBox> boxes(rings.size());
+  for (std::size_t i = 0; i < rings.size(); ++i)
+    boxes[i].expand(rings[i]->coordinates.begin(), rings[i]->coordinates.end());
+
+  Ints order(rings.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int lhs, int rhs) {
+    return boxes[lhs].minPoint.longitude < boxes[rhs].minPoint.longitude;
+  });
+
+  // rings which are inside the given one
+  std::vector<Ints> contained(rings.size());
+  // amount of remaining rings which contain the given one
+  Ints containers(rings.size(), 0);
+  for (int outer = 0; outer < static_cast<int>(rings.size()); ++outer) {
+    const auto &box = boxes[outer];
+    auto start = std::lower_bound(order.begin(), order.end(), box.minPoint.longitude,
+                                  [&](int ring, double longitude) {
+                                    return boxes[ring].minPoint.longitude < longitude;
+                                  });
+    for (auto it = start; it!=order.end() && boxes[*it].minPoint.longitude <= box.maxPoint.longitude; ++it) {
+      int inner = *it;
+      if (inner==outer || !containsBox(box, boxes[inner]) || !rings[outer]->containsRing(rings[inner]->coordinates))
+        continue;
+      contained[outer].push_back(inner);
+      ++containers[inner];
     }
+    std::sort(contained[outer].begin(), contained[outer].end());
+  }
+
+  // remaining rings which are not contained in other remaining rings
+  std::set<int> candidates;
+  for (int i = 0; i < static_cast<int>(rings.size()); ++i) {
+    if (containers[i]==0)
+      candidates.insert(i);
+  }
+
+  std::vector<bool> isUsed(rings.size(), false);
+  auto use = [&](int ring) {
+    isUsed[ring] = true;
+    candidates.erase(ring);
+    for (int inner : contained[ring]) {
+      if (--containers[inner]==0 && !isUsed[inner])
+        candidates.insert(inner);
+    }
+  };
+
+  while (!candidates.empty()) {
+    // find an outer ring
+    int outer = *candidates.begin();
+    use(outer);
 
     // find inner rings of that ring
-    CoordinateSequences inners;
-    for (auto ring = rings.begin(); ring!=rings.end();) {
-      if (outer->containsRing((*ring)->coordinates)) {
-        bool containedInOthers = false;
-        for (auto other = rings.begin(); other!=rings.end(); ++other) {
-          if (other!=ring && (*other)->containsRing((*ring)->coordinates)) {
-            containedInOthers = true;
-            break;
-          }
-        }
-        if (!containedInOthers) {
-          inners.push_back(*ring);
-          ring = rings.erase(ring);
-          continue;
-        }
-      }
-      ++ring;
+    Ints inners;
+    for (int inner : contained[outer]) {
+      if (isUsed[inner] || containers[inner]!=0) continue;
+      inners.push_back(inner);
+      use(inner);
     }
 
     // outer
     auto outerArea = std::make_shared<Area>();
-    outerArea->id = outer->id;
-    insertCoordinates(outer->coordinates, outerArea->coordinates, true);
+    outerArea->id = rings[outer]->id;
+    insertCoordinates(rings[outer]->coordinates, outerArea->coordinates, true);
     relation_.elements.push_back(outerArea);
 
     // inner: create a new area and remove the used rings
-    for (const auto &innerRing : inners) {
+    for (int inner : inners) {
       auto innerArea = std::make_shared<Area>();
-      insertCoordinates(innerRing->coordinates, innerArea->coordinates, false);
+      insertCoordinates(rings[inner]->coordinates, innerArea->coordinates, false);
       relation_.elements.push_back(innerArea);
     }
   }
@@ -1,6 +1,7 @@
 #ifndef FORMATS_OSM_MULTIPOLYGONPROCESSOR_HPP_DEFINED
 #define FORMATS_OSM_MULTIPOLYGONPROCESSOR_HPP_DEFINED
 
+#include "CancellationToken.hpp"
 #include "GeoCoordinate.hpp"
 #include "formats/FormatTypes.hpp"
 #include "formats/osm/OsmDataContext.hpp"
@@ -25,7 +26,8 @@ struct MultipolygonProcessor final {
   MultipolygonProcessor(utymap::entities::Relation &relation,
                         const utymap::formats::RelationMembers &members,
                         OsmDataContext &context,
-                        std::function<void(utymap::entities::Relation &)> resolve);
+                        std::function<void(utymap::entities::Relation &)> resolve,
+                        const utymap::CancellationToken &cancelToken);
 
   /// Builds relation from multipolygon relation.
   void process();
@@ -51,6 +53,7 @@ struct MultipolygonProcessor final {
   utymap::entities::Relation &relation_;
   const utymap::formats::RelationMembers &members_;
   utymap::formats::OsmDataContext &context_;
+  const utymap::CancellationToken &cancelToken_;
   std::function<void(utymap::entities::Relation &)> resolve_;
 };
 
@@ -0,0 +1,273 @@
+#include "formats/osm/NodeLocationStore.hpp"
+#include "math/FixedPoint.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::formats;
+using namespace utymap::math;
+
+namespace {
+const char FileMagic[] = { 'U', 'T', 'N', 'L' };
+const std::uint32_t FileVersion = 1;
+
+struct Location {
+  std::uint64_t id;
+  std::int32_t latitude;
+  std::int32_t longitude;
+};
+
+struct FileHeader {
+  char magic[sizeof(FileMagic)];
+  std::uint32_t version;
+  std::uint64_t stamp;
+  std::uint64_t count;
+  /// Non zero if all locations are written, sorted and unique.
+  std::uint64_t isComplete;
+};
+
+GeoCoordinate toCoordinate(const Location &location) {
+  return GeoCoordinate(fromFixed(location.latitude), fromFixed(location.longitude));
+}
+
+/// Sorts locations by id and removes duplicates keeping last added one. Returns new end.
+Location *normalize(Location *begin, Location *end) {
+  std::stable_sort(begin, end, [](const Location &left, const Location &right) { return left.id < right.id; });
+  auto last = std::unique(std::reverse_iterator<Location *>(end), std::reverse_iterator<Location *>(begin),
+                          [](const Location &left, const Location &right) { return left.id == right.id; });
+  auto first = last.base();
+  return first == begin ? end : std::move(first, end, begin);
+}
+
+bool find(const Location *begin, const Location *end, std::uint64_t id, GeoCoordinate &coordinate) {
+  auto it = std::lower_bound(begin, end, id, [](const Location &location, std::uint64_t value) {
+    return location.id < value;
+  });
+  if (it == end || it->id != id)
+    return false;
+
+  coordinate = toCoordinate(*it);
+  return true;
+}
+}
+
+class NodeLocationStore::NodeLocationStoreImpl {
+ public:
+  virtual ~NodeLocationStoreImpl() = default;
+  virtual void reserve(std::size_t count) = 0;
+  virtual void add(const Location &location) = 0;
+  virtual bool find(std::uint64_t id, GeoCoordinate &coordinate) = 0;
+  virtual std::size_t size() const = 0;
+  virtual bool isReused() const = 0;
+};
+
+/// Keeps locations in vector.
+class NodeLocationStore::MemoryStore final : public NodeLocationStore::NodeLocationStoreImpl {
+ public:
+  MemoryStore() : locations_(), isSorted_(true) {}
+
+  void reserve(std::size_t count) override {
+    locations_.reserve(count);
+  }
+
+  void add(const Location &location) override {
+    if (!locations_.empty() && locations_.back().id >= location.id)
+      isSorted_ = false;
+    locations_.push_back(location);
+  }
+
+  bool find(std::uint64_t id, GeoCoordinate &coordinate) override {
+    if (!isSorted_) {
+      auto data = locations_.data();
+      locations_.resize(static_cast<std::size_t>(normalize(data, data + locations_.size()) - data));
+      isSorted_ = true;
+    }
+    return ::find(locations_.data(), locations_.data() + locations_.size(), id, coordinate);
+  }
+
+  std::size_t size() const override {
+    return locations_.size();
+  }
+
+  bool isReused() const override {
+    return false;
+  }
+
+ private:
+  std::vector<Location> locations_;
+  bool isSorted_;
+};
+
+/// Appends locations to file and memory maps it on first lookup.
+class NodeLocationStore::FileStore final : public NodeLocationStore::NodeLocationStoreImpl {
+ public:
+  FileStore(const std::string &path, std::uint64_t stamp) :
+      path_(path), stamp_(stamp), count_(0), lastId_(0), isSorted_(true), isReused_(false),
+      mapping_(), region_(), locations_(nullptr) {
+    if (open())
+      isReused_ = true;
+    else
+      create();
+  }
+
+  ~FileStore() {
+    // NOTE incomplete file is kept: it is rebuilt when store is created next time.
+    if (file_.is_open())
+      file_.close();
+  }
+
+  void reserve(std::size_t) override {}
+
+  void add(const Location &location) override {
+    if (isReused_) return;
+    if (!file_.is_open())
+      throw std::domain_error("Cannot add node location after lookup.");
+
+    if (count_ > 0 && lastId_ >= location.id)
+      isSorted_ = false;
+    file_.write(reinterpret_cast<const char *>(&location), sizeof(location));
+    lastId_ = location.id;
+    ++count_;
+  }
+
+  bool find(std::uint64_t id, GeoCoordinate &coordinate) override {
+    if (file_.is_open())
+      complete();
+    return ::find(locations_, locations_ + count_, id, coordinate);
+  }
+
+  std::size_t size() const override {
+    return static_cast<std::size_t>(count_);
+  }
+
+  bool isReused() const override {
+    return isReused_;
+  }
+
+ private:
+  /// Maps existing complete file. Returns false if file cannot be reused.
+  bool open() {
+    boost::system::error_code error;
+    auto size = boost::filesystem::file_size(path_, error);
+    if (error || size < sizeof(FileHeader))
+      return false;
+
+    FileHeader header;
+    std::ifstream file(path_, std::ios::in | std::ios::binary);
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    bool isValid = file.good() &&
+        std::memcmp(header.magic, FileMagic, sizeof(FileMagic)) == 0 &&
+        header.version == FileVersion &&
+        header.stamp == stamp_ &&
+        header.isComplete != 0 &&
+        size == sizeof(FileHeader) + header.count * sizeof(Location);
+    if (!isValid)
+      return false;
+
+    file.close();
+    count_ = header.count;
+    map(boost::interprocess::read_only);
+    return true;
+  }
+
+  void create() {
+    file_.open(path_, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_.good())
+      throw std::domain_error("Cannot create node location file: " + path_);
+    writeHeader(file_, false);
+  }
+
+  /// Finishes writing, sorts locations if needed and maps file for lookup.
+  void complete() {
+    file_.close();
+    if (!isSorted_) {
+      map(boost::interprocess::read_write);
+      count_ = static_cast<std::uint64_t>(normalize(locations_, locations_ + count_) - locations_);
+      region_.flush();
+      unmap();
+      boost::filesystem::resize_file(path_, sizeof(FileHeader) + count_ * sizeof(Location));
+    }
+
+    std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+    writeHeader(file, true);
+    file.close();
+
+    map(boost::interprocess::read_only);
+  }
+
+  void writeHeader(std::ostream &out, bool isComplete) const {
+    FileHeader header;
+    std::memcpy(header.magic, FileMagic, sizeof(FileMagic));
+    header.version = FileVersion;
+    header.stamp = stamp_;
+    header.count = count_;
+    header.isComplete = isComplete ? 1 : 0;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+
+  void map(boost::interprocess::mode_t mode) {
+    mapping_ = boost::interprocess::file_mapping(path_.c_str(), mode);
+    region_ = boost::interprocess::mapped_region(mapping_, mode);
+    auto data = static_cast<char *>(region_.get_address());
+    locations_ = reinterpret_cast<Location *>(data + sizeof(FileHeader));
+  }
+
+  void unmap() {
+    region_ = boost::interprocess::mapped_region();
+    mapping_ = boost::interprocess::file_mapping();
+    locations_ = nullptr;
+  }
+
+  const std::string path_;
+  const std::uint64_t stamp_;
+  std::uint64_t count_;
+  std::uint64_t lastId_;
+  bool isSorted_;
+  bool isReused_;
+  std::ofstream file_;
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+  Location *locations_;
+};
+
+NodeLocationStore::NodeLocationStore() :
+    pimpl_(utymap::utils::make_unique<MemoryStore>()) {
+}
+
+NodeLocationStore::NodeLocationStore(const std::string &path, std::uint64_t stamp) :
+    pimpl_(utymap::utils::make_unique<FileStore>(path, stamp)) {
+}
+
+NodeLocationStore::~NodeLocationStore() {
+}
+
+void NodeLocationStore::reserve(std::size_t count) {
+  pimpl_->reserve(count);
+}
+
+void NodeLocationStore::add(std::uint64_t id, const GeoCoordinate &coordinate) {
+  pimpl_->add(Location{id, toFixed(coordinate.latitude), toFixed(coordinate.longitude)});
+}
+
+bool NodeLocationStore::find(std::uint64_t id, GeoCoordinate &coordinate) const {
+  return pimpl_->find(id, coordinate);
+}
+
+std::size_t NodeLocationStore::size() const {
+  return pimpl_->size();
+}
+
+bool NodeLocationStore::isReused() const {
+  return pimpl_->isReused();
+}
@@ -0,0 +1,56 @@
+#ifndef FORMATS_OSM_NODELOCATIONSTORE_HPP_DEFINED
+#define FORMATS_OSM_NODELOCATIONSTORE_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace utymap {
+namespace formats {
+
+/// Keeps node coordinates in compact form: sorted array of ids with fixed point
+/// latitude and longitude, so one location takes 16 bytes.
+/// Array is kept either in memory or in memory mapped file, so operating system
+/// can page it in and out while importing files which do not fit into memory.
+/// NOTE nodes are usually added in id order, otherwise array is sorted on first lookup.
+class NodeLocationStore final {
+ public:
+  /// Creates store which keeps locations in memory.
+  NodeLocationStore();
+
+  /// Creates store which keeps locations in file. If file is complete and it was
+  /// built with the same stamp, it is reused and new locations are ignored.
+  /// Stamp should identify source data, e.g. using its size and modification time.
+  NodeLocationStore(const std::string &path, std::uint64_t stamp);
+
+  ~NodeLocationStore();
+
+  /// Reserves space for given amount of locations.
+  void reserve(std::size_t count);
+
+  /// Adds location of node.
+  /// NOTE locations cannot be added to file after first lookup.
+  void add(std::uint64_t id, const utymap::GeoCoordinate &coordinate);
+
+  /// Finds location of node. Returns false if node is not found.
+  bool find(std::uint64_t id, utymap::GeoCoordinate &coordinate) const;
+
+  /// Returns amount of stored locations.
+  std::size_t size() const;
+
+  /// Returns true if locations are read from existing file, so adding is not needed.
+  bool isReused() const;
+
+ private:
+  class NodeLocationStoreImpl;
+  class MemoryStore;
+  class FileStore;
+  std::unique_ptr<NodeLocationStoreImpl> pimpl_;
+};
+
+}
+}
+
+#endif // FORMATS_OSM_NODELOCATIONSTORE_HPP_DEFINED
@@ -6,8 +6,12 @@
 #include "formats/osm/MultipolygonProcessor.hpp"
 #include "formats/osm/RelationProcessor.hpp"
 #include "formats/osm/OsmDataVisitor.hpp"
+#include "index/ElementGeometryVisitor.hpp"
+#include "utils/CoreUtils.hpp"
 #include "utils/GeometryUtils.hpp"
 
+#include <atomic>
+#include <mutex>
 #include <unordered_set>
 
 using namespace utymap;
@@ -15,24 +19,89 @@ using namespace utymap::formats;
 using namespace utymap::entities;
 using namespace utymap::index;
 
+namespace {
+/// Amount of elements which are added by single task.
+const std::size_t AddChunkSize = 256;
+
+/// Gets key of relation member which is used to group relations. Ways and relations share
+/// the same key space as multipolygon way member can be resolved as relation.
+std::uint64_t getMemberKey(std::uint64_t id, bool isNode) {
+  return (id << 1) | (isNode ? 1 : 0);
+}
+
+/// Finds root of set with path halving.
+std::size_t findRoot(std::vector<std::size_t> &parents, std::size_t index) {
+  while (parents[index] != index) {
+    parents[index] = parents[parents[index]];
+    index = parents[index];
+  }
+  return index;
+}
+}
+
+void OsmDataVisitor::setBoundingBox(const BoundingBox &bbox) {
+  filterBbox_ = bbox;
+}
+
 void OsmDataVisitor::visitBounds(BoundingBox bbox) {
   bbox_ = bbox;
 }
 
+void OsmDataVisitor::setNodeResolver(std::function<bool(std::uint64_t, GeoCoordinate &)> resolver) {
+  nodeResolver_ = std::move(resolver);
+}
+
+void OsmDataVisitor::visitChange(ChangeAction action) {
+  changeAction_ = action;
+}
+
+bool OsmDataVisitor::visitChanged(std::uint64_t id) {
+  if (changeAction_ == ChangeAction::Modify || changeAction_ == ChangeAction::Delete)
+    changedIds_.insert(id);
+  return changeAction_ != ChangeAction::Delete;
+}
+
 void OsmDataVisitor::visitNode(std::uint64_t id, GeoCoordinate &coordinate, utymap::formats::Tags &tags) {
+  if (!visitChanged(id)) return;
+
+  if (!nodeLocations_->isReused() &&
+      (references_ == nullptr || references_->findWayNode(id) != OsmReferences::NotFound))
+    nodeLocations_->add(id, coordinate);
+
+  bool isReferenced = references_ == nullptr ? !tags.empty() : references_->isRelationNode(id);
+  // NOTE node outside is dropped before it is created unless relation can use it.
+  if (!isReferenced && filterBbox_.isValid() && !filterBbox_.contains(coordinate))
+    return;
+
   auto node = std::make_shared<Node>();
   node->id = id;
   node->coordinate = coordinate;
   utymap::utils::setTags(stringTable_, *node, tags);
-  context_.nodeMap[id] = node;
+  // NOTE in single pass mode only tagged nodes can be resolved as relation members.
+  keepOrAdd(node, context_.nodeMap, isReferenced);
 }
 
 void OsmDataVisitor::visitWay(std::uint64_t id, std::vector<std::uint64_t> &nodeIds, utymap::formats::Tags &tags) {
+  if (!visitChanged(id)) return;
+
   std::vector<GeoCoordinate> coordinates;
   coordinates.reserve(nodeIds.size());
+  GeoCoordinate coordinate;
+  bool isResolved = true;
   for (auto nodeId : nodeIds) {
-    coordinates.push_back(context_.nodeMap[nodeId]->coordinate);
+    // NOTE nodes missing in file and unknown to resolver are skipped.
+    if (nodeLocations_->find(nodeId, coordinate) || (nodeResolver_ && nodeResolver_(nodeId, coordinate)))
+      coordinates.push_back(coordinate);
+    else
+      isResolved = false;
   }
+
+  // NOTE incomplete way would replace complete old version.
+  if (!isResolved && changeAction_ == ChangeAction::Modify) {
+    changedIds_.erase(id);
+    return;
+  }
+  bool isReferenced = references_ == nullptr || references_->isRelationWay(id);
   auto size = coordinates.size();
   if (size > 3 && coordinates[0]==coordinates[size - 1]) {
     coordinates.pop_back();
@@ -44,18 +113,20 @@ void OsmDataVisitor::visitWay(std::uint64_t id, std::vector<std::uint64_t> &node
     }
     area->coordinates = std::move(coordinates);
     utymap::utils::setTags(stringTable_, *area, tags);
-    context_.areaMap[id] = area;
+    keepOrAdd(area, context_.areaMap, isReferenced);
 
   } else {
     auto way = std::make_shared<Way>();
     way->id = id;
     way->coordinates = std::move(coordinates);
     utymap::utils::setTags(stringTable_, *way, tags);
-    context_.wayMap[id] = way;
+    keepOrAdd(way, context_.wayMap, isReferenced);
   }
 }
 
 void OsmDataVisitor::visitRelation(std::uint64_t id, RelationMembers &members, utymap::formats::Tags &tags) {
+  if (!visitChanged(id)) return;
+
   auto relation = std::make_shared<Relation>();
   relation->id = id;
   relation->tags = utymap::utils::convertTags(stringTable_, tags);
@@ -66,11 +137,25 @@ void OsmDataVisitor::visitRelation(std::uint64_t id, RelationMembers &members, u
   context_.relationMap[id] = relation;
 }
 
+template<typename T>
+void OsmDataVisitor::keepOrAdd(const std::shared_ptr<T> &element,
+                               std::unordered_map<std::uint64_t, std::shared_ptr<T>> &map,
+                               bool isReferenced) {
+  if (isReferenced)
+    map[element->id] = element;
+  else
+    add(*element);
+}
+
 void OsmDataVisitor::add(utymap::entities::Element &element) {
-  if (cancelToken_.isCancelled()) return;
+  if (cancelToken_.isCancelled() || !isInside(element)) return;
   add_(element);
 }
 
+bool OsmDataVisitor::isInside(const utymap::entities::Element &element) const {
+  return !filterBbox_.isValid() || utymap::index::ElementGeometryVisitor::intersects(element, filterBbox_);
+}
+
 bool OsmDataVisitor::hasTag(const std::string &key,
                             const std::string &value,
                             const std::vector<utymap::entities::Tag> &tags) const {
@@ -88,7 +173,7 @@ void OsmDataVisitor::resolve(Relation &relation) {
   auto resolveFunc = std::bind(&OsmDataVisitor::resolve, this, std::placeholders::_1);
 
   if (hasTag("type", "multipolygon", relation.tags))
-    MultipolygonProcessor(relation, membersPair->second, context_, resolveFunc).process();
+    MultipolygonProcessor(relation, membersPair->second, context_, resolveFunc, cancelToken_).process();
   else if (hasTag("type", "building", relation.tags))
     BuildingProcessor(relation, membersPair->second, context_, resolveFunc).process();
   else {
@@ -101,10 +186,19 @@ utymap::BoundingBox OsmDataVisitor::complete() {
   if (cancelToken_.isCancelled()) return utymap::BoundingBox();
 
   // All relations are visited can start to resolve them
-  for (auto &membersPair : relationMembers_) {
-    auto relationPair = context_.relationMap.find(membersPair.first);
-    if (relationPair!=context_.relationMap.end())
-      resolve(*relationPair->second);
+  if (completionPool_.get() != nullptr) {
+    resolveParallel();
+  } else {
+    for (auto &membersPair : relationMembers_) {
+      auto relationPair = context_.relationMap.find(membersPair.first);
+      if (relationPair!=context_.relationMap.end())
+        resolve(*relationPair->second);
+    }
+  }
+
+  if (completionPool_.get() != nullptr && isAddConcurrent_) {
+    addParallel();
+    return bbox_;
   }
 
   for (const auto &pair : context_.relationMap) {
@@ -126,8 +220,125 @@ utymap::BoundingBox OsmDataVisitor::complete() {
   return bbox_;
 }
 
+void OsmDataVisitor::resolveParallel() {
+  // NOTE processors change members and resolve member relations, so relations which
+  // share members are grouped using disjoint sets of member keys.
+  std::unordered_map<std::uint64_t, std::size_t> indices;
+  std::vector<std::size_t> parents;
+  auto getIndex = [&](std::uint64_t key) {
+    auto result = indices.emplace(key, parents.size());
+    if (result.second)
+      parents.push_back(parents.size());
+    return result.first->second;
+  };
+
+  std::vector<std::pair<Relation *, std::size_t>> relations;
+  for (const auto &membersPair : relationMembers_) {
+    auto relationPair = context_.relationMap.find(membersPair.first);
+    if (relationPair==context_.relationMap.end())
+      continue;
+
+    auto index = getIndex(getMemberKey(membersPair.first, false));
+    relations.emplace_back(relationPair->second.get(), index);
+    for (const auto &member : membersPair.second) {
+      auto root = findRoot(parents, getIndex(getMemberKey(member.refId, member.type=="n")));
+      parents[root] = findRoot(parents, index);
+    }
+  }
+
+  std::unordered_map<std::size_t, std::size_t> groupIndices;
+  std::vector<std::vector<Relation *>> groups;
+  for (const auto &pair : relations) {
+    auto group = groupIndices.emplace(findRoot(parents, pair.second), groups.size());
+    if (group.second)
+      groups.emplace_back();
+    groups[group.first->second].push_back(pair.first);
+  }
+
+  runParallel(groups.size(), [&](std::size_t i) {
+    for (auto *relation : groups[i])
+      resolve(*relation);
+  });
+}
+
+void OsmDataVisitor::addParallel() {
+  std::vector<Element *> elements;
+  elements.reserve(context_.relationMap.size() + context_.nodeMap.size() +
+      context_.wayMap.size() + context_.areaMap.size());
+  for (const auto &pair : context_.relationMap)
+    elements.push_back(pair.second.get());
+  for (const auto &pair : context_.nodeMap)
+    elements.push_back(pair.second.get());
+  for (const auto &pair : context_.wayMap)
+    elements.push_back(pair.second.get());
+  for (const auto &pair : context_.areaMap)
+    elements.push_back(pair.second.get());
+
+  runParallel((elements.size() + AddChunkSize - 1)/AddChunkSize, [&](std::size_t i) {
+    auto end = std::min(elements.size(), (i + 1)*AddChunkSize);
+    for (auto j = i*AddChunkSize; j < end; ++j)
+      add(*elements[j]);
+  });
+}
+
+void OsmDataVisitor::runParallel(std::size_t count, const std::function<void(std::size_t)> &work) {
+  std::atomic<std::size_t> next(0);
+  std::exception_ptr error;
+  std::mutex errorLock;
+  auto run = [&]() {
+    for (std::size_t i = next++; i < count; i = next++) {
+      try {
+        work(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorLock);
+        if (error == nullptr) error = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<utymap::utils::ThreadPool::Future> futures;
+  for (std::size_t i = 0; i < completionPool_.size(); ++i)
+    futures.push_back(completionPool_.get()->enqueue(run));
+  run();
+
+  // NOTE tasks refer to local state, so all of them should be finished before error is rethrown.
+  for (auto &future : futures)
+    future.wait();
+  if (error != nullptr)
+    std::rethrow_exception(error);
+}
+
+void OsmDataVisitor::setCompletionThreads(std::size_t threadCount,
+                                          utymap::utils::ThreadPool *threadPool,
+                                          bool isAddConcurrent) {
+  completionPool_ = utymap::utils::ThreadPoolShare(threadPool);
+  completionPool_.resize(threadCount);
+  isAddConcurrent_ = isAddConcurrent;
+}
+
+const std::unordered_set<std::uint64_t> &OsmDataVisitor::getChangedIds() const {
+  return changedIds_;
+}
+
 OsmDataVisitor::OsmDataVisitor(const StringTable &stringTable,
                                std::function<bool(Element &)> add,
                                const utymap::CancellationToken &cancelToken) :
-  stringTable_(stringTable), add_(add), cancelToken_(cancelToken), context_(), bbox_() {
+  stringTable_(stringTable), add_(add), cancelToken_(cancelToken), context_(), bbox_(), filterBbox_(),
+  nodeLocations_(utymap::utils::make_unique<NodeLocationStore>()), changeAction_(ChangeAction::None),
+  completionPool_(), isAddConcurrent_(false) {
+}
+
+OsmDataVisitor::OsmDataVisitor(const StringTable &stringTable,
+                               std::function<bool(Element &)> add,
+                               const utymap::CancellationToken &cancelToken,
+                               OsmReferences references) :
+  stringTable_(stringTable), add_(add), cancelToken_(cancelToken), context_(), bbox_(), filterBbox_(),
+  references_(utymap::utils::make_unique<OsmReferences>(std::move(references))),
+  nodeLocations_(utymap::utils::make_unique<NodeLocationStore>()), changeAction_(ChangeAction::None),
+  completionPool_(), isAddConcurrent_(false) {
+  nodeLocations_->reserve(references_->wayNodeCount());
+}
+
+void OsmDataVisitor::setNodeLocationStore(std::unique_ptr<NodeLocationStore> nodeLocations) {
+  nodeLocations_ = std::move(nodeLocations);
 }
@@ -6,13 +6,18 @@
 #include "GeoCoordinate.hpp"
 #include "entities/Element.hpp"
 #include "formats/FormatTypes.hpp"
+#include "formats/osm/NodeLocationStore.hpp"
 #include "formats/osm/OsmDataContext.hpp"
+#include "formats/osm/OsmReferenceVisitor.hpp"
 #include "index/StringTable.hpp"
+#include "utils/ThreadPool.hpp"
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace utymap {
 namespace formats {
@@ -24,8 +29,39 @@ class OsmDataVisitor final {
                  std::function<bool(utymap::entities::Element &)> add,
                  const utymap::CancellationToken &cancelToken);
 
+  /// Creates visitor for second pass of two pass import. Only coordinates of nodes used by
+  /// ways are kept and elements which are not relation members are added once visited.
+  /// NOTE nodes should be visited before ways as in sorted osm files.
+  OsmDataVisitor(const utymap::index::StringTable &stringTable,
+                 std::function<bool(utymap::entities::Element &)> add,
+                 const utymap::CancellationToken &cancelToken,
+                 utymap::formats::OsmReferences references);
+
+  /// Replaces store of node locations, e.g. with file backed one. Should be called before nodes are visited.
+  void setNodeLocationStore(std::unique_ptr<utymap::formats::NodeLocationStore> nodeLocations);
+
+  /// Sets bounding box which is used to drop elements outside of it while parsing.
+  /// NOTE locations of dropped nodes are still kept as ways may cross bounding box.
+  void setBoundingBox(const utymap::BoundingBox &bbox);
+
+  /// Sets amount of tasks which complete import on given pool or on own threads if pool is
+  /// not set: relations which don't share members are resolved in parallel. Elements are
+  /// added in parallel too if add callback can be called concurrently.
+  /// Zero means that completion runs on calling thread.
+  void setCompletionThreads(std::size_t threadCount, utymap::utils::ThreadPool *threadPool, bool isAddConcurrent);
+
+  /// Sets function which finds locations of nodes missing in file, e.g. in existing store
+  /// when osm change file is applied.
+  void setNodeResolver(std::function<bool(std::uint64_t, utymap::GeoCoordinate &)> resolver);
+
   void visitBounds(utymap::BoundingBox bbox);
 
+  /// Sets action of osm change file for following elements. Deleted elements are
+  /// not added, ids of modified and deleted elements are collected.
+  /// NOTE modified way which nodes cannot be resolved is not added and its id is not
+  /// collected, so its old version is kept.
+  void visitChange(utymap::formats::ChangeAction action);
+
   void visitNode(std::uint64_t id, utymap::GeoCoordinate &coordinate, utymap::formats::Tags &tags);
 
   void visitWay(std::uint64_t id, std::vector<std::uint64_t> &nodeIds, utymap::formats::Tags &tags);
@@ -36,17 +72,49 @@ class OsmDataVisitor final {
 
   utymap::BoundingBox complete();
 
+  /// Returns ids of elements which are modified or deleted by osm change file.
+  const std::unordered_set<std::uint64_t> &getChangedIds() const;
+
  private:
 
+  /// Collects id of changed element. Returns false if element is deleted.
+  bool visitChanged(std::uint64_t id);
+
+  /// Checks whether element is inside filter bounding box if it is set.
+  bool isInside(const utymap::entities::Element &element) const;
   bool hasTag(const std::string &key, const std::string &value, const std::vector<utymap::entities::Tag> &tags) const;
   void resolve(utymap::entities::Relation &relation);
 
+  /// Resolves relations by parallel tasks. Relations which share members are resolved by the same task.
+  void resolveParallel();
+
+  /// Adds all kept elements by parallel tasks.
+  void addParallel();
+
+  /// Calls work for every index on completion pool and calling thread. First error is rethrown.
+  void runParallel(std::size_t count, const std::function<void(std::size_t)> &work);
+
+  /// Keeps element if it can be used by relation or adds it.
+  template<typename T>
+  void keepOrAdd(const std::shared_ptr<T> &element,
+                 std::unordered_map<std::uint64_t, std::shared_ptr<T>> &map,
+                 bool isReferenced);
+
   const utymap::index::StringTable &stringTable_;
   std::function<bool(utymap::entities::Element &)> add_;
   const utymap::CancellationToken &cancelToken_;
   utymap::formats::OsmDataContext context_;
   utymap::BoundingBox bbox_;
+  utymap::BoundingBox filterBbox_;
   std::unordered_map<std::uint64_t, utymap::formats::RelationMembers> relationMembers_;
+  std::unique_ptr<utymap::formats::OsmReferences> references_;
+  /// Keeps coordinates of nodes which can be used by ways.
+  std::unique_ptr<utymap::formats::NodeLocationStore> nodeLocations_;
+  std::function<bool(std::uint64_t, utymap::GeoCoordinate &)> nodeResolver_;
+  utymap::formats::ChangeAction changeAction_;
+  std::unordered_set<std::uint64_t> changedIds_;
+  utymap::utils::ThreadPoolShare completionPool_;
+  bool isAddConcurrent_;
 };
 
 }
@@ -0,0 +1,98 @@
+#ifndef FORMATS_OSM_OSMREFERENCEVISITOR_HPP_DEFINED
+#define FORMATS_OSM_OSMREFERENCEVISITOR_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "GeoCoordinate.hpp"
+#include "formats/FormatTypes.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace utymap {
+namespace formats {
+
+/// Contains sorted ids of elements referenced by ways and relations.
+class OsmReferences final {
+ public:
+  /// Returned by find if id is not referenced.
+  static const std::size_t NotFound = std::numeric_limits<std::size_t>::max();
+
+  void addWayNode(std::uint64_t id) { wayNodes_.push_back(id); }
+  void addRelationNode(std::uint64_t id) { relationNodes_.push_back(id); }
+  void addRelationWay(std::uint64_t id) { relationWays_.push_back(id); }
+
+  /// Sorts ids and removes duplicates. Should be called before lookup.
+  void complete() {
+    normalize(wayNodes_);
+    normalize(relationNodes_);
+    normalize(relationWays_);
+  }
+
+  /// Returns amount of nodes used by ways.
+  std::size_t wayNodeCount() const { return wayNodes_.size(); }
+
+  /// Returns index of node used by ways or NotFound.
+  std::size_t findWayNode(std::uint64_t id) const {
+    auto it = std::lower_bound(wayNodes_.begin(), wayNodes_.end(), id);
+    return it != wayNodes_.end() && *it == id ? static_cast<std::size_t>(it - wayNodes_.begin()) : NotFound;
+  }
+
+  bool isRelationNode(std::uint64_t id) const {
+    return std::binary_search(relationNodes_.begin(), relationNodes_.end(), id);
+  }
+
+  bool isRelationWay(std::uint64_t id) const {
+    return std::binary_search(relationWays_.begin(), relationWays_.end(), id);
+  }
+
+ private:
+  static void normalize(std::vector<std::uint64_t> &ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    ids.shrink_to_fit();
+  }
+
+  std::vector<std::uint64_t> wayNodes_;
+  std::vector<std::uint64_t> relationNodes_;
+  std::vector<std::uint64_t> relationWays_;
+};
+
+/// Collects references of ways and relations. Used by first pass of two pass import.
+class OsmReferenceVisitor final {
+ public:
+  void visitBounds(utymap::BoundingBox) {}
+
+  void visitChange(ChangeAction) {}
+
+  void visitNode(std::uint64_t, utymap::GeoCoordinate &, Tags &) {}
+
+  void visitWay(std::uint64_t, std::vector<std::uint64_t> &nodeIds, Tags &) {
+    for (const auto nodeId : nodeIds)
+      references_.addWayNode(nodeId);
+  }
+
+  void visitRelation(std::uint64_t, RelationMembers &members, Tags &) {
+    for (const auto &member : members) {
+      if (member.type == "n")
+        references_.addRelationNode(member.refId);
+      else if (member.type == "w")
+        references_.addRelationWay(member.refId);
+    }
+  }
+
+  /// Returns collected references.
+  OsmReferences complete() {
+    references_.complete();
+    return std::move(references_);
+  }
+
+ private:
+  OsmReferences references_;
+};
+
+}
+}
+
+#endif // FORMATS_OSM_OSMREFERENCEVISITOR_HPP_DEFINED
@@ -0,0 +1,174 @@
+#include "formats/osm/json/JsonReader.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace utymap::formats;
+
+namespace {
+/// Size of chunk read from stream at once.
+const std::size_t ChunkSize = 64 * 1024;
+
+bool isSpace(int c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == ':';
+}
+
+bool isDelimiter(int c) {
+  return c == EOF || isSpace(c) || c == '}' || c == ']' || c == '{' || c == '[' || c == '"';
+}
+}
+
+JsonReader::JsonReader(std::istream &istream) :
+    istream_(istream), buffer_(ChunkSize), position_(0), size_(0), text_() {
+}
+
+JsonReader::Token JsonReader::next() {
+  skipSpaces();
+  int c = peek();
+  switch (c) {
+    case EOF: return Token::End;
+    case '{': ++position_; return Token::ObjectStart;
+    case '}': ++position_; return Token::ObjectEnd;
+    case '[': ++position_; return Token::ArrayStart;
+    case ']': ++position_; return Token::ArrayEnd;
+    case '"': {
+      readString();
+      // NOTE member name is string followed by colon.
+      while (peek() == ' ' || peek() == '\t' || peek() == '\n' || peek() == '\r') ++position_;
+      if (peek() == ':') {
+        ++position_;
+        return Token::Name;
+      }
+      return Token::String;
+    }
+    case 't':
+    case 'f':
+    case 'n': readWord(); return Token::Literal;
+    default:
+      if (c == '-' || (c >= '0' && c <= '9')) {
+        readWord();
+        return Token::Number;
+      }
+      throw std::domain_error(std::string("Unexpected json character: ") + static_cast<char>(c));
+  }
+}
+
+double JsonReader::number() const {
+  char *end = nullptr;
+  double value = std::strtod(text_.c_str(), &end);
+  if (text_.empty() || end != text_.c_str() + text_.size())
+    throw std::domain_error("Invalid json number: " + text_);
+  return value;
+}
+
+void JsonReader::skip(Token token) {
+  if (token != Token::ObjectStart && token != Token::ArrayStart) return;
+
+  int depth = 1;
+  while (depth > 0) {
+    switch (next()) {
+      case Token::ObjectStart:
+      case Token::ArrayStart: ++depth; break;
+      case Token::ObjectEnd:
+      case Token::ArrayEnd: --depth; break;
+      case Token::End: throw std::domain_error("Unexpected end of json.");
+      default: break;
+    }
+  }
+}
+
+bool JsonReader::fill() {
+  if (!istream_.good()) return false;
+  istream_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  position_ = 0;
+  size_ = static_cast<std::size_t>(istream_.gcount());
+  return size_ > 0;
+}
+
+int JsonReader::peek() {
+  if (position_ == size_ && !fill()) return EOF;
+  return static_cast<unsigned char>(buffer_[position_]);
+}
+
+void JsonReader::skipSpaces() {
+  while (isSpace(peek())) ++position_;
+}
+
+void JsonReader::readString() {
+  text_.clear();
+  ++position_;
+  while (true) {
+    // NOTE consume continuous run of plain characters from buffer at once.
+    std::size_t start = position_;
+    while (position_ < size_ && buffer_[position_] != '"' && buffer_[position_] != '\\')
+      ++position_;
+    text_.append(buffer_.data() + start, position_ - start);
+
+    int c = peek();
+    if (c == EOF) throw std::domain_error("Unexpected end of json.");
+    // NOTE buffer is refilled, so continue with next chunk.
+    if (c != '"' && c != '\\') continue;
+    ++position_;
+    if (c == '"') return;
+
+    c = peek();
+    if (c == EOF) throw std::domain_error("Unexpected end of json.");
+    ++position_;
+    switch (c) {
+      case 'b': text_.push_back('\b'); break;
+      case 'f': text_.push_back('\f'); break;
+      case 'n': text_.push_back('\n'); break;
+      case 'r': text_.push_back('\r'); break;
+      case 't': text_.push_back('\t'); break;
+      case 'u': {
+        std::uint32_t code = readHex();
+        if (code >= 0xD800 && code < 0xDC00 && peek() == '\\') {
+          ++position_;
+          if (peek() != 'u') throw std::domain_error("Invalid json escape sequence.");
+          ++position_;
+          code = 0x10000 + ((code - 0xD800) << 10) + (readHex() - 0xDC00);
+        }
+        appendUtf8(code);
+        break;
+      }
+      default: text_.push_back(static_cast<char>(c)); break;
+    }
+  }
+}
+
+void JsonReader::readWord() {
+  text_.clear();
+  while (!isDelimiter(peek()))
+    text_.push_back(buffer_[position_++]);
+}
+
+void JsonReader::appendUtf8(std::uint32_t code) {
+  if (code < 0x80) {
+    text_.push_back(static_cast<char>(code));
+  } else if (code < 0x800) {
+    text_.push_back(static_cast<char>(0xC0 | (code >> 6)));
+    text_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    text_.push_back(static_cast<char>(0xE0 | (code >> 12)));
+    text_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    text_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else {
+    text_.push_back(static_cast<char>(0xF0 | (code >> 18)));
+    text_.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+    text_.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    text_.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  }
+}
+
+std::uint32_t JsonReader::readHex() {
+  std::uint32_t code = 0;
+  for (int i = 0; i < 4; ++i) {
+    int c = peek();
+    ++position_;
+    if (c >= '0' && c <= '9') code = code * 16 + static_cast<std::uint32_t>(c - '0');
+    else if (c >= 'a' && c <= 'f') code = code * 16 + static_cast<std::uint32_t>(c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F') code = code * 16 + static_cast<std::uint32_t>(c - 'A' + 10);
+    else throw std::domain_error("Invalid json escape sequence.");
+  }
+  return code;
+}
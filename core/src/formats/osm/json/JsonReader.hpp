@@ -0,0 +1,61 @@
+#ifndef FORMATS_JSON_JSONREADER_HPP_INCLUDED
+#define FORMATS_JSON_JSONREADER_HPP_INCLUDED
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace utymap {
+namespace formats {
+
+/// Pull json reader which reads stream by fixed size chunks and returns tokens one by one.
+/// Separators are consumed internally, so only structural and value tokens are returned.
+/// NOTE text of last token is kept in reused string, so reading does not allocate memory
+/// once buffers have grown to the size of longest token.
+class JsonReader final {
+ public:
+  enum class Token {
+    ObjectStart, ObjectEnd, ArrayStart, ArrayEnd,
+    /// Name of object member.
+    Name,
+    String, Number,
+    /// true, false or null.
+    Literal,
+    End
+  };
+
+  explicit JsonReader(std::istream &istream);
+
+  /// Reads next token.
+  Token next();
+
+  /// Returns text of last name, string, number or literal token.
+  const std::string &text() const { return text_; }
+
+  /// Returns value of last number token.
+  double number() const;
+
+  /// Skips remaining part of value which starts with given token.
+  void skip(Token token);
+
+ private:
+  bool fill();
+  int peek();
+  void skipSpaces();
+  void readString();
+  void readWord();
+  void appendUtf8(std::uint32_t code);
+  std::uint32_t readHex();
+
+  std::istream &istream_;
+  std::vector<char> buffer_;
+  std::size_t position_;
+  std::size_t size_;
+  std::string text_;
+};
+
+}
+}
+
+#endif  // FORMATS_JSON_JSONREADER_HPP_INCLUDED
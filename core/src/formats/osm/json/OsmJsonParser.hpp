@@ -8,17 +8,22 @@
 #include "index/StringTable.hpp"
 #include "utils/ElementUtils.hpp"
 
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/property_tree/ptree.hpp>
+#include "formats/osm/json/JsonReader.hpp"
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace utymap {
 namespace formats {
 
+/// Parses GeoJSON feature collections grouped by feature name (e.g. Mapzen vector tiles).
+/// NOTE data is read by streaming reader: only current feature is kept in memory and
+/// visitor is notified as soon as feature is complete.
 template<typename Visitor>
 class OsmJsonParser {
   const std::string IdAttributeName = "id";
   const std::string FeatureAttributeName = "feature";
-  using ptree = boost::property_tree::ptree;
+  using Token = JsonReader::Token;
 
   struct FoldRelation final : public utymap::entities::ElementVisitor {
     std::shared_ptr<utymap::entities::Element> element;
@@ -40,6 +45,38 @@ class OsmJsonParser {
     }
   };
 
+  /// Keeps geometry of current feature as flat lists to reuse their capacity.
+  struct Geometry final {
+    std::string type;
+    /// All coordinates in the order of appearance.
+    std::vector<utymap::GeoCoordinate> coordinates;
+    /// End indices of coordinate lists in coordinates.
+    std::vector<std::size_t> lineEnds;
+    /// End indices of polygons in lineEnds.
+    std::vector<std::size_t> polygonEnds;
+
+    void clear() {
+      type.clear();
+      coordinates.clear();
+      lineEnds.clear();
+      polygonEnds.clear();
+    }
+  };
+
+  /// Keeps state of current feature.
+  struct Feature final {
+    std::uint32_t featureId = 0;
+    std::uint64_t id = 0;
+    std::vector<utymap::entities::Tag> tags;
+    Geometry geometry;
+
+    void clear() {
+      id = 0;
+      tags.clear();
+      geometry.clear();
+    }
+  };
+
  public:
 
   OsmJsonParser(const utymap::index::StringTable &stringTable) :
@@ -50,39 +87,146 @@ class OsmJsonParser {
 
   /// Parses osm json data from stream calling visitor.
   void parse(std::istream &istream, Visitor &visitor) const {
-    istream.unsetf(std::ios::skipws);
-    ptree pt;
-    read_json(istream, pt);
-
-    for (const ptree::value_type &feature : pt) {
-      std::string featureName = feature.first;
-      std::uint32_t featureId = stringTable_.getId(featureName);
-      for (const ptree::value_type &f : pt.get_child(featureName).get_child("features")) {
-        const auto &type = f.second.get_child("geometry.type").data();
-        if (type=="Point")
-          parsePoint(visitor, featureId, f.second);
-        else if (type=="LineString")
-          parseLineString(visitor, featureId, f.second);
-        else if (type=="Polygon")
-          parsePolygon(visitor, featureId, f.second);
-        else if (type=="MultiLineString")
-          parseMultiLineString(visitor, featureId, f.second);
-        else if (type=="MultiPolygon")
-          parseMultiPolygon(visitor, featureId, f.second);
-        else
-          throw std::invalid_argument(std::string("Unknown geometry type:") + type);
-      }
+    JsonReader reader(istream);
+    Feature feature;
+
+    expect(reader.next(), Token::ObjectStart);
+    Token token;
+    while ((token = reader.next()) == Token::Name) {
+      feature.featureId = stringTable_.getId(reader.text());
+      parseCollection(reader, visitor, feature);
     }
+    expect(token, Token::ObjectEnd);
   }
 
  private:
 
+  static void expect(Token actual, Token expected) {
+    if (actual != expected)
+      throw std::domain_error("Unexpected json structure.");
+  }
+
+  /// Parses feature collection notifying visitor about each feature.
+  void parseCollection(JsonReader &reader, Visitor &visitor, Feature &feature) const {
+    expect(reader.next(), Token::ObjectStart);
+    Token token;
+    while ((token = reader.next()) == Token::Name) {
+      if (reader.text() != "features") {
+        reader.skip(reader.next());
+        continue;
+      }
+      expect(reader.next(), Token::ArrayStart);
+      while ((token = reader.next()) == Token::ObjectStart) {
+        feature.clear();
+        parseFeature(reader, feature);
+        visitFeature(visitor, feature);
+      }
+      expect(token, Token::ArrayEnd);
+    }
+    expect(token, Token::ObjectEnd);
+  }
+
+  /// Reads geometry and properties of single feature.
+  void parseFeature(JsonReader &reader, Feature &feature) const {
+    Token token;
+    while ((token = reader.next()) == Token::Name) {
+      if (reader.text() == "geometry")
+        parseGeometry(reader, feature.geometry);
+      else if (reader.text() == "properties")
+        parseProperties(reader, feature);
+      else
+        reader.skip(reader.next());
+    }
+    expect(token, Token::ObjectEnd);
+  }
+
+  void parseGeometry(JsonReader &reader, Geometry &geometry) const {
+    expect(reader.next(), Token::ObjectStart);
+    Token token;
+    while ((token = reader.next()) == Token::Name) {
+      if (reader.text() == "type") {
+        expect(reader.next(), Token::String);
+        geometry.type = reader.text();
+      } else if (reader.text() == "coordinates") {
+        expect(reader.next(), Token::ArrayStart);
+        parseCoordinates(reader, geometry);
+      } else {
+        reader.skip(reader.next());
+      }
+    }
+    expect(token, Token::ObjectEnd);
+  }
+
+  /// Parses nested coordinate arrays of any depth after their start token.
+  /// Returns depth of array: one for coordinate, two for coordinate list, etc.
+  static int parseCoordinates(JsonReader &reader, Geometry &geometry) {
+    Token token = reader.next();
+    if (token == Token::Number) {
+      double longitude = reader.number();
+      expect(reader.next(), Token::Number);
+      double latitude = reader.number();
+      if (reader.next() != Token::ArrayEnd)
+        throw std::invalid_argument("Invalid geometry.");
+      geometry.coordinates.emplace_back(latitude, longitude);
+      return 1;
+    }
+
+    // NOTE empty array is treated as empty coordinate list.
+    int childDepth = 1;
+    for (; token == Token::ArrayStart; token = reader.next())
+      childDepth = parseCoordinates(reader, geometry);
+    expect(token, Token::ArrayEnd);
+
+    if (childDepth == 1) geometry.lineEnds.push_back(geometry.coordinates.size());
+    else if (childDepth == 2) geometry.polygonEnds.push_back(geometry.lineEnds.size());
+    return childDepth + 1;
+  }
+
+  void parseProperties(JsonReader &reader, Feature &feature) const {
+    expect(reader.next(), Token::ObjectStart);
+    Token token;
+    while ((token = reader.next()) == Token::Name) {
+      std::uint32_t key = stringTable_.getId(reader.text());
+      Token value = reader.next();
+      // NOTE nested values are not supported and stored as empty strings.
+      if (value == Token::ObjectStart || value == Token::ArrayStart) {
+        reader.skip(value);
+        feature.tags.emplace_back(key, stringTable_.getId(""));
+      } else if (key == idKey_) {
+        feature.id = parseId(reader.text());
+      } else {
+        feature.tags.emplace_back(key, stringTable_.getId(reader.text()));
+      }
+    }
+    expect(token, Token::ObjectEnd);
+  }
+
+  /// Creates elements from complete feature and notifies visitor.
+  void visitFeature(Visitor &visitor, const Feature &feature) const {
+    const auto &geometry = feature.geometry;
+    const auto &type = geometry.type;
+    if (type == "Point")
+      parsePoint(visitor, feature);
+    else if (type == "LineString")
+      parseLineString(visitor, feature);
+    else if (type == "Polygon")
+      parsePolygon(visitor, feature);
+    else if (type == "MultiLineString")
+      parseMultiLineString(visitor, feature);
+    else if (type == "MultiPolygon")
+      parseMultiPolygon(visitor, feature);
+    else
+      throw std::invalid_argument(std::string("Unknown geometry type:") + type);
+  }
+
   /// Parses relation with relations from multipolygon and notifies visitor.
-  void parseMultiPolygon(Visitor &visitor, std::uint32_t featureId, const ptree &feature) const {
+  void parseMultiPolygon(Visitor &visitor, const Feature &feature) const {
     utymap::entities::Relation relation;
-    parseProperties(relation, featureId, feature.get_child("properties"));
-    for (const ptree::value_type &geometry : feature.get_child("geometry.coordinates")) {
-      auto child = parseRelation(featureId, geometry.second);
+    setProperties(relation, feature);
+    std::size_t lineStart = 0;
+    for (std::size_t lineEnd : feature.geometry.polygonEnds) {
+      auto child = createRelation(feature.geometry, lineStart, lineEnd);
+      lineStart = lineEnd;
       if (child.elements.size()==1) {
         FoldRelation fold;
         child.elements[0]->accept(fold);
@@ -95,50 +239,56 @@ class OsmJsonParser {
   }
 
   /// Parses relation with areas from polygon (first is outer, nexts are inner) and notifies visitor.
-  void parsePolygon(Visitor &visitor, std::uint32_t featureId, const ptree &feature) const {
-    processSimpleRelation(visitor, featureId, feature);
+  void parsePolygon(Visitor &visitor, const Feature &feature) const {
+    processSimpleRelation(visitor, feature);
   }
 
   /// Parses relation with ways from multiline string and notifies visitor.
-  void parseMultiLineString(Visitor &visitor, std::uint32_t featureId, const ptree &feature) const {
-    processSimpleRelation(visitor, featureId, feature);
+  void parseMultiLineString(Visitor &visitor, const Feature &feature) const {
+    processSimpleRelation(visitor, feature);
   }
 
   /// Parses way from line string and notifies visitor.
-  void parseLineString(Visitor &visitor, std::uint32_t featureId, const ptree &feature) const {
+  void parseLineString(Visitor &visitor, const Feature &feature) const {
+    if (feature.geometry.lineEnds.size()!=1)
+      throw std::invalid_argument("Invalid geometry.");
+
     utymap::entities::Way way;
-    parseProperties(way, featureId, feature.get_child("properties"));
-    way.coordinates = parseCoordinates(feature.get_child("geometry.coordinates"));
+    setProperties(way, feature);
+    way.coordinates = getCoordinates(feature.geometry, 0);
     visitor.add(way);
   }
 
   /// Parses node from point and notifies visitor.
-  void parsePoint(Visitor &visitor, std::uint32_t featureId, const ptree &feature) const {
+  void parsePoint(Visitor &visitor, const Feature &feature) const {
+    if (feature.geometry.coordinates.size()!=1 || !feature.geometry.lineEnds.empty())
+      throw std::invalid_argument("Invalid geometry.");
+
     utymap::entities::Node node;
-    parseProperties(node, featureId, feature.get_child("properties"));
-    node.coordinate = parseCoordinate(feature.get_child("geometry.coordinates"));
+    setProperties(node, feature);
+    node.coordinate = feature.geometry.coordinates[0];
     visitor.add(node);
   }
 
   /// Parses relation as simple relation with non-relation children. If child is single, then
   /// calls visitor with this child instead of relation.
-  void processSimpleRelation(Visitor &visitor, std::uint32_t featureId, const ptree &feature) const {
-    auto relation = parseRelation(featureId, feature.get_child("geometry.coordinates"));
+  void processSimpleRelation(Visitor &visitor, const Feature &feature) const {
+    auto relation = createRelation(feature.geometry, 0, feature.geometry.lineEnds.size());
     if (relation.elements.size()==1) {
-      parseProperties(*relation.elements[0], featureId, feature.get_child("properties"));
+      setProperties(*relation.elements[0], feature);
       visitor.add(*relation.elements[0]);
     } else {
-      parseProperties(relation, featureId, feature.get_child("properties"));
+      setProperties(relation, feature);
       visitor.add(relation);
     }
   }
 
-  /// Returns parsed relation.
-  utymap::entities::Relation parseRelation(std::uint32_t featureId, const ptree &geometry) const {
+  /// Returns relation built from coordinate lists in given range.
+  utymap::entities::Relation createRelation(const Geometry &geometry, std::size_t lineStart, std::size_t lineEnd) const {
     utymap::entities::Relation relation;
     relation.id = 0;
-    for (const ptree::value_type &coordTree : geometry) {
-      auto coordinates = parseCoordinates(coordTree.second);
+    for (std::size_t i = lineStart; i < lineEnd; ++i) {
+      auto coordinates = getCoordinates(geometry, i);
       if (coordinates.size() > 3 && coordinates[0]==coordinates[coordinates.size() - 1])
         addToRelation<utymap::entities::Area>(relation, coordinates);
       else
@@ -155,40 +305,22 @@ class OsmJsonParser {
     relation.elements.push_back(element);
   }
 
-  /// Parses coordinates list. If input data is invalid, return false.
-  static std::vector<utymap::GeoCoordinate> parseCoordinates(const ptree &geometry) {
-    std::vector<utymap::GeoCoordinate> coordinates;
-    for (const ptree::value_type &coordinate : geometry) {
-      coordinates.emplace_back(parseCoordinate(coordinate.second));
-    }
+  /// Returns coordinates of list with given index.
+  static std::vector<utymap::GeoCoordinate> getCoordinates(const Geometry &geometry, std::size_t index) {
+    auto begin = geometry.coordinates.begin() + (index == 0 ? 0 : geometry.lineEnds[index - 1]);
+    auto end = geometry.coordinates.begin() + geometry.lineEnds[index];
 
     // TODO check orientation
-    std::reverse(coordinates.begin(), coordinates.end());
-    return coordinates;
+    return std::vector<utymap::GeoCoordinate>(std::reverse_iterator<decltype(end)>(end),
+                                              std::reverse_iterator<decltype(begin)>(begin));
   }
 
-  static utymap::GeoCoordinate parseCoordinate(const ptree &coordinate) {
-    if (std::distance(coordinate.begin(), coordinate.end())!=2)
-      throw std::invalid_argument("Invalid geometry.");
-
-    auto iter = coordinate.begin();
-    double longitude = iter->second.get_value<double>();
-    double latitude = (++iter)->second.get_value<double>();
-    return utymap::GeoCoordinate(latitude, longitude);
-  }
-
-  void parseProperties(utymap::entities::Element &element, std::uint32_t featureId, const ptree &properties) const {
-    element.id = 0;
-    for (const ptree::value_type &property : properties) {
-      std::uint32_t key = stringTable_.getId(property.first);
-      if (key==idKey_)
-        element.id = parseId(property.second.data());
-      else
-        element.tags.emplace_back(key, stringTable_.getId(property.second.data()));
-    }
+  void setProperties(utymap::entities::Element &element, const Feature &feature) const {
+    element.id = feature.id;
+    element.tags = feature.tags;
 
     // NOTE add artificial tag for mapcss processing.
-    element.tags.emplace_back(featureKey_, featureId);
+    element.tags.emplace_back(featureKey_, feature.featureId);
 
     std::sort(element.tags.begin(), element.tags.end());
   }
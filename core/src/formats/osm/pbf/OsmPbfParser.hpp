@@ -3,43 +3,78 @@
 
 #include "BoundingBox.hpp"
 #include "formats/FormatTypes.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/ThreadPool.hpp"
 
 #include <fileformat.pb.h>
 #include <osmformat.pb.h>
 #include <zlib.h>
 
 #include <cstdint>
+#include <cstring>
+#include <deque>
 #include <istream>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
 namespace utymap {
 namespace formats {
 
+/// Parses osm pbf files. In pipelined mode, blobs are read on calling thread,
+/// inflated and decoded on thread pool and visited on calling thread in file order.
 template<typename Visitor>
 class OsmPbfParser final {
   const static int MaxBlobHeaderSize = 64*1024;
   const static int MaxUncompressedBlobSize = 32*1024*1024;
+  /// Amount of decoded blocks per thread which are kept ahead of visitor.
+  const static std::size_t BlocksPerThread = 2;
+
+  /// Keeps data of primitive block decoded on thread pool.
+  struct BlockTask {
+    std::vector<char> blob;
+    OSMPBF::PrimitiveBlock block;
+    utymap::utils::ThreadPool::Future future;
+  };
 
  public:
 
-  OsmPbfParser() :
+  /// Creates parser which decodes blobs using given amount of tasks on given pool or on own
+  /// threads if pool is not set. Zero means that blobs are decoded on calling thread.
+  explicit OsmPbfParser(std::size_t threadCount = 0, utymap::utils::ThreadPool *threadPool = nullptr) :
       buffer_(MaxUncompressedBlobSize),
-      unpack_buffer_(MaxUncompressedBlobSize),
-      finished_(false) {
+      unpack_buffer_(threadCount > 0 ? 0 : MaxUncompressedBlobSize),
+      finished_(false),
+      threadPool_(threadPool) {
+    threadPool_.resize(threadCount);
+  }
+
+  /// Sets bounding box of interest. If file header has bounding box which does not
+  /// intersect it, data blobs are skipped without decompression.
+  void setBoundingBox(const utymap::BoundingBox &bbox) {
+    bbox_ = bbox;
   }
 
   void parse(std::istream &stream, Visitor &visitor) {
     finished_ = false;
 
+    if (threadPool_.get() != nullptr) {
+      parsePipelined(stream, visitor);
+      return;
+    }
+
     while (!stream.eof() && !stream.fail() && !finished_) {
       OSMPBF::BlobHeader header = readHeader(stream);
       if (!finished_) {
-        std::int32_t sz = readBlob(header, stream);
+        std::int32_t sz = readBlob(header, stream, buffer_);
         if (header.type()=="OSMData") {
-          parsePrimitiveBlock(sz, visitor);
+          sz = unpackBlob(buffer_, sz, unpack_buffer_);
+          OSMPBF::PrimitiveBlock primblock;
+          parsePrimitiveBlock(unpack_buffer_, sz, primblock);
+          visitPrimitiveBlock(primblock, visitor);
         } else if (header.type()=="OSMHeader") {
-          // used to be skipped
+          sz = unpackBlob(buffer_, sz, unpack_buffer_);
+          visitHeaderBlock(unpack_buffer_, sz);
         }
       }
     }
@@ -50,6 +85,60 @@ class OsmPbfParser final {
   std::vector<char> buffer_;
   std::vector<char> unpack_buffer_;
   bool finished_;
+  utymap::BoundingBox bbox_;
+  utymap::utils::ThreadPoolShare threadPool_;
+
+  void parsePipelined(std::istream &stream, Visitor &visitor) {
+    const std::size_t maxPending = threadPool_.size() * BlocksPerThread;
+    std::deque<std::unique_ptr<BlockTask>> pending;
+    try {
+      while (!stream.eof() && !stream.fail() && !finished_) {
+        OSMPBF::BlobHeader header = readHeader(stream);
+        if (finished_)
+          break;
+
+        auto task = utymap::utils::make_unique<BlockTask>();
+        std::int32_t sz = readBlob(header, stream, task->blob);
+        if (header.type() == "OSMHeader") {
+          std::vector<char> unpacked;
+          visitHeaderBlock(unpacked, unpackBlob(task->blob, sz, unpacked));
+          continue;
+        }
+        if (header.type() != "OSMData")
+          continue;
+
+        BlockTask *taskPtr = task.get();
+        task->future = threadPool_.get()->enqueue([taskPtr, sz]() {
+          std::vector<char> unpacked;
+          std::int32_t size = unpackBlob(taskPtr->blob, sz, unpacked);
+          std::vector<char>().swap(taskPtr->blob);
+          parsePrimitiveBlock(unpacked, size, taskPtr->block);
+        });
+        pending.push_back(std::move(task));
+
+        if (pending.size() >= maxPending)
+          visitFirst(pending, visitor);
+      }
+
+      while (!pending.empty())
+        visitFirst(pending, visitor);
+    } catch (...) {
+      // NOTE tasks reference pending blocks, so they should be finished first.
+      for (auto &task : pending) {
+        if (task->future.valid())
+          task->future.wait();
+      }
+      throw;
+    }
+  }
+
+  /// Waits for first pending block and visits it.
+  void visitFirst(std::deque<std::unique_ptr<BlockTask>> &pending, Visitor &visitor) {
+    auto &task = pending.front();
+    task->future.get();
+    visitPrimitiveBlock(task->block, visitor);
+    pending.pop_front();
+  }
 
   OSMPBF::BlobHeader readHeader(std::istream &stream) {
     std::int32_t sz;
@@ -77,34 +166,50 @@ class OsmPbfParser final {
     return result;
   }
 
-  std::int32_t readBlob(const OSMPBF::BlobHeader &header, std::istream &stream) {
-    OSMPBF::Blob blob;
-
+  /// Reads serialized blob into data and returns its size.
+  static std::int32_t readBlob(const OSMPBF::BlobHeader &header, std::istream &stream, std::vector<char> &data) {
     std::int32_t sz = header.datasize();
 
     if (sz > MaxUncompressedBlobSize)
       throw std::domain_error("Blob size is bigger then allowed");
 
-    if (!stream.read(buffer_.data(), sz))
+    if (data.size() < static_cast<std::size_t>(sz))
+      data.resize(sz);
+
+    if (!stream.read(data.data(), sz))
       throw std::domain_error("Unable to read blob from file");
 
-    if (!blob.ParseFromArray(buffer_.data(), sz))
+    return sz;
+  }
+
+  /// Parses serialized blob and stores its uncompressed content into output. Returns content size.
+  static std::int32_t unpackBlob(const std::vector<char> &data, std::int32_t size, std::vector<char> &output) {
+    OSMPBF::Blob blob;
+
+    if (!blob.ParseFromArray(data.data(), size))
       throw std::domain_error("Unable to parse blob");
 
     // uncompressed
     if (blob.has_raw()) {
-      sz = static_cast<std::int32_t>(blob.raw().size());
-      memcpy(unpack_buffer_.data(), buffer_.data(), sz);
+      std::int32_t sz = static_cast<std::int32_t>(blob.raw().size());
+      if (output.size() < static_cast<std::size_t>(sz))
+        output.resize(sz);
+      std::memcpy(output.data(), blob.raw().data(), sz);
       return sz;
     }
 
     if (blob.has_zlib_data()) {
-      sz = static_cast<std::int32_t>(blob.zlib_data().size());
+      std::int32_t sz = static_cast<std::int32_t>(blob.zlib_data().size());
+
+      if (blob.raw_size() > MaxUncompressedBlobSize)
+        throw std::domain_error("Blob size is bigger then allowed");
+      if (output.size() < static_cast<std::size_t>(blob.raw_size()))
+        output.resize(blob.raw_size());
 
       z_stream z;
       z.next_in = (unsigned char *) blob.zlib_data().c_str();
       z.avail_in = sz;
-      z.next_out = reinterpret_cast<unsigned char *>(unpack_buffer_.data());
+      z.next_out = reinterpret_cast<unsigned char *>(output.data());
       z.avail_out = blob.raw_size();
       z.zalloc = Z_NULL;
       z.zfree = Z_NULL;
@@ -128,18 +233,35 @@ class OsmPbfParser final {
     return 0;
   }
 
-  void parsePrimitiveBlock(int32_t sz, Visitor &visitor) {
-    OSMPBF::PrimitiveBlock primblock;
+  /// Stops parsing if file bounding box does not intersect bounding box of interest.
+  void visitHeaderBlock(const std::vector<char> &data, std::int32_t sz) {
+    if (!bbox_.isValid()) return;
 
-    if (!primblock.ParseFromArray(unpack_buffer_.data(), sz))
+    OSMPBF::HeaderBlock headerBlock;
+    if (!headerBlock.ParseFromArray(data.data(), sz))
+      throw std::domain_error("Unable to parse header block");
+
+    if (!headerBlock.has_bbox()) return;
+
+    const OSMPBF::HeaderBBox &bbox = headerBlock.bbox();
+    utymap::BoundingBox fileBbox(GeoCoordinate(0.000000001*bbox.bottom(), 0.000000001*bbox.left()),
+                                 GeoCoordinate(0.000000001*bbox.top(), 0.000000001*bbox.right()));
+    if (!fileBbox.intersects(bbox_))
+      finished_ = true;
+  }
+
+  static void parsePrimitiveBlock(const std::vector<char> &data, std::int32_t sz, OSMPBF::PrimitiveBlock &primblock) {
+    if (!primblock.ParseFromArray(data.data(), sz))
       throw std::domain_error("Unable to parse primitive block");
+  }
 
+  void visitPrimitiveBlock(const OSMPBF::PrimitiveBlock &primblock, Visitor &visitor) {
     for (int i = 0, l = primblock.primitivegroup_size(); i < l; i++) {
-      OSMPBF::PrimitiveGroup pg = primblock.primitivegroup(i);
+      const OSMPBF::PrimitiveGroup &pg = primblock.primitivegroup(i);
 
       // simple nodes
       for (int i = 0; i < pg.nodes_size(); ++i) {
-        OSMPBF::Node n = pg.nodes(i);
+        const OSMPBF::Node &n = pg.nodes(i);
         GeoCoordinate coordinate;
         coordinate.latitude = 0.000000001*(primblock.lat_offset() + (primblock.granularity()*n.lat()));
         coordinate.longitude = 0.000000001*(primblock.lon_offset() + (primblock.granularity()*n.lon()));
@@ -151,7 +273,7 @@ class OsmPbfParser final {
 
       // dense nodes
       if (pg.has_dense()) {
-        OSMPBF::DenseNodes dn = pg.dense();
+        const OSMPBF::DenseNodes &dn = pg.dense();
         uint64_t id = 0;
         double lon = 0;
         double lat = 0;
@@ -181,7 +303,7 @@ class OsmPbfParser final {
       }
 
       for (int i = 0; i < pg.ways_size(); ++i) {
-        OSMPBF::Way w = pg.ways(i);
+        const OSMPBF::Way &w = pg.ways(i);
 
         uint64_t ref = 0;
         std::vector<uint64_t> nodeIds;
@@ -197,7 +319,7 @@ class OsmPbfParser final {
       }
 
       for (int i = 0; i < pg.relations_size(); ++i) {
-        OSMPBF::Relation rel = pg.relations(i);
+        const OSMPBF::Relation &rel = pg.relations(i);
         uint64_t id = 0;
         RelationMembers refs;
         refs.reserve(rel.memids_size());
@@ -218,7 +340,7 @@ class OsmPbfParser final {
     }
   }
 
-  static std::string parseType(OSMPBF::Relation &rel, int index) {
+  static std::string parseType(const OSMPBF::Relation &rel, int index) {
     switch (rel.types(index)) {
       case OSMPBF::Relation::NODE:return "n";
       case OSMPBF::Relation::WAY:return "w";
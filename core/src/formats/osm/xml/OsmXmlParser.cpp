@@ -1,277 +1,435 @@
-#define BOOST_SPIRIT_USE_PHOENIX_V3
-#include <boost/fusion/include/io.hpp>
-#include <boost/bind.hpp>
-#include <boost/config/warning_disable.hpp>
-#include <boost/spirit/include/qi.hpp>
-#include <boost/spirit/include/phoenix_core.hpp>
-#include <boost/spirit/include/phoenix_operator.hpp>
-#include <boost/spirit/include/phoenix_object.hpp>
-#include <boost/fusion/include/adapt_struct.hpp>
-#include <boost/fusion/include/boost_tuple.hpp>
-
 #include "formats/FormatTypes.hpp"
 #include "formats/osm/xml/OsmXmlParser.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 using namespace utymap;
 using namespace utymap::formats;
 
-namespace qi = boost::spirit::qi;
-namespace ascii = boost::spirit::ascii;
-namespace phoenix = boost::phoenix;
+namespace {
+/// Size of chunk read from stream at once.
+const std::size_t ChunkSize = 64 * 1024;
 
-BOOST_FUSION_ADAPT_STRUCT(
-  Tag,
-  (std::string, key)
-  (std::string, value)
-)
+/// Max amount of significant digits which are parsed exactly.
+const int MaxExactDigits = 15;
 
-BOOST_FUSION_ADAPT_STRUCT(
-  RelationMember,
-  (std::string, type)
-  (std::uint64_t, refId)
-  (std::string, role)
-)
+/// Powers of ten which are exactly representable as double.
+const double ExactPowers[] = {
+  1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9, 1E10, 1E11,
+  1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20, 1E21, 1E22
+};
+const int MaxExactPower = 22;
 
-namespace {
-typedef boost::tuple<double, double, double, double> BoundsType;
-typedef Tag TagType;
-typedef boost::tuple<std::uint64_t, double, double, std::vector<TagType>> NodeType;
-typedef boost::tuple<std::uint64_t, std::vector<std::uint64_t>, std::vector<TagType>> WayType;
-typedef RelationMember MemberType;
-typedef boost::tuple<std::uint64_t, std::vector<MemberType>, std::vector<TagType>> RelationType;
-
-template <typename Iterator>
-struct AttributeSkipper : qi::grammar <Iterator> {
-  AttributeSkipper() : AttributeSkipper::base_type(attributeSkipper, "attr_skipper") {
-      knownKey =
-        ascii::string("id=") |
-        ascii::string("lat=") |
-        ascii::string("lon=")
-          ;
-
-      attributeSkipper =
-        ascii::space |
-        ((+qi::alnum - knownKey) >> "=\"" >> +(qi::char_ - '"') >> '"');
-      ;
-
-      BOOST_SPIRIT_DEBUG_NODE(knownKey);
-      BOOST_SPIRIT_DEBUG_NODE(attributeSkipper);
-  }
+/// Represents not owned range of characters inside read buffer.
+struct Range {
+  const char *begin;
+  const char *end;
 
-  qi::rule<Iterator> knownKey;
-  qi::rule<Iterator> attributeSkipper;
+  bool equals(const char *str) const {
+    std::size_t size = std::strlen(str);
+    return static_cast<std::size_t>(end - begin) == size && std::memcmp(begin, str, size) == 0;
+  }
 };
 
-template <typename Iterator>
-struct StringValueGrammar : qi::grammar < Iterator, std::string()> {
-  StringValueGrammar() : StringValueGrammar::base_type(stringValue, "string") {
-    stringValue =
-        '"' > *(qi::char_ - '"') > '"';
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
 
-    BOOST_SPIRIT_DEBUG_NODE(stringValue);
+/// Reads markups (content between angle brackets) from stream using fixed size buffer.
+/// Text between markups is skipped. Returned ranges are valid till next call.
+/// NOTE buffer grows only if single markup is larger than chunk.
+class MarkupReader final {
+ public:
+  explicit MarkupReader(std::istream &istream) :
+      istream_(istream), buffer_(2 * ChunkSize), begin_(0), end_(0) {
   }
 
-  qi::rule<Iterator, std::string()> stringValue;
-};
-
-template <typename Iterator>
-struct DoubleValueGrammar : qi::grammar < Iterator, double()> {
-  DoubleValueGrammar() : DoubleValueGrammar::base_type(doubleValue, "double") {
-    doubleValue =
-        '"' > qi::double_ > '"';
+  /// Reads next markup. Returns false at the end of stream.
+  bool next(Range &markup) {
+    while (true) {
+      auto found = static_cast<const char *>(std::memchr(data() + begin_, '<', end_ - begin_));
+      if (found != nullptr) {
+        begin_ = static_cast<std::size_t>(found - data());
+        break;
+      }
+      begin_ = end_;
+      if (!fill()) return false;
+    }
 
-    BOOST_SPIRIT_DEBUG_NODE(doubleValue);
+    std::size_t scanned = 1;
+    char quote = 0;
+    while (true) {
+      std::size_t length = findEnd(scanned, quote);
+      if (length > 0) {
+        markup.begin = data() + begin_ + 1;
+        markup.end = data() + begin_ + length - 1;
+        begin_ += length;
+        return true;
+      }
+      if (!fill())
+        throw std::domain_error("Unexpected end of xml.");
+    }
   }
 
-  qi::rule<Iterator, double()> doubleValue;
-};
+ private:
+  const char *data() const { return buffer_.data(); }
+
+  /// Returns length of markup which starts at begin or zero if its end is not read yet.
+  /// Scanned position and quote state are kept between calls.
+  std::size_t findEnd(std::size_t &scanned, char &quote) const {
+    const char *start = data() + begin_;
+    std::size_t available = end_ - begin_;
+
+    static const char Comment[] = "<!--";
+    if (std::memcmp(start, Comment, std::min(available, sizeof(Comment) - 1)) == 0) {
+      if (available < sizeof(Comment) - 1) return 0;
+      for (scanned = std::max(scanned, sizeof(Comment) + 1); scanned < available; ++scanned) {
+        if (start[scanned] == '>' && start[scanned - 1] == '-' && start[scanned - 2] == '-')
+          return scanned + 1;
+      }
+      return 0;
+    }
 
-template <typename Iterator>
-struct IdGrammar : qi::grammar < Iterator, std::uint64_t()> {
-  IdGrammar() : IdGrammar::base_type(id, "id") {
-    id =
-        qi::skip(qi::space)["id=\"" > qi::ulong_long > '"'];
+    // NOTE '>' is allowed inside attribute values.
+    for (; scanned < available; ++scanned) {
+      char c = start[scanned];
+      if (quote != 0) {
+        if (c == quote) quote = 0;
+      } else if (c == '"' || c == '\'') {
+        quote = c;
+      } else if (c == '>') {
+        return scanned + 1;
+      }
+    }
+    return 0;
+  }
 
-    BOOST_SPIRIT_DEBUG_NODE(id);
+  /// Moves unprocessed data to the beginning of buffer and appends next chunk.
+  bool fill() {
+    if (begin_ > 0) {
+      std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+      end_ -= begin_;
+      begin_ = 0;
+    }
+    if (buffer_.size() - end_ < ChunkSize)
+      buffer_.resize(end_ + ChunkSize);
+
+    if (!istream_.good()) return false;
+    istream_.read(buffer_.data() + end_, static_cast<std::streamsize>(ChunkSize));
+    auto count = static_cast<std::size_t>(istream_.gcount());
+    end_ += count;
+    return count > 0;
   }
 
-  qi::rule<Iterator, std::uint64_t()> id;
+  std::istream &istream_;
+  std::vector<char> buffer_;
+  std::size_t begin_;
+  std::size_t end_;
 };
 
-template <typename Iterator>
-struct RefGrammar : qi::grammar < Iterator, std::uint64_t()> {
-  RefGrammar() : RefGrammar::base_type(ref, "ref") {
-    ref =
-        qi::skip(qi::space)["ref=\"" > qi::ulong_long > '"'];
-
-    BOOST_SPIRIT_DEBUG_NODE(ref);
+/// Iterates over attributes of markup in place.
+class AttributeReader final {
+ public:
+  AttributeReader(const char *begin, const char *end) : current_(begin), end_(end) {}
+
+  /// Reads next attribute. Returns false if there are no more attributes.
+  bool next(Range &name, Range &value) {
+    while (current_ < end_ && (isSpace(*current_) || *current_ == '/')) ++current_;
+    if (current_ >= end_) return false;
+
+    name.begin = current_;
+    while (current_ < end_ && *current_ != '=' && !isSpace(*current_)) ++current_;
+    name.end = current_;
+
+    while (current_ < end_ && (isSpace(*current_) || *current_ == '=')) ++current_;
+    if (current_ >= end_ || (*current_ != '"' && *current_ != '\''))
+      throw std::domain_error("Invalid xml attribute: " + std::string(name.begin, name.end));
+
+    char quote = *current_++;
+    value.begin = current_;
+    auto found = static_cast<const char *>(std::memchr(current_, quote, end_ - current_));
+    if (found == nullptr)
+      throw std::domain_error("Invalid xml attribute: " + std::string(name.begin, name.end));
+    value.end = found;
+    current_ = found + 1;
+    return true;
   }
 
-  qi::rule<Iterator, std::uint64_t()> ref;
+ private:
+  const char *current_;
+  const char *end_;
 };
 
-template <typename Iterator>
-struct BoundsGrammar : qi::grammar < Iterator, BoundsType()> {
-  BoundsGrammar() : BoundsGrammar::base_type(bounds, "bounds") {
-    bounds =
-        qi::skip(qi::space)[("<bounds" > (("minlat=" > value) ^ ("minlon=" > value) ^ ("maxlat=" > value) ^ ("maxlon=" > value)) > "/>")]
-        ;
+/// Appends utf8 representation of code point.
+void appendUtf8(std::uint32_t code, std::string &str) {
+  if (code < 0x80) {
+    str.push_back(static_cast<char>(code));
+  } else if (code < 0x800) {
+    str.push_back(static_cast<char>(0xC0 | (code >> 6)));
+    str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    str.push_back(static_cast<char>(0xE0 | (code >> 12)));
+    str.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else {
+    str.push_back(static_cast<char>(0xF0 | (code >> 18)));
+    str.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+    str.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  }
+}
 
-    BOOST_SPIRIT_DEBUG_NODE(bounds);
+/// Assigns attribute value to string replacing entity references.
+void decode(const Range &value, std::string &str) {
+  str.clear();
+  for (const char *c = value.begin; c < value.end; ++c) {
+    if (*c != '&') {
+      str.push_back(*c);
+      continue;
+    }
+    auto semicolon = static_cast<const char *>(std::memchr(c, ';', value.end - c));
+    if (semicolon == nullptr) {
+      str.push_back(*c);
+      continue;
+    }
+    Range entity{c + 1, semicolon};
+    if (entity.equals("amp")) str.push_back('&');
+    else if (entity.equals("lt")) str.push_back('<');
+    else if (entity.equals("gt")) str.push_back('>');
+    else if (entity.equals("quot")) str.push_back('"');
+    else if (entity.equals("apos")) str.push_back('\'');
+    else if (entity.begin < entity.end && *entity.begin == '#') {
+      bool isHex = entity.begin + 1 < entity.end && (entity.begin[1] == 'x' || entity.begin[1] == 'X');
+      std::string digits(entity.begin + (isHex ? 2 : 1), entity.end);
+      appendUtf8(static_cast<std::uint32_t>(std::strtoul(digits.c_str(), nullptr, isHex ? 16 : 10)), str);
+    } else {
+      str.append(c, semicolon + 1);
+    }
+    c = semicolon;
   }
+}
 
-  DoubleValueGrammar<Iterator> value;
-  qi::rule<Iterator, BoundsType()> bounds;
-};
+std::uint64_t parseId(const Range &value) {
+  std::uint64_t id = 0;
+  const char *c = value.begin;
+  for (; c < value.end && *c >= '0' && *c <= '9'; ++c)
+    id = id * 10 + static_cast<std::uint64_t>(*c - '0');
+  if (c == value.begin || c != value.end)
+    throw std::domain_error("Invalid id: " + std::string(value.begin, value.end));
+  return id;
+}
 
-template <typename Iterator>
-struct TagGrammar : qi::grammar < Iterator, TagType(), AttributeSkipper<Iterator>> {
-  TagGrammar() : TagGrammar::base_type(tag, "tag") {
-    tag =
-        qi::skip(qi::space)["<tag" > ("k=" > value) > ("v=" > value) > "/>"]
-        ;
+/// Parses double without allocations. Values with many digits are parsed by strtod.
+/// NOTE exact mantissa is divided or multiplied by exact power of ten, so result is correctly rounded.
+double parseDouble(const Range &value) {
+  const char *c = value.begin;
+  bool isNegative = c < value.end && *c == '-';
+  if (isNegative || (c < value.end && *c == '+')) ++c;
+
+  std::uint64_t mantissa = 0;
+  int digits = 0, exponent = 0;
+  bool hasDigits = false;
+  for (; c < value.end && *c >= '0' && *c <= '9'; ++c, hasDigits = true) {
+    if (mantissa > 0 || *c != '0') ++digits;
+    mantissa = mantissa * 10 + static_cast<std::uint64_t>(*c - '0');
+  }
+  if (c < value.end && *c == '.') {
+    for (++c; c < value.end && *c >= '0' && *c <= '9'; ++c, hasDigits = true) {
+      if (mantissa > 0 || *c != '0') ++digits;
+      mantissa = mantissa * 10 + static_cast<std::uint64_t>(*c - '0');
+      --exponent;
+    }
+  }
 
-    BOOST_SPIRIT_DEBUG_NODE(tag);
+  if (!hasDigits || digits > MaxExactDigits || c != value.end || -exponent > MaxExactPower) {
+    std::string str(value.begin, value.end);
+    char *end = nullptr;
+    double result = std::strtod(str.c_str(), &end);
+    if (str.empty() || end != str.c_str() + str.size())
+      throw std::domain_error("Invalid number: " + str);
+    return result;
   }
 
-  StringValueGrammar<Iterator> value;
-  qi::rule<Iterator, TagType(), AttributeSkipper<Iterator>> tag;
-};
+  double result = static_cast<double>(mantissa) / ExactPowers[-exponent];
+  return isNegative ? -result : result;
+}
 
-template <typename Iterator>
-struct NodeGrammar : qi::grammar < Iterator, NodeType(), AttributeSkipper<Iterator> > {
-  NodeGrammar() : NodeGrammar::base_type(node, "node") {
-    lat = qi::skip(qi::space)["lat=" > doubleValue];
-    lon = qi::skip(qi::space)["lon=" > doubleValue];
-
-    node =
-        "<node" > id > lat > lon >
-        (
-          ('>' > *tag > "</node>") | (qi::eps > "/>")
-        );
-
-    BOOST_SPIRIT_DEBUG_NODE(lat);
-    BOOST_SPIRIT_DEBUG_NODE(lon);
-    BOOST_SPIRIT_DEBUG_NODE(node);
+/// Calls visitor for elements while markups are read.
+template<typename Visitor>
+class OsmXmlHandler final {
+  enum class State { None, Node, Way, Relation };
+
+ public:
+  explicit OsmXmlHandler(Visitor &visitor) :
+      visitor_(visitor), state_(State::None), id_(0), coordinate_(),
+      tagCount_(0), tags_(), nodeIds_(), members_(), memberCount_(0) {
   }
 
-  TagGrammar<Iterator> tag;
-  IdGrammar<Iterator> id;
-  qi::rule<Iterator, double()> lat;
-  qi::rule<Iterator, double()> lon;
+  void handle(const Range &markup) {
+    if (markup.begin == markup.end) return;
 
-  DoubleValueGrammar<Iterator> doubleValue;
-  qi::rule<Iterator, NodeType(), AttributeSkipper<Iterator>> node;
-};
+    char first = *markup.begin;
+    // skip declarations, comments and processing instructions
+    if (first == '?' || first == '!') return;
 
-template <typename Iterator>
-struct WayGrammar : qi::grammar < Iterator, WayType(), AttributeSkipper<Iterator> > {
-  WayGrammar() : WayGrammar::base_type(way, "way") {
-    nodeRef = qi::skip(qi::space)["<nd" > ref > "/>"];
+    if (first == '/') {
+      Range name = readName(markup.begin + 1, markup.end);
+      if (isChange(name)) visitor_.visitChange(ChangeAction::None);
+      else onEnd(name);
+      return;
+    }
 
-    way =
-        "<way" > id > '>' > +nodeRef > *tag > "</way>";
+    bool isEmpty = *(markup.end - 1) == '/';
+    Range name = readName(markup.begin, markup.end);
+    AttributeReader attributes(name.end, isEmpty ? markup.end - 1 : markup.end);
+
+    if (name.equals("node")) onNode(attributes, isEmpty);
+    else if (name.equals("nd")) onNodeRef(attributes);
+    else if (name.equals("tag")) onTag(attributes);
+    else if (name.equals("way")) onElement(State::Way, attributes, isEmpty);
+    else if (name.equals("member")) onMember(attributes);
+    else if (name.equals("relation")) onElement(State::Relation, attributes, isEmpty);
+    else if (name.equals("bounds")) onBounds(attributes);
+    else if (name.equals("create")) visitor_.visitChange(ChangeAction::Create);
+    else if (name.equals("modify")) visitor_.visitChange(ChangeAction::Modify);
+    else if (name.equals("delete")) visitor_.visitChange(ChangeAction::Delete);
+  }
 
-    BOOST_SPIRIT_DEBUG_NODE(nodeRef);
-    BOOST_SPIRIT_DEBUG_NODE(way);
+  void complete() {
+    if (state_ != State::None)
+      throw std::domain_error("Unexpected end of xml.");
   }
 
-  IdGrammar<Iterator> id;
-  TagGrammar<Iterator> tag;
-  RefGrammar<Iterator> ref;
-  qi::rule<Iterator, std::uint64_t(), AttributeSkipper<Iterator>> nodeRef;
-  qi::rule<Iterator, WayType(), AttributeSkipper<Iterator>> way;
-};
+ private:
+  /// Checks whether name is action of osm change file.
+  static bool isChange(const Range &name) {
+    return name.equals("create") || name.equals("modify") || name.equals("delete");
+  }
 
-template <typename Iterator>
-struct RelationGrammar : qi::grammar < Iterator, RelationType(), AttributeSkipper<Iterator> > {
-  RelationGrammar() : RelationGrammar::base_type(relation, "relation") {
-    memberRef = qi::skip(qi::space)["<member" > ("type=" > value) > ref > ("role=" > value) > "/>"];
+  static Range readName(const char *begin, const char *end) {
+    const char *c = begin;
+    while (c < end && !isSpace(*c) && *c != '/') ++c;
+    return Range{begin, c};
+  }
 
-    relation =
-        "<relation" > id > '>' > +memberRef > *tag > "</relation>";
+  void onBounds(AttributeReader &attributes) {
+    double minLat = 0, minLon = 0, maxLat = 0, maxLon = 0;
+    Range name, value;
+    while (attributes.next(name, value)) {
+      if (name.equals("minlat")) minLat = parseDouble(value);
+      else if (name.equals("minlon")) minLon = parseDouble(value);
+      else if (name.equals("maxlat")) maxLat = parseDouble(value);
+      else if (name.equals("maxlon")) maxLon = parseDouble(value);
+    }
+    visitor_.visitBounds(BoundingBox(GeoCoordinate(minLat, minLon), GeoCoordinate(maxLat, maxLon)));
+  }
 
-    BOOST_SPIRIT_DEBUG_NODE(memberRef);
-    BOOST_SPIRIT_DEBUG_NODE(relation);
+  void onNode(AttributeReader &attributes, bool isEmpty) {
+    start(State::Node);
+    Range name, value;
+    while (attributes.next(name, value)) {
+      if (name.equals("id")) id_ = parseId(value);
+      else if (name.equals("lat")) coordinate_.latitude = parseDouble(value);
+      else if (name.equals("lon")) coordinate_.longitude = parseDouble(value);
+    }
+    if (isEmpty) finish();
   }
 
-  IdGrammar<Iterator> id;
-  TagGrammar<Iterator> tag;
-  RefGrammar<Iterator> ref;
-  StringValueGrammar<Iterator> value;
-  qi::rule<Iterator, MemberType(), AttributeSkipper<Iterator>> memberRef;
-  qi::rule<Iterator, RelationType(), AttributeSkipper<Iterator>> relation;
-};
+  void onElement(State state, AttributeReader &attributes, bool isEmpty) {
+    start(state);
+    Range name, value;
+    while (attributes.next(name, value)) {
+      if (name.equals("id")) id_ = parseId(value);
+    }
+    if (isEmpty) finish();
+  }
 
-template <typename Visitor, typename Iterator>
-struct OsmGrammar : qi::grammar < Iterator, int(), AttributeSkipper<Iterator> > {
-  OsmGrammar(Visitor& visitor) : OsmGrammar::base_type(osm, "osm"), visitor(visitor) {
-    osm =
-      ascii::string("<?") > *(qi::char_ - '>') > '>' >
-      "<osm" > '>' >
-          -(qi::lexeme[+(qi::char_ - (ascii::string("<node") | "<bounds"))]) >
-          -qi::omit[bounds[boost::bind(&OsmGrammar::onBounds, this, _1)]] >
-          *qi::omit[node[boost::bind(&OsmGrammar::onNode, this, _1)]] >
-          *qi::omit[way[boost::bind(&OsmGrammar::onWay, this, _1)]] >
-          *qi::omit[relation[boost::bind(&OsmGrammar::onRelation, this, _1)]] >
-      "</osm>" > qi::eps;
-
-    BOOST_SPIRIT_DEBUG_NODE(osm);
-    qi::on_error<qi::fail>(
-      osm,
-      error
-      << phoenix::val("Error! Expecting ")
-      << qi::_4
-      << phoenix::val(" here: \"")
-      << phoenix::construct<std::string>(qi::_3, qi::_2)
-      << phoenix::val("\"")
-      << std::endl);
+  void onNodeRef(AttributeReader &attributes) {
+    Range name, value;
+    while (attributes.next(name, value)) {
+      if (name.equals("ref")) nodeIds_.push_back(parseId(value));
+    }
   }
 
-  Visitor& visitor;
-  std::stringstream error;
-  BoundsGrammar<Iterator> bounds;
-  NodeGrammar<Iterator> node;
-  WayGrammar<Iterator> way;
-  RelationGrammar<Iterator> relation;
-  qi::rule<Iterator, int(), AttributeSkipper<Iterator>> osm;
-
-private:
-  void onBounds(BoundsType& bounds) {
-    utymap::BoundingBox boundingBox(
-        utymap::GeoCoordinate(boost::get<0>(bounds), boost::get<1>(bounds)),
-        utymap::GeoCoordinate(boost::get<2>(bounds), boost::get<3>(bounds)));
-    visitor.visitBounds(boundingBox);
+  void onTag(AttributeReader &attributes) {
+    if (state_ == State::None) return;
+
+    // NOTE tag objects are reused to keep capacity of their strings.
+    if (tagCount_ == tags_.size()) tags_.emplace_back();
+    Tag &tag = tags_[tagCount_++];
+    tag.key.clear();
+    tag.value.clear();
+
+    Range name, value;
+    while (attributes.next(name, value)) {
+      if (name.equals("k")) decode(value, tag.key);
+      else if (name.equals("v")) decode(value, tag.value);
+    }
   }
 
-  void onNode(NodeType& node) {
-    utymap::GeoCoordinate coordinate(boost::get<1>(node), boost::get<2>(node));
-    Tags& tags = boost::get<3>(node);
-    visitor.visitNode(boost::get<0>(node), coordinate, tags);
+  void onMember(AttributeReader &attributes) {
+    if (memberCount_ == members_.size()) members_.emplace_back();
+    RelationMember &member = members_[memberCount_++];
+    member.refId = 0;
+    member.type.clear();
+    member.role.clear();
+
+    Range name, value;
+    while (attributes.next(name, value)) {
+      if (name.equals("ref")) member.refId = parseId(value);
+      else if (name.equals("role")) decode(value, member.role);
+      else if (name.equals("type"))
+        member.type = value.equals("node") ? "n" : (value.equals("way") ? "w" : "r");
+    }
   }
 
-  void onWay(WayType& way) {
-    auto& ids = boost::get<1>(way);
-    Tags& tags = boost::get<2>(way);
-    visitor.visitWay(boost::get<0>(way), ids, tags);
+  void onEnd(const Range &name) {
+    if ((name.equals("node") && state_ == State::Node) ||
+        (name.equals("way") && state_ == State::Way) ||
+        (name.equals("relation") && state_ == State::Relation))
+      finish();
   }
 
-  void onRelation(RelationType& relation) {
-    auto& members = boost::get<1>(relation);
-    for (auto& member : members) {
-        member.type = mapType(member.type);
-    }
-    Tags& tags = boost::get<2>(relation);
-    visitor.visitRelation(boost::get<0>(relation), members, tags);
+  void start(State state) {
+    if (state_ != State::None)
+      throw std::domain_error("Unexpected nested element.");
+    state_ = state;
+    id_ = 0;
+    coordinate_ = GeoCoordinate();
+    tagCount_ = 0;
+    memberCount_ = 0;
+    nodeIds_.clear();
   }
 
-  static std::string mapType(const std::string& type) {
-    if (type == "node")
-        return "n";
-    if (type == "way")
-        return "w";
-    return "r";
+  void finish() {
+    tags_.resize(tagCount_);
+    switch (state_) {
+      case State::Node: visitor_.visitNode(id_, coordinate_, tags_); break;
+      case State::Way: visitor_.visitWay(id_, nodeIds_, tags_); break;
+      case State::Relation: {
+        members_.resize(memberCount_);
+        visitor_.visitRelation(id_, members_, tags_);
+        break;
+      }
+      default: break;
+    }
+    state_ = State::None;
   }
+
+  Visitor &visitor_;
+  State state_;
+  std::uint64_t id_;
+  GeoCoordinate coordinate_;
+  std::size_t tagCount_;
+  Tags tags_;
+  std::vector<std::uint64_t> nodeIds_;
+  RelationMembers members_;
+  std::size_t memberCount_;
 };
 }
 
@@ -279,20 +437,17 @@ namespace utymap { namespace formats {
 
 template <typename Visitor>
 void OsmXmlParser<Visitor>::parse(std::istream& istream, Visitor& visitor) {
-  istream.unsetf(std::ios::skipws);
-  boost::spirit::istream_iterator begin(istream);
-  boost::spirit::istream_iterator end;
-
-  OsmGrammar<Visitor, boost::spirit::istream_iterator> grammar(visitor);
-  AttributeSkipper<boost::spirit::istream_iterator> skipper;
-  int result;
-
-  if (!phrase_parse(begin, end, grammar, skipper, result))
-      throw std::domain_error(grammar.error.str());
+  MarkupReader reader(istream);
+  OsmXmlHandler<Visitor> handler(visitor);
+  Range markup;
+  while (reader.next(markup))
+    handler.handle(markup);
+  handler.complete();
 }
 
 template class OsmXmlParser<OsmDataVisitor>;
 template class OsmXmlParser<CountableOsmDataVisitor>;
+template class OsmXmlParser<OsmReferenceVisitor>;
 
 }
 }
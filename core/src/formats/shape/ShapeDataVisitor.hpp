@@ -10,6 +10,7 @@
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 #include "formats/FormatTypes.hpp"
+#include "index/ElementGeometryVisitor.hpp"
 #include "index/StringTable.hpp"
 #include "utils/ElementUtils.hpp"
 
@@ -36,10 +37,19 @@ struct ShapeDataVisitor final {
       relations(0),
       stringTable_(stringTable),
       functor_(functor),
-      cancelToken_(cancelToken) {
+      cancelToken_(cancelToken),
+      bbox_() {
+  }
+
+  /// Sets bounding box which is used to drop elements outside of it while parsing.
+  void setBoundingBox(const utymap::BoundingBox &bbox) {
+    bbox_ = bbox;
   }
 
   void visitNode(utymap::GeoCoordinate &coordinate, utymap::formats::Tags &tags) {
+    if (bbox_.isValid() && !bbox_.contains(coordinate))
+      return;
+
     utymap::entities::Node node;
     node.id = 0;
     node.coordinate = coordinate;
@@ -100,12 +110,16 @@ struct ShapeDataVisitor final {
  private:
 
    bool add(utymap::entities::Element & element) const {
-     return cancelToken_.isCancelled() ? false : functor_(element);
+     if (cancelToken_.isCancelled() ||
+         (bbox_.isValid() && !utymap::index::ElementGeometryVisitor::intersects(element, bbox_)))
+       return false;
+     return functor_(element);
    }
 
   const utymap::index::StringTable &stringTable_;
   std::function<bool(utymap::entities::Element &)> functor_;
   const utymap::CancellationToken &cancelToken_;
+  utymap::BoundingBox bbox_;
 };
 
 }
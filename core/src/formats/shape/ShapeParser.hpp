@@ -4,11 +4,13 @@
 #include "GeoCoordinate.hpp"
 #include "entities/Element.hpp"
 #include "formats/FormatTypes.hpp"
+#include "formats/shape/ShapeReader.hpp"
 #include "utils/CoreUtils.hpp"
+#include "utils/ThreadPool.hpp"
 
-#include "shapefile/shapefil.h"
-
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <stdexcept>
 #include <vector>
@@ -16,139 +18,127 @@
 namespace utymap {
 namespace formats {
 
+/// Parses shapefiles. Records are decoded from memory mapped files by chunks. In parallel
+/// mode, chunks are decoded on thread pool and visited on calling thread in file order.
 template<typename Visitor>
 class ShapeParser final {
- public:
-
-  void parse(const std::string &path, Visitor &visitor) const {
-    SHPHandle shpFile = SHPOpen(path.c_str(), "rb");
-    if (shpFile==NULL)
-      throw std::domain_error("Cannot open shp file.");
+  /// Amount of records decoded at once.
+  const static std::size_t ChunkSize = 1024;
+  /// Amount of decoded chunks per thread which are kept ahead of visitor.
+  const static std::size_t ChunksPerThread = 2;
 
-    int shapeType, entityCount;
-    double adfMinBound[4], adfMaxBound[4];
-    SHPGetInfo(shpFile, &entityCount, &shapeType, adfMinBound, adfMaxBound);
+  using Shape = ShapeReader::Shape;
+  using ShapeType = ShapeReader::ShapeType;
 
-    DBFHandle dbfFile = DBFOpen(path.c_str(), "rb");
-    if (dbfFile==NULL)
-      throw std::domain_error("Cannot open dbf file.");
+  /// Keeps records of chunk decoded on thread pool.
+  struct ChunkTask {
+    std::vector<Shape> shapes;
+    utymap::utils::ThreadPool::Future future;
+  };
 
-    if (DBFGetFieldCount(dbfFile)==0)
-      throw std::domain_error("There are no fields in dbf table.");
-
-    if (entityCount!=DBFGetRecordCount(dbfFile))
-      throw std::domain_error("dbf file has different entity count.");
+ public:
 
-    for (int k = 0; k < entityCount; k++) {
-      SHPObject *shape = SHPReadObject(shpFile, k);
-      if (shape==NULL)
-        throw std::domain_error("Unable to read shape:" + utymap::utils::toString(k));
+  /// Creates parser which decodes records using given amount of tasks on given pool or on own
+  /// threads if pool is not set. Zero means that records are decoded on calling thread.
+  explicit ShapeParser(std::size_t threadCount = 0, utymap::utils::ThreadPool *threadPool = nullptr) :
+      threadPool_(threadPool) {
+    threadPool_.resize(threadCount);
+  }
 
-      Tags tags = parseTags(dbfFile, k);
-      visitShape(*shape, tags, visitor);
+  void parse(const std::string &path, Visitor &visitor) const {
+    ShapeReader reader(path);
 
-      SHPDestroyObject(shape);
+    if (threadPool_.get() != nullptr) {
+      parseParallel(reader, visitor);
+      return;
     }
 
-    DBFClose(dbfFile);
-    SHPClose(shpFile);
+    std::vector<Shape> shapes;
+    for (std::size_t start = 0; start < reader.size(); start += ChunkSize) {
+      read(reader, start, shapes);
+      visit(shapes, visitor);
+    }
   }
 
  private:
 
-  Tags parseTags(DBFHandle dbfFile, int k) const {
-    char title[12];
-    int fieldCount = DBFGetFieldCount(dbfFile);
-    Tags tags;
-    tags.reserve(static_cast<std::size_t>(fieldCount));
-    for (int i = 0; i < fieldCount; i++) {
-      if (DBFIsAttributeNULL(dbfFile, k, i))
-        continue;
-
-      utymap::formats::Tag tag;
-      int width, decimals;
-      DBFFieldType eType = DBFGetFieldInfo(dbfFile, i, title, &width, &decimals);
-      tag.key = std::string(title);
-      {
-        switch (eType) {
-          case FTString:tag.value = DBFReadStringAttribute(dbfFile, k, i);
-            break;
-          case FTInteger:tag.value = utymap::utils::toString(DBFReadIntegerAttribute(dbfFile, k, i));
-            break;
-          case FTDouble:tag.value = utymap::utils::toString(DBFReadDoubleAttribute(dbfFile, k, i));
-            break;
-          default:break;
-        }
+  utymap::utils::ThreadPoolShare threadPool_;
+
+  void parseParallel(const ShapeReader &reader, Visitor &visitor) const {
+    const std::size_t maxPending = threadPool_.size() * ChunksPerThread;
+    std::deque<std::unique_ptr<ChunkTask>> pending;
+    try {
+      for (std::size_t start = 0; start < reader.size(); start += ChunkSize) {
+        auto task = utymap::utils::make_unique<ChunkTask>();
+        ChunkTask *taskPtr = task.get();
+        task->future = threadPool_.get()->enqueue([&reader, taskPtr, start]() {
+          read(reader, start, taskPtr->shapes);
+        });
+        pending.push_back(std::move(task));
+
+        if (pending.size() >= maxPending)
+          visitFirst(pending, visitor);
       }
-      tags.push_back(tag);
+
+      while (!pending.empty())
+        visitFirst(pending, visitor);
+    } catch (...) {
+      // NOTE tasks reference pending chunks and reader, so they should be finished first.
+      for (auto &task : pending) {
+        if (task->future.valid())
+          task->future.wait();
+      }
+      throw;
     }
-    return std::move(tags);
   }
 
-  void visitShape(const SHPObject &shape, Tags &tags, Visitor &visitor) const {
-    switch (shape.nSHPType) {
-      case SHPT_POINT:
-      case SHPT_POINTM:
-      case SHPT_POINTZ:visitPoint(shape, tags, visitor);
-        break;
-      case SHPT_ARC:
-      case SHPT_ARCZ:
-      case SHPT_ARCM:visitArc(shape, tags, visitor);
+  /// Waits for first pending chunk and visits it.
+  void visitFirst(std::deque<std::unique_ptr<ChunkTask>> &pending, Visitor &visitor) const {
+    auto &task = pending.front();
+    task->future.get();
+    visit(task->shapes, visitor);
+    pending.pop_front();
+  }
+
+  /// Reads chunk of records which starts from given index.
+  static void read(const ShapeReader &reader, std::size_t start, std::vector<Shape> &shapes) {
+    std::size_t count = reader.size() - start;
+    if (count > ChunkSize) count = ChunkSize;
+    shapes.resize(count);
+    for (std::size_t i = 0; i < shapes.size(); ++i)
+      reader.read(start + i, shapes[i]);
+  }
+
+  static void visit(std::vector<Shape> &shapes, Visitor &visitor) {
+    for (auto &shape : shapes)
+      visitShape(shape, visitor);
+  }
+
+  static void visitShape(Shape &shape, Visitor &visitor) {
+    switch (shape.type) {
+      case ShapeType::Null: break;
+      case ShapeType::Point: visitor.visitNode(shape.coordinate, shape.tags);
         break;
-      case SHPT_POLYGON:
-      case SHPT_POLYGONZ:
-      case SHPT_POLYGONM:visitPolygon(shape, tags, visitor);
+      case ShapeType::Arc: visitArc(shape, visitor);
         break;
-      case SHPT_MULTIPOINT:
-      case SHPT_MULTIPOINTZ:
-      case SHPT_MULTIPOINTM:
-      case SHPT_MULTIPATCH:std::cerr << "Unsupported shape type:" << SHPTypeName(shape.nSHPType);
+      case ShapeType::Polygon: visitor.visitRelation(shape.parts, shape.tags);
         break;
-      default:std::cerr << "Unknown shape type:" << SHPTypeName(shape.nSHPType);
+      default:std::cerr << "Unsupported shape type:" << shape.typeCode;
         break;
     }
   }
 
-  void visitPoint(const SHPObject &shape, Tags &tags, Visitor &visitor) const {
-    utymap::GeoCoordinate coordinate(shape.padfY[0], shape.padfX[0]);
-    visitor.visitNode(coordinate, tags);
-  }
-
-  void visitArc(const SHPObject &shape, Tags &tags, Visitor &visitor) const {
-    if (shape.nParts > 1) {
+  static void visitArc(Shape &shape, Visitor &visitor) {
+    if (shape.parts.size() != 1) {
       std::cerr << "Arc type has more than one part.";
       return;
     }
 
-    std::vector<utymap::GeoCoordinate> coordinates;
-    coordinates.reserve(static_cast<std::size_t>(shape.nVertices));
-    for (int i = 0; i < shape.nVertices; ++i) {
-      coordinates.push_back(utymap::GeoCoordinate(shape.padfY[i], shape.padfX[i]));
-    }
-
-    visitor.visitWay(coordinates, tags, coordinates[0]==coordinates[coordinates.size() - 1]);
-  }
+    auto &coordinates = shape.parts[0].coordinates;
+    if (coordinates.empty()) return;
 
-  void visitPolygon(const SHPObject &shape, Tags &tags, Visitor &visitor) const {
-    PolygonMembers members;
-    members.reserve(static_cast<std::size_t>(shape.nParts));
-    std::size_t coordIndex = 0;
-    for (std::size_t i = 0, partNum = 0; i < shape.nVertices; ++i) {
-      int startIndex = shape.panPartStart[partNum];
-      if (partNum < shape.nParts && startIndex==i) {
-        coordIndex = static_cast<std::size_t>(partNum);
-        members.push_back(PolygonMember());
-        // TODO check inner/outer? Check whether this flag is true for closed polygon only
-        members[partNum].isRing = shape.panPartType[partNum]==SHPP_RING;
-        int endIndex = partNum==shape.nParts - 1
-                       ? shape.nVertices
-                       : shape.panPartStart[partNum + 1];
-        members[coordIndex].coordinates.reserve(static_cast<std::size_t>(endIndex - startIndex));
-        ++partNum;
-      }
-      members[coordIndex].coordinates.push_back(utymap::GeoCoordinate(shape.padfY[i], shape.padfX[i]));
-    }
-    visitor.visitRelation(members, tags);
+    bool isRing = coordinates[0]==coordinates[coordinates.size() - 1];
+    visitor.visitWay(coordinates, shape.tags, isRing);
   }
 };
 
@@ -0,0 +1,292 @@
+#include "formats/shape/ShapeReader.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::formats;
+
+namespace {
+const std::size_t ShpHeaderSize = 100;
+const std::size_t ShxRecordSize = 8;
+const std::size_t ShpRecordHeaderSize = 8;
+const std::size_t DbfFieldSize = 32;
+const char DbfHeaderTerminator = 0x0D;
+
+/// Keeps whole file mapped into memory.
+class MappedFile final {
+ public:
+  explicit MappedFile(const std::string &path) :
+      mapping_(path.c_str(), boost::interprocess::read_only),
+      region_(mapping_, boost::interprocess::read_only) {
+  }
+
+  const char *data() const {
+    return static_cast<const char *>(region_.get_address());
+  }
+
+  std::size_t size() const {
+    return region_.get_size();
+  }
+
+ private:
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+};
+
+std::int32_t readBigEndian(const char *data) {
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+  return static_cast<std::int32_t>((static_cast<std::uint32_t>(bytes[0]) << 24) |
+                                   (static_cast<std::uint32_t>(bytes[1]) << 16) |
+                                   (static_cast<std::uint32_t>(bytes[2]) << 8) |
+                                   static_cast<std::uint32_t>(bytes[3]));
+}
+
+template<typename T>
+T readLittleEndian(const char *data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+/// Returns path of existing file with given extension in lower or upper case.
+std::string findFile(const std::string &basePath, const std::string &extension, const std::string &upperExtension) {
+  for (const auto &path : { basePath + extension, basePath + upperExtension }) {
+    if (boost::filesystem::exists(path))
+      return path;
+  }
+  throw std::domain_error("Cannot open " + extension.substr(1) + " file.");
+}
+
+/// Strips extension from path if it has one.
+std::string getBasePath(const std::string &path) {
+  auto dot = path.find_last_of('.');
+  auto separator = path.find_last_of("\\/");
+  return dot != std::string::npos && (separator == std::string::npos || dot > separator)
+         ? path.substr(0, dot)
+         : path;
+}
+
+ShapeReader::ShapeType getShapeType(std::int32_t type) {
+  switch (type) {
+    case 0: return ShapeReader::ShapeType::Null;
+    case 1:
+    case 11:
+    case 21: return ShapeReader::ShapeType::Point;
+    case 3:
+    case 13:
+    case 23: return ShapeReader::ShapeType::Arc;
+    case 5:
+    case 15:
+    case 25: return ShapeReader::ShapeType::Polygon;
+    default: return ShapeReader::ShapeType::Unsupported;
+  }
+}
+
+/// Describes field of dbf table.
+struct DbfField final {
+  std::string name;
+  char type;
+  std::size_t offset;
+  std::size_t size;
+  std::size_t decimals;
+};
+}
+
+class ShapeReader::ShapeReaderImpl final {
+ public:
+  explicit ShapeReaderImpl(const std::string &path) :
+      shp_(findFile(getBasePath(path), ".shp", ".SHP")),
+      shx_(findFile(getBasePath(path), ".shx", ".SHX")),
+      dbf_(findFile(getBasePath(path), ".dbf", ".DBF")) {
+    if (shp_.size() < ShpHeaderSize || shx_.size() < ShpHeaderSize)
+      throw std::domain_error("Invalid shp file.");
+    count_ = (shx_.size() - ShpHeaderSize) / ShxRecordSize;
+
+    readDbfHeader();
+    if (fields_.empty())
+      throw std::domain_error("There are no fields in dbf table.");
+    if (count_ != dbfCount_)
+      throw std::domain_error("dbf file has different entity count.");
+  }
+
+  std::size_t size() const {
+    return count_;
+  }
+
+  void read(std::size_t index, Shape &shape) const {
+    if (index >= count_)
+      throw std::domain_error("Unable to read shape:" + utymap::utils::toString(index));
+
+    readShape(index, shape);
+    readTags(index, shape.tags);
+  }
+
+ private:
+  void readDbfHeader() {
+    const char *data = dbf_.data();
+    if (dbf_.size() < DbfFieldSize)
+      throw std::domain_error("Invalid dbf file.");
+
+    dbfCount_ = readLittleEndian<std::uint32_t>(data + 4);
+    dbfHeaderSize_ = readLittleEndian<std::uint16_t>(data + 8);
+    dbfRecordSize_ = readLittleEndian<std::uint16_t>(data + 10);
+    if (dbfHeaderSize_ > dbf_.size() || dbfHeaderSize_ + dbfCount_ * dbfRecordSize_ > dbf_.size())
+      throw std::domain_error("Invalid dbf file.");
+
+    // NOTE first byte of record is deletion flag.
+    std::size_t offset = 1;
+    for (std::size_t position = DbfFieldSize;
+         position + DbfFieldSize <= dbfHeaderSize_ && data[position] != DbfHeaderTerminator;
+         position += DbfFieldSize) {
+      const auto *bytes = reinterpret_cast<const unsigned char *>(data + position);
+      DbfField field;
+      field.name.assign(data + position, strnlen(data + position, 11));
+      while (field.name.size() > 1 && field.name.back() == ' ')
+        field.name.pop_back();
+      field.type = data[position + 11];
+      field.offset = offset;
+      field.size = bytes[16];
+      field.decimals = bytes[17];
+      // NOTE long character field keeps high byte of its size in decimals.
+      if (field.type == 'C') {
+        field.size += field.decimals * 256;
+        field.decimals = 0;
+      }
+      offset += field.size;
+      fields_.push_back(field);
+    }
+
+    if (offset > dbfRecordSize_)
+      throw std::domain_error("Invalid dbf file.");
+  }
+
+  void readShape(std::size_t index, Shape &shape) const {
+    const char *entry = shx_.data() + ShpHeaderSize + index * ShxRecordSize;
+    auto offset = static_cast<std::size_t>(readBigEndian(entry)) * 2;
+    auto length = static_cast<std::size_t>(readBigEndian(entry + 4)) * 2;
+    if (offset + ShpRecordHeaderSize + length > shp_.size())
+      throw std::domain_error("Unable to read shape:" + utymap::utils::toString(index));
+
+    const char *content = shp_.data() + offset + ShpRecordHeaderSize;
+    shape.parts.clear();
+    shape.typeCode = length < 4 ? 0 : readLittleEndian<std::int32_t>(content);
+    shape.type = getShapeType(shape.typeCode);
+
+    switch (shape.type) {
+      case ShapeType::Point:
+        if (length < 20) throw std::domain_error("Invalid point shape:" + utymap::utils::toString(index));
+        shape.coordinate = readCoordinate(content + 4);
+        break;
+      case ShapeType::Arc:
+      case ShapeType::Polygon:
+        readParts(index, content, length, shape.type == ShapeType::Polygon, shape.parts);
+        break;
+      default: break;
+    }
+  }
+
+  /// Reads parts of arc or polygon directly into coordinate buffers.
+  static void readParts(std::size_t index, const char *content, std::size_t length,
+                        bool isRing, PolygonMembers &parts) {
+    if (length < 44) throw std::domain_error("Invalid shape:" + utymap::utils::toString(index));
+    auto partCount = readLittleEndian<std::int32_t>(content + 36);
+    auto pointCount = readLittleEndian<std::int32_t>(content + 40);
+    if (partCount < 0 || pointCount < 0 ||
+        44 + static_cast<std::size_t>(partCount) * 4 + static_cast<std::size_t>(pointCount) * 16 > length)
+      throw std::domain_error("Invalid shape:" + utymap::utils::toString(index));
+
+    const char *partStarts = content + 44;
+    const char *points = partStarts + partCount * 4;
+    parts.resize(static_cast<std::size_t>(partCount));
+    for (std::int32_t i = 0; i < partCount; ++i) {
+      auto start = readLittleEndian<std::int32_t>(partStarts + i * 4);
+      auto end = i + 1 < partCount ? readLittleEndian<std::int32_t>(partStarts + (i + 1) * 4) : pointCount;
+      if (start < 0 || start > end || end > pointCount)
+        throw std::domain_error("Invalid shape:" + utymap::utils::toString(index));
+
+      auto &part = parts[i];
+      part.isRing = isRing;
+      part.coordinates.clear();
+      part.coordinates.reserve(static_cast<std::size_t>(end - start));
+      for (std::int32_t j = start; j < end; ++j)
+        part.coordinates.push_back(readCoordinate(points + j * 16));
+    }
+  }
+
+  static GeoCoordinate readCoordinate(const char *data) {
+    return GeoCoordinate(readLittleEndian<double>(data + 8), readLittleEndian<double>(data));
+  }
+
+  /// Reads not null attributes of record. Values are converted in the same way as by shapelib.
+  void readTags(std::size_t index, Tags &tags) const {
+    const char *record = dbf_.data() + dbfHeaderSize_ + index * dbfRecordSize_;
+    tags.clear();
+    for (const auto &field : fields_) {
+      const char *value = record + field.offset;
+      std::size_t size = strnlen(value, field.size);
+      while (size > 0 && *value == ' ') {
+        ++value;
+        --size;
+      }
+      while (size > 0 && value[size - 1] == ' ')
+        --size;
+
+      if (isNull(field.type, value, size))
+        continue;
+
+      Tag tag;
+      tag.key = field.name;
+      if (field.type == 'N' || field.type == 'F') {
+        double number = std::atof(std::string(value, size).c_str());
+        tag.value = field.decimals > 0 || field.size > 10
+                    ? utymap::utils::toString(number)
+                    : utymap::utils::toString(static_cast<int>(number));
+      } else if (field.type != 'L') {
+        tag.value.assign(value, size);
+      }
+      tags.push_back(std::move(tag));
+    }
+  }
+
+  static bool isNull(char type, const char *value, std::size_t size) {
+    switch (type) {
+      case 'N':
+      case 'F': return size == 0 || value[0] == '*';
+      case 'D': return size >= 8 && std::strncmp(value, "00000000", 8) == 0;
+      case 'L': return size > 0 && value[0] == '?';
+      default: return size == 0;
+    }
+  }
+
+  MappedFile shp_;
+  MappedFile shx_;
+  MappedFile dbf_;
+  std::size_t count_;
+  std::size_t dbfCount_;
+  std::size_t dbfHeaderSize_;
+  std::size_t dbfRecordSize_;
+  std::vector<DbfField> fields_;
+};
+
+ShapeReader::ShapeReader(const std::string &path) :
+    pimpl_(utymap::utils::make_unique<ShapeReaderImpl>(path)) {
+}
+
+ShapeReader::~ShapeReader() {}
+
+std::size_t ShapeReader::size() const {
+  return pimpl_->size();
+}
+
+void ShapeReader::read(std::size_t index, Shape &shape) const {
+  pimpl_->read(index, shape);
+}
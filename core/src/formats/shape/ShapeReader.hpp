@@ -0,0 +1,52 @@
+#ifndef FORMATS_SHAPE_SHAPEREADER_HPP_INCLUDED
+#define FORMATS_SHAPE_SHAPEREADER_HPP_INCLUDED
+
+#include "GeoCoordinate.hpp"
+#include "formats/FormatTypes.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace utymap {
+namespace formats {
+
+/// Reads records of shapefile which .shp, .shx and .dbf files are memory mapped.
+/// Shapes are decoded from mapped data directly into coordinate buffers.
+/// NOTE reader keeps no state between reads, so records can be read concurrently.
+class ShapeReader final {
+ public:
+  enum class ShapeType { Null, Point, Arc, Polygon, Unsupported };
+
+  /// Keeps decoded record.
+  struct Shape final {
+    ShapeType type = ShapeType::Null;
+    /// Type code of record as stored in shp file.
+    std::int32_t typeCode = 0;
+    /// Coordinate of point.
+    utymap::GeoCoordinate coordinate;
+    /// Parts of arc or rings of polygon.
+    PolygonMembers parts;
+    Tags tags;
+  };
+
+  /// Opens shapefile by path with or without extension.
+  explicit ShapeReader(const std::string &path);
+
+  ~ShapeReader();
+
+  /// Returns amount of records.
+  std::size_t size() const;
+
+  /// Reads record with given index.
+  void read(std::size_t index, Shape &shape) const;
+
+ private:
+  class ShapeReaderImpl;
+  std::unique_ptr<ShapeReaderImpl> pimpl_;
+};
+
+}
+}
+
+#endif  // FORMATS_SHAPE_SHAPEREADER_HPP_INCLUDED
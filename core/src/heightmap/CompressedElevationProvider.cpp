@@ -0,0 +1,437 @@
+#include "BoundingBox.hpp"
+#include "heightmap/CompressedElevationProvider.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/LruCache.hpp"
+#include "utils/Metrics.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+
+namespace {
+const char Magic[] = "UHGZ";
+const std::uint16_t Version = 1;
+/// Magic, version, block size, total pixels, seconds per pixel and blocks per side.
+const std::size_t HeaderSize = 20;
+
+struct CellKey {
+  int lat, lon;
+
+  bool operator<(const CellKey &other) const {
+    return lat < other.lat || (lat==other.lat && lon < other.lon);
+  }
+
+  bool operator==(const CellKey &other) const {
+    return lat==other.lat && lon==other.lon;
+  }
+};
+
+struct BlockKey {
+  CellKey cell;
+  int block;
+
+  bool operator<(const BlockKey &other) const {
+    return cell < other.cell || (cell==other.cell && block < other.block);
+  }
+};
+
+/// Mapped hgz file with its header values.
+struct Cell {
+  boost::interprocess::mapped_region region;
+  const unsigned char *data;
+  int blockSize, totalPx, secondsPerPx, blocksPerSide;
+};
+
+/// Decoded block: samples of (block size + 1) rows from south, so neighbour pixels
+/// needed for interpolation are always inside of one block.
+struct Block {
+  std::vector<std::int16_t> samples;
+};
+
+/// Last cell and block used by calling thread.
+struct Lookup {
+  std::uint64_t owner = 0;
+  CellKey cellKey {0, 0};
+  std::shared_ptr<Cell> cell;
+  int blockIndex = -1;
+  std::shared_ptr<Block> block;
+};
+
+std::uint16_t readUInt16(const unsigned char *pos) {
+  return static_cast<std::uint16_t>(pos[0] | (pos[1] << 8));
+}
+
+std::uint32_t readUInt32(const unsigned char *pos) {
+  return static_cast<std::uint32_t>(pos[0]) | (static_cast<std::uint32_t>(pos[1]) << 8) |
+      (static_cast<std::uint32_t>(pos[2]) << 16) | (static_cast<std::uint32_t>(pos[3]) << 24);
+}
+
+std::uint64_t readUInt64(const unsigned char *pos) {
+  return static_cast<std::uint64_t>(readUInt32(pos)) | (static_cast<std::uint64_t>(readUInt32(pos + 4)) << 32);
+}
+
+void writeUInt(std::vector<char> &buffer, std::uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i)
+    buffer.push_back(static_cast<char>((value >> (i*8)) & 0xFF));
+}
+
+/// Compresses block samples: rows are delta encoded and low bytes are stored before
+/// high ones, so smooth terrain turns into long runs of small values.
+std::vector<char> encodeBlock(const std::vector<std::int16_t> &samples, int size) {
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+  std::vector<Bytef> raw(samples.size()*2);
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    std::uint16_t delta = static_cast<std::uint16_t>(i%size==0 ? samples[i] : samples[i] - samples[i - 1]);
+    raw[i] = static_cast<Bytef>(delta & 0xFF);
+    raw[i + samples.size()] = static_cast<Bytef>(delta >> 8);
+  }
+  uLongf resultSize = compressBound(static_cast<uLong>(raw.size()));
+  std::vector<char> result(resultSize);
+  if (compress2(reinterpret_cast<Bytef *>(result.data()), &resultSize,
+                raw.data(), static_cast<uLong>(raw.size()), Z_BEST_COMPRESSION)!=Z_OK)
+    throw std::domain_error("Failed to compress elevation block.");
+  result.resize(resultSize);
+  return result;
+#else
+  throw std::domain_error("Compression is not supported.");
+#endif
+}
+
+std::shared_ptr<Block> decodeBlock(const unsigned char *data, std::size_t size, int blockSize) {
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+  std::size_t count = static_cast<std::size_t>((blockSize + 1)*(blockSize + 1));
+  std::vector<Bytef> raw(count*2);
+  uLongf rawSize = static_cast<uLongf>(raw.size());
+  if (uncompress(raw.data(), &rawSize, data, static_cast<uLong>(size))!=Z_OK || rawSize!=raw.size())
+    throw std::domain_error("Failed to decompress elevation block.");
+
+  auto block = std::make_shared<Block>();
+  block->samples.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    auto delta = static_cast<std::int16_t>(raw[i] | (raw[i + count] << 8));
+    block->samples[i] = i%(blockSize + 1)==0 ? delta : static_cast<std::int16_t>(block->samples[i - 1] + delta);
+  }
+  return block;
+#else
+  throw std::domain_error("Compression is not supported.");
+#endif
+}
+
+/// Returns name of SRTM cell file with given extension.
+std::string getFileName(const CellKey &key, const std::string &extension) {
+  std::ostringstream stream;
+  stream << std::setfill('0')
+         << (key.lat > 0 ? 'N' : 'S')
+         << std::setw(2) << std::abs(key.lat) << std::setw(0)
+         << (key.lon > 0 ? 'E' : 'W')
+         << std::setw(3) << std::abs(key.lon)
+         << extension;
+  return stream.str();
+}
+
+std::uint64_t nextId() {
+  static std::atomic<std::uint64_t> counter(0);
+  return ++counter;
+}
+}
+
+class CompressedElevationProvider::CompressedElevationProviderImpl final {
+ public:
+  CompressedElevationProviderImpl(const std::string &indexPath, int maxBlocks, int maxCells) :
+      id_(nextId()),
+      dataPath_(indexPath + "/data/"),
+      maxCells_(static_cast<std::size_t>(std::max(1, maxCells))),
+      maxBlocks_(static_cast<std::size_t>(std::max(1, maxBlocks))),
+      cells_(maxCells_),
+      blocks_(maxBlocks_) {
+  }
+
+  std::size_t getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return cells_.weigh(getCellSize) + blocks_.weigh(getBlockSize);
+  }
+
+  /// Drops decoded blocks first as they are cheaper to restore than mapped cells.
+  void trim(std::size_t maxBytes) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::size_t cellBytes = cells_.weigh(getCellSize);
+    std::size_t blockBytes = blocks_.trim(maxBytes > cellBytes ? maxBytes - cellBytes : 0, getBlockSize);
+    cells_.trim(maxBytes > blockBytes ? maxBytes - blockBytes : 0, getCellSize);
+  }
+
+  void prefetch(const QuadKey &quadKey) const {
+    BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    int minLat = static_cast<int>(bbox.minPoint.latitude), maxLat = static_cast<int>(bbox.maxPoint.latitude);
+    int minLon = static_cast<int>(bbox.minPoint.longitude), maxLon = static_cast<int>(bbox.maxPoint.longitude);
+    if (static_cast<std::size_t>((maxLat - minLat + 1)*(maxLon - minLon + 1)) > maxCells_)
+      return;
+
+    std::vector<std::pair<BlockKey, std::shared_ptr<Cell>>> blocks;
+    for (int lat = minLat; lat <= maxLat; ++lat) {
+      for (int lon = minLon; lon <= maxLon; ++lon) {
+        CellKey cellKey {lat, lon};
+        auto cell = loadCell(cellKey);
+        auto toPx = [&](double degrees, int origin) {
+          return clamp(static_cast<int>((degrees - origin)*3600/cell->secondsPerPx), 0, cell->totalPx - 2);
+        };
+        int minY = toPx(bbox.minPoint.latitude, lat)/cell->blockSize, maxY = toPx(bbox.maxPoint.latitude, lat)/cell->blockSize;
+        int minX = toPx(bbox.minPoint.longitude, lon)/cell->blockSize, maxX = toPx(bbox.maxPoint.longitude, lon)/cell->blockSize;
+        for (int y = minY; y <= maxY; ++y)
+          for (int x = minX; x <= maxX; ++x)
+            blocks.emplace_back(BlockKey {cellKey, y*cell->blocksPerSide + x}, cell);
+      }
+    }
+
+    if (blocks.size() > maxBlocks_/2)
+      return;
+    for (const auto &block : blocks)
+      loadBlock(block.first, *block.second);
+  }
+
+  double getElevation(double latitude, double longitude) const {
+    thread_local Lookup lookup;
+    int latDec = static_cast<int>(latitude);
+    int lonDec = static_cast<int>(longitude);
+    CellKey cellKey {latDec, lonDec};
+    if (lookup.owner!=id_ || !(lookup.cellKey==cellKey)) {
+      lookup.cell = loadCell(cellKey);
+      lookup.owner = id_;
+      lookup.cellKey = cellKey;
+      lookup.blockIndex = -1;
+    }
+    const Cell &cell = *lookup.cell;
+
+    double secondsLat = (latitude - latDec)*3600;
+    double secondsLon = (longitude - lonDec)*3600;
+    int y = clamp(static_cast<int>(secondsLat/cell.secondsPerPx), 0, cell.totalPx - 2);
+    int x = clamp(static_cast<int>(secondsLon/cell.secondsPerPx), 0, cell.totalPx - 2);
+
+    int blockY = y/cell.blockSize, blockX = x/cell.blockSize;
+    int blockIndex = blockY*cell.blocksPerSide + blockX;
+    if (lookup.blockIndex!=blockIndex) {
+      lookup.block = loadBlock(BlockKey {cellKey, blockIndex}, cell);
+      lookup.blockIndex = blockIndex;
+    }
+
+    int size = cell.blockSize + 1;
+    const std::int16_t *bottom = lookup.block->samples.data() +
+        (y - blockY*cell.blockSize)*size + (x - blockX*cell.blockSize);
+    const std::int16_t *top = bottom + size;
+
+    double dy = std::fmod(secondsLat, cell.secondsPerPx)/cell.secondsPerPx;
+    double dx = std::fmod(secondsLon, cell.secondsPerPx)/cell.secondsPerPx;
+
+    // Bilinear interpolation as in SrtmElevationProvider.
+    return top[0]*dy*(1 - dx) + top[1]*dy*dx + bottom[0]*(1 - dy)*(1 - dx) + bottom[1]*(1 - dy)*dx;
+  }
+
+  static void compress(const std::string &hgtPath, const std::string &hgzPath, int blockSize) {
+    using namespace boost::interprocess;
+
+    mapped_region region;
+    try {
+      file_mapping file(hgtPath.c_str(), read_only);
+      region = mapped_region(file, read_only);
+    } catch (const interprocess_exception &) {
+      throw std::domain_error("Cannot load srtm file:" + hgtPath);
+    }
+
+    int totalPx = static_cast<int>(std::lround(std::sqrt(region.get_size()/2.)));
+    if (totalPx < 2 || static_cast<std::size_t>(totalPx*totalPx*2)!=region.get_size() || 3600%(totalPx - 1)!=0)
+      throw std::domain_error("Cannot load srtm file:" + hgtPath);
+    if (blockSize < 1 || blockSize > std::numeric_limits<std::uint16_t>::max() - 1)
+      throw std::invalid_argument("Invalid elevation block size.");
+
+    const auto *data = static_cast<const unsigned char *>(region.get_address());
+    int blocksPerSide = (totalPx - 2)/blockSize + 1;
+    int size = blockSize + 1;
+
+    std::vector<char> blocks;
+    std::vector<std::uint64_t> offsets;
+    std::size_t dataOffset = HeaderSize + static_cast<std::size_t>(blocksPerSide*blocksPerSide + 1)*8;
+    std::vector<std::int16_t> samples(static_cast<std::size_t>(size*size));
+    for (int blockY = 0; blockY < blocksPerSide; ++blockY) {
+      for (int blockX = 0; blockX < blocksPerSide; ++blockX) {
+        for (int row = 0; row < size; ++row) {
+          // hgt rows are stored from north to south.
+          int y = std::min(blockY*blockSize + row, totalPx - 1);
+          for (int column = 0; column < size; ++column) {
+            int x = std::min(blockX*blockSize + column, totalPx - 1);
+            std::size_t pos = static_cast<std::size_t>(((totalPx - 1 - y)*totalPx + x)*2);
+            samples[row*size + column] = static_cast<std::int16_t>((data[pos] << 8) | data[pos + 1]);
+          }
+        }
+        offsets.push_back(dataOffset + blocks.size());
+        auto encoded = encodeBlock(samples, size);
+        blocks.insert(blocks.end(), encoded.begin(), encoded.end());
+      }
+    }
+    offsets.push_back(dataOffset + blocks.size());
+
+    std::vector<char> header(Magic, Magic + 4);
+    writeUInt(header, Version, 2);
+    writeUInt(header, static_cast<std::uint64_t>(blockSize), 2);
+    writeUInt(header, static_cast<std::uint64_t>(totalPx), 4);
+    writeUInt(header, static_cast<std::uint64_t>(3600/(totalPx - 1)), 4);
+    writeUInt(header, static_cast<std::uint64_t>(blocksPerSide), 4);
+    for (auto offset : offsets)
+      writeUInt(header, offset, 8);
+
+    std::ofstream file(hgzPath, std::ios::binary | std::ios::trunc);
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+    file.write(blocks.data(), static_cast<std::streamsize>(blocks.size()));
+    if (!file.good())
+      throw std::domain_error("Cannot write elevation file:" + hgzPath);
+  }
+
+ private:
+  static int clamp(int n, int lower, int upper) {
+    return std::max(lower, std::min(n, upper));
+  }
+
+  std::shared_ptr<Cell> loadCell(const CellKey &key) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (cells_.exists(key))
+      return cells_.get(key);
+
+    auto cell = readCell(dataPath_ + getFileName(key, ".hgz"));
+    utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::ElevationLoads);
+    cells_.put(key, cell);
+    return cell;
+  }
+
+  /// Returns decoded block from cache or decodes it.
+  /// NOTE block is decoded without lock, so two threads may decode the same block at once.
+  std::shared_ptr<Block> loadBlock(const BlockKey &key, const Cell &cell) const {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      if (blocks_.exists(key))
+        return blocks_.get(key);
+    }
+
+    const unsigned char *offsets = cell.data + HeaderSize + static_cast<std::size_t>(key.block)*8;
+    std::uint64_t start = readUInt64(offsets), end = readUInt64(offsets + 8);
+    if (start > end || end > cell.region.get_size())
+      throw std::domain_error("Corrupted elevation block.");
+    auto block = decodeBlock(cell.data + start, static_cast<std::size_t>(end - start), cell.blockSize);
+
+    std::lock_guard<std::mutex> lock(lock_);
+    blocks_.put(key, block);
+    return block;
+  }
+
+  static std::size_t getCellSize(const Cell &cell) {
+    return cell.region.get_size();
+  }
+
+  static std::size_t getBlockSize(const Block &block) {
+    return block.samples.capacity()*sizeof(std::int16_t);
+  }
+
+  static std::shared_ptr<Cell> readCell(const std::string &path) {
+    using namespace boost::interprocess;
+
+    auto cell = std::make_shared<Cell>();
+    try {
+      file_mapping file(path.c_str(), read_only);
+      cell->region = mapped_region(file, read_only);
+    } catch (const interprocess_exception &) {
+      throw std::domain_error("Cannot load elevation file:" + path);
+    }
+
+    cell->data = static_cast<const unsigned char *>(cell->region.get_address());
+    std::size_t size = cell->region.get_size();
+    if (size < HeaderSize || std::memcmp(cell->data, Magic, 4)!=0 || readUInt16(cell->data + 4)!=Version)
+      throw std::domain_error("Unsupported elevation file:" + path);
+
+    cell->blockSize = readUInt16(cell->data + 6);
+    cell->totalPx = static_cast<int>(readUInt32(cell->data + 8));
+    cell->secondsPerPx = static_cast<int>(readUInt32(cell->data + 12));
+    cell->blocksPerSide = static_cast<int>(readUInt32(cell->data + 16));
+    if (cell->blockSize < 1 || cell->totalPx < 2 || cell->secondsPerPx < 1 ||
+        cell->blocksPerSide!=(cell->totalPx - 2)/cell->blockSize + 1 ||
+        size < HeaderSize + static_cast<std::size_t>(cell->blocksPerSide*cell->blocksPerSide + 1)*8)
+      throw std::domain_error("Corrupted elevation file:" + path);
+
+    return cell;
+  }
+
+  const std::uint64_t id_;
+  const std::string dataPath_;
+  const std::size_t maxCells_;
+  const std::size_t maxBlocks_;
+  mutable utymap::utils::LruCache<CellKey, Cell> cells_;
+  mutable utymap::utils::LruCache<BlockKey, Block> blocks_;
+  mutable std::mutex lock_;
+};
+
+CompressedElevationProvider::CompressedElevationProvider(const std::string &indexPath, int maxBlocks, int maxCells) :
+    pimpl_(utymap::utils::make_unique<CompressedElevationProviderImpl>(indexPath, maxBlocks, maxCells)) {
+}
+
+CompressedElevationProvider::~CompressedElevationProvider() {}
+
+double CompressedElevationProvider::getElevation(const QuadKey &, const GeoCoordinate &coordinate) const {
+  return pimpl_->getElevation(coordinate.latitude, coordinate.longitude);
+}
+
+double CompressedElevationProvider::getElevation(const QuadKey &, double latitude, double longitude) const {
+  return pimpl_->getElevation(latitude, longitude);
+}
+
+void CompressedElevationProvider::getElevations(const QuadKey &,
+                                                const GeoCoordinate *coordinates,
+                                                double *elevations,
+                                                std::size_t count) const {
+  for (std::size_t i = 0; i < count; ++i)
+    elevations[i] = pimpl_->getElevation(coordinates[i].latitude, coordinates[i].longitude);
+}
+
+void CompressedElevationProvider::prefetch(const QuadKey &quadKey) const {
+  pimpl_->prefetch(quadKey);
+}
+
+std::size_t CompressedElevationProvider::getMemoryUsage() const {
+  return pimpl_->getMemoryUsage();
+}
+
+void CompressedElevationProvider::trim(std::size_t maxBytes) const {
+  pimpl_->trim(maxBytes);
+}
+
+void CompressedElevationProvider::compress(const std::string &hgtPath, const std::string &hgzPath, int blockSize) {
+  CompressedElevationProviderImpl::compress(hgtPath, hgzPath, blockSize);
+}
+
+void CompressedElevationProvider::compressAll(const std::string &indexPath, int blockSize) {
+  namespace fs = boost::filesystem;
+  fs::directory_iterator end;
+  for (fs::directory_iterator it(indexPath + "/data/"); it!=end; ++it) {
+    if (!fs::is_regular_file(it->path()) || it->path().extension()!=".hgt")
+      continue;
+    fs::path hgzPath = it->path();
+    hgzPath.replace_extension(".hgz");
+    compress(it->path().string(), hgzPath.string(), blockSize);
+  }
+}
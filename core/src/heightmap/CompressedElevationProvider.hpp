@@ -0,0 +1,57 @@
+#ifndef HEIGHTMAP_COMPRESSEDELEVATIONPROVIDER_HPP_DEFINED
+#define HEIGHTMAP_COMPRESSEDELEVATIONPROVIDER_HPP_DEFINED
+
+#include "heightmap/ElevationProvider.hpp"
+
+#include <memory>
+#include <string>
+
+namespace utymap {
+namespace heightmap {
+
+/// Provides elevation from SRTM cells stored as compressed hgz files: cell is split into
+/// square blocks which are zlib compressed independently, so only touched blocks are decoded.
+/// NOTE decoded blocks are kept in cache bounded by maxBlocks and shared by all threads,
+/// each thread remembers its last block, so lock is taken only when block changes.
+class CompressedElevationProvider final : public ElevationProvider {
+ public:
+  /// Default amount of samples along block side.
+  static const int DefaultBlockSize = 256;
+
+  CompressedElevationProvider(const std::string &indexPath, int maxBlocks = 64, int maxCells = 4);
+
+  ~CompressedElevationProvider();
+
+  double getElevation(const utymap::QuadKey &quadKey, const utymap::GeoCoordinate &coordinate) const override;
+
+  double getElevation(const utymap::QuadKey &quadKey, double latitude, double longitude) const override;
+
+  void getElevations(const utymap::QuadKey &quadKey,
+                     const utymap::GeoCoordinate *coordinates,
+                     double *elevations,
+                     std::size_t count) const override;
+
+  /// Maps cells covering given quadkey and decodes their blocks intersecting it.
+  /// NOTE nothing is decoded if blocks would take more than half of block cache.
+  void prefetch(const utymap::QuadKey &quadKey) const override;
+
+  /// Returns size of mapped cells and decoded blocks.
+  std::size_t getMemoryUsage() const override;
+
+  void trim(std::size_t maxBytes) const override;
+
+  /// Compresses hgt file into hgz file with blocks of given size.
+  static void compress(const std::string &hgtPath, const std::string &hgzPath, int blockSize = DefaultBlockSize);
+
+  /// Compresses all hgt files of index data into hgz files placed next to them.
+  static void compressAll(const std::string &indexPath, int blockSize = DefaultBlockSize);
+
+ private:
+  class CompressedElevationProviderImpl;
+  std::unique_ptr<CompressedElevationProviderImpl> pimpl_;
+};
+
+}
+}
+
+#endif // HEIGHTMAP_COMPRESSEDELEVATIONPROVIDER_HPP_DEFINED
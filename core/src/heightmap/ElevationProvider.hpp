@@ -4,6 +4,8 @@
 #include "GeoCoordinate.hpp"
 #include "QuadKey.hpp"
 
+#include <cstddef>
+
 namespace utymap {
 namespace heightmap {
 
@@ -16,6 +18,40 @@ class ElevationProvider {
   /// Gets elevation for given geocoordinate.
   virtual double getElevation(const QuadKey &quadkey, double latitude, double longitude) const = 0;
 
+  /// Gets elevations for given geocoordinates at once.
+  virtual void getElevations(const QuadKey &quadkey,
+                             const utymap::GeoCoordinate *coordinates,
+                             double *elevations,
+                             std::size_t count) const {
+    for (std::size_t i = 0; i < count; ++i)
+      elevations[i] = getElevation(quadkey, coordinates[i]);
+  }
+
+  /// Returns true if elevation is zero everywhere, so callers can skip querying it.
+  virtual bool isFlat() const {
+    return false;
+  }
+
+  /// Loads data needed for given quadkey in advance, e.g. on background thread before tile is built.
+  /// NOTE default implementation does nothing.
+  virtual void prefetch(const QuadKey &) const {
+  }
+
+  /// Returns approximate memory used by cached data including mapped files.
+  virtual std::size_t getMemoryUsage() const {
+    return 0;
+  }
+
+  /// Drops least recently used data until cache uses at most given amount of memory.
+  /// NOTE dropped data is loaded again on next request.
+  virtual void trim(std::size_t) const {
+  }
+
+  /// Sets max amount of data items, e.g. files, which are kept in cache.
+  /// NOTE default implementation does nothing.
+  virtual void setMaxCacheSize(int) const {
+  }
+
   virtual ~ElevationProvider() = default;
 };
 
@@ -3,6 +3,8 @@
 
 #include "heightmap/ElevationProvider.hpp"
 
+#include <algorithm>
+
 namespace utymap {
 namespace heightmap {
 
@@ -17,6 +19,15 @@ class FlatElevationProvider : public ElevationProvider {
   double getElevation(const utymap::QuadKey &, double, double) const override {
     return 0;
   };
+
+  void getElevations(const utymap::QuadKey &, const utymap::GeoCoordinate *,
+                     double *elevations, std::size_t count) const override {
+    std::fill(elevations, elevations + count, 0.);
+  }
+
+  bool isFlat() const override {
+    return true;
+  }
 };
 
 }
@@ -4,23 +4,43 @@
 #include "heightmap/ElevationProvider.hpp"
 #include "utils/CoreUtils.hpp"
 #include "utils/GeoUtils.hpp"
+#include "utils/LruCache.hpp"
+#include "utils/Metrics.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <stdexcept>
 #include <sstream>
-#include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 
 namespace utymap {
 namespace heightmap {
 
-/// Provides the way to get elevation for given location from grid 
-/// represented by comma separated list of integers
+/// Provides the way to get elevation for given location from grid stored either in binary
+/// file (<quadkey>.grd) which is memory mapped and read in place, or in text file (<quadkey>.ele)
+/// represented by comma separated list of integers. Binary file is preferred when both exist.
+/// Binary file starts with little endian header: "UGRD", version and sample type as uint16,
+/// resolution, x start, y start, x step and y step as int32; samples follow row by row
+/// from bottom left corner as little endian int16 or float32.
+/// NOTE loaded data is immutable and each thread remembers data of its last quadkey,
+/// so lock is taken only when another quadkey is requested. At most maxCacheSize least
+/// recently used grids are kept.
 class GridElevationProvider final : public ElevationProvider {
+ public:
+  /// Type of samples in binary grid file.
+  enum class SampleType : std::uint16_t { Int16 = 0, Float32 = 1 };
+
+ private:
   /// Holds elevation data information.
   struct EleData {
     int xStart = 0;
@@ -29,14 +49,40 @@ class GridElevationProvider final : public ElevationProvider {
     int yStep = 0;
     int resolution = 0;
 
+    /// Heights parsed from text file.
     std::vector<int> heights;
+
+    /// Samples of binary file pointing into mapped region.
+    boost::interprocess::mapped_region region;
+    const unsigned char *samples = nullptr;
+    SampleType sampleType = SampleType::Int16;
+
+    double height(int index) const {
+      if (samples==nullptr)
+        return heights[index];
+      if (sampleType==SampleType::Int16)
+        return static_cast<std::int16_t>(readUInt16(samples + index*2));
+      std::uint32_t bits = readUInt32(samples + index*4);
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  };
+
+  /// Data of last quadkey used by calling thread.
+  struct DataLookup {
+    std::uint64_t owner = 0;
+    QuadKey quadKey;
+    std::shared_ptr<const EleData> data;
   };
 
-  const double Scale = 1E7;
+  static constexpr double Scale = 1E7;
+  static constexpr std::uint16_t Version = 1;
+  static constexpr std::size_t HeaderSize = 28;
 
  public:
-  GridElevationProvider(const std::string& indexPath) :
-      dataPath_(indexPath + "/data/") {
+  GridElevationProvider(const std::string& indexPath, int maxCacheSize = 64) :
+      id_(nextId()), data_(static_cast<std::size_t>(std::max(1, maxCacheSize))), dataPath_(indexPath + "/data/") {
   }
 
   /// Gets elevation for given geocoordinate.
@@ -46,31 +92,110 @@ class GridElevationProvider final : public ElevationProvider {
 
   /// Gets elevation for given geocoordinate.
   double getElevation(const utymap::QuadKey &quadKey, double latitude, double longitude) const override {
-    auto data = data_.find(quadKey);
-    if (data==data_.end()) {
-      preload(quadKey);
-      data = data_.find(quadKey);
+    return interpolate(getData(quadKey), latitude, longitude);
+  }
+
+  /// Gets elevations for given geocoordinates using data of quadkey loaded once.
+  void getElevations(const utymap::QuadKey &quadKey,
+                     const utymap::GeoCoordinate *coordinates,
+                     double *elevations,
+                     std::size_t count) const override {
+    const EleData &data = getData(quadKey);
+    for (std::size_t i = 0; i < count; ++i)
+      elevations[i] = interpolate(data, coordinates[i].latitude, coordinates[i].longitude);
+  }
+
+  /// Loads grid of given quadkey into memory.
+  void prefetch(const utymap::QuadKey &quadKey) const override {
+    preload(quadKey);
+  }
+
+  /// Returns size of parsed heights and mapped grid files.
+  std::size_t getMemoryUsage() const override {
+    std::lock_guard<std::mutex> lock(lock_);
+    return data_.weigh(getSize);
+  }
+
+  /// NOTE grid stays loaded while thread which used it last doesn't request another one.
+  void trim(std::size_t maxBytes) const override {
+    std::lock_guard<std::mutex> lock(lock_);
+    data_.trim(maxBytes, getSize);
+  }
+
+  /// Sets max amount of grids kept in cache, least recently used grids above it are dropped.
+  void setMaxCacheSize(int maxCacheSize) const override {
+    std::lock_guard<std::mutex> lock(lock_);
+    data_.setMaxSize(static_cast<std::size_t>(std::max(1, maxCacheSize)));
+  }
+
+  /// Converts text grid of given quadkey into binary one placed next to it.
+  void convert(const utymap::QuadKey &quadKey, SampleType sampleType = SampleType::Int16) const {
+    convert(quadKey, getFilePath(quadKey, ".ele"), getFilePath(quadKey, ".grd"), sampleType);
+  }
+
+  /// Converts text grid of given quadkey from text file into binary file.
+  static void convert(const utymap::QuadKey &quadKey,
+                      const std::string &textPath,
+                      const std::string &binaryPath,
+                      SampleType sampleType = SampleType::Int16) {
+    EleData data = readText(quadKey, textPath);
+    std::size_t sampleSize = sampleType==SampleType::Int16 ? 2 : 4;
+    std::vector<unsigned char> buffer(HeaderSize + data.heights.size()*sampleSize);
+
+    unsigned char *pos = buffer.data();
+    std::memcpy(pos, "UGRD", 4);
+    writeUInt16(pos + 4, Version);
+    writeUInt16(pos + 6, static_cast<std::uint16_t>(sampleType));
+    writeUInt32(pos + 8, static_cast<std::uint32_t>(data.resolution));
+    writeUInt32(pos + 12, static_cast<std::uint32_t>(data.xStart));
+    writeUInt32(pos + 16, static_cast<std::uint32_t>(data.yStart));
+    writeUInt32(pos + 20, static_cast<std::uint32_t>(data.xStep));
+    writeUInt32(pos + 24, static_cast<std::uint32_t>(data.yStep));
+
+    pos += HeaderSize;
+    for (int height : data.heights) {
+      if (sampleType==SampleType::Int16) {
+        if (height < INT16_MIN || height > INT16_MAX)
+          throw std::domain_error("Height does not fit into int16 sample:" + textPath);
+        writeUInt16(pos, static_cast<std::uint16_t>(height));
+      } else {
+        float value = static_cast<float>(height);
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        writeUInt32(pos, bits);
+      }
+      pos += sampleSize;
     }
 
-    int resolution = data->second.resolution;
+    std::ofstream file(binaryPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+    if (!file.good())
+      throw std::domain_error("Cannot write elevation file:" + binaryPath);
+  }
+
+ private:
+
+  /// Interpolates elevation for given location using grid data.
+  double interpolate(const EleData &data, double latitude, double longitude) const {
+    int resolution = data.resolution;
 
-    int x = static_cast<int>(longitude*Scale) - data->second.xStart;
-    int y = static_cast<int>(latitude*Scale) - data->second.yStart;
+    int x = static_cast<int>(longitude*Scale) - data.xStart;
+    int y = static_cast<int>(latitude*Scale) - data.yStart;
 
-    int x0 = clamp(x/data->second.xStep, 0, resolution);
-    int y0 = clamp(y/data->second.yStep, 0, resolution);
+    int x0 = clamp(x/data.xStep, 0, resolution);
+    int y0 = clamp(y/data.yStep, 0, resolution);
 
     int x1 = std::min(x0 + 1, resolution);
     int y1 = std::min(y0 + 1, resolution);
 
-    double dx = static_cast<double>(x - x0*data->second.xStep)/data->second.xStep;
-    double dy = static_cast<double>(y - y0*data->second.yStep)/data->second.yStep;
+    double dx = static_cast<double>(x - x0*data.xStep)/data.xStep;
+    double dy = static_cast<double>(y - y0*data.yStep)/data.yStep;
 
     int cellSize = resolution + 1;
-    int height2 = data->second.heights[x0 + y0*cellSize];
-    int height0 = data->second.heights[x0 + y1*cellSize];
-    int height3 = data->second.heights[x1 + y0*cellSize];
-    int height1 = data->second.heights[x1 + y1*cellSize];
+    double height2 = data.height(x0 + y0*cellSize);
+    double height0 = data.height(x0 + y1*cellSize);
+    double height3 = data.height(x1 + y0*cellSize);
+    double height1 = data.height(x1 + y1*cellSize);
 
     // Bilinear interpolation
     // h0------------h1
@@ -84,26 +209,93 @@ class GridElevationProvider final : public ElevationProvider {
     return height0*dy*(1 - dx) + height1*dy*(dx) + height2*(1 - dy)*(1 - dx) + height3*(1 - dy)*dx;
   }
 
- private:
-
   static int clamp(int n, int lower, int upper) {
     return std::max(lower, std::min(n, upper));
   }
 
+  static std::uint64_t nextId() {
+    static std::atomic<std::uint64_t> counter(0);
+    return ++counter;
+  }
+
+  static std::size_t getSize(const EleData &data) {
+    return data.heights.capacity()*sizeof(int) + data.region.get_size();
+  }
+
+  /// Returns data for given quadkey remembering it for calling thread.
+  const EleData &getData(const QuadKey &quadKey) const {
+    thread_local DataLookup lookup;
+    if (lookup.owner!=id_ || !(lookup.quadKey==quadKey)) {
+      lookup.data = preload(quadKey);
+      lookup.owner = id_;
+      lookup.quadKey = quadKey;
+    }
+    return *lookup.data;
+  }
+
   /// Preloads data for given quadkey.
-  void preload(const utymap::QuadKey &quadKey) const {
+  std::shared_ptr<const EleData> preload(const utymap::QuadKey &quadKey) const {
     std::lock_guard<std::mutex> lock(lock_);
 
-    if (data_.find(quadKey)!=data_.end())
-      return;
+    if (data_.exists(quadKey))
+      return data_.get(quadKey);
+
+    std::string binaryPath = getFilePath(quadKey, ".grd");
+    auto dataPtr = std::ifstream(binaryPath).good()
+                   ? readBinary(binaryPath)
+                   : std::make_shared<EleData>(readText(quadKey, getFilePath(quadKey, ".ele")));
 
-    std::string filePath = getFilePath(quadKey);
+    utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::ElevationLoads);
+    data_.put(quadKey, dataPtr);
+    return dataPtr;
+  }
+
+  /// Maps binary grid file and uses its samples in place.
+  static std::shared_ptr<const EleData> readBinary(const std::string &filePath) {
+    using namespace boost::interprocess;
+
+    auto dataPtr = std::make_shared<EleData>();
+    EleData &data = *dataPtr;
+    try {
+      file_mapping file(filePath.c_str(), read_only);
+      data.region = mapped_region(file, read_only);
+    } catch (const interprocess_exception &) {
+      throw std::domain_error("Cannot load elevation file:" + filePath);
+    }
+
+    const auto *header = static_cast<const unsigned char *>(data.region.get_address());
+    std::size_t size = data.region.get_size();
+    if (size < HeaderSize || std::memcmp(header, "UGRD", 4)!=0 || readUInt16(header + 4)!=Version)
+      throw std::domain_error("Unsupported elevation file:" + filePath);
+
+    std::uint16_t sampleType = readUInt16(header + 6);
+    if (sampleType > static_cast<std::uint16_t>(SampleType::Float32))
+      throw std::domain_error("Unsupported sample type in elevation file:" + filePath);
+
+    data.sampleType = static_cast<SampleType>(sampleType);
+    data.resolution = static_cast<std::int32_t>(readUInt32(header + 8));
+    data.xStart = static_cast<std::int32_t>(readUInt32(header + 12));
+    data.yStart = static_cast<std::int32_t>(readUInt32(header + 16));
+    data.xStep = static_cast<std::int32_t>(readUInt32(header + 20));
+    data.yStep = static_cast<std::int32_t>(readUInt32(header + 24));
+    data.samples = header + HeaderSize;
+
+    std::size_t sampleSize = data.sampleType==SampleType::Int16 ? 2 : 4;
+    std::size_t cellSize = static_cast<std::size_t>(data.resolution) + 1;
+    if (data.resolution <= 0 || data.xStep <= 0 || data.yStep <= 0 ||
+        size - HeaderSize < cellSize*cellSize*sampleSize)
+      throw std::domain_error("Corrupted elevation file:" + filePath);
+
+    return dataPtr;
+  }
+
+  /// Parses text grid file.
+  static EleData readText(const QuadKey &quadKey, const std::string &filePath) {
     std::fstream file(filePath);
     if (!file.good())
       throw std::invalid_argument(std::string("Cannot find elevation file:") + filePath);
 
     EleData data;
-
     std::transform(std::istream_iterator<std::string>(file),
                    std::istream_iterator<std::string>(),
                    std::back_inserter(data.heights),
@@ -123,17 +315,36 @@ class GridElevationProvider final : public ElevationProvider {
     data.yStart = static_cast<int>(bbox.minPoint.latitude*Scale);
     data.xStep = static_cast<int>(bbox.width()/data.resolution*Scale);
     data.yStep = static_cast<int>(bbox.height()/data.resolution*Scale);
+    return data;
+  }
+
+  static std::uint16_t readUInt16(const unsigned char *pos) {
+    return static_cast<std::uint16_t>(pos[0] | (pos[1] << 8));
+  }
+
+  static std::uint32_t readUInt32(const unsigned char *pos) {
+    return static_cast<std::uint32_t>(pos[0]) | (static_cast<std::uint32_t>(pos[1]) << 8) |
+        (static_cast<std::uint32_t>(pos[2]) << 16) | (static_cast<std::uint32_t>(pos[3]) << 24);
+  }
+
+  static void writeUInt16(unsigned char *pos, std::uint16_t value) {
+    pos[0] = static_cast<unsigned char>(value & 0xFF);
+    pos[1] = static_cast<unsigned char>(value >> 8);
+  }
 
-    data_.emplace(quadKey, std::move(data));
+  static void writeUInt32(unsigned char *pos, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i)
+      pos[i] = static_cast<unsigned char>((value >> (i*8)) & 0xFF);
   }
 
-  std::string getFilePath(const QuadKey &quadKey) const {
+  std::string getFilePath(const QuadKey &quadKey, const char *extension) const {
     std::stringstream ss;
-    ss << dataPath_ << quadKey.levelOfDetail << "/" << utymap::utils::GeoUtils::quadKeyToString(quadKey) << ".ele";
+    ss << dataPath_ << quadKey.levelOfDetail << "/" << utymap::utils::GeoUtils::quadKeyToString(quadKey) << extension;
     return ss.str();
   }
 
-  mutable std::map<const QuadKey, EleData, QuadKey::Comparator> data_;
+  const std::uint64_t id_;
+  mutable utymap::utils::LruCache<QuadKey, const EleData, QuadKey::Comparator> data_;
   mutable std::mutex lock_;
   const std::string dataPath_;
 };
@@ -4,13 +4,21 @@
 #include "BoundingBox.hpp"
 #include "heightmap/ElevationProvider.hpp"
 #include "utils/GeoUtils.hpp"
+#include "utils/LruCache.hpp"
+#include "utils/Metrics.hpp"
 
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <stdexcept>
-#include <map>
 #include <memory>
 #include <mutex>
 #include <iomanip>
@@ -20,33 +28,112 @@ namespace utymap {
 namespace heightmap {
 
 /// Provides the way to get elevation for given location from SRTM data.
+/// NOTE hgt files are memory mapped and at most maxCacheSize least recently used ones are kept.
+/// Each thread remembers the last used cell, so lookup takes the lock only when cell changes.
+/// Coarse tiles are served from downsampled pyramid levels stored as hgt files in
+/// <index>/pyramid/<seconds per pixel>/ if they are built, see buildPyramid.
 class SrtmElevationProvider final : public ElevationProvider {
   struct HgtCellKey {
     int lat, lon;
+    /// Seconds per pixel of pyramid level, zero for original data.
+    int level;
 
-    HgtCellKey(int lat, int lon) : lat(lat), lon(lon) {}
+    HgtCellKey(int lat, int lon, int level = 0) : lat(lat), lon(lon), level(level) {}
 
     bool operator<(const HgtCellKey &other) const {
-      return lat < other.lat || (other.lat >= lat && lon < other.lon);
+      if (lat!=other.lat) return lat < other.lat;
+      if (lon!=other.lon) return lon < other.lon;
+      return level < other.level;
+    }
+
+    bool operator==(const HgtCellKey &other) const {
+      return lat==other.lat && lon==other.lon && level==other.level;
     }
   };
 
   struct HgtCell {
     int totalPx, secondsPerPx, offset;
-    std::vector<char> data;
+    boost::interprocess::mapped_region region;
+    const unsigned char *data;
 
-    HgtCell(int totalPx, int secondsPerPx, std::vector<char> &data) :
+    HgtCell(int totalPx, int secondsPerPx, boost::interprocess::mapped_region &&region) :
         totalPx(totalPx),
         secondsPerPx(secondsPerPx),
         offset((totalPx*totalPx - totalPx)*2),
-        data(std::move(data)) {
+        region(std::move(region)),
+        data(static_cast<const unsigned char *>(this->region.get_address())) {
     }
   };
 
+  /// Last cell used by calling thread.
+  struct CellLookup {
+    std::uint64_t owner = 0;
+    HgtCellKey key = HgtCellKey(0, 0);
+    std::shared_ptr<HgtCell> cell;
+  };
+
+  /// Seconds per pixel of pyramid levels: each divides a degree, so levels keep cell layout.
+  static const std::vector<int> &pyramidLevels() {
+    static const std::vector<int> levels {6, 12, 24, 48, 90, 180, 360, 720, 1800, 3600};
+    return levels;
+  }
+
+  /// Amount of samples along tile side which is enough for terrain mesh.
+  static constexpr double SamplesPerTile = 128;
+  static constexpr int VoidPx = -32768;
+
  public:
 
   SrtmElevationProvider(const std::string& indexPath, int maxCacheSize = 4) :
-      dataPath_(indexPath + "/data/"), maxCacheSize_(maxCacheSize) {
+      id_(nextId()), maxCells_(static_cast<std::size_t>(std::max(1, maxCacheSize))), cells_(maxCells_),
+      dataPath_(indexPath + "/data/"), pyramidPath_(indexPath + "/pyramid/") {
+  }
+
+  /// Maps cells covering given quadkey and reads their pages, so first lookup doesn't wait for storage.
+  /// NOTE nothing is done if cells don't fit into cache.
+  void prefetch(const utymap::QuadKey &quadKey) const override {
+    BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
+    int minLat = static_cast<int>(bbox.minPoint.latitude), maxLat = static_cast<int>(bbox.maxPoint.latitude);
+    int minLon = static_cast<int>(bbox.minPoint.longitude), maxLon = static_cast<int>(bbox.maxPoint.longitude);
+    if (static_cast<std::size_t>((maxLat - minLat + 1)*(maxLon - minLon + 1)) > maxCells_)
+      return;
+
+    int level = getLevel(quadKey.levelOfDetail);
+    for (int lat = minLat; lat <= maxLat; ++lat)
+      for (int lon = minLon; lon <= maxLon; ++lon) {
+        auto cell = loadCell(HgtCellKey(lat, lon, level));
+        touch(*cell);
+      }
+  }
+
+  /// Returns size of mapped cells.
+  std::size_t getMemoryUsage() const override {
+    std::lock_guard<std::mutex> lock(lock_);
+    return cells_.weigh(getSize);
+  }
+
+  /// NOTE cell stays mapped while thread which used it last doesn't request another one.
+  void trim(std::size_t maxBytes) const override {
+    std::lock_guard<std::mutex> lock(lock_);
+    cells_.trim(maxBytes, getSize);
+  }
+
+  /// Builds downsampled pyramid levels for all hgt files of given index.
+  /// Every pyramid pixel is the average of original pixels around it, voids are skipped.
+  static void buildPyramid(const std::string &indexPath) {
+    namespace fs = boost::filesystem;
+    fs::directory_iterator end;
+    for (fs::directory_iterator it(indexPath + "/data/"); it!=end; ++it) {
+      if (!fs::is_regular_file(it->path()) || it->path().extension()!=".hgt")
+        continue;
+      HgtCell cell = readCell(it->path().string());
+      for (int level : pyramidLevels()) {
+        if (level%cell.secondsPerPx!=0) continue;
+        fs::path levelPath = fs::path(indexPath) / "pyramid" / std::to_string(level);
+        fs::create_directories(levelPath);
+        writeLevel(cell, level/cell.secondsPerPx, (levelPath/it->path().filename()).string());
+      }
+    }
   }
 
   double getElevation(const utymap::QuadKey &quadKey, const utymap::GeoCoordinate &coordinate) const override {
@@ -57,51 +144,136 @@ class SrtmElevationProvider final : public ElevationProvider {
     return getElevationImpl(quadKey, latitude, longitude);
   }
 
- private:
-
-  void preload(const utymap::QuadKey &quadKey, HgtCellKey &hgtCellKey) const {
-    std::lock_guard<std::mutex> lock(lock_);
+  /// NOTE cell is looked up only when consecutive coordinates are in different cells.
+  void getElevations(const utymap::QuadKey &quadKey,
+                     const utymap::GeoCoordinate *coordinates,
+                     double *elevations,
+                     std::size_t count) const override {
+    const HgtCell *cell = nullptr;
+    int cellLat = 0, cellLon = 0;
+    int level = getLevel(quadKey.levelOfDetail);
+    for (std::size_t i = 0; i < count; ++i) {
+      int latDec = static_cast<int>(coordinates[i].latitude);
+      int lonDec = static_cast<int>(coordinates[i].longitude);
+      if (cell==nullptr || latDec!=cellLat || lonDec!=cellLon) {
+        cell = &getCell(HgtCellKey(latDec, lonDec, level));
+        cellLat = latDec;
+        cellLon = lonDec;
+      }
+      elevations[i] = interpolate(*cell, coordinates[i].latitude - latDec, coordinates[i].longitude - lonDec);
+    }
+  }
 
-    if (cells_.find(hgtCellKey)!=cells_.end())
-      return;
+ private:
 
-    BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey);
-    int minLat = static_cast<int>(bbox.minPoint.latitude);
-    int minLon = static_cast<int>(bbox.minPoint.longitude);
-    int maxLat = static_cast<int>(bbox.maxPoint.latitude);
-    int maxLon = static_cast<int>(bbox.maxPoint.longitude);
+  /// Returns unique id of provider instance: unlike address it is never reused.
+  static std::uint64_t nextId() {
+    static std::atomic<std::uint64_t> counter(0);
+    return ++counter;
+  }
 
-    int latDiff = maxLat - minLat;
-    int lonDiff = maxLon - minLon;
+  /// Returns cell for given key from last lookup of calling thread or from cache.
+  /// NOTE thread keeps its last cell mapped even if it is evicted from cache meanwhile.
+  const HgtCell &getCell(const HgtCellKey &cellKey) const {
+    thread_local CellLookup lookup;
+    if (lookup.owner!=id_ || !(lookup.key==cellKey)) {
+      lookup.cell = loadCell(cellKey);
+      lookup.owner = id_;
+      lookup.key = cellKey;
+    }
+    return *lookup.cell;
+  }
 
-    for (int j = 0; j <= latDiff; j++)
-      for (int i = 0; i <= lonDiff; i++) {
-        HgtCellKey cellKey(minLat + j, minLon + i);
+  /// Returns cell for given key mapping its file if necessary.
+  /// NOTE missing pyramid level falls back to finer one and the result is cached under requested key.
+  std::shared_ptr<HgtCell> loadCell(const HgtCellKey &cellKey) const {
+    std::lock_guard<std::mutex> lock(lock_);
 
-        if (cells_.find(cellKey)!=cells_.end())
-          continue;
+    if (cells_.exists(cellKey))
+      return cells_.get(cellKey);
 
-        std::string path = getFilePath(cellKey);
-        HgtCell cell = readCell(path);
-        cells_.emplace(cellKey, readCell(path));
+    std::shared_ptr<HgtCell> cell;
+    const auto &levels = pyramidLevels();
+    for (auto level = std::find(levels.rbegin(), levels.rend(), cellKey.level); level!=levels.rend(); ++level) {
+      std::string path = getFilePath(HgtCellKey(cellKey.lat, cellKey.lon, *level));
+      if (boost::filesystem::exists(path)) {
+        cell = std::make_shared<HgtCell>(readCell(path));
+        break;
       }
+    }
+    if (!cell)
+      cell = std::make_shared<HgtCell>(readCell(getFilePath(HgtCellKey(cellKey.lat, cellKey.lon))));
+
+    utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::ElevationLoads);
+    cells_.put(cellKey, cell);
+    return cell;
   }
 
   double getElevationImpl(const utymap::QuadKey &quadKey, double latitude, double longitude) const {
     int latDec = static_cast<int>(latitude);
     int lonDec = static_cast<int>(longitude);
+    HgtCellKey cellKey(latDec, lonDec, getLevel(quadKey.levelOfDetail));
 
-    double secondsLat = (latitude - latDec)*3600;
-    double secondsLon = (longitude - lonDec)*3600;
+    return interpolate(getCell(cellKey), latitude - latDec, longitude - lonDec);
+  }
+
+  static std::size_t getSize(const HgtCell &cell) {
+    return cell.region.get_size();
+  }
+
+  /// Reads every page of mapped cell.
+  static void touch(const HgtCell &cell) {
+    const std::size_t PageSize = 4096;
+    volatile unsigned char sum = 0;
+    for (std::size_t pos = 0; pos < cell.region.get_size(); pos += PageSize)
+      sum += cell.data[pos];
+  }
+
+  /// Returns the coarsest pyramid level which still has enough samples for tile of given level of detail.
+  static int getLevel(int levelOfDetail) {
+    double secondsPerPx = 360.*3600/std::pow(2., levelOfDetail)/SamplesPerTile;
+    int result = 0;
+    for (int level : pyramidLevels())
+      if (level <= secondsPerPx) result = level;
+    return result;
+  }
 
-    HgtCellKey hgtCellKey(latDec, lonDec);
-    auto cellPtr = cells_.find(hgtCellKey);
-    if (cellPtr==cells_.end()) {
-      preload(quadKey, hgtCellKey);
-      cellPtr = cells_.find(hgtCellKey);
+  /// Writes level downsampled by given factor as big endian hgt file.
+  static void writeLevel(const HgtCell &cell, int factor, const std::string &path) {
+    int totalPx = (cell.totalPx - 1)/factor + 1;
+    int radius = factor/2;
+    std::vector<char> buffer(static_cast<std::size_t>(totalPx*totalPx*2));
+    for (int y = 0; y < totalPx; ++y) {
+      for (int x = 0; x < totalPx; ++x) {
+        long sum = 0;
+        int count = 0;
+        int minY = std::max(0, y*factor - radius), maxY = std::min(cell.totalPx - 1, y*factor + radius);
+        int minX = std::max(0, x*factor - radius), maxX = std::min(cell.totalPx - 1, x*factor + radius);
+        for (int py = minY; py <= maxY; ++py)
+          for (int px = minX; px <= maxX; ++px) {
+            int height = readPx(cell, py, px);
+            if (height==VoidPx) continue;
+            sum += height;
+            ++count;
+          }
+        int height = count > 0 ? static_cast<int>(std::lround(static_cast<double>(sum)/count)) : VoidPx;
+        // rows are stored from north to south.
+        std::size_t pos = static_cast<std::size_t>(((totalPx - 1 - y)*totalPx + x)*2);
+        buffer[pos] = static_cast<char>((height >> 8) & 0xFF);
+        buffer[pos + 1] = static_cast<char>(height & 0xFF);
+      }
     }
 
-    const auto &cell = cellPtr->second;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!file.good())
+      throw std::domain_error(std::string("Cannot write srtm file:") + path);
+  }
+
+  /// Interpolates elevation inside cell for given offset in degrees from its origin.
+  static double interpolate(const HgtCell &cell, double latOffset, double lonOffset) {
+    double secondsLat = latOffset*3600;
+    double secondsLon = lonOffset*3600;
 
     // load tile
     //X corresponds to x/y values,
@@ -140,42 +312,39 @@ class SrtmElevationProvider final : public ElevationProvider {
     return height0*dy*(1 - dx) + height1*dy*(dx) + height2*(1 - dy)*(1 - dx) + height3*(1 - dy)*dx;
   }
 
+  /// Reads signed big endian value of given pixel directly from mapped file.
   static int readPx(const HgtCell &cell, int y, int x) {
     int pos = cell.offset + 2*(x - cell.totalPx*y);
-    return (cell.data[pos]) << 8 | (cell.data[pos + 1]);
+    return static_cast<std::int16_t>((cell.data[pos] << 8) | cell.data[pos + 1]);
   }
 
   static HgtCell readCell(const std::string &path) {
-    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::app);
-    file.seekg(0, std::ios::end);
-    auto size = file.tellg();
-
-    int totalPx, secondsPerPx;
-    switch (size) {
-      case 1201*1201*2: // SRTM-3
-        totalPx = 1201;
-        secondsPerPx = 3;
-        break;
-      case 3601*3601*2: // SRTM-1
-        totalPx = 3601;
-        secondsPerPx = 1;
-        break;
-      default:file.close();
-        throw std::domain_error(std::string("Cannot load srtm file:") + path);
+    using namespace boost::interprocess;
+
+    mapped_region region;
+    try {
+      file_mapping file(path.c_str(), read_only);
+      region = mapped_region(file, read_only);
+    } catch (const interprocess_exception &) {
+      throw std::domain_error(std::string("Cannot load srtm file:") + path);
     }
 
-    file.seekg(0, std::ios::beg);
-
-    std::vector<char> data((std::istreambuf_iterator<char>(file)),
-                           (std::istreambuf_iterator<char>()));
+    // SRTM-3 has 1201 pixels per side, SRTM-1 has 3601, pyramid levels have less.
+    int totalPx = static_cast<int>(std::lround(std::sqrt(region.get_size()/2.)));
+    if (totalPx < 2 || static_cast<std::size_t>(totalPx*totalPx*2)!=region.get_size() || 3600%(totalPx - 1)!=0)
+      throw std::domain_error(std::string("Cannot load srtm file:") + path);
+    int secondsPerPx = 3600/(totalPx - 1);
 
-    return HgtCell(totalPx, secondsPerPx, data);
+    return HgtCell(totalPx, secondsPerPx, std::move(region));
   }
 
   std::string getFilePath(const HgtCellKey &key) const {
     std::ostringstream stream;
-    stream << dataPath_
-           << std::setfill('0')
+    if (key.level > 0)
+      stream << pyramidPath_ << key.level << "/";
+    else
+      stream << dataPath_;
+    stream << std::setfill('0')
            << (key.lat > 0 ? 'N' : 'S')
            << std::setw(2) << std::abs(key.lat) << std::setw(0)
            << (key.lon > 0 ? 'E' : 'W')
@@ -184,10 +353,12 @@ class SrtmElevationProvider final : public ElevationProvider {
     return stream.str();
   }
 
-  mutable std::map<HgtCellKey, HgtCell> cells_;
+  const std::uint64_t id_;
+  const std::size_t maxCells_;
+  mutable utymap::utils::LruCache<HgtCellKey, HgtCell> cells_;
   mutable std::mutex lock_;
   std::string dataPath_;
-  int maxCacheSize_;
+  std::string pyramidPath_;
 };
 
 }
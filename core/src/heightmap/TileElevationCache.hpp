@@ -0,0 +1,102 @@
+#ifndef HEIGHTMAP_TILEELEVATIONCACHE_HPP_DEFINED
+#define HEIGHTMAP_TILEELEVATIONCACHE_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "heightmap/ElevationProvider.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace utymap {
+namespace heightmap {
+
+/// Samples elevation of one tile into regular grid once and interpolates it locally, so
+/// repeated lookups during tile build neither go to original provider nor repeat its work.
+/// NOTE locations outside of tile or requests for other quadkeys are passed to original provider.
+/// Instance is immutable after construction, so it can be shared between threads.
+class TileElevationCache final : public ElevationProvider {
+ public:
+  /// Samples given provider with resolution cells along each side of the tile.
+  TileElevationCache(const ElevationProvider &eleProvider, const utymap::QuadKey &quadKey, int resolution) :
+      eleProvider_(eleProvider),
+      quadKey_(quadKey),
+      bbox_(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey)),
+      resolution_(std::max(1, resolution)),
+      latStep_(bbox_.height()/resolution_),
+      lonStep_(bbox_.width()/resolution_),
+      heights_() {
+    int cellSize = resolution_ + 1;
+    std::vector<utymap::GeoCoordinate> coordinates;
+    coordinates.reserve(static_cast<std::size_t>(cellSize*cellSize));
+    for (int y = 0; y < cellSize; ++y)
+      for (int x = 0; x < cellSize; ++x)
+        coordinates.emplace_back(bbox_.minPoint.latitude + y*latStep_, bbox_.minPoint.longitude + x*lonStep_);
+
+    heights_.resize(coordinates.size());
+    eleProvider_.getElevations(quadKey_, coordinates.data(), heights_.data(), coordinates.size());
+  }
+
+  double getElevation(const utymap::QuadKey &quadKey, const utymap::GeoCoordinate &coordinate) const override {
+    return getElevation(quadKey, coordinate.latitude, coordinate.longitude);
+  }
+
+  double getElevation(const utymap::QuadKey &quadKey, double latitude, double longitude) const override {
+    return isCached(quadKey, latitude, longitude)
+           ? interpolate(latitude, longitude)
+           : eleProvider_.getElevation(quadKey, latitude, longitude);
+  }
+
+  void getElevations(const utymap::QuadKey &quadKey,
+                     const utymap::GeoCoordinate *coordinates,
+                     double *elevations,
+                     std::size_t count) const override {
+    for (std::size_t i = 0; i < count; ++i)
+      elevations[i] = getElevation(quadKey, coordinates[i].latitude, coordinates[i].longitude);
+  }
+
+  void prefetch(const utymap::QuadKey &quadKey) const override {
+    eleProvider_.prefetch(quadKey);
+  }
+
+  bool isFlat() const override {
+    return eleProvider_.isFlat();
+  }
+
+ private:
+  bool isCached(const utymap::QuadKey &quadKey, double latitude, double longitude) const {
+    return quadKey==quadKey_ &&
+        latitude >= bbox_.minPoint.latitude && latitude <= bbox_.maxPoint.latitude &&
+        longitude >= bbox_.minPoint.longitude && longitude <= bbox_.maxPoint.longitude;
+  }
+
+  /// Interpolates elevation bilinearly between four samples around given location.
+  double interpolate(double latitude, double longitude) const {
+    double y = (latitude - bbox_.minPoint.latitude)/latStep_;
+    double x = (longitude - bbox_.minPoint.longitude)/lonStep_;
+
+    int y0 = std::min(static_cast<int>(y), resolution_ - 1);
+    int x0 = std::min(static_cast<int>(x), resolution_ - 1);
+    double dy = y - y0;
+    double dx = x - x0;
+
+    int cellSize = resolution_ + 1;
+    const double *bottom = heights_.data() + y0*cellSize + x0;
+    const double *top = bottom + cellSize;
+
+    return (bottom[0]*(1 - dx) + bottom[1]*dx)*(1 - dy) + (top[0]*(1 - dx) + top[1]*dx)*dy;
+  }
+
+  const ElevationProvider &eleProvider_;
+  const utymap::QuadKey quadKey_;
+  const utymap::BoundingBox bbox_;
+  const int resolution_;
+  const double latStep_;
+  const double lonStep_;
+  std::vector<double> heights_;
+};
+
+}
+}
+
+#endif // HEIGHTMAP_TILEELEVATIONCACHE_HPP_DEFINED
@@ -0,0 +1,103 @@
+#include "index/BitmapData.hpp"
+#include "index/BitmapStream.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/Metrics.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+using namespace utymap::index;
+
+BitmapData::BitmapData(const std::string &bitmapPath, const std::string &bitmapLogPath,
+                       std::atomic<std::size_t> &totalBytes) :
+  path(bitmapPath), logPath(bitmapLogPath), isLoaded(false), isDirty(false), packed_(), totalBytes_(totalBytes),
+  bytes_(0) {}
+
+BitmapData::BitmapData(BitmapData &&other) :
+  path(std::move(other.path)),
+  logPath(std::move(other.logPath)),
+  data(std::move(other.data)),
+  isLoaded(other.isLoaded),
+  isDirty(other.isDirty),
+  logFile_(std::move(other.logFile_)),
+  packed_(other.packed_),
+  totalBytes_(other.totalBytes_),
+  bytes_(other.bytes_.exchange(0)) {
+  other.isDirty = false;
+}
+
+BitmapData::~BitmapData() {
+  merge();
+  setBytes(0);
+}
+
+void BitmapData::load() {
+  if (isLoaded) return;
+
+  if (packed_.data != nullptr) {
+    std::istringstream packedFile(std::string(packed_.data, packed_.size));
+    BitmapStream::read(packedFile, data);
+  } else {
+    std::fstream bitmapFile(path, std::ios::in | std::ios::binary);
+    if (bitmapFile.good())
+      BitmapStream::read(bitmapFile, data);
+  }
+
+  std::fstream logFile(logPath, std::ios::in | std::ios::binary);
+  if (logFile.good()) {
+    BitmapStream::readDelta(logFile, data);
+    isDirty = true;
+  }
+
+  std::size_t bytes = 0;
+  for (const auto &pair : data)
+    bytes += sizeof(pair.first) + pair.second.sizeInBytes();
+  setBytes(bytes);
+  isLoaded = true;
+  utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::BitmapLoads);
+}
+
+void BitmapData::append(std::uint32_t order, const BitmapIndex::Ids &ids) {
+  if (logFile_ == nullptr)
+    logFile_ = utymap::utils::make_unique<std::fstream>(logPath, std::ios::out | std::ios::binary | std::ios::app);
+  BitmapStream::writeDelta(*logFile_, order, ids);
+  // NOTE upper bound: every token can add at most one word to its bitset.
+  auto bytes = ids.size() * sizeof(std::uint32_t);
+  bytes_ += bytes;
+  totalBytes_ += bytes;
+  isDirty = true;
+}
+
+void BitmapData::markErased(const BitmapIndex::Ids &orders) {
+  for (const auto order : orders)
+    append(order, { BitmapIndex::ErasedToken });
+  BitmapIndex::markErased(data, orders);
+}
+
+void BitmapData::merge() {
+  if (!isDirty) return;
+
+  closeLog();
+  std::fstream bitmapFile(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  BitmapStream::write(bitmapFile, data);
+  std::remove(logPath.c_str());
+  isDirty = false;
+}
+
+void BitmapData::discard() {
+  closeLog();
+  data.clear();
+  isDirty = false;
+  isLoaded = false;
+  setBytes(0);
+}
+
+void BitmapData::closeLog() {
+  if (logFile_ != nullptr) logFile_->close();
+  logFile_.reset();
+}
+
+void BitmapData::setBytes(std::size_t bytes) {
+  totalBytes_ += bytes;
+  totalBytes_ -= bytes_.exchange(bytes);
+}
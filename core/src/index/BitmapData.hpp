@@ -0,0 +1,71 @@
+#ifndef INDEX_BITMAPDATA_HPP_DEFINED
+#define INDEX_BITMAPDATA_HPP_DEFINED
+
+#include "index/BitmapIndex.hpp"
+#include "index/TilePack.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace utymap {
+namespace index {
+
+/// Stores bitmap and its append only delta log which is merged into bitmap file on flush.
+/// Estimated memory of loaded bitmap is added to total of store which owns bitmap.
+struct BitmapData final {
+  const std::string path;
+  const std::string logPath;
+  BitmapIndex::Bitmap data;
+  bool isLoaded;
+  bool isDirty;
+
+  BitmapData(const std::string &bitmapPath, const std::string &bitmapLogPath, std::atomic<std::size_t> &totalBytes);
+
+  BitmapData(BitmapData &&other);
+
+  ~BitmapData();
+
+  /// Loads bitmap from file and applies not yet merged delta log.
+  void load();
+
+  /// Appends tokens of element with given order to delta log.
+  void append(std::uint32_t order, const BitmapIndex::Ids &ids);
+
+  /// Marks elements with given sorted orders as erased and appends tombstones to delta log.
+  void markErased(const BitmapIndex::Ids &orders);
+
+  /// Rewrites bitmap file with merged data and removes delta log.
+  void merge();
+
+  /// Drops in memory state without merging.
+  void discard();
+
+  /// Sets bitmap content stored in tile pack which is used instead of bitmap file.
+  void setPacked(const TilePack::Section &packed) {
+    packed_ = packed;
+  }
+
+  /// Returns estimated memory consumed by loaded bitmap. Can be called without lock.
+  std::size_t bytes() const {
+    return bytes_;
+  }
+
+ private:
+  void closeLog();
+
+  /// Replaces estimated memory of bitmap and updates total accordingly.
+  void setBytes(std::size_t bytes);
+
+  std::unique_ptr<std::fstream> logFile_;
+  TilePack::Section packed_;
+  std::atomic<std::size_t> &totalBytes_;
+  std::atomic<std::size_t> bytes_;
+};
+
+}
+}
+
+#endif // INDEX_BITMAPDATA_HPP_DEFINED
@@ -1,21 +1,34 @@
 #include "index/BitmapIndex.hpp"
 #include "utils/CoreUtils.hpp"
 
-#include<boost/tokenizer.hpp>
+#include <algorithm>
+#include <cctype>
+#include <sstream>
 
 using namespace utymap::entities;
 using namespace utymap::index;
 
+const std::uint32_t BitmapIndex::ErasedToken;
+
 namespace {
   using Bitset = BitmapIndex::Bitset;
   using Bitmap = BitmapIndex::Bitmap;
-  /// Defines symbols considered as token delimiters
-  const boost::char_separator<char> separator(" _:;!@#$%^&*(){}[],.?`\\/\"\'");
+  /// Marks term which matches any token with given prefix, e.g. "Ber*".
+  const char PrefixMarker = '*';
+  /// Marks term which matches tokens within edit distance, e.g. "Berln~" or "Brln~2".
+  const char FuzzyMarker = '~';
+  const std::size_t MaxEditDistance = 2;
+  /// Max amount of tokens which single prefix or fuzzy term is expanded to.
+  const std::size_t MaxTermExpansions = 256;
+  /// Amount of quad keys evaluated by single task in parallel mode.
+  const std::size_t QuadKeysPerTask = 16;
+  /// Amount of tasks per thread in one batch. Batch results are kept until visited.
+  const std::size_t TasksPerThread = 4;
 
   /// Applies logical operation
   void applyOperation(const BitmapIndex::Ids &terms,
                       const Bitmap &bitmap,
-                      const std::function<void(Bitset)> &op,
+                      const std::function<void(const Bitset &)> &op,
                       const std::function<bool()> &noOp) {
     for (const auto term: terms) {
       auto array = bitmap.find(term);
@@ -27,75 +40,317 @@ namespace {
         op(array->second);
     }
   }
+
+  /// Sorts ids and removes duplicates.
+  void normalize(BitmapIndex::Ids &ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  }
+
+  /// Intersects bitsets of all terms and merged bitsets of groups. Returns false if any term
+  /// or whole group is missing or intersection is empty. Merged is used as buffer.
+  /// NOTE compressed size is used as cheap estimation of cardinality.
+  bool intersect(const BitmapIndex::Ids &terms,
+                 const std::vector<BitmapIndex::Ids> &groups,
+                 const Bitmap &bitmap,
+                 std::vector<const Bitset *> &operands,
+                 std::vector<Bitset> &merged,
+                 Bitset &result) {
+    operands.clear();
+    for (const auto term : terms) {
+      auto array = bitmap.find(term);
+      if (array == bitmap.end())
+        return false;
+      operands.push_back(&array->second);
+    }
+
+    // NOTE merged should not be reallocated as operands point to its items.
+    merged.resize(groups.size());
+    for (std::size_t i = 0; i < groups.size(); ++i) {
+      merged[i].reset();
+      applyOperation(groups[i], bitmap, [&](const Bitset &b) {
+        merged[i].inplaceOr(b);
+      }, [](){ return true; });
+      if (merged[i].empty())
+        return false;
+      operands.push_back(&merged[i]);
+    }
+
+    std::sort(operands.begin(), operands.end(), [](const Bitset *lhs, const Bitset *rhs) {
+      return lhs->sizeInBytes() < rhs->sizeInBytes();
+    });
+
+    result = *operands.front();
+    for (std::size_t i = 1; i < operands.size() && !result.empty(); ++i)
+      result.inplaceAnd(*operands[i]);
+    return !result.empty();
+  }
 }
 
-void BitmapIndex::add(const Element &element, const utymap::QuadKey &quadKey, const std::uint32_t order) {
+BitmapIndex::Ids BitmapIndex::add(const Element &element, const utymap::QuadKey &quadKey, const std::uint32_t order) {
   auto& bitmap = getBitmap(quadKey);
-  for (const auto &token : tokenize(element)) {
+  auto tokens = tokenize(element);
+  for (const auto &token : tokens) {
     bitmap[token].set(order);
   }
+  return tokens;
+}
+
+BitmapIndex::Ids BitmapIndex::tokenize(const Element &element) const {
+  Ids tokens;
+  tokens.reserve(element.tags.size() * 2 + 4);
+  tokenizer_.tokenize(element, tokens);
+  return tokens;
 }
 
 void BitmapIndex::search(const BitmapIndex::Query &query, ElementVisitor &visitor) {
-  Ids andTerms, orTerms, notTerms;
-  tokenize(query.andTerms, andTerms);
-  tokenize(query.orTerms, orTerms);
-  tokenize(query.notTerms, notTerms);
+  search(compile(query), visitor);
+}
 
-  for (int lod = query.range.start; lod <= query.range.end; ++lod) {
-    utymap::utils::GeoUtils::visitTileRange(query.boundingBox, lod,
-      [&](const QuadKey &quadKey, const BoundingBox&) {
-        if (!hasData(quadKey)) return;
+BitmapIndex::CompiledQuery BitmapIndex::compile(const Query &query) const {
+  CompiledQuery compiled = { {}, {}, {}, {}, query.boundingBox, query.range };
+  std::vector<Ids> groups;
+  compile(query.notTerms, compiled.notTerms, groups);
+  for (const auto &group : groups)
+    compiled.notTerms.insert(compiled.notTerms.end(), group.begin(), group.end());
 
-        auto& bitmap = getBitmap(quadKey);
-        Bitset bitset;
+  groups.clear();
+  compile(query.orTerms, compiled.orTerms, groups);
+  for (const auto &group : groups)
+    compiled.orTerms.insert(compiled.orTerms.end(), group.begin(), group.end());
 
-        applyOperation(orTerms, bitmap, [&](const Bitset &b) {
-          bitset = b.logicalor(bitset);
-        }, [](){ return true; });
+  compile(query.andTerms, compiled.andTerms, compiled.andGroups);
 
-        applyOperation(andTerms, bitmap, [&](const Bitset &b) {
-          if (bitset.sizeInBits() == 0) {
-            bitset = b;
-            return;
-          }
-          bitset = b.logicaland(bitset);
-        }, [&]() {
-          bitset.reset();
-          return false;
-        });
+  normalize(compiled.notTerms);
+  normalize(compiled.andTerms);
+  normalize(compiled.orTerms);
+  for (auto &group : compiled.andGroups)
+    normalize(group);
+  return compiled;
+}
+
+void BitmapIndex::compile(const std::string &source, Ids &terms, std::vector<Ids> &groups) const {
+  std::istringstream stream(source);
+  std::string word;
+  while (stream >> word) {
+    std::size_t maxDistance = 0;
+    bool isPrefix = word.size() > 1 && word.back() == PrefixMarker;
+    auto marker = word.find_last_of(FuzzyMarker);
+    bool isFuzzy = !isPrefix && marker != std::string::npos && marker > 0 &&
+        (marker + 1 == word.size() || (marker + 2 == word.size() && std::isdigit(static_cast<unsigned char>(word.back()))));
+    if (isFuzzy) {
+      maxDistance = marker + 1 == word.size() ? 1 : static_cast<std::size_t>(word.back() - '0');
+      maxDistance = std::min(std::max(maxDistance, std::size_t(1)), MaxEditDistance);
+      word.erase(marker);
+    }
+
+    if (!isPrefix && !isFuzzy) {
+      tokenizer_.tokenize(word, terms);
+      continue;
+    }
+
+    // NOTE only last token of word is expanded: others should match exactly.
+    std::vector<std::string> parts;
+    tokenizer_.split(word, parts);
+    if (parts.empty())
+      continue;
+    for (std::size_t i = 0; i + 1 < parts.size(); ++i)
+      terms.push_back(stringTable_.getId(parts[i]));
+
+    Ids group;
+    if (isPrefix)
+      stringTable_.getIdsByPrefix(parts.back(), MaxTermExpansions, group);
+    else
+      stringTable_.getIdsBySimilarity(parts.back(), maxDistance, MaxTermExpansions, group);
+    groups.push_back(std::move(group));
+  }
+}
+
+void BitmapIndex::search(const CompiledQuery &query, ElementVisitor &visitor) {
+  search(query, visitor, []() { return false; });
+}
+
+void BitmapIndex::search(const CompiledQuery &query, ElementVisitor &visitor, const std::function<bool()> &isDone) {
+  if (threadPool_ != nullptr) {
+    searchParallel(query, visitor, isDone);
+    return;
+  }
 
-        applyOperation(notTerms, bitmap, [&](const Bitset &b) {
-          bitset = b.logicalxor(bitset).logicaland(bitset);
-        }, [](){ return true; });
+  std::vector<const Bitset *> operands;
+  std::vector<Bitset> merged;
+  operands.reserve(query.andTerms.size() + query.andGroups.size());
+
+  for (int lod = query.range.start; lod <= query.range.end && !isDone(); ++lod) {
+    utymap::utils::GeoUtils::visitTileRange(query.boundingBox, lod, utymap::utils::GeoUtils::TileOrder::Morton,
+      [&](const QuadKey &quadKey, const BoundingBox&) {
+        if (isDone() || !hasData(quadKey)) return;
 
-        for (auto i = bitset.begin(); i != bitset.end(); ++i) {
-          notify(quadKey, static_cast<std::uint32_t >(*i), visitor);
+        auto bitset = evaluate(query, quadKey, operands, merged);
+        for (auto i = bitset.begin(); i != bitset.end() && !isDone(); ++i) {
+          notify(quadKey, static_cast<std::uint32_t >(*i), query.boundingBox, visitor);
         }
       });
   }
 }
 
-std::vector<std::uint32_t> BitmapIndex::tokenize(const Element &element) {
-  Ids tokens;
-  tokens.reserve(element.tags.size() * 2 + 4);
-  for (const auto &tag : element.tags) {
-    auto key = stringTable_.getString(tag.key);
-    auto value = stringTable_.getString(tag.value);
-    tokenize(*key, tokens);
-    tokenize(*value, tokens);
+std::size_t BitmapIndex::count(const CompiledQuery &query, std::size_t maxCount, const std::function<bool()> &isDone) {
+  std::vector<const Bitset *> operands;
+  std::vector<Bitset> merged;
+  std::size_t count = 0;
+  auto isFull = [&]() { return (maxCount > 0 && count >= maxCount) || isDone(); };
+
+  for (int lod = query.range.start; lod <= query.range.end && !isFull(); ++lod) {
+    utymap::utils::GeoUtils::visitTileRange(query.boundingBox, lod, utymap::utils::GeoUtils::TileOrder::Morton,
+      [&](const QuadKey &quadKey, const BoundingBox&) {
+        if (isFull() || !hasData(quadKey)) return;
+        count += evaluate(query, quadKey, operands, merged).numberOfOnes();
+      });
   }
-  return tokens;
+  return maxCount > 0 ? std::min(count, maxCount) : count;
 }
 
-void BitmapIndex::tokenize(const std::string &source,
-                           Ids &destination) {
-  boost::tokenizer<boost::char_separator<char>> tokens(source, separator);
-  for (const auto& token : tokens) {
-    destination.push_back(stringTable_.getId(token));
+void BitmapIndex::searchParallel(const CompiledQuery &query, ElementVisitor &visitor, const std::function<bool()> &isDone) {
+  const std::size_t batchSize = threadPool_->size() * TasksPerThread * QuadKeysPerTask;
+  std::vector<QuadKey> quadKeys;
+  std::vector<Bitset> results;
+  std::vector<utymap::utils::ThreadPool::Future> futures;
+
+  for (int lod = query.range.start; lod <= query.range.end && !isDone(); ++lod) {
+    quadKeys.clear();
+    utymap::utils::GeoUtils::visitTileRange(query.boundingBox, lod, utymap::utils::GeoUtils::TileOrder::Morton,
+      [&](const QuadKey &quadKey, const BoundingBox&) {
+        quadKeys.push_back(quadKey);
+      });
+
+    for (std::size_t start = 0; start < quadKeys.size() && !isDone(); start += batchSize) {
+      const std::size_t end = std::min(start + batchSize, quadKeys.size());
+      results.clear();
+      results.resize(end - start);
+      futures.clear();
+
+      for (std::size_t first = start; first < end; first += QuadKeysPerTask) {
+        const std::size_t last = std::min(first + QuadKeysPerTask, end);
+        futures.push_back(threadPool_->enqueue([&, first, last, start]() {
+          std::vector<const Bitset *> operands;
+          std::vector<Bitset> merged;
+          for (std::size_t i = first; i < last; ++i) {
+            if (hasData(quadKeys[i]))
+              results[i - start] = evaluate(query, quadKeys[i], operands, merged);
+          }
+        }));
+      }
+
+      // NOTE wait for all tasks as they reference local buffers.
+      std::exception_ptr error;
+      for (auto &future : futures) {
+        try {
+          future.get();
+        } catch (...) {
+          if (!error)
+            error = std::current_exception();
+        }
+      }
+      if (error)
+        std::rethrow_exception(error);
+
+      for (std::size_t i = start; i < end && !isDone(); ++i) {
+        const auto &bitset = results[i - start];
+        for (auto it = bitset.begin(); it != bitset.end() && !isDone(); ++it) {
+          notify(quadKeys[i], static_cast<std::uint32_t>(*it), query.boundingBox, visitor);
+        }
+      }
+    }
   }
 }
 
+BitmapIndex::Bitset BitmapIndex::evaluate(const CompiledQuery &query,
+                                          const QuadKey &quadKey,
+                                          std::vector<const Bitset *> &operands,
+                                          std::vector<Bitset> &merged) {
+  const auto &andTerms = query.andTerms;
+  const auto &andGroups = query.andGroups;
+
+  Bitset bitset;
+  readBitmap(quadKey, [&](const Bitmap &bitmap) {
+    applyOperation(query.orTerms, bitmap, [&](const Bitset &b) {
+      bitset.inplaceOr(b);
+    }, [](){ return true; });
+
+    if (!andTerms.empty() || !andGroups.empty()) {
+      Bitset intersection;
+      if (!intersect(andTerms, andGroups, bitmap, operands, merged, intersection)) {
+        bitset.reset();
+        return;
+      }
+      // NOTE "or" result is only narrowed by "and" terms if it is not empty.
+      if (bitset.empty())
+        bitset.swap(intersection);
+      else
+        bitset.inplaceAnd(intersection);
+    }
+
+    applyOperation(query.notTerms, bitmap, [&](const Bitset &b) {
+      bitset.inplaceAndNot(b);
+    }, [](){ return true; });
+
+    auto erased = bitmap.find(ErasedToken);
+    if (erased != bitmap.end())
+      bitset.inplaceAndNot(erased->second);
+  });
+  return bitset;
+}
+
+BitmapIndex::MatchCursor::MatchCursor(BitmapIndex &index, CompiledQuery query) :
+    index_(index), query_(std::move(query)), levelOfDetail_(query_.range.start - 1),
+    quadKeys_(), quadKeyIndex_(0), orders_(), orderIndex_(0) {
+}
+
+bool BitmapIndex::MatchCursor::next(QuadKey &quadKey, std::uint32_t &order) {
+  while (orderIndex_ == orders_.size()) {
+    if (quadKeyIndex_ == quadKeys_.size()) {
+      if (levelOfDetail_ >= query_.range.end)
+        return false;
+
+      ++levelOfDetail_;
+      quadKeys_.clear();
+      quadKeyIndex_ = 0;
+      utymap::utils::GeoUtils::visitTileRange(query_.boundingBox, levelOfDetail_, utymap::utils::GeoUtils::TileOrder::Morton,
+        [&](const QuadKey &tileQuadKey, const BoundingBox&) {
+          quadKeys_.push_back(tileQuadKey);
+        });
+      continue;
+    }
+
+    const auto &current = quadKeys_[quadKeyIndex_++];
+    orders_.clear();
+    orderIndex_ = 0;
+    if (!index_.hasData(current))
+      continue;
+
+    auto bitset = index_.evaluate(query_, current, operands_, merged_);
+    for (auto it = bitset.begin(); it != bitset.end(); ++it)
+      orders_.push_back(static_cast<std::uint32_t>(*it));
+  }
+
+  quadKey = quadKeys_[quadKeyIndex_ - 1];
+  order = orders_[orderIndex_++];
+  return true;
+}
+
+void BitmapIndex::setSearchThreads(std::size_t threadCount) {
+  threadPool_ = threadCount > 0 ? utymap::utils::make_unique<utymap::utils::ThreadPool>(threadCount) : nullptr;
+}
+
+void BitmapIndex::markErased(Bitmap &bitmap, const Ids &orders) {
+  auto &erased = bitmap[ErasedToken];
+  for (const auto order : orders)
+    erased.set(order);
+}
+
+void BitmapIndex::setSearchKeys(const std::string &keys) {
+  tokenizer_.setSearchKeys(keys);
+}
+
 BitmapIndex::BitmapIndex(const StringTable &stringTable) :
-    stringTable_(stringTable) {
+    stringTable_(stringTable), tokenizer_(stringTable), threadPool_() {
 }
@@ -6,9 +6,14 @@
 #include "StringTable.hpp"
 #include "QuadKey.hpp"
 #include "entities/Element.hpp"
+#include "index/RoaringBitset.hpp"
+#include "index/Tokenizer.hpp"
+#include "utils/ThreadPool.hpp"
 
-#include <ewah/ewah.h>
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace utymap {
 namespace index {
@@ -16,10 +21,16 @@ namespace index {
 /// Provides the way to index strings in order to perform fast exact search.
 class BitmapIndex {
  public:
-  using Bitset = EWAHBoolArray<std::uint32_t>;
+  /// NOTE bitset type is changed only here: bitmap stream stores its format,
+  /// so bitmaps written by other type can be still read.
+  using Bitset = RoaringBitset;
   using Bitmap = std::unordered_map<std::uint32_t, Bitset>;
   using Ids = std::vector<std::uint32_t>;
 
+  /// Reserved token which marks orders of erased elements. Erased elements
+  /// are never returned by search.
+  static const std::uint32_t ErasedToken = 0xFFFFFFFF;
+
   /// Defines query to indexed string data.
   struct Query {
     /// Logical "not": result should not include any of these terms.
@@ -32,14 +43,54 @@ class BitmapIndex {
     utymap::BoundingBox boundingBox;
     /// LOD range constraint.
     utymap::LodRange range;
+    /// Amount of matches to skip. Used by element stores.
+    std::size_t offset;
+    /// Max amount of matches to visit. Zero means no limit. Used by element stores.
+    std::size_t limit;
+  };
+
+  /// Defines query with resolved term ids which can be searched many times.
+  /// Prefix and fuzzy terms are expanded to ids of matching tokens: "and" term
+  /// is kept as group where any of tokens should match.
+  struct CompiledQuery {
+    /// Sorted unique ids of terms.
+    Ids notTerms;
+    Ids andTerms;
+    std::vector<Ids> andGroups;
+    Ids orTerms;
+    utymap::BoundingBox boundingBox;
+    utymap::LodRange range;
+  };
+
+  /// Iterates over matches of query quad key by quad key: bitmap of next quad key is
+  /// evaluated only when matches of previous one are consumed. Quad keys are visited
+  /// in the same order as by sequential search.
+  /// NOTE no lock is held between calls.
+  class MatchCursor final {
+   public:
+    MatchCursor(BitmapIndex &index, CompiledQuery query);
+
+    /// Moves to next match. Returns false if there are no more matches.
+    bool next(utymap::QuadKey &quadKey, std::uint32_t &order);
+
+   private:
+    BitmapIndex &index_;
+    const CompiledQuery query_;
+    int levelOfDetail_;
+    std::vector<utymap::QuadKey> quadKeys_;
+    std::size_t quadKeyIndex_;
+    Ids orders_;
+    std::size_t orderIndex_;
+    std::vector<const Bitset *> operands_;
+    std::vector<Bitset> merged_;
   };
 
   explicit BitmapIndex(const utymap::index::StringTable &stringTable);
 
   virtual ~BitmapIndex() = default;
 
-  /// Adds element into index
-  void add(const utymap::entities::Element &element,
+  /// Adds element into index and returns ids of indexed tokens.
+  Ids add(const utymap::entities::Element &element,
            const utymap::QuadKey &quadKey,
            const std::uint32_t order);
 
@@ -47,30 +98,91 @@ class BitmapIndex {
   void search(const Query &query,
               utymap::entities::ElementVisitor &visitor);
 
+  /// Performs search using query with resolved terms. "And" terms are applied
+  /// starting from the smallest bitset and stop once result is empty.
+  void search(const CompiledQuery &query,
+              utymap::entities::ElementVisitor &visitor);
+
+  /// Performs search using query with resolved terms and stops visiting
+  /// quad keys once given predicate returns true.
+  void search(const CompiledQuery &query,
+              utymap::entities::ElementVisitor &visitor,
+              const std::function<bool()> &isDone);
+
+  /// Counts matches of query using bitmaps only. Counting stops once maxCount is
+  /// reached or given predicate returns true. Zero maxCount means no limit.
+  /// NOTE elements are not read, so they are not checked against bounding box and
+  /// element stored in many quad keys is counted in each of them.
+  std::size_t count(const CompiledQuery &query,
+                    std::size_t maxCount,
+                    const std::function<bool()> &isDone);
+
+  /// Sets keys of tags which are indexed, e.g. "name,addr:*". Empty list means that
+  /// all tags are indexed. Elements added before keep their tokens.
+  void setSearchKeys(const std::string &keys);
+
+  /// Enables parallel search mode: bitmaps of quad keys are evaluated on given amount
+  /// of threads and matches are passed to visitor in the same order as in sequential
+  /// mode. Zero disables it.
+  /// NOTE visitor and notify are called only from calling thread, readBitmap and
+  /// hasData should be safe to call concurrently.
+  void setSearchThreads(std::size_t threadCount);
+
+  /// Tokenizes query strings and resolves term ids once. Term which ends with "*"
+  /// matches tokens with given prefix and term which ends with "~" or "~2" matches
+  /// tokens within one or two edits.
+  CompiledQuery compile(const Query &query) const;
+
   /// Erases all data from given quad key.
   virtual void erase(const utymap::QuadKey &quadKey) = 0;
 
+  /// Marks elements with given orders as erased in bitmap. Orders should be sorted.
+  static void markErased(Bitmap &bitmap, const Ids &orders);
+
  protected:
+  /// Returns ids of indexed tokens of element.
+  Ids tokenize(const utymap::entities::Element &element) const;
+
   /// Notifies that element with given store order id
-  /// should be visited with visitor.
+  /// should be visited with visitor. Implementation may skip element
+  /// which doesn't intersect bounding box of query.
   virtual void notify(const utymap::QuadKey& quadKey,
                       const std::uint32_t order,
+                      const utymap::BoundingBox &bbox,
                       utymap::entities::ElementVisitor &visitor) = 0;
 
   /// Get bitmap for given quad key.
   virtual Bitmap& getBitmap(const utymap::QuadKey& quadKey) = 0;
 
+  /// Calls reader with bitmap for given quad key. Used by search, so
+  /// implementation can guard bitmap from concurrent modification.
+  virtual void readBitmap(const utymap::QuadKey& quadKey,
+                          const std::function<void(const Bitmap &)> &reader) {
+    reader(getBitmap(quadKey));
+  }
+
   /// Checks whether data exist for given quad key.
   virtual bool hasData(const utymap::QuadKey& quadKey) const = 0;
 
  private:
-  /// Gets tokens from element.
-  std::vector<std::uint32_t> tokenize(const utymap::entities::Element &element);
+  /// Evaluates query against bitmap of given quad key and returns matching orders.
+  /// Operands and merged are used as buffers.
+  Bitset evaluate(const CompiledQuery &query,
+                  const utymap::QuadKey &quadKey,
+                  std::vector<const Bitset *> &operands,
+                  std::vector<Bitset> &merged);
+
+  /// Performs search evaluating bitmaps of quad keys on thread pool in batches.
+  void searchParallel(const CompiledQuery &query,
+                      utymap::entities::ElementVisitor &visitor,
+                      const std::function<bool()> &isDone);
 
-  /// Stores tokens received from source into destination.
-  void tokenize(const std::string &str, Ids &destination);
+  /// Stores exact tokens of query string into terms and expansions of prefix and fuzzy terms into groups.
+  void compile(const std::string &source, Ids &terms, std::vector<Ids> &groups) const;
 
   const StringTable& stringTable_;
+  Tokenizer tokenizer_;
+  std::unique_ptr<utymap::utils::ThreadPool> threadPool_;
 };
 
 }
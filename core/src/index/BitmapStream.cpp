@@ -1,23 +1,96 @@
 #include "index/BitmapStream.hpp"
 
+#include <ewah/ewah.h>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
 using namespace utymap::index;
 
-void BitmapStream::read(std::istream &in, BitmapIndex::Bitmap &bitmap) {
+namespace {
+/// "UTBM" in little endian.
+const std::uint32_t Magic = 0x4D425455;
+/// Version of roaring bitset format.
+const std::uint32_t Version = 2;
+
+/// Reads bitmap written with ewah bitsets, before header was introduced.
+/// NOTE file starts with first token id, so it is treated as legacy unless
+/// that id matches magic which is not realistic for string table ids.
+void readLegacy(std::istream &in, BitmapIndex::Bitmap &bitmap) {
   std::uint32_t key;
-  BitmapIndex::Bitset bitset;
+  while (in.read(reinterpret_cast<char *>(&key), sizeof(key))) {
+    EWAHBoolArray<std::uint32_t> legacy;
+    legacy.read(in);
+    if (!in) break;
+    BitmapIndex::Bitset bitset;
+    for (auto it = legacy.begin(); it != legacy.end(); ++it)
+      bitset.set(static_cast<std::uint32_t>(*it));
+    bitmap.emplace(key, std::move(bitset));
+  }
+}
+}
+
+void BitmapStream::read(std::istream &in, BitmapIndex::Bitmap &bitmap) {
+  std::uint32_t header[2] = {0, 0};
   in.seekg(0, std::ios::beg);
-  do
-  {
-    in.read(reinterpret_cast<char *>(&key), sizeof(key));
-    bitset.read(in);
-    bitmap.emplace(key, bitset);
-  } while (in);
+  if (!in.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != Magic) {
+    in.clear();
+    in.seekg(0, std::ios::beg);
+    readLegacy(in, bitmap);
+    return;
+  }
+
+  if (header[1] != Version)
+    throw std::domain_error("Unsupported bitmap version: " + std::to_string(header[1]));
+
+  std::uint32_t key;
+  while (in.read(reinterpret_cast<char *>(&key), sizeof(key))) {
+    BitmapIndex::Bitset bitset;
+    if (!bitset.read(in)) break;
+    bitmap.emplace(key, std::move(bitset));
+  }
 }
 
 void BitmapStream::write(std::ostream &out, const BitmapIndex::Bitmap &bitmap) {
-  for (const auto kv : bitmap) {
+  out.write(reinterpret_cast<const char *>(&Magic), sizeof(Magic));
+  out.write(reinterpret_cast<const char *>(&Version), sizeof(Version));
+  for (const auto &kv : bitmap) {
     out.write(reinterpret_cast<const char *>(&kv.first), sizeof(kv.first));
     kv.second.write(out);
   }
   out.flush();
 }
+
+void BitmapStream::readDelta(std::istream &in, BitmapIndex::Bitmap &bitmap) {
+  std::uint32_t order;
+  in.seekg(0, std::ios::beg);
+  while (in.read(reinterpret_cast<char *>(&order), sizeof(order))) {
+    std::uint16_t size = 0;
+    in.read(reinterpret_cast<char *>(&size), sizeof(size));
+    for (std::uint16_t i = 0; i < size && in; ++i) {
+      std::uint32_t id;
+      if (!in.read(reinterpret_cast<char *>(&id), sizeof(id)))
+        break;
+      // NOTE erased orders are not appended in increasing order.
+      if (id == BitmapIndex::ErasedToken)
+        BitmapIndex::markErased(bitmap, { order });
+      else
+        bitmap[id].set(order);
+    }
+  }
+}
+
+void BitmapStream::writeDelta(std::ostream &out, std::uint32_t order, const BitmapIndex::Ids &ids) {
+  // NOTE entry keeps 16 bit token count, so more tokens are split into several entries of the same order.
+  const std::size_t maxSize = std::numeric_limits<std::uint16_t>::max();
+  std::size_t offset = 0;
+  do {
+    auto size = static_cast<std::uint16_t>(std::min(ids.size() - offset, maxSize));
+    out.write(reinterpret_cast<const char *>(&order), sizeof(order));
+    out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    if (size > 0)
+      out.write(reinterpret_cast<const char *>(&ids[offset]), size * sizeof(ids[offset]));
+    offset += size;
+  } while (offset < ids.size());
+}
@@ -9,6 +9,8 @@ namespace utymap {
 namespace index {
 
 /// Provides the way to store in stream and restore from it back.
+/// Stream starts with magic and format version. Streams without header are
+/// read as legacy ewah bitmaps.
 class BitmapStream final {
   public:
   /// Reads bitmap from stream.
@@ -16,6 +18,12 @@ class BitmapStream final {
 
   /// Writes bitmap to stream.
   static void write(std::ostream &out, const BitmapIndex::Bitmap &bitmap);
+
+  /// Reads delta log entries from stream and applies them to bitmap.
+  static void readDelta(std::istream &in, BitmapIndex::Bitmap &bitmap);
+
+  /// Appends delta log entry: tokens set for element with given order.
+  static void writeDelta(std::ostream &out, std::uint32_t order, const BitmapIndex::Ids &ids);
 };
 
 }
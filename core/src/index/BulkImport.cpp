@@ -0,0 +1,127 @@
+#include "index/BulkImport.hpp"
+#include "index/ElementStream.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+const std::string RunFileExtension = ".run";
+}
+
+BulkImport::BulkImport(const std::string &runPath, std::size_t maxRunBytes) :
+    runPath_(runPath), maxRunBytes_(maxRunBytes), records_(), recordBytes_(0), runPaths_() {}
+
+BulkImport::~BulkImport() {
+  removeRuns();
+}
+
+bool BulkImport::empty() const {
+  return records_.empty() && runPaths_.empty();
+}
+
+void BulkImport::add(const Element &element, const QuadKey &quadKey) {
+  std::ostringstream stream;
+  ElementStream::write(stream, element);
+  records_.push_back(Record{ quadKey, element.id, stream.str() });
+  recordBytes_ += records_.back().data.size() + sizeof(Record);
+  if (recordBytes_ >= maxRunBytes_)
+    writeRun();
+}
+
+void BulkImport::merge(const Visitor &visitor) {
+  if (runPaths_.empty()) {
+    sortRecords();
+    for (const auto &record : records_)
+      visit(record, visitor);
+    clear();
+    return;
+  }
+
+  writeRun();
+  std::vector<RunReader> readers;
+  for (std::size_t i = 0; i < runPaths_.size(); ++i) {
+    RunReader reader{ utymap::utils::make_unique<std::ifstream>(runPaths_[i], std::ios::in | std::ios::binary),
+                      Record(), i };
+    if (reader.next())
+      readers.push_back(std::move(reader));
+  }
+
+  // NOTE amount of runs is small: linear search of minimum is sufficient.
+  QuadKey::Comparator comparator;
+  while (!readers.empty()) {
+    std::size_t minIndex = 0;
+    for (std::size_t i = 1; i < readers.size(); ++i) {
+      if (comparator(readers[i].record.quadKey, readers[minIndex].record.quadKey))
+        minIndex = i;
+    }
+    visit(readers[minIndex].record, visitor);
+    if (!readers[minIndex].next())
+      readers.erase(readers.begin() + minIndex);
+  }
+  clear();
+}
+
+void BulkImport::clear() {
+  records_.clear();
+  recordBytes_ = 0;
+  removeRuns();
+}
+
+bool BulkImport::RunReader::next() {
+  std::int32_t header[3];
+  std::uint32_t size = 0;
+  if (!file->read(reinterpret_cast<char *>(header), sizeof(header)) ||
+      !file->read(reinterpret_cast<char *>(&record.id), sizeof(record.id)) ||
+      !file->read(reinterpret_cast<char *>(&size), sizeof(size)))
+    return false;
+  record.quadKey = QuadKey(header[0], header[1], header[2]);
+  record.data.resize(size);
+  return size == 0 || static_cast<bool>(file->read(&record.data[0], size));
+}
+
+void BulkImport::visit(const Record &record, const Visitor &visitor) {
+  auto element = ElementStream::read(record.data.data(), record.data.size(), record.id);
+  visitor(record.quadKey, *element);
+}
+
+void BulkImport::sortRecords() {
+  QuadKey::Comparator comparator;
+  std::stable_sort(records_.begin(), records_.end(), [&](const Record &lhs, const Record &rhs) {
+    return comparator(lhs.quadKey, rhs.quadKey);
+  });
+}
+
+void BulkImport::writeRun() {
+  if (records_.empty()) return;
+
+  sortRecords();
+  auto path = runPath_ + std::to_string(runPaths_.size()) + RunFileExtension;
+  std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  for (const auto &record : records_) {
+    std::int32_t header[3] = { record.quadKey.levelOfDetail, record.quadKey.tileX, record.quadKey.tileY };
+    auto size = static_cast<std::uint32_t>(record.data.size());
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(&record.id), sizeof(record.id));
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    file.write(record.data.data(), record.data.size());
+  }
+  if (!file.good())
+    throw std::domain_error("Cannot write bulk import run: " + path);
+
+  runPaths_.push_back(path);
+  records_.clear();
+  recordBytes_ = 0;
+}
+
+void BulkImport::removeRuns() {
+  for (const auto &path : runPaths_)
+    std::remove(path.c_str());
+  runPaths_.clear();
+}
@@ -0,0 +1,80 @@
+#ifndef INDEX_BULKIMPORT_HPP_DEFINED
+#define INDEX_BULKIMPORT_HPP_DEFINED
+
+#include "QuadKey.hpp"
+#include "entities/Element.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Collects elements of bulk import into run files sorted by quad key and merges them,
+/// so elements of every quad key are written together.
+class BulkImport final {
+ public:
+  using Visitor = std::function<void(const utymap::QuadKey &, const utymap::entities::Element &)>;
+
+  /// Creates import which writes run files with given path prefix once collected
+  /// elements take more than given amount of bytes.
+  BulkImport(const std::string &runPath, std::size_t maxRunBytes);
+
+  BulkImport(const BulkImport &) = delete;
+  BulkImport &operator=(const BulkImport &) = delete;
+
+  ~BulkImport();
+
+  /// Returns true if there are no collected elements.
+  bool empty() const;
+
+  /// Collects element of given quad key.
+  void add(const utymap::entities::Element &element, const utymap::QuadKey &quadKey);
+
+  /// Calls visitor with every element ordered by quad key. Elements of the same
+  /// quad key keep their insertion order.
+  void merge(const Visitor &visitor);
+
+  /// Drops collected elements.
+  void clear();
+
+ private:
+  /// Element record: element is kept serialized.
+  struct Record {
+    utymap::QuadKey quadKey;
+    std::uint64_t id;
+    std::string data;
+  };
+
+  /// Reads records of single run file sequentially.
+  struct RunReader {
+    std::unique_ptr<std::ifstream> file;
+    Record record;
+    std::size_t index;
+
+    bool next();
+  };
+
+  static void visit(const Record &record, const Visitor &visitor);
+
+  void sortRecords();
+
+  void writeRun();
+
+  void removeRuns();
+
+  const std::string runPath_;
+  const std::size_t maxRunBytes_;
+  std::vector<Record> records_;
+  std::size_t recordBytes_;
+  std::vector<std::string> runPaths_;
+};
+
+}
+}
+
+#endif // INDEX_BULKIMPORT_HPP_DEFINED
@@ -0,0 +1,35 @@
+#include "entities/ElementDispatch.hpp"
+#include "index/CompactionKeyVisitor.hpp"
+#include "index/ElementGeometryVisitor.hpp"
+#include "utils/GeoUtils.hpp"
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+/// Level of detail used to get spatial code of element on compaction.
+const int CompactionLevelOfDetail = 24;
+}
+
+CompactionKey CompactionKeyVisitor::create(const Element &element) {
+  CompactionKeyVisitor visitor;
+  dispatch(element, visitor);
+
+  ElementGeometryVisitor geometryVisitor;
+  dispatch(element, geometryVisitor);
+  const auto &bbox = geometryVisitor.boundingBox;
+
+  CompactionKey key;
+  key.type = visitor.type_;
+  key.id = element.id;
+  if (bbox.isValid()) {
+    GeoCoordinate center((bbox.minPoint.latitude + bbox.maxPoint.latitude) / 2,
+                         (bbox.minPoint.longitude + bbox.maxPoint.longitude) / 2);
+    auto quadKey = GeoUtils::GeoCoordinateToQuadKey(center, CompactionLevelOfDetail);
+    // NOTE level of detail is the same for all keys, so code is ordered by morton order of tiles.
+    key.spatialCode = quadKey.code();
+  }
+  return key;
+}
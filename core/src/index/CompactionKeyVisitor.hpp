@@ -0,0 +1,42 @@
+#ifndef INDEX_COMPACTIONKEYVISITOR_HPP_DEFINED
+#define INDEX_COMPACTIONKEYVISITOR_HPP_DEFINED
+
+#include "entities/Element.hpp"
+#include "entities/ElementVisitor.hpp"
+
+#include <cstdint>
+
+namespace utymap {
+namespace index {
+
+/// Defines order of elements in compacted quad key: by type, then by spatial order.
+struct CompactionKey final {
+  int type = 0;
+  std::uint64_t spatialCode = 0;
+  std::uint64_t id = 0;
+
+  bool operator<(const CompactionKey &other) const {
+    if (type != other.type) return type < other.type;
+    if (spatialCode != other.spatialCode) return spatialCode < other.spatialCode;
+    return id < other.id;
+  }
+};
+
+/// Creates compaction key of element: spatial code is Morton code of its bounding box center.
+class CompactionKeyVisitor final : public utymap::entities::ElementVisitor {
+ public:
+  static CompactionKey create(const utymap::entities::Element &element);
+
+  void visitNode(const utymap::entities::Node &) override { type_ = 0; }
+  void visitWay(const utymap::entities::Way &) override { type_ = 1; }
+  void visitArea(const utymap::entities::Area &) override { type_ = 2; }
+  void visitRelation(const utymap::entities::Relation &) override { type_ = 3; }
+
+ private:
+  int type_ = 0;
+};
+
+}
+}
+
+#endif // INDEX_COMPACTIONKEYVISITOR_HPP_DEFINED
@@ -0,0 +1,96 @@
+#ifndef INDEX_ELEMENTCURSOR_HPP_DEFINED
+#define INDEX_ELEMENTCURSOR_HPP_DEFINED
+
+#include "entities/Area.hpp"
+#include "entities/Element.hpp"
+#include "entities/ElementVisitor.hpp"
+#include "entities/Node.hpp"
+#include "entities/Relation.hpp"
+#include "entities/Way.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Provides pull based access to search results: elements are read only when they are
+/// requested, so consumer controls pace, can pause and interleave several cursors.
+/// NOTE cursor doesn't hold locks of store between calls, but store should outlive it.
+/// Cursor is not thread safe, but it can be passed to another thread.
+class ElementCursor {
+ public:
+  virtual ~ElementCursor() = default;
+
+  /// Returns next element or null if there are no more elements.
+  virtual std::unique_ptr<utymap::entities::Element> next() = 0;
+
+  /// Appends at most count next elements to batch. Returns amount of appended elements,
+  /// which is less than count only if cursor is exhausted.
+  std::size_t next(std::vector<std::unique_ptr<utymap::entities::Element>> &batch, std::size_t count) {
+    std::size_t appended = 0;
+    for (; appended < count; ++appended) {
+      auto element = next();
+      if (element == nullptr) break;
+      batch.push_back(std::move(element));
+    }
+    return appended;
+  }
+};
+
+/// Cursor over copies of elements which are collected before they are pulled. It is
+/// used by stores which can only push elements to visitor.
+class BufferedElementCursor final : public ElementCursor, public utymap::entities::ElementVisitor {
+ public:
+  std::unique_ptr<utymap::entities::Element> next() override {
+    if (position_ == elements_.size()) return nullptr;
+    return std::move(elements_[position_++]);
+  }
+
+  void visitNode(const utymap::entities::Node &node) override {
+    elements_.push_back(utymap::utils::make_unique<utymap::entities::Node>(node));
+  }
+
+  void visitWay(const utymap::entities::Way &way) override {
+    elements_.push_back(utymap::utils::make_unique<utymap::entities::Way>(way));
+  }
+
+  void visitArea(const utymap::entities::Area &area) override {
+    elements_.push_back(utymap::utils::make_unique<utymap::entities::Area>(area));
+  }
+
+  void visitRelation(const utymap::entities::Relation &relation) override {
+    elements_.push_back(utymap::utils::make_unique<utymap::entities::Relation>(relation));
+  }
+
+ private:
+  std::vector<std::unique_ptr<utymap::entities::Element>> elements_;
+  std::size_t position_ = 0;
+};
+
+/// Pulls elements from cursors one after another.
+class ChainedElementCursor final : public ElementCursor {
+ public:
+  explicit ChainedElementCursor(std::vector<std::unique_ptr<ElementCursor>> cursors) :
+      cursors_(std::move(cursors)), position_(0) {}
+
+  std::unique_ptr<utymap::entities::Element> next() override {
+    for (; position_ < cursors_.size(); ++position_) {
+      auto element = cursors_[position_]->next();
+      if (element != nullptr) return element;
+      // NOTE exhausted cursor is released, so it doesn't keep data of its store.
+      cursors_[position_].reset();
+    }
+    return nullptr;
+  }
+
+ private:
+  std::vector<std::unique_ptr<ElementCursor>> cursors_;
+  std::size_t position_;
+};
+
+}
+}
+
+#endif // INDEX_ELEMENTCURSOR_HPP_DEFINED
@@ -1,5 +1,6 @@
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Element.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
@@ -7,6 +8,10 @@
 #include "entities/Relation.hpp"
 #include "index/ElementStore.hpp"
 #include "index/ElementGeometryClipper.hpp"
+#include "math/FixedPoint.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <algorithm>
 
 using namespace utymap;
 using namespace utymap::entities;
@@ -14,9 +19,6 @@ using namespace utymap::mapcss;
 using namespace utymap::math;
 
 namespace {
-/// Max precision for Lat/Lon
-const double Scale = 1E7;
-
 using PointLocation = utymap::index::ElementGeometryClipper::PointLocation;
 
 template<typename T, typename std::enable_if<std::is_same<T, Way>::value, std::size_t>::type = 0>
@@ -30,8 +32,7 @@ bool areConnected(const BoundingBox &quadKeyBbox, const BoundingBox &elementBbox
 }
 
 template<typename T>
-PointLocation checkElement(const BoundingBox &quadKeyBbox, const T &element, IntPath &elementShape) {
-  elementShape.reserve(element.coordinates.size());
+PointLocation checkElement(const BoundingBox &quadKeyBbox, const T &element) {
   bool allInside = true;
   bool allOutside = true;
   BoundingBox elementBbox;
@@ -40,94 +41,282 @@ PointLocation checkElement(const BoundingBox &quadKeyBbox, const T &element, Int
     allInside &= contains;
     allOutside &= !contains;
     elementBbox.expand(coord);
-
-    auto x = static_cast<cInt>(coord.longitude*Scale);
-    auto y = static_cast<cInt>(coord.latitude*Scale);
-    elementShape.push_back(IntPoint(x, y));
   }
 
   return allInside ? PointLocation::AllInside :
          (areConnected<T>(quadKeyBbox, elementBbox, allOutside) ? PointLocation::Mixed : PointLocation::AllOutside);
 }
 
-template<typename T>
-void setCoordinates(T &t, const IntPath &path) {
-  t.coordinates.reserve(path.size());
-  for (const auto &c : path) {
-    t.coordinates.push_back(GeoCoordinate(c.Y/Scale, c.X/Scale));
-  }
+IntPath createPath(const std::vector<GeoCoordinate> &coordinates) {
+  IntPath path;
+  path.reserve(coordinates.size());
+  for (const GeoCoordinate &coord : coordinates)
+    path.push_back(toIntPoint(coord));
+  return path;
 }
 
 IntPath createPathFromBoundingBox(const BoundingBox &quadKeyBbox) {
-  double xMin = quadKeyBbox.minPoint.longitude, yMin = quadKeyBbox.minPoint.latitude,
-      xMax = quadKeyBbox.maxPoint.longitude, yMax = quadKeyBbox.maxPoint.latitude;
+  const GeoCoordinate &min = quadKeyBbox.minPoint, &max = quadKeyBbox.maxPoint;
   IntPath rect;
-  rect.push_back(IntPoint(static_cast<cInt>(xMin*Scale),
-                                      static_cast<cInt>(yMin*Scale)));
+  rect.push_back(toIntPoint(min));
+  rect.push_back(toIntPoint(GeoCoordinate(min.latitude, max.longitude)));
+  rect.push_back(toIntPoint(max));
+  rect.push_back(toIntPoint(GeoCoordinate(max.latitude, min.longitude)));
+  return std::move(rect);
+}
 
-  rect.push_back(IntPoint(static_cast<cInt>(xMax*Scale),
-                                      static_cast<cInt>(yMin*Scale)));
+/// Keeps buffers used while element is clipped: their capacity is reused by next element.
+struct ClipBuffers {
+  /// Clipped parts: only first partCount items are valid.
+  std::vector<std::vector<GeoCoordinate>> parts;
+  std::size_t partCount = 0;
+  std::vector<GeoCoordinate> ring;
+  std::vector<GeoCoordinate> buffer;
+
+  /// Adds empty part.
+  std::vector<GeoCoordinate> &addPart() {
+    if (partCount==parts.size())
+      parts.emplace_back();
+    auto &part = parts[partCount++];
+    part.clear();
+    return part;
+  }
+};
 
-  rect.push_back(IntPoint(static_cast<cInt>(xMax*Scale),
-                                      static_cast<cInt>(yMax*Scale)));
+/// Creates element from clipped parts: single part is stored as copy of element,
+/// many parts are stored as relation (collection of elements).
+template<typename T>
+std::shared_ptr<Element> createClipped(const T &element, ClipBuffers &buffers) {
+  if (buffers.partCount==0)
+    return nullptr;
 
-  rect.push_back(IntPoint(static_cast<cInt>(xMin*Scale),
-                                      static_cast<cInt>(yMax*Scale)));
-  return std::move(rect);
+  if (buffers.partCount==1) {
+    auto clippedElement = std::make_shared<T>();
+    clippedElement->id = element.id;
+    clippedElement->tags = element.tags;
+    clippedElement->coordinates = buffers.parts[0];
+    return clippedElement;
+  }
+
+  auto relation = std::make_shared<Relation>();
+  relation->id = element.id;
+  relation->elements.reserve(buffers.partCount);
+  for (std::size_t i = 0; i < buffers.partCount; ++i) {
+    auto clippedElement = std::make_shared<T>();
+    clippedElement->id = 0;
+    clippedElement->tags = element.tags;
+    clippedElement->coordinates = buffers.parts[i];
+    relation->elements.push_back(clippedElement);
+  }
+  return relation;
 }
 
-template<typename T>
-std::shared_ptr<Element> clipElement(Clipper &clipper,
-                                     const BoundingBox &bbox,
-                                     const T &element,
-                                     bool isClosed) {
-  IntPath elementShape;
-  PointLocation pointLocation = checkElement(bbox, element, elementShape);
-  // 1. all geometry inside current quadkey: no need to truncate.
-  if (pointLocation==PointLocation::AllInside) {
-    return std::make_shared<T>(element);
+/// Clips segment by rectangle using Liang-Barsky algorithm. Returns false if segment is outside.
+bool clipSegment(const BoundingBox &bbox, GeoCoordinate &start, GeoCoordinate &end) {
+  double dx = end.longitude - start.longitude;
+  double dy = end.latitude - start.latitude;
+  double p[] = { -dx, dx, -dy, dy };
+  double q[] = { start.longitude - bbox.minPoint.longitude, bbox.maxPoint.longitude - start.longitude,
+                 start.latitude - bbox.minPoint.latitude, bbox.maxPoint.latitude - start.latitude };
+  double t0 = 0, t1 = 1;
+  for (int i = 0; i < 4; ++i) {
+    if (p[i]==0) {
+      if (q[i] < 0) return false;
+      continue;
+    }
+    double t = q[i]/p[i];
+    if (p[i] < 0) {
+      if (t > t1) return false;
+      t0 = std::max(t0, t);
+    } else {
+      if (t < t0) return false;
+      t1 = std::min(t1, t);
+    }
   }
 
-  // 2. all geometry outside : way should be skipped
-  if (pointLocation==PointLocation::AllOutside) {
-    return nullptr;
+  GeoCoordinate clippedStart(start.latitude + t0*dy, start.longitude + t0*dx);
+  GeoCoordinate clippedEnd(start.latitude + t1*dy, start.longitude + t1*dx);
+  start = clippedStart;
+  end = clippedEnd;
+  return true;
+}
+
+/// Clips polyline by rectangle keeping its direction. Every part inside rectangle is added separately.
+void clipPolyline(const BoundingBox &bbox, const std::vector<GeoCoordinate> &coordinates, ClipBuffers &buffers) {
+  for (std::size_t i = 1; i < coordinates.size(); ++i) {
+    GeoCoordinate start = coordinates[i - 1], end = coordinates[i];
+    if (!clipSegment(bbox, start, end) || start==end)
+      continue;
+
+    if (buffers.partCount==0 || !(buffers.parts[buffers.partCount - 1].back()==start))
+      buffers.addPart().push_back(start);
+    buffers.parts[buffers.partCount - 1].push_back(end);
   }
+}
 
+/// Checks whether ring is convex and simple: all turns have the same direction and
+/// edge directions change sign at most twice along each axis.
+bool isConvex(const std::vector<GeoCoordinate> &ring) {
+  std::size_t size = ring.size();
+  if (size < 3) return false;
+
+  int turn = 0, xChanges = 0, yChanges = 0;
+  double lastDx = 0, lastDy = 0;
+  for (std::size_t i = 0; i < size + 2; ++i) {
+    const auto &a = ring[i%size], &b = ring[(i + 1)%size], &c = ring[(i + 2)%size];
+    double dx = b.longitude - a.longitude, dy = b.latitude - a.latitude;
+    double cross = dx*(c.latitude - b.latitude) - dy*(c.longitude - b.longitude);
+    if (cross!=0) {
+      int sign = cross > 0 ? 1 : -1;
+      if (turn!=0 && sign!=turn) return false;
+      turn = sign;
+    }
+    if (i < size) {
+      if (dx!=0) {
+        if (lastDx!=0 && (dx > 0)!=(lastDx > 0)) ++xChanges;
+        lastDx = dx;
+      }
+      if (dy!=0) {
+        if (lastDy!=0 && (dy > 0)!=(lastDy > 0)) ++yChanges;
+        lastDy = dy;
+      }
+    }
+  }
+  return turn!=0 && xChanges <= 2 && yChanges <= 2;
+}
+
+/// Clips convex ring by one side of rectangle: Sutherland-Hodgman step.
+template<typename Inside, typename Intersect>
+void clipBySide(const std::vector<GeoCoordinate> &input, std::vector<GeoCoordinate> &output,
+                const Inside &inside, const Intersect &intersect) {
+  output.clear();
+  if (input.empty()) return;
+
+  const GeoCoordinate *previous = &input.back();
+  for (const auto &current : input) {
+    bool isCurrentInside = inside(current);
+    if (isCurrentInside!=inside(*previous))
+      output.push_back(intersect(*previous, current));
+    if (isCurrentInside)
+      output.push_back(current);
+    previous = &current;
+  }
+}
+
+/// Clips convex ring by rectangle using Sutherland-Hodgman algorithm. Result is counterclockwise.
+/// Returns false if nothing is left.
+bool clipConvexRing(const BoundingBox &bbox,
+                    const std::vector<GeoCoordinate> &ring,
+                    std::vector<GeoCoordinate> &result,
+                    std::vector<GeoCoordinate> &buffer) {
+  auto atLongitude = [](double longitude) {
+    return [longitude](const GeoCoordinate &a, const GeoCoordinate &b) {
+      double t = (longitude - a.longitude)/(b.longitude - a.longitude);
+      return GeoCoordinate(a.latitude + t*(b.latitude - a.latitude), longitude);
+    };
+  };
+  auto atLatitude = [](double latitude) {
+    return [latitude](const GeoCoordinate &a, const GeoCoordinate &b) {
+      double t = (latitude - a.latitude)/(b.latitude - a.latitude);
+      return GeoCoordinate(latitude, a.longitude + t*(b.longitude - a.longitude));
+    };
+  };
+  const auto &min = bbox.minPoint;
+  const auto &max = bbox.maxPoint;
+
+  clipBySide(ring, buffer, [&](const GeoCoordinate &c) { return c.longitude >= min.longitude; }, atLongitude(min.longitude));
+  clipBySide(buffer, result, [&](const GeoCoordinate &c) { return c.longitude <= max.longitude; }, atLongitude(max.longitude));
+  clipBySide(result, buffer, [&](const GeoCoordinate &c) { return c.latitude >= min.latitude; }, atLatitude(min.latitude));
+  clipBySide(buffer, result, [&](const GeoCoordinate &c) { return c.latitude <= max.latitude; }, atLatitude(max.latitude));
+
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  while (result.size() > 1 && result.front()==result.back())
+    result.pop_back();
+  if (result.size() < 3)
+    return false;
+
+  double area = 0;
+  for (std::size_t i = 0, j = result.size() - 1; i < result.size(); j = i++)
+    area += result[j].longitude*result[i].latitude - result[i].longitude*result[j].latitude;
+  if (area==0)
+    return false;
+  if (area < 0)
+    std::reverse(result.begin(), result.end());
+
+  // NOTE ring starts from its top right point as rings produced by general clipper.
+  auto first = std::min_element(result.begin(), result.end(), [](const GeoCoordinate &lhs, const GeoCoordinate &rhs) {
+    return lhs.latitude > rhs.latitude || (lhs.latitude==rhs.latitude && lhs.longitude > rhs.longitude);
+  });
+  std::rotate(result.begin(), first, result.end());
+  return true;
+}
+
+/// Clips element by general polygon clipper.
+/// NOTE clipper library allocates its own structures.
+template<typename T>
+void clipByClipper(Clipper &clipper, const T &element, bool isClosed, ClipBuffers &buffers) {
   PolyTree solution;
-  addSubject(clipper, elementShape, isClosed);
+  addSubject(clipper, createPath(element.coordinates), isClosed);
   executeIntersection(clipper, solution);
   clipper.removeSubject();
 
-  std::size_t count = static_cast<std::size_t>(solution.Total());
+  PolyNode *polyNode = solution.GetFirst();
+  while (polyNode) {
+    auto &part = buffers.addPart();
+    for (const auto &point : polyNode->Contour)
+      part.push_back(toGeoCoordinate(point));
+    polyNode = polyNode->GetNext();
+  }
+}
 
-  // 3. way intersects border only once: store a copy with clipped geometry
-  if (count==1) {
-    auto clippedElement = std::make_shared<T>();
-    clippedElement->id = element.id;
-    clippedElement->tags = element.tags;
-    setCoordinates(*clippedElement, solution.GetFirst()->Contour);
-    
-    return clippedElement;
+/// Clips geometry of element. If element is partially inside, its clipped parts are kept in buffers.
+template<typename T>
+PointLocation clipParts(Clipper &clipper,
+                        const BoundingBox &bbox,
+                        const T &element,
+                        bool isClosed,
+                        ClipBuffers &buffers) {
+  buffers.partCount = 0;
+  PointLocation pointLocation = checkElement(bbox, element);
+  // 1. all geometry inside current quadkey: no need to truncate.
+  // 2. all geometry outside : way should be skipped
+  if (pointLocation!=PointLocation::Mixed)
+    return pointLocation;
+
+  // 3. way is clipped by rectangle directly: every part inside quadkey is stored.
+  if (!isClosed) {
+    clipPolyline(bbox, element.coordinates, buffers);
+    return pointLocation;
   }
-  // 4. in this case, result should be stored as relation (collection of ways)
-  if (count > 1) {
-    auto relation = std::make_shared<Relation>();
-    relation->id = element.id;
-    relation->elements.reserve(count);
-    PolyNode *polyNode = solution.GetFirst();
-    while (polyNode) {
-      auto clippedElement = std::make_shared<T>();
-      clippedElement->id = 0;
-      clippedElement->tags = element.tags;
-      setCoordinates(*clippedElement, polyNode->Contour);
-      relation->elements.push_back(clippedElement);
-      polyNode = polyNode->GetNext();
-    }
-    return relation;
+
+  // 4. convex area has at most one part inside quadkey.
+  auto &ring = buffers.ring;
+  ring.assign(element.coordinates.begin(), element.coordinates.end());
+  if (ring.size() > 1 && ring.front()==ring.back())
+    ring.pop_back();
+  if (isConvex(ring)) {
+    auto &part = buffers.addPart();
+    if (!clipConvexRing(bbox, ring, part, buffers.buffer))
+      buffers.partCount = 0;
+    return pointLocation;
   }
 
-  // no intersection
-  return nullptr;
+  // 5. other areas can be split into many parts, so general clipper is used.
+  clipByClipper(clipper, element, isClosed, buffers);
+  return pointLocation;
+}
+
+template<typename T>
+std::shared_ptr<Element> clipElement(Clipper &clipper,
+                                     const BoundingBox &bbox,
+                                     const T &element,
+                                     bool isClosed) {
+  ClipBuffers buffers;
+  switch (clipParts(clipper, bbox, element, isClosed, buffers)) {
+    case PointLocation::AllInside: return std::make_shared<T>(element);
+    case PointLocation::AllOutside: return nullptr;
+    default: return createClipped(element, buffers);
+  }
 }
 
 std::shared_ptr<Element> clipWay(Clipper &clipper, const BoundingBox &bbox, const Way &way) {
@@ -138,6 +327,20 @@ std::shared_ptr<Element> clipArea(Clipper &clipper, const BoundingBox &bbox, con
   return clipElement(clipper, bbox, area, true);
 }
 
+/// Returns part element from pool which is not referenced outside of pool, e.g. by stored
+/// relation, or adds new one.
+template<typename T>
+T &getPart(std::vector<std::shared_ptr<T>> &pool, std::size_t index) {
+  if (index==pool.size() || pool[index].use_count() > 1) {
+    auto part = std::make_shared<T>();
+    if (index==pool.size())
+      pool.push_back(part);
+    else
+      pool[index] = part;
+  }
+  return *pool[index];
+}
+
 std::shared_ptr<Element> clipRelation(Clipper &clipper,
                                       const BoundingBox &bbox,
                                       const Relation &relation);
@@ -194,7 +397,7 @@ std::shared_ptr<Element> clipRelation(Clipper &clipper,
   RelationVisitor visitor(clipper, bbox);
 
   for (const auto &element : relation.elements)
-    element->accept(visitor);
+    dispatch(*element, visitor);
 
   if (visitor.relation==nullptr)
     return nullptr;
@@ -213,39 +416,101 @@ std::shared_ptr<Element> clipRelation(Clipper &clipper,
 namespace utymap {
 namespace index {
 
+struct ElementGeometryClipper::Buffers : ClipBuffers {};
+
 ElementGeometryClipper::ElementGeometryClipper(const utymap::QuadKey &quadKey,
                                                const utymap::BoundingBox &quadKeyBbox,
                                                Callback callback) :
- callback_(callback), quadKey_(quadKey), quadKeyBbox_(quadKeyBbox), clipper_() {
+ callback_(callback), quadKey_(quadKey), quadKeyBbox_(quadKeyBbox), clipper_(), result_(),
+ buffers_(utymap::utils::make_unique<Buffers>()) {
   addClip(clipper_, createPathFromBoundingBox(quadKeyBbox_));
 }
 
+ElementGeometryClipper::~ElementGeometryClipper() {}
+
+void ElementGeometryClipper::setCallback(Callback callback) {
+  callback_ = std::move(callback);
+}
+
 void ElementGeometryClipper::clipAndCall(const Element &element) {
+  switch (element.kind) {
+    case ElementKind::Node:
+      if (quadKeyBbox_.contains(static_cast<const Node &>(element).coordinate))
+        callback_(element, quadKey_);
+      return;
+    case ElementKind::Way:
+      clipAndCall(static_cast<const Way &>(element), false, way_, wayParts_);
+      return;
+    case ElementKind::Area:
+      clipAndCall(static_cast<const Area &>(element), true, area_, areaParts_);
+      return;
+    default: {
+      auto clipped = clip(element);
+      if (clipped!=nullptr)
+        callback_(*clipped, quadKey_);
+    }
+  }
+}
+
+template<typename T>
+void ElementGeometryClipper::clipAndCall(const T &element,
+                                         bool isClosed,
+                                         T &scratch,
+                                         std::vector<std::shared_ptr<T>> &parts) {
+  auto &buffers = *buffers_;
+  auto pointLocation = clipParts(clipper_, quadKeyBbox_, element, isClosed, buffers);
+  if (pointLocation==PointLocation::AllInside) {
+    callback_(element, quadKey_);
+    return;
+  }
+
+  if (buffers.partCount==0)
+    return;
+
+  if (buffers.partCount==1) {
+    scratch.id = element.id;
+    scratch.tags.assign(element.tags.begin(), element.tags.end());
+    scratch.coordinates.assign(buffers.parts[0].begin(), buffers.parts[0].end());
+    callback_(scratch, quadKey_);
+    return;
+  }
+
+  relation_.id = element.id;
+  relation_.elements.clear();
+  for (std::size_t i = 0; i < buffers.partCount; ++i) {
+    auto &part = getPart(parts, i);
+    part.id = 0;
+    part.tags.assign(element.tags.begin(), element.tags.end());
+    part.coordinates.assign(buffers.parts[i].begin(), buffers.parts[i].end());
+    relation_.elements.push_back(parts[i]);
+  }
+  callback_(relation_, quadKey_);
+  relation_.elements.clear();
+}
+
+std::shared_ptr<Element> ElementGeometryClipper::clip(const Element &element) {
   element.accept(*this);
   clipper_.removeSubject();
+  auto result = result_;
+  result_.reset();
+  return result;
 }
 
 void ElementGeometryClipper::visitNode(const Node &node) {
   if (quadKeyBbox_.contains(node.coordinate))
-    callback_(node, quadKey_);
+    result_ = std::make_shared<Node>(node);
 }
 
 void ElementGeometryClipper::visitWay(const Way &way) {
-  auto element = clipWay(clipper_, quadKeyBbox_, way);
-  if (element!=nullptr)
-    callback_(*element, quadKey_);
+  result_ = clipWay(clipper_, quadKeyBbox_, way);
 }
 
 void ElementGeometryClipper::visitArea(const Area &area) {
-  auto element = clipArea(clipper_, quadKeyBbox_, area);
-  if (element!=nullptr)
-    callback_(*element, quadKey_);
+  result_ = clipArea(clipper_, quadKeyBbox_, area);
 }
 
 void ElementGeometryClipper::visitRelation(const Relation &relation) {
-  auto element = clipRelation(clipper_, quadKeyBbox_, relation);
-  if (element!=nullptr)
-    callback_(*element, quadKey_);
+  result_ = clipRelation(clipper_, quadKeyBbox_, relation);
 }
 
 }
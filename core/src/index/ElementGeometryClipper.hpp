@@ -3,11 +3,16 @@
 
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "entities/Area.hpp"
 #include "entities/Element.hpp"
 #include "entities/ElementVisitor.hpp"
+#include "entities/Relation.hpp"
+#include "entities/Way.hpp"
 #include "math/PolyClip.hpp"
 
 #include <functional>
+#include <memory>
+#include <vector>
 
 namespace utymap {
 namespace index {
@@ -24,8 +29,21 @@ class ElementGeometryClipper final : private utymap::entities::ElementVisitor {
                          const utymap::BoundingBox &quadKeyBbox,
                          Callback callback);
 
+  ~ElementGeometryClipper();
+
+  /// Sets callback, so clipper can be reused by another caller.
+  void setCallback(Callback callback);
+
+  /// Clips element and calls callback with result. Element which is inside is passed as is,
+  /// clipped way or area is passed as reusable element of clipper, so warmed up clipper
+  /// doesn't allocate memory for them. Relations are clipped by clip.
+  /// NOTE callback should copy element if it needs it after call.
   void clipAndCall(const utymap::entities::Element &element);
 
+  /// Returns element with geometry clipped by quadkey or nullptr if it is outside.
+  /// NOTE result can be clipped again by quadkey of child tile.
+  std::shared_ptr<utymap::entities::Element> clip(const utymap::entities::Element &element);
+
  private:
 
   void visitNode(const utymap::entities::Node &node) override;
@@ -36,10 +54,23 @@ class ElementGeometryClipper final : private utymap::entities::ElementVisitor {
 
   void visitRelation(const utymap::entities::Relation &relation) override;
 
+  template<typename T>
+  void clipAndCall(const T &element, bool isClosed, T &scratch, std::vector<std::shared_ptr<T>> &parts);
+
+  struct Buffers;
+
   Callback callback_;
   QuadKey quadKey_;
   BoundingBox quadKeyBbox_;
   utymap::math::Clipper clipper_;
+  std::shared_ptr<utymap::entities::Element> result_;
+  std::unique_ptr<Buffers> buffers_;
+  /// Reusable elements which are passed to callback.
+  utymap::entities::Way way_;
+  utymap::entities::Area area_;
+  utymap::entities::Relation relation_;
+  std::vector<std::shared_ptr<utymap::entities::Way>> wayParts_;
+  std::vector<std::shared_ptr<utymap::entities::Area>> areaParts_;
 };
 
 }
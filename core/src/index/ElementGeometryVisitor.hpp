@@ -3,6 +3,7 @@
 
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
@@ -13,7 +14,7 @@ namespace utymap {
 namespace index {
 
 /// Creates bounding box of given element.
-class ElementGeometryVisitor : public utymap::entities::ElementVisitor {
+class ElementGeometryVisitor final : public utymap::entities::ElementVisitor {
  public:
   utymap::BoundingBox boundingBox;
 
@@ -31,17 +32,67 @@ class ElementGeometryVisitor : public utymap::entities::ElementVisitor {
 
   void visitRelation(const utymap::entities::Relation &relation) override {
     for (const auto &element: relation.elements) {
-      element->accept(*this);
+      utymap::entities::dispatch(*element, *this);
     }
   }
 
   /// Checks whether element geometry intersects given bbox.
   static bool intersects(const utymap::entities::Element &element,
                          const utymap::BoundingBox &bbox) {
-    ElementGeometryVisitor visitor;
-    element.accept(visitor);
-    return bbox.intersects(visitor.boundingBox);
+    IntersectionVisitor visitor(bbox);
+    utymap::entities::dispatch(element, visitor);
+    return visitor.result || bbox.intersects(visitor.boundingBox);
   }
+
+ private:
+  /// Accumulates bounding box of element, but stops as soon as some coordinate
+  /// is found inside the query bbox: element's bbox definitely intersects it then.
+  class IntersectionVisitor final : public utymap::entities::ElementVisitor {
+   public:
+    explicit IntersectionVisitor(const utymap::BoundingBox &bbox) : result(false), bbox_(bbox) {}
+
+    bool result;
+    utymap::BoundingBox boundingBox;
+
+    void visitNode(const utymap::entities::Node &node) override {
+      result = result || isInside(node.coordinate);
+      boundingBox.expand(node.coordinate);
+    }
+
+    void visitWay(const utymap::entities::Way &way) override {
+      visitCoordinates(way.coordinates);
+    }
+
+    void visitArea(const utymap::entities::Area &area) override {
+      visitCoordinates(area.coordinates);
+    }
+
+    void visitRelation(const utymap::entities::Relation &relation) override {
+      for (const auto &element: relation.elements) {
+        if (result) return;
+        utymap::entities::dispatch(*element, *this);
+      }
+    }
+
+   private:
+    bool isInside(const utymap::GeoCoordinate &c) const {
+      return c.latitude >= bbox_.minPoint.latitude && c.latitude <= bbox_.maxPoint.latitude &&
+          c.longitude >= bbox_.minPoint.longitude && c.longitude <= bbox_.maxPoint.longitude;
+    }
+
+    void visitCoordinates(const std::vector<utymap::GeoCoordinate> &coordinates) {
+      if (result) return;
+      for (const auto &coordinate : coordinates) {
+        if (isInside(coordinate)) {
+          result = true;
+          return;
+        }
+      }
+      boundingBox.expand(coordinates.cbegin(), coordinates.cend());
+    }
+
+    const utymap::BoundingBox &bbox_;
+  };
 };
 
 }
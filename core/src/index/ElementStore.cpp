@@ -1,5 +1,6 @@
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Element.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
@@ -9,8 +10,15 @@
 #include "index/ElementGeometryClipper.hpp"
 #include "index/ElementGeometryVisitor.hpp"
 #include "index/ElementStore.hpp"
+#include "index/ElementVisitorLimit.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/GeometryUtils.hpp"
+#include "utils/MathUtils.hpp"
 #include <mapcss/StyleConsts.hpp>
 
+#include <cmath>
+#include <unordered_map>
+
 using namespace utymap;
 using namespace utymap::entities;
 using namespace utymap::formats;
@@ -18,6 +26,117 @@ using namespace utymap::mapcss;
 
 namespace {
  const std::string TrueValue = "true";
+
+/// Size of tile in pixels used to convert simplification tolerance to degrees.
+const double TileSize = 256;
+
+/// Creates copy of element with simplified geometry. Simplified ring which is degenerated
+/// or has changed orientation is replaced by original one.
+class ElementSimplifier final : public ElementVisitor {
+ public:
+  ElementSimplifier(double tolerance, double longitudeScale) :
+      tolerance_(tolerance), longitudeScale_(longitudeScale) {
+  }
+
+  static std::shared_ptr<Element> simplify(const Element &element, double tolerance, double longitudeScale) {
+    ElementSimplifier simplifier(tolerance, longitudeScale);
+    dispatch(element, simplifier);
+    return simplifier.result_;
+  }
+
+  void visitNode(const Node &node) override {
+    result_ = std::make_shared<Node>(node);
+  }
+
+  void visitWay(const Way &way) override {
+    auto result = std::make_shared<Way>();
+    copy(way, *result);
+    result->coordinates = utymap::utils::simplify(way.coordinates, tolerance_, longitudeScale_);
+    result_ = result;
+  }
+
+  void visitArea(const Area &area) override {
+    auto result = std::make_shared<Area>();
+    copy(area, *result);
+    result->coordinates = simplifyRing(area.coordinates);
+    result_ = result;
+  }
+
+  void visitRelation(const Relation &relation) override {
+    auto result = std::make_shared<Relation>();
+    copy(relation, *result);
+    result->elements.reserve(relation.elements.size());
+    for (const auto &member : relation.elements) {
+      dispatch(*member, *this);
+      result->elements.push_back(result_);
+    }
+    result_ = result;
+  }
+
+ private:
+  static void copy(const Element &source, Element &destination) {
+    destination.id = source.id;
+    destination.tags = source.tags;
+  }
+
+  /// NOTE ring is simplified as closed polyline, so its first point is always kept.
+  std::vector<GeoCoordinate> simplifyRing(const std::vector<GeoCoordinate> &coordinates) const {
+    if (coordinates.size() < 4)
+      return coordinates;
+
+    bool isClosed = coordinates.front()==coordinates.back();
+    std::vector<GeoCoordinate> ring = coordinates;
+    if (!isClosed)
+      ring.push_back(coordinates.front());
+
+    auto result = utymap::utils::simplify(ring, tolerance_, longitudeScale_);
+    if (!isClosed)
+      result.pop_back();
+
+    std::size_t minSize = isClosed ? 4 : 3;
+    if (result.size() < minSize ||
+        utymap::utils::isClockwise(result)!=utymap::utils::isClockwise(coordinates))
+      return coordinates;
+
+    return result;
+  }
+
+  const double tolerance_;
+  const double longitudeScale_;
+  std::shared_ptr<Element> result_;
+};
+
+/// Max amount of clippers kept per thread.
+const std::size_t MaxCachedClippers = 1024;
+
+/// Returns clipper of quad key with given callback. Clippers are kept between calls on the
+/// same thread, so their buffers are reused by next elements.
+utymap::index::ElementGeometryClipper &getClipper(const QuadKey &quadKey,
+                                                  const BoundingBox &quadKeyBbox,
+                                                  const utymap::index::ElementGeometryClipper::Callback &callback) {
+  using Clippers = std::unordered_map<QuadKey, std::unique_ptr<utymap::index::ElementGeometryClipper>, QuadKey::Hash>;
+  thread_local Clippers clippers;
+
+  auto clipper = clippers.find(quadKey);
+  if (clipper == clippers.end()) {
+    if (clippers.size() >= MaxCachedClippers)
+      clippers.clear();
+    clipper = clippers.emplace(quadKey, utymap::utils::make_unique<utymap::index::ElementGeometryClipper>(
+      quadKey, quadKeyBbox, callback)).first;
+  } else
+    clipper->second->setCallback(callback);
+  return *clipper->second;
+}
+
+/// Counts visited elements.
+struct ElementCounter final : public ElementVisitor {
+  std::size_t count = 0;
+
+  void visitNode(const Node &) override { ++count; }
+  void visitWay(const Way &) override { ++count; }
+  void visitArea(const Area &) override { ++count; }
+  void visitRelation(const Relation &) override { ++count; }
+};
 }
 
 namespace utymap {
@@ -25,7 +144,51 @@ namespace index {
 
 ElementStore::ElementStore(const StringTable &stringTable) :
     clipKeyId_(stringTable.getId(StyleConsts::ClipKey())),
-    skipKeyId_(stringTable.getId(StyleConsts::SkipKey())) {
+    skipKeyId_(stringTable.getId(StyleConsts::SkipKey())),
+    simplifyKeyId_(stringTable.getId(StyleConsts::SimplifyKey())),
+    statistics_(nullptr),
+    isHierarchicalClipping_(false) {
+}
+
+void ElementStore::search(const std::string &notTerms,
+                          const std::string &andTerms,
+                          const std::string &orTerms,
+                          const utymap::BoundingBox &bbox,
+                          const utymap::LodRange &range,
+                          std::size_t offset,
+                          std::size_t limit,
+                          ElementVisitor &visitor,
+                          const utymap::CancellationToken &cancelToken) {
+  ElementVisitorLimit page(visitor, offset, limit);
+  search(notTerms, andTerms, orTerms, bbox, range, page, cancelToken);
+}
+
+std::size_t ElementStore::count(const std::string &notTerms,
+                                const std::string &andTerms,
+                                const std::string &orTerms,
+                                const utymap::BoundingBox &bbox,
+                                const utymap::LodRange &range,
+                                std::size_t maxCount,
+                                const utymap::CancellationToken &cancelToken) {
+  ElementCounter counter;
+  search(notTerms, andTerms, orTerms, bbox, range, 0, maxCount, counter, cancelToken);
+  return counter.count;
+}
+
+std::unique_ptr<ElementCursor> ElementStore::openCursor(const std::string &notTerms,
+                                                        const std::string &andTerms,
+                                                        const std::string &orTerms,
+                                                        const utymap::BoundingBox &bbox,
+                                                        const utymap::LodRange &range) {
+  auto cursor = utymap::utils::make_unique<BufferedElementCursor>();
+  search(notTerms, andTerms, orTerms, bbox, range, *cursor, CancellationToken());
+  return std::move(cursor);
+}
+
+std::unique_ptr<ElementCursor> ElementStore::openCursor(const QuadKey &quadKey) {
+  auto cursor = utymap::utils::make_unique<BufferedElementCursor>();
+  search(quadKey, *cursor, CancellationToken());
+  return std::move(cursor);
 }
 
 bool ElementStore::store(const Element &element, const utymap::LodRange &range, const StyleProvider &styleProvider) {
@@ -57,50 +220,155 @@ bool ElementStore::store(const Element &element,
                });
 }
 
+bool ElementStore::storeClipped(const Element &element, const QuadKey &quadKey, const StyleProvider &styleProvider) {
+  using Clock = ImportStatistics::Clock;
+  using Phase = ImportStatistics::Phase;
+
+  auto styleStart = statistics_ != nullptr ? Clock::now() : Clock::time_point();
+  Style style = styleProvider.forElement(element, quadKey.levelOfDetail);
+  if (statistics_ != nullptr)
+    statistics_->addTime(Phase::Style, Clock::now() - styleStart);
+
+  if (style.empty() || style.has(skipKeyId_, TrueValue))
+    return false;
+
+  if (statistics_ == nullptr) {
+    save(element, quadKey);
+    return true;
+  }
+  auto writeStart = Clock::now();
+  save(element, quadKey);
+  statistics_->addTime(Phase::Write, Clock::now() - writeStart);
+  statistics_->addTile(quadKey);
+  return true;
+}
+
 template<typename Visitor>
 bool ElementStore::store(const Element &element,
                          const LodRange &range,
                          const StyleProvider &styleProvider,
                          const Visitor &visitor) {
+  using Clock = ImportStatistics::Clock;
+  using Phase = ImportStatistics::Phase;
+
+  // NOTE time of writes done by clipper is excluded from clip time.
+  Clock::duration writeTime(0);
+  auto write = [&](const Element &stored, const QuadKey &quadKey) {
+    if (statistics_ == nullptr) {
+      save(stored, quadKey);
+      return;
+    }
+    auto start = Clock::now();
+    save(stored, quadKey);
+    auto duration = Clock::now() - start;
+    writeTime += duration;
+    statistics_->addTime(Phase::Write, duration);
+    statistics_->addTile(quadKey);
+  };
+
+  using ClippedElements = std::unordered_map<utymap::QuadKey, std::shared_ptr<Element>, utymap::QuadKey::Hash>;
+
+  const ElementGeometryClipper::Callback callback = write;
   ElementGeometryVisitor bboxVisitor;
-  using namespace std::placeholders;
-  std::map<utymap::QuadKey, std::unique_ptr<ElementGeometryClipper>, utymap::QuadKey::Comparator> geometryClippers;
+  // NOTE in hierarchical mode, clipped elements of previous level are kept as source for their children.
+  ClippedElements parentElements, clippedElements;
+  int parentLod = -1;
   bool wasStored = false;
   for (int lod = range.start; lod <= range.end; ++lod) {
+    auto styleStart = statistics_ != nullptr ? Clock::now() : Clock::time_point();
     Style style = styleProvider.forElement(element, lod);
+    if (statistics_ != nullptr)
+      statistics_->addTime(Phase::Style, Clock::now() - styleStart);
+
     if (style.empty() || style.has(skipKeyId_, TrueValue))
       continue;
 
     // initialize bounding box only once
     if (!bboxVisitor.boundingBox.isValid())
-      element.accept(bboxVisitor);
+      dispatch(element, bboxVisitor);
+
+    // NOTE simplified element is not used as parent by next level which needs more details.
+    auto simplified = simplify(element, style, lod, bboxVisitor.boundingBox);
+    const Element &levelElement = simplified != nullptr ? *simplified : element;
+
+    bool isClipped = style.has(clipKeyId_, TrueValue);
+    bool isHierarchical = isHierarchicalClipping_ && isClipped && simplified == nullptr;
+    bool hasParents = isHierarchical && parentLod == lod - 1;
 
-    utymap::utils::GeoUtils::visitTileRange(bboxVisitor.boundingBox, lod,
+    utymap::utils::GeoUtils::visitTileRange(bboxVisitor.boundingBox, lod, utymap::utils::GeoUtils::TileOrder::Morton,
       [&](const QuadKey &quadKey, const BoundingBox &quadKeyBbox) {
         if (!visitor(bboxVisitor.boundingBox, quadKeyBbox))
           return;
 
-        if (style.has(clipKeyId_, TrueValue)) {
-          auto geometryClipperEntry = geometryClippers.find(quadKey);
-          if (geometryClipperEntry == geometryClippers.end()) {
-            geometryClipperEntry = geometryClippers.emplace(quadKey, utymap::utils::make_unique<ElementGeometryClipper>(
-              quadKey,
-              quadKeyBbox,
-              std::bind(&ElementStore::save, this, _1, _2))
-            ).first;
+        wasStored = true;
+        if (!isClipped) {
+          write(levelElement, quadKey);
+          return;
+        }
+
+        auto &geometryClipper = getClipper(quadKey, quadKeyBbox, callback);
+
+        if (!isHierarchical) {
+          if (statistics_ == nullptr) {
+            geometryClipper.clipAndCall(levelElement);
+          } else {
+            auto clipStart = Clock::now();
+            auto writeStart = writeTime;
+            geometryClipper.clipAndCall(levelElement);
+            statistics_->addTime(Phase::Clip, Clock::now() - clipStart - (writeTime - writeStart));
           }
-          geometryClipperEntry->second->clipAndCall(element);
+          return;
         }
-        else
-          save(element, quadKey);
 
-        wasStored = true;
+        // NOTE parent which was not clipped, e.g. filtered out, is replaced by original element.
+        const Element *source = &element;
+        if (hasParents) {
+          auto parent = parentElements.find(quadKey.parent());
+          if (parent != parentElements.end()) {
+            if (parent->second == nullptr)
+              return;
+            source = parent->second.get();
+          }
+        }
+
+        auto clipStart = statistics_ != nullptr ? Clock::now() : Clock::time_point();
+        auto clipped = geometryClipper.clip(*source);
+        if (statistics_ != nullptr)
+          statistics_->addTime(Phase::Clip, Clock::now() - clipStart);
+
+        clippedElements[quadKey] = clipped;
+        if (clipped != nullptr)
+          write(*clipped, quadKey);
       });
+
+    if (isHierarchical) {
+      parentElements.swap(clippedElements);
+      clippedElements.clear();
+      parentLod = lod;
+    }
   }
 
   // NOTE still might be clipped and then skipped
   return wasStored;
 }
 
+std::shared_ptr<Element> ElementStore::simplify(const Element &element,
+                                                const Style &style,
+                                                int levelOfDetail,
+                                                const BoundingBox &bbox) const {
+  if (!style.has(simplifyKeyId_))
+    return nullptr;
+
+  double pixels = utymap::utils::parseDouble(style.getString(simplifyKeyId_));
+  if (pixels <= 0)
+    return nullptr;
+
+  // NOTE distances are measured in degrees of latitude at element center where
+  // pixel of mercator tile has the same size along both axes.
+  double longitudeScale = std::cos(utymap::utils::deg2Rad(bbox.center().latitude));
+  double tolerance = pixels*360/(TileSize*std::pow(2., levelOfDetail))*longitudeScale;
+  return ElementSimplifier::simplify(element, tolerance, longitudeScale);
+}
+
 }
 }
@@ -7,8 +7,15 @@
 #include "QuadKey.hpp"
 #include "entities/Element.hpp"
 #include "entities/ElementVisitor.hpp"
+#include "index/ElementCursor.hpp"
+#include "index/ImportStatistics.hpp"
+#include "index/TileSummary.hpp"
 #include "mapcss/StyleProvider.hpp"
 
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+
 namespace utymap {
 namespace index {
 
@@ -28,14 +35,90 @@ class ElementStore {
                       utymap::entities::ElementVisitor &visitor,
                       const utymap::CancellationToken &cancelToken) = 0;
 
+  /// Searches for page of elements matches given query, bounding box and LOD range.
+  /// First offset matches are skipped and search stops once limit matches are visited.
+  /// Zero limit means no limit.
+  /// NOTE default implementation visits all matches, but passes only page to visitor.
+  virtual void search(const std::string &notTerms,
+                      const std::string &andTerms,
+                      const std::string &orTerms,
+                      const utymap::BoundingBox &bbox,
+                      const utymap::LodRange &range,
+                      std::size_t offset,
+                      std::size_t limit,
+                      utymap::entities::ElementVisitor &visitor,
+                      const utymap::CancellationToken &cancelToken);
+
+  /// Counts elements which match given query, bounding box and LOD range. Counting
+  /// stops once maxCount is reached, zero means no limit.
+  /// NOTE default implementation visits all matches.
+  virtual std::size_t count(const std::string &notTerms,
+                            const std::string &andTerms,
+                            const std::string &orTerms,
+                            const utymap::BoundingBox &bbox,
+                            const utymap::LodRange &range,
+                            std::size_t maxCount,
+                            const utymap::CancellationToken &cancelToken);
+
   /// Searches for elements for given quadKey
   virtual void search(const utymap::QuadKey &quadKey,
                       utymap::entities::ElementVisitor &visitor,
                       const utymap::CancellationToken &cancelToken) = 0;
 
+  /// Opens cursor over elements which match given query, bounding box and LOD range.
+  /// Elements are returned in the same order as search visits them.
+  /// NOTE default implementation collects all matches when cursor is opened.
+  virtual std::unique_ptr<ElementCursor> openCursor(const std::string &notTerms,
+                                                    const std::string &andTerms,
+                                                    const std::string &orTerms,
+                                                    const utymap::BoundingBox &bbox,
+                                                    const utymap::LodRange &range);
+
+  /// Opens cursor over elements of given quadKey.
+  /// NOTE default implementation collects all elements when cursor is opened.
+  virtual std::unique_ptr<ElementCursor> openCursor(const utymap::QuadKey &quadKey);
+
   /// Checks whether there is data for given quadkey.
   virtual bool hasData(const utymap::QuadKey &quadKey) const = 0;
 
+  /// Checks cheaply whether store might have data for given quadkey, so it can be
+  /// skipped without per tile work. False positives are allowed, false negatives are not.
+  /// NOTE store without coverage metadata always returns true.
+  virtual bool mayHaveData(const utymap::QuadKey &) const {
+    return true;
+  }
+
+  /// Checks cheaply whether store might have data in given bounding box and LOD range.
+  /// NOTE store without coverage metadata always returns true.
+  virtual bool mayHaveData(const utymap::BoundingBox &, const utymap::LodRange &) const {
+    return true;
+  }
+
+  /// Returns summary of elements stored in given quad key, so cost of building
+  /// its tile can be estimated without reading elements.
+  /// NOTE store which doesn't record summaries returns empty one.
+  virtual utymap::index::TileSummary getSummary(const utymap::QuadKey &) const {
+    return utymap::index::TileSummary();
+  }
+
+  /// Visits element with given id. Returns false if there is no such element.
+  /// NOTE element is stored in many quad keys: copy from quad key where it was
+  /// stored first is visited unless that quad key was erased since then.
+  /// Store without id index never finds element.
+  virtual bool searchById(std::uint64_t,
+                          utymap::entities::ElementVisitor &) {
+    return false;
+  }
+
+  /// Sets keys of tags which are indexed for text search, e.g. "name,addr:*".
+  /// Empty list means that all tags are indexed.
+  /// NOTE store without text index ignores it.
+  virtual void setSearchKeys(const std::string &) {}
+
+  /// Warms data of given quad keys in background, so their following search is faster.
+  /// NOTE store which has nothing to warm ignores it.
+  virtual void prefetch(const std::vector<utymap::QuadKey> &) {}
+
   /// Stores element in storage in all affected tiles at given level of details range.
   bool store(const utymap::entities::Element &element,
              const utymap::LodRange &range,
@@ -52,10 +135,36 @@ class ElementStore {
              const utymap::LodRange &range,
              const utymap::mapcss::StyleProvider &styleProvider);
 
+  /// Stores element which geometry is already clipped by given quadkey, e.g. feature of
+  /// vector tile, in the quadkey only without clipping it again.
+  bool storeClipped(const utymap::entities::Element &element,
+                    const utymap::QuadKey &quadKey,
+                    const utymap::mapcss::StyleProvider &styleProvider);
+
+  /// Sets statistics which collect time of style, clip and write phases of store
+  /// calls and written quad keys. Null disables collecting.
+  void setStatistics(utymap::index::ImportStatistics *statistics) {
+    statistics_ = statistics;
+  }
+
+  /// Enables hierarchical clipping: element stored at many levels of detail is clipped by
+  /// tile of previous level first and children tiles are clipped from its result, so every
+  /// level clips geometry which is already reduced.
+  void setHierarchicalClipping(bool enabled) {
+    isHierarchicalClipping_ = enabled;
+  }
+
   /// Saves element in given quadkey.
   virtual void save(const utymap::entities::Element &element,
                     const utymap::QuadKey &quadKey) = 0;
 
+  /// Starts batch of writes: storage may buffer saved elements until batch is committed.
+  /// Batches can be nested, data is written when the outermost batch is committed.
+  virtual void beginBatch() {}
+
+  /// Commits batch of writes started by beginBatch.
+  virtual void commitBatch() {}
+
   /// Erases all data for given quad key.
   virtual void erase(const utymap::QuadKey &quadKey) = 0;
 
@@ -63,6 +172,14 @@ class ElementStore {
   virtual void erase(const utymap::BoundingBox &bbox,
                      const utymap::LodRange &range) = 0;
 
+  /// Erases all copies of elements with given ids stored in quad keys of given LOD range.
+  /// Returns quad keys which had such elements.
+  /// NOTE every quad key of range is checked, so ids should be erased in one call.
+  virtual std::vector<utymap::QuadKey> erase(const std::unordered_set<std::uint64_t> &,
+                                             const utymap::LodRange &) {
+    throw std::domain_error("Deletion by element id is not implemented.");
+  }
+
  private:
   template<typename Visitor>
   bool store(const utymap::entities::Element &element,
@@ -70,7 +187,15 @@ class ElementStore {
              const utymap::mapcss::StyleProvider &styleProvider,
              const Visitor &visitor);
 
-  const std::uint32_t clipKeyId_, skipKeyId_;
+  /// Returns copy of element simplified according to style or nullptr if style has no simplification.
+  std::shared_ptr<utymap::entities::Element> simplify(const utymap::entities::Element &element,
+                                                      const utymap::mapcss::Style &style,
+                                                      int levelOfDetail,
+                                                      const utymap::BoundingBox &bbox) const;
+
+  const std::uint32_t clipKeyId_, skipKeyId_, simplifyKeyId_;
+  utymap::index::ImportStatistics *statistics_;
+  bool isHierarchicalClipping_;
 };
 
 }
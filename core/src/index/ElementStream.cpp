@@ -1,142 +1,257 @@
 #include "GeoCoordinate.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 #include "index/ElementStream.hpp"
+#include "math/FixedPoint.hpp"
 #include "utils/CoreUtils.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
 using namespace utymap;
 using namespace utymap::entities;
 using namespace utymap::index;
+using namespace utymap::math;
 
 namespace {
 
-const char NodeType = 0;
-const char WayType = 1;
-const char AreaType = 2;
-const char RelationType = 3;
+const std::uint8_t NodeType = 0;
+const std::uint8_t WayType = 1;
+const std::uint8_t AreaType = 2;
+const std::uint8_t RelationType = 3;
+/// Relation member which is stored as separate element in the same container: only its
+/// order is written. Used only by v2 format.
+const std::uint8_t ReferenceType = 4;
 
-std::ostream &operator<<(std::ostream &stream, const Tag &tag) {
-  stream.write(reinterpret_cast<const char *>(&tag.key), sizeof(tag.key));
-  stream.write(reinterpret_cast<const char *>(&tag.value), sizeof(tag.value));
-  return stream;
-}
+/// Element header flag: element is encoded with compact v2 format.
+/// v1 format: raw uint16 lengths, raw uint32 tag ids and raw double coordinates.
+/// v2 format: varint lengths and tag ids, zigzag varint fixed point coordinates
+/// delta encoded inside element.
+const std::uint8_t CompactFlag = 0x80;
+/// Element header flag: v2 element keeps raw double coordinates as some of them
+/// cannot be represented as fixed point value.
+const std::uint8_t RawCoordinatesFlag = 0x40;
+const std::uint8_t TypeMask = 0x0F;
 
-std::istream &operator>>(std::istream &stream, Tag &tag) {
-  stream.read(reinterpret_cast<char *>(&tag.key), sizeof(tag.key));
-  stream.read(reinterpret_cast<char *>(&tag.value), sizeof(tag.value));
-  return stream;
-}
-
-std::ostream &operator<<(std::ostream &stream, const utymap::GeoCoordinate &coordinate) {
-  stream.write(reinterpret_cast<const char *>(&coordinate.latitude), sizeof(coordinate.latitude));
-  stream.write(reinterpret_cast<const char *>(&coordinate.longitude), sizeof(coordinate.longitude));
-  return stream;
-}
+/// Max absolute value of coordinate which fits fixed point int32.
+const double MaxFixedCoordinate = std::numeric_limits<std::int32_t>::max() / FixedPointScale;
 
-std::istream &operator>>(std::istream &stream, utymap::GeoCoordinate &coordinate) {
-  stream.read(reinterpret_cast<char *>(&coordinate.latitude), sizeof(coordinate.latitude));
-  stream.read(reinterpret_cast<char *>(&coordinate.longitude), sizeof(coordinate.longitude));
-  return stream;
+std::uint64_t zigzag(std::int64_t value) {
+  return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
 }
 
-template<typename T>
-std::ostream &operator<<(std::ostream &stream, const std::vector<T> &data) {
-  std::uint16_t size = static_cast<std::uint16_t>(data.size());
-  stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
-  for (const auto &item : data)
-    stream << item;
-  return stream;
+std::int64_t unzigzag(std::uint64_t value) {
+  return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
 }
 
-template<typename T>
-std::istream &operator>>(std::istream &stream, std::vector<T> &data) {
-  std::uint16_t size = 0;
-  stream.read(reinterpret_cast<char *>(&size), sizeof(size));
-  data.resize(size);
-  for (size_t i = 0; i < size; ++i)
-    stream >> data[i];
-  return stream;
+bool canBeFixed(const GeoCoordinate &coordinate) {
+  return std::abs(coordinate.latitude) <= MaxFixedCoordinate &&
+      std::abs(coordinate.longitude) <= MaxFixedCoordinate;
 }
 
-/// Writes element to stream.
-struct ElementWriter : ElementVisitor {
-  explicit ElementWriter(std::ostream &s) : stream_(s) {}
+/// Writes element to stream using compact v2 format.
+struct ElementWriter final : ElementVisitor {
+  ElementWriter(std::ostream &s, const ElementStream::MemberResolver &memberResolver) :
+      stream_(s), memberResolver_(memberResolver) {}
 
   void visitNode(const Node &node) override {
-    stream_ << NodeType << node.tags << node.coordinate;
+    bool isFixed = canBeFixed(node.coordinate);
+    writeHeader(NodeType, isFixed);
+    writeTags(node.tags);
+    if (isFixed) {
+      writeVarint(zigzag(toFixed(node.coordinate.latitude)));
+      writeVarint(zigzag(toFixed(node.coordinate.longitude)));
+    }
+    else
+      writeRawCoordinate(node.coordinate);
   }
 
   void visitWay(const Way &way) override {
-    stream_ << WayType << way.tags << way.coordinates;
+    writeCoordinates(WayType, way.tags, way.coordinates);
   }
 
   void visitArea(const Area &area) override {
-    stream_ << AreaType << area.tags << area.coordinates;
+    writeCoordinates(AreaType, area.tags, area.coordinates);
   }
 
   void visitRelation(const Relation &relation) override {
-    stream_ << RelationType << relation.tags;
-    auto size = static_cast<std::uint16_t>(relation.elements.size());
-    stream_.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    writeHeader(RelationType, true);
+    writeTags(relation.tags);
+    writeVarint(relation.elements.size());
     for (const auto &element : relation.elements) {
-      stream_.write(reinterpret_cast<const char *>(&element->id), sizeof(element->id));
-      element->accept(*this);
+      writeVarint(element->id);
+      std::uint32_t order;
+      if (memberResolver_ && memberResolver_(*element, order)) {
+        writeHeader(ReferenceType, true);
+        writeVarint(order);
+      } else
+        dispatch(*element, *this);
     }
   }
 
+ private:
+  void writeHeader(std::uint8_t type, bool isFixed) {
+    auto header = static_cast<std::uint8_t>(type | CompactFlag | (isFixed ? 0 : RawCoordinatesFlag));
+    stream_.put(static_cast<char>(header));
+  }
+
+  void writeTags(const std::vector<Tag> &tags) {
+    writeVarint(tags.size());
+    for (const auto &tag : tags) {
+      writeVarint(tag.key);
+      writeVarint(tag.value);
+    }
+  }
+
+  void writeCoordinates(std::uint8_t type, const std::vector<Tag> &tags, const std::vector<GeoCoordinate> &coordinates) {
+    bool isFixed = std::all_of(coordinates.begin(), coordinates.end(), canBeFixed);
+    writeHeader(type, isFixed);
+    writeTags(tags);
+    writeVarint(coordinates.size());
+
+    if (!isFixed) {
+      for (const auto &coordinate : coordinates)
+        writeRawCoordinate(coordinate);
+      return;
+    }
+
+    std::int64_t lastLatitude = 0, lastLongitude = 0;
+    for (const auto &coordinate : coordinates) {
+      std::int64_t latitude = toFixed(coordinate.latitude);
+      std::int64_t longitude = toFixed(coordinate.longitude);
+      writeVarint(zigzag(latitude - lastLatitude));
+      writeVarint(zigzag(longitude - lastLongitude));
+      lastLatitude = latitude;
+      lastLongitude = longitude;
+    }
+  }
+
+  void writeRawCoordinate(const GeoCoordinate &coordinate) {
+    stream_.write(reinterpret_cast<const char *>(&coordinate.latitude), sizeof(coordinate.latitude));
+    stream_.write(reinterpret_cast<const char *>(&coordinate.longitude), sizeof(coordinate.longitude));
+  }
+
+  void writeVarint(std::uint64_t value) {
+    char buffer[10];
+    int size = 0;
+    while (value >= 0x80) {
+      buffer[size++] = static_cast<char>((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    buffer[size++] = static_cast<char>(value);
+    stream_.write(buffer, size);
+  }
+
   std::ostream &stream_;
+  const ElementStream::MemberResolver &memberResolver_;
+};
+
+/// Reads element data from memory buffer.
+class MemoryStream final {
+ public:
+  MemoryStream(const char *data, std::size_t size) :
+      data_(data), size_(size), position_(0) {}
+
+  void read(char *destination, std::size_t count) {
+    if (position_ + count > size_)
+      throw std::domain_error("Unexpected end of element data.");
+    std::memcpy(destination, data_ + position_, count);
+    position_ += count;
+  }
+
+  /// NOTE read throws on error, so stream is always valid.
+  explicit operator bool() const {
+    return true;
+  }
+
+ private:
+  const char *data_;
+  const std::size_t size_;
+  std::size_t position_;
 };
 
-/// Reads element from stream.
+/// Reads element from stream. Supports both v1 and v2 formats.
+template<typename Stream>
 class ElementReader final {
  public:
-  explicit ElementReader(std::istream &stream) : stream_(stream) {
+  ElementReader(Stream &stream, const ElementStream::MemberReader &memberReader) :
+      stream_(stream), memberReader_(memberReader) {
   }
 
   std::unique_ptr<Element> read() const {
-    char elementType;
-    stream_ >> elementType;
-
-    switch (elementType) {
-      case NodeType:return readNode();
-      case WayType:return readWay();
-      case AreaType:return readArea();
-      case RelationType:return readRelation();
+    std::uint8_t header;
+    readRaw(header);
+
+    Format format = (header & CompactFlag) == 0
+      ? Format::V1
+      : ((header & RawCoordinatesFlag) == 0 ? Format::Fixed : Format::Raw);
+
+    switch (header & TypeMask) {
+      case NodeType:return readNode(format);
+      case WayType:return readWithCoordinates<Way>(format);
+      case AreaType:return readWithCoordinates<Area>(format);
+      case RelationType:return readRelation(format);
+      case ReferenceType:return readReference(format);
       default:throw std::domain_error("Unknown element type.");
     }
   }
 
  private:
-  std::unique_ptr<Node> readNode() const {
+  /// Specifies element encoding.
+  enum class Format { V1, Fixed, Raw };
+
+  std::unique_ptr<Node> readNode(Format format) const {
     auto node = utymap::utils::make_unique<Node>();
-    stream_ >> node->tags >> node->coordinate;
+    readTags(format, node->tags);
+    if (format == Format::Fixed) {
+      node->coordinate.latitude = fromFixed(static_cast<std::int32_t>(unzigzag(readVarint())));
+      node->coordinate.longitude = fromFixed(static_cast<std::int32_t>(unzigzag(readVarint())));
+    }
+    else
+      readRawCoordinate(node->coordinate);
     return std::move(node);
   }
 
-  std::unique_ptr<Way> readWay() const {
-    auto way = utymap::utils::make_unique<Way>();
-    stream_ >> way->tags >> way->coordinates;
-    return std::move(way);
-  }
+  template<typename T>
+  std::unique_ptr<T> readWithCoordinates(Format format) const {
+    auto element = utymap::utils::make_unique<T>();
+    readTags(format, element->tags);
+
+    std::size_t size = readSize(format);
+    element->coordinates.resize(size);
 
-  std::unique_ptr<Area> readArea() const {
-    auto area = utymap::utils::make_unique<Area>();
-    stream_ >> area->tags >> area->coordinates;
-    return std::move(area);
+    if (format != Format::Fixed) {
+      for (std::size_t i = 0; i < size; ++i)
+        readRawCoordinate(element->coordinates[i]);
+      return std::move(element);
+    }
+
+    std::int64_t latitude = 0, longitude = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      latitude += unzigzag(readVarint());
+      longitude += unzigzag(readVarint());
+      element->coordinates[i].latitude = fromFixed(static_cast<std::int32_t>(latitude));
+      element->coordinates[i].longitude = fromFixed(static_cast<std::int32_t>(longitude));
+    }
+    return std::move(element);
   }
 
-  std::unique_ptr<Relation> readRelation() const {
+  std::unique_ptr<Relation> readRelation(Format format) const {
     auto relation = utymap::utils::make_unique<Relation>();
-    stream_ >> relation->tags;
-
-    std::uint16_t elementSize = 0;
-    stream_.read(reinterpret_cast<char *>(&elementSize), sizeof(elementSize));
+    readTags(format, relation->tags);
 
-    for (std::uint16_t i = 0; i < elementSize; ++i) {
+    std::size_t elementSize = readSize(format);
+    for (std::size_t i = 0; i < elementSize; ++i) {
       std::uint64_t id;
-      stream_.read(reinterpret_cast<char *>(&id), sizeof(id));
+      if (format == Format::V1)
+        readRaw(id);
+      else
+        id = readVarint();
       auto element = read();
       element->id = id;
       relation->elements.push_back(std::move(element));
@@ -144,18 +259,89 @@ class ElementReader final {
     return relation;
   }
 
-  std::istream &stream_;
+  std::unique_ptr<Element> readReference(Format format) const {
+    if (format != Format::Fixed)
+      throw std::domain_error("Unexpected member reference.");
+    if (!memberReader_)
+      throw std::domain_error("Cannot resolve member reference.");
+    return memberReader_(static_cast<std::uint32_t>(readVarint()));
+  }
+
+  void readTags(Format format, std::vector<Tag> &tags) const {
+    std::size_t size = readSize(format);
+    tags.resize(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      if (format == Format::V1) {
+        readRaw(tags[i].key);
+        readRaw(tags[i].value);
+      } else {
+        tags[i].key = static_cast<std::uint32_t>(readVarint());
+        tags[i].value = static_cast<std::uint32_t>(readVarint());
+      }
+    }
+  }
+
+  std::size_t readSize(Format format) const {
+    if (format != Format::V1)
+      return static_cast<std::size_t>(readVarint());
+
+    std::uint16_t size = 0;
+    readRaw(size);
+    return size;
+  }
+
+  void readRawCoordinate(GeoCoordinate &coordinate) const {
+    readRaw(coordinate.latitude);
+    readRaw(coordinate.longitude);
+  }
+
+  std::uint64_t readVarint() const {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      std::uint8_t byte;
+      readRaw(byte);
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return value;
+    }
+    throw std::domain_error("Malformed varint in element data.");
+  }
+
+  template<typename T>
+  void readRaw(T &value) const {
+    stream_.read(reinterpret_cast<char *>(&value), sizeof(value));
+    if (!stream_)
+      throw std::domain_error("Unexpected end of element data.");
+  }
+
+  Stream &stream_;
+  const ElementStream::MemberReader &memberReader_;
 };
-}
 
-std::unique_ptr<utymap::entities::Element> ElementStream::read(std::istream &stream, std::uint64_t id) {
-  auto reader = ElementReader(stream);
-  auto element = reader.read();
+template<typename Stream>
+std::unique_ptr<Element> readElement(Stream &stream, std::uint64_t id, const ElementStream::MemberReader &memberReader) {
+  auto element = ElementReader<Stream>(stream, memberReader).read();
   element->id = id;
   return element;
 }
 
-void ElementStream::write(std::ostream &stream, const utymap::entities::Element &element) {
-  auto writer = ElementWriter(stream);
-  element.accept(writer);
+}
+
+std::unique_ptr<utymap::entities::Element> ElementStream::read(std::istream &stream, std::uint64_t id) {
+  return readElement(stream, id, nullptr);
+}
+
+std::unique_ptr<utymap::entities::Element> ElementStream::read(const char *data,
+                                                               std::size_t size,
+                                                               std::uint64_t id,
+                                                               const MemberReader &memberReader) {
+  MemoryStream stream(data, size);
+  return readElement(stream, id, memberReader);
+}
+
+void ElementStream::write(std::ostream &stream,
+                          const utymap::entities::Element &element,
+                          const MemberResolver &memberResolver) {
+  ElementWriter writer(stream, memberResolver);
+  dispatch(element, writer);
 }
@@ -3,19 +3,40 @@
 
 #include "entities/Element.hpp"
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <iostream>
 
 namespace utymap {
 namespace index {
 
+/// Provides the way to store element in stream and restore it back.
+/// Elements are written in compact v2 format, v1 format is still readable.
+/// Relation member can be written as reference to element stored in the same container
+/// instead of its copy: reference keeps member id and order of element in container.
 class ElementStream final {
  public:
+  /// Returns true and order of stored element which is the same as given relation member.
+  using MemberResolver = std::function<bool(const utymap::entities::Element &, std::uint32_t &)>;
+  /// Reads stored element with given order which is referenced by relation.
+  using MemberReader = std::function<std::unique_ptr<utymap::entities::Element>(std::uint32_t)>;
+
   /// Reads element with given id from input stream.
   static std::unique_ptr<utymap::entities::Element> read(std::istream &stream, std::uint64_t id);
 
-  /// Writes element to output stream.
-  static void write(std::ostream &stream, const utymap::entities::Element &element);
+  /// Reads element with given id from memory buffer of given size.
+  /// NOTE throws if element has member references and reader is not set.
+  static std::unique_ptr<utymap::entities::Element> read(const char *data,
+                                                         std::size_t size,
+                                                         std::uint64_t id,
+                                                         const MemberReader &memberReader = nullptr);
+
+  /// Writes element to output stream. Relation members are written as references when
+  /// resolver finds them, otherwise they are inlined.
+  static void write(std::ostream &stream,
+                    const utymap::entities::Element &element,
+                    const MemberResolver &memberResolver = nullptr);
 };
 
 }
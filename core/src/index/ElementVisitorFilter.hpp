@@ -3,6 +3,7 @@
 
 #include "BoundingBox.hpp"
 #include "QuadKey.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
@@ -15,7 +16,7 @@ namespace utymap {
 namespace index {
 
 /// Provides the way to visit elements with filtering.
-class ElementVisitorFilter : public utymap::entities::ElementVisitor {
+class ElementVisitorFilter final : public utymap::entities::ElementVisitor {
  public:
 
   using Filter = std::function<bool(const utymap::entities::Element&)>;
@@ -42,7 +43,7 @@ class ElementVisitorFilter : public utymap::entities::ElementVisitor {
  private:
   void visit(const utymap::entities::Element &element) {
     if (predicate_(element)) {
-      element.accept(visitor_);
+      utymap::entities::dispatch(element, visitor_);
     }
   }
 
@@ -0,0 +1,71 @@
+#ifndef INDEX_ELEMENTVISITORLIMIT_HPP_DEFINED
+#define INDEX_ELEMENTVISITORLIMIT_HPP_DEFINED
+
+#include "entities/ElementDispatch.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "entities/ElementVisitor.hpp"
+
+#include <cstdint>
+
+namespace utymap {
+namespace index {
+
+/// Provides the way to visit page of elements: first offset elements are skipped
+/// and at most limit elements are passed to visitor. Zero limit means no limit.
+class ElementVisitorLimit final : public utymap::entities::ElementVisitor {
+ public:
+  ElementVisitorLimit(utymap::entities::ElementVisitor &visitor,
+                      std::size_t offset,
+                      std::size_t limit) :
+      visitor_(visitor), offset_(offset), limit_(limit), skipped_(0), visited_(0) { }
+
+  void visitNode(const utymap::entities::Node &node) override {
+    visit(node);
+  }
+
+  void visitWay(const utymap::entities::Way &way) override {
+    visit(way);
+  }
+
+  void visitArea(const utymap::entities::Area &area) override {
+    visit(area);
+  }
+
+  void visitRelation(const utymap::entities::Relation &relation) override {
+    visit(relation);
+  }
+
+  /// Returns true if limit is reached, so no more elements are needed.
+  bool isFull() const {
+    return limit_ > 0 && visited_ >= limit_;
+  }
+
+  /// Returns amount of elements which still should be found to fill page or zero if there is no limit.
+  std::size_t remaining() const {
+    return limit_ > 0 ? offset_ - skipped_ + limit_ - visited_ : 0;
+  }
+
+ private:
+  void visit(const utymap::entities::Element &element) {
+    if (skipped_ < offset_)
+      ++skipped_;
+    else if (!isFull()) {
+      ++visited_;
+      utymap::entities::dispatch(element, visitor_);
+    }
+  }
+
+  utymap::entities::ElementVisitor &visitor_;
+  const std::size_t offset_;
+  const std::size_t limit_;
+  std::size_t skipped_;
+  std::size_t visited_;
+};
+
+}
+}
+
+#endif //INDEX_ELEMENTVISITORLIMIT_HPP_DEFINED
@@ -0,0 +1,54 @@
+#ifndef INDEX_ELEMENTVISITORUNIQUE_HPP_DEFINED
+#define INDEX_ELEMENTVISITORUNIQUE_HPP_DEFINED
+
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "entities/ElementVisitor.hpp"
+
+#include <cstdint>
+#include <unordered_set>
+
+namespace utymap {
+namespace index {
+
+/// Provides the way to visit every element only once: copies of element with the same
+/// type and id, e.g. stored in many quad keys or lods, are skipped.
+class ElementVisitorUnique : public utymap::entities::ElementVisitor {
+ public:
+  explicit ElementVisitorUnique(utymap::entities::ElementVisitor &visitor) :
+      visitor_(visitor) { }
+
+  void visitNode(const utymap::entities::Node &node) override {
+    if (nodes_.insert(node.id).second)
+      visitor_.visitNode(node);
+  }
+
+  void visitWay(const utymap::entities::Way &way) override {
+    if (ways_.insert(way.id).second)
+      visitor_.visitWay(way);
+  }
+
+  void visitArea(const utymap::entities::Area &area) override {
+    if (areas_.insert(area.id).second)
+      visitor_.visitArea(area);
+  }
+
+  void visitRelation(const utymap::entities::Relation &relation) override {
+    if (relations_.insert(relation.id).second)
+      visitor_.visitRelation(relation);
+  }
+
+ private:
+  utymap::entities::ElementVisitor &visitor_;
+  std::unordered_set<std::uint64_t> nodes_;
+  std::unordered_set<std::uint64_t> ways_;
+  std::unordered_set<std::uint64_t> areas_;
+  std::unordered_set<std::uint64_t> relations_;
+};
+
+}
+}
+
+#endif //INDEX_ELEMENTVISITORUNIQUE_HPP_DEFINED
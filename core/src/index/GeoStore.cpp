@@ -1,5 +1,11 @@
+#include "entities/ElementDispatch.hpp"
 #include "entities/Element.hpp"
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
 #include "LodRange.hpp"
+#include "formats/mvt/MvtParser.hpp"
 #include "formats/shape/ShapeDataVisitor.hpp"
 #include "formats/shape/ShapeParser.hpp"
 #include "formats/osm/json/OsmJsonParser.hpp"
@@ -7,22 +13,331 @@
 #ifdef PBF_SUPPORTED_ENABLED
 #include "formats/osm/pbf/OsmPbfParser.hpp"
 #endif
+#include "index/ElementGeometryVisitor.hpp"
+#include "index/ElementVisitorLimit.hpp"
 #include "index/GeoStore.hpp"
 #include "index/InMemoryElementStore.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
 
 using namespace utymap::entities;
 using namespace utymap::formats;
 using namespace utymap::index;
 using namespace utymap::mapcss;
 
+namespace {
+/// Padding of bounding box used to drop data while parsing, in fraction of its size.
+const double BoundingBoxPadding = 0.1;
+
+/// Keeps batch of writes of element store open while in scope.
+class BatchScope final {
+ public:
+  explicit BatchScope(ElementStore &elementStore) : elementStore_(elementStore) {
+    elementStore_.beginBatch();
+  }
+
+  ~BatchScope() {
+    elementStore_.commitBatch();
+  }
+
+ private:
+  ElementStore &elementStore_;
+};
+
+/// Collects statistics of import into element store and reports them to progress callback.
+/// NOTE nothing is collected if callback is not set.
+class ImportTracker final {
+  /// Amount of parsed elements between progress reports.
+  const static std::uint64_t ReportInterval = 10000;
+  using Clock = ImportStatistics::Clock;
+  using Phase = ImportStatistics::Phase;
+
+ public:
+  /// Tracks progress of single file. Elapsed time which is not spent in element
+  /// functor is considered as parse time.
+  class File final {
+   public:
+    File(ImportTracker &tracker, const std::string &path) :
+        tracker_(tracker), path_(path), stream_(nullptr), position_(0),
+        mark_(Clock::now()), functorTime_(0) {
+    }
+
+    ~File() {
+      if (!tracker_.isActive()) return;
+      // NOTE stream may be already closed, so whole file is considered as parsed.
+      auto size = getFileSize(path_);
+      if (size > position_)
+        tracker_.statistics_.bytesParsed += size - position_;
+      updateParseTime();
+      tracker_.report();
+    }
+
+    /// Sets stream which position is used as amount of parsed bytes.
+    void setStream(std::istream &stream) {
+      stream_ = &stream;
+    }
+
+    std::function<bool(Element &)> wrap(const std::function<bool(Element &)> &functor) {
+      if (!tracker_.isActive()) return functor;
+
+      return [this, functor](Element &element) {
+        auto start = Clock::now();
+        bool isStored = functor(element);
+        functorTime_ += Clock::now() - start;
+
+        auto &statistics = tracker_.statistics_;
+        if (isStored) ++statistics.elementsStored;
+        if (++statistics.elementsParsed % ReportInterval == 0) {
+          updatePosition();
+          updateParseTime();
+          tracker_.report();
+        }
+        return isStored;
+      };
+    }
+
+   private:
+    void updatePosition() {
+      if (stream_ == nullptr) return;
+      auto position = stream_->tellg();
+      if (position < 0 || static_cast<std::uint64_t>(position) <= position_) return;
+      tracker_.statistics_.bytesParsed += static_cast<std::uint64_t>(position) - position_;
+      position_ = static_cast<std::uint64_t>(position);
+    }
+
+    void updateParseTime() {
+      auto now = Clock::now();
+      tracker_.statistics_.addTime(Phase::Parse, now - mark_ - functorTime_);
+      mark_ = now;
+      functorTime_ = Clock::duration(0);
+    }
+
+    ImportTracker &tracker_;
+    const std::string path_;
+    std::istream *stream_;
+    std::uint64_t position_;
+    Clock::time_point mark_;
+    Clock::duration functorTime_;
+  };
+
+  ImportTracker(ElementStore &elementStore,
+                const std::vector<std::string> &paths,
+                const GeoStore::ProgressCallback &callback) :
+      elementStore_(elementStore), callback_(callback) {
+    if (!isActive()) return;
+    for (const auto &path : paths)
+      statistics_.bytesTotal += getFileSize(path);
+    elementStore_.setStatistics(&statistics_);
+  }
+
+  ~ImportTracker() {
+    if (isActive())
+      elementStore_.setStatistics(nullptr);
+  }
+
+ private:
+  bool isActive() const {
+    return static_cast<bool>(callback_);
+  }
+
+  /// Calls callback with current statistics. Calls from import threads are serialized.
+  void report() {
+    std::lock_guard<std::mutex> lock(lock_);
+    callback_(statistics_.snapshot());
+  }
+
+  /// Returns size of file or shapefile records, zero if it is not found.
+  static std::uint64_t getFileSize(const std::string &path) {
+    for (const auto &candidate : { path, path + ".shp", path + ".SHP" }) {
+      boost::system::error_code error;
+      if (boost::filesystem::is_regular_file(candidate, error))
+        return boost::filesystem::file_size(candidate, error);
+    }
+    return 0;
+  }
+
+  ElementStore &elementStore_;
+  const GeoStore::ProgressCallback &callback_;
+  ImportStatistics statistics_;
+  std::mutex lock_;
+};
+
+/// Keeps amount of elements of file which are already passed to element store, so interrupted
+/// import which is started again with the same arguments skips them instead of storing them again.
+/// Store batch is committed before checkpoint is saved, so checkpoint never refers to lost data.
+/// NOTE elements are expected to be visited in the same order by every import of unchanged file.
+class ImportCheckpoint final {
+  /// Amount of elements between checkpoints.
+  const static std::uint64_t Interval = 50000;
+
+ public:
+  /// Creates checkpoint of import described by given key. Empty directory disables it.
+  ImportCheckpoint(ElementStore &elementStore,
+                   const std::string &directory,
+                   const std::string &path,
+                   const std::string &key) :
+      elementStore_(elementStore), checkpointPath_(), stamp_(0), skip_(0), count_(0) {
+    if (directory.empty()) return;
+
+    boost::filesystem::path sourcePath(path);
+    for (const auto &candidate : { path, path + ".shp", path + ".SHP" }) {
+      boost::system::error_code error;
+      if (boost::filesystem::is_regular_file(candidate, error)) {
+        sourcePath = candidate;
+        break;
+      }
+    }
+    stamp_ = boost::filesystem::file_size(sourcePath);
+    stamp_ = stamp_ * 31 + static_cast<std::uint64_t>(boost::filesystem::last_write_time(sourcePath));
+    stamp_ = stamp_ * 31 + std::hash<std::string>()(key);
+
+    checkpointPath_ = (boost::filesystem::path(directory) / sourcePath.filename()).string() +
+        "." + utymap::utils::toString(std::hash<std::string>()(key)) + ".checkpoint";
+    load();
+  }
+
+  bool isActive() const {
+    return !checkpointPath_.empty();
+  }
+
+  /// Returns amount of elements which were stored by previous interrupted import.
+  std::uint64_t skipped() const {
+    return skip_;
+  }
+
+  /// Wraps element functor to skip elements stored before and to save checkpoints periodically.
+  std::function<bool(Element &)> wrap(const std::function<bool(Element &)> &functor) {
+    if (!isActive()) return functor;
+
+    return [this, functor](Element &element) {
+      if (++count_ <= skip_) return false;
+      bool isStored = functor(element);
+      if (count_ % Interval == 0) {
+        elementStore_.commitBatch();
+        elementStore_.beginBatch();
+        save();
+      }
+      return isStored;
+    };
+  }
+
+  /// Saves position of interrupted import or removes checkpoint of finished one.
+  /// NOTE should be called once store batch is committed.
+  void complete(bool isCancelled) {
+    if (!isActive()) return;
+
+    if (isCancelled) {
+      save();
+      return;
+    }
+    boost::system::error_code error;
+    boost::filesystem::remove(checkpointPath_, error);
+  }
+
+ private:
+  void load() {
+    std::ifstream file(checkpointPath_);
+    std::uint64_t stamp = 0, count = 0;
+    if (file >> stamp >> count && stamp == stamp_)
+      skip_ = count;
+  }
+
+  void save() const {
+    // NOTE checkpoint is replaced at once, so interrupted write keeps previous one.
+    auto tmpPath = checkpointPath_ + ".tmp";
+    {
+      std::ofstream file(tmpPath, std::ios::trunc);
+      file << stamp_ << " " << std::max(count_, skip_);
+    }
+    boost::filesystem::rename(tmpPath, checkpointPath_);
+  }
+
+  ElementStore &elementStore_;
+  std::string checkpointPath_;
+  std::uint64_t stamp_;
+  std::uint64_t skip_;
+  std::uint64_t count_;
+};
+
+/// Keeps copies of visited elements to replay them later in the same order.
+class ElementBuffer final : public ElementVisitor {
+ public:
+  void visitNode(const Node &node) override {
+    elements_.push_back(std::make_shared<Node>(node));
+  }
+
+  void visitWay(const Way &way) override {
+    elements_.push_back(std::make_shared<Way>(way));
+  }
+
+  void visitArea(const Area &area) override {
+    elements_.push_back(std::make_shared<Area>(area));
+  }
+
+  void visitRelation(const Relation &relation) override {
+    elements_.push_back(std::make_shared<Relation>(relation));
+  }
+
+  const std::vector<std::shared_ptr<Element>> &elements() const {
+    return elements_;
+  }
+
+  void replay(ElementVisitor &visitor, const utymap::CancellationToken &cancelToken) const {
+    for (const auto &element : elements_) {
+      if (cancelToken.isCancelled()) break;
+      dispatch(*element, visitor);
+    }
+  }
+
+ private:
+  std::vector<std::shared_ptr<Element>> elements_;
+};
+
+/// Gets coordinate of visited node.
+class NodeLocationVisitor final : public ElementVisitor {
+ public:
+  explicit NodeLocationVisitor(utymap::GeoCoordinate &coordinate) : isFound(false), coordinate_(coordinate) {}
+
+  void visitNode(const Node &node) override {
+    coordinate_ = node.coordinate;
+    isFound = true;
+  }
+
+  void visitWay(const Way &) override {}
+  void visitArea(const Area &) override {}
+  void visitRelation(const Relation &) override {}
+
+  bool isFound;
+
+ private:
+  utymap::GeoCoordinate &coordinate_;
+};
+}
+
 class GeoStore::GeoStoreImpl final {
  public:
 
-  explicit GeoStoreImpl(const StringTable &stringTable) :
-      stringTable_(stringTable) {
+  GeoStoreImpl(const StringTable &stringTable, utymap::utils::ThreadPool *threadPool) :
+      stringTable_(stringTable), threadPool_(threadPool), searchPool_(threadPool),
+      importThreads_(0), importFileThreads_(0), twoPassImport_(false),
+      hierarchicalClipping_(false) {
   }
 
   void registerStore(const std::string &storeKey, std::unique_ptr<ElementStore> store) {
+    store->setHierarchicalClipping(hierarchicalClipping_);
     storeMap_.emplace(storeKey, std::move(store));
   }
 
@@ -31,6 +346,8 @@ class GeoStore::GeoStoreImpl final {
            const LodRange &range,
            const StyleProvider &styleProvider,
            const utymap::CancellationToken &cancelToken) {
+    // NOTE strings of element are written before it, so it never refers to lost strings.
+    stringTable_.flush();
     auto &elementStore = storeMap_[storeKey];
     elementStore->store(element, range, styleProvider);
   }
@@ -41,11 +358,23 @@ class GeoStore::GeoStoreImpl final {
            const StyleProvider &styleProvider,
            const utymap::CancellationToken &cancelToken) {
     auto &elementStore = storeMap_[storeKey];
-    add(path, cancelToken, [&](Element &element) {
-      return elementStore->store(element, quadKey, styleProvider);
-    });
+    configure(*elementStore, styleProvider, quadKey.levelOfDetail);
+    ImportCheckpoint checkpoint(*elementStore, checkpointDirectory_, path,
+                                getImportKey(storeKey, "quadkey", quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY));
+    {
+      BatchScope batch(*elementStore);
+      ImportTracker tracker(*elementStore, { path }, progressCallback_);
+      // NOTE features of vector tile with the same quadkey are already clipped.
+      bool isTile = getFormatTypeFromPath(path) == FormatType::Mvt && MvtParser<ShapeDataVisitor>::getTile(path) == quadKey;
+      add(path, cancelToken, checkpoint.wrap([&](Element &element) {
+        return isTile
+            ? elementStore->storeClipped(element, quadKey, styleProvider)
+            : elementStore->store(element, quadKey, styleProvider);
+      }), utymap::BoundingBox(), tracker, isConcurrent(checkpoint));
+    }
 
-    if (cancelToken.isCancelled()) 
+    checkpoint.complete(cancelToken.isCancelled());
+    if (cancelToken.isCancelled() && !checkpoint.isActive())
       elementStore->erase(quadKey);
   }
 
@@ -55,11 +384,20 @@ class GeoStore::GeoStoreImpl final {
            const StyleProvider &styleProvider,
            const utymap::CancellationToken &cancelToken) {
     auto &elementStore = storeMap_[storeKey];
-    auto bbox = add(path, cancelToken, [&](Element &element) {
-      return elementStore->store(element, range, styleProvider);
-    });
+    configure(*elementStore, styleProvider, range.start);
+    ImportCheckpoint checkpoint(*elementStore, checkpointDirectory_, path,
+                                getImportKey(storeKey, "range", range.start, range.end));
+    utymap::BoundingBox bbox;
+    {
+      BatchScope batch(*elementStore);
+      ImportTracker tracker(*elementStore, { path }, progressCallback_);
+      bbox = add(path, cancelToken, checkpoint.wrap([&](Element &element) {
+        return elementStore->store(element, range, styleProvider);
+      }), utymap::BoundingBox(), tracker, isConcurrent(checkpoint));
+    }
 
-    if (cancelToken.isCancelled())
+    checkpoint.complete(cancelToken.isCancelled());
+    if (cancelToken.isCancelled() && !checkpoint.isActive())
       elementStore->erase(bbox, range);
   }
 
@@ -70,85 +408,504 @@ class GeoStore::GeoStoreImpl final {
            const StyleProvider &styleProvider,
            const utymap::CancellationToken &cancelToken) {
     auto &elementStore = storeMap_[storeKey];
-    add(path, cancelToken, [&](Element &element) {
-      return elementStore->store(element, bbox, range, styleProvider);
-    });
+    configure(*elementStore, styleProvider, range.start);
+    double latPadding = bbox.height() * BoundingBoxPadding;
+    double lonPadding = bbox.width() * BoundingBoxPadding;
+    BoundingBox filterBbox(GeoCoordinate(bbox.minPoint.latitude - latPadding, bbox.minPoint.longitude - lonPadding),
+                           GeoCoordinate(bbox.maxPoint.latitude + latPadding, bbox.maxPoint.longitude + lonPadding));
+    ImportCheckpoint checkpoint(*elementStore, checkpointDirectory_, path,
+                                getImportKey(storeKey, "bbox", range.start, range.end,
+                                             bbox.minPoint.latitude, bbox.minPoint.longitude,
+                                             bbox.maxPoint.latitude, bbox.maxPoint.longitude));
+    {
+      BatchScope batch(*elementStore);
+      ImportTracker tracker(*elementStore, { path }, progressCallback_);
+      add(path, cancelToken, checkpoint.wrap([&](Element &element) {
+        return elementStore->store(element, bbox, range, styleProvider);
+      }), filterBbox, tracker, isConcurrent(checkpoint));
+    }
 
-    if (cancelToken.isCancelled())
+    checkpoint.complete(cancelToken.isCancelled());
+    if (cancelToken.isCancelled() && !checkpoint.isActive())
       elementStore->erase(bbox, range);
   }
 
+  void add(const std::string &storeKey,
+           const std::vector<GeoStore::ImportFile> &files,
+           const LodRange &range,
+           const utymap::CancellationToken &cancelToken) {
+    auto &elementStore = storeMap_[storeKey];
+    for (const auto &file : files)
+      configure(*elementStore, file.styleProvider, range.start);
+
+    std::vector<utymap::BoundingBox> bboxes(files.size());
+    {
+      BatchScope batch(*elementStore);
+      std::size_t threadCount = importFileThreads_ > 0
+          ? importFileThreads_
+          : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+      threadCount = std::min(threadCount, files.size());
+      std::vector<std::string> paths;
+      for (const auto &file : files)
+        paths.push_back(file.path);
+      ImportTracker tracker(*elementStore, paths, progressCallback_);
+
+      std::atomic<std::size_t> nextFile(0);
+      std::exception_ptr error;
+      std::mutex errorLock;
+      auto parseFiles = [&]() {
+        for (std::size_t i = nextFile++; i < files.size(); i = nextFile++) {
+          try {
+            const auto &styleProvider = files[i].styleProvider;
+            bboxes[i] = parse(files[i].path, cancelToken, [&](Element &element) {
+              return elementStore->store(element, range, styleProvider);
+            }, utymap::BoundingBox(), tracker);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(errorLock);
+            if (error == nullptr) error = std::current_exception();
+          }
+        }
+      };
+
+      // NOTE calling thread parses files too, so pool runs one task less.
+      utymap::utils::ThreadPoolShare threadPool(threadPool_);
+      threadPool.resize(threadCount > 1 ? threadCount - 1 : 0);
+      std::vector<utymap::utils::ThreadPool::Future> futures;
+      for (std::size_t i = 0; i < threadPool.size(); ++i)
+        futures.push_back(threadPool.get()->enqueue(parseFiles));
+      parseFiles();
+
+      // NOTE all files should be processed before error is rethrown as tasks refer to local state.
+      for (auto &future : futures)
+        future.wait();
+      stringTable_.flush();
+      if (error != nullptr)
+        std::rethrow_exception(error);
+    }
+
+    if (cancelToken.isCancelled()) {
+      for (const auto &bbox : bboxes)
+        elementStore->erase(bbox, range);
+    }
+  }
+
+  std::vector<QuadKey> applyChanges(const std::string &storeKey,
+                                    const std::string &path,
+                                    const LodRange &range,
+                                    const StyleProvider &styleProvider,
+                                    const utymap::CancellationToken &cancelToken) {
+    auto &elementStore = storeMap_[storeKey];
+    configure(*elementStore, styleProvider, range.start);
+
+    // NOTE old versions should be erased before new ones are stored, so elements are buffered.
+    ElementBuffer buffer;
+    std::unordered_set<std::uint64_t> ids;
+    {
+      OsmXmlParser<OsmDataVisitor> parser;
+      std::ifstream xmlFile(path);
+      OsmDataVisitor visitor(stringTable_, [&](Element &element) {
+        dispatch(element, buffer);
+        return true;
+      }, cancelToken);
+      // NOTE change file lists only changed nodes, so locations of others are read from store.
+      visitor.setNodeResolver([&](std::uint64_t id, utymap::GeoCoordinate &coordinate) {
+        NodeLocationVisitor nodeVisitor(coordinate);
+        return elementStore->searchById(id, nodeVisitor) && nodeVisitor.isFound;
+      });
+      parser.parse(xmlFile, visitor);
+      visitor.complete();
+      ids = visitor.getChangedIds();
+    }
+    stringTable_.flush();
+    if (cancelToken.isCancelled()) return {};
+
+    for (const auto &element : buffer.elements())
+      ids.insert(element->id);
+
+    auto quadKeys = elementStore->erase(ids, range);
+    {
+      BatchScope batch(*elementStore);
+      for (const auto &element : buffer.elements()) {
+        if (cancelToken.isCancelled()) break;
+        if (!elementStore->store(*element, range, styleProvider)) continue;
+
+        ElementGeometryVisitor geometryVisitor;
+        dispatch(*element, geometryVisitor);
+        for (int lod = range.start; lod <= range.end; ++lod) {
+          utymap::utils::GeoUtils::visitTileRange(geometryVisitor.boundingBox, lod,
+              [&](const QuadKey &quadKey, const BoundingBox &) { quadKeys.push_back(quadKey); });
+        }
+      }
+    }
+
+    std::sort(quadKeys.begin(), quadKeys.end(), QuadKey::Comparator());
+    quadKeys.erase(std::unique(quadKeys.begin(), quadKeys.end()), quadKeys.end());
+    return quadKeys;
+  }
+
+  void beginBatch(const std::string &storeKey) {
+    storeMap_[storeKey]->beginBatch();
+  }
+
+  void commitBatch(const std::string &storeKey) {
+    storeMap_[storeKey]->commitBatch();
+  }
+
+  /// Checks whether import functor can be called concurrently: element store is thread safe,
+  /// but checkpoint relies on order of elements and progress tracking is not synchronized.
+  bool isConcurrent(const ImportCheckpoint &checkpoint) const {
+    return !checkpoint.isActive() && !progressCallback_;
+  }
+
+  /// Applies store settings defined by canvas style of given level of detail.
+  /// NOTE settings which are not defined in style are kept.
+  static void configure(ElementStore &elementStore, const StyleProvider &styleProvider, int levelOfDetail) {
+    auto style = styleProvider.forCanvas(levelOfDetail);
+    auto searchKeysKey = styleProvider.getConstIds().searchKeysKey;
+    if (style.has(searchKeysKey))
+      elementStore.setSearchKeys(style.getString(searchKeysKey));
+  }
+
+  /// Parses file and writes strings found in it, so stored elements never refer to lost strings.
+  /// Elements outside of filter bounding box are dropped while parsing if it is valid.
+  /// If functor can be called concurrently, elements which are kept till the end of osm file
+  /// are added by parallel tasks.
   utymap::BoundingBox add(const std::string &path,
            const utymap::CancellationToken &cancelToken,
-           const std::function<bool(Element &)> &functor) const {
+           const std::function<bool(Element &)> &functor,
+           const utymap::BoundingBox &filterBbox,
+           ImportTracker &tracker,
+           bool isConcurrent = false) const {
+    auto bbox = parse(path, cancelToken, functor, filterBbox, tracker, isConcurrent);
+    stringTable_.flush();
+    return bbox;
+  }
+
+  utymap::BoundingBox parse(const std::string &path,
+           const utymap::CancellationToken &cancelToken,
+           const std::function<bool(Element &)> &elementFunctor,
+           const utymap::BoundingBox &filterBbox,
+           ImportTracker &tracker,
+           bool isConcurrent = false) const {
+    // NOTE file progress is completed on exit, after elements added by visitor completion.
+    ImportTracker::File file(tracker, path);
+    auto functor = file.wrap(elementFunctor);
     switch (getFormatTypeFromPath(path)) {
       case FormatType::Shape: {
-        ShapeParser<ShapeDataVisitor> parser;
+        ShapeParser<ShapeDataVisitor> parser(importThreads_, threadPool_);
         ShapeDataVisitor visitor(stringTable_, functor, cancelToken);
+        visitor.setBoundingBox(filterBbox);
         parser.parse(path, visitor);
         return visitor.complete();
       }
       case FormatType::Xml: {
         OsmXmlParser<OsmDataVisitor> parser;
         std::ifstream xmlFile(path);
-        OsmDataVisitor visitor(stringTable_, functor, cancelToken);
-        parser.parse(xmlFile, visitor);
-        return visitor.complete();
+        file.setStream(xmlFile);
+        auto visitor = twoPassImport_
+            ? utymap::utils::make_unique<OsmDataVisitor>(stringTable_, functor, cancelToken, collectXmlReferences(path))
+            : utymap::utils::make_unique<OsmDataVisitor>(stringTable_, functor, cancelToken);
+        setNodeLocationStore(path, *visitor);
+        visitor->setCompletionThreads(importThreads_, threadPool_, isConcurrent);
+        visitor->setBoundingBox(filterBbox);
+        parser.parse(xmlFile, *visitor);
+        return visitor->complete();
       }
 #ifdef PBF_SUPPORTED_ENABLED
       case FormatType::Pbf: {
-        OsmPbfParser<OsmDataVisitor> parser;
+        OsmPbfParser<OsmDataVisitor> parser(importThreads_, threadPool_);
         std::ifstream pbfFile(path, std::ios::in | std::ios::binary);
-        OsmDataVisitor visitor(stringTable_, functor, cancelToken);
-        parser.parse(pbfFile, visitor);
-        return visitor.complete();
+        file.setStream(pbfFile);
+        auto visitor = twoPassImport_
+            ? utymap::utils::make_unique<OsmDataVisitor>(stringTable_, functor, cancelToken, collectPbfReferences(path))
+            : utymap::utils::make_unique<OsmDataVisitor>(stringTable_, functor, cancelToken);
+        setNodeLocationStore(path, *visitor);
+        visitor->setCompletionThreads(importThreads_, threadPool_, isConcurrent);
+        visitor->setBoundingBox(filterBbox);
+        parser.setBoundingBox(filterBbox);
+        parser.parse(pbfFile, *visitor);
+        return visitor->complete();
       }
 #endif
       case FormatType::Json: {
         OsmJsonParser<OsmDataVisitor> parser(stringTable_);
         std::ifstream jsonFile(path);
+        file.setStream(jsonFile);
         OsmDataVisitor visitor(stringTable_, functor, cancelToken);
+        visitor.setBoundingBox(filterBbox);
         parser.parse(jsonFile, visitor);
         return visitor.complete();
       }
+      case FormatType::Mvt: {
+        MvtParser<ShapeDataVisitor> parser;
+        std::ifstream mvtFile(path, std::ios::in | std::ios::binary);
+        file.setStream(mvtFile);
+        ShapeDataVisitor visitor(stringTable_, functor, cancelToken);
+        visitor.setBoundingBox(filterBbox);
+        parser.parse(mvtFile, MvtParser<ShapeDataVisitor>::getTile(path), visitor);
+        return visitor.complete();
+      }
       default:throw std::domain_error("Not supported.");
     }
   }
 
+  void setImportThreads(std::size_t threadCount) {
+    importThreads_ = threadCount;
+  }
+
+  void setImportFileThreads(std::size_t threadCount) {
+    importFileThreads_ = threadCount;
+  }
+
+  void setImportProgress(const GeoStore::ProgressCallback &callback) {
+    progressCallback_ = callback;
+  }
+
+  void setTwoPassImport(bool enabled) {
+    twoPassImport_ = enabled;
+  }
+
+  void setHierarchicalClipping(bool enabled) {
+    hierarchicalClipping_ = enabled;
+    for (auto &pair : storeMap_)
+      pair.second->setHierarchicalClipping(enabled);
+  }
+
+  void setNodeLocationDirectory(const std::string &directory) {
+    nodeLocationDirectory_ = directory;
+  }
+
+  void setCheckpointDirectory(const std::string &directory) {
+    checkpointDirectory_ = directory;
+  }
+
+  void setSearchThreads(std::size_t threadCount) {
+    searchPool_.resize(threadCount);
+  }
+
   void search(const std::string &notTerms,
               const std::string &andTerms,
               const std::string &orTerms,
               const utymap::BoundingBox &bbox,
               const utymap::LodRange &range,
+              std::size_t offset,
+              std::size_t limit,
               ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) {
+    // NOTE page is applied to results of all stores, so every store is asked only
+    // for amount of elements which is still needed to fill it.
+    ElementVisitorLimit page(visitor, offset, limit);
+    const std::size_t needed = page.remaining();
+    auto isCandidate = [&](const ElementStore &store) { return store.mayHaveData(bbox, range); };
+    search(page, cancelToken, isCandidate, [&](ElementStore &store, ElementVisitor &storeVisitor) {
+      bool isCaller = &storeVisitor == &page;
+      if (isCaller && page.isFull())
+        return;
+      store.search(notTerms, andTerms, orTerms, bbox, range,
+                   0, isCaller ? page.remaining() : needed, storeVisitor, cancelToken);
+    });
+  }
+
+  std::size_t count(const std::string &notTerms,
+                    const std::string &andTerms,
+                    const std::string &orTerms,
+                    const utymap::BoundingBox &bbox,
+                    const utymap::LodRange &range,
+                    std::size_t maxCount,
+                    const utymap::CancellationToken &cancelToken) {
+    std::size_t count = 0;
     for (const auto &pair : storeMap_) {
-      pair.second->search(notTerms, andTerms, orTerms, bbox, range, visitor, cancelToken);
+      if ((maxCount > 0 && count >= maxCount) || cancelToken.isCancelled())
+        break;
+      if (!pair.second->mayHaveData(bbox, range))
+        continue;
+      count += pair.second->count(notTerms, andTerms, orTerms, bbox, range,
+                                  maxCount > 0 ? maxCount - count : 0, cancelToken);
     }
+    return count;
   }
 
   void search(const QuadKey &quadKey,
               const StyleProvider &styleProvider,
               ElementVisitor &visitor,
               const CancellationToken &cancelToken) {
+    // NOTE coverage prunes stores before they are asked for quad key.
+    auto isCandidate = [&](const ElementStore &store) {
+      return store.mayHaveData(quadKey) && store.hasData(quadKey);
+    };
+    search(visitor, cancelToken, isCandidate, [&](ElementStore &store, ElementVisitor &storeVisitor) {
+      store.search(quadKey, storeVisitor, cancelToken);
+    });
+  }
+
+  std::unique_ptr<ElementCursor> openCursor(const std::string &notTerms,
+                                            const std::string &andTerms,
+                                            const std::string &orTerms,
+                                            const utymap::BoundingBox &bbox,
+                                            const utymap::LodRange &range) {
+    std::vector<std::unique_ptr<ElementCursor>> cursors;
+    for (const auto &pair : storeMap_) {
+      if (pair.second->mayHaveData(bbox, range))
+        cursors.push_back(pair.second->openCursor(notTerms, andTerms, orTerms, bbox, range));
+    }
+    return utymap::utils::make_unique<ChainedElementCursor>(std::move(cursors));
+  }
+
+  std::unique_ptr<ElementCursor> openCursor(const QuadKey &quadKey) {
+    std::vector<std::unique_ptr<ElementCursor>> cursors;
+    for (const auto &pair : storeMap_) {
+      if (pair.second->mayHaveData(quadKey) && pair.second->hasData(quadKey))
+        cursors.push_back(pair.second->openCursor(quadKey));
+    }
+    return utymap::utils::make_unique<ChainedElementCursor>(std::move(cursors));
+  }
+
+  bool searchById(std::uint64_t id, ElementVisitor &visitor) {
     for (const auto &pair : storeMap_) {
-      // Search only if store has data
-      if (pair.second->hasData(quadKey))
-        pair.second->search(quadKey, visitor, cancelToken);
+      if (pair.second->searchById(id, visitor))
+        return true;
     }
+    return false;
+  }
+
+  void prefetch(const std::vector<QuadKey> &quadKeys) {
+    for (const auto &pair : storeMap_)
+      pair.second->prefetch(quadKeys);
   }
 
   bool hasData(const QuadKey &quadKey) {
     for (const auto &pair : storeMap_) {
-      if (pair.second->hasData(quadKey))
+      if (pair.second->mayHaveData(quadKey) && pair.second->hasData(quadKey))
         return true;
     }
     return false;
   }
 
+  TileSummary getSummary(const QuadKey &quadKey) {
+    TileSummary summary;
+    for (const auto &pair : storeMap_) {
+      if (pair.second->mayHaveData(quadKey))
+        summary.add(pair.second->getSummary(quadKey));
+    }
+    return summary;
+  }
+
  private:
+  using StorePredicate = std::function<bool(const ElementStore &)>;
+  using StoreSearch = std::function<void(ElementStore &, ElementVisitor &)>;
+
+  /// Runs search in every candidate store. In parallel mode, all stores except the first one
+  /// are searched on thread pool into buffers which are replayed in store order, so visitor
+  /// receives elements in the same order as in sequential mode.
+  void search(ElementVisitor &visitor,
+              const utymap::CancellationToken &cancelToken,
+              const StorePredicate &isCandidate,
+              const StoreSearch &storeSearch) {
+    // NOTE stores are pruned before any search work is scheduled.
+    std::vector<ElementStore *> stores;
+    for (const auto &pair : storeMap_) {
+      if (isCandidate(*pair.second))
+        stores.push_back(pair.second.get());
+    }
+
+    auto threadPool = searchPool_.get();
+    if (threadPool == nullptr || stores.size() < 2) {
+      for (auto store : stores)
+        storeSearch(*store, visitor);
+      return;
+    }
+
+    std::vector<ElementBuffer> buffers(stores.size() - 1);
+    std::vector<utymap::utils::ThreadPool::Future> futures;
+    futures.reserve(buffers.size());
+
+    for (std::size_t index = 0; index < buffers.size(); ++index) {
+      ElementStore &store = *stores[index + 1];
+      ElementBuffer &buffer = buffers[index];
+      futures.push_back(threadPool->enqueue([&storeSearch, &store, &buffer]() {
+        storeSearch(store, buffer);
+      }));
+    }
+
+    std::exception_ptr error;
+    try {
+      storeSearch(*stores.front(), visitor);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    // NOTE wait for all tasks as they reference local buffers.
+    for (std::size_t i = 0; i < futures.size(); ++i) {
+      try {
+        futures[i].get();
+        if (!error)
+          buffers[i].replay(visitor, cancelToken);
+      } catch (...) {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+
   const StringTable &stringTable_;
   std::map<std::string, std::unique_ptr<ElementStore>> storeMap_;
+  /// Shared pool of application or null.
+  utymap::utils::ThreadPool *threadPool_;
+  utymap::utils::ThreadPoolShare searchPool_;
+  std::size_t importThreads_;
+  GeoStore::ProgressCallback progressCallback_;
+  std::size_t importFileThreads_;
+  bool twoPassImport_;
+  bool hierarchicalClipping_;
+  std::string nodeLocationDirectory_;
+  std::string checkpointDirectory_;
+
+  /// Builds key which identifies arguments of import.
+  template<typename... Args>
+  static std::string getImportKey(const std::string &storeKey, const Args &... args) {
+    std::stringstream ss;
+    ss << storeKey;
+    (void) std::initializer_list<int>{ (ss << ":" << std::setprecision(12) << args, 0)... };
+    return ss.str();
+  }
+
+  /// Uses file backed node locations if location directory is set.
+  /// File is named after source file and reused while source file is not changed.
+  void setNodeLocationStore(const std::string &path, OsmDataVisitor &visitor) const {
+    if (nodeLocationDirectory_.empty()) return;
+
+    boost::filesystem::path sourcePath(path);
+    std::uint64_t stamp = boost::filesystem::file_size(sourcePath);
+    stamp = stamp * 31 + static_cast<std::uint64_t>(boost::filesystem::last_write_time(sourcePath));
+    if (twoPassImport_)
+      stamp = ~stamp;
+
+    auto locationPath = (boost::filesystem::path(nodeLocationDirectory_) / sourcePath.filename()).string() + ".nodes";
+    visitor.setNodeLocationStore(utymap::utils::make_unique<NodeLocationStore>(locationPath, stamp));
+  }
+
+  /// Reads ids of elements referenced by ways and relations from xml file.
+  static utymap::formats::OsmReferences collectXmlReferences(const std::string &path) {
+    OsmXmlParser<OsmReferenceVisitor> parser;
+    std::ifstream xmlFile(path);
+    OsmReferenceVisitor visitor;
+    parser.parse(xmlFile, visitor);
+    return visitor.complete();
+  }
+
+#ifdef PBF_SUPPORTED_ENABLED
+  /// Reads ids of elements referenced by ways and relations from pbf file.
+  utymap::formats::OsmReferences collectPbfReferences(const std::string &path) const {
+    OsmPbfParser<OsmReferenceVisitor> parser(importThreads_, threadPool_);
+    std::ifstream pbfFile(path, std::ios::in | std::ios::binary);
+    OsmReferenceVisitor visitor;
+    parser.parse(pbfFile, visitor);
+    return visitor.complete();
+  }
+#endif
 
   static FormatType getFormatTypeFromPath(const std::string &path) {
     if (utymap::utils::endsWith(path, "pbf"))
@@ -157,12 +914,15 @@ class GeoStore::GeoStoreImpl final {
       return FormatType::Xml;
     if (utymap::utils::endsWith(path, "json"))
       return FormatType::Json;
+    if (utymap::utils::endsWith(path, "mvt"))
+      return FormatType::Mvt;
 
     return FormatType::Shape;
   }
 };
 
-GeoStore::GeoStore(const StringTable &stringTable) : pimpl_(utymap::utils::make_unique<GeoStoreImpl>(stringTable)) {
+GeoStore::GeoStore(const StringTable &stringTable, utymap::utils::ThreadPool *threadPool) :
+    pimpl_(utymap::utils::make_unique<GeoStoreImpl>(stringTable, threadPool)) {
 }
 
 GeoStore::~GeoStore() {
@@ -205,6 +965,29 @@ void utymap::index::GeoStore::add(const std::string &storeKey,
   pimpl_->add(storeKey, path, bbox, range, styleProvider, cancelToken);
 }
 
+void utymap::index::GeoStore::add(const std::string &storeKey,
+                                  const std::vector<ImportFile> &files,
+                                  const LodRange &range,
+                                  const utymap::CancellationToken &cancelToken) {
+  pimpl_->add(storeKey, files, range, cancelToken);
+}
+
+std::vector<utymap::QuadKey> utymap::index::GeoStore::applyChanges(const std::string &storeKey,
+                                                                   const std::string &path,
+                                                                   const LodRange &range,
+                                                                   const StyleProvider &styleProvider,
+                                                                   const utymap::CancellationToken &cancelToken) {
+  return pimpl_->applyChanges(storeKey, path, range, styleProvider, cancelToken);
+}
+
+void utymap::index::GeoStore::beginBatch(const std::string &storeKey) {
+  pimpl_->beginBatch(storeKey);
+}
+
+void utymap::index::GeoStore::commitBatch(const std::string &storeKey) {
+  pimpl_->commitBatch(storeKey);
+}
+
 void utymap::index::GeoStore::search(const QuadKey &quadKey,
   const StyleProvider &styleProvider,
   ElementVisitor &visitor,
@@ -219,9 +1002,87 @@ void utymap::index::GeoStore::search(const std::string &notTerms,
                                      const utymap::LodRange &range,
                                      ElementVisitor &visitor,
                                      const utymap::CancellationToken &cancelToken) {
-  pimpl_->search(notTerms, andTerms, orTerms, bbox, range, visitor, cancelToken);
+  pimpl_->search(notTerms, andTerms, orTerms, bbox, range, 0, 0, visitor, cancelToken);
+}
+
+void utymap::index::GeoStore::search(const std::string &notTerms,
+                                     const std::string &andTerms,
+                                     const std::string &orTerms,
+                                     const utymap::BoundingBox &bbox,
+                                     const utymap::LodRange &range,
+                                     std::size_t offset,
+                                     std::size_t limit,
+                                     ElementVisitor &visitor,
+                                     const utymap::CancellationToken &cancelToken) {
+  pimpl_->search(notTerms, andTerms, orTerms, bbox, range, offset, limit, visitor, cancelToken);
+}
+
+std::size_t utymap::index::GeoStore::count(const std::string &notTerms,
+                                           const std::string &andTerms,
+                                           const std::string &orTerms,
+                                           const utymap::BoundingBox &bbox,
+                                           const utymap::LodRange &range,
+                                           std::size_t maxCount,
+                                           const utymap::CancellationToken &cancelToken) {
+  return pimpl_->count(notTerms, andTerms, orTerms, bbox, range, maxCount, cancelToken);
+}
+
+void utymap::index::GeoStore::setImportThreads(std::size_t threadCount) {
+  pimpl_->setImportThreads(threadCount);
+}
+
+void utymap::index::GeoStore::setImportFileThreads(std::size_t threadCount) {
+  pimpl_->setImportFileThreads(threadCount);
+}
+
+void utymap::index::GeoStore::setImportProgress(const ProgressCallback &callback) {
+  pimpl_->setImportProgress(callback);
+}
+
+void utymap::index::GeoStore::setTwoPassImport(bool enabled) {
+  pimpl_->setTwoPassImport(enabled);
+}
+
+void utymap::index::GeoStore::setHierarchicalClipping(bool enabled) {
+  pimpl_->setHierarchicalClipping(enabled);
+}
+
+void utymap::index::GeoStore::setNodeLocationDirectory(const std::string &directory) {
+  pimpl_->setNodeLocationDirectory(directory);
+}
+
+void utymap::index::GeoStore::setCheckpointDirectory(const std::string &directory) {
+  pimpl_->setCheckpointDirectory(directory);
+}
+
+void utymap::index::GeoStore::setSearchThreads(std::size_t threadCount) {
+  pimpl_->setSearchThreads(threadCount);
+}
+
+std::unique_ptr<ElementCursor> utymap::index::GeoStore::openCursor(const std::string &notTerms,
+                                                                   const std::string &andTerms,
+                                                                   const std::string &orTerms,
+                                                                   const BoundingBox &bbox,
+                                                                   const LodRange &range) {
+  return pimpl_->openCursor(notTerms, andTerms, orTerms, bbox, range);
+}
+
+std::unique_ptr<ElementCursor> utymap::index::GeoStore::openCursor(const QuadKey &quadKey) {
+  return pimpl_->openCursor(quadKey);
+}
+
+bool utymap::index::GeoStore::searchById(std::uint64_t id, ElementVisitor &visitor) {
+  return pimpl_->searchById(id, visitor);
 }
 
 bool utymap::index::GeoStore::hasData(const QuadKey &quadKey) const {
   return pimpl_->hasData(quadKey);
 }
+
+TileSummary utymap::index::GeoStore::getSummary(const QuadKey &quadKey) const {
+  return pimpl_->getSummary(quadKey);
+}
+
+void utymap::index::GeoStore::prefetch(const std::vector<QuadKey> &quadKeys) {
+  pimpl_->prefetch(quadKeys);
+}
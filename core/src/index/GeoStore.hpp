@@ -9,9 +9,13 @@
 #include "entities/Element.hpp"
 #include "entities/ElementVisitor.hpp"
 #include "index/ElementStore.hpp"
+#include "index/ImportStatistics.hpp"
 #include "index/StringTable.hpp"
+#include "index/TileSummary.hpp"
 #include "mapcss/StyleProvider.hpp"
+#include "utils/ThreadPool.hpp"
 
+#include <functional>
 #include <memory>
 
 namespace utymap {
@@ -20,7 +24,19 @@ namespace index {
 /// Provides API to store and access geo data using different underlying data stores.
 class GeoStore final {
  public:
-  explicit GeoStore(const utymap::index::StringTable &stringTable);
+  /// Receives statistics of running import.
+  using ProgressCallback = std::function<void(const ImportStatistics::Snapshot &)>;
+
+  /// Describes file imported by batch import together with style used to store its data.
+  struct ImportFile final {
+    std::string path;
+    const utymap::mapcss::StyleProvider &styleProvider;
+  };
+
+  /// Creates store which runs parallel tasks on given pool. Without pool, parallel features
+  /// use own threads.
+  explicit GeoStore(const utymap::index::StringTable &stringTable,
+                    utymap::utils::ThreadPool *threadPool = nullptr);
 
   ~GeoStore();
 
@@ -57,6 +73,70 @@ class GeoStore final {
            const utymap::mapcss::StyleProvider &styleProvider,
            const utymap::CancellationToken &cancelToken);
 
+  /// Adds all data from files to selected store in given level of detail range.
+  /// Files are parsed concurrently and are written to the same store, so import time
+  /// is bounded by the largest file. Strings are flushed once all files are parsed.
+  /// NOTE first error is rethrown once all files are processed.
+  void add(const std::string &storeKey,
+           const std::vector<ImportFile> &files,
+           const utymap::LodRange &range,
+           const utymap::CancellationToken &cancelToken);
+
+  /// Applies OSM change file (.osc) to selected store in given level of detail range.
+  /// Deleted and modified elements are erased, created and modified ones are stored.
+  /// Returns sorted quad keys which content was changed.
+  /// NOTE ways and relations which are not in change file are not updated when their nodes move.
+  std::vector<QuadKey> applyChanges(const std::string &storeKey,
+                                    const std::string &path,
+                                    const utymap::LodRange &range,
+                                    const utymap::mapcss::StyleProvider &styleProvider,
+                                    const utymap::CancellationToken &cancelToken);
+
+  /// Starts batch of writes in selected store. Adding data from file uses batch automatically.
+  void beginBatch(const std::string &storeKey);
+
+  /// Commits batch of writes in selected store.
+  void commitBatch(const std::string &storeKey);
+
+  /// Enables parallel search mode: stores are queried concurrently using given amount
+  /// of tasks and results are passed to visitor in store order. Zero disables it.
+  /// NOTE visitor is called only from calling thread.
+  void setSearchThreads(std::size_t threadCount);
+
+  /// Sets amount of tasks used to decode pbf blobs and shapefile records while importing files.
+  /// Zero means that they are decoded on calling thread.
+  void setImportThreads(std::size_t threadCount);
+
+  /// Sets amount of files parsed concurrently by batch import.
+  /// Zero means amount of hardware threads.
+  void setImportFileThreads(std::size_t threadCount);
+
+  /// Sets callback which receives statistics of file import periodically and once every
+  /// file is parsed. Statistics are collected only while callback is set.
+  /// NOTE callback is called from import threads, but calls are serialized.
+  void setImportProgress(const ProgressCallback &callback);
+
+  /// Enables two pass import of osm xml and pbf files. First pass collects ids of nodes and
+  /// ways used by other elements, so only referenced elements are kept in memory.
+  /// NOTE file is read twice and nodes are expected before ways and ways before relations.
+  void setTwoPassImport(bool enabled);
+
+  /// Enables hierarchical clipping in registered stores: elements are clipped by tiles of
+  /// previous level of detail first and children tiles are clipped from these results.
+  void setHierarchicalClipping(bool enabled);
+
+  /// Sets directory where node locations of imported osm xml and pbf files are kept
+  /// in memory mapped files instead of memory. Location file is reused by next imports
+  /// of unchanged source file. Empty directory disables file backed locations.
+  void setNodeLocationDirectory(const std::string &directory);
+
+  /// Sets directory where checkpoints of single file imports are kept. Interrupted import
+  /// keeps stored data and saves amount of elements passed to store, so next import of the
+  /// same unchanged file with the same arguments skips them. Checkpoint is removed once
+  /// import is finished. Empty directory disables checkpoints: data of interrupted import is erased.
+  /// NOTE checkpoints are saved periodically too, so import can be resumed after process is killed.
+  void setCheckpointDirectory(const std::string &directory);
+
   /// Searches for elements matches given query, bounding box and LOD range
   void search(const std::string &notTerms,
               const std::string &andTerms,
@@ -66,15 +146,59 @@ class GeoStore final {
               utymap::entities::ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken);
 
+  /// Searches for page of elements matches given query, bounding box and LOD range.
+  /// First offset matches are skipped and search stops once limit matches are visited.
+  /// Zero limit means no limit.
+  void search(const std::string &notTerms,
+              const std::string &andTerms,
+              const std::string &orTerms,
+              const utymap::BoundingBox &bbox,
+              const utymap::LodRange &range,
+              std::size_t offset,
+              std::size_t limit,
+              utymap::entities::ElementVisitor &visitor,
+              const utymap::CancellationToken &cancelToken);
+
+  /// Counts elements which match given query in all stores without reading them.
+  /// Counting stops once maxCount is reached, zero means no limit.
+  std::size_t count(const std::string &notTerms,
+                    const std::string &andTerms,
+                    const std::string &orTerms,
+                    const utymap::BoundingBox &bbox,
+                    const utymap::LodRange &range,
+                    std::size_t maxCount,
+                    const utymap::CancellationToken &cancelToken);
+
   /// Searches for elements inside quadkey.
   void search(const QuadKey &quadKey,
               const utymap::mapcss::StyleProvider &styleProvider,
               utymap::entities::ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken);
 
+  /// Opens cursor over elements which match given query in all stores. Stores are
+  /// pulled one after another in the same order as search visits them.
+  std::unique_ptr<ElementCursor> openCursor(const std::string &notTerms,
+                                            const std::string &andTerms,
+                                            const std::string &orTerms,
+                                            const utymap::BoundingBox &bbox,
+                                            const utymap::LodRange &range);
+
+  /// Opens cursor over elements of quadkey in all stores which have its data.
+  std::unique_ptr<ElementCursor> openCursor(const QuadKey &quadKey);
+
+  /// Visits element with given id using first store which has it.
+  /// Returns false if no store has such element.
+  bool searchById(std::uint64_t id, utymap::entities::ElementVisitor &visitor);
+
   /// Checks whether there is data for given quadkey.
   bool hasData(const QuadKey &quadKey) const;
 
+  /// Returns summary of elements stored for given quadkey in all stores.
+  TileSummary getSummary(const QuadKey &quadKey) const;
+
+  /// Warms data of given quad keys in all stores in background.
+  void prefetch(const std::vector<QuadKey> &quadKeys);
+
  private:
   class GeoStoreImpl;
   std::unique_ptr<GeoStoreImpl> pimpl_;
@@ -0,0 +1,77 @@
+#include "index/IdIndex.hpp"
+
+using namespace utymap;
+using namespace utymap::index;
+
+IdIndex::IdIndex(const std::string &path) : path_(path), isLoaded_(false) {}
+
+void IdIndex::add(std::uint64_t id, const QuadKey &quadKey, std::uint32_t order) {
+  std::lock_guard<std::mutex> lock(lock_);
+  load();
+
+  auto location = locations_.find(id);
+  if (location != locations_.end() && !(location->second.quadKey == quadKey) && !isStale(location->second))
+    return;
+
+  locations_[id] = Location{ quadKey, order, generations_[quadKey] };
+  append(id, quadKey, order);
+}
+
+void IdIndex::reset(const QuadKey &quadKey) {
+  std::lock_guard<std::mutex> lock(lock_);
+  load();
+  ++generations_[quadKey];
+  append(0, quadKey, ResetOrder);
+}
+
+bool IdIndex::find(std::uint64_t id, Location &location) {
+  std::lock_guard<std::mutex> lock(lock_);
+  load();
+
+  auto result = locations_.find(id);
+  if (result == locations_.end() || isStale(result->second))
+    return false;
+
+  location = result->second;
+  return true;
+}
+
+void IdIndex::flush() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (file_.is_open())
+    file_.flush();
+}
+
+bool IdIndex::isStale(const Location &location) const {
+  auto generation = generations_.find(location.quadKey);
+  return generation != generations_.end() && generation->second != location.generation;
+}
+
+void IdIndex::append(std::uint64_t id, const QuadKey &quadKey, std::uint32_t order) {
+  if (!file_.is_open())
+    file_.open(path_, std::ios::out | std::ios::binary | std::ios::app);
+
+  std::int32_t values[] = { quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY };
+  file_.write(reinterpret_cast<const char *>(&id), sizeof(id));
+  file_.write(reinterpret_cast<const char *>(values), sizeof(values));
+  file_.write(reinterpret_cast<const char *>(&order), sizeof(order));
+}
+
+void IdIndex::load() {
+  if (isLoaded_) return;
+  isLoaded_ = true;
+
+  std::ifstream file(path_, std::ios::in | std::ios::binary);
+  std::uint64_t id;
+  std::int32_t values[3];
+  std::uint32_t order;
+  while (file.read(reinterpret_cast<char *>(&id), sizeof(id)) &&
+         file.read(reinterpret_cast<char *>(values), sizeof(values)) &&
+         file.read(reinterpret_cast<char *>(&order), sizeof(order))) {
+    QuadKey quadKey(values[0], values[1], values[2]);
+    if (order == ResetOrder)
+      ++generations_[quadKey];
+    else
+      locations_[id] = Location{ quadKey, order, generations_[quadKey] };
+  }
+}
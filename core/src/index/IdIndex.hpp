@@ -0,0 +1,65 @@
+#ifndef INDEX_IDINDEX_HPP_DEFINED
+#define INDEX_IDINDEX_HPP_DEFINED
+
+#include "QuadKey.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace utymap {
+namespace index {
+
+/// Maps element id to location where element can be read. Locations and erased quad
+/// keys are appended to log file which is loaded on first use and written on flush.
+/// Location becomes stale when its quad key is erased: it is replaced once element is
+/// stored again, e.g. into another quad key. Caller should still verify location as
+/// element can be erased by id.
+class IdIndex final {
+ public:
+  struct Location {
+    utymap::QuadKey quadKey;
+    std::uint32_t order;
+    /// Erase generation of quad key when location was added.
+    std::uint32_t generation;
+  };
+
+  explicit IdIndex(const std::string &path);
+
+  /// Adds location of element. Existing location is kept if it is in another quad key
+  /// which is not erased since then. Element written again into the same quad key,
+  /// e.g. by compaction, gets new location.
+  void add(std::uint64_t id, const utymap::QuadKey &quadKey, std::uint32_t order);
+
+  /// Marks locations in erased quad key as stale.
+  void reset(const utymap::QuadKey &quadKey);
+
+  /// Returns false if element has no location or its location is stale.
+  bool find(std::uint64_t id, Location &location);
+
+  void flush();
+
+ private:
+  /// Order of record which marks quad key as erased.
+  static const std::uint32_t ResetOrder = 0xFFFFFFFF;
+
+  bool isStale(const Location &location) const;
+
+  void append(std::uint64_t id, const utymap::QuadKey &quadKey, std::uint32_t order);
+
+  void load();
+
+  const std::string path_;
+  std::mutex lock_;
+  std::ofstream file_;
+  std::unordered_map<std::uint64_t, Location> locations_;
+  std::unordered_map<utymap::QuadKey, std::uint32_t, utymap::QuadKey::Hash> generations_;
+  bool isLoaded_;
+};
+
+}
+}
+
+#endif // INDEX_IDINDEX_HPP_DEFINED
@@ -0,0 +1,86 @@
+#ifndef INDEX_IMPORTSTATISTICS_HPP_DEFINED
+#define INDEX_IMPORTSTATISTICS_HPP_DEFINED
+
+#include "QuadKey.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+
+namespace utymap {
+namespace index {
+
+/// Collects counters and time of phases of data import. It is updated concurrently
+/// by import threads, so time of phase is summed over all threads.
+class ImportStatistics final {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Phase { Parse = 0, Style, Clip, Write };
+
+  /// Contains values of statistics at some moment. Time is in seconds.
+  struct Snapshot {
+    std::uint64_t bytesParsed = 0;
+    std::uint64_t bytesTotal = 0;
+    std::uint64_t elementsParsed = 0;
+    std::uint64_t elementsStored = 0;
+    /// Amount of distinct quad keys which got elements.
+    std::uint64_t tilesWritten = 0;
+    double parseTime = 0;
+    double styleTime = 0;
+    double clipTime = 0;
+    double writeTime = 0;
+  };
+
+  ImportStatistics() : bytesParsed(0), bytesTotal(0), elementsParsed(0), elementsStored(0) {
+    for (auto &time : times_)
+      time = 0;
+  }
+
+  std::atomic<std::uint64_t> bytesParsed;
+  std::atomic<std::uint64_t> bytesTotal;
+  std::atomic<std::uint64_t> elementsParsed;
+  std::atomic<std::uint64_t> elementsStored;
+
+  void addTime(Phase phase, Clock::duration duration) {
+    times_[static_cast<int>(phase)] += std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+  }
+
+  void addTile(const utymap::QuadKey &quadKey) {
+    std::lock_guard<std::mutex> lock(tileLock_);
+    tiles_.insert(quadKey);
+  }
+
+  Snapshot snapshot() const {
+    Snapshot snapshot;
+    snapshot.bytesParsed = bytesParsed;
+    snapshot.bytesTotal = bytesTotal;
+    snapshot.elementsParsed = elementsParsed;
+    snapshot.elementsStored = elementsStored;
+    {
+      std::lock_guard<std::mutex> lock(tileLock_);
+      snapshot.tilesWritten = tiles_.size();
+    }
+    snapshot.parseTime = toSeconds(Phase::Parse);
+    snapshot.styleTime = toSeconds(Phase::Style);
+    snapshot.clipTime = toSeconds(Phase::Clip);
+    snapshot.writeTime = toSeconds(Phase::Write);
+    return snapshot;
+  }
+
+ private:
+  double toSeconds(Phase phase) const {
+    return times_[static_cast<int>(phase)] / 1e6;
+  }
+
+  std::atomic<std::int64_t> times_[4];
+  mutable std::mutex tileLock_;
+  std::unordered_set<utymap::QuadKey, utymap::QuadKey::Hash> tiles_;
+};
+
+}
+}
+
+#endif // INDEX_IMPORTSTATISTICS_HPP_DEFINED
@@ -1,11 +1,30 @@
+#include "entities/ElementDispatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
 #include "index/ElementGeometryVisitor.hpp"
 #include "index/ElementVisitorFilter.hpp"
+#include "index/ElementVisitorLimit.hpp"
+#include "index/ElementVisitorUnique.hpp"
 #include "index/InMemoryElementStore.hpp"
 #include "index/BitmapIndex.hpp"
+#include "index/BitmapStream.hpp"
+#include "index/ElementStream.hpp"
+#include "index/PersistentElementStore.hpp"
+#include "index/StoreCoverage.hpp"
+#include "index/TilePack.hpp"
+#include "utils/ReadWriteLock.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace utymap;
 using namespace utymap::index;
@@ -13,35 +32,258 @@ using namespace utymap::entities;
 using namespace utymap::mapcss;
 
 namespace {
-using Elements = std::vector<std::shared_ptr<Element>>;
-using ElementMap = std::map<QuadKey, Elements, QuadKey::Comparator>;
-using Bitmaps = std::map<QuadKey, BitmapIndex::Bitmap, QuadKey::Comparator>;
+using StorageMode = InMemoryElementStore::StorageMode;
+
+/// Estimates amount of memory used by element copy.
+struct ElementSizeVisitor final : ElementVisitor {
+  std::size_t size = 0;
+
+  void visitNode(const Node &node) override {
+    size += sizeof(Node) + node.tags.size() * sizeof(Tag);
+  }
+
+  void visitWay(const Way &way) override {
+    size += sizeof(Way) + way.tags.size() * sizeof(Tag) + way.coordinates.size() * sizeof(GeoCoordinate);
+  }
 
-class ElementMapVisitor : public ElementVisitor {
+  void visitArea(const Area &area) override {
+    size += sizeof(Area) + area.tags.size() * sizeof(Tag) + area.coordinates.size() * sizeof(GeoCoordinate);
+  }
+
+  void visitRelation(const Relation &relation) override {
+    size += sizeof(Relation) + relation.tags.size() * sizeof(Tag) +
+        relation.elements.size() * sizeof(std::shared_ptr<Element>);
+    for (const auto &element : relation.elements)
+      dispatch(*element, *this);
+  }
+};
+
+/// Keeps elements of single quad key. In arena mode, tags and coordinates of nodes,
+/// ways and areas are appended to contiguous buffers and elements are represented
+/// by lightweight records. Relations are always kept as copies.
+class QuadKeyElements final {
  public:
-  ElementMapVisitor(Elements &elements) :
-      elements_(elements) {
+  /// Holds reusable elements which are used to visit arena records.
+  /// NOTE visited element is valid only during visit call.
+  struct Views {
+    Node node;
+    Way way;
+    Area area;
+  };
+
+  void add(const Element &element, StorageMode mode) {
+    auto bytes = bytes_;
+    if (mode == StorageMode::Arena) {
+      ArenaWriter writer(*this);
+      dispatch(element, writer);
+    } else {
+      CopyWriter writer(*this);
+      dispatch(element, writer);
+    }
+    summary_.add(element, bytes_ - bytes);
+  }
+
+  std::size_t size() const {
+    return records_.size();
+  }
+
+  /// Returns id of element with given order.
+  std::uint64_t getId(std::size_t order) const {
+    return records_.at(order).id;
+  }
+
+  /// Returns approximate amount of memory used by elements.
+  std::size_t bytes() const {
+    return bytes_;
+  }
+
+  const TileSummary &summary() const {
+    return summary_;
+  }
+
+  void visit(std::size_t order, ElementVisitor &visitor, Views &views) const {
+    const auto &record = records_.at(order);
+    switch (record.kind) {
+      case Kind::Node:
+        fill(views.node, record);
+        views.node.coordinate = coordinates_[record.coordinateOffset];
+        views.node.accept(visitor);
+        break;
+      case Kind::Way:
+        fill(views.way, record);
+        fill(views.way.coordinates, record);
+        views.way.accept(visitor);
+        break;
+      case Kind::Area:
+        fill(views.area, record);
+        fill(views.area.coordinates, record);
+        views.area.accept(visitor);
+        break;
+      default:
+        dispatch(*copies_[record.copyIndex], visitor);
+        break;
+    }
   }
 
-  void visitNode(const utymap::entities::Node &node) override {
-    elements_.push_back(std::make_shared<Node>(node));
+ private:
+  enum class Kind : std::uint8_t { Node, Way, Area, Copy };
+
+  struct Record {
+    std::uint64_t id;
+    Kind kind;
+    std::uint32_t copyIndex;
+    std::uint32_t tagOffset;
+    std::uint32_t tagCount;
+    std::uint32_t coordinateOffset;
+    std::uint32_t coordinateCount;
+  };
+
+  /// Appends node, way and area data to arena buffers.
+  struct ArenaWriter final : ElementVisitor {
+    explicit ArenaWriter(QuadKeyElements &elements) : elements_(elements) {}
+
+    void visitNode(const Node &node) override {
+      elements_.addRecord(Kind::Node, node, &node.coordinate, &node.coordinate + 1);
+    }
+
+    void visitWay(const Way &way) override {
+      elements_.addRecord(Kind::Way, way, way.coordinates.data(), way.coordinates.data() + way.coordinates.size());
+    }
+
+    void visitArea(const Area &area) override {
+      elements_.addRecord(Kind::Area, area, area.coordinates.data(), area.coordinates.data() + area.coordinates.size());
+    }
+
+    void visitRelation(const Relation &relation) override {
+      elements_.addCopy(std::make_shared<Relation>(relation));
+    }
+
+   private:
+    QuadKeyElements &elements_;
+  };
+
+  /// Keeps copy of every element.
+  struct CopyWriter final : ElementVisitor {
+    explicit CopyWriter(QuadKeyElements &elements) : elements_(elements) {}
+
+    void visitNode(const Node &node) override {
+      elements_.addCopy(std::make_shared<Node>(node));
+    }
+
+    void visitWay(const Way &way) override {
+      elements_.addCopy(std::make_shared<Way>(way));
+    }
+
+    void visitArea(const Area &area) override {
+      elements_.addCopy(std::make_shared<Area>(area));
+    }
+
+    void visitRelation(const Relation &relation) override {
+      elements_.addCopy(std::make_shared<Relation>(relation));
+    }
+
+   private:
+    QuadKeyElements &elements_;
+  };
+
+  void addRecord(Kind kind, const Element &element, const GeoCoordinate *first, const GeoCoordinate *last) {
+    Record record = { element.id, kind, 0,
+                      static_cast<std::uint32_t>(tags_.size()),
+                      static_cast<std::uint32_t>(element.tags.size()),
+                      static_cast<std::uint32_t>(coordinates_.size()),
+                      static_cast<std::uint32_t>(last - first) };
+    tags_.insert(tags_.end(), element.tags.begin(), element.tags.end());
+    coordinates_.insert(coordinates_.end(), first, last);
+    records_.push_back(record);
+    bytes_ += sizeof(Record) + element.tags.size() * sizeof(Tag) + (last - first) * sizeof(GeoCoordinate);
   }
 
-  void visitWay(const utymap::entities::Way &way) override {
-    elements_.push_back(std::make_shared<Way>(way));
+  void addCopy(std::shared_ptr<Element> element) {
+    Record record = { element->id, Kind::Copy, static_cast<std::uint32_t>(copies_.size()), 0, 0, 0, 0 };
+    ElementSizeVisitor sizeVisitor;
+    dispatch(*element, sizeVisitor);
+    bytes_ += sizeof(Record) + sizeof(std::shared_ptr<Element>) + sizeVisitor.size;
+    copies_.push_back(std::move(element));
+    records_.push_back(record);
   }
 
-  void visitArea(const utymap::entities::Area &area) override {
-    elements_.push_back(std::make_shared<Area>(area));
+  /// NOTE assign reuses capacity of view buffers, so no allocation happens in steady state.
+  void fill(Element &element, const Record &record) const {
+    element.id = record.id;
+    auto tags = tags_.begin() + record.tagOffset;
+    element.tags.assign(tags, tags + record.tagCount);
   }
 
-  void visitRelation(const utymap::entities::Relation &relation) override {
-    elements_.push_back(std::make_shared<Relation>(relation));
+  void fill(std::vector<GeoCoordinate> &coordinates, const Record &record) const {
+    auto first = coordinates_.begin() + record.coordinateOffset;
+    coordinates.assign(first, first + record.coordinateCount);
   }
+
+  std::vector<Record> records_;
+  std::vector<Tag> tags_;
+  std::vector<GeoCoordinate> coordinates_;
+  std::vector<std::shared_ptr<Element>> copies_;
+  std::size_t bytes_ = 0;
+  TileSummary summary_;
+};
+
+/// Saves visited elements into another store.
+struct ElementSaveVisitor final : ElementVisitor {
+  ElementSaveVisitor(ElementStore &store, const QuadKey &quadKey) :
+      store_(store), quadKey_(quadKey) {}
+
+  void visitNode(const Node &node) override { store_.save(node, quadKey_); }
+  void visitWay(const Way &way) override { store_.save(way, quadKey_); }
+  void visitArea(const Area &area) override { store_.save(area, quadKey_); }
+  void visitRelation(const Relation &relation) override { store_.save(relation, quadKey_); }
+
+ private:
+  ElementStore &store_;
+  const QuadKey &quadKey_;
+};
+
+/// Calls functor for every visited element.
+struct ElementAddVisitor final : ElementVisitor {
+  explicit ElementAddVisitor(const std::function<void(const Element &)> &add) : add_(add) {}
+
+  void visitNode(const Node &node) override { add_(node); }
+  void visitWay(const Way &way) override { add_(way); }
+  void visitArea(const Area &area) override { add_(area); }
+  void visitRelation(const Relation &relation) override { add_(relation); }
+
  private:
-  Elements &elements_;
+  std::function<void(const Element &)> add_;
 };
 
+/// Location of element inside data section of snapshot tile.
+struct SnapshotEntry {
+  std::uint64_t id;
+  std::uint64_t offset;
+  std::uint64_t size;
+};
+
+/// Writes visited elements into index and data sections of snapshot tile.
+struct SnapshotWriter final : ElementVisitor {
+  std::string index;
+  std::ostringstream data;
+
+  void visitNode(const Node &node) override { write(node); }
+  void visitWay(const Way &way) override { write(way); }
+  void visitArea(const Area &area) override { write(area); }
+  void visitRelation(const Relation &relation) override { write(relation); }
+
+ private:
+  void write(const Element &element) {
+    SnapshotEntry entry = { element.id, static_cast<std::uint64_t>(data.tellp()), 0 };
+    ElementStream::write(data, element);
+    entry.size = static_cast<std::uint64_t>(data.tellp()) - entry.offset;
+    index.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+  }
+};
+
+using ElementMap = std::map<QuadKey, QuadKeyElements, QuadKey::Comparator>;
+using Bitmaps = std::map<QuadKey, BitmapIndex::Bitmap, QuadKey::Comparator>;
+
 class InMemoryStringIndex : public BitmapIndex {
  public:
   InMemoryStringIndex(const StringTable &stringTable,
@@ -54,15 +296,30 @@ class InMemoryStringIndex : public BitmapIndex {
     bitmaps_.erase(quadKey);
   }
 
+  /// Returns bitmap of quad key or null if it has none.
+  const Bitmap *findBitmap(const utymap::QuadKey &quadKey) const {
+    auto bitmap = bitmaps_.find(quadKey);
+    return bitmap != bitmaps_.end() ? &bitmap->second : nullptr;
+  }
+
+  /// Replaces bitmap of quad key with one read from stream.
+  void readBitmap(const utymap::QuadKey &quadKey, std::istream &stream) {
+    auto &bitmap = bitmaps_[quadKey];
+    bitmap.clear();
+    BitmapStream::read(stream, bitmap);
+  }
+
  protected:
   void notify(const utymap::QuadKey& quadKey,
               const std::uint32_t order,
+              const utymap::BoundingBox &,
               ElementVisitor &visitor) override {
     auto elements = elementsMap_.find(quadKey);
     if (elements==elementsMap_.end())
       throw std::domain_error("Cannot find element in memory while searching text!");
 
-    elements->second.at(order)->accept(visitor);
+    QuadKeyElements::Views views;
+    elements->second.visit(order, visitor, views);
   }
 
   Bitmap &getBitmap(const utymap::QuadKey &quadKey) override {
@@ -80,57 +337,286 @@ class InMemoryStringIndex : public BitmapIndex {
 }
 
 class InMemoryElementStore::InMemoryElementStoreImpl {
+  using QuadKeyList = std::list<QuadKey>;
+  using QuadKeyPositions = std::map<QuadKey, QuadKeyList::iterator, QuadKey::Comparator>;
+  using QuadKeySet = std::set<QuadKey, QuadKey::Comparator>;
+
+  /// Location of element in store.
+  struct Location {
+    QuadKey quadKey;
+    std::uint32_t order;
+  };
+
  public:
-  explicit InMemoryElementStoreImpl(const StringTable &stringTable) :
+  InMemoryElementStoreImpl(const StringTable &stringTable, StorageMode mode,
+                           std::size_t maxBytes, bool isSpillEnabled) :
       stringTable_(stringTable),
+      mode_(mode),
+      maxBytes_(maxBytes),
       elementsMap_(),
-      stringIndex_(stringTable, elementsMap_) {}
+      stringIndex_(stringTable, elementsMap_),
+      footprint_(0),
+      spillPath_(isSpillEnabled ? createSpillPath() : ""),
+      spillStore_(isSpillEnabled
+                  ? utymap::utils::make_unique<PersistentElementStore>(spillPath_, stringTable)
+                  : nullptr) {}
+
+  ~InMemoryElementStoreImpl() {
+    if (spillStore_ == nullptr)
+      return;
+
+    spillStore_.reset();
+    boost::system::error_code error;
+    boost::filesystem::remove_all(spillPath_, error);
+  }
 
   void search(const BitmapIndex::Query &query,
               ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) {
-    ElementVisitorFilter filter(visitor, [&](const Element &element) {
+    utymap::utils::SharedLock lock(lock_);
+    ElementVisitorLimit limit(visitor, query.offset, query.limit);
+    // NOTE copies of element stored in other quad keys are skipped. Lods are searched
+    // from the first one, so copy from the coarsest lod is visited.
+    ElementVisitorUnique unique(limit);
+    ElementVisitorFilter filter(unique, [&](const Element &element) {
       return ElementGeometryVisitor::intersects(element, query.boundingBox);
     });
-    stringIndex_.search(query, filter);
+    stringIndex_.search(stringIndex_.compile(query), filter, [&]() {
+      return limit.isFull() || cancelToken.isCancelled();
+    });
+
+    // NOTE spilled elements are paged through the same limit, so they follow elements in memory.
+    if (spillStore_ != nullptr && !spilledQuadKeys_.empty() && !limit.isFull())
+      spillStore_->search(query.notTerms, query.andTerms, query.orTerms,
+                          query.boundingBox, query.range, 0, limit.remaining(), unique, cancelToken);
+  }
+
+  std::size_t count(const BitmapIndex::Query &query,
+                    std::size_t maxCount,
+                    const utymap::CancellationToken &cancelToken) {
+    utymap::utils::SharedLock lock(lock_);
+    auto count = stringIndex_.count(stringIndex_.compile(query), maxCount, [&]() {
+      return cancelToken.isCancelled();
+    });
+
+    if (spillStore_ != nullptr && !spilledQuadKeys_.empty() && (maxCount == 0 || count < maxCount))
+      count += spillStore_->count(query.notTerms, query.andTerms, query.orTerms, query.boundingBox,
+                                  query.range, maxCount > 0 ? maxCount - count : 0, cancelToken);
+    return count;
   }
 
   void search(const utymap::QuadKey &quadKey,
               ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) {
+    utymap::utils::SharedLock lock(lock_);
+    if (isSpilled(quadKey)) {
+      spillStore_->search(quadKey, visitor, cancelToken);
+      return;
+    }
+
     auto it = begin(quadKey);
     // No elements for this quad key
     if (it == end())
       return;
 
-    for (const auto &element : it->second) {
+    touch(quadKey);
+
+    QuadKeyElements::Views views;
+    const auto &elements = it->second;
+    for (std::size_t order = 0; order < elements.size(); ++order) {
       if (cancelToken.isCancelled()) break;
-      element->accept(visitor);
+      elements.visit(order, visitor, views);
     }
   }
 
+  void setSearchKeys(const std::string &keys) {
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+    stringIndex_.setSearchKeys(keys);
+    if (spillStore_ != nullptr)
+      spillStore_->setSearchKeys(keys);
+  }
+
+  /// NOTE id index is not cleaned on erase or eviction: stale locations are skipped.
+  bool searchById(std::uint64_t id, ElementVisitor &visitor) {
+    utymap::utils::SharedLock lock(lock_);
+    auto location = locations_.find(id);
+    if (location != locations_.end() && isValid(location->second, id)) {
+      QuadKeyElements::Views views;
+      elementsMap_.find(location->second.quadKey)->second.visit(location->second.order, visitor, views);
+      return true;
+    }
+
+    return spillStore_ != nullptr && spillStore_->searchById(id, visitor);
+  }
+
   bool hasData(const utymap::QuadKey &quadKey) const {
-    return elementsMap_.find(quadKey)!=elementsMap_.end();
+    utymap::utils::SharedLock lock(lock_);
+    return elementsMap_.find(quadKey) != elementsMap_.end() || isSpilled(quadKey);
+  }
+
+  bool mayHaveData(const utymap::QuadKey &quadKey) const {
+    return coverage_.mayContain(quadKey);
+  }
+
+  bool mayHaveData(const utymap::BoundingBox &bbox, const utymap::LodRange &range) const {
+    return coverage_.mayIntersect(bbox, range);
+  }
+
+  TileSummary getSummary(const utymap::QuadKey &quadKey) const {
+    utymap::utils::SharedLock lock(lock_);
+    if (isSpilled(quadKey))
+      return spillStore_->getSummary(quadKey);
+
+    auto elements = elementsMap_.find(quadKey);
+    return elements != elementsMap_.end() ? elements->second.summary() : TileSummary();
   }
 
   void store(const utymap::entities::Element &element, const QuadKey &quadKey) {
-    auto &elements = elementsMap_[quadKey];
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+    add(element, quadKey, true);
+  }
+
+  void saveSnapshot(const std::string &path) {
+    utymap::utils::SharedLock lock(lock_);
+    // NOTE tiles are collected first as pack builder keeps pointers to their content.
+    std::vector<std::pair<QuadKey, std::unique_ptr<SnapshotWriter>>> tiles;
+    std::vector<std::string> bitmaps;
+    QuadKeyElements::Views views;
+    for (const auto &pair : elementsMap_) {
+      tiles.emplace_back(pair.first, utymap::utils::make_unique<SnapshotWriter>());
+      for (std::size_t order = 0; order < pair.second.size(); ++order)
+        pair.second.visit(order, *tiles.back().second, views);
+
+      std::ostringstream bitmap;
+      const auto *data = stringIndex_.findBitmap(pair.first);
+      if (data != nullptr)
+        BitmapStream::write(bitmap, *data);
+      bitmaps.push_back(bitmap.str());
+    }
+
+    // NOTE bitmaps of spilled quad keys are kept by spill store, so they are built again on load.
+    utymap::CancellationToken cancelToken;
+    for (const auto &quadKey : spilledQuadKeys_) {
+      tiles.emplace_back(quadKey, utymap::utils::make_unique<SnapshotWriter>());
+      spillStore_->search(quadKey, *tiles.back().second, cancelToken);
+      bitmaps.push_back("");
+    }
 
-    stringIndex_.add(element, quadKey, static_cast<std::uint32_t>(elements.size()));
-    ElementMapVisitor visitor(elements);
-    element.accept(visitor);
+    std::vector<std::string> data;
+    data.reserve(tiles.size());
+    TilePack::Builder builder;
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+      data.push_back(tiles[i].second->data.str());
+      const auto &index = tiles[i].second->index;
+      builder.add(tiles[i].first, TilePack::Tile {
+          { index.data(), index.size() },
+          { data.back().data(), data.back().size() },
+          { bitmaps[i].data(), bitmaps[i].size() },
+          { nullptr, 0 } });
+    }
+    builder.write(path);
+  }
+
+  void loadSnapshot(const std::string &path) {
+    TilePack pack(path);
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+    for (const auto &quadKey : pack.getQuadKeys()) {
+      TilePack::Tile tile;
+      pack.find(quadKey, tile);
+      if (tile.index.size % sizeof(SnapshotEntry) != 0)
+        throw std::domain_error("Invalid snapshot: " + path);
+
+      bool isIndexed = tile.bitmap.size == 0 || isSpilled(quadKey) ||
+          elementsMap_.find(quadKey) != elementsMap_.end();
+      if (!isIndexed) {
+        std::istringstream bitmap(std::string(tile.bitmap.data, tile.bitmap.size));
+        stringIndex_.readBitmap(quadKey, bitmap);
+      }
+
+      for (std::size_t offset = 0; offset < tile.index.size; offset += sizeof(SnapshotEntry)) {
+        SnapshotEntry entry;
+        std::memcpy(&entry, tile.index.data + offset, sizeof(entry));
+        if (entry.offset > tile.data.size || entry.size > tile.data.size - entry.offset)
+          throw std::domain_error("Invalid snapshot: " + path);
+
+        auto element = ElementStream::read(tile.data.data + entry.offset, entry.size, entry.id);
+        add(*element, quadKey, isIndexed);
+      }
+    }
   }
 
   void erase(const utymap::QuadKey &quadKey) {
-    elementsMap_.erase(quadKey);
-    stringIndex_.erase(quadKey);
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+    remove(quadKey);
+    if (isSpilled(quadKey)) {
+      spillStore_->erase(quadKey);
+      spilledQuadKeys_.erase(quadKey);
+    }
   }
 
   void erase(const utymap::BoundingBox &bbox, const utymap::LodRange &range) {
     throw std::domain_error("Deletion by bounding box and lod range is not implemented.");
   }
 
+  std::vector<utymap::QuadKey> erase(const std::unordered_set<std::uint64_t> &ids, const utymap::LodRange &range) {
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+    std::vector<utymap::QuadKey> quadKeys;
+    for (auto &pair : elementsMap_) {
+      if (pair.first.levelOfDetail < range.start || pair.first.levelOfDetail > range.end)
+        continue;
+
+      const auto &elements = pair.second;
+      bool hasErased = false;
+      for (std::size_t order = 0; order < elements.size() && !hasErased; ++order)
+        hasErased = ids.find(elements.getId(order)) != ids.end();
+
+      if (hasErased) {
+        rebuild(pair.first, pair.second, ids);
+        quadKeys.push_back(pair.first);
+      }
+    }
+
+    if (spillStore_ != nullptr && !spilledQuadKeys_.empty()) {
+      auto spilled = spillStore_->erase(ids, range);
+      quadKeys.insert(quadKeys.end(), spilled.begin(), spilled.end());
+    }
+    return quadKeys;
+  }
+
+  std::size_t getFootprint() const {
+    utymap::utils::SharedLock lock(lock_);
+    return footprint_;
+  }
+
  private:
+  /// Adds element to quad key. Bitmap is updated only if element is indexed.
+  void add(const utymap::entities::Element &element, const QuadKey &quadKey, bool isIndexed) {
+    coverage_.add(quadKey);
+    // NOTE spilled quad key stays on disk: new elements are appended there.
+    if (isSpilled(quadKey)) {
+      spillStore_->save(element, quadKey);
+      return;
+    }
+
+    auto &elements = elementsMap_[quadKey];
+    auto order = static_cast<std::uint32_t>(elements.size());
+
+    auto location = locations_.find(element.id);
+    if (location == locations_.end())
+      locations_.emplace(element.id, Location{ quadKey, order });
+    else if (!isValid(location->second, element.id))
+      location->second = Location{ quadKey, order };
+
+    if (isIndexed)
+      stringIndex_.add(element, quadKey, order);
+    footprint_ -= elements.bytes();
+    elements.add(element, mode_);
+    footprint_ += elements.bytes();
+
+    touch(quadKey);
+    evict(quadKey);
+  }
+
   ElementMap::const_iterator begin(const utymap::QuadKey &quadKey) const {
     return elementsMap_.find(quadKey);
   }
@@ -139,13 +625,140 @@ class InMemoryElementStore::InMemoryElementStoreImpl {
     return elementsMap_.cend();
   }
 
+  /// Checks whether location still points to element with given id.
+  bool isValid(const Location &location, std::uint64_t id) const {
+    auto elements = elementsMap_.find(location.quadKey);
+    return elements != elementsMap_.end() &&
+        location.order < elements->second.size() &&
+        elements->second.getId(location.order) == id;
+  }
+
+  bool isSpilled(const utymap::QuadKey &quadKey) const {
+    return spilledQuadKeys_.find(quadKey) != spilledQuadKeys_.end();
+  }
+
+  /// Marks quad key as most recently used.
+  void touch(const utymap::QuadKey &quadKey) {
+    if (maxBytes_ == 0)
+      return;
+
+    std::lock_guard<std::mutex> lock(lruLock_);
+    auto position = lruPositions_.find(quadKey);
+    if (position != lruPositions_.end())
+      lru_.splice(lru_.begin(), lru_, position->second);
+    else
+      lruPositions_[quadKey] = lru_.insert(lru_.begin(), quadKey);
+  }
+
+  /// Evicts least recently used quad keys while memory budget is exceeded.
+  /// NOTE quad key which is being stored is never evicted, so single quad key
+  /// might exceed budget.
+  void evict(const utymap::QuadKey &quadKey) {
+    while (maxBytes_ > 0 && footprint_ > maxBytes_ && !lru_.empty() && !(lru_.back() == quadKey)) {
+      QuadKey evicted = lru_.back();
+      if (spillStore_ != nullptr)
+        spill(evicted);
+      remove(evicted);
+    }
+  }
+
+  /// Moves elements of quad key into spill store.
+  void spill(const utymap::QuadKey &quadKey) {
+    auto elements = elementsMap_.find(quadKey);
+    if (elements == elementsMap_.end())
+      return;
+
+    boost::filesystem::create_directories(spillPath_ + "/" + std::to_string(quadKey.levelOfDetail));
+
+    QuadKeyElements::Views views;
+    ElementSaveVisitor visitor(*spillStore_, quadKey);
+    spillStore_->beginBatch();
+    for (std::size_t order = 0; order < elements->second.size(); ++order)
+      elements->second.visit(order, visitor, views);
+    spillStore_->commitBatch();
+
+    spilledQuadKeys_.insert(quadKey);
+  }
+
+  /// Replaces elements of quad key with the same elements except erased ones.
+  /// Text index and locations of kept elements are updated with their new orders.
+  void rebuild(const utymap::QuadKey &quadKey, QuadKeyElements &elements, const std::unordered_set<std::uint64_t> &ids) {
+    QuadKeyElements kept;
+    stringIndex_.erase(quadKey);
+    ElementAddVisitor visitor([&](const Element &element) {
+      auto order = static_cast<std::uint32_t>(kept.size());
+      auto location = locations_.find(element.id);
+      if (location != locations_.end() && location->second.quadKey == quadKey)
+        location->second.order = order;
+      stringIndex_.add(element, quadKey, order);
+      kept.add(element, mode_);
+    });
+
+    QuadKeyElements::Views views;
+    for (std::size_t order = 0; order < elements.size(); ++order) {
+      auto id = elements.getId(order);
+      if (ids.find(id) == ids.end()) {
+        elements.visit(order, visitor, views);
+        continue;
+      }
+      auto location = locations_.find(id);
+      if (location != locations_.end() && location->second.quadKey == quadKey)
+        locations_.erase(location);
+    }
+
+    footprint_ -= elements.bytes();
+    footprint_ += kept.bytes();
+    elements = std::move(kept);
+  }
+
+  /// Removes elements of quad key from memory.
+  void remove(const utymap::QuadKey &quadKey) {
+    auto elements = elementsMap_.find(quadKey);
+    if (elements != elementsMap_.end()) {
+      footprint_ -= elements->second.bytes();
+      elementsMap_.erase(elements);
+    }
+    stringIndex_.erase(quadKey);
+
+    auto position = lruPositions_.find(quadKey);
+    if (position != lruPositions_.end()) {
+      lru_.erase(position->second);
+      lruPositions_.erase(position);
+    }
+  }
+
+  static std::string createSpillPath() {
+    auto path = boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("utymap-spill-%%%%-%%%%-%%%%");
+    boost::filesystem::create_directories(path);
+    return path.string();
+  }
+
   const StringTable &stringTable_;
+  const StorageMode mode_;
+  const std::size_t maxBytes_;
   ElementMap elementsMap_;
   InMemoryStringIndex stringIndex_;
+  std::size_t footprint_;
+  std::unordered_map<std::uint64_t, Location> locations_;
+  StoreCoverage coverage_;
+
+  mutable utymap::utils::ReadWriteLock lock_;
+  std::mutex lruLock_;
+  QuadKeyList lru_;
+  QuadKeyPositions lruPositions_;
+
+  const std::string spillPath_;
+  std::unique_ptr<PersistentElementStore> spillStore_;
+  QuadKeySet spilledQuadKeys_;
 };
 
-InMemoryElementStore::InMemoryElementStore(const StringTable &stringTable) :
-    ElementStore(stringTable), pimpl_(utymap::utils::make_unique<InMemoryElementStoreImpl>(stringTable)) {
+InMemoryElementStore::InMemoryElementStore(const StringTable &stringTable,
+                                           StorageMode mode,
+                                           std::size_t maxBytes,
+                                           bool isSpillEnabled) :
+    ElementStore(stringTable),
+    pimpl_(utymap::utils::make_unique<InMemoryElementStoreImpl>(stringTable, mode, maxBytes, isSpillEnabled)) {
 }
 
 InMemoryElementStore::~InMemoryElementStore() {
@@ -159,17 +772,60 @@ bool InMemoryElementStore::hasData(const utymap::QuadKey &quadKey) const {
   return pimpl_->hasData(quadKey);
 }
 
+bool InMemoryElementStore::mayHaveData(const utymap::QuadKey &quadKey) const {
+  return pimpl_->mayHaveData(quadKey);
+}
+
+bool InMemoryElementStore::mayHaveData(const utymap::BoundingBox &bbox, const utymap::LodRange &range) const {
+  return pimpl_->mayHaveData(bbox, range);
+}
+
+TileSummary InMemoryElementStore::getSummary(const utymap::QuadKey &quadKey) const {
+  return pimpl_->getSummary(quadKey);
+}
+
+void InMemoryElementStore::setSearchKeys(const std::string &keys) {
+  pimpl_->setSearchKeys(keys);
+}
+
+bool InMemoryElementStore::searchById(std::uint64_t id, ElementVisitor &visitor) {
+  return pimpl_->searchById(id, visitor);
+}
+
+void InMemoryElementStore::search(const std::string &notTerms,
+                                  const std::string &andTerms,
+                                  const std::string &orTerms,
+                                  const utymap::BoundingBox &bbox,
+                                  const utymap::LodRange &range,
+                                  ElementVisitor &visitor,
+                                  const utymap::CancellationToken &cancelToken) {
+  search(notTerms, andTerms, orTerms, bbox, range, 0, 0, visitor, cancelToken);
+}
+
 void InMemoryElementStore::search(const std::string &notTerms,
                                   const std::string &andTerms,
                                   const std::string &orTerms,
                                   const utymap::BoundingBox &bbox,
                                   const utymap::LodRange &range,
+                                  std::size_t offset,
+                                  std::size_t limit,
                                   ElementVisitor &visitor,
                                   const utymap::CancellationToken &cancelToken) {
-  BitmapIndex::Query query = { notTerms, andTerms, orTerms, bbox, range };
+  BitmapIndex::Query query = { notTerms, andTerms, orTerms, bbox, range, offset, limit };
   pimpl_->search(query, visitor, cancelToken);
 }
 
+std::size_t InMemoryElementStore::count(const std::string &notTerms,
+                                       const std::string &andTerms,
+                                       const std::string &orTerms,
+                                       const utymap::BoundingBox &bbox,
+                                       const utymap::LodRange &range,
+                                       std::size_t maxCount,
+                                       const utymap::CancellationToken &cancelToken) {
+  BitmapIndex::Query query = { notTerms, andTerms, orTerms, bbox, range, 0, 0 };
+  return pimpl_->count(query, maxCount, cancelToken);
+}
+
 void InMemoryElementStore::search(const utymap::QuadKey &quadKey,
                                   ElementVisitor &visitor,
                                   const utymap::CancellationToken &cancelToken) {
@@ -184,3 +840,20 @@ void InMemoryElementStore::erase(const utymap::BoundingBox &bbox,
                                  const utymap::LodRange &range) {
   pimpl_->erase(bbox, range);
 }
+
+std::vector<utymap::QuadKey> InMemoryElementStore::erase(const std::unordered_set<std::uint64_t> &ids,
+                                                         const utymap::LodRange &range) {
+  return pimpl_->erase(ids, range);
+}
+
+std::size_t InMemoryElementStore::getFootprint() const {
+  return pimpl_->getFootprint();
+}
+
+void InMemoryElementStore::saveSnapshot(const std::string &path) {
+  pimpl_->saveSnapshot(path);
+}
+
+void InMemoryElementStore::loadSnapshot(const std::string &path) {
+  pimpl_->loadSnapshot(path);
+}
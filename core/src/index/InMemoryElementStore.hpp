@@ -13,7 +13,22 @@ namespace index {
 /// Provides API to store elements in memory.
 class InMemoryElementStore final : public ElementStore {
  public:
-  explicit InMemoryElementStore(const utymap::index::StringTable &stringTable);
+  /// Specifies how elements are kept in memory.
+  enum class StorageMode {
+    /// Every element is copied to separate heap object.
+    Copy,
+    /// Elements of quad key share contiguous tag and coordinate buffers.
+    /// Visited nodes, ways and areas are temporary views valid only during visit call.
+    Arena
+  };
+
+  /// Creates store. If maxBytes is not zero, least recently used quad keys are
+  /// evicted when approximate size of elements exceeds it. Evicted quad keys are
+  /// dropped or, if spill is enabled, moved to temporary persistent store.
+  explicit InMemoryElementStore(const utymap::index::StringTable &stringTable,
+                                StorageMode mode = StorageMode::Copy,
+                                std::size_t maxBytes = 0,
+                                bool isSpillEnabled = false);
 
   virtual ~InMemoryElementStore();
 
@@ -25,6 +40,25 @@ class InMemoryElementStore final : public ElementStore {
               utymap::entities::ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) override;
 
+  void search(const std::string &notTerms,
+              const std::string &andTerms,
+              const std::string &orTerms,
+              const utymap::BoundingBox &bbox,
+              const utymap::LodRange &range,
+              std::size_t offset,
+              std::size_t limit,
+              utymap::entities::ElementVisitor &visitor,
+              const utymap::CancellationToken &cancelToken) override;
+
+  /// NOTE matches are counted using bitmaps without reading elements.
+  std::size_t count(const std::string &notTerms,
+                    const std::string &andTerms,
+                    const std::string &orTerms,
+                    const utymap::BoundingBox &bbox,
+                    const utymap::LodRange &range,
+                    std::size_t maxCount,
+                    const utymap::CancellationToken &cancelToken) override;
+
   void search(const utymap::QuadKey &quadKey,
               utymap::entities::ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) override;
@@ -34,11 +68,40 @@ class InMemoryElementStore final : public ElementStore {
 
   bool hasData(const utymap::QuadKey &quadKey) const override;
 
+  bool mayHaveData(const utymap::QuadKey &quadKey) const override;
+
+  bool mayHaveData(const utymap::BoundingBox &bbox, const utymap::LodRange &range) const override;
+
+  /// NOTE bytes of summary are memory used by elements.
+  utymap::index::TileSummary getSummary(const utymap::QuadKey &quadKey) const override;
+
+  void setSearchKeys(const std::string &keys) override;
+
+  bool searchById(std::uint64_t id,
+                  utymap::entities::ElementVisitor &visitor) override;
+
   void erase(const utymap::QuadKey &quadKey) override;
 
   void erase(const utymap::BoundingBox &bbox,
              const utymap::LodRange &range) override;
 
+  /// NOTE elements of affected quad keys are rebuilt without erased ones.
+  std::vector<utymap::QuadKey> erase(const std::unordered_set<std::uint64_t> &ids,
+                                     const utymap::LodRange &range) override;
+
+  /// Returns approximate amount of memory used by elements in bytes.
+  std::size_t getFootprint() const;
+
+  /// Writes elements of all quad keys with their search bitmaps to single memory mapped
+  /// file, so they can be restored later without parsing and styling.
+  /// NOTE tags are kept as string ids, so snapshot is valid only with the same string table.
+  void saveSnapshot(const std::string &path);
+
+  /// Adds elements of snapshot to store. Bitmaps of quad keys which are not in store yet
+  /// are restored as they are, other quad keys are indexed again.
+  /// Throws domain_error if file is not a valid snapshot.
+  void loadSnapshot(const std::string &path);
+
  private:
   class InMemoryElementStoreImpl;
   std::unique_ptr<InMemoryElementStoreImpl> pimpl_;
@@ -0,0 +1,21 @@
+#include "index/MappedFile.hpp"
+
+using namespace utymap::index;
+using namespace boost::interprocess;
+
+MappedFile::MappedFile() : size_(0) {}
+
+void MappedFile::map(const std::string &path, std::size_t size) {
+  unmap();
+  if (size == 0) return;
+
+  mapping_ = file_mapping(path.c_str(), read_only);
+  region_ = mapped_region(mapping_, read_only, 0, size);
+  size_ = size;
+}
+
+void MappedFile::unmap() {
+  region_ = mapped_region();
+  mapping_ = file_mapping();
+  size_ = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef INDEX_MAPPEDFILE_HPP_DEFINED
+#define INDEX_MAPPEDFILE_HPP_DEFINED
+
+#include "index/TilePack.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <string>
+
+namespace utymap {
+namespace index {
+
+/// Provides read only access to file content mapped into memory.
+class MappedFile final {
+ public:
+  MappedFile();
+
+  /// Maps first size bytes of the file. Empty file is not mapped.
+  void map(const std::string &path, std::size_t size);
+
+  void unmap();
+
+  const char *data() const {
+    return static_cast<const char *>(region_.get_address());
+  }
+
+  std::size_t size() const {
+    return size_;
+  }
+
+  TilePack::Section view() const {
+    return TilePack::Section{ data(), size_ };
+  }
+
+ private:
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+  std::size_t size_;
+};
+
+}
+}
+
+#endif // INDEX_MAPPEDFILE_HPP_DEFINED
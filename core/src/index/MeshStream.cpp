@@ -1,7 +1,14 @@
 #include "index/MeshStream.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
 
+using namespace utymap;
 using namespace utymap::index;
 using namespace utymap::math;
 
@@ -14,14 +21,6 @@ T read(std::istream &stream) {
   return data;
 }
 
-/// Restores double from float.
-template<>
-double read<double>(std::istream &stream) {
-  float data;
-  stream.read(reinterpret_cast<char *>(&data), sizeof(data));
-  return data;
-}
-
 template<typename T>
 void write(std::ostream &stream, const T &data) {
   stream.write(reinterpret_cast<const char *>(&data), sizeof(data));
@@ -34,6 +33,15 @@ void write<double>(std::ostream &stream, const double &data) {
   stream.write(reinterpret_cast<const char *>(&simplified), sizeof(simplified));
 }
 
+/// Reads given amount of floats into doubles.
+void readFloats(std::istream &stream, std::size_t size, std::vector<double> &data) {
+  thread_local std::vector<float> buffer;
+  buffer.resize(size);
+  if (size > 0)
+    stream.read(reinterpret_cast<char *>(buffer.data()), size * sizeof(float));
+  data.assign(buffer.begin(), buffer.end());
+}
+
 template<typename T>
 std::ostream &operator<<(std::ostream &stream, const std::vector<T> &data) {
   auto size = static_cast<std::uint32_t>(data.size());
@@ -43,25 +51,328 @@ std::ostream &operator<<(std::ostream &stream, const std::vector<T> &data) {
   return stream;
 }
 
+/// Reads items stored with the same layout in one call.
 template<typename T>
 std::istream &operator>>(std::istream &stream, std::vector<T> &data) {
   std::uint32_t size = 0;
   stream.read(reinterpret_cast<char *>(&size), sizeof(size));
   data.resize(size);
-  for (size_t i = 0; i < size; ++i)
-    data[i] = read<T>(stream);
+  if (size > 0)
+    stream.read(reinterpret_cast<char *>(data.data()), size * sizeof(T));
   return stream;
 }
 
+/// Reads doubles stored as floats in one call.
+std::istream &operator>>(std::istream &stream, std::vector<double> &data) {
+  std::uint32_t size = 0;
+  stream.read(reinterpret_cast<char *>(&size), sizeof(size));
+  readFloats(stream, size, data);
+  return stream;
+}
+
+/// Writes vertices as float offsets from the first one, so precision is kept for any location.
+void writeVertices(std::ostream &stream, const std::vector<double> &vertices) {
+  double originX = vertices.size() > 2 ? vertices[0] : 0;
+  double originY = vertices.size() > 2 ? vertices[1] : 0;
+  stream.write(reinterpret_cast<const char *>(&originX), sizeof(originX));
+  stream.write(reinterpret_cast<const char *>(&originY), sizeof(originY));
+
+  auto size = static_cast<std::uint32_t>(vertices.size());
+  write(stream, size);
+  for (std::size_t i = 0; i < vertices.size(); ++i) {
+    auto offset = i % 3 == 0 ? originX : (i % 3 == 1 ? originY : 0);
+    write<double>(stream, vertices[i] - offset);
+  }
+}
+
+void readVertices(std::istream &stream, std::vector<double> &vertices) {
+  double originX = 0, originY = 0;
+  stream.read(reinterpret_cast<char *>(&originX), sizeof(originX));
+  stream.read(reinterpret_cast<char *>(&originY), sizeof(originY));
+
+  auto size = read<std::uint32_t>(stream);
+  readFloats(stream, size, vertices);
+  for (std::size_t i = 0; i + 1 < size; i += 3) {
+    vertices[i] += originX;
+    vertices[i + 1] += originY;
+  }
+}
+
 std::ostream &operator<<(std::ostream &stream, const Mesh &mesh) {
-  return stream << mesh.name.c_str() << '\0' << mesh.vertices << mesh.triangles
-                << mesh.colors << mesh.uvs << mesh.uvMap;
+  stream << mesh.name.c_str() << '\0';
+  writeVertices(stream, mesh.vertices);
+  return stream << mesh.triangles << mesh.colors << mesh.uvs << mesh.uvMap;
 }
 
 std::istream &operator>>(std::istream &stream, Mesh &mesh) {
   std::getline(stream, mesh.name, '\0');
-  return stream >> mesh.vertices >> mesh.triangles
-                >> mesh.colors >> mesh.uvs >> mesh.uvMap;
+  readVertices(stream, mesh.vertices);
+  return stream >> mesh.triangles >> mesh.colors >> mesh.uvs >> mesh.uvMap;
+}
+
+/// Version of compact form.
+const std::uint8_t CompactVersion = 1;
+/// Max value of quantized component.
+const double QuantizedMax = 65535;
+/// Max amount of bytes which is read from stream at once.
+const std::size_t ReadChunkSize = 64 * 1024;
+
+/// Appends compact form to memory buffer which is written to stream at once.
+class CompactWriter final {
+ public:
+  explicit CompactWriter(std::string &buffer) : buffer_(buffer) {
+    buffer_.clear();
+  }
+
+  template<typename T>
+  void raw(const T &data) {
+    buffer_.append(reinterpret_cast<const char *>(&data), sizeof(data));
+  }
+
+  void varint(std::uint64_t value) {
+    while (value >= 0x80) {
+      buffer_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+  }
+
+  void zigzag(std::int64_t value) {
+    varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+  }
+
+  void quantized(double value, double min, double max) {
+    auto scaled = max > min ? (value - min) / (max - min) * QuantizedMax : 0;
+    raw(static_cast<std::uint16_t>(std::lround(std::max(0.0, std::min(QuantizedMax, scaled)))));
+  }
+
+  void string(const std::string &value) {
+    buffer_.append(value.c_str());
+    buffer_.push_back('\0');
+  }
+
+ private:
+  std::string &buffer_;
+};
+
+/// Reads compact form from memory buffer.
+class CompactReader final {
+ public:
+  explicit CompactReader(const std::string &buffer) : buffer_(buffer), position_(0) {}
+
+  template<typename T>
+  T raw() {
+    ensure(sizeof(T));
+    T data;
+    std::memcpy(&data, buffer_.data() + position_, sizeof(data));
+    position_ += sizeof(T);
+    return data;
+  }
+
+  std::uint64_t varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      ensure(1);
+      auto byte = static_cast<std::uint8_t>(buffer_[position_++]);
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return value;
+    }
+    throw std::domain_error("Invalid compact mesh varint.");
+  }
+
+  std::int64_t zigzag() {
+    auto value = varint();
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+  }
+
+  double quantized(double min, double max) {
+    return min + raw<std::uint16_t>() * (max - min) / QuantizedMax;
+  }
+
+  std::string string() {
+    auto end = buffer_.find('\0', position_);
+    if (end == std::string::npos)
+      throw std::domain_error("Invalid compact mesh name.");
+    auto value = buffer_.substr(position_, end - position_);
+    position_ = end + 1;
+    return value;
+  }
+
+  /// Reads size of array which items take at least given amount of bytes.
+  std::size_t size(std::size_t itemBytes) {
+    auto value = varint();
+    if (value > (buffer_.size() - position_) / itemBytes)
+      throw std::domain_error("Invalid compact mesh size.");
+    return static_cast<std::size_t>(value);
+  }
+
+ private:
+  void ensure(std::size_t size) const {
+    if (buffer_.size() - position_ < size)
+      throw std::domain_error("Compact mesh is truncated.");
+  }
+
+  const std::string &buffer_;
+  std::size_t position_;
+};
+
+/// Writes positions quantized within horizontal extent and elevation range.
+void writeCompactVertices(CompactWriter &writer, const std::vector<double> &vertices, const BoundingBox &bbox) {
+  double minX = bbox.minPoint.longitude, minY = bbox.minPoint.latitude;
+  double maxX = bbox.maxPoint.longitude, maxY = bbox.maxPoint.latitude;
+  double minZ = 0, maxZ = 0;
+  for (std::size_t i = 0; i + 2 < vertices.size(); i += 3) {
+    minX = std::min(minX, vertices[i]);
+    maxX = std::max(maxX, vertices[i]);
+    minY = std::min(minY, vertices[i + 1]);
+    maxY = std::max(maxY, vertices[i + 1]);
+    minZ = i == 0 ? vertices[i + 2] : std::min(minZ, vertices[i + 2]);
+    maxZ = i == 0 ? vertices[i + 2] : std::max(maxZ, vertices[i + 2]);
+  }
+
+  writer.varint(vertices.size() / 3);
+  writer.raw(minX); writer.raw(minY); writer.raw(maxX); writer.raw(maxY);
+  writer.raw(minZ); writer.raw(maxZ);
+  for (std::size_t i = 0; i + 2 < vertices.size(); i += 3) {
+    writer.quantized(vertices[i], minX, maxX);
+    writer.quantized(vertices[i + 1], minY, maxY);
+    writer.quantized(vertices[i + 2], minZ, maxZ);
+  }
+}
+
+void readCompactVertices(CompactReader &reader, std::vector<double> &vertices) {
+  auto count = reader.size(3 * sizeof(std::uint16_t));
+  auto minX = reader.raw<double>(), minY = reader.raw<double>();
+  auto maxX = reader.raw<double>(), maxY = reader.raw<double>();
+  auto minZ = reader.raw<double>(), maxZ = reader.raw<double>();
+  vertices.resize(3 * count);
+  for (std::size_t i = 0; i < vertices.size(); i += 3) {
+    vertices[i] = reader.quantized(minX, maxX);
+    vertices[i + 1] = reader.quantized(minY, maxY);
+    vertices[i + 2] = reader.quantized(minZ, maxZ);
+  }
+}
+
+/// Writes indices as zigzag encoded distance from high water mark: next not yet used
+/// vertex costs one byte as well as recently used ones.
+void writeCompactTriangles(CompactWriter &writer, const std::vector<int> &triangles) {
+  writer.varint(triangles.size());
+  std::int64_t next = 0;
+  for (auto index : triangles) {
+    writer.zigzag(next - index);
+    next = std::max(next, static_cast<std::int64_t>(index) + 1);
+  }
+}
+
+void readCompactTriangles(CompactReader &reader, std::vector<int> &triangles, std::size_t vertexCount) {
+  triangles.resize(reader.size(1));
+  std::int64_t next = 0;
+  for (auto &index : triangles) {
+    auto value = next - reader.zigzag();
+    if (value < 0 || value >= static_cast<std::int64_t>(vertexCount))
+      throw std::domain_error("Invalid compact mesh triangle.");
+    index = static_cast<int>(value);
+    next = std::max(next, value + 1);
+  }
+}
+
+/// Writes colors as indices in palette of distinct ones.
+void writeCompactColors(CompactWriter &writer, const std::vector<int> &colors) {
+  thread_local std::unordered_map<int, std::uint32_t> indices;
+  thread_local std::vector<int> palette;
+  indices.clear();
+  palette.clear();
+  for (auto color : colors) {
+    if (indices.emplace(color, static_cast<std::uint32_t>(palette.size())).second)
+      palette.push_back(color);
+  }
+
+  writer.varint(palette.size());
+  for (auto color : palette)
+    writer.raw(color);
+  writer.varint(colors.size());
+  for (auto color : colors)
+    writer.varint(indices[color]);
+}
+
+void readCompactColors(CompactReader &reader, std::vector<int> &colors) {
+  thread_local std::vector<int> palette;
+  palette.resize(reader.size(sizeof(int)));
+  for (auto &color : palette)
+    color = reader.raw<int>();
+
+  colors.resize(reader.size(1));
+  for (auto &color : colors) {
+    auto index = reader.varint();
+    if (index >= palette.size())
+      throw std::domain_error("Invalid compact mesh color.");
+    color = palette[index];
+  }
+}
+
+/// Writes uvs quantized within their range per component.
+void writeCompactUvs(CompactWriter &writer, const std::vector<double> &uvs) {
+  double minU = 0, minV = 0, maxU = 0, maxV = 0;
+  for (std::size_t i = 0; i + 1 < uvs.size(); i += 2) {
+    minU = i == 0 ? uvs[i] : std::min(minU, uvs[i]);
+    maxU = i == 0 ? uvs[i] : std::max(maxU, uvs[i]);
+    minV = i == 0 ? uvs[i + 1] : std::min(minV, uvs[i + 1]);
+    maxV = i == 0 ? uvs[i + 1] : std::max(maxV, uvs[i + 1]);
+  }
+
+  writer.varint(uvs.size() / 2);
+  writer.raw(static_cast<float>(minU)); writer.raw(static_cast<float>(minV));
+  writer.raw(static_cast<float>(maxU)); writer.raw(static_cast<float>(maxV));
+  for (std::size_t i = 0; i + 1 < uvs.size(); i += 2) {
+    writer.quantized(uvs[i], static_cast<float>(minU), static_cast<float>(maxU));
+    writer.quantized(uvs[i + 1], static_cast<float>(minV), static_cast<float>(maxV));
+  }
+}
+
+void readCompactUvs(CompactReader &reader, std::vector<double> &uvs) {
+  auto count = reader.size(2 * sizeof(std::uint16_t));
+  double minU = reader.raw<float>(), minV = reader.raw<float>();
+  double maxU = reader.raw<float>(), maxV = reader.raw<float>();
+  uvs.resize(2 * count);
+  for (std::size_t i = 0; i < uvs.size(); i += 2) {
+    uvs[i] = reader.quantized(minU, maxU);
+    uvs[i + 1] = reader.quantized(minV, maxV);
+  }
+}
+
+/// Writes texture regions as zigzag encoded deltas as neighbour regions are similar.
+void writeCompactUvMap(CompactWriter &writer, const std::vector<int> &uvMap) {
+  writer.varint(uvMap.size());
+  std::int64_t previous = 0;
+  for (auto value : uvMap) {
+    writer.zigzag(value - previous);
+    previous = value;
+  }
+}
+
+/// Returns amount of bytes left in stream or max value if stream cannot tell it.
+std::uint64_t getRemainingSize(std::istream &stream) {
+  auto position = stream.tellg();
+  if (position < 0)
+    return std::numeric_limits<std::uint64_t>::max();
+  if (!stream.seekg(0, std::ios::end)) {
+    stream.clear();
+    stream.seekg(position);
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+  auto end = stream.tellg();
+  stream.seekg(position);
+  return static_cast<std::uint64_t>(end - position);
+}
+
+void readCompactUvMap(CompactReader &reader, std::vector<int> &uvMap) {
+  uvMap.resize(reader.size(1));
+  std::int64_t previous = 0;
+  for (auto &value : uvMap) {
+    previous += reader.zigzag();
+    value = static_cast<int>(previous);
+  }
 }
 }
 
@@ -71,6 +382,61 @@ Mesh MeshStream::read(std::istream &stream) {
   return std::move(mesh);
 }
 
+void MeshStream::read(std::istream &stream, Mesh &mesh) {
+  stream >> mesh;
+}
+
 void MeshStream::write(std::ostream &stream, const Mesh &mesh) {
   stream << mesh;
 }
+
+Mesh MeshStream::readCompact(std::istream &stream) {
+  Mesh mesh("");
+  readCompact(stream, mesh);
+  return std::move(mesh);
+}
+
+void MeshStream::readCompact(std::istream &stream, Mesh &mesh) {
+  auto version = ::read<std::uint8_t>(stream);
+  auto size = ::read<std::uint32_t>(stream);
+  if (!stream || version != CompactVersion)
+    throw std::domain_error("Unsupported compact mesh.");
+
+  if (size > getRemainingSize(stream))
+    throw std::domain_error("Compact mesh is truncated.");
+
+  // NOTE buffer grows with data which is actually read, so broken size of unseekable
+  // stream does not allocate memory at once.
+  thread_local std::string buffer;
+  buffer.clear();
+  while (buffer.size() < size) {
+    auto offset = buffer.size();
+    buffer.resize(offset + std::min<std::size_t>(size - offset, ReadChunkSize));
+    stream.read(&buffer[offset], buffer.size() - offset);
+    if (!stream)
+      throw std::domain_error("Compact mesh is truncated.");
+  }
+
+  CompactReader reader(buffer);
+  mesh.name = reader.string();
+  readCompactVertices(reader, mesh.vertices);
+  readCompactTriangles(reader, mesh.triangles, mesh.vertices.size() / 3);
+  readCompactColors(reader, mesh.colors);
+  readCompactUvs(reader, mesh.uvs);
+  readCompactUvMap(reader, mesh.uvMap);
+}
+
+void MeshStream::writeCompact(std::ostream &stream, const Mesh &mesh, const BoundingBox &bbox) {
+  thread_local std::string buffer;
+  CompactWriter writer(buffer);
+  writer.string(mesh.name);
+  writeCompactVertices(writer, mesh.vertices, bbox);
+  writeCompactTriangles(writer, mesh.triangles);
+  writeCompactColors(writer, mesh.colors);
+  writeCompactUvs(writer, mesh.uvs);
+  writeCompactUvMap(writer, mesh.uvMap);
+
+  ::write(stream, CompactVersion);
+  ::write(stream, static_cast<std::uint32_t>(buffer.size()));
+  stream.write(buffer.data(), buffer.size());
+}
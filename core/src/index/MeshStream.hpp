@@ -1,6 +1,7 @@
 #ifndef INDEX_MESHSTREAM_HPP_DEFINED
 #define INDEX_MESHSTREAM_HPP_DEFINED
 
+#include "BoundingBox.hpp"
 #include "math/Mesh.hpp"
 #include <iostream>
 
@@ -12,8 +13,25 @@ class MeshStream final {
   /// Reads mesh from input stream.
   static utymap::math::Mesh read(std::istream &stream);
 
+  /// Reads mesh from input stream into given one reusing its memory.
+  static void read(std::istream &stream, utymap::math::Mesh &mesh);
+
   /// Writes mesh to output stream.
   static void write(std::ostream &stream, const utymap::math::Mesh &mesh);
+
+  /// Reads mesh written in compact form.
+  static utymap::math::Mesh readCompact(std::istream &stream);
+
+  /// Reads mesh written in compact form into given one reusing its memory.
+  static void readCompact(std::istream &stream, utymap::math::Mesh &mesh);
+
+  /// Writes mesh in compact form which is used for network delivery: positions and
+  /// uvs are quantized to 16 bits, triangles are delta encoded and colors refer to
+  /// palette. Horizontal positions are relative to given bounding box which is
+  /// expanded to mesh extent if necessary.
+  /// NOTE it is lossy: precision of positions is about 1/65535 of bounding box size.
+  static void writeCompact(std::ostream &stream, const utymap::math::Mesh &mesh,
+                           const utymap::BoundingBox &bbox);
 };
 
 }
@@ -1,15 +1,37 @@
-#include "index/BitmapStream.hpp"
-#include "index/ElementStream.hpp"
+#include "entities/ElementDispatch.hpp"
 #include "index/BitmapIndex.hpp"
+#include "index/BulkImport.hpp"
+#include "index/CompactionKeyVisitor.hpp"
 #include "index/ElementGeometryVisitor.hpp"
 #include "index/ElementVisitorFilter.hpp"
+#include "index/ElementVisitorLimit.hpp"
+#include "index/ElementVisitorUnique.hpp"
+#include "index/IdIndex.hpp"
 #include "index/PersistentElementStore.hpp"
+#include "index/QuadKeyData.hpp"
+#include "index/SharedPayloads.hpp"
+#include "index/TilePack.hpp"
+#include "index/TileSummaries.hpp"
+#include "index/StoreCoverage.hpp"
+#include "utils/GeoUtils.hpp"
 #include "utils/LruCache.hpp"
+#include "utils/ThreadPool.hpp"
 
+#include <boost/filesystem/operations.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
 #include <cstdio>
 #include <fstream>
+#include <functional>
+#include <map>
 #include <mutex>
-#include <tuple>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 using namespace utymap;
 using namespace utymap::index;
@@ -21,229 +43,955 @@ namespace {
 const std::string IndexFileExtension = ".idf";
 const std::string DataFileExtension = ".dat";
 const std::string bitmapFileExtension = ".bmp";
+const std::string bitmapLogFileExtension = ".bml";
+const std::string BoundsFileExtension = ".bbx";
+const std::string IdIndexFileName = "elements.ids";
+const std::string SharedPayloadFileName = "elements.dat";
+const std::string TileSummaryFileName = "tiles.sum";
+const std::string PackFileExtension = ".pack";
+const std::string TemporaryFileExtension = ".tmp";
 
-struct BitmapData {
-  const std::string path;
-  BitmapIndex::Bitmap data;
-
-  BitmapData(const std::string &bitmapPath) :
-    path(bitmapPath) {}
+/// Amount of file handles kept open by cached quad key: data, index and bounds files.
+const std::size_t FilesPerQuadKey = 3;
+}
 
-  BitmapData(BitmapData &&other) :
-    path(std::move(other.path)),
-    data(std::move(other.data)) {}
-};
+class PersistentElementStore::PersistentElementStoreImpl : BitmapIndex {
+  using QuadKeyDataMap = std::unordered_map<QuadKey, std::weak_ptr<QuadKeyData>, QuadKey::Hash>;
+  using QuadKeySet = std::set<QuadKey, QuadKey::Comparator>;
+ public:
+  PersistentElementStoreImpl(const std::string &dataPath,
+                             const StringTable &stringTable,
+                             std::size_t maxOpenFiles,
+                             std::size_t maxBitmapBytes,
+                             Compression compression):
+    BitmapIndex(stringTable),
+    dataPath_(dataPath),
+    lock_(),
+    cacheCapacity_(std::max<std::size_t>(1, maxOpenFiles / FilesPerQuadKey)),
+    maxBitmapBytes_(maxBitmapBytes),
+    bitmapBytes_(0),
+    compression_(compression),
+    payloads_(dataPath + "/" + SharedPayloadFileName),
+    cache_(cacheCapacity_),
+    liveData_(),
+    statistics_(),
+    ids_(dataPath + "/" + IdIndexFileName),
+    summaries_(dataPath + "/" + TileSummaryFileName),
+    batchDepth_(0),
+    isReadOnly_(false),
+    prefetchGeneration_(0),
+    sharedPrefetchPool_(nullptr) {
+#ifndef COMPRESSION_SUPPORTED_ENABLED
+    if (compression != Compression::None)
+      throw std::domain_error("Compression is not supported.");
+#endif
+  }
 
-/// Stores file handlers related to data of specific quad key.
-struct QuadKeyData {
-  std::unique_ptr<std::fstream> dataFile;
-  std::unique_ptr<std::fstream> indexFile;
-
-  QuadKeyData(const std::string &dataPath,
-              const std::string &indexPath,
-              const std::string &bitmapPath) :
-      dataFile(utymap::utils::make_unique<std::fstream>()),
-      indexFile(utymap::utils::make_unique<std::fstream>()),
-      dataPath_(dataPath),
-      indexPath_(indexPath),
-      bitmapPath_(bitmapPath),
-      bitmapData_(utymap::utils::make_unique<BitmapData>(bitmapPath)) {
-    using std::ios;
-    dataFile->open(dataPath, ios::in | ios::out | ios::binary | ios::app | ios::ate);
-    indexFile->open(indexPath, ios::in | ios::out | ios::binary | ios::app | ios::ate);
-  }
-
-  BitmapData& getBitmap() const {
-    if (bitmapData_->data.empty()) {
-      // TODO not thread safe!
-      std::fstream bitmapFile;
-      bitmapFile.open(bitmapData_->path, std::ios::in | std::ios::binary);
-      BitmapStream::read(bitmapFile, bitmapData_->data);
+  ~PersistentElementStoreImpl() {
+    // NOTE pending prefetch is dropped, running one stops after current quad key.
+    ++prefetchGeneration_;
+    {
+      std::lock_guard<std::mutex> lock(prefetchLock_);
+      if (prefetchTask_.valid())
+        prefetchTask_.wait();
     }
-    return *bitmapData_;
+    prefetchPool_.reset();
   }
 
-  QuadKeyData(const QuadKeyData &) = delete;
-  QuadKeyData &operator=(const QuadKeyData &) = delete;
+  void setPrefetchPool(ThreadPool *threadPool) {
+    std::lock_guard<std::mutex> lock(prefetchLock_);
+    sharedPrefetchPool_ = threadPool;
+  }
 
-  QuadKeyData(QuadKeyData &&other) :
-      dataFile(std::move(other.dataFile)),
-      indexFile(std::move(other.indexFile)),
-      dataPath_(std::move(other.dataPath_)),
-      indexPath_(std::move(other.indexPath_)),
-      bitmapPath_(std::move(other.bitmapPath_)),
-      bitmapData_(std::move(other.bitmapData_)) {}
+  void prefetch(const std::vector<QuadKey> &quadKeys) {
+    auto generation = ++prefetchGeneration_;
+    std::vector<QuadKey> keys(quadKeys.begin(),
+                              quadKeys.begin() + std::min(quadKeys.size(), cacheCapacity_));
 
-  ~QuadKeyData() {
-    closeAll();
-  }
+    std::lock_guard<std::mutex> lock(prefetchLock_);
+    auto threadPool = sharedPrefetchPool_;
+    if (threadPool == nullptr) {
+      if (prefetchPool_ == nullptr)
+        prefetchPool_ = utymap::utils::make_unique<ThreadPool>(1);
+      threadPool = prefetchPool_.get();
+    }
 
-  void erase() {
-    closeAll();
-    if (std::remove(dataPath_.c_str())) logEraseError(dataPath_);
-    if (std::remove(indexPath_.c_str())) logEraseError(indexPath_);
-    if (std::remove(bitmapPath_.c_str())) logEraseError(bitmapPath_);
+    // NOTE new prefetch waits for previous one, so prefetches of store run one by one
+    // even on shared pool. Prefetch is best effort: error is kept by future.
+    auto previous = std::make_shared<ThreadPool::Future>(std::move(prefetchTask_));
+    prefetchTask_ = threadPool->enqueue([this, keys, generation, previous]() {
+      if (previous->valid())
+        previous->wait();
+      *previous = ThreadPool::Future();
+      for (const auto &quadKey : keys) {
+        if (prefetchGeneration_ != generation)
+          break;
+        if (!hasData(quadKey))
+          continue;
+        getQuadKeyData(quadKey)->prefetch();
+        {
+          std::lock_guard<std::mutex> lock(lock_);
+          ++statistics_.prefetches;
+        }
+      }
+      trimBitmaps();
+    });
   }
 
-private:
-  void closeAll() const {
-    if (dataFile != nullptr && dataFile->good()) dataFile->close();
-    if (indexFile != nullptr && indexFile->good()) indexFile->close();
-  }
+  void store(const Element &element, const QuadKey &quadKey) {
+    ensureWritable();
+    if (batchDepth_ > 0 && bulkImport_ != nullptr) {
+      std::lock_guard<std::mutex> lock(bulkLock_);
+      bulkImport_->add(element, quadKey);
+      return;
+    }
 
-  static void logEraseError(const std::string &path) {
-    std::cerr << "Cannot erase " << path << std::endl;
+    write(element, quadKey, false);
   }
 
-  const std::string dataPath_;
-  const std::string indexPath_;
-  const std::string bitmapPath_;
-  std::unique_ptr<BitmapData> bitmapData_;
-};
-}
+  using BitmapIndex::setSearchKeys;
+  using BitmapIndex::setSearchThreads;
 
-using Cache = utymap::utils::LruCache<QuadKey, QuadKeyData, QuadKey::Comparator>;
+  void setBulkImportRunSize(std::size_t maxRunBytes) {
+    std::lock_guard<std::mutex> lock(bulkLock_);
+    if (bulkImport_ != nullptr && !bulkImport_->empty())
+      throw std::domain_error("Cannot change bulk import while batch is not committed.");
 
-// TODO improve thread safety!
-class PersistentElementStore::PersistentElementStoreImpl : BitmapIndex {
- public:
-  PersistentElementStoreImpl(const std::string &dataPath,
-                             const StringTable &stringTable):
-    BitmapIndex(stringTable),
-    dataPath_(dataPath),
-    lock_(),
-    cache_(12) {}
+    bulkImport_ = maxRunBytes > 0
+      ? utymap::utils::make_unique<BulkImport>(dataPath_ + "/bulk", maxRunBytes)
+      : nullptr;
+  }
 
-  void store(const Element &element, const QuadKey &quadKey) {
-    const auto &quadKeyData = getQuadKeyData(quadKey);
-    auto offset = static_cast<std::uint32_t>(quadKeyData->dataFile->tellg());
-    auto fileSize = quadKeyData->indexFile->tellg();
-    auto order = static_cast<std::uint32_t>(fileSize / (sizeof(element.id) + sizeof(offset)));
+  void beginBatch() {
+    ++batchDepth_;
+  }
 
-    // write element index
-    quadKeyData->indexFile->seekg(0, std::ios::end);
-    quadKeyData->indexFile->write(reinterpret_cast<const char *>(&element.id), sizeof(element.id));
-    quadKeyData->indexFile->write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+  void commitBatch() {
+    if (batchDepth_ == 0 || --batchDepth_ > 0)
+      return;
 
-    // write element data
-    quadKeyData->dataFile->seekg(0, std::ios::end);
-    ElementStream::write(*quadKeyData->dataFile, element);
+    mergeBulkImport();
 
-    // write element search data
-    add(element, quadKey, order);
-    // TODO we always clean/write the whole file here.
-    std::fstream bitmapFile(quadKeyData->getBitmap().path, std::ios::out | std::ios::binary | std::ios::trunc);
-    BitmapStream::write(bitmapFile, quadKeyData->getBitmap().data);
+    // NOTE global lock is not held while data is written to keep lock order.
+    std::vector<std::shared_ptr<QuadKeyData>> quadKeyDataList;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      for (const auto &pair : liveData_) {
+        auto quadKeyData = pair.second.lock();
+        if (quadKeyData != nullptr)
+          quadKeyDataList.push_back(quadKeyData);
+      }
+    }
+
+    for (const auto &quadKeyData : quadKeyDataList)
+      quadKeyData->commit();
+    ids_.flush();
   }
 
+  /// NOTE elements are filtered by bounds in notify before they are read.
   void search(const BitmapIndex::Query &query,
               ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) {
-    ElementVisitorFilter filter(visitor, [&](const Element &element) {
+    ElementVisitorLimit limit(visitor, query.offset, query.limit);
+    // NOTE copies of element stored in other quad keys are skipped. Lods are searched
+    // from the first one, so copy from the coarsest lod is visited.
+    ElementVisitorUnique unique(limit);
+    ElementVisitorFilter filter(unique, [&](const Element &element) {
       return ElementGeometryVisitor::intersects(element, query.boundingBox);
     });
-    BitmapIndex::search(query, filter);
+    BitmapIndex::search(compile(query), filter, [&]() {
+      return limit.isFull() || cancelToken.isCancelled();
+    });
+  }
+
+  std::size_t count(const BitmapIndex::Query &query,
+                    std::size_t maxCount,
+                    const utymap::CancellationToken &cancelToken) {
+    return BitmapIndex::count(compile(query), maxCount, [&]() {
+      return cancelToken.isCancelled();
+    });
   }
 
   void search(const QuadKey &quadKey,
               ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) {
-    const auto &quadKeyData = getQuadKeyData(quadKey);
-    auto count = static_cast<std::uint32_t>(quadKeyData->indexFile->tellg() /
-        (sizeof(std::uint64_t) + sizeof(std::uint32_t)));
+    getQuadKeyData(quadKey)->readAll(cancelToken, [&](std::unique_ptr<Element> element) {
+      dispatch(*element, visitor);
+    });
+  }
 
-    quadKeyData->indexFile->seekg(0, std::ios::beg);
-    for (std::uint32_t i = 0; i < count; ++i) {
-      if (cancelToken.isCancelled()) break;
+  /// NOTE matches are read one by one, so cursor doesn't hold locks between calls.
+  std::unique_ptr<ElementCursor> openCursor(const BitmapIndex::Query &query) {
+    return utymap::utils::make_unique<TextCursor>(*this, compile(query));
+  }
 
-      auto entry = readIndexEntry(*quadKeyData);
-      quadKeyData->dataFile->seekg(std::get<1>(entry), std::ios::beg);
+  std::unique_ptr<ElementCursor> openCursor(const QuadKey &quadKey) {
+    if (!hasData(quadKey))
+      return utymap::utils::make_unique<BufferedElementCursor>();
+    return utymap::utils::make_unique<QuadKeyCursor>(getQuadKeyData(quadKey));
+  }
 
-      ElementStream::read(*quadKeyData->dataFile, std::get<0>(entry ))->accept(visitor);
-    }
+  /// NOTE id index is not cleaned on erase: stale locations are skipped.
+  bool searchById(std::uint64_t id, ElementVisitor &visitor) {
+    IdIndex::Location location;
+    if (!ids_.find(id, location) || !hasData(location.quadKey))
+      return false;
+
+    auto quadKeyData = getQuadKeyData(location.quadKey);
+    if (location.order >= quadKeyData->count() || quadKeyData->getErased().get(location.order))
+      return false;
+
+    auto element = quadKeyData->readElement(location.order);
+    if (element->id != id)
+      return false;
+
+    dispatch(*element, visitor);
+    return true;
   }
 
   bool hasData(const QuadKey &quadKey) const override {
-    std::ifstream file(getFilePath(quadKey, DataFileExtension));
-    return file.good();
+    if (hasFiles(quadKey))
+      return true;
+    auto pack = getPack(quadKey.levelOfDetail);
+    return pack != nullptr && pack->contains(quadKey);
+  }
+
+  bool mayHaveData(const QuadKey &quadKey) const {
+    return getCoverage().mayContain(quadKey);
+  }
+
+  bool mayHaveData(const utymap::BoundingBox &bbox, const utymap::LodRange &range) const {
+    return getCoverage().mayIntersect(bbox, range);
+  }
+
+  TileSummary getSummary(const QuadKey &quadKey) {
+    return summaries_.get(quadKey);
   }
 
   void erase(const utymap::QuadKey &quadKey) override {
-    auto quadKeyData = getQuadKeyData(quadKey);
+    ensureWritable();
     {
-      std::lock_guard<std::mutex> lock(lock_);
+      auto quadKeyData = getQuadKeyData(quadKey);
       quadKeyData->erase();
-      cache_.clear();
+      setHasFiles(quadKey, false);
+      summaries_.reset(quadKey);
+      ids_.reset(quadKey);
     }
+    clearCache();
+
+    auto pack = getPack(quadKey.levelOfDetail);
+    if (pack == nullptr || !pack->contains(quadKey))
+      return;
+
+    TilePack::Builder builder;
+    for (const auto &packedQuadKey : pack->getQuadKeys()) {
+      TilePack::Tile tile;
+      if (!(packedQuadKey == quadKey) && pack->find(packedQuadKey, tile))
+        builder.add(packedQuadKey, tile);
+    }
+    writePack(quadKey.levelOfDetail, builder, pack);
   }
 
+  /// NOTE compacted elements are written into temporary files which replace files of
+  /// quad key once they are complete, so quad key keeps its data if writing fails.
+  void compact(const QuadKey &quadKey) {
+    ensureWritable();
+    if (!hasData(quadKey)) return;
+
+    auto quadKeyData = getQuadKeyData(quadKey);
+    std::vector<std::pair<CompactionKey, std::unique_ptr<Element>>> elements;
+    quadKeyData->readAll(CancellationToken(), [&](std::unique_ptr<Element> element) {
+      auto key = CompactionKeyVisitor::create(*element);
+      elements.push_back(std::make_pair(key, std::move(element)));
+    });
+
+    std::sort(elements.begin(), elements.end(), [](const std::pair<CompactionKey, std::unique_ptr<Element>> &lhs,
+                                                   const std::pair<CompactionKey, std::unique_ptr<Element>> &rhs) {
+      return lhs.first < rhs.first;
+    });
+
+    // NOTE files left by failed compaction are overwritten.
+    auto getTemporaryPath = [&](const std::string &extension) {
+      auto path = getFilePath(quadKey, extension + TemporaryFileExtension);
+      std::remove(path.c_str());
+      return path;
+    };
+    QuadKeyData compacted(getTemporaryPath(DataFileExtension),
+                          getTemporaryPath(IndexFileExtension),
+                          getTemporaryPath(bitmapFileExtension),
+                          getTemporaryPath(bitmapLogFileExtension),
+                          getTemporaryPath(BoundsFileExtension),
+                          compression_,
+                          nullptr,
+                          TilePack::Tile(),
+                          payloads_,
+                          bitmapBytes_);
+    std::vector<std::uint32_t> sizes;
+    sizes.reserve(elements.size());
+    compacted.write([&]() {
+      auto &bitmap = compacted.getBitmap();
+      for (const auto &pair : elements) {
+        std::uint32_t size;
+        auto order = compacted.append(*pair.second, size);
+        for (const auto token : tokenize(*pair.second))
+          bitmap.data[token].set(order);
+        sizes.push_back(size);
+      }
+      bitmap.isDirty = true;
+    });
+    quadKeyData->replace(compacted);
+
+    setHasFiles(quadKey, true);
+    summaries_.reset(quadKey);
+    ids_.reset(quadKey);
+    for (std::uint32_t order = 0; order < elements.size(); ++order) {
+      ids_.add(elements[order].second->id, quadKey, order);
+      summaries_.add(quadKey, *elements[order].second, sizes[order]);
+    }
+    summaries_.flush();
+    ids_.flush();
+    trimBitmaps();
+  }
+
+  void compact() {
+    ensureWritable();
+    flush();
+
+    // NOTE compacting packed quad key rewrites pack, so only quad keys with own files are compacted.
+    for (int levelOfDetail : getLevelOfDetails()) {
+      for (const auto &quadKey : getLooseQuadKeys(levelOfDetail))
+        compact(quadKey);
+    }
+  }
+
+  void pack(int levelOfDetail) {
+    ensureWritable();
+    flush();
+
+    TilePack::Builder builder;
+    auto looseQuadKeys = getLooseQuadKeys(levelOfDetail);
+    auto pack = getPack(levelOfDetail);
+    addToPack(builder, looseQuadKeys, pack);
+
+    if (builder.empty()) return;
+
+    writePack(levelOfDetail, builder, pack);
+
+    for (const auto &quadKey : looseQuadKeys) {
+      for (const auto &extension : { DataFileExtension, IndexFileExtension, bitmapFileExtension, bitmapLogFileExtension, BoundsFileExtension })
+        std::remove(getFilePath(quadKey, extension).c_str());
+      setHasFiles(quadKey, false);
+    }
+  }
+
+  /// Erases whole quad keys covered by bounding box. Elements of partially covered
+  /// quad keys which intersect bounding box are marked as erased.
   void erase(const utymap::BoundingBox &bbox, const utymap::LodRange &range) {
-    throw std::domain_error("Deletion by bounding box and lod range is not implemented.");
+    ensureWritable();
+    for (int lod = range.start; lod <= range.end; ++lod) {
+      std::vector<QuadKey> covered, intersected;
+      GeoUtils::visitTileRange(bbox, lod, GeoUtils::TileOrder::Morton, [&](const QuadKey &quadKey, const BoundingBox &quadKeyBbox) {
+        if (!hasData(quadKey)) return;
+        if (bbox.contains(quadKeyBbox))
+          covered.push_back(quadKey);
+        else
+          intersected.push_back(quadKey);
+      });
+
+      for (const auto &quadKey : covered)
+        erase(quadKey);
+
+      for (const auto &quadKey : intersected)
+        getQuadKeyData(quadKey)->erase(bbox);
+    }
+    trimBitmaps();
+  }
+
+  std::vector<QuadKey> erase(const std::unordered_set<std::uint64_t> &ids, const utymap::LodRange &range) {
+    ensureWritable();
+    std::vector<QuadKey> quadKeys;
+    for (int lod = range.start; lod <= range.end; ++lod) {
+      auto candidates = getLooseQuadKeys(lod);
+      auto pack = getPack(lod);
+      if (pack != nullptr) {
+        for (const auto &quadKey : pack->getQuadKeys()) {
+          if (!hasFiles(quadKey))
+            candidates.push_back(quadKey);
+        }
+      }
+
+      for (const auto &quadKey : candidates) {
+        if (getQuadKeyData(quadKey)->erase(ids))
+          quadKeys.push_back(quadKey);
+      }
+    }
+    trimBitmaps();
+    return quadKeys;
   }
 
   void flush() {
-    cache_.clear();
+    summaries_.flush();
+    ids_.flush();
+    clearCache();
+  }
+
+  /// Compacts store and writes all its data as tile packs into package directory.
+  void exportPackage(const std::string &packagePath) {
+    compact();
+    boost::filesystem::create_directories(packagePath);
+
+    for (int levelOfDetail : getLevelOfDetails()) {
+      TilePack::Builder builder;
+      addToPack(builder, getLooseQuadKeys(levelOfDetail), getPack(levelOfDetail));
+      auto path = packagePath + "/" + std::to_string(levelOfDetail) + PackFileExtension;
+      boost::filesystem::remove(path);
+      if (!builder.empty())
+        builder.write(path);
+    }
+
+    summaries_.flush();
+    ids_.flush();
+    for (const auto &fileName : { IdIndexFileName, SharedPayloadFileName, TileSummaryFileName }) {
+      auto path = packagePath + "/" + fileName;
+      boost::filesystem::remove(path);
+      if (boost::filesystem::exists(dataPath_ + "/" + fileName))
+        boost::filesystem::copy_file(dataPath_ + "/" + fileName, path);
+    }
+  }
+
+  void setReadOnly(bool isReadOnly) {
+    isReadOnly_ = isReadOnly;
+  }
+
+  CacheStatistics getCacheStatistics() {
+    std::lock_guard<std::mutex> lock(lock_);
+    CacheStatistics statistics = statistics_;
+    statistics.entries = cache_.size();
+    statistics.bitmapBytes = bitmapBytes_;
+    return statistics;
+  }
+
+  void trimCache(std::size_t maxBitmapBytes) {
+    Releaser releaser(*this);
+    std::lock_guard<std::mutex> lock(lock_);
+    auto bytes = cache_.weigh([](const QuadKeyData &quadKeyData) { return quadKeyData.getBitmapSize(); });
+    while (bytes > maxBitmapBytes && cache_.size() > 0)
+      bytes -= std::min(bytes, evictLast(releaser));
   }
 
  protected:
   void notify(const utymap::QuadKey& quadKey,
               const std::uint32_t order,
+              const utymap::BoundingBox &bbox,
               ElementVisitor &visitor) override {
     auto quadKeyData = getQuadKeyData(quadKey);
-    auto offset = order * (sizeof(std::uint64_t) + sizeof(std::uint32_t));
-
-    quadKeyData->indexFile->seekg(offset, std::ios::beg);
-    auto entry = readIndexEntry(*quadKeyData);
-    quadKeyData->dataFile->seekg(std::get<1>(entry), std::ios::beg);
-
-    ElementStream::read(*quadKeyData->dataFile, std::get<0>(entry))->accept(visitor);
+    if (quadKeyData->mayIntersect(order, bbox))
+      dispatch(*quadKeyData->readElement(order), visitor);
   }
 
+  /// NOTE is called only from add inside write.
   Bitmap& getBitmap(const utymap::QuadKey& quadKey) override {
     return getQuadKeyData(quadKey)->getBitmap().data;
   }
 
+  void readBitmap(const utymap::QuadKey &quadKey, const std::function<void(const Bitmap &)> &reader) override {
+    auto quadKeyData = getQuadKeyData(quadKey);
+    quadKeyData->readBitmap(reader);
+    trimBitmaps();
+  }
+
  private:
-  /// Gets quad key data.
+  /// Keeps quad key data which is removed from cache under lock and releases it once lock is
+  /// released, so buffers of data are flushed without blocking other quad keys. Data of these
+  /// quad keys is not created again until released data is flushed.
+  /// NOTE should be declared before lock guard.
+  class Releaser final {
+   public:
+    explicit Releaser(PersistentElementStoreImpl &store) : store_(store) {}
+
+    Releaser(const Releaser &) = delete;
+    Releaser &operator=(const Releaser &) = delete;
+
+    ~Releaser() {
+      if (released_.empty()) return;
+
+      std::vector<QuadKey> quadKeys;
+      for (const auto &pair : released_)
+        quadKeys.push_back(pair.first);
+      released_.clear();
+
+      std::lock_guard<std::mutex> lock(store_.lock_);
+      for (const auto &quadKey : quadKeys)
+        store_.releasing_.erase(store_.releasing_.find(quadKey));
+      store_.dataCondition_.notify_all();
+    }
+
+    /// Adds data of given quad key. NOTE should be called under lock.
+    void add(const QuadKey &quadKey, std::shared_ptr<QuadKeyData> quadKeyData) {
+      store_.releasing_.insert(quadKey);
+      released_.push_back(std::make_pair(quadKey, std::move(quadKeyData)));
+    }
+
+   private:
+    PersistentElementStoreImpl &store_;
+    std::vector<std::pair<QuadKey, std::shared_ptr<QuadKeyData>>> released_;
+  };
+
+  /// Gets quad key data. Data is created outside of lock as it opens files.
   std::shared_ptr<QuadKeyData> getQuadKeyData(const QuadKey& quadKey) {
+    Releaser releaser(*this);
+    for (;;) {
+      std::unique_lock<std::mutex> lock(lock_);
+      if (cache_.exists(quadKey)) {
+        ++statistics_.hits;
+        return cache_.get(quadKey);
+      }
+
+      // NOTE evicted data might be still in use by other thread: reuse it to keep single writer per quad key.
+      auto liveData = liveData_.find(quadKey);
+      if (liveData != liveData_.end()) {
+        auto quadKeyData = liveData->second.lock();
+        if (quadKeyData != nullptr) {
+          ++statistics_.misses;
+          putToCache(quadKey, quadKeyData, releaser);
+          return quadKeyData;
+        }
+      }
+
+      // NOTE data is created by one thread once previous data of quad key is flushed.
+      if (releasing_.count(quadKey) > 0 || creating_.count(quadKey) > 0) {
+        dataCondition_.wait(lock);
+        continue;
+      }
+
+      ++statistics_.misses;
+      creating_.insert(quadKey);
+      lock.unlock();
+      std::shared_ptr<QuadKeyData> quadKeyData;
+      try {
+        quadKeyData = createQuadKeyData(quadKey);
+      } catch (...) {
+        lock.lock();
+        creating_.erase(quadKey);
+        dataCondition_.notify_all();
+        throw;
+      }
+      lock.lock();
+      creating_.erase(quadKey);
+      dataCondition_.notify_all();
+
+      if (liveData_.size() > 2 * cacheCapacity_)
+        removeExpiredData();
+      liveData_[quadKey] = quadKeyData;
+      putToCache(quadKey, quadKeyData, releaser);
+      return quadKeyData;
+    }
+  }
+
+  std::shared_ptr<QuadKeyData> createQuadKeyData(const QuadKey &quadKey) {
+    // NOTE quad key files are preferred over pack as they contain latest data.
+    std::shared_ptr<const TilePack> pack;
+    TilePack::Tile packedTile = {};
+    if (!hasFiles(quadKey)) {
+      pack = getPack(quadKey.levelOfDetail);
+      if (pack != nullptr && !pack->find(quadKey, packedTile))
+        pack.reset();
+      // NOTE quad key which is not packed gets empty files.
+      if (pack == nullptr)
+        setHasFiles(quadKey, true);
+    }
+
+    return std::make_shared<QuadKeyData>(getFilePath(quadKey, DataFileExtension),
+                                         getFilePath(quadKey, IndexFileExtension),
+                                         getFilePath(quadKey, bitmapFileExtension),
+                                         getFilePath(quadKey, bitmapLogFileExtension),
+                                         getFilePath(quadKey, BoundsFileExtension),
+                                         compression_,
+                                         pack,
+                                         packedTile,
+                                         payloads_,
+                                         bitmapBytes_);
+  }
+
+  /// Puts data to cache evicting least recently used data if cache is full.
+  /// NOTE should be called under lock.
+  void putToCache(const QuadKey &quadKey, const std::shared_ptr<QuadKeyData> &quadKeyData, Releaser &releaser) {
+    if (cache_.size() >= cacheCapacity_)
+      evictLast(releaser);
+    cache_.put(quadKey, quadKeyData);
+  }
+
+  /// Evicts least recently used data and returns memory of its bitmap.
+  /// NOTE should be called under lock.
+  std::size_t evictLast(Releaser &releaser) {
+    const auto quadKey = cache_.lastKey();
+    auto quadKeyData = cache_.peek(quadKey);
+    cache_.removeLast();
+    ++statistics_.evictions;
+    auto bitmapSize = quadKeyData->getBitmapSize();
+    releaser.add(quadKey, std::move(quadKeyData));
+    return bitmapSize;
+  }
+
+  /// Removes all data from cache.
+  void clearCache() {
+    Releaser releaser(*this);
     std::lock_guard<std::mutex> lock(lock_);
+    for (const auto &pair : liveData_) {
+      auto quadKeyData = pair.second.lock();
+      if (quadKeyData != nullptr)
+        releaser.add(pair.first, std::move(quadKeyData));
+    }
+    cache_.clear();
+    liveData_.clear();
+  }
 
-    if (cache_.exists(quadKey))
-      return cache_.get(quadKey);
+  /// Removes entries of no longer used data.
+  void removeExpiredData() {
+    for (auto it = liveData_.begin(); it != liveData_.end();) {
+      if (it->second.expired())
+        it = liveData_.erase(it);
+      else
+        ++it;
+    }
+  }
 
-    cache_.put(quadKey, std::move(QuadKeyData(getFilePath(quadKey, DataFileExtension),
-                                              getFilePath(quadKey, IndexFileExtension),
-                                              getFilePath(quadKey, bitmapFileExtension))));
+  /// Evicts least recently used quad keys while loaded bitmaps exceed memory budget.
+  /// Most recently used quad key is always kept.
+  /// NOTE bitmaps of evicted data which is still in use are counted until it is released.
+  void trimBitmaps() {
+    if (bitmapBytes_ <= maxBitmapBytes_)
+      return;
 
-    return cache_.get(quadKey);
+    Releaser releaser(*this);
+    std::lock_guard<std::mutex> lock(lock_);
+    std::size_t bytes = bitmapBytes_;
+    while (bytes > maxBitmapBytes_ && cache_.size() > 1)
+      bytes -= std::min(bytes, evictLast(releaser));
   }
 
-  /// Gets full file path for given quad key
-  std::string getFilePath(const QuadKey &quadKey, const std::string &extension) const {
-    std::stringstream ss;
-    ss << dataPath_ << "/" << quadKey.levelOfDetail << "/" <<
-      GeoUtils::quadKeyToString(quadKey) << extension;
-    return ss.str();
+  /// Reads elements of quad key in chunks like search does, but next chunk is read only
+  /// when previous one is consumed.
+  class QuadKeyCursor final : public ElementCursor {
+   public:
+    explicit QuadKeyCursor(std::shared_ptr<QuadKeyData> quadKeyData) :
+        quadKeyData_(std::move(quadKeyData)), position_(0), hasMore_(true) {
+      quadKeyData_->beginScan(state_);
+    }
+
+    std::unique_ptr<Element> next() override {
+      if (position_ == elements_.size()) {
+        elements_.clear();
+        position_ = 0;
+        while (hasMore_ && elements_.empty())
+          hasMore_ = quadKeyData_->readChunk(state_, elements_);
+        if (elements_.empty())
+          return nullptr;
+      }
+      return std::move(elements_[position_++]);
+    }
+
+   private:
+    std::shared_ptr<QuadKeyData> quadKeyData_;
+    QuadKeyData::ScanState state_;
+    std::vector<std::unique_ptr<Element>> elements_;
+    std::size_t position_;
+    bool hasMore_;
+  };
+
+  /// Reads matches of text query one by one in the same order as search visits them.
+  class TextCursor final : public ElementCursor {
+   public:
+    TextCursor(PersistentElementStoreImpl &store, BitmapIndex::CompiledQuery query) :
+        store_(store), bbox_(query.boundingBox), matches_(store, std::move(query)) {}
+
+    std::unique_ptr<Element> next() override {
+      QuadKey quadKey;
+      std::uint32_t order;
+      while (matches_.next(quadKey, order)) {
+        if (quadKeyData_ == nullptr || !(quadKey_ == quadKey)) {
+          quadKeyData_ = store_.getQuadKeyData(quadKey);
+          quadKey_ = quadKey;
+        }
+        if (!quadKeyData_->mayIntersect(order, bbox_))
+          continue;
+
+        auto element = quadKeyData_->readElement(order);
+        // NOTE copies of element stored in other quad keys are skipped as by search.
+        if (!ElementGeometryVisitor::intersects(*element, bbox_) ||
+            !ids_[static_cast<int>(element->kind)].insert(element->id).second)
+          continue;
+        return element;
+      }
+      quadKeyData_.reset();
+      return nullptr;
+    }
+
+   private:
+    PersistentElementStoreImpl &store_;
+    const BoundingBox bbox_;
+    BitmapIndex::MatchCursor matches_;
+    QuadKey quadKey_;
+    std::shared_ptr<QuadKeyData> quadKeyData_;
+    std::unordered_set<std::uint64_t> ids_[4];
+  };
+
+  /// Writes element into given quad key. Bulk write doesn't use bitmap delta log:
+  /// bitmap is merged once quad key is complete.
+  void write(const Element &element, const QuadKey &quadKey, bool isBulk) {
+    auto quadKeyData = getQuadKeyData(quadKey);
+    quadKeyData->write([&]() {
+      std::uint32_t size;
+      auto order = quadKeyData->append(element, size);
+      ids_.add(element.id, quadKey, order);
+      summaries_.add(quadKey, element, size);
+      // outside of batch, data is written immediately unless it waits for compressed block
+      if (batchDepth_ == 0 && !isBulk) {
+        quadKeyData->flushBuffersExceptPartialBlock();
+        ids_.flush();
+      }
+
+      // write element search data: bitmap file is rewritten only on merge
+      auto tokens = add(element, quadKey, order);
+      if (isBulk)
+        quadKeyData->getBitmap().isDirty = true;
+      else
+        quadKeyData->getBitmap().append(order, tokens);
+    });
+    // NOTE packed quad key gets own files on first write.
+    setHasFiles(quadKey, true);
+    coverage_.add(quadKey);
+    trimBitmaps();
+  }
+
+  /// Writes elements collected by bulk import: every quad key is written once.
+  void mergeBulkImport() {
+    std::lock_guard<std::mutex> lock(bulkLock_);
+    if (bulkImport_ == nullptr || bulkImport_->empty())
+      return;
+
+    std::shared_ptr<QuadKeyData> current;
+    QuadKey currentQuadKey;
+    bulkImport_->merge([&](const QuadKey &quadKey, const Element &element) {
+      if (current == nullptr || !(currentQuadKey == quadKey)) {
+        if (current != nullptr) current->complete();
+        current = getQuadKeyData(quadKey);
+        currentQuadKey = quadKey;
+      }
+      write(element, quadKey, true);
+    });
+    if (current != nullptr) current->complete();
   }
 
-  /// Reads element info from index.
-  std::tuple<std::uint64_t, std::uint32_t> readIndexEntry(const QuadKeyData &quadKeyData) {
-    std::uint64_t id;
-    std::uint32_t offset;
-    quadKeyData.indexFile->read(reinterpret_cast<char *>(&id), sizeof(id));
-    quadKeyData.indexFile->read(reinterpret_cast<char *>(&offset), sizeof(offset));
-    return std::make_tuple(id, offset);
+  /// Returns true if quad key has its own data file. Doesn't touch file system
+  /// once files of level of detail are listed.
+  bool hasFiles(const QuadKey &quadKey) const {
+    std::lock_guard<std::mutex> lock(directoryLock_);
+    const auto &quadKeys = getLooseQuadKeySet(quadKey.levelOfDetail);
+    return quadKeys.find(quadKey) != quadKeys.end();
+  }
+
+  /// Updates existence of quad key files.
+  void setHasFiles(const QuadKey &quadKey, bool hasFiles) {
+    std::lock_guard<std::mutex> lock(directoryLock_);
+    auto &quadKeys = getLooseQuadKeySet(quadKey.levelOfDetail);
+    if (hasFiles)
+      quadKeys.insert(quadKey);
+    else
+      quadKeys.erase(quadKey);
+  }
+
+  /// Gets quad keys which have own files at given level of detail.
+  std::vector<QuadKey> getLooseQuadKeys(int levelOfDetail) const {
+    std::lock_guard<std::mutex> lock(directoryLock_);
+    const auto &quadKeys = getLooseQuadKeySet(levelOfDetail);
+    return std::vector<QuadKey>(quadKeys.begin(), quadKeys.end());
+  }
+
+  /// Gets set of quad keys with own files. Directory of level of detail is listed on first access.
+  /// NOTE should be called under directory lock.
+  QuadKeySet &getLooseQuadKeySet(int levelOfDetail) const {
+    auto quadKeys = looseQuadKeys_.find(levelOfDetail);
+    if (quadKeys != looseQuadKeys_.end())
+      return quadKeys->second;
+
+    auto &result = looseQuadKeys_[levelOfDetail];
+    boost::filesystem::path directory(dataPath_ + "/" + std::to_string(levelOfDetail));
+    if (!boost::filesystem::is_directory(directory))
+      return result;
+
+    for (boost::filesystem::directory_iterator end, it(directory); it != end; ++it) {
+      if (it->path().extension().string() != DataFileExtension)
+        continue;
+      try {
+        auto quadKey = GeoUtils::stringToQuadKey(it->path().stem().string());
+        if (quadKey.levelOfDetail == levelOfDetail)
+          result.insert(quadKey);
+      } catch (const std::domain_error &) {
+        // NOTE skip files which are not created by store.
+      }
+    }
+    return result;
+  }
+
+  /// Gets tile pack of given level of detail. Returns nullptr if there is no pack.
+  std::shared_ptr<const TilePack> getPack(int levelOfDetail) const {
+    std::lock_guard<std::mutex> lock(directoryLock_);
+    auto pack = packs_.find(levelOfDetail);
+    if (pack != packs_.end())
+      return pack->second;
+
+    std::shared_ptr<const TilePack> result;
+    auto path = getPackPath(levelOfDetail);
+    if (std::ifstream(path).good())
+      result = std::make_shared<TilePack>(path);
+    packs_[levelOfDetail] = result;
+    return result;
+  }
+
+  /// Gets coverage of store. It is built from quad keys of data path on first access
+  /// and written quad keys are added to it.
+  const StoreCoverage &getCoverage() const {
+    std::call_once(coverageFlag_, [&]() {
+      for (int levelOfDetail : getLevelOfDetails()) {
+        for (const auto &quadKey : getLooseQuadKeys(levelOfDetail))
+          coverage_.add(quadKey);
+        auto pack = getPack(levelOfDetail);
+        if (pack == nullptr) continue;
+        for (const auto &quadKey : pack->getQuadKeys())
+          coverage_.add(quadKey);
+      }
+    });
+    return coverage_;
+  }
+
+  /// Gets levels of detail which have directory or pack in data path.
+  std::set<int> getLevelOfDetails() const {
+    std::set<int> levelOfDetails;
+    boost::filesystem::path directory(dataPath_);
+    if (!boost::filesystem::is_directory(directory))
+      return levelOfDetails;
+
+    for (boost::filesystem::directory_iterator end, it(directory); it != end; ++it) {
+      auto name = it->path().stem().string();
+      if (!name.empty() && std::all_of(name.begin(), name.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+        levelOfDetails.insert(std::stoi(name));
+    }
+    return levelOfDetails;
+  }
+
+  /// Adds files of loose quad keys and packed tiles to builder.
+  /// NOTE files of quad key override its packed version.
+  void addToPack(TilePack::Builder &builder,
+                 const std::vector<QuadKey> &looseQuadKeys,
+                 const std::shared_ptr<const TilePack> &pack) const {
+    for (const auto &quadKey : looseQuadKeys) {
+      builder.add(quadKey,
+                  getFilePath(quadKey, IndexFileExtension),
+                  getFilePath(quadKey, DataFileExtension),
+                  getFilePath(quadKey, bitmapFileExtension),
+                  getFilePath(quadKey, BoundsFileExtension));
+    }
+
+    if (pack == nullptr) return;
+
+    std::set<QuadKey, QuadKey::Comparator> looseSet(looseQuadKeys.begin(), looseQuadKeys.end());
+    for (const auto &quadKey : pack->getQuadKeys()) {
+      TilePack::Tile tile;
+      if (looseSet.find(quadKey) == looseSet.end() && pack->find(quadKey, tile))
+        builder.add(quadKey, tile);
+    }
+  }
+
+  void ensureWritable() const {
+    if (isReadOnly_)
+      throw std::domain_error("Store is read only.");
+  }
+
+  /// Writes pack to temporary file and replaces old one with it.
+  void writePack(int levelOfDetail, TilePack::Builder &builder, std::shared_ptr<const TilePack> &pack) {
+    auto path = getPackPath(levelOfDetail);
+    auto tempPath = path + ".tmp";
+    if (!builder.empty())
+      builder.write(tempPath);
+
+    // NOTE old pack should be unmapped before it is replaced.
+    pack.reset();
+    {
+      std::lock_guard<std::mutex> lock(directoryLock_);
+      packs_.erase(levelOfDetail);
+    }
+
+    if (builder.empty())
+      boost::filesystem::remove(path);
+    else
+      boost::filesystem::rename(tempPath, path);
+  }
+
+  std::string getPackPath(int levelOfDetail) const {
+    return dataPath_ + "/" + std::to_string(levelOfDetail) + PackFileExtension;
+  }
+
+  /// Gets full file path for given quad key
+  std::string getFilePath(const QuadKey &quadKey, const std::string &extension) const {
+    std::string path;
+    path.reserve(dataPath_.size() + static_cast<std::size_t>(quadKey.levelOfDetail) + extension.size() + 5);
+    path.append(dataPath_).append("/").append(std::to_string(quadKey.levelOfDetail)).append("/");
+    GeoUtils::appendQuadKey(quadKey, path);
+    path.append(extension);
+    return path;
   }
 
   const std::string dataPath_;
   std::mutex lock_;
+  const std::size_t cacheCapacity_;
+  const std::size_t maxBitmapBytes_;
+  /// Estimated memory of all loaded bitmaps. It is kept by bitmaps, so it is read without lock.
+  /// NOTE is declared before cache, so it outlives cached quad key data.
+  std::atomic<std::size_t> bitmapBytes_;
+  const Compression compression_;
+  /// NOTE is declared before cache, so it outlives cached quad key data.
+  SharedPayloads payloads_;
+  /// Guards tile packs and quad keys with own files which answer hasData.
+  mutable std::mutex directoryLock_;
+  mutable std::map<int, std::shared_ptr<const TilePack>> packs_;
+  mutable std::map<int, QuadKeySet> looseQuadKeys_;
   utymap::utils::LruCache<QuadKey, QuadKeyData, QuadKey::Comparator> cache_;
+  QuadKeyDataMap liveData_;
+  /// Quad keys which data is released or created outside of lock.
+  std::multiset<QuadKey, QuadKey::Comparator> releasing_;
+  QuadKeySet creating_;
+  std::condition_variable dataCondition_;
+  CacheStatistics statistics_;
+  IdIndex ids_;
+  TileSummaries summaries_;
+  /// NOTE erased quad keys stay covered.
+  mutable StoreCoverage coverage_;
+  mutable std::once_flag coverageFlag_;
+  std::atomic<int> batchDepth_;
+  std::atomic<bool> isReadOnly_;
+  std::mutex bulkLock_;
+  std::unique_ptr<BulkImport> bulkImport_;
+  std::atomic<std::uint64_t> prefetchGeneration_;
+  std::mutex prefetchLock_;
+  /// Pool of application or null if store uses own prefetch thread.
+  ThreadPool *sharedPrefetchPool_;
+  std::unique_ptr<ThreadPool> prefetchPool_;
+  /// Last queued prefetch.
+  ThreadPool::Future prefetchTask_;
 };
 
+const std::size_t PersistentElementStore::DefaultMaxOpenFiles;
+const std::size_t PersistentElementStore::DefaultMaxBitmapBytes;
+
 PersistentElementStore::PersistentElementStore(const std::string &dataPath,
-                                               const StringTable &stringTable) :
+                                               const StringTable &stringTable,
+                                               std::size_t maxOpenFiles,
+                                               std::size_t maxBitmapBytes,
+                                               Compression compression) :
   ElementStore(stringTable),
-  pimpl_(utymap::utils::make_unique<PersistentElementStoreImpl>(dataPath, stringTable)) {}
+  pimpl_(utymap::utils::make_unique<PersistentElementStoreImpl>(dataPath, stringTable,
+                                                                maxOpenFiles, maxBitmapBytes, compression)) {}
 
 PersistentElementStore::~PersistentElementStore() {
 }
@@ -259,24 +1007,132 @@ void PersistentElementStore::search(const std::string &notTerms,
                                     const utymap::LodRange &range,
                                     utymap::entities::ElementVisitor &visitor,
                                     const utymap::CancellationToken &cancelToken) {
-  BitmapIndex::Query query = { notTerms, andTerms, orTerms, bbox, range };
+  search(notTerms, andTerms, orTerms, bbox, range, 0, 0, visitor, cancelToken);
+}
+
+void PersistentElementStore::search(const std::string &notTerms,
+                                    const std::string &andTerms,
+                                    const std::string &orTerms,
+                                    const utymap::BoundingBox &bbox,
+                                    const utymap::LodRange &range,
+                                    std::size_t offset,
+                                    std::size_t limit,
+                                    utymap::entities::ElementVisitor &visitor,
+                                    const utymap::CancellationToken &cancelToken) {
+  BitmapIndex::Query query = { notTerms, andTerms, orTerms, bbox, range, offset, limit };
   pimpl_->search(query, visitor, cancelToken);
 }
 
+std::size_t PersistentElementStore::count(const std::string &notTerms,
+                                         const std::string &andTerms,
+                                         const std::string &orTerms,
+                                         const utymap::BoundingBox &bbox,
+                                         const utymap::LodRange &range,
+                                         std::size_t maxCount,
+                                         const utymap::CancellationToken &cancelToken) {
+  BitmapIndex::Query query = { notTerms, andTerms, orTerms, bbox, range, 0, 0 };
+  return pimpl_->count(query, maxCount, cancelToken);
+}
+
 void PersistentElementStore::search(const QuadKey &quadKey,
                                     ElementVisitor &visitor,
                                     const utymap::CancellationToken &cancelToken) {
   pimpl_->search(quadKey, visitor, cancelToken);
 }
 
+std::unique_ptr<ElementCursor> PersistentElementStore::openCursor(const std::string &notTerms,
+                                                                  const std::string &andTerms,
+                                                                  const std::string &orTerms,
+                                                                  const utymap::BoundingBox &bbox,
+                                                                  const utymap::LodRange &range) {
+  BitmapIndex::Query query = { notTerms, andTerms, orTerms, bbox, range, 0, 0 };
+  return pimpl_->openCursor(query);
+}
+
+std::unique_ptr<ElementCursor> PersistentElementStore::openCursor(const QuadKey &quadKey) {
+  return pimpl_->openCursor(quadKey);
+}
+
+void PersistentElementStore::setSearchKeys(const std::string &keys) {
+  pimpl_->setSearchKeys(keys);
+}
+
+bool PersistentElementStore::searchById(std::uint64_t id, ElementVisitor &visitor) {
+  return pimpl_->searchById(id, visitor);
+}
+
 bool PersistentElementStore::hasData(const QuadKey &quadKey) const {
   return pimpl_->hasData(quadKey);
 }
 
+bool PersistentElementStore::mayHaveData(const QuadKey &quadKey) const {
+  return pimpl_->mayHaveData(quadKey);
+}
+
+bool PersistentElementStore::mayHaveData(const utymap::BoundingBox &bbox, const utymap::LodRange &range) const {
+  return pimpl_->mayHaveData(bbox, range);
+}
+
+TileSummary PersistentElementStore::getSummary(const QuadKey &quadKey) const {
+  return pimpl_->getSummary(quadKey);
+}
+
+void PersistentElementStore::beginBatch() {
+  pimpl_->beginBatch();
+}
+
+void PersistentElementStore::commitBatch() {
+  pimpl_->commitBatch();
+}
+
+void PersistentElementStore::prefetch(const std::vector<QuadKey> &quadKeys) {
+  pimpl_->prefetch(quadKeys);
+}
+
 void PersistentElementStore::flush() {
   pimpl_->flush();
 }
 
+void PersistentElementStore::setBulkImportRunSize(std::size_t maxRunBytes) {
+  pimpl_->setBulkImportRunSize(maxRunBytes);
+}
+
+void PersistentElementStore::setSearchThreads(std::size_t threadCount) {
+  pimpl_->setSearchThreads(threadCount);
+}
+
+void PersistentElementStore::setPrefetchPool(utymap::utils::ThreadPool *threadPool) {
+  pimpl_->setPrefetchPool(threadPool);
+}
+
+void PersistentElementStore::compact(const QuadKey &quadKey) {
+  pimpl_->compact(quadKey);
+}
+
+void PersistentElementStore::compact() {
+  pimpl_->compact();
+}
+
+void PersistentElementStore::pack(int levelOfDetail) {
+  pimpl_->pack(levelOfDetail);
+}
+
+void PersistentElementStore::exportPackage(const std::string &packagePath) {
+  pimpl_->exportPackage(packagePath);
+}
+
+void PersistentElementStore::setReadOnly(bool isReadOnly) {
+  pimpl_->setReadOnly(isReadOnly);
+}
+
+PersistentElementStore::CacheStatistics PersistentElementStore::getCacheStatistics() const {
+  return pimpl_->getCacheStatistics();
+}
+
+void PersistentElementStore::trimCache(std::size_t maxBitmapBytes) {
+  pimpl_->trimCache(maxBitmapBytes);
+}
+
 void PersistentElementStore::erase(const utymap::QuadKey &quadKey) {
   pimpl_->erase(quadKey);
 }
@@ -284,4 +1140,9 @@ void PersistentElementStore::erase(const utymap::QuadKey &quadKey) {
 void PersistentElementStore::erase(const utymap::BoundingBox &bbox,
                                    const utymap::LodRange &range) {
   pimpl_->erase(bbox, range);
-}
\ No newline at end of file
+}
+
+std::vector<utymap::QuadKey> PersistentElementStore::erase(const std::unordered_set<std::uint64_t> &ids,
+                                                           const utymap::LodRange &range) {
+  return pimpl_->erase(ids, range);
+}
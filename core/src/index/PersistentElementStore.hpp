@@ -4,6 +4,7 @@
 #include "QuadKey.hpp"
 #include "entities/Element.hpp"
 #include "index/ElementStore.hpp"
+#include "utils/ThreadPool.hpp"
 
 #include <memory>
 
@@ -13,8 +14,38 @@ namespace index {
 /// Provides API to store elements in persistent store.
 class PersistentElementStore final : public ElementStore {
  public:
+  /// Default limit of file handles kept open by quad key data cache.
+  static const std::size_t DefaultMaxOpenFiles = 24;
+  /// Default limit of memory consumed by cached bitmaps.
+  static const std::size_t DefaultMaxBitmapBytes = 32 * 1024 * 1024;
+
+  /// Specifies compression of element data files.
+  enum class Compression {
+    /// Elements are stored as is.
+    None,
+    /// Elements are grouped into zlib compressed blocks.
+    Zlib
+  };
+
+  /// Contains counters of quad key data cache.
+  struct CacheStatistics {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    /// Amount of cached quad keys.
+    std::size_t entries = 0;
+    /// Estimated memory consumed by cached bitmaps.
+    std::size_t bitmapBytes = 0;
+    /// Amount of quad keys warmed by prefetch.
+    std::uint64_t prefetches = 0;
+  };
+
+  /// NOTE compression is applied to new data files only: existing files keep their format.
   PersistentElementStore(const std::string &path,
-                         const utymap::index::StringTable &stringTable);
+                         const utymap::index::StringTable &stringTable,
+                         std::size_t maxOpenFiles = DefaultMaxOpenFiles,
+                         std::size_t maxBitmapBytes = DefaultMaxBitmapBytes,
+                         Compression compression = Compression::None);
 
   virtual ~PersistentElementStore();
 
@@ -26,23 +57,122 @@ class PersistentElementStore final : public ElementStore {
               utymap::entities::ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) override;
 
+  void search(const std::string &notTerms,
+              const std::string &andTerms,
+              const std::string &orTerms,
+              const utymap::BoundingBox &bbox,
+              const utymap::LodRange &range,
+              std::size_t offset,
+              std::size_t limit,
+              utymap::entities::ElementVisitor &visitor,
+              const utymap::CancellationToken &cancelToken) override;
+
+  /// NOTE matches are counted using bitmaps without reading elements.
+  std::size_t count(const std::string &notTerms,
+                    const std::string &andTerms,
+                    const std::string &orTerms,
+                    const utymap::BoundingBox &bbox,
+                    const utymap::LodRange &range,
+                    std::size_t maxCount,
+                    const utymap::CancellationToken &cancelToken) override;
+
   void search(const utymap::QuadKey &quadKey,
               utymap::entities::ElementVisitor &visitor,
               const utymap::CancellationToken &cancelToken) override;
 
+  /// NOTE bitmaps of quad keys are evaluated and elements are read while cursor is pulled.
+  std::unique_ptr<ElementCursor> openCursor(const std::string &notTerms,
+                                            const std::string &andTerms,
+                                            const std::string &orTerms,
+                                            const utymap::BoundingBox &bbox,
+                                            const utymap::LodRange &range) override;
+
+  /// NOTE elements are read in chunks while cursor is pulled.
+  std::unique_ptr<ElementCursor> openCursor(const utymap::QuadKey &quadKey) override;
+
   void save(const utymap::entities::Element &element,
             const utymap::QuadKey &quadKey) override;
 
   bool hasData(const utymap::QuadKey &quadKey) const override;
 
+  /// NOTE coverage is built from data path on first call.
+  bool mayHaveData(const utymap::QuadKey &quadKey) const override;
+
+  bool mayHaveData(const utymap::BoundingBox &bbox, const utymap::LodRange &range) const override;
+
+  /// NOTE summaries are recorded when elements are written, so they are kept by package too.
+  utymap::index::TileSummary getSummary(const utymap::QuadKey &quadKey) const override;
+
+  void setSearchKeys(const std::string &keys) override;
+
+  bool searchById(std::uint64_t id,
+                  utymap::entities::ElementVisitor &visitor) override;
+
+  /// Opens files, loads bitmaps and reads pages of given quad keys on background thread.
+  /// New call replaces quad keys which are not prefetched yet. At most cache capacity
+  /// quad keys are prefetched, quad keys without data are skipped.
+  /// NOTE prefetch should not be used concurrently with pack or compact.
+  void prefetch(const std::vector<utymap::QuadKey> &quadKeys) override;
+
   void erase(const utymap::QuadKey &quadKey) override;
 
   void erase(const utymap::BoundingBox &bbox,
              const utymap::LodRange &range) override;
 
-  /// Flushes cached internally data.
+  /// NOTE matched elements are marked as erased, packed quad keys with such elements are unpacked.
+  std::vector<utymap::QuadKey> erase(const std::unordered_set<std::uint64_t> &ids,
+                                     const utymap::LodRange &range) override;
+
+  void beginBatch() override;
+
+  void commitBatch() override;
+
+  /// Flushes cached internally data and merges bitmap delta logs into bitmap files.
   void flush();
 
+  /// Enables bulk import mode when max run size is not zero. In this mode elements
+  /// saved inside batch are sorted by quad key into run files of given size which are
+  /// merged on commit, so files of every quad key are written once.
+  /// NOTE elements are not visible to readers until batch is committed.
+  void setBulkImportRunSize(std::size_t maxRunBytes);
+
+  /// Enables parallel text search: bitmaps of quad keys are evaluated on given amount
+  /// of threads while elements are read and visited on calling thread. Zero disables it.
+  void setSearchThreads(std::size_t threadCount);
+
+  /// Sets pool which runs prefetch. Without pool, prefetch uses own thread.
+  void setPrefetchPool(utymap::utils::ThreadPool *threadPool);
+
+  /// Moves files of all quad keys at given level of detail into single tile pack file.
+  /// Packed quad keys are read directly from pack and unpacked on first write.
+  /// NOTE store should not be used concurrently while packing.
+  void pack(int levelOfDetail);
+
+  /// Rewrites data of given quad key without erased elements: elements are sorted
+  /// by type and spatial order and bitmap is rebuilt.
+  /// NOTE store should not be used concurrently while compacting.
+  void compact(const utymap::QuadKey &quadKey);
+
+  /// Compacts all quad keys which have own files. Packed quad keys should be compacted
+  /// individually or before packing.
+  void compact();
+
+  /// Compacts store and exports it as package: directory with tile pack per level of detail
+  /// and id index. Package can be opened as store with its own path and set read only.
+  /// NOTE elements reference string ids, so package should be used with string table
+  /// exported by StringTable::exportTo.
+  void exportPackage(const std::string &packagePath);
+
+  /// Rejects modifications of store when enabled: they throw domain_error.
+  void setReadOnly(bool isReadOnly);
+
+  /// Returns statistics of quad key data cache.
+  CacheStatistics getCacheStatistics() const;
+
+  /// Evicts least recently used quad keys until their bitmaps use at most given amount
+  /// of memory. Evicted quad keys are loaded again on next access.
+  void trimCache(std::size_t maxBitmapBytes);
+
  private:
   class PersistentElementStoreImpl;
   std::unique_ptr<PersistentElementStoreImpl> pimpl_;
@@ -0,0 +1,731 @@
+#include "entities/ElementDispatch.hpp"
+#include "index/ElementGeometryVisitor.hpp"
+#include "index/QuadKeyData.hpp"
+#include "utils/CoreUtils.hpp"
+#include "utils/Metrics.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+/// Size of index entry: element id and its offset in data file.
+const std::size_t IndexEntrySize = sizeof(std::uint64_t) + sizeof(std::uint32_t);
+
+/// Step used to touch mapped pages while prefetching.
+const std::size_t PageSize = 4096;
+
+/// Bounding box of element stored in bounds file at position of its order.
+/// Values are rounded outwards, so element which doesn't intersect stored box
+/// doesn't intersect query.
+struct BoundsEntry {
+  float minLatitude;
+  float minLongitude;
+  float maxLatitude;
+  float maxLongitude;
+
+  static BoundsEntry create(const Element &element) {
+    ElementGeometryVisitor visitor;
+    dispatch(element, visitor);
+    const auto &bbox = visitor.boundingBox;
+    return BoundsEntry{ roundDown(bbox.minPoint.latitude), roundDown(bbox.minPoint.longitude),
+                        roundUp(bbox.maxPoint.latitude), roundUp(bbox.maxPoint.longitude) };
+  }
+
+  bool intersects(const BoundingBox &bbox) const {
+    return std::max<double>(minLatitude, bbox.minPoint.latitude) <= std::min<double>(maxLatitude, bbox.maxPoint.latitude) &&
+        std::max<double>(minLongitude, bbox.minPoint.longitude) <= std::min<double>(maxLongitude, bbox.maxPoint.longitude);
+  }
+
+ private:
+  static float roundDown(double value) {
+    auto result = static_cast<float>(value);
+    return result > value ? std::nextafter(result, -std::numeric_limits<float>::infinity()) : result;
+  }
+
+  static float roundUp(double value) {
+    auto result = static_cast<float>(value);
+    return result < value ? std::nextafter(result, std::numeric_limits<float>::infinity()) : result;
+  }
+};
+
+/// Starts data file which stores compressed element blocks instead of elements.
+const char CompressedFileMagic[] = { 'U', 'T', 'Z', '1' };
+/// Amount of raw element data collected before block is compressed.
+const std::size_t BlockSize = 64 * 1024;
+
+std::string compressBlock(const std::string &data) {
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+  uLongf size = compressBound(static_cast<uLong>(data.size()));
+  std::string result(size, '\0');
+  if (compress(reinterpret_cast<Bytef *>(&result[0]), &size,
+               reinterpret_cast<const Bytef *>(data.data()), static_cast<uLong>(data.size())) != Z_OK)
+    throw std::domain_error("Failed to compress element block.");
+  result.resize(size);
+  return result;
+#else
+  throw std::domain_error("Compression is not supported.");
+#endif
+}
+
+std::string decompressBlock(const char *data, std::size_t size, std::size_t rawSize) {
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+  uLongf resultSize = static_cast<uLongf>(rawSize);
+  std::string result(rawSize, '\0');
+  if (uncompress(reinterpret_cast<Bytef *>(&result[0]), &resultSize,
+                 reinterpret_cast<const Bytef *>(data), static_cast<uLong>(size)) != Z_OK || resultSize != rawSize)
+    throw std::domain_error("Failed to decompress element block.");
+  return result;
+#else
+  throw std::domain_error("Compression is not supported.");
+#endif
+}
+
+/// Starts element record which refers to payload in shared payload file instead of
+/// element data: it is followed by payload offset and size.
+const char SharedPayloadMarker = 0x20;
+/// Size of element record which refers to shared payload.
+const std::size_t SharedPayloadRecordSize = 1 + sizeof(std::uint64_t) + sizeof(std::uint32_t);
+/// Payloads which are smaller are always stored in quad key.
+const std::size_t MinSharedPayloadSize = 64;
+}
+
+/// Raw block starts with table of element offsets inside block which is followed by element data.
+struct QuadKeyData::BlockHeader {
+  std::uint32_t rawSize;
+  std::uint32_t compressedSize;
+  /// Order of first element in block.
+  std::uint32_t firstOrder;
+  /// Amount of elements in block.
+  std::uint32_t count;
+};
+
+QuadKeyData::QuadKeyData(const std::string &dataPath,
+                         const std::string &indexPath,
+                         const std::string &bitmapPath,
+                         const std::string &bitmapLogPath,
+                         const std::string &boundsPath,
+                         PersistentElementStore::Compression compression,
+                         std::shared_ptr<const TilePack> pack,
+                         const TilePack::Tile &packedTile,
+                         SharedPayloads &payloads,
+                         std::atomic<std::size_t> &bitmapBytes) :
+    dataFile_(utymap::utils::make_unique<std::fstream>()),
+    indexFile_(utymap::utils::make_unique<std::fstream>()),
+    boundsFile_(utymap::utils::make_unique<std::fstream>()),
+    dataPath_(dataPath),
+    indexPath_(indexPath),
+    bitmapPath_(bitmapPath),
+    boundsPath_(boundsPath),
+    bitmapData_(utymap::utils::make_unique<BitmapData>(bitmapPath, bitmapLogPath, bitmapBytes)),
+    dataBuffer_(utymap::utils::make_unique<std::ostringstream>()),
+    indexBuffer_(utymap::utils::make_unique<std::ostringstream>()),
+    boundsBuffer_(utymap::utils::make_unique<std::ostringstream>()),
+    lock_(utymap::utils::make_unique<ReadWriteLock>()),
+    blockLock_(utymap::utils::make_unique<std::mutex>()),
+    compression_(compression),
+    pack_(std::move(pack)),
+    packedTile_(packedTile),
+    payloads_(&payloads),
+    dataSize_(0),
+    indexSize_(0),
+    boundsSize_(0),
+    isMapped_(false) {
+  if (pack_ == nullptr) {
+    openFiles();
+    return;
+  }
+
+  dataSize_ = packedTile_.data.size;
+  indexSize_ = packedTile_.index.size;
+  boundsSize_ = packedTile_.bounds.size;
+  hasBounds_ = hasValidBounds();
+  isCompressed_ = dataSize_ == 0
+    ? compression_ != PersistentElementStore::Compression::None
+    : hasCompressedMagic(packedTile_.data.data, packedTile_.data.size);
+  bitmapData_->setPacked(packedTile_.bitmap);
+}
+
+QuadKeyData::QuadKeyData(QuadKeyData &&other) :
+    dataFile_(std::move(other.dataFile_)),
+    indexFile_(std::move(other.indexFile_)),
+    boundsFile_(std::move(other.boundsFile_)),
+    dataPath_(std::move(other.dataPath_)),
+    indexPath_(std::move(other.indexPath_)),
+    bitmapPath_(std::move(other.bitmapPath_)),
+    boundsPath_(std::move(other.boundsPath_)),
+    bitmapData_(std::move(other.bitmapData_)),
+    dataBuffer_(std::move(other.dataBuffer_)),
+    indexBuffer_(std::move(other.indexBuffer_)),
+    boundsBuffer_(std::move(other.boundsBuffer_)),
+    lock_(std::move(other.lock_)),
+    blockLock_(std::move(other.blockLock_)),
+    compression_(other.compression_),
+    pack_(std::move(other.pack_)),
+    packedTile_(other.packedTile_),
+    payloads_(other.payloads_),
+    pendingIds_(std::move(other.pendingIds_)),
+    pendingOffsets_(std::move(other.pendingOffsets_)),
+    members_(std::move(other.members_)),
+    dataSize_(other.dataSize_),
+    indexSize_(other.indexSize_),
+    boundsSize_(other.boundsSize_),
+    isCompressed_(other.isCompressed_),
+    hasBounds_(other.hasBounds_),
+    isMapped_(false) {}
+
+QuadKeyData::~QuadKeyData() {
+  if (dataBuffer_ != nullptr) flushAllBuffers();
+  closeAll();
+}
+
+void QuadKeyData::commit() {
+  std::lock_guard<ReadWriteLock> lock(*lock_);
+  flushAllBuffers();
+}
+
+void QuadKeyData::complete() {
+  std::lock_guard<ReadWriteLock> lock(*lock_);
+  flushAllBuffers();
+  bitmapData_->merge();
+}
+
+std::uint32_t QuadKeyData::append(const Element &element, std::uint32_t &size) {
+  auto order = static_cast<std::uint32_t>(indexSize_ / IndexEntrySize);
+  indexSize_ += IndexEntrySize;
+  isMapped_ = false;
+
+  if (hasBounds_) {
+    auto bounds = BoundsEntry::create(element);
+    boundsBuffer_->write(reinterpret_cast<const char *>(&bounds), sizeof(bounds));
+    boundsSize_ += sizeof(bounds);
+  }
+
+  bool hasReferences = false;
+  std::ostringstream stream;
+  ElementStream::write(stream, element, [&](const Element &member, std::uint32_t &memberOrder) {
+    bool isFound = findMember(member, memberOrder);
+    hasReferences |= isFound;
+    return isFound;
+  });
+  auto data = stream.str();
+  size = static_cast<std::uint32_t>(data.size());
+  if (element.kind != ElementKind::Relation)
+    members_[element.id] = MemberEntry{ order, data.size(), std::hash<std::string>()(data) };
+
+  // NOTE references to members are valid only inside quad key, so such payload is not shared.
+  std::uint64_t payloadOffset;
+  if (!hasReferences && data.size() >= MinSharedPayloadSize && payloads_->share(element.id, data, payloadOffset)) {
+    auto size = static_cast<std::uint32_t>(data.size());
+    data.resize(SharedPayloadRecordSize);
+    data[0] = SharedPayloadMarker;
+    std::memcpy(&data[1], &payloadOffset, sizeof(payloadOffset));
+    std::memcpy(&data[1 + sizeof(payloadOffset)], &size, sizeof(size));
+  }
+
+  // NOTE index entries of compressed elements are written with their block.
+  if (isCompressed_) {
+    pendingIds_.push_back(element.id);
+    pendingOffsets_.push_back(static_cast<std::uint32_t>(dataBuffer_->tellp()));
+    dataBuffer_->write(data.data(), data.size());
+    if (static_cast<std::size_t>(dataBuffer_->tellp()) >= BlockSize)
+      flushBlock();
+    return order;
+  }
+
+  auto offset = static_cast<std::uint32_t>(dataSize_);
+  indexBuffer_->write(reinterpret_cast<const char *>(&element.id), sizeof(element.id));
+  indexBuffer_->write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+
+  dataBuffer_->write(data.data(), data.size());
+  dataSize_ += data.size();
+
+  return order;
+}
+
+void QuadKeyData::flushAllBuffers() {
+  flushBuffersExceptPartialBlock();
+  if (isCompressed_) flushBlock();
+}
+
+void QuadKeyData::flushBuffersExceptPartialBlock() {
+  if (boundsBuffer_->tellp() > 0)
+    writeBuffer(*boundsBuffer_, *boundsFile_);
+
+  if (isCompressed_ || indexBuffer_->tellp() <= 0) return;
+
+  writeBuffer(*dataBuffer_, *dataFile_);
+  writeBuffer(*indexBuffer_, *indexFile_);
+}
+
+BitmapData& QuadKeyData::getBitmap() const {
+  return *bitmapData_;
+}
+
+std::uint32_t QuadKeyData::count() {
+  std::uint32_t count = 0;
+  readViews([&](const TilePack::Section &indexView, const TilePack::Section &) {
+    count = static_cast<std::uint32_t>(indexView.size / IndexEntrySize);
+  });
+  return count;
+}
+
+std::unique_ptr<Element> QuadKeyData::readElement(std::uint32_t order) {
+  std::unique_ptr<Element> element;
+  readViews([&](const TilePack::Section &indexView, const TilePack::Section &dataView) {
+    element = readElement(indexView, dataView, order);
+  });
+  return element;
+}
+
+void QuadKeyData::prefetch() {
+  read([&]() { return isMapped_; },
+       [&]() { ensureMapped(); },
+       [&]() {
+         touch(indexView_);
+         touch(dataView_);
+         touch(boundsView_);
+       });
+  readBitmap([](const BitmapIndex::Bitmap &) {});
+}
+
+bool QuadKeyData::mayIntersect(std::uint32_t order, const BoundingBox &bbox) {
+  bool result = true;
+  read([&]() { return isMapped_; },
+       [&]() { ensureMapped(); },
+       [&]() { result = mayIntersect(boundsView_, order, bbox); });
+  return result;
+}
+
+void QuadKeyData::beginScan(ScanState &state) {
+  state.erased = getErased();
+  state.next = state.erased.begin();
+}
+
+bool QuadKeyData::readChunk(ScanState &state, std::vector<std::unique_ptr<Element>> &elements) {
+  bool hasMore = false;
+  readViews([&](const TilePack::Section &indexView, const TilePack::Section &dataView) {
+    auto count = static_cast<std::uint32_t>(indexView.size / IndexEntrySize);
+    for (; state.order < count && elements.size() < ScanChunkSize; ++state.order) {
+      if (!isErased(state.erased, state.next, state.order))
+        elements.push_back(readElement(indexView, dataView, state.order, &state.cursor));
+    }
+    hasMore = state.order < count;
+  });
+  return hasMore;
+}
+
+void QuadKeyData::erase(const BoundingBox &bbox) {
+  std::lock_guard<ReadWriteLock> lock(*lock_);
+  if (pack_ != nullptr) unpack();
+  bitmapData_->load();
+  ensureMapped();
+
+  auto count = static_cast<std::uint32_t>(indexView_.size / IndexEntrySize);
+  auto erased = getErased(bitmapData_->data);
+  auto next = erased.begin();
+  BitmapIndex::Ids orders;
+  for (std::uint32_t order = 0; order < count; ++order) {
+    if (isErased(erased, next, order) || !mayIntersect(boundsView_, order, bbox)) continue;
+    if (ElementGeometryVisitor::intersects(*readElement(indexView_, dataView_, order), bbox))
+      orders.push_back(order);
+  }
+
+  if (!orders.empty())
+    bitmapData_->markErased(orders);
+}
+
+bool QuadKeyData::erase(const std::unordered_set<std::uint64_t> &ids) {
+  auto erased = getErased();
+  auto next = erased.begin();
+  BitmapIndex::Ids orders;
+  readViews([&](const TilePack::Section &indexView, const TilePack::Section &) {
+    auto count = static_cast<std::uint32_t>(indexView.size / IndexEntrySize);
+    for (std::uint32_t order = 0; order < count; ++order) {
+      std::uint64_t id;
+      std::memcpy(&id, indexView.data + order * IndexEntrySize, sizeof(id));
+      if (ids.find(id) != ids.end() && !isErased(erased, next, order))
+        orders.push_back(order);
+    }
+  });
+
+  if (orders.empty()) return false;
+
+  std::lock_guard<ReadWriteLock> lock(*lock_);
+  if (pack_ != nullptr) unpack();
+  bitmapData_->load();
+  bitmapData_->markErased(orders);
+  return true;
+}
+
+BitmapIndex::Bitset QuadKeyData::getErased() {
+  BitmapIndex::Bitset erased;
+  readBitmap([&](const BitmapIndex::Bitmap &bitmap) { erased = getErased(bitmap); });
+  return erased;
+}
+
+bool QuadKeyData::isErased(const BitmapIndex::Bitset &erased,
+                           BitmapIndex::Bitset::const_iterator &next,
+                           std::uint32_t order) {
+  while (next != erased.end() && *next < order) ++next;
+  return next != erased.end() && *next == order;
+}
+
+std::size_t QuadKeyData::getBitmapSize() const {
+  return bitmapData_->bytes();
+}
+
+void QuadKeyData::replace(QuadKeyData &other) {
+  other.complete();
+  std::lock_guard<ReadWriteLock> lock(*lock_);
+  other.closeAll();
+  closeAll();
+  bitmapData_->discard();
+  bitmapData_->setPacked(TilePack::Section());
+  std::remove(bitmapData_->logPath.c_str());
+  pack_.reset();
+  moveFile(other.bitmapPath_, bitmapPath_);
+  moveFile(other.boundsPath_, boundsPath_);
+  moveFile(other.indexPath_, indexPath_);
+  moveFile(other.dataPath_, dataPath_);
+  members_ = std::move(other.members_);
+  openFiles();
+}
+
+void QuadKeyData::erase() {
+  std::lock_guard<ReadWriteLock> lock(*lock_);
+  closeAll();
+  bitmapData_->discard();
+  bitmapData_->setPacked(TilePack::Section());
+  // NOTE packed quad key has no files: it is removed from pack by store.
+  if (pack_ == nullptr) {
+    if (std::remove(dataPath_.c_str())) logEraseError(dataPath_);
+    if (std::remove(indexPath_.c_str())) logEraseError(indexPath_);
+  }
+  pack_.reset();
+  // NOTE bitmap, its log and bounds are optional as they are written lazily or missing in old data
+  std::remove(bitmapPath_.c_str());
+  std::remove(bitmapData_->logPath.c_str());
+  std::remove(boundsPath_.c_str());
+  dataSize_ = 0;
+  indexSize_ = 0;
+  boundsSize_ = 0;
+  members_.clear();
+  hasBounds_ = true;
+  isCompressed_ = compression_ != PersistentElementStore::Compression::None;
+}
+
+bool QuadKeyData::findMember(const Element &member, std::uint32_t &order) const {
+  if (member.kind == ElementKind::Relation) return false;
+
+  auto entry = members_.find(member.id);
+  if (entry == members_.end()) return false;
+
+  std::ostringstream stream;
+  ElementStream::write(stream, member);
+  auto data = stream.str();
+  if (data.size() != entry->second.size || std::hash<std::string>()(data) != entry->second.hash)
+    return false;
+
+  order = entry->second.order;
+  return true;
+}
+
+bool QuadKeyData::mayIntersect(const TilePack::Section &boundsView, std::uint32_t order, const BoundingBox &bbox) {
+  std::size_t offset = order * sizeof(BoundsEntry);
+  if (offset + sizeof(BoundsEntry) > boundsView.size)
+    return true;
+
+  BoundsEntry bounds;
+  std::memcpy(&bounds, boundsView.data + offset, sizeof(bounds));
+  return bounds.intersects(bbox);
+}
+
+bool QuadKeyData::hasValidBounds() const {
+  return boundsSize_ == indexSize_ / IndexEntrySize * sizeof(BoundsEntry);
+}
+
+BitmapIndex::Bitset QuadKeyData::getErased(const BitmapIndex::Bitmap &bitmap) {
+  auto erased = bitmap.find(BitmapIndex::ErasedToken);
+  return erased != bitmap.end() ? erased->second : BitmapIndex::Bitset();
+}
+
+std::unique_ptr<Element> QuadKeyData::readElement(const TilePack::Section &indexView,
+                                                  const TilePack::Section &dataView,
+                                                  std::uint32_t order,
+                                                  BlockCursor *cursor) {
+  // NOTE relation references only members appended before it.
+  auto memberReader = [&](std::uint32_t memberOrder) {
+    if (memberOrder >= order)
+      throw std::domain_error("Invalid member reference.");
+    return readElement(indexView, dataView, memberOrder);
+  };
+
+  std::size_t entryOffset = order * IndexEntrySize;
+  if (entryOffset + IndexEntrySize > indexView.size)
+    throw std::domain_error("Cannot find element in index.");
+
+  std::uint64_t id;
+  std::uint32_t offset;
+  std::memcpy(&id, indexView.data + entryOffset, sizeof(id));
+  std::memcpy(&offset, indexView.data + entryOffset + sizeof(id), sizeof(offset));
+  if (offset >= dataView.size)
+    throw std::domain_error("Cannot find element data.");
+
+  utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StoreReads);
+  if (!isCompressed_) {
+    // NOTE element data ends where data of next element starts.
+    std::uint32_t end = static_cast<std::uint32_t>(dataView.size);
+    if (entryOffset + 2 * IndexEntrySize <= indexView.size)
+      std::memcpy(&end, indexView.data + entryOffset + IndexEntrySize + sizeof(id), sizeof(end));
+    utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StoreReadBytes, end > offset ? end - offset : 0);
+    return readRecord(dataView.data + offset, dataView.size - offset, id, memberReader);
+  }
+
+  BlockHeader header;
+  if (offset + sizeof(header) > dataView.size)
+    throw std::domain_error("Cannot find element block.");
+  std::memcpy(&header, dataView.data + offset, sizeof(header));
+  if (order < header.firstOrder || order - header.firstOrder >= header.count)
+    throw std::domain_error("Cannot find element in block.");
+
+  std::shared_ptr<const std::string> block;
+  if (cursor == nullptr)
+    block = getBlock(dataView, offset, header, true);
+  else {
+    if (cursor->block == nullptr || cursor->offset != offset) {
+      cursor->block = getBlock(dataView, offset, header, false);
+      cursor->offset = offset;
+    }
+    block = cursor->block;
+  }
+
+  std::uint32_t elementOffset;
+  std::memcpy(&elementOffset, block->data() + (order - header.firstOrder) * sizeof(elementOffset), sizeof(elementOffset));
+  if (elementOffset >= block->size())
+    throw std::domain_error("Cannot find element data.");
+
+  return readRecord(block->data() + elementOffset, block->size() - elementOffset, id, memberReader);
+}
+
+std::unique_ptr<Element> QuadKeyData::readRecord(const char *data,
+                                                 std::size_t size,
+                                                 std::uint64_t id,
+                                                 const ElementStream::MemberReader &memberReader) {
+  if (size == 0 || data[0] != SharedPayloadMarker)
+    return ElementStream::read(data, size, id, memberReader);
+
+  if (size < SharedPayloadRecordSize)
+    throw std::domain_error("Unexpected end of element data.");
+
+  std::uint64_t payloadOffset;
+  std::uint32_t payloadSize;
+  std::memcpy(&payloadOffset, data + 1, sizeof(payloadOffset));
+  std::memcpy(&payloadSize, data + 1 + sizeof(payloadOffset), sizeof(payloadSize));
+
+  std::unique_ptr<Element> element;
+  payloads_->read(payloadOffset, payloadSize, [&](const char *payload, std::size_t payloadSize) {
+    element = ElementStream::read(payload, payloadSize, id, memberReader);
+  });
+  return element;
+}
+
+std::shared_ptr<const std::string> QuadKeyData::getBlock(const TilePack::Section &dataView,
+                                                         std::uint32_t offset,
+                                                         const BlockHeader &header,
+                                                         bool isCached) {
+  {
+    std::lock_guard<std::mutex> lock(*blockLock_);
+    auto block = blocks_.find(offset);
+    if (block != blocks_.end()) return block->second;
+  }
+
+  if (offset + sizeof(header) + header.compressedSize > dataView.size ||
+      header.count * sizeof(std::uint32_t) > header.rawSize)
+    throw std::domain_error("Cannot find element block.");
+
+  utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StoreReadBytes, sizeof(header) + header.compressedSize);
+  std::shared_ptr<const std::string> block = std::make_shared<std::string>(
+    decompressBlock(dataView.data + offset + sizeof(header), header.compressedSize, header.rawSize));
+
+  if (!isCached) return block;
+
+  std::lock_guard<std::mutex> lock(*blockLock_);
+  return blocks_.emplace(offset, block).first->second;
+}
+
+void QuadKeyData::flushBlock() {
+  if (pendingIds_.empty()) return;
+
+  auto count = static_cast<std::uint32_t>(pendingIds_.size());
+  auto tableSize = static_cast<std::uint32_t>(count * sizeof(std::uint32_t));
+  std::string raw(tableSize, '\0');
+  for (std::size_t i = 0; i < pendingOffsets_.size(); ++i) {
+    std::uint32_t elementOffset = tableSize + pendingOffsets_[i];
+    std::memcpy(&raw[i * sizeof(elementOffset)], &elementOffset, sizeof(elementOffset));
+  }
+  raw += dataBuffer_->str();
+  auto compressed = compressBlock(raw);
+
+  dataFile_->seekp(0, std::ios::end);
+  if (dataSize_ == 0) {
+    dataFile_->write(CompressedFileMagic, sizeof(CompressedFileMagic));
+    dataSize_ = sizeof(CompressedFileMagic);
+  }
+
+  BlockHeader header = { static_cast<std::uint32_t>(raw.size()),
+                         static_cast<std::uint32_t>(compressed.size()),
+                         static_cast<std::uint32_t>(indexSize_ / IndexEntrySize) - count,
+                         count };
+  auto blockOffset = static_cast<std::uint32_t>(dataSize_);
+  dataFile_->write(reinterpret_cast<const char *>(&header), sizeof(header));
+  dataFile_->write(compressed.data(), compressed.size());
+  dataFile_->flush();
+  dataSize_ += sizeof(header) + compressed.size();
+
+  for (auto id : pendingIds_) {
+    indexBuffer_->write(reinterpret_cast<const char *>(&id), sizeof(id));
+    indexBuffer_->write(reinterpret_cast<const char *>(&blockOffset), sizeof(blockOffset));
+  }
+  writeBuffer(*indexBuffer_, *indexFile_);
+
+  dataBuffer_->str(std::string());
+  pendingIds_.clear();
+  pendingOffsets_.clear();
+}
+
+bool QuadKeyData::hasCompressedMagic(std::fstream &file) {
+  char magic[sizeof(CompressedFileMagic)];
+  file.seekg(0, std::ios::beg);
+  file.read(magic, sizeof(magic));
+  bool result = hasCompressedMagic(magic, static_cast<std::size_t>(file.gcount()));
+  file.clear();
+  return result;
+}
+
+bool QuadKeyData::hasCompressedMagic(const char *data, std::size_t size) {
+  return size >= sizeof(CompressedFileMagic) &&
+      std::memcmp(data, CompressedFileMagic, sizeof(CompressedFileMagic)) == 0;
+}
+
+void QuadKeyData::openFiles() {
+  using std::ios;
+  dataFile_->open(dataPath_, ios::in | ios::out | ios::binary | ios::app | ios::ate);
+  indexFile_->open(indexPath_, ios::in | ios::out | ios::binary | ios::app | ios::ate);
+  boundsFile_->open(boundsPath_, ios::in | ios::out | ios::binary | ios::app | ios::ate);
+  dataSize_ = getSize(*dataFile_);
+  indexSize_ = getSize(*indexFile_);
+  boundsSize_ = getSize(*boundsFile_);
+  hasBounds_ = hasValidBounds();
+  isCompressed_ = dataSize_ == 0
+    ? compression_ != PersistentElementStore::Compression::None
+    : hasCompressedMagic(*dataFile_);
+}
+
+void QuadKeyData::unpack() {
+  writeFile(indexPath_, packedTile_.index);
+  writeFile(dataPath_, packedTile_.data);
+  if (packedTile_.bitmap.size > 0)
+    writeFile(bitmapPath_, packedTile_.bitmap);
+  writeFile(boundsPath_, packedTile_.bounds);
+
+  bitmapData_->setPacked(TilePack::Section());
+  indexView_ = TilePack::Section();
+  dataView_ = TilePack::Section();
+  boundsView_ = TilePack::Section();
+  isMapped_ = false;
+  pack_.reset();
+  openFiles();
+}
+
+void QuadKeyData::writeFile(const std::string &path, const TilePack::Section &section) {
+  std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(section.data, section.size);
+}
+
+void QuadKeyData::ensureMapped() {
+  if (isMapped_) return;
+
+  flushAllBuffers();
+  if (pack_ != nullptr) {
+    indexView_ = packedTile_.index;
+    dataView_ = packedTile_.data;
+    boundsView_ = hasBounds_ ? packedTile_.bounds : TilePack::Section();
+  } else {
+    dataMapping_.map(dataPath_, dataSize_);
+    indexMapping_.map(indexPath_, indexSize_);
+    boundsMapping_.map(boundsPath_, hasBounds_ ? boundsSize_ : 0);
+    dataView_ = dataMapping_.view();
+    indexView_ = indexMapping_.view();
+    boundsView_ = boundsMapping_.view();
+  }
+  isMapped_ = true;
+}
+
+void QuadKeyData::touch(const TilePack::Section &section) {
+  volatile char value = 0;
+  for (std::size_t i = 0; i < section.size; i += PageSize)
+    value = value + section.data[i];
+}
+
+std::size_t QuadKeyData::getSize(std::fstream &file) {
+  file.seekg(0, std::ios::end);
+  return static_cast<std::size_t>(file.tellg());
+}
+
+void QuadKeyData::writeBuffer(std::ostringstream &buffer, std::fstream &file) {
+  const auto &data = buffer.str();
+  file.seekp(0, std::ios::end);
+  file.write(data.data(), data.size());
+  file.flush();
+  buffer.str(std::string());
+}
+
+void QuadKeyData::closeAll() {
+  indexMapping_.unmap();
+  dataMapping_.unmap();
+  boundsMapping_.unmap();
+  indexView_ = TilePack::Section();
+  dataView_ = TilePack::Section();
+  boundsView_ = TilePack::Section();
+  isMapped_ = false;
+  if (blockLock_ != nullptr) {
+    std::lock_guard<std::mutex> lock(*blockLock_);
+    blocks_.clear();
+  }
+  pendingIds_.clear();
+  pendingOffsets_.clear();
+  if (dataBuffer_ != nullptr) dataBuffer_->str(std::string());
+  if (indexBuffer_ != nullptr) indexBuffer_->str(std::string());
+  if (boundsBuffer_ != nullptr) boundsBuffer_->str(std::string());
+  if (dataFile_ != nullptr && dataFile_->good()) dataFile_->close();
+  if (indexFile_ != nullptr && indexFile_->good()) indexFile_->close();
+  if (boundsFile_ != nullptr && boundsFile_->good()) boundsFile_->close();
+}
+
+void QuadKeyData::moveFile(const std::string &from, const std::string &to) {
+  if (boost::filesystem::exists(from))
+    boost::filesystem::rename(from, to);
+  else
+    std::remove(to.c_str());
+}
+
+void QuadKeyData::logEraseError(const std::string &path) {
+  std::cerr << "Cannot erase " << path << std::endl;
+}
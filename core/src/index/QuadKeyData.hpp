@@ -0,0 +1,323 @@
+#ifndef INDEX_QUADKEYDATA_HPP_DEFINED
+#define INDEX_QUADKEYDATA_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "CancellationToken.hpp"
+#include "entities/Element.hpp"
+#include "index/BitmapData.hpp"
+#include "index/BitmapIndex.hpp"
+#include "index/ElementStream.hpp"
+#include "index/MappedFile.hpp"
+#include "index/PersistentElementStore.hpp"
+#include "index/SharedPayloads.hpp"
+#include "index/TilePack.hpp"
+#include "utils/ReadWriteLock.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Stores file handlers related to data of specific quad key.
+/// Reads are position independent and can run concurrently, writes are exclusive.
+/// Compressed data file stores blocks of elements which are decompressed once and cached.
+/// Packed quad key is read from tile pack and its files are extracted on first write.
+/// Bounds file keeps bounding boxes of elements and is used to skip elements by bounding box
+/// without reading them. Bounds are not written if file doesn't match index, e.g. for old data.
+/// Relation member which was appended before relation as separate element is written as reference.
+/// Payload of element which is stored in other quad keys too is kept in shared payload file.
+class QuadKeyData final {
+ public:
+  /// Keeps last decompressed block while elements are read sequentially.
+  struct BlockCursor {
+    std::uint32_t offset = 0;
+    std::shared_ptr<const std::string> block;
+  };
+
+  /// Keeps position of sequential scan, so scan can be continued later.
+  /// NOTE is not copyable as it refers to own bitset.
+  struct ScanState {
+    ScanState() : next(erased.end()) {}
+    ScanState(const ScanState &) = delete;
+    ScanState &operator=(const ScanState &) = delete;
+
+    BitmapIndex::Bitset erased;
+    BitmapIndex::Bitset::const_iterator next;
+    BlockCursor cursor;
+    std::uint32_t order = 0;
+  };
+
+  QuadKeyData(const std::string &dataPath,
+              const std::string &indexPath,
+              const std::string &bitmapPath,
+              const std::string &bitmapLogPath,
+              const std::string &boundsPath,
+              PersistentElementStore::Compression compression,
+              std::shared_ptr<const TilePack> pack,
+              const TilePack::Tile &packedTile,
+              SharedPayloads &payloads,
+              std::atomic<std::size_t> &bitmapBytes);
+
+  QuadKeyData(const QuadKeyData &) = delete;
+  QuadKeyData &operator=(const QuadKeyData &) = delete;
+
+  QuadKeyData(QuadKeyData &&other);
+
+  ~QuadKeyData();
+
+  /// Calls writer under exclusive lock once bitmap is loaded.
+  template<typename Writer>
+  void write(const Writer &writer) {
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(*lock_);
+    if (pack_ != nullptr) unpack();
+    bitmapData_->load();
+    writer();
+  }
+
+  /// Writes all buffered data under exclusive lock.
+  void commit();
+
+  /// Writes all buffered data and merges bitmap.
+  void complete();
+
+  /// Appends element to write buffers and returns its order inside quad key.
+  /// Size of serialized element is returned via size.
+  /// NOTE should be called inside write.
+  std::uint32_t append(const utymap::entities::Element &element, std::uint32_t &size);
+
+  /// Writes all buffered data to files including partially filled compressed block.
+  /// NOTE should be called inside write.
+  void flushAllBuffers();
+
+  /// Writes buffered data to files, but keeps partially filled compressed block
+  /// in buffer, so it is compressed once it is full.
+  /// NOTE should be called inside write.
+  void flushBuffersExceptPartialBlock();
+
+  /// Returns bitmap data.
+  /// NOTE should be called inside write or readBitmap.
+  BitmapData& getBitmap() const;
+
+  /// Returns amount of stored elements.
+  std::uint32_t count();
+
+  /// Reads element with given order directly from mapped index and data files.
+  std::unique_ptr<utymap::entities::Element> readElement(std::uint32_t order);
+
+  /// Maps files, loads bitmap and touches mapped pages, so they are read into page cache.
+  void prefetch();
+
+  /// Checks using bounds file whether element with given order might intersect bounding box.
+  /// Returns true if element has no stored bounds.
+  bool mayIntersect(std::uint32_t order, const utymap::BoundingBox &bbox);
+
+  /// Starts scan over elements which are not erased at this moment.
+  void beginScan(ScanState &state);
+
+  /// Appends next chunk of not erased elements which are read under single shared lock.
+  /// Returns false if there are no more elements.
+  bool readChunk(ScanState &state, std::vector<std::unique_ptr<utymap::entities::Element>> &elements);
+
+  /// Visits all not erased elements in order. Index and data are read sequentially
+  /// in chunks under shared lock, visitor is called outside of lock. Blocks of
+  /// compressed data are decompressed once and are not cached. Visitor gets ownership of element.
+  template<typename Visitor>
+  void readAll(const utymap::CancellationToken &cancelToken, const Visitor &visitor) {
+    ScanState state;
+    beginScan(state);
+    std::vector<std::unique_ptr<utymap::entities::Element>> elements;
+    elements.reserve(ScanChunkSize);
+
+    for (bool hasMore = true; hasMore && !cancelToken.isCancelled();) {
+      hasMore = readChunk(state, elements);
+      for (auto &element : elements) {
+        if (cancelToken.isCancelled()) break;
+        visitor(std::move(element));
+      }
+      elements.clear();
+    }
+  }
+
+  /// Marks elements which intersect bounding box as erased. Erased elements stay in data file.
+  void erase(const utymap::BoundingBox &bbox);
+
+  /// Marks elements with given ids as erased. Index is scanned under shared lock first,
+  /// so packed quad key is unpacked only when it has such elements.
+  /// Returns true if any element was erased.
+  bool erase(const std::unordered_set<std::uint64_t> &ids);
+
+  /// Returns orders of erased elements.
+  BitmapIndex::Bitset getErased();
+
+  /// Checks whether order is erased. Orders should be checked in increasing order.
+  static bool isErased(const BitmapIndex::Bitset &erased,
+                       BitmapIndex::Bitset::const_iterator &next,
+                       std::uint32_t order);
+
+  /// Calls reader with loaded bitmap under shared lock.
+  template<typename Reader>
+  void readBitmap(const Reader &reader) {
+    read([&]() { return bitmapData_->isLoaded; },
+         [&]() { bitmapData_->load(); },
+         [&]() { reader(bitmapData_->data); });
+  }
+
+  /// Returns memory used by loaded bitmap.
+  std::size_t getBitmapSize() const;
+
+  /// Replaces content with other data which is written into separate files: its files
+  /// are completed and renamed over files of this data.
+  void replace(QuadKeyData &other);
+
+  /// Removes all files of quad key.
+  void erase();
+
+ private:
+  /// Amount of elements read under single lock by sequential quad key scan.
+  static const std::size_t ScanChunkSize = 256;
+
+  /// Precedes compressed block in data file.
+  struct BlockHeader;
+
+  /// Element appended to quad key which can be referenced by relation written later.
+  struct MemberEntry {
+    std::uint32_t order;
+    std::size_t size;
+    std::size_t hash;
+  };
+
+  /// Finds order of element appended earlier which has the same data as relation member.
+  /// NOTE member can be clipped differently from stored element with the same id,
+  /// so data is compared too.
+  bool findMember(const utymap::entities::Element &member, std::uint32_t &order) const;
+
+  static bool mayIntersect(const TilePack::Section &boundsView, std::uint32_t order, const utymap::BoundingBox &bbox);
+
+  /// Checks whether bounds file has entry for every indexed element.
+  bool hasValidBounds() const;
+
+  static BitmapIndex::Bitset getErased(const BitmapIndex::Bitmap &bitmap);
+
+  /// Calls reader under shared lock once state is ready. State is prepared under exclusive lock.
+  template<typename IsReady, typename Prepare, typename Reader>
+  void read(const IsReady &isReady, const Prepare &prepare, const Reader &reader) {
+    for (;;) {
+      {
+        utymap::utils::SharedLock lock(*lock_);
+        if (isReady()) {
+          reader();
+          return;
+        }
+      }
+      std::lock_guard<utymap::utils::ReadWriteLock> lock(*lock_);
+      prepare();
+    }
+  }
+
+  /// Calls reader with memory mapped index and data views under shared lock.
+  template<typename Reader>
+  void readViews(const Reader &reader) {
+    read([&]() { return isMapped_; },
+         [&]() { ensureMapped(); },
+         [&]() { reader(indexView_, dataView_); });
+  }
+
+  /// Reads element with given order. If cursor is set, its block is reused
+  /// and a new block is not put into block cache.
+  std::unique_ptr<utymap::entities::Element> readElement(const TilePack::Section &indexView,
+                                                         const TilePack::Section &dataView,
+                                                         std::uint32_t order,
+                                                         BlockCursor *cursor = nullptr);
+
+  /// Reads element from its record which keeps element data or refers to shared payload.
+  std::unique_ptr<utymap::entities::Element> readRecord(const char *data,
+                                                        std::size_t size,
+                                                        std::uint64_t id,
+                                                        const ElementStream::MemberReader &memberReader);
+
+  /// Returns decompressed block which starts at given offset. Can be called concurrently.
+  std::shared_ptr<const std::string> getBlock(const TilePack::Section &dataView,
+                                              std::uint32_t offset,
+                                              const BlockHeader &header,
+                                              bool isCached);
+
+  /// Compresses buffered elements and writes them as single block together with their index entries.
+  void flushBlock();
+
+  static bool hasCompressedMagic(std::fstream &file);
+
+  static bool hasCompressedMagic(const char *data, std::size_t size);
+
+  /// Opens index and data files and gets their sizes.
+  void openFiles();
+
+  /// Extracts files of packed quad key to make it writable.
+  void unpack();
+
+  static void writeFile(const std::string &path, const TilePack::Section &section);
+
+  /// Maps files into memory using their current sizes.
+  void ensureMapped();
+
+  static void touch(const TilePack::Section &section);
+
+  static std::size_t getSize(std::fstream &file);
+
+  static void writeBuffer(std::ostringstream &buffer, std::fstream &file);
+
+  void closeAll();
+
+  /// Moves file over existing one. Missing source file removes target.
+  static void moveFile(const std::string &from, const std::string &to);
+
+  static void logEraseError(const std::string &path);
+
+  std::unique_ptr<std::fstream> dataFile_;
+  std::unique_ptr<std::fstream> indexFile_;
+  std::unique_ptr<std::fstream> boundsFile_;
+  const std::string dataPath_;
+  const std::string indexPath_;
+  const std::string bitmapPath_;
+  const std::string boundsPath_;
+  std::unique_ptr<BitmapData> bitmapData_;
+  std::unique_ptr<std::ostringstream> dataBuffer_;
+  std::unique_ptr<std::ostringstream> indexBuffer_;
+  std::unique_ptr<std::ostringstream> boundsBuffer_;
+  std::unique_ptr<utymap::utils::ReadWriteLock> lock_;
+  std::unique_ptr<std::mutex> blockLock_;
+  PersistentElementStore::Compression compression_;
+  std::shared_ptr<const TilePack> pack_;
+  TilePack::Tile packedTile_;
+  SharedPayloads *payloads_;
+  std::map<std::uint32_t, std::shared_ptr<const std::string>> blocks_;
+  std::vector<std::uint64_t> pendingIds_;
+  std::vector<std::uint32_t> pendingOffsets_;
+  std::unordered_map<std::uint64_t, MemberEntry> members_;
+  std::size_t dataSize_;
+  std::size_t indexSize_;
+  std::size_t boundsSize_;
+  MappedFile indexMapping_;
+  MappedFile dataMapping_;
+  MappedFile boundsMapping_;
+  TilePack::Section indexView_;
+  TilePack::Section dataView_;
+  TilePack::Section boundsView_;
+  bool isCompressed_;
+  bool hasBounds_;
+  bool isMapped_;
+};
+
+}
+}
+
+#endif // INDEX_QUADKEYDATA_HPP_DEFINED
@@ -0,0 +1,410 @@
+#include "index/RoaringBitset.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace utymap::index;
+
+namespace {
+/// Max amount of values in sparse container. Dense container uses the same memory.
+const std::uint32_t MaxSparseSize = 4096;
+/// Amount of words in dense container.
+const std::size_t WordCount = 1024;
+const std::uint64_t One = 1;
+
+std::uint32_t countBits(std::uint64_t word) {
+#ifdef _MSC_VER
+  return static_cast<std::uint32_t>(__popcnt64(word));
+#else
+  return static_cast<std::uint32_t>(__builtin_popcountll(word));
+#endif
+}
+
+std::uint32_t countTrailingZeros(std::uint64_t word) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return static_cast<std::uint32_t>(index);
+#else
+  return static_cast<std::uint32_t>(__builtin_ctzll(word));
+#endif
+}
+
+template<typename Container>
+bool contains(const Container &container, std::uint16_t low) {
+  if (container.isDense())
+    return (container.words[low >> 6] & (One << (low & 63))) != 0;
+  return std::binary_search(container.values.begin(), container.values.end(), low);
+}
+
+template<typename Container>
+void toDense(Container &container) {
+  container.words.assign(WordCount, 0);
+  for (const auto low : container.values)
+    container.words[low >> 6] |= One << (low & 63);
+  std::vector<std::uint16_t>().swap(container.values);
+}
+
+template<typename Container>
+void toSparse(Container &container) {
+  std::vector<std::uint16_t> values;
+  values.reserve(container.cardinality);
+  for (std::size_t i = 0; i < WordCount; ++i) {
+    for (auto word = container.words[i]; word != 0; word &= word - 1)
+      values.push_back(static_cast<std::uint16_t>(i * 64 + countTrailingZeros(word)));
+  }
+  container.values.swap(values);
+  std::vector<std::uint64_t>().swap(container.words);
+}
+
+/// Updates cardinality and chooses representation which fits it.
+template<typename Container>
+void normalize(Container &container) {
+  if (container.isDense()) {
+    container.cardinality = 0;
+    for (const auto word : container.words)
+      container.cardinality += countBits(word);
+    if (container.cardinality <= MaxSparseSize)
+      toSparse(container);
+  } else {
+    container.cardinality = static_cast<std::uint32_t>(container.values.size());
+    if (container.cardinality > MaxSparseSize)
+      toDense(container);
+  }
+}
+
+template<typename Container>
+void orInto(Container &target, const Container &source) {
+  if (!target.isDense() && !source.isDense()) {
+    std::vector<std::uint16_t> values;
+    values.reserve(target.values.size() + source.values.size());
+    std::set_union(target.values.begin(), target.values.end(),
+                   source.values.begin(), source.values.end(), std::back_inserter(values));
+    target.values.swap(values);
+  } else {
+    if (!target.isDense())
+      toDense(target);
+    if (source.isDense()) {
+      for (std::size_t i = 0; i < WordCount; ++i)
+        target.words[i] |= source.words[i];
+    } else {
+      for (const auto low : source.values)
+        target.words[low >> 6] |= One << (low & 63);
+    }
+  }
+  normalize(target);
+}
+
+template<typename Container>
+void andInto(Container &target, const Container &source) {
+  if (target.isDense() && source.isDense()) {
+    for (std::size_t i = 0; i < WordCount; ++i)
+      target.words[i] &= source.words[i];
+  } else if (target.isDense()) {
+    std::vector<std::uint16_t> values;
+    for (const auto low : source.values)
+      if (contains(target, low)) values.push_back(low);
+    target.values.swap(values);
+    std::vector<std::uint64_t>().swap(target.words);
+  } else {
+    target.values.erase(std::remove_if(target.values.begin(), target.values.end(),
+                                       [&](std::uint16_t low) { return !contains(source, low); }),
+                        target.values.end());
+  }
+  normalize(target);
+}
+
+template<typename Container>
+void andNotInto(Container &target, const Container &source) {
+  if (!target.isDense()) {
+    target.values.erase(std::remove_if(target.values.begin(), target.values.end(),
+                                       [&](std::uint16_t low) { return contains(source, low); }),
+                        target.values.end());
+  } else if (source.isDense()) {
+    for (std::size_t i = 0; i < WordCount; ++i)
+      target.words[i] &= ~source.words[i];
+  } else {
+    for (const auto low : source.values)
+      target.words[low >> 6] &= ~(One << (low & 63));
+  }
+  normalize(target);
+}
+}
+
+RoaringBitset::const_iterator::const_iterator(const RoaringBitset &bitset, std::size_t container) :
+    bitset_(&bitset), container_(container), position_(0), value_(0) {
+  seek();
+}
+
+RoaringBitset::const_iterator &RoaringBitset::const_iterator::operator++() {
+  ++position_;
+  seek();
+  return *this;
+}
+
+void RoaringBitset::const_iterator::seek() {
+  const auto &containers = bitset_->containers_;
+  for (; container_ < containers.size(); ++container_, position_ = 0) {
+    const auto &container = containers[container_];
+    std::uint32_t high = static_cast<std::uint32_t>(container.key) << 16;
+    if (!container.isDense()) {
+      if (position_ < container.values.size()) {
+        value_ = high | container.values[position_];
+        return;
+      }
+      continue;
+    }
+
+    for (std::size_t i = position_ >> 6; i < WordCount; ++i) {
+      std::uint64_t word = container.words[i];
+      if (i == position_ >> 6)
+        word &= ~std::uint64_t(0) << (position_ & 63);
+      if (word != 0) {
+        position_ = i * 64 + countTrailingZeros(word);
+        value_ = high | static_cast<std::uint32_t>(position_);
+        return;
+      }
+    }
+  }
+  position_ = 0;
+}
+
+void RoaringBitset::set(std::uint32_t value) {
+  auto key = static_cast<std::uint16_t>(value >> 16);
+  auto low = static_cast<std::uint16_t>(value & 0xFFFF);
+
+  auto container = containers_.empty() || containers_.back().key < key ? containers_.end() : find(key);
+  if (container == containers_.end() || container->key != key)
+    container = containers_.insert(container, Container{ key, 0, {}, {} });
+
+  if (container->isDense()) {
+    auto &word = container->words[low >> 6];
+    std::uint64_t bit = One << (low & 63);
+    if ((word & bit) == 0) {
+      word |= bit;
+      ++container->cardinality;
+    }
+    return;
+  }
+
+  auto &values = container->values;
+  // NOTE values are usually added in increasing order.
+  if (values.empty() || values.back() < low)
+    values.push_back(low);
+  else {
+    auto position = std::lower_bound(values.begin(), values.end(), low);
+    if (*position == low) return;
+    values.insert(position, low);
+  }
+  if (++container->cardinality > MaxSparseSize)
+    toDense(*container);
+}
+
+bool RoaringBitset::get(std::uint32_t value) const {
+  auto key = static_cast<std::uint16_t>(value >> 16);
+  auto container = find(key);
+  return container != containers_.end() && container->key == key &&
+      contains(*container, static_cast<std::uint16_t>(value & 0xFFFF));
+}
+
+void RoaringBitset::reset() {
+  containers_.clear();
+}
+
+std::size_t RoaringBitset::numberOfOnes() const {
+  std::size_t count = 0;
+  for (const auto &container : containers_)
+    count += container.cardinality;
+  return count;
+}
+
+std::size_t RoaringBitset::sizeInBits() const {
+  if (containers_.empty())
+    return 0;
+
+  const auto &container = containers_.back();
+  std::size_t high = static_cast<std::size_t>(container.key) << 16;
+  if (!container.isDense())
+    return high + container.values.back() + 1;
+
+  for (std::size_t i = WordCount; i > 0; --i) {
+    std::uint64_t word = container.words[i - 1];
+    if (word == 0) continue;
+    std::size_t bit = 63;
+    while ((word & (One << bit)) == 0) --bit;
+    return high + (i - 1) * 64 + bit + 1;
+  }
+  return high;
+}
+
+std::size_t RoaringBitset::sizeInBytes() const {
+  std::size_t bytes = 0;
+  for (const auto &container : containers_)
+    bytes += sizeof(Container) + container.values.size() * sizeof(std::uint16_t) +
+        container.words.size() * sizeof(std::uint64_t);
+  return bytes;
+}
+
+RoaringBitset RoaringBitset::logicalor(const RoaringBitset &other) const {
+  RoaringBitset result(*this);
+  result.inplaceOr(other);
+  return result;
+}
+
+RoaringBitset RoaringBitset::logicaland(const RoaringBitset &other) const {
+  RoaringBitset result;
+  auto left = containers_.begin();
+  auto right = other.containers_.begin();
+  while (left != containers_.end() && right != other.containers_.end()) {
+    if (left->key < right->key) ++left;
+    else if (right->key < left->key) ++right;
+    else {
+      // NOTE sparse side is copied as it is never larger than result.
+      bool isLeftSmaller = !left->isDense() || right->isDense();
+      Container container = isLeftSmaller ? *left : *right;
+      andInto(container, isLeftSmaller ? *right : *left);
+      if (container.cardinality > 0)
+        result.containers_.push_back(std::move(container));
+      ++left;
+      ++right;
+    }
+  }
+  return result;
+}
+
+RoaringBitset RoaringBitset::logicalandnot(const RoaringBitset &other) const {
+  RoaringBitset result(*this);
+  result.inplaceAndNot(other);
+  return result;
+}
+
+RoaringBitset RoaringBitset::logicalxor(const RoaringBitset &other) const {
+  return logicalor(other).logicalandnot(logicaland(other));
+}
+
+void RoaringBitset::inplaceOr(const RoaringBitset &other) {
+  if (other.containers_.empty())
+    return;
+
+  std::vector<Container> containers;
+  containers.reserve(containers_.size() + other.containers_.size());
+  auto left = containers_.begin();
+  auto right = other.containers_.begin();
+  while (left != containers_.end() || right != other.containers_.end()) {
+    if (right == other.containers_.end() || (left != containers_.end() && left->key < right->key))
+      containers.push_back(std::move(*left++));
+    else if (left == containers_.end() || right->key < left->key)
+      containers.push_back(*right++);
+    else {
+      orInto(*left, *right++);
+      containers.push_back(std::move(*left++));
+    }
+  }
+  containers_.swap(containers);
+}
+
+void RoaringBitset::inplaceAnd(const RoaringBitset &other) {
+  auto right = other.containers_.begin();
+  auto last = containers_.begin();
+  for (auto left = containers_.begin(); left != containers_.end(); ++left) {
+    while (right != other.containers_.end() && right->key < left->key) ++right;
+    if (right == other.containers_.end() || right->key != left->key)
+      continue;
+    andInto(*left, *right);
+    if (left->cardinality > 0) {
+      if (last != left) *last = std::move(*left);
+      ++last;
+    }
+  }
+  containers_.erase(last, containers_.end());
+}
+
+void RoaringBitset::inplaceAndNot(const RoaringBitset &other) {
+  auto right = other.containers_.begin();
+  auto last = containers_.begin();
+  for (auto left = containers_.begin(); left != containers_.end(); ++left) {
+    while (right != other.containers_.end() && right->key < left->key) ++right;
+    if (right != other.containers_.end() && right->key == left->key)
+      andNotInto(*left, *right);
+    if (left->cardinality > 0) {
+      if (last != left) *last = std::move(*left);
+      ++last;
+    }
+  }
+  containers_.erase(last, containers_.end());
+}
+
+void RoaringBitset::write(std::ostream &out) const {
+  auto count = static_cast<std::uint32_t>(containers_.size());
+  out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  for (const auto &container : containers_) {
+    std::uint16_t isDense = container.isDense() ? 1 : 0;
+    out.write(reinterpret_cast<const char *>(&container.key), sizeof(container.key));
+    out.write(reinterpret_cast<const char *>(&isDense), sizeof(isDense));
+    out.write(reinterpret_cast<const char *>(&container.cardinality), sizeof(container.cardinality));
+    if (isDense)
+      out.write(reinterpret_cast<const char *>(container.words.data()), WordCount * sizeof(std::uint64_t));
+    else
+      out.write(reinterpret_cast<const char *>(container.values.data()),
+                container.values.size() * sizeof(std::uint16_t));
+  }
+}
+
+bool RoaringBitset::read(std::istream &in) {
+  reset();
+  std::uint32_t count = 0;
+  if (!in.read(reinterpret_cast<char *>(&count), sizeof(count)))
+    return false;
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    Container container = { 0, 0, {}, {} };
+    std::uint16_t isDense = 0;
+    in.read(reinterpret_cast<char *>(&container.key), sizeof(container.key));
+    in.read(reinterpret_cast<char *>(&isDense), sizeof(isDense));
+    in.read(reinterpret_cast<char *>(&container.cardinality), sizeof(container.cardinality));
+    if (!in || isDense > 1 || container.cardinality == 0 || container.cardinality > 0x10000 ||
+        (!containers_.empty() && containers_.back().key >= container.key))
+      return false;
+
+    if (isDense) {
+      container.words.resize(WordCount);
+      in.read(reinterpret_cast<char *>(container.words.data()), WordCount * sizeof(std::uint64_t));
+    } else {
+      container.values.resize(container.cardinality);
+      in.read(reinterpret_cast<char *>(container.values.data()), container.cardinality * sizeof(std::uint16_t));
+    }
+    if (!in)
+      return false;
+
+    normalize(container);
+    containers_.push_back(std::move(container));
+  }
+  return true;
+}
+
+bool RoaringBitset::operator==(const RoaringBitset &other) const {
+  if (containers_.size() != other.containers_.size())
+    return false;
+  for (std::size_t i = 0; i < containers_.size(); ++i) {
+    const auto &left = containers_[i];
+    const auto &right = other.containers_[i];
+    if (left.key != right.key || left.cardinality != right.cardinality ||
+        left.values != right.values || left.words != right.words)
+      return false;
+  }
+  return true;
+}
+
+std::vector<RoaringBitset::Container>::iterator RoaringBitset::find(std::uint16_t key) {
+  return std::lower_bound(containers_.begin(), containers_.end(), key,
+                          [](const Container &container, std::uint16_t k) { return container.key < k; });
+}
+
+std::vector<RoaringBitset::Container>::const_iterator RoaringBitset::find(std::uint16_t key) const {
+  return std::lower_bound(containers_.begin(), containers_.end(), key,
+                          [](const Container &container, std::uint16_t k) { return container.key < k; });
+}
@@ -0,0 +1,124 @@
+#ifndef INDEX_ROARINGBITSET_HPP_DEFINED
+#define INDEX_ROARINGBITSET_HPP_DEFINED
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Represents compressed set of 32 bit values. Values are split by high 16 bits into
+/// containers: sparse container keeps sorted array of low bits, dense one keeps bitset.
+/// Operations are applied container by container, so disjoint ranges are skipped and
+/// in place operations don't copy whole set.
+/// NOTE unlike run length encoded bitsets, values can be set in any order.
+class RoaringBitset final {
+  /// Keeps values which have the same high bits.
+  struct Container {
+    std::uint16_t key;
+    std::uint32_t cardinality;
+    /// Sorted low bits. Used if container is sparse.
+    std::vector<std::uint16_t> values;
+    /// Bitset of low bits. Used if container is dense.
+    std::vector<std::uint64_t> words;
+
+    bool isDense() const { return !words.empty(); }
+  };
+
+ public:
+  /// Iterates over values in increasing order.
+  class const_iterator {
+   public:
+    const_iterator(const RoaringBitset &bitset, std::size_t container);
+
+    std::uint32_t operator*() const { return value_; }
+
+    const_iterator &operator++();
+
+    bool operator==(const const_iterator &other) const {
+      return container_ == other.container_ && position_ == other.position_;
+    }
+
+    bool operator!=(const const_iterator &other) const { return !(*this == other); }
+
+   private:
+    /// Moves to first value starting from current position.
+    void seek();
+
+    const RoaringBitset *bitset_;
+    std::size_t container_;
+    std::size_t position_;
+    std::uint32_t value_;
+  };
+
+  /// Adds value.
+  void set(std::uint32_t value);
+
+  /// Checks whether value is in set.
+  bool get(std::uint32_t value) const;
+
+  /// Removes all values.
+  void reset();
+
+  /// Exchanges values with other set.
+  void swap(RoaringBitset &other) { containers_.swap(other.containers_); }
+
+  /// Returns true if there are no values.
+  bool empty() const { return containers_.empty(); }
+
+  /// Returns amount of values without iterating them.
+  std::size_t numberOfOnes() const;
+
+  /// Returns max value plus one or zero if set is empty.
+  std::size_t sizeInBits() const;
+
+  /// Returns approximate amount of used memory.
+  std::size_t sizeInBytes() const;
+
+  RoaringBitset logicalor(const RoaringBitset &other) const;
+  RoaringBitset logicaland(const RoaringBitset &other) const;
+  RoaringBitset logicalandnot(const RoaringBitset &other) const;
+  RoaringBitset logicalxor(const RoaringBitset &other) const;
+
+  /// Adds values of other set.
+  void inplaceOr(const RoaringBitset &other);
+
+  /// Keeps only values which are in other set.
+  void inplaceAnd(const RoaringBitset &other);
+
+  /// Removes values which are in other set.
+  void inplaceAndNot(const RoaringBitset &other);
+
+  /// Returns values in increasing order.
+  std::vector<std::uint32_t> toArray() const {
+    std::vector<std::uint32_t> values;
+    values.reserve(numberOfOnes());
+    for (auto it = begin(); it != end(); ++it)
+      values.push_back(*it);
+    return values;
+  }
+
+  const_iterator begin() const { return const_iterator(*this, 0); }
+  const_iterator end() const { return const_iterator(*this, containers_.size()); }
+
+  /// Writes set to stream.
+  void write(std::ostream &out) const;
+
+  /// Reads set from stream. Returns false if stream has no valid set.
+  bool read(std::istream &in);
+
+  bool operator==(const RoaringBitset &other) const;
+
+ private:
+  /// Finds container with given key or position where it should be inserted.
+  std::vector<Container>::iterator find(std::uint16_t key);
+  std::vector<Container>::const_iterator find(std::uint16_t key) const;
+
+  std::vector<Container> containers_;
+};
+
+}
+}
+
+#endif // INDEX_ROARINGBITSET_HPP_DEFINED
@@ -0,0 +1,48 @@
+#include "index/SharedPayloads.hpp"
+
+#include <functional>
+
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+/// Amount of recently stored elements which payloads can be shared.
+const std::size_t RecentPayloadCount = 64;
+}
+
+SharedPayloads::SharedPayloads(const std::string &path) :
+  path_(path), entries_(RecentPayloadCount), isOpened_(false), fileSize_(0) {}
+
+bool SharedPayloads::share(std::uint64_t id, const std::string &data, std::uint64_t &offset) {
+  auto hash = std::hash<std::string>()(data);
+  auto size = static_cast<std::uint32_t>(data.size());
+
+  std::lock_guard<ReadWriteLock> lock(lock_);
+  open();
+  // NOTE elements which are stored concurrently by other threads likely use other slots.
+  auto &entry = entries_[id % RecentPayloadCount];
+  if (entry.size == 0 || entry.id != id || entry.hash != hash || entry.size != size) {
+    entry = Entry{ id, hash, size, 0, false };
+    return false;
+  }
+
+  if (!entry.isShared) {
+    file_.seekp(0, std::ios::end);
+    file_.write(data.data(), data.size());
+    file_.flush();
+    if (!file_.good())
+      throw std::domain_error("Cannot write shared payload: " + path_);
+    entry.offset = fileSize_;
+    entry.isShared = true;
+    fileSize_ += data.size();
+  }
+  offset = entry.offset;
+  return true;
+}
+
+void SharedPayloads::open() {
+  if (isOpened_) return;
+  isOpened_ = true;
+  file_.open(path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::app | std::ios::ate);
+  fileSize_ = file_.good() ? static_cast<std::size_t>(file_.tellp()) : 0;
+}
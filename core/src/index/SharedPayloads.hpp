@@ -0,0 +1,75 @@
+#ifndef INDEX_SHAREDPAYLOADS_HPP_DEFINED
+#define INDEX_SHAREDPAYLOADS_HPP_DEFINED
+
+#include "index/MappedFile.hpp"
+#include "utils/ReadWriteLock.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Keeps payloads of elements which are stored in several quad keys, e.g. unclipped element
+/// on every level of detail, in single append only file, so quad keys refer to payload
+/// instead of keeping its copy. Payload is moved to file when element with the same id and
+/// data is stored second time. Can be used concurrently.
+/// NOTE element is stored in all its quad keys back-to-back, so only payloads of recently
+/// stored elements are remembered. Payloads are not removed when quad keys are erased.
+class SharedPayloads final {
+ public:
+  explicit SharedPayloads(const std::string &path);
+
+  /// Returns true and offset of payload in file if element with the same id and data was
+  /// stored before.
+  bool share(std::uint64_t id, const std::string &data, std::uint64_t &offset);
+
+  /// Calls reader with payload data under shared lock.
+  template<typename Reader>
+  void read(std::uint64_t offset, std::uint32_t size, const Reader &reader) {
+    for (;;) {
+      {
+        utymap::utils::SharedLock lock(lock_);
+        if (offset + size <= mapping_.size()) {
+          reader(mapping_.data() + offset, size);
+          return;
+        }
+      }
+      std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+      open();
+      if (offset + size > fileSize_)
+        throw std::domain_error("Cannot find shared payload.");
+      mapping_.map(path_, fileSize_);
+    }
+  }
+
+ private:
+  /// Payload of element stored before.
+  struct Entry {
+    std::uint64_t id;
+    std::size_t hash;
+    std::uint32_t size;
+    std::uint64_t offset;
+    bool isShared;
+  };
+
+  void open();
+
+  const std::string path_;
+  utymap::utils::ReadWriteLock lock_;
+  std::fstream file_;
+  MappedFile mapping_;
+  /// Entries of recently stored elements by id modulo their amount.
+  std::vector<Entry> entries_;
+  bool isOpened_;
+  std::size_t fileSize_;
+};
+
+}
+}
+
+#endif // INDEX_SHAREDPAYLOADS_HPP_DEFINED
@@ -0,0 +1,130 @@
+#ifndef INDEX_STORECOVERAGE_HPP_DEFINED
+#define INDEX_STORECOVERAGE_HPP_DEFINED
+
+#include "BoundingBox.hpp"
+#include "LodRange.hpp"
+#include "QuadKey.hpp"
+#include "index/RoaringBitset.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/ReadWriteLock.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Keeps aggregate coverage of store: bounding box of all quad keys with data and per
+/// level of detail bitmap of coarse tiles which contain them. It answers whether store
+/// might have data, so store can be skipped before any per tile work.
+/// NOTE coverage only grows: erased quad keys stay covered, so answer can be false positive.
+class StoreCoverage final {
+ public:
+  /// Max level of coarse tiles: deeper quad keys are mapped to their ancestor.
+  static const int MaxCoarseLevel = 10;
+
+  /// Marks quad key as having data.
+  void add(const utymap::QuadKey &quadKey) {
+    if (quadKey.levelOfDetail < 0 || quadKey.levelOfDetail > utymap::QuadKey::MaxLevelOfDetail)
+      return;
+
+    auto coarse = toCoarse(quadKey);
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+    if (levels_.size() <= static_cast<std::size_t>(quadKey.levelOfDetail))
+      levels_.resize(quadKey.levelOfDetail + 1);
+    auto &tiles = levels_[quadKey.levelOfDetail];
+    auto index = getIndex(coarse);
+    if (tiles.get(index)) return;
+
+    tiles.set(index);
+    auto bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(coarse);
+    if (bbox_.isValid())
+      bbox_.expand(bbox);
+    else
+      bbox_ = bbox;
+  }
+
+  /// Checks whether quad key might have data.
+  bool mayContain(const utymap::QuadKey &quadKey) const {
+    utymap::utils::SharedLock lock(lock_);
+    if (quadKey.levelOfDetail < 0 || static_cast<std::size_t>(quadKey.levelOfDetail) >= levels_.size())
+      return false;
+    return levels_[quadKey.levelOfDetail].get(getIndex(toCoarse(quadKey)));
+  }
+
+  /// Checks whether some quad key of given range which intersects bounding box might have data.
+  bool mayIntersect(const utymap::BoundingBox &bbox, const utymap::LodRange &range) const {
+    utymap::utils::SharedLock lock(lock_);
+    if (!bbox_.isValid() || !bbox.isValid() || !bbox_.intersects(bbox))
+      return false;
+
+    int end = std::min(range.end, static_cast<int>(levels_.size()) - 1);
+    for (int lod = std::max(range.start, 0); lod <= end; ++lod) {
+      if (mayIntersect(levels_[lod], bbox, lod < MaxCoarseLevel ? lod : static_cast<int>(MaxCoarseLevel)))
+        return true;
+    }
+    return false;
+  }
+
+  /// Returns bounding box of all covered quad keys. It is invalid if there are none.
+  utymap::BoundingBox getBoundingBox() const {
+    utymap::utils::SharedLock lock(lock_);
+    return bbox_;
+  }
+
+  void clear() {
+    std::lock_guard<utymap::utils::ReadWriteLock> lock(lock_);
+    levels_.clear();
+    bbox_ = utymap::BoundingBox();
+  }
+
+ private:
+  static utymap::QuadKey toCoarse(const utymap::QuadKey &quadKey) {
+    if (quadKey.levelOfDetail <= MaxCoarseLevel)
+      return quadKey;
+    int shift = quadKey.levelOfDetail - MaxCoarseLevel;
+    return utymap::QuadKey(MaxCoarseLevel, quadKey.tileX >> shift, quadKey.tileY >> shift);
+  }
+
+  static std::uint32_t getIndex(const utymap::QuadKey &coarse) {
+    return (static_cast<std::uint32_t>(coarse.tileX) << coarse.levelOfDetail) |
+           static_cast<std::uint32_t>(coarse.tileY);
+  }
+
+  /// Checks tiles of bounding box or set tiles depending on which is smaller.
+  static bool mayIntersect(const RoaringBitset &tiles, const utymap::BoundingBox &bbox, int level) {
+    if (tiles.empty()) return false;
+
+    auto start = utymap::utils::GeoUtils::GeoCoordinateToQuadKey(bbox.minPoint, level);
+    auto end = utymap::utils::GeoUtils::GeoCoordinateToQuadKey(bbox.maxPoint, level);
+    int minX = start.tileX, maxX = end.tileX, minY = end.tileY, maxY = start.tileY;
+    auto area = static_cast<std::size_t>(maxX - minX + 1) * static_cast<std::size_t>(maxY - minY + 1);
+
+    if (area <= tiles.numberOfOnes()) {
+      for (int x = minX; x <= maxX; ++x)
+        for (int y = minY; y <= maxY; ++y)
+          if (tiles.get(getIndex(utymap::QuadKey(level, x, y))))
+            return true;
+      return false;
+    }
+
+    const std::uint32_t mask = (std::uint32_t(1) << level) - 1;
+    for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+      int x = static_cast<int>(*it >> level), y = static_cast<int>(*it & mask);
+      if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+        return true;
+    }
+    return false;
+  }
+
+  mutable utymap::utils::ReadWriteLock lock_;
+  std::vector<RoaringBitset> levels_;
+  utymap::BoundingBox bbox_;
+};
+
+}
+}
+
+#endif // INDEX_STORECOVERAGE_HPP_DEFINED
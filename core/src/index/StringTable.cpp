@@ -1,141 +1,1044 @@
 #include "hashing/MurmurHash3.h"
 #include "index/StringTable.hpp"
+#include "utils/AllocationTracker.hpp"
 #include "utils/CoreUtils.hpp"
-#include "utils/LruCache.hpp"
+#include "utils/ShardedLruCache.hpp"
+#include "utils/Metrics.hpp"
 
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 using std::ios;
 using namespace utymap::index;
 
-/// Naive implementation of string table: reads all the time string from file; acquires lock
-/// TODO optimize it to avoid locks and expensive file reads.
+namespace {
+const char HashTableMagic[] = { 'U', 'T', 'S', 'H' };
+const std::uint32_t HashTableVersion = 2;
+/// Min amount of hash table slots. Should be power of two.
+const std::uint32_t MinHashTableCapacity = 1024;
+
+const char SealedTableMagic[] = { 'U', 'T', 'S', 'S' };
+const std::uint32_t SealedTableVersion = 1;
+/// Average amount of strings in bucket of sealed table.
+const std::uint32_t SealedBucketSize = 4;
+/// Displacement flag which marks bucket with directly stored slot.
+const std::uint32_t DirectSlotFlag = 0x80000000;
+
+/// Min amount of strings collected before new snapshot is published.
+const std::size_t MinPublishSize = 64;
+/// Max amount of strings in published snapshot.
+const std::size_t MaxPublishedSize = 64 * 1024;
+/// Approximate size of hash map node used to estimate memory of snapshot.
+const std::size_t NodeSize = 32;
+
+/// Size of index entry: string hash and offset of string in data file.
+const std::size_t IndexEntrySize = sizeof(std::uint32_t) * 2;
+
+/// Max amount of buffered bytes of data and index files in fast mode.
+const std::size_t MaxPendingSize = 64 * 1024;
+
+/// Compares strings of views byte by byte.
+bool isLess(const StringTable::StringView &lhs, const StringTable::StringView &rhs) {
+  int result = std::memcmp(lhs.data, rhs.data, std::min(lhs.size, rhs.size));
+  return result < 0 || (result == 0 && lhs.size < rhs.size);
+}
+
+/// Calculates edit distance between strings. Returns value greater than max distance
+/// once it is exceeded. Row is used as buffer.
+std::size_t getDistance(const StringTable::StringView &lhs,
+                        const StringTable::StringView &rhs,
+                        std::size_t maxDistance,
+                        std::vector<std::size_t> &row) {
+  if ((lhs.size > rhs.size ? lhs.size - rhs.size : rhs.size - lhs.size) > maxDistance)
+    return maxDistance + 1;
+
+  row.resize(rhs.size + 1);
+  for (std::size_t j = 0; j <= rhs.size; ++j)
+    row[j] = j;
+
+  for (std::size_t i = 1; i <= lhs.size; ++i) {
+    std::size_t diagonal = row[0];
+    std::size_t rowMin = row[0] = i;
+    for (std::size_t j = 1; j <= rhs.size; ++j) {
+      std::size_t above = row[j];
+      row[j] = std::min(std::min(row[j - 1], above) + 1,
+                        diagonal + (lhs.data[i - 1] == rhs.data[j - 1] ? 0 : 1));
+      diagonal = above;
+      rowMin = std::min(rowMin, row[j]);
+    }
+    if (rowMin > maxDistance)
+      return maxDistance + 1;
+  }
+  return row[rhs.size];
+}
+
+/// Forces written content of file to storage device.
+void syncFile(const std::string &path) {
+#ifdef _WIN32
+  int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+  if (fd < 0 || _commit(fd) != 0) {
+    if (fd >= 0) _close(fd);
+    throw std::domain_error("Cannot sync file: " + path);
+  }
+  _close(fd);
+#else
+  int fd = ::open(path.c_str(), O_RDWR);
+  if (fd < 0 || ::fsync(fd) != 0) {
+    if (fd >= 0) ::close(fd);
+    throw std::domain_error("Cannot sync file: " + path);
+  }
+  ::close(fd);
+#endif
+}
+
+struct HashTableHeader {
+  char magic[sizeof(HashTableMagic)];
+  std::uint32_t version;
+  /// First indexed id: strings before it are in sealed table.
+  std::uint32_t first;
+  /// Amount of indexed strings: ids from first to first + count are in table.
+  std::uint32_t count;
+  std::uint32_t capacity;
+  std::uint32_t reserved;
+};
+
+/// Hash table slot. Id is stored increased by one, so zero marks empty slot.
+struct HashSlot {
+  std::uint32_t hash;
+  std::uint32_t id;
+};
+
+/// Sealed table header. Header is followed by bucket displacements, hashes and ids
+/// of slots, string offsets and null terminated string data.
+struct SealedTableHeader {
+  char magic[sizeof(SealedTableMagic)];
+  std::uint32_t version;
+  std::uint32_t count;
+  std::uint32_t bucketCount;
+  std::uint32_t dataSize;
+  std::uint32_t reserved;
+};
+
+/// Read only table of strings with minimal perfect hash built using hash and displace
+/// algorithm: primary hash selects bucket whose displacement is used as seed of second
+/// hash which gives slot. Bucket with single string keeps its slot directly.
+class SealedTable final {
+ public:
+  /// Opens table. Returns false if table is missing or invalid.
+  bool open(const std::string &path) {
+    boost::system::error_code error;
+    auto size = boost::filesystem::file_size(path, error);
+    if (error || size < sizeof(SealedTableHeader))
+      return false;
+
+    using namespace boost::interprocess;
+    mapping_ = file_mapping(path.c_str(), read_only);
+    region_ = mapped_region(mapping_, read_only);
+    const char *data = static_cast<const char *>(region_.get_address());
+    std::memcpy(&header_, data, sizeof(header_));
+
+    bool isValid = std::memcmp(header_.magic, SealedTableMagic, sizeof(SealedTableMagic)) == 0 &&
+        header_.version == SealedTableVersion &&
+        header_.bucketCount > 0 &&
+        size == getFileSize(header_);
+    if (!isValid) {
+      close();
+      return false;
+    }
+
+    displacements_ = reinterpret_cast<const std::uint32_t *>(data + sizeof(header_));
+    hashes_ = displacements_ + header_.bucketCount;
+    ids_ = hashes_ + header_.count;
+    offsets_ = ids_ + header_.count;
+    data_ = reinterpret_cast<const char *>(offsets_ + header_.count + 1);
+    return true;
+  }
+
+  void close() {
+    region_ = boost::interprocess::mapped_region();
+    mapping_ = boost::interprocess::file_mapping();
+    header_ = SealedTableHeader();
+  }
+
+  std::uint32_t count() const {
+    return header_.count;
+  }
+
+  /// Finds id of string using its primary hash. String is compared at most once.
+  bool find(const std::string &str, std::uint32_t hash, std::uint32_t &id) const {
+    if (header_.count == 0)
+      return false;
+
+    auto slot = getSlot(str, hash, displacements_[hash % header_.bucketCount], header_.count);
+    if (hashes_[slot] != hash)
+      return false;
+
+    auto view = getView(ids_[slot]);
+    if (view.size != str.size() || std::memcmp(view.data, str.data(), view.size) != 0)
+      return false;
+
+    id = ids_[slot];
+    return true;
+  }
+
+  /// Gets string by id which should be less than count.
+  StringTable::StringView getView(std::uint32_t id) const {
+    return StringTable::StringView{ data_ + offsets_[id], offsets_[id + 1] - offsets_[id] - 1 };
+  }
+
+  /// Writes table of given strings which ids are their positions.
+  static void write(const std::string &path,
+                    const std::vector<std::string> &strings,
+                    const std::vector<std::uint32_t> &hashes) {
+    auto count = static_cast<std::uint32_t>(strings.size());
+    SealedTableHeader header;
+    std::memcpy(header.magic, SealedTableMagic, sizeof(SealedTableMagic));
+    header.version = SealedTableVersion;
+    header.count = count;
+    header.bucketCount = count / SealedBucketSize + 1;
+    header.reserved = 0;
+
+    std::vector<std::vector<std::uint32_t>> buckets(header.bucketCount);
+    for (std::uint32_t id = 0; id < count; ++id)
+      buckets[hashes[id] % header.bucketCount].push_back(id);
+
+    std::vector<std::uint32_t> order(header.bucketCount);
+    for (std::uint32_t i = 0; i < header.bucketCount; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t left, std::uint32_t right) {
+      return buckets[left].size() > buckets[right].size();
+    });
+
+    std::vector<std::uint32_t> displacements(header.bucketCount, 0);
+    std::vector<std::uint32_t> slotHashes(count, 0), slotIds(count, 0);
+    std::vector<bool> isTaken(count, false);
+    std::vector<std::uint32_t> slots;
+    std::uint32_t nextFree = 0;
+
+    for (auto bucketIndex : order) {
+      const auto &bucket = buckets[bucketIndex];
+      if (bucket.empty())
+        break;
+
+      std::uint32_t displacement = 0;
+      if (bucket.size() == 1) {
+        while (isTaken[nextFree]) ++nextFree;
+        displacement = DirectSlotFlag | nextFree;
+        slots.assign(1, nextFree);
+      } else {
+        for (displacement = 1;; ++displacement) {
+          if (displacement >= DirectSlotFlag)
+            throw std::domain_error("Cannot build perfect hash of string table.");
+          slots.clear();
+          for (auto id : bucket) {
+            auto slot = getSlot(strings[id], hashes[id], displacement, count);
+            if (isTaken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+              break;
+            slots.push_back(slot);
+          }
+          if (slots.size() == bucket.size())
+            break;
+        }
+      }
+
+      displacements[bucketIndex] = displacement;
+      for (std::size_t i = 0; i < bucket.size(); ++i) {
+        isTaken[slots[i]] = true;
+        slotHashes[slots[i]] = hashes[bucket[i]];
+        slotIds[slots[i]] = bucket[i];
+      }
+    }
+
+    std::vector<std::uint32_t> offsets;
+    offsets.reserve(count + 1);
+    std::string data;
+    for (const auto &str : strings) {
+      offsets.push_back(static_cast<std::uint32_t>(data.size()));
+      data.append(str.c_str(), str.size());
+      data.push_back('\0');
+    }
+    offsets.push_back(static_cast<std::uint32_t>(data.size()));
+    header.dataSize = static_cast<std::uint32_t>(data.size());
+
+    auto tempPath = path + ".tmp";
+    {
+      std::ofstream file(tempPath, ios::out | ios::binary | ios::trunc);
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      writeArray(file, displacements);
+      writeArray(file, slotHashes);
+      writeArray(file, slotIds);
+      writeArray(file, offsets);
+      file.write(data.data(), data.size());
+      if (!file.good())
+        throw std::domain_error("Cannot write sealed string table: " + path);
+    }
+    boost::filesystem::rename(tempPath, path);
+  }
+
+ private:
+  static std::uint32_t getSlot(const std::string &str,
+                               std::uint32_t hash,
+                               std::uint32_t displacement,
+                               std::uint32_t count) {
+    if ((displacement & DirectSlotFlag) != 0)
+      return displacement & ~DirectSlotFlag;
+    std::uint32_t slotHash;
+    MurmurHash3_x86_32(str.c_str(), static_cast<int>(str.size()), displacement, &slotHash);
+    return slotHash % count;
+  }
+
+  static std::size_t getFileSize(const SealedTableHeader &header) {
+    return sizeof(header) + (header.bucketCount + 3 * static_cast<std::size_t>(header.count) + 1) *
+        sizeof(std::uint32_t) + header.dataSize;
+  }
+
+  static void writeArray(std::ostream &file, const std::vector<std::uint32_t> &values) {
+    if (!values.empty())
+      file.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(std::uint32_t));
+  }
+
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+  SealedTableHeader header_ = SealedTableHeader();
+  const std::uint32_t *displacements_ = nullptr;
+  const std::uint32_t *hashes_ = nullptr;
+  const std::uint32_t *ids_ = nullptr;
+  const std::uint32_t *offsets_ = nullptr;
+  const char *data_ = nullptr;
+};
+
+/// Open addressing hash table of string ids stored in memory mapped file.
+/// Table is searched in place, so opening it doesn't depend on its size.
+class HashTable final {
+ public:
+  explicit HashTable(const std::string &path) :
+      path_(path), header_(nullptr), slots_(nullptr) {
+  }
+
+  /// Opens existing table. Returns false if table is missing or invalid.
+  bool open() {
+    boost::system::error_code error;
+    auto size = boost::filesystem::file_size(path_, error);
+    if (error || size < sizeof(HashTableHeader))
+      return false;
+
+    map();
+    bool isValid = std::memcmp(header_->magic, HashTableMagic, sizeof(HashTableMagic)) == 0 &&
+        header_->version == HashTableVersion &&
+        header_->capacity >= MinHashTableCapacity &&
+        (header_->capacity & (header_->capacity - 1)) == 0 &&
+        size == getFileSize(header_->capacity);
+    if (!isValid)
+      unmap();
+    return isValid;
+  }
+
+  /// Creates empty table which starts from given id and fits given amount of strings.
+  void create(std::uint32_t first, std::uint32_t count) {
+    std::uint32_t capacity = MinHashTableCapacity;
+    while (capacity / 2 < count) capacity *= 2;
+
+    unmap();
+    std::ofstream(path_, ios::out | ios::binary | ios::trunc);
+    boost::filesystem::resize_file(path_, getFileSize(capacity));
+    map();
+
+    std::memcpy(header_->magic, HashTableMagic, sizeof(HashTableMagic));
+    header_->version = HashTableVersion;
+    header_->first = first;
+    header_->count = 0;
+    header_->capacity = capacity;
+    header_->reserved = 0;
+  }
+
+  std::uint32_t first() const {
+    return header_->first;
+  }
+
+  /// Returns next id which is not in table.
+  std::uint32_t end() const {
+    return header_->first + header_->count;
+  }
+
+  /// Finds id of string with given hash using predicate which checks candidate id.
+  template<typename Predicate>
+  bool find(std::uint32_t hash, const Predicate &isMatch, std::uint32_t &id) const {
+    std::uint32_t mask = header_->capacity - 1;
+    for (std::uint32_t i = hash & mask;; i = (i + 1) & mask) {
+      const auto &slot = slots_[i];
+      if (slot.id == 0)
+        return false;
+      if (slot.hash == hash && isMatch(slot.id - 1)) {
+        id = slot.id - 1;
+        return true;
+      }
+    }
+  }
+
+  /// Writes modified pages of table to file.
+  void sync() {
+    region_.flush();
+  }
+
+  /// Adds string with next id. Table grows twice if it is half full.
+  void add(std::uint32_t hash) {
+    if ((header_->count + 1) * 2 > header_->capacity)
+      grow();
+    insert(hash, end());
+    ++header_->count;
+  }
+
+ private:
+  static std::size_t getFileSize(std::uint32_t capacity) {
+    return sizeof(HashTableHeader) + capacity * sizeof(HashSlot);
+  }
+
+  void insert(std::uint32_t hash, std::uint32_t id) {
+    std::uint32_t mask = header_->capacity - 1;
+    std::uint32_t i = hash & mask;
+    while (slots_[i].id != 0) i = (i + 1) & mask;
+    slots_[i].hash = hash;
+    slots_[i].id = id + 1;
+  }
+
+  void grow() {
+    std::vector<HashSlot> slots(slots_, slots_ + header_->capacity);
+    std::uint32_t first = header_->first, count = header_->count;
+
+    create(first, count * 2);
+    for (const auto &slot : slots) {
+      if (slot.id != 0)
+        insert(slot.hash, slot.id - 1);
+    }
+    header_->count = count;
+  }
+
+  void map() {
+    using namespace boost::interprocess;
+    mapping_ = file_mapping(path_.c_str(), read_write);
+    region_ = mapped_region(mapping_, read_write);
+    header_ = static_cast<HashTableHeader *>(region_.get_address());
+    slots_ = reinterpret_cast<HashSlot *>(header_ + 1);
+  }
+
+  void unmap() {
+    region_ = boost::interprocess::mapped_region();
+    mapping_ = boost::interprocess::file_mapping();
+    header_ = nullptr;
+    slots_ = nullptr;
+  }
+
+  const std::string path_;
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+  HashTableHeader *header_;
+  HashSlot *slots_;
+};
+}
+
+/// Keeps strings in append only data and index files and finds them using memory
+/// mapped hash table file. Index file is memory mapped too, so nothing is read on startup.
+/// Strings which are already known are looked up without lock in immutable snapshot.
+/// It is republished with strings found under lock once enough of them are collected.
+/// If table is sealed, strings which existed on sealing are found in sealed table
+/// without lock and hash table contains only strings added after it.
+/// New strings are appended to memory buffers which are written to files in fast mode
+/// when they grow enough or on flush. In safe mode, strings added by one call are written
+/// at once: data file is synced before index file, so index never refers to missing data.
+/// Sorted dictionary of all strings is built on first prefix or similarity search
+/// and is extended by strings added later.
+/// NOTE hash table is rebuilt from index if it is missing or doesn't match index.
 class StringTable::StringTableImpl {
-  typedef std::vector<std::uint32_t> IdList;
-  typedef std::unordered_map<std::uint32_t, IdList> HashIdMap;
+  /// Immutable set of known strings shared by readers.
+  struct Snapshot {
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::unordered_map<std::uint32_t, std::shared_ptr<std::string>> strings;
+  };
+
+  /// Dictionary entry. View stays valid while table exists.
+  struct Term {
+    StringView view;
+    std::uint32_t id;
+  };
 
  public:
-  StringTableImpl(const std::string &indexPath, const std::string &dataPath, std::uint32_t seed) :
+  StringTableImpl(const std::string &indexPath,
+                  const std::string &dataPath,
+                  const std::string &hashPath,
+                  const std::string &sealedPath,
+                  Durability durability,
+                  std::uint32_t seed) :
+      indexPath_(indexPath),
+      dataPath_(dataPath),
       indexFile_(indexPath, ios::in | ios::out | ios::binary | ios::ate | ios::app),
       dataFile_(dataPath, ios::in | ios::out | ios::binary | ios::app),
+      durability_(durability),
       seed_(seed),
       nextId_(0),
-      map_(),
+      dataSize_(0),
+      flushedDataSize_(0),
+      pendingData_(),
+      pendingIndex_(),
+      mappedCount_(0),
+      mappedDataSize_(0),
+      sealedPath_(sealedPath),
+      sealedCount_(0),
+      hashTable_(hashPath),
       offsets_(),
-      cache_(1024) {
-    nextId_ = static_cast<std::uint32_t>(indexFile_.tellg()/(sizeof(std::uint32_t)*2));
+      snapshot_(std::make_shared<const Snapshot>()),
+      pending_(),
+      views_(),
+      cache_(1024, utymap::utils::Metrics::Cache::Strings, getSize) {
+    nextId_ = static_cast<std::uint32_t>(indexFile_.tellg() / IndexEntrySize);
+    dataFile_.seekg(0, ios::end);
+    dataSize_ = static_cast<std::uint32_t>(dataFile_.tellg());
+    flushedDataSize_ = dataSize_;
     if (nextId_ > 0) {
-      std::uint32_t count = nextId_;
-      indexFile_.seekg(0, ios::beg);
-
-      // NOTE reserve some extra size for possible insertions
-      std::size_t capacity = count + 2048;
-      offsets_.reserve(capacity);
-      map_.reserve(capacity);
-
-      for (std::uint32_t i = 0; i < count; ++i) {
-        std::uint32_t hash, offset;
-        indexFile_.read(reinterpret_cast<char *>(&hash), sizeof(hash));
-        indexFile_.read(reinterpret_cast<char *>(&offset), sizeof(offset));
-        offsets_.push_back(offset);
-        map_[hash].push_back(i);
+      using namespace boost::interprocess;
+      indexMapping_ = file_mapping(indexPath.c_str(), read_only);
+      indexRegion_ = mapped_region(indexMapping_, read_only, 0, nextId_ * IndexEntrySize);
+      mappedCount_ = nextId_;
+
+      mappedDataSize_ = dataSize_;
+      if (mappedDataSize_ > 0) {
+        dataMapping_ = file_mapping(dataPath.c_str(), read_only);
+        dataRegion_ = mapped_region(dataMapping_, read_only, 0, mappedDataSize_);
       }
     }
+
+    // NOTE sealed table is built from index, so it cannot have more strings.
+    if (sealed_.open(sealedPath_)) {
+      if (sealed_.count() <= nextId_)
+        sealedCount_ = sealed_.count();
+      else
+        sealed_.close();
+    }
+
+    if (!hashTable_.open() || hashTable_.first() != sealedCount_ || hashTable_.end() > nextId_)
+      hashTable_.create(sealedCount_, nextId_ - sealedCount_);
+    // NOTE table misses strings if it was not updated after index: add them.
+    for (std::uint32_t id = hashTable_.end(); id < nextId_; ++id)
+      hashTable_.add(getIndexEntry(id, 0));
+  }
+
+  ~StringTableImpl() {
+    try {
+      flushPending(durability_ == Durability::Safe);
+    } catch (...) {
+      // NOTE strings not written here are lost, but written index stays consistent.
+    }
+  }
+
+  void setDurability(Durability durability) {
+    std::lock_guard<std::mutex> lock(lock_);
+    durability_ = durability;
+    commit();
+  }
+
+  void flush() {
+    std::lock_guard<std::mutex> lock(lock_);
+    flushPending(durability_ == Durability::Safe);
+  }
+
+  void getIdsByPrefix(const std::string &prefix, std::size_t maxCount, std::vector<std::uint32_t> &ids) {
+    std::lock_guard<std::mutex> lock(dictionaryLock_);
+    updateDictionary();
+
+    StringView view = { prefix.c_str(), prefix.size() };
+    auto term = std::lower_bound(dictionary_.begin(), dictionary_.end(), view, [](const Term &t, const StringView &v) {
+      return isLess(t.view, v);
+    });
+    for (; term != dictionary_.end() && ids.size() < maxCount; ++term) {
+      if (term->view.size < prefix.size() || std::memcmp(term->view.data, prefix.c_str(), prefix.size()) != 0)
+        break;
+      ids.push_back(term->id);
+    }
+  }
+
+  void getIdsBySimilarity(const std::string &str, std::size_t maxDistance, std::size_t maxCount,
+                          std::vector<std::uint32_t> &ids) {
+    std::lock_guard<std::mutex> lock(dictionaryLock_);
+    updateDictionary();
+
+    StringView view = { str.c_str(), str.size() };
+    std::vector<std::size_t> row;
+    for (auto term = dictionary_.begin(); term != dictionary_.end() && ids.size() < maxCount; ++term) {
+      if (getDistance(term->view, view, maxDistance, row) <= maxDistance)
+        ids.push_back(term->id);
+    }
+  }
+
+  void seal() {
+    std::lock_guard<std::mutex> lock(lock_);
+    writeSealed();
+  }
+
+  /// Seals table and copies its files to given paths. Hash file is not copied as
+  /// it is rebuilt from index when copy is opened.
+  void exportTo(const std::string &indexPath, const std::string &dataPath, const std::string &sealedPath) {
+    std::lock_guard<std::mutex> lock(lock_);
+    writeSealed();
+    for (const auto &pair : { std::make_pair(indexPath_, indexPath),
+                              std::make_pair(dataPath_, dataPath),
+                              std::make_pair(sealedPath_, sealedPath) }) {
+      boost::filesystem::remove(pair.second);
+      boost::filesystem::copy_file(pair.first, pair.second);
+    }
   }
 
   std::uint32_t getId(const std::string &str) {
-    std::uint32_t hash;
+    std::uint32_t hash, id = 0;
     MurmurHash3_x86_32(str.c_str(), static_cast<int>(str.size()), seed_, &hash);
+    if (sealedCount_ > 0 && sealed_.find(str, hash, id)) {
+      utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StringHits);
+      return id;
+    }
+
+    auto snapshot = std::atomic_load(&snapshot_);
+    auto known = snapshot->ids.find(str);
+    if (known != snapshot->ids.end()) {
+      utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StringHits);
+      return known->second;
+    }
 
-    // TODO avoid lock there
     std::lock_guard<std::mutex> lock(lock_);
-    HashIdMap::iterator hashLookupResult = map_.find(hash);
-    if (hashLookupResult!=map_.end()) {
-      std::string data;
-      for (std::uint32_t id : hashLookupResult->second) {
-        // first check string in cache
-        if (cache_.exists(id) && *cache_.peek(id) == str) {
-          cache_.promote(id);
-          return id;
-        }
-        data.clear();
-        readString(id, data);
-        if (str==data)
-          return id;
+    std::string data;
+    bool isFound = hashTable_.find(hash, [&](std::uint32_t candidate) {
+      return isSame(candidate, str, data);
+    }, id);
+    if (!isFound) {
+      writeString(hash, str);
+      id = nextId_++;
+      commit();
+    }
+    utymap::utils::Metrics::add(isFound ? utymap::utils::Metrics::Counter::StringHits
+                                        : utymap::utils::Metrics::Counter::StringMisses);
+
+    publish(id, std::make_shared<std::string>(str));
+    return id;
+  }
+
+  void getIds(const std::vector<const std::string *> &strings, std::vector<std::uint32_t> &ids) {
+    ids.resize(strings.size());
+
+    // NOTE hashes are calculated before lock is taken.
+    auto snapshot = std::atomic_load(&snapshot_);
+    std::vector<std::pair<std::size_t, std::uint32_t>> misses;
+    for (std::size_t i = 0; i < strings.size(); ++i) {
+      const auto &str = *strings[i];
+      std::uint32_t hash;
+      MurmurHash3_x86_32(str.c_str(), static_cast<int>(str.size()), seed_, &hash);
+      if (sealedCount_ > 0 && sealed_.find(str, hash, ids[i]))
+        continue;
+      auto known = snapshot->ids.find(str);
+      if (known != snapshot->ids.end()) {
+        ids[i] = known->second;
+        continue;
+      }
+      misses.push_back(std::make_pair(i, hash));
+    }
+    if (misses.empty()) {
+      utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StringHits, strings.size());
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    const std::uint32_t firstId = nextId_;
+    std::vector<const std::string *> added;
+    std::string data;
+
+    for (const auto &miss : misses) {
+      const auto &str = *strings[miss.first];
+      std::uint32_t hash = miss.second, id = 0;
+      // NOTE strings added by this call are compared without reading them back.
+      bool isFound = hashTable_.find(hash, [&](std::uint32_t candidate) {
+        return candidate >= firstId ? *added[candidate - firstId] == str : isSame(candidate, str, data);
+      }, id);
+      if (!isFound) {
+        writeString(hash, str);
+        added.push_back(&str);
+        id = nextId_++;
       }
+      ids[miss.first] = id;
+      publish(id, std::make_shared<std::string>(str));
     }
 
-    writeString(hash, str);
-    return nextId_++;
+    if (!added.empty())
+      commit();
+    utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StringHits, strings.size() - added.size());
+    utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StringMisses, added.size());
   }
 
   std::shared_ptr<std::string> getString(std::uint32_t id) {
+    if (id < sealedCount_) {
+      auto view = sealed_.getView(id);
+      return std::make_shared<std::string>(view.data, view.size);
+    }
+
+    auto snapshot = std::atomic_load(&snapshot_);
+    auto known = snapshot->strings.find(id);
+    if (known != snapshot->strings.end())
+      return known->second;
+
+    return cache_.getOrLoad(id, [this](std::uint32_t id) {
+      std::lock_guard<std::mutex> lock(lock_);
+      auto str = std::make_shared<std::string>();
+      readString(id, *str);
+      if (id < nextId_)
+        publish(id, str);
+      return str;
+    });
+  }
+
+  StringView getStringView(std::uint32_t id) {
+    // NOTE mapped data is never changed, so it is read without lock.
+    if (id < sealedCount_)
+      return sealed_.getView(id);
+
+    if (id < mappedCount_) {
+      std::uint32_t offset = getIndexEntry(id, 1);
+      if (offset >= mappedDataSize_)
+        return StringView{ "", 0 };
+      const char *data = static_cast<const char *>(dataRegion_.get_address()) + offset;
+      const void *end = std::memchr(data, '\0', mappedDataSize_ - offset);
+      // NOTE last string is not terminated only if data file was truncated.
+      if (end == nullptr)
+        return StringView{ "", 0 };
+      return StringView{ data, static_cast<std::size_t>(static_cast<const char *>(end) - data) };
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    if (id >= nextId_)
+      return StringView{ "", 0 };
+
+    auto view = views_.find(id);
+    if (view == views_.end()) {
+      auto str = utymap::utils::make_unique<std::string>();
+      readString(id, *str);
+      view = views_.emplace(id, std::move(str)).first;
+    }
+    return StringView{ view->second->c_str(), view->second->size() };
+  }
+
+  std::size_t getMemoryUsage() {
+    std::lock_guard<std::mutex> dictionaryLock(dictionaryLock_);
+    std::lock_guard<std::mutex> lock(lock_);
+    return cache_.weigh() + getSnapshotSize() + dictionary_.capacity() * sizeof(Term);
+  }
+
+  void trimMemory(std::size_t maxBytes) {
+    std::lock_guard<std::mutex> dictionaryLock(dictionaryLock_);
     std::lock_guard<std::mutex> lock(lock_);
-    if (cache_.exists(id))
-      return cache_.get(id);
+    std::size_t snapshotBytes = getSnapshotSize();
+    std::size_t dictionaryBytes = dictionary_.capacity() * sizeof(Term);
+    std::size_t otherBytes = snapshotBytes + dictionaryBytes;
+    std::size_t cacheBytes = cache_.trim(maxBytes > otherBytes ? maxBytes - otherBytes : 0);
+    if (cacheBytes + otherBytes <= maxBytes)
+      return;
 
-    std::string str;
-    readString(id, str);
-    cache_.put(id, std::move(str));
+    // NOTE readers keep snapshot which they have already loaded.
+    std::atomic_store(&snapshot_, std::make_shared<const Snapshot>());
+    pending_.clear();
+    if (cacheBytes + dictionaryBytes <= maxBytes)
+      return;
 
-    return cache_.get(id);
+    std::vector<Term>().swap(dictionary_);
   }
 
  private:
+  static std::size_t getSize(const std::string &str) {
+    return sizeof(std::string) + str.capacity();
+  }
+
+  /// Gets approximate memory used by published and pending strings.
+  /// NOTE should be called under lock.
+  std::size_t getSnapshotSize() const {
+    auto snapshot = std::atomic_load(&snapshot_);
+    std::size_t bytes = 0;
+    for (const auto &pair : pending_)
+      bytes += getSize(*pair.second) + NodeSize;
+    for (const auto &pair : snapshot->strings)
+      bytes += 2 * (getSize(*pair.second) + NodeSize);
+    return bytes;
+  }
+
+  /// Adds strings which are not in dictionary yet.
+  /// NOTE should be called under dictionary lock.
+  void updateDictionary() {
+    std::uint32_t count;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      count = nextId_;
+    }
+    if (count <= dictionary_.size())
+      return;
+
+    auto first = static_cast<std::uint32_t>(dictionary_.size());
+    dictionary_.reserve(count);
+    for (std::uint32_t id = first; id < count; ++id)
+      dictionary_.push_back(Term{ getStringView(id), id });
+
+    auto compare = [](const Term &lhs, const Term &rhs) { return isLess(lhs.view, rhs.view); };
+    auto middle = dictionary_.begin() + first;
+    std::sort(middle, dictionary_.end(), compare);
+    std::inplace_merge(dictionary_.begin(), middle, dictionary_.end(), compare);
+  }
+
+  /// Collects known string and republishes snapshot with collected strings.
+  /// NOTE should be called under lock.
+  void publish(std::uint32_t id, const std::shared_ptr<std::string> &str) {
+    auto snapshot = std::atomic_load(&snapshot_);
+    std::size_t size = snapshot->strings.size();
+    // NOTE string which is looked up again before it is published is collected once.
+    if (size >= MaxPublishedSize || snapshot->strings.count(id) > 0 || !pending_.emplace(id, str).second)
+      return;
+
+    // NOTE snapshot is copied, so publishing is delayed until it grows enough.
+    if (pending_.size() < std::max(MinPublishSize, size / 2))
+      return;
+
+    auto next = std::make_shared<Snapshot>(*snapshot);
+    for (const auto &pair : pending_) {
+      next->ids.insert(std::make_pair(*pair.second, pair.first));
+      next->strings.insert(pair);
+    }
+    pending_.clear();
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(next)));
+  }
+
+  /// Gets field of index entry: zero is hash, one is offset.
+  std::uint32_t getIndexEntry(std::uint32_t id, std::size_t field) const {
+    std::uint32_t value;
+    const char *entry = static_cast<const char *>(indexRegion_.get_address()) + id * IndexEntrySize;
+    std::memcpy(&value, entry + field * sizeof(value), sizeof(value));
+    return value;
+  }
+
+  /// Checks whether string with given id is equal to given one. Data is used as buffer.
+  bool isSame(std::uint32_t id, const std::string &str, std::string &data) {
+    // first check string in cache
+    auto cached = cache_.find(id);
+    if (cached != nullptr && *cached == str)
+      return true;
+    data.clear();
+    readString(id, data);
+    return str == data;
+  }
 
   /// Reads string by id.
   void readString(std::uint32_t id, std::string &data) {
-    if (id < offsets_.size()) {
-      std::uint32_t offset = offsets_[id];
+    if (id < nextId_) {
+      std::uint32_t offset = id < mappedCount_ ? getIndexEntry(id, 1) : offsets_[id - mappedCount_];
+      if (offset >= flushedDataSize_) {
+        data.assign(pendingData_.c_str() + (offset - flushedDataSize_));
+        return;
+      }
       dataFile_.seekg(offset, ios::beg);
       std::getline(dataFile_, data, '\0');
     }
   }
 
-  /// Writes string to index.
+  /// Appends string and its index entry to pending buffers.
   void writeString(std::uint32_t hash, const std::string &data) {
-    // get offset as file size
-    dataFile_.seekg(0, ios::end);
-    std::uint32_t offset = static_cast<std::uint32_t>(dataFile_.tellg());
+    std::uint32_t offset = dataSize_;
+    pendingData_.append(data.c_str());
+    pendingData_.push_back('\0');
+    dataSize_ = flushedDataSize_ + static_cast<std::uint32_t>(pendingData_.size());
+
+    pendingIndex_.append(reinterpret_cast<const char *>(&hash), sizeof(hash));
+    pendingIndex_.append(reinterpret_cast<const char *>(&offset), sizeof(offset));
+
+    hashTable_.add(hash);
+    offsets_.push_back(offset);
+  }
+
+  /// Writes sealed table of all strings.
+  /// NOTE should be called under lock.
+  void writeSealed() {
+    // NOTE sealed table cannot have strings which are missing in index.
+    flushPending(durability_ == Durability::Safe);
+    std::vector<std::string> strings(nextId_);
+    std::vector<std::uint32_t> hashes(nextId_);
+    for (std::uint32_t id = 0; id < nextId_; ++id) {
+      if (id < sealedCount_) {
+        auto view = sealed_.getView(id);
+        strings[id].assign(view.data, view.size);
+      } else
+        readString(id, strings[id]);
+      MurmurHash3_x86_32(strings[id].c_str(), static_cast<int>(strings[id].size()), seed_, &hashes[id]);
+    }
+    SealedTable::write(sealedPath_, strings, hashes);
+  }
+
+  /// Writes pending buffers according to durability mode.
+  /// NOTE should be called under lock after strings are added.
+  void commit() {
+    if (durability_ == Durability::Safe)
+      flushPending(true);
+    else if (pendingData_.size() + pendingIndex_.size() >= MaxPendingSize)
+      flushPending(false);
+  }
+
+  /// Writes pending buffers to files. Data is written before index.
+  void flushPending(bool isSync) {
+    if (pendingIndex_.empty())
+      return;
 
-    // write string
     dataFile_.seekp(0, ios::end);
-    dataFile_ << data.c_str() << '\0';
+    dataFile_.write(pendingData_.data(), pendingData_.size());
+    dataFile_.flush();
+    if (isSync) syncFile(dataPath_);
 
-    // write index entry
     indexFile_.seekp(0, ios::end);
-    indexFile_.write(reinterpret_cast<char *>(&hash), sizeof(hash));
-    indexFile_.write(reinterpret_cast<char *>(&offset), sizeof(offset));
+    indexFile_.write(pendingIndex_.data(), pendingIndex_.size());
+    indexFile_.flush();
+    if (isSync) {
+      syncFile(indexPath_);
+      hashTable_.sync();
+    }
 
-    map_[hash].push_back(nextId_);
-    offsets_.push_back(offset);
+    if (!dataFile_.good() || !indexFile_.good())
+      throw std::domain_error("Cannot write string table: " + indexPath_);
+
+    flushedDataSize_ = dataSize_;
+    pendingData_.clear();
+    pendingIndex_.clear();
   }
 
+  const std::string indexPath_;
+  const std::string dataPath_;
   std::fstream indexFile_;
   std::fstream dataFile_;
+  Durability durability_;
   std::uint32_t seed_;
   std::uint32_t nextId_;
 
-  /// TODO think about better data structure alternatives
-  HashIdMap map_;
+  /// Size of data including pending strings.
+  std::uint32_t dataSize_;
+  /// Size of data written to file.
+  std::uint32_t flushedDataSize_;
+  /// Strings and index entries which are not written to files yet.
+  std::string pendingData_;
+  std::string pendingIndex_;
+
+  /// Index entries which existed on startup are read from mapped index.
+  boost::interprocess::file_mapping indexMapping_;
+  boost::interprocess::mapped_region indexRegion_;
+  std::uint32_t mappedCount_;
+  boost::interprocess::file_mapping dataMapping_;
+  boost::interprocess::mapped_region dataRegion_;
+  std::size_t mappedDataSize_;
+
+  /// Strings which existed when table was sealed.
+  const std::string sealedPath_;
+  SealedTable sealed_;
+  std::uint32_t sealedCount_;
+
+  HashTable hashTable_;
+  /// Offsets of strings added after startup.
   std::vector<std::uint32_t> offsets_;
 
+  /// Published known strings. Accessed atomically.
+  std::shared_ptr<const Snapshot> snapshot_;
+  /// Known strings which are not published yet.
+  std::unordered_map<std::uint32_t, std::shared_ptr<std::string>> pending_;
+  /// Strings added after startup which are requested as views. They are never removed.
+  std::unordered_map<std::uint32_t, std::unique_ptr<std::string>> views_;
+
   std::mutex lock_;
-  utymap::utils::LruCache<std::uint32_t, std::string> cache_;
+  /// NOTE cache has own locks, so strings are looked up without lock.
+  utymap::utils::ShardedLruCache<std::uint32_t, std::string> cache_;
+
+  /// Strings sorted for prefix search. Ids from zero to its size are added.
+  std::vector<Term> dictionary_;
+  std::mutex dictionaryLock_;
 };
 
-StringTable::StringTable(const std::string &path) :
-    pimpl_(utymap::utils::make_unique<StringTableImpl>(path + "string.idx", path + "string.dat", 0)) {
+StringTable::StringTable(const std::string &path, Durability durability) :
+    pimpl_(utymap::utils::make_unique<StringTableImpl>(path + "string.idx",
+                                                       path + "string.dat",
+                                                       path + "string.hsh",
+                                                       path + "string.sld",
+                                                       durability,
+                                                       0)) {
+}
+
+void StringTable::setDurability(Durability durability) {
+  pimpl_->setDurability(durability);
+}
+
+void StringTable::flush() const {
+  pimpl_->flush();
+}
+
+void StringTable::seal() {
+  pimpl_->seal();
+}
+
+void StringTable::exportTo(const std::string &path) {
+  pimpl_->exportTo(path + "string.idx", path + "string.dat", path + "string.sld");
 }
 
 StringTable::~StringTable() {}
 
 std::uint32_t StringTable::getId(const std::string &str) const {
+  ALLOCATION_SCOPE(Strings);
   return pimpl_->getId(str);
 }
 
 std::shared_ptr<std::string> StringTable::getString(std::uint32_t id) const {
+  ALLOCATION_SCOPE(Strings);
   return pimpl_->getString(id);
 }
+
+void StringTable::getIds(const std::vector<std::string> &strings, std::vector<std::uint32_t> &ids) const {
+  std::vector<const std::string *> pointers;
+  pointers.reserve(strings.size());
+  for (const auto &str : strings)
+    pointers.push_back(&str);
+  pimpl_->getIds(pointers, ids);
+}
+
+void StringTable::getIds(const std::vector<const std::string *> &strings, std::vector<std::uint32_t> &ids) const {
+  pimpl_->getIds(strings, ids);
+}
+
+void StringTable::getIdsByPrefix(const std::string &prefix, std::size_t maxCount, std::vector<std::uint32_t> &ids) const {
+  pimpl_->getIdsByPrefix(prefix, maxCount, ids);
+}
+
+void StringTable::getIdsBySimilarity(const std::string &str,
+                                     std::size_t maxDistance,
+                                     std::size_t maxCount,
+                                     std::vector<std::uint32_t> &ids) const {
+  pimpl_->getIdsBySimilarity(str, maxDistance, maxCount, ids);
+}
+
+StringTable::StringView StringTable::getStringView(std::uint32_t id) const {
+  ALLOCATION_SCOPE(Strings);
+  return pimpl_->getStringView(id);
+}
+
+std::size_t StringTable::getMemoryUsage() const {
+  return pimpl_->getMemoryUsage();
+}
+
+void StringTable::trimMemory(std::size_t maxBytes) const {
+  pimpl_->trimMemory(maxBytes);
+}
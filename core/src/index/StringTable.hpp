@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace utymap {
 namespace index {
@@ -12,23 +13,89 @@ namespace index {
 /// Index file consists of id-offset pairs where id - string id,
 /// offset - first character of the string inside data file.
 /// data file contains list of null terminated strings.
+/// Hash file contains open addressing table of string hashes and ids which
+/// is memory mapped and searched in place, so startup cost doesn't depend on
+/// table size. It is rebuilt from index if missing.
+/// Sealed file is optional read only snapshot of strings built by seal.
+/// New strings are buffered and appended to data and index files in groups.
 class StringTable final {
  public:
+  /// Defines when new strings are written to files.
+  enum class Durability {
+    /// Strings are buffered until buffer is full or table is flushed.
+    /// Strings added after last flush are lost on crash.
+    Fast,
+    /// Strings added by one call are written and synced with storage device at once.
+    Safe
+  };
+
+  /// Represents null terminated string stored in table.
+  struct StringView {
+    const char *data;
+    std::size_t size;
+  };
 
   /// Creates instance of StringTable using file path provided.
-  explicit StringTable(const std::string &path);
+  explicit StringTable(const std::string &path, Durability durability = Durability::Fast);
 
   StringTable(const StringTable &) = delete;
   StringTable &operator=(StringTable const &) = delete;
 
+  /// Flushes pending strings.
   ~StringTable();
 
+  /// Changes durability mode. Pending strings are written if mode is safe.
+  void setDurability(Durability durability);
+
+  /// Writes pending strings to files. They are synced with storage device in safe mode.
+  void flush() const;
+
   /// Gets id of given string.
   std::uint32_t getId(const std::string &str) const;
 
+  /// Compiles all strings into sealed table file with minimal perfect hash. When table
+  /// is opened next time, these strings are found with at most one string comparison
+  /// and strings added later are kept in small overflow hash table.
+  /// NOTE sealed table is written next to other files and is used after table is reopened.
+  void seal();
+
+  /// Seals table and copies its files using given path prefix, so table can be opened
+  /// there by another instance.
+  void exportTo(const std::string &path);
+
+  /// Gets ids of given strings. Lock is taken once and new strings are written at once.
+  void getIds(const std::vector<std::string> &strings, std::vector<std::uint32_t> &ids) const;
+
+  /// Gets ids of given strings without copying them.
+  void getIds(const std::vector<const std::string *> &strings, std::vector<std::uint32_t> &ids) const;
+
   /// Gets original string by id.
   std::shared_ptr<std::string> getString(std::uint32_t id) const;
 
+  /// Appends ids of strings which start with given prefix in byte order. At most maxCount ids are appended.
+  /// NOTE sorted dictionary of all strings is built on first call.
+  void getIdsByPrefix(const std::string &prefix, std::size_t maxCount, std::vector<std::uint32_t> &ids) const;
+
+  /// Appends ids of strings which differ from given one by at most maxDistance
+  /// edits. At most maxCount ids are appended.
+  /// NOTE all strings are checked, so it is slower than prefix search.
+  void getIdsBySimilarity(const std::string &str,
+                          std::size_t maxDistance,
+                          std::size_t maxCount,
+                          std::vector<std::uint32_t> &ids) const;
+
+  /// Gets original string by id without copying it. View stays valid while table exists.
+  /// NOTE strings which existed on startup are read from memory mapped data file.
+  StringView getStringView(std::uint32_t id) const;
+
+  /// Returns approximate memory used by cached strings and dictionary.
+  std::size_t getMemoryUsage() const;
+
+  /// Releases cached strings until they use at most given amount of memory: least recently
+  /// used strings are dropped first, then snapshot of known strings, then dictionary.
+  /// NOTE dropped data is rebuilt on demand, strings stored in files are not affected.
+  void trimMemory(std::size_t maxBytes) const;
+
  private:
   class StringTableImpl;
   std::unique_ptr<StringTableImpl> pimpl_;
@@ -0,0 +1,251 @@
+#include "index/TilePack.hpp"
+#include "utils/CoreUtils.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace utymap;
+using namespace utymap::index;
+
+namespace {
+const char PackMagic[] = { 'U', 'T', 'P', 'K' };
+/// Version 1 has no bounds section.
+const std::uint32_t PackVersion = 2;
+const std::uint32_t PackVersionWithoutBounds = 1;
+
+/// Amount of files per tile: index, data, bitmap and bounds.
+const std::size_t SectionCount = 4;
+const std::size_t SectionCountWithoutBounds = 3;
+
+struct PackHeader {
+  char magic[sizeof(PackMagic)];
+  std::uint32_t version;
+  std::uint32_t tileCount;
+  std::uint32_t reserved;
+};
+
+/// Directory entry: quad key and offsets with sizes of its files inside pack.
+struct DirectoryEntry {
+  std::int32_t levelOfDetail;
+  std::int32_t tileX;
+  std::int32_t tileY;
+  std::uint32_t reserved;
+  std::uint64_t offsets[SectionCount];
+  std::uint64_t sizes[SectionCount];
+
+  QuadKey quadKey() const {
+    return QuadKey(levelOfDetail, tileX, tileY);
+  }
+};
+
+/// Directory entry of version 1 pack.
+struct DirectoryEntryWithoutBounds {
+  std::int32_t levelOfDetail;
+  std::int32_t tileX;
+  std::int32_t tileY;
+  std::uint32_t reserved;
+  std::uint64_t offsets[SectionCountWithoutBounds];
+  std::uint64_t sizes[SectionCountWithoutBounds];
+};
+
+std::size_t getFileSize(const std::string &path) {
+  std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+  return file.good() ? static_cast<std::size_t>(file.tellg()) : 0;
+}
+
+void copyFile(const std::string &path, std::ostream &out) {
+  std::ifstream file(path, std::ios::in | std::ios::binary);
+  if (file.good() && file.peek() != std::ifstream::traits_type::eof())
+    out << file.rdbuf();
+}
+
+TilePack::Section &getSection(TilePack::Tile &tile, std::size_t index) {
+  return index == 0 ? tile.index : (index == 1 ? tile.data : (index == 2 ? tile.bitmap : tile.bounds));
+}
+
+const TilePack::Section &getSection(const TilePack::Tile &tile, std::size_t index) {
+  return index == 0 ? tile.index : (index == 1 ? tile.data : (index == 2 ? tile.bitmap : tile.bounds));
+}
+}
+
+class TilePack::TilePackImpl final {
+ public:
+  explicit TilePackImpl(const std::string &path) :
+      mapping_(path.c_str(), boost::interprocess::read_only),
+      region_(mapping_, boost::interprocess::read_only),
+      directory_() {
+    const char *data = static_cast<const char *>(region_.get_address());
+    std::size_t size = region_.get_size();
+
+    PackHeader header;
+    if (size < sizeof(header))
+      throw std::domain_error("Invalid tile pack: " + path);
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, PackMagic, sizeof(PackMagic)) != 0 ||
+        (header.version != PackVersion && header.version != PackVersionWithoutBounds))
+      throw std::domain_error("Unsupported tile pack: " + path);
+
+    if (header.version == PackVersion)
+      readDirectory<DirectoryEntry>(data, size, header.tileCount, path);
+    else
+      readDirectory<DirectoryEntryWithoutBounds>(data, size, header.tileCount, path);
+
+    for (const auto &entry : directory_) {
+      for (std::size_t i = 0; i < SectionCount; ++i) {
+        if (entry.offsets[i] + entry.sizes[i] > size)
+          throw std::domain_error("Invalid tile pack entry: " + path);
+      }
+    }
+  }
+
+  bool find(const QuadKey &quadKey, Tile &tile) const {
+    auto entry = findEntry(quadKey);
+    if (entry == directory_.end())
+      return false;
+
+    const char *data = static_cast<const char *>(region_.get_address());
+    for (std::size_t i = 0; i < SectionCount; ++i) {
+      auto &section = getSection(tile, i);
+      section.data = data + entry->offsets[i];
+      section.size = static_cast<std::size_t>(entry->sizes[i]);
+    }
+    return true;
+  }
+
+  bool contains(const QuadKey &quadKey) const {
+    return findEntry(quadKey) != directory_.end();
+  }
+
+  std::vector<QuadKey> getQuadKeys() const {
+    std::vector<QuadKey> quadKeys;
+    quadKeys.reserve(directory_.size());
+    for (const auto &entry : directory_)
+      quadKeys.push_back(entry.quadKey());
+    return quadKeys;
+  }
+
+ private:
+  /// Reads directory entries of given type. Missing sections are empty.
+  template<typename Entry>
+  void readDirectory(const char *data, std::size_t size, std::uint32_t tileCount, const std::string &path) {
+    std::size_t directorySize = tileCount * sizeof(Entry);
+    if (sizeof(PackHeader) + directorySize > size)
+      throw std::domain_error("Invalid tile pack directory: " + path);
+
+    const std::size_t sectionCount = sizeof(Entry::offsets) / sizeof(Entry::offsets[0]);
+    directory_.resize(tileCount);
+    for (std::uint32_t i = 0; i < tileCount; ++i) {
+      Entry entry;
+      std::memcpy(&entry, data + sizeof(PackHeader) + i * sizeof(Entry), sizeof(Entry));
+      auto &result = directory_[i];
+      result.levelOfDetail = entry.levelOfDetail;
+      result.tileX = entry.tileX;
+      result.tileY = entry.tileY;
+      result.reserved = 0;
+      for (std::size_t j = 0; j < SectionCount; ++j) {
+        result.offsets[j] = j < sectionCount ? entry.offsets[j] : 0;
+        result.sizes[j] = j < sectionCount ? entry.sizes[j] : 0;
+      }
+    }
+  }
+
+  std::vector<DirectoryEntry>::const_iterator findEntry(const QuadKey &quadKey) const {
+    QuadKey::Comparator comparator;
+    auto entry = std::lower_bound(directory_.begin(), directory_.end(), quadKey,
+                                  [&](const DirectoryEntry &e, const QuadKey &key) {
+                                    return comparator(e.quadKey(), key);
+                                  });
+    return entry != directory_.end() && entry->quadKey() == quadKey ? entry : directory_.end();
+  }
+
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+  std::vector<DirectoryEntry> directory_;
+};
+
+void TilePack::Builder::add(const QuadKey &quadKey, const Tile &tile) {
+  sources_.push_back(Source{ quadKey, tile, {} });
+}
+
+void TilePack::Builder::add(const QuadKey &quadKey,
+                            const std::string &indexPath,
+                            const std::string &dataPath,
+                            const std::string &bitmapPath,
+                            const std::string &boundsPath) {
+  sources_.push_back(Source{ quadKey, Tile(), { indexPath, dataPath, bitmapPath, boundsPath } });
+}
+
+bool TilePack::Builder::empty() const {
+  return sources_.empty();
+}
+
+void TilePack::Builder::write(const std::string &path) {
+  QuadKey::Comparator comparator;
+  std::sort(sources_.begin(), sources_.end(), [&](const Source &lhs, const Source &rhs) {
+    return comparator(lhs.quadKey, rhs.quadKey);
+  });
+
+  PackHeader header;
+  std::memcpy(header.magic, PackMagic, sizeof(PackMagic));
+  header.version = PackVersion;
+  header.tileCount = static_cast<std::uint32_t>(sources_.size());
+  header.reserved = 0;
+
+  std::vector<DirectoryEntry> directory(sources_.size());
+  std::uint64_t offset = sizeof(header) + directory.size() * sizeof(DirectoryEntry);
+  for (std::size_t i = 0; i < sources_.size(); ++i) {
+    const auto &source = sources_[i];
+    auto &entry = directory[i];
+    entry.levelOfDetail = source.quadKey.levelOfDetail;
+    entry.tileX = source.quadKey.tileX;
+    entry.tileY = source.quadKey.tileY;
+    entry.reserved = 0;
+    for (std::size_t j = 0; j < SectionCount; ++j) {
+      entry.offsets[j] = offset;
+      entry.sizes[j] = source.paths.empty() ? getSection(source.tile, j).size : getFileSize(source.paths[j]);
+      offset += entry.sizes[j];
+    }
+  }
+
+  std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (!directory.empty())
+    file.write(reinterpret_cast<const char *>(&directory[0]), directory.size() * sizeof(DirectoryEntry));
+
+  for (const auto &source : sources_) {
+    for (std::size_t j = 0; j < SectionCount; ++j) {
+      if (source.paths.empty()) {
+        const auto &section = getSection(source.tile, j);
+        file.write(section.data, section.size);
+      } else
+        copyFile(source.paths[j], file);
+    }
+  }
+
+  file.flush();
+  if (!file.good())
+    throw std::domain_error("Cannot write tile pack: " + path);
+}
+
+TilePack::TilePack(const std::string &path) :
+    pimpl_(utymap::utils::make_unique<TilePackImpl>(path)) {
+}
+
+TilePack::~TilePack() {
+}
+
+bool TilePack::find(const QuadKey &quadKey, Tile &tile) const {
+  return pimpl_->find(quadKey, tile);
+}
+
+bool TilePack::contains(const QuadKey &quadKey) const {
+  return pimpl_->contains(quadKey);
+}
+
+std::vector<QuadKey> TilePack::getQuadKeys() const {
+  return pimpl_->getQuadKeys();
+}
@@ -0,0 +1,87 @@
+#ifndef INDEX_TILEPACK_HPP_DEFINED
+#define INDEX_TILEPACK_HPP_DEFINED
+
+#include "QuadKey.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Provides read access to tile pack: single file which contains index, data and
+/// bitmap files of many quad keys. Pack starts with tile directory sorted by quad key
+/// which is followed by file contents. Pack is memory mapped and never modified.
+/// Packs of previous version without bounds section are readable.
+class TilePack final {
+ public:
+  /// Represents content of single tile file.
+  struct Section {
+    const char *data;
+    std::size_t size;
+  };
+
+  /// Represents content of tile files.
+  struct Tile {
+    Section index;
+    Section data;
+    Section bitmap;
+    Section bounds;
+  };
+
+  /// Builds tile pack from tile files or from tiles of another pack.
+  class Builder final {
+   public:
+    /// Adds tile with content in memory. Content should stay valid until pack is written.
+    void add(const utymap::QuadKey &quadKey, const Tile &tile);
+
+    /// Adds tile with content in files. Missing bitmap and bounds files are treated as empty.
+    void add(const utymap::QuadKey &quadKey,
+             const std::string &indexPath,
+             const std::string &dataPath,
+             const std::string &bitmapPath,
+             const std::string &boundsPath = "");
+
+    /// Returns true if no tile is added.
+    bool empty() const;
+
+    /// Writes pack to given path.
+    void write(const std::string &path);
+
+   private:
+    struct Source {
+      utymap::QuadKey quadKey;
+      Tile tile;
+      std::vector<std::string> paths;
+    };
+    std::vector<Source> sources_;
+  };
+
+  /// Opens pack. Throws domain_error if file is not a valid pack.
+  explicit TilePack(const std::string &path);
+
+  TilePack(const TilePack &) = delete;
+  TilePack &operator=(const TilePack &) = delete;
+
+  ~TilePack();
+
+  /// Finds tile content of given quad key. Returns false if pack has no such tile.
+  bool find(const utymap::QuadKey &quadKey, Tile &tile) const;
+
+  /// Returns true if pack has tile of given quad key.
+  bool contains(const utymap::QuadKey &quadKey) const;
+
+  /// Returns quad keys of all tiles in directory order.
+  std::vector<utymap::QuadKey> getQuadKeys() const;
+
+ private:
+  class TilePackImpl;
+  std::unique_ptr<TilePackImpl> pimpl_;
+};
+
+}
+}
+
+#endif // INDEX_TILEPACK_HPP_DEFINED
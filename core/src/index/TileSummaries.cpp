@@ -0,0 +1,73 @@
+#include "index/TileSummaries.hpp"
+#include "utils/ElementUtils.hpp"
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+TileSummaries::TileSummaries(const std::string &path) : path_(path), isLoaded_(false) {}
+
+void TileSummaries::add(const QuadKey &quadKey, const Element &element, std::uint32_t size) {
+  std::lock_guard<std::mutex> lock(lock_);
+  load();
+  summaries_[quadKey].add(element, size);
+  append(quadKey, static_cast<std::uint32_t>(element.kind),
+         static_cast<std::uint32_t>(countVertices(element)), size);
+}
+
+void TileSummaries::reset(const QuadKey &quadKey) {
+  std::lock_guard<std::mutex> lock(lock_);
+  load();
+  if (summaries_.erase(quadKey) > 0)
+    append(quadKey, ResetKind, 0, 0);
+}
+
+TileSummary TileSummaries::get(const QuadKey &quadKey) {
+  std::lock_guard<std::mutex> lock(lock_);
+  load();
+  auto summary = summaries_.find(quadKey);
+  return summary != summaries_.end() ? summary->second : TileSummary();
+}
+
+void TileSummaries::flush() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (file_.is_open())
+    file_.flush();
+}
+
+void TileSummaries::append(const QuadKey &quadKey, std::uint32_t kind, std::uint32_t vertices, std::uint32_t size) {
+  if (!file_.is_open())
+    file_.open(path_, std::ios::out | std::ios::binary | std::ios::app);
+
+  std::int32_t values[] = { quadKey.levelOfDetail, quadKey.tileX, quadKey.tileY };
+  std::uint32_t entry[] = { kind, vertices, size };
+  file_.write(reinterpret_cast<const char *>(values), sizeof(values));
+  file_.write(reinterpret_cast<const char *>(entry), sizeof(entry));
+}
+
+void TileSummaries::load() {
+  if (isLoaded_) return;
+  isLoaded_ = true;
+
+  std::ifstream file(path_, std::ios::in | std::ios::binary);
+  std::int32_t values[3];
+  std::uint32_t entry[3];
+  while (file.read(reinterpret_cast<char *>(values), sizeof(values)) &&
+         file.read(reinterpret_cast<char *>(entry), sizeof(entry))) {
+    QuadKey quadKey(values[0], values[1], values[2]);
+    if (entry[0] == ResetKind) {
+      summaries_.erase(quadKey);
+      continue;
+    }
+    auto &summary = summaries_[quadKey];
+    switch (static_cast<ElementKind>(entry[0])) {
+      case ElementKind::Node: ++summary.nodes; break;
+      case ElementKind::Way: ++summary.ways; break;
+      case ElementKind::Area: ++summary.areas; break;
+      case ElementKind::Relation: ++summary.relations; break;
+    }
+    summary.vertices += entry[1];
+    summary.bytes += entry[2];
+  }
+}
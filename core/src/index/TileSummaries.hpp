@@ -0,0 +1,51 @@
+#ifndef INDEX_TILESUMMARIES_HPP_DEFINED
+#define INDEX_TILESUMMARIES_HPP_DEFINED
+
+#include "QuadKey.hpp"
+#include "entities/Element.hpp"
+#include "index/TileSummary.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace utymap {
+namespace index {
+
+/// Keeps summaries of quad keys. Every written element and erased quad key is appended
+/// to log file which is loaded on first use and written on flush.
+class TileSummaries final {
+ public:
+  explicit TileSummaries(const std::string &path);
+
+  /// Adds element which takes given amount of bytes in quad key.
+  void add(const utymap::QuadKey &quadKey, const utymap::entities::Element &element, std::uint32_t size);
+
+  /// Resets summary of erased quad key.
+  void reset(const utymap::QuadKey &quadKey);
+
+  TileSummary get(const utymap::QuadKey &quadKey);
+
+  void flush();
+
+ private:
+  /// Kind of record which resets summary of quad key.
+  static const std::uint32_t ResetKind = 0xFFFFFFFF;
+
+  void append(const utymap::QuadKey &quadKey, std::uint32_t kind, std::uint32_t vertices, std::uint32_t size);
+
+  void load();
+
+  const std::string path_;
+  std::mutex lock_;
+  std::ofstream file_;
+  std::unordered_map<utymap::QuadKey, TileSummary, utymap::QuadKey::Hash> summaries_;
+  bool isLoaded_;
+};
+
+}
+}
+
+#endif // INDEX_TILESUMMARIES_HPP_DEFINED
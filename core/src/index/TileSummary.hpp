@@ -0,0 +1,65 @@
+#ifndef INDEX_TILESUMMARY_HPP_DEFINED
+#define INDEX_TILESUMMARY_HPP_DEFINED
+
+#include "utils/ElementUtils.hpp"
+
+#include <cstdint>
+
+namespace utymap {
+namespace index {
+
+/// Summarizes elements stored in quad key, so cost of building tile can be estimated
+/// without reading its data.
+/// NOTE elements which are erased by id or bounding box are still counted until
+/// quad key is compacted.
+struct TileSummary final {
+  std::uint32_t nodes = 0;
+  std::uint32_t ways = 0;
+  std::uint32_t areas = 0;
+  std::uint32_t relations = 0;
+  /// Amount of coordinates of all elements including relation members.
+  std::uint64_t vertices = 0;
+  /// Size of serialized elements.
+  std::uint64_t bytes = 0;
+
+  /// Returns amount of elements.
+  std::uint64_t elements() const {
+    return static_cast<std::uint64_t>(nodes) + ways + areas + relations;
+  }
+
+  bool empty() const {
+    return elements() == 0;
+  }
+
+  /// Adds element of given serialized size.
+  void add(const utymap::entities::Element &element, std::uint64_t size) {
+    switch (element.kind) {
+      case utymap::entities::ElementKind::Node: ++nodes; break;
+      case utymap::entities::ElementKind::Way: ++ways; break;
+      case utymap::entities::ElementKind::Area: ++areas; break;
+      case utymap::entities::ElementKind::Relation: ++relations; break;
+    }
+    vertices += utymap::utils::countVertices(element);
+    bytes += size;
+  }
+
+  void add(const TileSummary &other) {
+    nodes += other.nodes;
+    ways += other.ways;
+    areas += other.areas;
+    relations += other.relations;
+    vertices += other.vertices;
+    bytes += other.bytes;
+  }
+
+  /// Returns relative cost of building tile: vertices dominate geometry processing
+  /// while every element pays for styling.
+  double getCost() const {
+    return static_cast<double>(vertices) + 16.0 * elements();
+  }
+};
+
+}
+}
+
+#endif // INDEX_TILESUMMARY_HPP_DEFINED
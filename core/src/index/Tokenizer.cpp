@@ -0,0 +1,99 @@
+#include "index/Tokenizer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+  /// Separates keys in search keys list.
+  const std::string KeySeparators = ", ";
+  /// Marks key which matches any key with given prefix.
+  const char PrefixMarker = '*';
+}
+
+const std::string &Tokenizer::DefaultDelimiters() {
+  static const std::string value = " _:;!@#$%^&*(){}[],.?`\\/\"\'";
+  return value;
+}
+
+Tokenizer::Tokenizer(const StringTable &stringTable, const std::string &delimiters) :
+    stringTable_(stringTable), keys_() {
+  std::fill(std::begin(isDelimiter_), std::end(isDelimiter_), false);
+  for (const auto c : delimiters)
+    isDelimiter_[static_cast<unsigned char>(c)] = true;
+}
+
+void Tokenizer::setSearchKeys(const std::string &keys) {
+  keys_.clear();
+  std::size_t start = 0;
+  while (start < keys.size()) {
+    auto end = keys.find_first_of(KeySeparators, start);
+    if (end == std::string::npos)
+      end = keys.size();
+    if (end > start) {
+      std::string key = keys.substr(start, end - start);
+      bool isPrefix = key.back() == PrefixMarker;
+      if (isPrefix)
+        key.pop_back();
+      keys_.push_back(KeyPattern{ key, isPrefix });
+    }
+    start = end + 1;
+  }
+}
+
+bool Tokenizer::isSearchable(std::uint32_t key) const {
+  if (keys_.empty())
+    return true;
+
+  auto view = stringTable_.getStringView(key);
+  return std::any_of(keys_.begin(), keys_.end(), [&](const KeyPattern &pattern) {
+    return (pattern.isPrefix ? view.size >= pattern.key.size() : view.size == pattern.key.size()) &&
+        std::memcmp(view.data, pattern.key.data(), pattern.key.size()) == 0;
+  });
+}
+
+template<typename Visitor>
+void Tokenizer::visit(const char *data, std::size_t size, const Visitor &visitor) const {
+  std::size_t start = 0;
+  for (std::size_t i = 0; i <= size; ++i) {
+    if (i < size && !isDelimiter_[static_cast<unsigned char>(data[i])])
+      continue;
+    if (i > start)
+      visitor(data + start, i - start);
+    start = i + 1;
+  }
+}
+
+void Tokenizer::tokenize(const Element &element, std::vector<std::uint32_t> &ids) const {
+  std::string buffer;
+  for (const auto &tag : element.tags) {
+    if (!isSearchable(tag.key))
+      continue;
+    // NOTE views stay valid while string table exists, so tag strings are not copied.
+    auto key = stringTable_.getStringView(tag.key);
+    auto value = stringTable_.getStringView(tag.value);
+    tokenize(key.data, key.size, ids, buffer);
+    tokenize(value.data, value.size, ids, buffer);
+  }
+}
+
+void Tokenizer::tokenize(const std::string &str, std::vector<std::uint32_t> &ids) const {
+  std::string buffer;
+  tokenize(str.data(), str.size(), ids, buffer);
+}
+
+void Tokenizer::split(const std::string &str, std::vector<std::string> &tokens) const {
+  visit(str.data(), str.size(), [&](const char *token, std::size_t size) {
+    tokens.push_back(std::string(token, size));
+  });
+}
+
+void Tokenizer::tokenize(const char *data, std::size_t size, std::vector<std::uint32_t> &ids, std::string &buffer) const {
+  visit(data, size, [&](const char *token, std::size_t tokenSize) {
+    // NOTE buffer keeps its capacity, so it is allocated only for long tokens.
+    buffer.assign(token, tokenSize);
+    ids.push_back(stringTable_.getId(buffer));
+  });
+}
@@ -0,0 +1,63 @@
+#ifndef INDEX_TOKENIZER_HPP_DEFINED
+#define INDEX_TOKENIZER_HPP_DEFINED
+
+#include "entities/Element.hpp"
+#include "index/StringTable.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace utymap {
+namespace index {
+
+/// Splits tag keys and values into search tokens and resolves their ids.
+/// Strings are scanned in place using delimiter table: only one token buffer
+/// is used per call instead of string per token.
+class Tokenizer final {
+ public:
+  /// Returns delimiters used by default.
+  static const std::string &DefaultDelimiters();
+
+  explicit Tokenizer(const StringTable &stringTable,
+                     const std::string &delimiters = DefaultDelimiters());
+
+  /// Sets keys of tags which are tokenized. Keys are separated by comma or space,
+  /// key which ends with "*" matches all keys with given prefix, e.g. "name,addr:*".
+  /// Empty list means that all tags are tokenized.
+  void setSearchKeys(const std::string &keys);
+
+  /// Checks whether tag with given key is tokenized.
+  bool isSearchable(std::uint32_t key) const;
+
+  /// Appends ids of tokens of searchable tags.
+  void tokenize(const utymap::entities::Element &element, std::vector<std::uint32_t> &ids) const;
+
+  /// Appends ids of tokens of given string.
+  void tokenize(const std::string &str, std::vector<std::uint32_t> &ids) const;
+
+  /// Appends tokens of given string without resolving them.
+  void split(const std::string &str, std::vector<std::string> &tokens) const;
+
+ private:
+  /// Defines key of searchable tags.
+  struct KeyPattern {
+    std::string key;
+    bool isPrefix;
+  };
+
+  /// Calls visitor with start and size of every token.
+  template<typename Visitor>
+  void visit(const char *data, std::size_t size, const Visitor &visitor) const;
+
+  void tokenize(const char *data, std::size_t size, std::vector<std::uint32_t> &ids, std::string &buffer) const;
+
+  const StringTable &stringTable_;
+  bool isDelimiter_[256];
+  std::vector<KeyPattern> keys_;
+};
+
+}
+}
+
+#endif // INDEX_TOKENIZER_HPP_DEFINED
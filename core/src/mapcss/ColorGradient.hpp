@@ -3,6 +3,7 @@
 
 #include "mapcss/Color.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <utility>
@@ -11,7 +12,12 @@ namespace utymap {
 namespace mapcss {
 
 /// Represents color gradient.
+/// NOTE gradient is immutable, so colors between first and last time are precomputed
+/// into lookup table and evaluation is a single indexed load.
 class ColorGradient final {
+  /// Amount of intervals in lookup table: power of two, so times like 0.25 are exact.
+  static const std::size_t TableIntervals = 1024;
+
  public:
 
   /// gradient data: first - time, second - color.
@@ -21,20 +27,54 @@ class ColorGradient final {
 
   explicit ColorGradient(const GradientData &colors) :
       colors_(colors) {
+    buildTable();
   }
 
   ColorGradient(ColorGradient &&other) :
-      colors_(std::move(other.colors_)) {
+      colors_(std::move(other.colors_)),
+      table_(std::move(other.table_)),
+      minTime_(other.minTime_),
+      maxTime_(other.maxTime_),
+      scale_(other.scale_) {
   }
 
   ColorGradient &operator=(ColorGradient &&other) {
-    if (this!=&other)
+    if (this!=&other) {
       colors_ = std::move(other.colors_);
+      table_ = std::move(other.table_);
+      minTime_ = other.minTime_;
+      maxTime_ = other.maxTime_;
+      scale_ = other.scale_;
+    }
 
     return *this;
   }
 
   utymap::mapcss::Color evaluate(double time) const {
+    if (table_.empty() || !(time <= maxTime_))
+      return interpolate(time);
+
+    return time <= minTime_
+           ? table_.front()
+           : table_[static_cast<std::size_t>((time - minTime_)*scale_ + 0.5)];
+  }
+
+  /// Evaluates colors for given times and writes them in RGBA form used by mesh.
+  void evaluate(const double *times, int *colors, std::size_t count) const {
+    for (std::size_t i = 0; i < count; ++i)
+      colors[i] = static_cast<int>(static_cast<std::uint32_t>(evaluate(times[i])));
+  }
+
+  /// Returns color stops of gradient.
+  const GradientData &data() const { return colors_; }
+
+  /// Returns true if there is no color specified.
+  bool empty() const { return colors_.empty(); }
+
+ private:
+
+  /// Finds color stops around given time and interpolates between them.
+  utymap::mapcss::Color interpolate(double time) const {
     if (colors_.empty())
       return utymap::mapcss::Color();
 
@@ -52,10 +92,18 @@ class ColorGradient final {
     return interpolate(pairA.second, pairB.second, mu);
   }
 
-  /// Returns true if there is no color specified.
-  bool empty() const { return colors_.empty(); }
-
- private:
+  /// Precomputes colors between first and last time.
+  void buildTable() {
+    if (colors_.size() < 2 || !(colors_.back().first > colors_.front().first))
+      return;
+
+    minTime_ = colors_.front().first;
+    maxTime_ = colors_.back().first;
+    scale_ = TableIntervals/(maxTime_ - minTime_);
+    table_.reserve(TableIntervals + 1);
+    for (std::size_t i = 0; i <= TableIntervals; ++i)
+      table_.push_back(interpolate(minTime_ + i/scale_));
+  }
 
   /// So far, use linear interpolation algorithm as the fastest.
   static utymap::mapcss::Color interpolate(const utymap::mapcss::Color &a,
@@ -65,6 +113,10 @@ class ColorGradient final {
   }
 
   GradientData colors_;
+  std::vector<utymap::mapcss::Color> table_;
+  double minTime_ = 0;
+  double maxTime_ = 0;
+  double scale_ = 0;
 };
 
 }
@@ -179,6 +179,7 @@ struct ImportGrammar : qi::grammar<Iterator, CommentSkipper<Iterator>> {
 
  private:
   void readImport(const std::string &url) const {
+    stylesheet.sources.push_back(directory + url);
     std::ifstream importFile(directory + url);
     std::string content((std::istreambuf_iterator<char>(importFile)), std::istreambuf_iterator<char>());
     // NOTE indirected recursion: caller must ensure that there is no recursive import.
@@ -230,6 +231,7 @@ struct ExtraImportGrammar : qi::grammar<Iterator, CommentSkipper<Iterator> > {
 
   /// Gets content of the file.
   std::string getContent(const std::string &fileName) const {
+    stylesheet.sources.push_back(directory + fileName);
     std::ifstream file(directory + fileName);
     if (!file.good())
       throw utymap::MapCssException(std::string("Cannot find:") + directory + fileName);
@@ -5,46 +5,86 @@
 #include "entities/Element.hpp"
 #include "mapcss/StyleConsts.hpp"
 #include "mapcss/StyleDeclaration.hpp"
+#include "mapcss/StyleStatistics.hpp"
 #include "index/StringTable.hpp"
 #include "utils/CoreUtils.hpp"
 #include "utils/GeoUtils.hpp"
+#include "utils/InlineVector.hpp"
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
-#include <set>
-#include <unordered_map>
+#include <vector>
 
 namespace utymap {
 namespace mapcss {
 
 /// Represents style for element.
+/// NOTE style refers to tags of element instead of copying them, so it should not outlive the
+/// element unless it is copied: copy owns its tags and can be stored independently.
 struct Style final {
+  /// Sorted by key declarations.
+  typedef utymap::utils::InlineVector<const StyleDeclaration *, 32> Declarations;
+  /// Sorted string ids of builder names.
+  typedef utymap::utils::InlineVector<std::uint32_t, 4> Builders;
+  /// Fingerprints of rules which declarations were merged into style.
+  typedef utymap::utils::InlineVector<std::uint64_t, 8> Rules;
+
   Style(const std::vector<utymap::entities::Tag> &tags,
-        const utymap::index::StringTable &stringTable) :
-      stringTable_(stringTable), builderKeyId_(stringTable.getId(StyleConsts::BuilderKey())),
-      tags_(tags), declarations_(), builders_() {
+        const utymap::index::StringTable &stringTable,
+        const StyleConstIds &constIds) :
+      stringTable_(stringTable), builderKeyId_(constIds.builderKey),
+      tags_(&tags), ownedTags_(), declarations_(), builders_(), rules_(), statistics_(nullptr) {
+  }
+
+  /// Creates style with declarations of other one which refers to given tags.
+  Style(const Style &other, const std::vector<utymap::entities::Tag> &tags) :
+      stringTable_(other.stringTable_),
+      builderKeyId_(other.builderKeyId_),
+      tags_(&tags),
+      ownedTags_(),
+      declarations_(other.declarations_),
+      builders_(other.builders_),
+      rules_(other.rules_),
+      statistics_(nullptr) {
   }
 
   Style(Style &&other) :
       stringTable_(other.stringTable_),
       builderKeyId_(other.builderKeyId_),
-      tags_(std::move(other.tags_)),
-      declarations_(std::move(other.declarations_)),
-      builders_(std::move(other.builders_)) {
+      tags_(other.tags_),
+      ownedTags_(std::move(other.ownedTags_)),
+      declarations_(other.declarations_),
+      builders_(other.builders_),
+      rules_(other.rules_),
+      statistics_(other.statistics_) {
   }
 
-  Style(const Style &) = default;
+  Style(const Style &other) :
+      stringTable_(other.stringTable_),
+      builderKeyId_(other.builderKeyId_),
+      tags_(),
+      ownedTags_(other.ownedTags_!=nullptr
+                 ? other.ownedTags_
+                 : std::make_shared<const std::vector<utymap::entities::Tag>>(*other.tags_)),
+      declarations_(other.declarations_),
+      builders_(other.builders_),
+      rules_(other.rules_),
+      statistics_(other.statistics_) {
+    tags_ = ownedTags_.get();
+  }
 
   Style &operator=(const Style &) = delete;
   Style &operator=(Style &&) = delete;
 
   bool has(std::uint32_t key) const {
-    return declarations_.find(key)!=declarations_.end();
+    return find(key)!=declarations_.end();
   }
 
   bool has(std::uint32_t key, const std::string &value) const {
-    auto it = declarations_.find(key);
-    return it!=declarations_.end() && it->second->value()==value;
+    auto it = find(key);
+    return it!=declarations_.end() && (*it)->value()==value;
   }
 
   bool empty() const {
@@ -53,39 +93,61 @@ struct Style final {
 
   void put(const StyleDeclaration &declaration) {
     if (declaration.key()==builderKeyId_) {
-      builders_.insert(declaration.value());
+      std::uint32_t builderId = stringTable_.getId(declaration.value());
+      auto it = std::lower_bound(builders_.begin(), builders_.end(), builderId);
+      if (it==builders_.end() || *it!=builderId)
+        builders_.insert(it, builderId);
     }
     // TODO remove this branch if condition above is true, after style migration
-    declarations_[declaration.key()] = &declaration;
+    auto it = find(declaration.key());
+    if (it!=declarations_.end())
+      declarations_[static_cast<std::size_t>(it - declarations_.begin())] = &declaration;
+    else
+      declarations_.insert(lowerBound(declaration.key()), &declaration);
+  }
+
+  /// Records rule which declarations are merged into style.
+  void addRule(std::uint64_t fingerprint) {
+    rules_.push_back(fingerprint);
+  }
+
+  /// Gets fingerprints of rules which declarations are merged into style.
+  const Rules &getRules() const {
+    return rules_;
+  }
+
+  /// Sets counters which collect time of expression evaluation. Null disables collecting.
+  void setStatistics(StyleStatistics::Level *statistics) {
+    statistics_ = statistics;
   }
 
   const StyleDeclaration &get(std::uint32_t key) const {
-    auto it = declarations_.find(key);
+    auto it = find(key);
     if (it == declarations_.end()) {
       auto tag = stringTable_.getString(key);
       throw MapCssException("Cannot find declaration with the key: " + *tag);
     }
 
-    return *it->second;
+    return **it;
   }
 
-  std::vector<const StyleDeclaration *> declarations() const {
-    std::vector<const StyleDeclaration *> decs;
-    std::transform(std::begin(declarations_), std::end(declarations_), std::back_inserter(decs),
-                   [](std::unordered_map<std::uint32_t, const StyleDeclaration *>::value_type const &pair) {
-                     return pair.second;
-                   });
+  /// Gets declarations sorted by key.
+  const Declarations &declarations() const {
+    return declarations_;
+  }
 
-    return decs;
+  /// Gets sorted string ids of builders extracted from declarations.
+  const Builders &getBuilderIds() const {
+    return builders_;
   }
 
   /// Gets list of builders extracted from declarations.
   std::vector<std::string> getBuilders() const {
     std::vector<std::string> builders;
-    std::transform(builders_.cbegin(), builders_.cend(), std::back_inserter(builders),
-      [](std::string const &item) {
-      return item;
-    });
+    builders.reserve(builders_.size());
+    for (auto builderId : builders_)
+      builders.push_back(*stringTable_.getString(builderId));
+    std::sort(builders.begin(), builders.end());
 
     return builders;
   }
@@ -104,7 +166,7 @@ struct Style final {
     auto &declaration = get(keyId);
 
     return declaration.isEval()
-           ? declaration.evaluate<std::string>(tags_, stringTable_)
+           ? evaluate<std::string>(declaration)
            : declaration.value();
   }
 
@@ -136,31 +198,51 @@ struct Style final {
       return 0;
 
     const auto &declaration = get(keyId);
-    const auto &rawValue = declaration.value();
-    char dimen = rawValue[rawValue.size() - 1];
-
-    if (dimen=='m') {
-      double value = utymap::utils::parseDouble(rawValue.substr(0, rawValue.size() - 1));
-      return bbox.isValid()
-             ? utymap::utils::GeoUtils::getOffset(bbox.center(), value)
-             : value;
+    switch (declaration.unit()) {
+      case StyleDeclaration::Unit::Meter:
+        return bbox.isValid()
+               ? utymap::utils::GeoUtils::getOffset(bbox.center(), declaration.number())
+               : declaration.number();
+      case StyleDeclaration::Unit::Percent:
+        return relativeSize*declaration.number()*0.01;
+      default:
+        return declaration.isEval()
+               ? evaluate<double>(declaration)
+               : declaration.number();
     }
+  }
 
-    if (dimen=='%') {
-      double value = utymap::utils::parseDouble(rawValue.substr(0, rawValue.size() - 1));
-      return relativeSize*value*0.01;
-    }
+  template<typename T>
+  T evaluate(const StyleDeclaration &declaration) const {
+    if (statistics_==nullptr)
+      return declaration.evaluate<T>(*tags_, stringTable_);
 
-    return declaration.isEval()
-           ? declaration.evaluate<double>(tags_, stringTable_)
-           : utymap::utils::parseDouble(rawValue);
+    auto start = StyleStatistics::Clock::now();
+    T value = declaration.evaluate<T>(*tags_, stringTable_);
+    statistics_->addEvaluationTime(StyleStatistics::Clock::now() - start);
+    return value;
+  }
+
+  Declarations::const_iterator lowerBound(std::uint32_t key) const {
+    return std::lower_bound(declarations_.begin(), declarations_.end(), key,
+                            [](const StyleDeclaration *declaration, std::uint32_t k) {
+                              return declaration->key() < k;
+                            });
+  }
+
+  Declarations::const_iterator find(std::uint32_t key) const {
+    auto it = lowerBound(key);
+    return it!=declarations_.end() && (*it)->key()==key ? it : declarations_.end();
   }
 
   const utymap::index::StringTable &stringTable_;
   const std::uint64_t builderKeyId_;
-  std::vector<utymap::entities::Tag> tags_;
-  std::unordered_map<std::uint32_t, const StyleDeclaration *> declarations_;
-  std::set<std::string> builders_;
+  const std::vector<utymap::entities::Tag> *tags_;
+  std::shared_ptr<const std::vector<utymap::entities::Tag>> ownedTags_;
+  Declarations declarations_;
+  Builders builders_;
+  Rules rules_;
+  StyleStatistics::Level *statistics_;
 };
 
 }
@@ -1,5 +1,8 @@
+#include "index/StringTable.hpp"
 #include "mapcss/StyleConsts.hpp"
 
+#include <vector>
+
 using namespace utymap::mapcss;
 
 const std::string &StyleConsts::ClipKey() {
@@ -12,6 +15,11 @@ const std::string &StyleConsts::SkipKey() {
   return value;
 }
 
+const std::string &StyleConsts::SimplifyKey() {
+  static const std::string value = "simplify";
+  return value;
+}
+
 const std::string &StyleConsts::BuilderKey() {
   static const std::string value = "builder";
   return value;
@@ -77,6 +85,11 @@ const std::string &StyleConsts::GridCellSize() {
   return value;
 }
 
+const std::string &StyleConsts::GridMeshKey() {
+  static const std::string value = "grid-mesh";
+  return value;
+}
+
 const std::string &StyleConsts::TerrainLayerKey() {
   static const std::string value = "terrain-layer";
   return value;
@@ -151,3 +164,93 @@ const std::string &StyleConsts::StepKey() {
   static const std::string value = "step";
   return value;
 }
+
+const std::string &StyleConsts::SearchKeysKey() {
+  static const std::string value = "search-keys";
+  return value;
+}
+
+const std::string &StyleConsts::SimplificationErrorKey() {
+  static const std::string value = "simplification-error";
+  return value;
+}
+
+const std::string &StyleConsts::MeshVertexBudgetKey() {
+  static const std::string value = "mesh-vertex-budget";
+  return value;
+}
+
+StyleConstIds::StyleConstIds(const utymap::index::StringTable &stringTable) {
+  std::vector<std::uint32_t> ids;
+  stringTable.getIds({
+      &StyleConsts::ClipKey(),
+      &StyleConsts::SkipKey(),
+      &StyleConsts::BuilderKey(),
+      &StyleConsts::EleNoiseFreqKey(),
+      &StyleConsts::ColorNoiseFreqKey(),
+      &StyleConsts::GradientKey(),
+      &StyleConsts::LSystemKey(),
+      &StyleConsts::TextureIndexKey(),
+      &StyleConsts::TextureTypeKey(),
+      &StyleConsts::TextureScaleKey(),
+      &StyleConsts::MaxAreaKey(),
+      &StyleConsts::HeightOffsetKey(),
+      &StyleConsts::MeshNameKey(),
+      &StyleConsts::MeshExtrasKey(),
+      &StyleConsts::GridCellSize(),
+      &StyleConsts::TerrainLayerKey(),
+      &StyleConsts::HeightKey(),
+      &StyleConsts::WidthKey(),
+      &StyleConsts::LengthKey(),
+      &StyleConsts::GapKey(),
+      &StyleConsts::RadiusKey(),
+      &StyleConsts::SizeKey(),
+      &StyleConsts::MinHeightKey(),
+      &StyleConsts::FrequencyKey(),
+      &StyleConsts::LevelKey(),
+      &StyleConsts::SortOrderKey(),
+      &StyleConsts::DimensionKey(),
+      &StyleConsts::DirectionKey(),
+      &StyleConsts::TypeKey(),
+      &StyleConsts::StepKey(),
+      &StyleConsts::SearchKeysKey(),
+      &StyleConsts::GridMeshKey(),
+      &StyleConsts::SimplificationErrorKey(),
+      &StyleConsts::MeshVertexBudgetKey()
+  }, ids);
+
+  clipKey = ids[0];
+  skipKey = ids[1];
+  builderKey = ids[2];
+  eleNoiseFreqKey = ids[3];
+  colorNoiseFreqKey = ids[4];
+  gradientKey = ids[5];
+  lSystemKey = ids[6];
+  textureIndexKey = ids[7];
+  textureTypeKey = ids[8];
+  textureScaleKey = ids[9];
+  maxAreaKey = ids[10];
+  heightOffsetKey = ids[11];
+  meshNameKey = ids[12];
+  meshExtrasKey = ids[13];
+  gridCellSize = ids[14];
+  terrainLayerKey = ids[15];
+  heightKey = ids[16];
+  widthKey = ids[17];
+  lengthKey = ids[18];
+  gapKey = ids[19];
+  radiusKey = ids[20];
+  sizeKey = ids[21];
+  minHeightKey = ids[22];
+  frequencyKey = ids[23];
+  levelKey = ids[24];
+  sortOrderKey = ids[25];
+  dimensionKey = ids[26];
+  directionKey = ids[27];
+  typeKey = ids[28];
+  stepKey = ids[29];
+  searchKeysKey = ids[30];
+  gridMeshKey = ids[31];
+  simplificationErrorKey = ids[32];
+  meshVertexBudgetKey = ids[33];
+}
@@ -1,9 +1,13 @@
 #ifndef MAPCSS_STYLECONSTS_HPP_INCLUDED
 #define MAPCSS_STYLECONSTS_HPP_INCLUDED
 
+#include <cstdint>
 #include <string>
 
 namespace utymap {
+namespace index {
+class StringTable;
+}
 namespace mapcss {
 
 /// Specifies mapcss consts used by built-in builders.
@@ -11,6 +15,8 @@ struct StyleConsts final {
 
   static const std::string &ClipKey();
   static const std::string &SkipKey();
+  /// Tolerance of geometry simplification in pixels of 256 pixel tile.
+  static const std::string &SimplifyKey();
 
   static const std::string &BuilderKey();
 
@@ -29,6 +35,7 @@ struct StyleConsts final {
   static const std::string &MeshNameKey();
   static const std::string &MeshExtrasKey();
   static const std::string &GridCellSize();
+  static const std::string &GridMeshKey();
 
   static const std::string &TerrainLayerKey();
 
@@ -47,6 +54,51 @@ struct StyleConsts final {
   static const std::string &DirectionKey();
   static const std::string &TypeKey();
   static const std::string &StepKey();
+
+  static const std::string &SearchKeysKey();
+
+  static const std::string &SimplificationErrorKey();
+  static const std::string &MeshVertexBudgetKey();
+};
+
+/// Contains ids of all StyleConsts keys resolved once for given string table.
+struct StyleConstIds final {
+  explicit StyleConstIds(const utymap::index::StringTable &stringTable);
+
+  std::uint32_t clipKey;
+  std::uint32_t skipKey;
+  std::uint32_t builderKey;
+  std::uint32_t eleNoiseFreqKey;
+  std::uint32_t colorNoiseFreqKey;
+  std::uint32_t gradientKey;
+  std::uint32_t lSystemKey;
+  std::uint32_t textureIndexKey;
+  std::uint32_t textureTypeKey;
+  std::uint32_t textureScaleKey;
+  std::uint32_t maxAreaKey;
+  std::uint32_t heightOffsetKey;
+  std::uint32_t meshNameKey;
+  std::uint32_t meshExtrasKey;
+  std::uint32_t gridCellSize;
+  std::uint32_t terrainLayerKey;
+  std::uint32_t heightKey;
+  std::uint32_t widthKey;
+  std::uint32_t lengthKey;
+  std::uint32_t gapKey;
+  std::uint32_t radiusKey;
+  std::uint32_t sizeKey;
+  std::uint32_t minHeightKey;
+  std::uint32_t frequencyKey;
+  std::uint32_t levelKey;
+  std::uint32_t sortOrderKey;
+  std::uint32_t dimensionKey;
+  std::uint32_t directionKey;
+  std::uint32_t typeKey;
+  std::uint32_t stepKey;
+  std::uint32_t searchKeysKey;
+  std::uint32_t gridMeshKey;
+  std::uint32_t simplificationErrorKey;
+  std::uint32_t meshVertexBudgetKey;
 };
 
 }
@@ -5,6 +5,7 @@
 #include "entities/Element.hpp"
 #include "index/StringTable.hpp"
 #include "mapcss/StyleEvaluator.hpp"
+#include "utils/CoreUtils.hpp"
 #include "utils/ElementUtils.hpp"
 
 #include <cstdint>
@@ -17,15 +18,44 @@ namespace mapcss {
 
 /// Represents style declaration which support evaluation.
 struct StyleDeclaration final {
+  /// Specifies dimension of numeric value.
+  enum class Unit { None, Meter, Percent };
+
   StyleDeclaration(std::uint32_t key, const std::string &value) :
       key_(key),
       value_(value),
-      tree_(StyleEvaluator::parse(value)) {
+      program_(compile(value, nullptr)),
+      unit_(Unit::None),
+      number_(0) {
+    parseNumber();
+  }
+
+  /// Creates declaration which expression has tag keys resolved using given string table.
+  /// NOTE the same string table should be used for evaluation.
+  StyleDeclaration(std::uint32_t key, const std::string &value, const utymap::index::StringTable &stringTable) :
+      key_(key),
+      value_(value),
+      program_(compile(value, &stringTable)),
+      unit_(Unit::None),
+      number_(0) {
+    parseNumber();
+  }
+
+  /// Creates declaration from precompiled expression which tag keys are resolved using given string table.
+  StyleDeclaration(std::uint32_t key, const std::string &value, const StyleEvaluator::Program &program,
+                   const utymap::index::StringTable &stringTable) :
+      key_(key),
+      value_(value),
+      program_(StyleEvaluator::resolve(program, stringTable)),
+      unit_(Unit::None),
+      number_(0) {
+    parseNumber();
   }
 
   ~StyleDeclaration() {};
   StyleDeclaration(StyleDeclaration &&other) :
-      key_(other.key_), value_(other.value_), tree_(std::move(other.tree_)) {
+      key_(other.key_), value_(other.value_), program_(std::move(other.program_)),
+      unit_(other.unit_), number_(other.number_) {
   }
 
   StyleDeclaration(const StyleDeclaration &) = delete;
@@ -38,8 +68,15 @@ struct StyleDeclaration final {
   /// Gets declaration value.
   const std::string &value() const { return value_; };
 
+  /// Gets dimension of value parsed at construction.
+  Unit unit() const { return unit_; }
+
+  /// Gets numeric value parsed at construction without dimension suffix.
+  /// NOTE zero is returned for non numeric or evaluated values.
+  double number() const { return number_; }
+
   /// Gets true if declaration should be evaluated
-  bool isEval() const { return tree_!=nullptr; }
+  bool isEval() const { return program_!=nullptr; }
 
   /// Evaluates expression using tags
   template<typename T>
@@ -48,14 +85,35 @@ struct StyleDeclaration final {
     if (!isEval())
       throw utymap::MapCssException("Cannot evaluate raw value.");
 
-    return StyleEvaluator::evaluate<T>(*tree_, tags, stringTable);
+    return StyleEvaluator::evaluate<T>(*program_, tags, stringTable);
   }
 
  private:
+  static std::unique_ptr<StyleEvaluator::Program> compile(const std::string &value,
+                                                          const utymap::index::StringTable *stringTable) {
+    auto tree = StyleEvaluator::parse(value);
+    return tree!=nullptr ? StyleEvaluator::compile(*tree, stringTable) : nullptr;
+  }
+
+  /// Parses constant value once, so numeric lookups do not convert string each time.
+  void parseNumber() {
+    if (value_.empty())
+      return;
+
+    char dimen = value_[value_.size() - 1];
+    if (dimen=='m' || dimen=='%') {
+      unit_ = dimen=='m' ? Unit::Meter : Unit::Percent;
+      number_ = utymap::utils::parseDouble(value_.data(), value_.size() - 1);
+    } else if (!isEval()) {
+      number_ = utymap::utils::parseDouble(value_);
+    }
+  }
 
   std::uint32_t key_;
   std::string value_;
-  std::unique_ptr<StyleEvaluator::Tree> tree_;
+  std::unique_ptr<StyleEvaluator::Program> program_;
+  Unit unit_;
+  double number_;
 };
 
 }
@@ -88,3 +88,83 @@ std::unique_ptr<Tree> StyleEvaluator::parse(const std::string &expression) {
 
   return tree;
 }
+
+namespace {
+typedef StyleEvaluator::Program Program;
+
+/// Converts AST operand into program instruction.
+struct InstructionBuilder : public boost::static_visitor<Program::Instruction> {
+  explicit InstructionBuilder(const StringTable *stringTable) : stringTable_(stringTable) {}
+
+  Program::Instruction operator()(const Nil &) const {
+    return constant(0, "");
+  }
+
+  Program::Instruction operator()(const double &value) const {
+    return constant(value, utymap::utils::toString(value));
+  }
+
+  Program::Instruction operator()(const std::string &value) const {
+    return constant(utymap::utils::parseDouble(value), value);
+  }
+
+  Program::Instruction operator()(const TagKey &tag) const {
+    bool isResolved = stringTable_!=nullptr;
+    return Program::Instruction{0, Program::Kind::Tag, false, isResolved, 1, 0, tag.key,
+                                isResolved ? stringTable_->getId(tag.key) : 0};
+  }
+
+  Program::Instruction operator()(const Signed &s) const {
+    auto instruction = boost::apply_visitor(*this, s.operand);
+    double sign = s.sign=='-' ? -1 : (s.sign=='+' ? 1 : 0);
+    instruction.isSigned = true;
+    instruction.sign *= sign;
+    instruction.number *= sign;
+    return instruction;
+  }
+
+ private:
+  static Program::Instruction constant(double number, const std::string &text) {
+    return Program::Instruction{0, Program::Kind::Constant, false, false, 1, number, text, 0};
+  }
+
+  const StringTable *stringTable_;
+};
+}
+
+std::unique_ptr<Program> StyleEvaluator::compile(const Tree &tree, const StringTable *stringTable) {
+  auto program = utymap::utils::make_unique<Program>();
+  InstructionBuilder builder(stringTable);
+
+  program->instructions.push_back(boost::apply_visitor(builder, tree.first));
+  for (const Operation &operation : tree.rest) {
+    program->instructions.push_back(boost::apply_visitor(builder, operation.operand));
+    program->instructions.back().operator_ = operation.operator_;
+  }
+
+  // NOTE operations are applied from left to right, so only constant prefix is folded.
+  for (const auto &instruction : program->instructions) {
+    auto &numeric = program->numeric;
+    if (numeric.size()==1 && numeric.front().kind==Program::Kind::Constant &&
+        instruction.kind==Program::Kind::Constant) {
+      apply(instruction.operator_, numeric.front().number, instruction.number);
+      continue;
+    }
+    numeric.push_back(instruction);
+  }
+
+  return program;
+}
+
+std::unique_ptr<Program> StyleEvaluator::resolve(const Program &program, const StringTable &stringTable) {
+  auto resolved = utymap::utils::make_unique<Program>(program);
+  for (auto *instructions : { &resolved->instructions, &resolved->numeric }) {
+    for (auto &instruction : *instructions) {
+      if (instruction.kind!=Program::Kind::Tag)
+        continue;
+      instruction.isResolved = true;
+      instruction.keyId = stringTable.getId(instruction.text);
+    }
+  }
+  return resolved;
+}
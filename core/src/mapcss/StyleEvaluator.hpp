@@ -10,6 +10,8 @@
 #include <boost/variant/apply_visitor.hpp>
 
 #include <cstdint>
+#include <limits>
+#include <stdexcept>
 #include <string>
 #include <list>
 #include <memory>
@@ -45,132 +47,122 @@ struct StyleEvaluator final {
     std::list<Operation> rest;
   };
 
+  /// Expression compiled into flat instruction list: operands are applied from left to right
+  /// to accumulator, so evaluation neither walks AST nor resolves tag keys each time.
+  struct Program {
+    enum class Kind : std::uint8_t { Constant, Tag };
+
+    struct Instruction {
+      /// Operator applied to accumulator and operand, zero for the first operand.
+      char operator_;
+      Kind kind;
+      /// True if operand has sign which is not supported by string evaluation.
+      bool isSigned;
+      /// True if key id of tag is resolved during compilation.
+      bool isResolved;
+      /// Sign multiplier of tag value.
+      double sign;
+      /// Constant value used by double evaluation.
+      double number;
+      /// Constant value used by string evaluation or tag key.
+      std::string text;
+      std::uint32_t keyId;
+    };
+
+    /// Instructions used by string evaluation.
+    std::vector<Instruction> instructions;
+    /// Instructions used by double evaluation with folded constant prefix.
+    std::vector<Instruction> numeric;
+  };
+
   StyleEvaluator() = delete;
 
   /// Parses expression into AST.
   static std::unique_ptr<Tree> parse(const std::string &expression);
 
+  /// Compiles AST into program. Tag keys are resolved if string table is passed.
+  static std::unique_ptr<Program> compile(const Tree &tree, const utymap::index::StringTable *stringTable = nullptr);
+
+  /// Copies program with tag keys resolved using given string table.
+  static std::unique_ptr<Program> resolve(const Program &program, const utymap::index::StringTable &stringTable);
+
   /// Evaluates expression using tags.
   template<typename T>
-  static T evaluate(const Tree &tree,
+  static T evaluate(const Program &program,
                     const std::vector<utymap::entities::Tag> &tags,
                     const utymap::index::StringTable &stringTable) {
-    typedef typename std::conditional<std::is_same<T, std::string>::value, StringEvaluator, DoubleEvaluator>::type
-        EvaluatorType;
-    return EvaluatorType(tags, stringTable).visit(tree);
+    return evaluate(program, tags, stringTable, static_cast<T *>(nullptr));
   }
 
  private:
 
-  /// Specifies default AST evaluator behaviour.
-  template<typename T>
-  struct Evaluator {
-    typedef T result_type;
-
-    Evaluator(const std::vector<utymap::entities::Tag> &tags,
-              const utymap::index::StringTable &stringTable) :
-        tags_(tags), stringTable_(stringTable) {}
-
-  protected:
-    const std::vector<utymap::entities::Tag> &tags_;
-    const utymap::index::StringTable &stringTable_;
-  };
-
-  /// Evaluates double from AST.
-  struct DoubleEvaluator : public Evaluator<double> {
-    DoubleEvaluator(const std::vector<utymap::entities::Tag> &tags,
-                    const utymap::index::StringTable &stringTable) :
-        Evaluator(tags, stringTable) {}
-
-    double operator()(const Nil&) const {
-      return 0;
-    }
- 
-    double operator()(const double &value) const {
-      return value;
-    }
-
-    double operator()(const std::string &value) const {
-      return utymap::utils::parseDouble(value);
-    }
-
-    double operator()(const Tag &tag) const {
-      auto keyId = stringTable_.getId(tag.key);
-      auto value = utymap::utils::getTagValue(keyId, tags_, stringTable_);
-      return utymap::utils::parseDouble(*value);
-    }
-
-    double operator()(const Signed &s) const {
-      double rhs = boost::apply_visitor(*this, s.operand);
-      switch (s.sign) {
-        case '-': return -rhs;
-        case '+': return +rhs;
-        default: return 0;
-      }
-    }
-
-    double visit(const Tree &tree) const {
-      double state = boost::apply_visitor(*this, tree.first);
-      for (const Operation &op : tree.rest)
-        apply(op, state);
-      return state;
-    }
-
-  private:
-    void apply(const Operation &o, double& state) const {
-      double rhs = boost::apply_visitor(*this, o.operand);
-      switch (o.operator_) {
-        case '+': state += rhs; break;
-        case '-': state -= rhs; break;
-        case '*': state *= rhs; break;
-        case '/': state /= rhs; break;
-        default: return;
-      }
-    }
-  };
-
-  /// Evaluates string from AST.
-  struct StringEvaluator : public Evaluator<std::string> {
-    StringEvaluator(const std::vector<utymap::entities::Tag> &tags,
-                    const utymap::index::StringTable &stringTable)
-        : Evaluator(tags, stringTable) {}
+  static double evaluate(const Program &program,
+                         const std::vector<utymap::entities::Tag> &tags,
+                         const utymap::index::StringTable &stringTable,
+                         double *) {
+    const auto &instructions = program.numeric;
+    double state = getNumber(instructions.front(), tags, stringTable);
+    for (std::size_t i = 1; i < instructions.size(); ++i)
+      apply(instructions[i].operator_, state, getNumber(instructions[i], tags, stringTable));
+    return state;
+  }
 
-    std::string operator()(const Nil&) const {
-      return "";
-    }
-   
-    std::string operator()(const double& value) const {
-      return utymap::utils::toString(value);
+  static std::string evaluate(const Program &program,
+                              const std::vector<utymap::entities::Tag> &tags,
+                              const utymap::index::StringTable &stringTable,
+                              std::string *) {
+    const auto &instructions = program.instructions;
+    std::string state = getString(instructions.front(), tags, stringTable);
+    for (std::size_t i = 1; i < instructions.size(); ++i) {
+      std::string rhs = getString(instructions[i], tags, stringTable);
+      if (instructions[i].operator_ != '+')
+        throw std::domain_error(std::string("StringEvaluator: unsupported merge operation: ") + instructions[i].operator_);
+      state += rhs;
     }
+    return state;
+  }
 
-    std::string operator()(const std::string &value) const {
-      return value;
+  /// Applies arithmetic operator to state. Unknown operator is ignored.
+  static void apply(char operator_, double &state, double rhs) {
+    switch (operator_) {
+      case '+': state += rhs; break;
+      case '-': state -= rhs; break;
+      case '*': state *= rhs; break;
+      case '/': state /= rhs; break;
+      default: return;
     }
+  }
 
-    std::string operator()(const Tag &tag) const {
-      return *utymap::utils::getTagValue(stringTable_.getId(tag.key), tags_, stringTable_);
-    }
+  static double getNumber(const Program::Instruction &instruction,
+                          const std::vector<utymap::entities::Tag> &tags,
+                          const utymap::index::StringTable &stringTable) {
+    if (instruction.kind==Program::Kind::Constant)
+      return instruction.number;
+    auto value = stringTable.getStringView(getTagValueId(instruction, tags, stringTable));
+    return instruction.sign*utymap::utils::parseDouble(value.data, value.size);
+  }
 
-    std::string operator()(const Signed &s) const {
+  static std::string getString(const Program::Instruction &instruction,
+                               const std::vector<utymap::entities::Tag> &tags,
+                               const utymap::index::StringTable &stringTable) {
+    if (instruction.isSigned)
       throw std::domain_error("StringEvaluator: sign operation is not supported.");
-    }
-
-    std::string visit(const Tree &tree) const {
-      auto state = boost::apply_visitor(*this, tree.first);
-      for (const Operation &op : tree.rest)
-        apply(op, state);
-      return state;
-    }
-
-  private:
-    void apply(const Operation &o, std::string &state) const {
-      std::string rhs = boost::apply_visitor(*this, o.operand);
-      if (o.operator_ != '+')
-        throw std::domain_error(std::string("StringEvaluator: unsupported merge operation: ") + o.operator_);
+    if (instruction.kind==Program::Kind::Constant)
+      return instruction.text;
+    return *stringTable.getString(getTagValueId(instruction, tags, stringTable));
+  }
 
-      state += rhs;
-    }
-  };
+  /// Returns id of tag value or throws exception if there is no such tag.
+  static std::uint32_t getTagValueId(const Program::Instruction &instruction,
+                                     const std::vector<utymap::entities::Tag> &tags,
+                                     const utymap::index::StringTable &stringTable) {
+    auto keyId = instruction.isResolved ? instruction.keyId : stringTable.getId(instruction.text);
+    auto valueId = utymap::utils::getTagValue(keyId, tags, std::numeric_limits<std::uint32_t>::max(),
+                                              [](std::uint32_t value) { return value; });
+    if (valueId==std::numeric_limits<std::uint32_t>::max())
+      throw std::domain_error("Cannot find tag:" + instruction.text);
+    return valueId;
+  }
 
   std::string value_;
   std::unique_ptr<Tree> tree_;
@@ -1,4 +1,6 @@
-#include "hashing/MD5.h"
+#include "QuadKey.hpp"
+#include "hashing/MurmurHash3.h"
+#include "entities/ElementDispatch.hpp"
 #include "entities/ElementVisitor.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
@@ -7,8 +9,18 @@
 #include "mapcss/Style.hpp"
 #include "mapcss/StyleProvider.hpp"
 #include "utils/GradientUtils.hpp"
-
+#include "utils/Metrics.hpp"
+#include "utils/Tracer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 #include <mutex>
+#include <map>
+#include <unordered_map>
+#include <sstream>
 
 using namespace utymap::entities;
 using namespace utymap::index;
@@ -17,6 +29,8 @@ using namespace utymap::mapcss;
 namespace {
 
 const std::uint16_t DefaultTextureIndex = std::numeric_limits<std::uint16_t>::max();
+/// Tags of styles which are not bound to any element.
+const std::vector<Tag> NoTags;
 
 /// Contains operation types supported by mapcss parser.
 enum class OpType { Exists, Equals, NotEquals, Less, Greater };
@@ -25,104 +39,327 @@ struct ConditionType final {
   uint32_t key;
   uint32_t value;
   OpType type;
+  /// Value parsed as number which is used by numeric comparisons.
+  double number;
+};
+
+/// Caches string values parsed as numbers using string id as index.
+/// Values are kept in lazily allocated pages, so lookup doesn't take lock.
+class NumberCache final {
+  static const std::uint32_t PageBits = 16;
+  static const std::uint32_t PageSize = 1 << PageBits;
+  static const std::uint32_t PageCount = 1 << (32 - PageBits);
+  /// Marks value which is not parsed yet: signaling NaN is never produced by parsing.
+  static const std::uint64_t Unknown = 0x7FF4000000000000ull;
+
+  using Entry = std::atomic<std::uint64_t>;
+
+ public:
+  NumberCache() : pages_(new std::atomic<Entry *>[PageCount]) {
+    for (std::uint32_t i = 0; i < PageCount; ++i)
+      pages_[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  NumberCache(const NumberCache &) = delete;
+  NumberCache &operator=(const NumberCache &) = delete;
+
+  ~NumberCache() {
+    for (std::uint32_t i = 0; i < PageCount; ++i)
+      delete[] pages_[i].load(std::memory_order_relaxed);
+  }
+
+  /// Gets number of string with given id. Parser is called only on first access.
+  template<typename Parser>
+  double get(std::uint32_t id, const Parser &parse) {
+    auto &entry = getPage(id >> PageBits)[id & (PageSize - 1)];
+    std::uint64_t bits = entry.load(std::memory_order_relaxed);
+    if (bits != Unknown)
+      return toDouble(bits);
+
+    double value = parse();
+    // NOTE parsed NaN is stored as quiet NaN which differs from marker.
+    if (value != value)
+      value = std::numeric_limits<double>::quiet_NaN();
+    std::memcpy(&bits, &value, sizeof(bits));
+    entry.store(bits, std::memory_order_relaxed);
+    return value;
+  }
+
+ private:
+  Entry *getPage(std::uint32_t index) {
+    Entry *page = pages_[index].load(std::memory_order_acquire);
+    if (page != nullptr)
+      return page;
+
+    Entry *newPage = new Entry[PageSize];
+    for (std::uint32_t i = 0; i < PageSize; ++i)
+      newPage[i].store(Unknown, std::memory_order_relaxed);
+    if (pages_[index].compare_exchange_strong(page, newPage, std::memory_order_acq_rel))
+      return newPage;
+
+    // NOTE another thread has already allocated page.
+    delete[] newPage;
+    return page;
+  }
+
+  static double toDouble(std::uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::unique_ptr<std::atomic<Entry *>[]> pages_;
 };
 
+/// Identifies style of elements with the same kind and tags at given level of details.
+struct StyleKey final {
+  int kind;
+  int levelOfDetail;
+  std::vector<Tag> tags;
+
+  bool operator==(const StyleKey &other) const {
+    return kind==other.kind && levelOfDetail==other.levelOfDetail && tags.size()==other.tags.size() &&
+        std::equal(tags.begin(), tags.end(), other.tags.begin(), [](const Tag &lhs, const Tag &rhs) {
+          return lhs.key==rhs.key && lhs.value==rhs.value;
+        });
+  }
+};
+
+struct StyleKeyHash final {
+  std::size_t operator()(const StyleKey &key) const {
+    std::size_t seed = static_cast<std::size_t>(key.kind*31 + key.levelOfDetail);
+    for (const auto &tag : key.tags) {
+      seed ^= tag.key + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      seed ^= tag.value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+  }
+};
+
+/// Gets kind of element which defines filters used for it.
+/// NOTE filter is stored once for the whole range of levels of details of its rule.
 struct ConditionFilter final {
   std::vector<ConditionType> conditions;
   std::vector<std::shared_ptr<const StyleDeclaration>> declarations;
+  /// Range of levels of details where the filter is valid.
+  int startLevel = 0;
+  int endLevel = 0;
+};
+
+/// Refers to condition filter from specific level of details.
+struct LevelFilter final {
+  /// Index of filter in its collection.
+  std::uint32_t filter = 0;
+  /// Fingerprint of conditions, declarations and position of the filter at level of details.
+  std::uint64_t fingerprint = 0;
+  /// Index of rule counters in style statistics.
+  std::uint32_t index = 0;
+};
+
+/// Filters of one level of details indexed by tag which they require.
+/// NOTE every condition requires its key to be present, so filter can match only elements
+/// which have the tag of its anchor condition: equality is preferred as the most selective one.
+struct LevelFilters final {
+  std::vector<LevelFilter> filters;
+  /// Indices of filters anchored by equality condition keyed by tag key and value.
+  std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> byTag;
+  /// Indices of filters anchored by other condition keyed by tag key.
+  std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> byKey;
+  /// Indices of filters without conditions.
+  std::vector<std::uint32_t> unconditional;
+
+  static std::uint64_t tagKey(std::uint32_t key, std::uint32_t value) {
+    return (static_cast<std::uint64_t>(key) << 32) | value;
+  }
+
+  /// Builds index of filters.
+  void compile(const std::vector<ConditionFilter> &conditionFilters) {
+    for (std::uint32_t i = 0; i < filters.size(); ++i) {
+      const auto &conditions = conditionFilters[filters[i].filter].conditions;
+      if (conditions.empty()) {
+        unconditional.push_back(i);
+        continue;
+      }
+      auto anchor = std::find_if(conditions.begin(), conditions.end(),
+                                 [](const ConditionType &c) { return c.type==OpType::Equals; });
+      if (anchor!=conditions.end())
+        byTag[tagKey(anchor->key, anchor->value)].push_back(i);
+      else
+        byKey[conditions.front().key].push_back(i);
+    }
+  }
+
+  /// Collects indices of filters which might match given tags in order of their declaration.
+  void getCandidates(const std::vector<Tag> &tags, std::vector<std::uint32_t> &candidates) const {
+    candidates.assign(unconditional.begin(), unconditional.end());
+    for (const auto &tag : tags) {
+      auto tagFilters = byTag.find(tagKey(tag.key, tag.value));
+      if (tagFilters!=byTag.end())
+        candidates.insert(candidates.end(), tagFilters->second.begin(), tagFilters->second.end());
+      auto keyFilters = byKey.find(tag.key);
+      if (keyFilters!=byKey.end())
+        candidates.insert(candidates.end(), keyFilters->second.begin(), keyFilters->second.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+  }
+};
+
+/// Filters of one element kind. Every filter is kept once with range of levels of details
+/// while levels keep only references to filters valid for them.
+struct ConditionFilters final {
+  std::vector<ConditionFilter> filters;
+  /// Filters by level of details. Built by compile.
+  std::vector<LevelFilters> levels;
+
+  void add(ConditionFilter &&filter) {
+    filters.push_back(std::move(filter));
+  }
+
+  /// Builds filters of levels of details in order of declaration.
+  void compile() {
+    for (std::uint32_t i = 0; i < filters.size(); ++i) {
+      if (filters[i].endLevel >= static_cast<int>(levels.size()))
+        levels.resize(filters[i].endLevel + 1);
+      for (int level = filters[i].startLevel; level <= filters[i].endLevel; ++level) {
+        LevelFilter levelFilter;
+        levelFilter.filter = i;
+        levels[level].filters.push_back(levelFilter);
+      }
+    }
+    for (auto &level : levels)
+      level.compile(filters);
+  }
+
+  /// Gets filters of given level of details or null if there are none.
+  const LevelFilters *getLevel(int levelOfDetail) const {
+    return levelOfDetail >= 0 && levelOfDetail < static_cast<int>(levels.size()) &&
+           !levels[levelOfDetail].filters.empty() ? &levels[levelOfDetail] : nullptr;
+  }
 };
 
 typedef std::vector<std::shared_ptr<const StyleDeclaration>> StyleDeclarations;
-/// Key: level of details, value: filters for specific element type.
-typedef std::unordered_map<int, std::vector<ConditionFilter>> ConditionFilterMap;
 typedef std::unordered_map<std::uint64_t, StyleDeclarations> IdentifierFilter;
 typedef std::unordered_map<int, IdentifierFilter> IdentifierFilterMap;
+typedef std::unordered_map<std::string, std::shared_ptr<const StyleEvaluator::Program>> Expressions;
 
 struct FilterCollection final {
-  ConditionFilterMap nodes;
-  ConditionFilterMap ways;
-  ConditionFilterMap areas;
-  ConditionFilterMap relations;
-  ConditionFilterMap canvases;
+  ConditionFilters nodes;
+  ConditionFilters ways;
+  ConditionFilters areas;
+  ConditionFilters relations;
+  ConditionFilters canvases;
   IdentifierFilterMap elements;
 };
 
-/// Alters tag with value specific for passed style declarations.
-void addTo(std::string &tag, const StyleDeclarations &styles) {
-  for (const auto &style :styles) {
-    tag.append(utymap::utils::toString(style->key()));
-    tag.append(utymap::utils::toString(style->value()));
+/// Computes fingerprint of filter structure without building intermediate string.
+/// NOTE it is not cryptographic hash: it only names cache directory of the styles.
+class TagHasher final {
+ public:
+  void add(std::uint64_t value) {
+    h1_ = mix(h1_ ^ value);
+    h2_ = mix(h2_ + value + h1_);
   }
-}
 
-void addTo(std::string &tag, const OpType &type) {
-  switch (type) {
-    case OpType::Exists: tag.append("~");
-      break;
-    case OpType::Equals: tag.append("==");
-      break;
-    case OpType::NotEquals: tag.append("!=");
-      break;
-    case OpType::Less: tag.append("<");
-      break;
-    case OpType::Greater: tag.append(">");
-      break;
+  void add(const std::string &value) {
+    std::uint64_t hash[2];
+    MurmurHash3_x64_128(value.data(), static_cast<int>(value.size()), 0, hash);
+    add(hash[0]);
+    add(hash[1]);
   }
-}
 
-/// Alters tag with value specific for passed filter map.
-void addTo(std::string &tag, const ConditionFilterMap &filterMap) {
-  for (const auto &pair : filterMap) {
-    tag.append(utymap::utils::toString(pair.first));
-    for (const auto &filter : pair.second) {
-      for (const auto &cond : filter.conditions) {
-        tag.append(utymap::utils::toString(cond.key));
-        addTo(tag, cond.type);
-        tag.append(utymap::utils::toString(cond.value));
+  void add(const StyleDeclarations &styles) {
+    for (const auto &style : styles) {
+      add(style->key());
+      add(style->value());
+    }
+  }
+
+  void add(const std::vector<ConditionType> &conditions) {
+    for (const auto &cond : conditions) {
+      add(cond.key);
+      add(static_cast<std::uint64_t>(cond.type));
+      add(cond.value);
+    }
+  }
+
+  void add(const ConditionFilters &conditionFilters) {
+    for (std::uint64_t level = 0; level < conditionFilters.levels.size(); ++level) {
+      if (conditionFilters.levels[level].filters.empty())
+        continue;
+      add(level);
+      for (const auto &levelFilter : conditionFilters.levels[level].filters) {
+        const auto &filter = conditionFilters.filters[levelFilter.filter];
+        add(filter.conditions);
+        add(filter.declarations);
       }
-      addTo(tag, filter.declarations);
     }
   }
-}
 
-/// Alters tag with value specific for passed filter map.
-void addTo(std::string &tag, const IdentifierFilterMap &filterMap) {
-  for (const auto &pair : filterMap) {
-    tag.append(utymap::utils::toString(pair.first));
-    for (const auto &id : pair.second) {
-      tag.append(utymap::utils::toString(id.first));
-      addTo(tag, id.second);
+  void add(const IdentifierFilterMap &filterMap) {
+    for (const auto &pair : filterMap) {
+      add(static_cast<std::uint64_t>(pair.first));
+      for (const auto &id : pair.second) {
+        add(id.first);
+        add(id.second);
+      }
     }
   }
-}
 
-/// Gets hash for given filter collection.
-std::string getHashTag(const FilterCollection &filterCollection) {
-  std::string tag;
-  tag.reserve(64000);
+  /// Returns fingerprint as number.
+  std::uint64_t digest() const {
+    return h1_ ^ h2_;
+  }
+
+  /// Returns fingerprint as hex string.
+  std::string hexdigest() const {
+    char buffer[33];
+    std::snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+                  static_cast<unsigned long long>(h1_), static_cast<unsigned long long>(h2_));
+    return buffer;
+  }
+
+ private:
+  /// Finalization mix of MurmurHash3: forces all bits of value to avalanche.
+  static std::uint64_t mix(std::uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+  }
 
-  addTo(tag, filterCollection.nodes);
-  addTo(tag, filterCollection.ways);
-  addTo(tag, filterCollection.areas);
-  addTo(tag, filterCollection.relations);
-  addTo(tag, filterCollection.canvases);
-  addTo(tag, filterCollection.elements);
+  std::uint64_t h1_ = 0x9e3779b97f4a7c15ULL;
+  std::uint64_t h2_ = 0;
+};
 
-  return MD5(tag).hexdigest();
+/// Gets hash for given filter collection.
+std::string getHashTag(const FilterCollection &filterCollection) {
+  TagHasher hasher;
+  hasher.add(filterCollection.nodes);
+  hasher.add(filterCollection.ways);
+  hasher.add(filterCollection.areas);
+  hasher.add(filterCollection.relations);
+  hasher.add(filterCollection.canvases);
+  hasher.add(filterCollection.elements);
+  return hasher.hexdigest();
 }
 
 class StyleBuilder final : public ElementVisitor {
   typedef std::vector<Tag>::const_iterator TagIterator;
  public:
 
-  StyleBuilder(std::vector<Tag> tags, StringTable &stringTable,
-               const FilterCollection &filters, int levelOfDetail, bool onlyCheck = false) :
-      style(tags, stringTable),
+  StyleBuilder(const std::vector<Tag> &tags, StringTable &stringTable, const StyleConstIds &constIds,
+               NumberCache &numbers, const FilterCollection &filters, int levelOfDetail, bool onlyCheck = false,
+               StyleStatistics *statistics = nullptr) :
+      style(tags, stringTable, constIds),
       filters_(filters),
       levelOfDetail_(levelOfDetail),
       onlyCheck_(onlyCheck),
       canBuild_(false),
-      stringTable_(stringTable) {
+      stringTable_(stringTable),
+      numbers_(numbers),
+      statistics_(statistics) {
   }
 
   void visitNode(const Node &node) override { checkOrBuild(node, filters_.nodes); }
@@ -139,7 +376,7 @@ class StyleBuilder final : public ElementVisitor {
 
  private:
 
-  void checkOrBuild(const Element &element, const ConditionFilterMap &filters) {
+  void checkOrBuild(const Element &element, const ConditionFilters &filters) {
     if (!buildFromIdentifier(element))
       buildFromCondition(element.tags, filters);
   }
@@ -150,21 +387,21 @@ class StyleBuilder final : public ElementVisitor {
       case OpType::Exists:return true;
       case OpType::Equals:return tag.value==condition.value;
       case OpType::NotEquals:return tag.value!=condition.value;
-      case OpType::Less:return compareDoubles(tag.value, condition.value, std::less<double>());
-      case OpType::Greater:return compareDoubles(tag.value, condition.value, std::greater<double>());
+      case OpType::Less:return compareDoubles(tag.value, condition.number, std::less<double>());
+      case OpType::Greater:return compareDoubles(tag.value, condition.number, std::greater<double>());
       default:return false;
     }
   }
 
-  /// Compares two raw string values using double conversion.
+  /// Compares raw string value with condition number using double conversion.
   template<typename Func>
-  bool compareDoubles(std::uint32_t left, std::uint32_t right, Func binaryOp) {
-    auto leftStr = stringTable_.getString(left);
-    auto rightStr = stringTable_.getString(right);
-    double leftValue = utymap::utils::parseDouble(*leftStr);
-    double rightValue = utymap::utils::parseDouble(*rightStr);
+  bool compareDoubles(std::uint32_t left, double right, Func binaryOp) {
+    double leftValue = numbers_.get(left, [&]() {
+      auto leftStr = stringTable_.getStringView(left);
+      return utymap::utils::parseDouble(leftStr.data, leftStr.size);
+    });
 
-    return binaryOp(leftValue, rightValue);
+    return binaryOp(leftValue, right);
   }
 
   /// Tries to find tag which satisfy condition using binary search.
@@ -182,19 +419,30 @@ class StyleBuilder final : public ElementVisitor {
   }
 
   /// Builds style object from regular mapcss rule encapsulated by condition filter.
-  void buildFromCondition(const std::vector<Tag> &tags, const ConditionFilterMap &filters) {
-    ConditionFilterMap::const_iterator iter = filters.find(levelOfDetail_);
-    if (iter!=filters.end()) {
-      for (const ConditionFilter &filter : iter->second) {
+  /// Only filters whose anchor tag is present are evaluated.
+  void buildFromCondition(const std::vector<Tag> &tags, const ConditionFilters &filters) {
+    const LevelFilters *level = filters.getLevel(levelOfDetail_);
+    if (level!=nullptr) {
+      thread_local std::vector<std::uint32_t> candidates;
+      level->getCandidates(tags, candidates);
+      for (std::uint32_t index : candidates) {
+        const LevelFilter &levelFilter = level->filters[index];
+        const ConditionFilter &filter = filters.filters[levelFilter.filter];
         bool isMatched = true;
         for (auto it = filter.conditions.cbegin(); it!=filter.conditions.cend() && isMatched; ++it) {
           isMatched &= matchTags(tags.cbegin(), tags.cend(), *it);
         }
+        if (statistics_!=nullptr) {
+          auto &rule = statistics_->rule(levelFilter.index);
+          rule.evaluations.fetch_add(1, std::memory_order_relaxed);
+          if (isMatched) rule.matches.fetch_add(1, std::memory_order_relaxed);
+        }
         // merge declarations to style
         if (isMatched) {
           canBuild_ = true;
           if (onlyCheck_) return;
 
+          style.addRule(levelFilter.fingerprint);
           for (const auto &d : filter.declarations) {
             style.put(*d);
           }
@@ -225,8 +473,21 @@ class StyleBuilder final : public ElementVisitor {
   bool onlyCheck_;
   bool canBuild_;
   StringTable &stringTable_;
+  NumberCache &numbers_;
+  StyleStatistics *statistics_;
 };
 
+/// Writes string as json string literal.
+void writeJson(std::ostream &stream, const std::string &value) {
+  stream << '"';
+  for (char c : value) {
+    if (c=='"' || c=='\\') stream << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20) stream << ' ';
+    else stream << c;
+  }
+  stream << '"';
+}
+
 }
 
 /// Converts mapcss stylesheet to index optimized representation to speed search query up.
@@ -235,35 +496,41 @@ class StyleProvider::StyleProviderImpl {
 
   FilterCollection filters;
   StringTable &stringTable;
+  const StyleConstIds constIds;
+  /// NOTE is shared by style builders of all threads.
+  mutable NumberCache numbers;
+
+  /// Max amount of cached styles. Cache is cleared once it is reached.
+  static const std::size_t MaxCachedStyles = 8192;
 
   StyleProviderImpl(const StyleSheet &stylesheet, StringTable &stringTable) :
       filters(),
       stringTable(stringTable),
+      constIds(stringTable),
+      numbers(),
       gradients(),
       textures() {
-    filters.nodes.reserve(24);
-    filters.ways.reserve(24);
-    filters.areas.reserve(24);
-    filters.relations.reserve(24);
-    filters.canvases.reserve(24);
     filters.elements.reserve(24);
 
+    for (const auto &gradient : stylesheet.gradients)
+      gradients.emplace(gradient.first, utymap::utils::make_unique<const ColorGradient>(gradient.second));
+
     for (const Rule &rule : stylesheet.rules) {
       for (const Selector &selector : rule.selectors) {
         for (const std::string &name : selector.names) {
-          ConditionFilterMap *filtersPtr = nullptr;
+          ConditionFilters *filtersPtr = nullptr;
           if (name=="node") filtersPtr = &filters.nodes;
           else if (name=="way") filtersPtr = &filters.ways;
           else if (name=="area") filtersPtr = &filters.areas;
           else if (name=="relation") filtersPtr = &filters.relations;
           else if (name=="canvas") filtersPtr = &filters.canvases;
           else if (name=="element") {
-            addIdentifierRule(selector, rule.declarations);
+            addIdentifierRule(selector, rule.declarations, stylesheet.expressions);
             continue;
           } else
             throw std::domain_error("Unexpected selector name:" + name);
 
-          addConditionRule(filtersPtr, rule, selector);
+          addConditionRule(filtersPtr, rule, selector, stylesheet.expressions);
         }
       }
     }
@@ -277,7 +544,84 @@ class StyleProvider::StyleProviderImpl {
       lsystems.emplace(lsystem.first, utymap::utils::make_unique<const utymap::lsys::LSystem>(lsystem.second));
     }
 
+    for (auto *conditionFilters : {&filters.nodes, &filters.ways, &filters.areas, &filters.relations, &filters.canvases})
+      conditionFilters->compile();
+
     hashTag_ = getHashTag(filters);
+    addFingerprints();
+    statistics_ = utymap::utils::make_unique<StyleStatistics>(utymap::QuadKey::MaxLevelOfDetail + 1, ruleNames_.size());
+  }
+
+  /// Enables collecting of statistics. Counters are reset each time it is enabled.
+  void enableProfiling(bool enabled) {
+    if (enabled)
+      statistics_->reset();
+    isProfiling_ = enabled;
+  }
+
+  /// Gets statistics if profiling is enabled and level of details is valid, otherwise null.
+  StyleStatistics *getStatistics(int levelOfDetails) const {
+    return isProfiling_ && levelOfDetails >= 0 && levelOfDetails < static_cast<int>(statistics_->levelCount())
+           ? statistics_.get()
+           : nullptr;
+  }
+
+  /// Gets statistics of levels of details and their rules as json.
+  std::string getProfile() const {
+    std::vector<std::vector<std::uint32_t>> levelRules(statistics_->levelCount());
+    for (std::uint32_t i = 0; i < ruleNames_.size(); ++i)
+      levelRules[ruleNames_[i].first].push_back(i);
+
+    std::stringstream ss;
+    ss << "{\"levels\":[";
+    bool isFirstLevel = true;
+    for (int lod = 0; lod < static_cast<int>(statistics_->levelCount()); ++lod) {
+      const auto &level = statistics_->level(lod);
+      if (levelRules[lod].empty() && level.elements==0)
+        continue;
+
+      ss << (isFirstLevel ? "" : ",") << "{\"lod\":" << lod
+         << ",\"elements\":" << level.elements
+         << ",\"matches\":" << level.matches
+         << ",\"matchTime\":" << level.matchTime()
+         << ",\"evaluations\":" << level.evaluations
+         << ",\"evaluationTime\":" << level.evaluationTime()
+         << ",\"rules\":[";
+      isFirstLevel = false;
+
+      bool isFirstRule = true;
+      for (auto index : levelRules[lod]) {
+        const auto &rule = statistics_->rule(index);
+        ss << (isFirstRule ? "" : ",") << "{\"selector\":";
+        writeJson(ss, ruleNames_[index].second);
+        ss << ",\"evaluations\":" << rule.evaluations
+           << ",\"matches\":" << rule.matches
+           << ",\"elements\":" << rule.elements << "}";
+        isFirstRule = false;
+      }
+      ss << "]}";
+    }
+    ss << "]}";
+    return ss.str();
+  }
+
+  std::uint64_t getLayoutFingerprint(int levelOfDetails) const {
+    auto layout = layouts_.find(levelOfDetails);
+    return layout!=layouts_.end() ? layout->second : 0;
+  }
+
+  bool hasRule(std::uint64_t fingerprint) const {
+    return rules_.find(fingerprint)!=rules_.end();
+  }
+
+  bool hasStyle(const Element &element, int levelOfDetails) const {
+    auto statistics = getStatistics(levelOfDetails);
+    auto start = statistics!=nullptr ? StyleStatistics::Clock::now() : StyleStatistics::Clock::time_point();
+    StyleBuilder builder(element.tags, stringTable, constIds, numbers, filters, levelOfDetails, true, statistics);
+    dispatch(element, builder);
+    if (statistics!=nullptr)
+      statistics->level(levelOfDetails).addMatchTime(StyleStatistics::Clock::now() - start);
+    return builder.canBuild();
   }
 
   const std::string &getTag() const {
@@ -305,6 +649,26 @@ class StyleProvider::StyleProviderImpl {
     return texturePair->second->get(key);
   }
 
+  /// Gets style of element. Styles are cached by element kind, tags and level of details,
+  /// so elements with the same tags are styled once.
+  /// NOTE element with identifier rule at given level of details is not cached.
+  Style forElement(const Element &element, int levelOfDetails) const {
+    auto statistics = getStatistics(levelOfDetails);
+    if (statistics==nullptr)
+      return getStyle(element, levelOfDetails, nullptr);
+
+    auto &level = statistics->level(levelOfDetails);
+    level.elements.fetch_add(1, std::memory_order_relaxed);
+    auto style = getStyle(element, levelOfDetails, statistics);
+    for (auto fingerprint : style.getRules()) {
+      auto rule = rules_.find(fingerprint);
+      if (rule!=rules_.end())
+        statistics->rule(rule->second).elements.fetch_add(1, std::memory_order_relaxed);
+    }
+    style.setStatistics(&level);
+    return style;
+  }
+
   const utymap::lsys::LSystem &getLsystem(const std::string &key) const {
     auto lsystemPair = lsystems.find(key);
     if (lsystemPair==lsystems.end())
@@ -315,10 +679,117 @@ class StyleProvider::StyleProviderImpl {
 
  private:
 
+  Style getStyle(const Element &element, int levelOfDetails, StyleStatistics *statistics) const {
+    if (hasIdentifierRule(element, levelOfDetails))
+      return build(element, levelOfDetails, statistics);
+
+    StyleKey key{ static_cast<int>(element.kind), levelOfDetails, element.tags };
+    {
+      std::lock_guard<std::mutex> lock(styleLock_);
+      auto style = styles_.find(key);
+      if (style!=styles_.end())
+        return Style(*style->second, element.tags);
+    }
+
+    // NOTE cached style does not refer to tags of element: it is only used as template.
+    auto style = build(element, levelOfDetails, statistics);
+    {
+      std::lock_guard<std::mutex> lock(styleLock_);
+      if (styles_.size() >= MaxCachedStyles)
+        styles_.clear();
+      styles_.emplace(std::move(key), std::make_shared<const Style>(style, NoTags));
+    }
+    return style;
+  }
+
+  /// Computes fingerprints and statistics indices of filters and layouts of levels of details.
+  /// Layout covers conditions of all filters, so elements match the same filters while it is not changed.
+  /// Canvas and identifier rules are applied to the whole level of details, so they are part of layout.
+  void addFingerprints() {
+    std::map<int, TagHasher> layouts;
+    std::uint64_t kind = 0;
+    for (auto *conditionFilters : {&filters.nodes, &filters.ways, &filters.areas, &filters.relations}) {
+      ++kind;
+      for (int level = 0; level < static_cast<int>(conditionFilters->levels.size()); ++level) {
+        auto &levelFilters = conditionFilters->levels[level].filters;
+        if (levelFilters.empty())
+          continue;
+        auto &layout = layouts[level];
+        for (std::uint64_t i = 0; i < levelFilters.size(); ++i) {
+          const auto &filter = conditionFilters->filters[levelFilters[i].filter];
+          TagHasher hasher;
+          hasher.add(kind);
+          hasher.add(i);
+          hasher.add(filter.conditions);
+          hasher.add(filter.declarations);
+          levelFilters[i].fingerprint = hasher.digest();
+          levelFilters[i].index = static_cast<std::uint32_t>(ruleNames_.size());
+          rules_.emplace(levelFilters[i].fingerprint, levelFilters[i].index);
+          ruleNames_.emplace_back(level, getSelector(kind, level, filter.conditions));
+
+          layout.add(kind);
+          layout.add(i);
+          layout.add(filter.conditions);
+        }
+      }
+    }
+
+    for (const auto &filter : filters.canvases.filters) {
+      for (int level = filter.startLevel; level <= filter.endLevel; ++level) {
+        layouts[level].add(filter.conditions);
+        layouts[level].add(filter.declarations);
+      }
+    }
+
+    for (const auto &pair : filters.elements) {
+      for (const auto &id : pair.second) {
+        layouts[pair.first].add(id.first);
+        layouts[pair.first].add(id.second);
+      }
+    }
+
+    for (const auto &layout : layouts)
+      layouts_[layout.first] = layout.second.digest();
+  }
+
+  /// Gets selector text of filter for statistics.
+  std::string getSelector(std::uint64_t kind, int levelOfDetails, const std::vector<ConditionType> &conditions) const {
+    static const char *names[] = {"", "node", "way", "area", "relation"};
+    std::stringstream ss;
+    ss << names[kind] << "|z" << levelOfDetails;
+    for (const auto &condition : conditions) {
+      ss << '[' << *stringTable.getString(condition.key);
+      switch (condition.type) {
+        case OpType::Exists: ss << ']'; continue;
+        case OpType::Equals: ss << '='; break;
+        case OpType::NotEquals: ss << "!="; break;
+        case OpType::Less: ss << '<'; break;
+        case OpType::Greater: ss << '>'; break;
+      }
+      ss << *stringTable.getString(condition.value) << ']';
+    }
+    return ss.str();
+  }
+
+  Style build(const Element &element, int levelOfDetails, StyleStatistics *statistics) const {
+    auto start = statistics!=nullptr ? StyleStatistics::Clock::now() : StyleStatistics::Clock::time_point();
+    StyleBuilder builder(element.tags, stringTable, constIds, numbers, filters, levelOfDetails, false, statistics);
+    dispatch(element, builder);
+    if (statistics!=nullptr)
+      statistics->level(levelOfDetails).addMatchTime(StyleStatistics::Clock::now() - start);
+    return std::move(builder.style);
+  }
+
+  bool hasIdentifierRule(const Element &element, int levelOfDetails) const {
+    auto filterMap = filters.elements.find(levelOfDetails);
+    return filterMap!=filters.elements.end() && filterMap->second.find(element.id)!=filterMap->second.end();
+  }
+
   /// Adds rule for element with specific id.
-  void addIdentifierRule(const Selector &selector, const std::vector<Declaration> &declarations) {
+  void addIdentifierRule(const Selector &selector, const std::vector<Declaration> &declarations,
+                         const Expressions &expressions) {
     auto filter = IdentifierFilter();
-    addDeclarations(declarations, [&](std::shared_ptr<const StyleDeclaration> declaration) {
+    addDeclarations(declarations, expressions, [&](std::shared_ptr<const StyleDeclaration> declaration) {
       auto id = utymap::utils::lexicalCast<std::uint64_t>(selector.conditions[0].value);
       filter[id].push_back(declaration);
     });
@@ -330,10 +801,11 @@ class StyleProvider::StyleProviderImpl {
   }
 
   /// Adds rule for element.
-  void addConditionRule(ConditionFilterMap *filtersPtr, const Rule &rule, const Selector &selector) {
+  void addConditionRule(ConditionFilters *filtersPtr, const Rule &rule, const Selector &selector,
+                        const Expressions &expressions) {
     ConditionFilter filter;
     addConditions(filter, selector.conditions);
-    addDeclarations(rule.declarations, [&](std::shared_ptr<const StyleDeclaration> declaration) {
+    addDeclarations(rule.declarations, expressions, [&](std::shared_ptr<const StyleDeclaration> declaration) {
       filter.declarations.push_back(declaration);
     });
     addToFilterMap(filtersPtr, filter, selector);
@@ -353,25 +825,33 @@ class StyleProvider::StyleProviderImpl {
 
       c.key = stringTable.getId(condition.key);
       c.value = stringTable.getId(condition.value);
+      c.number = utymap::utils::parseDouble(condition.value);
       filter.conditions.push_back(c);
     }
   }
 
   template<typename T>
-  void addDeclarations(const std::vector<Declaration> &declarations, const T &filter) {
+  void addDeclarations(const std::vector<Declaration> &declarations, const Expressions &expressions, const T &filter) {
     for (const auto &declaration : declarations) {
       if (utymap::utils::GradientUtils::isGradient(declaration.value))
         addGradient(declaration.value);
-      filter(std::make_shared<const StyleDeclaration>(stringTable.getId(declaration.key), declaration.value));
+
+      auto key = stringTable.getId(declaration.key);
+      auto expression = expressions.find(declaration.value);
+      filter(expression!=expressions.end()
+             ? std::make_shared<const StyleDeclaration>(key, declaration.value, *expression->second, stringTable)
+             : std::make_shared<const StyleDeclaration>(key, declaration.value, stringTable));
     }
   }
 
-  void addToFilterMap(ConditionFilterMap *filtersPtr, ConditionFilter &filter, const Selector &selector) {
+  void addToFilterMap(ConditionFilters *filtersPtr, ConditionFilter &filter, const Selector &selector) {
     std::sort(filter.conditions.begin(), filter.conditions.end(),
               [](const ConditionType &c1, const ConditionType &c2) { return c1.key > c2.key; });
-    for (int i = selector.zoom.start; i <= selector.zoom.end; ++i) {
-      (*filtersPtr)[i].push_back(filter);
-    }
+    if (selector.zoom.start > selector.zoom.end)
+      return;
+    filter.startLevel = selector.zoom.start;
+    filter.endLevel = selector.zoom.end;
+    filtersPtr->add(std::move(filter));
   }
 
   void addGradient(const std::string &key) {
@@ -385,6 +865,16 @@ class StyleProvider::StyleProviderImpl {
   std::mutex lock_;
   std::string hashTag_;
 
+  mutable std::mutex styleLock_;
+  mutable std::unordered_map<StyleKey, std::shared_ptr<const Style>, StyleKeyHash> styles_;
+  std::unordered_map<int, std::uint64_t> layouts_;
+  /// Maps fingerprint of rule to its statistics index.
+  std::unordered_map<std::uint64_t, std::uint32_t> rules_;
+  /// Level of details and selector of rules by statistics index.
+  std::vector<std::pair<int, std::string>> ruleNames_;
+  std::unique_ptr<StyleStatistics> statistics_;
+  std::atomic<bool> isProfiling_{false};
+
   std::unordered_map<std::string, std::unique_ptr<const ColorGradient>> gradients;
   std::unordered_map<std::uint16_t, std::unique_ptr<const TextureAtlas>> textures;
   std::unordered_map<std::string, std::unique_ptr<const utymap::lsys::LSystem>> lsystems;
@@ -404,28 +894,51 @@ const std::string &StyleProvider::getTag() const {
   return pimpl_->getTag();
 }
 
+std::uint64_t StyleProvider::getLayoutFingerprint(int levelOfDetails) const {
+  return pimpl_->getLayoutFingerprint(levelOfDetails);
+}
+
+bool StyleProvider::hasRule(std::uint64_t fingerprint) const {
+  return pimpl_->hasRule(fingerprint);
+}
+
 bool StyleProvider::hasStyle(const utymap::entities::Element &element, int levelOfDetails) const {
-  StyleBuilder builder(element.tags, pimpl_->stringTable, pimpl_->filters, levelOfDetails, true);
-  element.accept(builder);
-  return builder.canBuild();
+  return pimpl_->hasStyle(element, levelOfDetails);
+}
+
+void StyleProvider::enableProfiling(bool enabled) const {
+  pimpl_->enableProfiling(enabled);
+}
+
+std::string StyleProvider::getProfile() const {
+  return pimpl_->getProfile();
 }
 
 Style StyleProvider::forElement(const Element &element, int levelOfDetails) const {
-  StyleBuilder builder(element.tags, pimpl_->stringTable, pimpl_->filters, levelOfDetails);
-  element.accept(builder);
-  return std::move(builder.style);
+  utymap::utils::Metrics::add(utymap::utils::Metrics::Counter::StyleMatches);
+  TRACE_ZONE("style");
+  return pimpl_->forElement(element, levelOfDetails);
 }
 
 Style StyleProvider::forCanvas(int levelOfDetails) const {
-  Style style({}, pimpl_->stringTable);
-  for (const auto &filter : pimpl_->filters.canvases[levelOfDetails]) {
-    for (const auto &declaration : filter.declarations) {
+  Style style(NoTags, pimpl_->stringTable, pimpl_->constIds);
+  const auto &canvases = pimpl_->filters.canvases;
+  const auto *level = canvases.getLevel(levelOfDetails);
+  if (level==nullptr)
+    return std::move(style);
+
+  for (const auto &levelFilter : level->filters) {
+    for (const auto &declaration : canvases.filters[levelFilter.filter].declarations) {
       style.put(*declaration);
     }
   }
   return std::move(style);
 }
 
+const StyleConstIds &StyleProvider::getConstIds() const {
+  return pimpl_->constIds;
+}
+
 const ColorGradient &StyleProvider::getGradient(const std::string &key) const {
   return pimpl_->getGradient(key);
 }
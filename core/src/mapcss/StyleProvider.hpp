@@ -31,15 +31,34 @@ class StyleProvider final {
   /// Returns an unique tag associated with the used styles.
   const std::string &getTag() const;
 
+  /// Returns fingerprint of rule conditions, canvas and identifier rules at given level of details.
+  /// NOTE elements match rules at the same positions while it is not changed.
+  std::uint64_t getLayoutFingerprint(int levelOfDetails) const;
+
+  /// Checks whether rule with given fingerprint exists. Fingerprints are reported by Style::getRules.
+  bool hasRule(std::uint64_t fingerprint) const;
+
   /// Checks whether style is defined for the element.
   bool hasStyle(const utymap::entities::Element &, int levelOfDetails) const;
 
+  /// Enables or disables collecting of rule statistics. Statistics are reset when it is enabled.
+  /// NOTE statistics are collected for styles requested after the call.
+  void enableProfiling(bool enabled) const;
+
+  /// Gets rule statistics collected since profiling was enabled as json: match and evaluation
+  /// counters and time of each level of details with counters of its rules.
+  std::string getProfile() const;
+
   /// Returns style for given element at given level of details.
+  /// NOTE styles are cached by element kind, tags and level of details.
   Style forElement(const utymap::entities::Element &, int levelOfDetails) const;
 
   /// Returns style for canvas at given level of details.
   Style forCanvas(int levelOfDetails) const;
 
+  /// Returns ids of style const keys resolved for used string table.
+  const StyleConstIds &getConstIds() const;
+
   /// Returns color gradient for given key.
   const ColorGradient &getGradient(const std::string &key) const;
 
@@ -3,8 +3,11 @@
 
 #include "math/Rectangle.hpp"
 #include "lsys/LSystem.hpp"
+#include "mapcss/ColorGradient.hpp"
+#include "mapcss/StyleEvaluator.hpp"
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -46,6 +49,16 @@ struct TextureGroup final {
         static_cast<std::uint16_t>(rect.height()));
   }
 
+  /// Adds given region to the group.
+  void add(const TextureRegion &region) {
+    regions_.push_back(region);
+  }
+
+  /// Returns all regions of the group.
+  const std::vector<TextureRegion> &regions() const {
+    return regions_;
+  }
+
   /// Returns pseudo random region.
   const TextureRegion &random(std::uint64_t seed) const {
     return regions_[seed%regions_.size()];
@@ -74,6 +87,11 @@ struct TextureAtlas final {
     return index_;
   }
 
+  /// Returns all texture groups.
+  const Groups &groups() const {
+    return textureGroups_;
+  }
+
   /// Returns a reference to texture group.
   /// Note: returns raw reference from map.
   const TextureGroup &get(const std::string &key) const {
@@ -128,6 +146,12 @@ struct StyleSheet final {
   std::vector<Rule> rules;
   std::vector<TextureAtlas> textures;
   std::unordered_map<std::string, utymap::lsys::LSystem> lsystems;
+  /// Paths of files imported by stylesheet.
+  std::vector<std::string> sources;
+  /// Precompiled expressions by declaration value. Empty when stylesheet is parsed from source.
+  std::unordered_map<std::string, std::shared_ptr<const StyleEvaluator::Program>> expressions;
+  /// Precompiled gradients by declaration value. Empty when stylesheet is parsed from source.
+  std::unordered_map<std::string, ColorGradient::GradientData> gradients;
 };
 
 }
@@ -0,0 +1,428 @@
+#include "hashing/MD5.h"
+#include "lsys/Rules.hpp"
+#include "mapcss/StyleSheetStream.hpp"
+#include "utils/GradientUtils.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <typeindex>
+#include <utility>
+
+using namespace utymap::lsys;
+using namespace utymap::mapcss;
+
+namespace {
+
+const char Magic[4] = {'U', 'C', 'S', 'S'};
+const std::uint16_t Version = 1;
+/// Max size of single string: protects from allocations caused by corrupted data.
+const std::uint32_t MaxStringSize = 1 << 24;
+
+typedef StyleEvaluator::Program Program;
+
+/// Word rule has own code as it is the only rule with data.
+const std::uint8_t WordRuleCode = 0;
+
+/// Rules without data: code of rule is its index plus one.
+const std::vector<std::pair<std::type_index, LSystem::RuleType>> &getRules() {
+  static const std::vector<std::pair<std::type_index, LSystem::RuleType>> rules = {
+      {typeid(MoveForwardRule), std::make_shared<MoveForwardRule>()},
+      {typeid(JumpForwardRule), std::make_shared<JumpForwardRule>()},
+      {typeid(TurnLeftRule), std::make_shared<TurnLeftRule>()},
+      {typeid(TurnRightRule), std::make_shared<TurnRightRule>()},
+      {typeid(TurnAroundRule), std::make_shared<TurnAroundRule>()},
+      {typeid(PitchUpRule), std::make_shared<PitchUpRule>()},
+      {typeid(PitchDownRule), std::make_shared<PitchDownRule>()},
+      {typeid(RollLeftRule), std::make_shared<RollLeftRule>()},
+      {typeid(RollRightRule), std::make_shared<RollRightRule>()},
+      {typeid(IncrementRule), std::make_shared<IncrementRule>()},
+      {typeid(DecrementRule), std::make_shared<DecrementRule>()},
+      {typeid(SwitchStyleRule), std::make_shared<SwitchStyleRule>()},
+      {typeid(ScaleUpRule), std::make_shared<ScaleUpRule>()},
+      {typeid(ScaleDownRule), std::make_shared<ScaleDownRule>()},
+      {typeid(SaveRule), std::make_shared<SaveRule>()},
+      {typeid(RestoreRule), std::make_shared<RestoreRule>()},
+  };
+  return rules;
+}
+
+/// Gets hash of given content.
+std::string getHash(const std::string &content) {
+  return MD5(content).hexdigest();
+}
+
+/// Gets hash of file content or empty string if file cannot be read.
+std::string getFileHash(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.good())
+    return "";
+  return getHash(std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+}
+
+class Writer final {
+ public:
+  explicit Writer(std::ostream &stream) : stream_(stream) {}
+
+  template<typename T>
+  void write(T value) {
+    stream_.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void write(const std::string &value) {
+    write(static_cast<std::uint32_t>(value.size()));
+    stream_.write(value.data(), value.size());
+  }
+
+  void write(const StyleSheet &stylesheet) {
+    write(static_cast<std::uint32_t>(stylesheet.rules.size()));
+    for (const auto &rule : stylesheet.rules)
+      write(rule);
+
+    write(static_cast<std::uint32_t>(stylesheet.textures.size()));
+    for (const auto &texture : stylesheet.textures)
+      write(texture);
+
+    write(static_cast<std::uint32_t>(stylesheet.lsystems.size()));
+    for (const auto &lsystem : stylesheet.lsystems) {
+      write(lsystem.first);
+      write(lsystem.second);
+    }
+
+    writeCompiled(stylesheet);
+  }
+
+ private:
+  void write(const utymap::mapcss::Rule &rule) {
+    write(static_cast<std::uint32_t>(rule.selectors.size()));
+    for (const auto &selector : rule.selectors) {
+      write(static_cast<std::uint32_t>(selector.names.size()));
+      for (const auto &name : selector.names)
+        write(name);
+      write(selector.zoom.start);
+      write(selector.zoom.end);
+      write(static_cast<std::uint32_t>(selector.conditions.size()));
+      for (const auto &condition : selector.conditions) {
+        write(condition.key);
+        write(condition.operation);
+        write(condition.value);
+      }
+    }
+
+    write(static_cast<std::uint32_t>(rule.declarations.size()));
+    for (const auto &declaration : rule.declarations) {
+      write(declaration.key);
+      write(declaration.value);
+    }
+  }
+
+  void write(const TextureAtlas &atlas) {
+    write(atlas.index());
+    write(static_cast<std::uint32_t>(atlas.groups().size()));
+    for (const auto &group : atlas.groups()) {
+      write(group.first);
+      write(static_cast<std::uint32_t>(group.second.regions().size()));
+      for (const auto &region : group.second.regions()) {
+        write(region.atlasWidth);
+        write(region.atlasHeight);
+        write(region.x);
+        write(region.y);
+        write(region.width);
+        write(region.height);
+      }
+    }
+  }
+
+  void write(const LSystem &lsystem) {
+    write(static_cast<std::int32_t>(lsystem.generations));
+    write(lsystem.angle);
+    write(lsystem.scale);
+    write(lsystem.axiom);
+    write(static_cast<std::uint32_t>(lsystem.productions.size()));
+    for (const auto &production : lsystem.productions) {
+      write(*production.first);
+      write(static_cast<std::uint32_t>(production.second.size()));
+      for (const auto &rules : production.second) {
+        write(rules.first);
+        write(rules.second);
+      }
+    }
+  }
+
+  void write(const LSystem::Rules &rules) {
+    write(static_cast<std::uint32_t>(rules.size()));
+    for (const auto &rule : rules)
+      write(*rule);
+  }
+
+  void write(const utymap::lsys::Rule &rule) {
+    const auto &rules = getRules();
+    const auto type = std::type_index(typeid(rule));
+    if (type==std::type_index(typeid(WordRule))) {
+      write(WordRuleCode);
+      write(static_cast<const WordRule &>(rule).word);
+      return;
+    }
+
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+      if (rules[i].first==type) {
+        write(static_cast<std::uint8_t>(i + 1));
+        return;
+      }
+    }
+    throw std::domain_error("Unknown lsystem rule.");
+  }
+
+  /// Writes expressions and gradients compiled from declaration values.
+  void writeCompiled(const StyleSheet &stylesheet) {
+    std::unordered_map<std::string, std::unique_ptr<Program>> expressions;
+    std::unordered_map<std::string, ColorGradient::GradientData> gradients;
+    for (const auto &rule : stylesheet.rules) {
+      for (const auto &declaration : rule.declarations) {
+        const auto &value = declaration.value;
+        if (utymap::utils::GradientUtils::isGradient(value)) {
+          if (gradients.find(value)==gradients.end())
+            gradients.emplace(value, utymap::utils::GradientUtils::parseGradient(value)->data());
+        } else if (expressions.find(value)==expressions.end()) {
+          auto tree = StyleEvaluator::parse(value);
+          if (tree!=nullptr)
+            expressions.emplace(value, StyleEvaluator::compile(*tree));
+        }
+      }
+    }
+
+    write(static_cast<std::uint32_t>(expressions.size()));
+    for (const auto &expression : expressions) {
+      write(expression.first);
+      write(expression.second->instructions);
+      write(expression.second->numeric);
+    }
+
+    write(static_cast<std::uint32_t>(gradients.size()));
+    for (const auto &gradient : gradients) {
+      write(gradient.first);
+      write(static_cast<std::uint32_t>(gradient.second.size()));
+      for (const auto &stop : gradient.second) {
+        write(stop.first);
+        write(stop.second.r);
+        write(stop.second.g);
+        write(stop.second.b);
+        write(stop.second.a);
+      }
+    }
+  }
+
+  void write(const std::vector<Program::Instruction> &instructions) {
+    write(static_cast<std::uint32_t>(instructions.size()));
+    for (const auto &instruction : instructions) {
+      write(instruction.operator_);
+      write(static_cast<std::uint8_t>(instruction.kind));
+      write(static_cast<std::uint8_t>(instruction.isSigned));
+      write(instruction.sign);
+      write(instruction.number);
+      write(instruction.text);
+    }
+  }
+
+  std::ostream &stream_;
+};
+
+class Reader final {
+ public:
+  explicit Reader(std::istream &stream) : stream_(stream) {}
+
+  template<typename T>
+  T read() {
+    T value = T();
+    stream_.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return value;
+  }
+
+  std::string readString() {
+    auto size = read<std::uint32_t>();
+    if (!stream_.good() || size > MaxStringSize) {
+      stream_.setstate(std::ios::failbit);
+      return "";
+    }
+    std::string value(size, '\0');
+    stream_.read(&value[0], size);
+    return value;
+  }
+
+  /// Returns amount of items to read or zero if stream is broken.
+  std::uint32_t readCount() {
+    auto count = read<std::uint32_t>();
+    return stream_.good() ? count : 0;
+  }
+
+  void read(StyleSheet &stylesheet) {
+    stylesheet.rules.resize(readCount());
+    for (auto &rule : stylesheet.rules)
+      read(rule);
+
+    for (std::uint32_t i = readCount(); i > 0; --i)
+      stylesheet.textures.push_back(readAtlas());
+
+    for (std::uint32_t i = readCount(); i > 0; --i) {
+      auto name = readString();
+      stylesheet.lsystems.emplace(name, readLSystem());
+    }
+
+    for (std::uint32_t i = readCount(); i > 0; --i) {
+      auto value = readString();
+      auto program = std::make_shared<Program>();
+      program->instructions = readInstructions();
+      program->numeric = readInstructions();
+      stylesheet.expressions.emplace(value, program);
+    }
+
+    for (std::uint32_t i = readCount(); i > 0; --i) {
+      auto value = readString();
+      auto &data = stylesheet.gradients[value];
+      for (std::uint32_t j = readCount(); j > 0; --j) {
+        auto time = read<double>();
+        auto r = read<unsigned char>();
+        auto g = read<unsigned char>();
+        auto b = read<unsigned char>();
+        auto a = read<unsigned char>();
+        data.emplace_back(time, Color(r, g, b, a));
+      }
+    }
+  }
+
+ private:
+  void read(utymap::mapcss::Rule &rule) {
+    rule.selectors.resize(readCount());
+    for (auto &selector : rule.selectors) {
+      for (std::uint32_t i = readCount(); i > 0; --i)
+        selector.names.push_back(readString());
+      selector.zoom.start = read<std::uint8_t>();
+      selector.zoom.end = read<std::uint8_t>();
+      selector.conditions.resize(readCount());
+      for (auto &condition : selector.conditions) {
+        condition.key = readString();
+        condition.operation = readString();
+        condition.value = readString();
+      }
+    }
+
+    rule.declarations.resize(readCount());
+    for (auto &declaration : rule.declarations) {
+      declaration.key = readString();
+      declaration.value = readString();
+    }
+  }
+
+  TextureAtlas readAtlas() {
+    auto index = read<std::uint16_t>();
+    TextureAtlas::Groups groups;
+    for (std::uint32_t i = readCount(); i > 0; --i) {
+      auto &group = groups[readString()];
+      for (std::uint32_t j = readCount(); j > 0; --j) {
+        auto atlasWidth = read<std::uint16_t>();
+        auto atlasHeight = read<std::uint16_t>();
+        auto x = read<std::uint16_t>();
+        auto y = read<std::uint16_t>();
+        auto width = read<std::uint16_t>();
+        auto height = read<std::uint16_t>();
+        group.add(TextureRegion(atlasWidth, atlasHeight, x, y, width, height));
+      }
+    }
+    return TextureAtlas(index, groups);
+  }
+
+  LSystem readLSystem() {
+    LSystem lsystem;
+    lsystem.generations = read<std::int32_t>();
+    lsystem.angle = read<double>();
+    lsystem.scale = read<double>();
+    lsystem.axiom = readRules();
+    for (std::uint32_t i = readCount(); i > 0; --i) {
+      auto &productions = lsystem.productions[readRule()];
+      for (std::uint32_t j = readCount(); j > 0; --j) {
+        auto probability = read<double>();
+        productions.emplace_back(probability, readRules());
+      }
+    }
+    return lsystem;
+  }
+
+  LSystem::Rules readRules() {
+    LSystem::Rules rules;
+    for (std::uint32_t i = readCount(); i > 0; --i)
+      rules.push_back(readRule());
+    return rules;
+  }
+
+  LSystem::RuleType readRule() {
+    const auto &rules = getRules();
+    auto code = read<std::uint8_t>();
+    if (code==WordRuleCode)
+      return std::make_shared<WordRule>(readString());
+    if (code > rules.size()) {
+      stream_.setstate(std::ios::failbit);
+      return rules.front().second;
+    }
+    return rules[code - 1].second;
+  }
+
+  std::vector<Program::Instruction> readInstructions() {
+    std::vector<Program::Instruction> instructions;
+    for (std::uint32_t i = readCount(); i > 0; --i) {
+      Program::Instruction instruction;
+      instruction.operator_ = read<char>();
+      instruction.kind = static_cast<Program::Kind>(read<std::uint8_t>());
+      instruction.isSigned = read<std::uint8_t>()!=0;
+      instruction.isResolved = false;
+      instruction.sign = read<double>();
+      instruction.number = read<double>();
+      instruction.text = readString();
+      instruction.keyId = 0;
+      instructions.push_back(instruction);
+    }
+    return instructions;
+  }
+
+  std::istream &stream_;
+};
+}
+
+bool StyleSheetStream::read(std::istream &stream, const std::string &content, StyleSheet &stylesheet) {
+  Reader reader(stream);
+  char magic[sizeof(Magic)];
+  stream.read(magic, sizeof(Magic));
+  if (!stream.good() || std::memcmp(magic, Magic, sizeof(Magic))!=0 || reader.read<std::uint16_t>()!=Version)
+    return false;
+
+  if (reader.readString()!=getHash(content))
+    return false;
+
+  StyleSheet result;
+  for (std::uint32_t i = reader.readCount(); i > 0; --i) {
+    auto path = reader.readString();
+    if (!stream.good() || reader.readString()!=getFileHash(path))
+      return false;
+    result.sources.push_back(path);
+  }
+
+  reader.read(result);
+  if (!stream.good())
+    return false;
+
+  stylesheet = std::move(result);
+  return true;
+}
+
+void StyleSheetStream::write(std::ostream &stream, const std::string &content, const StyleSheet &stylesheet) {
+  Writer writer(stream);
+  stream.write(Magic, sizeof(Magic));
+  writer.write(Version);
+  writer.write(getHash(content));
+
+  writer.write(static_cast<std::uint32_t>(stylesheet.sources.size()));
+  for (const auto &path : stylesheet.sources) {
+    writer.write(path);
+    writer.write(getFileHash(path));
+  }
+
+  writer.write(stylesheet);
+}
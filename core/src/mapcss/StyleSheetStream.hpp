@@ -0,0 +1,28 @@
+#ifndef MAPCSS_STYLESHEETSTREAM_HPP_DEFINED
+#define MAPCSS_STYLESHEETSTREAM_HPP_DEFINED
+
+#include "mapcss/StyleSheet.hpp"
+
+#include <iostream>
+#include <string>
+
+namespace utymap {
+namespace mapcss {
+
+/// Provides the way to store compiled stylesheet in binary form and restore it back without
+/// parsing mapcss, texture atlases and lsystems again.
+/// NOTE stored stylesheet is keyed by hash of its mapcss content and of all imported files.
+class StyleSheetStream final {
+ public:
+  /// Reads stylesheet compiled from given mapcss content.
+  /// Returns false if stream is not valid or sources have changed since it was written.
+  static bool read(std::istream &stream, const std::string &content, StyleSheet &stylesheet);
+
+  /// Writes stylesheet parsed from given mapcss content with its expressions and gradients compiled.
+  static void write(std::ostream &stream, const std::string &content, const StyleSheet &stylesheet);
+};
+
+}
+}
+
+#endif // MAPCSS_STYLESHEETSTREAM_HPP_DEFINED
@@ -0,0 +1,107 @@
+#ifndef MAPCSS_STYLESTATISTICS_HPP_DEFINED
+#define MAPCSS_STYLESTATISTICS_HPP_DEFINED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace utymap {
+namespace mapcss {
+
+/// Collects usage of mapcss rules and time spent on styling per level of details. It is updated
+/// concurrently by all threads which request styles, so time is summed over threads.
+class StyleStatistics final {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Counters of one condition rule.
+  struct Rule {
+    /// Amount of times conditions of rule were checked.
+    std::atomic<std::uint64_t> evaluations;
+    /// Amount of times conditions of rule were satisfied.
+    std::atomic<std::uint64_t> matches;
+    /// Amount of elements styled by rule including ones which got cached style.
+    std::atomic<std::uint64_t> elements;
+  };
+
+  /// Counters of one level of details.
+  struct Level {
+    /// Amount of element styles requested.
+    std::atomic<std::uint64_t> elements;
+    /// Amount of styles built by matching rules.
+    std::atomic<std::uint64_t> matches;
+    /// Amount of evaluated expressions.
+    std::atomic<std::uint64_t> evaluations;
+
+    void addMatchTime(Clock::duration duration) {
+      matches.fetch_add(1, std::memory_order_relaxed);
+      matchTime_.fetch_add(toNanoseconds(duration), std::memory_order_relaxed);
+    }
+
+    void addEvaluationTime(Clock::duration duration) {
+      evaluations.fetch_add(1, std::memory_order_relaxed);
+      evaluationTime_.fetch_add(toNanoseconds(duration), std::memory_order_relaxed);
+    }
+
+    /// Gets time of rule matching in seconds.
+    double matchTime() const { return matchTime_/1e9; }
+
+    /// Gets time of expression evaluation in seconds.
+    double evaluationTime() const { return evaluationTime_/1e9; }
+
+   private:
+    friend class StyleStatistics;
+
+    static std::int64_t toNanoseconds(Clock::duration duration) {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+
+    std::atomic<std::int64_t> matchTime_;
+    std::atomic<std::int64_t> evaluationTime_;
+  };
+
+  StyleStatistics(std::size_t levelCount, std::size_t ruleCount) :
+      levels_(new Level[levelCount]), rules_(new Rule[ruleCount]),
+      levelCount_(levelCount), ruleCount_(ruleCount) {
+    reset();
+  }
+
+  /// Gets counters of given level of details.
+  Level &level(int levelOfDetail) { return levels_[levelOfDetail]; }
+  const Level &level(int levelOfDetail) const { return levels_[levelOfDetail]; }
+
+  /// Gets counters of rule with given index.
+  Rule &rule(std::uint32_t index) { return rules_[index]; }
+  const Rule &rule(std::uint32_t index) const { return rules_[index]; }
+
+  std::size_t levelCount() const { return levelCount_; }
+
+  /// Sets all counters to zero.
+  /// NOTE counters updated concurrently might be not reset.
+  void reset() {
+    for (std::size_t i = 0; i < levelCount_; ++i) {
+      levels_[i].elements = 0;
+      levels_[i].matches = 0;
+      levels_[i].evaluations = 0;
+      levels_[i].matchTime_ = 0;
+      levels_[i].evaluationTime_ = 0;
+    }
+    for (std::size_t i = 0; i < ruleCount_; ++i) {
+      rules_[i].evaluations = 0;
+      rules_[i].matches = 0;
+      rules_[i].elements = 0;
+    }
+  }
+
+ private:
+  std::unique_ptr<Level[]> levels_;
+  std::unique_ptr<Rule[]> rules_;
+  std::size_t levelCount_;
+  std::size_t ruleCount_;
+};
+
+}
+}
+
+#endif // MAPCSS_STYLESTATISTICS_HPP_DEFINED
@@ -0,0 +1,437 @@
+#ifndef MATH_EARCLIPPER_HPP_DEFINED
+#define MATH_EARCLIPPER_HPP_DEFINED
+
+#include "math/Polygon.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <vector>
+
+namespace utymap {
+namespace math {
+
+/// Triangulates polygon with holes by ear clipping. Holes are bridged to their outer
+/// contour, so no new points are introduced. It is much faster than constrained Delaunay
+/// triangulation for small polygons, but it does not refine mesh.
+/// NOTE instance keeps its buffers between calls, so it should be reused, but not shared between threads.
+class EarClipper final {
+  struct Node {
+    int i;
+    double x, y;
+    Node *prev, *next;
+    bool steiner;
+  };
+
+ public:
+  /// Triangulates polygon and writes indices of counterclockwise triangles into given buffer.
+  /// Returns false if polygon cannot be triangulated reliably, e.g. contours intersect.
+  bool triangulate(const Polygon &polygon, std::vector<int> &indices) {
+    indices.clear();
+    if (polygon.outers.empty())
+      return false;
+
+    const auto &points = polygon.points;
+    std::vector<std::vector<const Polygon::Range *>> holesByOuter(polygon.outers.size());
+    for (const auto &inner : polygon.inners) {
+      if (inner.second - inner.first < 6)
+        continue;
+      std::size_t outerIndex = polygon.outers.size();
+      for (std::size_t j = 0; j < polygon.outers.size(); ++j) {
+        if (contains(points, polygon.outers[j], points[inner.first], points[inner.first + 1])) {
+          outerIndex = j;
+          break;
+        }
+      }
+      if (outerIndex==polygon.outers.size())
+        return false;
+      holesByOuter[outerIndex].push_back(&inner);
+    }
+
+    for (std::size_t j = 0; j < polygon.outers.size(); ++j) {
+      const auto &outer = polygon.outers[j];
+      if (outer.second - outer.first < 6)
+        continue;
+
+      std::size_t start = indices.size();
+      nodes_.clear();
+      Node *outerNode = linkedList(points, outer, true);
+      if (outerNode==nullptr || outerNode->next==outerNode->prev)
+        continue;
+
+      double expectedArea = std::abs(signedArea(points, outer));
+      if (!holesByOuter[j].empty())
+        outerNode = eliminateHoles(points, holesByOuter[j], outerNode, expectedArea);
+
+      earcutLinked(outerNode, indices, 0);
+
+      if (!orientAndCheck(points, indices, start, expectedArea))
+        return false;
+    }
+
+    return !indices.empty();
+  }
+
+ private:
+  /// Relative tolerance of difference between area of triangles and area of polygon.
+  static constexpr double AreaTolerance = 1E-6;
+
+  std::deque<Node> nodes_;
+  std::vector<Node *> queue_;
+
+  /// Makes triangles counterclockwise and checks that they cover polygon area exactly.
+  static bool orientAndCheck(const std::vector<double> &points, std::vector<int> &indices,
+                             std::size_t start, double expectedArea) {
+    double area = 0;
+    for (std::size_t i = start; i < indices.size(); i += 3) {
+      double ax = points[indices[i]*2], ay = points[indices[i]*2 + 1];
+      double bx = points[indices[i + 1]*2], by = points[indices[i + 1]*2 + 1];
+      double cx = points[indices[i + 2]*2], cy = points[indices[i + 2]*2 + 1];
+      double doubleArea = (bx - ax)*(cy - ay) - (by - ay)*(cx - ax);
+      if (doubleArea < 0)
+        std::swap(indices[i + 1], indices[i + 2]);
+      area += std::abs(doubleArea)/2;
+    }
+    return std::abs(area - expectedArea) <= AreaTolerance*expectedArea;
+  }
+
+  static double signedArea(const std::vector<double> &points, const Polygon::Range &range) {
+    double sum = 0;
+    for (std::size_t i = range.first, j = range.second - 2; i < range.second; j = i, i += 2)
+      sum += (points[j] - points[i])*(points[i + 1] + points[j + 1]);
+    return sum/2;
+  }
+
+  static bool contains(const std::vector<double> &points, const Polygon::Range &range, double x, double y) {
+    bool inside = false;
+    for (std::size_t i = range.first, j = range.second - 2; i < range.second; j = i, i += 2) {
+      double xi = points[i], yi = points[i + 1], xj = points[j], yj = points[j + 1];
+      if ((yi > y)!=(yj > y) && x < (xj - xi)*(y - yi)/(yj - yi) + xi)
+        inside = !inside;
+    }
+    return inside;
+  }
+
+  Node *insertNode(int i, double x, double y, Node *last) {
+    nodes_.push_back(Node{i, x, y, nullptr, nullptr, false});
+    Node *p = &nodes_.back();
+    if (last==nullptr) {
+      p->prev = p;
+      p->next = p;
+    } else {
+      p->next = last->next;
+      p->prev = last;
+      last->next->prev = p;
+      last->next = p;
+    }
+    return p;
+  }
+
+  static void removeNode(Node *p) {
+    p->next->prev = p->prev;
+    p->prev->next = p->next;
+  }
+
+  /// Creates circular linked list from contour in given orientation.
+  Node *linkedList(const std::vector<double> &points, const Polygon::Range &range, bool clockwise) {
+    Node *last = nullptr;
+    if (clockwise==(signedArea(points, range) > 0)) {
+      for (std::size_t i = range.first; i < range.second; i += 2)
+        last = insertNode(static_cast<int>(i/2), points[i], points[i + 1], last);
+    } else {
+      for (std::size_t i = range.second; i > range.first; i -= 2)
+        last = insertNode(static_cast<int>(i/2 - 1), points[i - 2], points[i - 1], last);
+    }
+
+    if (last!=nullptr && equals(last, last->next)) {
+      removeNode(last);
+      last = last->next;
+    }
+    return last;
+  }
+
+  /// Removes duplicate and collinear points.
+  static Node *filterPoints(Node *start, Node *end = nullptr) {
+    if (start==nullptr) return start;
+    if (end==nullptr) end = start;
+
+    Node *p = start;
+    bool again;
+    do {
+      again = false;
+      if (!p->steiner && (equals(p, p->next) || area(p->prev, p, p->next)==0)) {
+        removeNode(p);
+        p = end = p->prev;
+        if (p==p->next) break;
+        again = true;
+      } else {
+        p = p->next;
+      }
+    } while (again || p!=end);
+    return end;
+  }
+
+  /// Main ear slicing loop which triangulates polygon given as linked list.
+  void earcutLinked(Node *ear, std::vector<int> &indices, int pass) {
+    if (ear==nullptr) return;
+
+    Node *stop = ear;
+    while (ear->prev!=ear->next) {
+      Node *prev = ear->prev;
+      Node *next = ear->next;
+
+      if (isEar(ear)) {
+        indices.push_back(prev->i);
+        indices.push_back(ear->i);
+        indices.push_back(next->i);
+        removeNode(ear);
+        ear = next->next;
+        stop = next->next;
+        continue;
+      }
+
+      ear = next;
+      if (ear==stop) {
+        // try filtering points and slicing again, then fix self intersections, then split polygon.
+        if (pass==0)
+          earcutLinked(filterPoints(ear), indices, 1);
+        else if (pass==1)
+          earcutLinked(cureLocalIntersections(filterPoints(ear), indices), indices, 2);
+        else
+          splitEarcut(ear, indices);
+        break;
+      }
+    }
+  }
+
+  static bool isEar(const Node *ear) {
+    const Node *a = ear->prev, *b = ear, *c = ear->next;
+    if (area(a, b, c) >= 0) return false; // reflex
+
+    for (const Node *p = c->next; p!=a; p = p->next) {
+      if (pointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) && area(p->prev, p, p->next) >= 0)
+        return false;
+    }
+    return true;
+  }
+
+  static Node *cureLocalIntersections(Node *start, std::vector<int> &indices) {
+    Node *p = start;
+    do {
+      Node *a = p->prev, *b = p->next->next;
+      if (!equals(a, b) && intersects(a, p, p->next, b) && locallyInside(a, b) && locallyInside(b, a)) {
+        indices.push_back(a->i);
+        indices.push_back(p->i);
+        indices.push_back(b->i);
+        removeNode(p);
+        removeNode(p->next);
+        p = start = b;
+      }
+      p = p->next;
+    } while (p!=start);
+    return filterPoints(p);
+  }
+
+  void splitEarcut(Node *start, std::vector<int> &indices) {
+    Node *a = start;
+    do {
+      for (Node *b = a->next->next; b!=a->prev; b = b->next) {
+        if (a->i!=b->i && isValidDiagonal(a, b)) {
+          Node *c = splitPolygon(a, b);
+          a = filterPoints(a, a->next);
+          c = filterPoints(c, c->next);
+          earcutLinked(a, indices, 0);
+          earcutLinked(c, indices, 0);
+          return;
+        }
+      }
+      a = a->next;
+    } while (a!=start);
+  }
+
+  /// Links holes into outer contour.
+  Node *eliminateHoles(const std::vector<double> &points, const std::vector<const Polygon::Range *> &holes,
+                       Node *outerNode, double &expectedArea) {
+    queue_.clear();
+    for (const auto *hole : holes) {
+      Node *list = linkedList(points, *hole, false);
+      if (list==nullptr) continue;
+      if (list==list->next) list->steiner = true;
+      expectedArea -= std::abs(signedArea(points, *hole));
+      queue_.push_back(getLeftmost(list));
+    }
+
+    std::sort(queue_.begin(), queue_.end(), [](const Node *a, const Node *b) { return a->x < b->x; });
+    for (Node *hole : queue_)
+      outerNode = eliminateHole(hole, outerNode);
+    return outerNode;
+  }
+
+  Node *eliminateHole(Node *hole, Node *outerNode) {
+    Node *bridge = findHoleBridge(hole, outerNode);
+    if (bridge==nullptr) return outerNode;
+
+    Node *bridgeReverse = splitPolygon(bridge, hole);
+    filterPoints(bridgeReverse, bridgeReverse->next);
+    return filterPoints(bridge, bridge->next);
+  }
+
+  /// Finds outer contour vertex which can be connected with hole's leftmost vertex (David Eberly's algorithm).
+  static Node *findHoleBridge(const Node *hole, Node *outerNode) {
+    Node *p = outerNode;
+    double hx = hole->x, hy = hole->y;
+    double qx = -std::numeric_limits<double>::infinity();
+    Node *m = nullptr;
+
+    do {
+      if (hy <= p->y && hy >= p->next->y && p->next->y!=p->y) {
+        double x = p->x + (hy - p->y)*(p->next->x - p->x)/(p->next->y - p->y);
+        if (x <= hx && x > qx) {
+          qx = x;
+          m = p->x < p->next->x ? p : p->next;
+          if (x==hx) return m;
+        }
+      }
+      p = p->next;
+    } while (p!=outerNode);
+
+    if (m==nullptr) return nullptr;
+
+    // look for points inside the triangle of hole point, segment intersection and endpoint.
+    const Node *stop = m;
+    double mx = m->x, my = m->y;
+    double tanMin = std::numeric_limits<double>::infinity();
+    p = m;
+    do {
+      if (hx >= p->x && p->x >= mx && hx!=p->x &&
+          pointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+        double tan = std::abs(hy - p->y)/(hx - p->x);
+        if (locallyInside(p, hole) &&
+            (tan < tanMin || (tan==tanMin && (p->x > m->x || (p->x==m->x && sectorContainsSector(m, p)))))) {
+          m = p;
+          tanMin = tan;
+        }
+      }
+      p = p->next;
+    } while (p!=stop);
+
+    return m;
+  }
+
+  static bool sectorContainsSector(const Node *m, const Node *p) {
+    return area(m->prev, m, p->prev) < 0 && area(p->next, m, m->next) < 0;
+  }
+
+  static Node *getLeftmost(Node *start) {
+    Node *p = start, *leftmost = start;
+    do {
+      if (p->x < leftmost->x || (p->x==leftmost->x && p->y < leftmost->y))
+        leftmost = p;
+      p = p->next;
+    } while (p!=start);
+    return leftmost;
+  }
+
+  static bool pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy,
+                              double px, double py) {
+    return (cx - px)*(ay - py) >= (ax - px)*(cy - py) &&
+        (ax - px)*(by - py) >= (bx - px)*(ay - py) &&
+        (bx - px)*(cy - py) >= (cx - px)*(by - py);
+  }
+
+  static bool isValidDiagonal(const Node *a, const Node *b) {
+    return a->next->i!=b->i && a->prev->i!=b->i && !intersectsPolygon(a, b) &&
+        ((locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b) &&
+            (area(a->prev, a, b->prev)!=0 || area(a, b->prev, b)!=0)) ||
+            (equals(a, b) && area(a->prev, a, a->next) > 0 && area(b->prev, b, b->next) > 0));
+  }
+
+  static double area(const Node *p, const Node *q, const Node *r) {
+    return (q->y - p->y)*(r->x - q->x) - (q->x - p->x)*(r->y - q->y);
+  }
+
+  static bool equals(const Node *a, const Node *b) {
+    return a->x==b->x && a->y==b->y;
+  }
+
+  static int sign(double value) {
+    return value > 0 ? 1 : (value < 0 ? -1 : 0);
+  }
+
+  static bool onSegment(const Node *p, const Node *q, const Node *r) {
+    return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) &&
+        q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+  }
+
+  static bool intersects(const Node *p1, const Node *q1, const Node *p2, const Node *q2) {
+    int o1 = sign(area(p1, q1, p2));
+    int o2 = sign(area(p1, q1, q2));
+    int o3 = sign(area(p2, q2, p1));
+    int o4 = sign(area(p2, q2, q1));
+
+    if (o1!=o2 && o3!=o4) return true;
+    if (o1==0 && onSegment(p1, p2, q1)) return true;
+    if (o2==0 && onSegment(p1, q2, q1)) return true;
+    if (o3==0 && onSegment(p2, p1, q2)) return true;
+    if (o4==0 && onSegment(p2, q1, q2)) return true;
+    return false;
+  }
+
+  static bool intersectsPolygon(const Node *a, const Node *b) {
+    const Node *p = a;
+    do {
+      if (p->i!=a->i && p->next->i!=a->i && p->i!=b->i && p->next->i!=b->i && intersects(p, p->next, a, b))
+        return true;
+      p = p->next;
+    } while (p!=a);
+    return false;
+  }
+
+  static bool locallyInside(const Node *a, const Node *b) {
+    return area(a->prev, a, a->next) < 0
+           ? area(a, b, a->next) >= 0 && area(a, a->prev, b) >= 0
+           : area(a, b, a->prev) < 0 || area(a, a->next, b) < 0;
+  }
+
+  static bool middleInside(const Node *a, const Node *b) {
+    const Node *p = a;
+    bool inside = false;
+    double px = (a->x + b->x)/2, py = (a->y + b->y)/2;
+    do {
+      if ((p->y > py)!=(p->next->y > py) && p->next->y!=p->y &&
+          px < (p->next->x - p->x)*(py - p->y)/(p->next->y - p->y) + p->x)
+        inside = !inside;
+      p = p->next;
+    } while (p!=a);
+    return inside;
+  }
+
+  Node *splitPolygon(Node *a, Node *b) {
+    nodes_.push_back(Node{a->i, a->x, a->y, nullptr, nullptr, false});
+    Node *a2 = &nodes_.back();
+    nodes_.push_back(Node{b->i, b->x, b->y, nullptr, nullptr, false});
+    Node *b2 = &nodes_.back();
+    Node *an = a->next, *bp = b->prev;
+
+    a->next = b;
+    b->prev = a;
+
+    a2->next = an;
+    an->prev = a2;
+
+    b2->next = a2;
+    a2->prev = b2;
+
+    bp->next = b2;
+    b2->prev = bp;
+
+    return b2;
+  }
+};
+
+}
+}
+
+#endif // MATH_EARCLIPPER_HPP_DEFINED
@@ -0,0 +1,41 @@
+#ifndef MATH_FIXEDPOINT_HPP_DEFINED
+#define MATH_FIXEDPOINT_HPP_DEFINED
+
+#include "GeoCoordinate.hpp"
+#include "math/PolyClip.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+namespace utymap {
+namespace math {
+
+/// Scale of fixed point coordinate: 1e-7 degree (~1cm) which is precision of osm data.
+/// NOTE the same scale is used by storage, clipping and terrain, so coordinate which
+/// passes through all of them is quantized only once.
+const double FixedPointScale = 1E7;
+
+/// Converts degrees to fixed point value using rounding to nearest.
+inline std::int32_t toFixed(double value) {
+  return static_cast<std::int32_t>(std::lround(value*FixedPointScale));
+}
+
+/// Converts fixed point value to degrees.
+inline double fromFixed(cInt value) {
+  return value/FixedPointScale;
+}
+
+/// Converts coordinate to clipper's point: x is longitude, y is latitude.
+inline IntPoint toIntPoint(const GeoCoordinate &coordinate) {
+  return IntPoint(toFixed(coordinate.longitude), toFixed(coordinate.latitude));
+}
+
+/// Converts clipper's point back to coordinate.
+inline GeoCoordinate toGeoCoordinate(const IntPoint &point) {
+  return GeoCoordinate(fromFixed(point.Y), fromFixed(point.X));
+}
+
+}
+}
+
+#endif // MATH_FIXEDPOINT_HPP_DEFINED
@@ -17,12 +17,17 @@ struct Mesh final {
   std::vector<double> uvs;
   std::vector<int> uvMap;
 
+  /// Creates empty mesh which buffers grow on demand.
   explicit Mesh(const std::string &name) : name(name) {
-    vertices.reserve(4096);
-    triangles.reserve(4096);
-    colors.reserve(4096);
-    uvs.reserve(4096);
-    uvMap.reserve(128);
+  }
+
+  /// Creates mesh which keeps given amount of vertices without reallocation.
+  /// NOTE about one triangle per vertex is expected.
+  Mesh(const std::string &name, std::size_t vertexCount) : name(name) {
+    vertices.reserve(3*vertexCount);
+    triangles.reserve(3*vertexCount);
+    colors.reserve(vertexCount);
+    uvs.reserve(2*vertexCount);
   }
 
   Mesh(Mesh &&other) :
@@ -0,0 +1,281 @@
+#ifndef MATH_MESHSIMPLIFIER_HPP_DEFINED
+#define MATH_MESHSIMPLIFIER_HPP_DEFINED
+
+#include "math/Mesh.hpp"
+#include "math/Vector3.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace utymap {
+namespace math {
+
+/// Reduces amount of triangles by collapsing edges in order of quadric error metric
+/// (Garland and Heckbert). Vertex is always moved into the other end of edge, so colors
+/// and texture coordinates of remaining vertices stay valid.
+/// NOTE boundary vertices are never moved: tile borders and texture seams are preserved.
+/// NOTE instance keeps its buffers between calls, so it should be reused, but not shared between threads.
+class MeshSimplifier final {
+  /// Symmetric 4x4 matrix stored as upper triangle.
+  typedef std::array<double, 10> Quadric;
+
+  struct Candidate {
+    double cost;
+    int from, to;
+    std::uint32_t fromStamp, toStamp;
+
+    bool operator>(const Candidate &other) const { return cost > other.cost; }
+  };
+
+ public:
+  /// Writes simplified source mesh into destination. Collapse is done only if distance
+  /// between moved vertex and planes of original triangles stays within max error.
+  /// Vertex coordinates are multiplied by scale to get the same units on all axes.
+  void simplify(const Mesh &source, Mesh &destination, double maxError,
+                const Vector3 &scale = Vector3(1, 1, 1)) {
+    std::size_t vertexCount = source.vertices.size()/3;
+    if (maxError <= 0 || source.triangles.size() < 3) {
+      copy(source, destination, std::vector<int>(), false);
+      return;
+    }
+
+    build(source, scale);
+    collapse(maxError*maxError);
+
+    std::vector<int> remap(vertexCount, -1);
+    for (std::size_t t = 0; t < triangles_.size(); ++t) {
+      if (removed_[t]) continue;
+      for (int index : triangles_[t])
+        remap[index] = 0;
+    }
+    int next = 0;
+    for (auto &index : remap)
+      if (index==0) index = next++;
+
+    copy(source, destination, remap, true);
+  }
+
+ private:
+  void build(const Mesh &source, const Vector3 &scale) {
+    std::size_t vertexCount = source.vertices.size()/3;
+    positions_.resize(vertexCount);
+    quadrics_.assign(vertexCount, Quadric());
+    vertexTriangles_.assign(vertexCount, std::vector<int>());
+    stamps_.assign(vertexCount, 0);
+    locked_.assign(vertexCount, false);
+    triangles_.clear();
+    removed_.clear();
+
+    for (std::size_t i = 0; i < vertexCount; ++i)
+      positions_[i] = Vector3(source.vertices[i*3]*scale.x,
+                              source.vertices[i*3 + 1]*scale.y,
+                              source.vertices[i*3 + 2]*scale.z);
+
+    std::unordered_map<std::uint64_t, int> edges(source.triangles.size());
+    for (std::size_t i = 0; i + 2 < source.triangles.size(); i += 3) {
+      std::array<int, 3> triangle {source.triangles[i], source.triangles[i + 1], source.triangles[i + 2]};
+      int index = static_cast<int>(triangles_.size());
+      triangles_.push_back(triangle);
+      removed_.push_back(false);
+
+      const auto &p0 = positions_[triangle[0]];
+      auto normal = Vector3::cross(positions_[triangle[1]] - p0, positions_[triangle[2]] - p0).normalized();
+      double d = -Vector3::dot(normal, p0);
+      for (int j = 0; j < 3; ++j) {
+        addPlane(quadrics_[triangle[j]], normal, d);
+        vertexTriangles_[triangle[j]].push_back(index);
+        ++edges[edgeKey(triangle[j], triangle[(j + 1)%3])];
+      }
+    }
+
+    // edge which is used by one triangle is on boundary, by more than two is non manifold.
+    for (const auto &edge : edges) {
+      if (edge.second==2) continue;
+      locked_[static_cast<std::size_t>(edge.first >> 32)] = true;
+      locked_[static_cast<std::size_t>(edge.first & 0xFFFFFFFF)] = true;
+    }
+  }
+
+  void collapse(double maxCost) {
+    queue_ = CandidateQueue();
+    for (std::size_t v = 0; v < positions_.size(); ++v)
+      addCandidates(static_cast<int>(v), maxCost);
+
+    while (!queue_.empty()) {
+      Candidate candidate = queue_.top();
+      queue_.pop();
+      if (candidate.fromStamp!=stamps_[candidate.from] || candidate.toStamp!=stamps_[candidate.to] ||
+          !canCollapse(candidate.from, candidate.to))
+        continue;
+
+      int from = candidate.from, to = candidate.to;
+      for (int t : vertexTriangles_[from]) {
+        if (removed_[t]) continue;
+        auto &triangle = triangles_[t];
+        if (triangle[0]==to || triangle[1]==to || triangle[2]==to) {
+          removed_[t] = true;
+          continue;
+        }
+        std::replace(triangle.begin(), triangle.end(), from, to);
+        vertexTriangles_[to].push_back(t);
+      }
+      vertexTriangles_[from].clear();
+      for (std::size_t i = 0; i < quadrics_[to].size(); ++i)
+        quadrics_[to][i] += quadrics_[from][i];
+
+      ++stamps_[from];
+      ++stamps_[to];
+      addCandidates(to, maxCost);
+    }
+  }
+
+  /// Adds collapses of edges around given vertex.
+  void addCandidates(int vertex, double maxCost) {
+    for (int t : vertexTriangles_[vertex]) {
+      if (removed_[t]) continue;
+      for (int other : triangles_[t]) {
+        if (other==vertex) continue;
+        addCandidate(other, vertex, maxCost);
+        addCandidate(vertex, other, maxCost);
+      }
+    }
+  }
+
+  void addCandidate(int from, int to, double maxCost) {
+    if (locked_[from]) return;
+    double cost = evaluate(quadrics_[from], quadrics_[to], positions_[to]);
+    if (cost <= maxCost)
+      queue_.push(Candidate {cost, from, to, stamps_[from], stamps_[to]});
+  }
+
+  /// Checks that collapse neither flips triangles nor changes topology.
+  bool canCollapse(int from, int to) {
+    int shared = 0;
+    for (int t : vertexTriangles_[from]) {
+      if (removed_[t]) continue;
+      const auto &triangle = triangles_[t];
+      if (triangle[0]==to || triangle[1]==to || triangle[2]==to) {
+        ++shared;
+        continue;
+      }
+      const auto &p0 = positions_[triangle[0]];
+      auto before = Vector3::cross(positions_[triangle[1]] - p0, positions_[triangle[2]] - p0);
+      std::array<Vector3, 3> points;
+      for (int j = 0; j < 3; ++j)
+        points[j] = positions_[triangle[j]==from ? to : triangle[j]];
+      auto after = Vector3::cross(points[1] - points[0], points[2] - points[0]);
+      if (Vector3::dot(before, after) <= 0)
+        return false;
+    }
+
+    // link condition: only vertices opposite to collapsed edge may be shared by both ends.
+    collectNeighbours(from, to, fromNeighbours_);
+    collectNeighbours(to, from, toNeighbours_);
+    std::size_t common = 0;
+    for (int vertex : fromNeighbours_)
+      if (std::binary_search(toNeighbours_.begin(), toNeighbours_.end(), vertex))
+        ++common;
+    return shared > 0 && common==static_cast<std::size_t>(shared);
+  }
+
+  /// Collects sorted unique vertices adjacent to given one except excluded.
+  void collectNeighbours(int vertex, int excluded, std::vector<int> &neighbours) const {
+    neighbours.clear();
+    for (int t : vertexTriangles_[vertex]) {
+      if (removed_[t]) continue;
+      for (int other : triangles_[t])
+        if (other!=vertex && other!=excluded) neighbours.push_back(other);
+    }
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+  }
+
+  void copy(const Mesh &source, Mesh &destination, const std::vector<int> &remap, bool useRemap) {
+    std::size_t vertexCount = source.vertices.size()/3;
+    bool hasColors = source.colors.size()==vertexCount;
+    bool hasUvs = source.uvs.size()==vertexCount*2;
+    std::size_t offset = destination.vertices.size()/3;
+    std::size_t uvOffset = destination.uvs.size();
+
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+      if (useRemap && remap[i] < 0) continue;
+      destination.vertices.insert(destination.vertices.end(), source.vertices.begin() + i*3,
+                                  source.vertices.begin() + i*3 + 3);
+      if (hasColors) destination.colors.push_back(source.colors[i]);
+      if (hasUvs) destination.uvs.insert(destination.uvs.end(), source.uvs.begin() + i*2,
+                                         source.uvs.begin() + i*2 + 2);
+    }
+    if (!hasColors) destination.colors.insert(destination.colors.end(), source.colors.begin(), source.colors.end());
+    if (!hasUvs) destination.uvs.insert(destination.uvs.end(), source.uvs.begin(), source.uvs.end());
+
+    if (useRemap) {
+      for (std::size_t t = 0; t < triangles_.size(); ++t) {
+        if (removed_[t]) continue;
+        for (int index : triangles_[t])
+          destination.triangles.push_back(static_cast<int>(offset) + remap[index]);
+      }
+    } else {
+      for (int index : source.triangles)
+        destination.triangles.push_back(static_cast<int>(offset) + index);
+    }
+
+    // NOTE uv map contains end of texture range in uvs followed by seven texture values.
+    std::size_t vertex = 0;
+    int kept = 0;
+    for (std::size_t i = 0; i + 8 <= source.uvMap.size(); i += 8) {
+      int end = source.uvMap[i];
+      if (useRemap && hasUvs) {
+        for (; vertex < std::min(static_cast<std::size_t>(end/2), vertexCount); ++vertex)
+          if (remap[vertex] >= 0) ++kept;
+        end = kept*2;
+      }
+      destination.uvMap.push_back(static_cast<int>(uvOffset) + end);
+      destination.uvMap.insert(destination.uvMap.end(), source.uvMap.begin() + i + 1, source.uvMap.begin() + i + 8);
+    }
+  }
+
+  static std::uint64_t edgeKey(int a, int b) {
+    if (a > b) std::swap(a, b);
+    return (static_cast<std::uint64_t>(a) << 32) | static_cast<std::uint32_t>(b);
+  }
+
+  static void addPlane(Quadric &q, const Vector3 &n, double d) {
+    q[0] += n.x*n.x; q[1] += n.x*n.y; q[2] += n.x*n.z; q[3] += n.x*d;
+    q[4] += n.y*n.y; q[5] += n.y*n.z; q[6] += n.y*d;
+    q[7] += n.z*n.z; q[8] += n.z*d;
+    q[9] += d*d;
+  }
+
+  static double evaluate(const Quadric &a, const Quadric &b, const Vector3 &v) {
+    Quadric q;
+    for (std::size_t i = 0; i < q.size(); ++i)
+      q[i] = a[i] + b[i];
+    return q[0]*v.x*v.x + 2*q[1]*v.x*v.y + 2*q[2]*v.x*v.z + 2*q[3]*v.x +
+        q[4]*v.y*v.y + 2*q[5]*v.y*v.z + 2*q[6]*v.y +
+        q[7]*v.z*v.z + 2*q[8]*v.z + q[9];
+  }
+
+  typedef std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> CandidateQueue;
+
+  std::vector<Vector3> positions_;
+  std::vector<Quadric> quadrics_;
+  std::vector<std::vector<int>> vertexTriangles_;
+  std::vector<std::uint32_t> stamps_;
+  std::vector<bool> locked_;
+  std::vector<std::array<int, 3>> triangles_;
+  std::vector<bool> removed_;
+  std::vector<int> fromNeighbours_;
+  std::vector<int> toNeighbours_;
+  CandidateQueue queue_;
+};
+
+}
+}
+
+#endif // MATH_MESHSIMPLIFIER_HPP_DEFINED
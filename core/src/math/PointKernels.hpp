@@ -0,0 +1,138 @@
+#ifndef MATH_POINTKERNELS_HPP_DEFINED
+#define MATH_POINTKERNELS_HPP_DEFINED
+
+#include "math/Rectangle.hpp"
+#include "math/Vector2.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace utymap {
+namespace math {
+
+/// Keeps points as separate arrays of coordinates, so batch operations on them
+/// read contiguous memory. Float coordinates fit twice more points into vector register.
+template<typename T>
+struct PointArrays final {
+  std::vector<T> xs;
+  std::vector<T> ys;
+
+  std::size_t size() const {
+    return xs.size();
+  }
+
+  void clear() {
+    xs.clear();
+    ys.clear();
+  }
+
+  /// Replaces points with given interleaved x, y pairs.
+  void assign(const double *points, std::size_t count);
+
+  /// Replaces points with given contour.
+  void assign(const std::vector<Vector2> &contour) {
+    xs.resize(contour.size());
+    ys.resize(contour.size());
+    for (std::size_t i = 0; i < contour.size(); ++i) {
+      xs[i] = static_cast<T>(contour[i].x);
+      ys[i] = static_cast<T>(contour[i].y);
+    }
+  }
+};
+
+/// Provides batch operations on points stored as separate arrays of coordinates.
+/// NOTE loops have no branches and no dependencies between iterations except sums,
+/// so they can be vectorized by compiler. Sums use independent accumulators.
+class PointKernels final {
+ public:
+  /// Splits interleaved x, y pairs into separate arrays.
+  template<typename T>
+  static void deinterleave(const double *points, std::size_t count, T *xs, T *ys) {
+    for (std::size_t i = 0; i < count; ++i) {
+      xs[i] = static_cast<T>(points[i*2]);
+      ys[i] = static_cast<T>(points[i*2 + 1]);
+    }
+  }
+
+  /// Joins separate arrays into interleaved x, y pairs, e.g. to feed triangle library.
+  template<typename T>
+  static void interleave(const T *xs, const T *ys, std::size_t count, double *points) {
+    for (std::size_t i = 0; i < count; ++i) {
+      points[i*2] = xs[i];
+      points[i*2 + 1] = ys[i];
+    }
+  }
+
+  /// Returns signed area of ring with implicitly closed last edge:
+  /// positive for counter clockwise order.
+  template<typename T>
+  static double signedArea(const T *xs, const T *ys, std::size_t count) {
+    if (count < 3) return 0;
+
+    double sums[4] = { 0, 0, 0, 0 };
+    std::size_t i = 1;
+    for (; i + 4 <= count; i += 4) {
+      for (std::size_t k = 0; k < 4; ++k)
+        sums[k] += static_cast<double>(xs[i + k - 1])*ys[i + k] - static_cast<double>(xs[i + k])*ys[i + k - 1];
+    }
+    for (; i < count; ++i)
+      sums[0] += static_cast<double>(xs[i - 1])*ys[i] - static_cast<double>(xs[i])*ys[i - 1];
+    sums[0] += static_cast<double>(xs[count - 1])*ys[0] - static_cast<double>(xs[0])*ys[count - 1];
+
+    return (sums[0] + sums[1] + sums[2] + sums[3])/2;
+  }
+
+  /// Expands rectangle to contain given points.
+  template<typename T>
+  static void expand(const T *xs, const T *ys, std::size_t count, Rectangle &rectangle) {
+    if (count == 0) return;
+
+    T xMin = xs[0], xMax = xs[0], yMin = ys[0], yMax = ys[0];
+    for (std::size_t i = 1; i < count; ++i) {
+      xMin = xs[i] < xMin ? xs[i] : xMin;
+      xMax = xs[i] > xMax ? xs[i] : xMax;
+      yMin = ys[i] < yMin ? ys[i] : yMin;
+      yMax = ys[i] > yMax ? ys[i] : yMax;
+    }
+    rectangle.expand(Vector2(xMin, yMin));
+    rectangle.expand(Vector2(xMax, yMax));
+  }
+
+  /// Calculates (point - origin)*scale for every point. Output can be the same as input.
+  template<typename T>
+  static void transform(const T *xs, const T *ys, std::size_t count,
+                        const Vector2 &origin, const Vector2 &scale,
+                        T *outXs, T *outYs) {
+    const T originX = static_cast<T>(origin.x), originY = static_cast<T>(origin.y);
+    const T scaleX = static_cast<T>(scale.x), scaleY = static_cast<T>(scale.y);
+    for (std::size_t i = 0; i < count; ++i) {
+      outXs[i] = (xs[i] - originX)*scaleX;
+      outYs[i] = (ys[i] - originY)*scaleY;
+    }
+  }
+
+  /// Writes texture coordinates (point - origin)*scale as interleaved u, v pairs
+  /// which is layout of mesh.
+  template<typename T>
+  static void mapUv(const T *xs, const T *ys, std::size_t count,
+                    const Vector2 &origin, const Vector2 &scale,
+                    double *uvs) {
+    for (std::size_t i = 0; i < count; ++i) {
+      uvs[i*2] = (xs[i] - origin.x)*scale.x;
+      uvs[i*2 + 1] = (ys[i] - origin.y)*scale.y;
+    }
+  }
+};
+
+template<typename T>
+void PointArrays<T>::assign(const double *points, std::size_t count) {
+  xs.resize(count);
+  ys.resize(count);
+  PointKernels::deinterleave(points, count, xs.data(), ys.data());
+}
+
+}
+}
+
+#endif // MATH_POINTKERNELS_HPP_DEFINED
@@ -70,6 +70,11 @@ inline bool getOrientation(const IntPath &poly) {
   return ClipperLib::Orientation(poly);
 }
 
+/// Returns 0 if point is outside, 1 if it is inside and -1 if it is on polygon's boundary.
+inline int pointInPolygon(const IntPoint &point, const IntPath &poly) {
+  return ClipperLib::PointInPolygon(point, poly);
+}
+
 }
 }
 #endif // MATH_POLYCLIP_HPP_DEFINED
@@ -0,0 +1,58 @@
+#include "utils/AllocationTracker.hpp"
+
+#include <cstdlib>
+#include <new>
+
+using namespace utymap::utils;
+
+thread_local AllocationTracker::Subsystem AllocationTracker::current = AllocationTracker::Subsystem::None;
+std::atomic<std::uint64_t> AllocationTracker::counts[static_cast<std::size_t>(AllocationTracker::Subsystem::Count)];
+std::atomic<std::uint64_t> AllocationTracker::bytes[static_cast<std::size_t>(AllocationTracker::Subsystem::Count)];
+
+#ifdef ALLOCATION_TRACKING_ENABLED
+
+namespace {
+void *allocate(std::size_t size) {
+  AllocationTracker::record(size);
+  // NOTE zero size is allocated as one byte, so returned pointer is unique.
+  if (void *ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+  throw std::bad_alloc();
+}
+}
+
+void *operator new(std::size_t size) {
+  return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+  return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  AllocationTracker::record(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  AllocationTracker::record(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef UTILS_ALLOCATIONTRACKER_HPP_DEFINED
+#define UTILS_ALLOCATIONTRACKER_HPP_DEFINED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace utymap {
+namespace utils {
+
+/// Counts heap allocations of tile build and import per subsystem. Subsystem is selected by scope which
+/// is active on allocating thread, allocations outside of scopes are not counted.
+/// NOTE allocations are counted by global operator new which is replaced only if
+/// ALLOCATION_TRACKING_ENABLED is defined, see ALLOCATION_SCOPE macro.
+class AllocationTracker final {
+ public:
+  enum class Subsystem {
+    None = 0, // not counted
+    Build,    // tile build which is not covered by other subsystems
+    Search,   // reading of tile elements from store
+    Style,    // style matching of tile elements
+    Strings,  // string table lookups
+    Mesh,     // running of builders
+    Callback, // passing of tile meshes and elements to callbacks
+    Import,   // keeping of imported elements in memory
+    Count
+  };
+
+  /// Sets subsystem of calling thread till the end of scope.
+  class Scope final {
+   public:
+    explicit Scope(Subsystem subsystem) : previous_(current) {
+      current = subsystem;
+    }
+
+    ~Scope() {
+      current = previous_;
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    const Subsystem previous_;
+  };
+
+  /// Counts allocation of given size in subsystem of calling thread.
+  static void record(std::size_t size) {
+    auto index = static_cast<std::size_t>(current);
+    if (index == 0) return;
+    counts[index].fetch_add(1, std::memory_order_relaxed);
+    bytes[index].fetch_add(size, std::memory_order_relaxed);
+  }
+
+  static std::uint64_t getCount(Subsystem subsystem) {
+    return counts[static_cast<std::size_t>(subsystem)].load(std::memory_order_relaxed);
+  }
+
+  static std::uint64_t getBytes(Subsystem subsystem) {
+    return bytes[static_cast<std::size_t>(subsystem)].load(std::memory_order_relaxed);
+  }
+
+  /// Returns counts and bytes of all subsystems as json object.
+  static std::string toJson() {
+    static const char *names[] = { "none", "build", "search", "style", "strings", "mesh", "callback", "import" };
+
+    std::stringstream ss;
+    ss << "{";
+    for (std::size_t i = 1; i < static_cast<std::size_t>(Subsystem::Count); ++i)
+      ss << (i == 1 ? "" : ",") << "\"" << names[i] << "\":{\"count\":" << counts[i].load()
+         << ",\"bytes\":" << bytes[i].load() << "}";
+    ss << "}";
+    return ss.str();
+  }
+
+  static void reset() {
+    for (std::size_t i = 0; i < static_cast<std::size_t>(Subsystem::Count); ++i) {
+      counts[i] = 0;
+      bytes[i] = 0;
+    }
+  }
+
+ private:
+  /// NOTE defined in translation unit with replaced operator new, so it is linked together
+  /// with every user of scopes.
+  static thread_local Subsystem current;
+  static std::atomic<std::uint64_t> counts[static_cast<std::size_t>(Subsystem::Count)];
+  static std::atomic<std::uint64_t> bytes[static_cast<std::size_t>(Subsystem::Count)];
+};
+
+}
+}
+
+#define ALLOCATION_CONCAT_IMPL(a, b) a##b
+#define ALLOCATION_CONCAT(a, b) ALLOCATION_CONCAT_IMPL(a, b)
+
+/// Declares scope of subsystem which lasts till the end of block.
+#ifdef ALLOCATION_TRACKING_ENABLED
+#define ALLOCATION_SCOPE(subsystem) utymap::utils::AllocationTracker::Scope \
+    ALLOCATION_CONCAT(allocationScope, __LINE__)(utymap::utils::AllocationTracker::Subsystem::subsystem)
+#else
+#define ALLOCATION_SCOPE(subsystem) ((void) 0)
+#endif
+
+#endif // UTILS_ALLOCATIONTRACKER_HPP_DEFINED
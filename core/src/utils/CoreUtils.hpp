@@ -61,6 +61,15 @@ inline double parseDouble(const std::string &value, double defaultValue = 0) {
   }
 }
 
+inline double parseDouble(const char *data, std::size_t size, double defaultValue = 0) {
+  try {
+    return boost::lexical_cast<double>(data, size);
+  }
+  catch (const boost::bad_lexical_cast &) {
+    return defaultValue;
+  }
+}
+
 template<typename TimeT = std::chrono::milliseconds>
 struct measure {
   template<typename F, typename ...Args>
@@ -1,7 +1,11 @@
 #ifndef UTILS_ELEMENTUTILS_HPP_DEFINED
 #define UTILS_ELEMENTUTILS_HPP_DEFINED
 
+#include "entities/Area.hpp"
 #include "entities/Element.hpp"
+#include "entities/Node.hpp"
+#include "entities/Relation.hpp"
+#include "entities/Way.hpp"
 #include "formats/FormatTypes.hpp"
 #include "formats/osm/OsmDataContext.hpp"
 #include "index/StringTable.hpp"
@@ -12,32 +16,43 @@
 namespace utymap {
 namespace utils {
 
-/// Sets tags to element.
-inline void setTags(const utymap::index::StringTable &stringTable,
-                    utymap::entities::Element &element,
-                    const utymap::formats::Tags &tags) {
-  for (const auto &tag : tags) {
-    std::uint32_t key = stringTable.getId(tag.key);
-    std::uint32_t value = stringTable.getId(tag.value);
-    element.tags.push_back(utymap::entities::Tag(key, value));
-  }
-  // NOTE: tags should be sorted to speed up mapcss styling
-  std::sort(element.tags.begin(), element.tags.end());
-}
-
 /// Convert format specific tags to entity ones.
 inline std::vector<utymap::entities::Tag> convertTags(const utymap::index::StringTable &stringTable,
                                                       const utymap::formats::Tags &tags) {
-  std::vector<utymap::entities::Tag> convertedTags(tags.size());
-  std::transform(tags.begin(), tags.end(), convertedTags.begin(), [&](const utymap::formats::Tag &tag) {
-    return utymap::entities::Tag(stringTable.getId(tag.key), stringTable.getId(tag.value));
-  });
+  // NOTE all keys and values are interned by one string table call.
+  std::vector<const std::string *> strings;
+  strings.reserve(tags.size() * 2);
+  for (const auto &tag : tags) {
+    strings.push_back(&tag.key);
+    strings.push_back(&tag.value);
+  }
+  std::vector<std::uint32_t> ids;
+  stringTable.getIds(strings, ids);
+
+  std::vector<utymap::entities::Tag> convertedTags;
+  convertedTags.reserve(tags.size());
+  for (std::size_t i = 0; i < tags.size(); ++i)
+    convertedTags.push_back(utymap::entities::Tag(ids[2 * i], ids[2 * i + 1]));
 
   std::sort(convertedTags.begin(), convertedTags.end());
 
   return std::move(convertedTags);
 }
 
+/// Sets tags to element.
+inline void setTags(const utymap::index::StringTable &stringTable,
+                    utymap::entities::Element &element,
+                    const utymap::formats::Tags &tags) {
+  auto convertedTags = convertTags(stringTable, tags);
+  if (element.tags.empty()) {
+    element.tags = std::move(convertedTags);
+    return;
+  }
+  element.tags.insert(element.tags.end(), convertedTags.begin(), convertedTags.end());
+  // NOTE: tags should be sorted to speed up mapcss styling
+  std::sort(element.tags.begin(), element.tags.end());
+}
+
 template<typename T>
 std::uint32_t getTagValue(std::uint32_t key,
                           const std::vector<utymap::entities::Tag> &tags,
@@ -96,6 +111,25 @@ inline std::string getMeshName(const std::string &prefix, const utymap::entities
   return prefix + utymap::utils::toString(element.id);
 }
 
+/// Returns amount of coordinates of element including relation members.
+inline std::uint64_t countVertices(const utymap::entities::Element &element) {
+  switch (element.kind) {
+    case utymap::entities::ElementKind::Node:
+      return 1;
+    case utymap::entities::ElementKind::Way:
+      return static_cast<const utymap::entities::Way &>(element).coordinates.size();
+    case utymap::entities::ElementKind::Area:
+      return static_cast<const utymap::entities::Area &>(element).coordinates.size();
+    case utymap::entities::ElementKind::Relation: {
+      std::uint64_t count = 0;
+      for (const auto &member : static_cast<const utymap::entities::Relation &>(element).elements)
+        count += countVertices(*member);
+      return count;
+    }
+  }
+  return 0;
+}
+
 template<typename T>
 static void visitRelationMembers(const utymap::formats::OsmDataContext &context,
                                  const utymap::formats::RelationMembers &members,
@@ -6,7 +6,11 @@
 #include "utils/MathUtils.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
 #include <string>
 
 namespace utymap {
@@ -40,46 +44,99 @@ class GeoUtils final {
   }
 
   /// Converts quadkey to bounding box
+  /// NOTE recently used bounding boxes are kept in small per thread cache as the same
+  /// tiles are requested many times by element store, builders and terrain.
   static BoundingBox quadKeyToBoundingBox(const QuadKey &quadKey) {
-    GeoCoordinate minPoint, maxPoint;
     int levelOfDetail = quadKey.levelOfDetail;
-    minPoint.latitude = tileYToLat(quadKey.tileY + 1, levelOfDetail);
-    maxPoint.latitude = tileYToLat(quadKey.tileY, levelOfDetail);
-    minPoint.longitude = tileXToLon(quadKey.tileX, levelOfDetail);
-    maxPoint.longitude = tileXToLon(quadKey.tileX + 1, levelOfDetail);
-
-    return BoundingBox(minPoint, maxPoint);
+    bool isCacheable = levelOfDetail >= 0 && levelOfDetail <= QuadKey::MaxLevelOfDetail &&
+        quadKey.tileX >= 0 && quadKey.tileY >= 0 &&
+        quadKey.tileX < (1 << levelOfDetail) && quadKey.tileY < (1 << levelOfDetail);
+    if (!isCacheable)
+      return createBoundingBox(quadKey);
+
+    std::uint64_t code = quadKey.code();
+    auto &entry = tileBoxCache()[QuadKey::Hash()(quadKey) % TileBoxCacheSize];
+    if (entry.code != code) {
+      entry.code = code;
+      entry.bbox = createBoundingBox(quadKey);
+    }
+    return entry.bbox;
   }
 
   static std::string quadKeyToString(const QuadKey &quadKey) {
     std::string code;
-    code.reserve(static_cast<std::size_t>(quadKey.levelOfDetail));
-    for (int i = quadKey.levelOfDetail; i > 0; --i) {
-      char digit = '0';
-      int mask = 1 << (i - 1);
-      if ((quadKey.tileX & mask)!=0)
-        digit++;
-      if ((quadKey.tileY & mask)!=0) {
-        digit++;
-        digit++;
+    appendQuadKey(quadKey, code);
+    return code;
+  }
+
+  /// Appends string code of quadkey to given buffer without intermediate strings.
+  /// NOTE packed code keeps digits as bit pairs, so they are read directly from it.
+  static void appendQuadKey(const QuadKey &quadKey, std::string &buffer) {
+    std::uint64_t code = quadKey.code();
+    std::size_t start = buffer.size();
+    buffer.resize(start + static_cast<std::size_t>(quadKey.levelOfDetail));
+    for (int i = quadKey.levelOfDetail - 1; i >= 0; --i, code >>= 2)
+      buffer[start + i] = static_cast<char>('0' + (code & 3));
+  }
+
+  /// Parses quadkey from its string code. Throws domain_error if code is invalid.
+  static QuadKey stringToQuadKey(const std::string &code) {
+    QuadKey quadKey(static_cast<int>(code.size()), 0, 0);
+    for (std::size_t i = 0; i < code.size(); ++i) {
+      int mask = 1 << (code.size() - i - 1);
+      switch (code[i]) {
+        case '0': break;
+        case '1': quadKey.tileX |= mask; break;
+        case '2': quadKey.tileY |= mask; break;
+        case '3': quadKey.tileX |= mask; quadKey.tileY |= mask; break;
+        default: throw std::domain_error("Invalid quadkey code: " + code);
       }
-      code += digit;
     }
-    return code;
+    return quadKey;
   }
 
+  /// Order of visiting tiles of range.
+  enum class TileOrder {
+    /// Row by row from north to south.
+    Rows,
+    /// Z-order curve which matches order of quad key codes, so neighbouring tiles are
+    /// visited together. It is preferred when every tile reads data from storage.
+    Morton
+  };
+
   /// Visits all tiles which are intersecting with given bounding box at given level of details
   template<typename Visitor>
   static void visitTileRange(const BoundingBox &bbox, int levelOfDetail, const Visitor &visitor) {
+    visitTileRange(bbox, levelOfDetail, TileOrder::Rows, visitor);
+  }
+
+  /// Visits all tiles which are intersecting with given bounding box at given level of details
+  /// in given order.
+  template<typename Visitor>
+  static void visitTileRange(const BoundingBox &bbox, int levelOfDetail, TileOrder order, const Visitor &visitor) {
     if (!bbox.isValid()) return;
 
     QuadKey start = GeoCoordinateToQuadKey(bbox.minPoint, levelOfDetail);
     QuadKey end = GeoCoordinateToQuadKey(bbox.maxPoint, levelOfDetail);
 
+    if (order==TileOrder::Morton) {
+      // NOTE traversal starts from the smallest tile which contains whole range.
+      int shift = 0;
+      while ((start.tileX >> shift)!=(end.tileX >> shift) || (end.tileY >> shift)!=(start.tileY >> shift))
+        ++shift;
+      visitMortonRange(bbox, levelOfDetail, levelOfDetail - shift, start.tileX >> shift, end.tileY >> shift,
+                       start.tileX, end.tileX, end.tileY, start.tileY, visitor);
+      return;
+    }
+
+    // NOTE latitudes are computed once per row and longitudes once per column.
     for (int y = end.tileY; y < start.tileY + 1; y++) {
+      double minLatitude = tileYToLat(y + 1, levelOfDetail);
+      double maxLatitude = tileYToLat(y, levelOfDetail);
       for (int x = start.tileX; x < end.tileX + 1; x++) {
         const QuadKey currentQuadKey = {levelOfDetail, x, y};
-        const BoundingBox currentBbox = quadKeyToBoundingBox(currentQuadKey);
+        const BoundingBox currentBbox(GeoCoordinate(minLatitude, tileXToLon(x, levelOfDetail)),
+                                      GeoCoordinate(maxLatitude, tileXToLon(x + 1, levelOfDetail)));
         if (bbox.intersects(currentBbox)) {
           visitor(currentQuadKey, currentBbox);
         }
@@ -88,16 +145,23 @@ class GeoUtils final {
   }
 
   /// Checks whether given point inside polygon.
+  /// NOTE crossings are accumulated without branches and division is replaced with
+  /// multiplication by sign of edge direction, so loop body is straight line code.
   template<typename Iter>
   static bool isPointInPolygon(const GeoCoordinate &point, Iter begin, Iter end) {
-    bool c = false;
+    if (begin==end) return false;
+    unsigned int crossings = 0;
     for (auto iCoord = begin, jCoord = end - 1; iCoord!=end; jCoord = iCoord++) {
-      if (((iCoord->latitude > point.latitude)!=(jCoord->latitude > point.latitude)) &&
-          (point.longitude < (jCoord->longitude - iCoord->longitude)*(point.latitude - iCoord->latitude)/
-              (jCoord->latitude - iCoord->latitude) + iCoord->longitude))
-        c = !c;
+      bool iAbove = iCoord->latitude > point.latitude;
+      bool jAbove = jCoord->latitude > point.latitude;
+      // point is left of edge: px < dx*(py - iy)/dy + ix => (px - ix)*dy < dx*(py - iy) when dy > 0.
+      double dy = jCoord->latitude - iCoord->latitude;
+      double lhs = (point.longitude - iCoord->longitude)*dy;
+      double rhs = (jCoord->longitude - iCoord->longitude)*(point.latitude - iCoord->latitude);
+      bool isLeft = dy > 0 ? lhs < rhs : lhs > rhs;
+      crossings += static_cast<unsigned int>((iAbove!=jAbove) & isLeft);
     }
-    return c;
+    return (crossings & 1)!=0;
   }
 
   /// Gets offset in degrees
@@ -140,23 +204,69 @@ class GeoUtils final {
   }
 
  private:
+  /// Visits tiles of given tile range which belong to tile of given level in Z-order.
+  template<typename Visitor>
+  static void visitMortonRange(const BoundingBox &bbox, int levelOfDetail, int level, int x, int y,
+                               int minX, int maxX, int minY, int maxY, const Visitor &visitor) {
+    int shift = levelOfDetail - level;
+    if ((((x + 1) << shift) - 1) < minX || (x << shift) > maxX ||
+        (((y + 1) << shift) - 1) < minY || (y << shift) > maxY)
+      return;
+
+    if (shift==0) {
+      const QuadKey currentQuadKey(levelOfDetail, x, y);
+      const BoundingBox currentBbox = createBoundingBox(currentQuadKey);
+      if (bbox.intersects(currentBbox))
+        visitor(currentQuadKey, currentBbox);
+      return;
+    }
+
+    for (int i = 0; i < 4; ++i)
+      visitMortonRange(bbox, levelOfDetail, level + 1, 2*x + (i & 1), 2*y + (i >> 1),
+                       minX, maxX, minY, maxY, visitor);
+  }
+
+  /// Amount of entries in per thread cache of tile bounding boxes.
+  static const std::size_t TileBoxCacheSize = 256;
+
+  struct TileBoxEntry {
+    std::uint64_t code = std::numeric_limits<std::uint64_t>::max();
+    BoundingBox bbox;
+  };
+
+  static std::array<TileBoxEntry, TileBoxCacheSize> &tileBoxCache() {
+    thread_local std::array<TileBoxEntry, TileBoxCacheSize> cache;
+    return cache;
+  }
+
+  /// Returns amount of tiles along one axis at given level of detail: exact power of two.
+  static constexpr double tileCount(int levelOfDetail) {
+    return static_cast<double>(std::uint64_t(1) << levelOfDetail);
+  }
+
+  static BoundingBox createBoundingBox(const QuadKey &quadKey) {
+    int levelOfDetail = quadKey.levelOfDetail;
+    return BoundingBox(GeoCoordinate(tileYToLat(quadKey.tileY + 1, levelOfDetail), tileXToLon(quadKey.tileX, levelOfDetail)),
+                       GeoCoordinate(tileYToLat(quadKey.tileY, levelOfDetail), tileXToLon(quadKey.tileX + 1, levelOfDetail)));
+  }
 
   static int lonToTileX(double lon, int levelOfDetail) {
-    return static_cast<int>(std::floor((lon + 180.0)/360.0*pow(2.0, levelOfDetail)));
+    return static_cast<int>(std::floor((lon + 180.0)/360.0*tileCount(levelOfDetail)));
   }
 
   static int latToTileY(double lat, int levelOfDetail) {
+    double radians = lat*pi/180.0;
     return static_cast<int>(std::floor(
-        (1.0 - log(tan(lat*pi/180.0) + 1.0/cos(lat*pi/180.0))/pi)/2.0*pow(2.0, levelOfDetail)));
+        (1.0 - std::log(std::tan(radians) + 1.0/std::cos(radians))/pi)/2.0*tileCount(levelOfDetail)));
   }
 
   static double tileXToLon(int x, int levelOfDetail) {
-    return x/pow(2.0, levelOfDetail)*360.0 - 180;
+    return x/tileCount(levelOfDetail)*360.0 - 180;
   }
 
   static double tileYToLat(int y, int levelOfDetail) {
-    double n = pi - 2.0*pi*y/pow(2.0, levelOfDetail);
-    return 180.0/pi*atan(0.5*(exp(n) - exp(-n)));
+    double n = pi - 2.0*pi*y/tileCount(levelOfDetail);
+    return 180.0/pi*std::atan(0.5*(std::exp(n) - std::exp(-n)));
   }
 
   /// Earth radius at a given latitude, according to the WGS-84 ellipsoid [m].
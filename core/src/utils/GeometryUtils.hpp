@@ -9,6 +9,7 @@
 #include "math/Vector3.hpp"
 
 #include <algorithm>
+#include <vector>
 
 namespace utymap {
 namespace utils {
@@ -176,6 +177,59 @@ inline bool isPointInPolygon(const utymap::math::Vector2 &p,
   return result;
 }
 
+/// Simplifies polyline using Douglas-Peucker algorithm: points which are closer than tolerance
+/// to simplified line are removed, first and last points are kept. Distances are measured
+/// in degrees of latitude, longitude is multiplied by given scale.
+inline std::vector<utymap::GeoCoordinate> simplify(const std::vector<utymap::GeoCoordinate> &coordinates,
+                                                   double tolerance,
+                                                   double longitudeScale = 1) {
+  std::size_t size = coordinates.size();
+  if (size < 3 || tolerance <= 0)
+    return coordinates;
+
+  std::vector<bool> isKept(size, false);
+  isKept[0] = isKept[size - 1] = true;
+  std::vector<std::pair<std::size_t, std::size_t>> ranges = { { 0, size - 1 } };
+  double squaredTolerance = tolerance*tolerance;
+  while (!ranges.empty()) {
+    auto range = ranges.back();
+    ranges.pop_back();
+
+    const auto &start = coordinates[range.first];
+    const auto &end = coordinates[range.second];
+    double dx = (end.longitude - start.longitude)*longitudeScale;
+    double dy = end.latitude - start.latitude;
+    double length = dx*dx + dy*dy;
+
+    double maxDistance = 0;
+    std::size_t index = range.first;
+    for (std::size_t i = range.first + 1; i < range.second; ++i) {
+      double px = (coordinates[i].longitude - start.longitude)*longitudeScale;
+      double py = coordinates[i].latitude - start.latitude;
+      double t = length > 0 ? std::max(0., std::min(1., (px*dx + py*dy)/length)) : 0;
+      double distance = (px - t*dx)*(px - t*dx) + (py - t*dy)*(py - t*dy);
+      if (distance > maxDistance) {
+        maxDistance = distance;
+        index = i;
+      }
+    }
+
+    if (maxDistance <= squaredTolerance)
+      continue;
+
+    isKept[index] = true;
+    ranges.push_back({ range.first, index });
+    ranges.push_back({ index, range.second });
+  }
+
+  std::vector<utymap::GeoCoordinate> result;
+  for (std::size_t i = 0; i < size; ++i) {
+    if (isKept[i])
+      result.push_back(coordinates[i]);
+  }
+  return result;
+}
+
 }
 }
 
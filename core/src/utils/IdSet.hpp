@@ -0,0 +1,108 @@
+#ifndef UTILS_IDSET_HPP_DEFINED
+#define UTILS_IDSET_HPP_DEFINED
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utymap {
+namespace utils {
+
+/// Set of element ids stored in open addressing table with linear probing, so insert and
+/// lookup do not allocate per item. Clearing keeps memory, so the set can be reused.
+class IdSet final {
+  /// Marks empty slot. Zero id is kept separately.
+  static const std::uint64_t EmptyId = 0;
+  static const std::size_t MinCapacity = 64;
+ public:
+  IdSet() : slots_(MinCapacity, std::uint64_t(EmptyId)), size_(0), hasZero_(false) {}
+
+  /// Returns true if id was not in set.
+  bool insert(std::uint64_t id) {
+    if (id==EmptyId) {
+      bool isInserted = !hasZero_;
+      hasZero_ = true;
+      return isInserted;
+    }
+
+    if ((size_ + 1)*2 > slots_.size())
+      rehash(slots_.size()*2);
+
+    auto &slot = find(slots_, id);
+    if (slot==id)
+      return false;
+
+    slot = id;
+    ++size_;
+    return true;
+  }
+
+  bool contains(std::uint64_t id) const {
+    if (id==EmptyId)
+      return hasZero_;
+
+    auto mask = slots_.size() - 1;
+    for (auto index = hash(id) & mask;; index = (index + 1) & mask) {
+      if (slots_[index]==id) return true;
+      if (slots_[index]==EmptyId) return false;
+    }
+  }
+
+  std::size_t size() const {
+    return size_ + (hasZero_ ? 1 : 0);
+  }
+
+  /// Ensures that given amount of ids is inserted without rehashing.
+  void reserve(std::size_t count) {
+    std::size_t capacity = slots_.size();
+    while (capacity < count*2)
+      capacity *= 2;
+    if (capacity!=slots_.size())
+      rehash(capacity);
+  }
+
+  /// Removes all ids, but keeps memory.
+  void clear() {
+    if (size_ > 0)
+      std::fill(slots_.begin(), slots_.end(), std::uint64_t(EmptyId));
+    size_ = 0;
+    hasZero_ = false;
+  }
+
+ private:
+  /// Mixes bits of id as sequential ids are common.
+  static std::size_t hash(std::uint64_t id) {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdull;
+    id ^= id >> 33;
+    return static_cast<std::size_t>(id);
+  }
+
+  /// Finds slot which contains given id or empty slot where it should be inserted.
+  static std::uint64_t &find(std::vector<std::uint64_t> &slots, std::uint64_t id) {
+    auto mask = slots.size() - 1;
+    auto index = hash(id) & mask;
+    while (slots[index]!=EmptyId && slots[index]!=id)
+      index = (index + 1) & mask;
+    return slots[index];
+  }
+
+  void rehash(std::size_t capacity) {
+    std::vector<std::uint64_t> slots(capacity, std::uint64_t(EmptyId));
+    for (auto id : slots_) {
+      if (id!=EmptyId)
+        find(slots, id) = id;
+    }
+    slots_.swap(slots);
+  }
+
+  std::vector<std::uint64_t> slots_;
+  std::size_t size_;
+  bool hasZero_;
+};
+
+}
+}
+
+#endif // UTILS_IDSET_HPP_DEFINED
@@ -0,0 +1,69 @@
+#ifndef UTILS_INLINEVECTOR_HPP_DEFINED
+#define UTILS_INLINEVECTOR_HPP_DEFINED
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace utymap {
+namespace utils {
+
+/// Vector which keeps up to Capacity items inside itself and uses heap only when it grows bigger.
+/// NOTE only trivially copyable items are supported: they are moved around by plain copy.
+template<typename T, std::size_t Capacity>
+class InlineVector final {
+  static_assert(std::is_trivially_copyable<T>::value, "InlineVector supports only trivially copyable types.");
+ public:
+  typedef const T *const_iterator;
+
+  InlineVector() : inline_(), heap_(), size_(0) {
+  }
+
+  std::size_t size() const { return size_; }
+
+  bool empty() const { return size_==0; }
+
+  const T *data() const { return isInline() ? inline_.data() : heap_.data(); }
+
+  const_iterator begin() const { return data(); }
+
+  const_iterator end() const { return data() + size_; }
+
+  const T &operator[](std::size_t index) const { return data()[index]; }
+
+  T &operator[](std::size_t index) { return mutableData()[index]; }
+
+  /// Inserts item before given position.
+  void insert(const_iterator position, const T &item) {
+    std::size_t index = static_cast<std::size_t>(position - begin());
+    if (isInline() && size_ < Capacity) {
+      for (std::size_t i = size_; i > index; --i)
+        inline_[i] = inline_[i - 1];
+      inline_[index] = item;
+    } else {
+      if (isInline())
+        heap_.assign(inline_.begin(), inline_.end());
+      heap_.insert(heap_.begin() + index, item);
+    }
+    ++size_;
+  }
+
+  void push_back(const T &item) {
+    insert(end(), item);
+  }
+
+ private:
+  bool isInline() const { return heap_.empty(); }
+
+  T *mutableData() { return isInline() ? inline_.data() : heap_.data(); }
+
+  std::array<T, Capacity> inline_;
+  std::vector<T> heap_;
+  std::size_t size_;
+};
+
+}
+}
+
+#endif // UTILS_INLINEVECTOR_HPP_DEFINED
@@ -21,7 +21,12 @@ class LruCache final {
 
   /// Puts value to cache.
   void put(const Key &key, Value &&value) {
-    itemsList_.push_front(KeyValuePair(key, std::make_shared<Value>(std::move(value))));
+    put(key, std::make_shared<Value>(std::move(value)));
+  }
+
+  /// Puts shared value to cache.
+  void put(const Key &key, const std::shared_ptr<Value> &value) {
+    itemsList_.push_front(KeyValuePair(key, value));
 
     auto it = itemsMap_.find(key);
     if (it!=itemsMap_.end()) {
@@ -73,6 +78,66 @@ class LruCache final {
     return itemsMap_.size();
   }
 
+  /// Returns key of least recently used value.
+  const Key &lastKey() const {
+    if (itemsList_.empty()) throwException();
+
+    return itemsList_.back().first;
+  }
+
+  /// Removes value with given key from cache. Returns false if there is no such key.
+  bool remove(const Key &key) {
+    auto it = itemsMap_.find(key);
+    if (it == itemsMap_.end()) return false;
+
+    itemsList_.erase(it->second);
+    itemsMap_.erase(it);
+    return true;
+  }
+
+  /// Removes least recently used value from cache.
+  void removeLast() {
+    if (itemsList_.empty()) return;
+
+    itemsMap_.erase(itemsList_.back().first);
+    itemsList_.pop_back();
+  }
+
+  /// Visits all cached values from most to least recently used without promoting them.
+  template<typename Visitor>
+  void visit(const Visitor &visitor) {
+    for (auto &pair : itemsList_)
+      visitor(pair.first, *pair.second);
+  }
+
+  /// Returns sum of sizes of cached values given by size function.
+  template<typename SizeFunction>
+  size_t weigh(const SizeFunction &sizeOf) const {
+    size_t size = 0;
+    for (const auto &pair : itemsList_)
+      size += sizeOf(*pair.second);
+    return size;
+  }
+
+  /// Removes least recently used values until sum of their sizes given by size function
+  /// doesn't exceed given limit. Returns sum of sizes of remaining values.
+  template<typename SizeFunction>
+  size_t trim(size_t maxSize, const SizeFunction &sizeOf) {
+    size_t size = weigh(sizeOf);
+    while (size > maxSize && !itemsList_.empty()) {
+      size -= sizeOf(*itemsList_.back().second);
+      removeLast();
+    }
+    return size;
+  }
+
+  /// Sets max amount of values and removes least recently used values above it.
+  void setMaxSize(size_t maxSize) {
+    maxSize_ = maxSize;
+    while (itemsMap_.size() > maxSize_)
+      removeLast();
+  }
+
   /// Clears cache.
   void clear() {
     itemsList_.clear();
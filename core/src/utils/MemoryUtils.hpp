@@ -0,0 +1,28 @@
+#ifndef UTILS_MEMORYUTILS_HPP_DEFINED
+#define UTILS_MEMORYUTILS_HPP_DEFINED
+
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace utymap {
+namespace utils {
+
+/// Returns peak resident memory of process in bytes.
+/// NOTE not supported on windows, zero is returned.
+inline std::uint64_t getPeakMemory() {
+#ifndef _WIN32
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    // NOTE linux reports kilobytes.
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+  return 0;
+}
+
+}
+}
+
+#endif // UTILS_MEMORYUTILS_HPP_DEFINED
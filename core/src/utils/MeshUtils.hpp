@@ -1,8 +1,18 @@
 #ifndef UTILS_MESHUTILS_HPP_DEFINED
 #define UTILS_MESHUTILS_HPP_DEFINED
 
+#include "GeoCoordinate.hpp"
+#include "QuadKey.hpp"
+#include "heightmap/ElevationProvider.hpp"
 #include "math/Mesh.hpp"
 #include "math/Vector3.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
 
 namespace utymap {
 namespace utils {
@@ -41,22 +51,111 @@ inline void copyMesh(const utymap::math::Vector3 &offset,
   }
 }
 
+/// Calls visitor with offset from position of every point placed with given step between two coordinates.
+/// NOTE elevations of all points are sampled at once.
+template<typename Visitor>
+inline void visitOffsetsAlong(const utymap::QuadKey &quadKey, const utymap::GeoCoordinate &position,
+                              const utymap::GeoCoordinate &p1, const utymap::GeoCoordinate &p2, double stepInMeters,
+                              const utymap::heightmap::ElevationProvider &eleProvider, Visitor &&visitor) {
+  double distanceInMeters = GeoUtils::distance(p1, p2);
+  int count = static_cast<int>(distanceInMeters/stepInMeters);
+  if (count <= 0) return;
+
+  std::vector<GeoCoordinate> positions(static_cast<std::size_t>(count));
+  for (int j = 0; j < count; ++j)
+    positions[j] = GeoUtils::newPoint(p1, p2, static_cast<double>(j)/count);
+
+  std::vector<double> elevations(positions.size());
+  eleProvider.getElevations(quadKey, positions.data(), elevations.data(), positions.size());
+
+  for (std::size_t j = 0; j < positions.size(); ++j) {
+    visitor(utymap::math::Vector3(positions[j].longitude - position.longitude,
+                                  elevations[j],
+                                  positions[j].latitude - position.latitude));
+  }
+}
+
 /// Copies mesh along two coordinates.
 inline void copyMeshAlong(const utymap::QuadKey &quadKey, const utymap::GeoCoordinate &position,
                           const utymap::GeoCoordinate &p1, const utymap::GeoCoordinate &p2,
                           const utymap::math::Mesh &source, utymap::math::Mesh &destination, double stepInMeters,
                           const utymap::heightmap::ElevationProvider &eleProvider) {
-  double distanceInMeters = GeoUtils::distance(p1, p2);
-  int count = static_cast<int>(distanceInMeters/stepInMeters);
+  visitOffsetsAlong(quadKey, position, p1, p2, stepInMeters, eleProvider,
+                    [&](const utymap::math::Vector3 &offset) {
+                      utymap::utils::copyMesh(offset, source, destination);
+                    });
+}
+
+/// Copies mesh into empty destination merging vertices with the same position, color and
+/// texture coordinates. Vertices are merged only inside the same texture range of uv map.
+/// Triangles which become degenerate are removed.
+/// NOTE merged vertices share normal, so flat shaded mesh looks smooth if normals are recalculated.
+inline void weldMesh(const utymap::math::Mesh &source, utymap::math::Mesh &destination) {
+  struct Vertex {
+    double x, y, z, u, v;
+    int color;
+
+    bool operator==(const Vertex &other) const {
+      return x==other.x && y==other.y && z==other.z && u==other.u && v==other.v && color==other.color;
+    }
+  };
+
+  struct VertexHash {
+    std::size_t operator()(const Vertex &vertex) const {
+      std::size_t seed = std::hash<int>()(vertex.color);
+      for (double value : {vertex.x, vertex.y, vertex.z, vertex.u, vertex.v})
+        seed ^= std::hash<double>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+      return seed;
+    }
+  };
+
+  std::size_t vertexCount = source.vertices.size()/3;
+  if (source.colors.size()!=vertexCount || source.uvs.size()!=vertexCount*2) {
+    copyMesh(utymap::math::Vector3(0, 0, 0), source, destination);
+    return;
+  }
+
+  destination.vertices.reserve(source.vertices.size());
+  destination.colors.reserve(source.colors.size());
+  destination.uvs.reserve(source.uvs.size());
+  destination.triangles.reserve(source.triangles.size());
+
+  std::unordered_map<Vertex, int, VertexHash> indices(vertexCount);
+  std::vector<int> remap(vertexCount);
+  std::size_t uvMapIndex = 0;
+
+  // NOTE uv map contains end of texture range in uvs followed by seven texture values.
+  auto copyUvMapEntry = [&]() {
+    destination.uvMap.push_back(static_cast<int>(destination.uvs.size()));
+    destination.uvMap.insert(destination.uvMap.end(),
+                             source.uvMap.begin() + uvMapIndex + 1,
+                             source.uvMap.begin() + uvMapIndex + 8);
+    uvMapIndex += 8;
+    indices.clear();
+  };
+
+  for (std::size_t i = 0; i < vertexCount; ++i) {
+    while (uvMapIndex + 8 <= source.uvMap.size() && source.uvMap[uvMapIndex] <= static_cast<int>(i*2))
+      copyUvMapEntry();
+
+    Vertex vertex {source.vertices[i*3], source.vertices[i*3 + 1], source.vertices[i*3 + 2],
+                   source.uvs[i*2], source.uvs[i*2 + 1], source.colors[i]};
+    auto result = indices.emplace(vertex, static_cast<int>(destination.vertices.size()/3));
+    remap[i] = result.first->second;
+    if (!result.second) continue;
+
+    destination.vertices.insert(destination.vertices.end(), {vertex.x, vertex.y, vertex.z});
+    destination.colors.push_back(vertex.color);
+    destination.uvs.insert(destination.uvs.end(), {vertex.u, vertex.v});
+  }
 
-  for (int j = 0; j < count; ++j) {
-    GeoCoordinate newPosition = GeoUtils::newPoint(p1, p2, static_cast<double>(j)/count);
+  while (uvMapIndex + 8 <= source.uvMap.size())
+    copyUvMapEntry();
 
-    const auto elevation = eleProvider.getElevation(quadKey, newPosition);
-    const auto offset = utymap::math::Vector3(newPosition.longitude - position.longitude,
-                                              elevation,
-                                              newPosition.latitude - position.latitude);
-    utymap::utils::copyMesh(offset, source, destination);
+  for (std::size_t i = 0; i + 2 < source.triangles.size(); i += 3) {
+    int a = remap[source.triangles[i]], b = remap[source.triangles[i + 1]], c = remap[source.triangles[i + 2]];
+    if (a==b || b==c || a==c) continue;
+    destination.triangles.insert(destination.triangles.end(), {a, b, c});
   }
 }
 
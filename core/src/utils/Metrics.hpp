@@ -0,0 +1,203 @@
+#ifndef UTILS_METRICS_HPP_DEFINED
+#define UTILS_METRICS_HPP_DEFINED
+
+#include "utils/AllocationTracker.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace utymap {
+namespace utils {
+
+/// Collects process wide counters and latency histograms of data pipeline, so host can
+/// scrape them into monitoring. Updates use relaxed atomics and take no locks.
+class Metrics final {
+ public:
+  enum class Counter {
+    StoreReads = 0,  // elements read from persistent store
+    StoreReadBytes,  // bytes of element data read from persistent store
+    BitmapLoads,     // bitmaps loaded from persistent store
+    StringHits,      // string ids found in string table
+    StringMisses,    // strings added to string table
+    StyleMatches,    // style provider requests for element
+    MeshCacheHits,   // tiles read from mesh cache
+    MeshCacheMisses, // tiles not found in mesh cache
+    MeshesBuilt,     // meshes passed to mesh callback
+    MeshVertices,    // vertices of meshes passed to mesh callback
+    ElevationLoads,  // elevation data cells loaded from disk
+    Count
+  };
+
+  enum class Latency {
+    Triangulation = 0, // polygon triangulation
+    TileBuild,         // building of tile
+    TileSearch,        // reading of tile elements from store
+    TileStyle,         // style matching of tile elements
+    TileMesh,          // running of builders, mesh welding and simplification
+    TileCallback,      // passing of tile meshes and elements to callbacks
+    Count
+  };
+
+  /// Caches which report their hits, misses and evictions.
+  enum class Cache {
+    Strings = 0, // strings of string table read from disk
+    Count
+  };
+
+  enum class CacheEvent {
+    Hit = 0,
+    Miss,
+    Eviction,
+    Count
+  };
+
+  /// Histogram bucket i counts durations below 2^i microseconds, the last one counts the rest.
+  static const std::size_t BucketCount = 24;
+
+  /// Measures time between construction and destruction.
+  class Timer final {
+   public:
+    explicit Timer(Latency latency) : latency_(latency), start_(std::chrono::steady_clock::now()) {}
+
+    ~Timer() {
+      record(latency_, std::chrono::steady_clock::now() - start_);
+    }
+
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+   private:
+    const Latency latency_;
+    const std::chrono::steady_clock::time_point start_;
+  };
+
+  static void add(Counter counter, std::uint64_t value = 1) {
+    instance().counters_[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  static void add(Cache cache, CacheEvent event, std::uint64_t value = 1) {
+    instance().caches_[static_cast<std::size_t>(cache)][static_cast<std::size_t>(event)]
+        .fetch_add(value, std::memory_order_relaxed);
+  }
+
+  static void record(Latency latency, std::chrono::steady_clock::duration duration) {
+    auto micros = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    std::size_t bucket = 0;
+    while (bucket + 1 < BucketCount && (std::uint64_t(1) << bucket) <= micros)
+      ++bucket;
+
+    auto &histogram = instance().histograms_[static_cast<std::size_t>(latency)];
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.sum.fetch_add(micros, std::memory_order_relaxed);
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static std::uint64_t get(Counter counter) {
+    return instance().counters_[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+  }
+
+  static std::uint64_t get(Cache cache, CacheEvent event) {
+    return instance().caches_[static_cast<std::size_t>(cache)][static_cast<std::size_t>(event)]
+        .load(std::memory_order_relaxed);
+  }
+
+  /// Returns sum of recorded durations in microseconds.
+  static std::uint64_t getSum(Latency latency) {
+    return instance().histograms_[static_cast<std::size_t>(latency)].sum.load(std::memory_order_relaxed);
+  }
+
+  /// Returns all metrics as json. Latency sum is in microseconds. Allocations of tile build
+  /// per subsystem are added if allocation tracking is enabled.
+  /// NOTE values are read one by one, so they are not consistent snapshot.
+  static std::string toJson() {
+    static const char *counterNames[] = {
+      "storeReads", "storeReadBytes", "bitmapLoads", "stringHits", "stringMisses", "styleMatches",
+      "meshCacheHits", "meshCacheMisses", "meshesBuilt", "meshVertices", "elevationLoads"
+    };
+    static const char *latencyNames[] = {
+      "triangulation", "tileBuild", "tileSearch", "tileStyle", "tileMesh", "tileCallback"
+    };
+    static const char *cacheNames[] = { "strings" };
+    static const char *cacheEventNames[] = { "hits", "misses", "evictions" };
+
+    const auto &metrics = instance();
+    std::stringstream ss;
+    ss << "{\"counters\":{";
+    for (std::size_t i = 0; i < static_cast<std::size_t>(Counter::Count); ++i)
+      ss << (i == 0 ? "" : ",") << "\"" << counterNames[i] << "\":" << metrics.counters_[i].load();
+
+    ss << "},\"latencies\":{";
+    for (std::size_t i = 0; i < static_cast<std::size_t>(Latency::Count); ++i) {
+      const auto &histogram = metrics.histograms_[i];
+      ss << (i == 0 ? "" : ",") << "\"" << latencyNames[i] << "\":{\"count\":" << histogram.count.load()
+         << ",\"sum\":" << histogram.sum.load() << ",\"buckets\":[";
+      for (std::size_t j = 0; j < BucketCount; ++j)
+        ss << (j == 0 ? "" : ",") << histogram.buckets[j].load();
+      ss << "]}";
+    }
+
+    ss << "},\"caches\":{";
+    for (std::size_t i = 0; i < static_cast<std::size_t>(Cache::Count); ++i) {
+      ss << (i == 0 ? "" : ",") << "\"" << cacheNames[i] << "\":{";
+      for (std::size_t j = 0; j < static_cast<std::size_t>(CacheEvent::Count); ++j)
+        ss << (j == 0 ? "" : ",") << "\"" << cacheEventNames[j] << "\":" << metrics.caches_[i][j].load();
+      ss << "}";
+    }
+    ss << "}";
+#ifdef ALLOCATION_TRACKING_ENABLED
+    ss << ",\"allocations\":" << AllocationTracker::toJson();
+#endif
+    ss << "}";
+    return ss.str();
+  }
+
+  /// Sets all metrics to zero.
+  static void reset() {
+    instance().clear();
+    AllocationTracker::reset();
+  }
+
+ private:
+  struct Histogram {
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> buckets[BucketCount];
+  };
+
+  Metrics() {
+    clear();
+  }
+
+  static Metrics &instance() {
+    static Metrics metrics;
+    return metrics;
+  }
+
+  void clear() {
+    for (auto &counter : counters_)
+      counter = 0;
+    for (auto &cache : caches_)
+      for (auto &event : cache)
+        event = 0;
+    for (auto &histogram : histograms_) {
+      histogram.count = 0;
+      histogram.sum = 0;
+      for (auto &bucket : histogram.buckets)
+        bucket = 0;
+    }
+  }
+
+  std::atomic<std::uint64_t> counters_[static_cast<std::size_t>(Counter::Count)];
+  Histogram histograms_[static_cast<std::size_t>(Latency::Count)];
+  std::atomic<std::uint64_t> caches_[static_cast<std::size_t>(Cache::Count)][static_cast<std::size_t>(CacheEvent::Count)];
+};
+
+}
+}
+
+#endif // UTILS_METRICS_HPP_DEFINED
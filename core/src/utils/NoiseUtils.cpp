@@ -1,10 +1,15 @@
 #include "utils/NoiseUtils.hpp"
 
+#include <algorithm>
+
 using namespace utymap::math;
 using namespace utymap::utils;
 
 const double Sqr2 = std::sqrt(2);
 
+/// Amount of points processed by one pass of batch noise calculation.
+const std::size_t BatchSize = 64;
+
 const int NoiseUtils::Hash[] =
     {
         151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
@@ -112,6 +117,64 @@ double NoiseUtils::perlin2D(double x, double y, double frequency) {
   return (a + b*tx + (c + d*tx)*ty)*Sqr2;
 }
 
+void NoiseUtils::perlin2D(const double *xs, const double *ys, double *out, std::size_t n, double frequency) {
+  if (frequency < 1E-5) {
+    std::fill(out, out + n, 0.);
+    return;
+  }
+
+  double tx0[BatchSize], ty0[BatchSize];
+  double g00x[BatchSize], g00y[BatchSize], g10x[BatchSize], g10y[BatchSize];
+  double g01x[BatchSize], g01y[BatchSize], g11x[BatchSize], g11y[BatchSize];
+
+  for (std::size_t start = 0; start < n; start += BatchSize) {
+    std::size_t count = std::min(BatchSize, n - start);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double x = xs[start + i]*frequency;
+      double y = ys[start + i]*frequency;
+      int ix0 = static_cast<int>(std::floor(x));
+      int iy0 = static_cast<int>(std::floor(y));
+      tx0[i] = x - ix0;
+      ty0[i] = y - iy0;
+      ix0 &= HashMask;
+      iy0 &= HashMask;
+
+      int h0 = Hash[ix0];
+      int h1 = Hash[ix0 + 1];
+      const Vector2 &g00 = Gradients2D[Hash[h0 + iy0] & GradientsMask2D];
+      const Vector2 &g10 = Gradients2D[Hash[h1 + iy0] & GradientsMask2D];
+      const Vector2 &g01 = Gradients2D[Hash[h0 + iy0 + 1] & GradientsMask2D];
+      const Vector2 &g11 = Gradients2D[Hash[h1 + iy0 + 1] & GradientsMask2D];
+      g00x[i] = g00.x, g00y[i] = g00.y;
+      g10x[i] = g10.x, g10y[i] = g10.y;
+      g01x[i] = g01.x, g01y[i] = g01.y;
+      g11x[i] = g11.x, g11y[i] = g11.y;
+    }
+
+    double *result = out + start;
+    for (std::size_t i = 0; i < count; ++i) {
+      double tx1 = tx0[i] - 1;
+      double ty1 = ty0[i] - 1;
+
+      double v00 = g00x[i]*tx0[i] + g00y[i]*ty0[i];
+      double v10 = g10x[i]*tx1 + g10y[i]*ty0[i];
+      double v01 = g01x[i]*tx0[i] + g01y[i]*ty1;
+      double v11 = g11x[i]*tx1 + g11y[i]*ty1;
+
+      double tx = smooth(tx0[i]);
+      double ty = smooth(ty0[i]);
+
+      double a = v00;
+      double b = v10 - v00;
+      double c = v01 - v00;
+      double d = v11 - v01 - v10 + v00;
+
+      result[i] = (a + b*tx + (c + d*tx)*ty)*Sqr2;
+    }
+  }
+}
+
 double NoiseUtils::perlin3D(double x, double y, double z, double frequency) {
   if (frequency < 1E-5) return 0;
 
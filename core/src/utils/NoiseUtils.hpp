@@ -4,6 +4,8 @@
 #include "math/Vector2.hpp"
 #include "math/Vector3.hpp"
 
+#include <cstddef>
+
 namespace utymap {
 namespace utils {
 
@@ -14,6 +16,11 @@ class NoiseUtils final {
   /// Calculates perlin 2D noise.
   static double perlin2D(double x, double y, double frequency);
 
+  /// Calculates perlin 2D noise for given amount of points at once.
+  /// NOTE table lookups are done in separate pass, so interpolation is done in
+  /// branchless loop which can be vectorized by compiler.
+  static void perlin2D(const double *xs, const double *ys, double *out, std::size_t n, double frequency);
+
   /// Calculates perlin 3D noise.
   static double perlin3D(double x, double y, double z, double freq);
 
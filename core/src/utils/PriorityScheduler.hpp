@@ -0,0 +1,220 @@
+#ifndef UTILS_PRIORITYSCHEDULER_HPP_DEFINED
+#define UTILS_PRIORITYSCHEDULER_HPP_DEFINED
+
+#include "CancellationToken.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utymap {
+namespace utils {
+
+/// Runs tasks on fixed amount of worker threads picking pending task with the highest
+/// priority first. Tasks with equal priority run in submission order. Every task gets
+/// its own cancellation token, so pending and running tasks can be cancelled by priority.
+/// NOTE bigger value means more important task, e.g. negative distance to camera.
+class PriorityScheduler final {
+ public:
+  /// Task receives token which is cancelled when task becomes obsolete.
+  typedef std::function<void(const utymap::CancellationToken &)> Task;
+
+  /// Creates scheduler which runs up to given amount of tasks at the same time. Tasks are run
+  /// on given pool if it is set, otherwise on own worker threads.
+  /// NOTE pool should have workers.
+  explicit PriorityScheduler(std::size_t threadCount, ThreadPool *threadPool = nullptr) :
+    threadPool_(threadPool), threadCount_(threadCount), runners_(0), sequence_(0), isStopped_(false) {
+    if (threadPool_ != nullptr)
+      return;
+    for (std::size_t i = 0; i < threadCount; ++i)
+      workers_.emplace_back([this]() { run(); });
+  }
+
+  PriorityScheduler(const PriorityScheduler &) = delete;
+  PriorityScheduler &operator=(const PriorityScheduler &) = delete;
+
+  /// Waits for pending tasks and stops workers.
+  ~PriorityScheduler() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      isStopped_ = true;
+    }
+    condition_.notify_all();
+    for (auto &worker : workers_)
+      worker.join();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [&]() { return runners_ == 0; });
+  }
+
+  /// Returns max amount of tasks which run at the same time.
+  std::size_t size() const {
+    return threadCount_;
+  }
+
+  /// Queues task with given id and priority. Id is used to reprioritize task later
+  /// and doesn't have to be unique.
+  /// NOTE task is called exactly once, cancelled task should return as soon as possible.
+  void submit(int id, double priority, Task task) {
+    bool hasRunner = true;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back(Entry { id, priority, sequence_++,
+                                 std::make_shared<utymap::CancellationToken>(), std::move(task) });
+      if (threadPool_ != nullptr && runners_ < threadCount_) {
+        ++runners_;
+        hasRunner = false;
+      }
+    }
+    if (hasRunner)
+      condition_.notify_one();
+    else
+      threadPool_->post([this]() { runOnPool(); });
+  }
+
+  /// Changes priority of pending tasks with given id. Returns amount of affected tasks.
+  std::size_t reprioritize(int id, double priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = 0;
+    for (auto &entry : pending_) {
+      if (entry.id==id && !entry.token->isCancelled()) {
+        entry.priority = priority;
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  /// Cancels pending and running tasks which priority is below given threshold.
+  /// Returns amount of cancelled tasks.
+  std::size_t cancelBelow(double threshold) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = 0;
+    for (auto &entry : pending_) {
+      if (entry.priority < threshold && !entry.token->isCancelled()) {
+        entry.token->cancel();
+        ++count;
+      }
+    }
+    for (auto &pair : running_) {
+      if (pair.second.priority < threshold && !pair.second.token->isCancelled()) {
+        pair.second.token->cancel();
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  /// Returns amount of tasks which are not started yet.
+  std::size_t pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+  }
+
+ private:
+  struct Entry {
+    int id;
+    double priority;
+    std::uint64_t sequence;
+    std::shared_ptr<utymap::CancellationToken> token;
+    Task task;
+  };
+
+  struct Running {
+    double priority;
+    std::shared_ptr<utymap::CancellationToken> token;
+  };
+
+  /// Finds pending task to run next: cancelled tasks are drained first as they finish
+  /// immediately, then the highest priority wins.
+  std::vector<Entry>::iterator next() {
+    auto best = pending_.begin();
+    for (auto it = pending_.begin() + 1; it < pending_.end(); ++it) {
+      bool isCancelled = it->token->isCancelled();
+      bool isBestCancelled = best->token->isCancelled();
+      if (isCancelled!=isBestCancelled) {
+        if (isCancelled) best = it;
+        continue;
+      }
+      if (it->priority > best->priority ||
+          (it->priority==best->priority && it->sequence < best->sequence))
+        best = it;
+    }
+    return best;
+  }
+
+  /// Moves next pending task to running ones.
+  /// NOTE should be called under lock when there are pending tasks.
+  Entry take() {
+    auto it = next();
+    Entry entry = std::move(*it);
+    pending_.erase(it);
+    running_[entry.sequence] = Running { entry.priority, entry.token };
+    return entry;
+  }
+
+  void execute(Entry &entry) {
+    try {
+      entry.task(*entry.token);
+    } catch (...) {
+      // NOTE task is expected to report its errors, worker should survive anyway.
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_.erase(entry.sequence);
+  }
+
+  void run() {
+    while (true) {
+      Entry entry;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [&]() { return isStopped_ || !pending_.empty(); });
+        if (pending_.empty())
+          return;
+        entry = take();
+      }
+      execute(entry);
+    }
+  }
+
+  /// Runs one task on pool and queues itself again while there are pending tasks.
+  void runOnPool() {
+    Entry entry;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (pending_.empty()) {
+        --runners_;
+        condition_.notify_all();
+        return;
+      }
+      entry = take();
+    }
+    execute(entry);
+    // NOTE runner goes to the end of pool queue, so it doesn't starve tasks of other components.
+    threadPool_->post([this]() { runOnPool(); });
+  }
+
+  ThreadPool *threadPool_;
+  const std::size_t threadCount_;
+  /// Amount of runners which are queued or running on pool.
+  std::size_t runners_;
+  std::vector<std::thread> workers_;
+  std::vector<Entry> pending_;
+  std::map<std::uint64_t, Running> running_;
+  std::uint64_t sequence_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  bool isStopped_;
+};
+
+}
+}
+
+#endif // UTILS_PRIORITYSCHEDULER_HPP_DEFINED
@@ -0,0 +1,79 @@
+#ifndef UTILS_READWRITELOCK_HPP_DEFINED
+#define UTILS_READWRITELOCK_HPP_DEFINED
+
+#include <condition_variable>
+#include <mutex>
+
+namespace utymap {
+namespace utils {
+
+/// Implements reader-writer lock: allows many readers or one writer.
+/// Waiting writers have priority over new readers.
+/// NOTE std::shared_mutex is not available in C++11.
+class ReadWriteLock final {
+ public:
+  ReadWriteLock() : readers_(0), waitingWriters_(0), hasWriter_(false) {}
+
+  ReadWriteLock(const ReadWriteLock &) = delete;
+  ReadWriteLock &operator=(const ReadWriteLock &) = delete;
+
+  /// Acquires exclusive ownership.
+  void lock() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++waitingWriters_;
+    condition_.wait(lock, [&]() { return !hasWriter_ && readers_ == 0; });
+    --waitingWriters_;
+    hasWriter_ = true;
+  }
+
+  /// Releases exclusive ownership.
+  void unlock() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hasWriter_ = false;
+    condition_.notify_all();
+  }
+
+  /// Acquires shared ownership.
+  void lock_shared() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [&]() { return !hasWriter_ && waitingWriters_ == 0; });
+    ++readers_;
+  }
+
+  /// Releases shared ownership.
+  void unlock_shared() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--readers_ == 0)
+      condition_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  int readers_;
+  int waitingWriters_;
+  bool hasWriter_;
+};
+
+/// Holds shared ownership of reader-writer lock while in scope.
+class SharedLock final {
+ public:
+  explicit SharedLock(ReadWriteLock &lock) : lock_(lock) {
+    lock_.lock_shared();
+  }
+
+  ~SharedLock() {
+    lock_.unlock_shared();
+  }
+
+  SharedLock(const SharedLock &) = delete;
+  SharedLock &operator=(const SharedLock &) = delete;
+
+ private:
+  ReadWriteLock &lock_;
+};
+
+}
+}
+
+#endif // UTILS_READWRITELOCK_HPP_DEFINED
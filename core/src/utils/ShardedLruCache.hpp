@@ -0,0 +1,200 @@
+#ifndef UTILS_SHARDEDLRUCACHE_HPP_DEFINED
+#define UTILS_SHARDEDLRUCACHE_HPP_DEFINED
+
+#include "utils/LruCache.hpp"
+#include "utils/Metrics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace utymap {
+namespace utils {
+
+/// Implements thread safe Least Recently Used cache. Keys are split between shards by hash,
+/// so threads which access different shards don't contend. Every shard has own part of
+/// capacity and evicts its own least recently used values. If size function is given,
+/// shard also keeps sum of value sizes below its part of max bytes.
+/// Hits, misses and evictions are counted and added to metrics if cache is registered there.
+template<typename Key, typename Value, std::size_t ShardCount = 8,
+    typename Hash = std::hash<Key>, typename Comparator = std::less<Key>>
+class ShardedLruCache final {
+ public:
+  typedef std::function<std::size_t(const Value &)> SizeFunction;
+
+  /// Creates cache which keeps up to capacity values. Cache is registered in metrics unless
+  /// metrics cache is Count.
+  ShardedLruCache(std::size_t capacity,
+                  Metrics::Cache metricsCache = Metrics::Cache::Count,
+                  const SizeFunction &sizeOf = nullptr,
+                  std::size_t maxBytes = std::numeric_limits<std::size_t>::max()) :
+      shardCapacity_(std::max<std::size_t>(1, (capacity + ShardCount - 1) / ShardCount)),
+      shardMaxBytes_(maxBytes / ShardCount),
+      metricsCache_(metricsCache),
+      sizeOf_(sizeOf),
+      hits_(0), misses_(0), evictions_(0) {}
+
+  ShardedLruCache(const ShardedLruCache &) = delete;
+  ShardedLruCache &operator=(const ShardedLruCache &) = delete;
+
+  /// Returns cached value promoting it higher or loads it with loader and puts to cache.
+  /// Loader is called with key and returns shared value or nullptr which is not cached.
+  /// NOTE loader is called without lock, so it can use cache or locks of its owner.
+  /// Concurrent misses of the same key may load it several times, the last value is kept.
+  template<typename Loader>
+  std::shared_ptr<Value> getOrLoad(const Key &key, const Loader &loader) {
+    if (auto value = find(key))
+      return value;
+
+    auto value = loader(key);
+    if (value != nullptr)
+      put(key, value);
+    return value;
+  }
+
+  /// Returns value from cache promoting it higher or nullptr if there is no such key.
+  std::shared_ptr<Value> find(const Key &key) {
+    auto &shard = getShard(key);
+    {
+      std::lock_guard<std::mutex> lock(shard.lock);
+      if (shard.cache.exists(key)) {
+        count(hits_, Metrics::CacheEvent::Hit);
+        return shard.cache.get(key);
+      }
+    }
+    count(misses_, Metrics::CacheEvent::Miss);
+    return nullptr;
+  }
+
+  /// Puts shared value to cache.
+  void put(const Key &key, const std::shared_ptr<Value> &value) {
+    auto &shard = getShard(key);
+    std::size_t evicted = 0;
+    {
+      std::lock_guard<std::mutex> lock(shard.lock);
+      if (sizeOf_ && shard.cache.exists(key))
+        shard.bytes -= sizeOf_(*shard.cache.peek(key));
+      shard.cache.put(key, value);
+      if (sizeOf_)
+        shard.bytes += sizeOf_(*value);
+      evicted = evict(shard, shardCapacity_, shardMaxBytes_);
+    }
+    if (evicted > 0)
+      count(evictions_, Metrics::CacheEvent::Eviction, evicted);
+  }
+
+  /// Puts value to cache.
+  void put(const Key &key, Value &&value) {
+    put(key, std::make_shared<Value>(std::move(value)));
+  }
+
+  /// Removes value with given key from cache. Returns false if there is no such key.
+  bool remove(const Key &key) {
+    auto &shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.lock);
+    if (sizeOf_ && shard.cache.exists(key))
+      shard.bytes -= sizeOf_(*shard.cache.peek(key));
+    return shard.cache.remove(key);
+  }
+
+  /// Returns current amount of values.
+  std::size_t size() const {
+    std::size_t size = 0;
+    for (auto &shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.lock);
+      size += shard.cache.size();
+    }
+    return size;
+  }
+
+  /// Returns sum of sizes of cached values or zero if there is no size function.
+  std::size_t weigh() const {
+    std::size_t bytes = 0;
+    for (auto &shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.lock);
+      bytes += shard.bytes;
+    }
+    return bytes;
+  }
+
+  /// Removes least recently used values of every shard until sum of value sizes doesn't
+  /// exceed given limit. Returns sum of sizes of remaining values.
+  /// NOTE does nothing if there is no size function.
+  std::size_t trim(std::size_t maxBytes) {
+    std::size_t bytes = 0, evicted = 0;
+    for (auto &shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.lock);
+      evicted += evict(shard, shardCapacity_, maxBytes / ShardCount);
+      bytes += shard.bytes;
+    }
+    if (evicted > 0)
+      count(evictions_, Metrics::CacheEvent::Eviction, evicted);
+    return bytes;
+  }
+
+  /// Clears cache. Cleared values are not counted as evicted.
+  void clear() {
+    for (auto &shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.lock);
+      shard.cache.clear();
+      shard.bytes = 0;
+    }
+  }
+
+  std::uint64_t getHits() const { return hits_.load(std::memory_order_relaxed); }
+  std::uint64_t getMisses() const { return misses_.load(std::memory_order_relaxed); }
+  std::uint64_t getEvictions() const { return evictions_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Shard {
+    /// NOTE capacity is checked by sharded cache, so eviction can be counted.
+    Shard() : cache(std::numeric_limits<std::size_t>::max()), bytes(0) {}
+
+    mutable std::mutex lock;
+    LruCache<Key, Value, Comparator> cache;
+    std::size_t bytes;
+  };
+
+  Shard &getShard(const Key &key) {
+    return shards_[Hash()(key) % ShardCount];
+  }
+
+  /// Removes least recently used values of shard above limits. Returns amount of them.
+  /// NOTE should be called under shard lock.
+  std::size_t evict(Shard &shard, std::size_t maxCount, std::size_t maxBytes) {
+    std::size_t evicted = 0;
+    while (shard.cache.size() > maxCount || (sizeOf_ && shard.bytes > maxBytes && shard.cache.size() > 0)) {
+      if (sizeOf_)
+        shard.bytes -= sizeOf_(*shard.cache.peek(shard.cache.lastKey()));
+      shard.cache.removeLast();
+      ++evicted;
+    }
+    return evicted;
+  }
+
+  void count(std::atomic<std::uint64_t> &counter, Metrics::CacheEvent event, std::uint64_t value = 1) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+    if (metricsCache_ != Metrics::Cache::Count)
+      Metrics::add(metricsCache_, event, value);
+  }
+
+  const std::size_t shardCapacity_;
+  const std::size_t shardMaxBytes_;
+  const Metrics::Cache metricsCache_;
+  const SizeFunction sizeOf_;
+  std::array<Shard, ShardCount> shards_;
+  std::atomic<std::uint64_t> hits_;
+  std::atomic<std::uint64_t> misses_;
+  std::atomic<std::uint64_t> evictions_;
+};
+
+}
+}
+
+#endif // UTILS_SHARDEDLRUCACHE_HPP_DEFINED
@@ -0,0 +1,114 @@
+#ifndef UTILS_SINGLEFLIGHT_HPP_DEFINED
+#define UTILS_SINGLEFLIGHT_HPP_DEFINED
+
+#include "CancellationToken.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace utymap {
+namespace utils {
+
+/// Coalesces concurrent calls with the same key: the first caller runs work and callers
+/// which arrive while it is running wait for its result instead of repeating the work.
+/// Result is not kept once all callers got it, so it is not a cache.
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class SingleFlight final {
+ public:
+  typedef std::shared_ptr<const Value> Result;
+
+  SingleFlight() = default;
+  SingleFlight(const SingleFlight &) = delete;
+  SingleFlight &operator=(const SingleFlight &) = delete;
+
+  /// Runs work for given key or waits for result of work which is already running.
+  /// Work returns null if it has no result to share, e.g. when it is cancelled. Leader
+  /// flag tells whether work was run by this call.
+  /// NOTE waiting stops once token is cancelled and null is returned. Exception of work
+  /// is rethrown to its caller only, waiting callers get null.
+  template<typename Work>
+  Result run(const Key &key, const Work &work, const utymap::CancellationToken &cancelToken, bool &isLeader) {
+    std::shared_ptr<Flight> flight;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      auto &current = flights_[key];
+      isLeader = current == nullptr;
+      if (isLeader)
+        current = std::make_shared<Flight>();
+      flight = current;
+    }
+
+    if (isLeader)
+      return lead(key, *flight, work);
+
+    return wait(*flight, cancelToken);
+  }
+
+  /// Returns amount of running flights.
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return flights_.size();
+  }
+
+ private:
+  /// Period of checking cancellation by waiting callers.
+  static std::chrono::milliseconds pollInterval() {
+    return std::chrono::milliseconds(10);
+  }
+
+  struct Flight final {
+    std::mutex lock;
+    std::condition_variable condition;
+    bool isCompleted = false;
+    Result result;
+  };
+
+  template<typename Work>
+  Result lead(const Key &key, Flight &flight, const Work &work) {
+    Result result;
+    try {
+      result = work();
+    } catch (...) {
+      complete(key, flight, nullptr);
+      throw;
+    }
+    complete(key, flight, result);
+    return result;
+  }
+
+  void complete(const Key &key, Flight &flight, const Result &result) {
+    {
+      // NOTE flight is removed first, so callers which come later start new one.
+      std::lock_guard<std::mutex> lock(lock_);
+      flights_.erase(key);
+    }
+    {
+      std::lock_guard<std::mutex> lock(flight.lock);
+      flight.result = result;
+      flight.isCompleted = true;
+    }
+    flight.condition.notify_all();
+  }
+
+  static Result wait(Flight &flight, const utymap::CancellationToken &cancelToken) {
+    std::unique_lock<std::mutex> lock(flight.lock);
+    while (!flight.isCompleted) {
+      if (cancelToken.isCancelled())
+        return nullptr;
+      flight.condition.wait_for(lock, pollInterval());
+    }
+    return flight.result;
+  }
+
+  mutable std::mutex lock_;
+  std::unordered_map<Key, std::shared_ptr<Flight>, Hash> flights_;
+};
+
+}
+}
+
+#endif // UTILS_SINGLEFLIGHT_HPP_DEFINED
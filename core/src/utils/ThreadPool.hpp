@@ -0,0 +1,312 @@
+#ifndef UTILS_THREADPOOL_HPP_DEFINED
+#define UTILS_THREADPOOL_HPP_DEFINED
+
+#include "utils/CoreUtils.hpp"
+#include "utils/ReadWriteLock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace utymap {
+namespace utils {
+
+/// Runs tasks on worker threads. Every worker has own task deque: tasks queued by worker go to
+/// its deque and are taken back in LIFO order, idle workers steal the oldest tasks of others.
+/// Worker which waits for task which is not started yet runs it itself, so tasks can wait for
+/// nested tasks of the same pool without exhausting workers.
+class ThreadPool final {
+  struct Job {
+    explicit Job(std::function<void()> &&function) : isClaimed(false), task(std::move(function)) {}
+
+    /// Runs task unless it is already taken by other thread.
+    void run() {
+      if (!isClaimed.exchange(true))
+        task();
+    }
+
+    std::atomic<bool> isClaimed;
+    std::packaged_task<void()> task;
+  };
+
+  struct Queue {
+    std::deque<std::shared_ptr<Job>> jobs;
+    std::mutex mutex;
+  };
+
+ public:
+  /// Result of queued task.
+  class Future final {
+   public:
+    Future() : pool_(nullptr) {}
+
+    bool valid() const {
+      return future_.valid();
+    }
+
+    /// Waits for task. Worker of the same pool or any thread if pool has no workers runs
+    /// task itself if it is not started yet.
+    void wait() {
+      if (pool_ != nullptr && (pool_->isWorker() || pool_->size() == 0))
+        job_->run();
+      future_.wait();
+    }
+
+    /// Waits for task and rethrows its exception.
+    void get() {
+      wait();
+      future_.get();
+    }
+
+    /// Returns true if task is finished.
+    bool isReady() const {
+      return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+   private:
+    friend class ThreadPool;
+    Future(const ThreadPool *pool, const std::shared_ptr<Job> &job) :
+      pool_(pool), job_(job), future_(job->task.get_future()) {}
+
+    const ThreadPool *pool_;
+    std::shared_ptr<Job> job_;
+    std::future<void> future_;
+  };
+
+  /// Creates pool with given amount of workers. Core mask selects cores which workers are bound
+  /// to, e.g. big cores of big.LITTLE device, zero means any core. Niceness is added to
+  /// scheduling priority of workers: positive value makes them yield to other threads.
+  /// NOTE affinity and niceness are applied on linux and android only, failures are ignored.
+  explicit ThreadPool(std::size_t threadCount, std::uint64_t coreMask = 0, int niceness = 0) :
+    pending_(0), workerCount_(0), isStopped_(false) {
+    start(threadCount, coreMask, niceness);
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Waits for queued tasks and stops workers.
+  ~ThreadPool() {
+    stop();
+  }
+
+  /// Returns amount of worker threads.
+  std::size_t size() const {
+    return workerCount_;
+  }
+
+  /// Replaces workers with new ones, queued tasks are finished by old workers first.
+  /// Other threads which queue tasks meanwhile wait until new workers are started.
+  /// NOTE should not be called by task of the pool.
+  void configure(std::size_t threadCount, std::uint64_t coreMask = 0, int niceness = 0) {
+    std::lock_guard<ReadWriteLock> lock(configureLock_);
+    stop();
+    start(threadCount, coreMask, niceness);
+  }
+
+  /// Queues task. Returned future rethrows exception thrown by task.
+  /// NOTE task queued by worker is likely run by the same worker.
+  Future enqueue(std::function<void()> function) {
+    auto job = std::make_shared<Job>(std::move(function));
+    Future future(this, job);
+    if (isWorker())
+      push(*queues_[current().second], job);
+    else
+      pushInjected(job);
+    return future;
+  }
+
+  /// Queues task to the end of shared queue even if it is called by worker, so
+  /// task which queues its continuation lets tasks queued before run first.
+  Future post(std::function<void()> function) {
+    auto job = std::make_shared<Job>(std::move(function));
+    Future future(this, job);
+    pushInjected(job);
+    return future;
+  }
+
+ private:
+  /// Worker identity: pool and index of worker in it.
+  static std::pair<const ThreadPool *, std::size_t> &current() {
+    static thread_local std::pair<const ThreadPool *, std::size_t> worker(nullptr, 0);
+    return worker;
+  }
+
+  bool isWorker() const {
+    return current().first == this;
+  }
+
+  /// Pushes job to shared queue.
+  /// NOTE workers keep their queues until they are stopped, so only other threads wait for configure.
+  void pushInjected(const std::shared_ptr<Job> &job) {
+    if (isWorker()) {
+      push(injected_, job);
+      return;
+    }
+    SharedLock lock(configureLock_);
+    push(injected_, job);
+  }
+
+  void push(Queue &queue, const std::shared_ptr<Job> &job) {
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.jobs.push_back(job);
+      ++pending_;
+    }
+    // NOTE lock ensures that worker which has just checked counter is already waiting.
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    condition_.notify_one();
+  }
+
+  /// Takes job from own deque first, then from shared queue, then steals from other workers.
+  std::shared_ptr<Job> take(std::size_t index) {
+    std::shared_ptr<Job> job;
+    if (pop(*queues_[index], false, job) || pop(injected_, true, job))
+      return job;
+    for (std::size_t i = 1; i < queues_.size(); ++i) {
+      if (pop(*queues_[(index + i) % queues_.size()], true, job))
+        return job;
+    }
+    return nullptr;
+  }
+
+  bool pop(Queue &queue, bool isOldest, std::shared_ptr<Job> &job) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+      return false;
+    if (isOldest) {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+    } else {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+    }
+    --pending_;
+    return true;
+  }
+
+  void start(std::size_t threadCount, std::uint64_t coreMask, int niceness) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      isStopped_ = false;
+    }
+    for (std::size_t i = 0; i < threadCount; ++i)
+      queues_.push_back(utymap::utils::make_unique<Queue>());
+    for (std::size_t i = 0; i < threadCount; ++i)
+      workers_.emplace_back([this, i, coreMask, niceness]() {
+        current() = std::make_pair(this, i);
+        setupThread(coreMask, niceness);
+        run(i);
+      });
+    workerCount_ = threadCount;
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      isStopped_ = true;
+    }
+    condition_.notify_all();
+    for (auto &worker : workers_)
+      worker.join();
+    workers_.clear();
+    queues_.clear();
+    workerCount_ = 0;
+  }
+
+  void run(std::size_t index) {
+    while (true) {
+      auto job = take(index);
+      if (job != nullptr) {
+        job->run();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [&]() { return isStopped_ || pending_ > 0; });
+      if (isStopped_ && pending_ == 0)
+        return;
+    }
+  }
+
+  static void setupThread(std::uint64_t coreMask, int niceness) {
+#ifdef __linux__
+    if (coreMask != 0) {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      for (int core = 0; core < 64 && core < CPU_SETSIZE; ++core) {
+        if ((coreMask >> core) & 1)
+          CPU_SET(core, &cpuSet);
+      }
+      sched_setaffinity(0, sizeof(cpuSet), &cpuSet);
+    }
+    if (niceness != 0)
+      setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), niceness);
+#else
+    (void) coreMask;
+    (void) niceness;
+#endif
+  }
+
+  std::vector<std::thread> workers_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  /// Tasks queued by threads which are not workers.
+  Queue injected_;
+  std::atomic<std::size_t> pending_;
+  /// Amount of workers which is read by other threads while pool is configured.
+  std::atomic<std::size_t> workerCount_;
+  std::mutex mutex_;
+  /// Held exclusively by configure and shared by threads which queue tasks.
+  ReadWriteLock configureLock_;
+  std::condition_variable condition_;
+  bool isStopped_;
+};
+
+/// Pool which component uses to run given amount of tasks in parallel: shared pool if component
+/// has one, otherwise own pool with that amount of threads, e.g. when component is created
+/// outside of application.
+class ThreadPoolShare final {
+ public:
+  explicit ThreadPoolShare(ThreadPool *sharedPool = nullptr) : sharedPool_(sharedPool), size_(0) {}
+
+  /// Sets amount of parallel tasks. Zero means that tasks are run on calling thread.
+  void resize(std::size_t size) {
+    size_ = size;
+    ownPool_ = size > 0 && sharedPool_ == nullptr ? utymap::utils::make_unique<ThreadPool>(size) : nullptr;
+  }
+
+  /// Returns amount of parallel tasks.
+  std::size_t size() const {
+    return size_;
+  }
+
+  /// Returns pool or null if tasks should be run on calling thread.
+  ThreadPool *get() const {
+    return size_ == 0 ? nullptr : (sharedPool_ != nullptr ? sharedPool_ : ownPool_.get());
+  }
+
+ private:
+  ThreadPool *sharedPool_;
+  std::unique_ptr<ThreadPool> ownPool_;
+  std::size_t size_;
+};
+
+}
+}
+
+#endif // UTILS_THREADPOOL_HPP_DEFINED
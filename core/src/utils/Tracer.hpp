@@ -0,0 +1,137 @@
+#ifndef UTILS_TRACER_HPP_DEFINED
+#define UTILS_TRACER_HPP_DEFINED
+
+#include "QuadKey.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace utymap {
+namespace utils {
+
+/// Collects timed zones of tile builds while tracing is started and writes them as
+/// chrome trace event json which can be opened in chrome://tracing or Perfetto UI.
+/// NOTE zones are compiled in only if TRACING_ENABLED is defined, see TRACE_ZONE macro.
+class Tracer final {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// Completed zone. Name should be string literal.
+  struct Event {
+    const char *name;
+    std::uint64_t start;    // microseconds since tracing is started
+    std::uint64_t duration; // microseconds
+    std::size_t threadId;
+    int tag;
+    utymap::QuadKey quadKey;
+  };
+
+  /// Measures time between construction and destruction if tracing is started.
+  class Zone final {
+   public:
+    Zone(const char *name, const utymap::QuadKey &quadKey = utymap::QuadKey(), int tag = -1) :
+        name_(isStarted() ? name : nullptr), tag_(tag), quadKey_(quadKey),
+        start_(name_ != nullptr ? Clock::now() : Clock::time_point()) {}
+
+    ~Zone() {
+      if (name_ != nullptr)
+        instance().add(name_, start_, Clock::now(), tag_, quadKey_);
+    }
+
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+
+   private:
+    const char *name_;
+    const int tag_;
+    const utymap::QuadKey quadKey_;
+    const Clock::time_point start_;
+  };
+
+  /// Discards collected zones and starts collecting new ones.
+  static void start() {
+    auto &tracer = instance();
+    std::lock_guard<std::mutex> lock(tracer.lock_);
+    tracer.events_.clear();
+    tracer.origin_ = Clock::now();
+    tracer.isStarted_ = true;
+  }
+
+  /// Stops collecting zones and returns them as json.
+  static std::string stop() {
+    auto &tracer = instance();
+    std::lock_guard<std::mutex> lock(tracer.lock_);
+    tracer.isStarted_ = false;
+    std::string json = toJson(tracer.events_);
+    tracer.events_.clear();
+    return json;
+  }
+
+  static bool isStarted() {
+    return instance().isStarted_.load(std::memory_order_relaxed);
+  }
+
+  /// Converts events to chrome trace json with complete ("X") events.
+  static std::string toJson(const std::vector<Event> &events) {
+    std::stringstream ss;
+    ss << "{\"traceEvents\":[";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      const auto &event = events[i];
+      ss << (i == 0 ? "" : ",") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1"
+         << ",\"tid\":" << event.threadId << ",\"ts\":" << event.start << ",\"dur\":" << event.duration
+         << ",\"args\":{\"tag\":" << event.tag << ",\"quadKey\":\"" << event.quadKey.levelOfDetail << "/"
+         << event.quadKey.tileX << "/" << event.quadKey.tileY << "\"}}";
+    }
+    ss << "],\"displayTimeUnit\":\"ms\"}";
+    return ss.str();
+  }
+
+ private:
+  Tracer() : isStarted_(false) {}
+
+  static Tracer &instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  void add(const char *name, Clock::time_point start, Clock::time_point end, int tag, const utymap::QuadKey &quadKey) {
+    // NOTE thread ids are hashed as chrome expects numbers.
+    std::size_t threadId = std::hash<std::thread::id>()(std::this_thread::get_id()) % 1000000;
+    std::lock_guard<std::mutex> lock(lock_);
+    // NOTE zone which was started before tracing is dropped.
+    if (!isStarted_ || start < origin_)
+      return;
+    events_.push_back(Event { name, toMicros(start - origin_), toMicros(end - start), threadId, tag, quadKey });
+  }
+
+  static std::uint64_t toMicros(Clock::duration duration) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+  }
+
+  std::atomic<bool> isStarted_;
+  Clock::time_point origin_;
+  std::vector<Event> events_;
+  std::mutex lock_;
+};
+
+}
+}
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+/// Declares zone which lasts till the end of scope. Arguments are name and optionally quadkey and tag.
+#ifdef TRACING_ENABLED
+#define TRACE_ZONE(...) utymap::utils::Tracer::Zone TRACE_CONCAT(traceZone, __LINE__)(__VA_ARGS__)
+#else
+#define TRACE_ZONE(...) ((void) 0)
+#endif
+
+#endif // UTILS_TRACER_HPP_DEFINED
@@ -67,4 +67,16 @@ BOOST_AUTO_TEST_CASE(GivenBoundingBox_WhenExpandOperator_ThenReturnExpanded) {
   BOOST_CHECK_CLOSE(a.maxPoint.longitude, 15, Precision);
 }
 
+BOOST_AUTO_TEST_CASE(GivenCoordinates_WhenExpand_ThenReturnExpanded) {
+  BoundingBox a;
+  std::vector<GeoCoordinate> coordinates = { {1, 5}, {-2, 3}, {4, -1} };
+
+  a.expand(coordinates.begin(), coordinates.end());
+
+  BOOST_CHECK_CLOSE(a.minPoint.latitude, -2, Precision);
+  BOOST_CHECK_CLOSE(a.minPoint.longitude, -1, Precision);
+  BOOST_CHECK_CLOSE(a.maxPoint.latitude, 4, Precision);
+  BOOST_CHECK_CLOSE(a.maxPoint.longitude, 5, Precision);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,55 @@
+#include "CancellationToken.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+
+BOOST_AUTO_TEST_SUITE(CancellationToken_Suite)
+
+BOOST_AUTO_TEST_CASE(GivenTokenWithPassedDeadline_WhenIsCancelled_ThenReturnsTrue) {
+  CancellationToken token;
+
+  token.setDeadline(std::chrono::milliseconds(-1));
+
+  BOOST_CHECK(token.hasDeadline());
+  BOOST_CHECK(token.isCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(GivenTokenWithFutureDeadline_WhenIsCancelled_ThenReturnsFalse) {
+  CancellationToken token;
+
+  token.setDeadline(std::chrono::hours(1));
+
+  BOOST_CHECK(!token.isCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(GivenTokenWithDeadline_WhenLaterDeadlineIsSet_ThenEarlierIsKept) {
+  CancellationToken token;
+  token.setDeadline(std::chrono::milliseconds(-1));
+
+  token.setDeadline(std::chrono::hours(1));
+
+  BOOST_CHECK(token.isCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(GivenCancelledParent_WhenIsCancelled_ThenChildReturnsTrue) {
+  CancellationToken parent;
+  CancellationToken child(&parent);
+
+  parent.cancel();
+
+  BOOST_CHECK(child.isCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(GivenChildWithPassedDeadline_WhenIsCancelled_ThenParentReturnsFalse) {
+  CancellationToken parent;
+  CancellationToken child(&parent);
+
+  child.setDeadline(std::chrono::milliseconds(-1));
+
+  BOOST_CHECK(child.isCancelled());
+  BOOST_CHECK(!parent.isCancelled());
+  BOOST_CHECK(!parent.hasDeadline());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
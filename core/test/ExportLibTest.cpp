@@ -1,10 +1,16 @@
 #include "config.hpp"
 #include "ExportLib.cpp"
 
+#include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include "test_utils/ElementUtils.hpp"
 
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <thread>
+
 using namespace utymap::entities;
 using namespace utymap::utils;
 
@@ -14,6 +20,8 @@ const char *NaturalEarthMapcss = TEST_MAPCSS_PATH "natural_earth.z1.mapcss";
 
 // Use global variable as it is used inside lambda which is passed as function.
 bool isCalled;
+int batchCount;
+int elementCount;
 
 struct ExportLibFixture {
   ExportLibFixture() {
@@ -61,6 +69,14 @@ struct ExportLibFixture {
     ::disconnect();
     std::remove((std::string(TEST_ASSETS_PATH) + "string.idx").c_str());
     std::remove((std::string(TEST_ASSETS_PATH) + "string.dat").c_str());
+    std::remove((std::string(TEST_ASSETS_PATH) + "string.hsh").c_str());
+    std::remove((std::string(TEST_ASSETS_PATH) + "string.sld").c_str());
+
+    boost::filesystem::directory_iterator end;
+    for (boost::filesystem::directory_iterator it(TEST_ASSETS_PATH); it!=end; ++it) {
+      if (it->path().extension()==".style")
+        boost::filesystem::remove(it->path());
+    }
   }
 
   utymap::CancellationToken cancelToken;
@@ -96,6 +112,14 @@ BOOST_AUTO_TEST_CASE(GivenTestData_WhenDataIsLoadedInLodRangeAtDetailedZoom_Then
   loadQuadKeys(16, 35205, 35205, 21489, 21489);
 }
 
+BOOST_AUTO_TEST_CASE(GivenParallelBuilders_WhenDataIsLoadedAtDetailedZoom_ThenCallbacksAreCalled) {
+  ::setBuildThreads(2);
+  ::enableParallelBuilders(1);
+  ::addDataInRange(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 16, 16, callback, &cancelToken);
+
+  loadQuadKeys(16, 35205, 35205, 21489, 21489);
+}
+
 /// This case tests dynamic addition incremental addition/search to store.
 BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeysAreLoadedInSequenceAtDetailedZoom_ThenCallbacksAreCalled) {
   ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
@@ -111,6 +135,71 @@ BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoaded_ThenHasDataReturnsTrue) {
   BOOST_CHECK(::hasData(35205, 21489, 16));
 }
 
+BOOST_AUTO_TEST_CASE(GivenStartedRequestLog_WhenCallsAreMade_ThenTheyAreRecordedWithArguments) {
+  auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  BOOST_CHECK(::startRequestLog(path.c_str()));
+
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  ::hasData(35205, 21489, 16);
+  ::stopRequestLog();
+  ::hasData(35204, 21489, 16);
+
+  std::ifstream file(path);
+  std::string line;
+  std::vector<RequestLog::Entry> entries;
+  while (std::getline(file, line)) {
+    RequestLog::Entry entry;
+    BOOST_CHECK(RequestLog::parse(line, entry));
+    entries.push_back(entry);
+  }
+  BOOST_REQUIRE_EQUAL(entries.size(), 2);
+  BOOST_CHECK_EQUAL(entries[0].name, "addDataInQuadKey");
+  BOOST_CHECK_EQUAL(entries[0].args[2], TEST_XML_FILE);
+  BOOST_CHECK_EQUAL(entries[1].name, "hasData");
+  BOOST_CHECK_EQUAL(entries[1].args[0], "35205");
+  BOOST_CHECK_GE(entries[1].start, entries[0].start + entries[0].duration);
+  file.close();
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenStartedRequestLog_WhenHandleCallsAreMade_ThenTheyAreRecordedWithHandle) {
+  auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  auto indexPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  boost::filesystem::create_directories(indexPath);
+  BOOST_CHECK(::startRequestLog(path.c_str()));
+
+  void *handle = ::connectEx((indexPath.string() + "/").c_str(), [](const char *message) { BOOST_FAIL(message); });
+  BOOST_REQUIRE(handle != nullptr);
+  ::setRequestBudgetEx(handle, 50);
+  const char *styleFiles[] = { TEST_MAPCSS_DEFAULT };
+  ::purgeMeshCacheEx(handle, styleFiles, 1);
+  ::disconnectEx(handle);
+  ::stopRequestLog();
+
+  std::ifstream file(path);
+  std::string line;
+  std::vector<RequestLog::Entry> entries;
+  while (std::getline(file, line)) {
+    RequestLog::Entry entry;
+    BOOST_CHECK(RequestLog::parse(line, entry));
+    entries.push_back(entry);
+  }
+  BOOST_REQUIRE_EQUAL(entries.size(), 4);
+  for (const auto &entry : entries)
+    BOOST_CHECK_EQUAL(entry.handle, reinterpret_cast<std::uintptr_t>(handle));
+  BOOST_CHECK_EQUAL(entries[0].name, "connect");
+  BOOST_CHECK_EQUAL(entries[1].name, "setRequestBudget");
+  BOOST_CHECK_EQUAL(entries[1].args[0], "50");
+  BOOST_CHECK_EQUAL(entries[2].name, "purgeMeshCache");
+  BOOST_REQUIRE_EQUAL(entries[2].args.size(), 2);
+  BOOST_CHECK_EQUAL(entries[2].args[0], "1");
+  BOOST_CHECK_EQUAL(entries[2].args[1], TEST_MAPCSS_DEFAULT);
+  BOOST_CHECK_EQUAL(entries[3].name, "disconnect");
+  file.close();
+  std::remove(path.c_str());
+  boost::filesystem::remove_all(indexPath);
+}
+
 BOOST_AUTO_TEST_CASE(GivenTestData_WhenSpecificQuadKeyIsLoaded_ThenHasDataReturnsFalseForAnother) {
   ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
 
@@ -139,6 +228,463 @@ BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoaded_ThenSearchFindsElement) {
   BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenRegionIsBaked_ThenEveryTileIsBuilt) {
+  static std::atomic<int> progressCount;
+  static std::uint64_t lastBuilt, lastTotal;
+  progressCount = 0;
+  utymap::QuadKey quadkey(16, 35205, 21489);
+  utymap::BoundingBox bbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(quadkey);
+  double margin = (bbox.maxPoint.latitude - bbox.minPoint.latitude) / 4;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE,
+    quadkey.tileX, quadkey.tileY, quadkey.levelOfDetail, callback, &cancelToken);
+
+  ::bakeRegion(TEST_MAPCSS_DEFAULT,
+    bbox.minPoint.latitude + margin, bbox.minPoint.longitude + margin,
+    bbox.maxPoint.latitude - margin, bbox.maxPoint.longitude - margin, 15, 16, 0,
+    [](std::uint64_t tilesBuilt, std::uint64_t tilesTotal, double seconds) {
+      ++progressCount;
+      lastBuilt = tilesBuilt;
+      lastTotal = tilesTotal;
+      BOOST_CHECK_GE(seconds, 0);
+    },
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }, &cancelToken);
+
+  BOOST_CHECK_EQUAL(progressCount, 2);
+  BOOST_CHECK_EQUAL(lastBuilt, 2);
+  BOOST_CHECK_EQUAL(lastTotal, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedInBatches_ThenElementsArePacked) {
+  isCalled = false;
+  batchCount = 0;
+  elementCount = 0;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  ::getDataByQuadKeyBatch(0, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0, 8,
+    [](int, const char *, const double *, int, const int *, int, const int *, int,
+       const double *, int, const int *, int) {},
+    [](int tag, const std::uint64_t *ids, int count, const char **tags, const int *tagOffsets,
+       const double *vertices, const int *vertexOffsets, const char **styles, const int *styleOffsets) {
+      isCalled = true;
+      ++batchCount;
+      elementCount += count;
+      BOOST_CHECK_GT(count, 0);
+      BOOST_CHECK_LE(count, 8);
+      BOOST_CHECK_EQUAL(tagOffsets[0], 0);
+      for (int i = 0; i < count; ++i) {
+        BOOST_CHECK_EQUAL((tagOffsets[i + 1] - tagOffsets[i]) % 2, 0);
+        BOOST_CHECK_EQUAL((vertexOffsets[i + 1] - vertexOffsets[i]) % 3, 0);
+        BOOST_CHECK_LE(styleOffsets[i], styleOffsets[i + 1]);
+      }
+    },
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }, &cancelToken);
+
+  BOOST_CHECK(isCalled);
+  BOOST_CHECK_GT(elementCount, 8);
+  BOOST_CHECK_EQUAL(batchCount, (elementCount + 7) / 8);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsSubmittedWithBatches_ThenElementsArePackedAndRequestCompleted) {
+  static std::atomic<int> completions;
+  completions = 0;
+  batchCount = 0;
+  elementCount = 0;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  ::submitDataByQuadKeyBatch(0, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0, 0, 8,
+    [](int, const char *, const double *, int, const int *, int, const int *, int,
+       const double *, int, const int *, int) {},
+    [](int tag, const std::uint64_t *ids, int count, const char **, const int *,
+       const double *, const int *, const char **, const int *) {
+      ++batchCount;
+      elementCount += count;
+      BOOST_CHECK_LE(count, 8);
+    },
+    [](const char *message) {
+      BOOST_FAIL(message);
+    },
+    [](int tag, int isCancelled) {
+      BOOST_CHECK_EQUAL(isCancelled, 0);
+      ++completions;
+    });
+  while (completions == 0)
+    std::this_thread::yield();
+
+  BOOST_CHECK_GT(elementCount, 8);
+  BOOST_CHECK_EQUAL(batchCount, (elementCount + 7) / 8);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedAsFloat_ThenVerticesAreRelativeToTile) {
+  isCalled = false;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  ::getDataByQuadKeyFloat(0, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0,
+    [](int tag, const char *name, double originX, double originY,
+       const float *vertices, int vertexCount, const int *, int triCount, const int *, int,
+       const float *, int, const int *, int) {
+      isCalled = true;
+      auto bbox = GeoUtils::quadKeyToBoundingBox(utymap::QuadKey(16, 35205, 21489));
+      BOOST_CHECK_CLOSE(originX, bbox.center().longitude, 1e-9);
+      BOOST_CHECK_CLOSE(originY, bbox.center().latitude, 1e-9);
+      BOOST_CHECK_GT(triCount, 0);
+      for (int i = 0; i + 2 < vertexCount; i += 3) {
+        BOOST_CHECK_LT(std::abs(vertices[i]), bbox.width());
+        BOOST_CHECK_LT(std::abs(vertices[i + 1]), bbox.height());
+      }
+    },
+    [](int, uint64_t, const char **, int, const double *, int, const char **, int) {},
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }, &cancelToken);
+
+  BOOST_CHECK(isCalled);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedWithOwnership_ThenMeshesStayValidUntilRelease) {
+  static std::vector<std::pair<std::uint64_t, const double *>> meshes;
+  static std::vector<std::vector<double>> copies;
+  meshes.clear();
+  copies.clear();
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  ::getDataByQuadKeyOwned(0, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0,
+    [](int, std::uint64_t handle, const char *, const double *vertices, int vertexCount, const int *, int,
+       const int *, int, const double *, int, const int *, int) {
+      meshes.push_back(std::make_pair(handle, vertices));
+      copies.push_back(std::vector<double>(vertices, vertices + vertexCount));
+    },
+    [](int, uint64_t, const char **, int, const double *, int, const char **, int) {},
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }, &cancelToken);
+
+  BOOST_REQUIRE(!meshes.empty());
+  for (std::size_t i = 0; i < meshes.size(); ++i) {
+    BOOST_CHECK(std::equal(copies[i].begin(), copies[i].end(), meshes[i].second));
+    BOOST_CHECK(::releaseMesh(meshes[i].first));
+  }
+  BOOST_CHECK(!::releaseMesh(meshes[0].first));
+}
+
+BOOST_AUTO_TEST_CASE(GivenRequestBudget_WhenQuadKeyIsLoaded_ThenTokenOfCallerIsNotChanged) {
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  ::setRequestBudget(60000);
+
+  ::getDataByQuadKey(0, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0,
+                     [](int, const char *, const double *, int, const int *, int,
+                        const int *, int, const double *, int, const int *, int) {},
+                     [](int, std::uint64_t, const char **, int, const double *, int, const char **, int) {},
+                     callback, &cancelToken);
+  ::setRequestBudget(0);
+
+  BOOST_CHECK(!cancelToken.hasDeadline());
+  BOOST_CHECK(!cancelToken.isCancelled());
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyJobIsSubmitted_ThenResultIsFetchedAfterPolling) {
+  isCalled = false;
+  elementCount = 0;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  int jobId = ::submitQuadKeyJob(TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0, 0);
+  int completedId = 0;
+  while (::pollCompletedJobs(&completedId, 1) == 0)
+    std::this_thread::yield();
+
+  BOOST_CHECK_EQUAL(completedId, jobId);
+  BOOST_CHECK(::fetchJobResult(jobId,
+    [](int tag, const char *, const double *, int vertexCount, const int *, int triCount,
+       const int *, int, const double *, int, const int *, int) {
+      isCalled = true;
+      BOOST_CHECK_GT(vertexCount, 0);
+      BOOST_CHECK_GT(triCount, 0);
+    },
+    [](int, uint64_t, const char **, int, const double *, int, const char **, int) {
+      ++elementCount;
+    },
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }));
+  BOOST_CHECK(isCalled);
+  BOOST_CHECK_GT(elementCount, 0);
+  BOOST_CHECK(!::fetchJobResult(jobId, nullptr, nullptr, nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompletedJob_WhenMeshesAreFetchedIntoBuffers_ThenMeshesFillReportedSizes) {
+  static int vertexEnd, triEnd, meshCount;
+  vertexEnd = triEnd = meshCount = 0;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  int jobId = ::submitQuadKeyJob(TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0, 0);
+  int completedId = 0;
+  while (::pollCompletedJobs(&completedId, 1) == 0)
+    std::this_thread::yield();
+  int sizes[6];
+  BOOST_REQUIRE(::getJobMeshSizes(jobId, &sizes[0], &sizes[1], &sizes[2], &sizes[3], &sizes[4], &sizes[5]));
+  BOOST_REQUIRE_GT(sizes[0], 0);
+  std::vector<double> vertices(sizes[1]), uvs(sizes[4]);
+  std::vector<int> triangles(sizes[2]), colors(sizes[3]), uvMap(sizes[5]);
+
+  // NOTE too small buffer keeps result.
+  BOOST_CHECK(!::fetchJobMeshes(jobId, vertices.data(), sizes[1] - 1, triangles.data(), sizes[2],
+                                colors.data(), sizes[3], uvs.data(), sizes[4], uvMap.data(), sizes[5],
+                                nullptr, nullptr, nullptr));
+  BOOST_CHECK(::fetchJobMeshes(jobId, vertices.data(), sizes[1], triangles.data(), sizes[2],
+    colors.data(), sizes[3], uvs.data(), sizes[4], uvMap.data(), sizes[5],
+    [](int, const char *, int vertexOffset, int vertexSize, int triOffset, int triSize,
+       int, int, int, int, int, int) {
+      BOOST_CHECK_EQUAL(vertexOffset, vertexEnd);
+      BOOST_CHECK_EQUAL(triOffset, triEnd);
+      vertexEnd += vertexSize;
+      triEnd += triSize;
+      ++meshCount;
+    }, nullptr, nullptr));
+
+  BOOST_CHECK_EQUAL(meshCount, sizes[0]);
+  BOOST_CHECK_EQUAL(vertexEnd, sizes[1]);
+  BOOST_CHECK_EQUAL(triEnd, sizes[2]);
+  BOOST_CHECK(std::any_of(vertices.begin(), vertices.end(), [](double value) { return value != 0; }));
+  BOOST_CHECK(!::getJobMeshSizes(jobId, &sizes[0], &sizes[1], &sizes[2], &sizes[3], &sizes[4], &sizes[5]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenLoadedQuadKey_WhenGetStatistics_ThenPipelineCountersArePresent) {
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  loadQuadKeys(16, 35205, 35205, 21489, 21489);
+
+  int size = ::getStatistics(nullptr, 0);
+  std::vector<char> buffer(static_cast<std::size_t>(size));
+  BOOST_CHECK_EQUAL(::getStatistics(buffer.data(), size), size);
+
+  std::string json(buffer.data());
+  BOOST_CHECK_EQUAL(json.size() + 1, static_cast<std::size_t>(size));
+  BOOST_CHECK(json.find("\"styleMatches\":0,") == std::string::npos);
+  BOOST_CHECK(json.find("\"meshesBuilt\":0,") == std::string::npos);
+  BOOST_CHECK(json.find("\"tileBuild\":{") != std::string::npos);
+  BOOST_CHECK(json.find("\"tileMesh\":{\"count\":0,") == std::string::npos);
+  BOOST_CHECK(json.find("\"tileCallback\":{") != std::string::npos);
+  BOOST_CHECK(json.find("\"caches\":{\"strings\":{") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLoadedQuadKey_WhenMemoryIsTrimmedAtCriticalLevel_ThenCachesAreReleased) {
+  auto getUsage = [](const std::string &subsystem) {
+    std::vector<char> buffer(static_cast<std::size_t>(::getMemoryUsage(nullptr, 0)));
+    ::getMemoryUsage(buffer.data(), static_cast<int>(buffer.size()));
+    std::string json(buffer.data());
+    auto pos = json.find("\"" + subsystem + "\":");
+    BOOST_REQUIRE(pos != std::string::npos);
+    return std::stoull(json.substr(pos + subsystem.size() + 3));
+  };
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  loadQuadKeys(16, 35205, 35205, 21489, 21489);
+  BOOST_CHECK_GT(getUsage("inMemoryStores"), 0);
+  BOOST_CHECK_GT(getUsage("total"), 0);
+
+  ::trimMemory(static_cast<int>(MemoryTrimLevel::Critical));
+
+  BOOST_CHECK_EQUAL(getUsage("stringTable"), 0);
+  BOOST_CHECK_EQUAL(getUsage("meshPools"), 0);
+  BOOST_CHECK_GT(getUsage("inMemoryStores"), 0);
+  loadQuadKeys(16, 35205, 35205, 21489, 21489);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoadedWithIds_ThenEveryIdHasStringPassedOnce) {
+  static std::map<std::uint32_t, std::string> strings;
+  static bool isDuplicate;
+  static bool isUnknown;
+    strings.clear();
+  isDuplicate = isUnknown = false;
+  ::elementCount = 0;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  ::getDataByQuadKeyIds(0, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0,
+    [](int, const char *, const double *, int, const int *, int, const int *, int,
+       const double *, int, const int *, int) {},
+    [](int, const std::uint32_t *ids, const char **values, int count) {
+      for (int i = 0; i < count; ++i)
+        isDuplicate |= !strings.emplace(ids[i], values[i]).second;
+    },
+    [](int, std::uint64_t, const std::uint32_t *tags, int tagSize, const double *, int,
+       const std::uint32_t *styles, int styleSize) {
+      ++::elementCount;
+      for (int i = 0; i < tagSize; ++i)
+        isUnknown |= strings.find(tags[i]) == strings.end();
+      for (int i = 0; i < styleSize; ++i)
+        isUnknown |= strings.find(styles[i]) == strings.end();
+    },
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }, &cancelToken);
+
+  BOOST_CHECK_GT(::elementCount, 0);
+  BOOST_CHECK(!isDuplicate);
+  BOOST_CHECK(!isUnknown);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNewStyle_WhenQuadKeyIsLoadedConcurrently_ThenNoErrorsAreReported) {
+  static std::atomic<int> errorCount;
+  static std::atomic<int> meshCount;
+  errorCount = 0;
+  meshCount = 0;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      utymap::CancellationToken token;
+      ::getDataByQuadKey(0, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0,
+        [](int, const char *, const double *, int, const int *, int, const int *, int,
+           const double *, int, const int *, int) { ++meshCount; },
+        [](int, uint64_t, const char **, int, const double *, int, const char **, int) {},
+        [](const char *) { ++errorCount; }, &token);
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(errorCount.load(), 0);
+  BOOST_CHECK_GT(meshCount.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCoalescing_WhenSameQuadKeyIsLoadedConcurrently_ThenEveryRequestGetsWholeTile) {
+  static std::atomic<int> meshCounts[5];
+  static std::atomic<int> elementCounts[5];
+  for (int i = 0; i < 5; ++i) {
+    meshCounts[i] = 0;
+    elementCounts[i] = 0;
+  }
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  auto load = [](int tag) {
+    utymap::CancellationToken token;
+    ::getDataByQuadKey(tag, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0,
+      [](int tag, const char *, const double *, int, const int *, int, const int *, int,
+         const double *, int, const int *, int) { ++meshCounts[tag]; },
+      [](int tag, uint64_t, const char **, int, const double *, int, const char **, int) { ++elementCounts[tag]; },
+      [](const char *message) { BOOST_FAIL(message); }, &token);
+  };
+  load(0);
+  ::enableRequestCoalescing(1);
+
+  std::vector<std::thread> threads;
+  for (int tag = 1; tag < 5; ++tag)
+    threads.emplace_back(load, tag);
+  for (auto &thread : threads)
+    thread.join();
+
+  BOOST_CHECK_GT(meshCounts[0].load(), 0);
+  BOOST_CHECK_GT(elementCounts[0].load(), 0);
+  for (int tag = 1; tag < 5; ++tag) {
+    BOOST_CHECK_EQUAL(meshCounts[tag].load(), meshCounts[0].load());
+    BOOST_CHECK_EQUAL(elementCounts[tag].load(), elementCounts[0].load());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoHandles_WhenDataIsAddedToOne_ThenOtherDoesNotHaveIt) {
+  std::vector<boost::filesystem::path> indexPaths;
+  std::vector<void *> handles;
+  for (int i = 0; i < 2; ++i) {
+    indexPaths.push_back(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path());
+    boost::filesystem::create_directories(indexPaths.back());
+    handles.push_back(::connectEx((indexPaths.back().string() + "/").c_str(),
+                                  [](const char *message) { BOOST_FAIL(message); }));
+    BOOST_REQUIRE(handles.back() != nullptr);
+    ::registerInMemoryStoreEx(handles.back(), InMemoryStoreKey);
+  }
+
+  ::addDataInQuadKeyEx(handles[0], InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16,
+                       callback, &cancelToken);
+
+  BOOST_CHECK(::hasDataEx(handles[0], 35205, 21489, 16));
+  BOOST_CHECK(!::hasDataEx(handles[1], 35205, 21489, 16));
+  for (std::size_t i = 0; i < handles.size(); ++i) {
+    ::disconnectEx(handles[i]);
+    boost::filesystem::remove_all(indexPaths[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenHandle_WhenQuadKeyJobIsSubmitted_ThenResultIsFetchedFromTheSameHandle) {
+  isCalled = false;
+  auto indexPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  boost::filesystem::create_directories(indexPath);
+  void *handle = ::connectEx((indexPath.string() + "/").c_str(), [](const char *message) { BOOST_FAIL(message); });
+  BOOST_REQUIRE(handle != nullptr);
+  ::registerInMemoryStoreEx(handle, InMemoryStoreKey);
+  ::setRequestThreadsEx(handle, 2);
+  ::addDataInQuadKeyEx(handle, InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16,
+                       callback, &cancelToken);
+
+  int jobId = ::submitQuadKeyJobEx(handle, TEST_MAPCSS_DEFAULT, 35205, 21489, 16, 0, 0);
+  int completedId = 0;
+  while (::pollCompletedJobsEx(handle, &completedId, 1) == 0)
+    std::this_thread::yield();
+
+  BOOST_CHECK_EQUAL(completedId, jobId);
+  BOOST_CHECK_EQUAL(::pollCompletedJobs(&completedId, 1), 0);
+  BOOST_CHECK(::fetchJobResultEx(handle, jobId,
+    [](int, const char *, const double *, int, const int *, int, const int *, int, const double *, int,
+       const int *, int) {
+      isCalled = true;
+    }, nullptr, [](const char *message) { BOOST_FAIL(message); }));
+  BOOST_CHECK(isCalled);
+  double coordinates[] = { 52.53, 13.38, 52.54, 13.39 };
+  double elevations[] = { -1, -1 };
+  ::getElevationsByQuadKeyEx(handle, 35205, 21489, 16, 0, coordinates, 2, elevations);
+  BOOST_CHECK_EQUAL(elevations[0], 0);
+  BOOST_CHECK_EQUAL(elevations[1], 0);
+  ::disconnectEx(handle);
+  boost::filesystem::remove_all(indexPath);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeysAreLoadedInBatch_ThenResultsAreTaggedByTile) {
+  static std::vector<int> meshTags;
+  meshTags.clear();
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  ::setRequestThreads(2);
+  int tiles[] = { 35204, 21489, 35205, 21489 };
+
+  ::getDataByQuadKeys(TEST_MAPCSS_DEFAULT, tiles, 2, 16, 0,
+    [](int tag, const char *, const double *, int, const int *, int, const int *, int,
+       const double *, int, const int *, int) {
+      meshTags.push_back(tag);
+    },
+    [](int tag, uint64_t, const char **, int, const double *, int, const char **, int) {
+      BOOST_CHECK(tag == 0 || tag == 1);
+    },
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }, &cancelToken);
+  ::setRequestThreads(1);
+
+  BOOST_CHECK(std::find(meshTags.begin(), meshTags.end(), 1) != meshTags.end());
+  BOOST_CHECK(std::all_of(meshTags.begin(), meshTags.end(), [](int tag) { return tag == 0 || tag == 1; }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenSingleThreadCpuPool_WhenQuadKeysAreLoadedInBatchWithParallelBuilders_ThenTilesAreBuilt) {
+  static std::vector<int> meshTags;
+  meshTags.clear();
+  ::configureThreadPool(0, 1, 0, 0);
+  ::setBuildThreads(2);
+  ::enableParallelBuilders(1);
+  ::setRequestThreads(2);
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+  int tiles[] = { 35204, 21489, 35205, 21489 };
+
+  ::getDataByQuadKeys(TEST_MAPCSS_DEFAULT, tiles, 2, 16, 0,
+    [](int tag, const char *, const double *, int, const int *, int, const int *, int,
+       const double *, int, const int *, int) {
+      meshTags.push_back(tag);
+    },
+    [](int, uint64_t, const char **, int, const double *, int, const char **, int) {},
+    [](const char *message) {
+      BOOST_FAIL(message);
+    }, &cancelToken);
+  ::setRequestThreads(1);
+
+  BOOST_CHECK(std::find(meshTags.begin(), meshTags.end(), 1) != meshTags.end());
+}
+
 BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoaded_ThenSearchFindsRelation) {
   int lod = 14;
   isCalled = false;
@@ -159,6 +705,29 @@ BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoaded_ThenSearchFindsRelation)
   BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenQuadKeyIsLoaded_ThenElementIsFoundById) {
+  isCalled = false;
+  ::addDataInQuadKey(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16, callback, &cancelToken);
+
+  bool isFound = ::getDataById(0, 2866993675,
+    [](int tag, uint64_t id, const char **tags, int size, const double *vertices,
+       int vertexCount, const char **style, int styleSize) {
+      isCalled = true;
+      BOOST_CHECK_EQUAL(id, 2866993675);
+    },
+    [](const char *message) {
+      BOOST_FAIL(message);
+    });
+
+  BOOST_CHECK(isFound);
+  BOOST_CHECK(isCalled);
+  BOOST_CHECK(!::getDataById(0, 1, [](int, uint64_t, const char **, int, const double *, int, const char **, int) {
+    BOOST_FAIL("Unexpected element.");
+  }, [](const char *message) {
+    BOOST_FAIL(message);
+  }));
+}
+
 BOOST_AUTO_TEST_CASE(GivenElement_WhenAddInMemory_ThenItIsAdded) {
   const std::vector<double> vertices = {5, 5, 20, 5, 20, 10, 5, 10, 5, 5};
   const std::vector<const char *> tags = {"featurecla", "Lake", "scalerank", "0"};
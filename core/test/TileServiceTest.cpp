@@ -0,0 +1,98 @@
+#include "config.hpp"
+#include "Application.hpp"
+#include "TileService.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <sstream>
+
+using namespace utymap;
+
+namespace {
+const char *InMemoryStoreKey = "InMemory";
+const std::string TileTarget = "/tile/16/35205/21489";
+
+struct TileServiceFixture {
+  TileServiceFixture() :
+    application(TEST_ASSETS_PATH),
+    service(application.getSearch(), TEST_MAPCSS_DEFAULT, 16) {
+    application.getConfiguration().registerInMemoryStore(InMemoryStoreKey);
+    CancellationToken cancelToken;
+    application.getStorage().addToStore(InMemoryStoreKey, TEST_MAPCSS_DEFAULT, TEST_XML_FILE, 35205, 21489, 16,
+                                        [](const char *message) { BOOST_FAIL(message); }, &cancelToken);
+  }
+
+  ~TileServiceFixture() {
+    service.stop();
+    std::remove((std::string(TEST_ASSETS_PATH) + "string.idx").c_str());
+    std::remove((std::string(TEST_ASSETS_PATH) + "string.dat").c_str());
+    std::remove((std::string(TEST_ASSETS_PATH) + "string.hsh").c_str());
+    std::remove((std::string(TEST_ASSETS_PATH) + "string.sld").c_str());
+
+    boost::filesystem::directory_iterator end;
+    for (boost::filesystem::directory_iterator it(TEST_ASSETS_PATH); it != end; ++it) {
+      if (it->path().extension() == ".style")
+        boost::filesystem::remove(it->path());
+    }
+  }
+
+  Application application;
+  TileService service;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Shared_TileService, TileServiceFixture)
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenTileIsRequested_ThenCompactMeshesAreReturned) {
+  auto response = service.handle(TileTarget);
+
+  BOOST_REQUIRE_EQUAL(response->status, 200);
+  std::stringstream stream(response->body);
+  int count = 0;
+  while (stream.peek() != std::char_traits<char>::eof()) {
+    auto mesh = utymap::index::MeshStream::readCompact(stream);
+    BOOST_CHECK(!mesh.vertices.empty());
+    ++count;
+  }
+  BOOST_CHECK_GT(count, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenConcurrentRequestsOfTheSameTile_WhenTileIsBuilt_ThenResponseIsSharedAndCached) {
+  auto first = std::async(std::launch::async, [&]() { return service.handle(TileTarget); });
+  auto second = std::async(std::launch::async, [&]() { return service.handle(TileTarget + "?ele=0"); });
+
+  auto response = first.get();
+  BOOST_CHECK_EQUAL(response->status, 200);
+  BOOST_CHECK_EQUAL(second.get(), response);
+  BOOST_CHECK_EQUAL(service.handle(TileTarget), response);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTestData_WhenSearchIsRequested_ThenElementsAreReturnedAsJson) {
+  auto bbox = utils::GeoUtils::quadKeyToBoundingBox(QuadKey(16, 35205, 21489));
+  std::stringstream target;
+  target.precision(10);
+  target << "/search?and=Nordbahnhof+tram+stop&lod=16,16&bbox="
+         << bbox.minPoint.latitude << "," << bbox.minPoint.longitude << ","
+         << bbox.maxPoint.latitude << "," << bbox.maxPoint.longitude;
+
+  auto response = service.handle(target.str());
+
+  BOOST_CHECK_EQUAL(response->status, 200);
+  BOOST_CHECK_EQUAL(response->contentType, "application/json");
+  BOOST_CHECK_EQUAL(response->body.front(), '[');
+  BOOST_CHECK(response->body.find("\"id\":") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoppedService_WhenTileIsRequested_ThenServiceUnavailableIsReturned) {
+  service.stop();
+
+  BOOST_CHECK_EQUAL(service.handle(TileTarget)->status, 503);
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnknownTarget_WhenHandle_ThenNotFoundIsReturned) {
+  BOOST_CHECK_EQUAL(service.handle("/unknown")->status, 404);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "mapcss/MapCssParser.hpp"
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/test/unit_test.hpp>
@@ -33,6 +34,7 @@ namespace {
 const double Precision = 1e-5;
 const QuadKey quadKey = QuadKey(1, 0, 0);
 const std::string stylesheet = "node|z1[any], way|z1[any], area|z1[any], relation|z1[any] { clip: false; }";
+const std::string otherRule = " node|z1[other] { clip: false; }";
 
 std::string getCacheDir(const StyleProvider &styleProvider) {
   return std::string("data/cache/") + styleProvider.getTag() + "/1";
@@ -68,7 +70,7 @@ struct Builders_MeshCacheFixture {
   Builders_MeshCacheFixture() :
       cache_("data", "mesh"),
       origContext(quadKey,
-                  *dependencyProvider.getStyleProvider(stylesheet),
+                  *dependencyProvider.getStyleProvider(stylesheet + otherRule),
                   *dependencyProvider.getStringTable(),
                   *dependencyProvider.getMeshPool(),
                   *dependencyProvider.getElevationProvider(),
@@ -81,8 +83,33 @@ struct Builders_MeshCacheFixture {
   }
 
   ~Builders_MeshCacheFixture() {
+    cache_.flush();
     auto filePath = getCacheDir(*dependencyProvider.getStyleProvider()) + "/0.mesh";
     boost::filesystem::remove(filePath);
+    boost::filesystem::remove(filePath + ".deps");
+    for (const auto &otherProvider : otherProviders_)
+      boost::filesystem::remove_all(std::string("data/cache/") + otherProvider->getTag());
+  }
+
+  /// Stores element as quadkey builder does and fetches it with other stylesheet.
+  bool storeAndFetchWithOtherStyle(const Element &element, const std::string &otherStylesheet) {
+    auto rules = dependencyProvider.getStyleProvider()->forElement(element, quadKey.levelOfDetail).getRules();
+    wrapContext.styleRules->insert(rules.begin(), rules.end());
+    wrapContext.elementCallback(element);
+    cache_.unwrap(wrapContext);
+    resetData();
+
+    otherProviders_.push_back(std::make_shared<StyleProvider>(MapCssParser().parse(otherStylesheet),
+                                                              *dependencyProvider.getStringTable()));
+    BuilderContext otherContext(quadKey,
+                                *otherProviders_.back(),
+                                *dependencyProvider.getStringTable(),
+                                *dependencyProvider.getMeshPool(),
+                                *dependencyProvider.getElevationProvider(),
+                                origContext.meshCallback,
+                                origContext.elementCallback,
+                                dependencyProvider.getCancellationToken());
+    return cache_.fetch(otherContext);
   }
 
   void assertStoreAndFetch(const Element &element) {
@@ -132,6 +159,7 @@ struct Builders_MeshCacheFixture {
 
   std::uint64_t lastId_;
   Mesh lastMesh_;
+  std::vector<std::shared_ptr<StyleProvider>> otherProviders_;
 };
 }
 
@@ -178,7 +206,7 @@ BOOST_AUTO_TEST_CASE(GivenRelation_WhenStoreAndFetch_ThenItIsStoredAndReadBack)
 BOOST_AUTO_TEST_CASE(GivenMesh_WhenStoreAndFetch_ThenItIsStoredAndReadBack) {
   Mesh mesh("My mesh");
   mesh.vertices.assign({1, 2, 3, 4.5, 5.555555, 6.6666666});
-  mesh.triangles.assign({1, 2, 3, 4});
+  mesh.triangles.assign({0, 1, 0});
   mesh.colors.assign({4, 3, 2, 1});
   mesh.uvs.assign({0.1, 0.2, 0.3, 0.4});
   mesh.uvMap.assign({1, 2, 3});
@@ -186,4 +214,123 @@ BOOST_AUTO_TEST_CASE(GivenMesh_WhenStoreAndFetch_ThenItIsStoredAndReadBack) {
   assertStoreAndFetch(mesh);
 }
 
+BOOST_AUTO_TEST_CASE(GivenMeshFarFromOrigin_WhenStoreAndFetch_ThenVerticesKeepPrecision) {
+  Mesh mesh("My mesh");
+  mesh.vertices.assign({139.6917064, 35.6894875, 40.5, 139.6917131, 35.6894902, 41.25});
+  wrapContext.meshCallback(mesh);
+  cache_.unwrap(wrapContext);
+  resetData();
+
+  cache_.fetch(origContext);
+
+  BOOST_REQUIRE_EQUAL(lastMesh_.vertices.size(), mesh.vertices.size());
+  for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+    BOOST_CHECK_SMALL(lastMesh_.vertices[i] - mesh.vertices[i], 1e-7);
+}
+
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+BOOST_AUTO_TEST_CASE(GivenLargeMesh_WhenStoreAndFetch_ThenItIsCompressedAndReadBack) {
+  const std::size_t VertexCount = 3000;
+  Mesh mesh("large");
+  for (std::size_t i = 0; i < VertexCount; ++i) {
+    mesh.vertices.insert(mesh.vertices.end(), { 13.4 + (i % 10) * 1E-4, 52.5, 10 });
+    mesh.colors.push_back(0xFF0000FF);
+  }
+  for (std::size_t i = 0; i + 2 < VertexCount; i += 3)
+    mesh.triangles.insert(mesh.triangles.end(), { static_cast<int>(i), static_cast<int>(i + 1), static_cast<int>(i + 2) });
+
+  assertStoreAndFetch(mesh);
+
+  cache_.flush();
+  auto filePath = getCacheDir(*dependencyProvider.getStyleProvider()) + "/0.mesh";
+  BOOST_CHECK_LT(boost::filesystem::file_size(filePath), VertexCount * 5 * sizeof(float) / 4);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(GivenUnwrappedContext_WhenFlush_ThenDataIsWrittenToDisk) {
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  wrapContext.elementCallback(node);
+  cache_.unwrap(wrapContext);
+
+  cache_.flush();
+
+  auto filePath = getCacheDir(*dependencyProvider.getStyleProvider()) + "/0.mesh";
+  BOOST_CHECK(boost::filesystem::exists(filePath));
+  BOOST_CHECK(boost::filesystem::exists(filePath + ".deps"));
+  BOOST_CHECK(!boost::filesystem::exists(filePath + ".tmp"));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMemoryLimit_WhenFetchWrittenData_ThenItIsReadFromMemory) {
+  cache_.setMemoryLimit(1024 * 1024);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  wrapContext.elementCallback(node);
+  cache_.unwrap(wrapContext);
+  cache_.flush();
+  auto filePath = getCacheDir(*dependencyProvider.getStyleProvider()) + "/0.mesh";
+  boost::filesystem::remove(filePath);
+  resetData();
+
+  BOOST_CHECK(cache_.fetch(origContext));
+
+  BOOST_CHECK_EQUAL(lastId_, node.id);
+}
+
+BOOST_AUTO_TEST_CASE(GivenDiskLimit_WhenExceeded_ThenLeastRecentlyUsedDataIsRemoved) {
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  wrapContext.elementCallback(node);
+  cache_.unwrap(wrapContext);
+  BuilderContext otherContext(QuadKey(1, 1, 0),
+                              *dependencyProvider.getStyleProvider(),
+                              *dependencyProvider.getStringTable(),
+                              *dependencyProvider.getMeshPool(),
+                              *dependencyProvider.getElevationProvider(),
+                              origContext.meshCallback,
+                              origContext.elementCallback,
+                              dependencyProvider.getCancellationToken());
+  auto otherWrapContext = cache_.wrap(otherContext);
+  otherWrapContext.elementCallback(node);
+  cache_.unwrap(otherWrapContext);
+  cache_.flush();
+  auto filePath = getCacheDir(*dependencyProvider.getStyleProvider()) + "/0.mesh";
+  auto otherPath = getCacheDir(*dependencyProvider.getStyleProvider()) + "/1.mesh";
+  auto size = boost::filesystem::file_size(filePath) + boost::filesystem::file_size(filePath + ".deps") +
+      boost::filesystem::file_size(otherPath) + boost::filesystem::file_size(otherPath + ".deps");
+  cache_.fetch(origContext);
+
+  cache_.setDiskLimit(size - 1);
+  cache_.flush();
+
+  BOOST_CHECK(boost::filesystem::exists(filePath));
+  BOOST_CHECK(!boost::filesystem::exists(otherPath));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStaleStyle_WhenPurge_ThenItsDataIsRemoved) {
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  wrapContext.elementCallback(node);
+  cache_.unwrap(wrapContext);
+  cache_.flush();
+
+  cache_.purge({ "other" });
+
+  BOOST_CHECK(!boost::filesystem::exists(std::string("data/cache/") + dependencyProvider.getStyleProvider()->getTag()));
+  BOOST_CHECK(!cache_.fetch(origContext));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStyleWithChangedUnusedRule_WhenFetch_ThenCachedDataIsReused) {
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+
+  BOOST_CHECK(storeAndFetchWithOtherStyle(node, stylesheet + " node|z1[other] { clip: true; }"));
+
+  BOOST_CHECK_EQUAL(lastId_, node.id);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStyleWithChangedUsedRule_WhenFetch_ThenCachedDataIsNotReused) {
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+
+  BOOST_CHECK(!storeAndFetchWithOtherStyle(node,
+    "node|z1[any], way|z1[any], area|z1[any], relation|z1[any] { clip: true; }" + otherRule));
+
+  BOOST_CHECK_EQUAL(lastId_, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+#include "builders/MeshInterleaver.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::builders;
+using namespace utymap::math;
+
+namespace {
+const double Precision = 1e-4;
+
+Mesh createMesh() {
+  Mesh mesh("");
+  mesh.vertices.assign({10.5, 20.25, 1, 10.75, 20.5, 2, 11, 20, 3});
+  mesh.triangles.assign({0, 1, 2});
+  mesh.colors.assign({static_cast<int>(0x11223344), static_cast<int>(0xFF0000FF), 0});
+  mesh.uvs.assign({0.1, 0.2, 0.3, 0.4, 0.5, 0.6});
+  // NOTE first two vertices use one texture region, the last one uses another.
+  mesh.uvMap.assign({4, 1, 100, 200, 10, 20, 50, 40,
+                     6, 2, 0, 0, 0, 0, 0, 0});
+  return mesh;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(Builders_MeshInterleaver)
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenInterleave_ThenAttributesAreInterleaved) {
+  std::vector<InterleavedVertex> vertices;
+  std::vector<int> indices;
+
+  MeshInterleaver::interleave(createMesh(), GeoCoordinate(20, 10), vertices, indices);
+
+  BOOST_REQUIRE_EQUAL(vertices.size(), 3);
+  BOOST_CHECK_EQUAL(indices.size(), 3);
+  BOOST_CHECK_CLOSE(vertices[1].position[0], 0.75, Precision);
+  BOOST_CHECK_CLOSE(vertices[1].position[1], 0.5, Precision);
+  BOOST_CHECK_CLOSE(vertices[1].position[2], 2, Precision);
+  BOOST_CHECK_EQUAL(vertices[0].color[0], 0x11);
+  BOOST_CHECK_EQUAL(vertices[0].color[3], 0x44);
+  BOOST_CHECK_CLOSE(vertices[2].uv[1], 0.6, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshWithTwoTextureRegions_WhenInterleave_ThenVerticesUseTheirRegion) {
+  std::vector<InterleavedVertex> vertices;
+  std::vector<int> indices;
+
+  MeshInterleaver::interleave(createMesh(), GeoCoordinate(20, 10), vertices, indices);
+
+  BOOST_CHECK_EQUAL(vertices[1].textureIndex, 1);
+  BOOST_CHECK_CLOSE(vertices[1].textureOffset[0], 0.1, Precision);
+  BOOST_CHECK_CLOSE(vertices[1].textureSize[1], 0.2, Precision);
+  BOOST_CHECK_EQUAL(vertices[2].textureIndex, 2);
+  BOOST_CHECK_EQUAL(vertices[2].textureSize[0], 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshAboveLimit_WhenSplit_ThenChunksHaveNoMoreVerticesThanLimit) {
+  std::vector<InterleavedVertex> vertices(8);
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+    vertices[i].position[0] = static_cast<float>(i);
+  // NOTE quads which share vertices with previous ones.
+  std::vector<int> indices = {0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5, 4, 5, 6, 6, 5, 7};
+  std::vector<std::size_t> sizes;
+  std::vector<float> positions;
+
+  auto count = MeshInterleaver::split(vertices, indices, 4,
+    [&](const std::vector<InterleavedVertex> &chunkVertices, const std::vector<int> &chunkIndices) {
+      sizes.push_back(chunkVertices.size());
+      for (auto index : chunkIndices)
+        positions.push_back(chunkVertices[index].position[0]);
+    });
+
+  std::vector<std::size_t> expectedSizes = {4, 4, 4};
+  BOOST_CHECK_EQUAL(count, 3);
+  BOOST_CHECK_EQUAL_COLLECTIONS(sizes.begin(), sizes.end(), expectedSizes.begin(), expectedSizes.end());
+  BOOST_REQUIRE_EQUAL(positions.size(), indices.size());
+  for (std::size_t i = 0; i < indices.size(); ++i)
+    BOOST_CHECK_EQUAL(positions[i], indices[i]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenIndices_WhenNarrow_ThenShortIndicesUsedOnlyIfVerticesFit) {
+  std::vector<int> indices = {0, 1, 65535};
+  std::vector<std::uint16_t> result;
+
+  BOOST_CHECK(MeshInterleaver::narrow(indices, 65536, result));
+  BOOST_CHECK_EQUAL(result[2], 65535);
+  BOOST_CHECK(!MeshInterleaver::narrow(indices, 65537, result));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -80,4 +80,82 @@ BOOST_AUTO_TEST_CASE(GivenEmptyPoolAfterRelease_WhenGetSmall_ThenMeshReturned) {
   BOOST_CHECK_EQUAL(result.vertices.capacity(), SmallSize);
 }
 
+BOOST_AUTO_TEST_CASE(GivenPoolWithTwoObjectsOfSameSize_WhenGetSmall_ThenBothReturned) {
+  MeshPool pool;
+  addMesh(pool, SmallSize);
+  addMesh(pool, SmallSize);
+
+  auto first = pool.getSmall("first");
+  auto second = pool.getSmall("second");
+
+  BOOST_CHECK_EQUAL(first.vertices.capacity(), SmallSize);
+  BOOST_CHECK_EQUAL(second.vertices.capacity(), SmallSize);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyPool_WhenGetWithVertexCount_ThenMeshIsReserved) {
+  MeshPool pool;
+
+  auto mesh = pool.get("my_name", 100);
+
+  BOOST_CHECK_EQUAL(mesh.name, "my_name");
+  BOOST_CHECK_EQUAL(mesh.vertices.capacity(), 300);
+  BOOST_CHECK_EQUAL(mesh.colors.capacity(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPoolWithThreeObjects_WhenGetWithVertexCount_ThenFittingReturned) {
+  MeshPool pool;
+  addMesh(pool, 16);
+  addMesh(pool, SmallSize);
+  addMesh(pool, BigSize);
+
+  auto mesh = pool.get("my_name", 2000);
+
+  BOOST_CHECK_EQUAL(mesh.vertices.capacity(), SmallSize);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPool_WhenGetMesh_ThenStatisticsUpdated) {
+  MeshPool pool;
+  auto before = MeshPool::getStatistics();
+  addMesh(pool, SmallSize);
+
+  pool.getSmall("hit");
+  pool.getSmall("miss");
+
+  auto after = MeshPool::getStatistics();
+  BOOST_CHECK_EQUAL(after.hits - before.hits, 1);
+  BOOST_CHECK_EQUAL(after.misses - before.misses, 1);
+  BOOST_CHECK_EQUAL(after.retainedBytes, before.retainedBytes);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPoolOverLimit_WhenRelease_ThenLargestMeshIsTrimmed) {
+  MeshPool pool;
+  auto before = MeshPool::getStatistics();
+  MeshPool::setMaxBytes(before.retainedBytes + SmallSize * 30);
+  addMesh(pool, SmallSize);
+  addMesh(pool, BigSize);
+
+  auto large = pool.getLarge("large");
+  auto small = pool.getSmall("small");
+  MeshPool::setMaxBytes(128 * 1024 * 1024);
+
+  BOOST_CHECK_EQUAL(large.vertices.capacity(), 0);
+  BOOST_CHECK_EQUAL(small.vertices.capacity(), SmallSize);
+  BOOST_CHECK_GT(MeshPool::getStatistics().trimmedBytes, before.trimmedBytes);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPools_WhenTrimAll_ThenMeshesOfAllPoolsAreTrimmed) {
+  MeshPool pool1, pool2;
+  addMesh(pool1, SmallSize);
+  addMesh(pool2, BigSize);
+  auto before = MeshPool::getStatistics();
+
+  MeshPool::trimAll(0);
+
+  auto after = MeshPool::getStatistics();
+  BOOST_CHECK_EQUAL(after.retainedBytes, 0);
+  BOOST_CHECK_EQUAL(after.trimmedBytes - before.trimmedBytes, before.retainedBytes);
+  pool1.getSmall("small");
+  BOOST_CHECK_EQUAL(MeshPool::getStatistics().misses - after.misses, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
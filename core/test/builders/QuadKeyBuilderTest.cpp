@@ -0,0 +1,182 @@
+#include "builders/ElementBuilder.hpp"
+#include "builders/QuadKeyBuilder.hpp"
+#include "entities/Node.hpp"
+#include "index/GeoStore.hpp"
+#include "index/InMemoryElementStore.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace utymap;
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::math;
+using namespace utymap::tests;
+using namespace utymap::utils;
+
+namespace {
+const std::string StoreKey = "memory";
+const std::string Stylesheet = "node|z1[a] { builder: first; clip: false; } "
+                               "node|z1[b] { builder: second; clip: false; }";
+const QuadKey quadKey = QuadKey(1, 0, 0);
+
+/// Reports every visited node and completion by mesh named after builder.
+class NamedBuilder final : public ElementBuilder {
+ public:
+  NamedBuilder(const BuilderContext &context, const std::string &name) :
+      ElementBuilder(context), name_(name) {}
+
+  void visitNode(const Node &node) override {
+    context_.meshCallback(Mesh(name_ + ":" + std::to_string(node.id)));
+  }
+
+  void visitWay(const Way &) override {}
+
+  void visitArea(const Area &) override {}
+
+  void visitRelation(const Relation &) override {}
+
+  void complete() override {
+    context_.meshCallback(Mesh(name_ + ":complete"));
+  }
+
+ private:
+  std::string name_;
+};
+
+/// Waits in completion until given flag is set or timeout is reached.
+class WaitingBuilder final : public ElementBuilder {
+ public:
+  WaitingBuilder(const BuilderContext &context, const std::atomic<bool> &flag) :
+      ElementBuilder(context), flag_(flag) {}
+
+  void visitNode(const Node &) override {}
+
+  void visitWay(const Way &) override {}
+
+  void visitArea(const Area &) override {}
+
+  void visitRelation(const Relation &) override {}
+
+  void complete() override {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!flag_ && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::yield();
+    context_.meshCallback(Mesh(flag_ ? "first:after" : "first:before"));
+  }
+
+ private:
+  const std::atomic<bool> &flag_;
+};
+
+struct Builders_QuadKeyBuilderFixture {
+  Builders_QuadKeyBuilderFixture() :
+      geoStore(*dependencyProvider.getStringTable()),
+      quadKeyBuilder(geoStore, *dependencyProvider.getStringTable()) {
+    geoStore.registerStore(StoreKey, make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    for (const auto &name : {"first", "second"}) {
+      quadKeyBuilder.registerElementBuilder(name, [name](const BuilderContext &context) {
+        return make_unique<NamedBuilder>(context, name);
+      });
+    }
+
+    addNode(1, {{"a", "1"}});
+    addNode(2, {{"b", "1"}});
+    addNode(3, {{"a", "1"}, {"b", "1"}});
+  }
+
+  void addNode(std::uint64_t id, std::initializer_list<std::pair<const char *, const char *>> tags) {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), id, tags);
+    node.coordinate = GeoCoordinate(45, -90);
+    geoStore.add(StoreKey, node, LodRange(1, 1), *dependencyProvider.getStyleProvider(Stylesheet),
+                 dependencyProvider.getCancellationToken());
+  }
+
+  std::vector<std::string> build() {
+    std::vector<std::string> names;
+    quadKeyBuilder.build(quadKey, *dependencyProvider.getStyleProvider(), *dependencyProvider.getElevationProvider(),
+                         [&](const Mesh &mesh) { names.push_back(mesh.name); },
+                         [](const Element &) {},
+                         dependencyProvider.getCancellationToken());
+    return names;
+  }
+
+  DependencyProvider dependencyProvider;
+  GeoStore geoStore;
+  QuadKeyBuilder quadKeyBuilder;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Builders_QuadKeyBuilder, Builders_QuadKeyBuilderFixture)
+
+BOOST_AUTO_TEST_CASE(GivenParallelBuilders_WhenBuild_ThenOutputIsTheSameAsSequential) {
+  auto expected = build();
+  quadKeyBuilder.setBuildThreads(2);
+  quadKeyBuilder.setParallelBuilders(true);
+
+  auto actual = build();
+
+  std::sort(expected.begin(), expected.end());
+  std::sort(actual.begin(), actual.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenParallelBuilders_WhenBuild_ThenOutputIsGroupedByBuilderInOrderOfFirstUse) {
+  quadKeyBuilder.setBuildThreads(2);
+  quadKeyBuilder.setParallelBuilders(true);
+
+  auto actual = build();
+
+  BOOST_REQUIRE_EQUAL(actual.size(), 6);
+  auto first = actual[0].substr(0, actual[0].find(':'));
+  auto second = first=="first" ? "second" : "first";
+  for (std::size_t i = 0; i < 3; ++i) {
+    BOOST_CHECK_EQUAL(actual[i].substr(0, actual[i].find(':')), first);
+    BOOST_CHECK_EQUAL(actual[i + 3].substr(0, actual[i + 3].find(':')), second);
+  }
+  BOOST_CHECK_EQUAL(actual[2], first + ":complete");
+}
+
+BOOST_AUTO_TEST_CASE(GivenProgressiveOrder_WhenBuild_ThenBuildersCompleteInThatOrder) {
+  quadKeyBuilder.setProgressiveOrder({ "second" });
+
+  auto actual = build();
+
+  BOOST_REQUIRE_EQUAL(actual.size(), 6);
+  auto secondComplete = std::find(actual.begin(), actual.end(), "second:complete");
+  auto firstComplete = std::find(actual.begin(), actual.end(), "first:complete");
+  BOOST_CHECK(secondComplete < firstComplete);
+}
+
+BOOST_AUTO_TEST_CASE(GivenProgressiveParallelBuilders_WhenBuild_ThenOutputIsDeliveredBeforeNextBuilderIsFinished) {
+  std::atomic<bool> isDelivered(false);
+  quadKeyBuilder.setBuildThreads(2);
+  quadKeyBuilder.setParallelBuilders(true);
+  quadKeyBuilder.setProgressiveOrder({ "second", "first" });
+  quadKeyBuilder.registerElementBuilder("first", [&isDelivered](const BuilderContext &context) {
+    return make_unique<WaitingBuilder>(context, isDelivered);
+  });
+
+  std::vector<std::string> names;
+  quadKeyBuilder.build(quadKey, *dependencyProvider.getStyleProvider(), *dependencyProvider.getElevationProvider(),
+                       [&](const Mesh &mesh) {
+                         names.push_back(mesh.name);
+                         if (mesh.name=="second:complete")
+                           isDelivered = true;
+                       },
+                       [](const Element &) {},
+                       dependencyProvider.getCancellationToken());
+
+  std::vector<std::string> expected = { "second:2", "second:3", "second:complete", "first:after" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(names.begin(), names.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
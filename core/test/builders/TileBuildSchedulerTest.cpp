@@ -0,0 +1,97 @@
+#include "builders/QuadKeyBuilder.hpp"
+#include "builders/TileBuildScheduler.hpp"
+#include "entities/Node.hpp"
+#include "index/GeoStore.hpp"
+#include "index/InMemoryElementStore.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+#include <map>
+#include <stdexcept>
+
+using namespace utymap;
+using namespace utymap::builders;
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::math;
+using namespace utymap::tests;
+using namespace utymap::utils;
+
+namespace {
+const std::string StoreKey = "memory";
+const std::string Stylesheet = "node|z1[any] { builder: external; clip: false; }";
+
+struct Builders_TileBuildSchedulerFixture {
+  Builders_TileBuildSchedulerFixture() :
+      geoStore(*dependencyProvider.getStringTable()),
+      quadKeyBuilder(geoStore, *dependencyProvider.getStringTable()) {
+    geoStore.registerStore(StoreKey, make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+    dependencyProvider.getStyleProvider(Stylesheet);
+  }
+
+  /// Adds node to each tile of the first level of details.
+  std::vector<QuadKey> addNodes() {
+    std::vector<QuadKey> quadKeys;
+    std::uint64_t id = 0;
+    for (double latitude : {45., -45.}) {
+      for (double longitude : {-90., 90.}) {
+        Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), ++id, {{"any", "true"}});
+        node.coordinate = GeoCoordinate(latitude, longitude);
+        geoStore.add(StoreKey, node, LodRange(1, 1), *dependencyProvider.getStyleProvider(),
+                     dependencyProvider.getCancellationToken());
+        quadKeys.push_back(GeoUtils::GeoCoordinateToQuadKey(node.coordinate, 1));
+        ids[quadKeys.back()] = id;
+      }
+    }
+    return quadKeys;
+  }
+
+  DependencyProvider dependencyProvider;
+  GeoStore geoStore;
+  QuadKeyBuilder quadKeyBuilder;
+  std::map<QuadKey, std::uint64_t, QuadKey::Comparator> ids;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Builders_TileBuildScheduler, Builders_TileBuildSchedulerFixture)
+
+BOOST_AUTO_TEST_CASE(GivenTilesWithNodes_WhenBuild_ThenEachTileGetsItsNode) {
+  auto quadKeys = addNodes();
+  TileBuildScheduler scheduler(quadKeyBuilder, 2);
+  std::map<QuadKey, std::vector<std::uint64_t>, QuadKey::Comparator> actual;
+
+  scheduler.build(quadKeys, *dependencyProvider.getStyleProvider(), *dependencyProvider.getElevationProvider(),
+                  [](const QuadKey &, const Mesh &) {},
+                  [&](const QuadKey &quadKey, const Element &element) { actual[quadKey].push_back(element.id); },
+                  dependencyProvider.getCancellationToken());
+
+  BOOST_CHECK_EQUAL(actual.size(), quadKeys.size());
+  for (const auto &quadKey : quadKeys) {
+    BOOST_REQUIRE_EQUAL(actual[quadKey].size(), 1);
+    BOOST_CHECK_EQUAL(actual[quadKey][0], ids[quadKey]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenFailingCallback_WhenBuild_ThenAllTilesAreProcessedAndErrorIsRethrown) {
+  auto quadKeys = addNodes();
+  TileBuildScheduler scheduler(quadKeyBuilder, 2);
+  int calls = 0;
+
+  BOOST_CHECK_THROW(scheduler.build(quadKeys, *dependencyProvider.getStyleProvider(),
+                                    *dependencyProvider.getElevationProvider(),
+                                    [](const QuadKey &, const Mesh &) {},
+                                    [&](const QuadKey &, const Element &) {
+                                      ++calls;
+                                      throw std::domain_error("Test error");
+                                    },
+                                    dependencyProvider.getCancellationToken()),
+                    std::domain_error);
+
+  BOOST_CHECK_EQUAL(calls, static_cast<int>(quadKeys.size()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -6,6 +6,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
@@ -30,6 +32,29 @@ const std::string stylesheet = "area,relation|z1[building=yes] { "
     "relation|z1[type=multipolygon] {"
     "multipolygon: true;"
     "};";
+const std::string impostorStylesheet = "area|z1[building=yes] { "
+    "builder: building;"
+    "building: true;"
+    "impostor: true;"
+    "facade-color: gradient(blue);"
+    "facade-type: flat;"
+    "roof-color: gradient(red);"
+    "roof-type: dome;"
+    "height: 12m;"
+    "min-height: 0m;"
+    "}";
+const std::string evalRoofStylesheet = "area|z1[building=yes] { "
+    "builder: building;"
+    "building: true;"
+    "facade-color: gradient(blue);"
+    "facade-type: flat;"
+    "roof-color: gradient(red);"
+    "roof-type: eval(\"tag('roof:shape')\");"
+    "roof-height: 2m;"
+    "height: 12m;"
+    "min-height: 0m;"
+    "}";
+
 struct Builders_Buildings_BuildingsBuilderFixture {
   DependencyProvider dependencyProvider;
 };
@@ -75,6 +100,8 @@ BOOST_AUTO_TEST_CASE(GivenRelationWithHole_WhenVisitRelation_ThenMeshIsBuilt) {
       ElementUtils::createTag(*dependencyProvider.getStringTable(), "building", "yes"),
       ElementUtils::createTag(*dependencyProvider.getStringTable(), "type", "multipolygon"),
   };
+  // NOTE tags should be sorted by key id as style lookup uses binary search.
+  std::sort(relation.tags.begin(), relation.tags.end());
   auto outer = std::make_shared<Area>(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0, {},
                                                                         {{10, 0}, {10, 10}, {0, 10}, {0, 0}}));
   auto inner = std::make_shared<Area>(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0, {},
@@ -88,4 +115,90 @@ BOOST_AUTO_TEST_CASE(GivenRelationWithHole_WhenVisitRelation_ThenMeshIsBuilt) {
   BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenBatching_WhenVisitAreasAndComplete_ThenMeshesAreMergedWithRanges) {
+  QuadKey quadKey(1, 1, 0);
+  std::vector<std::string> names;
+  std::size_t triangles = 0;
+  auto context = dependencyProvider.createBuilderContext(
+      quadKey,
+      stylesheet,
+      [&](const Mesh &mesh) {
+        names.push_back(mesh.name);
+        triangles = mesh.triangles.size()/3;
+      });
+  context->batchVertexLimit = 65535;
+  BuildingBuilder builder(*context);
+
+  for (std::uint64_t id : {1, 2}) {
+    double offset = id*20;
+    builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), id, {{"building", "yes"}},
+                                                        {{offset + 10, 0}, {offset + 10, 10}, {offset, 10}, {offset, 0}}));
+  }
+  BOOST_CHECK(names.empty());
+  builder.complete();
+
+  BOOST_REQUIRE_EQUAL(names.size(), 1);
+  auto expected = "buildings:1-0,2-" + std::to_string(triangles/2);
+  BOOST_CHECK_EQUAL(names[0], expected);
+}
+
+BOOST_AUTO_TEST_CASE(GivenImpostorStyle_WhenVisitArea_ThenOnlyWallsAndFlatTopAreBuilt) {
+  QuadKey quadKey(1, 1, 0);
+  std::size_t triangles = 0, uvMapSize = 0;
+  auto context = dependencyProvider.createBuilderContext(
+      quadKey,
+      impostorStylesheet,
+      [&](const Mesh &mesh) {
+        triangles = mesh.triangles.size()/3;
+        uvMapSize = mesh.uvMap.size();
+      });
+  Area building = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0, {{"building", "yes"}},
+                                                    {{10, 0}, {10, 10}, {0, 10}, {0, 0}});
+  BuildingBuilder builder(*context);
+
+  builder.visitArea(building);
+
+  // NOTE four walls of two triangles and top of two triangles.
+  BOOST_CHECK_EQUAL(triangles, 10);
+  BOOST_CHECK_EQUAL(uvMapSize, 8);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSameStyle_WhenVisitAreas_ThenMeshesAreEqual) {
+  QuadKey quadKey(1, 1, 0);
+  std::vector<std::size_t> triangles;
+  auto context = dependencyProvider.createBuilderContext(
+      quadKey,
+      stylesheet,
+      [&](const Mesh &mesh) { triangles.push_back(mesh.triangles.size()); });
+  BuildingBuilder builder(*context);
+
+  for (std::uint64_t id : {1, 2})
+    builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), id, {{"building", "yes"}},
+                                                        {{10, 0}, {10, 10}, {0, 10}, {0, 0}}));
+
+  BOOST_REQUIRE_EQUAL(triangles.size(), 2);
+  BOOST_CHECK_GT(triangles[0], 0);
+  BOOST_CHECK_EQUAL(triangles[0], triangles[1]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenEvaluatedRoofType_WhenVisitAreas_ThenRoofIsResolvedPerBuilding) {
+  QuadKey quadKey(1, 1, 0);
+  std::vector<std::size_t> triangles;
+  auto context = dependencyProvider.createBuilderContext(
+      quadKey,
+      evalRoofStylesheet,
+      [&](const Mesh &mesh) { triangles.push_back(mesh.triangles.size()); });
+  BuildingBuilder builder(*context);
+
+  std::uint64_t id = 0;
+  for (const auto &shape : {"flat", "pyramidal", "flat"})
+    builder.visitArea(ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), ++id,
+                                                        {{"building", "yes"}, {"roof:shape", shape}},
+                                                        {{10, 0}, {10, 10}, {0, 10}, {0, 0}}));
+
+  BOOST_REQUIRE_EQUAL(triangles.size(), 3);
+  BOOST_CHECK_NE(triangles[0], triangles[1]);
+  BOOST_CHECK_EQUAL(triangles[0], triangles[2]);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -26,6 +26,7 @@ struct Builders_Buildings_Roofs_RoofBuildersFixture {
   std::shared_ptr<BuilderContext> builderContext;
   std::shared_ptr<MeshContext> meshContext;
   std::shared_ptr<Mesh> mesh;
+  Area building;
   std::shared_ptr<Style> style;
   ColorGradient gradient;
   TextureRegion textureRegion;
@@ -33,7 +34,7 @@ struct Builders_Buildings_Roofs_RoofBuildersFixture {
   template<typename T>
   T createRoofBuilder() {
     builderContext = dependencyProvider.createBuilderContext(QuadKey(16, 1, 0), stylesheet);
-    Area building =
+    building =
         ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0, {{"building", "yes"}}, {});
     style = std::make_shared<Style>(dependencyProvider.getStyleProvider(stylesheet)->forElement(building, 16));
     mesh = std::make_shared<Mesh>("");
@@ -3,6 +3,7 @@
 #include "builders/generators/LSystemGenerator.hpp"
 #include "entities/Node.hpp"
 #include "lsys/LSystemParser.hpp"
+#include "mapcss/MapCssParser.hpp"
 
 #include <boost/test/unit_test.hpp>
 #include <fstream>
@@ -38,10 +39,8 @@ struct Builders_Generators_GeneratorFixture {
       mesh(""),
       gradient(),
       textureRegion(),
-      style(dependencyProvider.getStyleProvider(stylesheet)
-                ->forElement(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(),
-                                                               0,
-                                                               {{"natural", "tree"}}), 1)),
+      node(ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, {{"natural", "tree"}})),
+      style(dependencyProvider.getStyleProvider(stylesheet)->forElement(node, 1)),
       builderContext(
           QuadKey(1, 35205, 21489),
           *dependencyProvider.getStyleProvider(stylesheet),
@@ -58,6 +57,7 @@ struct Builders_Generators_GeneratorFixture {
   Mesh mesh;
   ColorGradient gradient;
   TextureRegion textureRegion;
+  Node node;
   Style style;
   BuilderContext builderContext;
   MeshContext meshContext;
@@ -107,4 +107,32 @@ BOOST_AUTO_TEST_CASE(GivenLSystemGeneratorWithSimpleData_WhenGenerate_ThenCanGen
   BOOST_CHECK_GT(mesh.colors.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(GivenLSystemGeneratorWithCache_WhenGenerateTwice_ThenMeshIsTheSameAsGenerated) {
+  std::ifstream file(TEST_MAPCSS_PATH "tree.lsys");
+  auto stylesheet = utymap::mapcss::MapCssParser().parse(::stylesheet);
+  stylesheet.lsystems.emplace("tree", utymap::lsys::LSystemParser().parse(file));
+  StyleProvider styleProvider(stylesheet, *dependencyProvider.getStringTable());
+  BuilderContext context(builderContext.quadKey, styleProvider, builderContext.stringTable, builderContext.meshPool,
+                         builderContext.eleProvider, nullptr, nullptr, builderContext.cancelToken);
+  LSystemGenerator::Cache cache;
+  Mesh cached("");
+
+  for (const auto &position : {GeoCoordinate(52.53178, 13.38750), GeoCoordinate(52.53278, 13.38850)}) {
+    mesh.clear();
+    cached.clear();
+
+    LSystemGenerator::generate(context, style, mesh, position, 10);
+    LSystemGenerator::generate(context, style, cache, cached, position, 10);
+
+    BOOST_REQUIRE_EQUAL(cached.vertices.size(), mesh.vertices.size());
+    for (std::size_t i = 0; i < mesh.vertices.size(); ++i)
+      BOOST_CHECK_CLOSE(cached.vertices[i], mesh.vertices[i], 1E-6);
+    BOOST_CHECK_EQUAL_COLLECTIONS(cached.triangles.begin(), cached.triangles.end(),
+                                  mesh.triangles.begin(), mesh.triangles.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(cached.colors.begin(), cached.colors.end(),
+                                  mesh.colors.begin(), mesh.colors.end());
+  }
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
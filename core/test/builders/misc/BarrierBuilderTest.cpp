@@ -17,9 +17,24 @@ const std::string stylesheet = "way|z16[barrier] {"
     "color:gradient(red);"
     "offset:0.2m;"
     "}";
+const std::string gapStylesheet = "way|z16[barrier] {"
+    "height:2m; min-height:0m;"
+    "color:gradient(red);"
+    "width:0.1m; length:1m; gap:1m;"
+    "}";
+
 struct Builders_Misc_BarrierBuilderFixture {
   DependencyProvider dependencyProvider;
 };
+
+void checkTriangles(const Mesh &mesh) {
+  auto vertexCount = static_cast<int>(mesh.vertices.size()/3);
+  BOOST_CHECK_EQUAL(mesh.colors.size(), static_cast<std::size_t>(vertexCount));
+  BOOST_CHECK_EQUAL(mesh.uvs.size(), static_cast<std::size_t>(vertexCount*2));
+  BOOST_CHECK_EQUAL(mesh.triangles.size() % 3, 0);
+  for (int index : mesh.triangles)
+    BOOST_CHECK(index >= 0 && index < vertexCount);
+}
 }
 
 BOOST_FIXTURE_TEST_SUITE(Builders_Misc_BarrierBuilder, Builders_Misc_BarrierBuilderFixture)
@@ -43,4 +58,42 @@ BOOST_AUTO_TEST_CASE(GivenBarrier_WhenVisitWay_ThenMeshIsBuilt) {
   BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenContinuousBarrier_WhenVisitWay_ThenSegmentsShareVertices) {
+  std::size_t vertexSize = 0, triangleSize = 0;
+  auto context = dependencyProvider.createBuilderContext(QuadKey(16, 1, 1), stylesheet,
+                                                         [&](const Mesh &mesh) {
+                                                           vertexSize = mesh.vertices.size();
+                                                           triangleSize = mesh.triangles.size();
+                                                           checkTriangles(mesh);
+                                                         });
+  BarrierBuilder builder(*context);
+  Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+                                             {{"barrier", "yes"}},
+                                             {{0, 0}, {0, 10}, {10, 10}, {10, 0}});
+
+  builder.visitWay(way);
+
+  // two sides and top are strips with two vertices per point, two caps are planes.
+  BOOST_CHECK_EQUAL(vertexSize, (3*4*2 + 2*6)*3);
+  BOOST_CHECK_EQUAL(triangleSize, (3*3*2 + 2*2)*3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBarrierWithGaps_WhenVisitWay_ThenSeparateSegmentsAreBuilt) {
+  std::size_t vertexSize = 0;
+  auto context = dependencyProvider.createBuilderContext(QuadKey(16, 1, 1), gapStylesheet,
+                                                         [&](const Mesh &mesh) {
+                                                           vertexSize = mesh.vertices.size();
+                                                           checkTriangles(mesh);
+                                                         });
+  BarrierBuilder builder(*context);
+  Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+                                             {{"barrier", "yes"}},
+                                             {{0, 0}, {0, 0.00005}});
+
+  builder.visitWay(way);
+
+  // NOTE segment is about 5.5m long, so it has two pieces of wall.
+  BOOST_CHECK_EQUAL(vertexSize, 2*(4*6 + 2*3)*3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -87,4 +87,33 @@ BOOST_AUTO_TEST_CASE(GivenTreeRow_WhenVisitWay_ThenMeshIsBuilt) {
   BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenInstancing_WhenVisitTreesAndComplete_ThenPrototypeIsFollowedByInstances) {
+  std::vector<std::string> names;
+  std::vector<std::size_t> triangleSizes;
+  std::size_t instances = 0;
+  BuilderContext instancingContext(context.quadKey, context.styleProvider, context.stringTable, context.meshPool,
+                                   context.eleProvider,
+                                   [&](const Mesh &mesh) {
+                                     names.push_back(mesh.name);
+                                     triangleSizes.push_back(mesh.triangles.size());
+                                     if (mesh.triangles.empty()) instances = mesh.vertices.size()/3;
+                                   },
+                                   nullptr, context.cancelToken);
+  instancingContext.useInstancing = true;
+  TreeBuilder builder(instancingContext);
+  for (std::uint64_t id : {1, 2}) {
+    Node tree = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), id, {{"natural", "tree"}});
+    tree.coordinate = GeoCoordinate(52.5137977, 13.3818357 + id*0.0001);
+    builder.visitNode(tree);
+  }
+
+  builder.complete();
+
+  BOOST_REQUIRE_EQUAL(names.size(), 2);
+  BOOST_CHECK_EQUAL(names[0].find(MeshInstancer::prototypePrefix()), 0);
+  BOOST_CHECK_EQUAL(names[1], MeshInstancer::instancesPrefix() + names[0].substr(MeshInstancer::prototypePrefix().size()));
+  BOOST_CHECK_GT(triangleSizes[0], 0);
+  BOOST_CHECK_EQUAL(instances, 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
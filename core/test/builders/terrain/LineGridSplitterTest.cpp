@@ -116,4 +116,20 @@ BOOST_AUTO_TEST_CASE(GivenSpecificCase3_WhenSplit_ThenDoNotInflateDuplicates) {
   BOOST_CHECK_EQUAL(result.size(), 6);
 }
 
+BOOST_AUTO_TEST_CASE(GivenPath_WhenSplit_ThenAppendsPointsOfAllSegmentsWithoutDuplicates) {
+  LineGridSplitter splitter;
+  IntPath path {IntPoint(0, 0), IntPoint(3, 0), IntPoint(3, 2)};
+  DoublePoints result {Vector2(-1, -1)};
+
+  splitter.split(path, result);
+
+  DoublePoints expected {{-1, -1}, {0, 0}, {1, 0}, {2, 0}, {3, 0}, {3, 1}, {3, 2},
+                        {2, 4./3}, {1.5, 1}, {1, 2./3}, {0, 0}};
+  BOOST_REQUIRE_EQUAL(result.size(), expected.size());
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    BOOST_CHECK_CLOSE(expected[i].x, result[i].x, Precision);
+    BOOST_CHECK_CLOSE(expected[i].y, result[i].y, Precision);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,11 +1,14 @@
 #include "QuadKey.hpp"
 #include "builders/BuilderContext.hpp"
 #include "builders/terrain/TerraBuilder.hpp"
+#include "builders/terrain/TerraCache.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 
 #include <boost/test/unit_test.hpp>
 
+#include <numeric>
+
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
@@ -18,12 +21,25 @@ using namespace utymap::tests;
 namespace {
 const std::string stylesheet =
     "canvas|z1 { grid-cell-size: 1%; ele-noise-freq: 0.05; color-noise-freq: 0.1; color:gradient(red); max-area: 5%;"
-        "road-ele-noise-freq: 0; road-color-noise-freq: 0; road-color:gradient(red); road-max-area: 0;}"
+        "road-ele-noise-freq: 0; road-color-noise-freq: 0; road-color:gradient(red); road-max-area: 0;"
+        "water-ele-noise-freq: 0; water-color-noise-freq: 0; water-color:gradient(blue); water-max-area: 5%;}"
         "area|z1[landuse=commercial] { builder: terrain; terrain-layer:road; }"
 
         "way|z1[highway][incline] { incline: eval(\"tag('incline')\"); }"
         "way|z1[highway] { builder: terrain; terrain-layer:road; width: 0.0000001; }"
-        "way|z1[layer<0] { level: eval(\"tag('layer')\"); }";
+        "way|z1[layer<0] { level: eval(\"tag('layer')\"); }"
+        "way|z1[waterway] { builder: terrain; terrain-layer:water; width: 1; }";
+
+/// Returns area of mesh projection on surface.
+double getSurfaceArea(const Mesh &mesh) {
+  const auto &v = mesh.vertices;
+  double area = 0;
+  for (std::size_t i = 0; i < mesh.triangles.size(); i += 3) {
+    int a = mesh.triangles[i]*3, b = mesh.triangles[i + 1]*3, c = mesh.triangles[i + 2]*3;
+    area += std::abs((v[b] - v[a])*(v[c + 1] - v[a + 1]) - (v[b + 1] - v[a + 1])*(v[c] - v[a]))/2;
+  }
+  return area;
+}
 
 struct Builders_Terrain_TerraBuilderFixture {
   DependencyProvider dependencyProvider;
@@ -31,16 +47,21 @@ struct Builders_Terrain_TerraBuilderFixture {
   CancellationToken cancelToken;
 
   std::unique_ptr<TerraBuilder> create(const QuadKey &quadKey,
-                                       std::function<void(const utymap::math::Mesh &)> meshCallback) {
+                                       std::function<void(const utymap::math::Mesh &)> meshCallback,
+                                       utymap::utils::ThreadPool *threadPool = nullptr,
+                                       DependencyProvider *provider = nullptr,
+                                       TerraCache *cache = nullptr) {
+    if (provider==nullptr) provider = &dependencyProvider;
     context = utymap::utils::make_unique<BuilderContext>(quadKey,
-                                                         *dependencyProvider.getStyleProvider(stylesheet),
-                                                         *dependencyProvider.getStringTable(),
-                                                         *dependencyProvider.getMeshPool(),
-                                                         *dependencyProvider.getElevationProvider(),
+                                                         *provider->getStyleProvider(stylesheet),
+                                                         *provider->getStringTable(),
+                                                         *provider->getMeshPool(),
+                                                         *provider->getElevationProvider(),
                                                          meshCallback,
                                                          nullptr,
-                                                         cancelToken);
-    return utymap::utils::make_unique<TerraBuilder>(*context);
+                                                         cancelToken,
+                                                         threadPool);
+    return utymap::utils::make_unique<TerraBuilder>(*context, cache);
   }
 };
 }
@@ -65,4 +86,122 @@ BOOST_AUTO_TEST_CASE(GivenArea_WhenComplete_ThenSurfaceMeshIsNotEmpty) {
   BOOST_CHECK(isCalled);
 }
 
+BOOST_AUTO_TEST_CASE(GivenLayerWays_WhenComplete_ThenSurfaceMeshHasThem) {
+  std::size_t backgroundVertices = 0, vertices = 0;
+  auto callback = [](std::size_t &count) {
+    return [&count](const Mesh &mesh) {
+      if (mesh.name=="terrain_surface") count = mesh.vertices.size();
+    };
+  };
+  create(QuadKey(1, 0, 0), callback(backgroundVertices))->complete();
+  auto terraBuilder = create(QuadKey(1, 0, 0), callback(vertices));
+  ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+                                   {{"waterway", "river"}}, {{10, -170}, {10, -10}})
+      .accept(*terraBuilder);
+  ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 2,
+                                   {{"waterway", "river"}}, {{60, -90}, {0, -90}})
+      .accept(*terraBuilder);
+
+  terraBuilder->complete();
+
+  BOOST_CHECK_GT(backgroundVertices, 0);
+  BOOST_CHECK_GT(vertices, backgroundVertices);
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreadPool_WhenComplete_ThenSurfaceMeshIsTheSame) {
+  utymap::utils::ThreadPool threadPool(4);
+  std::vector<std::vector<double>> vertices(2);
+  for (std::size_t i = 0; i < vertices.size(); ++i) {
+    auto terraBuilder = create(QuadKey(1, 0, 0), [&](const Mesh &mesh) {
+      if (mesh.name=="terrain_surface") vertices[i] = mesh.vertices;
+    }, i==0 ? nullptr : &threadPool);
+    ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+                                      {{"landuse", "commercial"}},
+                                      {{0, 0}, {20, 0}, {20, 20}, {0, 20}})
+        .accept(*terraBuilder);
+    ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+                                     {{"waterway", "river"}}, {{60, -90}, {0, -90}})
+        .accept(*terraBuilder);
+
+    terraBuilder->complete();
+  }
+
+  BOOST_CHECK_GT(vertices[0].size(), 0);
+  BOOST_CHECK(vertices[0]==vertices[1]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenGridMesh_WhenComplete_ThenSurfaceHasLessTrianglesAndTheSameArea) {
+  DependencyProvider gridDependencyProvider;
+  gridDependencyProvider.getStyleProvider(stylesheet + "canvas|z1 { grid-mesh: true; grid-cell-size: 10%; }");
+  std::vector<std::pair<std::size_t, double>> meshes;
+  for (auto *provider : {&dependencyProvider, &gridDependencyProvider}) {
+    auto terraBuilder = create(QuadKey(1, 0, 0), [&](const Mesh &mesh) {
+      if (mesh.name=="terrain_surface") meshes.emplace_back(mesh.triangles.size(), getSurfaceArea(mesh));
+    }, nullptr, provider);
+    ElementUtils::createElement<Area>(*provider->getStringTable(), 0,
+                                      {{"landuse", "commercial"}},
+                                      {{0, 0}, {20, 0}, {20, 20}, {0, 20}})
+        .accept(*terraBuilder);
+
+    terraBuilder->complete();
+  }
+
+  BOOST_REQUIRE_EQUAL(meshes.size(), 2);
+  BOOST_CHECK_LT(meshes[1].first, meshes[0].first);
+  BOOST_CHECK_CLOSE(meshes[1].second, meshes[0].second, 1E-6);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCache_WhenLayerChanges_ThenSurfaceMeshIsTheSameAsWithoutCache) {
+  TerraCache cache;
+  auto build = [&](TerraCache *terraCache, double latitude) {
+    std::vector<double> vertices;
+    auto terraBuilder = create(QuadKey(1, 0, 0), [&](const Mesh &mesh) {
+      if (mesh.name=="terrain_surface") vertices = mesh.vertices;
+    }, nullptr, nullptr, terraCache);
+    ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+                                     {{"waterway", "river"}}, {{10, -170}, {10, -10}})
+        .accept(*terraBuilder);
+    ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 2,
+                                     {{"waterway", "river"}}, {{latitude, -90}, {0, -90}})
+        .accept(*terraBuilder);
+    terraBuilder->complete();
+    return vertices;
+  };
+
+  auto original = build(&cache, 60);
+  auto cached = build(&cache, 60);
+  auto changed = build(&cache, 50);
+
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+  BOOST_CHECK_GT(original.size(), 0);
+  BOOST_CHECK(cached==original);
+  BOOST_CHECK(changed!=original);
+  BOOST_CHECK(changed==build(nullptr, 50));
+}
+
+BOOST_AUTO_TEST_CASE(GivenVertexBudget_WhenComplete_ThenSurfaceIsEmittedInPartsWithTheSameArea) {
+  DependencyProvider streamingDependencyProvider;
+  streamingDependencyProvider.getStyleProvider(stylesheet + "canvas|z1 { mesh-vertex-budget: 1; }");
+  std::vector<std::vector<double>> areas(2);
+  for (std::size_t i = 0; i < areas.size(); ++i) {
+    auto *provider = i==0 ? &dependencyProvider : &streamingDependencyProvider;
+    auto terraBuilder = create(QuadKey(1, 0, 0), [&](const Mesh &mesh) {
+      if (mesh.name=="terrain_surface") areas[i].push_back(getSurfaceArea(mesh));
+    }, nullptr, provider);
+    ElementUtils::createElement<Area>(*provider->getStringTable(), 0,
+                                      {{"landuse", "commercial"}},
+                                      {{0, 0}, {20, 0}, {20, 20}, {0, 20}})
+        .accept(*terraBuilder);
+    ElementUtils::createElement<Way>(*provider->getStringTable(), 1,
+                                     {{"waterway", "river"}}, {{60, -90}, {0, -90}})
+        .accept(*terraBuilder);
+
+    terraBuilder->complete();
+  }
+
+  BOOST_REQUIRE_EQUAL(areas[0].size(), 1);
+  BOOST_CHECK_GT(areas[1].size(), 1);
+  BOOST_CHECK_CLOSE(std::accumulate(areas[1].begin(), areas[1].end(), 0.), areas[0][0], 1E-6);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -61,9 +61,9 @@ struct Builders_Terrain_TerraExtrasFixture {
   }
 
   Style generateStyle() {
-    Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
-                                                  {{"amenity", "forest"}},
-                                                  {{0, 0}, {10, 0}, {10, 10}, {0, 10}});
+    area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+                                             {{"amenity", "forest"}},
+                                             {{0, 0}, {10, 0}, {10, 10}, {0, 10}});
     return dependencyProvider.getStyleProvider(createStyleSheet())->forElement(area, 16);
   }
 
@@ -82,6 +82,7 @@ struct Builders_Terrain_TerraExtrasFixture {
   QuadKey quadKey;
   DependencyProvider dependencyProvider;
   BuilderContext builderContext;
+  Area area;
   bool isVerified;
 };
 }
@@ -1,3 +1,4 @@
+#include "entities/ElementDispatch.hpp"
 #include "entities/Node.hpp"
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
@@ -87,4 +88,30 @@ BOOST_AUTO_TEST_CASE(GivenRelation_WhenVisit_ThenIncrementsCounter) {
   BOOST_CHECK_EQUAL(counter.relations, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenElementsOfAllKinds_WhenDispatch_ThenVisitsActualTypes) {
+  Counter counter;
+  Node node;
+  Way way;
+  Area area;
+  Relation relation;
+  std::vector<const Element *> elements = { &node, &way, &area, &area, &relation };
+
+  for (const auto *element : elements)
+    dispatch(*element, counter);
+
+  BOOST_CHECK_EQUAL(counter.nodes, 1);
+  BOOST_CHECK_EQUAL(counter.ways, 1);
+  BOOST_CHECK_EQUAL(counter.areas, 2);
+  BOOST_CHECK_EQUAL(counter.relations, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCopiedArea_WhenGetKind_ThenReturnsArea) {
+  Area area;
+  area.id = 1;
+
+  Area copy(area);
+
+  BOOST_CHECK(copy.kind == ElementKind::Area);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+#include "formats/mvt/MvtParser.hpp"
+#include "formats/shape/CountableShapeDataVisitor.hpp"
+#include "utils/GeometryUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+using namespace utymap;
+using namespace utymap::formats;
+
+namespace {
+const double Precision = 0.1e-7;
+
+typedef std::vector<std::vector<std::pair<int, int>>> Parts;
+
+/// Encodes vector tile messages.
+struct TileWriter final {
+  static void varint(std::string &out, std::uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+  }
+
+  static void field(std::string &out, std::uint32_t field, std::uint64_t value) {
+    varint(out, field << 3);
+    varint(out, value);
+  }
+
+  static void message(std::string &out, std::uint32_t field, const std::string &data) {
+    varint(out, (field << 3) | 2);
+    varint(out, data.size());
+    out.append(data);
+  }
+
+  static std::uint32_t zigzag(int value) {
+    return static_cast<std::uint32_t>((value << 1) ^ (value >> 31));
+  }
+
+  /// Encodes geometry commands of parts. Rings of polygon are closed by ClosePath.
+  static std::string geometry(const Parts &parts, bool isPolygon) {
+    std::string out;
+    int x = 0, y = 0;
+    for (const auto &part : parts) {
+      for (std::size_t i = 0; i < part.size(); ++i) {
+        if (i == 0) varint(out, (1 << 3) | 1);
+        if (i == 1) varint(out, ((part.size() - 1) << 3) | 2);
+        varint(out, zigzag(part[i].first - x));
+        varint(out, zigzag(part[i].second - y));
+        x = part[i].first;
+        y = part[i].second;
+      }
+      if (isPolygon) varint(out, (1 << 3) | 7);
+    }
+    return out;
+  }
+
+  static std::string feature(int type, const std::vector<std::uint32_t> &tags, const Parts &parts) {
+    std::string out, packed;
+    for (auto tag : tags) varint(packed, tag);
+    message(out, 2, packed);
+    field(out, 3, static_cast<std::uint64_t>(type));
+    message(out, 4, geometry(parts, type == 3));
+    return out;
+  }
+
+  static std::string value(const std::string &text) {
+    std::string out;
+    message(out, 1, text);
+    return out;
+  }
+
+  static std::string layer(const std::string &name, const std::vector<std::string> &features,
+                           const std::vector<std::string> &keys, const std::vector<std::string> &values) {
+    std::string out;
+    field(out, 15, 2);
+    message(out, 1, name);
+    for (const auto &feature : features) message(out, 2, feature);
+    for (const auto &key : keys) message(out, 3, key);
+    for (const auto &text : values) message(out, 4, value(text));
+    field(out, 5, 4096);
+    return out;
+  }
+};
+
+struct Formats_Mvt_MvtParserFixture {
+  void parse(const std::vector<std::string> &layers, const QuadKey &tile) {
+    std::string data;
+    for (const auto &layer : layers)
+      TileWriter::message(data, 3, layer);
+    std::stringstream stream(data);
+    parser.parse(stream, tile, visitor);
+  }
+
+  MvtParser<CountableShapeDataVisitor> parser;
+  CountableShapeDataVisitor visitor;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Formats_Mvt_MvtParser, Formats_Mvt_MvtParserFixture)
+
+BOOST_AUTO_TEST_CASE(GivenPoint_WhenParse_ThenHasCorrectCoordinateAndTags) {
+  parse({ TileWriter::layer("poi", { TileWriter::feature(1, { 0, 0 }, { {{ 2048, 4096 }} }) }, { "shop" }, { "bakery" }) },
+        QuadKey(1, 0, 0));
+
+  BOOST_CHECK_EQUAL(visitor.nodes, 1);
+  BOOST_CHECK_SMALL(visitor.lastCoordinate.latitude, Precision);
+  BOOST_CHECK_CLOSE(visitor.lastCoordinate.longitude, -90, Precision);
+  BOOST_REQUIRE_EQUAL(visitor.lastTags.size(), 2);
+  BOOST_CHECK_EQUAL(visitor.lastTags[0].key, "shop");
+  BOOST_CHECK_EQUAL(visitor.lastTags[0].value, "bakery");
+  BOOST_CHECK_EQUAL(visitor.lastTags[1].key, MvtParser<CountableShapeDataVisitor>::layerKey());
+  BOOST_CHECK_EQUAL(visitor.lastTags[1].value, "poi");
+}
+
+BOOST_AUTO_TEST_CASE(GivenLinesAndPolygons_WhenParse_ThenVisitsWaysAndRelations) {
+  Parts line = { {{ 0, 0 }, { 10, 10 }, { 20, 0 }} };
+  Parts multiLine = { {{ 0, 0 }, { 10, 10 }}, {{ 20, 20 }, { 30, 30 }} };
+  Parts polygon = { {{ 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }} };
+  Parts polygonWithHole = { {{ 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }},
+                            {{ 2, 2 }, { 2, 8 }, { 8, 8 }, { 8, 2 }} };
+
+  parse({ TileWriter::layer("roads", { TileWriter::feature(2, {}, line), TileWriter::feature(2, {}, multiLine) }, {}, {}),
+          TileWriter::layer("water", { TileWriter::feature(3, {}, polygon), TileWriter::feature(3, {}, polygonWithHole) }, {}, {}) },
+        QuadKey(14, 8800, 5373));
+
+  BOOST_CHECK_EQUAL(visitor.ways, 2);
+  BOOST_CHECK_EQUAL(visitor.relations, 2);
+  BOOST_REQUIRE_EQUAL(visitor.lastMembers.size(), 2);
+  BOOST_CHECK(visitor.lastMembers[0].isRing);
+  BOOST_CHECK_EQUAL(visitor.lastMembers[0].coordinates.size(), 4);
+  BOOST_CHECK(!utymap::utils::isClockwise(visitor.lastMembers[0].coordinates));
+  BOOST_CHECK(utymap::utils::isClockwise(visitor.lastMembers[1].coordinates));
+}
+
+BOOST_AUTO_TEST_CASE(GivenPolygonWithoutHoles_WhenParse_ThenVisitsRing) {
+  parse({ TileWriter::layer("building", { TileWriter::feature(3, {}, { {{ 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 }} }) }, {}, {}) },
+        QuadKey(14, 8800, 5373));
+
+  BOOST_CHECK_EQUAL(visitor.ways, 1);
+  BOOST_CHECK(visitor.isRing);
+  BOOST_CHECK_EQUAL(visitor.lastCoordinates.size(), 4);
+  BOOST_CHECK(!utymap::utils::isClockwise(visitor.lastCoordinates));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTilePath_WhenGetTile_ThenReturnsQuadKey) {
+  auto tile = MvtParser<CountableShapeDataVisitor>::getTile("data/tiles/14/8800/5373.mvt");
+
+  BOOST_CHECK(tile == QuadKey(14, 8800, 5373));
+  BOOST_CHECK_THROW(MvtParser<CountableShapeDataVisitor>::getTile("data/tile.mvt"), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -62,6 +62,7 @@ struct Formats_Osm_MultipolygonProcessorFixture {
 
   DependencyProvider dependencyProvider;
   OsmDataContext context;
+  utymap::CancellationToken cancelToken;
 };
 }
 
@@ -77,7 +78,8 @@ BOOST_AUTO_TEST_CASE(GivenOneOuterOneInnerAllClosed_WhenProcess_ThenReturnCorrec
   MultipolygonProcessor processor(*createRelation(), relationMembers, context,
                                   std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
                                             this,
-                                            std::placeholders::_1));
+                                            std::placeholders::_1),
+                                  cancelToken);
 
   processor.process();
 
@@ -105,7 +107,8 @@ BOOST_AUTO_TEST_CASE(GivenOneOuterTwoInnerAllClosed_WhenProcess_ThenReturnCorrec
   MultipolygonProcessor processor(*createRelation(), relationMembers, context,
                                   std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
                                             this,
-                                            std::placeholders::_1));
+                                            std::placeholders::_1),
+                                  cancelToken);
 
   processor.process();
 
@@ -135,7 +138,8 @@ BOOST_AUTO_TEST_CASE(GivenOneOuterNonClosed_WhenProcess_ThenReturnCorrectResult)
   MultipolygonProcessor processor(*createRelation(), relationMembers, context,
                                   std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
                                             this,
-                                            std::placeholders::_1));
+                                            std::placeholders::_1),
+                                  cancelToken);
 
   processor.process();
 
@@ -156,7 +160,8 @@ BOOST_AUTO_TEST_CASE(GivenTwoOuterClosed_WhenProcess_ThenReturnCorrectResult) {
   MultipolygonProcessor processor(*createRelation(), relationMembers, context,
                                   std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
                                             this,
-                                            std::placeholders::_1));
+                                            std::placeholders::_1),
+                                  cancelToken);
 
   processor.process();
 
@@ -182,7 +187,8 @@ BOOST_AUTO_TEST_CASE(GivenOneOuterNonClosedAndTwoInnerClosed_WhenProcess_ThenRet
   MultipolygonProcessor processor(*createRelation(), relationMembers, context,
                                   std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
                                             this,
-                                            std::placeholders::_1));
+                                            std::placeholders::_1),
+                                  cancelToken);
 
   processor.process();
 
@@ -258,7 +264,8 @@ BOOST_AUTO_TEST_CASE(GivenMultiplyOuterAndMultiplyInner_WhenProcess_ThenReturnCo
   MultipolygonProcessor processor(*createRelation(), relationMembers, context,
                                   std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
                                             this,
-                                            std::placeholders::_1));
+                                            std::placeholders::_1),
+                                  cancelToken);
 
   processor.process();
 
@@ -286,7 +293,8 @@ BOOST_AUTO_TEST_CASE(GivenSpecificFourOuter_WhenProcess_ThenDoesNotCrash) {
   MultipolygonProcessor processor(*createRelation(), relationMembers, context,
                                   std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
                                             this,
-                                            std::placeholders::_1));
+                                            std::placeholders::_1),
+                                  cancelToken);
 
   processor.process();
 
@@ -295,4 +303,51 @@ BOOST_AUTO_TEST_CASE(GivenSpecificFourOuter_WhenProcess_ThenDoesNotCrash) {
   BOOST_CHECK_EQUAL(4, reinterpret_cast<const Area &>(*relation->elements[0]).coordinates.size());
 }
 
+BOOST_AUTO_TEST_CASE(GivenManyShuffledOuterWaysAndManyInner_WhenProcess_ThenReturnCorrectResult) {
+  const int sideSegments = 25;
+  const int innerCount = 40;
+  // square outline split into ways which are listed in mixed order and direction
+  std::vector<GeoCoordinate> outline;
+  for (int i = 0; i < sideSegments; ++i) outline.push_back(GeoCoordinate(0, i * 4));
+  for (int i = 0; i < sideSegments; ++i) outline.push_back(GeoCoordinate(i * 4, 100));
+  for (int i = 0; i < sideSegments; ++i) outline.push_back(GeoCoordinate(100, 100 - i * 4));
+  for (int i = 0; i < sideSegments; ++i) outline.push_back(GeoCoordinate(100 - i * 4, 0));
+  RelationMembers relationMembers;
+  const int wayCount = static_cast<int>(outline.size());
+  for (int i = 0; i < wayCount; ++i) {
+    int index = (i * 37) % wayCount;
+    auto way = createElement<Way>({});
+    way->coordinates.push_back(outline[index]);
+    way->coordinates.push_back(outline[(index + 1) % wayCount]);
+    if (i % 2 == 0)
+      std::reverse(way->coordinates.begin(), way->coordinates.end());
+    context.wayMap[i + 1] = way;
+    relationMembers.push_back(RelationMember{static_cast<std::uint64_t>(i + 1), "w", "outer"});
+  }
+  for (int i = 0; i < innerCount; ++i) {
+    double lat = 10 + (i / 8) * 15, lon = 10 + (i % 8) * 10;
+    std::uint64_t id = wayCount + i + 1;
+    context.areaMap[id] = createElement<Area>({{lat, lon}, {lat + 5, lon}, {lat + 5, lon + 5}, {lat, lon + 5}});
+    relationMembers.push_back(RelationMember{id, "w", "inner"});
+  }
+  MultipolygonProcessor processor(*createRelation(), relationMembers, context,
+                                  std::bind(&Formats_Osm_MultipolygonProcessorFixture::resolve,
+                                            this,
+                                            std::placeholders::_1),
+                                  cancelToken);
+
+  processor.process();
+
+  auto relation = context.relationMap[0];
+  BOOST_CHECK_EQUAL(innerCount + 1, relation->elements.size());
+  const auto &outer = reinterpret_cast<const Area &>(*relation->elements[0]).coordinates;
+  BOOST_CHECK_EQUAL(outline.size(), outer.size());
+  BOOST_CHECK(!utymap::utils::isClockwise(outer));
+  for (std::size_t i = 1; i < relation->elements.size(); ++i) {
+    const auto &inner = reinterpret_cast<const Area &>(*relation->elements[i]).coordinates;
+    BOOST_CHECK_EQUAL(4, inner.size());
+    BOOST_CHECK(utymap::utils::isClockwise(inner));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+#include "formats/osm/NodeLocationStore.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::formats;
+
+namespace {
+const double Precision = 1E-7;
+const std::string LocationPath = "nodes.test";
+
+struct Formats_Osm_NodeLocationStoreFixture {
+  ~Formats_Osm_NodeLocationStoreFixture() {
+    boost::filesystem::remove(LocationPath);
+  }
+
+  NodeLocationStore store;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Formats_Osm_NodeLocationStore, Formats_Osm_NodeLocationStoreFixture)
+
+BOOST_AUTO_TEST_CASE(GivenSortedLocations_WhenFind_ThenReturnsCoordinate) {
+  store.add(1, GeoCoordinate(52.5306085, 13.3831211));
+  store.add(5, GeoCoordinate(-33.8567844, 151.2152967));
+
+  GeoCoordinate coordinate;
+  BOOST_CHECK(store.find(5, coordinate));
+
+  BOOST_CHECK_CLOSE(coordinate.latitude, -33.8567844, Precision);
+  BOOST_CHECK_CLOSE(coordinate.longitude, 151.2152967, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnknownId_WhenFind_ThenReturnsFalse) {
+  store.add(1, GeoCoordinate(52.53, 13.38));
+
+  GeoCoordinate coordinate;
+  BOOST_CHECK(!store.find(2, coordinate));
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnsortedLocationsWithDuplicate_WhenFind_ThenLastLocationIsUsed) {
+  store.add(7, GeoCoordinate(1, 1));
+  store.add(3, GeoCoordinate(2, 2));
+  store.add(7, GeoCoordinate(3, 3));
+
+  GeoCoordinate coordinate;
+  BOOST_CHECK(store.find(7, coordinate));
+
+  BOOST_CHECK_EQUAL(store.size(), 2);
+  BOOST_CHECK_CLOSE(coordinate.latitude, 3, Precision);
+  BOOST_CHECK(store.find(3, coordinate));
+  BOOST_CHECK_CLOSE(coordinate.latitude, 2, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnsortedLocationsInFile_WhenFind_ThenReturnsCoordinates) {
+  NodeLocationStore fileStore(LocationPath, 1);
+  fileStore.add(9, GeoCoordinate(9, 9));
+  fileStore.add(2, GeoCoordinate(2, 2));
+  fileStore.add(9, GeoCoordinate(10, 10));
+
+  GeoCoordinate coordinate;
+  BOOST_CHECK(fileStore.find(9, coordinate));
+
+  BOOST_CHECK_EQUAL(fileStore.size(), 2);
+  BOOST_CHECK_CLOSE(coordinate.latitude, 10, Precision);
+  BOOST_CHECK(fileStore.find(2, coordinate));
+  BOOST_CHECK(!fileStore.find(3, coordinate));
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompleteFile_WhenOpenWithSameStamp_ThenLocationsAreReused) {
+  GeoCoordinate coordinate;
+  {
+    NodeLocationStore fileStore(LocationPath, 1);
+    fileStore.add(1, GeoCoordinate(52.53, 13.38));
+    fileStore.find(1, coordinate);
+  }
+
+  NodeLocationStore fileStore(LocationPath, 1);
+
+  BOOST_CHECK(fileStore.isReused());
+  BOOST_CHECK(fileStore.find(1, coordinate));
+  BOOST_CHECK_CLOSE(coordinate.longitude, 13.38, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompleteFile_WhenOpenWithOtherStamp_ThenFileIsRebuilt) {
+  GeoCoordinate coordinate;
+  {
+    NodeLocationStore fileStore(LocationPath, 1);
+    fileStore.add(1, GeoCoordinate(52.53, 13.38));
+    fileStore.find(1, coordinate);
+  }
+
+  NodeLocationStore fileStore(LocationPath, 2);
+
+  BOOST_CHECK(!fileStore.isReused());
+  BOOST_CHECK(!fileStore.find(1, coordinate));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
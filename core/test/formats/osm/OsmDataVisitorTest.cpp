@@ -1,8 +1,14 @@
 #include "entities/Relation.hpp"
 #include "formats/osm/OsmDataVisitor.hpp"
+#include "formats/osm/xml/OsmXmlParser.hpp"
 
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <utility>
 
+#include "config.hpp"
 #include "test_utils/DependencyProvider.hpp"
 
 using namespace utymap::entities;
@@ -22,6 +28,30 @@ struct Formats_Osm_OsmDataVisitorFixture {
   }
 
   bool add(utymap::entities::Element &) { return false; }
+
+  /// Imports test xml file and returns sorted ids of added elements.
+  std::vector<std::uint64_t> import(bool isTwoPass) {
+    std::vector<std::uint64_t> ids;
+    auto collect = [&](Element &element) { ids.push_back(element.id); return true; };
+    const auto &stringTable = *dependencyProvider.getStringTable();
+    const auto &cancelToken = dependencyProvider.getCancellationToken();
+
+    std::ifstream file(TEST_XML_FILE);
+    if (isTwoPass) {
+      std::ifstream referenceFile(TEST_XML_FILE);
+      OsmReferenceVisitor referenceVisitor;
+      OsmXmlParser<OsmReferenceVisitor>().parse(referenceFile, referenceVisitor);
+      OsmDataVisitor dataVisitor(stringTable, collect, cancelToken, referenceVisitor.complete());
+      OsmXmlParser<OsmDataVisitor>().parse(file, dataVisitor);
+      dataVisitor.complete();
+    } else {
+      OsmDataVisitor dataVisitor(stringTable, collect, cancelToken);
+      OsmXmlParser<OsmDataVisitor>().parse(file, dataVisitor);
+      dataVisitor.complete();
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  }
 };
 }
 
@@ -38,4 +68,57 @@ BOOST_AUTO_TEST_CASE(GivenRelationWithRecursion_WhenComplete_ThenDoesNotCrash) {
   visitor.complete();
 }
 
+BOOST_AUTO_TEST_CASE(GivenXmlFile_WhenImportInTwoPasses_ThenSameElementsAreAdded) {
+  auto expected = import(false);
+
+  auto actual = import(true);
+
+  BOOST_CHECK(!expected.empty());
+  BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenBoundingBox_WhenVisitNodesAndWay_ThenOnlyElementsInsideAreAdded) {
+  std::vector<std::uint64_t> ids;
+  OsmDataVisitor dataVisitor(*dependencyProvider.getStringTable(),
+                             [&](Element &element) { ids.push_back(element.id); return true; },
+                             dependencyProvider.getCancellationToken());
+  dataVisitor.setBoundingBox(utymap::BoundingBox(utymap::GeoCoordinate(0, 0), utymap::GeoCoordinate(1, 1)));
+  Tags tags = {};
+  utymap::GeoCoordinate inside(0.5, 0.5), outside(2, 2);
+  std::vector<std::uint64_t> nodeIds = {1, 2};
+
+  dataVisitor.visitNode(1, inside, tags);
+  dataVisitor.visitNode(2, outside, tags);
+  dataVisitor.visitWay(3, nodeIds, tags);
+  dataVisitor.complete();
+
+  std::vector<std::uint64_t> expected = {1, 3};
+  BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenXmlFile_WhenCompleteInParallel_ThenSameElementsAndRelationMembersAreAdded) {
+  auto importFile = [&](std::size_t threadCount) {
+    std::vector<std::pair<std::uint64_t, std::size_t>> elements;
+    std::mutex lock;
+    OsmDataVisitor dataVisitor(*dependencyProvider.getStringTable(), [&](Element &element) {
+      auto relation = dynamic_cast<Relation *>(&element);
+      std::lock_guard<std::mutex> guard(lock);
+      elements.emplace_back(element.id, relation != nullptr ? relation->elements.size() : 0);
+      return true;
+    }, dependencyProvider.getCancellationToken());
+    dataVisitor.setCompletionThreads(threadCount, nullptr, true);
+    std::ifstream file(TEST_XML_FILE);
+    OsmXmlParser<OsmDataVisitor>().parse(file, dataVisitor);
+    dataVisitor.complete();
+    std::sort(elements.begin(), elements.end());
+    return elements;
+  };
+  auto expected = importFile(0);
+
+  auto actual = importFile(3);
+
+  BOOST_CHECK(!expected.empty());
+  BOOST_CHECK(actual == expected);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,8 @@
 #include "config.hpp"
 
 #include <boost/test/unit_test.hpp>
+#include <fstream>
+#include <sstream>
 
 #include "test_utils/DependencyProvider.hpp"
 
@@ -34,4 +36,19 @@ BOOST_AUTO_TEST_CASE(GivenDefaultJson_WhenParserParse_ThenHasExpectedElementCoun
   BOOST_CHECK_EQUAL(16, visitor.relations);
 }
 
+BOOST_AUTO_TEST_CASE(GivenPropertiesBeforeGeometry_WhenParserParse_ThenHasExpectedElementCount) {
+  std::istringstream json(
+    "{\"pois\": {\"type\": \"FeatureCollection\", \"features\": ["
+    "  {\"properties\": {\"name\": \"A \\\"B\\\" \\u00e9\", \"tags\": [1, 2], \"id\": -5},"
+    "   \"geometry\": {\"type\": \"Point\", \"coordinates\": [13.5, 52.5]}},"
+    "  {\"geometry\": {\"coordinates\": [[[[0, 0], [1, 0], [1, 1], [0, 0]]], [[[2, 2], [3, 2], [3, 3], [2, 2]]]],"
+    "   \"type\": \"MultiPolygon\"}, \"properties\": {}}"
+    "]}}");
+
+  parser.parse(json, visitor);
+
+  BOOST_CHECK_EQUAL(1, visitor.nodes);
+  BOOST_CHECK_EQUAL(1, visitor.relations);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -37,4 +37,14 @@ BOOST_AUTO_TEST_CASE(GivenDefaultPbf_WhenParserParse_ThenHasExpectedElementCount
   BOOST_CHECK_EQUAL(visitor.relations, 3064);
 }
 
+BOOST_AUTO_TEST_CASE(GivenPipelinedParser_WhenParse_ThenHasExpectedElementCount) {
+  OsmPbfParser<CountableOsmDataVisitor> pipelinedParser(4);
+
+  pipelinedParser.parse(istream, visitor);
+
+  BOOST_CHECK_EQUAL(visitor.nodes, 562170);
+  BOOST_CHECK_EQUAL(visitor.ways, 82731);
+  BOOST_CHECK_EQUAL(visitor.relations, 3064);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
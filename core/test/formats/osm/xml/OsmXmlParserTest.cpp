@@ -8,6 +8,7 @@
 #include "test_utils/DependencyProvider.hpp"
 
 #include <fstream>
+#include <sstream>
 #include <boost/test/unit_test.hpp>
 #include <numeric>
 
@@ -145,4 +146,35 @@ BOOST_AUTO_TEST_CASE(GivenTestDummyOsmXml_WhenParserParse_ThenHasProperWay) {
   BOOST_CHECK(reduce(checkList.begin(), checkList.end()));
 }
 
+BOOST_AUTO_TEST_CASE(GivenXmlWithEntitiesAndComments_WhenParserParse_ThenValuesAreDecoded) {
+  std::istringstream istream(
+    "<?xml version='1.0' encoding='UTF-8'?>\n"
+    "<osm version=\"0.6\">\n"
+    "  <!-- node <node id=\"2\"/> is commented -->\n"
+    "  <node id=\"1\" lat=\"52.5\" lon=\"-13.25\">\n"
+    "    <tag k=\"name\" v=\"A &amp; B &gt; C &#x41;\"/>\n"
+    "    <tag k=\"note\" v='1 > 0'/>\n"
+    "  </node>\n"
+    "</osm>");
+  std::vector<std::uint64_t> ids;
+  CountableOsmDataVisitor counter;
+  OsmXmlParser<CountableOsmDataVisitor>().parse(istream, counter);
+  BOOST_CHECK_EQUAL(1, counter.nodes);
+
+  istream.clear();
+  istream.seekg(0);
+  OsmDataVisitor visitor(*dependencyProvider.getStringTable(), [&](Element &element) {
+    if (auto node = dynamic_cast<Node *>(&element)) {
+      ids.push_back(node->id);
+      assertNode(*node, utymap::GeoCoordinate(52.5, -13.25),
+                 {createTag("name", "A & B > C A"), createTag("note", "1 > 0")});
+    }
+    return true;
+  }, dependencyProvider.getCancellationToken());
+  OsmXmlParser<OsmDataVisitor>().parse(istream, visitor);
+  visitor.complete();
+
+  BOOST_CHECK_EQUAL(ids.size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
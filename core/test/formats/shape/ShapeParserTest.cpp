@@ -92,4 +92,18 @@ BOOST_AUTO_TEST_CASE(GivenTestMultiPolyFile_WhenParse_ThenHasCorrectGeometry) {
   BOOST_CHECK_CLOSE(visitor.lastMembers[1].coordinates[0].longitude, -94.9856752963366, Precision);
 }
 
+BOOST_AUTO_TEST_CASE(GivenThreadPool_WhenParse_ThenVisitsSameRecordsAsSequentialParser) {
+  ShapeParser<CountableShapeDataVisitor> parallelParser(2);
+  CountableShapeDataVisitor parallelVisitor;
+
+  parser.parse(TEST_SHAPE_NE_110M_ADMIN, visitor);
+  parallelParser.parse(TEST_SHAPE_NE_110M_ADMIN, parallelVisitor);
+
+  BOOST_CHECK(visitor.relations > 0);
+  BOOST_CHECK_EQUAL(parallelVisitor.relations, visitor.relations);
+  BOOST_CHECK_EQUAL(parallelVisitor.ways, visitor.ways);
+  BOOST_CHECK_EQUAL(parallelVisitor.lastTags.size(), visitor.lastTags.size());
+  BOOST_CHECK_EQUAL(parallelVisitor.lastMembers.size(), visitor.lastMembers.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,78 @@
+#include "heightmap/CompressedElevationProvider.hpp"
+#include "heightmap/SrtmElevationProvider.hpp"
+
+#include "config.hpp"
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+
+namespace {
+const std::string IndexPath = "compressed_index/";
+
+struct Heightmap_CompressedElevationProviderFixture {
+  Heightmap_CompressedElevationProviderFixture() :
+      quadKey(16, 35205, 21489),
+      srtmEleProvider(TEST_ASSETS_PATH "index/") {
+    boost::filesystem::create_directories(IndexPath + "data/");
+  }
+
+  ~Heightmap_CompressedElevationProviderFixture() {
+    boost::filesystem::remove_all(IndexPath);
+  }
+
+  QuadKey quadKey;
+  SrtmElevationProvider srtmEleProvider;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Heightmap_CompressedElevationProvider, Heightmap_CompressedElevationProviderFixture)
+
+BOOST_AUTO_TEST_CASE(GivenCompressedCell_WhenGetElevation_ThenReturnTheSameValuesAsSrtm) {
+  std::string hgzPath = IndexPath + "data/N52E013.hgz";
+  CompressedElevationProvider::compress(TEST_ASSETS_PATH "index/data/N52E013.hgt", hgzPath, 100);
+  CompressedElevationProvider eleProvider(IndexPath, 2);
+  std::vector<GeoCoordinate> coordinates {{52.5317429, 13.3871987}, {52.52, 13.38}, {52.9, 13.9},
+                                          {52.0001, 13.0001}, {52.9999, 13.9999}, {52.5, 13.25}};
+
+  BOOST_CHECK(boost::filesystem::file_size(hgzPath) < boost::filesystem::file_size(TEST_ASSETS_PATH "index/data/N52E013.hgt"));
+  for (const auto &coordinate : coordinates)
+    BOOST_CHECK_EQUAL(eleProvider.getElevation(quadKey, coordinate), srtmEleProvider.getElevation(quadKey, coordinate));
+}
+
+BOOST_AUTO_TEST_CASE(GivenLocations_WhenGetElevations_ThenReturnTheSameValuesAsForSingleLocation) {
+  CompressedElevationProvider::compress(TEST_ASSETS_PATH "index/data/N52E013.hgt", IndexPath + "data/N52E013.hgz");
+  CompressedElevationProvider eleProvider(IndexPath);
+  std::vector<GeoCoordinate> coordinates {{52.5317429, 13.3871987}, {52.52, 13.38}, {52.9, 13.9}};
+  std::vector<double> elevations(coordinates.size());
+
+  eleProvider.getElevations(quadKey, coordinates.data(), elevations.data(), coordinates.size());
+
+  for (std::size_t i = 0; i < coordinates.size(); ++i)
+    BOOST_CHECK_EQUAL(elevations[i], eleProvider.getElevation(quadKey, coordinates[i]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenPrefetchedTile_WhenGetElevation_ThenReturnTheSameValueAsSrtm) {
+  CompressedElevationProvider::compress(TEST_ASSETS_PATH "index/data/N52E013.hgt", IndexPath + "data/N52E013.hgz");
+  CompressedElevationProvider eleProvider(IndexPath);
+
+  eleProvider.prefetch(quadKey);
+
+  BOOST_CHECK_EQUAL(eleProvider.getElevation(quadKey, 52.5317429, 13.3871987),
+                    srtmEleProvider.getElevation(quadKey, 52.5317429, 13.3871987));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingCell_WhenGetElevation_ThenThrowsException) {
+  CompressedElevationProvider eleProvider(IndexPath);
+
+  BOOST_CHECK_THROW(eleProvider.getElevation(quadKey, 10.5, 10.5), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
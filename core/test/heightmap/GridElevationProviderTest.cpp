@@ -1,8 +1,11 @@
 #include "heightmap/GridElevationProvider.hpp"
 
 #include "config.hpp"
+#include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 using namespace utymap;
 using namespace utymap::heightmap;
 
@@ -65,4 +68,75 @@ BOOST_AUTO_TEST_CASE(GivenLocationNearTopRight_WhenGetElevation_ThenReturnExpect
   BOOST_CHECK_CLOSE(ele, 4.5, Precision);
 }
 
+BOOST_AUTO_TEST_CASE(GivenLocations_WhenGetElevations_ThenReturnTheSameHeightsAsForSingleLocation) {
+  std::vector<GeoCoordinate> coordinates {bbox.minPoint, bbox.center(), bbox.maxPoint};
+  std::vector<double> elevations(coordinates.size());
+
+  eleProvider.getElevations(quadKey, coordinates.data(), elevations.data(), coordinates.size());
+
+  for (std::size_t i = 0; i < coordinates.size(); ++i)
+    BOOST_CHECK_EQUAL(elevations[i], eleProvider.getElevation(quadKey, coordinates[i]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingGrid_WhenPrefetch_ThenThrowsException) {
+  BOOST_CHECK_THROW(eleProvider.prefetch(QuadKey(16, 0, 0)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBinaryGrid_WhenGetElevation_ThenReturnTheSameHeightsAsForTextGrid) {
+  std::string indexPath = "grid_index/";
+  std::string dataPath = indexPath + "data/16/";
+  boost::filesystem::create_directories(dataPath);
+  std::vector<GeoCoordinate> coordinates {bbox.minPoint, bbox.center(), bbox.maxPoint,
+                                          GeoCoordinate(bbox.maxPoint.latitude, bbox.center().longitude + bbox.width()/4)};
+  for (auto sampleType : {GridElevationProvider::SampleType::Int16, GridElevationProvider::SampleType::Float32}) {
+    GridElevationProvider::convert(quadKey,
+                                   TEST_ASSETS_PATH "index/data/16/1202102332220103.ele",
+                                   dataPath + "1202102332220103.grd",
+                                   sampleType);
+    GridElevationProvider binaryProvider(indexPath);
+
+    for (const auto &coordinate : coordinates)
+      BOOST_CHECK_CLOSE(binaryProvider.getElevation(quadKey, coordinate),
+                        eleProvider.getElevation(quadKey, coordinate), Precision);
+  }
+  boost::filesystem::remove_all(indexPath);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCacheOfOneGrid_WhenGetElevationForDifferentQuadKeys_ThenReturnExpectedHeights) {
+  std::string indexPath = "grid_lru_index/";
+  boost::filesystem::create_directories(indexPath + "data/16/");
+  QuadKey otherQuadKey(16, 35206, 21489);
+  BoundingBox otherBbox = utymap::utils::GeoUtils::quadKeyToBoundingBox(otherQuadKey);
+  for (const auto &key : {quadKey, otherQuadKey})
+    GridElevationProvider::convert(key,
+                                   TEST_ASSETS_PATH "index/data/16/1202102332220103.ele",
+                                   indexPath + "data/16/" + utymap::utils::GeoUtils::quadKeyToString(key) + ".grd");
+  GridElevationProvider lruProvider(indexPath, 1);
+
+  for (int i = 0; i < 3; ++i) {
+    BOOST_CHECK_CLOSE(lruProvider.getElevation(quadKey, bbox.minPoint), -3, Precision);
+    BOOST_CHECK_CLOSE(lruProvider.getElevation(otherQuadKey, otherBbox.maxPoint), 5, Precision);
+  }
+  boost::filesystem::remove_all(indexPath);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoLoadedGrids_WhenSetMaxCacheSizeToOne_ThenOneGridIsKept) {
+  std::string indexPath = "grid_capacity_index/";
+  boost::filesystem::create_directories(indexPath + "data/16/");
+  QuadKey otherQuadKey(16, 35206, 21489);
+  for (const auto &key : {quadKey, otherQuadKey})
+    GridElevationProvider::convert(key,
+                                   TEST_ASSETS_PATH "index/data/16/1202102332220103.ele",
+                                   indexPath + "data/16/" + utymap::utils::GeoUtils::quadKeyToString(key) + ".grd");
+  GridElevationProvider provider(indexPath);
+  provider.prefetch(quadKey);
+  provider.prefetch(otherQuadKey);
+  auto memoryUsage = provider.getMemoryUsage();
+
+  provider.setMaxCacheSize(1);
+
+  BOOST_CHECK_EQUAL(provider.getMemoryUsage() * 2, memoryUsage);
+  boost::filesystem::remove_all(indexPath);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,8 +1,12 @@
 #include "heightmap/SrtmElevationProvider.hpp"
 
 #include "config.hpp"
+#include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <thread>
+#include <vector>
+
 using namespace utymap;
 using namespace utymap::heightmap;
 
@@ -16,4 +20,83 @@ BOOST_AUTO_TEST_CASE(GivenTestLocation_WhenGetElevation_ThenReturnExpectedIntege
   BOOST_CHECK_CLOSE(ele, 34.853, 0.01);
 }
 
+BOOST_AUTO_TEST_CASE(GivenCacheOfOneCell_WhenGetElevationRepeatedly_ThenReturnTheSameValue) {
+  SrtmElevationProvider eleProvider(TEST_ASSETS_PATH "index/", 1);
+  QuadKey quadKey(16, 35205, 21489);
+
+  double ele = eleProvider.getElevation(quadKey, 52.5317429, 13.3871987);
+
+  BOOST_CHECK_CLOSE(eleProvider.getElevation(quadKey, 52.5317429, 13.3871987), ele, 1E-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeveralThreads_WhenGetElevation_ThenReturnTheSameValue) {
+  SrtmElevationProvider eleProvider(TEST_ASSETS_PATH "index/");
+  QuadKey quadKey(16, 35205, 21489);
+  std::vector<double> elevations(4);
+  std::vector<std::thread> threads;
+
+  for (std::size_t i = 0; i < elevations.size(); ++i)
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < 1000; ++j)
+        elevations[i] = eleProvider.getElevation(quadKey, 52.5317429, 13.3871987);
+    });
+  for (auto &thread : threads)
+    thread.join();
+
+  for (double ele : elevations)
+    BOOST_CHECK_CLOSE(ele, 34.853, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLocations_WhenGetElevations_ThenReturnTheSameValuesAsForSingleLocation) {
+  SrtmElevationProvider eleProvider(TEST_ASSETS_PATH "index/");
+  QuadKey quadKey(16, 35205, 21489);
+  std::vector<GeoCoordinate> coordinates {{52.5317429, 13.3871987}, {52.52, 13.38}, {52.9, 13.9}};
+  std::vector<double> elevations(coordinates.size());
+
+  eleProvider.getElevations(quadKey, coordinates.data(), elevations.data(), coordinates.size());
+
+  for (std::size_t i = 0; i < coordinates.size(); ++i)
+    BOOST_CHECK_EQUAL(elevations[i], eleProvider.getElevation(quadKey, coordinates[i]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenMissingCell_WhenGetElevation_ThenThrowsDomainError) {
+  SrtmElevationProvider eleProvider(TEST_ASSETS_PATH "index/");
+
+  BOOST_CHECK_THROW(eleProvider.getElevation(QuadKey(16, 0, 0), 10.5, 10.5), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPrefetchedTile_WhenGetElevation_ThenReturnExpectedValue) {
+  SrtmElevationProvider eleProvider(TEST_ASSETS_PATH "index/", 1);
+  QuadKey quadKey(16, 35205, 21489);
+
+  eleProvider.prefetch(quadKey);
+
+  BOOST_CHECK_CLOSE(eleProvider.getElevation(quadKey, 52.5317429, 13.3871987), 34.853, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoPyramid_WhenGetElevationForCoarseTile_ThenReturnOriginalValue) {
+  SrtmElevationProvider eleProvider(TEST_ASSETS_PATH "index/");
+
+  double ele = eleProvider.getElevation(QuadKey(1, 1, 0), 52.5317429, 13.3871987);
+
+  BOOST_CHECK_CLOSE(ele, 34.853, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPyramid_WhenGetElevationForCoarseTile_ThenUsesDownsampledLevel) {
+  namespace fs = boost::filesystem;
+  std::string indexPath = "srtm_index/";
+  fs::create_directories(indexPath + "data/");
+  fs::copy_file(TEST_ASSETS_PATH "index/data/N52E013.hgt", indexPath + "data/N52E013.hgt",
+                fs::copy_option::overwrite_if_exists);
+
+  SrtmElevationProvider::buildPyramid(indexPath);
+  SrtmElevationProvider eleProvider(indexPath);
+
+  BOOST_CHECK_EQUAL(fs::file_size(indexPath + "pyramid/6/N52E013.hgt"), 601*601*2);
+  BOOST_CHECK_EQUAL(fs::file_size(indexPath + "pyramid/3600/N52E013.hgt"), 2*2*2);
+  BOOST_CHECK_CLOSE(eleProvider.getElevation(QuadKey(16, 35205, 21489), 52.5317429, 13.3871987), 34.853, 0.01);
+  BOOST_CHECK_CLOSE(eleProvider.getElevation(QuadKey(10, 550, 335), 52.5317429, 13.3871987), 34.853, 5);
+  fs::remove_all(indexPath);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+#include "heightmap/GridElevationProvider.hpp"
+#include "heightmap/TileElevationCache.hpp"
+
+#include "config.hpp"
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::heightmap;
+
+namespace {
+struct Heightmap_TileElevationCacheFixture {
+  Heightmap_TileElevationCacheFixture() :
+      quadKey(16, 35205, 21489),
+      bbox(utymap::utils::GeoUtils::quadKeyToBoundingBox(quadKey)),
+      eleProvider(TEST_ASSETS_PATH "index/") {
+  }
+
+  QuadKey quadKey;
+  BoundingBox bbox;
+  GridElevationProvider eleProvider;
+};
+
+const double Precision = 0.1;
+}
+
+BOOST_FIXTURE_TEST_SUITE(Heightmap_TileElevationCache, Heightmap_TileElevationCacheFixture)
+
+BOOST_AUTO_TEST_CASE(GivenLocationsInsideTile_WhenGetElevation_ThenReturnTheSameHeightsAsProvider) {
+  TileElevationCache eleCache(eleProvider, quadKey, 2);
+  std::vector<GeoCoordinate> coordinates {bbox.minPoint, bbox.center(), bbox.maxPoint,
+                                          GeoCoordinate(bbox.center().latitude + bbox.height()/4,
+                                                        bbox.center().longitude + bbox.width()/4)};
+
+  for (const auto &coordinate : coordinates)
+    BOOST_CHECK_CLOSE(eleCache.getElevation(quadKey, coordinate),
+                      eleProvider.getElevation(quadKey, coordinate), Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenLocations_WhenGetElevations_ThenReturnTheSameHeightsAsForSingleLocation) {
+  TileElevationCache eleCache(eleProvider, quadKey, 8);
+  std::vector<GeoCoordinate> coordinates {bbox.minPoint, bbox.center(), bbox.maxPoint};
+  std::vector<double> elevations(coordinates.size());
+
+  eleCache.getElevations(quadKey, coordinates.data(), elevations.data(), coordinates.size());
+
+  for (std::size_t i = 0; i < coordinates.size(); ++i)
+    BOOST_CHECK_EQUAL(elevations[i], eleCache.getElevation(quadKey, coordinates[i]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenLocationOutsideTile_WhenGetElevation_ThenProviderIsUsed) {
+  TileElevationCache eleCache(eleProvider, quadKey, 2);
+  GeoCoordinate coordinate(bbox.maxPoint.latitude + bbox.height()/4, bbox.center().longitude);
+
+  BOOST_CHECK_EQUAL(eleCache.getElevation(quadKey, coordinate), eleProvider.getElevation(quadKey, coordinate));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
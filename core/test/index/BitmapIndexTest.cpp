@@ -23,6 +23,7 @@ namespace {
 
     void notify(const utymap::QuadKey& quadKey,
                 const std::uint32_t order,
+                const utymap::BoundingBox &,
                 ElementVisitor &visitor) override {
       addedElements.at(order)->accept(visitor_);
     }
@@ -225,4 +226,64 @@ BOOST_AUTO_TEST_CASE(GivenElement_WhenQueryWithPartiallyValidAndRule_ThenHasNoRe
   BOOST_CHECK_EQUAL(this->visitedElements.size(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(GivenCompiledQueryWithDuplicateTerms_WhenSearchTwice_ThenHasSameResults) {
+  addThreeElements();
+  auto query = index.compile({ "", "addr Eichendorffstr addr", "", bbox, lodRange });
+
+  index.search(query, *this);
+  index.search(query, *this);
+
+  BOOST_CHECK_EQUAL(query.andTerms.size(), 2);
+  BOOST_REQUIRE_EQUAL(this->visitedElements.size(), 2);
+  BOOST_CHECK_EQUAL(getString(this->visitedElements[0]->tags[0].key), "addr:street");
+  BOOST_CHECK_EQUAL(getString(this->visitedElements[1]->tags[0].key), "addr:street");
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreeElements_WhenQueryWithPrefixAnd_ThenOneResult) {
+  BitmapIndex::Query query = { "", "addr Eichen*", "", bbox, lodRange };
+  addThreeElements();
+
+  index.search(query, *this);
+
+  BOOST_REQUIRE_EQUAL(this->visitedElements.size(), 1);
+  BOOST_CHECK_EQUAL(getString(this->visitedElements[0]->tags[0].key), "addr:street");
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreeElements_WhenQueryWithPrefixOr_ThenTwoResults) {
+  BitmapIndex::Query query = { "", "", "Ber* Deu*", bbox, lodRange };
+  addThreeElements();
+
+  index.search(query, *this);
+
+  BOOST_CHECK_EQUAL(this->visitedElements.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreeElements_WhenQueryWithUnknownPrefix_ThenNoResults) {
+  BitmapIndex::Query query = { "", "addr Xyz*", "", bbox, lodRange };
+  addThreeElements();
+
+  index.search(query, *this);
+
+  BOOST_CHECK_EQUAL(this->visitedElements.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreeElements_WhenQueryWithFuzzyAnd_ThenOneResult) {
+  BitmapIndex::Query query = { "", "Berln~", "", bbox, lodRange };
+  addThreeElements();
+
+  index.search(query, *this);
+
+  BOOST_REQUIRE_EQUAL(this->visitedElements.size(), 1);
+  BOOST_CHECK_EQUAL(getString(this->visitedElements[0]->tags[0].key), "addr:city");
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreeElements_WhenQueryWithFuzzyAndOutOfDistance_ThenNoResults) {
+  BitmapIndex::Query query = { "", "Brn~", "", bbox, lodRange };
+  addThreeElements();
+
+  index.search(query, *this);
+
+  BOOST_CHECK_EQUAL(this->visitedElements.size(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
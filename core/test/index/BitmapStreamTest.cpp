@@ -2,6 +2,7 @@
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/test/unit_test.hpp>
+#include <ewah/ewah.h>
 
 #include <fstream>
 
@@ -64,4 +65,68 @@ BOOST_AUTO_TEST_CASE(GivenBitmapWithTwoRows_WhenSaved_ThenCanBeReadBack) {
   BOOST_CHECK_EQUAL_COLLECTIONS(resultArray2.begin(), resultArray2.end(), expectedArray2.begin(), expectedArray2.end());
 }
 
+BOOST_AUTO_TEST_CASE(GivenDeltaLog_WhenReadDelta_ThenBitmapHasAllEntries) {
+  BitmapIndex::Bitmap result;
+  result[0].set(1);
+
+  BitmapStream::writeDelta(file, 2, { 0, 5 });
+  BitmapStream::writeDelta(file, 3, { 5 });
+  file.flush();
+  BitmapStream::readDelta(file, result);
+
+  BOOST_CHECK_EQUAL(result.size(), 2);
+  auto resultArray1 = result[0].toArray();
+  auto resultArray2 = result[5].toArray();
+  std::vector<std::uint32_t> expectedArray1 = { 1, 2 };
+  std::vector<std::uint32_t> expectedArray2 = { 2, 3 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(resultArray1.begin(), resultArray1.end(), expectedArray1.begin(), expectedArray1.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(resultArray2.begin(), resultArray2.end(), expectedArray2.begin(), expectedArray2.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenDeltaLogWithUnorderedTombstones_WhenReadDelta_ThenAllOrdersAreErased) {
+  BitmapIndex::Bitmap result;
+
+  BitmapStream::writeDelta(file, 4, { BitmapIndex::ErasedToken });
+  BitmapStream::writeDelta(file, 1, { BitmapIndex::ErasedToken });
+  file.flush();
+  BitmapStream::readDelta(file, result);
+
+  auto resultArray = result[BitmapIndex::ErasedToken].toArray();
+  std::vector<std::uint32_t> expectedArray = { 1, 4 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(resultArray.begin(), resultArray.end(), expectedArray.begin(), expectedArray.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMoreTokensThanEntryCanKeep_WhenReadDelta_ThenBitmapHasAllTokens) {
+  BitmapIndex::Bitmap result;
+  BitmapIndex::Ids ids(70000);
+  for (std::uint32_t i = 0; i < ids.size(); ++i)
+    ids[i] = i;
+
+  BitmapStream::writeDelta(file, 7, ids);
+  file.flush();
+  BitmapStream::readDelta(file, result);
+
+  BOOST_CHECK_EQUAL(result.size(), ids.size());
+  BOOST_CHECK(result[ids.back()].get(7));
+}
+
+BOOST_AUTO_TEST_CASE(GivenLegacyEwahBitmap_WhenRead_ThenCanBeReadBack) {
+  BitmapIndex::Bitmap result;
+  std::uint32_t key = 3;
+  EWAHBoolArray<std::uint32_t> legacy;
+  legacy.set(1);
+  legacy.set(40);
+  legacy.set(100000);
+  file.write(reinterpret_cast<const char *>(&key), sizeof(key));
+  legacy.write(file);
+  file.flush();
+
+  BitmapStream::read(file, result);
+
+  BOOST_CHECK_EQUAL(result.size(), 1);
+  auto resultArray = result[3].toArray();
+  std::vector<std::uint32_t> expectedArray = { 1, 40, 100000 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(resultArray.begin(), resultArray.end(), expectedArray.begin(), expectedArray.end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
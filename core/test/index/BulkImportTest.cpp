@@ -0,0 +1,57 @@
+#include "entities/Node.hpp"
+#include "index/BulkImport.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+const std::string RunPath = "test";
+
+struct Index_BulkImportFixture {
+  /// Adds nodes with given ids into given quad keys.
+  void add(BulkImport &import, const std::vector<std::pair<std::uint64_t, QuadKey>> &nodes) {
+    for (const auto &pair : nodes) {
+      Node node;
+      node.id = pair.first;
+      node.coordinate = GeoCoordinate(1, 2);
+      import.add(node, pair.second);
+    }
+  }
+
+  /// Returns ids of merged elements.
+  std::vector<std::uint64_t> merge(BulkImport &import) {
+    std::vector<std::uint64_t> ids;
+    import.merge([&](const QuadKey &, const Element &element) { ids.push_back(element.id); });
+    return ids;
+  }
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_BulkImport, Index_BulkImportFixture)
+
+BOOST_AUTO_TEST_CASE(GivenElementsInMemory_WhenMerge_ThenTheyAreOrderedByQuadKey) {
+  BulkImport import(RunPath, 1024 * 1024);
+  add(import, { { 1, QuadKey(1, 1, 0) }, { 2, QuadKey(1, 0, 0) }, { 3, QuadKey(1, 1, 0) } });
+
+  BOOST_CHECK((merge(import) == std::vector<std::uint64_t>{ 2, 1, 3 }));
+  BOOST_CHECK(import.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementsInRuns_WhenMerge_ThenTheyAreOrderedByQuadKeyAndRunsAreRemoved) {
+  // NOTE every element exceeds limit, so it is written into separate run.
+  BulkImport import(RunPath, 1);
+  add(import, { { 1, QuadKey(1, 1, 0) }, { 2, QuadKey(1, 0, 0) }, { 3, QuadKey(1, 1, 0) } });
+  BOOST_CHECK(boost::filesystem::exists(RunPath + "0.run"));
+
+  BOOST_CHECK((merge(import) == std::vector<std::uint64_t>{ 2, 1, 3 }));
+  BOOST_CHECK(import.empty());
+  BOOST_CHECK(!boost::filesystem::exists(RunPath + "0.run"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
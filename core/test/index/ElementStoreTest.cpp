@@ -4,6 +4,7 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "index/ElementGeometryVisitor.hpp"
 #include "index/ElementStore.hpp"
 
 #include <boost/test/unit_test.hpp>
@@ -11,6 +12,8 @@
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
+#include <map>
+
 using namespace utymap;
 using namespace utymap::entities;
 using namespace utymap::index;
@@ -84,9 +87,9 @@ BOOST_AUTO_TEST_CASE(GivenWayIntersectsTwoTilesOnce_WhenStore_GeometryIsClipped)
   TestElementStore elementStore(*dependencyProvider.getStringTable(),
     [&](const Element &element, const QuadKey &quadKey) {
       if (checkQuadKey(quadKey, 1, 0, 0)) {
-        checkGeometry<Way>(static_cast<const Way &>(element), {{10, -10}, {10, 0}});
+        checkGeometry<Way>(static_cast<const Way &>(element), {{10, 0}, {10, -10}});
       } else if (checkQuadKey(quadKey, 1, 1, 0)) {
-        checkGeometry<Way>(static_cast<const Way &>(element), {{10, 0}, {10, 10}});
+        checkGeometry<Way>(static_cast<const Way &>(element), {{10, 10}, {10, 0}});
       } else {
         BOOST_FAIL("Unexpected quadKey!");
       }
@@ -106,14 +109,14 @@ BOOST_AUTO_TEST_CASE(GivenWayIntersectsTwoTilesTwice_WhenStore_GeometryIsClipped
       [&](const Element &element, const QuadKey &quadKey) {
         if (checkQuadKey(quadKey, 1, 0, 0)) {
           checkGeometry<Way>(static_cast<const Way &>(element),
-                              {{20, 0}, {20, -10}, {10, -10}, {10, 0}});
+                              {{10, 0}, {10, -10}, {20, -10}, {20, 0}});
         } else if (checkQuadKey(quadKey, 1, 1, 0)) {
           const Relation &relation = static_cast<const Relation &>(element);
           BOOST_CHECK_EQUAL(relation.elements.size(), 2);
           checkGeometry<Way>(static_cast<const Way &>(*relation.elements[0]),
-                              {{20, 10}, {20, 0}});
+                              {{10, 10}, {10, 0}});
           checkGeometry<Way>(static_cast<const Way &>(*relation.elements[1]),
-                              {{10, 0}, {10, 10}});
+                              {{20, 0}, {20, 10}});
         } else {
           BOOST_FAIL("Unexpected quadKey!");
         }
@@ -125,6 +128,29 @@ BOOST_AUTO_TEST_CASE(GivenWayIntersectsTwoTilesTwice_WhenStore_GeometryIsClipped
   BOOST_CHECK_EQUAL(elementStore.times, 2);
 }
 
+BOOST_AUTO_TEST_CASE(GivenStoredCopyOfClippedRelation_WhenStoreAnotherWay_ThenCopyIsNotChanged) {
+  Way way1 = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+                                              {{"test", "Foo"}},
+                                              {{10, 10}, {10, -10}, {20, -10}, {20, 10}});
+  Way way2 = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 2,
+                                              {{"test", "Foo"}},
+                                              {{30, 10}, {30, -10}, {40, -10}, {40, 10}});
+  std::vector<std::shared_ptr<Relation>> relations;
+  TestElementStore elementStore(*dependencyProvider.getStringTable(),
+      [&](const Element &element, const QuadKey &quadKey) {
+        if (checkQuadKey(quadKey, 1, 1, 0))
+          relations.push_back(std::make_shared<Relation>(static_cast<const Relation &>(element)));
+      });
+  auto styleProvider = dependencyProvider.getStyleProvider("way|z1[test=Foo] { key:val; clip: true;}");
+
+  elementStore.store(way1, LodRange(1, 1), *styleProvider);
+  elementStore.store(way2, LodRange(1, 1), *styleProvider);
+
+  BOOST_REQUIRE_EQUAL(relations.size(), 2);
+  checkGeometry<Way>(static_cast<const Way &>(*relations[0]->elements[0]), {{10, 10}, {10, 0}});
+  checkGeometry<Way>(static_cast<const Way &>(*relations[1]->elements[0]), {{30, 10}, {30, 0}});
+}
+
 BOOST_AUTO_TEST_CASE(GivenWayOutsideTileWithBoundingBoxIntersectingTile_WhenStore_IsSkipped) {
   Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
                                              {{"test", "Foo"}},
@@ -302,4 +328,58 @@ BOOST_AUTO_TEST_CASE(GivenWay_WhenStoreInsideQuadKey_IsStored) {
   BOOST_CHECK_EQUAL(elementStore.times, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenConcaveArea_WhenStoreWithHierarchicalClipping_ThenGeometryIsTheSameAsWithout) {
+  typedef std::map<QuadKey, BoundingBox, QuadKey::Comparator> BoundingBoxes;
+  Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 0,
+                                                {{"test", "Foo"}},
+                                                {{-50, -60}, {50, -60}, {50, 60}, {-50, 60},
+                                                 {-50, 50}, {40, 50}, {40, -50}, {-50, -50}});
+  auto styleProvider = dependencyProvider.getStyleProvider("area|z1-3[test=Foo] { key:val; clip: true;}");
+  auto storeArea = [&](bool isHierarchical, BoundingBoxes &bboxes) {
+    TestElementStore elementStore(*dependencyProvider.getStringTable(),
+      [&](const Element &element, const QuadKey &quadKey) {
+        ElementGeometryVisitor visitor;
+        element.accept(visitor);
+        bboxes[quadKey] = visitor.boundingBox;
+      });
+    elementStore.setHierarchicalClipping(isHierarchical);
+    elementStore.store(area, LodRange(1, 3), *styleProvider);
+    return elementStore.times;
+  };
+  BoundingBoxes expected, actual;
+
+  int expectedTimes = storeArea(false, expected);
+  int actualTimes = storeArea(true, actual);
+
+  BOOST_CHECK(expectedTimes > 8);
+  BOOST_CHECK_EQUAL(actualTimes, expectedTimes);
+  BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+  for (const auto &pair : expected) {
+    auto bbox = actual.find(pair.first);
+    BOOST_REQUIRE(bbox != actual.end());
+    BOOST_CHECK_SMALL(bbox->second.minPoint.latitude - pair.second.minPoint.latitude, 1E-6);
+    BOOST_CHECK_SMALL(bbox->second.minPoint.longitude - pair.second.minPoint.longitude, 1E-6);
+    BOOST_CHECK_SMALL(bbox->second.maxPoint.latitude - pair.second.maxPoint.latitude, 1E-6);
+    BOOST_CHECK_SMALL(bbox->second.maxPoint.longitude - pair.second.maxPoint.longitude, 1E-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayWithSimplifyStyle_WhenStore_ThenOnlyLowLevelGeometryIsSimplified) {
+  Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+                                             {{"test", "Foo"}},
+                                             {{10, 10}, {10.0001, 10.001}, {9.9999, 10.002}, {10, 10.003}});
+  std::map<int, std::size_t> sizes;
+  TestElementStore elementStore(*dependencyProvider.getStringTable(),
+      [&](const Element &element, const QuadKey &quadKey) {
+        sizes[quadKey.levelOfDetail] = static_cast<const Way &>(element).coordinates.size();
+      });
+
+  elementStore.store(way, LodRange(1, 16),
+                     *dependencyProvider.getStyleProvider("way|z1[test=Foo], way|z16[test=Foo] { key:val; simplify: 1;}"));
+
+  BOOST_CHECK_EQUAL(sizes.size(), 2);
+  BOOST_CHECK_EQUAL(sizes[1], 2);
+  BOOST_CHECK_EQUAL(sizes[16], 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,177 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
+#include "index/ElementStream.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+  const double Precision = 1E-7;
+
+  template<typename T>
+  void writeRaw(std::ostream &stream, T value) {
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  std::unique_ptr<Element> roundtrip(const Element &element, std::uint64_t id) {
+    std::stringstream stream;
+    ElementStream::write(stream, element);
+    std::string data = stream.str();
+    return ElementStream::read(data.data(), data.size(), id);
+  }
+
+  void checkCoordinate(const GeoCoordinate &actual, const GeoCoordinate &expected) {
+    BOOST_CHECK_SMALL(actual.latitude - expected.latitude, Precision);
+    BOOST_CHECK_SMALL(actual.longitude - expected.longitude, Precision);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(Index_ElementStream)
+
+BOOST_AUTO_TEST_CASE(GivenNode_WhenWrittenAndRead_ThenItIsTheSame) {
+  Node node;
+  node.coordinate = GeoCoordinate(52.5301234, 13.3876543);
+  node.tags = { Tag(1, 2), Tag(300000, 70000) };
+
+  auto result = roundtrip(node, 7);
+
+  auto resultNode = dynamic_cast<Node *>(result.get());
+  BOOST_REQUIRE(resultNode != nullptr);
+  BOOST_CHECK_EQUAL(resultNode->id, 7);
+  checkCoordinate(resultNode->coordinate, node.coordinate);
+  BOOST_REQUIRE_EQUAL(resultNode->tags.size(), 2);
+  BOOST_CHECK_EQUAL(resultNode->tags[1].key, 300000);
+  BOOST_CHECK_EQUAL(resultNode->tags[1].value, 70000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenArea_WhenWritten_ThenItIsSmallerThanRawCoordinates) {
+  Area area;
+  area.coordinates = { GeoCoordinate(-33.8567844, 151.2152967), GeoCoordinate(-33.8567, 151.2153), GeoCoordinate(-33.85, 151.21) };
+  area.tags = { Tag(1, 2) };
+
+  std::stringstream stream;
+  ElementStream::write(stream, area);
+  auto result = ElementStream::read(stream, 2);
+
+  BOOST_CHECK_LT(stream.str().size(), area.coordinates.size() * 2 * sizeof(double));
+  auto resultArea = dynamic_cast<Area *>(result.get());
+  BOOST_REQUIRE(resultArea != nullptr);
+  BOOST_REQUIRE_EQUAL(resultArea->coordinates.size(), 3);
+  for (std::size_t i = 0; i < resultArea->coordinates.size(); ++i)
+    checkCoordinate(resultArea->coordinates[i], area.coordinates[i]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRelation_WhenWrittenAndRead_ThenMembersAreRestored) {
+  auto node = std::make_shared<Node>();
+  node->id = 1ull << 40;
+  node->coordinate = GeoCoordinate(1, 2);
+  auto way = std::make_shared<Way>();
+  way->id = 3;
+  way->coordinates = { GeoCoordinate(1, 2), GeoCoordinate(3, 4) };
+  Relation relation;
+  relation.tags = { Tag(5, 6) };
+  relation.elements = { node, way };
+
+  auto result = roundtrip(relation, 10);
+
+  auto resultRelation = dynamic_cast<Relation *>(result.get());
+  BOOST_REQUIRE(resultRelation != nullptr);
+  BOOST_REQUIRE_EQUAL(resultRelation->elements.size(), 2);
+  BOOST_CHECK_EQUAL(resultRelation->elements[0]->id, node->id);
+  BOOST_CHECK_EQUAL(resultRelation->elements[1]->id, way->id);
+  auto resultWay = dynamic_cast<Way *>(resultRelation->elements[1].get());
+  BOOST_REQUIRE(resultWay != nullptr);
+  checkCoordinate(resultWay->coordinates[1], way->coordinates[1]);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRelationWithResolvedMember_WhenWrittenAndRead_ThenMemberIsReadByOrder) {
+  auto node = std::make_shared<Node>();
+  node->id = 1;
+  node->coordinate = GeoCoordinate(1, 2);
+  auto way = std::make_shared<Way>();
+  way->id = 3;
+  way->coordinates = { GeoCoordinate(1, 2), GeoCoordinate(3, 4) };
+  Relation relation;
+  relation.elements = { node, way };
+  std::stringstream stream;
+  std::uint32_t readOrder = 0;
+
+  ElementStream::write(stream, relation, [&](const Element &member, std::uint32_t &order) {
+    order = 5;
+    return member.id == way->id;
+  });
+  std::string data = stream.str();
+  auto result = ElementStream::read(data.data(), data.size(), 10, [&](std::uint32_t order) {
+    readOrder = order;
+    return std::unique_ptr<Element>(new Way(*way));
+  });
+
+  BOOST_CHECK_EQUAL(readOrder, 5);
+  auto resultRelation = dynamic_cast<Relation *>(result.get());
+  BOOST_REQUIRE(resultRelation != nullptr);
+  BOOST_REQUIRE_EQUAL(resultRelation->elements.size(), 2);
+  BOOST_CHECK_EQUAL(resultRelation->elements[1]->id, way->id);
+  BOOST_REQUIRE(dynamic_cast<Way *>(resultRelation->elements[1].get()) != nullptr);
+  BOOST_CHECK_THROW(ElementStream::read(data.data(), data.size(), 10), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWayWithManyCoordinates_WhenWrittenAndRead_ThenNoneAreLost) {
+  Way way;
+  for (int i = 0; i < 70000; ++i)
+    way.coordinates.push_back(GeoCoordinate(i * 1E-4, -i * 1E-4));
+
+  auto result = roundtrip(way, 1);
+
+  const auto &coordinates = dynamic_cast<Way *>(result.get())->coordinates;
+  BOOST_REQUIRE_EQUAL(coordinates.size(), way.coordinates.size());
+  checkCoordinate(coordinates.back(), way.coordinates.back());
+}
+
+BOOST_AUTO_TEST_CASE(GivenCoordinateOutOfFixedRange_WhenWrittenAndRead_ThenItIsExact) {
+  Node node;
+  node.coordinate = GeoCoordinate(1000.123456789123, 0.5);
+
+  auto result = roundtrip(node, 1);
+
+  BOOST_CHECK_EQUAL(dynamic_cast<Node *>(result.get())->coordinate.latitude, node.coordinate.latitude);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeInV1Format_WhenRead_ThenItIsRestored) {
+  std::stringstream stream;
+  writeRaw<std::uint8_t>(stream, 0);
+  writeRaw<std::uint16_t>(stream, 1);
+  writeRaw<std::uint32_t>(stream, 4);
+  writeRaw<std::uint32_t>(stream, 5);
+  writeRaw<double>(stream, 52.123456789);
+  writeRaw<double>(stream, 13.987654321);
+
+  auto result = ElementStream::read(stream, 3);
+
+  auto node = dynamic_cast<Node *>(result.get());
+  BOOST_REQUIRE(node != nullptr);
+  BOOST_CHECK_EQUAL(node->id, 3);
+  BOOST_CHECK_EQUAL(node->coordinate.latitude, 52.123456789);
+  BOOST_CHECK_EQUAL(node->coordinate.longitude, 13.987654321);
+  BOOST_REQUIRE_EQUAL(node->tags.size(), 1);
+  BOOST_CHECK_EQUAL(node->tags[0].key, 4);
+  BOOST_CHECK_EQUAL(node->tags[0].value, 5);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTruncatedData_WhenRead_ThenThrows) {
+  Way way;
+  way.coordinates = { GeoCoordinate(1, 2), GeoCoordinate(3, 4) };
+  std::stringstream stream;
+  ElementStream::write(stream, way);
+  std::string data = stream.str();
+
+  BOOST_CHECK_THROW(ElementStream::read(data.data(), data.size() - 1, 1), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,13 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "entities/Area.hpp"
+#include "entities/Relation.hpp"
 #include "index/GeoStore.hpp"
+#include "index/InMemoryElementStore.hpp"
 #include "index/PersistentElementStore.hpp"
 #include "mapcss/MapCssParser.hpp"
+#include "utils/ElementUtils.hpp"
+#include "utils/GeoUtils.hpp"
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/test/unit_test.hpp>
@@ -9,6 +16,7 @@
 
 #include "config.hpp"
 #include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
 
 using namespace utymap;
 using namespace utymap::index;
@@ -80,6 +88,111 @@ private:
   volatile bool isErased_;
 };
 
+/// Decorates in-memory store to cancel import once given amount of elements is saved.
+class CancellingElementStore : public ElementStore {
+public:
+  CancellingElementStore(const StringTable &stringTable, CancellationToken &token, int limit) :
+    ElementStore(stringTable), store_(stringTable), token_(token), counter_(0), limit_(limit) {}
+
+  void search(const std::string &notTerms, const std::string &andTerms, const std::string &orTerms,
+              const BoundingBox &bbox, const LodRange &range, entities::ElementVisitor &visitor,
+              const CancellationToken &cancelToken) override {
+    store_.search(notTerms, andTerms, orTerms, bbox, range, visitor, cancelToken);
+  }
+
+  void search(const QuadKey &quadKey, entities::ElementVisitor &visitor, const CancellationToken &cancelToken) override {
+    store_.search(quadKey, visitor, cancelToken);
+  }
+
+  bool hasData(const QuadKey &quadKey) const override {
+    return store_.hasData(quadKey);
+  }
+
+  void save(const entities::Element &element, const QuadKey &quadKey) override {
+    store_.save(element, quadKey);
+    if (++counter_ == limit_)
+      token_.cancel();
+  }
+
+  void erase(const QuadKey &quadKey) override {
+    store_.erase(quadKey);
+  }
+
+  void erase(const BoundingBox &bbox, const LodRange &range) override {
+    store_.erase(bbox, range);
+  }
+
+private:
+  InMemoryElementStore store_;
+  CancellationToken &token_;
+  int counter_;
+  int limit_;
+};
+
+/// Decorates in-memory store to fail on any per tile work, so it is usable only when
+/// it is skipped by coverage.
+class CoverageOnlyElementStore : public ElementStore {
+public:
+  explicit CoverageOnlyElementStore(const StringTable &stringTable) :
+    ElementStore(stringTable), store_(stringTable) {}
+
+  void search(const std::string&, const std::string&, const std::string&, const BoundingBox&,
+              const LodRange&, entities::ElementVisitor&, const CancellationToken&) override {
+    throw std::domain_error("Unexpected function call.");
+  }
+
+  void search(const QuadKey&, entities::ElementVisitor&, const CancellationToken&) override {
+    throw std::domain_error("Unexpected function call.");
+  }
+
+  bool hasData(const QuadKey&) const override {
+    throw std::domain_error("Unexpected function call.");
+  }
+
+  bool mayHaveData(const QuadKey &quadKey) const override {
+    return store_.mayHaveData(quadKey);
+  }
+
+  bool mayHaveData(const BoundingBox &bbox, const LodRange &range) const override {
+    return store_.mayHaveData(bbox, range);
+  }
+
+  void save(const entities::Element &element, const QuadKey &quadKey) override {
+    store_.save(element, quadKey);
+  }
+
+  void erase(const QuadKey &quadKey) override {
+    store_.erase(quadKey);
+  }
+
+  void erase(const BoundingBox &bbox, const LodRange &range) override {
+    store_.erase(bbox, range);
+  }
+
+private:
+  InMemoryElementStore store_;
+};
+
+/// Collects ids of visited elements.
+struct ElementIdCollector : public entities::ElementVisitor {
+  std::vector<std::uint64_t> ids;
+
+  void visitNode(const entities::Node &node) override { ids.push_back(node.id); }
+  void visitWay(const entities::Way &way) override { ids.push_back(way.id); }
+  void visitArea(const entities::Area &area) override { ids.push_back(area.id); }
+  void visitRelation(const entities::Relation &relation) override { ids.push_back(relation.id); }
+};
+
+/// Keeps copy of visited way.
+struct WayCollector : public entities::ElementVisitor {
+  std::vector<entities::Way> ways;
+
+  void visitNode(const entities::Node &) override {}
+  void visitWay(const entities::Way &way) override { ways.push_back(way); }
+  void visitArea(const entities::Area &) override {}
+  void visitRelation(const entities::Relation &) override {}
+};
+
 struct Index_GeoStoreFixture {
   Index_GeoStoreFixture() :
     dependencyProvider(),
@@ -92,6 +205,47 @@ struct Index_GeoStoreFixture {
     boost::filesystem::remove_all(DataDirectory);
   }
 
+  /// Registers in-memory stores with nodes which ids are stored in key order.
+  void addInMemoryStores(const QuadKey &quadKey) {
+    const auto &stringTable = *dependencyProvider.getStringTable();
+    const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+    std::uint64_t id = 0;
+    for (const std::string &key : { "a", "b", "c" }) {
+      auto store = utymap::utils::make_unique<InMemoryElementStore>(stringTable);
+      for (int i = 0; i < 3; ++i) {
+        auto node = utymap::tests::ElementUtils::createElement<entities::Node>(stringTable, id++, {{"shop", "yes"}});
+        node.coordinate = GeoCoordinate(52.53, 13.38);
+        store->save(node, quadKey);
+      }
+      store_.registerStore(key, std::move(store));
+    }
+  }
+
+  /// Imports two shop nodes and applies change which deletes first one,
+  /// modifies second one to amenity and creates new shop node.
+  std::vector<QuadKey> applyChanges(const std::string &storeKey, const LodRange &range) {
+    const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+    const std::string osmPath = DataDirectory + "/data.osm.xml";
+    const std::string oscPath = DataDirectory + "/data.osc";
+    std::ofstream(osmPath) << "<osm version=\"0.6\">"
+        "<node id=\"1\" lat=\"52.53\" lon=\"13.38\"><tag k=\"shop\" v=\"yes\"/></node>"
+        "<node id=\"2\" lat=\"52.531\" lon=\"13.381\"><tag k=\"shop\" v=\"yes\"/></node>"
+        "</osm>";
+    std::ofstream(oscPath) << "<osmChange version=\"0.6\">"
+        "<delete><node id=\"1\" lat=\"52.53\" lon=\"13.38\"/></delete>"
+        "<modify><node id=\"2\" lat=\"52.531\" lon=\"13.381\"><tag k=\"amenity\" v=\"cafe\"/></node></modify>"
+        "<create><node id=\"3\" lat=\"52.532\" lon=\"13.382\"><tag k=\"shop\" v=\"yes\"/></node></create>"
+        "</osmChange>";
+
+    store_.add(storeKey, osmPath, range, styleProvider, dependencyProvider.getCancellationToken());
+    return store_.applyChanges(storeKey, oscPath, range, styleProvider, dependencyProvider.getCancellationToken());
+  }
+
+  std::size_t count(const std::string &andTerms, const LodRange &range) {
+    BoundingBox bbox(GeoCoordinate(52, 13), GeoCoordinate(53, 14));
+    return store_.count("", andTerms, "", bbox, range, 0, CancellationToken());
+  }
+
   DependencyProvider dependencyProvider;
   GeoStore store_;
   StyleSheet stylesheet;
@@ -122,4 +276,254 @@ BOOST_AUTO_TEST_CASE(GivenImportQuadKeyToPersistentStore_WhenAddOperationIsCance
   BOOST_ASSERT(!boost::filesystem::exists(TestZoomDirectory + "/1202102332220103.idf"));
 }
 
+BOOST_AUTO_TEST_CASE(GivenParallelSearch_WhenSearchQuadKey_ThenElementsAreVisitedInStoreOrder) {
+  QuadKey quadKey(16, 35205, 21489);
+  addInMemoryStores(quadKey);
+  store_.setSearchThreads(2);
+  ElementIdCollector collector;
+
+  store_.search(quadKey, *dependencyProvider.getStyleProvider(stylesheet), collector, CancellationToken());
+
+  std::vector<std::uint64_t> expected = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyStores_WhenSearchTextPage_ThenOnlyPageIsVisited) {
+  QuadKey quadKey(16, 35205, 21489);
+  addInMemoryStores(quadKey);
+  BoundingBox bbox(GeoCoordinate(52.52, 13.37), GeoCoordinate(52.54, 13.39));
+  ElementIdCollector collector;
+
+  store_.search("", "shop", "", bbox, LodRange(16, 16), 2, 3, collector, CancellationToken());
+
+  std::vector<std::uint64_t> expected = { 2, 3, 4 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenParallelSearch_WhenSearchTextPage_ThenPageIsSameAsInSequentialMode) {
+  QuadKey quadKey(16, 35205, 21489);
+  addInMemoryStores(quadKey);
+  store_.setSearchThreads(2);
+  BoundingBox bbox(GeoCoordinate(52.52, 13.37), GeoCoordinate(52.54, 13.39));
+  ElementIdCollector collector;
+
+  store_.search("", "shop", "", bbox, LodRange(16, 16), 4, 4, collector, CancellationToken());
+
+  std::vector<std::uint64_t> expected = { 4, 5, 6, 7 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(collector.ids.begin(), collector.ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyStores_WhenCountText_ThenMatchesOfAllStoresAreCounted) {
+  QuadKey quadKey(16, 35205, 21489);
+  addInMemoryStores(quadKey);
+  BoundingBox bbox(GeoCoordinate(52.52, 13.37), GeoCoordinate(52.54, 13.39));
+  LodRange range(16, 16);
+
+  BOOST_CHECK_EQUAL(store_.count("", "shop", "", bbox, range, 0, CancellationToken()), 9);
+  BOOST_CHECK_EQUAL(store_.count("", "shop", "", bbox, range, 4, CancellationToken()), 4);
+  BOOST_CHECK_EQUAL(store_.count("", "shop", "", bbox, range, 1, CancellationToken()), 1);
+  BOOST_CHECK_EQUAL(store_.count("", "unknown", "", bbox, range, 1, CancellationToken()), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoreWithDataElsewhere_WhenSearch_ThenItIsSkippedByCoverage) {
+  QuadKey quadKey(16, 35205, 21489);
+  addInMemoryStores(quadKey);
+  const auto &stringTable = *dependencyProvider.getStringTable();
+  auto overlay = utymap::utils::make_unique<CoverageOnlyElementStore>(stringTable);
+  auto node = utymap::tests::ElementUtils::createElement<entities::Node>(stringTable, 100, {{"shop", "yes"}});
+  node.coordinate = GeoCoordinate(55.75, 37.62);
+  overlay->save(node, utymap::utils::GeoUtils::GeoCoordinateToQuadKey(node.coordinate, 16));
+  store_.registerStore("overlay", std::move(overlay));
+  store_.setSearchThreads(2);
+  BoundingBox bbox(GeoCoordinate(52.52, 13.37), GeoCoordinate(52.54, 13.39));
+  ElementIdCollector quadKeyCollector, textCollector;
+
+  store_.search(quadKey, *dependencyProvider.getStyleProvider(stylesheet), quadKeyCollector, CancellationToken());
+  store_.search("", "shop", "", bbox, LodRange(16, 16), 0, 0, textCollector, CancellationToken());
+
+  BOOST_CHECK_EQUAL(quadKeyCollector.ids.size(), 9);
+  BOOST_CHECK_EQUAL(textCollector.ids.size(), 9);
+  BOOST_CHECK(store_.hasData(quadKey));
+  BOOST_CHECK_EQUAL(store_.count("", "shop", "", bbox, LodRange(16, 16), 0, CancellationToken()), 9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeLocationDirectory_WhenImportXmlTwice_ThenSameDataIsStored) {
+  QuadKey quadKey(16, 35205, 21489);
+  const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+  auto firstStore = new InMemoryElementStore(*dependencyProvider.getStringTable());
+  auto secondStore = new InMemoryElementStore(*dependencyProvider.getStringTable());
+  store_.registerStore("a", std::unique_ptr<ElementStore>(firstStore));
+  store_.registerStore("b", std::unique_ptr<ElementStore>(secondStore));
+  store_.setNodeLocationDirectory(DataDirectory);
+  ElementIdCollector first, second;
+
+  store_.add("a", TEST_XML_FILE, quadKey, styleProvider, dependencyProvider.getCancellationToken());
+  store_.add("b", TEST_XML_FILE, quadKey, styleProvider, dependencyProvider.getCancellationToken());
+
+  firstStore->search(quadKey, first, dependencyProvider.getCancellationToken());
+  secondStore->search(quadKey, second, dependencyProvider.getCancellationToken());
+  BOOST_CHECK(boost::filesystem::exists(DataDirectory + "/" + boost::filesystem::path(TEST_XML_FILE).filename().string() + ".nodes"));
+  BOOST_CHECK(!first.ids.empty());
+  BOOST_CHECK_EQUAL_COLLECTIONS(first.ids.begin(), first.ids.end(), second.ids.begin(), second.ids.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenInMemoryStore_WhenApplyChanges_ThenElementsAreReplaced) {
+  LodRange range(16, 16);
+  store_.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+
+  auto quadKeys = applyChanges("a", range);
+
+  BOOST_CHECK_EQUAL(count("shop", range), 1);
+  BOOST_CHECK_EQUAL(count("amenity", range), 1);
+  BOOST_REQUIRE(!quadKeys.empty());
+  BOOST_CHECK(quadKeys.front() == utymap::utils::GeoUtils::GeoCoordinateToQuadKey(GeoCoordinate(52.53, 13.38), 16));
+}
+
+BOOST_AUTO_TEST_CASE(GivenPersistentStore_WhenApplyChanges_ThenElementsAreReplaced) {
+  LodRange range(16, 16);
+  store_.registerStore("a", utymap::utils::make_unique<PersistentElementStore>(DataDirectory, *dependencyProvider.getStringTable()));
+
+  auto quadKeys = applyChanges("a", range);
+
+  BOOST_CHECK_EQUAL(count("shop", range), 1);
+  BOOST_CHECK_EQUAL(count("amenity", range), 1);
+  BOOST_CHECK(!quadKeys.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenChangeOfWayWithoutItsNodes_WhenApplyChanges_ThenCoordinatesAreKept) {
+  LodRange range(16, 16);
+  const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+  store_.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+  const std::string osmPath = DataDirectory + "/data.osm.xml";
+  const std::string oscPath = DataDirectory + "/data.osc";
+  std::ofstream(osmPath) << "<osm version=\"0.6\">"
+      "<node id=\"1\" lat=\"52.53\" lon=\"13.38\"><tag k=\"shop\" v=\"yes\"/></node>"
+      "<node id=\"2\" lat=\"52.531\" lon=\"13.381\"><tag k=\"shop\" v=\"yes\"/></node>"
+      "<node id=\"3\" lat=\"52.532\" lon=\"13.382\"/>"
+      "<node id=\"4\" lat=\"52.533\" lon=\"13.383\"/>"
+      "<way id=\"10\"><nd ref=\"1\"/><nd ref=\"2\"/><tag k=\"highway\" v=\"residential\"/></way>"
+      "<way id=\"11\"><nd ref=\"3\"/><nd ref=\"4\"/><tag k=\"highway\" v=\"residential\"/></way>"
+      "</osm>";
+  std::ofstream(oscPath) << "<osmChange version=\"0.6\"><modify>"
+      "<way id=\"10\"><nd ref=\"1\"/><nd ref=\"2\"/><tag k=\"highway\" v=\"primary\"/></way>"
+      "<way id=\"11\"><nd ref=\"3\"/><nd ref=\"4\"/><tag k=\"highway\" v=\"primary\"/></way>"
+      "</modify></osmChange>";
+  store_.add("a", osmPath, range, styleProvider, dependencyProvider.getCancellationToken());
+
+  store_.applyChanges("a", oscPath, range, styleProvider, dependencyProvider.getCancellationToken());
+
+  WayCollector resolved, kept;
+  BOOST_REQUIRE(store_.searchById(10, resolved));
+  BOOST_REQUIRE(store_.searchById(11, kept));
+  const auto &stringTable = *dependencyProvider.getStringTable();
+  auto highwayKey = stringTable.getId("highway");
+  BOOST_CHECK_EQUAL(resolved.ways.front().coordinates.size(), 2);
+  BOOST_CHECK_EQUAL(kept.ways.front().coordinates.size(), 2);
+  BOOST_CHECK_EQUAL(*utymap::utils::getTagValue(highwayKey, resolved.ways.front().tags, stringTable), "primary");
+  BOOST_CHECK_EQUAL(*utymap::utils::getTagValue(highwayKey, kept.ways.front().tags, stringTable), "residential");
+}
+
+BOOST_AUTO_TEST_CASE(GivenElement_WhenAdd_ThenItsStringsAreWritten) {
+  LodRange range(16, 16);
+  const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+  store_.registerStore("a", utymap::utils::make_unique<PersistentElementStore>(DataDirectory, *dependencyProvider.getStringTable()));
+  auto node = ElementUtils::createElement<entities::Node>(*dependencyProvider.getStringTable(), 1, {{"shop", "yes"}});
+  node.coordinate = GeoCoordinate(52.53, 13.38);
+
+  store_.add("a", node, range, styleProvider, dependencyProvider.getCancellationToken());
+
+  BOOST_CHECK_GT(boost::filesystem::file_size("string.idx"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyFiles_WhenAddInBatch_ThenDataOfAllFilesIsStored) {
+  LodRange range(16, 16);
+  const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+  store_.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+  store_.setImportFileThreads(2);
+  std::vector<GeoStore::ImportFile> files;
+  for (int i = 0; i < 4; ++i) {
+    auto path = DataDirectory + "/data" + std::to_string(i) + ".osm.xml";
+    std::ofstream(path) << "<osm version=\"0.6\">"
+        "<node id=\"" << i + 1 << "\" lat=\"52.53\" lon=\"13.38\"><tag k=\"shop\" v=\"yes\"/></node>"
+        "</osm>";
+    files.push_back({ path, styleProvider });
+  }
+
+  store_.add("a", files, range, dependencyProvider.getCancellationToken());
+
+  BOOST_CHECK_EQUAL(count("shop", range), 4);
+}
+
+BOOST_AUTO_TEST_CASE(GivenProgressCallback_WhenImportXml_ThenFinalStatisticsAreReported) {
+  QuadKey quadKey(16, 35205, 21489);
+  const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+  store_.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+  std::vector<ImportStatistics::Snapshot> snapshots;
+  store_.setImportProgress([&](const ImportStatistics::Snapshot &snapshot) { snapshots.push_back(snapshot); });
+
+  store_.add("a", TEST_XML_FILE, quadKey, styleProvider, dependencyProvider.getCancellationToken());
+
+  BOOST_REQUIRE(!snapshots.empty());
+  const auto &last = snapshots.back();
+  BOOST_CHECK_EQUAL(last.bytesParsed, boost::filesystem::file_size(TEST_XML_FILE));
+  BOOST_CHECK_EQUAL(last.bytesTotal, last.bytesParsed);
+  BOOST_CHECK(last.elementsParsed > 0);
+  BOOST_CHECK(last.elementsStored > 0 && last.elementsStored <= last.elementsParsed);
+  BOOST_CHECK_EQUAL(last.tilesWritten, 1);
+  BOOST_CHECK(last.parseTime > 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCheckpointDirectory_WhenImportIsCancelledAndStartedAgain_ThenItIsResumed) {
+  LodRange range(16, 16);
+  const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+  const std::string path = DataDirectory + "/data.osm.xml";
+  {
+    std::ofstream file(path);
+    file << "<osm version=\"0.6\">";
+    for (int i = 1; i <= 10; ++i)
+      file << "<node id=\"" << i << "\" lat=\"52.53\" lon=\"13.38\"><tag k=\"shop\" v=\"yes\"/></node>";
+    file << "</osm>";
+  }
+  auto hasCheckpoint = [&]() {
+    for (boost::filesystem::directory_iterator end, it(DataDirectory); it != end; ++it) {
+      if (it->path().extension() == ".checkpoint")
+        return true;
+    }
+    return false;
+  };
+  CancellationToken cancelToken;
+  store_.registerStore("a", utymap::utils::make_unique<CancellingElementStore>(
+      *dependencyProvider.getStringTable(), cancelToken, 4));
+  store_.setCheckpointDirectory(DataDirectory);
+
+  store_.add("a", path, range, styleProvider, cancelToken);
+
+  BOOST_CHECK_EQUAL(count("shop", range), 4);
+  BOOST_CHECK(hasCheckpoint());
+
+  store_.add("a", path, range, styleProvider, CancellationToken());
+
+  BOOST_CHECK_EQUAL(count("shop", range), 10);
+  BOOST_CHECK(!hasCheckpoint());
+}
+
+BOOST_AUTO_TEST_CASE(GivenVectorTileOfQuadKey_WhenImportQuadKey_ThenFeaturesAreStored) {
+  QuadKey quadKey(16, 35205, 21489);
+  const auto &styleProvider = *dependencyProvider.getStyleProvider(stylesheet);
+  store_.registerStore("a", utymap::utils::make_unique<InMemoryElementStore>(*dependencyProvider.getStringTable()));
+  const std::string path = TestZoomDirectory + "/35205/21489.mvt";
+  boost::filesystem::create_directories(TestZoomDirectory + "/35205");
+  // NOTE layer "poi" with one point feature shop=yes in the center of tile.
+  const unsigned char tile[] = {
+      0x1A, 0x26, 0x78, 0x02, 0x0A, 0x03, 'p', 'o', 'i',
+      0x12, 0x0D, 0x12, 0x02, 0x00, 0x00, 0x18, 0x01, 0x22, 0x05, 0x09, 0x80, 0x20, 0x80, 0x20,
+      0x1A, 0x04, 's', 'h', 'o', 'p', 0x22, 0x05, 0x0A, 0x03, 'y', 'e', 's', 0x28, 0x80, 0x20
+  };
+  std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(tile), sizeof(tile));
+
+  store_.add("a", path, quadKey, styleProvider, dependencyProvider.getCancellationToken());
+
+  BOOST_CHECK_EQUAL(count("shop", LodRange(16, 16)), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
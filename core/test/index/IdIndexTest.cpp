@@ -0,0 +1,65 @@
+#include "index/IdIndex.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::index;
+
+namespace {
+const std::string IndexPath = "test.ids";
+
+struct Index_IdIndexFixture {
+  ~Index_IdIndexFixture() {
+    boost::filesystem::remove(IndexPath);
+  }
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_IdIndex, Index_IdIndexFixture)
+
+BOOST_AUTO_TEST_CASE(GivenLocations_WhenFind_ThenFirstQuadKeyIsKept) {
+  IdIndex index(IndexPath);
+  IdIndex::Location location;
+
+  index.add(7, QuadKey(1, 0, 0), 3);
+  index.add(7, QuadKey(2, 1, 1), 5);
+
+  BOOST_REQUIRE(index.find(7, location));
+  BOOST_CHECK(location.quadKey == QuadKey(1, 0, 0));
+  BOOST_CHECK_EQUAL(location.order, 3);
+  BOOST_CHECK(!index.find(8, location));
+}
+
+BOOST_AUTO_TEST_CASE(GivenErasedQuadKey_WhenFind_ThenLocationIsStaleUntilAddedAgain) {
+  IdIndex index(IndexPath);
+  IdIndex::Location location;
+  index.add(7, QuadKey(1, 0, 0), 3);
+
+  index.reset(QuadKey(1, 0, 0));
+  BOOST_CHECK(!index.find(7, location));
+
+  index.add(7, QuadKey(2, 1, 1), 5);
+  BOOST_REQUIRE(index.find(7, location));
+  BOOST_CHECK(location.quadKey == QuadKey(2, 1, 1));
+  BOOST_CHECK_EQUAL(location.order, 5);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFlushedIndex_WhenLoaded_ThenLocationsAndResetsAreRestored) {
+  {
+    IdIndex index(IndexPath);
+    index.add(7, QuadKey(1, 0, 0), 3);
+    index.add(8, QuadKey(2, 1, 1), 4);
+    index.reset(QuadKey(2, 1, 1));
+    index.flush();
+  }
+  IdIndex index(IndexPath);
+  IdIndex::Location location;
+
+  BOOST_REQUIRE(index.find(7, location));
+  BOOST_CHECK(location.quadKey == QuadKey(1, 0, 0));
+  BOOST_CHECK_EQUAL(location.order, 3);
+  BOOST_CHECK(!index.find(8, location));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,8 +5,11 @@
 #include "entities/Area.hpp"
 #include "index/InMemoryElementStore.hpp"
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <cstdio>
+
 #include "test_utils/DependencyProvider.hpp"
 #include "test_utils/ElementUtils.hpp"
 
@@ -20,9 +23,10 @@ namespace {
 const std::string stylesheet = "area|z1[any],way|z1[any],node|z1[any] { clip: true; }";
 
 struct Index_InMemoryElementStoreFixture {
-  Index_InMemoryElementStoreFixture() :
+  explicit Index_InMemoryElementStoreFixture(
+      InMemoryElementStore::StorageMode mode = InMemoryElementStore::StorageMode::Copy) :
       dependencyProvider(),
-      elementStore(*dependencyProvider.getStringTable()),
+      elementStore(*dependencyProvider.getStringTable(), mode),
       styleProvider(*dependencyProvider.getStyleProvider(stylesheet)) {}
 
   void addTestData() {
@@ -57,6 +61,23 @@ struct Index_InMemoryElementStoreFixture {
   StyleProvider &styleProvider;
 };
 
+struct Index_ArenaElementStoreFixture : public Index_InMemoryElementStoreFixture {
+  Index_ArenaElementStoreFixture() :
+      Index_InMemoryElementStoreFixture(InMemoryElementStore::StorageMode::Arena) {}
+};
+
+/// Keeps copies of visited elements.
+struct ElementCollector : public ElementVisitor {
+  std::vector<Node> nodes;
+  std::vector<Way> ways;
+  std::vector<Area> areas;
+
+  void visitNode(const Node &node) override { nodes.push_back(node); }
+  void visitWay(const Way &way) override { ways.push_back(way); }
+  void visitArea(const Area &area) override { areas.push_back(area); }
+  void visitRelation(const Relation &) override {}
+};
+
 struct ElementCounter : public ElementVisitor {
   int times = 0;
 
@@ -100,6 +121,32 @@ BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenSearchText_ThenOneFound) {
   BOOST_CHECK_EQUAL(counter.times, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenSearchKeys_WhenSearchTextByOtherKey_ThenNothingFound) {
+  BoundingBox boundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  LodRange lodRange(1, 1);
+  ElementCounter areaCounter, anyCounter;
+  elementStore.setSearchKeys("any");
+  addTestData();
+
+  elementStore.search({}, {"area"}, {}, boundingBox, lodRange, areaCounter, CancellationToken());
+  elementStore.search({}, {"any"}, {}, boundingBox, lodRange, anyCounter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(areaCounter.times, 0);
+  BOOST_CHECK_EQUAL(anyCounter.times, 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeWayAreaInTwoLods_WhenSearchTextInBothLods_ThenEveryElementFoundOnce) {
+  BoundingBox boundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  ElementCollector collector;
+  addTestData();
+
+  elementStore.search({}, {"any"}, {}, boundingBox, LodRange(1, 2), collector, CancellationToken());
+
+  BOOST_CHECK_EQUAL(collector.nodes.size(), 1);
+  BOOST_CHECK_EQUAL(collector.ways.size(), 1);
+  BOOST_CHECK_EQUAL(collector.areas.size(), 1);
+}
+
 BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenSearchOutside_ThenNoResults) {
   BoundingBox boundingBox(GeoCoordinate(20, -180), GeoCoordinate(90, 180));
   LodRange lodRange(1, 1);
@@ -126,4 +173,173 @@ BOOST_AUTO_TEST_CASE(GivenElementWithNonAnsiSymbols_WhenSearchText_ThenItIsFound
   BOOST_CHECK_EQUAL(counter.times, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenStoredElements_WhenGetFootprint_ThenItIsNotZero) {
+  BOOST_CHECK_EQUAL(elementStore.getFootprint(), 0);
+
+  addTestData();
+
+  BOOST_CHECK(elementStore.getFootprint() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredElements_WhenGetSummary_ThenElementsAndVerticesAreCounted) {
+  addTestData();
+
+  auto summary = elementStore.getSummary(QuadKey(1, 0, 0));
+
+  BOOST_CHECK_EQUAL(summary.nodes, 1);
+  BOOST_CHECK_EQUAL(summary.ways, 1);
+  BOOST_CHECK_EQUAL(summary.areas, 1);
+  BOOST_CHECK_EQUAL(summary.relations, 0);
+  BOOST_CHECK(summary.vertices >= 4);
+  BOOST_CHECK(summary.bytes > 0);
+  BOOST_CHECK(elementStore.getSummary(QuadKey(1, 1, 1)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodeWayArea_WhenPullQuadKeyCursor_ThenAllAreReturned) {
+  addTestData();
+  std::vector<std::unique_ptr<Element>> batch;
+
+  auto cursor = elementStore.openCursor(QuadKey(1, 0, 0));
+
+  BOOST_CHECK_EQUAL(cursor->next(batch, 10), 3);
+  BOOST_CHECK(cursor->next() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBudgetExceeded_WhenStore_ThenLeastRecentlyUsedQuadKeyIsEvicted) {
+  InMemoryElementStore store(*dependencyProvider.getStringTable(), InMemoryElementStore::StorageMode::Copy, 1);
+  LodRange range(1, 1);
+  auto way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+                                              {{"any", "true"}}, {{5, -5}, {5, -10}});
+  auto other = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+                                                {{"any", "true"}}, {{-5, 5}, {-5, 10}});
+
+  store.store(way, range, styleProvider);
+  store.store(other, range, styleProvider);
+
+  BOOST_CHECK(!store.hasData(QuadKey(1, 0, 0)));
+  BOOST_CHECK(store.hasData(QuadKey(1, 1, 1)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenBudgetExceededWithSpill_WhenSearch_ThenSpilledElementsAreFound) {
+  InMemoryElementStore store(*dependencyProvider.getStringTable(), InMemoryElementStore::StorageMode::Copy, 1, true);
+  LodRange range(1, 1);
+  auto way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 0,
+                                              {{"any", "true"}}, {{5, -5}, {5, -10}});
+  auto other = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 1,
+                                                {{"any", "true"}}, {{-5, 5}, {-5, 10}});
+  store.store(way, range, styleProvider);
+  std::size_t footprint = store.getFootprint();
+  store.store(other, range, styleProvider);
+  ElementCounter quadKeyCounter, textCounter;
+
+  store.search(QuadKey(1, 0, 0), quadKeyCounter, CancellationToken());
+  store.search({}, {"any"}, {}, BoundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180)),
+               range, textCounter, CancellationToken());
+
+  BOOST_CHECK(store.hasData(QuadKey(1, 0, 0)));
+  BOOST_CHECK_EQUAL(store.getFootprint(), footprint);
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 1);
+  BOOST_CHECK_EQUAL(textCounter.times, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredElements_WhenSearchById_ThenOnlyThatElementIsFound) {
+  ElementCounter counter;
+  elementStore.store(ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7,
+                                                      {{"any", "true"}}, {{5, -5}, {5, -10}}),
+                     LodRange(1, 2), styleProvider);
+
+  BOOST_CHECK(elementStore.searchById(7, counter));
+  BOOST_CHECK_EQUAL(counter.times, 1);
+  BOOST_CHECK(!elementStore.searchById(8, counter));
+}
+
+BOOST_AUTO_TEST_CASE(GivenErasedQuadKey_WhenSearchById_ThenNotFound) {
+  ElementCounter counter;
+  elementStore.store(ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 7,
+                                                      {{"any", "true"}}, {{5, -5}, {5, -10}}),
+                     LodRange(1, 1), styleProvider);
+
+  elementStore.erase(QuadKey(1, 0, 0));
+
+  BOOST_CHECK(!elementStore.searchById(7, counter));
+}
+
+BOOST_AUTO_TEST_CASE(GivenSnapshot_WhenLoadIntoOtherStore_ThenElementsAndBitmapsAreRestored) {
+  auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  addTestData();
+  elementStore.saveSnapshot(path);
+  InMemoryElementStore restored(*dependencyProvider.getStringTable(), InMemoryElementStore::StorageMode::Arena);
+
+  restored.loadSnapshot(path);
+  std::remove(path.c_str());
+
+  ElementCounter quadKeyCounter, textCounter;
+  restored.search(QuadKey(1, 0, 0), quadKeyCounter, CancellationToken());
+  restored.search({}, {"area"}, {}, BoundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180)),
+                  LodRange(1, 1), textCounter, CancellationToken());
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 3);
+  BOOST_CHECK_EQUAL(textCounter.times, 1);
+  BOOST_CHECK_EQUAL(restored.getSummary(QuadKey(1, 0, 0)).elements(), 3);
+  BOOST_CHECK(restored.mayHaveData(QuadKey(1, 0, 0)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenSnapshot_WhenLoadIntoStoreWithSameQuadKey_ThenElementsAreIndexedAgain) {
+  auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+  addTestData();
+  elementStore.saveSnapshot(path);
+
+  elementStore.loadSnapshot(path);
+  std::remove(path.c_str());
+
+  ElementCounter quadKeyCounter;
+  elementStore.search(QuadKey(1, 0, 0), quadKeyCounter, CancellationToken());
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 6);
+  BOOST_CHECK_EQUAL(elementStore.count({}, {"any"}, {}, BoundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180)),
+                                       LodRange(1, 1), 0, CancellationToken()), 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(Index_InMemoryElementStoreArena, Index_ArenaElementStoreFixture)
+
+BOOST_AUTO_TEST_CASE(GivenArenaMode_WhenSearch_ThenAllFound) {
+  ElementCounter counter;
+  addTestData();
+
+  elementStore.search(QuadKey(1, 0, 0), counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(counter.times, 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenArenaMode_WhenSearchText_ThenOneFound) {
+  BoundingBox boundingBox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  ElementCounter counter;
+  addTestData();
+
+  elementStore.search({}, {"area"}, {}, boundingBox, LodRange(1, 1), counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(counter.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenArenaMode_WhenSearch_ThenElementDataIsPreserved) {
+  const auto &stringTable = *dependencyProvider.getStringTable();
+  ElementCollector collector;
+  addTestData();
+
+  elementStore.search(QuadKey(1, 0, 0), collector, CancellationToken());
+
+  BOOST_REQUIRE_EQUAL(collector.ways.size(), 1);
+  BOOST_REQUIRE_EQUAL(collector.areas.size(), 1);
+  BOOST_REQUIRE_EQUAL(collector.nodes.size(), 1);
+  BOOST_REQUIRE_EQUAL(collector.ways[0].tags.size(), 1);
+  BOOST_CHECK_EQUAL(collector.ways[0].tags[0].key, stringTable.getId("any"));
+  BOOST_REQUIRE_EQUAL(collector.ways[0].coordinates.size(), 2);
+  BOOST_CHECK_EQUAL(collector.ways[0].coordinates[1].longitude, -10);
+  BOOST_CHECK_EQUAL(collector.areas[0].tags.size(), 2);
+  BOOST_CHECK_EQUAL(collector.areas[0].coordinates.size(), 3);
+  BOOST_CHECK_EQUAL(collector.nodes[0].tags.size(), 1);
+  BOOST_CHECK_EQUAL(collector.nodes[0].coordinate.latitude, 5);
+  BOOST_CHECK_EQUAL(collector.nodes[0].coordinate.longitude, -5);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,124 @@
+#include "index/MeshStream.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+using namespace utymap;
+using namespace utymap::index;
+using namespace utymap::math;
+
+namespace {
+  const BoundingBox TileBox(GeoCoordinate(52.51, 13.38), GeoCoordinate(52.52, 13.39));
+
+  Mesh createMesh() {
+    Mesh mesh("building:42");
+    for (int i = 0; i < 100; ++i) {
+      mesh.vertices.push_back(13.38 + i * 0.0001);
+      mesh.vertices.push_back(52.51 + (i % 10) * 0.001);
+      mesh.vertices.push_back(30 + i % 7);
+      mesh.colors.push_back(i % 3 == 0 ? 0xFF0000 : 0x00FF00);
+      mesh.uvs.push_back((i % 10) * 0.1);
+      mesh.uvs.push_back((i / 10) * 0.1);
+    }
+    for (int i = 0; i + 2 < 100; ++i) {
+      mesh.triangles.push_back(i);
+      mesh.triangles.push_back(i + 2);
+      mesh.triangles.push_back(i + 1);
+    }
+    mesh.uvMap = { 0, 1, 256, 128, 0, 0, 1, 1 };
+    return mesh;
+  }
+
+  /// Checks components with tolerance which is repeated with given stride.
+  void checkClose(const std::vector<double> &actual, const std::vector<double> &expected,
+                  const std::vector<double> &tolerances) {
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (std::size_t i = 0; i < actual.size(); ++i)
+      BOOST_CHECK_SMALL(actual[i] - expected[i], tolerances[i % tolerances.size()]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(Index_MeshStream)
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenWriteCompact_ThenCanBeReadBack) {
+  auto mesh = createMesh();
+  std::stringstream stream;
+
+  MeshStream::writeCompact(stream, mesh, TileBox);
+  auto result = MeshStream::readCompact(stream);
+
+  BOOST_CHECK_EQUAL(result.name, mesh.name);
+  checkClose(result.vertices, mesh.vertices, { 1E-6, 1E-6, 1E-4 });
+  checkClose(result.uvs, mesh.uvs, { 1E-4 });
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.triangles.begin(), result.triangles.end(),
+                                mesh.triangles.begin(), mesh.triangles.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.colors.begin(), result.colors.end(),
+                                mesh.colors.begin(), mesh.colors.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(result.uvMap.begin(), result.uvMap.end(),
+                                mesh.uvMap.begin(), mesh.uvMap.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenMeshOutsideBoundingBox_WhenWriteCompact_ThenVerticesAreKept) {
+  auto mesh = createMesh();
+  mesh.vertices[0] = 13.37;
+  std::stringstream stream;
+
+  MeshStream::writeCompact(stream, mesh, TileBox);
+  auto result = MeshStream::readCompact(stream);
+
+  checkClose(result.vertices, mesh.vertices, { 1E-6, 1E-6, 1E-4 });
+}
+
+BOOST_AUTO_TEST_CASE(GivenMesh_WhenWriteCompact_ThenItIsSmallerThanRegularForm) {
+  auto mesh = createMesh();
+  std::stringstream regular, compact;
+
+  MeshStream::write(regular, mesh);
+  MeshStream::writeCompact(compact, mesh, TileBox);
+
+  BOOST_CHECK_LT(compact.str().size() * 2, regular.str().size());
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptyMesh_WhenWriteCompact_ThenCanBeReadBack) {
+  Mesh mesh("empty");
+  std::stringstream stream;
+
+  MeshStream::writeCompact(stream, mesh, TileBox);
+  auto result = MeshStream::readCompact(stream);
+
+  BOOST_CHECK_EQUAL(result.name, "empty");
+  BOOST_CHECK(result.vertices.empty());
+  BOOST_CHECK(result.triangles.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenTruncatedStream_WhenReadCompact_ThenThrows) {
+  auto mesh = createMesh();
+  std::stringstream stream;
+  MeshStream::writeCompact(stream, mesh, TileBox);
+  auto data = stream.str();
+  std::stringstream truncated(data.substr(0, data.size() / 2));
+
+  BOOST_CHECK_THROW(MeshStream::readCompact(truncated), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSizeBeyondStreamEnd_WhenReadCompact_ThenThrows) {
+  std::stringstream stream;
+  stream.put(1);
+  std::uint32_t size = 0xFFFFFFFF;
+  stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  stream << "name";
+
+  BOOST_CHECK_THROW(MeshStream::readCompact(stream), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTriangleWithIndexOutOfVertices_WhenReadCompact_ThenThrows) {
+  auto mesh = createMesh();
+  mesh.triangles.back() = 100;
+  std::stringstream stream;
+  MeshStream::writeCompact(stream, mesh, TileBox);
+
+  BOOST_CHECK_THROW(MeshStream::readCompact(stream), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
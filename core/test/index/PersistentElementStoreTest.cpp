@@ -2,7 +2,9 @@
 #include "entities/Way.hpp"
 #include "entities/Area.hpp"
 #include "entities/Relation.hpp"
+#include "index/ElementStream.hpp"
 #include "index/PersistentElementStore.hpp"
+#include "utils/GeoUtils.hpp"
 
 #include <boost/test/unit_test.hpp>
 #include "test_utils/DependencyProvider.hpp"
@@ -10,6 +12,12 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
 using namespace utymap;
 using namespace utymap::entities;
 using namespace utymap::index;
@@ -19,6 +27,10 @@ using namespace utymap::tests;
 namespace {
 const std::string DataDirectory = "data";
 const std::string TestZoomDirectory = DataDirectory + "/1";
+const std::string TestPackPath = DataDirectory + "/1.pack";
+const std::string TestIdIndexPath = DataDirectory + "/elements.ids";
+const std::string TestSharedPayloadPath = DataDirectory + "/elements.dat";
+const std::string TestTileSummaryPath = DataDirectory + "/tiles.sum";
 const std::string stylesheet = "node|z1[any], way|z1[any], area|z1[any], relation|z1[any] { clip: false; }";
 
 struct Index_PersistentElementStoreFixture {
@@ -35,6 +47,10 @@ struct Index_PersistentElementStoreFixture {
       boost::filesystem::remove_all(it->path());
     }
     boost::filesystem::remove(TestZoomDirectory);
+    boost::filesystem::remove(TestPackPath);
+    boost::filesystem::remove(TestIdIndexPath);
+    boost::filesystem::remove(TestSharedPayloadPath);
+    boost::filesystem::remove(TestTileSummaryPath);
   }
 
   DependencyProvider dependencyProvider;
@@ -64,6 +80,17 @@ struct ElementCounter : public ElementVisitor {
   }
 };
 
+struct ElementIdCollector : public ElementVisitor {
+  explicit ElementIdCollector(std::vector<std::uint64_t> &ids) : ids(ids) {}
+
+  void visitNode(const Node &node) override { ids.push_back(node.id); }
+  void visitWay(const Way &way) override { ids.push_back(way.id); }
+  void visitArea(const Area &area) override { ids.push_back(area.id); }
+  void visitRelation(const Relation &relation) override { ids.push_back(relation.id); }
+
+  std::vector<std::uint64_t> &ids;
+};
+
 void assertGeometry(const GeoCoordinate &expected, const GeoCoordinate &actual) {
   BOOST_CHECK_EQUAL(expected.latitude, actual.latitude);
   BOOST_CHECK_EQUAL(expected.longitude, actual.longitude);
@@ -167,6 +194,59 @@ BOOST_AUTO_TEST_CASE(GivenRelationWithDifferentElements_WhenStoreAndSearch_ThenI
   assertElement(relation, result);
 }
 
+BOOST_AUTO_TEST_CASE(GivenRelationWithStoredMember_WhenStoreAndSearch_ThenMemberIsReferencedAndReadBack) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  for (int i = 0; i < 100; ++i)
+    area.coordinates.push_back(GeoCoordinate(1 + i * 0.125, -1 - (i % 7) * 0.25));
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"n", "2"}});
+  node.coordinate = {0.5, -0.5};
+  Relation relation = ElementUtils::createElement<Relation>(*dependencyProvider.getStringTable(), 3, {{"any", "true"}});
+  relation.elements.push_back(std::make_shared<Area>(area));
+  relation.elements.push_back(std::make_shared<Node>(node));
+  std::stringstream areaStream;
+  ElementStream::write(areaStream, area);
+  ElementCounter counter;
+
+  elementStore.store(area, range, *styleProvider);
+  elementStore.store(relation, range, *styleProvider);
+  elementStore.flush();
+  elementStore.search(quadKey, counter, CancellationToken());
+
+  BOOST_CHECK_LT(boost::filesystem::file_size(TestZoomDirectory + "/0.dat"), areaStream.str().size() * 3 / 2);
+  BOOST_CHECK_EQUAL(counter.times, 2);
+  Relation result = *std::dynamic_pointer_cast<Relation>(counter.element);
+  BOOST_REQUIRE_EQUAL(result.elements.size(), 2);
+  assertWayOrArea(area, *std::dynamic_pointer_cast<Area>(result.elements[0]));
+  assertNode(node, *std::dynamic_pointer_cast<Node>(result.elements[1]));
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnclippedArea_WhenStoreOnSeveralLods_ThenPayloadIsSharedAndReadBack) {
+  LodRange range(1, 3);
+  auto styleProvider = dependencyProvider.getStyleProvider("area|z1-3[any] { clip: false; }");
+  Area area = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  for (int i = 0; i < 100; ++i)
+    area.coordinates.push_back(GeoCoordinate(1 + i * 0.125, -1 - (i % 7) * 0.25));
+  std::stringstream areaStream;
+  ElementStream::write(areaStream, area);
+  ElementCounter counter;
+  for (int lod = 2; lod <= range.end; ++lod)
+    boost::filesystem::create_directories(DataDirectory + "/" + std::to_string(lod));
+
+  elementStore.store(area, range, *styleProvider);
+  elementStore.flush();
+  for (int lod = range.start; lod <= range.end; ++lod)
+    elementStore.search(utymap::utils::GeoUtils::GeoCoordinateToQuadKey(area.coordinates[0], lod), counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(TestSharedPayloadPath), areaStream.str().size());
+  BOOST_CHECK_EQUAL(counter.times, 3);
+  assertWayOrArea(area, *std::dynamic_pointer_cast<Area>(counter.element));
+  for (int lod = 2; lod <= range.end; ++lod)
+    boost::filesystem::remove_all(DataDirectory + "/" + std::to_string(lod));
+}
+
 BOOST_AUTO_TEST_CASE(GivenTwoAreas_WhenStoreAndSearchOnce_ThenTheyStoredTwiceAndSecondReturnedLast) {
   LodRange range(1, 2);
   QuadKey quadKey(1, 0, 0);
@@ -189,6 +269,541 @@ BOOST_AUTO_TEST_CASE(GivenTwoAreas_WhenStoreAndSearchOnce_ThenTheyStoredTwiceAnd
   assertWayOrArea(area2, *std::dynamic_pointer_cast<Area>(counter.element));
 }
 
+BOOST_AUTO_TEST_CASE(GivenStoredArea_WhenStoreAnotherAfterSearch_ThenBothAreReadBack) {
+  LodRange range(1, 2);
+  QuadKey quadKey(1, 0, 0);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Area area1 = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(),
+                                                 1,
+                                                 {{"any", "true"}},
+                                                 {{4, -4}, {5, -5}, {6, -6}});
+  Area area2 = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(),
+                                                 2,
+                                                 {{"any", "true"}},
+                                                 {{1, -1}, {2, -2}, {3, -3}});
+  ElementCounter firstCounter, secondCounter;
+  elementStore.store(area1, range, *styleProvider);
+  elementStore.search(quadKey, firstCounter, CancellationToken());
+
+  elementStore.store(area2, range, *styleProvider);
+  elementStore.search(quadKey, secondCounter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(firstCounter.times, 1);
+  BOOST_CHECK_EQUAL(secondCounter.times, 2);
+  assertWayOrArea(area2, *std::dynamic_pointer_cast<Area>(secondCounter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenBatch_WhenStoreAndCommit_ThenDataIsWrittenOnCommit) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Area area1 = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(),
+                                                 1,
+                                                 {{"any", "true"}},
+                                                 {{4, -4}, {5, -5}, {6, -6}});
+  Area area2 = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(),
+                                                 2,
+                                                 {{"any", "true"}},
+                                                 {{1, -1}, {2, -2}, {3, -3}});
+  ElementCounter counter;
+  elementStore.beginBatch();
+  elementStore.store(area1, range, *styleProvider);
+  elementStore.store(area2, range, *styleProvider);
+  auto sizeBeforeCommit = boost::filesystem::file_size(TestZoomDirectory + "/0.idf");
+
+  elementStore.commitBatch();
+
+  BOOST_CHECK_EQUAL(sizeBeforeCommit, 0);
+  BOOST_CHECK_GT(boost::filesystem::file_size(TestZoomDirectory + "/0.idf"), 0);
+  elementStore.search(quadKey, counter, CancellationToken());
+  BOOST_CHECK_EQUAL(counter.times, 2);
+  assertWayOrArea(area2, *std::dynamic_pointer_cast<Area>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenBulkImport_WhenStoreInDifferentQuadKeysAndCommit_ThenElementsAreWrittenInOrder) {
+  LodRange range(1, 1);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  elementStore.setBulkImportRunSize(1);
+  elementStore.beginBatch();
+  for (int i = 0; i < 10; ++i) {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), i, {{"any", "bulk"}});
+    node.coordinate = i % 2 == 0 ? GeoCoordinate(5, -5) : GeoCoordinate(-5, 5);
+    elementStore.store(node, range, *styleProvider);
+  }
+  bool hasDataBeforeCommit = elementStore.hasData(QuadKey(1, 0, 0));
+  ElementCounter quadKeyCounter, textCounter;
+
+  elementStore.commitBatch();
+  elementStore.search(QuadKey(1, 0, 0), quadKeyCounter, CancellationToken());
+  elementStore.search({}, {"bulk"}, {}, bbox, range, textCounter, CancellationToken());
+
+  BOOST_CHECK(!hasDataBeforeCommit);
+  BOOST_CHECK(!boost::filesystem::exists(TestZoomDirectory + "/0.bml"));
+  BOOST_CHECK(!boost::filesystem::exists(DataDirectory + "/bulk0.run"));
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 5);
+  BOOST_CHECK_EQUAL(quadKeyCounter.element->id, 8);
+  BOOST_CHECK_EQUAL(textCounter.times, 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoreWithSmallFileBudget_WhenStoreInDifferentQuadKeys_ThenCacheEvicts) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable(), 2);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "true"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {-5, 5};
+  ElementCounter counter;
+
+  store.store(node1, range, *styleProvider);
+  store.store(node2, range, *styleProvider);
+  store.search(QuadKey(1, 1, 1), counter, CancellationToken());
+
+  auto statistics = store.getCacheStatistics();
+  BOOST_CHECK_EQUAL(statistics.entries, 1);
+  BOOST_CHECK_EQUAL(statistics.misses, 2);
+  BOOST_CHECK_EQUAL(statistics.evictions, 1);
+  BOOST_CHECK_GT(statistics.hits, 0);
+  BOOST_CHECK_EQUAL(counter.times, 1);
+  store.flush();
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoreWithSmallBitmapBudget_WhenStoreInDifferentQuadKeys_ThenBitmapBytesAreTracked) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable(),
+                               PersistentElementStore::DefaultMaxOpenFiles, 1);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "true"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {-5, 5};
+
+  store.store(node1, range, *styleProvider);
+  store.store(node2, range, *styleProvider);
+  auto statistics = store.getCacheStatistics();
+  store.flush();
+
+  BOOST_CHECK_EQUAL(statistics.entries, 1);
+  BOOST_CHECK_GT(statistics.bitmapBytes, 0);
+  BOOST_CHECK_EQUAL(store.getCacheStatistics().bitmapBytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNodes_WhenSearchConcurrently_ThenAllReadersGetAllNodes) {
+  const int NodeCount = 50;
+  const int ReaderCount = 4;
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  for (int i = 0; i < NodeCount; ++i) {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), i, {{"any", "true"}});
+    node.coordinate = {5, -5};
+    elementStore.store(node, range, *styleProvider);
+  }
+  std::vector<ElementCounter> quadKeyCounters(ReaderCount), textCounters(ReaderCount);
+  std::vector<std::thread> readers;
+
+  for (int i = 0; i < ReaderCount; ++i) {
+    readers.push_back(std::thread([&, i]() {
+      elementStore.search(quadKey, quadKeyCounters[i], CancellationToken());
+      elementStore.search({}, {"true"}, {}, bbox, range, textCounters[i], CancellationToken());
+    }));
+  }
+  for (auto &reader : readers)
+    reader.join();
+
+  for (int i = 0; i < ReaderCount; ++i) {
+    BOOST_CHECK_EQUAL(quadKeyCounters[i].times, NodeCount);
+    BOOST_CHECK_EQUAL(textCounters[i].times, NodeCount);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoreWithSmallFileBudget_WhenStoreInDifferentQuadKeysConcurrently_ThenAllNodesAreStored) {
+  const int NodeCount = 100;
+  const int WriterCount = 4;
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable(), 2);
+  std::vector<std::thread> writers;
+
+  for (int i = 0; i < WriterCount; ++i) {
+    writers.push_back(std::thread([&, i]() {
+      for (int j = i; j < NodeCount; j += WriterCount) {
+        Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), j, {{"any", "true"}});
+        node.coordinate = j % 2 == 0 ? GeoCoordinate(5, -5) : GeoCoordinate(-5, 5);
+        store.store(node, range, *styleProvider);
+      }
+    }));
+  }
+  for (auto &writer : writers)
+    writer.join();
+  store.flush();
+
+  ElementCounter counter1, counter2;
+  store.search(QuadKey(1, 0, 0), counter1, CancellationToken());
+  store.search(QuadKey(1, 1, 1), counter2, CancellationToken());
+  BOOST_CHECK_EQUAL(counter1.times, NodeCount / 2);
+  BOOST_CHECK_EQUAL(counter2.times, NodeCount / 2);
+  BOOST_CHECK_GT(store.getCacheStatistics().evictions, 0);
+}
+
+#ifdef COMPRESSION_SUPPORTED_ENABLED
+BOOST_AUTO_TEST_CASE(GivenCompressedStore_WhenStoreManyAreasAndReopen_ThenAllAreReadBack) {
+  const int AreaCount = 3000;
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Area lastArea;
+  {
+    PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable(),
+                                 PersistentElementStore::DefaultMaxOpenFiles,
+                                 PersistentElementStore::DefaultMaxBitmapBytes,
+                                 PersistentElementStore::Compression::Zlib);
+    for (int i = 0; i < AreaCount; ++i) {
+      lastArea = ElementUtils::createElement<Area>(*dependencyProvider.getStringTable(),
+                                                   i,
+                                                   {{"any", i == 7 ? "seven" : "true"}},
+                                                   {{4, -4}, {5, -5}, {6, -6}, {5, -7}, {4, -6}});
+      store.store(lastArea, range, *styleProvider);
+    }
+    store.flush();
+  }
+  ElementCounter quadKeyCounter, textCounter;
+
+  elementStore.search(quadKey, quadKeyCounter, CancellationToken());
+  elementStore.search({}, {"seven"}, {}, bbox, range, textCounter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, AreaCount);
+  assertWayOrArea(lastArea, *std::dynamic_pointer_cast<Area>(quadKeyCounter.element));
+  BOOST_CHECK_EQUAL(textCounter.times, 1);
+  BOOST_CHECK_EQUAL(textCounter.element->id, 7);
+  BOOST_CHECK_LT(boost::filesystem::file_size(TestZoomDirectory + "/0.dat"), AreaCount * 5 * sizeof(GeoCoordinate) / 10);
+}
+
+BOOST_AUTO_TEST_CASE(GivenUncompressedData_WhenStoreWithCompression_ThenFileKeepsItsFormat) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "true"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {6, -6};
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.flush();
+  ElementCounter counter;
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable(),
+                               PersistentElementStore::DefaultMaxOpenFiles,
+                               PersistentElementStore::DefaultMaxBitmapBytes,
+                               PersistentElementStore::Compression::Zlib);
+
+  store.store(node2, range, *styleProvider);
+  store.search(quadKey, counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(counter.times, 2);
+  assertNode(node2, *std::dynamic_pointer_cast<Node>(counter.element));
+  store.flush();
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenOpenAnotherStore_ThenHasDataIsKnownAndUpdatedOnErase) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.store(node, range, *styleProvider);
+  elementStore.flush();
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable());
+
+  bool hasDataBeforeErase = store.hasData(quadKey);
+  bool hasOtherData = store.hasData(QuadKey(1, 1, 0));
+  store.erase(quadKey);
+
+  BOOST_CHECK(hasDataBeforeErase);
+  BOOST_CHECK(!hasOtherData);
+  BOOST_CHECK(!store.hasData(quadKey));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenOpenAnotherStore_ThenCoverageIsBuiltFromData) {
+  QuadKey quadKey(1, 0, 0);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.save(node, quadKey);
+  elementStore.flush();
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable());
+
+  BOOST_CHECK(store.mayHaveData(quadKey));
+  BOOST_CHECK(!store.mayHaveData(QuadKey(1, 1, 0)));
+  BOOST_CHECK(!store.mayHaveData(QuadKey(2, 0, 0)));
+  BOOST_CHECK(store.mayHaveData(BoundingBox(GeoCoordinate(1, -10), GeoCoordinate(10, -1)), LodRange(1, 1)));
+  BOOST_CHECK(!store.mayHaveData(BoundingBox(GeoCoordinate(1, 1), GeoCoordinate(10, 10)), LodRange(1, 1)));
+  BOOST_CHECK(!store.mayHaveData(BoundingBox(GeoCoordinate(1, -10), GeoCoordinate(10, -1)), LodRange(2, 19)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredElements_WhenOpenAnotherStore_ThenSummaryIsKeptAndResetOnErase) {
+  QuadKey quadKey(1, 0, 0);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(), 2,
+                                             {{"any", "true"}}, {{1, -1}, {5, -5}, {10, -10}});
+  elementStore.save(node, quadKey);
+  elementStore.save(way, quadKey);
+  auto summary = elementStore.getSummary(quadKey);
+  elementStore.flush();
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable());
+
+  auto reopened = store.getSummary(quadKey);
+  store.erase(quadKey);
+
+  BOOST_CHECK_EQUAL(summary.nodes, 1);
+  BOOST_CHECK_EQUAL(summary.ways, 1);
+  BOOST_CHECK_EQUAL(summary.vertices, 4);
+  BOOST_CHECK(summary.bytes > 0);
+  BOOST_CHECK_EQUAL(reopened.elements(), summary.elements());
+  BOOST_CHECK_EQUAL(reopened.vertices, summary.vertices);
+  BOOST_CHECK_EQUAL(reopened.bytes, summary.bytes);
+  BOOST_CHECK(store.getSummary(quadKey).empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenEraseBoundingBoxCoveringQuadKey_ThenQuadKeyIsErased) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.store(node, range, *styleProvider);
+
+  elementStore.erase(BoundingBox(GeoCoordinate(-1, -181), GeoCoordinate(89, 1)), range);
+
+  BOOST_CHECK(!elementStore.hasData(quadKey));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNodes_WhenEraseBoundingBoxInsideQuadKey_ThenOnlyIntersectingAreErased) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "true"}});
+  Node node3 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 3, {{"any", "true"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {50, -100};
+  node3.coordinate = {20, -20};
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.store(node3, range, *styleProvider);
+  ElementCounter quadKeyCounter, textCounter;
+
+  elementStore.erase(BoundingBox(GeoCoordinate(15, -25), GeoCoordinate(25, -15)), range);
+  elementStore.erase(BoundingBox(GeoCoordinate(0, -10), GeoCoordinate(10, 0)), range);
+  elementStore.flush();
+  elementStore.search(quadKey, quadKeyCounter, CancellationToken());
+  elementStore.search({}, {"true"}, {}, bbox, range, textCounter, CancellationToken());
+
+  BOOST_CHECK(elementStore.hasData(quadKey));
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 1);
+  assertNode(node2, *std::dynamic_pointer_cast<Node>(quadKeyCounter.element));
+  BOOST_CHECK_EQUAL(textCounter.times, 1);
+  assertNode(node2, *std::dynamic_pointer_cast<Node>(textCounter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenErasedElements_WhenCompact_ThenDataIsSmallerAndSortedByType) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Way way = ElementUtils::createElement<Way>(*dependencyProvider.getStringTable(),
+                                             1,
+                                             {{"any", "way"}},
+                                             {{40, -40}, {45, -45}});
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "node"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 3, {{"any", "node"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {20, -20};
+  elementStore.store(way, range, *styleProvider);
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.erase(BoundingBox(GeoCoordinate(15, -25), GeoCoordinate(25, -15)), range);
+  elementStore.flush();
+  auto sizeBeforeCompact = boost::filesystem::file_size(TestZoomDirectory + "/0.dat");
+  ElementCounter quadKeyCounter, textCounter;
+
+  elementStore.compact();
+  elementStore.search(quadKey, quadKeyCounter, CancellationToken());
+  elementStore.search({}, {"node"}, {}, bbox, range, textCounter, CancellationToken());
+
+  BOOST_CHECK_LT(boost::filesystem::file_size(TestZoomDirectory + "/0.dat"), sizeBeforeCompact);
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 2);
+  assertWayOrArea(way, *std::dynamic_pointer_cast<Way>(quadKeyCounter.element));
+  BOOST_CHECK_EQUAL(textCounter.times, 1);
+  assertNode(node1, *std::dynamic_pointer_cast<Node>(textCounter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNodes_WhenCompactQuadKey_ThenOtherQuadKeysStayCachedAndNodesAreFoundById) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "one"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "two"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {-5, 5};
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  ElementCounter idCounter, quadKeyCounter;
+
+  elementStore.compact(QuadKey(1, 0, 0));
+  auto misses = elementStore.getCacheStatistics().misses;
+  elementStore.search(QuadKey(1, 1, 1), quadKeyCounter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(elementStore.getCacheStatistics().misses, misses);
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 1);
+  BOOST_CHECK(elementStore.searchById(1, idCounter));
+  assertNode(node1, *std::dynamic_pointer_cast<Node>(idCounter.element));
+  BOOST_CHECK(!boost::filesystem::exists(TestZoomDirectory + "/0.dat.tmp"));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNodes_WhenPack_ThenTheyAreReadFromPack) {
+  LodRange range(1, 1);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "one"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "two"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {-5, 5};
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  ElementCounter quadKeyCounter, textCounter;
+
+  elementStore.pack(1);
+  elementStore.search(QuadKey(1, 0, 0), quadKeyCounter, CancellationToken());
+  elementStore.search({}, {"two"}, {}, bbox, range, textCounter, CancellationToken());
+
+  BOOST_CHECK(boost::filesystem::exists(TestPackPath));
+  BOOST_CHECK(!boost::filesystem::exists(TestZoomDirectory + "/0.dat"));
+  BOOST_CHECK(elementStore.hasData(QuadKey(1, 0, 0)));
+  BOOST_CHECK(elementStore.hasData(QuadKey(1, 1, 1)));
+  BOOST_CHECK(!elementStore.hasData(QuadKey(1, 1, 0)));
+  BOOST_CHECK_EQUAL(quadKeyCounter.times, 1);
+  assertNode(node1, *std::dynamic_pointer_cast<Node>(quadKeyCounter.element));
+  BOOST_CHECK_EQUAL(textCounter.times, 1);
+  assertNode(node2, *std::dynamic_pointer_cast<Node>(textCounter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenPackedNode_WhenStoreAnotherAndPackAgain_ThenBothAreReadBack) {
+  LodRange range(1, 1);
+  QuadKey quadKey(1, 0, 0);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "true"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {6, -6};
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.pack(1);
+  ElementCounter unpackedCounter, packedCounter;
+
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.search(quadKey, unpackedCounter, CancellationToken());
+  elementStore.pack(1);
+  elementStore.search(quadKey, packedCounter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(unpackedCounter.times, 2);
+  BOOST_CHECK_EQUAL(packedCounter.times, 2);
+  assertNode(node2, *std::dynamic_pointer_cast<Node>(packedCounter.element));
+  BOOST_CHECK(!boost::filesystem::exists(TestZoomDirectory + "/0.dat"));
+}
+
+BOOST_AUTO_TEST_CASE(GivenPackedNodes_WhenEraseQuadKey_ThenItIsRemovedFromPack) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "true"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "true"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {-5, 5};
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.pack(1);
+  ElementCounter counter;
+
+  elementStore.erase(QuadKey(1, 0, 0));
+  elementStore.search(QuadKey(1, 1, 1), counter, CancellationToken());
+
+  BOOST_CHECK(!elementStore.hasData(QuadKey(1, 0, 0)));
+  BOOST_CHECK(elementStore.hasData(QuadKey(1, 1, 1)));
+  BOOST_CHECK_EQUAL(counter.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyNodesWithErased_WhenSearchQuadKey_ThenAllRemainingAreReadInOrder) {
+  const int NodeCount = 700;
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  for (int i = 0; i < NodeCount; ++i) {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), i, {{"any", "node"}});
+    node.coordinate = i % 10 == 0 ? GeoCoordinate(20, -20) : GeoCoordinate(5, -5);
+    elementStore.store(node, range, *styleProvider);
+  }
+  elementStore.erase(BoundingBox(GeoCoordinate(15, -25), GeoCoordinate(25, -15)), range);
+  elementStore.flush();
+  std::vector<std::uint64_t> ids;
+  ElementIdCollector collector(ids);
+
+  elementStore.search(QuadKey(1, 0, 0), collector, CancellationToken());
+
+  BOOST_REQUIRE_EQUAL(ids.size(), NodeCount - NodeCount / 10);
+  BOOST_CHECK(std::is_sorted(ids.begin(), ids.end()));
+  BOOST_CHECK(std::none_of(ids.begin(), ids.end(), [](std::uint64_t id) { return id % 10 == 0; }));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyNodesWithErased_WhenPullQuadKeyCursor_ThenAllRemainingAreReadInOrder) {
+  const int NodeCount = 700;
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  for (int i = 0; i < NodeCount; ++i) {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), i, {{"any", "node"}});
+    node.coordinate = i % 10 == 0 ? GeoCoordinate(20, -20) : GeoCoordinate(5, -5);
+    elementStore.store(node, range, *styleProvider);
+  }
+  elementStore.erase(BoundingBox(GeoCoordinate(15, -25), GeoCoordinate(25, -15)), range);
+  elementStore.flush();
+  std::vector<std::uint64_t> ids;
+  std::vector<std::unique_ptr<Element>> batch;
+
+  auto cursor = elementStore.openCursor(QuadKey(1, 0, 0));
+  auto first = cursor->next();
+  while (cursor->next(batch, 100) > 0) {}
+
+  BOOST_REQUIRE(first != nullptr);
+  BOOST_REQUIRE_EQUAL(batch.size() + 1, NodeCount - NodeCount / 10);
+  ids.push_back(first->id);
+  for (const auto &element : batch)
+    ids.push_back(element->id);
+  BOOST_CHECK(std::is_sorted(ids.begin(), ids.end()));
+  BOOST_CHECK(std::none_of(ids.begin(), ids.end(), [](std::uint64_t id) { return id % 10 == 0; }));
+  BOOST_CHECK(cursor->next() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenPrefetchAndSearch_ThenDataIsFromCache) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.store(node, range, *styleProvider);
+  elementStore.flush();
+  auto before = elementStore.getCacheStatistics();
+  ElementCounter counter;
+
+  elementStore.prefetch({QuadKey(1, 0, 0), QuadKey(1, 1, 1)});
+  for (int i = 0; i < 500 && elementStore.getCacheStatistics().prefetches == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  auto prefetched = elementStore.getCacheStatistics();
+  elementStore.search(QuadKey(1, 0, 0), counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(prefetched.prefetches, 1);
+  BOOST_CHECK_EQUAL(counter.times, 1);
+  BOOST_CHECK_EQUAL(elementStore.getCacheStatistics().hits, prefetched.hits + 1);
+  BOOST_CHECK_EQUAL(elementStore.getCacheStatistics().misses, before.misses + 1);
+}
+
 BOOST_AUTO_TEST_CASE(GivenNodes_WhenSearchText_ThenOneFound) {
   LodRange range(1, 1);
   BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
@@ -209,6 +824,76 @@ BOOST_AUTO_TEST_CASE(GivenNodes_WhenSearchText_ThenOneFound) {
   assertNode(node2, *std::dynamic_pointer_cast<Node>(counter.element));
 }
 
+BOOST_AUTO_TEST_CASE(GivenNodesInSeveralLods_WhenPullTextCursor_ThenMatchesAreTheSameAsSearch) {
+  LodRange range(1, 2);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(
+      "node|z1-2[any] { clip: false; }");
+  boost::filesystem::create_directories(DataDirectory + "/2");
+  for (int i = 0; i < 10; ++i) {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), i,
+                                                  {{"any", i % 2 == 0 ? "even" : "odd"}});
+    node.coordinate = i < 5 ? GeoCoordinate(5, -5) : GeoCoordinate(-5, 5);
+    elementStore.store(node, range, *styleProvider);
+  }
+  std::vector<std::uint64_t> expected, actual;
+  ElementIdCollector collector(expected);
+  elementStore.search({}, {}, {"even"}, bbox, range, collector, CancellationToken());
+
+  auto cursor = elementStore.openCursor({}, {}, {"even"}, bbox, range);
+  for (auto element = cursor->next(); element != nullptr; element = cursor->next())
+    actual.push_back(element->id);
+
+  BOOST_CHECK_EQUAL(expected.size(), 5);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), actual.begin(), actual.end());
+  elementStore.flush();
+  boost::filesystem::remove_all(DataDirectory + "/2");
+}
+
+BOOST_AUTO_TEST_CASE(GivenNodesInDifferentQuadKeys_WhenSearchTextInParallel_ThenOrderIsTheSame) {
+  LodRange range(1, 1);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  std::vector<GeoCoordinate> coordinates = { { 45, 90 }, { -45, -90 }, { 45, -90 }, { -45, 90 } };
+  for (std::size_t i = 0; i < coordinates.size() * 2; ++i) {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), i, { { "any", "shop" } });
+    node.coordinate = coordinates[i % coordinates.size()];
+    elementStore.store(node, range, *styleProvider);
+  }
+  std::vector<std::uint64_t> expected;
+  ElementIdCollector sequential(expected);
+  elementStore.search({}, {"shop"}, {}, bbox, range, sequential, CancellationToken());
+  std::vector<std::uint64_t> ids, pageIds;
+  ElementIdCollector parallel(ids), page(pageIds);
+
+  elementStore.setSearchThreads(2);
+  elementStore.search({}, {"shop"}, {}, bbox, range, parallel, CancellationToken());
+  elementStore.search({}, {"shop"}, {}, bbox, range, 3, 2, page, CancellationToken());
+
+  BOOST_CHECK_EQUAL(expected.size(), 8);
+  BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(pageIds.begin(), pageIds.end(), expected.begin() + 3, expected.begin() + 5);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNodes_WhenSearchTextAfterFlush_ThenBitmapIsMergedAndNodeFound) {
+  LodRange range(1, 1);
+  BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "one" } });
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "two" } });
+  node1.coordinate = { 5, -5 };
+  node2.coordinate = { 5, -5 };
+  ElementCounter counter;
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.flush();
+
+  elementStore.search({}, {"two"}, {}, bbox, range, counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(counter.times, 1);
+  assertNode(node2, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
 BOOST_AUTO_TEST_CASE(GivenElementWithNonAnsiSymbols_WhenSearchText_ThenItIsFound) {
   LodRange range(1, 1);
   BoundingBox bbox(GeoCoordinate(-90, -180), GeoCoordinate(90, 180));
@@ -224,4 +909,160 @@ BOOST_AUTO_TEST_CASE(GivenElementWithNonAnsiSymbols_WhenSearchText_ThenItIsFound
   BOOST_CHECK_EQUAL(counter.times, 1);
 }
 
+BOOST_AUTO_TEST_CASE(GivenNodes_WhenStore_ThenBoundsAreWrittenForEveryElement) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "one" } });
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "two" } });
+  node1.coordinate = { 5, -5 };
+  node2.coordinate = { 60, -100 };
+
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.flush();
+
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(TestZoomDirectory + "/0.bbx"), 2 * 4 * sizeof(float));
+}
+
+BOOST_AUTO_TEST_CASE(GivenElementOutsideQueryBoundingBox_WhenSearchText_ThenItIsNotRead) {
+  LodRange range(1, 1);
+  BoundingBox bbox(GeoCoordinate(0, -10), GeoCoordinate(10, 0));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+  node1.coordinate = { 5, -5 };
+  node2.coordinate = { 60, -100 };
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.flush();
+  // NOTE data of second element is cut off, so search fails if it is read.
+  std::uint32_t offset;
+  std::ifstream indexFile(TestZoomDirectory + "/0.idf", std::ios::in | std::ios::binary);
+  indexFile.seekg(sizeof(std::uint64_t) + sizeof(std::uint32_t) + sizeof(std::uint64_t));
+  indexFile.read(reinterpret_cast<char *>(&offset), sizeof(offset));
+  boost::filesystem::resize_file(TestZoomDirectory + "/0.dat", offset);
+  ElementCounter counter;
+
+  elementStore.search({}, {"true"}, {}, bbox, range, counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(counter.times, 1);
+  assertNode(node1, *std::dynamic_pointer_cast<Node>(counter.element));
+}
+
+BOOST_AUTO_TEST_CASE(GivenQuadKeyWithoutBounds_WhenSearchText_ThenElementsAreFilteredByGeometry) {
+  LodRange range(1, 1);
+  BoundingBox bbox(GeoCoordinate(0, -10), GeoCoordinate(10, 0));
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, { { "any", "true" } });
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, { { "any", "true" } });
+  node1.coordinate = { 5, -5 };
+  node2.coordinate = { 60, -100 };
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.flush();
+  boost::filesystem::remove(TestZoomDirectory + "/0.bbx");
+  elementStore.store(node2, range, *styleProvider);
+  elementStore.flush();
+  ElementCounter counter;
+
+  elementStore.search({}, {"true"}, {}, bbox, range, counter, CancellationToken());
+
+  BOOST_CHECK_EQUAL(counter.times, 1);
+  assertNode(node1, *std::dynamic_pointer_cast<Node>(counter.element));
+  BOOST_CHECK_EQUAL(boost::filesystem::file_size(TestZoomDirectory + "/0.bbx"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenSearchById_ThenItIsFound) {
+  LodRange range(1, 2);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.store(node, range, *styleProvider);
+  ElementCounter counter;
+
+  bool isFound = elementStore.searchById(7, counter);
+
+  BOOST_CHECK(isFound);
+  BOOST_CHECK_EQUAL(counter.times, 1);
+  assertNode(node, *std::dynamic_pointer_cast<Node>(counter.element));
+  BOOST_CHECK(!elementStore.searchById(8, counter));
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoredNode_WhenSearchByIdAfterReopen_ThenItIsFound) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.store(node, range, *styleProvider);
+  elementStore.flush();
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable());
+  ElementCounter counter;
+
+  BOOST_CHECK(store.searchById(7, counter));
+  BOOST_CHECK_EQUAL(counter.times, 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPackedAndLooseNodes_WhenExportPackage_ThenReadOnlyStoreReadsThem) {
+  const std::string PackagePath = "package";
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node1 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 1, {{"any", "one"}});
+  Node node2 = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 2, {{"any", "two"}});
+  node1.coordinate = {5, -5};
+  node2.coordinate = {-5, 5};
+  elementStore.store(node1, range, *styleProvider);
+  elementStore.pack(1);
+  elementStore.store(node2, range, *styleProvider);
+
+  elementStore.exportPackage(PackagePath);
+
+  {
+    PersistentElementStore package(PackagePath, *dependencyProvider.getStringTable());
+    package.setReadOnly(true);
+    ElementCounter quadKeyCounter, idCounter;
+    package.search(QuadKey(1, 1, 1), quadKeyCounter, CancellationToken());
+
+    BOOST_CHECK(boost::filesystem::exists(PackagePath + "/1.pack"));
+    BOOST_CHECK(package.hasData(QuadKey(1, 0, 0)));
+    BOOST_CHECK_EQUAL(quadKeyCounter.times, 1);
+    assertNode(node2, *std::dynamic_pointer_cast<Node>(quadKeyCounter.element));
+    BOOST_CHECK(package.searchById(1, idCounter));
+    assertNode(node1, *std::dynamic_pointer_cast<Node>(idCounter.element));
+    BOOST_CHECK_THROW(package.save(node1, QuadKey(1, 0, 0)), std::domain_error);
+    BOOST_CHECK_THROW(package.erase(QuadKey(1, 0, 0)), std::domain_error);
+  }
+  boost::filesystem::remove_all(PackagePath);
+}
+
+BOOST_AUTO_TEST_CASE(GivenErasedQuadKey_WhenSearchById_ThenNotFound) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.store(node, range, *styleProvider);
+  elementStore.erase(QuadKey(1, 0, 0));
+  ElementCounter counter;
+
+  BOOST_CHECK(!elementStore.searchById(7, counter));
+  BOOST_CHECK_EQUAL(counter.times, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenErasedQuadKey_WhenStoreInAnotherQuadKeyAndSearchById_ThenItIsFound) {
+  LodRange range(1, 1);
+  auto styleProvider = dependencyProvider.getStyleProvider(stylesheet);
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 7, {{"any", "true"}});
+  node.coordinate = {5, -5};
+  elementStore.store(node, range, *styleProvider);
+  elementStore.erase(QuadKey(1, 0, 0));
+  node.coordinate = {-5, 5};
+  elementStore.store(node, range, *styleProvider);
+  elementStore.flush();
+  PersistentElementStore store(DataDirectory, *dependencyProvider.getStringTable());
+  ElementCounter counter, reopenCounter;
+
+  BOOST_CHECK(elementStore.searchById(7, counter));
+  BOOST_CHECK(store.searchById(7, reopenCounter));
+  assertNode(node, *std::dynamic_pointer_cast<Node>(counter.element));
+  assertNode(node, *std::dynamic_pointer_cast<Node>(reopenCounter.element));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+#include "index/RoaringBitset.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+using namespace utymap::index;
+
+namespace {
+  RoaringBitset create(const std::vector<std::uint32_t> &values) {
+    RoaringBitset bitset;
+    for (const auto value : values)
+      bitset.set(value);
+    return bitset;
+  }
+
+  void checkValues(const RoaringBitset &bitset, const std::vector<std::uint32_t> &expected) {
+    auto values = bitset.toArray();
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(Index_RoaringBitset)
+
+BOOST_AUTO_TEST_CASE(GivenValuesInAnyOrder_WhenIterate_ThenValuesAreSorted) {
+  auto bitset = create({ 70000, 5, 3, 5, 1 << 20 });
+
+  checkValues(bitset, { 3, 5, 70000, 1 << 20 });
+  BOOST_CHECK_EQUAL(bitset.numberOfOnes(), 4);
+  BOOST_CHECK_EQUAL(bitset.sizeInBits(), (1 << 20) + 1);
+  BOOST_CHECK(bitset.get(70000));
+  BOOST_CHECK(!bitset.get(4));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyValues_WhenSet_ThenDenseContainerKeepsAllValues) {
+  RoaringBitset bitset;
+  std::vector<std::uint32_t> expected;
+  for (std::uint32_t i = 0; i < 10000; ++i) {
+    bitset.set(i * 2);
+    expected.push_back(i * 2);
+  }
+
+  checkValues(bitset, expected);
+  BOOST_CHECK_EQUAL(bitset.numberOfOnes(), 10000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoSets_WhenApplyOperations_ThenResultsAreCorrect) {
+  auto left = create({ 1, 2, 3, 70000 });
+  auto right = create({ 2, 3, 4, 140000 });
+
+  checkValues(left.logicalor(right), { 1, 2, 3, 4, 70000, 140000 });
+  checkValues(left.logicaland(right), { 2, 3 });
+  checkValues(left.logicalandnot(right), { 1, 70000 });
+  checkValues(left.logicalxor(right), { 1, 4, 70000, 140000 });
+}
+
+BOOST_AUTO_TEST_CASE(GivenTwoSets_WhenApplyInplaceOperations_ThenResultsAreCorrect) {
+  auto right = create({ 2, 3, 4, 140000 });
+  auto orResult = create({ 1, 2, 3, 70000 });
+  auto andResult = orResult;
+  auto andNotResult = orResult;
+
+  orResult.inplaceOr(right);
+  andResult.inplaceAnd(right);
+  andNotResult.inplaceAndNot(right);
+
+  checkValues(orResult, { 1, 2, 3, 4, 70000, 140000 });
+  checkValues(andResult, { 2, 3 });
+  checkValues(andNotResult, { 1, 70000 });
+}
+
+BOOST_AUTO_TEST_CASE(GivenDisjointSets_WhenInplaceAnd_ThenResultIsEmpty) {
+  auto bitset = create({ 1, 2 });
+
+  bitset.inplaceAnd(create({ 70000 }));
+
+  BOOST_CHECK(bitset.empty());
+  BOOST_CHECK_EQUAL(bitset.sizeInBits(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSparseAndDenseSet_WhenWrittenAndRead_ThenItIsTheSame) {
+  auto bitset = create({ 1, 70000 });
+  for (std::uint32_t i = 0; i < 5000; ++i)
+    bitset.set(200000 + i);
+  std::stringstream stream;
+
+  bitset.write(stream);
+  RoaringBitset result;
+  BOOST_CHECK(result.read(stream));
+
+  BOOST_CHECK(result == bitset);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
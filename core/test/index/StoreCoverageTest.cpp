@@ -0,0 +1,54 @@
+#include "index/StoreCoverage.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::index;
+using namespace utymap::utils;
+
+namespace {
+const GeoCoordinate Berlin(52.52, 13.40);
+const GeoCoordinate Moscow(55.75, 37.62);
+}
+
+BOOST_AUTO_TEST_SUITE(Index_StoreCoverage)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyCoverage_WhenCheck_ThenNothingIsCovered) {
+  StoreCoverage coverage;
+
+  BOOST_CHECK(!coverage.mayContain(QuadKey(1, 0, 0)));
+  BOOST_CHECK(!coverage.mayIntersect(BoundingBox(GeoCoordinate(-80, -170), GeoCoordinate(80, 170)), LodRange(1, 19)));
+  BOOST_CHECK(!coverage.getBoundingBox().isValid());
+}
+
+BOOST_AUTO_TEST_CASE(GivenDeepQuadKey_WhenCheckQuadKeys_ThenOnlyItsCoarseTileIsCovered) {
+  StoreCoverage coverage;
+  auto quadKey = GeoUtils::GeoCoordinateToQuadKey(Berlin, 16);
+
+  coverage.add(quadKey);
+
+  BOOST_CHECK(coverage.mayContain(quadKey));
+  BOOST_CHECK(coverage.mayContain(quadKey.neighbour(1, 0)));
+  BOOST_CHECK(!coverage.mayContain(quadKey.neighbour(1 << 6, 0)));
+  BOOST_CHECK(!coverage.mayContain(GeoUtils::GeoCoordinateToQuadKey(Berlin, 15)));
+  BOOST_CHECK(!coverage.mayContain(GeoUtils::GeoCoordinateToQuadKey(Moscow, 16)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenQuadKeys_WhenCheckBoundingBoxes_ThenOnlyIntersectingOnesAreCovered) {
+  StoreCoverage coverage;
+  coverage.add(GeoUtils::GeoCoordinateToQuadKey(Berlin, 16));
+  coverage.add(GeoUtils::GeoCoordinateToQuadKey(Moscow, 16));
+  BoundingBox nearBerlin(GeoCoordinate(52.51, 13.39), GeoCoordinate(52.53, 13.41));
+  BoundingBox world(GeoCoordinate(-80, -170), GeoCoordinate(80, 170));
+  BoundingBox between(GeoCoordinate(53, 20), GeoCoordinate(54, 30));
+
+  BOOST_CHECK(coverage.mayIntersect(nearBerlin, LodRange(16, 16)));
+  BOOST_CHECK(coverage.mayIntersect(world, LodRange(1, 19)));
+  BOOST_CHECK(!coverage.mayIntersect(between, LodRange(16, 16)));
+  BOOST_CHECK(!coverage.mayIntersect(nearBerlin, LodRange(1, 15)));
+  BOOST_CHECK(coverage.getBoundingBox().contains(Berlin));
+  BOOST_CHECK(coverage.getBoundingBox().contains(Moscow));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
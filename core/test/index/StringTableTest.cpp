@@ -1,8 +1,14 @@
 #include "index/StringTable.hpp"
 
+#include <boost/filesystem/operations.hpp>
 #include <boost/test/unit_test.hpp>
 #include "test_utils/DependencyProvider.hpp"
 
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
 using namespace utymap::index;
 using namespace utymap::tests;
 
@@ -50,4 +56,208 @@ BOOST_AUTO_TEST_CASE(GivenThreeStrings_WhenGetStringOfSecond_ThenReturnValidStri
   BOOST_CHECK_EQUAL(*str, "string2");
 }
 
+BOOST_AUTO_TEST_CASE(GivenManyStrings_WhenReopen_ThenIdsAreKept) {
+  const std::uint32_t Count = 5000;
+  {
+    StringTable table("");
+    for (std::uint32_t i = 0; i < Count; ++i)
+      table.getId("string" + std::to_string(i));
+  }
+
+  StringTable table("");
+
+  BOOST_CHECK_EQUAL(table.getId("string0"), 0);
+  BOOST_CHECK_EQUAL(table.getId("string4321"), 4321);
+  BOOST_CHECK_EQUAL(*table.getString(Count - 1), "string" + std::to_string(Count - 1));
+  BOOST_CHECK_EQUAL(table.getId("new"), Count);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTableWithoutHashFile_WhenReopen_ThenHashFileIsRebuilt) {
+  {
+    StringTable table("");
+    table.getId("string1");
+    table.getId("string2");
+  }
+  std::remove("string.hsh");
+
+  StringTable table("");
+
+  BOOST_CHECK_EQUAL(table.getId("string2"), 1);
+  BOOST_CHECK_EQUAL(table.getId("string3"), 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenTable_WhenExportAndOpenCopy_ThenIdsAreKept) {
+  const std::string ExportPath = "exported.";
+  auto stringTable = dependencyProvider.getStringTable();
+  stringTable->getId("string1");
+  stringTable->getId("string2");
+
+  stringTable->exportTo(ExportPath);
+  stringTable->getId("string3");
+
+  {
+    StringTable table(ExportPath);
+
+    BOOST_CHECK_EQUAL(table.getId("string2"), 1);
+    BOOST_CHECK_EQUAL(*table.getString(0), "string1");
+    BOOST_CHECK_EQUAL(table.getId("other"), 2);
+  }
+  for (const auto &extension : { "idx", "dat", "hsh", "sld" })
+    std::remove((ExportPath + "string." + extension).c_str());
+}
+
+BOOST_AUTO_TEST_CASE(GivenFastTable_WhenAddStringsAndFlush_ThenStringsAreReadableAndWrittenOnFlush) {
+  {
+    StringTable table("");
+    table.getId("string1");
+    table.getId("string22");
+
+    BOOST_CHECK_EQUAL(*table.getString(1), "string22");
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size("string.idx"), 0);
+
+    table.flush();
+
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size("string.idx"), 16);
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size("string.dat"), 17);
+    table.getId("string333");
+  }
+
+  StringTable table("");
+
+  BOOST_CHECK_EQUAL(table.getId("string333"), 2);
+  BOOST_CHECK_EQUAL(*table.getString(0), "string1");
+}
+
+BOOST_AUTO_TEST_CASE(GivenSafeTable_WhenAddStrings_ThenStringsAreWrittenAtOnce) {
+  {
+    StringTable table("", StringTable::Durability::Safe);
+    std::vector<std::uint32_t> ids;
+    table.getIds(std::vector<std::string>{ "string1", "string22", "string1" }, ids);
+
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size("string.idx"), 16);
+    table.getId("string333");
+    BOOST_CHECK_EQUAL(boost::filesystem::file_size("string.idx"), 24);
+  }
+
+  StringTable table("");
+
+  BOOST_CHECK_EQUAL(table.getId("string22"), 1);
+  BOOST_CHECK_EQUAL(*table.getString(2), "string333");
+}
+
+BOOST_AUTO_TEST_CASE(GivenStrings_WhenGetIdsByPrefixAndSimilarity_ThenMatchingIdsAreReturned) {
+  StringTable table("");
+  table.getId("berlin");
+  table.getId("bern");
+  table.getId("moscow");
+
+  std::vector<std::uint32_t> prefixIds, similarIds;
+  table.getIdsByPrefix("ber", 10, prefixIds);
+  table.getId("bergen");
+  table.getIdsByPrefix("berg", 10, prefixIds);
+  table.getIdsBySimilarity("bernn", 1, 10, similarIds);
+
+  std::vector<std::uint32_t> expectedPrefixIds = { 0, 1, 3 }, expectedSimilarIds = { 1 };
+  BOOST_CHECK_EQUAL_COLLECTIONS(prefixIds.begin(), prefixIds.end(), expectedPrefixIds.begin(), expectedPrefixIds.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(similarIds.begin(), similarIds.end(), expectedSimilarIds.begin(), expectedSimilarIds.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenStrings_WhenGetStringViewBeforeAndAfterReopen_ThenViewsHaveStrings) {
+  {
+    StringTable table("");
+    table.getId("string1");
+    table.getId("string22");
+    auto view = table.getStringView(1);
+    BOOST_CHECK_EQUAL(std::string(view.data, view.size), "string22");
+  }
+
+  StringTable table("");
+  table.getId("string333");
+
+  auto mapped = table.getStringView(1);
+  auto added = table.getStringView(2);
+  BOOST_CHECK_EQUAL(std::string(mapped.data, mapped.size), "string22");
+  BOOST_CHECK_EQUAL(std::string(mapped.data), "string22");
+  BOOST_CHECK_EQUAL(std::string(added.data, added.size), "string333");
+  BOOST_CHECK_EQUAL(table.getStringView(3).size, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenKnownAndNewStrings_WhenGetIds_ThenIdsMatchSingleLookups) {
+  auto stringTable = dependencyProvider.getStringTable();
+  stringTable->getId("known");
+  std::vector<std::uint32_t> ids;
+
+  stringTable->getIds({"new1", "known", "new2", "new1"}, ids);
+
+  BOOST_REQUIRE_EQUAL(ids.size(), 4);
+  BOOST_CHECK_EQUAL(ids[0], 1);
+  BOOST_CHECK_EQUAL(ids[1], 0);
+  BOOST_CHECK_EQUAL(ids[2], 2);
+  BOOST_CHECK_EQUAL(ids[3], 1);
+  BOOST_CHECK_EQUAL(stringTable->getId("new2"), 2);
+  BOOST_CHECK_EQUAL(*stringTable->getString(1), "new1");
+  BOOST_CHECK_EQUAL(stringTable->getId("other"), 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSealedTable_WhenReopenAndAddStrings_ThenIdsAreKept) {
+  const std::uint32_t Count = 3000;
+  {
+    StringTable table("");
+    for (std::uint32_t i = 0; i < Count; ++i)
+      table.getId("string" + std::to_string(i));
+    table.seal();
+  }
+  {
+    StringTable table("");
+    for (std::uint32_t i = 0; i < Count; i += 7)
+      BOOST_CHECK_EQUAL(table.getId("string" + std::to_string(i)), i);
+    auto view = table.getStringView(42);
+    BOOST_CHECK_EQUAL(std::string(view.data, view.size), "string42");
+    BOOST_CHECK_EQUAL(*table.getString(Count - 1), "string" + std::to_string(Count - 1));
+    BOOST_CHECK_EQUAL(table.getId("overflow"), Count);
+  }
+
+  StringTable table("");
+
+  BOOST_CHECK_EQUAL(table.getId("overflow"), Count);
+  BOOST_CHECK_EQUAL(table.getId("string1"), 1);
+  BOOST_CHECK_EQUAL(table.getId("another"), Count + 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnpublishedString_WhenGetIdManyTimes_ThenItIsCollectedOnce) {
+  auto stringTable = dependencyProvider.getStringTable();
+  stringTable->getId("string");
+  std::size_t memoryUsage = stringTable->getMemoryUsage();
+
+  for (int i = 0; i < 32; ++i)
+    stringTable->getId("string");
+
+  BOOST_CHECK_EQUAL(stringTable->getMemoryUsage(), memoryUsage);
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyThreads_WhenGetIdsOfSameStrings_ThenIdsAreConsistent) {
+  const int ThreadCount = 4;
+  const int StringCount = 1000;
+  auto stringTable = dependencyProvider.getStringTable();
+  std::vector<std::vector<std::uint32_t>> ids(ThreadCount);
+  std::vector<std::thread> threads;
+
+  for (int thread = 0; thread < ThreadCount; ++thread) {
+    threads.emplace_back([&, thread]() {
+      for (int round = 0; round < 3; ++round) {
+        ids[thread].clear();
+        for (int i = 0; i < StringCount; ++i)
+          ids[thread].push_back(stringTable->getId("string" + std::to_string(i)));
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  for (int thread = 1; thread < ThreadCount; ++thread)
+    BOOST_CHECK(ids[thread] == ids[0]);
+  for (int i = 0; i < StringCount; ++i)
+    BOOST_CHECK_EQUAL(*stringTable->getString(ids[0][i]), "string" + std::to_string(i));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+#include "index/TilePack.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+using namespace utymap;
+using namespace utymap::index;
+
+namespace {
+const std::string PackPath = "test.pack";
+const std::string IndexPath = "test.idf";
+const std::string DataPath = "test.dat";
+
+struct Index_TilePackFixture {
+  ~Index_TilePackFixture() {
+    boost::filesystem::remove(PackPath);
+    boost::filesystem::remove(IndexPath);
+    boost::filesystem::remove(DataPath);
+  }
+};
+
+TilePack::Section toSection(const std::string &content) {
+  return TilePack::Section{ content.data(), content.size() };
+}
+
+std::string toString(const TilePack::Section &section) {
+  return std::string(section.data, section.size);
+}
+
+void writeFile(const std::string &path, const std::string &content) {
+  std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  file << content;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_TilePack, Index_TilePackFixture)
+
+BOOST_AUTO_TEST_CASE(GivenTilesInMemoryAndFiles_WhenWriteAndOpen_ThenTheyAreFound) {
+  std::string index = "index", data = "data", bitmap = "bitmap";
+  writeFile(IndexPath, "file index");
+  writeFile(DataPath, "file data");
+  TilePack::Builder builder;
+  builder.add(QuadKey(2, 3, 1), TilePack::Tile{ toSection(index), toSection(data), toSection(bitmap) });
+  builder.add(QuadKey(2, 0, 2), IndexPath, DataPath, "missing.bmp");
+  builder.write(PackPath);
+
+  TilePack pack(PackPath);
+  TilePack::Tile tile;
+
+  BOOST_REQUIRE(pack.find(QuadKey(2, 3, 1), tile));
+  BOOST_CHECK_EQUAL(toString(tile.index), index);
+  BOOST_CHECK_EQUAL(toString(tile.data), data);
+  BOOST_CHECK_EQUAL(toString(tile.bitmap), bitmap);
+  BOOST_REQUIRE(pack.find(QuadKey(2, 0, 2), tile));
+  BOOST_CHECK_EQUAL(toString(tile.index), "file index");
+  BOOST_CHECK_EQUAL(toString(tile.data), "file data");
+  BOOST_CHECK_EQUAL(tile.bitmap.size, 0);
+  BOOST_CHECK(!pack.contains(QuadKey(2, 1, 1)));
+}
+
+BOOST_AUTO_TEST_CASE(GivenUnsortedTiles_WhenWrite_ThenDirectoryIsSortedByQuadKey) {
+  std::string content = "content";
+  TilePack::Tile tile = { toSection(content), toSection(content), toSection(content) };
+  TilePack::Builder builder;
+  builder.add(QuadKey(1, 1, 0), tile);
+  builder.add(QuadKey(1, 0, 1), tile);
+  builder.add(QuadKey(1, 0, 0), tile);
+  builder.write(PackPath);
+
+  auto quadKeys = TilePack(PackPath).getQuadKeys();
+
+  BOOST_REQUIRE_EQUAL(quadKeys.size(), 3);
+  BOOST_CHECK(quadKeys[0] == QuadKey(1, 0, 0));
+  BOOST_CHECK(quadKeys[1] == QuadKey(1, 0, 1));
+  BOOST_CHECK(quadKeys[2] == QuadKey(1, 1, 0));
+}
+
+BOOST_AUTO_TEST_CASE(GivenTileWithBounds_WhenWriteAndOpen_ThenBoundsAreFound) {
+  std::string content = "content", bounds = "bounds";
+  TilePack::Builder builder;
+  builder.add(QuadKey(1, 0, 0), TilePack::Tile{ toSection(content), toSection(content), toSection(content), toSection(bounds) });
+  builder.write(PackPath);
+
+  TilePack pack(PackPath);
+  TilePack::Tile tile;
+
+  BOOST_REQUIRE(pack.find(QuadKey(1, 0, 0), tile));
+  BOOST_CHECK_EQUAL(toString(tile.bounds), bounds);
+}
+
+BOOST_AUTO_TEST_CASE(GivenInvalidFile_WhenOpen_ThenThrows) {
+  writeFile(PackPath, "not a tile pack file");
+
+  BOOST_CHECK_THROW(TilePack pack(PackPath), std::domain_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,62 @@
+#include "entities/Node.hpp"
+#include "entities/Way.hpp"
+#include "index/TileSummaries.hpp"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::entities;
+using namespace utymap::index;
+
+namespace {
+const std::string SummaryPath = "test.sum";
+
+struct Index_TileSummariesFixture {
+  Index_TileSummariesFixture() {
+    way.coordinates = { GeoCoordinate(1, 1), GeoCoordinate(2, 2), GeoCoordinate(3, 3) };
+  }
+
+  ~Index_TileSummariesFixture() {
+    boost::filesystem::remove(SummaryPath);
+  }
+
+  Node node;
+  Way way;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_TileSummaries, Index_TileSummariesFixture)
+
+BOOST_AUTO_TEST_CASE(GivenElements_WhenGet_ThenSummaryIsReturned) {
+  TileSummaries summaries(SummaryPath);
+
+  summaries.add(QuadKey(1, 0, 0), node, 10);
+  summaries.add(QuadKey(1, 0, 0), way, 20);
+
+  auto summary = summaries.get(QuadKey(1, 0, 0));
+  BOOST_CHECK_EQUAL(summary.nodes, 1);
+  BOOST_CHECK_EQUAL(summary.ways, 1);
+  BOOST_CHECK_EQUAL(summary.vertices, 4);
+  BOOST_CHECK_EQUAL(summary.bytes, 30);
+  BOOST_CHECK_EQUAL(summaries.get(QuadKey(1, 1, 0)).bytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFlushedSummaries_WhenLoaded_ThenResetQuadKeyIsEmpty) {
+  {
+    TileSummaries summaries(SummaryPath);
+    summaries.add(QuadKey(1, 0, 0), node, 10);
+    summaries.add(QuadKey(1, 1, 0), way, 20);
+    summaries.reset(QuadKey(1, 1, 0));
+    summaries.flush();
+  }
+  TileSummaries summaries(SummaryPath);
+
+  auto summary = summaries.get(QuadKey(1, 0, 0));
+  BOOST_CHECK_EQUAL(summary.nodes, 1);
+  BOOST_CHECK_EQUAL(summary.vertices, 1);
+  BOOST_CHECK_EQUAL(summary.bytes, 10);
+  BOOST_CHECK_EQUAL(summaries.get(QuadKey(1, 1, 0)).ways, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
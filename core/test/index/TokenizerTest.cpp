@@ -0,0 +1,77 @@
+#include "entities/Node.hpp"
+#include "index/Tokenizer.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+using namespace utymap::entities;
+using namespace utymap::index;
+using namespace utymap::tests;
+
+namespace {
+struct Index_TokenizerFixture {
+  Index_TokenizerFixture() :
+      dependencyProvider(),
+      stringTable(*dependencyProvider.getStringTable()),
+      tokenizer(stringTable) {}
+
+  std::vector<std::uint32_t> getIds(const std::vector<std::string> &strings) {
+    std::vector<std::uint32_t> ids;
+    for (const auto &str : strings)
+      ids.push_back(stringTable.getId(str));
+    return ids;
+  }
+
+  DependencyProvider dependencyProvider;
+  StringTable &stringTable;
+  Tokenizer tokenizer;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(Index_Tokenizer, Index_TokenizerFixture)
+
+BOOST_AUTO_TEST_CASE(GivenStringWithDelimiters_WhenTokenize_ThenTokensAreResolved) {
+  std::vector<std::uint32_t> ids;
+
+  tokenizer.tokenize(" Unter den_Linden,,77 ", ids);
+
+  auto expected = getIds({ "Unter", "den", "Linden", "77" });
+  BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenString_WhenSplit_ThenTokensAreReturned) {
+  std::vector<std::string> tokens;
+
+  tokenizer.split("addr:street", tokens);
+
+  std::vector<std::string> expected = { "addr", "street" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(tokens.begin(), tokens.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenSearchKeys_WhenTokenizeElement_ThenOnlyMatchingTagsAreTokenized) {
+  auto node = ElementUtils::createElement<Node>(stringTable, 1,
+    { { "name", "Berlin" }, { "addr:city", "Mitte" }, { "building", "yes" }, { "names", "other" } });
+  std::vector<std::uint32_t> ids;
+
+  tokenizer.setSearchKeys("name, addr:*");
+  tokenizer.tokenize(node, ids);
+
+  auto expected = getIds({ "name", "Berlin", "addr", "city", "Mitte" });
+  BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenEmptySearchKeys_WhenTokenizeElement_ThenAllTagsAreTokenized) {
+  auto node = ElementUtils::createElement<Node>(stringTable, 1, { { "name", "Berlin" }, { "building", "yes" } });
+  std::vector<std::uint32_t> ids;
+
+  tokenizer.setSearchKeys("name");
+  tokenizer.setSearchKeys("");
+  tokenizer.tokenize(node, ids);
+
+  auto expected = getIds({ "name", "Berlin", "building", "yes" });
+  BOOST_CHECK_EQUAL_COLLECTIONS(ids.begin(), ids.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
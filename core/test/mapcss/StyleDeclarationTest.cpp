@@ -48,6 +48,24 @@ BOOST_AUTO_TEST_CASE(GivenOneTagOneNumber_WhenDoubleEvaluate_ThenReturnValue) {
   BOOST_CHECK_EQUAL(result, 15);
 }
 
+BOOST_AUTO_TEST_CASE(GivenConstantPrefixAndTag_WhenDoubleEvaluate_ThenOperationsAreAppliedFromLeftToRight) {
+  StyleDeclaration styleDeclaration(0, "eval(\"2 + 3 * tag('building:levels') - 1\")", *dependencyProvider.getStringTable());
+  auto node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+                                                { { "building:levels", "4" } });
+
+  double result = styleDeclaration.evaluate<double>(node.tags, *dependencyProvider.getStringTable());
+
+  BOOST_CHECK_EQUAL(result, 19);
+}
+
+BOOST_AUTO_TEST_CASE(GivenResolvedTagAndMissingTag_WhenDoubleEvaluate_ThenThrowsException) {
+  StyleDeclaration styleDeclaration(0, "eval(\"tag('height') * 1.5\")", *dependencyProvider.getStringTable());
+  auto node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, { { "levels", "4" } });
+
+  BOOST_CHECK_THROW(styleDeclaration.evaluate<double>(node.tags, *dependencyProvider.getStringTable()),
+                    std::domain_error);
+}
+
 BOOST_AUTO_TEST_CASE(GivenRawValue_WhenDoubleEvaluate_ThenThrowsException) {
   StyleDeclaration styleDeclaration(0, "13");
   auto node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
@@ -97,4 +115,17 @@ BOOST_AUTO_TEST_CASE(GivenTwoTagsConcatenatedWithRawString_WhenStringEvaluate_Th
   BOOST_CHECK_EQUAL(result, "place_of_worship_christian");
 }
 
+BOOST_AUTO_TEST_CASE(GivenConstantValuesWithDimension_WhenCreate_ThenNumberIsParsed) {
+  StyleDeclaration meters(0, "2.5m");
+  StyleDeclaration percents(0, "50%");
+  StyleDeclaration plain(0, "0.3");
+
+  BOOST_CHECK(meters.unit()==StyleDeclaration::Unit::Meter);
+  BOOST_CHECK_EQUAL(meters.number(), 2.5);
+  BOOST_CHECK(percents.unit()==StyleDeclaration::Unit::Percent);
+  BOOST_CHECK_EQUAL(percents.number(), 50);
+  BOOST_CHECK(plain.unit()==StyleDeclaration::Unit::None);
+  BOOST_CHECK_EQUAL(plain.number(), 0.3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -88,6 +88,19 @@ BOOST_AUTO_TEST_CASE(GivenSimpleGreaterCondition_WhenHasStyle_ThenReturnsExpecte
       zoomLevel));
 }
 
+BOOST_AUTO_TEST_CASE(GivenGreaterConditionAndNonNumericValue_WhenHasStyleTwice_ThenResultIsSame) {
+  int zoomLevel = 1;
+  setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"height", ">", "-1"}});
+  Node number = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, {{"height", "20"}});
+  Node text = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, {{"height", "tall"}});
+
+  for (int i = 0; i < 2; ++i) {
+    BOOST_CHECK(styleProvider->hasStyle(number, zoomLevel));
+    // NOTE not a number is compared as zero.
+    BOOST_CHECK(styleProvider->hasStyle(text, zoomLevel));
+  }
+}
+
 BOOST_AUTO_TEST_CASE(GivenTwoNamesAndSimpleEqualsCondition_WhenHasStyleForSecondName_ThenReturnTrue) {
   int zoomLevel = 1;
   setSingleSelector(zoomLevel, zoomLevel, {"way", "node"}, {{"amenity", "=", "biergarten"}});
@@ -110,6 +123,20 @@ BOOST_AUTO_TEST_CASE(GivenSimpleEqualsConditionButDifferentZoomLevel_WhenHasStyl
   BOOST_CHECK(!styleProvider->hasStyle(node, 2));
 }
 
+BOOST_AUTO_TEST_CASE(GivenRuleForRangeOfZoomLevels_WhenHasStyle_ThenReturnTrueOnlyInsideRange) {
+  setSingleSelector(1, 19, {"node"}, {{"amenity", "=", "biergarten"}});
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+                                                {
+                                                    std::make_pair("amenity", "biergarten")
+                                                });
+
+  BOOST_CHECK(!styleProvider->hasStyle(node, 0));
+  BOOST_CHECK(styleProvider->hasStyle(node, 1));
+  BOOST_CHECK(styleProvider->hasStyle(node, 10));
+  BOOST_CHECK(styleProvider->hasStyle(node, 19));
+  BOOST_CHECK(!styleProvider->hasStyle(node, 20));
+}
+
 BOOST_AUTO_TEST_CASE(GivenTwoEqualsConditions_WhenHasStyle_ThenReturnTrue) {
   int zoomLevel = 1;
   setSingleSelector(zoomLevel, zoomLevel, {"node"},
@@ -159,6 +186,50 @@ BOOST_AUTO_TEST_CASE(GivenCustomElementRuleOverridesDefault_WhenForElement_ThenS
   BOOST_CHECK(!style.has(dependencyProvider.getStringTable()->getId("key1")));
 }
 
+BOOST_AUTO_TEST_CASE(GivenElementsWithTheSameTagsAndOneWithCustomRule_WhenForElement_ThenOnlyCustomRuleDiffers) {
+  int zoomLevel = 1;
+  setSingleSelector(zoomLevel, zoomLevel, {"node"},
+                    {{"amenity", "=", "biergarten"}},
+                    {{"key1", "value1"}});
+  setSingleSelector(zoomLevel, zoomLevel, {"element"},
+                    {{"id", "=", "7"}},
+                    {{"key2", "value2"}});
+  auto stringTable = dependencyProvider.getStringTable();
+  Node node1 = ElementUtils::createElement<Node>(*stringTable, 1, {std::make_pair("amenity", "biergarten")});
+  Node node2 = ElementUtils::createElement<Node>(*stringTable, 2, {std::make_pair("amenity", "biergarten")});
+  Node custom = ElementUtils::createElement<Node>(*stringTable, 7, {std::make_pair("amenity", "biergarten")});
+  Way way = ElementUtils::createElement<Way>(*stringTable, 3, {std::make_pair("amenity", "biergarten")});
+
+  Style style1 = styleProvider->forElement(node1, zoomLevel);
+  Style style2 = styleProvider->forElement(node2, zoomLevel);
+  Style customStyle = styleProvider->forElement(custom, zoomLevel);
+  Style wayStyle = styleProvider->forElement(way, zoomLevel);
+
+  BOOST_CHECK(style1.has(stringTable->getId("key1"), "value1"));
+  BOOST_CHECK(style2.has(stringTable->getId("key1"), "value1"));
+  BOOST_CHECK(customStyle.has(stringTable->getId("key2"), "value2"));
+  BOOST_CHECK(!customStyle.has(stringTable->getId("key1")));
+  BOOST_CHECK(wayStyle.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenRulesAnchoredByDifferentTags_WhenForElement_ThenLaterRuleOverridesEarlierOne) {
+  int zoomLevel = 1;
+  setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"amenity", "", ""}}, {{"color", "red"}});
+  setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"shop", "=", "bakery"}}, {{"color", "blue"}});
+  setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"amenity", "=", "cafe"}}, {{"color", "green"}});
+  setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"shop", "!=", "bakery"}}, {{"color", "black"}});
+  auto stringTable = dependencyProvider.getStringTable();
+  Node cafe = ElementUtils::createElement<Node>(*stringTable, 1,
+                                                {std::make_pair("amenity", "cafe"), std::make_pair("shop", "bakery")});
+  Node bakery = ElementUtils::createElement<Node>(*stringTable, 2,
+                                                  {std::make_pair("amenity", "pub"), std::make_pair("shop", "bakery")});
+  Node other = ElementUtils::createElement<Node>(*stringTable, 3, {std::make_pair("name", "cafe")});
+
+  BOOST_CHECK(styleProvider->forElement(cafe, zoomLevel).has(stringTable->getId("color"), "green"));
+  BOOST_CHECK(styleProvider->forElement(bakery, zoomLevel).has(stringTable->getId("color"), "blue"));
+  BOOST_CHECK(!styleProvider->hasStyle(other, zoomLevel));
+}
+
 BOOST_AUTO_TEST_CASE(GivenTwoDifferentStyles_WhenConstructed_ThenTheyHaveDifferentTags) {
   int zoomLevel = 1;
   setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"a", "=", "b"}}, {{"k", "v"}});
@@ -183,4 +254,43 @@ BOOST_AUTO_TEST_CASE(GivenTwoEqualStyles_WhenConstructed_ThenTheyHaveTheSameTag)
   BOOST_CHECK_EQUAL(tag1, tag2);
 }
 
+BOOST_AUTO_TEST_CASE(GivenStyleProvider_WhenGetConstIds_ThenIdsMatchStringTable) {
+  setSingleSelector(1, 1, {"node"}, {{"amenity", "=", "biergarten"}});
+  auto stringTable = dependencyProvider.getStringTable();
+
+  const auto &ids = styleProvider->getConstIds();
+
+  BOOST_CHECK_EQUAL(ids.builderKey, stringTable->getId(StyleConsts::BuilderKey()));
+  BOOST_CHECK_EQUAL(ids.terrainLayerKey, stringTable->getId(StyleConsts::TerrainLayerKey()));
+  BOOST_CHECK_EQUAL(ids.stepKey, stringTable->getId(StyleConsts::StepKey()));
+}
+
+BOOST_AUTO_TEST_CASE(GivenEnabledProfiling_WhenGetStyleTwice_ThenRuleStatisticsAreCollected) {
+  int zoomLevel = 1;
+  setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"amenity", "=", "biergarten"}}, {{"k", "v"}});
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+                                                {std::make_pair("amenity", "biergarten")});
+  styleProvider->enableProfiling(true);
+
+  styleProvider->forElement(node, zoomLevel);
+  styleProvider->forElement(node, zoomLevel);
+
+  auto profile = styleProvider->getProfile();
+  BOOST_CHECK(profile.find("{\"lod\":1,\"elements\":2,\"matches\":1,") != std::string::npos);
+  BOOST_CHECK(profile.find("{\"selector\":\"node|z1[amenity=biergarten]\",\"evaluations\":1,"
+                           "\"matches\":1,\"elements\":2}") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenDisabledProfiling_WhenGetStyle_ThenRuleStatisticsAreEmpty) {
+  int zoomLevel = 1;
+  setSingleSelector(zoomLevel, zoomLevel, {"node"}, {{"amenity", "=", "biergarten"}}, {{"k", "v"}});
+  Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0,
+                                                {std::make_pair("amenity", "biergarten")});
+
+  styleProvider->forElement(node, zoomLevel);
+
+  auto profile = styleProvider->getProfile();
+  BOOST_CHECK(profile.find("\"evaluations\":0,\"matches\":0,\"elements\":0}") != std::string::npos);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
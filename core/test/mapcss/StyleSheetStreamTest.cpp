@@ -0,0 +1,84 @@
+#include "entities/Node.hpp"
+#include "mapcss/MapCssParser.hpp"
+#include "mapcss/StyleProvider.hpp"
+#include "mapcss/StyleSheetStream.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include "config.hpp"
+#include "test_utils/DependencyProvider.hpp"
+#include "test_utils/ElementUtils.hpp"
+
+#include <fstream>
+#include <sstream>
+
+using namespace utymap::entities;
+using namespace utymap::mapcss;
+using namespace utymap::tests;
+
+namespace {
+const std::string stylesheetStr = "node|z16[height] { height: eval(\"tag('height') * 2\"); }"
+    "area|z16[building] { color: gradient(#dcdcdc 0%, #c0c0c0 10%, #808080); }";
+
+struct MapCss_StyleSheetStreamFixture {
+  std::string readImportFile() {
+    std::ifstream file(TEST_MAPCSS_PATH "import.mapcss");
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  }
+
+  DependencyProvider dependencyProvider;
+  std::stringstream stream;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(MapCss_StyleSheetStream, MapCss_StyleSheetStreamFixture)
+
+BOOST_AUTO_TEST_CASE(GivenStyleSheetWithImports_WhenWriteAndRead_ThenReturnsSameContent) {
+  auto content = readImportFile();
+  StyleSheet original = MapCssParser(TEST_MAPCSS_PATH).parse(content);
+  StyleSheetStream::write(stream, content, original);
+  StyleSheet result;
+
+  BOOST_CHECK(StyleSheetStream::read(stream, content, result));
+
+  BOOST_CHECK_EQUAL(result.rules.size(), original.rules.size());
+  BOOST_CHECK_EQUAL(result.textures.size(), 1);
+  BOOST_CHECK_EQUAL(result.lsystems.size(), 2);
+  BOOST_CHECK_EQUAL(result.sources.size(), 5);
+  BOOST_CHECK_EQUAL(result.rules[0].declarations[0].value, original.rules[0].declarations[0].value);
+}
+
+BOOST_AUTO_TEST_CASE(GivenChangedContent_WhenRead_ThenReturnsFalse) {
+  StyleSheet original = MapCssParser().parse(stylesheetStr);
+  StyleSheetStream::write(stream, stylesheetStr, original);
+  StyleSheet result;
+
+  BOOST_CHECK(!StyleSheetStream::read(stream, stylesheetStr + " ", result));
+  BOOST_CHECK(result.rules.empty());
+}
+
+BOOST_AUTO_TEST_CASE(GivenExpressionAndGradient_WhenRead_ThenTheyArePrecompiled) {
+  StyleSheet original = MapCssParser().parse(stylesheetStr);
+  StyleSheetStream::write(stream, stylesheetStr, original);
+  StyleSheet result;
+
+  StyleSheetStream::read(stream, stylesheetStr, result);
+
+  BOOST_CHECK_EQUAL(result.expressions.size(), 1);
+  BOOST_CHECK_EQUAL(result.gradients.size(), 1);
+  BOOST_CHECK_EQUAL(result.gradients.begin()->second.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenReadStyleSheet_WhenGetStyle_ThenEvaluatesPrecompiledExpression) {
+  StyleSheet original = MapCssParser().parse(stylesheetStr);
+  StyleSheetStream::write(stream, stylesheetStr, original);
+  StyleSheet result;
+  StyleSheetStream::read(stream, stylesheetStr, result);
+  auto node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(), 0, {{"height", "3"}});
+
+  Style style = dependencyProvider.getStyleProvider(result)->forElement(node, 16);
+
+  BOOST_CHECK_EQUAL(style.getValue("height"), 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
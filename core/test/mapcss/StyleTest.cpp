@@ -21,7 +21,8 @@ const std::string stylesheet = "way|z16[meters] { width: 10m; }"
   "node|z16[place] { builder: place; }"
   "node|z16[place=stop] { builder: stop; }"
   "node|z16[amenity] { builder: amenity; }"
-  "node|z16[amenity=bar] { builder: amenity; }";
+  "node|z16[amenity=bar] { builder: amenity; }"
+  "node|z16[height] { height: eval(\"tag('height')\"); }";
 struct MapCss_StyleFixture {
   DependencyProvider dependencyProvider;
   BoundingBox boundingBox = GeoUtils::quadKeyToBoundingBox(QuadKey(16, 35205, 21489));
@@ -88,4 +89,17 @@ BOOST_AUTO_TEST_CASE(GivenBuilderDeclarations_WhenGetBuilders_ThenReturnsUnique)
   BOOST_CHECK_EQUAL(builders.at(0), "amenity");
 }
 
+BOOST_AUTO_TEST_CASE(GivenCopiedStyle_WhenElementIsDestroyed_ThenEvaluatesOwnTags) {
+  int lod = 16;
+  std::unique_ptr<Style> style;
+  {
+    Node node = ElementUtils::createElement<Node>(*dependencyProvider.getStringTable(),
+      0, { std::make_pair("height", "12") });
+    Style bound = dependencyProvider.getStyleProvider(stylesheet)->forElement(node, lod);
+    style = utymap::utils::make_unique<Style>(bound);
+  }
+
+  BOOST_CHECK_EQUAL(style->getValue("height"), 12);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
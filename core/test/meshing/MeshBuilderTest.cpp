@@ -30,6 +30,21 @@ struct Meshing_MeshingFixture {
   MeshBuilder::GeometryOptions geometryOptions;
   MeshBuilder::AppearanceOptions appearanceOptions;
 };
+
+/// Returns zero elevation without telling that it is flat, so general build path is used.
+class ZeroElevationProvider final : public FlatElevationProvider {
+ public:
+  bool isFlat() const override {
+    return false;
+  }
+};
+
+/// Returns signed area of mesh triangle.
+double triangleArea(const Mesh &mesh, std::size_t triangle) {
+  const auto &v = mesh.vertices;
+  int a = mesh.triangles[triangle*3], b = mesh.triangles[triangle*3 + 1], c = mesh.triangles[triangle*3 + 2];
+  return ((v[b*3] - v[a*3])*(v[c*3 + 1] - v[a*3 + 1]) - (v[b*3 + 1] - v[a*3 + 1])*(v[c*3] - v[a*3]))/2;
+}
 }
 
 BOOST_FIXTURE_TEST_SUITE(Meshing_MeshBuilder, Meshing_MeshingFixture)
@@ -149,4 +164,75 @@ BOOST_AUTO_TEST_CASE(GivenSimpleSquareWithScale_WhenAddPolygon_ThenScaledTexture
   BOOST_CHECK_EQUAL(mesh.vertices.size()*2/3, mesh.uvs.size());
 }
 
+BOOST_AUTO_TEST_CASE(GivenPolygonWithHoleAndNoArea_WhenAddPolygon_ThenCoversItWithoutNewPoints) {
+  Mesh mesh("");
+  Polygon polygon(12, 1);
+  polygon.addContour(std::vector<DPoint> {{0, 0}, {10, 0}, {10, 10}, {5, 4}, {0, 10}});
+  polygon.addHole(std::vector<DPoint> {{4, 1}, {6, 1}, {6, 2}, {4, 2}});
+
+  builder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+
+  BOOST_CHECK_EQUAL(mesh.vertices.size()/3, 9);
+  BOOST_REQUIRE_EQUAL(mesh.triangles.size()/3, 9);
+  double area = 0;
+  for (std::size_t i = 0; i < mesh.triangles.size()/3; ++i) {
+    BOOST_CHECK(triangleArea(mesh, i) < 0);
+    area += triangleArea(mesh, i);
+  }
+  BOOST_CHECK_CLOSE(area, -(70 - 2), 1E-9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPolygons_WhenAddPolygons_ThenMeshIsTheSameAsForAddPolygon) {
+  std::vector<Polygon> polygons;
+  for (int i = 0; i < 3; ++i) {
+    polygons.emplace_back(4, 0);
+    polygons.back().addContour(std::vector<DPoint> {{i*10., 0}, {i*10. + 5, 0}, {i*10. + 5, 5}, {i*10., 5}});
+  }
+  geometryOptions.area = 1;
+  Mesh expected("");
+  for (auto &polygon : polygons)
+    builder.addPolygon(expected, polygon, geometryOptions, appearanceOptions);
+
+  Mesh mesh("");
+  builder.addPolygons(mesh, polygons, geometryOptions, appearanceOptions);
+
+  BOOST_CHECK(mesh.vertices==expected.vertices);
+  BOOST_CHECK(mesh.triangles==expected.triangles);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFlatProvider_WhenAddPolygonAndPlane_ThenMeshIsTheSameAsForGeneralPath) {
+  ZeroElevationProvider zeroProvider;
+  MeshBuilder generalBuilder(utymap::QuadKey(1, 1, 0), zeroProvider);
+  Polygon polygon(4, 0);
+  polygon.addContour(std::vector<DPoint> {{0, 0}, {10, 0}, {10, 10}, {0, 10}});
+  geometryOptions.area = 5;
+  geometryOptions.heightOffset = 2;
+  Mesh expected(""), mesh("");
+
+  generalBuilder.addPolygon(expected, polygon, geometryOptions, appearanceOptions);
+  generalBuilder.addPlane(expected, DPoint(0, 0), DPoint(10, 0), geometryOptions, appearanceOptions);
+  builder.addPolygon(mesh, polygon, geometryOptions, appearanceOptions);
+  builder.addPlane(mesh, DPoint(0, 0), DPoint(10, 0), geometryOptions, appearanceOptions);
+
+  BOOST_CHECK(mesh.vertices==expected.vertices);
+  BOOST_CHECK(mesh.triangles==expected.triangles);
+  BOOST_CHECK(mesh.uvs==expected.uvs);
+}
+
+BOOST_AUTO_TEST_CASE(GivenGridWithMask_WhenAddGrid_ThenVerticesAreShared) {
+  Mesh mesh("");
+  std::vector<bool> cells {true, true, false, true};
+
+  builder.addGrid(mesh, {0, 1, 2}, {0, 1, 2}, cells, geometryOptions, appearanceOptions);
+
+  BOOST_CHECK_EQUAL(mesh.vertices.size()/3, 8);
+  BOOST_REQUIRE_EQUAL(mesh.triangles.size()/3, 6);
+  double area = 0;
+  for (std::size_t i = 0; i < mesh.triangles.size()/3; ++i) {
+    BOOST_CHECK(triangleArea(mesh, i) < 0);
+    area += triangleArea(mesh, i);
+  }
+  BOOST_CHECK_CLOSE(area, -3, 1E-9);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
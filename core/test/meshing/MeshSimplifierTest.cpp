@@ -0,0 +1,72 @@
+#include "math/MeshSimplifier.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::math;
+
+namespace {
+/// Creates grid of size x size cells with given height function.
+template<typename Height>
+void createGrid(Mesh &mesh, int size, const Height &height) {
+  for (int y = 0; y <= size; ++y)
+    for (int x = 0; x <= size; ++x) {
+      mesh.vertices.insert(mesh.vertices.end(), {double(x), double(y), height(x, y)});
+      mesh.colors.push_back(0);
+      mesh.uvs.insert(mesh.uvs.end(), {0, 0});
+    }
+  for (int y = 0; y < size; ++y)
+    for (int x = 0; x < size; ++x) {
+      int a = y*(size + 1) + x, b = a + 1, c = a + size + 2, d = a + size + 1;
+      mesh.triangles.insert(mesh.triangles.end(), {a, c, b, a, d, c});
+    }
+  mesh.uvMap.insert(mesh.uvMap.end(), {static_cast<int>(mesh.uvs.size()), 0, 1, 1, 0, 0, 1, 1});
+}
+
+bool hasVertex(const Mesh &mesh, double x, double y) {
+  for (std::size_t i = 0; i < mesh.vertices.size(); i += 3)
+    if (mesh.vertices[i]==x && mesh.vertices[i + 1]==y) return true;
+  return false;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_MeshSimplifier)
+
+BOOST_AUTO_TEST_CASE(GivenFlatGrid_WhenSimplify_ThenOnlyBoundaryVerticesStay) {
+  Mesh source(""), mesh("");
+  createGrid(source, 4, [](int, int) { return 0.; });
+
+  MeshSimplifier().simplify(source, mesh, 0.1);
+
+  BOOST_CHECK_EQUAL(mesh.vertices.size()/3, 16);
+  BOOST_CHECK_EQUAL(mesh.triangles.size()/3, 14);
+  BOOST_CHECK_EQUAL(mesh.colors.size(), 16);
+  BOOST_REQUIRE_EQUAL(mesh.uvMap.size(), 8);
+  BOOST_CHECK_EQUAL(mesh.uvMap[0], 32);
+  for (int i = 0; i <= 4; ++i) {
+    BOOST_CHECK(hasVertex(mesh, i, 0) && hasVertex(mesh, i, 4));
+    BOOST_CHECK(hasVertex(mesh, 0, i) && hasVertex(mesh, 4, i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenGridWithPeak_WhenSimplify_ThenPeakStays) {
+  Mesh source(""), mesh("");
+  createGrid(source, 4, [](int x, int y) { return x==2 && y==2 ? 1. : 0.; });
+
+  MeshSimplifier().simplify(source, mesh, 0.1);
+
+  BOOST_CHECK(hasVertex(mesh, 2, 2));
+  BOOST_CHECK(mesh.triangles.size() < source.triangles.size());
+}
+
+BOOST_AUTO_TEST_CASE(GivenZeroError_WhenSimplify_ThenMeshIsCopied) {
+  Mesh source(""), mesh("");
+  createGrid(source, 2, [](int, int) { return 0.; });
+
+  MeshSimplifier().simplify(source, mesh, 0);
+
+  BOOST_CHECK(mesh.vertices==source.vertices);
+  BOOST_CHECK(mesh.triangles==source.triangles);
+  BOOST_CHECK(mesh.uvMap==source.uvMap);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,78 @@
+#include "math/PointKernels.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::math;
+
+namespace {
+const double Precision = 1E-9;
+
+/// Returns points of counter clockwise square with given size.
+PointArrays<double> createSquare(double size) {
+  PointArrays<double> points;
+  points.assign({ Vector2(0, 0), Vector2(size, 0), Vector2(size, size), Vector2(0, size) });
+  return points;
+}
+}
+
+BOOST_AUTO_TEST_SUITE(Meshing_PointKernels)
+
+BOOST_AUTO_TEST_CASE(GivenInterleavedPoints_WhenDeinterleaveAndInterleave_ThenTheyAreTheSame) {
+  const double points[] = { 1, 2, 3, 4, 5, 6 };
+  PointArrays<double> arrays;
+  double result[6];
+
+  arrays.assign(points, 3);
+  PointKernels::interleave(arrays.xs.data(), arrays.ys.data(), arrays.size(), result);
+
+  BOOST_CHECK_EQUAL(arrays.xs[2], 5);
+  BOOST_CHECK_EQUAL(arrays.ys[2], 6);
+  BOOST_CHECK_EQUAL_COLLECTIONS(result, result + 6, points, points + 6);
+}
+
+BOOST_AUTO_TEST_CASE(GivenCounterClockwiseSquare_WhenSignedArea_ThenItIsPositive) {
+  auto points = createSquare(2);
+
+  BOOST_CHECK_CLOSE(PointKernels::signedArea(points.xs.data(), points.ys.data(), points.size()), 4, Precision);
+  BOOST_CHECK_CLOSE(PointKernels::signedArea(points.ys.data(), points.xs.data(), points.size()), -4, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRingWithManyFloatPoints_WhenSignedArea_ThenAllEdgesAreCounted) {
+  PointArrays<float> points;
+  std::vector<Vector2> contour;
+  for (int i = 0; i <= 10; ++i)
+    contour.push_back(Vector2(i, 0));
+  for (int i = 10; i >= 0; --i)
+    contour.push_back(Vector2(i, 1));
+  points.assign(contour);
+
+  BOOST_CHECK_CLOSE(PointKernels::signedArea(points.xs.data(), points.ys.data(), points.size()), 10, Precision);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPoints_WhenExpand_ThenRectangleContainsThem) {
+  auto points = createSquare(2);
+  Rectangle rectangle(1, -1, 1, -1);
+
+  PointKernels::expand(points.xs.data(), points.ys.data(), points.size(), rectangle);
+
+  BOOST_CHECK_EQUAL(rectangle.xMin, 0);
+  BOOST_CHECK_EQUAL(rectangle.yMin, -1);
+  BOOST_CHECK_EQUAL(rectangle.xMax, 2);
+  BOOST_CHECK_EQUAL(rectangle.yMax, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenPoints_WhenTransformInPlaceAndMapUv_ThenOriginAndScaleAreApplied) {
+  auto points = createSquare(2);
+  std::vector<double> uvs(points.size()*2);
+
+  PointKernels::transform(points.xs.data(), points.ys.data(), points.size(), Vector2(1, 1), Vector2(2, 3),
+                          points.xs.data(), points.ys.data());
+  PointKernels::mapUv(points.xs.data(), points.ys.data(), points.size(), Vector2(-2, -3), Vector2(0.5, 0.25), uvs.data());
+
+  BOOST_CHECK_EQUAL(points.xs[2], 2);
+  BOOST_CHECK_EQUAL(points.ys[2], 3);
+  BOOST_CHECK_EQUAL(uvs[4], 2);
+  BOOST_CHECK_EQUAL(uvs[5], 1.5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
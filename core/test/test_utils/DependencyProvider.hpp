@@ -23,6 +23,8 @@ class DependencyProvider {
 
     bool hasError = std::remove("string.idx") > 0;
     hasError = std::remove("string.dat") > 0 || hasError;
+    hasError = std::remove("string.hsh") > 0 || hasError;
+    std::remove("string.sld");
 
     if (hasError)
       std::cout << "Error while deleting index files.";
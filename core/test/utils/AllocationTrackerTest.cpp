@@ -0,0 +1,35 @@
+#include "utils/AllocationTracker.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(Utils_AllocationTracker)
+
+BOOST_AUTO_TEST_CASE(GivenNestedScopes_WhenRecord_ThenAllocationIsCountedInInnerSubsystem) {
+  AllocationTracker::reset();
+
+  {
+    AllocationTracker::Scope build(AllocationTracker::Subsystem::Build);
+    {
+      AllocationTracker::Scope style(AllocationTracker::Subsystem::Style);
+      AllocationTracker::record(16);
+    }
+    AllocationTracker::record(8);
+  }
+
+  BOOST_CHECK_EQUAL(AllocationTracker::getCount(AllocationTracker::Subsystem::Style), 1);
+  BOOST_CHECK_EQUAL(AllocationTracker::getBytes(AllocationTracker::Subsystem::Style), 16);
+  BOOST_CHECK_EQUAL(AllocationTracker::getCount(AllocationTracker::Subsystem::Build), 1);
+  BOOST_CHECK_EQUAL(AllocationTracker::getBytes(AllocationTracker::Subsystem::Build), 8);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoScope_WhenRecord_ThenAllocationIsNotCounted) {
+  AllocationTracker::reset();
+
+  AllocationTracker::record(16);
+
+  BOOST_CHECK(AllocationTracker::toJson().find("\"count\":1") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,10 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 using namespace utymap;
 using namespace utymap::utils;
 
@@ -58,6 +62,47 @@ BOOST_AUTO_TEST_CASE(GivenQuadKeyAtNineteenLod_WhenToString_ThenReturnValidCode)
   BOOST_CHECK_EQUAL("1202102332220103020", code);
 }
 
+BOOST_AUTO_TEST_CASE(GivenBufferWithPrefix_WhenAppendQuadKey_ThenAppendsCode) {
+  std::string buffer = "path/";
+
+  GeoUtils::appendQuadKey(QuadKey(19, 281640, 171914), buffer);
+  GeoUtils::appendQuadKey(QuadKey(0, 0, 0), buffer);
+
+  BOOST_CHECK_EQUAL("path/1202102332220103020", buffer);
+}
+
+BOOST_AUTO_TEST_CASE(GivenQuadKeyAtNineteenLod_WhenPackCode_ThenRestoresQuadKey) {
+  QuadKey quadKey(19, 281640, 171914);
+
+  QuadKey restored = QuadKey::fromCode(quadKey.code());
+
+  BOOST_CHECK(restored == quadKey);
+  BOOST_CHECK(QuadKey::fromCode(QuadKey(QuadKey::MaxLevelOfDetail, (1 << 29) - 1, 1).code()) ==
+      QuadKey(QuadKey::MaxLevelOfDetail, (1 << 29) - 1, 1));
+  BOOST_CHECK(QuadKey(19, 171914, 281640).code() != quadKey.code());
+  BOOST_CHECK(QuadKey(18, 281640, 171914).code() != quadKey.code());
+}
+
+BOOST_AUTO_TEST_CASE(GivenQuadKey_WhenGetParentAndChildren_ThenCodesMatchString) {
+  QuadKey quadKey = GeoUtils::stringToQuadKey("120210");
+
+  BOOST_CHECK_EQUAL(GeoUtils::quadKeyToString(quadKey.parent()), "12021");
+  for (int digit = 0; digit < 4; ++digit) {
+    auto child = quadKey.child(digit);
+    BOOST_CHECK_EQUAL(GeoUtils::quadKeyToString(child), "120210" + std::to_string(digit));
+    BOOST_CHECK(child.parent() == quadKey);
+  }
+  BOOST_CHECK(quadKey.neighbour(1, -1) == QuadKey(6, quadKey.tileX + 1, quadKey.tileY - 1));
+}
+
+BOOST_AUTO_TEST_CASE(GivenCodeAtNineteenLod_WhenToQuadKey_ThenReturnValidQuadKey) {
+  QuadKey quadKey = GeoUtils::stringToQuadKey("1202102332220103020");
+
+  BOOST_CHECK_EQUAL(quadKey.levelOfDetail, 19);
+  BOOST_CHECK_EQUAL(quadKey.tileX, 281640);
+  BOOST_CHECK_EQUAL(quadKey.tileY, 171914);
+}
+
 BOOST_AUTO_TEST_CASE(GivenBboxAtLodOne_WhenVisitTileRange_VisitsOneTile) {
   BoundingBox bbox(GeoCoordinate(1, 1), GeoCoordinate(2, 2));
   int count = 0;
@@ -84,4 +129,56 @@ BOOST_AUTO_TEST_CASE(GivenBboxAtLodOne_WhenVisitTileRange_VisitsTwoTiles) {
   BOOST_CHECK_EQUAL(2, count);
 }
 
+BOOST_AUTO_TEST_CASE(GivenConcavePolygon_WhenIsPointInPolygon_ThenReturnsCorrectResult) {
+  // U shape in both orientations.
+  std::vector<GeoCoordinate> polygon = { {0, 0}, {0, 3}, {3, 3}, {3, 2}, {1, 2}, {1, 1}, {3, 1}, {3, 0} };
+  std::vector<GeoCoordinate> reversed(polygon.rbegin(), polygon.rend());
+
+  for (const auto &coordinates : { polygon, reversed }) {
+    BOOST_CHECK(GeoUtils::isPointInPolygon(GeoCoordinate(0.5, 0.5), coordinates.begin(), coordinates.end()));
+    BOOST_CHECK(GeoUtils::isPointInPolygon(GeoCoordinate(2.5, 2.5), coordinates.begin(), coordinates.end()));
+    BOOST_CHECK(!GeoUtils::isPointInPolygon(GeoCoordinate(2, 1.5), coordinates.begin(), coordinates.end()));
+    BOOST_CHECK(!GeoUtils::isPointInPolygon(GeoCoordinate(4, 1), coordinates.begin(), coordinates.end()));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenBbox_WhenVisitTileRange_ThenTileBboxesMatchQuadKeyBboxes) {
+  BoundingBox bbox(GeoCoordinate(52.5, 13.3), GeoCoordinate(52.6, 13.5));
+  int count = 0;
+
+  GeoUtils::visitTileRange(bbox, 12, [&](const QuadKey &quadKey, const BoundingBox &tileBbox) {
+    // NOTE second call is served from cache.
+    for (int i = 0; i < 2; ++i) {
+      BoundingBox expected = GeoUtils::quadKeyToBoundingBox(quadKey);
+      BOOST_CHECK_EQUAL(expected.minPoint.latitude, tileBbox.minPoint.latitude);
+      BOOST_CHECK_EQUAL(expected.minPoint.longitude, tileBbox.minPoint.longitude);
+      BOOST_CHECK_EQUAL(expected.maxPoint.latitude, tileBbox.maxPoint.latitude);
+      BOOST_CHECK_EQUAL(expected.maxPoint.longitude, tileBbox.maxPoint.longitude);
+    }
+    count++;
+  });
+
+  BOOST_CHECK_EQUAL(count, 9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenBbox_WhenVisitTileRangeInMortonOrder_ThenVisitsSameTilesInQuadKeyCodeOrder) {
+  BoundingBox bbox(GeoCoordinate(52.3, 13.1), GeoCoordinate(52.7, 13.8));
+  std::vector<std::string> rows, morton;
+
+  GeoUtils::visitTileRange(bbox, 12, [&](const QuadKey &quadKey, const BoundingBox &) {
+    rows.push_back(GeoUtils::quadKeyToString(quadKey));
+  });
+  GeoUtils::visitTileRange(bbox, 12, GeoUtils::TileOrder::Morton, [&](const QuadKey &quadKey, const BoundingBox &tileBbox) {
+    BoundingBox expected = GeoUtils::quadKeyToBoundingBox(quadKey);
+    BOOST_CHECK_EQUAL(expected.minPoint.latitude, tileBbox.minPoint.latitude);
+    BOOST_CHECK_EQUAL(expected.maxPoint.longitude, tileBbox.maxPoint.longitude);
+    morton.push_back(GeoUtils::quadKeyToString(quadKey));
+  });
+
+  BOOST_CHECK_GT(rows.size(), 4);
+  BOOST_CHECK(std::is_sorted(morton.begin(), morton.end()));
+  std::sort(rows.begin(), rows.end());
+  BOOST_CHECK(rows==morton);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -57,4 +57,18 @@ BOOST_AUTO_TEST_CASE(GivePointIsOutsidePolygon_WhenIsPointInPolygon_ThenReturnsF
   BOOST_CHECK(!isPointInPolygon({11, 11}, {{0, 0}, {0, 10}, {10, 10}, {10, 0}}));
 }
 
+BOOST_AUTO_TEST_CASE(GivenPolylineWithSmallDeviations_WhenSimplify_ThenOnlyBigDeviationsAreKept) {
+  std::vector<GeoCoordinate> coordinates = {
+      {0, 0}, {0.01, 1}, {0, 2}, {1, 2}, {2, 2.01}, {3, 2}
+  };
+
+  auto result = simplify(coordinates, 0.1);
+
+  BOOST_REQUIRE_EQUAL(result.size(), 3);
+  BOOST_CHECK(result[0]==coordinates[0]);
+  BOOST_CHECK(result[1]==coordinates[2]);
+  BOOST_CHECK(result[2]==coordinates[5]);
+  BOOST_CHECK_EQUAL(simplify(coordinates, 0.001).size(), coordinates.size());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
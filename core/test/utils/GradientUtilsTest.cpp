@@ -3,6 +3,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 using namespace utymap::mapcss;
 using namespace utymap::utils;
 
@@ -52,4 +54,26 @@ BOOST_AUTO_TEST_CASE(GivenColorString_WhenParseGradient_ThenReturnValid) {
   BOOST_CHECK_EQUAL(gradient->evaluate(0), 0xEC8859FF);
 }
 
+BOOST_AUTO_TEST_CASE(GivenTwoColorGradient_WhenEvaluateBetweenStops_ThenColorIsInterpolated) {
+  auto gradient = GradientUtils::parseGradient("gradient(#000000, #ffffff)");
+
+  for (int i = 0; i <= 100; ++i) {
+    double time = i/100.;
+    Color color = gradient->evaluate(time);
+    BOOST_CHECK_SMALL(color.r - 255*time, 1.5);
+    BOOST_CHECK_EQUAL(color.r, color.g);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenTimes_WhenEvaluateInBatch_ThenColorsAreTheSameAsForSingleTime) {
+  auto gradient = GradientUtils::parseGradient("gradient(#0fffff, #099999 50%, #033333 70%, #000000)");
+  std::vector<double> times {-0.5, 0, 0.1, 0.33, 0.5, 0.7, 0.99, 1, 1.5};
+  std::vector<int> colors(times.size());
+
+  gradient->evaluate(times.data(), colors.data(), times.size());
+
+  for (std::size_t i = 0; i < times.size(); ++i)
+    BOOST_CHECK_EQUAL(static_cast<std::uint32_t>(colors[i]), static_cast<std::uint32_t>(gradient->evaluate(times[i])));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,48 @@
+#include "utils/IdSet.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(Utils_IdSet)
+
+BOOST_AUTO_TEST_CASE(GivenIds_WhenInsert_ThenOnlyNewIdsAreInserted) {
+  IdSet ids;
+
+  BOOST_CHECK(ids.insert(0));
+  BOOST_CHECK(ids.insert(42));
+  BOOST_CHECK(!ids.insert(42));
+  BOOST_CHECK(!ids.insert(0));
+
+  BOOST_CHECK_EQUAL(ids.size(), 2);
+  BOOST_CHECK(ids.contains(0));
+  BOOST_CHECK(ids.contains(42));
+  BOOST_CHECK(!ids.contains(7));
+}
+
+BOOST_AUTO_TEST_CASE(GivenManyIds_WhenInsert_ThenAllAreFound) {
+  IdSet ids;
+  for (std::uint64_t id = 1; id <= 10000; ++id)
+    ids.insert(id * 3);
+
+  BOOST_CHECK_EQUAL(ids.size(), 10000);
+  for (std::uint64_t id = 1; id <= 10000; ++id) {
+    BOOST_CHECK(ids.contains(id * 3));
+    BOOST_CHECK(!ids.contains(id * 3 + 1));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GivenSet_WhenClear_ThenItIsEmpty) {
+  IdSet ids;
+  ids.reserve(100);
+  ids.insert(0);
+  ids.insert(5);
+
+  ids.clear();
+
+  BOOST_CHECK_EQUAL(ids.size(), 0);
+  BOOST_CHECK(!ids.contains(0));
+  BOOST_CHECK(!ids.contains(5));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
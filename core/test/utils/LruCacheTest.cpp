@@ -45,4 +45,36 @@ BOOST_AUTO_TEST_CASE(GivenLruCacheWithValue_WhenClear_ValueIsUsed) {
   BOOST_CHECK_EQUAL(value->data, "my string 0");
 }
 
+BOOST_AUTO_TEST_CASE(GivenLruCacheWithValues_WhenTrim_LeastRecentlyUsedAreRemoved) {
+  LruCache<int, CachedValue> cache;
+  cache.put(0, CachedValue("0123456789"));
+  cache.put(1, CachedValue("01234"));
+  cache.put(2, CachedValue("0123"));
+  cache.get(0);
+  auto sizeOf = [](const CachedValue &value) { return value.data.size(); };
+
+  auto size = cache.trim(15, sizeOf);
+
+  BOOST_CHECK_EQUAL(size, 14);
+  BOOST_CHECK_EQUAL(cache.weigh(sizeOf), 14);
+  BOOST_CHECK(cache.exists(0));
+  BOOST_CHECK(!cache.exists(1));
+  BOOST_CHECK(cache.exists(2));
+}
+
+BOOST_AUTO_TEST_CASE(GivenLruCacheWithValues_WhenSetMaxSize_LeastRecentlyUsedAreRemoved) {
+  LruCache<int, CachedValue> cache;
+  cache.put(0, CachedValue("0"));
+  cache.put(1, CachedValue("1"));
+  cache.put(2, CachedValue("2"));
+  cache.get(0);
+
+  cache.setMaxSize(2);
+  cache.put(3, CachedValue("3"));
+
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(cache.exists(0));
+  BOOST_CHECK(cache.exists(3));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
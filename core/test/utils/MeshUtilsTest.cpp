@@ -0,0 +1,79 @@
+#include "utils/MeshUtils.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::math;
+using namespace utymap::utils;
+
+namespace {
+/// Adds quad as two triangles with own vertices.
+void addQuad(Mesh &mesh, double offset) {
+  const std::vector<double> points {0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1};
+  for (std::size_t i = 0; i < points.size(); i += 2) {
+    int index = static_cast<int>(mesh.vertices.size()/3);
+    mesh.vertices.insert(mesh.vertices.end(), {points[i] + offset, points[i + 1], 0});
+    mesh.uvs.insert(mesh.uvs.end(), {points[i], points[i + 1]});
+    mesh.colors.push_back(0);
+    mesh.triangles.push_back(index);
+  }
+}
+
+/// Adds texture range which ends at current size of uvs.
+void addUvMapEntry(Mesh &mesh, int textureId) {
+  mesh.uvMap.insert(mesh.uvMap.end(), {static_cast<int>(mesh.uvs.size()), textureId, 1, 1, 0, 0, 1, 1});
+}
+}
+
+BOOST_AUTO_TEST_SUITE(Utils_MeshUtils)
+
+BOOST_AUTO_TEST_CASE(GivenMeshWithDuplicateVertices_WhenWeld_ThenVerticesAreMerged) {
+  Mesh source("");
+  addQuad(source, 0);
+  addUvMapEntry(source, 0);
+  Mesh mesh("");
+
+  weldMesh(source, mesh);
+
+  BOOST_CHECK_EQUAL(mesh.vertices.size()/3, 4);
+  BOOST_CHECK_EQUAL(mesh.uvs.size(), 8);
+  BOOST_CHECK_EQUAL(mesh.colors.size(), 4);
+  BOOST_CHECK_EQUAL(mesh.triangles.size(), 6);
+  BOOST_REQUIRE_EQUAL(mesh.uvMap.size(), 8);
+  BOOST_CHECK_EQUAL(mesh.uvMap[0], 8);
+}
+
+BOOST_AUTO_TEST_CASE(GivenDuplicateVerticesInDifferentTextureRanges_WhenWeld_ThenTheyAreNotMerged) {
+  Mesh source("");
+  addQuad(source, 0);
+  addUvMapEntry(source, 0);
+  addQuad(source, 0);
+  addUvMapEntry(source, 1);
+  Mesh mesh("");
+
+  weldMesh(source, mesh);
+
+  BOOST_CHECK_EQUAL(mesh.vertices.size()/3, 8);
+  BOOST_CHECK_EQUAL(mesh.triangles.size(), 12);
+  BOOST_REQUIRE_EQUAL(mesh.uvMap.size(), 16);
+  BOOST_CHECK_EQUAL(mesh.uvMap[0], 8);
+  BOOST_CHECK_EQUAL(mesh.uvMap[8], 16);
+  BOOST_CHECK_EQUAL(mesh.uvMap[9], 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenDegenerateTriangle_WhenWeld_ThenItIsRemoved) {
+  Mesh source("");
+  addQuad(source, 0);
+  source.vertices.insert(source.vertices.end(), {0, 0, 0, 0, 0, 0, 1, 1, 0});
+  source.uvs.insert(source.uvs.end(), {0, 0, 0, 0, 1, 1});
+  source.colors.insert(source.colors.end(), {0, 0, 0});
+  source.triangles.insert(source.triangles.end(), {6, 7, 8});
+  addUvMapEntry(source, 0);
+  Mesh mesh("");
+
+  weldMesh(source, mesh);
+
+  BOOST_CHECK_EQUAL(mesh.vertices.size()/3, 4);
+  BOOST_CHECK_EQUAL(mesh.triangles.size(), 6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,26 @@
+#include "utils/Metrics.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(Utils_Metrics)
+
+BOOST_AUTO_TEST_CASE(GivenCounter_WhenAdd_ThenValueIsIncreased) {
+  auto value = Metrics::get(Metrics::Counter::ElevationLoads);
+
+  Metrics::add(Metrics::Counter::ElevationLoads, 3);
+
+  BOOST_CHECK_EQUAL(Metrics::get(Metrics::Counter::ElevationLoads), value + 3);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRecordedLatency_WhenToJson_ThenItIsCountedInItsBucket) {
+  Metrics::reset();
+
+  Metrics::record(Metrics::Latency::Triangulation, std::chrono::microseconds(5));
+
+  auto json = Metrics::toJson();
+  BOOST_CHECK(json.find("\"triangulation\":{\"count\":1,\"sum\":5,\"buckets\":[0,0,0,1,0") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
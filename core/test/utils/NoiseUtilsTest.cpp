@@ -2,6 +2,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <vector>
+
 using namespace utymap::utils;
 
 namespace {
@@ -17,4 +19,18 @@ BOOST_AUTO_TEST_CASE(GivenTestValues_WhenPerlin3d_ThenReturnExpectedValues) {
   BOOST_CHECK_CLOSE(NoiseUtils::perlin3D(52, 120, 13, 0.12), -0.1014592, Tolerance);
 }
 
+BOOST_AUTO_TEST_CASE(GivenPoints_WhenPerlin2dInBatch_ThenReturnTheSameValuesAsForSinglePoint) {
+  std::vector<double> xs, ys;
+  for (int i = 0; i < 150; ++i) {
+    xs.push_back(-180 + i*2.41);
+    ys.push_back(-90 + i*1.23);
+  }
+  std::vector<double> values(xs.size());
+
+  NoiseUtils::perlin2D(xs.data(), ys.data(), values.data(), xs.size(), 0.37);
+
+  for (std::size_t i = 0; i < xs.size(); ++i)
+    BOOST_CHECK_CLOSE(values[i], NoiseUtils::perlin2D(xs[i], ys[i], 0.37), 1E-9);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#include "utils/PriorityScheduler.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::utils;
+
+namespace {
+  /// Keeps single worker busy until released, so other tasks stay pending.
+  struct Utils_PrioritySchedulerFixture {
+    Utils_PrioritySchedulerFixture() : scheduler(1) {
+      auto started = std::make_shared<std::promise<void>>();
+      auto released = gate.get_future().share();
+      scheduler.submit(-1, 0, [started, released](const CancellationToken &) {
+        started->set_value();
+        released.wait();
+      });
+      started->get_future().wait();
+    }
+
+    PriorityScheduler::Task record(int id) {
+      return [this, id](const CancellationToken &token) {
+        std::lock_guard<std::mutex> lock(mutex);
+        (token.isCancelled() ? cancelled : order).push_back(id);
+      };
+    }
+
+    /// Releases worker and waits until given amount of recorded tasks is run.
+    void runUntil(std::size_t count) {
+      gate.set_value();
+      std::unique_lock<std::mutex> lock(mutex);
+      while (order.size() + cancelled.size() < count) {
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+      }
+    }
+
+    std::promise<void> gate;
+    std::mutex mutex;
+    std::vector<int> order;
+    std::vector<int> cancelled;
+    PriorityScheduler scheduler;
+  };
+}
+
+BOOST_FIXTURE_TEST_SUITE(Utils_PriorityScheduler, Utils_PrioritySchedulerFixture)
+
+BOOST_AUTO_TEST_CASE(GivenPendingTasks_WhenRun_ThenHighestPriorityRunsFirst) {
+  scheduler.submit(1, -3, record(1));
+  scheduler.submit(2, -1, record(2));
+  scheduler.submit(3, -2, record(3));
+  scheduler.submit(4, -1, record(4));
+
+  runUntil(4);
+
+  std::vector<int> expected = {2, 4, 3, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenPendingTask_WhenReprioritize_ThenItRunsFirst) {
+  scheduler.submit(1, -1, record(1));
+  scheduler.submit(2, -2, record(2));
+
+  BOOST_CHECK_EQUAL(scheduler.reprioritize(2, 0), 1);
+  runUntil(2);
+
+  std::vector<int> expected = {2, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenPendingTasks_WhenCancelBelow_ThenOnlyLowPriorityTasksAreCancelled) {
+  scheduler.submit(1, -5, record(1));
+  scheduler.submit(2, -1, record(2));
+  scheduler.submit(3, -4, record(3));
+
+  BOOST_CHECK_EQUAL(scheduler.cancelBelow(-2), 2);
+  runUntil(3);
+
+  std::vector<int> expectedOrder = {2};
+  std::vector<int> expectedCancelled = {3, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expectedOrder.begin(), expectedOrder.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS(cancelled.begin(), cancelled.end(),
+                                expectedCancelled.begin(), expectedCancelled.end());
+}
+
+BOOST_AUTO_TEST_CASE(GivenThreadPool_WhenRunnerIsBusy_ThenPendingTasksRunOnPoolByPriority) {
+  ThreadPool threadPool(2);
+  {
+    PriorityScheduler poolScheduler(1, &threadPool);
+    std::promise<void> started, released;
+    poolScheduler.submit(-1, 0, [&](const CancellationToken &) {
+      started.set_value();
+      released.get_future().wait();
+    });
+    started.get_future().wait();
+    poolScheduler.submit(1, -2, record(1));
+    poolScheduler.submit(2, -1, record(2));
+    released.set_value();
+  }
+  runUntil(2);
+
+  std::vector<int> expected = {2, 1};
+  BOOST_CHECK_EQUAL_COLLECTIONS(order.begin(), order.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
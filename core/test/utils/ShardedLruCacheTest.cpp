@@ -0,0 +1,92 @@
+#include "utils/ShardedLruCache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace utymap::utils;
+
+namespace {
+  typedef ShardedLruCache<int, std::string, 1> SingleShardCache;
+
+  std::size_t getSize(const std::string &str) { return str.size(); }
+}
+
+BOOST_AUTO_TEST_SUITE(Utils_ShardedLruCache)
+
+BOOST_AUTO_TEST_CASE(GivenEmptyCache_WhenGetOrLoad_LoadsOnlyOnce) {
+  SingleShardCache cache(4);
+  int loads = 0;
+  auto loader = [&](int key) { ++loads; return std::make_shared<std::string>(std::to_string(key)); };
+
+  auto first = cache.getOrLoad(1, loader);
+  auto second = cache.getOrLoad(1, loader);
+
+  BOOST_CHECK_EQUAL(*first, "1");
+  BOOST_CHECK_EQUAL(first.get(), second.get());
+  BOOST_CHECK_EQUAL(loads, 1);
+  BOOST_CHECK_EQUAL(cache.getHits(), 1);
+  BOOST_CHECK_EQUAL(cache.getMisses(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFullCache_WhenPut_EvictsLeastRecentlyUsed) {
+  SingleShardCache cache(2);
+  cache.put(0, std::string("0"));
+  cache.put(1, std::string("1"));
+  cache.find(0);
+
+  cache.put(2, std::string("2"));
+
+  BOOST_CHECK(cache.find(0) != nullptr);
+  BOOST_CHECK(cache.find(1) == nullptr);
+  BOOST_CHECK(cache.find(2) != nullptr);
+  BOOST_CHECK_EQUAL(cache.getEvictions(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenWeightedCache_WhenPut_KeepsBytesBelowLimit) {
+  SingleShardCache cache(100, Metrics::Cache::Count, getSize, 10);
+  cache.put(0, std::string("01234"));
+  cache.put(1, std::string("01234"));
+
+  cache.put(2, std::string("0123"));
+
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.weigh(), 9);
+  BOOST_CHECK_EQUAL(cache.trim(4), 4);
+  BOOST_CHECK(cache.find(2) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(GivenRegisteredCache_WhenMiss_MetricsAreUpdated) {
+  ShardedLruCache<int, std::string> cache(4, Metrics::Cache::Strings);
+  auto misses = Metrics::get(Metrics::Cache::Strings, Metrics::CacheEvent::Miss);
+
+  cache.find(1);
+
+  BOOST_CHECK_EQUAL(Metrics::get(Metrics::Cache::Strings, Metrics::CacheEvent::Miss), misses + 1);
+}
+
+BOOST_AUTO_TEST_CASE(GivenSeveralThreads_WhenGetOrLoad_CapacityIsKept) {
+  ShardedLruCache<int, std::string> cache(16);
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches(0);
+
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back([&cache, &mismatches, i] {
+      for (int j = 0; j < 1000; ++j) {
+        int key = (j * (i + 1)) % 64;
+        auto value = cache.getOrLoad(key, [](int key) { return std::make_shared<std::string>(std::to_string(key)); });
+        if (*value != std::to_string(key)) ++mismatches;
+      }
+    });
+  for (auto &thread : threads)
+    thread.join();
+
+  BOOST_CHECK_EQUAL(mismatches.load(), 0);
+  BOOST_CHECK_LE(cache.size(), 16);
+  BOOST_CHECK_EQUAL(cache.getHits() + cache.getMisses(), 4000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
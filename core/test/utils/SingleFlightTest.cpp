@@ -0,0 +1,136 @@
+#include "utils/SingleFlight.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace utymap;
+using namespace utymap::utils;
+
+namespace {
+  typedef SingleFlight<int, std::string> StringFlight;
+
+  /// Waits until flight of leader is running.
+  void waitForFlight(const StringFlight &flight) {
+    while (flight.size() == 0)
+      std::this_thread::yield();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(Utils_SingleFlight)
+
+BOOST_AUTO_TEST_CASE(GivenConcurrentCalls_WhenRun_ThenWorkIsRunOnceAndResultIsShared) {
+  StringFlight flight;
+  std::atomic<int> runs(0);
+  std::atomic<bool> isReleased(false);
+  std::atomic<int> waiting(0);
+  CancellationToken token;
+  StringFlight::Result leaderResult;
+  std::vector<StringFlight::Result> results(3);
+  std::vector<std::thread> followers;
+
+  std::thread leader([&]() {
+    bool isLeader = false;
+    leaderResult = flight.run(1, [&]() {
+      ++runs;
+      while (!isReleased) std::this_thread::yield();
+      return std::make_shared<const std::string>("tile");
+    }, token, isLeader);
+    BOOST_CHECK(isLeader);
+  });
+  waitForFlight(flight);
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    followers.emplace_back([&, i]() {
+      bool isLeader = true;
+      ++waiting;
+      results[i] = flight.run(1, [&]() { ++runs; return std::make_shared<const std::string>("other"); }, token, isLeader);
+      BOOST_CHECK(!isLeader);
+    });
+  }
+  while (waiting != static_cast<int>(results.size())) std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  isReleased = true;
+  leader.join();
+  for (auto &follower : followers) follower.join();
+
+  BOOST_CHECK_EQUAL(runs, 1);
+  BOOST_CHECK_EQUAL(flight.size(), 0);
+  for (const auto &result : results)
+    BOOST_CHECK_EQUAL(result.get(), leaderResult.get());
+}
+
+BOOST_AUTO_TEST_CASE(GivenCompletedFlight_WhenRunAgain_ThenWorkIsRunAgain) {
+  StringFlight flight;
+  CancellationToken token;
+  int runs = 0;
+  bool isLeader = false;
+  auto work = [&]() { ++runs; return std::make_shared<const std::string>("tile"); };
+
+  flight.run(1, work, token, isLeader);
+  flight.run(1, work, token, isLeader);
+
+  BOOST_CHECK(isLeader);
+  BOOST_CHECK_EQUAL(runs, 2);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFailingWork_WhenRun_ThenLeaderGetsExceptionAndFollowerGetsNull) {
+  StringFlight flight;
+  CancellationToken token;
+  std::atomic<bool> isReleased(false);
+  StringFlight::Result followerResult = std::make_shared<const std::string>("initial");
+  bool isThrown = false;
+
+  std::thread leader([&]() {
+    bool isLeader = false;
+    try {
+      flight.run(1, [&]() -> StringFlight::Result {
+        while (!isReleased) std::this_thread::yield();
+        throw std::domain_error("failed");
+      }, token, isLeader);
+    } catch (const std::domain_error &) {
+      isThrown = true;
+    }
+  });
+  waitForFlight(flight);
+  std::thread follower([&]() {
+    bool isLeader = true;
+    followerResult = flight.run(1, [&]() { return std::make_shared<const std::string>("other"); }, token, isLeader);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  isReleased = true;
+  leader.join();
+  follower.join();
+
+  BOOST_CHECK(isThrown);
+  BOOST_CHECK(followerResult == nullptr || *followerResult == "other");
+}
+
+BOOST_AUTO_TEST_CASE(GivenCancelledToken_WhenWaitForFlight_ThenNullIsReturned) {
+  StringFlight flight;
+  CancellationToken leaderToken, followerToken;
+  std::atomic<bool> isReleased(false);
+
+  std::thread leader([&]() {
+    bool isLeader = false;
+    flight.run(1, [&]() {
+      while (!isReleased) std::this_thread::yield();
+      return std::make_shared<const std::string>("tile");
+    }, leaderToken, isLeader);
+  });
+  waitForFlight(flight);
+  followerToken.cancel();
+  bool isLeader = true;
+
+  auto result = flight.run(1, [&]() { return std::make_shared<const std::string>("other"); }, followerToken, isLeader);
+  isReleased = true;
+  leader.join();
+
+  BOOST_CHECK(!isLeader);
+  BOOST_CHECK(result == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
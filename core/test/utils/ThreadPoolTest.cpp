@@ -0,0 +1,92 @@
+#include "utils/ThreadPool.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(Utils_ThreadPool)
+
+BOOST_AUTO_TEST_CASE(GivenSingleWorker_WhenTaskWaitsForNestedTasks_ThenAllTasksRun) {
+  ThreadPool threadPool(1);
+  std::atomic<int> count(0);
+
+  threadPool.enqueue([&]() {
+    std::vector<ThreadPool::Future> futures;
+    for (int i = 0; i < 4; ++i)
+      futures.push_back(threadPool.enqueue([&]() { ++count; }));
+    for (auto &future : futures)
+      future.get();
+  }).get();
+
+  BOOST_CHECK_EQUAL(count, 4);
+}
+
+BOOST_AUTO_TEST_CASE(GivenFailingTask_WhenGet_ThenExceptionIsRethrown) {
+  ThreadPool threadPool(2);
+
+  auto future = threadPool.enqueue([]() { throw std::domain_error("error"); });
+
+  BOOST_CHECK_THROW(future.get(), std::domain_error);
+}
+
+BOOST_AUTO_TEST_CASE(GivenNoWorkers_WhenGet_ThenTaskRunsOnCallingThread) {
+  ThreadPool threadPool(0);
+  std::thread::id threadId;
+
+  threadPool.enqueue([&]() { threadId = std::this_thread::get_id(); }).get();
+
+  BOOST_CHECK(threadId == std::this_thread::get_id());
+}
+
+BOOST_AUTO_TEST_CASE(GivenQueuedTasks_WhenConfigure_ThenTasksAreFinishedAndWorkersReplaced) {
+  ThreadPool threadPool(1);
+  std::atomic<int> count(0);
+  std::vector<ThreadPool::Future> futures;
+  for (int i = 0; i < 8; ++i)
+    futures.push_back(threadPool.enqueue([&]() { ++count; }));
+
+  threadPool.configure(3);
+
+  BOOST_CHECK_EQUAL(count, 8);
+  BOOST_CHECK_EQUAL(threadPool.size(), 3);
+  threadPool.enqueue([&]() { ++count; }).get();
+  BOOST_CHECK_EQUAL(count, 9);
+}
+
+BOOST_AUTO_TEST_CASE(GivenOtherThreadQueuingTasks_WhenConfigure_ThenAllTasksAreFinished) {
+  ThreadPool threadPool(2);
+  std::atomic<int> count(0);
+  std::thread producer([&]() {
+    for (int i = 0; i < 1000; ++i)
+      threadPool.enqueue([&]() { ++count; }).get();
+  });
+
+  for (std::size_t i = 1; i <= 10; ++i)
+    threadPool.configure(i % 3 + 1);
+  producer.join();
+
+  BOOST_CHECK_EQUAL(count, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(GivenShare_WhenResize_ThenSharedPoolIsPreferred) {
+  ThreadPool threadPool(1);
+  ThreadPoolShare sharedShare(&threadPool);
+  ThreadPoolShare ownShare;
+
+  sharedShare.resize(4);
+  ownShare.resize(2);
+
+  BOOST_CHECK(sharedShare.get() == &threadPool);
+  BOOST_CHECK_EQUAL(sharedShare.size(), 4);
+  BOOST_CHECK(ownShare.get() != nullptr);
+  BOOST_CHECK_EQUAL(ownShare.get()->size(), 2);
+  ownShare.resize(0);
+  BOOST_CHECK(ownShare.get() == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,33 @@
+#include "utils/Tracer.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace utymap;
+using namespace utymap::utils;
+
+BOOST_AUTO_TEST_SUITE(Utils_Tracer)
+
+BOOST_AUTO_TEST_CASE(GivenStartedTracer_WhenZoneIsCompleted_ThenItIsWrittenAsCompleteEvent) {
+  Tracer::start();
+  {
+    Tracer::Zone zone("build", QuadKey(16, 35205, 21489), 7);
+  }
+
+  auto json = Tracer::stop();
+
+  BOOST_CHECK(json.find("\"name\":\"build\",\"ph\":\"X\"") != std::string::npos);
+  BOOST_CHECK(json.find("\"args\":{\"tag\":7,\"quadKey\":\"16/35205/21489\"}") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(GivenStoppedTracer_WhenZoneIsCompleted_ThenItIsNotCollected) {
+  {
+    Tracer::Zone zone("build");
+  }
+  Tracer::start();
+
+  auto json = Tracer::stop();
+
+  BOOST_CHECK_EQUAL(json, "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,31 @@
+#include "index/PersistentElementStore.hpp"
+#include "index/StringTable.hpp"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace utymap::index;
+
+/// Bakes imported persistent element store into package for offline distribution:
+/// package contains tile packs, id index and string table, so it is opened as
+/// read only store without import.
+/// Usage: UtyMap.Bake <index path> <store data path> <package path>
+int main(int argc, char *argv[]) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0] << " <index path> <store data path> <package path>" << std::endl;
+    return 1;
+  }
+
+  try {
+    StringTable stringTable(argv[1]);
+    PersistentElementStore store(argv[2], stringTable);
+    store.exportPackage(argv[3]);
+    stringTable.exportTo(std::string(argv[3]) + "/");
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot bake package: " << ex.what() << std::endl;
+    return 2;
+  }
+  return 0;
+}
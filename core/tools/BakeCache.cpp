@@ -0,0 +1,63 @@
+#include "Application.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <string>
+
+namespace {
+std::atomic<std::uint64_t> errorCount(0);
+
+void createDirectory(const char *path) {
+  boost::filesystem::create_directories(path);
+}
+
+void reportProgress(std::uint64_t tilesBuilt, std::uint64_t tilesTotal, double seconds) {
+  if (tilesBuilt % 100 != 0 && tilesBuilt != tilesTotal)
+    return;
+  std::cout << tilesBuilt << "/" << tilesTotal << " tiles, "
+            << (seconds > 0 ? tilesBuilt / seconds : 0) << " tiles/s" << std::endl;
+}
+
+void reportError(const char *message) {
+  ++errorCount;
+  std::cerr << message << std::endl;
+}
+}
+
+/// Builds all tiles of region with given style, so mesh cache of index is shipped warm.
+/// Elevation type is 0 (flat), 1 (srtm), 2 (grid) or 3 (compressed srtm).
+/// Usage: UtyMap.BakeCache <index path> <store data path> <style file> <min lat> <min lon>
+///                         <max lat> <max lon> <start lod> <end lod> [elevation type] [thread count]
+int main(int argc, char *argv[]) {
+  if (argc < 10 || argc > 12) {
+    std::cerr << "Usage: " << argv[0] << " <index path> <store data path> <style file> <min lat> <min lon>"
+              << " <max lat> <max lon> <start lod> <end lod> [elevation type] [thread count]" << std::endl;
+    return 1;
+  }
+
+  try {
+    Application application(argv[1]);
+    auto &configuration = application.getConfiguration();
+    configuration.registerPersistentStore("bake", argv[2], &createDirectory);
+    configuration.registerStylesheet(argv[3], &createDirectory);
+    configuration.enableMeshCache(1);
+
+    auto &search = application.getSearch();
+    if (argc == 12)
+      search.setRequestThreads(std::stoi(argv[11]));
+
+    utymap::CancellationToken cancelToken;
+    search.bakeRegion(argv[3], std::stod(argv[4]), std::stod(argv[5]), std::stod(argv[6]), std::stod(argv[7]),
+                      std::stoi(argv[8]), std::stoi(argv[9]), argc > 10 ? std::stoi(argv[10]) : 0,
+                      &reportProgress, &reportError, &cancelToken);
+    configuration.flushMeshCache();
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot bake mesh cache: " << ex.what() << std::endl;
+    return 2;
+  }
+  return errorCount > 0 ? 3 : 0;
+}
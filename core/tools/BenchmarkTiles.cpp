@@ -0,0 +1,207 @@
+#include "Application.hpp"
+#include "utils/AllocationTracker.hpp"
+#include "utils/GeoUtils.hpp"
+#include "utils/MemoryUtils.hpp"
+#include "utils/Metrics.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using utymap::utils::AllocationTracker;
+using utymap::utils::getPeakMemory;
+using utymap::utils::Metrics;
+
+namespace {
+
+const char *StoreKey = "benchmark";
+const int StartLod = 12;
+const int EndLod = 16;
+/// Tiles around center tile which are built at every level of detail.
+const int TileRadius = 1;
+
+const char *ElevationNames[] = { "flat", "srtm", "grid", "compressedSrtm" };
+
+/// Output of current tile.
+std::uint64_t meshCount = 0;
+std::uint64_t vertexCount = 0;
+std::uint64_t elementCount = 0;
+std::uint64_t errorCount = 0;
+
+void createDirectory(const char *path) {
+  boost::filesystem::create_directories(path);
+}
+
+void countMesh(int, const char *, const double *, int vertexSize, const int *, int,
+               const int *, int, const double *, int, const int *, int) {
+  ++meshCount;
+  vertexCount += static_cast<std::uint64_t>(vertexSize / 3);
+}
+
+void countElement(int, std::uint64_t, const char **, int, const double *, int, const char **, int) {
+  ++elementCount;
+}
+
+/// NOTE only the first message is printed as missing elevation data fails every tile.
+void countError(const char *message) {
+  static bool isPrinted = false;
+  ++errorCount;
+  if (!isPrinted)
+    std::cerr << "Error: " << message << std::endl;
+  isPrinted = true;
+}
+
+double toMilliseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/// Returns value at given percentile using nearest rank.
+double getPercentile(std::vector<double> values, double percentile) {
+  if (values.empty())
+    return 0;
+  std::sort(values.begin(), values.end());
+  auto rank = static_cast<std::size_t>(percentile / 100 * values.size() + 0.5);
+  return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+/// Results of building the same tiles with the same elevation type.
+struct Run {
+  int eleDataType;
+  int levelOfDetail;
+  std::vector<double> latencies;
+  std::uint64_t meshes = 0;
+  std::uint64_t vertices = 0;
+  std::uint64_t elements = 0;
+  std::uint64_t errors = 0;
+  /// Stage times in microseconds: search, style, mesh and callback.
+  std::uint64_t stages[4] = { 0, 0, 0, 0 };
+  /// Allocation counts and bytes per subsystem, collected if allocation tracking is enabled.
+  std::uint64_t allocations[static_cast<std::size_t>(AllocationTracker::Subsystem::Count)] = {};
+  std::uint64_t allocatedBytes[static_cast<std::size_t>(AllocationTracker::Subsystem::Count)] = {};
+};
+
+Run buildTiles(Search &search, const char *styleFile, const utymap::GeoCoordinate &center,
+               int levelOfDetail, int eleDataType, int repetitions) {
+  static const Metrics::Latency Stages[] = {
+    Metrics::Latency::TileSearch, Metrics::Latency::TileStyle, Metrics::Latency::TileMesh, Metrics::Latency::TileCallback
+  };
+
+  Run run;
+  run.eleDataType = eleDataType;
+  run.levelOfDetail = levelOfDetail;
+  auto centerKey = utymap::utils::GeoUtils::GeoCoordinateToQuadKey(center, levelOfDetail);
+  for (int repetition = 0; repetition < repetitions; ++repetition) {
+    for (int y = centerKey.tileY - TileRadius; y <= centerKey.tileY + TileRadius; ++y) {
+      for (int x = centerKey.tileX - TileRadius; x <= centerKey.tileX + TileRadius; ++x) {
+        meshCount = vertexCount = elementCount = errorCount = 0;
+        Metrics::reset();
+        utymap::CancellationToken cancelToken;
+        auto start = std::chrono::steady_clock::now();
+        search.getDataByQuadKey(0, styleFile, x, y, levelOfDetail, eleDataType,
+                                &countMesh, &countElement, &countError, &cancelToken);
+        run.latencies.push_back(toMilliseconds(std::chrono::steady_clock::now() - start));
+        for (std::size_t i = 0; i < 4; ++i)
+          run.stages[i] += Metrics::getSum(Stages[i]);
+        for (std::size_t i = 0; i < static_cast<std::size_t>(AllocationTracker::Subsystem::Count); ++i) {
+          run.allocations[i] += AllocationTracker::getCount(static_cast<AllocationTracker::Subsystem>(i));
+          run.allocatedBytes[i] += AllocationTracker::getBytes(static_cast<AllocationTracker::Subsystem>(i));
+        }
+        run.meshes += meshCount;
+        run.vertices += vertexCount;
+        run.elements += elementCount;
+        run.errors += errorCount;
+      }
+    }
+  }
+  return run;
+}
+
+void writeReport(std::ostream &stream, double importTime, const std::vector<Run> &runs,
+                 Configuration &configuration) {
+  static const char *StageNames[] = { "search", "style", "mesh", "callback", "import" };
+  static const char *SubsystemNames[] = { "none", "build", "search", "style", "strings", "mesh", "callback" };
+
+  stream << "{\"importTime\":" << importTime << ",\"runs\":[";
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    const auto &run = runs[i];
+    stream << (i == 0 ? "" : ",") << "{\"elevation\":\"" << ElevationNames[run.eleDataType] << "\""
+           << ",\"lod\":" << run.levelOfDetail << ",\"tiles\":" << run.latencies.size()
+           << ",\"p50\":" << getPercentile(run.latencies, 50) << ",\"p95\":" << getPercentile(run.latencies, 95)
+           << ",\"meshes\":" << run.meshes << ",\"vertices\":" << run.vertices
+           << ",\"elements\":" << run.elements << ",\"errors\":" << run.errors << ",\"stages\":{";
+    for (std::size_t j = 0; j < 4; ++j)
+      stream << (j == 0 ? "" : ",") << "\"" << StageNames[j] << "\":" << run.stages[j] / 1000.0;
+    stream << "}";
+#ifdef ALLOCATION_TRACKING_ENABLED
+    stream << ",\"allocationsPerTile\":{";
+    for (std::size_t j = 1; j < static_cast<std::size_t>(AllocationTracker::Subsystem::Count); ++j)
+      stream << (j == 1 ? "" : ",") << "\"" << SubsystemNames[j] << "\":{\"count\":"
+             << run.allocations[j] / run.latencies.size() << ",\"bytes\":"
+             << run.allocatedBytes[j] / run.latencies.size() << "}";
+    stream << "}";
+#endif
+    stream << "}";
+  }
+  stream << "],\"peakMemory\":" << getPeakMemory() << ",\"memoryUsage\":" << configuration.getMemoryUsage() << "}";
+}
+}
+
+/// Measures end to end tile build: imports osm file into new persistent store, then builds
+/// tiles around given center at levels of detail 12-16 with every elevation type. Report is
+/// written as json: import time, latencies and stage times are in milliseconds, stage times
+/// are summed over tiles of run, memory is in bytes. Allocations per tile are added if
+/// allocation tracking is enabled.
+/// NOTE the first repetition reads data from disk, the rest use caches.
+/// Usage: UtyMap.BenchmarkTiles <index path> <osm file> <style file> <report file>
+///        [center latitude] [center longitude] [repetitions]
+int main(int argc, char *argv[]) {
+  if (argc < 5 || argc > 8) {
+    std::cerr << "Usage: " << argv[0] << " <index path> <osm file> <style file> <report file>"
+              << " [center latitude] [center longitude] [repetitions]" << std::endl;
+    return 1;
+  }
+
+  try {
+    utymap::GeoCoordinate center(argc > 5 ? std::stod(argv[5]) : 52.53, argc > 6 ? std::stod(argv[6]) : 13.38);
+    int repetitions = std::max(1, argc > 7 ? std::stoi(argv[7]) : 3);
+    auto storePath = (boost::filesystem::path(argv[1]) / StoreKey).string();
+    boost::filesystem::remove_all(storePath);
+
+    Application application(argv[1]);
+    auto &configuration = application.getConfiguration();
+    configuration.registerPersistentStore(StoreKey, storePath.c_str(), &createDirectory);
+    configuration.registerStylesheet(argv[3], &createDirectory);
+
+    utymap::CancellationToken cancelToken;
+    auto start = std::chrono::steady_clock::now();
+    application.getStorage().addToStore(StoreKey, argv[3], argv[2], StartLod, EndLod, &countError, &cancelToken);
+    if (errorCount > 0)
+      return 2;
+    double importTime = toMilliseconds(std::chrono::steady_clock::now() - start);
+
+    std::vector<Run> runs;
+    for (int eleDataType = 0; eleDataType < 4; ++eleDataType) {
+      for (int lod = StartLod; lod <= EndLod; ++lod) {
+        runs.push_back(buildTiles(application.getSearch(), argv[3], center, lod, eleDataType, repetitions));
+        const auto &run = runs.back();
+        std::cout << ElevationNames[eleDataType] << " lod " << lod << ": p50 " << getPercentile(run.latencies, 50)
+                  << " ms, p95 " << getPercentile(run.latencies, 95) << " ms" << std::endl;
+      }
+    }
+
+    std::ofstream report(argv[4]);
+    writeReport(report, importTime, runs, configuration);
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot run benchmark: " << ex.what() << std::endl;
+    return 2;
+  }
+  return 0;
+}
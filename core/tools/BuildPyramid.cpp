@@ -0,0 +1,24 @@
+#include "heightmap/SrtmElevationProvider.hpp"
+
+#include <exception>
+#include <iostream>
+
+using namespace utymap::heightmap;
+
+/// Builds downsampled SRTM pyramid levels which are used for coarse tiles.
+/// Usage: UtyMap.BuildPyramid <index path>
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <index path>" << std::endl;
+    return 1;
+  }
+
+  try {
+    SrtmElevationProvider::buildPyramid(argv[1]);
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot build elevation pyramid: " << ex.what() << std::endl;
+    return 2;
+  }
+  return 0;
+}
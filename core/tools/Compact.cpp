@@ -0,0 +1,28 @@
+#include "index/PersistentElementStore.hpp"
+#include "index/StringTable.hpp"
+
+#include <exception>
+#include <iostream>
+
+using namespace utymap::index;
+
+/// Compacts persistent element store offline: data of every quad key is rewritten
+/// without erased elements in spatial order and its bitmap is rebuilt.
+/// Usage: UtyMap.Compact <index path> <store data path>
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <index path> <store data path>" << std::endl;
+    return 1;
+  }
+
+  try {
+    StringTable stringTable(argv[1]);
+    PersistentElementStore store(argv[2], stringTable);
+    store.compact();
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot compact store: " << ex.what() << std::endl;
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,26 @@
+#include "heightmap/CompressedElevationProvider.hpp"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace utymap::heightmap;
+
+/// Compresses SRTM hgt files of index into block compressed hgz files.
+/// Usage: UtyMap.CompressSrtm <index path> [block size]
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <index path> [block size]" << std::endl;
+    return 1;
+  }
+
+  try {
+    int blockSize = argc==3 ? std::stoi(argv[2]) : CompressedElevationProvider::DefaultBlockSize;
+    CompressedElevationProvider::compressAll(argv[1], blockSize);
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot compress elevation data: " << ex.what() << std::endl;
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include "heightmap/GridElevationProvider.hpp"
+#include "utils/GeoUtils.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace utymap::heightmap;
+
+/// Converts text elevation grids of index into binary ones which are memory mapped on load.
+/// Usage: UtyMap.ConvertEle <index path> [int16|float32]
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: " << argv[0] << " <index path> [int16|float32]" << std::endl;
+    return 1;
+  }
+
+  auto sampleType = argc==3 && std::string(argv[2])=="float32"
+                    ? GridElevationProvider::SampleType::Float32
+                    : GridElevationProvider::SampleType::Int16;
+  try {
+    std::string indexPath = argv[1];
+    GridElevationProvider eleProvider(indexPath);
+    boost::filesystem::recursive_directory_iterator end;
+    for (boost::filesystem::recursive_directory_iterator it(indexPath + "/data/"); it!=end; ++it) {
+      if (!boost::filesystem::is_regular_file(it->path()) || it->path().extension()!=".ele")
+        continue;
+      auto quadKey = utymap::utils::GeoUtils::stringToQuadKey(it->path().stem().string());
+      eleProvider.convert(quadKey, sampleType);
+    }
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot convert elevation data: " << ex.what() << std::endl;
+    return 2;
+  }
+  return 0;
+}
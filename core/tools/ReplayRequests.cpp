@@ -0,0 +1,638 @@
+#include "ExportLib.cpp"
+#include "RequestLog.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Replayed call with its dependency on recorded calls.
+struct Call {
+  RequestLog::Entry entry;
+  /// Amount of calls in end order which should be completed before this one is started.
+  std::size_t dependencies;
+  std::uint64_t duration;
+  bool isReplayed;
+};
+
+std::atomic<std::uint64_t> errorCount(0);
+
+void createDirectory(const char *path) {
+  boost::filesystem::create_directories(path);
+}
+
+void ignoreMesh(int, const char *, const double *, int, const int *, int, const int *, int,
+                const double *, int, const int *, int) {}
+
+void ignoreMeshFloat(int, const char *, double, double, const float *, int, const int *, int, const int *, int,
+                     const float *, int, const int *, int) {}
+
+void ignoreInterleavedMesh(int, const char *, double, double, const void *, int, int, const void *, int, int) {}
+
+void ignoreOwnedMesh(int, std::uint64_t, const char *, const double *, int, const int *, int, const int *, int,
+                     const double *, int, const int *, int) {}
+
+void ignoreWrittenMesh(int, const char *, int, int, int, int, int, int, int, int, int, int) {}
+
+void ignoreInstances(int, const char *, const double *, int) {}
+
+void ignoreElement(int, std::uint64_t, const char **, int, const double *, int, const char **, int) {}
+
+void ignoreElements(int, const std::uint64_t *, int, const char **, const int *, const double *, const int *,
+                    const char **, const int *) {}
+
+void ignoreStrings(int, const std::uint32_t *, const char **, int) {}
+
+void ignoreElementIds(int, std::uint64_t, const std::uint32_t *, int, const double *, int,
+                      const std::uint32_t *, int) {}
+
+void ignoreImportProgress(std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t,
+                          double, double, double, double) {}
+
+void ignoreStyleProfile(const char *) {}
+
+void ignoreCompletion(int, int) {}
+
+void ignoreBakeProgress(std::uint64_t, std::uint64_t, double) {}
+
+void countError(const char *) {
+  ++errorCount;
+}
+
+std::vector<int> toInts(const std::string &arg) {
+  std::vector<int> ints;
+  std::size_t start = 0;
+  while (start < arg.size()) {
+    auto end = arg.find(',', start);
+    if (end == std::string::npos) end = arg.size();
+    ints.push_back(std::stoi(arg.substr(start, end - start)));
+    start = end + 1;
+  }
+  return ints;
+}
+
+std::vector<double> toDoubles(const std::string &arg) {
+  std::vector<double> doubles;
+  std::size_t start = 0;
+  while (start < arg.size()) {
+    auto end = arg.find(',', start);
+    if (end == std::string::npos) end = arg.size();
+    doubles.push_back(std::stod(arg.substr(start, end - start)));
+    start = end + 1;
+  }
+  return doubles;
+}
+
+/// Keeps dependencies between calls: call is started only when all calls which were completed
+/// before its start in recorded session are completed, so recorded concurrency is kept.
+class Schedule final {
+ public:
+  Schedule(std::vector<Call> &calls) : calls_(calls), completed_(0) {
+    std::vector<std::uint64_t> ends;
+    for (std::size_t i = 0; i < calls.size(); ++i) {
+      endOrder_.push_back(i);
+      ends.push_back(calls[i].entry.start + calls[i].entry.duration);
+    }
+    std::sort(endOrder_.begin(), endOrder_.end(), [&](std::size_t a, std::size_t b) { return ends[a] < ends[b]; });
+    std::sort(ends.begin(), ends.end());
+    for (auto &call : calls)
+      call.dependencies = static_cast<std::size_t>(
+          std::upper_bound(ends.begin(), ends.end(), call.entry.start) - ends.begin());
+    isDone_.assign(calls.size(), false);
+    positions_.resize(calls.size());
+    for (std::size_t i = 0; i < endOrder_.size(); ++i)
+      positions_[endOrder_[i]] = i;
+  }
+
+  void wait(std::size_t index) {
+    std::unique_lock<std::mutex> lock(lock_);
+    condition_.wait(lock, [&] { return completed_ >= calls_[index].dependencies; });
+  }
+
+  void complete(std::size_t index) {
+    std::lock_guard<std::mutex> lock(lock_);
+    isDone_[positions_[index]] = true;
+    while (completed_ < isDone_.size() && isDone_[completed_])
+      ++completed_;
+    condition_.notify_all();
+  }
+
+ private:
+  std::vector<Call> &calls_;
+  std::vector<std::size_t> endOrder_;
+  std::vector<std::size_t> positions_;
+  std::vector<bool> isDone_;
+  std::size_t completed_;
+  std::mutex lock_;
+  std::condition_variable condition_;
+};
+
+/// Re-issues recorded calls through handle functions of export API, so replayed calls take the
+/// same path as recorded ones. Every recorded application gets its own replayed one.
+class Replayer final {
+ public:
+  Replayer(const std::string &indexPath, const std::string &fromPrefix, const std::string &toPrefix) :
+      indexPath_(indexPath), fromPrefix_(fromPrefix), toPrefix_(toPrefix) {}
+
+  ~Replayer() {
+    for (const auto &pair : connections_)
+      disconnectEx(pair.second.handle);
+  }
+
+  /// Replays call. Returns false if call is not supported or its application is not connected.
+  bool replay(const RequestLog::Entry &entry) {
+    const auto &name = entry.name;
+    const auto &args = entry.args;
+    auto toInt = [&](std::size_t i) { return std::stoi(args.at(i)); };
+    auto toUInt64 = [&](std::size_t i) { return static_cast<std::uint64_t>(std::stoull(args.at(i))); };
+    auto toDouble = [&](std::size_t i) { return std::stod(args.at(i)); };
+    auto toPath = [&](std::size_t i) { return getPath(args.at(i)); };
+
+    if (name == "connect") {
+      auto handle = connectEx(getIndexPath(args.at(0)).c_str(), &countError);
+      if (handle == nullptr)
+        return false;
+      std::lock_guard<std::mutex> lock(lock_);
+      auto &connection = connections_[entry.handle];
+      // NOTE application which is not disconnected by host is replaced when its address is reused.
+      if (connection.handle != nullptr)
+        disconnectEx(connection.handle);
+      connection = Connection{ handle, {} };
+      return true;
+    }
+
+    auto handle = getHandle(entry.handle);
+    if (handle == nullptr)
+      return false;
+
+    utymap::CancellationToken cancelToken;
+
+    // Lifecycle API.
+    if (name == "disconnect") {
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        connections_.erase(entry.handle);
+      }
+      disconnectEx(handle);
+    }
+
+    // Configuration API.
+    else if (name == "registerStylesheet")
+      registerStylesheetEx(handle, toPath(0).c_str(), &createDirectory);
+    else if (name == "registerInMemoryStore")
+      registerInMemoryStoreEx(handle, args.at(0).c_str());
+    else if (name == "registerInMemoryStoreWithBudget")
+      registerInMemoryStoreWithBudgetEx(handle, args.at(0).c_str(), toUInt64(1), toInt(2));
+    else if (name == "getInMemoryStoreFootprint") {
+      std::uint64_t bytes;
+      getInMemoryStoreFootprintEx(handle, args.at(0).c_str(), &bytes);
+    } else if (name == "saveInMemoryStoreSnapshot")
+      saveInMemoryStoreSnapshotEx(handle, args.at(0).c_str(), toPath(1).c_str(), &countError);
+    else if (name == "loadInMemoryStoreSnapshot")
+      loadInMemoryStoreSnapshotEx(handle, args.at(0).c_str(), toPath(1).c_str(), &countError);
+    else if (name == "registerPersistentStore")
+      registerPersistentStoreEx(handle, args.at(0).c_str(), toPath(1).c_str(), &createDirectory);
+    else if (name == "registerPersistentStoreWithLimits")
+      registerPersistentStoreWithLimitsEx(handle, args.at(0).c_str(), toPath(1).c_str(), toInt(2), toUInt64(3),
+                                          &createDirectory);
+    else if (name == "registerPackageStore")
+      registerPackageStoreEx(handle, args.at(0).c_str(), toPath(1).c_str());
+    else if (name == "exportPackage")
+      exportPackageEx(handle, args.at(0).c_str(), toPath(1).c_str());
+    else if (name == "getPersistentStoreStatistics") {
+      std::uint64_t hits, misses, evictions, bitmapBytes;
+      getPersistentStoreStatisticsEx(handle, args.at(0).c_str(), &hits, &misses, &evictions, &bitmapBytes);
+    } else if (name == "setSearchThreads")
+      setSearchThreadsEx(handle, toInt(0));
+    else if (name == "setImportThreads")
+      setImportThreadsEx(handle, toInt(0));
+    else if (name == "setImportFileThreads")
+      setImportFileThreadsEx(handle, toInt(0));
+    else if (name == "setBuildThreads")
+      setBuildThreadsEx(handle, toInt(0));
+    else if (name == "configureThreadPool")
+      configureThreadPoolEx(handle, toInt(0), toInt(1), toUInt64(2), toInt(3));
+    else if (name == "enableMeshWelding")
+      enableMeshWeldingEx(handle, toInt(0));
+    else if (name == "enableParallelBuilders")
+      enableParallelBuildersEx(handle, toInt(0));
+    else if (name == "enableProgressiveDelivery")
+      enableProgressiveDeliveryEx(handle, toInt(0));
+    else if (name == "enableInstancing")
+      enableInstancingEx(handle, toInt(0));
+    else if (name == "setBatchVertexLimit")
+      setBatchVertexLimitEx(handle, toInt(0));
+    else if (name == "setMeshPoolMaxBytes")
+      setMeshPoolMaxBytesEx(handle, toUInt64(0));
+    else if (name == "setGridElevationCacheSize")
+      setGridElevationCacheSizeEx(handle, toInt(0));
+    else if (name == "getMeshPoolStatistics") {
+      std::uint64_t hits, misses, retainedBytes, trimmedBytes;
+      getMeshPoolStatisticsEx(handle, &hits, &misses, &retainedBytes, &trimmedBytes);
+    } else if (name == "setMeshCacheMemoryLimit")
+      setMeshCacheMemoryLimitEx(handle, toUInt64(0));
+    else if (name == "setMeshCacheDiskLimit")
+      setMeshCacheDiskLimitEx(handle, toUInt64(0));
+    else if (name == "purgeMeshCache") {
+      std::size_t index = 0;
+      auto styleFiles = toPaths(args, index);
+      auto styleFilePtrs = toPointers(styleFiles);
+      purgeMeshCacheEx(handle, styleFilePtrs.data(), static_cast<int>(styleFilePtrs.size()));
+    } else if (name == "setElevationCacheResolution")
+      setElevationCacheResolutionEx(handle, toInt(0));
+    else if (name == "setImportProgressCallback")
+      setImportProgressCallbackEx(handle, toInt(0) != 0 ? &ignoreImportProgress : nullptr);
+    else if (name == "setTwoPassImport")
+      setTwoPassImportEx(handle, toInt(0) != 0);
+    else if (name == "setHierarchicalClipping")
+      setHierarchicalClippingEx(handle, toInt(0) != 0);
+    else if (name == "setNodeLocationDirectory")
+      setNodeLocationDirectoryEx(handle, toPath(0).c_str());
+    else if (name == "setCheckpointDirectory")
+      setCheckpointDirectoryEx(handle, toPath(0).c_str());
+    else if (name == "sealStringTable")
+      sealStringTableEx(handle);
+    else if (name == "setStringTableDurability")
+      setStringTableDurabilityEx(handle, toInt(0));
+    else if (name == "enableMeshCache")
+      enableMeshCacheEx(handle, toInt(0));
+    else if (name == "enableStyleProfiling")
+      enableStyleProfilingEx(handle, toPath(0).c_str(), toInt(1));
+    else if (name == "getStyleProfile")
+      getStyleProfileEx(handle, toPath(0).c_str(), &ignoreStyleProfile);
+    else if (name == "getStatistics") {
+      std::vector<char> buffer(static_cast<std::size_t>(toInt(0)));
+      getStatisticsEx(handle, buffer.data(), static_cast<int>(buffer.size()));
+    } else if (name == "getMemoryUsage") {
+      std::vector<char> buffer(static_cast<std::size_t>(toInt(0)));
+      getMemoryUsageEx(handle, buffer.data(), static_cast<int>(buffer.size()));
+    } else if (name == "setMemoryFloor")
+      setMemoryFloorEx(handle, toInt(0), toUInt64(1));
+    else if (name == "trimMemory")
+      trimMemoryEx(handle, toInt(0));
+    else if (name == "startTracing")
+      startTracingEx(handle);
+    else if (name == "stopTracing")
+      stopTracingEx(handle, toPath(0).c_str());
+
+    // Storage API.
+    else if (name == "addDataInRange")
+      addDataInRangeEx(handle, args.at(0).c_str(), toPath(1).c_str(), toPath(2).c_str(), toInt(3), toInt(4),
+                       &countError, &cancelToken);
+    else if (name == "addDataInRangeBatch") {
+      std::size_t index = 1;
+      auto styleFiles = toPaths(args, index);
+      auto paths = toPaths(args, index);
+      auto styleFilePtrs = toPointers(styleFiles);
+      auto pathPtrs = toPointers(paths);
+      addDataInRangeBatchEx(handle, args.at(0).c_str(), styleFilePtrs.data(), pathPtrs.data(),
+                            static_cast<int>(pathPtrs.size()), toInt(index), toInt(index + 1),
+                            &countError, &cancelToken);
+    } else if (name == "addDataInBoundingBox")
+      addDataInBoundingBoxEx(handle, args.at(0).c_str(), toPath(1).c_str(), toPath(2).c_str(),
+                             toDouble(3), toDouble(4), toDouble(5), toDouble(6), toInt(7), toInt(8),
+                             &countError, &cancelToken);
+    else if (name == "addDataInQuadKey")
+      addDataInQuadKeyEx(handle, args.at(0).c_str(), toPath(1).c_str(), toPath(2).c_str(),
+                         toInt(3), toInt(4), toInt(5), &countError, &cancelToken);
+    else if (name == "addDataInElement") {
+      auto vertices = toDoubles(args.at(3));
+      std::size_t index = 4;
+      auto tags = toStrings(args, index);
+      auto tagPtrs = toPointers(tags);
+      addDataInElementEx(handle, args.at(0).c_str(), toPath(1).c_str(), toUInt64(2),
+                         vertices.data(), static_cast<int>(vertices.size()),
+                         tagPtrs.data(), static_cast<int>(tagPtrs.size()), toInt(index), toInt(index + 1),
+                         &countError, &cancelToken);
+    } else if (name == "applyChanges")
+      applyChangesEx(handle, args.at(0).c_str(), toPath(1).c_str(), toPath(2).c_str(), toInt(3), toInt(4),
+                     &countError, &cancelToken);
+    else if (name == "hasData")
+      hasDataEx(handle, toInt(0), toInt(1), toInt(2));
+    else if (name == "getTileSummary") {
+      std::uint64_t values[6];
+      getTileSummaryEx(handle, toInt(0), toInt(1), toInt(2), values);
+    }
+
+    // Search API.
+    else if (name == "getDataByText")
+      getDataByTextEx(handle, toInt(0), toString(args.at(1)), toString(args.at(2)), toString(args.at(3)),
+                      toDouble(4), toDouble(5), toDouble(6), toDouble(7), toInt(8), toInt(9),
+                      &ignoreElement, &countError, &cancelToken);
+    else if (name == "getDataByTextPage")
+      getDataByTextPageEx(handle, toInt(0), toString(args.at(1)), toString(args.at(2)), toString(args.at(3)),
+                          toDouble(4), toDouble(5), toDouble(6), toDouble(7), toInt(8), toInt(9),
+                          toInt(10), toInt(11), &ignoreElement, &countError, &cancelToken);
+    else if (name == "getDataByTextBatch")
+      getDataByTextBatchEx(handle, toInt(0), toString(args.at(1)), toString(args.at(2)), toString(args.at(3)),
+                           toDouble(4), toDouble(5), toDouble(6), toDouble(7), toInt(8), toInt(9),
+                           toInt(10), toInt(11), toInt(12), &ignoreElements, &countError, &cancelToken);
+    else if (name == "countDataByText")
+      countDataByTextEx(handle, toString(args.at(0)), toString(args.at(1)), toString(args.at(2)),
+                        toDouble(3), toDouble(4), toDouble(5), toDouble(6), toInt(7), toInt(8),
+                        &countError, &cancelToken);
+    else if (name == "existsDataByText")
+      existsDataByTextEx(handle, toString(args.at(0)), toString(args.at(1)), toString(args.at(2)),
+                         toDouble(3), toDouble(4), toDouble(5), toDouble(6), toInt(7), toInt(8),
+                         &countError, &cancelToken);
+    else if (name == "getDataById")
+      getDataByIdEx(handle, toInt(0), toUInt64(1), &ignoreElement, &countError);
+    else if (name == "getDataByQuadKey")
+      getDataByQuadKeyEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                         &ignoreMesh, &ignoreElement, &countError, &cancelToken);
+    else if (name == "getDataByQuadKeyBatch")
+      getDataByQuadKeyBatchEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                              toInt(6), &ignoreMesh, &ignoreElements, &countError, &cancelToken);
+    else if (name == "getDataByQuadKeyFloat")
+      getDataByQuadKeyFloatEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                              &ignoreMeshFloat, &ignoreElement, &countError, &cancelToken);
+    else if (name == "getDataByQuadKeyIds")
+      getDataByQuadKeyIdsEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                            &ignoreMesh, &ignoreStrings, &ignoreElementIds, &countError, &cancelToken);
+    else if (name == "getDataByQuadKeys") {
+      auto tiles = toInts(args.at(1));
+      getDataByQuadKeysEx(handle, toPath(0).c_str(), tiles.data(), static_cast<int>(tiles.size() / 2),
+                          toInt(2), toInt(3), &ignoreMesh, &ignoreElement, &countError, &cancelToken);
+    } else if (name == "getDataByQuadKeyOwned")
+      getDataByQuadKeyOwnedEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                              &ignoreOwnedMesh, &ignoreElement, &countError, &cancelToken);
+    else if (name == "releaseMesh")
+      // NOTE mesh handles are given in order of built meshes, so they match recorded ones as
+      // long as owned meshes are not requested concurrently.
+      releaseMeshEx(handle, toUInt64(0));
+    else if (name == "getDataByQuadKeyInterleaved")
+      getDataByQuadKeyInterleavedEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                                    &ignoreInterleavedMesh, &ignoreElement, &countError, &cancelToken);
+    else if (name == "enableMeshSplitting")
+      enableMeshSplittingEx(handle, toInt(0));
+    else if (name == "enableRequestCoalescing")
+      enableRequestCoalescingEx(handle, toInt(0));
+    else if (name == "getDataByQuadKeyInstanced")
+      getDataByQuadKeyInstancedEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                                  &ignoreMesh, &ignoreInstances, &ignoreElement, &countError, &cancelToken);
+    else if (name == "setRequestThreads")
+      setRequestThreadsEx(handle, toInt(0));
+    else if (name == "setRequestBudget")
+      setRequestBudgetEx(handle, toInt(0));
+    else if (name == "submitDataByQuadKey")
+      submitDataByQuadKeyEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                            toDouble(6), &ignoreMesh, &ignoreElement, &countError, &ignoreCompletion);
+    else if (name == "submitDataByQuadKeyBatch")
+      submitDataByQuadKeyBatchEx(handle, toInt(0), toPath(1).c_str(), toInt(2), toInt(3), toInt(4), toInt(5),
+                                 toDouble(6), toInt(7), &ignoreMesh, &ignoreElements, &countError,
+                                 &ignoreCompletion);
+    else if (name == "bakeRegion")
+      bakeRegionEx(handle, toPath(0).c_str(), toDouble(1), toDouble(2), toDouble(3), toDouble(4),
+                   toInt(5), toInt(6), toInt(7), &ignoreBakeProgress, &countError, &cancelToken);
+    else if (name == "submitQuadKeyJob") {
+      int jobId = submitQuadKeyJobEx(handle, toPath(0).c_str(), toInt(1), toInt(2), toInt(3), toInt(4),
+                                     toDouble(5));
+      std::lock_guard<std::mutex> lock(lock_);
+      auto connection = connections_.find(entry.handle);
+      if (connection != connections_.end())
+        connection->second.jobIds[toInt(6)] = jobId;
+    } else if (name == "pollCompletedJobs") {
+      std::vector<int> jobIds(static_cast<std::size_t>(std::max(toInt(0), 0)));
+      pollCompletedJobsEx(handle, jobIds.data(), static_cast<int>(jobIds.size()));
+    } else if (name == "fetchJobResult")
+      fetchJobResultEx(handle, getJobId(entry.handle, toInt(0)), &ignoreMesh, &ignoreElement, &countError);
+    else if (name == "getJobMeshSizes") {
+      int meshCount, vertexSize, triSize, colorSize, uvSize, uvMapSize;
+      getJobMeshSizesEx(handle, getJobId(entry.handle, toInt(0)), &meshCount, &vertexSize, &triSize, &colorSize,
+                        &uvSize, &uvMapSize);
+    } else if (name == "fetchJobMeshes") {
+      std::vector<double> vertices(static_cast<std::size_t>(toInt(1)));
+      std::vector<int> triangles(static_cast<std::size_t>(toInt(2)));
+      std::vector<int> colors(static_cast<std::size_t>(toInt(3)));
+      std::vector<double> uvs(static_cast<std::size_t>(toInt(4)));
+      std::vector<int> uvMap(static_cast<std::size_t>(toInt(5)));
+      fetchJobMeshesEx(handle, getJobId(entry.handle, toInt(0)), vertices.data(), toInt(1), triangles.data(),
+                       toInt(2), colors.data(), toInt(3), uvs.data(), toInt(4), uvMap.data(), toInt(5),
+                       &ignoreWrittenMesh, &ignoreElement, &countError);
+    } else if (name == "setRequestPriority")
+      setRequestPriorityEx(handle, toInt(0), toDouble(1));
+    else if (name == "cancelRequestsBelow")
+      cancelRequestsBelowEx(handle, toDouble(0));
+    else if (name == "prefetch") {
+      auto tiles = toInts(args.at(0));
+      prefetchEx(handle, tiles.data(), static_cast<int>(tiles.size() / 2), toInt(1));
+    } else if (name == "prefetchElevation") {
+      auto tiles = toInts(args.at(0));
+      prefetchElevationEx(handle, tiles.data(), static_cast<int>(tiles.size() / 2), toInt(1), toInt(2));
+    } else if (name == "getElevationByQuadKey")
+      getElevationByQuadKeyEx(handle, toInt(0), toInt(1), toInt(2), toInt(3), toDouble(4), toDouble(5));
+    else if (name == "getElevationsByQuadKey") {
+      auto coordinates = toDoubles(args.at(4));
+      std::vector<double> elevations(coordinates.size() / 2);
+      getElevationsByQuadKeyEx(handle, toInt(0), toInt(1), toInt(2), toInt(3), coordinates.data(),
+                               static_cast<int>(elevations.size()), elevations.data());
+    } else
+      return false;
+    return true;
+  }
+
+ private:
+  /// Replayed application of recorded one with ids of its jobs.
+  struct Connection {
+    void *handle;
+    /// Maps recorded job ids to replayed ones.
+    std::map<int, int> jobIds;
+  };
+
+  void *getHandle(std::uint64_t recordedHandle) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto connection = connections_.find(recordedHandle);
+    return connection != connections_.end() ? connection->second.handle : nullptr;
+  }
+
+  /// Returns replayed job id of recorded one or zero if job is unknown.
+  int getJobId(std::uint64_t recordedHandle, int recordedJobId) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto connection = connections_.find(recordedHandle);
+    if (connection == connections_.end())
+      return 0;
+    auto jobId = connection->second.jobIds.find(recordedJobId);
+    return jobId != connection->second.jobIds.end() ? jobId->second : 0;
+  }
+
+  /// Returns index path given for replay instead of recorded one of the first application.
+  std::string getIndexPath(const std::string &recordedPath) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (indexPath_.empty() || (!recordedIndexPath_.empty() && recordedIndexPath_ != recordedPath))
+      return getPath(recordedPath);
+    recordedIndexPath_ = recordedPath;
+    return indexPath_;
+  }
+
+  /// Returns null for null string which is recorded as \N.
+  static const char *toString(const std::string &arg) {
+    return arg == "\\N" ? nullptr : arg.c_str();
+  }
+
+  /// Reads array of strings which is recorded as its size followed by strings. Index is moved
+  /// to the argument after array.
+  static std::vector<std::string> toStrings(const std::vector<std::string> &args, std::size_t &index) {
+    auto count = static_cast<std::size_t>(std::stoi(args.at(index++)));
+    std::vector<std::string> strings(args.begin() + index, args.begin() + index + count);
+    index += count;
+    return strings;
+  }
+
+  /// Reads array of paths like toStrings and replaces their prefix.
+  std::vector<std::string> toPaths(const std::vector<std::string> &args, std::size_t &index) const {
+    auto paths = toStrings(args, index);
+    for (auto &path : paths)
+      path = getPath(path);
+    return paths;
+  }
+
+  static std::vector<const char *> toPointers(const std::vector<std::string> &strings) {
+    std::vector<const char *> pointers;
+    for (const auto &str : strings)
+      pointers.push_back(toString(str));
+    return pointers;
+  }
+
+  /// Replaces prefix of recorded path, so session can be replayed on another machine.
+  std::string getPath(const std::string &path) const {
+    if (!fromPrefix_.empty() && path.compare(0, fromPrefix_.size(), fromPrefix_) == 0)
+      return toPrefix_ + path.substr(fromPrefix_.size());
+    return path;
+  }
+
+  const std::string indexPath_;
+  const std::string fromPrefix_;
+  const std::string toPrefix_;
+  std::string recordedIndexPath_;
+  /// Replayed applications by recorded handles.
+  std::map<std::uint64_t, Connection> connections_;
+  std::mutex lock_;
+};
+
+double toMilliseconds(std::uint64_t micros) {
+  return static_cast<double>(micros) / 1000;
+}
+
+/// Prints recorded and replayed time of calls grouped by name.
+void printReport(const std::vector<Call> &calls, std::uint64_t recordedTime, std::uint64_t replayedTime) {
+  struct Summary {
+    std::size_t count = 0;
+    std::size_t skipped = 0;
+    std::uint64_t recorded = 0;
+    std::uint64_t replayed = 0;
+  };
+
+  std::map<std::string, Summary> summaries;
+  for (const auto &call : calls) {
+    auto &summary = summaries[call.entry.name];
+    if (!call.isReplayed) {
+      ++summary.skipped;
+      continue;
+    }
+    ++summary.count;
+    summary.recorded += call.entry.duration;
+    summary.replayed += call.duration;
+  }
+
+  std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(24) << "call"
+            << std::right << std::setw(8) << "count" << std::setw(8) << "skipped"
+            << std::setw(16) << "recorded ms" << std::setw(16) << "replayed ms" << std::endl;
+  for (const auto &pair : summaries)
+    std::cout << std::left << std::setw(24) << pair.first << std::right << std::setw(8) << pair.second.count
+              << std::setw(8) << pair.second.skipped << std::setw(16) << toMilliseconds(pair.second.recorded)
+              << std::setw(16) << toMilliseconds(pair.second.replayed) << std::endl;
+  std::cout << "session: recorded " << toMilliseconds(recordedTime) << " ms, replayed "
+            << toMilliseconds(replayedTime) << " ms, errors " << errorCount << std::endl;
+}
+
+}
+
+/// Replays session recorded by request log of export API: calls of every recorded thread are
+/// issued in their order on own thread and wait only for calls which were completed before they
+/// started, so replay keeps concurrency of session while running as fast as possible.
+/// Index path replaces recorded one of the first connected application, other applications use
+/// their recorded paths. Recorded path prefix is replaced in all paths.
+/// NOTE callbacks are ignored and cancellation is not replayed. Job results are fetched when
+/// recorded fetch is replayed, so job which is not completed by then stays unfetched.
+int main(int argc, char *argv[]) {
+  if (argc != 2 && argc != 3 && argc != 5) {
+    std::cerr << "Usage: " << argv[0] << " <request log> [index path] [recorded path prefix] [new path prefix]"
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    std::ifstream file(argv[1]);
+    if (!file.good()) {
+      std::cerr << "Cannot open request log: " << argv[1] << std::endl;
+      return 1;
+    }
+
+    std::vector<Call> calls;
+    std::string line;
+    std::uint64_t recordedTime = 0;
+    while (std::getline(file, line)) {
+      Call call = {};
+      if (!RequestLog::parse(line, call.entry)) {
+        std::cerr << "Malformed line is skipped: " << line << std::endl;
+        continue;
+      }
+      recordedTime = std::max(recordedTime, call.entry.start + call.entry.duration);
+      calls.push_back(std::move(call));
+    }
+    std::stable_sort(calls.begin(), calls.end(),
+                     [](const Call &a, const Call &b) { return a.entry.start < b.entry.start; });
+
+    std::map<std::size_t, std::vector<std::size_t>> threadCalls;
+    for (std::size_t i = 0; i < calls.size(); ++i)
+      threadCalls[calls[i].entry.threadId].push_back(i);
+
+    Schedule schedule(calls);
+    Replayer replayer(argc > 2 ? argv[2] : "", argc > 3 ? argv[3] : "", argc > 4 ? argv[4] : "");
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (const auto &pair : threadCalls) {
+      const auto &indices = pair.second;
+      threads.emplace_back([&calls, &schedule, &replayer, &indices]() {
+        for (auto index : indices) {
+          auto &call = calls[index];
+          schedule.wait(index);
+          auto callStart = std::chrono::steady_clock::now();
+          try {
+            call.isReplayed = replayer.replay(call.entry);
+          } catch (const std::exception &ex) {
+            std::cerr << "Call " << call.entry.name << " failed: " << ex.what() << std::endl;
+          }
+          call.duration = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - callStart).count());
+          schedule.complete(index);
+        }
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+
+    auto replayedTime = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    printReport(calls, recordedTime, replayedTime);
+  } catch (std::exception &ex) {
+    std::cerr << "Error: " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
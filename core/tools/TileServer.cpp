@@ -0,0 +1,151 @@
+#include "Application.hpp"
+#include "TileService.hpp"
+#include "utils/ThreadPool.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/filesystem.hpp>
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace {
+namespace http = boost::beast::http;
+using tcp = boost::asio::ip::tcp;
+
+const char *StoreKey = "server";
+
+void createDirectory(const char *path) {
+  boost::filesystem::create_directories(path);
+}
+
+/// Keeps open connections, so they can be closed on shutdown.
+class Connections final {
+ public:
+  void add(const std::shared_ptr<tcp::socket> &socket) {
+    std::lock_guard<std::mutex> lock(lock_);
+    sockets_.insert(socket);
+  }
+
+  void remove(const std::shared_ptr<tcp::socket> &socket) {
+    std::lock_guard<std::mutex> lock(lock_);
+    sockets_.erase(socket);
+  }
+
+  /// Shuts down all connections, so blocked reads of them fail.
+  void close() {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (const auto &socket : sockets_) {
+      boost::system::error_code error;
+      socket->shutdown(tcp::socket::shutdown_both, error);
+    }
+  }
+
+ private:
+  std::set<std::shared_ptr<tcp::socket>> sockets_;
+  std::mutex lock_;
+};
+
+void serve(TileService &service, tcp::socket &socket) {
+  try {
+    boost::beast::flat_buffer buffer;
+    while (true) {
+      http::request<http::string_body> request;
+      http::read(socket, buffer, request);
+
+      std::shared_ptr<const TileService::Response> response;
+      try {
+        response = request.method() == http::verb::get
+                   ? service.handle(std::string(request.target()))
+                   : std::make_shared<const TileService::Response>(TileService::Response {
+                       static_cast<int>(http::status::method_not_allowed), "text/plain", "Only GET is supported" });
+      } catch (std::exception &ex) {
+        response = std::make_shared<const TileService::Response>(TileService::Response {
+          static_cast<int>(http::status::bad_request), "text/plain", ex.what() });
+      }
+
+      http::response<http::string_body> message(static_cast<http::status>(response->status), request.version());
+      message.set(http::field::content_type, response->contentType);
+      message.keep_alive(request.keep_alive());
+      message.body() = response->body;
+      message.prepare_payload();
+      http::write(socket, message);
+      if (!request.keep_alive())
+        break;
+    }
+  } catch (std::exception &) {
+    // NOTE connection is closed by client or on shutdown.
+  }
+  boost::system::error_code error;
+  socket.shutdown(tcp::socket::shutdown_send, error);
+}
+
+/// Accepts connections until acceptor is closed.
+void accept(tcp::acceptor &acceptor, TileService &service, Connections &connections,
+            utymap::utils::ThreadPool &connectionPool) {
+  acceptor.async_accept([&](const boost::system::error_code &error, tcp::socket socket) {
+    if (error)
+      return;
+    auto connection = std::make_shared<tcp::socket>(std::move(socket));
+    connections.add(connection);
+    connectionPool.enqueue([&, connection]() {
+      serve(service, *connection);
+      connections.remove(connection);
+    });
+    accept(acceptor, service, connections, connectionPool);
+  });
+}
+}
+
+/// Serves data of persistent store over http, see TileService for endpoints. Tiles are sent
+/// as sequence of compact mesh records. Elevation type is 0 (flat), 1 (srtm), 2 (grid) or
+/// 3 (compressed srtm). SIGINT or SIGTERM stops server gracefully.
+/// Usage: UtyMap.TileServer <index path> <store data path> <style file> [port] [thread count] [cached tiles]
+int main(int argc, char *argv[]) {
+  if (argc < 4 || argc > 7) {
+    std::cerr << "Usage: " << argv[0] << " <index path> <store data path> <style file>"
+              << " [port] [thread count] [cached tiles]" << std::endl;
+    return 1;
+  }
+
+  try {
+    Application application(argv[1]);
+    auto &configuration = application.getConfiguration();
+    configuration.registerPersistentStore(StoreKey, argv[2], &createDirectory);
+    configuration.registerStylesheet(argv[3], &createDirectory);
+
+    auto threadCount = static_cast<std::size_t>(argc > 5 ? std::stoi(argv[5]) : 4);
+    application.getSearch().setRequestThreads(static_cast<int>(threadCount));
+    TileService service(application.getSearch(), argv[3],
+                        static_cast<std::size_t>(argc > 6 ? std::stoi(argv[6]) : 1024));
+
+    boost::asio::io_context context;
+    tcp::acceptor acceptor(context, tcp::endpoint(tcp::v4(), static_cast<unsigned short>(argc > 4 ? std::stoi(argv[4]) : 8080)));
+    Connections connections;
+    {
+      // NOTE connections mostly wait for tile builds, so there are more of them than build threads.
+      utymap::utils::ThreadPool connectionPool(threadCount * 4);
+      boost::asio::signal_set signals(context, SIGINT, SIGTERM);
+      signals.async_wait([&](const boost::system::error_code &, int) {
+        boost::system::error_code error;
+        acceptor.close(error);
+        connections.close();
+        // NOTE requests which wait for tiles are completed, so connection threads can finish.
+        service.stop();
+      });
+      accept(acceptor, service, connections, connectionPool);
+      std::cout << "Listening on port " << acceptor.local_endpoint().port() << std::endl;
+      context.run();
+    }
+    std::cout << "Stopped" << std::endl;
+  }
+  catch (std::exception &ex) {
+    std::cerr << "Cannot serve tiles: " << ex.what() << std::endl;
+    return 2;
+  }
+}
@@ -1,4 +1,5 @@
-﻿using System.Runtime.InteropServices;
+﻿using System;
+using System.Runtime.InteropServices;
 
 namespace UtyMap.Unity
 {
@@ -8,6 +9,12 @@ namespace UtyMap.Unity
     {
         internal int IsCancelled;
 
+        /// <summary> Deadline set by native code, should not be changed. </summary>
+        internal long Deadline;
+
+        /// <summary> Parent token set by native code, should not be changed. </summary>
+        internal IntPtr Parent;
+
         internal void SetCancelled(bool isCancelled)
         {
             IsCancelled = (byte) (isCancelled ? 1 : 0);
@@ -100,6 +100,8 @@ namespace UtyMap.Unity.Data
     internal class MapDataLibrary : IMapDataLibrary
     {
         private const string TraceCategory = "library";
+        /// <summary> Max amount of elements passed from native code in one call. </summary>
+        private const int ElementBatchSize = 64;
         private readonly object __lockObj = new object();
         private readonly IPathResolver _pathResolver;
         private readonly ITrace _trace;
@@ -118,14 +120,14 @@ namespace UtyMap.Unity.Data
         public IObservable<int> Get(Tile tile, IList<IObserver<MapData>> observers)
         {
             var tileHandler = new TileHandler(tile, observers);
-            return Get(tile, tile.GetHashCode(), tileHandler.OnMeshBuiltHandler, tileHandler.OnElementLoadedHandler, OnErrorHandler);
+            return Get(tile, tile.GetHashCode(), tileHandler.OnMeshBuiltHandler, tileHandler.OnElementsLoadedHandler, OnErrorHandler);
         }
 
         /// <inheritdoc />
         public IObservable<int> Get(MapQuery query, IList<IObserver<Element>> observers)
         {
             var queryHandler = new QueryHandler(observers);
-            return Get(query, 0, queryHandler.OnElementLoadedHandler, OnErrorHandler);
+            return Get(query, 0, queryHandler.OnElementsLoadedHandler, OnErrorHandler);
         }
 
         /// <inheritdoc />
@@ -254,28 +256,28 @@ namespace UtyMap.Unity.Data
 
         #region Private members
 
-        private IObservable<int> Get(Tile tile, int tag, OnMeshBuilt meshBuiltHandler, OnElementLoaded elementLoadedHandler, OnError errorHandler)
+        private IObservable<int> Get(Tile tile, int tag, OnMeshBuilt meshBuiltHandler, OnElementsLoaded elementsLoadedHandler, OnError errorHandler)
         {
             _trace.Debug(TraceCategory, "Get tile {0}", tile.ToString());
             var stylePath = RegisterStylesheet(tile.Stylesheet);
             var quadKey = tile.QuadKey;
-            WithCancelToken(tile.CancelationToken, (cancelTokenHandle) => getDataByQuadKey(
+            WithCancelToken(tile.CancelationToken, (cancelTokenHandle) => getDataByQuadKeyBatch(
                 tag, stylePath, quadKey.TileX, quadKey.TileY, quadKey.LevelOfDetail,
-                (int)tile.ElevationType, meshBuiltHandler, elementLoadedHandler, errorHandler,
+                (int)tile.ElevationType, ElementBatchSize, meshBuiltHandler, elementsLoadedHandler, errorHandler,
                 cancelTokenHandle.AddrOfPinnedObject())
             );
             return Observable.Return(100);
         }
 
-        private IObservable<int> Get(MapQuery query, int tag, OnElementLoaded elementLoadedHandler, OnError errorHandler)
+        private IObservable<int> Get(MapQuery query, int tag, OnElementsLoaded elementsLoadedHandler, OnError errorHandler)
         {
             _trace.Debug(TraceCategory, "Search elements");
-            WithCancelToken(new CancellationToken(), (cancelTokenHandle) => getDataByText(
+            WithCancelToken(new CancellationToken(), (cancelTokenHandle) => getDataByTextBatch(
                 tag, query.NotTerms, query.AndTerms, query.OrTerms,
                 query.BoundingBox.MinPoint.Latitude, query.BoundingBox.MinPoint.Longitude,
                 query.BoundingBox.MaxPoint.Latitude, query.BoundingBox.MaxPoint.Longitude,
-                query.LodRange.Minimum, query.LodRange.Maximum, elementLoadedHandler, errorHandler,
-                cancelTokenHandle.AddrOfPinnedObject())
+                query.LodRange.Minimum, query.LodRange.Maximum, 0, 0, ElementBatchSize,
+                elementsLoadedHandler, errorHandler, cancelTokenHandle.AddrOfPinnedObject())
             );
             return Observable.Return(100);
         }
@@ -330,11 +332,15 @@ namespace UtyMap.Unity.Data
             [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 9)] [In] double[] uvs, [In] int uvCount,
             [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 11)] [In] int[] uvMap, [In] int uvMapCount);
 
+        /// <remarks>
+        ///     Sizes of packed arrays are known only from their offsets, so arrays are
+        ///     passed as pointers and copied by <see cref="GetElements"/>.
+        /// </remarks>
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
-        private delegate void OnElementLoaded(int tag, [In] long id,
-            [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)] [In] string[] tags, [In] int tagCount,
-            [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 5)] [In] double[] vertices, [In] int vertexCount,
-            [MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 7)] [In] string[] styles, [In] int styleCount);
+        private delegate void OnElementsLoaded(int tag, [In] IntPtr ids, [In] int count,
+            [In] IntPtr tags, [In] IntPtr tagOffsets,
+            [In] IntPtr vertices, [In] IntPtr vertexOffsets,
+            [In] IntPtr styles, [In] IntPtr styleOffsets);
 
         [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
         private delegate void OnError([In] string message);
@@ -362,11 +368,11 @@ namespace UtyMap.Unity.Data
                 NotifyObservers(new MapData(_tile, new Union<Element, Mesh>(mesh)));
             }
 
-            public void OnElementLoadedHandler(int tag, long id, string[] tags, int tagCount,
-                double[] vertices, int vertexCount, string[] styles, int styleCount)
+            public void OnElementsLoadedHandler(int tag, IntPtr ids, int count, IntPtr tags, IntPtr tagOffsets,
+                IntPtr vertices, IntPtr vertexOffsets, IntPtr styles, IntPtr styleOffsets)
             {
-                Element element = GetElement(id, tags, vertices, styles);
-                NotifyObservers(new MapData(_tile, new Union<Element, Mesh>(element)));
+                foreach (var element in GetElements(ids, count, tags, tagOffsets, vertices, vertexOffsets, styles, styleOffsets))
+                    NotifyObservers(new MapData(_tile, new Union<Element, Mesh>(element)));
             }
 
             private void NotifyObservers(MapData mapData)
@@ -385,12 +391,14 @@ namespace UtyMap.Unity.Data
                 _observers = observers;
             }
 
-            public void OnElementLoadedHandler(int tag, long id, string[] tags, int tagCount,
-                double[] vertices, int vertexCount, string[] styles, int styleCount)
+            public void OnElementsLoadedHandler(int tag, IntPtr ids, int count, IntPtr tags, IntPtr tagOffsets,
+                IntPtr vertices, IntPtr vertexOffsets, IntPtr styles, IntPtr styleOffsets)
             {
-                Element element = GetElement(id, tags, vertices, styles);
-                foreach (var observer in _observers)
-                    observer.OnNext(element);
+                foreach (var element in GetElements(ids, count, tags, tagOffsets, vertices, vertexOffsets, styles, styleOffsets))
+                {
+                    foreach (var observer in _observers)
+                        observer.OnNext(element);
+                }
             }
         }
 
@@ -432,6 +440,58 @@ namespace UtyMap.Unity.Data
             return new Mesh(name, 0, worldPoints, triangles, unityColors, unityUvs, unityUvs2, unityUvs3);
         }
 
+        /// <summary> Copies batch of elements packed by native code. </summary>
+        private static Element[] GetElements(IntPtr ids, int count, IntPtr tags, IntPtr tagOffsets,
+            IntPtr vertices, IntPtr vertexOffsets, IntPtr styles, IntPtr styleOffsets)
+        {
+            var elementIds = new long[count];
+            Marshal.Copy(ids, elementIds, 0, count);
+            var tagBounds = ReadInts(tagOffsets, count + 1);
+            var vertexBounds = ReadInts(vertexOffsets, count + 1);
+            var styleBounds = ReadInts(styleOffsets, count + 1);
+
+            var allTags = ReadStrings(tags, tagBounds[count]);
+            var allVertices = new double[vertexBounds[count]];
+            if (allVertices.Length > 0)
+                Marshal.Copy(vertices, allVertices, 0, allVertices.Length);
+            var allStyles = ReadStrings(styles, styleBounds[count]);
+
+            var elements = new Element[count];
+            for (int i = 0; i < count; ++i)
+            {
+                elements[i] = GetElement(elementIds[i],
+                    Slice(allTags, tagBounds[i], tagBounds[i + 1]),
+                    Slice(allVertices, vertexBounds[i], vertexBounds[i + 1]),
+                    Slice(allStyles, styleBounds[i], styleBounds[i + 1]));
+            }
+            return elements;
+        }
+
+        private static int[] ReadInts(IntPtr data, int count)
+        {
+            var result = new int[count];
+            Marshal.Copy(data, result, 0, count);
+            return result;
+        }
+
+        private static string[] ReadStrings(IntPtr data, int count)
+        {
+            var pointers = new IntPtr[count];
+            if (count > 0)
+                Marshal.Copy(data, pointers, 0, count);
+            var result = new string[count];
+            for (int i = 0; i < count; ++i)
+                result[i] = Marshal.PtrToStringAnsi(pointers[i]);
+            return result;
+        }
+
+        private static T[] Slice<T>(T[] data, int start, int end)
+        {
+            var result = new T[end - start];
+            Array.Copy(data, start, result, 0, result.Length);
+            return result;
+        }
+
         private static Element GetElement(long id, string[] tags, double[] vertices, string[] styles)
         {
             var vertexCount = vertices.Length;
@@ -498,14 +558,14 @@ namespace UtyMap.Unity.Data
         #region Search API
 
         [DllImport("UtyMap.Shared")]
-        private static extern void getDataByQuadKey(int tag, string stylePath, int tileX, int tileY, int levelOfDetails, int eleDataType,
-            OnMeshBuilt meshBuiltHandler, OnElementLoaded elementLoadedHandler, OnError errorHandler, IntPtr cancelToken);
+        private static extern void getDataByQuadKeyBatch(int tag, string stylePath, int tileX, int tileY, int levelOfDetails, int eleDataType,
+            int batchSize, OnMeshBuilt meshBuiltHandler, OnElementsLoaded elementsLoadedHandler, OnError errorHandler, IntPtr cancelToken);
 
         [DllImport("UtyMap.Shared")]
-        private static extern void getDataByText(int tag, string notTerms, string andTerms, string orTerms,
+        private static extern void getDataByTextBatch(int tag, string notTerms, string andTerms, string orTerms,
             double minLatitude, double minLogitude, double maxLatitude, double maxLogitude,
-            int startLod, int endLod,
-            OnElementLoaded elementLoadedHandler, OnError errorHandler, IntPtr cancelToken);
+            int startLod, int endLod, int offset, int limit, int batchSize,
+            OnElementsLoaded elementsLoadedHandler, OnError errorHandler, IntPtr cancelToken);
 
         [DllImport("UtyMap.Shared")]
         private static extern double getElevationByQuadKey(int tileX, int tileY, int levelOfDetails, int eleDataType, double latitude, double longitude);